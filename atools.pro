@@ -42,6 +42,12 @@
 # Optional. Set this to "true" to omit all GRIB2 decoding code if not needed.
 # Reduces compilation time.
 #
+# ATOOLS_SQLITE_PATH
+# Optional. Path to SQLite installation containing "include/sqlite3.h" and the library in "lib".
+# Enables the native SQLite path in atools::sql::SqliteStatement for bulk reading and writing.
+# Qt has to be built with "-system-sqlite" using the same SQLite library.
+# Example: "/usr/local"
+#
 # This project has no deploy or install target. The include and library should
 # be used directly from the source tree.
 #
@@ -68,6 +74,7 @@ DEPLOY_BASE=$$(DEPLOY_BASE)
 QUIET=$$(ATOOLS_QUIET)
 ATOOLS_NO_FS=$$(ATOOLS_NO_FS)
 ATOOLS_NO_GRIB=$$(ATOOLS_NO_GRIB)
+ATOOLS_SQLITE_PATH=$$(ATOOLS_SQLITE_PATH)
 
 # =======================================================================
 # Fill defaults for unset
@@ -109,6 +116,12 @@ isEmpty(GIT_PATH) {
 }
 
 DEFINES += GIT_REVISION_ATOOLS=$$GIT_REVISION
+
+!isEmpty(ATOOLS_SQLITE_PATH) {
+  DEFINES += ATOOLS_SQLITE_NATIVE
+  INCLUDEPATH += $$ATOOLS_SQLITE_PATH/include
+  LIBS += -L$$ATOOLS_SQLITE_PATH/lib -lsqlite3
+}
 DEFINES += QT_NO_CAST_FROM_BYTEARRAY
 DEFINES += QT_NO_CAST_TO_ASCII
 
@@ -136,6 +149,7 @@ message(GIT_PATH: $$GIT_PATH)
 message(GIT_REVISION: $$GIT_REVISION)
 message(ATOOLS_NO_FS: $$ATOOLS_NO_FS)
 message(ATOOLS_NO_GRIB: $$ATOOLS_NO_GRIB)
+message(ATOOLS_SQLITE_PATH: $$ATOOLS_SQLITE_PATH)
 message(SIMCONNECT_PATH: $$SIMCONNECT_PATH)
 message(DEFINES: $$DEFINES)
 message(INCLUDEPATH: $$INCLUDEPATH)
@@ -156,12 +170,17 @@ HEADERS += \
   src/atools.h \
   src/exception.h \
   src/fs/bgl/surface.h \
+  src/fs/sc/aifetchfilter.h \
   src/fs/sc/connecthandler.h \
   src/fs/sc/datareaderthread.h \
+  src/fs/sc/replayfile.h \
+  src/fs/sc/sharedmemoryring.h \
   src/fs/sc/simconnectaircraft.h \
   src/fs/sc/simconnectapi.h \
   src/fs/sc/simconnectdata.h \
   src/fs/sc/simconnectdatabase.h \
+  src/fs/sc/simconnectdatachannel.h \
+  src/fs/sc/simconnectdatacodec.h \
   src/fs/sc/simconnectdummy.h \
   src/fs/sc/simconnecthandler.h \
   src/fs/sc/simconnectreply.h \
@@ -176,24 +195,33 @@ HEADERS += \
   src/fs/scenery/materiallib.h \
   src/fs/userdata/airspacereaderbase.h \
   src/fs/userdata/airspacereaderopenair.h \
+  src/fs/userdata/bulkimporter.h \
   src/fs/userdata/datamanagerbase.h \
   src/fs/userdata/logdatamanager.h \
   src/fs/weather/metar.h \
+  src/fs/weather/metargrid.h \
   src/fs/weather/metarindex.h \
   src/fs/weather/metarparser.h \
+  src/fs/weather/metarsummary.h \
   src/fs/weather/noaaweatherdownloader.h \
   src/fs/weather/weatherdownloadbase.h \
   src/fs/weather/weathernetdownload.h \
   src/fs/weather/weathertypes.h \
   src/fs/weather/xpweatherreader.h \
+  src/geo/batchcalculations.h \
   src/geo/calculations.h \
+  src/geo/geobenchmark.h \
   src/geo/line.h \
   src/geo/linestring.h \
+  src/geo/linestringlod.h \
+  src/geo/packedlinestring.h \
   src/geo/point3d.h \
+  src/geo/polygonindex.h \
   src/geo/pos.h \
   src/geo/rect.h \
   src/geo/nanoflann.h \
   src/geo/spatialindex.h \
+  src/geo/trailstore.h \
   src/grib/windquery.h \
   src/gui/actionstatesaver.h \
   src/gui/actiontextsaver.h \
@@ -210,21 +238,31 @@ HEADERS += \
   src/gui/mapposhistory.h \
   src/gui/palettesettings.h \
   src/gui/signalblocker.h \
+  src/gui/startupbenchmark.h \
   src/gui/tabwidgethandler.h \
   src/gui/tools.h \
   src/gui/translator.h \
   src/gui/widgetstate.h \
   src/gui/widgetutil.h \
+  src/httpserver/eventstreamcontroller.h \
+  src/httpserver/httpbenchmark.h \
+  src/httpserver/httpconnection.h \
   src/httpserver/httpconnectionhandler.h \
   src/httpserver/httpconnectionhandlerpool.h \
+  src/httpserver/httpcompressor.h \
   src/httpserver/httpcookie.h \
+  src/httpserver/httpeventchannel.h \
+  src/httpserver/httpeventlooppool.h \
   src/httpserver/httpglobal.h \
+  src/httpserver/httpheaderlist.h \
   src/httpserver/httplistener.h \
+  src/httpserver/httpmultiparthandler.h \
   src/httpserver/httprequest.h \
   src/httpserver/httprequesthandler.h \
   src/httpserver/httpresponse.h \
   src/httpserver/httpsession.h \
   src/httpserver/httpsessionstore.h \
+  src/httpserver/httpstatisticshandler.h \
   src/httpserver/staticfilecontroller.h \
   src/io/abstractinireader.h \
   src/io/binarystream.h \
@@ -237,18 +275,32 @@ HEADERS += \
   src/logging/logginghandler.h \
   src/logging/loggingtypes.h \
   src/logging/loggingutil.h \
+  src/logging/loggingwriter.h \
   src/routing/routenetwork.h \
   src/routing/routenetworkloader.h \
   src/routing/routenetworktypes.h \
+  src/routing/routewindcache.h \
   src/settings/settings.h \
+  src/settings/settingssnapshot.h \
+  src/sql/sqlcolumnindex.h \
+  src/sql/sqlconnectionpool.h \
   src/sql/sqldatabase.h \
   src/sql/sqlexception.h \
   src/sql/sqlexport.h \
+  src/sql/sqlexportwriter.h \
+  src/sql/sqlfulltextindex.h \
+  src/sql/sqlitecompressedvfs.h \
+  src/sql/sqlitestatement.h \
   src/sql/sqlquery.h \
+  src/sql/sqlquerystats.h \
   src/sql/sqlrecord.h \
   src/sql/sqlscript.h \
+  src/sql/sqlspatialindex.h \
   src/sql/sqltransaction.h \
+  src/sql/sqlwriterthread.h \
   src/sql/sqlutil.h \
+  src/sql/sqlwindowedquery.h \
+  src/templateengine/compiledtemplate.h \
   src/templateengine/template.h \
   src/templateengine/templatecache.h \
   src/templateengine/templateglobal.h \
@@ -256,17 +308,30 @@ HEADERS += \
   src/track/trackdownloader.h \
   src/track/trackreader.h \
   src/track/tracktypes.h \
+  src/util/arena.h \
+  src/util/csvfilereader.h \
   src/util/csvreader.h \
   src/util/filesystemwatcher.h \
   src/util/flags.h \
+  src/util/flathashmap.h \
   src/util/heap.h \
   src/util/htmlbuilder.h \
+  src/util/httpcache.h \
   src/util/httpdownloader.h \
+  src/util/httpscheduler.h \
+  src/util/jsonstreamreader.h \
+  src/util/lrucache.h \
+  src/util/memorybudget.h \
+  src/util/multipathwatcher.h \
   src/util/paintercontextsaver.h \
+  src/util/parallel.h \
   src/util/properties.h \
   src/util/roundedpolygon.h \
   src/util/str.h \
+  src/util/stringinterner.h \
+  src/util/taskscheduler.h \
   src/util/timedcache.h \
+  src/util/trace.h \
   src/util/updatecheck.h \
   src/util/version.h \
   src/util/xmlstream.h \
@@ -281,12 +346,17 @@ SOURCES += \
   src/atools.cpp \
   src/exception.cpp \
   src/fs/bgl/surface.cpp \
+  src/fs/sc/aifetchfilter.cpp \
   src/fs/sc/connecthandler.cpp \
   src/fs/sc/datareaderthread.cpp \
+  src/fs/sc/replayfile.cpp \
+  src/fs/sc/sharedmemoryring.cpp \
   src/fs/sc/simconnectaircraft.cpp \
   src/fs/sc/simconnectapi.cpp \
   src/fs/sc/simconnectdata.cpp \
   src/fs/sc/simconnectdatabase.cpp \
+  src/fs/sc/simconnectdatachannel.cpp \
+  src/fs/sc/simconnectdatacodec.cpp \
   src/fs/sc/simconnectdummy.cpp \
   src/fs/sc/simconnecthandler.cpp \
   src/fs/sc/simconnectreply.cpp \
@@ -301,23 +371,32 @@ SOURCES += \
   src/fs/scenery/materiallib.cpp \
   src/fs/userdata/airspacereaderbase.cpp \
   src/fs/userdata/airspacereaderopenair.cpp \
+  src/fs/userdata/bulkimporter.cpp \
   src/fs/userdata/datamanagerbase.cpp \
   src/fs/userdata/logdatamanager.cpp \
   src/fs/weather/metar.cpp \
+  src/fs/weather/metargrid.cpp \
   src/fs/weather/metarindex.cpp \
   src/fs/weather/metarparser.cpp \
+  src/fs/weather/metarsummary.cpp \
   src/fs/weather/noaaweatherdownloader.cpp \
   src/fs/weather/weatherdownloadbase.cpp \
   src/fs/weather/weathernetdownload.cpp \
   src/fs/weather/weathertypes.cpp \
   src/fs/weather/xpweatherreader.cpp \
+  src/geo/batchcalculations.cpp \
   src/geo/calculations.cpp \
+  src/geo/geobenchmark.cpp \
   src/geo/line.cpp \
   src/geo/linestring.cpp \
+  src/geo/linestringlod.cpp \
+  src/geo/packedlinestring.cpp \
   src/geo/point3d.cpp \
+  src/geo/polygonindex.cpp \
   src/geo/pos.cpp \
   src/geo/rect.cpp \
   src/geo/spatialindex.cpp \
+  src/geo/trailstore.cpp \
   src/grib/windquery.cpp \
   src/gui/actionstatesaver.cpp \
   src/gui/actiontextsaver.cpp \
@@ -334,21 +413,30 @@ SOURCES += \
   src/gui/mapposhistory.cpp \
   src/gui/palettesettings.cpp \
   src/gui/signalblocker.cpp \
+  src/gui/startupbenchmark.cpp \
   src/gui/tabwidgethandler.cpp \
   src/gui/tools.cpp \
   src/gui/translator.cpp \
   src/gui/widgetstate.cpp \
   src/gui/widgetutil.cpp \
+  src/httpserver/eventstreamcontroller.cpp \
+  src/httpserver/httpbenchmark.cpp \
+  src/httpserver/httpconnection.cpp \
   src/httpserver/httpconnectionhandler.cpp \
   src/httpserver/httpconnectionhandlerpool.cpp \
+  src/httpserver/httpcompressor.cpp \
   src/httpserver/httpcookie.cpp \
+  src/httpserver/httpeventchannel.cpp \
+  src/httpserver/httpeventlooppool.cpp \
   src/httpserver/httpglobal.cpp \
+  src/httpserver/httpheaderlist.cpp \
   src/httpserver/httplistener.cpp \
   src/httpserver/httprequest.cpp \
   src/httpserver/httprequesthandler.cpp \
   src/httpserver/httpresponse.cpp \
   src/httpserver/httpsession.cpp \
   src/httpserver/httpsessionstore.cpp \
+  src/httpserver/httpstatisticshandler.cpp \
   src/httpserver/staticfilecontroller.cpp \
   src/io/abstractinireader.cpp \
   src/io/binarystream.cpp \
@@ -360,35 +448,58 @@ SOURCES += \
   src/logging/loggingguiabort.cpp \
   src/logging/logginghandler.cpp \
   src/logging/loggingutil.cpp \
+  src/logging/loggingwriter.cpp \
   src/routing/routenetwork.cpp \
   src/routing/routenetworkloader.cpp \
   src/routing/routenetworktypes.cpp \
+  src/routing/routewindcache.cpp \
   src/settings/settings.cpp \
+  src/sql/sqlcolumnindex.cpp \
+  src/sql/sqlconnectionpool.cpp \
   src/sql/sqldatabase.cpp \
   src/sql/sqlexception.cpp \
   src/sql/sqlexport.cpp \
+  src/sql/sqlexportwriter.cpp \
+  src/sql/sqlfulltextindex.cpp \
+  src/sql/sqlitecompressedvfs.cpp \
+  src/sql/sqlitestatement.cpp \
   src/sql/sqlquery.cpp \
+  src/sql/sqlquerystats.cpp \
   src/sql/sqlrecord.cpp \
   src/sql/sqlscript.cpp \
+  src/sql/sqlspatialindex.cpp \
   src/sql/sqltransaction.cpp \
+  src/sql/sqlwriterthread.cpp \
   src/sql/sqlutil.cpp \
+  src/sql/sqlwindowedquery.cpp \
+  src/templateengine/compiledtemplate.cpp \
   src/templateengine/template.cpp \
   src/templateengine/templatecache.cpp \
   src/templateengine/templateloader.cpp \
   src/track/trackdownloader.cpp \
 src/track/trackreader.cpp \
   src/track/tracktypes.cpp \
+  src/util/csvfilereader.cpp \
   src/util/csvreader.cpp \
   src/util/filesystemwatcher.cpp \
   src/util/flags.cpp \
   src/util/heap.cpp \
   src/util/htmlbuilder.cpp \
+  src/util/httpcache.cpp \
   src/util/httpdownloader.cpp \
+  src/util/httpscheduler.cpp \
+  src/util/jsonstreamreader.cpp \
+  src/util/lrucache.cpp \
+  src/util/memorybudget.cpp \
+  src/util/multipathwatcher.cpp \
   src/util/paintercontextsaver.cpp \
   src/util/properties.cpp \
   src/util/roundedpolygon.cpp \
   src/util/str.cpp \
+  src/util/stringinterner.cpp \
+  src/util/taskscheduler.cpp \
   src/util/timedcache.cpp \
+  src/util/trace.cpp \
   src/util/updatecheck.cpp \
   src/util/version.cpp \
   src/util/xmlstream.cpp \
@@ -454,6 +565,7 @@ HEADERS += \
   src/fs/bgl/subsection.h \
   src/fs/bgl/util.h \
   src/fs/common/airportindex.h \
+  src/fs/common/airspaceindex.h \
   src/fs/common/binarygeometry.h \
   src/fs/common/globereader.h \
   src/fs/common/magdecreader.h \
@@ -478,12 +590,16 @@ HEADERS += \
   src/fs/db/ap/taxipathwriter.h \
   src/fs/db/ap/transitionlegwriter.h \
   src/fs/db/ap/transitionwriter.h \
+  src/fs/db/bglfilecache.h \
+  src/fs/db/databasediff.h \
   src/fs/db/databasemeta.h \
   src/fs/db/datawriter.h \
   src/fs/db/dbairportindex.h \
+  src/fs/db/dbsessionindex.h \
   src/fs/db/meta/bglfilewriter.h \
   src/fs/db/meta/sceneryareawriter.h \
   src/fs/db/nav/airwaysegmentwriter.h \
+  src/fs/db/nav/boundarytilewriter.h \
   src/fs/db/nav/boundarywriter.h \
   src/fs/db/nav/ilswriter.h \
   src/fs/db/nav/markerwriter.h \
@@ -491,41 +607,55 @@ HEADERS += \
   src/fs/db/nav/tacanwriter.h \
   src/fs/db/nav/vorwriter.h \
   src/fs/db/nav/waypointwriter.h \
+  src/fs/db/proceduregeometrywriter.h \
   src/fs/db/routeedgewriter.h \
+  src/fs/db/routeshortcutwriter.h \
   src/fs/db/runwayindex.h \
   src/fs/db/writerbase.h \
   src/fs/db/writerbasebasic.h \
   src/fs/dfd/dfdcompiler.h \
   src/fs/fspaths.h \
   src/fs/navdatabase.h \
+  src/fs/navdatabasebenchmark.h \
   src/fs/navdatabaseerrors.h \
+  src/fs/navdatabasemulti.h \
   src/fs/navdatabaseoptions.h \
   src/fs/navdatabaseprogress.h \
+  src/fs/ns/aircrafteventpublisher.h \
   src/fs/ns/navserver.h \
   src/fs/ns/navservercommon.h \
+  src/fs/ns/navserverframe.h \
   src/fs/ns/navserverworker.h \
+  src/fs/online/onlineclientstore.h \
   src/fs/online/onlinedatamanager.h \
   src/fs/online/onlinetypes.h \
   src/fs/online/statustextparser.h \
   src/fs/online/whazzuptextparser.h \
   src/fs/perf/aircraftperf.h \
+  src/fs/perf/aircraftperfcatalog.h \
   src/fs/perf/aircraftperfconstants.h \
   src/fs/perf/aircraftperfhandler.h \
+  src/fs/perf/aircraftperftable.h \
   src/fs/pln/flightplan.h \
   src/fs/pln/flightplanconstants.h \
   src/fs/pln/flightplanentry.h \
   src/fs/pln/flightplanio.h \
+  src/fs/pln/flightplansnapshot.h \
   src/fs/progresshandler.h \
+  src/routing/routebenchmark.h \
   src/routing/routefinder.h \
+  src/routing/routematrix.h \
   src/fs/scenery/addoncfg.h \
   src/fs/scenery/addoncomponent.h \
   src/fs/scenery/addonpackage.h \
+  src/fs/scenery/directorycache.h \
   src/fs/scenery/fileresolver.h \
   src/fs/scenery/sceneryarea.h \
   src/fs/scenery/scenerycfg.h \
   src/fs/userdata/userdatamanager.h \
   src/fs/util/coordinates.h \
   src/fs/util/fsutil.h \
+  src/fs/util/fsutilbenchmark.h \
   src/fs/util/morsecode.h \
   src/fs/util/tacanfrequencies.h \
   src/fs/xp/airwaypostprocess.h \
@@ -533,10 +663,13 @@ HEADERS += \
   src/fs/xp/xpairportwriter.h \
   src/fs/xp/xpairspacewriter.h \
   src/fs/xp/xpairwaywriter.h \
+  src/fs/xp/xpaptindex.h \
   src/fs/xp/xpcifpwriter.h \
   src/fs/xp/xpconstants.h \
+  src/fs/xp/xpdatacache.h \
   src/fs/xp/xpdatacompiler.h \
   src/fs/xp/xpfixwriter.h \
+  src/fs/xp/xplinereader.h \
   src/fs/xp/xpnavwriter.h \
   src/fs/xp/xpwriter.h
 
@@ -592,6 +725,7 @@ SOURCES += \
   src/fs/bgl/subsection.cpp \
   src/fs/bgl/util.cpp \
   src/fs/common/airportindex.cpp \
+  src/fs/common/airspaceindex.cpp \
   src/fs/common/binarygeometry.cpp \
   src/fs/common/globereader.cpp \
   src/fs/common/magdecreader.cpp \
@@ -616,12 +750,16 @@ SOURCES += \
   src/fs/db/ap/taxipathwriter.cpp \
   src/fs/db/ap/transitionlegwriter.cpp \
   src/fs/db/ap/transitionwriter.cpp \
+  src/fs/db/bglfilecache.cpp \
+  src/fs/db/databasediff.cpp \
   src/fs/db/databasemeta.cpp \
   src/fs/db/datawriter.cpp \
   src/fs/db/dbairportindex.cpp \
+  src/fs/db/dbsessionindex.cpp \
   src/fs/db/meta/bglfilewriter.cpp \
   src/fs/db/meta/sceneryareawriter.cpp \
   src/fs/db/nav/airwaysegmentwriter.cpp \
+  src/fs/db/nav/boundarytilewriter.cpp \
   src/fs/db/nav/boundarywriter.cpp \
   src/fs/db/nav/ilswriter.cpp \
   src/fs/db/nav/markerwriter.cpp \
@@ -629,40 +767,54 @@ SOURCES += \
   src/fs/db/nav/tacanwriter.cpp \
   src/fs/db/nav/vorwriter.cpp \
   src/fs/db/nav/waypointwriter.cpp \
+  src/fs/db/proceduregeometrywriter.cpp \
   src/fs/db/routeedgewriter.cpp \
+  src/fs/db/routeshortcutwriter.cpp \
   src/fs/db/runwayindex.cpp \
   src/fs/db/writerbasebasic.cpp \
   src/fs/dfd/dfdcompiler.cpp \
   src/fs/fspaths.cpp \
   src/fs/navdatabase.cpp \
+  src/fs/navdatabasebenchmark.cpp \
   src/fs/navdatabaseerrors.cpp \
+  src/fs/navdatabasemulti.cpp \
   src/fs/navdatabaseoptions.cpp \
   src/fs/navdatabaseprogress.cpp \
+  src/fs/ns/aircrafteventpublisher.cpp \
   src/fs/ns/navserver.cpp \
   src/fs/ns/navservercommon.cpp \
+  src/fs/ns/navserverframe.cpp \
   src/fs/ns/navserverworker.cpp \
+  src/fs/online/onlineclientstore.cpp \
   src/fs/online/onlinedatamanager.cpp \
   src/fs/online/onlinetypes.cpp \
   src/fs/online/statustextparser.cpp \
   src/fs/online/whazzuptextparser.cpp \
   src/fs/perf/aircraftperf.cpp \
+  src/fs/perf/aircraftperfcatalog.cpp \
   src/fs/perf/aircraftperfconstants.cpp \
   src/fs/perf/aircraftperfhandler.cpp \
+  src/fs/perf/aircraftperftable.cpp \
   src/fs/pln/flightplan.cpp \
   src/fs/pln/flightplanconstants.cpp \
   src/fs/pln/flightplanentry.cpp \
   src/fs/pln/flightplanio.cpp \
+  src/fs/pln/flightplansnapshot.cpp \
   src/fs/progresshandler.cpp \
+  src/routing/routebenchmark.cpp \
   src/routing/routefinder.cpp \
+  src/routing/routematrix.cpp \
   src/fs/scenery/addoncfg.cpp \
   src/fs/scenery/addoncomponent.cpp \
   src/fs/scenery/addonpackage.cpp \
+  src/fs/scenery/directorycache.cpp \
   src/fs/scenery/fileresolver.cpp \
   src/fs/scenery/sceneryarea.cpp \
   src/fs/scenery/scenerycfg.cpp \
   src/fs/userdata/userdatamanager.cpp \
   src/fs/util/coordinates.cpp \
   src/fs/util/fsutil.cpp \
+  src/fs/util/fsutilbenchmark.cpp \
   src/fs/util/morsecode.cpp \
   src/fs/util/tacanfrequencies.cpp \
   src/fs/xp/airwaypostprocess.cpp \
@@ -670,10 +822,13 @@ SOURCES += \
   src/fs/xp/xpairportwriter.cpp \
   src/fs/xp/xpairspacewriter.cpp \
   src/fs/xp/xpairwaywriter.cpp \
+  src/fs/xp/xpaptindex.cpp \
   src/fs/xp/xpcifpwriter.cpp \
   src/fs/xp/xpconstants.cpp \
+  src/fs/xp/xpdatacache.cpp \
   src/fs/xp/xpdatacompiler.cpp \
   src/fs/xp/xpfixwriter.cpp \
+  src/fs/xp/xplinereader.cpp \
   src/fs/xp/xpnavwriter.cpp \
   src/fs/xp/xpwriter.cpp
 } # ATOOLS_NO_FS
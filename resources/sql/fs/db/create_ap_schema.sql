@@ -541,6 +541,32 @@ create index if not exists idx_transition_leg_transition_id on transition_leg(tr
 
 -- **************************************************
 
+drop table if exists procedure_geometry;
+
+-- Approximated geometry of an approach or a transition. Only filled if option PROCEDURE_GEOMETRY is set.
+-- Lines connect the fix positions of the legs. Arcs (AF and RF legs) are interpolated around the
+-- recommended fix or center. Legs without fix like course to altitude or to intercept are not included.
+create table procedure_geometry
+(
+  procedure_geometry_id integer primary key,
+  approach_id integer not null,
+  transition_id integer,            -- Null if this is the geometry of the approach itself
+  is_missed integer not null,       -- 1 if this is the geometry of the missed approach legs
+  distance double not null,         -- Length of the line string in NM
+  left_lonx double not null,        -- Bounding rectangle of the geometry
+  top_laty double not null,         -- "
+  right_lonx double not null,       -- "
+  bottom_laty double not null,      -- "
+  geometry blob not null,           -- Line string - see atools::fs::common::BinaryGeometry
+foreign key(approach_id) references approach(approach_id),
+foreign key(transition_id) references transition(transition_id)
+);
+
+create index if not exists idx_procedure_geometry_approach_id on procedure_geometry(approach_id);
+create index if not exists idx_procedure_geometry_transition_id on procedure_geometry(transition_id);
+
+-- **************************************************
+
 drop table if exists parking;
 
 -- Parking spot. Includes fuel and vehicle parking.
@@ -19,6 +19,7 @@
 -- This script create all boundary and MORA tables
 -- *************************************************************
 
+drop table if exists boundary_tile;
 drop table if exists boundary;
 
 -- Airspace boundary
@@ -53,3 +54,25 @@ foreign key(file_id) references bgl_file(bgl_file_id)
 
 create index if not exists idx_boundary_file_id on boundary(file_id);
 
+-- Simplified and tiled geometry for large boundaries having at least 500 positions.
+-- Allows to load only the needed cells and level of detail. Full geometry is still stored in boundary.
+-- Written only by the FSX/P3D compiler. Clients have to fall back to boundary.geometry if no tiles exist.
+create table boundary_tile
+(
+  boundary_tile_id integer primary key,
+  boundary_id integer not null,
+  lod integer not null,                 -- Level of detail. 0 is full resolution.
+  tolerance double not null,            -- Maximum distance of removed positions to the line in meter for this level
+  tile_size integer not null,           -- Cell size in degree. 1 for levels below 1 km tolerance and 5 otherwise.
+  tile_lonx integer not null,           -- West border of cell in degree - multiple of tile_size
+  tile_laty integer not null,           -- South border of cell in degree - multiple of tile_size
+  max_lonx double not null,             -- Bounding rectangle of geometry which can exceed the cell
+  max_laty double not null,             -- "
+  min_lonx double not null,             -- Bounding rectangle
+  min_laty double not null,             -- "
+  geometry blob,                        -- Line pieces starting in the cell separated by invalid positions
+foreign key(boundary_id) references boundary(boundary_id)
+);
+
+create index if not exists idx_boundary_tile_boundary_id on boundary_tile(boundary_id);
+
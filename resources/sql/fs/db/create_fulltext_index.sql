@@ -0,0 +1,44 @@
+-- *****************************************************************************
+-- Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+-- ****************************************************************************/
+
+-- *************************************************************
+-- Create optional FTS5 full text indexes for name and ident searches.
+-- Run after finish_schema.sql since airport and nav_search have to be complete.
+--
+-- The indexes use the tables as external content and store only the index.
+-- Case and diacritics are ignored and prefix indexes speed up type-ahead searches.
+--
+-- See atools::sql::SqlFullTextIndex for queries
+-- *************************************************************
+
+-- Airports by ident, ICAO, IATA, name, city, state and country
+drop table if exists airport_fts;
+create virtual table airport_fts using fts5(ident, icao, iata, name, city, state, country,
+  content = 'airport', content_rowid = 'airport_id', tokenize = 'unicode61 remove_diacritics 1', prefix = '2 3');
+
+insert into airport_fts(airport_fts) values('rebuild');
+
+-- VOR, NDB and waypoints by ident, name, region and airport ident
+drop table if exists nav_search_fts;
+create virtual table nav_search_fts using fts5(ident, name, region, airport_ident,
+  content = 'nav_search', content_rowid = 'nav_search_id', tokenize = 'unicode61 remove_diacritics 1', prefix = '2 3');
+
+insert into nav_search_fts(nav_search_fts) values('rebuild');
+
+insert into airport_fts(airport_fts) values('optimize');
+insert into nav_search_fts(nav_search_fts) values('optimize');
+
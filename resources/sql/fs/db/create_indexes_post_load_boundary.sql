@@ -28,3 +28,5 @@ create index if not exists idx_boundary_max_laty on boundary(max_laty);
 create index if not exists idx_boundary_min_altitude on boundary(min_altitude);
 create index if not exists idx_boundary_min_lonx on boundary(min_lonx);
 create index if not exists idx_boundary_min_laty on boundary(min_laty);
+
+create index if not exists idx_boundary_tile_lod_tile on boundary_tile(lod, tile_lonx, tile_laty);
@@ -77,6 +77,26 @@ create index if not exists idx_bgl_file_scenery_area_id on bgl_file(scenery_area
 create index if not exists idx_bgl_file_filepath on bgl_file(filepath);
 create index if not exists idx_bgl_file_filename on bgl_file(filename);
 
+-- **************************************************
+
+drop table if exists scenery_area_state;
+
+-- State of all scenery areas at the time of the last compilation.
+-- Used to detect changes when loading incrementally.
+create table scenery_area_state
+(
+  scenery_area_state_id integer primary key,
+  layer integer not null,                  -- Layer number
+  title varchar(250) not null,             -- Area title as shown in the library in FS
+  local_path varchar(250),                 -- Scenery path as given in the scenery configuration
+  num_files integer not null,              -- Number of BGL files found in the area
+  size integer not null,                   -- Total size of all files in bytes
+  file_modification_time integer not null, -- Latest modification time of all files. Seconds since Epoch.
+  fingerprint varchar(50) not null         -- SHA-1 of options, compiler, area and all file paths, sizes and times
+);
+
+-- **************************************************
+
 drop table if exists script;
 
 -- A database preparation script containiing create index statements for example
@@ -92,3 +92,23 @@ foreign key(to_node_id) references route_node_airway(node_id)
 create index if not exists idx_route_edge_airway_id on route_edge_airway(airway_id);
 create index if not exists idx_route_edge_airway_from_node_id on route_edge_airway(from_node_id);
 create index if not exists idx_route_edge_airway_to_node_id on route_edge_airway(to_node_id);
+
+-- **************************************************
+
+drop table if exists route_shortcut_airway;
+
+-- Shortcuts for airway routing. Each row replaces a chain of segments of the same airway which runs
+-- through waypoints without any other airway connection. Filled by class RouteShortcutWriter.
+-- Altitude restrictions and lengths are combined when loading the network.
+create table route_shortcut_airway
+(
+  shortcut_id integer primary key,
+  from_waypoint_id integer not null,  -- First waypoint of chain - junction of two or more airways or airway end
+  via_waypoint_id integer not null,   -- Second waypoint of chain defining the direction
+  to_waypoint_id integer not null,    -- Last waypoint of chain
+  num_segments integer not null,      -- Number of airway segments in chain
+  airway_name varchar(15) not null,   -- Airway name
+foreign key(from_waypoint_id) references waypoint(waypoint_id),
+foreign key(via_waypoint_id) references waypoint(waypoint_id),
+foreign key(to_waypoint_id) references waypoint(waypoint_id)
+);
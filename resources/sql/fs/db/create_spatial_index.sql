@@ -0,0 +1,118 @@
+-- *****************************************************************************
+-- Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+--
+-- This program is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- This program is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with this program.  If not, see <http://www.gnu.org/licenses/>.
+-- ****************************************************************************/
+
+-- *************************************************************
+-- Create optional R*Tree spatial indexes for the tables with coordinates.
+-- Run after all other scripts since tables have to be filled.
+--
+-- Each table "x" gets a virtual table "x_rtree" with the columns
+-- id (primary key of the table), min_lonx, max_lonx, min_laty and max_laty.
+-- Points are stored as rectangles with zero size.
+-- Rectangles crossing the anti-meridian cover the whole longitude range since the
+-- R*Tree cannot store them. Coordinates are stored as 32 bit float values rounded outwards.
+--
+-- See atools::sql::SqlSpatialIndex for queries
+-- *************************************************************
+
+-- Airports by bounding rectangle
+drop table if exists airport_rtree;
+create virtual table airport_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into airport_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select airport_id,
+  case when left_lonx > right_lonx then -180.0 else left_lonx end,
+  case when left_lonx > right_lonx then 180.0 else right_lonx end,
+  bottom_laty, top_laty
+from airport;
+
+drop table if exists airport_medium_rtree;
+create virtual table airport_medium_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into airport_medium_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select airport_id,
+  case when left_lonx > right_lonx then -180.0 else left_lonx end,
+  case when left_lonx > right_lonx then 180.0 else right_lonx end,
+  bottom_laty, top_laty
+from airport_medium;
+
+drop table if exists airport_large_rtree;
+create virtual table airport_large_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into airport_large_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select airport_id,
+  case when left_lonx > right_lonx then -180.0 else left_lonx end,
+  case when left_lonx > right_lonx then 180.0 else right_lonx end,
+  bottom_laty, top_laty
+from airport_large;
+
+-- Navaids by position
+drop table if exists waypoint_rtree;
+create virtual table waypoint_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into waypoint_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select waypoint_id, lonx, lonx, laty, laty from waypoint;
+
+drop table if exists vor_rtree;
+create virtual table vor_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into vor_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select vor_id, lonx, lonx, laty, laty from vor;
+
+drop table if exists ndb_rtree;
+create virtual table ndb_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into ndb_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select ndb_id, lonx, lonx, laty, laty from ndb;
+
+drop table if exists marker_rtree;
+create virtual table marker_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into marker_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select marker_id, lonx, lonx, laty, laty from marker;
+
+-- ILS by rectangle covering origin and feather
+drop table if exists ils_rtree;
+create virtual table ils_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into ils_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select ils_id,
+  min(lonx, end1_lonx, end2_lonx), max(lonx, end1_lonx, end2_lonx),
+  min(laty, end1_laty, end2_laty), max(laty, end1_laty, end2_laty)
+from ils;
+
+-- Airway segments by bounding rectangle
+drop table if exists airway_rtree;
+create virtual table airway_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into airway_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select airway_id,
+  case when left_lonx > right_lonx then -180.0 else left_lonx end,
+  case when left_lonx > right_lonx then 180.0 else right_lonx end,
+  bottom_laty, top_laty
+from airway;
+
+-- Airspaces by bounding rectangle
+drop table if exists boundary_rtree;
+create virtual table boundary_rtree using rtree(id, min_lonx, max_lonx, min_laty, max_laty);
+
+insert into boundary_rtree (id, min_lonx, max_lonx, min_laty, max_laty)
+select boundary_id,
+  case when min_lonx > max_lonx then -180.0 else min_lonx end,
+  case when min_lonx > max_lonx then 180.0 else max_lonx end,
+  min_laty, max_laty
+from boundary;
+
@@ -28,3 +28,9 @@ drop table if exists airport;
 drop table if exists airport_file;
 drop table if exists airport_medium;
 drop table if exists airport_large;
+
+-- drop optional spatial indexes
+drop table if exists airport_rtree;
+drop table if exists airport_medium_rtree;
+drop table if exists airport_large_rtree;
+drop table if exists airport_fts;
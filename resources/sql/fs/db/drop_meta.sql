@@ -22,6 +22,7 @@
 -- Order is important to avoid fk conflicts
 
 -- drop meta
+drop table if exists scenery_area_state;
 drop table if exists bgl_file;
 drop table if exists scenery_area;
 drop table if exists metadata;
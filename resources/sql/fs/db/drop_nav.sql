@@ -33,6 +33,16 @@ drop table if exists marker;
 drop table if exists ndb;
 drop table if exists vor;
 drop table if exists waypoint;
+drop table if exists boundary_tile;
 drop table if exists boundary;
 drop table if exists mora_grid;
 
+-- drop optional spatial indexes
+drop table if exists airway_rtree;
+drop table if exists ils_rtree;
+drop table if exists marker_rtree;
+drop table if exists ndb_rtree;
+drop table if exists vor_rtree;
+drop table if exists waypoint_rtree;
+drop table if exists boundary_rtree;
+
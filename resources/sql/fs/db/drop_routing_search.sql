@@ -28,3 +28,6 @@ drop table if exists route_node_radio;
 drop table if exists route_node_airway;
 drop table if exists nav_search;
 
+-- drop optional full text index
+drop table if exists nav_search_fts;
+
@@ -95,3 +95,56 @@ create index if not exists idx_logbook_destination_laty on logbook(destination_l
 create index if not exists idx_logbook_destination_time on logbook(destination_time);
 create index if not exists idx_logbook_destination_time_sim on logbook(destination_time_sim);
 create index if not exists idx_logbook_simulator on logbook(simulator);
+
+-- **************************************************
+
+drop table if exists logbook_geometry;
+
+-- Binary geometry derived from logbook.aircraft_trail to avoid parsing the GPX for display.
+-- Created on demand and recreated if trail_size does not match the current trail.
+create table logbook_geometry
+(
+  logbook_id integer primary key,                    -- Same as in logbook
+  trail_size integer not null,                       -- Size of aircraft_trail when this was created
+  west double,                                       -- Bounding rectangle of route and track for spatial index
+  north double,                                      -- "
+  east double,                                       -- "
+  south double,                                      -- "
+  geometry blob                                      -- Route, route names and track in compact binary format
+);
+
+-- **************************************************
+
+drop table if exists logbook_stats;
+
+-- Precomputed aggregates for the logbook statistics which are updated with each change of the logbook.
+-- Contains a single row if valid. Missing row means that the statistics have to be rebuilt.
+create table logbook_stats
+(
+  num_entries integer not null,                      -- Number of logbook entries
+  distance_sum double,                               -- Flight plan distance in NM
+  distance_max double,                               -- "
+  distance_num integer,                              -- Number of entries having a distance
+  departure_time_min varchar(100),                   -- Departure time range
+  departure_time_max varchar(100),                   -- "
+  departure_time_sim_min varchar(100),               -- "
+  departure_time_sim_max varchar(100),               -- "
+  time_real_max integer,                             -- Trip time in seconds
+  time_real_sum integer,                             -- "
+  time_real_num integer,                             -- Number of entries having a trip time
+  time_sim_max integer,                              -- "
+  time_sim_sum integer,                              -- "
+  time_sim_num integer                               -- "
+);
+
+drop table if exists logbook_stats_value;
+
+-- Number of logbook entries for each distinct value of the columns used in the statistics
+create table logbook_stats_value
+(
+  type varchar(50) not null,                         -- Column name in logbook, e.g. "aircraft_type"
+  value varchar(1024),                               -- Column value
+  num integer not null                               -- Number of logbook entries having this value
+);
+
+create index if not exists idx_logbook_stats_value_type on logbook_stats_value(type);
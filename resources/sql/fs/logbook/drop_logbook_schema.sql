@@ -17,6 +17,9 @@
 
 
 drop table if exists logbook;
+drop table if exists logbook_geometry;
+drop table if exists logbook_stats;
+drop table if exists logbook_stats_value;
 
 drop index if exists idx_logbook_aircraft_name logbook;
 drop index if exists idx_logbook_aircraft_type logbook;
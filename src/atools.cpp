@@ -28,6 +28,8 @@
 #include <QDateTime>
 #include <QStandardPaths>
 
+#include <algorithm>
+
 namespace atools {
 
 const static QChar SEP(QDir::separator());
@@ -59,6 +61,31 @@ QTextCodec *codecForFile(QFile& file, QTextCodec *defaultCodec)
   return codec;
 }
 
+/* Read lines for probeFile() and probeBytes() */
+static QStringList probeStream(QTextStream& stream, int numLinesRead)
+{
+  QStringList lines;
+  stream.setCodec("UTF-8");
+  stream.setAutoDetectUnicode(true);
+
+  int numLines = 0, numLinesTotal = 0;
+  while(!stream.atEnd() && numLines < numLinesRead && numLinesTotal < numLinesRead * 2)
+  {
+    QString line = stream.readLine(256).trimmed();
+    if(!line.isEmpty())
+    {
+      lines.append(line.toLower().simplified());
+      numLines++;
+    }
+    numLinesTotal++;
+  }
+
+  // Fill missing entries with empty strings to ease checking.
+  for(int i = lines.size(); i < 6; i++)
+    lines.append(QString());
+  return lines;
+}
+
 QStringList probeFile(const QString& file, int numLinesRead)
 {
   QFile testFile(file);
@@ -67,24 +94,7 @@ QStringList probeFile(const QString& file, int numLinesRead)
   if(testFile.open(QIODevice::ReadOnly))
   {
     QTextStream stream(&testFile);
-    stream.setCodec("UTF-8");
-    stream.setAutoDetectUnicode(true);
-
-    int numLines = 0, numLinesTotal = 0;
-    while(!stream.atEnd() && numLines < numLinesRead && numLinesTotal < numLinesRead * 2)
-    {
-      QString line = stream.readLine(256).trimmed();
-      if(!line.isEmpty())
-      {
-        lines.append(line.toLower().simplified());
-        numLines++;
-      }
-      numLinesTotal++;
-    }
-
-    // Fill missing entries with empty strings to ease checking.
-    for(int i = lines.size(); i < 6; i++)
-      lines.append(QString());
+    lines = probeStream(stream, numLinesRead);
     testFile.close();
   }
   else
@@ -93,6 +103,12 @@ QStringList probeFile(const QString& file, int numLinesRead)
   return lines;
 }
 
+QStringList probeBytes(const QByteArray& bytes, int numLinesRead)
+{
+  QTextStream stream(bytes);
+  return probeStream(stream, numLinesRead);
+}
+
 QString capWord(QString str)
 {
   if(!str.isEmpty())
@@ -121,12 +137,90 @@ void capWord(QString& lastWord, QChar last, const QSet<QString>& toUpper,
   }
 }
 
+/* ASCII only version of capWord() which changes the word in place. buffer is reused for the set lookups
+ * to avoid a temporary string for each word. */
+static void capWordAscii(QChar *word, int size, QChar last, QString& buffer, const QSet<QString>& toUpper,
+                         const QSet<QString>& toLower, const QSet<QString>& ignore)
+{
+  buffer.resize(size);
+  QChar *buf = buffer.data();
+  for(int i = 0; i < size; i++)
+    buf[i] = QChar(latin1ToUpper(word[i].toLatin1()));
+
+  if(toUpper.contains(buffer))
+  {
+    std::copy(buf, buf + size, word);
+    return;
+  }
+
+  if(!toLower.isEmpty() || !ignore.isEmpty())
+  {
+    std::copy(word, word + size, buf);
+    if(toLower.contains(buffer))
+    {
+      for(int i = 0; i < size; i++)
+        word[i] = QChar(latin1ToLower(word[i].toLatin1()));
+      return;
+    }
+    else if(ignore.contains(buffer))
+      return;
+  }
+
+  // Convert all letters after an apostrophe to lower case (St. Mary's)
+  if(last == '\'' && size == 1)
+    word[0] = QChar(latin1ToLower(word[0].toLatin1()));
+  else
+  {
+    word[0] = QChar(latin1ToUpper(word[0].toLatin1()));
+    for(int i = 1; i < size; i++)
+      word[i] = QChar(latin1ToLower(word[i].toLatin1()));
+  }
+}
+
+/* Fast path of capString() for pure ASCII strings which works on a single copy of the string */
+static QString capStringAscii(const QString& str, const QSet<QString>& toUpper, const QSet<QString>& toLower,
+                              const QSet<QString>& ignore)
+{
+  QString retval(str), buffer;
+  buffer.reserve(str.size());
+
+  QChar *data = retval.data();
+  int size = retval.size(), wordStart = -1;
+  QChar lastSep;
+  for(int i = 0; i <= size; i++)
+  {
+    if(i < size && isAsciiLetterOrNumber(data[i].toLatin1()))
+    {
+      if(wordStart == -1)
+        wordStart = i;
+      continue;
+    }
+
+    if(wordStart != -1)
+    {
+      capWordAscii(data + wordStart, i - wordStart, lastSep, buffer, toUpper, toLower, ignore);
+      wordStart = -1;
+    }
+
+    if(i < size)
+    {
+      lastSep = data[i];
+      if(data[i] == '_')
+        data[i] = ' ';
+    }
+  }
+  return retval;
+}
+
 QString capString(const QString& str, const QSet<QString>& toUpper, const QSet<QString>& toLower,
                   const QSet<QString>& ignore)
 {
   if(str.isEmpty())
     return str;
 
+  if(isAscii(str))
+    return capStringAscii(str, toUpper, toLower, ignore);
+
   QString retval, lastWord;
   QChar last, lastSep;
   for(QChar c : str)
@@ -143,6 +143,9 @@ QTextCodec *codecForFile(QFile& file, QTextCodec *defaultCodec = nullptr);
  *  All trimmed and converted to lower case. */
 QStringList probeFile(const QString& file, int numLinesRead = 6);
 
+/* Same as above for the beginning of a file already loaded into memory. Does not throw. */
+QStringList probeBytes(const QByteArray& bytes, int numLinesRead = 6);
+
 /* Calculate the step size for an axis along a range for number of steps.
  * Steps will stick to the 1, 2, and 5 range */
 float calculateSteps(float range, float numSteps);
@@ -196,6 +199,55 @@ inline char latin1CharAt(const QString& str, int index)
   return index >= 0 && index < str.size() ? str.at(index).toLatin1() : '\0';
 }
 
+/* true if all characters are in the ASCII range. Allows to use the locale independent fast paths below. */
+inline bool isAscii(const QString& str)
+{
+  for(QChar c : str)
+  {
+    if(c.unicode() > 127)
+      return false;
+  }
+  return true;
+}
+
+/* Character class checks for ASCII characters which do not need the Unicode tables of QChar */
+Q_DECL_CONSTEXPR inline bool isAsciiDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+Q_DECL_CONSTEXPR inline bool isAsciiUpper(char c)
+{
+  return c >= 'A' && c <= 'Z';
+}
+
+Q_DECL_CONSTEXPR inline bool isAsciiLower(char c)
+{
+  return c >= 'a' && c <= 'z';
+}
+
+Q_DECL_CONSTEXPR inline bool isAsciiLetterOrNumber(char c)
+{
+  return isAsciiDigit(c) || isAsciiUpper(c) || isAsciiLower(c);
+}
+
+/* Same as \s in a regular expression */
+Q_DECL_CONSTEXPR inline bool isAsciiSpace(char c)
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/* Changes case of ASCII letters only */
+Q_DECL_CONSTEXPR inline char latin1ToUpper(char c)
+{
+  return isAsciiLower(c) ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+Q_DECL_CONSTEXPR inline char latin1ToLower(char c)
+{
+  return isAsciiUpper(c) ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
 template<typename TYPE>
 const TYPE& at(const QList<TYPE>& list, int index, const TYPE& defaultType = TYPE())
 {
@@ -19,6 +19,7 @@
 #include "fs/bgl/recordtypes.h"
 #include "fs/util/fsutil.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/bgl/converter.h"
 #include "fs/navdatabaseoptions.h"
 #include "fs/bgl/ap/jetway.h"
@@ -78,8 +79,9 @@ Airport::Airport(const NavDatabaseOptions *options, BinaryStream *bs,
   magVar = converter::adjustMagvar(bs->readFloat());
   ident = converter::intToIcao(bs->readUInt());
 
-  // Check if the airport is filtered out in the configuration file
-  if(!options->isIncludedAirportIdent(ident))
+  // Check if the airport is filtered out in the configuration file by ident or position
+  // before reading any subrecords
+  if(!options->isIncludedAirportIdent(ident) || !options->isIncludedAirportPos(position.getPos()))
   {
     // Stop reading
     seekToStart();
@@ -87,7 +89,7 @@ Airport::Airport(const NavDatabaseOptions *options, BinaryStream *bs,
     return;
   }
 
-  region = converter::intToIcao(bs->readUInt()); // TODO wiki is always null
+  region = atools::util::intern(converter::intToIcao(bs->readUInt())); // TODO wiki is always null
 
   fuelFlags = static_cast<ap::FuelFlags>(bs->readUInt());
 
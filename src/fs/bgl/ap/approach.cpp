@@ -19,6 +19,7 @@
 #include "fs/bgl/converter.h"
 #include "fs/bgl/recordtypes.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/navdatabaseoptions.h"
 
 #include <QDebug>
@@ -78,8 +79,8 @@ Approach::Approach(const NavDatabaseOptions *options, BinaryStream *bs, bool sid
     fixIdent = converter::intToIcao((fixFlags >> 5) & 0xfffffff, true);
 
     unsigned int fixIdentFlags = bs->readUInt();
-    fixRegion = converter::intToIcao(fixIdentFlags & 0x7ff, true);
-    fixAirportIdent = converter::intToIcao((fixIdentFlags >> 11) & 0x1fffff, true);
+    fixRegion = atools::util::intern(converter::intToIcao(fixIdentFlags & 0x7ff, true));
+    fixAirportIdent = atools::util::intern(converter::intToIcao((fixIdentFlags >> 11) & 0x1fffff, true));
 
     altitude = bs->readFloat();
     heading = bs->readFloat(); // Heading is float degrees
@@ -17,6 +17,7 @@
 
 #include "fs/bgl/ap/approachleg.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/bgl/converter.h"
 #include "fs/bgl/ap/approach.h"
 
@@ -44,13 +45,13 @@ ApproachLeg::ApproachLeg(io::BinaryStream *bs, bool ismissed, bool msfs)
   fixIdent = converter::intToIcao((fixFlags >> 5) & 0xfffffff, true);
 
   unsigned int fixIdentFlags = bs->readUInt();
-  fixRegion = converter::intToIcao(fixIdentFlags & 0x7ff, true);
-  fixAirportIdent = converter::intToIcao((fixIdentFlags >> 11) & 0x1fffff, true);
+  fixRegion = atools::util::intern(converter::intToIcao(fixIdentFlags & 0x7ff, true));
+  fixAirportIdent = atools::util::intern(converter::intToIcao((fixIdentFlags >> 11) & 0x1fffff, true));
 
   unsigned int recFixFlags = bs->readUInt();
   recommendedFixType = static_cast<ap::fix::ApproachFixType>(recFixFlags & 0xf);
   recommendedFixIdent = converter::intToIcao((recFixFlags >> 5) & 0xfffffff, true);
-  recommendedFixRegion = converter::intToIcao(bs->readUInt() & 0x7ff, true);
+  recommendedFixRegion = atools::util::intern(converter::intToIcao(bs->readUInt() & 0x7ff, true));
 
   theta = bs->readFloat(); // heading
   rho = bs->readFloat(); // distance
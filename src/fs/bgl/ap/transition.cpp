@@ -20,6 +20,7 @@
 #include "fs/bgl/recordtypes.h"
 #include "fs/bgl/converter.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/navdatabaseoptions.h"
 
 namespace atools {
@@ -85,8 +86,8 @@ Transition::Transition(const NavDatabaseOptions *options, BinaryStream *bs)
   transFixIdent = converter::intToIcao((transFixFlags >> 5) & 0xfffffff, true);
 
   unsigned int fixIdentFlags = bs->readUInt();
-  fixRegion = converter::intToIcao(fixIdentFlags & 0x7ff, true);
-  fixAirportIdent = converter::intToIcao((fixIdentFlags >> 11) & 0x1fffff, true);
+  fixRegion = atools::util::intern(converter::intToIcao(fixIdentFlags & 0x7ff, true));
+  fixAirportIdent = atools::util::intern(converter::intToIcao((fixIdentFlags >> 11) & 0x1fffff, true));
 
   altitude = bs->readFloat();
 
@@ -94,8 +95,8 @@ Transition::Transition(const NavDatabaseOptions *options, BinaryStream *bs)
   {
     dmeIdent = converter::intToIcao(bs->readUInt());
     unsigned int tempFixIdentFlags = bs->readUInt();
-    dmeRegion = converter::intToIcao(tempFixIdentFlags & 0x7ff, true);
-    dmeAirportIdent = converter::intToIcao((tempFixIdentFlags >> 11) & 0x1fffff, true);
+    dmeRegion = atools::util::intern(converter::intToIcao(tempFixIdentFlags & 0x7ff, true));
+    dmeAirportIdent = atools::util::intern(converter::intToIcao((tempFixIdentFlags >> 11) & 0x1fffff, true));
     dmeRadial = bs->readInt();
     dmeDist = bs->readFloat();
   }
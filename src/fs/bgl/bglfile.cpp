@@ -33,6 +33,7 @@
 #include "fs/bgl/boundary.h"
 #include "fs/bgl/recordtypes.h"
 #include "fs/scenery/sceneryarea.h"
+#include "util/trace.h"
 
 #include <QList>
 #include <QDebug>
@@ -58,6 +59,8 @@ BglFile::~BglFile()
 
 void BglFile::readFile(QString file, const atools::fs::scenery::SceneryArea& area)
 {
+  ATOOLS_TRACE_SCOPE("BglFile::readFile", "bgl");
+
   deleteAllObjects();
   filename = file;
 
@@ -71,7 +74,8 @@ void BglFile::readFile(QString file, const atools::fs::scenery::SceneryArea& are
 
   if(ifs.open(QIODevice::ReadOnly))
   {
-    BinaryStream bs(&ifs);
+    // Memory mapped reading avoids a stream call for each value
+    BinaryStream bs(&ifs, QDataStream::LittleEndian, true /* memoryMapped */);
 
     this->filename = file;
     this->size = bs.getFileSize();
@@ -188,8 +192,8 @@ void BglFile::readSections(BinaryStream *bs)
   {
     Section s = Section(options, bs);
 
-    // Add only supported sections to the list
-    if(supportedSectionTypes.contains(s.getType()))
+    // Add only supported sections to the list which are not excluded by options
+    if(supportedSectionTypes.contains(s.getType()) && isSectionIncluded(s.getType()))
     {
       if(options->isVerbose())
         qDebug() << "Section" << s;
@@ -219,6 +223,35 @@ void BglFile::readSections(BinaryStream *bs)
   }
 }
 
+bool BglFile::isSectionIncluded(section::SectionType type) const
+{
+  switch(type)
+  {
+    case section::AIRPORT:
+    case section::AIRPORT_ALT:
+    case section::NAME_LIST: // Name lists are only used for airports
+      return options->isIncludedNavDbObject(type::AIRPORT);
+
+    case section::ILS_VOR:
+      return options->isIncludedNavDbObject(type::VOR) || options->isIncludedNavDbObject(type::ILS);
+
+    case section::NDB:
+      return options->isIncludedNavDbObject(type::NDB);
+
+    case section::MARKER:
+      return options->isIncludedNavDbObject(type::MARKER);
+
+    case section::WAYPOINT:
+      return options->isIncludedNavDbObject(type::WAYPOINT);
+
+    case section::BOUNDARY:
+      return options->isIncludedNavDbObject(type::BOUNDARY);
+
+    default:
+      return true;
+  }
+}
+
 const Record *BglFile::handleIlsVor(BinaryStream *bs)
 {
   // Read only type before creating concrete object
@@ -391,8 +424,11 @@ void BglFile::deleteAllObjects()
   sections.clear();
   subsections.clear();
 
-  qDeleteAll(allRecords);
+  // Memory is released by the arena
+  for(const Record *rec : allRecords)
+    rec->~Record();
   allRecords.clear();
+  arena.reset();
 
   filename = QString();
   size = 0;
@@ -24,6 +24,7 @@
 #include "fs/bgl/subsection.h"
 #include "fs/navdatabaseoptions.h"
 #include "io/binarystream.h"
+#include "util/arena.h"
 
 #include <QString>
 #include <QList>
@@ -164,6 +165,9 @@ private:
   void readSections(atools::io::BinaryStream *bs);
 
   void readRecords(atools::io::BinaryStream *bs, const atools::fs::scenery::SceneryArea& area);
+
+  /* false if all records of the section type are excluded by options. Avoids reading subsections and records. */
+  bool isSectionIncluded(atools::fs::bgl::section::SectionType type) const;
   const Record *handleIlsVor(atools::io::BinaryStream *bs);
 
   /* Boundaries are a special mess since it is not well documented */
@@ -184,6 +188,9 @@ private:
   /* Keep a list of all records to make object deletion easier */
   QList<const atools::fs::bgl::Record *> allRecords;
 
+  /* All records are allocated here and released at once when reading the next file */
+  atools::util::Arena arena;
+
   QList<const atools::fs::bgl::Airport *> airports;
   QList<const atools::fs::bgl::Namelist *> namelists;
   QList<const atools::fs::bgl::Vor *> vors;
@@ -207,11 +214,11 @@ private:
 template<typename TYPE>
 const TYPE *BglFile::createRecord(atools::io::BinaryStream *bs, QList<const TYPE *> *list)
 {
-  TYPE *rec = new TYPE(options, bs);
+  TYPE *rec = arena.create<TYPE>(options, bs);
 
   if(rec->isExcluded())
   {
-    delete rec;
+    rec->~TYPE();
     return nullptr;
   }
 
@@ -221,7 +228,7 @@ const TYPE *BglFile::createRecord(atools::io::BinaryStream *bs, QList<const TYPE
     if(!rec->isDisabled())
       qWarning() << "Found invalid record: " << rec->getObjectName();
     rec->seekToStart();
-    delete rec;
+    rec->~TYPE();
     return nullptr;
   }
 
@@ -241,11 +248,11 @@ template<typename TYPE>
 const TYPE *BglFile::createRecord(atools::io::BinaryStream *bs, QList<const TYPE *> *list,
                                   atools::fs::bgl::flags::CreateFlags flags)
 {
-  TYPE *rec = new TYPE(options, bs, flags);
+  TYPE *rec = arena.create<TYPE>(options, bs, flags);
 
   if(rec->isExcluded())
   {
-    delete rec;
+    rec->~TYPE();
     return nullptr;
   }
 
@@ -255,7 +262,7 @@ const TYPE *BglFile::createRecord(atools::io::BinaryStream *bs, QList<const TYPE
     if(!rec->isDisabled())
       qWarning() << "Found invalid record: " << rec->getObjectName();
     rec->seekToStart();
-    delete rec;
+    rec->~TYPE();
     return nullptr;
   }
 
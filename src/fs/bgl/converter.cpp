@@ -18,7 +18,6 @@
 #include "fs/bgl/converter.h"
 #include "exception.h"
 
-#include <QVarLengthArray>
 #include <QDebug>
 
 namespace atools {
@@ -26,11 +25,10 @@ namespace fs {
 namespace bgl {
 namespace converter {
 
-static const char *RUNWAY_DESIGNATORS[] = {"", "L", "R", "C", "W", "A", "B"};
+static constexpr const char *RUNWAY_DESIGNATORS[] = {"", "L", "R", "C", "W", "A", "B"};
 
 QString intToIcao(unsigned int icao, bool noBitShift)
 {
-  QString icaoStr;
   unsigned int value = icao;
   // The ICAO identifiers for primary and secondary ILS in a runway record are not shifted.
   if(!noBitShift)
@@ -39,46 +37,37 @@ QString intToIcao(unsigned int icao, bool noBitShift)
   if(value == 0)
     return QString();
 
-  QVarLengthArray<unsigned int, 5> codedArr({0, 0, 0, 0, 0});
-  unsigned int coded = 0;
-
-  // First extract the coded/compressed values
-  int idx = 0;
-  if(value > 37)
+  // First extract the coded/compressed base 38 values - least significant first
+  unsigned int codedArr[5];
+  int numCoded = 0;
+  while(value > 0)
   {
-    while(value > 37)
-    {
-      if(idx >= codedArr.size())
-        return QString();
-
-      coded = value % 38;
-      codedArr[idx++] = coded;
-      value = (value - coded) / 38;
-      if(value < 38)
-      {
-        if(idx >= codedArr.size())
-          return QString();
-
-        coded = value;
-        codedArr[idx++] = coded;
-      }
-    }
+    if(numCoded >= 5)
+      return QString();
+
+    codedArr[numCoded++] = value % 38;
+    value /= 38;
   }
-  else
-    codedArr[idx++] = value;
 
-  // Convert the decompressed bytes to characters
-  for(int i = 0; i < 5; i++)
+  // Characters end at the first zero value
+  int len = 0;
+  while(len < numCoded && codedArr[len] != 0)
+    len++;
+
+  if(len == 0)
+    return QString();
+
+  // Convert the decompressed values to characters - most significant first
+  char icaoChars[5];
+  for(int i = 0; i < len; i++)
   {
-    coded = codedArr.at(i);
-    if(coded == 0)
-      break;
+    unsigned int coded = codedArr[i];
     if(coded > 1 && coded < 12)
-      icaoStr.insert(0, '0' + (coded - 2));
+      icaoChars[len - 1 - i] = static_cast<char>('0' + (coded - 2));
     else
-      icaoStr.insert(0, 'A' + (coded - 12));
+      icaoChars[len - 1 - i] = static_cast<char>('A' + (coded - 12));
   }
-  return icaoStr;
+  return QString::fromLatin1(icaoChars, len);
 }
 
 QString designatorStr(int designator)
@@ -95,56 +84,55 @@ QString designatorStr(int designator)
 
 QString runwayToStr(int runwayNumber, int designator)
 {
-  QString retval;
-  if(runwayNumber < 10)
-  {
-    // Normal one digit runway number with leading zero
-    retval += "0";
-    retval += static_cast<char>(runwayNumber) + '0';
-  }
-  else if(runwayNumber > 36)
+  if(runwayNumber > 36)
   {
     // Special runway number code
     switch(runwayNumber)
     {
       case 37:
-        return "N";
+        return QStringLiteral("N");
 
       case 38:
-        return "NE";
+        return QStringLiteral("NE");
 
       case 39:
-        return "E";
+        return QStringLiteral("E");
 
       case 40:
-        return "SE";
+        return QStringLiteral("SE");
 
       case 41:
-        return "S";
+        return QStringLiteral("S");
 
       case 42:
-        return "SW";
+        return QStringLiteral("SW");
 
       case 43:
-        return "W";
+        return QStringLiteral("W");
 
       case 44:
-        return "NW";
+        return QStringLiteral("NW");
 
       default:
         qWarning() << "Runway number out of range in runwayToStr()" << runwayNumber;
     }
   }
-  else
+
+  // Runway number with leading zero and designator if there is one
+  char runway[3];
+  int len = 0;
+  if(runwayNumber <= 36)
   {
-    // Normal two digit runway number without leading zero
-    retval += static_cast<char>(runwayNumber / 10) + '0';
-    retval += static_cast<char>(runwayNumber % 10) + '0';
+    runway[len++] = static_cast<char>(runwayNumber / 10 + '0');
+    runway[len++] = static_cast<char>(runwayNumber % 10 + '0');
   }
-  // Add designator if there is one
-  retval += designatorStr(designator);
-  return retval;
 
+  if(designator >= 1 && designator <= 6)
+    runway[len++] = RUNWAY_DESIGNATORS[designator][0];
+  else if(designator != 0)
+    qWarning() << "Value for designator out of range in designatorStr()" << designator;
+
+  return len > 0 ? QString::fromLatin1(runway, len) : QString();
 }
 
 time_t filetime(unsigned int lowDateTime, unsigned int highDateTime)
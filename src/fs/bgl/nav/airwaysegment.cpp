@@ -18,6 +18,7 @@
 #include "fs/bgl/nav/airwaysegment.h"
 #include "fs/bgl/converter.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/bgl/nav/waypoint.h"
 
 namespace atools {
@@ -51,7 +52,7 @@ AirwaySegment::AirwaySegment(const atools::fs::NavDatabaseOptions *options, Bina
   : BglBase(options, bs)
 {
   type = static_cast<nav::AirwayType>(bs->readUByte());
-  name = bs->readString(8, atools::io::LATIN1);
+  name = atools::util::intern(bs->readString(8, atools::io::LATIN1));
 
   mid = AirwayWaypoint(waypoint);
   next = AirwayWaypoint(options, bs);
@@ -18,6 +18,7 @@
 #include "fs/bgl/nav/airwaywaypoint.h"
 #include "fs/bgl/converter.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/bgl/nav/waypoint.h"
 
 namespace atools {
@@ -64,8 +65,8 @@ AirwayWaypoint::AirwayWaypoint(const atools::fs::NavDatabaseOptions *options, at
 
   type = static_cast<nav::AirwayWaypointType>(nextFlags & 0x7);
   ident = converter::intToIcao((nextFlags >> 5) & 0x7ffffff, true);
-  region = converter::intToIcao(nextIdFlags & 0x7ff, true);
-  airportIdent = converter::intToIcao((nextIdFlags >> 11) & 0xfffff, true);
+  region = atools::util::intern(converter::intToIcao(nextIdFlags & 0x7ff, true));
+  airportIdent = atools::util::intern(converter::intToIcao((nextIdFlags >> 11) & 0xfffff, true));
 }
 
 AirwayWaypoint::~AirwayWaypoint()
@@ -23,6 +23,7 @@
 #include "fs/bgl/converter.h"
 #include "fs/bgl/recordtypes.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/navdatabaseoptions.h"
 
 namespace atools {
@@ -64,9 +65,9 @@ Ils::Ils(const NavDatabaseOptions *options, BinaryStream *bs)
 
   unsigned int regionFlags = bs->readUInt();
   // Two letter region code
-  region = converter::intToIcao(regionFlags & 0x7ff, true); // TODO wiki region is never set
+  region = atools::util::intern(converter::intToIcao(regionFlags & 0x7ff, true)); // TODO wiki region is never set
   // Read airport ICAO ident
-  airportIdent = converter::intToIcao((regionFlags >> 11) & 0x1fffff, true);
+  airportIdent = atools::util::intern(converter::intToIcao((regionFlags >> 11) & 0x1fffff, true));
 
   atools::io::Encoding encoding = options->getSimulatorType() ==
                                   atools::fs::FsPaths::MSFS ? atools::io::UTF8 : atools::io::LATIN1;
@@ -18,6 +18,7 @@
 #include "fs/bgl/nav/marker.h"
 #include "fs/bgl/converter.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 
 namespace atools {
 namespace fs {
@@ -65,7 +66,7 @@ Marker::Marker(const NavDatabaseOptions *options, BinaryStream *bs)
 
   position = BglPosition(bs, true, 1000.f);
   ident = converter::intToIcao(bs->readUInt());
-  region = converter::intToIcao(bs->readUInt()); // TODO wiki is always null
+  region = atools::util::intern(converter::intToIcao(bs->readUInt())); // TODO wiki is always null
 }
 
 Marker::~Marker()
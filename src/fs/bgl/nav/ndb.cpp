@@ -19,6 +19,7 @@
 #include "fs/bgl/converter.h"
 #include "fs/bgl/recordtypes.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/navdatabaseoptions.h"
 
 namespace atools {
@@ -58,8 +59,8 @@ Ndb::Ndb(const NavDatabaseOptions *options, BinaryStream *bs)
   ident = converter::intToIcao(bs->readUInt());
 
   unsigned int regionFlags = bs->readUInt();
-  region = converter::intToIcao(regionFlags & 0x7ff, true);
-  airportIdent = converter::intToIcao((regionFlags >> 11) & 0x1fffff, true);
+  region = atools::util::intern(converter::intToIcao(regionFlags & 0x7ff, true));
+  airportIdent = atools::util::intern(converter::intToIcao((regionFlags >> 11) & 0x1fffff, true));
 
   atools::io::Encoding encoding = options->getSimulatorType() ==
                                   atools::fs::FsPaths::MSFS ? atools::io::UTF8 : atools::io::LATIN1;
@@ -21,6 +21,7 @@
 #include "fs/bgl/nav/dme.h"
 #include "fs/bgl/nav/glideslope.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/bgl/converter.h"
 #include "fs/bgl/recordtypes.h"
 #include "fs/navdatabaseoptions.h"
@@ -44,8 +45,8 @@ Tacan::Tacan(const NavDatabaseOptions *options, BinaryStream *bs)
   magVar = converter::adjustMagvar(bs->readFloat());
   ident = converter::intToIcao(bs->readUInt());
   unsigned int regionFlags = bs->readUInt();
-  region = converter::intToIcao(regionFlags & 0x7ff, true);
-  airportIdent = converter::intToIcao((regionFlags >> 11) & 0x1fffff, true);
+  region = atools::util::intern(converter::intToIcao(regionFlags & 0x7ff, true));
+  airportIdent = atools::util::intern(converter::intToIcao((regionFlags >> 11) & 0x1fffff, true));
 
   atools::io::Encoding encoding = options->getSimulatorType() ==
                                   atools::fs::FsPaths::MSFS ? atools::io::UTF8 : atools::io::LATIN1;
@@ -20,6 +20,7 @@
 #include "fs/bgl/nav/dme.h"
 #include "fs/bgl/nav/glideslope.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 
 #include "fs/bgl/converter.h"
 #include "fs/bgl/recordtypes.h"
@@ -65,10 +66,10 @@ Vor::Vor(const NavDatabaseOptions *options, BinaryStream *bs)
   ident = converter::intToIcao(bs->readUInt());
 
   unsigned int regionFlags = bs->readUInt();
-  region = converter::intToIcao(regionFlags & 0x7ff, true);
+  region = atools::util::intern(converter::intToIcao(regionFlags & 0x7ff, true));
 
   // TODO report wiki error ap ident is never set
-  airportIdent = converter::intToIcao((regionFlags >> 11) & 0x1fffff, true);
+  airportIdent = atools::util::intern(converter::intToIcao((regionFlags >> 11) & 0x1fffff, true));
   atools::io::Encoding encoding = options->getSimulatorType() ==
                                   atools::fs::FsPaths::MSFS ? atools::io::UTF8 : atools::io::LATIN1;
 
@@ -19,6 +19,7 @@
 #include "fs/bgl/converter.h"
 #include "fs/bgl/nav/airwaysegment.h"
 #include "io/binarystream.h"
+#include "util/stringinterner.h"
 #include "fs/navdatabaseoptions.h"
 
 namespace atools {
@@ -93,8 +94,8 @@ Waypoint::Waypoint(const NavDatabaseOptions *options, BinaryStream *bs)
   ident = converter::intToIcao(identInt);
 
   unsigned int regionFlags = bs->readUInt();
-  region = converter::intToIcao(regionFlags & 0x7ff, true);
-  airportIdent = converter::intToIcao((regionFlags >> 11) & 0x1fffff, true);
+  region = atools::util::intern(converter::intToIcao(regionFlags & 0x7ff, true));
+  airportIdent = atools::util::intern(converter::intToIcao((regionFlags >> 11) & 0x1fffff, true));
 
   if(region.isEmpty() && !isDisabled())
     qWarning().nospace().noquote() << "Waypoint at " << position << " ident " << ident << " has no region";
@@ -20,6 +20,7 @@
 #include "io/binarystream.h"
 #include "fs/bgl/converter.h"
 #include "fs/navdatabaseoptions.h"
+#include "util/stringinterner.h"
 
 namespace atools {
 namespace fs {
@@ -75,7 +76,7 @@ Namelist::Namelist(const NavDatabaseOptions *options, BinaryStream *bs)
     icaoRec.cityName = cities.value(bs->readShort());
     icaoRec.airportName = airports.value(bs->readShort());
     icaoRec.airportIdent = converter::intToIcao(bs->readUInt());
-    icaoRec.regionIdent = converter::intToIcao(bs->readUInt());
+    icaoRec.regionIdent = atools::util::intern(converter::intToIcao(bs->readUInt()));
 
     bs->skip(4); // QMID Level 9 Square.
 
@@ -100,7 +101,8 @@ void Namelist::readList(QStringList& names, BinaryStream *bs, int numNames, int
   for(int i = 0; i < numNames; i++)
   {
     bs->seekg(offs + indexes[i]);
-    names.append(bs->readString(encoding));
+    // Names repeat across the BGL files - share them between all lists of the compilation
+    names.append(atools::util::intern(bs->readString(encoding)));
   }
   delete[] indexes;
 }
@@ -29,46 +29,46 @@ QString recordTypeStr(rec::RecordType type)
   switch(type)
   {
     case rec::AIRPORT:
-      return "AIRPORT";
+      return QStringLiteral("AIRPORT");
 
     case rec::WAYPOINT:
-      return "WAYPOINT";
+      return QStringLiteral("WAYPOINT");
 
     case rec::AIRPORTSUMMARY:
-      return "AIRPORTSUMMARY";
+      return QStringLiteral("AIRPORTSUMMARY");
 
     case rec::ILS_VOR:
-      return "ILS_VOR";
+      return QStringLiteral("ILS_VOR");
 
     case rec::NDB:
-      return "NDB";
+      return QStringLiteral("NDB");
 
     case rec::SCENERYOBJECT:
-      return "SCENERYOBJECT";
+      return QStringLiteral("SCENERYOBJECT");
 
     case rec::MARKER:
-      return "MARKER";
+      return QStringLiteral("MARKER");
 
     case rec::BOUNDARY:
-      return "BOUNDARY";
+      return QStringLiteral("BOUNDARY");
 
     case rec::GEOPOL:
-      return "GEOPOL";
+      return QStringLiteral("GEOPOL");
 
     case rec::NAMELIST:
-      return "NAMELIST";
+      return QStringLiteral("NAMELIST");
 
     case rec::VOR_ILS_ICAO_INDEX:
-      return "VOR_ILS_ICAO_INDEX";
+      return QStringLiteral("VOR_ILS_ICAO_INDEX");
 
     case rec::NDB_ICAO_INDEX:
-      return "NDB_ICAO_INDEX";
+      return QStringLiteral("NDB_ICAO_INDEX");
 
     case rec::WAYPOINT_ICAO_INDEX:
-      return "WAYPOINT_ICAO_INDEX";
+      return QStringLiteral("WAYPOINT_ICAO_INDEX");
   }
   qWarning().nospace().noquote() << "Invalid record type " << type;
-  return "INVALID";
+  return QStringLiteral("INVALID");
 }
 
 QString airportRecordTypeStr(rec::AirportRecordType type)
@@ -77,133 +77,133 @@ QString airportRecordTypeStr(rec::AirportRecordType type)
   {
     // Unknown but common records from MSFS to silence warnings
     case rec::UNKNOWN_MSFS_00CF:
-      return "UNKNOWN_MSFS_00CF";
+      return QStringLiteral("UNKNOWN_MSFS_00CF");
 
     case rec::UNKNOWN_MSFS_00DE:
-      return "UNKNOWN_MSFS_00DE";
+      return QStringLiteral("UNKNOWN_MSFS_00DE");
 
     case rec::UNKNOWN_MSFS_00D9:
-      return "UNKNOWN_MSFS_00D9";
+      return QStringLiteral("UNKNOWN_MSFS_00D9");
 
     case rec::UNKNOWN_MSFS_00DD:
-      return "UNKNOWN_MSFS_00DD";
+      return QStringLiteral("UNKNOWN_MSFS_00DD");
 
     case rec::UNKNOWN_MSFS_00D8:
-      return "UNKNOWN_MSFS_00D8";
+      return QStringLiteral("UNKNOWN_MSFS_00D8");
 
     case rec::UNKNOWN_MSFS_0057:
-      return "UNKNOWN_MSFS_0057";
+      return QStringLiteral("UNKNOWN_MSFS_0057");
 
     case rec::SID_MSFS:
-      return "SID_MSFS";
+      return QStringLiteral("SID_MSFS");
 
     case rec::STAR_MSFS:
-      return "STAR_MSFS";
+      return QStringLiteral("STAR_MSFS");
 
     case rec::UNKNOWN_MSFS_00CD:
-      return "UNKNOWN_MSFS_00CD";
+      return QStringLiteral("UNKNOWN_MSFS_00CD");
 
     case rec::NAME:
-      return "NAME";
+      return QStringLiteral("NAME");
 
     case rec::TOWER_OBJ:
-      return "TOWER_OBJ";
+      return QStringLiteral("TOWER_OBJ");
 
     case rec::RUNWAY:
-      return "RUNWAY";
+      return QStringLiteral("RUNWAY");
 
     case rec::RUNWAY_P3D_V4:
-      return "RUNWAY_P3D_V4";
+      return QStringLiteral("RUNWAY_P3D_V4");
 
     case rec::RUNWAY_MSFS:
-      return "RUNWAY_MSFS";
+      return QStringLiteral("RUNWAY_MSFS");
 
     case rec::AIRPORT_WAYPOINT:
-      return "AIRPORT_WAYPOINT";
+      return QStringLiteral("AIRPORT_WAYPOINT");
 
     case rec::HELIPAD:
-      return "HELIPAD";
+      return QStringLiteral("HELIPAD");
 
     case rec::START:
-      return "START";
+      return QStringLiteral("START");
 
     case rec::COM:
-      return "COM";
+      return QStringLiteral("COM");
 
     case rec::DELETE_AIRPORT:
-      return "DELETE_AIRPORT";
+      return QStringLiteral("DELETE_AIRPORT");
 
     case rec::APRON_FIRST:
-      return "APRON_FIRST";
+      return QStringLiteral("APRON_FIRST");
 
     case rec::APRON_FIRST_P3D_V5:
-      return "APRON_FIRST_P3D_V5";
+      return QStringLiteral("APRON_FIRST_P3D_V5");
 
     case rec::APRON_FIRST_MSFS:
-      return "APRON_FIRST_MSFS";
+      return QStringLiteral("APRON_FIRST_MSFS");
 
     case rec::APRON_SECOND:
-      return "APRON_SECOND";
+      return QStringLiteral("APRON_SECOND");
 
     case rec::APRON_SECOND_P3D_V4:
-      return "APRON_SECOND_P3D_V4";
+      return QStringLiteral("APRON_SECOND_P3D_V4");
 
     case rec::APRON_SECOND_P3D_V5:
-      return "APRON_SECOND_P3D_V5";
+      return QStringLiteral("APRON_SECOND_P3D_V5");
 
     case rec::APRON_EDGE_LIGHTS:
-      return "APRON_EDGE_LIGHTS";
+      return QStringLiteral("APRON_EDGE_LIGHTS");
 
     case rec::TAXI_POINT:
-      return "TAXI_POINT";
+      return QStringLiteral("TAXI_POINT");
 
     case rec::TAXI_POINT_P3DV5:
-      return "TAXI_POINT_P3DV5";
+      return QStringLiteral("TAXI_POINT_P3DV5");
 
     case rec::TAXI_PARKING:
-      return "TAXI_PARKING";
+      return QStringLiteral("TAXI_PARKING");
 
     case rec::TAXI_PARKING_P3D_V5:
-      return "TAXI_PARKING_P3D_V5";
+      return QStringLiteral("TAXI_PARKING_P3D_V5");
 
     case rec::TAXI_PARKING_MSFS:
-      return "TAXI_PARKING_MSFS";
+      return QStringLiteral("TAXI_PARKING_MSFS");
 
     case rec::TAXI_PARKING_FS9:
-      return "TAXI_PARKING_FS9";
+      return QStringLiteral("TAXI_PARKING_FS9");
 
     case rec::TAXI_PATH:
-      return "TAXI_PATH";
+      return QStringLiteral("TAXI_PATH");
 
     case rec::TAXI_PATH_P3D_V4:
-      return "TAXI_PATH_P3D_V4";
+      return QStringLiteral("TAXI_PATH_P3D_V4");
 
     case rec::TAXI_PATH_P3D_V5:
-      return "TAXI_PATH_P3D_V5";
+      return QStringLiteral("TAXI_PATH_P3D_V5");
 
     case rec::TAXI_NAME:
-      return "TAXI_NAME";
+      return QStringLiteral("TAXI_NAME");
 
     case rec::JETWAY:
-      return "JETWAY";
+      return QStringLiteral("JETWAY");
 
     case rec::APPROACH:
-      return "APPROACH";
+      return QStringLiteral("APPROACH");
 
     case rec::FENCE_BLAST:
-      return "FENCE_BLAST";
+      return QStringLiteral("FENCE_BLAST");
 
     case rec::FENCE_BOUNDARY:
-      return "FENCE_BOUNDARY";
+      return QStringLiteral("FENCE_BOUNDARY");
 
     case rec::UNKNOWN_003B:
-      return "UNKNOWN_REC_003B";
+      return QStringLiteral("UNKNOWN_REC_003B");
 
     case rec::TAXI_PATH_MSFS:
-      return "TAXI_PATH_MSFS";
+      return QStringLiteral("TAXI_PATH_MSFS");
   }
   // qWarning().nospace().noquote() << "Invalid airport record type " << type;
-  return "INVALID";
+  return QStringLiteral("INVALID");
 }
 
 bool airportRecordTypeValid(rec::AirportRecordType type)
@@ -269,55 +269,55 @@ QString runwayRecordTypeStr(rec::RunwayRecordType type)
   {
     // Unknown but common records from MSFS to silence warnings
     case atools::fs::bgl::rec::UNKNOWN_MSFS_003E:
-      return "UNKNOWN_MSFS_003E";
+      return QStringLiteral("UNKNOWN_MSFS_003E");
 
     case atools::fs::bgl::rec::UNKNOWN_MSFS_00CB:
-      return "UNKNOWN_MSFS_00CB";
+      return QStringLiteral("UNKNOWN_MSFS_00CB");
 
     case rec::OFFSET_THRESHOLD_PRIM:
-      return "OFFSET_THRESHOLD_PRIM";
+      return QStringLiteral("OFFSET_THRESHOLD_PRIM");
 
     case rec::OFFSET_THRESHOLD_SEC:
-      return "OFFSET_THRESHOLD_SEC";
+      return QStringLiteral("OFFSET_THRESHOLD_SEC");
 
     case rec::BLAST_PAD_PRIM:
-      return "BLAST_PAD_PRIM";
+      return QStringLiteral("BLAST_PAD_PRIM");
 
     case rec::BLAST_PAD_SEC:
-      return "BLAST_PAD_SEC";
+      return QStringLiteral("BLAST_PAD_SEC");
 
     case rec::OVERRUN_PRIM:
-      return "OVERRUN_PRIM";
+      return QStringLiteral("OVERRUN_PRIM");
 
     case rec::OVERRUN_SEC:
-      return "OVERRUN_SEC";
+      return QStringLiteral("OVERRUN_SEC");
 
     case rec::VASI_PRIM_LEFT:
-      return "VASI_PRIM_LEFT";
+      return QStringLiteral("VASI_PRIM_LEFT");
 
     case rec::VASI_PRIM_RIGHT:
-      return "VASI_PRIM_RIGHT";
+      return QStringLiteral("VASI_PRIM_RIGHT");
 
     case rec::VASI_SEC_LEFT:
-      return "VASI_SEC_LEFT";
+      return QStringLiteral("VASI_SEC_LEFT");
 
     case rec::VASI_SEC_RIGHT:
-      return "VASI_SEC_RIGHT";
+      return QStringLiteral("VASI_SEC_RIGHT");
 
     case rec::APP_LIGHTS_PRIM:
-      return "APP_LIGHTS_PRIM";
+      return QStringLiteral("APP_LIGHTS_PRIM");
 
     case rec::APP_LIGHTS_PRIM_MSFS:
-      return "APP_LIGHTS_PRIM_MSFS";
+      return QStringLiteral("APP_LIGHTS_PRIM_MSFS");
 
     case rec::APP_LIGHTS_SEC:
-      return "APP_LIGHTS_SEC";
+      return QStringLiteral("APP_LIGHTS_SEC");
 
     case rec::APP_LIGHTS_SEC_MSFS:
-      return "APP_LIGHTS_SEC_MSFS";
+      return QStringLiteral("APP_LIGHTS_SEC_MSFS");
   }
   qWarning().nospace().noquote() << "Invalid runway record type " << type;
-  return "INVALID";
+  return QStringLiteral("INVALID");
 }
 
 QString approachRecordTypeStr(rec::ApprRecordType type)
@@ -325,28 +325,28 @@ QString approachRecordTypeStr(rec::ApprRecordType type)
   switch(type)
   {
     case rec::LEGS:
-      return "LEGS";
+      return QStringLiteral("LEGS");
 
     case rec::LEGS_MSFS:
-      return "LEGS_MSFS";
+      return QStringLiteral("LEGS_MSFS");
 
     case rec::MISSED_LEGS:
-      return "MISSED_LEGS";
+      return QStringLiteral("MISSED_LEGS");
 
     case rec::MISSED_LEGS_MSFS:
-      return "MISSED_LEGS_MSFS";
+      return QStringLiteral("MISSED_LEGS_MSFS");
 
     case rec::TRANSITION:
-      return "TRANSITION";
+      return QStringLiteral("TRANSITION");
 
     case rec::TRANSITION_MSFS:
-      return "TRANSITION_MSFS";
+      return QStringLiteral("TRANSITION_MSFS");
 
     case rec::TRANSITION_LEGS:
-      return "TRANS_LEGS";
+      return QStringLiteral("TRANS_LEGS");
   }
   qWarning().nospace().noquote() << "Invalid approach record type " << type;
-  return "INVALID";
+  return QStringLiteral("INVALID");
 }
 
 QString ilsvorRecordTypeStr(rec::IlsVorRecordType type)
@@ -354,19 +354,19 @@ QString ilsvorRecordTypeStr(rec::IlsVorRecordType type)
   switch(type)
   {
     case rec::LOCALIZER:
-      return "LOCALIZER";
+      return QStringLiteral("LOCALIZER");
 
     case rec::GLIDESLOPE:
-      return "GLIDESLOPE";
+      return QStringLiteral("GLIDESLOPE");
 
     case rec::DME:
-      return "DME";
+      return QStringLiteral("DME");
 
     case rec::ILS_VOR_NAME:
-      return "ILS_VOR_NAME";
+      return QStringLiteral("ILS_VOR_NAME");
   }
   qWarning().nospace().noquote() << "Invalid ILS/VOR type " << type;
-  return "INVALID";
+  return QStringLiteral("INVALID");
 }
 
 QString ndbRecordTypeStr(rec::NdbRecordType type)
@@ -374,10 +374,10 @@ QString ndbRecordTypeStr(rec::NdbRecordType type)
   switch(type)
   {
     case rec::NDB_NAME:
-      return "NDB_NAME";
+      return QStringLiteral("NDB_NAME");
   }
   qWarning().nospace().noquote() << "Invalid NDB type " << type;
-  return "INVALID";
+  return QStringLiteral("INVALID");
 }
 
 QString sceneryObjRecordTypeStr(rec::SceneryObjRecordType type)
@@ -385,29 +385,29 @@ QString sceneryObjRecordTypeStr(rec::SceneryObjRecordType type)
   switch(type)
   {
     case rec::SCENERYOBJECT_LIB_OBJECT:
-      return "SCENERYOBJECT_LIB_OBJECT";
+      return QStringLiteral("SCENERYOBJECT_LIB_OBJECT");
 
     case rec::SCENERYOBJECT_ATTACHED_OBJECT:
-      return "SCENERYOBJECT_ATTACHED_OBJECT";
+      return QStringLiteral("SCENERYOBJECT_ATTACHED_OBJECT");
 
     case rec::SCENERYOBJECT_EFFECT:
-      return "SCENERYOBJECT_EFFECT";
+      return QStringLiteral("SCENERYOBJECT_EFFECT");
 
     case rec::SCENERYOBJECT_GEN_BUILDING:
-      return "SCENERYOBJECT_GEN_BUILDING";
+      return QStringLiteral("SCENERYOBJECT_GEN_BUILDING");
 
     case rec::SCENERYOBJECT_WINDSOCK:
-      return "SCENERYOBJECT_WINDSOCK";
+      return QStringLiteral("SCENERYOBJECT_WINDSOCK");
 
     case rec::SCENERYOBJECT_EXT_BRIDGE:
-      return "SCENERYOBJECT_EXT_BRIDGE";
+      return QStringLiteral("SCENERYOBJECT_EXT_BRIDGE");
 
     case rec::SCENERYOBJECT_TRIGGER:
-      return "SCENERYOBJECT_TRIGGER";
+      return QStringLiteral("SCENERYOBJECT_TRIGGER");
   }
   qWarning().nospace().noquote() << "Invalid scenery object record type " << type;
 
-  return "INVALID";
+  return QStringLiteral("INVALID");
 }
 
 QString boundaryRecordTypeStr(rec::BoundaryRecordType type)
@@ -415,16 +415,16 @@ QString boundaryRecordTypeStr(rec::BoundaryRecordType type)
   switch(type)
   {
     case atools::fs::bgl::rec::BOUNDARY_COM:
-      return "BOUNDARY_COM";
+      return QStringLiteral("BOUNDARY_COM");
 
     case atools::fs::bgl::rec::BOUNDARY_NAME:
-      return "BOUNDARY_NAME";
+      return QStringLiteral("BOUNDARY_NAME");
 
     case rec::BOUNDARY_LINES:
-      return "BOUNDARY_LINES";
+      return QStringLiteral("BOUNDARY_LINES");
   }
   qWarning().nospace().noquote() << "Invalid boundary record type " << type;
-  return "INVALID";
+  return QStringLiteral("INVALID");
 }
 
 } // namespace rec
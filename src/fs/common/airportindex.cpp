@@ -32,7 +32,7 @@ AirportIndex::AirportIndex()
 
 bool AirportIndex::addAirportIdent(const QString& ident)
 {
-  Name idxName(ident);
+  Name idxName = name(ident);
   if(airportIdents.contains(idxName))
     return false;
 
@@ -44,7 +44,7 @@ QVariant AirportIndex::getAirportId(const QString& ident) const
 {
   if(!ident.isEmpty() && ident != EN_ROUTE)
   {
-    int id = identToIdMap.value(Name(ident), -1);
+    int id = identToIdMap.value(name(ident), -1);
     if(id != -1)
       return id;
   }
@@ -57,7 +57,7 @@ QVariant AirportIndex::getRunwayEndId(const QString& ident, const QString& runwa
 
   if(!ident.isEmpty())
   {
-    int id = identRunwayNameToEndId.value(Name2(ident, runwayName), -1);
+    int id = identRunwayNameToEndId.value(name(ident, runwayName), -1);
     if(id != -1)
       return id;
   }
@@ -66,41 +66,41 @@ QVariant AirportIndex::getRunwayEndId(const QString& ident, const QString& runwa
 
 bool AirportIndex::addAirportId(const QString& ident, int airportId)
 {
-  if(identToIdMap.contains(Name(ident)))
+  if(identToIdMap.contains(name(ident)))
     return false;
   else
   {
-    identToIdMap.insert(Name(ident), airportId);
+    identToIdMap.insert(name(ident), airportId);
     return true;
   }
 }
 
 void AirportIndex::addRunwayEnd(const QString& ident, const QString& runwayName, int runwayEndId)
 {
-  identRunwayNameToEndId.insert(Name2(ident, runwayName), runwayEndId);
+  identRunwayNameToEndId.insert(name(ident, runwayName), runwayEndId);
 }
 
 void AirportIndex::addAirportIls(const QString& ident, const QString& airportRegion, const QString& ilsIdent,
                                  int ilsId)
 {
-  airportIlsIdMap.insert(Name3(ident, airportRegion, ilsIdent), ilsId);
+  airportIlsIdMap.insert(name(ident, airportRegion, ilsIdent), ilsId);
 }
 
 int AirportIndex::getAirportIlsId(const QString& ident, const QString& airportRegion, const QString& ilsIdent) const
 {
-  return airportIlsIdMap.value(Name3(ident, airportRegion, ilsIdent), -1);
+  return airportIlsIdMap.value(name(ident, airportRegion, ilsIdent), -1);
 }
 
 void AirportIndex::addSkippedAirportIls(const QString& ident, const QString& airportRegion,
                                         const QString& ilsIdent)
 {
-  skippedIlsSet.insert(Name3(ident, airportRegion, ilsIdent));
+  skippedIlsSet.insert(name(ident, airportRegion, ilsIdent));
 }
 
 bool AirportIndex::hasSkippedAirportIls(const QString& ident, const QString& airportRegion,
                                         const QString& ilsIdent) const
 {
-  return skippedIlsSet.contains(Name3(ident, airportRegion, ilsIdent));
+  return skippedIlsSet.contains(name(ident, airportRegion, ilsIdent));
 }
 
 bool AirportIndex::addIdentIcaoMapping(const QString& ident, const QString& icao)
@@ -108,8 +108,8 @@ bool AirportIndex::addIdentIcaoMapping(const QString& ident, const QString& icao
   bool retval = false;
   if(!ident.isEmpty() && !icao.isEmpty())
   {
-    retval = identToIcaoMap.contains(Name(icao));
-    identToIcaoMap.insert(Name(ident), Name(icao));
+    retval = identToIcaoMap.contains(name(icao));
+    identToIcaoMap.insert(name(ident), name(icao));
   }
   return retval;
 }
@@ -18,10 +18,8 @@
 #ifndef ATOOLS_XPAIRPORTINDEX_H
 #define ATOOLS_XPAIRPORTINDEX_H
 
-#include "util/str.h"
+#include "util/flathashmap.h"
 
-#include <QHash>
-#include <QSet>
 #include <QVariant>
 
 namespace atools {
@@ -31,6 +29,9 @@ namespace common {
 /*
  * Filled when reading airports in the beginning of the compilation process.
  * Provides an index from airport ICAO to airport_id and runwayname/airport ICAO to runway_end_id.
+ *
+ * Idents are packed into integers using atools::util::packIdent() and stored in flat hash maps.
+ * Idents are truncated to eight characters.
  */
 class AirportIndex
 {
@@ -71,26 +72,41 @@ public:
 
   void clear();
 
-  typedef atools::util::Str<8> Name;
-  typedef atools::util::StrPair<8> Name2;
-  typedef atools::util::StrTriple<8> Name3;
+  typedef quint64 Name;
+  typedef std::array<quint64, 2> Name2;
+  typedef std::array<quint64, 3> Name3;
 
 private:
+  static Name name(const QString& ident)
+  {
+    return atools::util::packIdent(ident);
+  }
+
+  static Name2 name(const QString& ident, const QString& ident2)
+  {
+    return Name2({{atools::util::packIdent(ident), atools::util::packIdent(ident2)}});
+  }
+
+  static Name3 name(const QString& ident, const QString& ident2, const QString& ident3)
+  {
+    return Name3({{atools::util::packIdent(ident), atools::util::packIdent(ident2), atools::util::packIdent(ident3)}});
+  }
+
   // Airport ICAO to airport_id
-  QHash<Name, int> identToIdMap;
+  atools::util::FlatHashMap<Name, int> identToIdMap;
 
   // Airport idents
-  QSet<Name> airportIdents;
+  atools::util::FlatHashSet<Name> airportIdents;
 
   // Maps airport idents to ICAO
-  QHash<Name, Name> identToIcaoMap;
+  atools::util::FlatHashMap<Name, Name> identToIcaoMap;
 
   // Airport ICAO and runway name to runway_end_id
-  QHash<Name2, int> identRunwayNameToEndId;
+  atools::util::FlatHashMap<Name2, int> identRunwayNameToEndId;
 
   // Airport ICAO, airport region and ILS ident to ils_id
-  QHash<Name3, int> airportIlsIdMap;
-  QSet<Name3> skippedIlsSet;
+  atools::util::FlatHashMap<Name3, int> airportIlsIdMap;
+  atools::util::FlatHashSet<Name3> skippedIlsSet;
 
 };
 
@@ -98,8 +114,4 @@ private:
 } // namespace fs
 } // namespace atools
 
-Q_DECLARE_TYPEINFO(atools::fs::common::AirportIndex::Name, Q_PRIMITIVE_TYPE);
-Q_DECLARE_TYPEINFO(atools::fs::common::AirportIndex::Name2, Q_PRIMITIVE_TYPE);
-Q_DECLARE_TYPEINFO(atools::fs::common::AirportIndex::Name3, Q_PRIMITIVE_TYPE);
-
 #endif // ATOOLS_XPAIRPORTINDEX_H
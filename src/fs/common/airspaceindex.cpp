@@ -0,0 +1,305 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/common/airspaceindex.h"
+
+#include "fs/common/binarygeometry.h"
+#include "geo/linestring.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+#include <QHash>
+
+#include <cmath>
+#include <limits>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+using atools::geo::LineString;
+using atools::geo::Pos;
+using atools::geo::Rect;
+using atools::geo::PolygonIndex;
+using atools::sql::SqlQuery;
+
+/* Number of bisection steps for borders which gives less than 1 meter for the default sample distance */
+static const int REFINE_ITERATIONS = 10;
+
+void AirspaceIndex::loadAirspaces(sql::SqlDatabase *db, int source, const QString& table)
+{
+  SqlQuery query(db);
+  query.exec("select boundary_id, min_altitude, max_altitude, max_altitude_type, geometry from " + table);
+
+  LineString line;
+  int num = 0;
+  while(query.next())
+  {
+    BinaryGeometry::readFromByteArray(query.value("geometry").toByteArray(), line);
+
+    float minAlt = query.isNull("min_altitude") ? std::numeric_limits<float>::lowest() :
+                   query.value("min_altitude").toFloat();
+    float maxAlt = query.isNull("max_altitude") || query.valueStr("max_altitude_type") == "UL" ?
+                   UNLIMITED_ALTITUDE_FT : query.value("max_altitude").toFloat();
+
+    addAirspace(query.valueInt("boundary_id"), source, minAlt, maxAlt, line);
+    num++;
+  }
+  qDebug() << Q_FUNC_INFO << "Loaded" << num << "airspaces from" << table << "source" << source;
+}
+
+void AirspaceIndex::addAirspace(int id, int source, float minAltitudeFt, float maxAltitudeFt, const LineString& line)
+{
+  // Polygon index skips degenerated polygons - keep indexes in sync
+  int numPolygons = polygons.size();
+  polygons.addPolygon(airspaces.size(), line);
+  if(polygons.size() > numPolygons)
+    airspaces.append({id, source, minAltitudeFt, maxAltitudeFt, line.boundingRect()});
+}
+
+void AirspaceIndex::clear()
+{
+  airspaces.clear();
+  polygons.clear();
+  gridAirspaces.clear();
+  gridOffsets.clear();
+}
+
+void AirspaceIndex::cellRange(const Rect& rect, int& column1, int& column2, int& row1, int& row2)
+{
+  auto column = [](float lonX) -> int {
+                  return std::max(0, std::min(PolygonIndex::GRID_COLUMNS - 1,
+                                              static_cast<int>((lonX + 180.f) / PolygonIndex::GRID_CELL_DEG)));
+                };
+  auto row = [](float latY) -> int {
+               return std::max(0, std::min(PolygonIndex::GRID_ROWS - 1,
+                                           static_cast<int>((latY + 90.f) / PolygonIndex::GRID_CELL_DEG)));
+             };
+
+  column1 = column(rect.getWest());
+  column2 = column(rect.getEast());
+  row1 = row(rect.getSouth());
+  row2 = row(rect.getNorth());
+}
+
+void AirspaceIndex::build()
+{
+  polygons.build();
+
+  // Collect cell entries for all airspaces
+  QVector<QVector<int> > cells(PolygonIndex::GRID_COLUMNS * PolygonIndex::GRID_ROWS);
+  for(int i = 0; i < airspaces.size(); i++)
+  {
+    for(const Rect& rect : airspaces.at(i).rect.splitAtAntiMeridian())
+    {
+      int column1, column2, row1, row2;
+      cellRange(rect, column1, column2, row1, row2);
+      for(int row = row1; row <= row2; row++)
+      {
+        for(int column = column1; column <= column2; column++)
+        {
+          QVector<int>& cell = cells[row * PolygonIndex::GRID_COLUMNS + column];
+          if(cell.isEmpty() || cell.last() != i)
+            cell.append(i);
+        }
+      }
+    }
+  }
+
+  // Flatten into one vector and sort each cell by lower altitude
+  gridAirspaces.clear();
+  gridOffsets.clear();
+  gridOffsets.reserve(cells.size() + 1);
+  for(QVector<int>& cell : cells)
+  {
+    std::sort(cell.begin(), cell.end(), [this](int index1, int index2) -> bool {
+                return airspaces.at(index1).minAltitude < airspaces.at(index2).minAltitude;
+              });
+    gridOffsets.append(gridAirspaces.size());
+    gridAirspaces.append(cell);
+  }
+  gridOffsets.append(gridAirspaces.size());
+}
+
+void AirspaceIndex::getCandidates(QVector<int>& indexes, const Rect& rect, float minAltitudeFt,
+                                  float maxAltitudeFt) const
+{
+  if(gridOffsets.isEmpty() || !rect.isValid())
+    return;
+
+  int numIndexes = indexes.size();
+  for(const Rect& part : rect.splitAtAntiMeridian())
+  {
+    int column1, column2, row1, row2;
+    cellRange(part, column1, column2, row1, row2);
+    for(int row = row1; row <= row2; row++)
+    {
+      for(int column = column1; column <= column2; column++)
+      {
+        int cell = row * PolygonIndex::GRID_COLUMNS + column;
+        for(int i = gridOffsets.at(cell); i < gridOffsets.at(cell + 1); i++)
+        {
+          int index = gridAirspaces.at(i);
+          const Airspace& airspace = airspaces.at(index);
+
+          if(airspace.minAltitude > maxAltitudeFt)
+            // Sorted by lower altitude - all remaining ones are above
+            break;
+
+          if(airspace.maxAltitude >= minAltitudeFt && airspace.rect.overlaps(part))
+            indexes.append(index);
+        }
+      }
+    }
+  }
+
+  // Remove duplicates from neighbour cells
+  std::sort(indexes.begin() + numIndexes, indexes.end());
+  indexes.erase(std::unique(indexes.begin() + numIndexes, indexes.end()), indexes.end());
+}
+
+void AirspaceIndex::getAirspaceIds(QVector<int>& ids, const Rect& rect, float minAltitudeFt,
+                                   float maxAltitudeFt) const
+{
+  QVector<int> indexes;
+  getCandidates(indexes, rect, minAltitudeFt, maxAltitudeFt);
+  for(int index : indexes)
+    ids.append(airspaces.at(index).id);
+}
+
+bool AirspaceIndex::isInside(int index, const Pos& pos) const
+{
+  const Airspace& airspace = airspaces.at(index);
+  return pos.getAltitude() >= airspace.minAltitude && pos.getAltitude() <= airspace.maxAltitude &&
+         polygons.contains(index, pos);
+}
+
+Pos AirspaceIndex::interpolate(const Pos& pos1, const Pos& pos2, float lengthMeter, float fraction)
+{
+  Pos pos = pos1.interpolate(pos2, lengthMeter, fraction);
+  pos.setAltitude(pos1.getAltitude() + (pos2.getAltitude() - pos1.getAltitude()) * fraction);
+  return pos;
+}
+
+float AirspaceIndex::refineBorder(int index, const Pos& pos1, const Pos& pos2, float lengthMeter,
+                                  float fraction1, float fraction2) const
+{
+  bool inside1 = isInside(index, interpolate(pos1, pos2, lengthMeter, fraction1));
+  for(int i = 0; i < REFINE_ITERATIONS; i++)
+  {
+    float fraction = (fraction1 + fraction2) / 2.f;
+    if(isInside(index, interpolate(pos1, pos2, lengthMeter, fraction)) == inside1)
+      fraction1 = fraction;
+    else
+      fraction2 = fraction;
+  }
+  return (fraction1 + fraction2) / 2.f;
+}
+
+QVector<AirspaceIntersection> AirspaceIndex::getIntersections(const LineString& line) const
+{
+  QVector<AirspaceIntersection> intersections;
+
+  // Maps internal airspace index to the index of the not yet closed intersection
+  QHash<int, int> open;
+
+  auto enter = [&](int index, float distance, float altitude) -> void {
+                 const Airspace& airspace = airspaces.at(index);
+                 open.insert(index, intersections.size());
+                 intersections.append({airspace.id, airspace.source, distance, distance, altitude, altitude});
+               };
+
+  auto leave = [&](int index, float distance, float altitude) -> void {
+                 AirspaceIntersection& intersection = intersections[open.take(index)];
+                 intersection.exitDistanceMeter = distance;
+                 intersection.exitAltitudeFt = altitude;
+               };
+
+  float segmentStart = 0.f;
+  Pos lastPos;
+  QVector<int> candidates;
+  for(int i = 0; i < line.size() - 1; i++)
+  {
+    const Pos& pos1 = line.at(i);
+    const Pos& pos2 = line.at(i + 1);
+    if(!pos1.isValid() || !pos2.isValid())
+      continue;
+
+    float length = pos1.distanceMeterTo(pos2);
+    int numSteps = std::max(1, static_cast<int>(std::ceil(length / SAMPLE_DISTANCE_METER)));
+
+    float minAlt = std::min(pos1.getAltitude(), pos2.getAltitude());
+    float maxAlt = std::max(pos1.getAltitude(), pos2.getAltitude());
+    candidates.clear();
+    getCandidates(candidates, LineString({pos1, pos2}).boundingRect(), minAlt, maxAlt);
+
+    // Close airspaces which are not touched by this segment at all
+    for(int index : open.keys())
+    {
+      if(!std::binary_search(candidates.constBegin(), candidates.constEnd(), index))
+        leave(index, segmentStart, pos1.getAltitude());
+    }
+
+    for(int index : candidates)
+    {
+      bool inside = isInside(index, pos1);
+
+      // State can change at the waypoint if altitude jumps
+      if(inside && !open.contains(index))
+        enter(index, segmentStart, pos1.getAltitude());
+      else if(!inside && open.contains(index))
+        leave(index, segmentStart, pos1.getAltitude());
+
+      float lastFraction = 0.f;
+      for(int step = 1; step <= numSteps; step++)
+      {
+        float fraction = static_cast<float>(step) / numSteps;
+        bool insideNext = isInside(index, step == numSteps ? pos2 : interpolate(pos1, pos2, length, fraction));
+        if(insideNext != inside)
+        {
+          float border = refineBorder(index, pos1, pos2, length, lastFraction, fraction);
+          float altitude = pos1.getAltitude() + (pos2.getAltitude() - pos1.getAltitude()) * border;
+          if(insideNext)
+            enter(index, segmentStart + length * border, altitude);
+          else
+            leave(index, segmentStart + length * border, altitude);
+          inside = insideNext;
+        }
+        lastFraction = fraction;
+      }
+    }
+
+    segmentStart += length;
+    lastPos = pos2;
+  }
+
+  // Corridor ends inside
+  for(int index : open.keys())
+    leave(index, segmentStart, lastPos.getAltitude());
+
+  std::sort(intersections.begin(), intersections.end(),
+            [](const AirspaceIntersection& i1, const AirspaceIntersection& i2) -> bool {
+              return i1.entryDistanceMeter < i2.entryDistanceMeter;
+            });
+  return intersections;
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
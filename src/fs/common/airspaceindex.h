@@ -0,0 +1,141 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_COMMON_AIRSPACEINDEX_H
+#define ATOOLS_FS_COMMON_AIRSPACEINDEX_H
+
+#include "geo/polygonindex.h"
+#include "geo/rect.h"
+
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class LineString;
+}
+namespace sql {
+class SqlDatabase;
+}
+namespace fs {
+namespace common {
+
+/* An airspace penetrated by a corridor. Distances are measured along the corridor from its start. */
+struct AirspaceIntersection
+{
+  int id; /* boundary_id */
+  int source; /* Caller defined value given when loading */
+  float entryDistanceMeter, exitDistanceMeter;
+  float entryAltitudeFt, exitAltitudeFt;
+};
+
+/*
+ * Three dimensional index for airspaces which allows to find all airspaces penetrated by a flight path
+ * or vertical profile in one call.
+ *
+ * Airspaces are sorted into a grid of PolygonIndex::GRID_CELL_DEG cells by bounding rectangle. Each cell keeps its
+ * airspaces sorted by lower altitude, so a query for an altitude band stops at the first airspace above.
+ * Geometry is tested using a PolygonIndex.
+ *
+ * Airspaces from several databases like simulator and user airspaces can be combined. The caller defined source
+ * value tells them apart in the result since ids are only unique within one database.
+ *
+ * Altitudes are in feet like in the boundary table. A built index can be queried from multiple threads.
+ */
+class AirspaceIndex
+{
+public:
+  /* Read all airspaces from a table with the layout of the boundary table.
+   * Null or unlimited upper altitudes are treated as unlimited. Call build() after loading. */
+  void loadAirspaces(atools::sql::SqlDatabase *db, int source, const QString& table = "boundary");
+
+  /* Add a single airspace. The line string is treated as closed polygon. Call build() after adding. */
+  void addAirspace(int id, int source, float minAltitudeFt, float maxAltitudeFt, const atools::geo::LineString& line);
+
+  /* Build grid after adding airspaces */
+  void build();
+
+  void clear();
+
+  /* Get all airspaces penetrated by the corridor sorted by entry distance.
+   * Altitude of the line positions is in feet and interpolated linearly along each segment.
+   * An airspace is reported more than once if the corridor leaves and enters it again.
+   * A corridor starting or ending inside an airspace gives an entry at zero or an exit at the total length.
+   * The line is sampled every SAMPLE_DISTANCE_METER and borders are refined by bisection. Airspaces smaller
+   * than the sample distance can be missed. */
+  QVector<AirspaceIntersection> getIntersections(const atools::geo::LineString& line) const;
+
+  /* Appends the ids of all airspaces overlapping rect and the altitude band without testing geometry */
+  void getAirspaceIds(QVector<int>& ids, const atools::geo::Rect& rect, float minAltitudeFt,
+                      float maxAltitudeFt) const;
+
+  int size() const
+  {
+    return airspaces.size();
+  }
+
+  bool isEmpty() const
+  {
+    return airspaces.isEmpty();
+  }
+
+  static Q_DECL_CONSTEXPR float SAMPLE_DISTANCE_METER = 1000.f;
+
+  /* Upper altitude for unlimited airspaces */
+  static Q_DECL_CONSTEXPR float UNLIMITED_ALTITUDE_FT = 1000000.f;
+
+private:
+  struct Airspace
+  {
+    int id, source;
+    float minAltitude, maxAltitude;
+    atools::geo::Rect rect;
+  };
+
+  /* Appends internal indexes of all airspaces overlapping rect and altitude band. Sorted and unique. */
+  void getCandidates(QVector<int>& indexes, const atools::geo::Rect& rect, float minAltitudeFt,
+                     float maxAltitudeFt) const;
+
+  /* true if position and altitude are within the airspace with internal index */
+  bool isInside(int index, const atools::geo::Pos& pos) const;
+
+  /* Position and altitude at fraction of a segment */
+  static atools::geo::Pos interpolate(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2,
+                                      float lengthMeter, float fraction);
+
+  /* Fraction of the segment where the inside state changes between fraction1 and fraction2 */
+  float refineBorder(int index, const atools::geo::Pos& pos1, const atools::geo::Pos& pos2, float lengthMeter,
+                     float fraction1, float fraction2) const;
+
+  /* Cell range for a rectangle not crossing the anti-meridian */
+  static void cellRange(const atools::geo::Rect& rect, int& column1, int& column2, int& row1, int& row2);
+
+  /* Airspace at index i uses polygon i in the polygon index */
+  QVector<Airspace> airspaces;
+  atools::geo::PolygonIndex polygons;
+
+  /* Airspace indexes sorted by cell and then by lower altitude. The airspaces for cell i
+   * can be found in the range gridOffsets[i] to gridOffsets[i + 1]. */
+  QVector<int> gridAirspaces;
+  QVector<int> gridOffsets;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_AIRSPACEINDEX_H
@@ -16,13 +16,60 @@
 *****************************************************************************/
 
 #include "fs/common/binarygeometry.h"
+#include "geo/packedlinestring.h"
 
 #include <QDataStream>
+#include <QDebug>
 
 namespace atools {
 namespace fs {
 namespace common {
 
+namespace delta {
+
+/* Resolution for coordinates in the delta format - about one meter */
+static const double COORD_FACTOR = 100000.;
+
+void writeVarint(QByteArray& bytes, quint64 value)
+{
+  while(value >= 0x80)
+  {
+    bytes.append(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  bytes.append(static_cast<char>(value));
+}
+
+/* Zig zag encoding to keep small negative values short */
+void writeSigned(QByteArray& bytes, qint64 value)
+{
+  writeVarint(bytes, (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+}
+
+bool readVarint(const QByteArray& bytes, int& offset, quint64& value)
+{
+  value = 0;
+  for(int shift = 0; shift < 64 && offset < bytes.size(); shift += 7)
+  {
+    quint8 byte = static_cast<quint8>(bytes.at(offset++));
+    value |= static_cast<quint64>(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+bool readSigned(const QByteArray& bytes, int& offset, qint64& value)
+{
+  quint64 raw;
+  if(!readVarint(bytes, offset, raw))
+    return false;
+  value = static_cast<qint64>(raw >> 1) ^ -static_cast<qint64>(raw & 1);
+  return true;
+}
+
+} // namespace delta
+
 BinaryGeometry::BinaryGeometry(const geo::LineString& value)
   : geometry(value)
 {
@@ -34,40 +81,178 @@ BinaryGeometry::BinaryGeometry(const QByteArray& bytes)
   readFromByteArray(bytes);
 }
 
+BinaryGeometry::BinaryGeometry(const geo::PackedLineString& value)
+  : geometry(value.toLineString())
+{
+
+}
+
 BinaryGeometry::BinaryGeometry()
 {
 
 }
 
+void BinaryGeometry::readFromByteArray(const QByteArray& bytes, geo::PackedLineString& packed)
+{
+  packed.clear();
+  BinaryGeometryView(bytes).forEach([&packed](const atools::geo::Pos& pos) -> void {
+    packed.append(pos);
+  });
+  packed.squeeze();
+}
+
+void BinaryGeometry::readFromByteArray(const QByteArray& bytes, geo::LineString& line)
+{
+  BinaryGeometryView view(bytes);
+
+  // Resize keeps capacity
+  line.resize(view.size());
+  atools::geo::Pos *data = line.data();
+  int i = 0;
+  view.forEach([data, &i](const atools::geo::Pos& pos) -> void {
+    data[i++] = pos;
+  });
+
+  // Truncated compact data
+  line.resize(i);
+}
+
 void BinaryGeometry::readFromByteArray(const QByteArray& bytes)
 {
-  geometry.clear();
+  readFromByteArray(bytes, geometry);
+}
 
-  QDataStream in(bytes);
-  in.setVersion(QDataStream::Qt_5_5);
-  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+QByteArray BinaryGeometry::writeToByteArray(Format format)
+{
+  QByteArray bytes;
+
+  if(format == FORMAT_COMPACT)
+  {
+    bytes.reserve(geometry.size() * 6 + 8);
+    bytes.append(static_cast<char>(COMPACT_MARKER));
+    bytes.append(static_cast<char>(COMPACT_VERSION));
+    delta::writeVarint(bytes, static_cast<quint64>(geometry.size()));
+
+    qint64 lastLonX = 0, lastLatY = 0;
+    for(const atools::geo::Pos& pos : geometry)
+    {
+      qint64 lonX = COMPACT_INVALID_COORD, latY = COMPACT_INVALID_COORD;
+      if(pos.isValid())
+      {
+        lonX = qRound64(pos.getLonX() * COMPACT_UNITS_PER_DEGREE);
+        latY = qRound64(pos.getLatY() * COMPACT_UNITS_PER_DEGREE);
+      }
 
-  quint32 size;
-  float lonx, laty;
-  in >> size;
-  for(unsigned int i = 0; i < size; i++)
+      delta::writeSigned(bytes, lonX - lastLonX);
+      delta::writeSigned(bytes, latY - lastLatY);
+      lastLonX = lonX;
+      lastLatY = latY;
+    }
+  }
+  else
   {
-    in >> lonx >> laty;
-    geometry.append(lonx, laty);
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_5);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    out << static_cast<quint32>(geometry.size());
+    for(const atools::geo::Pos& pos : geometry)
+      out << pos.getLonX() << pos.getLatY();
   }
+  return bytes;
 }
 
-QByteArray BinaryGeometry::writeToByteArray()
+void BinaryGeometry::writeDelta(const geo::LineString& line, QByteArray& bytes)
 {
-  QByteArray bytes;
-  QDataStream out(&bytes, QIODevice::WriteOnly);
-  out.setVersion(QDataStream::Qt_5_5);
-  out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  delta::writeVarint(bytes, static_cast<quint64>(line.size()));
 
-  out << static_cast<quint32>(geometry.size());
-  for(const atools::geo::Pos& pos : geometry)
-    out << pos.getLonX() << pos.getLatY();
-  return bytes;
+  qint64 lastLonX = 0, lastLatY = 0, lastAlt = 0;
+  for(const atools::geo::Pos& pos : line)
+  {
+    if(!pos.isValid())
+    {
+      // Lowest bit of first value marks an invalid position without further values
+      delta::writeVarint(bytes, 1);
+      continue;
+    }
+
+    qint64 lonX = qRound64(pos.getLonX() * delta::COORD_FACTOR);
+    qint64 latY = qRound64(pos.getLatY() * delta::COORD_FACTOR);
+    qint64 alt = qRound64(pos.getAltitude());
+
+    qint64 diff = lonX - lastLonX;
+    delta::writeVarint(bytes, ((static_cast<quint64>(diff) << 1) ^ static_cast<quint64>(diff >> 63)) << 1);
+    delta::writeSigned(bytes, latY - lastLatY);
+    delta::writeSigned(bytes, alt - lastAlt);
+
+    lastLonX = lonX;
+    lastLatY = latY;
+    lastAlt = alt;
+  }
+}
+
+bool BinaryGeometry::readDelta(const QByteArray& bytes, int& offset, geo::LineString& line)
+{
+  line.clear();
+
+  quint64 size;
+  if(!delta::readVarint(bytes, offset, size) || size > static_cast<quint64>(bytes.size()))
+    return false;
+
+  line.reserve(static_cast<int>(size));
+  qint64 lonX = 0, latY = 0, alt = 0;
+  for(quint64 i = 0; i < size; i++)
+  {
+    quint64 first;
+    if(!delta::readVarint(bytes, offset, first))
+      return false;
+
+    if(first & 1)
+    {
+      line.append(atools::geo::EMPTY_POS);
+      continue;
+    }
+
+    quint64 zigzag = first >> 1;
+    qint64 lonDiff = static_cast<qint64>(zigzag >> 1) ^ -static_cast<qint64>(zigzag & 1);
+    qint64 latDiff, altDiff;
+    if(!delta::readSigned(bytes, offset, latDiff) || !delta::readSigned(bytes, offset, altDiff))
+      return false;
+
+    lonX += lonDiff;
+    latY += latDiff;
+    alt += altDiff;
+    line.append(atools::geo::Pos(lonX / delta::COORD_FACTOR, latY / delta::COORD_FACTOR, static_cast<double>(alt)));
+  }
+  return true;
+}
+
+// ==========================================================================================
+BinaryGeometryView::BinaryGeometryView(const QByteArray& bytes)
+  : data(bytes)
+{
+  const uchar *ptr = reinterpret_cast<const uchar *>(data.constData());
+
+  if(data.size() >= 2 && ptr[0] == BinaryGeometry::COMPACT_MARKER)
+  {
+    if(ptr[1] == BinaryGeometry::COMPACT_VERSION)
+    {
+      compact = true;
+      dataOffset = 2;
+      quint64 size;
+      if(delta::readVarint(data, dataOffset, size))
+        numPositions = static_cast<int>(std::min(size, static_cast<quint64>(data.size())));
+    }
+    else
+      qWarning() << Q_FUNC_INFO << "Unknown geometry version" << ptr[1];
+  }
+  else if(data.size() >= 4)
+  {
+    // Float format - big endian count and coordinates as written by QDataStream
+    dataOffset = 4;
+    quint32 size = qFromBigEndian<quint32>(ptr);
+    numPositions = static_cast<int>(std::min(size, static_cast<quint32>((data.size() - 4) / 8)));
+  }
 }
 
 } // namespace common
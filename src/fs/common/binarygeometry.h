@@ -20,9 +20,15 @@
 
 #include "geo/linestring.h"
 
-class QByteArray;
+#include <QByteArray>
+#include <QtEndian>
+
+#include <cstring>
 
 namespace atools {
+namespace geo {
+class PackedLineString;
+}
 namespace fs {
 namespace common {
 
@@ -31,10 +37,20 @@ namespace common {
  *
  * Writes a simple lat/long (not altitude) list in single floating point precision into a byte array which can be used
  * to write and read it into and from a database BLOB.
+ *
+ * The optional compact format stores micro degree coordinates as variable length zig-zag encoded differences
+ * to the previous point. It starts with the byte COMPACT_MARKER and a version byte which cannot appear at the
+ * start of the float format. All read methods detect the format.
  */
 class BinaryGeometry
 {
 public:
+  enum Format
+  {
+    FORMAT_FLOAT, /* Position count and single precision floats - readable by all versions */
+    FORMAT_COMPACT /* Versioned delta encoding - usually less than half the size */
+  };
+
   BinaryGeometry();
 
   /* Sets line string geometry and does nothing else */
@@ -43,8 +59,29 @@ public:
   /* Reads from byte array and provides line string */
   BinaryGeometry(const QByteArray& bytes);
 
+  /* Sets line string geometry from packed geometry */
+  BinaryGeometry(const atools::geo::PackedLineString& value);
+
+  /* Reads from byte array directly into the packed geometry without creating a line string */
+  static void readFromByteArray(const QByteArray& bytes, atools::geo::PackedLineString& packed);
+
+  /* Decodes into line which is resized and keeps its capacity. Allows to reuse a buffer for many geometries. */
+  static void readFromByteArray(const QByteArray& bytes, atools::geo::LineString& line);
+
   void readFromByteArray(const QByteArray& bytes);
-  QByteArray writeToByteArray();
+  QByteArray writeToByteArray(Format format = FORMAT_FLOAT);
+
+  /*
+   * Compact format including altitude which is not compatible with the one above.
+   * Coordinates are stored with a resolution of 0.00001 degree and altitude in full feet.
+   * Each value is stored as variable length difference to the previous point.
+   * Invalid positions like segment separators are kept.
+   *
+   * Appends to bytes or reads from bytes starting at offset which is moved behind the geometry.
+   * Returns false if bytes are truncated.
+   */
+  static void writeDelta(const atools::geo::LineString& line, QByteArray& bytes);
+  static bool readDelta(const QByteArray& bytes, int& offset, atools::geo::LineString& line);
 
   const atools::geo::LineString& getGeometry() const
   {
@@ -61,10 +98,114 @@ public:
     geometry = value;
   }
 
+  /* First byte of the compact format and current version */
+  static Q_DECL_CONSTEXPR quint8 COMPACT_MARKER = 0xff;
+  static Q_DECL_CONSTEXPR quint8 COMPACT_VERSION = 1;
+
+  /* Fixed point units per degree in compact format */
+  Q_DECL_CONSTEXPR static double COMPACT_UNITS_PER_DEGREE = 1000000.;
+
+  /* Used for invalid positions in compact format */
+  Q_DECL_CONSTEXPR static qint64 COMPACT_INVALID_COORD = std::numeric_limits<qint32>::min();
+
 private:
   atools::geo::LineString geometry;
 };
 
+/*
+ * Read only access to the positions of a geometry blob written by BinaryGeometry without decoding it into a
+ * line string first. Keeps a shallow copy of the byte array, i.e. nothing is copied.
+ * Both formats are supported. Truncated data is ignored.
+ */
+class BinaryGeometryView
+{
+public:
+  explicit BinaryGeometryView(const QByteArray& bytes);
+
+  /* Calls func(const Pos& pos) for each position in order */
+  template<typename FUNC>
+  void forEach(FUNC func) const;
+
+  int size() const
+  {
+    return numPositions;
+  }
+
+  bool isEmpty() const
+  {
+    return numPositions == 0;
+  }
+
+  bool isCompact() const
+  {
+    return compact;
+  }
+
+private:
+  /* Read variable length zig-zag encoded value. Returns false if end is reached. */
+  static bool readSigned(const uchar *& ptr, const uchar *end, qint64& value)
+  {
+    quint64 raw = 0;
+    for(int shift = 0; shift < 64 && ptr < end; shift += 7)
+    {
+      uchar byte = *ptr++;
+      raw |= static_cast<quint64>(byte & 0x7f) << shift;
+      if(!(byte & 0x80))
+      {
+        value = static_cast<qint64>(raw >> 1) ^ -static_cast<qint64>(raw & 1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static float readFloat(const uchar *ptr)
+  {
+    quint32 raw = qFromBigEndian<quint32>(ptr);
+    float value;
+    std::memcpy(&value, &raw, sizeof(value));
+    return value;
+  }
+
+  QByteArray data;
+  int numPositions = 0;
+
+  /* Byte offset of first position */
+  int dataOffset = 0;
+  bool compact = false;
+};
+
+template<typename FUNC>
+void BinaryGeometryView::forEach(FUNC func) const
+{
+  const uchar *ptr = reinterpret_cast<const uchar *>(data.constData()) + dataOffset;
+  const uchar *end = reinterpret_cast<const uchar *>(data.constData()) + data.size();
+
+  if(compact)
+  {
+    qint64 lonX = 0, latY = 0, lonDiff, latDiff;
+    for(int i = 0; i < numPositions; i++)
+    {
+      if(!readSigned(ptr, end, lonDiff) || !readSigned(ptr, end, latDiff))
+        break;
+
+      lonX += lonDiff;
+      latY += latDiff;
+      if(lonX == BinaryGeometry::COMPACT_INVALID_COORD || latY == BinaryGeometry::COMPACT_INVALID_COORD)
+        func(atools::geo::EMPTY_POS);
+      else
+        func(atools::geo::Pos(static_cast<double>(lonX) / BinaryGeometry::COMPACT_UNITS_PER_DEGREE,
+                              static_cast<double>(latY) / BinaryGeometry::COMPACT_UNITS_PER_DEGREE));
+    }
+  }
+  else
+  {
+    // Number of positions is limited to the data size in the constructor
+    for(int i = 0; i < numPositions; i++, ptr += 8)
+      func(atools::geo::Pos(readFloat(ptr), readFloat(ptr + 4)));
+  }
+}
+
 } // namespace common
 } // namespace fs
 } // namespace atools
@@ -22,14 +22,22 @@
 #include "geo/pos.h"
 #include "geo/linestring.h"
 #include "geo/line.h"
+#include "geo/rect.h"
+#include "util/parallel.h"
 
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QMutexLocker>
+#include <QtEndian>
 
 using atools::geo::Pos;
 using atools::geo::Line;
 using atools::geo::LineString;
+using atools::geo::Rect;
 
 namespace atools {
 namespace fs {
@@ -39,8 +47,13 @@ GlobeReader::GlobeReader(const QString& dataDirParam)
   : dataDir(dataDirParam)
 {
   dataFiles.fill(nullptr, NUM_DATAFILES);
-  dataStreams.fill(nullptr, NUM_DATAFILES);
+  dataMaps.fill(nullptr, NUM_DATAFILES);
   dataFilenames.fill(QString(), NUM_DATAFILES);
+  for(int i = 0; i < NUM_DATAFILES; i++)
+  {
+    fileStates[i] = FILE_NOT_OPENED;
+    pyramidBuilt[i] = false;
+  }
 }
 
 GlobeReader::~GlobeReader()
@@ -92,40 +105,57 @@ bool GlobeReader::openFiles()
 
 void GlobeReader::openFile(int i)
 {
+  // Called with fileMutex locked
+  if(fileStates[i] != FILE_NOT_OPENED)
+    return;
+
   const QString& name = dataFilenames.at(i);
-  if(!name.isEmpty() && dataFiles[i] == nullptr)
+  if(name.isEmpty())
   {
-    qDebug() << Q_FUNC_INFO << name;
-    dataFiles[i] = new QFile(name);
-    if(dataFiles[i]->open(QIODevice::ReadOnly))
-    {
-      dataStreams[i] = new QDataStream(dataFiles[i]);
-      dataStreams[i]->setByteOrder(QDataStream::LittleEndian);
-    }
+    fileStates[i] = FILE_UNAVAILABLE;
+    return;
+  }
+
+  qDebug() << Q_FUNC_INFO << name;
+  dataFiles[i] = new QFile(name);
+  if(dataFiles[i]->open(QIODevice::ReadOnly))
+  {
+    // Map whole file - pages are loaded by the system on access
+    dataMaps[i] = dataFiles[i]->map(0, dataFiles[i]->size());
+    if(dataMaps[i] != nullptr)
+      fileStates[i] = FILE_MAPPED;
     else
     {
-      closeFile(i);
-      // Clear filename to avoid reopening
-      dataFilenames[i].clear();
-      qWarning() << "Cannot open file" << name;
+      qWarning() << Q_FUNC_INFO << "Cannot map file" << name << dataFiles[i]->errorString();
+      fileStates[i] = FILE_READ;
     }
   }
+  else
+  {
+    qWarning() << "Cannot open file" << name;
+    closeFile(i);
+    // Clear filename to avoid reopening
+    dataFilenames[i].clear();
+    fileStates[i] = FILE_UNAVAILABLE;
+  }
 }
 
 void GlobeReader::closeFile(int i)
 {
-  if(dataStreams[i] != nullptr)
-  {
-    delete dataStreams[i];
-    dataStreams[i] = nullptr;
-  }
-
   if(dataFiles[i] != nullptr)
   {
+    if(dataMaps[i] != nullptr)
+      dataFiles[i]->unmap(const_cast<uchar *>(dataMaps[i]));
     dataFiles[i]->close();
     delete dataFiles[i];
     dataFiles[i] = nullptr;
   }
+  dataMaps[i] = nullptr;
+  fileStates[i] = FILE_NOT_OPENED;
+
+  // Files might be different after reopening
+  pyramidTiles[i] = PyramidTile();
+  pyramidBuilt[i] = false;
 }
 
 void GlobeReader::closeFiles()
@@ -135,27 +165,76 @@ void GlobeReader::closeFiles()
 }
 
 float GlobeReader::getElevation(const atools::geo::Pos& pos)
+{
+  double gridCol, gridRow;
+  gridPos(gridCol, gridRow, pos);
+  return getElevation(static_cast<int>(gridCol), static_cast<int>(gridRow));
+}
+
+float GlobeReader::getElevation(int gridCol, int gridRow)
 {
   int fileIndex;
-  qint64 fileOffset = calcFileOffset(pos.getLonX(), pos.getLatY(), fileIndex);
+  qint64 fileOffset = calcFileOffset(gridCol, gridRow, fileIndex);
 
-  openFile(fileIndex);
-  QFile *dataFile = dataFiles[fileIndex];
+  int state = fileStates[fileIndex].load(std::memory_order_acquire);
+  if(state == FILE_NOT_OPENED)
+  {
+    QMutexLocker locker(&fileMutex);
+    openFile(fileIndex);
+    state = fileStates[fileIndex];
+  }
 
-  if(dataFile != nullptr)
+  if(state == FILE_MAPPED)
+    return qFromLittleEndian<qint16>(dataMaps.at(fileIndex) + fileOffset);
+  else if(state == FILE_READ)
   {
-    dataFile->seek(fileOffset);
-    QDataStream *dataStream = dataStreams[fileIndex];
+    // Fallback if mapping failed - position and read need to be atomic
+    QMutexLocker locker(&fileMutex);
+    QFile *dataFile = dataFiles.at(fileIndex);
+    uchar data[2];
+    if(dataFile->seek(fileOffset) && dataFile->read(reinterpret_cast<char *>(data), 2) == 2)
+      return qFromLittleEndian<qint16>(data);
+  }
+  return INVALID;
+}
+
+float GlobeReader::getElevationBilinear(const atools::geo::Pos& pos)
+{
+  // Use cell centers as sampling points
+  double gridCol, gridRow;
+  gridPos(gridCol, gridRow, pos);
+  gridCol -= 0.5;
+  gridRow = atools::minmax(0., static_cast<double>(GRID_ROWS - 1), gridRow - 0.5);
 
-    qint16 elevation;
-    *dataStream >> elevation;
-    return elevation;
+  // Columns roll over at the anti-meridian in calcFileOffset()
+  int col = static_cast<int>(std::floor(gridCol));
+  int row = std::min(static_cast<int>(gridRow), GRID_ROWS - 2);
+  float fracCol = static_cast<float>(gridCol - col), fracRow = static_cast<float>(gridRow - row);
+
+  float e00 = getElevation(col, row), e10 = getElevation(col + 1, row),
+        e01 = getElevation(col, row + 1), e11 = getElevation(col + 1, row + 1);
+
+  for(float e : {e00, e10, e01, e11})
+  {
+    if(e >= INVALID || e <= OCEAN)
+      // Do not mix up ocean or missing values
+      return getElevation(pos);
   }
-  else
-    return INVALID;
+
+  float upper = e00 + (e10 - e00) * fracCol;
+  float lower = e01 + (e11 - e01) * fracCol;
+  return upper + (lower - upper) * fracRow;
+}
+
+void GlobeReader::getElevations(QVector<float>& elevations, const atools::geo::LineString& positions, bool bilinear)
+{
+  elevations.resize(positions.size());
+  for(int i = 0; i < positions.size(); i++)
+    elevations[i] = bilinear ? getElevationBilinear(positions.at(i)) : getElevation(positions.at(i));
 }
 
-void GlobeReader::getElevations(atools::geo::LineString& elevations, const atools::geo::LineString& linestring)
+void GlobeReader::getElevations(atools::geo::LineString& elevations, const atools::geo::LineString& linestring,
+                                bool bilinear)
 {
   QList<Pos> positions;
 
@@ -172,33 +251,87 @@ void GlobeReader::getElevations(atools::geo::LineString& elevations, const atool
 
     Pos lastDropped;
     for(const Pos& pos : positions)
-    {
-      float elevation = getElevation(pos);
+      addElevation(elevations, lastDropped, pos, bilinear ? getElevationBilinear(pos) : getElevation(pos));
+  }
+
+  elevations.append(linestring.last());
+  if(!elevations.isEmpty())
+    elevations.last().setAltitude(bilinear ? getElevationBilinear(elevations.last()) :
+                                  getElevation(elevations.last()));
+}
+
+void GlobeReader::getElevationsAdaptive(atools::geo::LineString& elevations, const atools::geo::LineString& linestring,
+                                        bool bilinear)
+{
+  if(linestring.size() < 2)
+    return;
+
+  QList<Pos> positions;
+  for(int i = 0; i < linestring.size() - 1; i++)
+  {
+    Line line = Line(linestring.at(i), linestring.at(i + 1));
+    float length = line.lengthMeter();
+    int numSteps = std::max(1, static_cast<int>(length / PYRAMID_SEGMENT_LENGTH));
+    float stepLength = length / numSteps;
 
-      if(!elevations.isEmpty())
+    Pos lastDropped, stepStart = line.getPos1();
+    float startElevation = getFlatElevation(stepStart);
+    for(int j = 1; j <= numSteps; j++)
+    {
+      Pos stepEnd = j < numSteps ? line.interpolate(length, static_cast<float>(j) / numSteps) : line.getPos2();
+      float endElevation = getFlatElevation(stepEnd);
+
+      if(startElevation < INVALID && endElevation < INVALID &&
+         atools::almostEqual(startElevation, endElevation, SAME_ELEVATION_EPSILON))
+        // Both ends in flat cells of same elevation - no need to sample in between
+        addElevation(elevations, lastDropped, stepStart, startElevation);
+      else
       {
-        if(atools::almostEqual(elevations.last().getAltitude(), elevation, SAME_ELEVATION_EPSILON))
-        {
-          // Drop points with similar altitude
-          lastDropped = pos;
-          lastDropped.setAltitude(elevation);
-          continue;
-        }
-        else if(lastDropped.isValid())
-        {
-          // Add last point of a stretch with similar altitude
-          elevations.append(lastDropped);
-          lastDropped = Pos();
-        }
+        // Refine near terrain - positions include start but not end
+        positions.clear();
+        stepStart.interpolatePoints(stepEnd, stepLength,
+                                    std::max(1, static_cast<int>(stepLength / INTERPOLATION_SEGMENT_LENGTH)),
+                                    positions);
+        for(const Pos& pos : positions)
+          addElevation(elevations, lastDropped, pos, bilinear ? getElevationBilinear(pos) : getElevation(pos));
       }
 
-      elevations.append(pos.alt(elevation));
+      stepStart = stepEnd;
+      startElevation = endElevation;
     }
   }
 
   elevations.append(linestring.last());
+  elevations.last().setAltitude(bilinear ? getElevationBilinear(elevations.last()) : getElevation(elevations.last()));
+}
+
+void GlobeReader::addElevation(atools::geo::LineString& elevations, atools::geo::Pos& lastDropped,
+                               const atools::geo::Pos& pos, float elevation)
+{
   if(!elevations.isEmpty())
-    elevations.last().setAltitude(getElevation(elevations.last()));
+  {
+    if(atools::almostEqual(elevations.last().getAltitude(), elevation, SAME_ELEVATION_EPSILON))
+    {
+      // Drop points with similar altitude
+      lastDropped = pos;
+      lastDropped.setAltitude(elevation);
+      return;
+    }
+    else if(lastDropped.isValid())
+    {
+      // Add last point of a stretch with similar altitude
+      elevations.append(lastDropped);
+      lastDropped = Pos();
+    }
+  }
+
+  elevations.append(pos.alt(elevation));
+}
+
+void GlobeReader::gridPos(double& gridCol, double& gridRow, const atools::geo::Pos& pos)
+{
+  gridCol = GRID_COLUMNS * (static_cast<double>(pos.getLonX()) + 180.) / 360.;
+  gridRow = GRID_ROWS * (180. - (static_cast<double>(pos.getLatY()) + 90.)) / 180.;
 }
 
 qint64 GlobeReader::calcFileOffset(const atools::geo::Pos& pos, int& fileIndex)
@@ -215,6 +348,17 @@ qint64 GlobeReader::calcFileOffset(double lonx, double laty, int& fileIndex)
 }
 
 qint64 GlobeReader::calcFileOffset(int gridCol, int gridRow, int& fileIndex)
+{
+  fileIndex = calcTile(gridCol, gridRow);
+
+  // Word offset in file
+  qint64 offset = gridCol + static_cast<qint64>(gridRow) * TILE_COLUMNS;
+
+  // Byte offset in file
+  return offset * 2;
+}
+
+int GlobeReader::calcTile(int& gridCol, int& gridRow)
 {
   // Normalize / rollover values
   while(gridCol >= GRID_COLUMNS)
@@ -257,14 +401,314 @@ qint64 GlobeReader::calcFileOffset(int gridCol, int gridRow, int& fileIndex)
   else
     throw atools::Exception(QString("Invalid grid row %1").arg(gridRow));
 
+  gridCol = fileColOffset;
+  gridRow = fileRowOffset;
+
   // Index in file array
-  fileIndex = fileRow * 4 + fileCol;
+  return fileRow * 4 + fileCol;
+}
 
-  // Word offset in file
-  qint64 offset = fileColOffset + fileRowOffset * TILE_COLUMNS;
+void GlobeReader::tileGeometry(int fileIndex, int& gridCol, int& gridRow, int& rows)
+{
+  int fileRow = fileIndex / 4;
+  gridCol = (fileIndex % 4) * TILE_COLUMNS;
+  gridRow = fileRow == 0 ? 0 : TILE_ROWS_SMALL + (fileRow - 1) * TILE_ROWS_LARGE;
+  rows = fileRow == 0 || fileRow == 3 ? TILE_ROWS_SMALL : TILE_ROWS_LARGE;
+}
 
-  // Byte offset in file
-  return offset * 2;
+/* ================================================================================ */
+/* Elevation pyramid */
+
+void GlobeReader::buildPyramid()
+{
+  atools::util::parallelFor(NUM_DATAFILES, [&](int i) -> void {
+    pyramidTile(i);
+  });
+}
+
+const GlobeReader::PyramidTile *GlobeReader::pyramidTile(int fileIndex)
+{
+  if(!pyramidBuilt[fileIndex].load(std::memory_order_acquire))
+  {
+    QMutexLocker locker(&pyramidMutex[fileIndex]);
+    if(!pyramidBuilt[fileIndex])
+    {
+      buildPyramidTile(fileIndex);
+      pyramidBuilt[fileIndex].store(true, std::memory_order_release);
+    }
+  }
+
+  const PyramidTile& tile = pyramidTiles[fileIndex];
+  return tile.maxElevation[0].isEmpty() ? nullptr : &tile;
+}
+
+void GlobeReader::buildPyramidTile(int fileIndex)
+{
+  // Called with pyramidMutex locked
+  int state = fileStates[fileIndex].load(std::memory_order_acquire);
+  if(state == FILE_NOT_OPENED)
+  {
+    QMutexLocker locker(&fileMutex);
+    openFile(fileIndex);
+    state = fileStates[fileIndex];
+  }
+
+  if(state == FILE_UNAVAILABLE)
+    return;
+
+  PyramidTile tile;
+  if(!loadPyramidTile(tile, fileIndex))
+  {
+    int tileGridCol, tileGridRow, rows;
+    tileGeometry(fileIndex, tileGridCol, tileGridRow, rows);
+
+    // Scan full tile for the fine level
+    int factor = pyramidFactor(0);
+    int cellColumns = TILE_COLUMNS / factor;
+    int numCells = cellColumns * (rows / factor);
+    tile.minElevation[0].fill(std::numeric_limits<qint16>::max(), numCells);
+    tile.maxElevation[0].fill(std::numeric_limits<qint16>::min(), numCells);
+    qint16 *minData = tile.minElevation[0].data(), *maxData = tile.maxElevation[0].data();
+
+    const uchar *map = state == FILE_MAPPED ? dataMaps.at(fileIndex) : nullptr;
+    for(int row = 0; row < rows; row++)
+    {
+      int cellRowStart = (row / factor) * cellColumns;
+      for(int col = 0; col < TILE_COLUMNS; col++)
+      {
+        qint16 elevation;
+        if(map != nullptr)
+          elevation = qFromLittleEndian<qint16>(map + (static_cast<qint64>(row) * TILE_COLUMNS + col) * 2);
+        else
+        {
+          // Slow fallback if file is not mapped
+          float value = getElevation(tileGridCol + col, tileGridRow + row);
+          elevation = value < INVALID ? static_cast<qint16>(value) : std::numeric_limits<qint16>::max();
+        }
+
+        int cell = cellRowStart + col / factor;
+        if(elevation < minData[cell])
+          minData[cell] = elevation;
+        if(elevation > maxData[cell])
+          maxData[cell] = elevation;
+      }
+    }
+    savePyramidTile(tile, fileIndex);
+  }
+
+  // Coarse level from fine level
+  int ratio = pyramidFactor(1) / pyramidFactor(0);
+  int fineColumns = TILE_COLUMNS / pyramidFactor(0), fineRows = tile.minElevation[0].size() / fineColumns;
+  int coarseColumns = fineColumns / ratio, numCoarse = coarseColumns * (fineRows / ratio);
+  tile.minElevation[1].fill(std::numeric_limits<qint16>::max(), numCoarse);
+  tile.maxElevation[1].fill(std::numeric_limits<qint16>::min(), numCoarse);
+  for(int row = 0; row < fineRows; row++)
+  {
+    for(int col = 0; col < fineColumns; col++)
+    {
+      int fine = row * fineColumns + col, coarse = (row / ratio) * coarseColumns + col / ratio;
+      tile.minElevation[1][coarse] = std::min(tile.minElevation[1].at(coarse), tile.minElevation[0].at(fine));
+      tile.maxElevation[1][coarse] = std::max(tile.maxElevation[1].at(coarse), tile.maxElevation[0].at(fine));
+    }
+  }
+
+  pyramidTiles[fileIndex] = tile;
+}
+
+/* ================================================================================ */
+/* Degree grid */
+
+void GlobeReader::getMaxElevationDegreeGrid(QVector<float>& grid)
+{
+  grid.fill(INVALID, 360 * 180);
+
+  // Open all files before starting the threads
+  {
+    QMutexLocker locker(&fileMutex);
+    for(int i = 0; i < NUM_DATAFILES; i++)
+      openFile(i);
+  }
+
+  // Collect bands of one degree for all available tiles - tile heights are multiples of one degree
+  QVector<std::pair<int, int> > bands;
+  for(int fileIndex = 0; fileIndex < NUM_DATAFILES; fileIndex++)
+  {
+    if(fileStates[fileIndex] == FILE_UNAVAILABLE)
+      continue;
+
+    int tileGridCol, tileGridRow, rows;
+    tileGeometry(fileIndex, tileGridCol, tileGridRow, rows);
+    for(int band = 0; band < rows / DEGREE_CELLS; band++)
+      bands.append(std::make_pair(fileIndex, band));
+  }
+
+  // Each band writes a distinct range of degree cells - no locking needed
+  float *gridData = grid.data();
+  atools::util::parallelFor(bands.size(), [&](int i) -> void {
+    int fileIndex = bands.at(i).first, band = bands.at(i).second;
+    int tileGridCol, tileGridRow, rows;
+    tileGeometry(fileIndex, tileGridCol, tileGridRow, rows);
+
+    const uchar *map = fileStates[fileIndex] == FILE_MAPPED ? dataMaps.at(fileIndex) : nullptr;
+    qint16 maxElevation[TILE_COLUMNS / DEGREE_CELLS];
+    std::fill(std::begin(maxElevation), std::end(maxElevation), std::numeric_limits<qint16>::min());
+
+    for(int row = band * DEGREE_CELLS; row < (band + 1) * DEGREE_CELLS; row++)
+    {
+      const uchar *line = map != nullptr ? map + static_cast<qint64>(row) * TILE_COLUMNS * 2 : nullptr;
+      for(int col = 0; col < TILE_COLUMNS; col++)
+      {
+        qint16 elevation;
+        if(line != nullptr)
+          elevation = qFromLittleEndian<qint16>(line + col * 2);
+        else
+        {
+          // Slow fallback if file is not mapped
+          float value = getElevation(tileGridCol + col, tileGridRow + row);
+          if(!(value < INVALID))
+            continue;
+          elevation = static_cast<qint16>(value);
+        }
+
+        qint16& cell = maxElevation[col / DEGREE_CELLS];
+        if(elevation > cell)
+          cell = elevation;
+      }
+    }
+
+    int degreeRow = tileGridRow / DEGREE_CELLS + band, degreeCol = tileGridCol / DEGREE_CELLS;
+    for(int c = 0; c < TILE_COLUMNS / DEGREE_CELLS; c++)
+    {
+      if(maxElevation[c] > std::numeric_limits<qint16>::min())
+        gridData[degreeRow * 360 + degreeCol + c] = maxElevation[c];
+    }
+  });
+}
+
+QString GlobeReader::pyramidFilename(int fileIndex) const
+{
+  return QDir(pyramidCacheDir).filePath(QFileInfo(dataFilenames.at(fileIndex)).fileName() + ".pyramid");
+}
+
+bool GlobeReader::loadPyramidTile(PyramidTile& tile, int fileIndex)
+{
+  if(pyramidCacheDir.isEmpty())
+    return false;
+
+  QFile file(pyramidFilename(fileIndex));
+  if(!file.open(QIODevice::ReadOnly))
+    return false;
+
+  QFileInfo source(dataFilenames.at(fileIndex));
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  // Reject outdated cache files
+  quint32 magic, version;
+  qint64 size, lastModified;
+  in >> magic >> version >> size >> lastModified;
+  if(magic != PYRAMID_FILE_MAGIC || version != PYRAMID_FILE_VERSION || size != source.size() ||
+     lastModified != source.lastModified().toMSecsSinceEpoch())
+    return false;
+
+  int tileGridCol, tileGridRow, rows;
+  tileGeometry(fileIndex, tileGridCol, tileGridRow, rows);
+  int numCells = (TILE_COLUMNS / pyramidFactor(0)) * (rows / pyramidFactor(0));
+
+  in >> tile.minElevation[0] >> tile.maxElevation[0];
+  if(in.status() != QDataStream::Ok || tile.minElevation[0].size() != numCells ||
+     tile.maxElevation[0].size() != numCells)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid pyramid file" << file.fileName();
+    tile = PyramidTile();
+    return false;
+  }
+  return true;
+}
+
+void GlobeReader::savePyramidTile(const PyramidTile& tile, int fileIndex)
+{
+  if(pyramidCacheDir.isEmpty())
+    return;
+
+  QFile file(pyramidFilename(fileIndex));
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QFileInfo source(dataFilenames.at(fileIndex));
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+    out << PYRAMID_FILE_MAGIC << PYRAMID_FILE_VERSION << source.size()
+        << source.lastModified().toMSecsSinceEpoch() << tile.minElevation[0] << tile.maxElevation[0];
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write pyramid file" << file.fileName() << file.errorString();
+}
+
+bool GlobeReader::getPyramidCell(int gridCol, int gridRow, int level, float& minElevation, float& maxElevation)
+{
+  int fileIndex = calcTile(gridCol, gridRow);
+  const PyramidTile *tile = pyramidTile(fileIndex);
+  if(tile == nullptr)
+    return false;
+
+  int factor = pyramidFactor(level);
+  int cell = (gridRow / factor) * (TILE_COLUMNS / factor) + gridCol / factor;
+  minElevation = tile->minElevation[level].at(cell);
+  maxElevation = tile->maxElevation[level].at(cell);
+  return true;
+}
+
+float GlobeReader::getFlatElevation(const atools::geo::Pos& pos)
+{
+  double gridCol, gridRow;
+  gridPos(gridCol, gridRow, pos);
+
+  float minElevation, maxElevation;
+  if(getPyramidCell(static_cast<int>(gridCol), static_cast<int>(gridRow), 0, minElevation, maxElevation) &&
+     atools::almostEqual(minElevation, maxElevation, SAME_ELEVATION_EPSILON))
+    return minElevation;
+  else
+    return INVALID;
+}
+
+float GlobeReader::getMaxElevation(const atools::geo::Rect& rect)
+{
+  if(!rect.isValid())
+    return INVALID;
+
+  double west, north, east, south;
+  gridPos(west, north, rect.getTopLeft());
+  gridPos(east, south, rect.getBottomRight());
+
+  if(east < west)
+    // Crosses anti-meridian - columns roll over in calcTile()
+    east += GRID_COLUMNS;
+  north = std::max(north, 0.);
+  south = std::min(south, static_cast<double>(GRID_ROWS - 1));
+
+  // Use coarse level if too many fine cells would be needed
+  int factor = pyramidFactor(0);
+  int level = ((east - west) / factor + 1.) * ((south - north) / factor + 1.) > PYRAMID_MAX_QUERY_CELLS ? 1 : 0;
+  factor = pyramidFactor(level);
+
+  int colStart = static_cast<int>(west) / factor, colEnd = static_cast<int>(east) / factor;
+  int rowStart = static_cast<int>(north) / factor, rowEnd = static_cast<int>(south) / factor;
+
+  float maxElevation = std::numeric_limits<float>::lowest();
+  bool found = false;
+  for(int row = rowStart; row <= rowEnd; row++)
+  {
+    for(int col = colStart; col <= colEnd; col++)
+    {
+      float cellMin, cellMax;
+      if(getPyramidCell(col * factor, row * factor, level, cellMin, cellMax))
+      {
+        maxElevation = std::max(maxElevation, cellMax);
+        found = true;
+      }
+    }
+  }
+  return found ? maxElevation : INVALID;
 }
 
 } // namespace common
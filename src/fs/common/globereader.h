@@ -19,8 +19,11 @@
 #define ATOOLS_DTM_GLOBEREADER_H
 
 #include <QFile>
+#include <QMutex>
 #include <QVector>
 
+#include <atomic>
+
 class DtmTest;
 class QFileInfo;
 
@@ -28,6 +31,7 @@ namespace atools {
 namespace geo {
 class Pos;
 class LineString;
+class Rect;
 }
 
 namespace fs {
@@ -38,6 +42,15 @@ static Q_DECL_CONSTEXPR float OCEAN = -500.f;
 
 /*
  * DTM reader class for the GLOBE data which can be get at https://www.ngdc.noaa.gov/mgg/topo/globeget.html
+ *
+ * Tile files are memory mapped on first access and elevations are read directly from the mapped memory.
+ * Falls back to file reads if a file cannot be mapped.
+ *
+ * An elevation pyramid keeps the minimum and maximum elevation for coarse cells of 8 arc minutes and 2 degrees.
+ * It is built once per tile on first use and can be saved in a cache directory to avoid scanning the tiles again.
+ * The pyramid allows conservative checks for large areas and profiles which are refined only near terrain.
+ *
+ * Elevation queries are thread safe and can be run in a worker thread. openFiles() and closeFiles() are not.
  */
 class GlobeReader
 {
@@ -52,12 +65,46 @@ public:
   bool openFiles();
   void closeFiles();
 
-  /* Elevation in meter */
+  /* Elevation in meter of the grid cell containing pos */
   float getElevation(const atools::geo::Pos& pos);
 
-  /* Get elevations along a great circle line. Will create a point every 500 meters and delete
+  /* Elevation in meter interpolated bilinear between the four nearest grid cells.
+   * Uses the nearest cell if one of the cells is ocean or not available. */
+  float getElevationBilinear(const atools::geo::Pos& pos);
+
+  /* Get elevations along a great circle line. Will create a point every 250 meters and delete
    * consecutive ones with same elevation */
-  void getElevations(geo::LineString& elevations, const atools::geo::LineString& linestring);
+  void getElevations(geo::LineString& elevations, const atools::geo::LineString& linestring, bool bilinear = false);
+
+  /* Get elevation in meter for each position. elevations is resized to the number of positions. */
+  void getElevations(QVector<float>& elevations, const atools::geo::LineString& positions, bool bilinear = false);
+
+  /* Like getElevations() but checks the line in steps of 4 km using the elevation pyramid first. Stretches
+   * where both ends are in flat pyramid cells of the same elevation (usually ocean) are not sampled in detail.
+   * Much faster for long routes across water. */
+  void getElevationsAdaptive(geo::LineString& elevations, const atools::geo::LineString& linestring,
+                             bool bilinear = false);
+
+  /* Maximum elevation in meter within rect from the elevation pyramid. Conservative, i.e. the result is never
+   * lower than the actual maximum. Uses the 2 degree cells for large rectangles.
+   * Returns INVALID if no data is available. */
+  float getMaxElevation(const atools::geo::Rect& rect);
+
+  /* Set directory for saving and loading the elevation pyramid. Not saved if empty which is the default.
+   * Must be set before any pyramid queries. */
+  void setPyramidCacheDir(const QString& value)
+  {
+    pyramidCacheDir = value;
+  }
+
+  /* Build the elevation pyramid for all tiles in parallel. Otherwise each tile is built on first access. */
+  void buildPyramid();
+
+  /* Exact maximum elevation in meter for each cell of one by one degree. grid is resized to 360 columns
+   * and 180 rows starting at the top left corner at 180° W and 90° N.
+   * Scans all elevations of the mapped tiles in parallel in bands of one degree.
+   * Cells of missing tiles are INVALID and cells containing only water are OCEAN. */
+  void getMaxElevationDegreeGrid(QVector<float>& grid);
 
 private:
   friend class::DtmTest;
@@ -77,6 +124,53 @@ private:
   /* Points are considered equal if they are equal within this range in meter */
   static Q_DECL_CONSTEXPR float SAME_ELEVATION_EPSILON = 1.f;
 
+  /* Grid cells per degree */
+  static Q_DECL_CONSTEXPR int DEGREE_CELLS = GRID_COLUMNS / 360;
+
+  /* Pyramid levels with cells of 16 (8 arc minutes) and 240 grid cells (2 degrees) */
+  static Q_DECL_CONSTEXPR int PYRAMID_LEVELS = 2;
+  /* Fine pyramid level is used for rectangles up to this number of cells */
+  static Q_DECL_CONSTEXPR int PYRAMID_MAX_QUERY_CELLS = 400;
+  /* Step length for coarse profile checks in meter */
+  static Q_DECL_CONSTEXPR float PYRAMID_SEGMENT_LENGTH = 4000.f;
+  static Q_DECL_CONSTEXPR quint32 PYRAMID_FILE_MAGIC = 0x474C5059;
+  static Q_DECL_CONSTEXPR quint32 PYRAMID_FILE_VERSION = 1;
+
+  /* Elevation pyramid for one tile. Cells are stored row by row. */
+  struct PyramidTile
+  {
+    QVector<qint16> minElevation[PYRAMID_LEVELS], maxElevation[PYRAMID_LEVELS];
+  };
+
+  /* Number of grid cells per pyramid cell */
+  static int pyramidFactor(int level)
+  {
+    return level == 0 ? 16 : 240;
+  }
+
+  /* Get or build pyramid for tile. null if tile is not available. */
+  const PyramidTile *pyramidTile(int fileIndex);
+  void buildPyramidTile(int fileIndex);
+  bool loadPyramidTile(PyramidTile& tile, int fileIndex);
+  void savePyramidTile(const PyramidTile& tile, int fileIndex);
+  QString pyramidFilename(int fileIndex) const;
+
+  /* Get elevation range of the pyramid cell at level containing the grid cell. false if no data. */
+  bool getPyramidCell(int gridCol, int gridRow, int level, float& minElevation, float& maxElevation);
+
+  /* Elevation in meter of pos if it is in a flat pyramid cell of the fine level. Otherwise INVALID. */
+  float getFlatElevation(const atools::geo::Pos& pos);
+
+  /* Add point to profile and drop consecutive ones with same elevation */
+  static void addElevation(atools::geo::LineString& elevations, atools::geo::Pos& lastDropped,
+                           const atools::geo::Pos& pos, float elevation);
+
+  /* Normalize grid position, return file index and change gridCol and gridRow to position within tile */
+  static int calcTile(int& gridCol, int& gridRow);
+
+  /* Top left grid position and number of rows of tile */
+  static void tileGeometry(int fileIndex, int& gridCol, int& gridRow, int& rows);
+
   /* Calculate file index and byte offset within file */
   qint64 calcFileOffset(int gridCol, int gridRow, int& fileIndex);
   qint64 calcFileOffset(const atools::geo::Pos& pos, int& fileIndex);
@@ -85,10 +179,41 @@ private:
   void closeFile(int i);
   void openFile(int i);
 
+  /* Elevation for grid cell. Opens and maps file if needed. */
+  float getElevation(int gridCol, int gridRow);
+
+  /* Calculate grid position with fraction */
+  static void gridPos(double& gridCol, double& gridRow, const atools::geo::Pos& pos);
+
+  /* State of a file in fileStates */
+  enum FileState
+  {
+    FILE_NOT_OPENED, /* Not accessed yet */
+    FILE_MAPPED, /* Mapped to memory in dataMaps */
+    FILE_READ, /* Open but not mapped - read using file */
+    FILE_UNAVAILABLE /* Missing or cannot be opened */
+  };
+
   QString dataDir;
   QVector<QString> dataFilenames;
   QVector<QFile *> dataFiles;
-  QVector<QDataStream *> dataStreams;
+
+  /* Mapped files or null */
+  QVector<const uchar *> dataMaps;
+
+  /* FileState for each file. Written under fileMutex and read without lock. */
+  std::atomic<int> fileStates[NUM_DATAFILES];
+
+  /* Guards opening files and reading not mapped files */
+  QMutex fileMutex;
+
+  /* Pyramid for each tile. Written once under pyramidMutex before pyramidBuilt is set. */
+  PyramidTile pyramidTiles[NUM_DATAFILES];
+  std::atomic<bool> pyramidBuilt[NUM_DATAFILES];
+
+  /* Guards building of pyramid tiles */
+  QMutex pyramidMutex[NUM_DATAFILES];
+  QString pyramidCacheDir;
 };
 
 } // namespace common
@@ -18,16 +18,20 @@
 #include "fs/common/magdecreader.h"
 #include "io/binarystream.h"
 #include "geo/pos.h"
+#include "geo/linestring.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlutil.h"
 #include "atools.h"
 #include "wmm/magdectool.h"
 #include "exception.h"
 #include "sql/sqlquery.h"
+#include "util/trace.h"
 
 #include <QFile>
+#include <QDataStream>
 #include <QDebug>
 #include <cmath>
+#include <algorithm>
 
 using atools::geo::Pos;
 
@@ -57,12 +61,37 @@ void MagDecReader::readFromWmm(const QDate& date)
 void MagDecReader::readFromWmm(int year, int month)
 {
   clear();
+  referenceDate = calculateWmm(year, month);
+}
+
+void MagDecReader::readFromWmmDeferred(const QDate& date)
+{
+  clear();
+  referenceDate.setDate(date.year(), date.month(), 1);
+  deferred.store(true);
+}
 
-  // Create WMM model data
+void MagDecReader::calculateDeferred() const
+{
+  if(deferred.load(std::memory_order_acquire))
+  {
+    QMutexLocker locker(&deferredMutex);
+    if(deferred.load(std::memory_order_relaxed))
+    {
+      calculateWmm(referenceDate.year(), referenceDate.month());
+      deferred.store(false, std::memory_order_release);
+    }
+  }
+}
+
+QDate MagDecReader::calculateWmm(int year, int month) const
+{
+  ATOOLS_TRACE_SCOPE("MagDecReader::calculateWmm", "startup");
+
+  // Create WMM model data - rows are calculated in parallel
   atools::wmm::MagDecTool magDecTool;
-  magDecTool.init(year, month);
+  magDecTool.init(year, month, true /* parallel */);
 
-  referenceDate = magDecTool.getReferenceDate();
   numValues = 360 * 181;
 
   // Copy to internal representation that allows saving and loading
@@ -72,6 +101,120 @@ void MagDecReader::readFromWmm(int year, int month)
     for(int lonX = -180; lonX < 180; lonX++)
       magDecValues[offset(lonX, latY)] = magDecTool.getMagVar(lonX, latY);
   }
+  return magDecTool.getReferenceDate();
+}
+
+void MagDecReader::writeWmmCache(const QString& filename, int firstYear, int numYears)
+{
+  QByteArray values;
+  QDataStream valueStream(&values, QIODevice::WriteOnly);
+  valueStream.setVersion(QDataStream::Qt_5_5);
+
+  QString version;
+  for(int year = firstYear; year < firstYear + numYears; year++)
+  {
+    atools::wmm::MagDecTool magDecTool;
+    magDecTool.init(year, 1);
+    version = magDecTool.getVersion();
+
+    // Same order as the internal array
+    QVector<qint16> grid(360 * 181);
+    for(int latY = -90; latY <= 90; latY++)
+    {
+      for(int lonX = -180; lonX < 180; lonX++)
+        grid[offset(lonX, latY)] = static_cast<qint16>(atools::roundToInt(magDecTool.getMagVar(lonX, latY) * 100.f));
+    }
+    valueStream << grid;
+  }
+
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+    out << WMM_CACHE_MAGIC << WMM_CACHE_VERSION << version << static_cast<qint32>(firstYear)
+        << static_cast<qint32>(numYears) << qCompress(values);
+    file.close();
+  }
+  else
+    throw atools::Exception(tr("Cannot write %1. Reason: %2").arg(file.fileName()).arg(file.errorString()));
+}
+
+bool MagDecReader::readFromWmmCache(const QString& filename, const QDate& date)
+{
+  QFile file(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    return false;
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magic, version;
+  QString cacheWmmVersion;
+  qint32 firstYear, numYears;
+  QByteArray compressed;
+  in >> magic >> version >> cacheWmmVersion >> firstYear >> numYears >> compressed;
+  file.close();
+
+  if(in.status() != QDataStream::Ok || magic != WMM_CACHE_MAGIC || version != WMM_CACHE_VERSION)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid WMM cache file" << filename;
+    return false;
+  }
+
+  // Find epochs before and after date - epochs are January 1st
+  QDate firstDate(firstYear, 1, 1), lastDate(firstYear + numYears - 1, 1, 1);
+  if(date < firstDate || date > lastDate)
+    return false;
+
+  int epoch = std::min(date.year() - firstYear, numYears - 2);
+  QDate epochDate(firstYear + epoch, 1, 1);
+  float fraction = 0.f;
+  if(numYears > 1)
+    fraction = static_cast<float>(epochDate.daysTo(date)) / static_cast<float>(epochDate.daysTo(epochDate.addYears(1)));
+
+  QByteArray values = qUncompress(compressed);
+  QDataStream valueStream(values);
+  valueStream.setVersion(QDataStream::Qt_5_5);
+
+  QVector<qint16> grid1, grid2;
+  for(int i = 0; i <= std::max(epoch, 0); i++)
+    valueStream >> grid1;
+  if(numYears > 1)
+    valueStream >> grid2;
+  else
+    grid2 = grid1;
+
+  if(valueStream.status() != QDataStream::Ok || grid1.size() != 360 * 181 || grid2.size() != grid1.size())
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid WMM cache file" << filename;
+    return false;
+  }
+
+  clear();
+  referenceDate = date;
+  wmmVersion = cacheWmmVersion;
+  numValues = static_cast<quint32>(grid1.size());
+  magDecValues = new float[numValues];
+  for(quint32 i = 0; i < numValues; i++)
+  {
+    float value1 = grid1.at(static_cast<int>(i)) / 100.f, value2 = grid2.at(static_cast<int>(i)) / 100.f;
+
+    // Avoid interpolating across the +/-180 degree jump near the magnetic poles
+    float diff = value2 - value1;
+    if(diff > 180.f)
+      diff -= 360.f;
+    else if(diff < -180.f)
+      diff += 360.f;
+
+    float value = value1 + diff * fraction;
+    if(value > 180.f)
+      value -= 360.f;
+    else if(value < -180.f)
+      value += 360.f;
+    magDecValues[i] = value;
+  }
+  return true;
 }
 
 void MagDecReader::readFromBgl(const QString& filename)
@@ -200,23 +343,40 @@ bool MagDecReader::readFromTable(sql::SqlDatabase& db)
   return false;
 }
 
+void MagDecReader::readFromReader(const MagDecReader& other)
+{
+  other.calculateDeferred();
+
+  clear();
+  referenceDate = other.referenceDate;
+  wmmVersion = other.wmmVersion;
+  if(other.magDecValues != nullptr)
+  {
+    numValues = other.numValues;
+    magDecValues = new float[numValues];
+    std::copy(other.magDecValues, other.magDecValues + numValues, magDecValues);
+  }
+}
+
 void MagDecReader::clear()
 {
   delete[] magDecValues;
   magDecValues = nullptr;
+  deferred.store(false);
   referenceDate = QDate();
   wmmVersion.clear();
 }
 
 bool MagDecReader::isValid() const
 {
-  return magDecValues != nullptr;
+  return magDecValues != nullptr || deferred.load(std::memory_order_acquire);
 }
 
 QByteArray MagDecReader::writeToBytes() const
 {
   if(!isValid())
     throw Exception("Magnetic declination values are invalid");
+  calculateDeferred();
 
   QByteArray bytes;
   QDataStream out(&bytes, QIODevice::WriteOnly);
@@ -234,7 +394,25 @@ float MagDecReader::getMagVar(const geo::Pos& pos) const
 {
   if(!isValid())
     throw Exception("MagDecReader is invalid");
+  calculateDeferred();
+
+  return interpolateMagVar(pos);
+}
+
+void MagDecReader::getMagVars(QVector<float>& magVars, const geo::LineString& positions) const
+{
+  if(!isValid())
+    throw Exception("MagDecReader is invalid");
+  calculateDeferred();
+
+  magVars.resize(positions.size());
+  float *data = magVars.data();
+  for(int i = 0; i < positions.size(); i++)
+    data[i] = interpolateMagVar(positions.at(i));
+}
 
+float MagDecReader::interpolateMagVar(const geo::Pos& pos) const
+{
   Pos posNorm(pos.normalized());
   float lonX = posNorm.getLonX();
   float latY = posNorm.getLatY();
@@ -304,7 +482,7 @@ float MagDecReader::magvar(int offset) const
 // For negative (West) longitudes (from -1 to -179):
 // Offset =((Long+360)*362)+(Lat*2)+316
 // Note that North latitudes should be entered as positive values (0 to 90) and South latitudes as negative values (-1 to -90)
-int MagDecReader::offset(int lonX, int latY) const
+int MagDecReader::offset(int lonX, int latY)
 {
   if(lonX == -180)
     // Wrap around - other values should not appear on normalized coordinates
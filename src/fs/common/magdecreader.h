@@ -20,10 +20,14 @@
 
 #include <QDate>
 #include <QApplication>
+#include <QMutex>
+
+#include <atomic>
 
 namespace atools {
 namespace geo {
 class Pos;
+class LineString;
 }
 
 namespace sql {
@@ -51,9 +55,27 @@ public:
   void readFromWmm(const QDate& date);
   void readFromWmm();
 
+  /* Like readFromWmm() but values are calculated on first use by any method needing them.
+   * Object is valid after this call. Avoids the calculation on startup if declination is rarely needed.
+   * The calculation is thread safe if methods are called concurrently. */
+  void readFromWmmDeferred(const QDate& date = QDate::currentDate());
+
+  /* Load values for date from a cache file written by writeWmmCache().
+   * Declination is interpolated linearly between the two epochs around the date.
+   * Returns false if the file cannot be read or if the date is not covered by the file. */
+  bool readFromWmmCache(const QString& filename, const QDate& date);
+
+  /* Write cache file with declination grids for January 1st of numYears years starting at firstYear.
+   * Values are stored compressed with a resolution of 0.01 degree. Throws exception on error. */
+  static void writeWmmCache(const QString& filename, int firstYear, int numYears);
+
   /* Read values from magdec.bgl file */
   void readFromBgl(const QString& filename);
 
+  /* Copy values from another reader which has to be valid. Calculates deferred values of other if needed.
+   * Used to share a world magnetic model which is calculated once between several compilations. */
+  void readFromReader(const MagDecReader& other);
+
   /* Read values from table "magdecl" returns true if successfull and table exists. */
   bool readFromTable(atools::sql::SqlDatabase& db);
 
@@ -71,6 +93,10 @@ public:
    */
   float getMagVar(const atools::geo::Pos& pos) const;
 
+  /* Interpolated declination for each position. magVars is resized to the number of positions.
+   * Faster than calling getMagVar() for each position. Throws exception if object is not valid. */
+  void getMagVars(QVector<float>& magVars, const atools::geo::LineString& positions) const;
+
   const QDate& getReferenceDate() const
   {
     return referenceDate;
@@ -86,14 +112,32 @@ private:
   QByteArray writeToBytes() const;
   void readFromBytes(const QByteArray& bytes);
 
-  int offset(int lonX, int latY) const;
+  /* getMagVar() without validity check */
+  float interpolateMagVar(const atools::geo::Pos& pos) const;
+
+  /* Calculate values if requested by readFromWmmDeferred() */
+  void calculateDeferred() const;
+
+  /* Calculate values and return reference date used by the model */
+  QDate calculateWmm(int year, int month) const;
+
+  static Q_DECL_CONSTEXPR quint32 WMM_CACHE_MAGIC = 0x574D4D43;
+  static Q_DECL_CONSTEXPR quint32 WMM_CACHE_VERSION = 1;
+
+  static int offset(int lonX, int latY);
   float magvar(int offset) const;
 
   QDate referenceDate;
-  quint32 numValues = 0;
+
+  /* Mutable since values are calculated on first access after readFromWmmDeferred() */
+  mutable quint32 numValues = 0;
 
   /* https://www.fsdeveloper.com/wiki/index.php?title=Magdec_BGL_File */
-  float *magDecValues = nullptr;
+  mutable float *magDecValues = nullptr;
+
+  /* true if values are not calculated yet. deferredMutex guards the calculation. */
+  mutable std::atomic<bool> deferred{false};
+  mutable QMutex deferredMutex;
 
   QString wmmVersion;
 };
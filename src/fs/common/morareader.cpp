@@ -16,13 +16,20 @@
 *****************************************************************************/
 
 #include "fs/common/morareader.h"
+#include "fs/common/globereader.h"
 #include "sql/sqlquery.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlutil.h"
 #include "geo/pos.h"
+#include "geo/linestring.h"
+#include "geo/rect.h"
+#include "geo/calculations.h"
 #include "exception.h"
+#include "atools.h"
 
 #include <QDataStream>
+#include <algorithm>
+#include <cmath>
 
 using atools::sql::SqlQuery;
 using atools::sql::SqlUtil;
@@ -108,6 +115,7 @@ bool MoraReader::readFromTable()
             << lonxColums << "x *" << latyRows << "y" << bytes.size() << "bytes";
 
     dataAvailable = true;
+    buildRowMaxTable();
     return true;
   }
   else
@@ -125,6 +133,7 @@ void MoraReader::writeToTable(const QVector<quint16>& grid, int columns, int row
   lonxColums = columns;
   latyRows = rows;
   dataAvailable = true;
+  buildRowMaxTable();
 
   SqlQuery moraWriteQuery(db);
   moraWriteQuery.prepare(SqlUtil(db).buildInsertStatement("mora_grid", QString(), {"mora_grid_id"}));
@@ -153,6 +162,29 @@ void MoraReader::writeToTable(const QVector<quint16>& grid, int columns, int row
   moraWriteQuery.exec();
 }
 
+void MoraReader::writeFromGlobe(GlobeReader& globeReader)
+{
+  QVector<float> elevations;
+  globeReader.getMaxElevationDegreeGrid(elevations);
+
+  QVector<quint16> grid(elevations.size(), OCEAN);
+  for(int i = 0; i < elevations.size(); i++)
+  {
+    float elevation = elevations.at(i);
+    if(elevation >= atools::fs::common::INVALID)
+      grid[i] = UNKNOWN;
+    else if(elevation > atools::fs::common::OCEAN)
+    {
+      // Round up to hundreds of feet after adding the clearance
+      float elevationFt = atools::geo::meterToFeet(std::max(elevation, 0.f));
+      float clearanceFt = elevationFt > 5000.f ? 2000.f : 1000.f;
+      grid[i] = static_cast<quint16>(std::ceil((elevationFt + clearanceFt) / 100.f));
+    }
+  }
+
+  writeToTable(grid, 360, 180);
+}
+
 bool MoraReader::isDataAvailable()
 {
   return dataAvailable;
@@ -161,7 +193,8 @@ bool MoraReader::isDataAvailable()
 void MoraReader::clear()
 {
   datagrid.clear();
-  lonxColums = latyRows = 0;
+  rowMaxTable.clear();
+  lonxColums = latyRows = rowMaxLevels = 0;
   dataAvailable = false;
 }
 
@@ -207,6 +240,220 @@ int MoraReader::getMoraFt(int lonx, int laty) const
   return datagrid.at(pos);
 }
 
+void MoraReader::buildRowMaxTable()
+{
+  rowMaxTable.clear();
+  rowMaxLevels = 0;
+  if(lonxColums <= 0 || latyRows <= 0)
+    return;
+
+  while((1 << rowMaxLevels) <= lonxColums)
+    rowMaxLevels++;
+
+  int levelSize = latyRows * lonxColums;
+  rowMaxTable.resize(rowMaxLevels * levelSize);
+  qint16 *table = rowMaxTable.data();
+
+  // Level 0 - use the same adjustments as getMoraFt()
+  for(int row = 0; row < latyRows; row++)
+  {
+    for(int col = 0; col < lonxColums; col++)
+    {
+      int value = getMoraFt(col - 180, -row + 90);
+      table[row * lonxColums + col] = static_cast<qint16>(value == UNKNOWN || value == ERROR ? -1 : value);
+    }
+  }
+
+  // Each level combines two ranges of the level below
+  for(int level = 1; level < rowMaxLevels; level++)
+  {
+    int half = 1 << (level - 1);
+    for(int row = 0; row < latyRows; row++)
+    {
+      const qint16 *below = table + ((level - 1) * latyRows + row) * lonxColums;
+      qint16 *current = table + (level * latyRows + row) * lonxColums;
+      for(int col = 0; col + (1 << level) <= lonxColums; col++)
+        current[col] = std::max(below[col], below[col + half]);
+    }
+  }
+}
+
+int MoraReader::rowMax(int row, int col1, int col2) const
+{
+  int level = 0;
+  while((2 << level) <= col2 - col1 + 1)
+    level++;
+
+  const qint16 *table = rowMaxTable.constData() + (level * latyRows + row) * lonxColums;
+  return std::max(table[col1], table[col2 - (1 << level) + 1]);
+}
+
+int MoraReader::getMaxMoraFt(const geo::Rect& rect) const
+{
+  if(!dataAvailable)
+    throw Exception("MORA data not available");
+
+  // Cells are given by top left corner - include cells touched at the border
+  int north = std::min(static_cast<int>(std::floor(rect.getNorth())) + 1, 90);
+  int south = std::max(static_cast<int>(std::ceil(rect.getSouth())), -89);
+  int west = static_cast<int>(std::floor(rect.getWest())), east = static_cast<int>(std::floor(rect.getEast()));
+
+  if(rect.crossesAntiMeridian())
+    east += 360;
+  if(west > 179)
+  {
+    west -= 360;
+    east -= 360;
+  }
+  if(east - west >= 360)
+  {
+    west = -180;
+    east = 179;
+  }
+
+  int col1 = west + 180, col2 = east + 180;
+  int result = -1;
+  for(int laty = south; laty <= north; laty++)
+  {
+    int row = -laty + 90;
+    if(col2 < lonxColums)
+      result = std::max(result, rowMax(row, col1, col2));
+    else
+    {
+      // Split at anti-meridian
+      result = std::max(result, rowMax(row, col1, lonxColums - 1));
+      result = std::max(result, rowMax(row, 0, col2 - lonxColums));
+    }
+  }
+  return result == -1 ? UNKNOWN : result;
+}
+
+int MoraReader::getMaxMoraFt(const geo::Pos& pos1, const geo::Pos& pos2) const
+{
+  if(!dataAvailable)
+    throw Exception("MORA data not available");
+
+  int result = UNKNOWN;
+  maxMoraLeg(result, pos1, pos2);
+  return result;
+}
+
+int MoraReader::getMaxMoraFt(const geo::LineString& line) const
+{
+  if(!dataAvailable)
+    throw Exception("MORA data not available");
+
+  int result = UNKNOWN;
+  if(line.size() == 1)
+    maxMoraLeg(result, line.first(), line.first());
+
+  for(int i = 0; i < line.size() - 1; i++)
+    maxMoraLeg(result, line.at(i), line.at(i + 1));
+  return result;
+}
+
+void MoraReader::maxMoraColumn(int& result, int lonx, double minLat, double maxLat) const
+{
+  // Include cells touched at the border
+  int south = std::max(static_cast<int>(std::ceil(minLat)), -89);
+  int north = std::min(static_cast<int>(std::floor(maxLat)) + 1, 90);
+
+  for(int laty = south; laty <= north; laty++)
+  {
+    int value = getMoraFt(lonx, laty);
+    if(value != UNKNOWN && value != ERROR)
+      result = result == UNKNOWN ? value : std::max(result, value);
+  }
+}
+
+void MoraReader::maxMoraLeg(int& result, const geo::Pos& pos1, const geo::Pos& pos2) const
+{
+  using atools::geo::toRadians;
+  using atools::geo::toDegree;
+
+  double lon1 = pos1.getLonX(), lat1 = pos1.getLatY(), lat2 = pos2.getLatY();
+  double deltaLon = static_cast<double>(pos2.getLonX()) - lon1;
+  while(deltaLon > 180.)
+    deltaLon -= 360.;
+  while(deltaLon <= -180.)
+    deltaLon += 360.;
+
+  if(std::abs(deltaLon) < 1.e-9)
+  {
+    // Along meridian
+    maxMoraColumn(result, static_cast<int>(std::floor(lon1)), std::min(lat1, lat2), std::max(lat1, lat2));
+    return;
+  }
+
+  if(std::abs(deltaLon) > 180. - 1.e-9)
+  {
+    // Crosses pole
+    double pole = lat1 + lat2 >= 0. ? 90. : -90.;
+    maxMoraColumn(result, static_cast<int>(std::floor(lon1)), std::min(lat1, pole), std::max(lat1, pole));
+    maxMoraColumn(result, static_cast<int>(std::floor(lon1 + deltaLon)), std::min(lat2, pole),
+                  std::max(lat2, pole));
+    return;
+  }
+
+  // Great circle latitude at longitude:
+  // tan(lat) = (tan(lat1) * sin(lon2 - lon) + tan(lat2) * sin(lon - lon1)) / sin(lon2 - lon1)
+  double lon2 = lon1 + deltaLon;
+  double lambda1 = toRadians(lon1), lambda2 = toRadians(lon2);
+  double tan1 = std::tan(toRadians(atools::minmax(-89.9999, 89.9999, lat1)));
+  double tan2 = std::tan(toRadians(atools::minmax(-89.9999, 89.9999, lat2)));
+  double sinDelta = std::sin(lambda2 - lambda1);
+
+  auto latAt = [&](double lon) -> double {
+    if(lon <= std::min(lon1, lon2))
+      return lon1 < lon2 ? lat1 : lat2;
+    else if(lon >= std::max(lon1, lon2))
+      return lon1 < lon2 ? lat2 : lat1;
+
+    double lambda = toRadians(lon);
+    return toDegree(std::atan((tan1 * std::sin(lambda2 - lambda) + tan2 * std::sin(lambda - lambda1)) / sinDelta));
+  };
+
+  // Numerator is a * sin(lon) + b * cos(lon) which has its extremes at atan2(a, b) and atan2(a, b) + 180
+  double a = tan2 * std::cos(lambda1) - tan1 * std::cos(lambda2);
+  double b = tan1 * std::sin(lambda2) - tan2 * std::sin(lambda1);
+  double lonLow = std::min(lon1, lon2), lonHigh = std::max(lon1, lon2);
+  double vertexLon = toDegree(std::atan2(a, b));
+  bool hasVertex = false;
+  for(int i = 0; i < 2 && !hasVertex; i++)
+  {
+    double lon = vertexLon + i * 180.;
+    while(lon < lonLow)
+      lon += 360.;
+    while(lon - 360. >= lonLow)
+      lon -= 360.;
+
+    if(lon < lonHigh)
+    {
+      vertexLon = lon;
+      hasVertex = true;
+    }
+  }
+
+  // Follow line from meridian to meridian - each part is within one column
+  double start = lonLow;
+  while(start < lonHigh)
+  {
+    double end = std::min(std::floor(start) + 1., lonHigh);
+    double latStart = latAt(start), latEnd = latAt(end);
+    double minLat = std::min(latStart, latEnd), maxLat = std::max(latStart, latEnd);
+
+    if(hasVertex && vertexLon > start && vertexLon < end)
+    {
+      double latVertex = latAt(vertexLon);
+      minLat = std::min(minLat, latVertex);
+      maxLat = std::max(maxLat, latVertex);
+    }
+
+    maxMoraColumn(result, static_cast<int>(std::floor(start)), minLat, maxLat);
+    start = end;
+  }
+}
+
 } // namespace common
 } // namespace fs
 } // namespace atools
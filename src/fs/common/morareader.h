@@ -24,6 +24,8 @@
 namespace atools {
 namespace geo {
 class Pos;
+class LineString;
+class Rect;
 }
 namespace sql {
 class SqlDatabase;
@@ -32,6 +34,8 @@ class SqlDatabase;
 namespace fs {
 namespace common {
 
+class GlobeReader;
+
 /*
  * Provides methods to read, write and access the MORA (minimum off route altitude) data.
  *
@@ -57,6 +61,12 @@ public:
   /* Writes values to table "mora_grid". Object has to be valid. Copies data to this instance. */
   void writeToTable(const QVector<quint16>& datagrid, int columns, int rows);
 
+  /* Calculates the grid from the maximum elevation of each one degree cell in the GLOBE data and writes it to
+   * table "mora_grid" like writeToTable(). Used if the source has no MORA. Adds a clearance of 1000 feet
+   * for elevations up to 5000 feet and 2000 feet above. Cells without data are UNKNOWN and water is OCEAN.
+   * globeReader must have opened files. */
+  void writeFromGlobe(atools::fs::common::GlobeReader& globeReader);
+
   /* True if table is present in schema and has one row */
   bool isDataAvailable();
 
@@ -79,6 +89,19 @@ public:
   int getMoraFt(const atools::geo::Pos& pos) const;
   int getMoraFt(int lonx, int laty) const;
 
+  /* Maximum MORA in feet * 100 of all grid cells crossed by the great circle line from pos1 to pos2.
+   * Cells are found by following the line from meridian to meridian which includes the latitude extremes
+   * of the line. Cells touched only at the border are included.
+   * Returns UNKNOWN if all cells are not surveyed. Throws exception if object is not valid. */
+  int getMaxMoraFt(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2) const;
+
+  /* Maximum MORA as above for all great circle legs of the line string */
+  int getMaxMoraFt(const atools::geo::LineString& line) const;
+
+  /* Maximum MORA of all grid cells overlapping the rectangle. Uses a range table for each row, i.e. needs
+   * only one lookup per row. Returns UNKNOWN if all cells are not surveyed. */
+  int getMaxMoraFt(const atools::geo::Rect& rect) const;
+
   /* Not surveyed */
   const static quint16 UNKNOWN = std::numeric_limits<quint16>::max();
 
@@ -89,11 +112,26 @@ public:
   const static quint16 OCEAN = 0;
 
 private:
+  /* Fill rowMaxTable from datagrid */
+  void buildRowMaxTable();
+
+  /* Maximum of known values in columns col1 to col2 of grid row. -1 if all unknown. */
+  int rowMax(int row, int col1, int col2) const;
+
+  /* Update result with maximum of cells in column lonx between the latitudes */
+  void maxMoraColumn(int& result, int lonx, double minLat, double maxLat) const;
+  void maxMoraLeg(int& result, const atools::geo::Pos& pos1, const atools::geo::Pos& pos2) const;
+
   atools::sql::SqlDatabase *db;
   bool dataAvailable = false;
   QVector<quint16> datagrid;
   int lonxColums = 0, latyRows = 0;
 
+  /* Sparse table for each row. Level k contains the maximum of 2^k cells starting at each column.
+   * Unknown values are stored as -1. Index is (level * latyRows + row) * lonxColums + column */
+  QVector<qint16> rowMaxTable;
+  int rowMaxLevels = 0;
+
   const static quint32 MAGIC_NUMBER_DATA = 0xA5B44CDB;
   const static quint32 DATA_VERSION = 1;
 
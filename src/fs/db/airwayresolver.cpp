@@ -24,6 +24,7 @@
 #include "geo/rect.h"
 #include "geo/calculations.h"
 #include "fs/progresshandler.h"
+#include "util/parallel.h"
 
 #include <QDebug>
 #include <QString>
@@ -31,6 +32,7 @@
 #include <algorithm>
 #include <QQueue>
 #include <QElapsedTimer>
+#include <QStringBuilder>
 
 namespace atools {
 namespace fs {
@@ -117,6 +119,37 @@ uint qHash(const AirwayResolver::AirwaySegment& segment)
          qHash(segment.type);
 }
 
+/* Connected chain of segments for an airway name */
+struct AirwayResolver::Fragment
+{
+  QSet<int> waypoints;
+  QVector<AirwaySegment> segments;
+  int fragmentNum = 0;
+};
+
+namespace {
+
+/* Row from tmp_airway_point with resolved waypoint for the in-memory resolver */
+struct AirwayPoint
+{
+  QString name, type, prevKey, nextKey;
+  int waypointId;
+  atools::geo::Pos pos;
+  char prevDir, nextDir;
+  int prevMinAlt, prevMaxAlt, nextMinAlt, nextMaxAlt;
+};
+
+/* Key for waypoint hash tables. Returns empty string if ident is null which avoids joining. */
+inline QString waypointKey(const QVariant& type, const QVariant& ident, const QVariant& region)
+{
+  if(ident.isNull())
+    return QString();
+
+  return type.toString() % '|' % ident.toString() % '|' % region.toString();
+}
+
+} // namespace
+
 AirwayResolver::AirwayResolver(sql::SqlDatabase *sqlDb, atools::fs::ProgressHandler& progress)
   : progressHandler(progress), curAirwayId(1), numAirways(0), airwayInsertStmt(sqlDb), db(sqlDb)
 {
@@ -180,18 +213,8 @@ bool AirwayResolver::run(int numReportSteps)
     QString awName = query.value("name").toString();
     QString awType = query.value("type").toString();
 
-    if((row++ % rowsPerStep) == 0)
-    {
-      qint64 elapsed2 = timer.elapsed();
-
-      // Update only every 500 ms - otherwise update only progress count
-      bool silent = !(elapsed + MIN_PROGRESS_REPORT_MS < elapsed2);
-      if(!silent)
-        elapsed = elapsed2;
-      steps++;
-      if((aborted = progressHandler.reportOther(tr("Creating airways: %1...").arg(awName), -1, silent)) == true)
-        break;
-    }
+    if((aborted = reportProgress(row++, rowsPerStep, steps, elapsed, timer, awName)))
+      break;
 
     if(awName != currentAirway)
     {
@@ -200,20 +223,12 @@ bool AirwayResolver::run(int numReportSteps)
       {
         // Build airway fragments
         QVector<Fragment> fragments;
-        buildAirway(currentAirway, airway, fragments);
+        buildAirway(airway, fragments);
 
         // Remove all fragments that are contained by others
         cleanFragments(fragments);
 
-        for(const Fragment& fragment : fragments)
-        {
-          for(const TypeRowValueVector& bindRow : fragment.boundValues)
-          {
-            airwayInsertStmt.bindValues(bindRow);
-            airwayInsertStmt.exec();
-            numAirways += airwayInsertStmt.numRowsAffected();
-          }
-        }
+        writeFragments(currentAirway, fragments);
         airway.clear();
       }
       currentAirway = awName;
@@ -264,8 +279,150 @@ bool AirwayResolver::run(int numReportSteps)
   return aborted;
 }
 
-void AirwayResolver::buildAirway(const QString& airwayName, QSet<AirwaySegment>& airway,
-                                 QVector<Fragment>& fragments)
+bool AirwayResolver::runInMemory(int numReportSteps)
+{
+  bool aborted = false;
+
+  // Clean the table
+  SqlQuery query(db);
+  query.exec("delete from airway");
+  int deleted = query.numRowsAffected();
+  qInfo() << "Removed" << deleted << "from airway table";
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // Load all waypoints and index them by type, ident and region ==========================
+  // Type mapping is the same as for tmp_waypoint in assignWaypointIds()
+  QMultiHash<QString, int> waypointIdsByKey;
+  QHash<int, Pos> waypointPosById;
+  SqlQuery waypointQuery(db);
+  waypointQuery.setForwardOnly(true);
+  waypointQuery.prepare("select waypoint_id, "
+                        "  case when type == 'V' then 'V' when type == 'N' then 'N' else 'O' end as type, "
+                        "  ident, region, lonx, laty from waypoint order by waypoint_id");
+  waypointQuery.exec();
+  while(waypointQuery.next())
+  {
+    int id = waypointQuery.valueInt(0);
+    waypointIdsByKey.insert(waypointKey(waypointQuery.value(1), waypointQuery.value(2), waypointQuery.value(3)), id);
+    waypointPosById.insert(id, Pos(waypointQuery.valueFloat(4), waypointQuery.valueFloat(5)));
+  }
+  waypointQuery.finish();
+
+  // Load all airway points ordered by name and resolve the waypoint ==========================
+  QVector<AirwayPoint> points;
+  SqlQuery pointQuery(db);
+  pointQuery.setForwardOnly(true);
+  pointQuery.prepare("select name, type, mid_type, mid_ident, mid_region, "
+                     "  previous_type, previous_ident, previous_region, previous_direction, "
+                     "  previous_minimum_altitude, previous_maximum_altitude, "
+                     "  next_type, next_ident, next_region, next_direction, "
+                     "  next_minimum_altitude, next_maximum_altitude "
+                     "from tmp_airway_point order by name, airway_point_id");
+  pointQuery.exec();
+  while(pointQuery.next())
+  {
+    // Use the lowest id if the waypoint is ambiguous like assignWaypointIds() does
+    QList<int> ids = waypointIdsByKey.values(waypointKey(pointQuery.value(2), pointQuery.value(3),
+                                                         pointQuery.value(4)));
+    if(ids.isEmpty())
+      continue;
+
+    AirwayPoint point;
+    point.name = pointQuery.valueStr(0);
+    point.type = pointQuery.valueStr(1);
+    point.waypointId = *std::min_element(ids.constBegin(), ids.constEnd());
+    point.pos = waypointPosById.value(point.waypointId);
+
+    point.prevKey = waypointKey(pointQuery.value(5), pointQuery.value(6), pointQuery.value(7));
+    point.prevDir = atools::strToChar(pointQuery.valueStr(8));
+    point.prevMinAlt = pointQuery.valueInt(9);
+    point.prevMaxAlt = pointQuery.valueInt(10);
+
+    point.nextKey = waypointKey(pointQuery.value(11), pointQuery.value(12), pointQuery.value(13));
+    point.nextDir = atools::strToChar(pointQuery.valueStr(14));
+    point.nextMinAlt = pointQuery.valueInt(15);
+    point.nextMaxAlt = pointQuery.valueInt(16);
+    points.append(point);
+  }
+  pointQuery.finish();
+
+  // Get ranges of points having the same airway name
+  QVector<std::pair<int, int> > ranges;
+  for(int i = 0; i < points.size(); i++)
+  {
+    if(i == 0 || points.at(i).name != points.at(i - 1).name)
+      ranges.append(std::make_pair(i, i + 1));
+    else
+      ranges.last().second = i + 1;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Loaded" << points.size() << "airway points" << ranges.size() << "airways"
+           << timer.elapsed() << "ms";
+
+  // Build fragments for each airway in parallel ==========================
+  // Hash tables are only read which is thread safe
+  float maxLengthMeter = atools::geo::nmToMeter(maxAirwaySegmentLengthNm);
+  QVector<QVector<Fragment> > airwayFragments(ranges.size());
+  atools::util::parallelFor(ranges.size(), [&](int rangeIndex) {
+    QSet<AirwaySegment> airway;
+    for(int i = ranges.at(rangeIndex).first; i < ranges.at(rangeIndex).second; i++)
+    {
+      const AirwayPoint& point = points.at(i);
+
+      // Previous waypoints found - add segments
+      for(int prevId : waypointIdsByKey.values(point.prevKey))
+      {
+        Pos prevPos = waypointPosById.value(prevId);
+        if(point.pos.distanceMeterTo(prevPos) < maxLengthMeter)
+          airway.insert(AirwaySegment(prevId, point.waypointId, point.prevDir, point.prevMinAlt, point.prevMaxAlt,
+                                      point.type, prevPos, point.pos));
+      }
+
+      // Next waypoints found - add segments
+      for(int nextId : waypointIdsByKey.values(point.nextKey))
+      {
+        Pos nextPos = waypointPosById.value(nextId);
+        if(point.pos.distanceMeterTo(nextPos) < maxLengthMeter)
+          airway.insert(AirwaySegment(point.waypointId, nextId, point.nextDir, point.nextMinAlt, point.nextMaxAlt,
+                                      point.type, point.pos, nextPos));
+      }
+    }
+
+    QVector<Fragment>& fragments = airwayFragments[rangeIndex];
+    buildAirway(airway, fragments);
+    cleanFragments(fragments);
+  });
+
+  qDebug() << Q_FUNC_INFO << "Built fragments" << timer.elapsed() << "ms";
+
+  // Write all airways in order of name ==========================
+  int rowsPerStep = std::max(1, static_cast<int>(std::ceil(static_cast<float>(ranges.size()) /
+                                                           static_cast<float>(numReportSteps))));
+  int steps = 0;
+  qint64 elapsed = timer.elapsed();
+  for(int i = 0; i < ranges.size(); i++)
+  {
+    const QString& name = points.at(ranges.at(i).first).name;
+    if((aborted = reportProgress(i, rowsPerStep, steps, elapsed, timer, name)))
+      break;
+
+    writeFragments(name, airwayFragments.at(i));
+  }
+
+  // Eat up any remaining progress steps
+  progressHandler.increaseCurrent(numReportSteps - steps);
+
+  qInfo() << "Added " << numAirways << " airway segments" << timer.elapsed() << "ms";
+
+  if(!aborted)
+    db->commit();
+
+  return aborted;
+}
+
+void AirwayResolver::buildAirway(QSet<AirwaySegment>& airway, QVector<Fragment>& fragments)
 {
   // Queue of waypoints that will get waypoints in order prependend and appendend
   QQueue<AirwaySegment> newAirway;
@@ -332,56 +489,77 @@ void AirwayResolver::buildAirway(const QString& airwayName, QSet<AirwaySegment>&
       }
     } while(foundTo || foundFrom);
 
-    // Write airway fragment - there may be more fragments for the same airway name
-    AirwaySegment last;
-    int seqNo = 1;
+    // Collect airway fragment - there may be more fragments for the same airway name
     Fragment fragment;
-
+    fragment.fragmentNum = fragmentNum++;
     for(const AirwaySegment& newSegment : newAirway)
     {
-      last = newSegment;
-
       fragment.waypoints.insert(newSegment.fromWaypointId);
       fragment.waypoints.insert(newSegment.toWaypointId);
+      fragment.segments.append(newSegment);
+    }
+    fragments.append(fragment);
+  }
+}
 
+void AirwayResolver::writeFragments(const QString& airwayName, const QVector<Fragment>& fragments)
+{
+  for(const Fragment& fragment : fragments)
+  {
+    int seqNo = 1;
+    for(const AirwaySegment& segment : fragment.segments)
+    {
       // Create bounding rect for this segment
-      Rect bounding(newSegment.fromPos);
-      bounding.extend(newSegment.toPos);
-
-      TypeRowValueVector row;
-
-      row.append(std::make_pair(":airway_id", curAirwayId));
-      row.append(std::make_pair(":airway_name", airwayName));
-      row.append(std::make_pair(":airway_type", newSegment.type));
-      row.append(std::make_pair(":airway_fragment_no", fragmentNum));
-      row.append(std::make_pair(":sequence_no", seqNo));
-
-      row.append(std::make_pair(":from_waypoint_id", newSegment.fromWaypointId));
-      row.append(std::make_pair(":to_waypoint_id", newSegment.toWaypointId));
-
-      row.append(std::make_pair(":direction", atools::charToStr(newSegment.dir)));
-      row.append(std::make_pair(":minimum_altitude", newSegment.minAlt));
-      row.append(std::make_pair(":maximum_altitude", newSegment.maxAlt));
-      row.append(std::make_pair(":left_lonx", bounding.getTopLeft().getLonX()));
-      row.append(std::make_pair(":top_laty", bounding.getTopLeft().getLatY()));
-      row.append(std::make_pair(":right_lonx", bounding.getBottomRight().getLonX()));
-      row.append(std::make_pair(":bottom_laty", bounding.getBottomRight().getLatY()));
+      Rect bounding(segment.fromPos);
+      bounding.extend(segment.toPos);
+
+      airwayInsertStmt.bindValue(":airway_id", curAirwayId);
+      airwayInsertStmt.bindValue(":airway_name", airwayName);
+      airwayInsertStmt.bindValue(":airway_type", segment.type);
+      airwayInsertStmt.bindValue(":airway_fragment_no", fragment.fragmentNum);
+      airwayInsertStmt.bindValue(":sequence_no", seqNo);
+
+      airwayInsertStmt.bindValue(":from_waypoint_id", segment.fromWaypointId);
+      airwayInsertStmt.bindValue(":to_waypoint_id", segment.toWaypointId);
+
+      airwayInsertStmt.bindValue(":direction", atools::charToStr(segment.dir));
+      airwayInsertStmt.bindValue(":minimum_altitude", segment.minAlt);
+      airwayInsertStmt.bindValue(":maximum_altitude", segment.maxAlt);
+      airwayInsertStmt.bindValue(":left_lonx", bounding.getTopLeft().getLonX());
+      airwayInsertStmt.bindValue(":top_laty", bounding.getTopLeft().getLatY());
+      airwayInsertStmt.bindValue(":right_lonx", bounding.getBottomRight().getLonX());
+      airwayInsertStmt.bindValue(":bottom_laty", bounding.getBottomRight().getLatY());
 
       // Write start and end coordinates for this segment
-      row.append(std::make_pair(":from_lonx", newSegment.fromPos.getLonX()));
-      row.append(std::make_pair(":from_laty", newSegment.fromPos.getLatY()));
-      row.append(std::make_pair(":to_lonx", newSegment.toPos.getLonX()));
-      row.append(std::make_pair(":to_laty", newSegment.toPos.getLatY()));
+      airwayInsertStmt.bindValue(":from_lonx", segment.fromPos.getLonX());
+      airwayInsertStmt.bindValue(":from_laty", segment.fromPos.getLatY());
+      airwayInsertStmt.bindValue(":to_lonx", segment.toPos.getLonX());
+      airwayInsertStmt.bindValue(":to_laty", segment.toPos.getLatY());
 
-      fragment.boundValues.append(row);
+      airwayInsertStmt.exec();
+      numAirways += airwayInsertStmt.numRowsAffected();
 
       seqNo++;
       curAirwayId++;
     }
-    fragments.append(fragment);
+  }
+}
 
-    fragmentNum++;
+bool AirwayResolver::reportProgress(int row, int rowsPerStep, int& steps, qint64& elapsed, const QElapsedTimer& timer,
+                                    const QString& airwayName)
+{
+  if((row % rowsPerStep) == 0)
+  {
+    qint64 elapsed2 = timer.elapsed();
+
+    // Update only every 500 ms - otherwise update only progress count
+    bool silent = !(elapsed + MIN_PROGRESS_REPORT_MS < elapsed2);
+    if(!silent)
+      elapsed = elapsed2;
+    steps++;
+    return progressHandler.reportOther(tr("Creating airways: %1...").arg(airwayName), -1, silent);
   }
+  return false;
 }
 
 void AirwayResolver::cleanFragments(QVector<Fragment>& fragments)
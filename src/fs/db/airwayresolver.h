@@ -22,8 +22,11 @@
 #include "geo/pos.h"
 
 #include <QSet>
+#include <QVector>
 #include <QCoreApplication>
 
+class QElapsedTimer;
+
 namespace atools {
 namespace fs {
 
@@ -52,6 +55,14 @@ public:
    */
   bool run(int numReportSteps);
 
+  /*
+   * Same as run() but loads all airway points and waypoints into memory and joins them using hash tables.
+   * Airway fragments are built in parallel for each airway name. Does not need assignWaypointIds().
+   * Reads from "tmp_airway_point" and "waypoint" and writes to table "airway".
+   * @return true if the process was aborted
+   */
+  bool runInMemory(int numReportSteps);
+
   struct AirwaySegment;
 
   /*
@@ -68,18 +79,21 @@ public:
 private:
   int maxAirwaySegmentLengthNm = 8000;
 
-  typedef std::pair<QString, QVariant> TypeRowValue;
-  typedef QVector<TypeRowValue> TypeRowValueVector;
+  struct Fragment;
 
-  struct Fragment
-  {
-    QSet<int> waypoints;
-    QVector<TypeRowValueVector> boundValues;
-  };
+  /* Connect segments of one airway to fragments. Segments are removed from airway. */
+  static void buildAirway(QSet<atools::fs::db::AirwayResolver::AirwaySegment>& airway,
+                          QVector<atools::fs::db::AirwayResolver::Fragment>& fragments);
+
+  /* Remove all fragments that are contained by others */
+  static void cleanFragments(QVector<atools::fs::db::AirwayResolver::Fragment>& fragments);
+
+  /* Write all segments of the fragments into the airway table and assign airway ids */
+  void writeFragments(const QString& airwayName, const QVector<atools::fs::db::AirwayResolver::Fragment>& fragments);
 
-  void buildAirway(const QString& airwayName, QSet<atools::fs::db::AirwayResolver::AirwaySegment>& airway,
-                   QVector<Fragment>& fragments);
-  void cleanFragments(QVector<Fragment>& fragments);
+  /* Report progress for row and airway name. Returns true if aborted. */
+  bool reportProgress(int row, int rowsPerStep, int& steps, qint64& elapsed, const QElapsedTimer& timer,
+                      const QString& airwayName);
 
   atools::fs::ProgressHandler& progressHandler;
   int curAirwayId, numAirways;
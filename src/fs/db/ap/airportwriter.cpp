@@ -33,6 +33,7 @@
 #include "fs/bgl/ap/rw/runway.h"
 #include "fs/bgl/ap/del/deleteairport.h"
 #include "fs/db/dbairportindex.h"
+#include "fs/db/dbsessionindex.h"
 #include "fs/db/nav/waypointwriter.h"
 #include "fs/db/ap/comwriter.h"
 #include "fs/bgl/ap/parking.h"
@@ -146,8 +147,13 @@ void AirportWriter::writeObject(const Airport *type)
     if(getOptions().isDeletes())
     {
       if(delAp != nullptr || isRealAddon)
+      {
+        // Delete processor reads and changes rows of previous airports
+        dw.flushBatches();
+
         // Now delete the stock/default airport
         deleteProcessor.preProcessDelete();
+      }
     }
 
     QStringList sceneryLocalPaths, bglFilenames;
@@ -277,10 +283,11 @@ void AirportWriter::writeObject(const Airport *type)
     // Write the airport to the database
     executeStatement();
 
-    // Update index
+    // Update indexes
     currentIdent = type->getIdent();
     currentPos = type->getPosition().getPos();
     getAirportIndex()->add(type->getIdent(), getCurrentId());
+    getSessionIndex()->addAirport(type->getIdent(), getCurrentId());
 
     // Write all subrecords now since the airport id is not available - this keeps the foreign keys valid
     RunwayWriter *rwWriter = dw.getRunwayWriter();
@@ -316,6 +323,10 @@ void AirportWriter::writeObject(const Airport *type)
     TaxiPathWriter *taxiWriter = dw.getTaxiPathWriter();
     taxiWriter->write(type->getTaxiPaths());
 
+    if(getOptions().isDeletes() && (delAp != nullptr || isRealAddon))
+      // Delete processor reads features of this airport
+      dw.flushBatches();
+
     if(getOptions().isDeletes())
     {
       if(delAp != nullptr)
@@ -332,13 +343,7 @@ void AirportWriter::writeObject(const Airport *type)
 
 int atools::fs::db::AirportWriter::airportIdByIdent(const QString& ident)
 {
-  atools::sql::SqlQuery query(getDataWriter().getDatabase());
-  query.prepare("select airport_id from airport where ident = :ident");
-  query.bindValue(":ident", ident);
-  query.exec();
-  int newId = -1;
-  if(query.next())
-    newId = query.valueInt(0);
+  int newId = getSessionIndex()->getAirportId(ident);
 
   if(newId == -1)
     qWarning() << Q_FUNC_INFO << "Other airport with ident" << ident << "not found";
@@ -44,7 +44,7 @@ class AirportWriter :
 {
 public:
   AirportWriter(atools::sql::SqlDatabase& db, atools::fs::db::DataWriter& dataWriter)
-    : WriterBase(db, dataWriter, "airport"), deleteProcessor(db, dataWriter.getOptions())
+    : WriterBase(db, dataWriter, "airport"), deleteProcessor(db, dataWriter.getOptions(), dataWriter.getSessionIndex())
   {
   }
 
@@ -65,10 +65,16 @@ public:
     return currentPos;
   }
 
+  /* Run collected airport deletes and updates. Called at the end of each scenery area. */
+  void flushDeletes()
+  {
+    deleteProcessor.flush();
+  }
+
 private:
   virtual void writeObject(const atools::fs::bgl::Airport *type) override;
 
-  /* Get airport id for given ident */
+  /* Get id of the last written airport for given ident from the session index */
   int airportIdByIdent(const QString& ident);
 
   /* Update frequencies and other flags MSFS airports if encountering a dummy for COM and procedures */
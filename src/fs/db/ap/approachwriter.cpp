@@ -21,12 +21,13 @@
 #include "fs/bgl/util.h"
 #include "fs/db/ap/airportwriter.h"
 #include "fs/db/ap/approachlegwriter.h"
-#include "fs/db/runwayindex.h"
+#include "fs/db/dbsessionindex.h"
 #include "fs/db/ap/transitionwriter.h"
 #include "fs/bgl/ap/approachtypes.h"
 #include "geo/calculations.h"
 #include "atools.h"
 
+#include <QDebug>
 #include <QString>
 
 namespace atools {
@@ -86,8 +87,17 @@ void ApproachWriter::writeObject(const Approach *type)
       // Use invalid 36 as fallback if nothing found
       runway = type->getRunwayName();
 
-    int id = getDataWriter().getRunwayIndex()->getRunwayEndId(
-      getDataWriter().getAirportWriter()->getCurrentAirportIdent(), runway, "approach runway");
+    // Session index finds runways of airports in other BGL files too - needed for MSFS navdata airports
+    int id = -1;
+    if(runway != "00")
+    {
+      id = getSessionIndex()->getRunwayEndId(getDataWriter().getAirportWriter()->getCurrentId(), runway);
+      if(id == -1)
+        qWarning().nospace().noquote() << "Runway end ID for airport "
+                                       << getDataWriter().getAirportWriter()->getCurrentAirportIdent()
+                                       << " and runway " << runway << " not found for approach runway";
+    }
+
     if(id != -1)
       bind(":runway_name", runway);
     else
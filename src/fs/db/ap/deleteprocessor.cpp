@@ -26,6 +26,7 @@
 #include "fs/bgl/ap/airport.h"
 #include "fs/db/ap/transitionwriter.h"
 #include "fs/navdatabaseoptions.h"
+#include "fs/db/dbsessionindex.h"
 
 #include <QDebug>
 
@@ -39,8 +40,9 @@ using atools::sql::SqlQuery;
 using atools::sql::SqlUtil;
 using bgl::util::isFlagSet;
 
-DeleteProcessor::DeleteProcessor(atools::sql::SqlDatabase& sqlDb, const NavDatabaseOptions& opts)
-  : options(opts), db(&sqlDb)
+DeleteProcessor::DeleteProcessor(atools::sql::SqlDatabase& sqlDb, const NavDatabaseOptions& opts,
+                                 DbSessionIndex *sessionIndexParam)
+  : options(opts), sessionIndex(sessionIndexParam), db(&sqlDb)
 {
   // Create all queries
   deleteRunwayStmt = new SqlQuery(sqlDb);
@@ -48,7 +50,6 @@ DeleteProcessor::DeleteProcessor(atools::sql::SqlDatabase& sqlDb, const NavDatab
   deleteParkingStmt = new SqlQuery(sqlDb);
   updateParkingStmt = new SqlQuery(sqlDb);
 
-  fetchRunwayEndIdStmt = new SqlQuery(sqlDb);
   deleteRunwayEndStmt = new SqlQuery(sqlDb);
 
   updateApprochRwIds = new SqlQuery(sqlDb);
@@ -156,6 +157,20 @@ DeleteProcessor::DeleteProcessor(atools::sql::SqlDatabase& sqlDb, const NavDatab
     "  select end_lonx as lonx, end_laty as laty from taxi_path where airport_id = :apid "
     ")");
 
+  deferred = options.isBatchDeletes();
+  if(deferred)
+  {
+    // One row for each table and action containing the airport ids
+    db->exec("create temp table if not exists tmp_delete_airport ("
+             "tbl varchar(20) not null, remove integer not null, "
+             "prev_airport_id integer not null, cur_airport_id integer not null, "
+             "primary key (tbl, remove, prev_airport_id))");
+    db->exec("delete from tmp_delete_airport");
+
+    insertDeferredStmt = new SqlQuery(sqlDb);
+    insertDeferredStmt->prepare("insert into tmp_delete_airport (tbl, remove, prev_airport_id, cur_airport_id) "
+                                "values(:tbl, :remove, :prevApId, :curApId)");
+  }
 }
 
 DeleteProcessor::~DeleteProcessor()
@@ -164,7 +179,6 @@ DeleteProcessor::~DeleteProcessor()
   delete updateRunwayStmt;
   delete deleteParkingStmt;
   delete updateParkingStmt;
-  delete fetchRunwayEndIdStmt;
   delete deleteRunwayEndStmt;
   delete updateApprochRwIds;
   delete updateApproachStmt;
@@ -189,6 +203,7 @@ DeleteProcessor::~DeleteProcessor()
 
   delete updateBoundingStmt;
   delete fetchBoundingStmt;
+  delete insertDeferredStmt;
 }
 
 void DeleteProcessor::init(const DeleteAirport *deleteAirportRec, const Airport *airport, int airportId,
@@ -221,6 +236,13 @@ void DeleteProcessor::preProcessDelete()
   // Get facility counts for current airport
   extractPreviousAirportFeatures();
 
+  if(deferred && hasPrevious && deferredCurrentIds.contains(prevAirportId))
+  {
+    // Previous airport replaced another one in this batch - finish this first to get all features
+    flush();
+    extractPreviousAirportFeatures();
+  }
+
   // Delete the whole tree of approaches, transitions and legs on the old airport later in
   // ":/atools/resources/sql/fs/db/delete_duplicates.sql"
 
@@ -257,7 +279,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasApproach)
   {
-    removeOrUpdate(deleteApproachStmt, updateApproachStmt, bgl::del::APPROACHES);
+    removeOrUpdate(deleteApproachStmt, updateApproachStmt, bgl::del::APPROACHES, "approach");
 
     if(hasPrevious && !isFlagSet(deleteFlags, bgl::del::APPROACHES))
     {
@@ -270,7 +292,7 @@ void DeleteProcessor::postProcessDelete()
   // Work on facilities that will be either removed or attached to the new airport depending on flags
   if(prevHasApron)
   {
-    removeOrUpdate(deleteApronStmt, updateApronStmt, bgl::del::APRONS);
+    removeOrUpdate(deleteApronStmt, updateApronStmt, bgl::del::APRONS, "apron");
 
     if(!isFlagSet(deleteFlags, bgl::del::APRONS) && hasPrevious)
       // Update apron count in new airport
@@ -279,7 +301,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasCom)
   {
-    removeOrUpdate(deleteComStmt, updateComStmt, bgl::del::COMS);
+    removeOrUpdate(deleteComStmt, updateComStmt, bgl::del::COMS, "com");
 
     if(!isFlagSet(deleteFlags, bgl::del::COMS) && hasPrevious)
     {
@@ -291,7 +313,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasHelipad)
   {
-    removeOrUpdate(deleteHelipadStmt, updateHelipadStmt, bgl::del::HELIPADS);
+    removeOrUpdate(deleteHelipadStmt, updateHelipadStmt, bgl::del::HELIPADS, "helipad");
 
     if(!isFlagSet(deleteFlags, bgl::del::HELIPADS) && hasPrevious)
       // Update helipad count in new airport
@@ -300,7 +322,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasTaxi)
   {
-    removeOrUpdate(deleteTaxiPathStmt, updateTaxiPathStmt, bgl::del::TAXIWAYS);
+    removeOrUpdate(deleteTaxiPathStmt, updateTaxiPathStmt, bgl::del::TAXIWAYS, "taxi_path");
 
     if(!isFlagSet(deleteFlags, bgl::del::TAXIWAYS) && hasPrevious)
       // Update taxi count in new airport
@@ -309,7 +331,7 @@ void DeleteProcessor::postProcessDelete()
 
   if(prevHasStart)
   {
-    removeOrUpdate(deleteStartStmt, updateStartStmt, bgl::del::STARTS);
+    removeOrUpdate(deleteStartStmt, updateStartStmt, bgl::del::STARTS, "start");
 
     if(!isFlagSet(deleteFlags, bgl::del::STARTS) && hasPrevious)
       // Update start count in new airport
@@ -319,11 +341,18 @@ void DeleteProcessor::postProcessDelete()
   if(prevHasRunways)
   {
     if(isFlagSet(deleteFlags, bgl::del::RUNWAYS))
-      removeRunways();
+    {
+      if(deferred)
+        executeOrDefer(deleteRunwayStmt, "runway", true, "runways deleted");
+      else
+        removeRunways();
+      sessionIndex->removeRunwayEnds(prevAirportId);
+    }
     else if(hasPrevious)
     {
       // Relink runways
-      bindAndExecute(updateRunwayStmt, "runways updated");
+      executeOrDefer(updateRunwayStmt, "runway", false, "runways updated");
+      sessionIndex->moveRunwayEnds(prevAirportId, currentAirportId);
       copyAirportColumns << "is_closed" << "num_runway_hard" << "num_runway_soft" << "num_runway_water" <<
         "num_runway_light" << "num_runway_end_closed" << "num_runway_end_vasi" << "num_runway_end_als" <<
         "longest_runway_length" << "longest_runway_width" <<
@@ -334,11 +363,11 @@ void DeleteProcessor::postProcessDelete()
 
   if(!newAirport->getParkings().isEmpty())
     // New airport has parking - delete the previous ones
-    bindAndExecute(deleteParkingStmt, "parking spots deleted");
+    executeOrDefer(deleteParkingStmt, "parking", true, "parking spots deleted");
   else if(hasPrevious)
   {
     // New airport has no parking - transfer previous ones and update counts
-    bindAndExecute(updateParkingStmt, "parking spots updated");
+    executeOrDefer(updateParkingStmt, "parking", false, "parking spots updated");
 
     copyAirportColumns << "num_parking_gate" << "num_parking_ga_ramp" << "num_parking_cargo"
                        << "num_parking_mil_cargo" << "num_parking_mil_combat" << "num_jetway"
@@ -388,43 +417,96 @@ void DeleteProcessor::postProcessDelete()
   }
 
   copyAirportValues(copyAirportColumns);
-  updateBoundingRect();
+
+  if(hasPrevious && newAirport->getPosition().getPos().distanceMeterTo(prevPos) > 500)
+  {
+    // Airport has moved more than 500 meter - update bounding rectangle after features are moved
+    if(deferred)
+      deferredBoundingIds.append(currentAirportId);
+    else
+      updateBoundingRect(currentAirportId);
+  }
 
   removeAirport();
+
+  if(deferred && hasPrevious)
+    deferredCurrentIds.insert(currentAirportId);
 }
 
-void DeleteProcessor::updateBoundingRect()
+void DeleteProcessor::flush()
 {
-  if(hasPrevious && newAirport->getPosition().getPos().distanceMeterTo(prevPos) > 500)
+  if(!deferred || deferredCurrentIds.isEmpty())
+    return;
+
+  if(options.isVerbose())
+    qInfo() << Q_FUNC_INFO << "airports" << deferredCurrentIds.size();
+
+  // Order is the same as in postProcessDelete() and removeAirport()
+  static const QStringList TABLES({"approach", "apron", "com", "helipad", "taxi_path", "start", "runway",
+                                   "parking", "waypoint", "vor", "ndb", "airport"});
+
+  // Delete runway ends first since the ids are fetched from the runways
+  bindAndExecute("delete from runway_end where runway_end_id in ("
+                 "select r.primary_end_id from runway r "
+                 "join tmp_delete_airport d on r.airport_id = d.prev_airport_id "
+                 "where d.tbl = 'runway' and d.remove = 1 "
+                 "union "
+                 "select r.secondary_end_id from runway r "
+                 "join tmp_delete_airport d on r.airport_id = d.prev_airport_id "
+                 "where d.tbl = 'runway' and d.remove = 1)", "runway ends deleted");
+
+  for(const QString& table : TABLES)
   {
-    // Airport has moved more than 500 meter - update bounding rectangle
+    bindAndExecute("delete from " + table + " where airport_id in ("
+                   "select prev_airport_id from tmp_delete_airport where tbl = '" + table + "' and remove = 1)",
+                   table + " deleted");
+
+    bindAndExecute("update " + table + " set airport_id = ("
+                   "select d.cur_airport_id from tmp_delete_airport d where d.tbl = '" + table + "' and "
+                   "d.remove = 0 and d.prev_airport_id = " + table + ".airport_id) "
+                   "where airport_id in ("
+                   "select prev_airport_id from tmp_delete_airport where tbl = '" + table + "' and remove = 0)",
+                   table + " updated");
+  }
+
+  db->exec("delete from tmp_delete_airport");
+
+  // Features are moved now - calculate new bounding rectangles
+  for(int id : deferredBoundingIds)
+    updateBoundingRect(id);
 
-    fetchBoundingStmt->bindValue(":apid", currentAirportId);
-    executeStatement(fetchBoundingStmt, "Fetch bounding");
-    if(fetchBoundingStmt->next())
+  deferredCurrentIds.clear();
+  deferredBoundingIds.clear();
+}
+
+void DeleteProcessor::updateBoundingRect(int airportId)
+{
+  fetchBoundingStmt->bindValue(":apid", airportId);
+  executeStatement(fetchBoundingStmt, "Fetch bounding");
+  if(fetchBoundingStmt->next())
+  {
+    if(!fetchBoundingStmt->isNull("left_lonx") &&
+       !fetchBoundingStmt->isNull("top_laty") &&
+       !fetchBoundingStmt->isNull("right_lonx") &&
+       !fetchBoundingStmt->isNull("bottom_laty"))
     {
-      if(!fetchBoundingStmt->isNull("left_lonx") &&
-         !fetchBoundingStmt->isNull("top_laty") &&
-         !fetchBoundingStmt->isNull("right_lonx") &&
-         !fetchBoundingStmt->isNull("bottom_laty"))
-      {
-        updateBoundingStmt->bindValue(":apid", currentAirportId);
-        updateBoundingStmt->bindValue(":leftlonx", fetchBoundingStmt->value("left_lonx").toFloat());
-        updateBoundingStmt->bindValue(":toplaty", fetchBoundingStmt->value("top_laty").toFloat());
-        updateBoundingStmt->bindValue(":rightlonx", fetchBoundingStmt->value("right_lonx").toFloat());
-        updateBoundingStmt->bindValue(":bottomlaty", fetchBoundingStmt->value("bottom_laty").toFloat());
-        executeStatement(updateBoundingStmt, "Update bounding");
-      }
+      updateBoundingStmt->bindValue(":apid", airportId);
+      updateBoundingStmt->bindValue(":leftlonx", fetchBoundingStmt->value("left_lonx").toFloat());
+      updateBoundingStmt->bindValue(":toplaty", fetchBoundingStmt->value("top_laty").toFloat());
+      updateBoundingStmt->bindValue(":rightlonx", fetchBoundingStmt->value("right_lonx").toFloat());
+      updateBoundingStmt->bindValue(":bottomlaty", fetchBoundingStmt->value("bottom_laty").toFloat());
+      executeStatement(updateBoundingStmt, "Update bounding");
     }
-    fetchBoundingStmt->finish();
   }
+  fetchBoundingStmt->finish();
 }
 
 void DeleteProcessor::removeRunways()
 {
-  QList<int> runwayEndIds;
-  fetchRunwayEndIdStmt->bindValue(":prevApId", prevAirportId);
-  fetchIds(fetchRunwayEndIdStmt, runwayEndIds, " runway ends to delete");
+  // Session index knows the runway ends of all airports written in this compilation
+  QVector<int> runwayEndIds = sessionIndex->getRunwayEndIds(prevAirportId);
+  if(options.isVerbose())
+    qDebug() << runwayEndIds.size() << " runway ends to delete";
 
   // Delete runway first due to foreign key from rw -> rw end
   bindAndExecute(deleteRunwayStmt, "runways deleted");
@@ -439,15 +521,40 @@ void DeleteProcessor::removeRunways()
 
 void DeleteProcessor::removeAirport()
 {
+  if(hasPrevious)
+    sessionIndex->removeAirport(ident, prevAirportId);
+
   // Unlink navigation - will be updated later in "update_nav_ids.sql" script
   // we accecpt duplicates here - these will be deleted later
-  bindAndExecute(updateWpStmt, "waypoints updated");
-  bindAndExecute(updateVorStmt, "vors updated");
-  bindAndExecute(updateNdbStmt, "ndb updated");
+  executeOrDefer(updateWpStmt, "waypoint", false, "waypoints updated");
+  executeOrDefer(updateVorStmt, "vor", false, "vors updated");
+  executeOrDefer(updateNdbStmt, "ndb", false, "ndb updated");
 
-  int deleted = bindAndExecute(deleteAirportStmt, "airports deleted");
-  if(deleted > 1)
-    qWarning() << "Removed more than one airport" << deleted;
+  if(deferred)
+    executeOrDefer(deleteAirportStmt, "airport", true, "airports deleted");
+  else
+  {
+    int deleted = bindAndExecute(deleteAirportStmt, "airports deleted");
+    if(deleted > 1)
+      qWarning() << "Removed more than one airport" << deleted;
+  }
+}
+
+void DeleteProcessor::executeOrDefer(SqlQuery *stmt, const QString& table, bool remove, const QString& msg)
+{
+  if(deferred)
+  {
+    if(hasPrevious)
+    {
+      insertDeferredStmt->bindValue(":tbl", table);
+      insertDeferredStmt->bindValue(":remove", remove);
+      insertDeferredStmt->bindValue(":prevApId", prevAirportId);
+      insertDeferredStmt->bindValue(":curApId", currentAirportId);
+      insertDeferredStmt->exec();
+    }
+  }
+  else
+    bindAndExecute(stmt, msg);
 }
 
 int DeleteProcessor::executeStatement(SqlQuery *stmt, const QString& what)
@@ -462,26 +569,16 @@ int DeleteProcessor::executeStatement(SqlQuery *stmt, const QString& what)
   return retval > 0 ? retval : 0;
 }
 
-void DeleteProcessor::fetchIds(SqlQuery *stmt, QList<int>& ids, const QString& what)
-{
-  stmt->exec();
-  while(stmt->next())
-    ids.append(stmt->value(0).toInt());
-
-  if(options.isVerbose())
-    qDebug() << ids.size() << " " << what /*<< "bound" << stmt->boundValues()*/;
-}
-
 /* use the remove of update query for a feture depending on the delete flag */
 void DeleteProcessor::removeOrUpdate(SqlQuery *deleteStmt, SqlQuery *updateStmt,
-                                     bgl::del::DeleteAllFlags flag)
+                                     bgl::del::DeleteAllFlags flag, const QString& table)
 {
   QString delTypeStr = bgl::DeleteAirport::deleteAllFlagsToStr(flag).toLower();
 
   if(isFlagSet(deleteFlags, flag))
-    bindAndExecute(deleteStmt, delTypeStr + " deleted");
+    executeOrDefer(deleteStmt, table, true, delTypeStr + " deleted");
   else
-    bindAndExecute(updateStmt, delTypeStr + " updated");
+    executeOrDefer(updateStmt, table, false, delTypeStr + " updated");
 }
 
 /* Create a statement that sets all airport_id columns to null in the given table that have
@@ -577,8 +674,6 @@ void DeleteProcessor::extractDeleteFlags()
 
 void DeleteProcessor::extractPreviousAirportFeatures()
 {
-  bindAndExecute(selectAirportStmt, "select airports");
-
   prevHasApproach = false;
   prevHasApron = false;
   prevHasCom = false;
@@ -594,6 +689,11 @@ void DeleteProcessor::extractPreviousAirportFeatures()
   bglFilename.clear();
   prevPos = atools::geo::Pos();
 
+  // All airports pass the session index - avoid the query if there is no other airport with the same ident
+  if(sessionIndex->getAirportId(ident, currentAirportId) == -1)
+    return;
+
+  bindAndExecute(selectAirportStmt, "select airports");
   if(selectAirportStmt->next())
   {
     prevHasApproach |= selectAirportStmt->valueInt("num_approach") > 0;
@@ -20,6 +20,8 @@
 
 #include "fs/bgl/ap/airport.h"
 
+#include <QSet>
+
 namespace bgl {
 namespace ap {
 class Airport;
@@ -39,6 +41,7 @@ namespace db {
 
 class DataWriter;
 class ApproachWriter;
+class DbSessionIndex;
 
 /*
  * Deletes stock/default airports for a new airport. Uses the delete records and removes or updates all
@@ -47,7 +50,9 @@ class ApproachWriter;
 class DeleteProcessor
 {
 public:
-  DeleteProcessor(atools::sql::SqlDatabase& sqlDb, const atools::fs::NavDatabaseOptions& opts);
+  /* Session index is used to look up previous airports and runway ends and is updated on deletes */
+  DeleteProcessor(atools::sql::SqlDatabase& sqlDb, const atools::fs::NavDatabaseOptions& opts,
+                  atools::fs::db::DbSessionIndex *sessionIndexParam);
   virtual ~DeleteProcessor();
 
   /*
@@ -68,6 +73,13 @@ public:
    */
   void postProcessDelete();
 
+  /*
+   * Run all deletes and updates collected for batch deletes (see NavDatabaseOptions::isBatchDeletes())
+   * with a few statements per table. Has to be called at the end of each scenery area. Does nothing if
+   * batch deletes are disabled.
+   */
+  void flush();
+
   const QString& getBglFilename() const
   {
     return bglFilename;
@@ -80,7 +92,6 @@ public:
 
 private:
   int executeStatement(sql::SqlQuery *stmt, const QString& what);
-  void fetchIds(sql::SqlQuery *stmt, QList<int>& ids, const QString& what);
 
   void removeRunways();
   void removeAirport();
@@ -88,7 +99,10 @@ private:
   QString updateAptFeatureStmt(const QString& table);
   QString delAptFeatureStmt(const QString& table);
   void removeOrUpdate(sql::SqlQuery *deleteStmt, sql::SqlQuery *updateStmt,
-                      atools::fs::bgl::del::DeleteAllFlags flag);
+                      atools::fs::bgl::del::DeleteAllFlags flag, const QString& table);
+
+  /* Execute statement or remember previous and current airport id for table in batch mode */
+  void executeOrDefer(sql::SqlQuery *stmt, const QString& table, bool remove, const QString& msg);
   QString updateAptFeatureToNullStmt(const QString& table);
   void removeApproachesAndTransitions(const QList<int>& ids);
   void extractDeleteFlags();
@@ -97,16 +111,16 @@ private:
   int bindAndExecute(const QString& sql, const QString& msg);
   void extractPreviousAirportFeatures();
   void copyAirportValues(const QStringList& copyAirportColumns);
-  void updateBoundingRect();
+  void updateBoundingRect(int airportId);
 
   const atools::fs::NavDatabaseOptions& options;
+  atools::fs::db::DbSessionIndex *sessionIndex;
 
   atools::sql::SqlQuery
   *deleteRunwayStmt = nullptr,
   *updateRunwayStmt = nullptr,
   *deleteParkingStmt = nullptr,
   *updateParkingStmt = nullptr,
-  *fetchRunwayEndIdStmt = nullptr,
   *updateApprochRwIds = nullptr,
   *deleteRunwayEndStmt = nullptr,
   *updateWpStmt = nullptr,
@@ -120,7 +134,13 @@ private:
   *deleteTaxiPathStmt = nullptr, *updateTaxiPathStmt = nullptr,
   *deleteComStmt = nullptr, *updateComStmt = nullptr,
   *fetchPrimaryAppStmt = nullptr, *fetchSecondaryAppStmt = nullptr,
-  *updateBoundingStmt = nullptr, *fetchBoundingStmt = nullptr;
+  *updateBoundingStmt = nullptr, *fetchBoundingStmt = nullptr,
+  *insertDeferredStmt = nullptr;
+
+  /* Batch mode - ids of new airports which are waiting for flush and need a bounding rectangle update */
+  bool deferred = false;
+  QSet<int> deferredCurrentIds;
+  QVector<int> deferredBoundingIds;
 
   const atools::fs::bgl::DeleteAirport *deleteAirport = nullptr;
   atools::fs::bgl::del::DeleteAllFlags deleteFlags = atools::fs::bgl::del::NONE;
@@ -22,6 +22,7 @@
 #include "fs/db/ap/airportwriter.h"
 #include "fs/db/ap/rw/runwayendwriter.h"
 #include "fs/db/runwayindex.h"
+#include "fs/db/dbsessionindex.h"
 #include "fs/navdatabaseoptions.h"
 #include "geo/calculations.h"
 #include "atools.h"
@@ -40,6 +41,7 @@ void RunwayWriter::writeObject(const Runway *type)
   int runwayId = getNextId();
 
   QString apIdent = getDataWriter().getAirportWriter()->getCurrentAirportIdent();
+  int airportId = getDataWriter().getAirportWriter()->getCurrentId();
 
   // Write runway ends before runway because we need the end ids to keep the foreign keys valid
   RunwayEndWriter *runwayEndWriter = getDataWriter().getRunwayEndWriter();
@@ -47,17 +49,19 @@ void RunwayWriter::writeObject(const Runway *type)
   runwayEndWriter->writeOne(type->getPrimary());
   int primaryEndId = runwayEndWriter->getCurrentId();
   getRunwayIndex()->add(apIdent, type->getPrimary().getName(), primaryEndId);
+  getSessionIndex()->addRunwayEnd(airportId, type->getPrimary().getName(), primaryEndId);
 
   runwayEndWriter->writeOne(type->getSecondary());
   int secondaryEndId = runwayEndWriter->getCurrentId();
   getRunwayIndex()->add(apIdent, type->getSecondary().getName(), secondaryEndId);
+  getSessionIndex()->addRunwayEnd(airportId, type->getSecondary().getName(), secondaryEndId);
 
   if(getOptions().isVerbose())
     qDebug() << "Writing Runway for airport " << apIdent;
 
   // Write runway
   bind(":runway_id", runwayId);
-  bind(":airport_id", getDataWriter().getAirportWriter()->getCurrentId());
+  bind(":airport_id", airportId);
   bind(":primary_end_id", primaryEndId);
   bind(":secondary_end_id", secondaryEndId);
 
@@ -0,0 +1,140 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/db/bglfilecache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+static const quint32 CACHE_MAGIC_NUMBER = 0x42474C43; // "BGLC"
+static const quint16 CACHE_VERSION = 1;
+
+BglFileCache::BglFileCache(const QString& filename, const QByteArray& optionsHash)
+  : cacheFilename(filename), hash(optionsHash)
+{
+  load();
+}
+
+BglFileCache::~BglFileCache()
+{
+
+}
+
+bool BglFileCache::isEmptyFile(const QFileInfo& fileinfo) const
+{
+  auto it = files.constFind(fileinfo.absoluteFilePath());
+  return it != files.constEnd() && it.value().size == fileinfo.size() &&
+         it.value().lastModified == fileinfo.lastModified().toMSecsSinceEpoch();
+}
+
+void BglFileCache::addEmptyFile(const QFileInfo& fileinfo)
+{
+  files.insert(fileinfo.absoluteFilePath(), {fileinfo.size(), fileinfo.lastModified().toMSecsSinceEpoch()});
+  changed = true;
+}
+
+void BglFileCache::load()
+{
+  files.clear();
+
+  QFile file(cacheFilename);
+  if(!file.exists())
+    return;
+
+  if(file.open(QIODevice::ReadOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    quint32 magic;
+    quint16 version;
+    QByteArray fileHash;
+    stream >> magic >> version;
+
+    if(magic == CACHE_MAGIC_NUMBER && version == CACHE_VERSION)
+    {
+      stream >> fileHash;
+      if(fileHash == hash)
+      {
+        qint32 num;
+        stream >> num;
+        files.reserve(num);
+        for(qint32 i = 0; i < num && stream.status() == QDataStream::Ok; i++)
+        {
+          QString path;
+          Entry entry;
+          stream >> path >> entry.size >> entry.lastModified;
+          files.insert(path, entry);
+        }
+
+        if(stream.status() != QDataStream::Ok)
+        {
+          qWarning() << Q_FUNC_INFO << "Error reading cache file" << cacheFilename;
+          files.clear();
+        }
+      }
+      else
+        qInfo() << Q_FUNC_INFO << "Options changed. Dropping cache" << cacheFilename;
+    }
+    else
+      qWarning() << Q_FUNC_INFO << "Invalid cache file" << cacheFilename << "magic" << magic << "version" << version;
+    file.close();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot read cache file" << cacheFilename << file.errorString();
+
+  qInfo() << Q_FUNC_INFO << "Loaded" << files.size() << "empty files from" << cacheFilename;
+}
+
+void BglFileCache::save()
+{
+  if(!changed)
+    return;
+
+  QSaveFile file(cacheFilename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    stream << CACHE_MAGIC_NUMBER << CACHE_VERSION << hash << static_cast<qint32>(files.size());
+    for(auto it = files.constBegin(); it != files.constEnd(); ++it)
+      stream << it.key() << it.value().size << it.value().lastModified;
+
+    if(file.commit())
+    {
+      changed = false;
+      qInfo() << Q_FUNC_INFO << "Saved" << files.size() << "empty files to" << cacheFilename;
+    }
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot write cache file" << cacheFilename << file.errorString();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write cache file" << cacheFilename << file.errorString();
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,85 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_DB_BGLFILECACHE_H
+#define ATOOLS_FS_DB_BGLFILECACHE_H
+
+#include <QHash>
+#include <QString>
+
+class QFileInfo;
+
+namespace atools {
+namespace fs {
+namespace db {
+
+/*
+ * Persistent cache of BGL files which were found to have no relevant content like airports or navaids.
+ * Most stock scenery BGL files contain only terrain or objects. These are skipped on recompiles
+ * without opening and parsing them.
+ *
+ * Files are keyed by absolute path, size and modification time. The whole cache is dropped
+ * if the options hash changes since filters decide which records are relevant.
+ * Not thread safe.
+ */
+class BglFileCache
+{
+public:
+  /*
+   * @param filename Cache file which is loaded if it exists
+   * @param optionsHash Hash of all options affecting the BGL reader. See NavDatabaseOptions::getOptionsHash().
+   */
+  BglFileCache(const QString& filename, const QByteArray& optionsHash);
+  ~BglFileCache();
+
+  BglFileCache(const BglFileCache& other) = delete;
+  BglFileCache& operator=(const BglFileCache& other) = delete;
+
+  /* true if the file was read before without finding any content and is unchanged */
+  bool isEmptyFile(const QFileInfo& fileinfo) const;
+
+  /* Remember file as having no content */
+  void addEmptyFile(const QFileInfo& fileinfo);
+
+  /* Write cache file if changed. Errors are only logged. */
+  void save();
+
+  int size() const
+  {
+    return files.size();
+  }
+
+private:
+  struct Entry
+  {
+    qint64 size, lastModified;
+  };
+
+  void load();
+
+  QString cacheFilename;
+  QByteArray hash;
+  QHash<QString, Entry> files;
+  bool changed = false;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_BGLFILECACHE_H
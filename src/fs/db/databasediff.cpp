@@ -0,0 +1,588 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/db/databasediff.h"
+
+#include "fs/db/databasemeta.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqltransaction.h"
+#include "sql/sqlutil.h"
+#include "exception.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+
+/* Row id column name used if a table has no own integer primary key */
+static const QString ROWID("rowid");
+
+namespace {
+
+QByteArray hash(const QByteArray& data)
+{
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+QByteArray serialize(const QVariantList& values)
+{
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream.setVersion(QDataStream::Qt_5_5);
+  for(const QVariant& value : values)
+    stream << value;
+  return data;
+}
+
+QVariantList deserialize(const QByteArray& data, int numValues)
+{
+  QVariantList values;
+  QDataStream stream(data);
+  stream.setVersion(QDataStream::Qt_5_5);
+  for(int i = 0; i < numValues; i++)
+  {
+    QVariant value;
+    stream >> value;
+    values.append(value);
+  }
+
+  if(stream.status() != QDataStream::Ok)
+    throw atools::Exception("Invalid row data in patch");
+  return values;
+}
+
+/* Save references as "column=table,column=table" */
+QString referencesToString(const QHash<QString, QString>& references)
+{
+  QStringList list;
+  for(auto it = references.constBegin(); it != references.constEnd(); ++it)
+    list.append(it.key() + "=" + it.value());
+  list.sort();
+  return list.join(",");
+}
+
+QHash<QString, QString> referencesFromString(const QString& str)
+{
+  QHash<QString, QString> references;
+  for(const QString& ref : str.split(",", QString::SkipEmptyParts))
+    references.insert(ref.section('=', 0, 0), ref.section('=', 1, 1));
+  return references;
+}
+
+QString metaValue(SqlDatabase *patchDb, const QString& key)
+{
+  SqlQuery query(patchDb);
+  query.prepare("select value from diff_meta where key = :key");
+  query.bindValue(":key", key);
+  query.exec();
+  return query.next() ? query.valueStr(0) : QString();
+}
+
+} // namespace
+
+DatabaseDiff::DatabaseDiff()
+{
+  // Keep ids of the most referenced tables to avoid changes in all airport features or navaids
+  setKeyColumns("airport", {"ident"});
+  setKeyColumns("bgl_file", {"filename"});
+
+  // Copies of airport rows sharing the same id
+  addReference("airport_medium", "airport_id", "airport");
+  addReference("airport_large", "airport_id", "airport");
+
+  // Only used while loading
+  addExcludedTable("tmp_waypoint");
+  addExcludedTable("tmp_airway_point");
+  addExcludedTable("airway_temp");
+}
+
+DatabaseDiff::~DatabaseDiff()
+{
+
+}
+
+void DatabaseDiff::setKeyColumns(const QString& table, const QStringList& columns)
+{
+  keyColumns.insert(table, columns);
+}
+
+void DatabaseDiff::addReference(const QString& table, const QString& column, const QString& refTable)
+{
+  extraReferences[table].insert(column, refTable);
+}
+
+void DatabaseDiff::addExcludedTable(const QString& table)
+{
+  excludedTables.insert(table);
+}
+
+QVector<DatabaseDiff::TableInfo> DatabaseDiff::readTableInfos(SqlDatabase *db) const
+{
+  // Virtual tables and their shadow tables like "airport_rtree_node" are not copied
+  QStringList virtualTables;
+  SqlQuery virtualQuery("select name from sqlite_master where type = 'table' and sql like 'create virtual%'", db);
+  virtualQuery.exec();
+  while(virtualQuery.next())
+    virtualTables.append(virtualQuery.valueStr(0));
+
+  QHash<QString, TableInfo> infos;
+  for(const QString& name : db->tables())
+  {
+    if(name.startsWith("sqlite_") || excludedTables.contains(name))
+      continue;
+
+    bool isVirtual = false;
+    for(const QString& virtualTable : virtualTables)
+    {
+      if(name == virtualTable || name.startsWith(virtualTable + "_"))
+        isVirtual = true;
+    }
+    if(isVirtual)
+      continue;
+
+    TableInfo info;
+    info.name = name;
+    info.keyColumns = keyColumns.value(name);
+    info.references = extraReferences.value(name);
+
+    SqlQuery columnQuery("pragma table_info(" + name + ")", db);
+    columnQuery.exec();
+    QStringList pkColumns;
+    while(columnQuery.next())
+    {
+      QString column = columnQuery.valueStr("name");
+      info.columns.append(column);
+      if(columnQuery.valueInt("pk") > 0 && columnQuery.valueStr("type").compare("integer", Qt::CaseInsensitive) == 0)
+        pkColumns.append(column);
+    }
+
+    SqlQuery fkQuery("pragma foreign_key_list(" + name + ")", db);
+    fkQuery.exec();
+    while(fkQuery.next())
+    {
+      QString refTable = fkQuery.valueStr("table");
+      if(refTable == name)
+        qWarning() << Q_FUNC_INFO << "Ignoring self reference in" << name << fkQuery.valueStr("from");
+      else if(!excludedTables.contains(refTable))
+        info.references.insert(fkQuery.valueStr("from"), refTable);
+    }
+
+    // Use a single integer primary key as id unless it refers to another table
+    if(pkColumns.size() == 1 && !info.references.contains(pkColumns.first()))
+    {
+      info.idColumn = pkColumns.first();
+      info.columns.removeAll(info.idColumn);
+    }
+
+    infos.insert(name, info);
+  }
+
+  // Sort topologically so that referenced tables are read before the referencing ones
+  QVector<TableInfo> sorted;
+  QSet<QString> done;
+  QStringList names = infos.keys();
+  names.sort();
+  while(sorted.size() < infos.size())
+  {
+    bool found = false;
+    for(const QString& name : names)
+    {
+      if(done.contains(name))
+        continue;
+
+      bool ready = true;
+      for(const QString& refTable : infos.value(name).references)
+      {
+        if(infos.contains(refTable) && !done.contains(refTable))
+          ready = false;
+      }
+
+      if(ready)
+      {
+        sorted.append(infos.value(name));
+        done.insert(name);
+        found = true;
+      }
+    }
+
+    if(!found)
+      throw atools::Exception("Circular references between tables found");
+  }
+  return sorted;
+}
+
+void DatabaseDiff::readTable(SqlDatabase *db, const TableInfo& table, QHash<QString, IdKeyMap>& idKeys,
+                             const RowFuncType& func)
+{
+  QString idColumn = table.idColumn.isEmpty() ? ROWID : table.idColumn;
+
+  QVector<int> keyIndexes;
+  for(const QString& column : table.keyColumns)
+  {
+    int index = table.columns.indexOf(column);
+    if(index == -1)
+      throw atools::Exception(QString("Key column \"%1\" not found in table \"%2\"").arg(column).arg(table.name));
+    keyIndexes.append(index);
+  }
+
+  // Referenced tables for each column or null
+  QVector<const IdKeyMap *> refKeys;
+  for(const QString& column : table.columns)
+  {
+    QString refTable = table.references.value(column);
+    refKeys.append(refTable.isEmpty() ? nullptr : &idKeys[refTable]);
+  }
+
+  IdKeyMap& keys = idKeys[table.name];
+  QSet<QByteArray> usedKeys;
+
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.exec("select " + idColumn + ", " + table.columns.join(", ") + " from " + table.name +
+             " order by " + idColumn);
+
+  QVariantList values, keyValues;
+  while(query.next())
+  {
+    qint64 id = query.value(0).toLongLong();
+
+    // Replace references with the key of the referenced row
+    values.clear();
+    for(int i = 0; i < table.columns.size(); i++)
+    {
+      QVariant value = query.value(i + 1);
+      if(refKeys.at(i) != nullptr && !value.isNull())
+        value = refKeys.at(i)->value(value.toLongLong());
+      values.append(value);
+    }
+
+    QByteArray content = serialize(values), contentHash = hash(content), key;
+    if(keyIndexes.isEmpty())
+      key = contentHash;
+    else
+    {
+      keyValues.clear();
+      for(int index : keyIndexes)
+        keyValues.append(values.at(index));
+      key = hash(serialize(keyValues));
+    }
+
+    // Number duplicates in id order
+    QByteArray baseKey = key;
+    for(int num = 1; usedKeys.contains(key); num++)
+      key = hash(baseKey + QByteArray::number(num));
+    usedKeys.insert(key);
+
+    keys.insert(id, key);
+    func(key, contentHash, content, id);
+  }
+}
+
+void DatabaseDiff::createPatchSchema(SqlDatabase *patchDb)
+{
+  patchDb->exec("create table diff_meta (key varchar(50) not null, value varchar(250))");
+  patchDb->exec("create table diff_table (table_name varchar(100) primary key, seq integer not null, "
+                "id_column varchar(100), columns text not null, key_columns text, refs text)");
+  patchDb->exec("create table diff_delete (table_name varchar(100) not null, row_key blob not null)");
+  patchDb->exec("create table diff_row (table_name varchar(100) not null, row_key blob not null, "
+                "row_data blob not null)");
+}
+
+void DatabaseDiff::createPatch(SqlDatabase *oldDb, SqlDatabase *newDb, SqlDatabase *patchDb)
+{
+  numDeleted = numUpserted = numUnchanged = 0;
+
+  DatabaseMeta oldMeta(oldDb), newMeta(newDb);
+  if(oldMeta.getMajorVersion() != newMeta.getMajorVersion() || oldMeta.getMinorVersion() != newMeta.getMinorVersion())
+    throw atools::Exception(QString("Database versions differ: %1.%2 and %3.%4").
+                            arg(oldMeta.getMajorVersion()).arg(oldMeta.getMinorVersion()).
+                            arg(newMeta.getMajorVersion()).arg(newMeta.getMinorVersion()));
+
+  QVector<TableInfo> tables = readTableInfos(newDb);
+  QVector<TableInfo> oldTables = readTableInfos(oldDb);
+  if(tables.size() != oldTables.size())
+    throw atools::Exception("Database schemas differ");
+
+  atools::sql::SqlTransaction transaction(patchDb);
+  createPatchSchema(patchDb);
+
+  SqlQuery metaQuery(patchDb);
+  metaQuery.prepare("insert into diff_meta (key, value) values(:key, :value)");
+  for(const std::pair<QString, QString>& meta : {
+        std::make_pair(QString("major_version"), QString::number(newMeta.getMajorVersion())),
+        std::make_pair(QString("minor_version"), QString::number(newMeta.getMinorVersion())),
+        std::make_pair(QString("from_airac_cycle"), oldMeta.getAiracCycle()),
+        std::make_pair(QString("to_airac_cycle"), newMeta.getAiracCycle())})
+  {
+    metaQuery.bindValue(":key", meta.first);
+    metaQuery.bindValue(":value", meta.second);
+    metaQuery.exec();
+  }
+
+  SqlQuery tableQuery(patchDb);
+  tableQuery.prepare("insert into diff_table (table_name, seq, id_column, columns, key_columns, refs) "
+                     "values(:table, :seq, :id, :columns, :keys, :refs)");
+  SqlQuery rowQuery(patchDb);
+  rowQuery.prepare("insert into diff_row (table_name, row_key, row_data) values(:table, :key, :data)");
+  SqlQuery deleteQuery(patchDb);
+  deleteQuery.prepare("insert into diff_delete (table_name, row_key) values(:table, :key)");
+
+  QHash<QString, IdKeyMap> oldIdKeys, newIdKeys;
+  for(int seq = 0; seq < tables.size(); seq++)
+  {
+    const TableInfo& table = tables.at(seq);
+
+    const TableInfo& oldTable = oldTables.at(seq);
+    if(oldTable.name != table.name || oldTable.columns != table.columns || oldTable.idColumn != table.idColumn)
+      throw atools::Exception(QString("Database schemas differ in table \"%1\"").arg(table.name));
+
+    tableQuery.bindValue(":table", table.name);
+    tableQuery.bindValue(":seq", seq);
+    tableQuery.bindValue(":id", table.idColumn);
+    tableQuery.bindValue(":columns", table.columns.join(","));
+    tableQuery.bindValue(":keys", table.keyColumns.join(","));
+    tableQuery.bindValue(":refs", referencesToString(table.references));
+    tableQuery.exec();
+
+    // Key to content hash of all old rows
+    QHash<QByteArray, QByteArray> oldRows;
+    readTable(oldDb, oldTable, oldIdKeys, [&oldRows](const QByteArray& key, const QByteArray& contentHash,
+                                                     const QByteArray&, qint64) {
+      oldRows.insert(key, contentHash);
+    });
+
+    int upserted = 0;
+    readTable(newDb, table, newIdKeys, [&](const QByteArray& key, const QByteArray& contentHash,
+                                           const QByteArray& content, qint64) {
+      auto it = oldRows.find(key);
+      if(it == oldRows.end() || it.value() != contentHash)
+      {
+        rowQuery.bindValue(":table", table.name);
+        rowQuery.bindValue(":key", key);
+        rowQuery.bindValue(":data", content);
+        rowQuery.exec();
+        upserted++;
+      }
+      else
+        numUnchanged++;
+
+      if(it != oldRows.end())
+        oldRows.erase(it);
+    });
+
+    // Remaining old rows are not in the new database
+    for(auto it = oldRows.constBegin(); it != oldRows.constEnd(); ++it)
+    {
+      deleteQuery.bindValue(":table", table.name);
+      deleteQuery.bindValue(":key", it.key());
+      deleteQuery.exec();
+    }
+
+    qInfo() << Q_FUNC_INFO << table.name << "upserted" << upserted << "deleted" << oldRows.size();
+    numUpserted += upserted;
+    numDeleted += oldRows.size();
+  }
+  transaction.commit();
+
+  qInfo() << Q_FUNC_INFO << "Patch from" << oldMeta.getAiracCycle() << "to" << newMeta.getAiracCycle()
+          << "upserted" << numUpserted << "deleted" << numDeleted << "unchanged" << numUnchanged;
+}
+
+void DatabaseDiff::applyPatch(SqlDatabase *db, SqlDatabase *patchDb)
+{
+  numDeleted = numUpserted = numUnchanged = 0;
+
+  DatabaseMeta meta(db);
+  QString major = metaValue(patchDb, "major_version"), minor = metaValue(patchDb, "minor_version"),
+          fromCycle = metaValue(patchDb, "from_airac_cycle"), toCycle = metaValue(patchDb, "to_airac_cycle");
+
+  if(major != QString::number(meta.getMajorVersion()) || minor != QString::number(meta.getMinorVersion()))
+    throw atools::Exception(QString("Patch version %1.%2 does not match database version %3.%4").
+                            arg(major).arg(minor).arg(meta.getMajorVersion()).arg(meta.getMinorVersion()));
+
+  if(fromCycle != meta.getAiracCycle())
+    throw atools::Exception(QString("Patch for AIRAC cycle %1 does not match database cycle %2").
+                            arg(fromCycle).arg(meta.getAiracCycle()));
+
+  // Read table structure as used when creating the patch
+  QVector<TableInfo> tables;
+  SqlQuery tableQuery("select table_name, id_column, columns, key_columns, refs from diff_table order by seq",
+                      patchDb);
+  tableQuery.exec();
+  SqlUtil util(db);
+  while(tableQuery.next())
+  {
+    TableInfo table;
+    table.name = tableQuery.valueStr("table_name");
+    table.idColumn = tableQuery.valueStr("id_column");
+    table.columns = tableQuery.valueStr("columns").split(",", QString::SkipEmptyParts);
+    table.keyColumns = tableQuery.valueStr("key_columns").split(",", QString::SkipEmptyParts);
+    table.references = referencesFromString(tableQuery.valueStr("refs"));
+
+    if(!util.hasTable(table.name))
+      throw atools::Exception(QString("Table \"%1\" not found in database").arg(table.name));
+    tables.append(table);
+  }
+
+  // Calculate keys of all existing rows
+  QHash<QString, IdKeyMap> idKeys;
+  QHash<QString, QHash<QByteArray, qint64> > keyIds;
+  for(const TableInfo& table : tables)
+  {
+    QHash<QByteArray, qint64>& ids = keyIds[table.name];
+    readTable(db, table, idKeys, [&ids](const QByteArray& key, const QByteArray&, const QByteArray&, qint64 id) {
+      ids.insert(key, id);
+    });
+  }
+  idKeys.clear();
+
+  atools::sql::SqlTransaction transaction(db);
+
+  // Delete referencing rows first
+  SqlQuery keyQuery(patchDb);
+  keyQuery.prepare("select row_key from diff_delete where table_name = :table");
+  for(int i = tables.size() - 1; i >= 0; i--)
+  {
+    const TableInfo& table = tables.at(i);
+    QHash<QByteArray, qint64>& ids = keyIds[table.name];
+
+    SqlQuery deleteQuery(db);
+    deleteQuery.prepare("delete from " + table.name + " where " +
+                        (table.idColumn.isEmpty() ? ROWID : table.idColumn) + " = ?");
+
+    keyQuery.bindValue(":table", table.name);
+    keyQuery.exec();
+    while(keyQuery.next())
+    {
+      qint64 id = ids.take(keyQuery.value(0).toByteArray());
+      if(id > 0)
+      {
+        deleteQuery.bindValue(0, id);
+        deleteQuery.exec();
+        numDeleted++;
+      }
+      else
+        qWarning() << Q_FUNC_INFO << "Row to delete not found in" << table.name;
+    }
+  }
+
+  // Insert or update referenced rows first
+  SqlQuery rowQuery(patchDb);
+  rowQuery.prepare("select row_key, row_data from diff_row where table_name = :table");
+  for(const TableInfo& table : tables)
+  {
+    QHash<QByteArray, qint64>& ids = keyIds[table.name];
+    QString idColumn = table.idColumn.isEmpty() ? ROWID : table.idColumn;
+
+    QStringList assignments, binds;
+    for(const QString& column : table.columns)
+    {
+      assignments.append(column + " = ?");
+      binds.append("?");
+    }
+
+    SqlQuery updateQuery(db);
+    updateQuery.prepare("update " + table.name + " set " + assignments.join(", ") + " where " + idColumn + " = ?");
+
+    SqlQuery insertQuery(db);
+    if(table.idColumn.isEmpty())
+      insertQuery.prepare("insert into " + table.name + " (" + table.columns.join(", ") + ") values(" +
+                          binds.join(", ") + ")");
+    else
+      insertQuery.prepare("insert into " + table.name + " (" + table.idColumn + ", " + table.columns.join(", ") +
+                          ") values(?, " + binds.join(", ") + ")");
+
+    qint64 nextId = 1;
+    if(!table.idColumn.isEmpty())
+    {
+      SqlQuery maxQuery("select max(" + table.idColumn + ") from " + table.name, db);
+      maxQuery.exec();
+      if(maxQuery.next())
+        nextId = maxQuery.value(0).toLongLong() + 1;
+    }
+
+    rowQuery.bindValue(":table", table.name);
+    rowQuery.exec();
+    while(rowQuery.next())
+    {
+      QByteArray key = rowQuery.value(0).toByteArray();
+      QVariantList values = deserialize(rowQuery.value(1).toByteArray(), table.columns.size());
+
+      // Replace keys of referenced rows with their ids in this database
+      for(int i = 0; i < table.columns.size(); i++)
+      {
+        QString refTable = table.references.value(table.columns.at(i));
+        if(!refTable.isEmpty() && !values.at(i).isNull())
+        {
+          qint64 refId = keyIds.value(refTable).value(values.at(i).toByteArray(), -1);
+          if(refId == -1)
+          {
+            qWarning() << Q_FUNC_INFO << "Referenced row not found for" << table.name << table.columns.at(i);
+            values[i] = QVariant(QVariant::LongLong);
+          }
+          else
+            values[i] = refId;
+        }
+      }
+
+      qint64 id = ids.value(key, -1);
+      if(id != -1)
+      {
+        for(int i = 0; i < values.size(); i++)
+          updateQuery.bindValue(i, values.at(i));
+        updateQuery.bindValue(values.size(), id);
+        updateQuery.exec();
+      }
+      else
+      {
+        int pos = 0;
+        if(!table.idColumn.isEmpty())
+        {
+          id = nextId++;
+          insertQuery.bindValue(pos++, id);
+        }
+        for(const QVariant& value : values)
+          insertQuery.bindValue(pos++, value);
+        insertQuery.exec();
+
+        if(table.idColumn.isEmpty())
+          // Not referenced since references need a primary key
+          id = 0;
+        ids.insert(key, id);
+      }
+      numUpserted++;
+    }
+  }
+
+  transaction.commit();
+
+  qInfo() << Q_FUNC_INFO << "Applied patch from" << fromCycle << "to" << toCycle
+          << "upserted" << numUpserted << "deleted" << numDeleted;
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,140 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_DB_DATABASEDIFF_H
+#define ATOOLS_FS_DB_DATABASEDIFF_H
+
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+namespace fs {
+namespace db {
+
+/*
+ * Computes row level differences between two compiled navdatabases and applies them to produce the new database
+ * from the old one. Allows to distribute small per cycle patches instead of full databases.
+ *
+ * Rows are identified by stable keys instead of autoincrement ids. The key of a row is a hash of its content or
+ * of the configured key columns like "ident" for airports. Foreign key columns are replaced by the key of the
+ * referenced row. Therefore rows are equal in both databases if their content and the content of all referenced
+ * rows is equal, independent of the assigned ids.
+ * Tables with key columns get updates on content changes. All other tables receive a delete and an insert.
+ *
+ * References are read from the declared foreign keys. Undeclared references can be added with addReference().
+ * Columns referencing different tables depending on a type like "waypoint.nav_id" are copied as they are.
+ *
+ * The patch is written into an empty SQLite database. Virtual tables like R*Tree or FTS5 indexes are not
+ * included and have to be rebuilt after applying.
+ */
+class DatabaseDiff
+{
+public:
+  /* Creates a diff with default keys for airport and BGL files and excludes temporary tables */
+  DatabaseDiff();
+  ~DatabaseDiff();
+
+  DatabaseDiff(const DatabaseDiff& other) = delete;
+  DatabaseDiff& operator=(const DatabaseDiff& other) = delete;
+
+  /* Use columns as key for table instead of the row content */
+  void setKeyColumns(const QString& table, const QStringList& columns);
+
+  /* Add a reference from column in table to the primary key of refTable which is not declared as foreign key */
+  void addReference(const QString& table, const QString& column, const QString& refTable);
+
+  /* Do not compare and patch table */
+  void addExcludedTable(const QString& table);
+
+  /*
+   * Compute the difference between oldDb and newDb and write it into the empty patchDb.
+   * Throws an exception if schema versions of both databases differ.
+   */
+  void createPatch(atools::sql::SqlDatabase *oldDb, atools::sql::SqlDatabase *newDb,
+                   atools::sql::SqlDatabase *patchDb);
+
+  /*
+   * Apply patchDb to db which has to contain the same data as oldDb given to createPatch().
+   * Unchanged and updated rows keep their ids. Inserted rows get new ids.
+   * Throws an exception if schema version or AIRAC cycle of db do not match the patch.
+   * All changes are committed at once after applying.
+   */
+  void applyPatch(atools::sql::SqlDatabase *db, atools::sql::SqlDatabase *patchDb);
+
+  /* Statistics for the last call of createPatch() or applyPatch() */
+  int getNumDeleted() const
+  {
+    return numDeleted;
+  }
+
+  int getNumUpserted() const
+  {
+    return numUpserted;
+  }
+
+  /* Only filled by createPatch() */
+  int getNumUnchanged() const
+  {
+    return numUnchanged;
+  }
+
+private:
+  struct TableInfo
+  {
+    QString name,
+            idColumn; /* Integer primary key or empty if rowid is used */
+    QStringList columns, /* All columns except idColumn */
+                keyColumns; /* Empty if row is identified by content */
+    QHash<QString, QString> references; /* Column name to referenced table */
+  };
+
+  /* Map of row id to row key for one table */
+  typedef QHash<qint64, QByteArray> IdKeyMap;
+
+  /* Called for each row with key, hash of content, serialized content and row id */
+  typedef std::function<void (const QByteArray& key, const QByteArray& hash, const QByteArray& content,
+                              qint64 id)> RowFuncType;
+
+  /* Read structure of all tables from database and sort them so that referenced tables come first */
+  QVector<TableInfo> readTableInfos(atools::sql::SqlDatabase *db) const;
+
+  /* Read all rows of a table, calculate keys and call func. Adds row keys to idKeys. */
+  static void readTable(atools::sql::SqlDatabase *db, const TableInfo& table, QHash<QString, IdKeyMap>& idKeys,
+                        const RowFuncType& func);
+
+  static void createPatchSchema(atools::sql::SqlDatabase *patchDb);
+
+  QHash<QString, QStringList> keyColumns;
+  QHash<QString, QHash<QString, QString> > extraReferences;
+  QSet<QString> excludedTables;
+
+  int numDeleted = 0, numUpserted = 0, numUnchanged = 0;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_DATABASEDIFF_H
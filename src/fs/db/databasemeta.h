@@ -143,9 +143,10 @@ public:
    * 19 Complete MSFS support. New waypoint types and new ramp and gate extra types.
    *    Removed fence and apron light tables. Delete edge and center line light columns from taxipath.
    *    New table translation for MSFS language files.
+   * 20 New table scenery_area_state for change detection.
    *
    */
-  static const int DB_VERSION_MINOR = 19;
+  static const int DB_VERSION_MINOR = 20;
 
   void init();
 
@@ -17,12 +17,14 @@
 
 #include "fs/db/datawriter.h"
 
+#include "fs/db/bglfilecache.h"
 #include "fs/bgl/bglfile.h"
 #include "fs/scenery/fileresolver.h"
 #include "fs/scenery/languagejson.h"
 #include "fs/scenery/materiallib.h"
 #include "fs/navdatabaseoptions.h"
 #include "sql/sqldatabase.h"
+#include "util/stringinterner.h"
 #include "fs/db/nav/waypointwriter.h"
 #include "fs/db/nav/airwaysegmentwriter.h"
 #include "fs/db/nav/vorwriter.h"
@@ -37,6 +39,7 @@
 #include "fs/db/ap/rw/runwayendwriter.h"
 #include "fs/db/runwayindex.h"
 #include "fs/db/dbairportindex.h"
+#include "fs/db/dbsessionindex.h"
 #include "fs/db/ap/approachwriter.h"
 #include "fs/db/ap/approachlegwriter.h"
 #include "fs/db/ap/transitionlegwriter.h"
@@ -48,6 +51,7 @@
 #include "fs/db/ap/apronwriter.h"
 #include "fs/db/ap/taxipathwriter.h"
 #include "fs/db/nav/boundarywriter.h"
+#include "fs/db/nav/boundarytilewriter.h"
 #include "fs/progresshandler.h"
 #include "fs/scenery/fileresolver.h"
 #include "fs/db/meta/sceneryareawriter.h"
@@ -58,6 +62,12 @@
 
 #include <QDebug>
 #include <QFileInfo>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <exception>
 
 namespace atools {
 namespace fs {
@@ -76,9 +86,74 @@ static const QSet<atools::fs::bgl::section::SectionType> SUPPORTED_SECTION_TYPES
   bgl::section::TACAN
 };
 
+namespace {
+
+/* Reads one BGL file in a thread pool. Exceptions are caught and passed to the writer thread.
+ * Uses a copy of the options since the contained QRegExp filters are not thread safe.
+ * The interner is installed for the pool thread only while reading. */
+class BglReadTask :
+  public QRunnable
+{
+public:
+  BglReadTask(const NavDatabaseOptions& opts, const QString& filepathParam, const SceneryArea& areaParam,
+              atools::util::StringInterner *internerParam)
+    : options(opts), bglFile(&options), filepath(filepathParam), area(areaParam), interner(internerParam)
+  {
+    setAutoDelete(false);
+    bglFile.setSupportedSectionTypes(SUPPORTED_SECTION_TYPES);
+  }
+
+  virtual void run() override
+  {
+    try
+    {
+      atools::util::StringInternerScope internerScope(interner);
+
+      // Read all records into a internal object tree (atools::fs::bgl namespace)
+      bglFile.readFile(filepath, area);
+    }
+    catch(...)
+    {
+      exception = std::current_exception();
+    }
+    done.release();
+  }
+
+  /* Blocks until run() is finished */
+  void waitForDone()
+  {
+    done.acquire();
+  }
+
+  BglFile& getBglFile()
+  {
+    return bglFile;
+  }
+
+  /* Exception thrown while reading or null */
+  const std::exception_ptr& getException() const
+  {
+    return exception;
+  }
+
+private:
+  NavDatabaseOptions options;
+  BglFile bglFile;
+  QString filepath;
+  const SceneryArea& area;
+  atools::util::StringInterner *interner;
+  std::exception_ptr exception;
+  QSemaphore done;
+};
+
+} // namespace
+
 DataWriter::DataWriter(SqlDatabase& sqlDb, const NavDatabaseOptions& opts, atools::fs::ProgressHandler *progress)
   : db(sqlDb), progressHandler(progress), options(opts)
 {
+  // Needed by the airport writer and its delete processor
+  sessionIndex = new DbSessionIndex();
+
   bglFileWriter = new BglFileWriter(db, *this);
   sceneryAreaWriter = new SceneryAreaWriter(db, *this);
   airportWriter = new AirportWriter(db, *this);
@@ -104,11 +179,19 @@ DataWriter::DataWriter(SqlDatabase& sqlDb, const NavDatabaseOptions& opts, atool
   ilsWriter = new IlsWriter(db, *this);
 
   boundaryWriter = new BoundaryWriter(db, *this);
+  boundaryTileWriter = new BoundaryTileWriter(db, *this);
 
   runwayIndex = new RunwayIndex();
   airportIndex = new DbAirportIndex();
 
+  // Writers for the most frequent airport features insert multiple rows at once
+  for(WriterBaseBasic *writer : batchWriters())
+    writer->setBatchSize(options.getWriterBatchSize());
+
   magDecReader = new MagDecReader();
+
+  if(!options.getBglFileCache().isEmpty())
+    bglFileCache = new BglFileCache(options.getBglFileCache(), options.getOptionsHash());
 }
 
 DataWriter::~DataWriter()
@@ -166,12 +249,23 @@ void DataWriter::close()
   ilsWriter = nullptr;
   delete boundaryWriter;
   boundaryWriter = nullptr;
+  delete boundaryTileWriter;
+  boundaryTileWriter = nullptr;
   delete runwayIndex;
   runwayIndex = nullptr;
   delete airportIndex;
   airportIndex = nullptr;
+  delete sessionIndex;
+  sessionIndex = nullptr;
   delete magDecReader;
   magDecReader = nullptr;
+
+  if(bglFileCache != nullptr)
+  {
+    bglFileCache->save();
+    delete bglFileCache;
+    bglFileCache = nullptr;
+  }
 }
 
 float DataWriter::getMagVar(const geo::Pos& pos, float defaultValue) const
@@ -210,125 +304,83 @@ QString DataWriter::getLanguage(const QString& key)
     return key;
 }
 
-void DataWriter::writeSceneryArea(const SceneryArea& area)
+void DataWriter::writeSceneryArea(const SceneryArea& area, const scenery::SceneryAreaFiles *files)
 {
-  QStringList filepaths, filenames;
+  // Progress is weighted by file size only if the caller counted the steps from the file manifest
+  bool weightedProgress = files != nullptr;
 
-  // Get all BGL files in this scenery area
-  atools::fs::scenery::FileResolver resolver(options);
-  resolver.getFiles(area, &filepaths, &filenames);
+  scenery::SceneryAreaFiles resolvedFiles;
+  if(files == nullptr)
+  {
+    // Get all BGL files in this scenery area
+    atools::fs::scenery::FileResolver resolver(options);
+    resolver.setDirectoryCache(directoryCache);
+    resolver.getFiles(area, resolvedFiles);
+    files = &resolvedFiles;
+  }
+
+  const QStringList& filepaths = files->filepaths;
 
   if(sceneryErrors != nullptr)
-    sceneryErrors->sceneryErrorsMessages.append(resolver.getErrorMessages());
-  progressHandler->reportErrors(resolver.getErrorMessages().size());
+    sceneryErrors->sceneryErrorsMessages.append(files->errorMessages);
+  progressHandler->reportErrors(files->errorMessages.size());
 
   if(!filepaths.empty())
   {
     // Write the scenery area metadata
     sceneryAreaWriter->writeOne(area);
 
-    BglFile bglFile(&options);
+    // Files are parsed concurrently in the pool while this thread writes the results in file order
+    // which keeps the layering intact. Number of parsed files waiting for the writer is limited
+    // to keep memory usage low.
+    int numThreads = std::max(1, QThread::idealThreadCount());
+    int maxQueued = numThreads * 2;
 
-    bglFile.setSupportedSectionTypes(SUPPORTED_SECTION_TYPES);
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+
+    QVector<BglReadTask *> tasks(filepaths.size(), nullptr);
+    int nextTask = 0;
 
     for(int i = 0; i < filepaths.size(); i++)
     {
-      progressHandler->setNumFiles(numFiles);
-      progressHandler->setNumAirports(airportIdents.size());
-      progressHandler->setNumNamelists(numNamelists);
-      progressHandler->setNumVors(numVors);
-      progressHandler->setNumIls(numIls);
-      progressHandler->setNumNdbs(numNdbs);
-      progressHandler->setNumMarker(numMarker);
-      progressHandler->setNumBoundaries(numBoundaries);
-      progressHandler->setNumWaypoints(numWaypoints);
-      progressHandler->setNumObjectsWritten(numObjectsWritten);
-
-      if((aborted = progressHandler->reportBglFile(filepaths.at(i))) == true)
-        return;
-
-      QString currentBglFilePath = filepaths.at(i);
+      // Fill queue
+      for(; nextTask < filepaths.size() && nextTask < i + maxQueued; nextTask++)
+      {
+        // Do not parse unchanged files which had no content before - task stays null
+        if(bglFileCache != nullptr && bglFileCache->isEmptyFile(QFileInfo(filepaths.at(nextTask))))
+          continue;
+
+        tasks[nextTask] = new BglReadTask(options, filepaths.at(nextTask), area, stringInterner);
+        pool.start(tasks.at(nextTask));
+      }
+
+      updateProgressCounts();
+
+      int increment = weightedProgress ? files->progressSteps.at(i) : 1;
+      if((aborted = progressHandler->reportBglFile(filepaths.at(i), increment)) == true)
+        break;
+
+      // Wait until this file is parsed
+      BglReadTask *task = tasks.at(i);
+      if(task == nullptr)
+        // Skipped by cache
+        continue;
+
+      task->waitForDone();
 
+      const QString& currentBglFilePath = filepaths.at(i);
       try
       {
-        // ================================================================================
-        // Read all records into a internal object tree (atools::fs::bgl namespace)
-        bglFile.readFile(currentBglFilePath, area);
-
-        if(bglFile.hasContent() && bglFile.isValid())
-        {
-          // ================================================================================
-          // Write to the database
-
-          // if(!bglFile.getHeader().hasValidMagicNumber())
-          // qWarning() << "Content in file with invalid magic number";
-
-          // Write BGL file metadata
-          bglFileWriter->writeOne(bglFile);
-
-          // Clear the indexes
-          runwayIndex->clear();
-          airportIndex->clear();
-
-          // Execution order is important due to dependencies between the writers
-          // (i.e. ILS writer looks for runway end ids)
-          // Writer also need to access the ids of their parent record objects
-          // (i.e. runway needs the current airport ID
-
-          airportWriter->setNameLists(bglFile.getNamelists());
-
-          // Write airport and all subrecords like runways, approaches, parking and so on
-          airportWriter->write(bglFile.getAirports());
-
-          airportFileWriter->write(bglFile.getAirports());
-
-          if(!area.isNavdataThirdPartyUpdate())
-          {
-            // Write all navaids to the database
-            waypointWriter->write(bglFile.getWaypoints());
-            vorWriter->write(bglFile.getVors());
-            tacanWriter->write(bglFile.getTacans());
-            ndbWriter->write(bglFile.getNdbs());
-            markerWriter->write(bglFile.getMarker());
-          }
-          ilsWriter->write(bglFile.getIls());
-
-          if(!area.isNavdataThirdPartyUpdate())
-            boundaryWriter->write(bglFile.getBoundaries());
-
-          for(const atools::fs::bgl::Airport *ap : bglFile.getAirports())
-            airportIdents.insert(ap->getIdent());
-
-          numNamelists += bglFile.getNamelists().size();
-
-          if(!area.isNavdataThirdPartyUpdate())
-          {
-            numVors += bglFile.getVors().size() + bglFile.getTacans().size();
-            numNdbs += bglFile.getNdbs().size();
-            numMarker += bglFile.getMarker().size();
-            numWaypoints += bglFile.getWaypoints().size();
-            numBoundaries += bglFile.getBoundaries().size();
-          }
-          numIls += bglFile.getIls().size();
-          numFiles++;
-        }
-
-        // Print a one line short report on airports that were found in the BGL
-        if(!bglFile.getAirports().isEmpty())
-        {
-          QStringList apIcaos;
-          for(const atools::fs::bgl::Airport *ap : bglFile.getAirports())
-          {
-            // Truncate at 10
-            if(apIcaos.size() < 10)
-              apIcaos.append(ap->getIdent());
-            else
-              break;
-          }
-          if(bglFile.getAirports().size() > 10)
-            apIcaos.append("...");
-          qDebug() << "Found" << bglFile.getAirports().size() << "airports. idents:" << apIcaos.join(",");
-        }
+        if(task->getException())
+          // Pass exception from parser thread
+          std::rethrow_exception(task->getException());
+
+        progressHandler->incBytesRead(task->getBglFile().getFilesize());
+        writeBglFile(task->getBglFile(), area);
+
+        if(bglFileCache != nullptr && !(task->getBglFile().hasContent() && task->getBglFile().isValid()))
+          bglFileCache->addEmptyFile(QFileInfo(currentBglFilePath));
       }
       catch(atools::Exception& e)
       {
@@ -344,8 +396,129 @@ void DataWriter::writeSceneryArea(const SceneryArea& area)
         if(sceneryErrors != nullptr)
           sceneryErrors->fileErrors.append({currentBglFilePath, QString(), 0});
       }
+
+      delete task;
+      tasks[i] = nullptr;
     }
-    db.commit();
+
+    // Remove tasks not started yet in case of abort and wait for running ones before deleting
+    pool.clear();
+    pool.waitForDone();
+    qDeleteAll(tasks);
+
+    if(!aborted)
+    {
+      // Replaced airports are collected for the whole scenery area
+      airportWriter->flushDeletes();
+      db.commit();
+    }
+  }
+}
+
+QVector<WriterBaseBasic *> DataWriter::batchWriters() const
+{
+  return {approachLegWriter, approachTransLegWriter, parkingWriter, airportComWriter, airportStartWriter,
+          airportHelipadWriter, airportTaxiPathWriter, boundaryTileWriter};
+}
+
+void DataWriter::flushBatches()
+{
+  for(WriterBaseBasic *writer : batchWriters())
+    writer->flush();
+}
+
+void DataWriter::updateProgressCounts()
+{
+  progressHandler->setNumFiles(numFiles);
+  progressHandler->setNumAirports(airportIdents.size());
+  progressHandler->setNumNamelists(numNamelists);
+  progressHandler->setNumVors(numVors);
+  progressHandler->setNumIls(numIls);
+  progressHandler->setNumNdbs(numNdbs);
+  progressHandler->setNumMarker(numMarker);
+  progressHandler->setNumBoundaries(numBoundaries);
+  progressHandler->setNumWaypoints(numWaypoints);
+  progressHandler->setNumObjectsWritten(numObjectsWritten);
+}
+
+void DataWriter::writeBglFile(BglFile& bglFile, const SceneryArea& area)
+{
+  if(bglFile.hasContent() && bglFile.isValid())
+  {
+    // ================================================================================
+    // Write to the database
+
+    // if(!bglFile.getHeader().hasValidMagicNumber())
+    // qWarning() << "Content in file with invalid magic number";
+
+    // Write BGL file metadata
+    bglFileWriter->writeOne(bglFile);
+
+    // Clear the indexes
+    runwayIndex->clear();
+    airportIndex->clear();
+
+    // Execution order is important due to dependencies between the writers
+    // (i.e. ILS writer looks for runway end ids)
+    // Writer also need to access the ids of their parent record objects
+    // (i.e. runway needs the current airport ID
+
+    airportWriter->setNameLists(bglFile.getNamelists());
+
+    // Write airport and all subrecords like runways, approaches, parking and so on
+    airportWriter->write(bglFile.getAirports());
+
+    airportFileWriter->write(bglFile.getAirports());
+
+    if(!area.isNavdataThirdPartyUpdate())
+    {
+      // Write all navaids to the database
+      waypointWriter->write(bglFile.getWaypoints());
+      vorWriter->write(bglFile.getVors());
+      tacanWriter->write(bglFile.getTacans());
+      ndbWriter->write(bglFile.getNdbs());
+      markerWriter->write(bglFile.getMarker());
+    }
+    ilsWriter->write(bglFile.getIls());
+
+    if(!area.isNavdataThirdPartyUpdate())
+      boundaryWriter->write(bglFile.getBoundaries());
+
+    for(const atools::fs::bgl::Airport *ap : bglFile.getAirports())
+      airportIdents.insert(ap->getIdent());
+
+    numNamelists += bglFile.getNamelists().size();
+
+    if(!area.isNavdataThirdPartyUpdate())
+    {
+      numVors += bglFile.getVors().size() + bglFile.getTacans().size();
+      numNdbs += bglFile.getNdbs().size();
+      numMarker += bglFile.getMarker().size();
+      numWaypoints += bglFile.getWaypoints().size();
+      numBoundaries += bglFile.getBoundaries().size();
+    }
+    numIls += bglFile.getIls().size();
+    numFiles++;
+
+    // Insert remaining rows before next file or commit
+    flushBatches();
+  }
+
+  // Print a one line short report on airports that were found in the BGL
+  if(!bglFile.getAirports().isEmpty())
+  {
+    QStringList apIcaos;
+    for(const atools::fs::bgl::Airport *ap : bglFile.getAirports())
+    {
+      // Truncate at 10
+      if(apIcaos.size() < 10)
+        apIcaos.append(ap->getIdent());
+      else
+        break;
+    }
+    if(bglFile.getAirports().size() > 10)
+      apIcaos.append("...");
+    qDebug() << "Found" << bglFile.getAirports().size() << "airports. idents:" << apIcaos.join(",");
   }
 }
 
@@ -412,7 +585,11 @@ void DataWriter::readMagDeclBgl(const QString& fileScenery)
 
   if(!loaded)
   {
-    magDecReader->readFromWmm();
+    if(options.getSharedMagDecReader() != nullptr)
+      // Calculated only once for all compilations
+      magDecReader->readFromReader(*options.getSharedMagDecReader());
+    else
+      magDecReader->readFromWmm();
     magDecReader->writeToTable(db);
     db.commit();
   }
@@ -23,12 +23,16 @@
 #include <QList>
 #include <QSet>
 #include <QString>
+#include <QVector>
 #include <QApplication>
 
 namespace atools {
 namespace sql {
 class SqlDatabase;
 }
+namespace util {
+class StringInterner;
+}
 namespace geo {
 class Pos;
 }
@@ -38,15 +42,21 @@ class NavDatabaseErrors;
 namespace common {
 class MagDecReader;
 }
+namespace bgl {
+class BglFile;
+}
 namespace scenery {
 class SceneryArea;
 class LanguageJson;
 class MaterialLib;
+class DirectoryCache;
+struct SceneryAreaFiles;
 }
 class ProgressHandler;
 
 namespace db {
 
+class BglFileCache;
 class BglFileWriter;
 class SceneryAreaWriter;
 class AirportWriter;
@@ -70,9 +80,12 @@ class StartWriter;
 class HelipadWriter;
 class RunwayIndex;
 class DbAirportIndex;
+class DbSessionIndex;
 class ApronWriter;
 class TaxiPathWriter;
 class BoundaryWriter;
+class BoundaryTileWriter;
+class WriterBaseBasic;
 
 /*
  * Keeps all writer objects and calls them in order to write BGL records to the database.
@@ -88,11 +101,17 @@ public:
 
   /*
    * @param area all BGL file content of this scenery area will be written to the database
+   * @param files already resolved files of the area. Resolves files again if null.
    */
-  void writeSceneryArea(const atools::fs::scenery::SceneryArea& area);
+  void writeSceneryArea(const atools::fs::scenery::SceneryArea& area,
+                        const atools::fs::scenery::SceneryAreaFiles *files = nullptr);
 
   void readMagDeclBgl(const QString& fileScenery);
 
+  /* Insert all rows buffered by writers which use batching. Has to be called before reading
+   * from tables of these writers. */
+  void flushBatches();
+
   /*
    * Log written record number, etc. to the log/console.
    */
@@ -127,6 +146,14 @@ public:
     return runwayIndex;
   }
 
+  /*
+   * @return index of airports and runway ends for the whole compilation which crosses BGL file boundaries
+   */
+  DbSessionIndex *getSessionIndex()
+  {
+    return sessionIndex;
+  }
+
   /*
    * @return configuration options for the scenery library compiler
    */
@@ -225,6 +252,11 @@ public:
     return boundaryWriter;
   }
 
+  atools::fs::db::BoundaryTileWriter *getBoundaryTileWriter() const
+  {
+    return boundaryTileWriter;
+  }
+
   atools::fs::db::VorWriter *getVorWriter() const
   {
     return vorWriter;
@@ -267,12 +299,33 @@ public:
     materialLibScenery = value;
   }
 
+  /* Cached directory listings for resolving scenery files. Not owned. */
+  void setDirectoryCache(atools::fs::scenery::DirectoryCache *value)
+  {
+    directoryCache = value;
+  }
+
+  /* Shares repeated names between all BGL files read by the reader threads. Not owned. Null disables interning. */
+  void setStringInterner(atools::util::StringInterner *value)
+  {
+    stringInterner = value;
+  }
+
   atools::sql::SqlDatabase& getDatabase() const
   {
     return db;
   }
 
 private:
+  /* Write content of one parsed BGL file to the database. Called in file order from the thread owning the database. */
+  void writeBglFile(atools::fs::bgl::BglFile& bglFile, const atools::fs::scenery::SceneryArea& area);
+
+  /* Update progress handler counts */
+  void updateProgressCounts();
+
+  /* All writers using batched inserts */
+  QVector<atools::fs::db::WriterBaseBasic *> batchWriters() const;
+
   int numFiles = 0, numNamelists = 0, numVors = 0, numIls = 0,
       numNdbs = 0, numMarker = 0, numWaypoints = 0, numBoundaries = 0, numObjectsWritten = 0;
   bool aborted = false;
@@ -312,14 +365,21 @@ private:
   atools::fs::db::IlsWriter *ilsWriter = nullptr;
 
   atools::fs::db::BoundaryWriter *boundaryWriter = nullptr;
+  atools::fs::db::BoundaryTileWriter *boundaryTileWriter = nullptr;
 
   atools::fs::db::RunwayIndex *runwayIndex = nullptr;
   atools::fs::db::DbAirportIndex *airportIndex = nullptr;
+  atools::fs::db::DbSessionIndex *sessionIndex = nullptr;
   atools::fs::common::MagDecReader *magDecReader = nullptr;
 
   const atools::fs::NavDatabaseOptions& options;
   const atools::fs::scenery::LanguageJson *languageIndex = nullptr;
   const atools::fs::scenery::MaterialLib *materialLib = nullptr, *materialLibScenery = nullptr;
+  atools::fs::scenery::DirectoryCache *directoryCache = nullptr;
+  atools::util::StringInterner *stringInterner = nullptr;
+
+  /* Files without content which are skipped. Null if disabled. */
+  atools::fs::db::BglFileCache *bglFileCache = nullptr;
 };
 
 } // namespace writer
@@ -0,0 +1,115 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/db/dbsessionindex.h"
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::util::packIdent;
+
+void DbSessionIndex::addAirport(const QString& airportIdent, int airportId)
+{
+  quint64 key = packIdent(airportIdent);
+  QVector<int> ids = identToAirportIds.value(key);
+  ids.append(airportId);
+  identToAirportIds.insert(key, ids);
+}
+
+void DbSessionIndex::removeAirport(const QString& airportIdent, int airportId)
+{
+  quint64 key = packIdent(airportIdent);
+  QVector<int> ids = identToAirportIds.value(key);
+  if(ids.removeOne(airportId))
+    identToAirportIds.insert(key, ids);
+}
+
+int DbSessionIndex::getAirportId(const QString& airportIdent, int excludeId) const
+{
+  QVector<int> ids = identToAirportIds.value(packIdent(airportIdent));
+
+  // Search backwards to get the last inserted airport
+  for(int i = ids.size() - 1; i >= 0; i--)
+  {
+    if(ids.at(i) != excludeId)
+      return ids.at(i);
+  }
+  return -1;
+}
+
+void DbSessionIndex::addRunwayEnd(int airportId, const QString& runwayName, int runwayEndId)
+{
+  quint64 key = static_cast<quint64>(airportId);
+  QVector<RunwayEnd> ends = airportIdToRunwayEnds.value(key);
+  ends.append(std::make_pair(packIdent(runwayName), runwayEndId));
+  airportIdToRunwayEnds.insert(key, ends);
+}
+
+int DbSessionIndex::getRunwayEndId(int airportId, const QString& runwayName) const
+{
+  if(airportId != -1)
+  {
+    quint64 name = packIdent(runwayName);
+    for(const RunwayEnd& end : airportIdToRunwayEnds.value(static_cast<quint64>(airportId)))
+    {
+      if(end.first == name)
+        return end.second;
+    }
+  }
+  return -1;
+}
+
+QVector<int> DbSessionIndex::getRunwayEndIds(int airportId) const
+{
+  QVector<int> ids;
+  for(const RunwayEnd& end : airportIdToRunwayEnds.value(static_cast<quint64>(airportId)))
+    ids.append(end.second);
+  return ids;
+}
+
+void DbSessionIndex::removeRunwayEnds(int airportId)
+{
+  quint64 key = static_cast<quint64>(airportId);
+  if(airportIdToRunwayEnds.contains(key))
+    airportIdToRunwayEnds.insert(key, QVector<RunwayEnd>());
+}
+
+void DbSessionIndex::moveRunwayEnds(int fromAirportId, int toAirportId)
+{
+  quint64 fromKey = static_cast<quint64>(fromAirportId), toKey = static_cast<quint64>(toAirportId);
+  QVector<RunwayEnd> fromEnds = airportIdToRunwayEnds.value(fromKey);
+  if(!fromEnds.isEmpty())
+  {
+    // Own runways of the airport are found first
+    QVector<RunwayEnd> ends = airportIdToRunwayEnds.value(toKey);
+    ends.append(fromEnds);
+    airportIdToRunwayEnds.insert(toKey, ends);
+    airportIdToRunwayEnds.insert(fromKey, QVector<RunwayEnd>());
+  }
+}
+
+void DbSessionIndex::clear()
+{
+  identToAirportIds.clear();
+  airportIdToRunwayEnds.clear();
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,88 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_DB_DBSESSIONINDEX_H
+#define ATOOLS_FS_DB_DBSESSIONINDEX_H
+
+#include "util/flathashmap.h"
+
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+/*
+ * Index of airports and runway ends which lives for the whole compilation in DataWriter.
+ * Other than RunwayIndex and DbAirportIndex it crosses the BGL file boundary.
+ *
+ * Fed by the writers when rows are inserted and by the DeleteProcessor when rows are removed or moved
+ * to another airport. Answers ident to id lookups from memory instead of selecting from the database.
+ * Idents and runway names are packed into integers and truncated to eight characters.
+ */
+class DbSessionIndex
+{
+public:
+  /* Airport row with given ident was inserted */
+  void addAirport(const QString& airportIdent, int airportId);
+
+  /* Airport row with given ident was deleted. Runway ends are kept. */
+  void removeAirport(const QString& airportIdent, int airportId);
+
+  /* Get id of the last inserted airport with the given ident which is not excludeId or -1 if not found */
+  int getAirportId(const QString& airportIdent, int excludeId = -1) const;
+
+  /* Runway end was inserted for airport */
+  void addRunwayEnd(int airportId, const QString& runwayName, int runwayEndId);
+
+  /* Runway end id for airport and runway name like "12L" or -1 if not found */
+  int getRunwayEndId(int airportId, const QString& runwayName) const;
+
+  /* Runway end id for the last inserted airport with the given ident or -1 if not found */
+  int getRunwayEndId(const QString& airportIdent, const QString& runwayName) const
+  {
+    return getRunwayEndId(getAirportId(airportIdent), runwayName);
+  }
+
+  /* Get ids of all runway ends of an airport */
+  QVector<int> getRunwayEndIds(int airportId) const;
+
+  /* Runways of an airport were deleted */
+  void removeRunwayEnds(int airportId);
+
+  /* Runways were relinked from one airport to another */
+  void moveRunwayEnds(int fromAirportId, int toAirportId);
+
+  void clear();
+
+private:
+  /* Packed runway name and runway_end_id */
+  typedef std::pair<quint64, int> RunwayEnd;
+
+  /* Airport ident to ids of all airports with this ident in insertion order */
+  atools::util::FlatHashMap<quint64, QVector<int> > identToAirportIds;
+
+  /* airport_id to runway ends */
+  atools::util::FlatHashMap<quint64, QVector<RunwayEnd> > airportIdToRunwayEnds;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_DBSESSIONINDEX_H
@@ -0,0 +1,134 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/db/nav/boundarytilewriter.h"
+#include "fs/common/binarygeometry.h"
+#include "geo/linestringlod.h"
+#include "geo/rect.h"
+
+#include <QHash>
+
+#include <cmath>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::geo::LineString;
+using atools::geo::LineStringLod;
+using atools::geo::Pos;
+using atools::geo::Rect;
+using atools::fs::common::BinaryGeometry;
+
+namespace {
+
+/* Pieces of a line in one cell */
+struct Tile
+{
+  LineString line;
+  Rect bounding;
+};
+
+typedef QPair<int, int> CellKey;
+
+CellKey cellForPos(const Pos& pos, int tileSize)
+{
+  return CellKey(static_cast<int>(std::floor(pos.getLonX() / tileSize)),
+                 static_cast<int>(std::floor(pos.getLatY() / tileSize)));
+}
+
+} // namespace
+
+void BoundaryTileWriter::writeTiles(int boundaryId, const LineString& line)
+{
+  if(line.size() < MIN_POSITIONS)
+    return;
+
+  // Close the ring to get the last edge into the tiles
+  LineString closed(line);
+  if(closed.first() != closed.last())
+    closed.append(closed.first());
+
+  LineStringLod lod(closed);
+  for(int level = 0; level < lod.getNumLevels(); level++)
+    writeLevel(boundaryId, level, lod.getLevelTolerance(level), lod.getLevel(level));
+}
+
+void BoundaryTileWriter::writeLevel(int boundaryId, int level, float tolerance, const LineString& line)
+{
+  int tileSize = tolerance < COARSE_TOLERANCE_METER ? DETAIL_TILE_SIZE : COARSE_TILE_SIZE;
+
+  // Keep order of cells for reproducible ids
+  QVector<CellKey> cells;
+  QHash<CellKey, Tile> tiles;
+
+  // Each segment goes into the cell of its first position. A piece ends with the first position outside the
+  // cell to keep the line connected.
+  CellKey currentCell = cellForPos(line.first(), tileSize);
+  LineString piece({line.first()});
+  for(int i = 1; i < line.size(); i++)
+  {
+    const Pos& pos = line.at(i);
+    piece.append(pos);
+
+    CellKey cell = cellForPos(pos, tileSize);
+    if(cell != currentCell || i == line.size() - 1)
+    {
+      if(!tiles.contains(currentCell))
+        cells.append(currentCell);
+
+      Tile& tile = tiles[currentCell];
+      if(tile.line.isEmpty())
+        tile.bounding = Rect(piece);
+      else
+      {
+        // Separate pieces by an invalid position
+        tile.line.append(atools::geo::EMPTY_POS);
+        tile.bounding.extend(piece);
+      }
+      tile.line.append(piece);
+
+      piece.clear();
+      piece.append(pos);
+      currentCell = cell;
+    }
+  }
+
+  for(const CellKey& cell : cells)
+  {
+    const Tile& tile = tiles.value(cell);
+
+    bind(":boundary_tile_id", ++id);
+    bind(":boundary_id", boundaryId);
+    bind(":lod", level);
+    bind(":tolerance", tolerance);
+    bind(":tile_size", tileSize);
+    bind(":tile_lonx", cell.first * tileSize);
+    bind(":tile_laty", cell.second * tileSize);
+    bind(":max_lonx", tile.bounding.getEast());
+    bind(":max_laty", tile.bounding.getNorth());
+    bind(":min_lonx", tile.bounding.getWest());
+    bind(":min_laty", tile.bounding.getSouth());
+    bind(":geometry", BinaryGeometry(tile.line).writeToByteArray(BinaryGeometry::FORMAT_COMPACT));
+    executeStatement();
+  }
+}
+
+} // namespace writer
+} // namespace fs
+} // namespace atools
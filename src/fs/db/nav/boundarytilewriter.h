@@ -0,0 +1,78 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_DB_BOUNDARYTILEWRITER_H
+#define ATOOLS_FS_DB_BOUNDARYTILEWRITER_H
+
+#include "fs/db/writerbasebasic.h"
+
+namespace atools {
+namespace geo {
+class LineString;
+}
+namespace fs {
+namespace db {
+
+/*
+ * Writes simplified and tiled versions of large boundaries into table boundary_tile.
+ *
+ * All levels of detail of the boundary line are split into pieces by grid cells. Detailed levels use one
+ * degree cells and coarse levels five degree cells. All pieces of a level in a cell are stored as one geometry
+ * separated by invalid positions. A client can then load only the cells and the resolution needed for the
+ * current view instead of decoding the full geometry in table boundary.
+ *
+ * Boundaries with less than MIN_POSITIONS positions are not tiled.
+ */
+class BoundaryTileWriter :
+  public atools::fs::db::WriterBaseBasic
+{
+public:
+  BoundaryTileWriter(atools::sql::SqlDatabase& db, atools::fs::db::DataWriter& dataWriter)
+    : WriterBaseBasic(db, dataWriter, "boundary_tile", QString())
+  {
+  }
+
+  virtual ~BoundaryTileWriter()
+  {
+  }
+
+  /* Write tiles for the closed boundary line if it is large enough */
+  void writeTiles(int boundaryId, const atools::geo::LineString& line);
+
+  /* Boundaries with less positions are not tiled */
+  static Q_DECL_CONSTEXPR int MIN_POSITIONS = 500;
+
+  /* Cell size in degree for levels having a tolerance below COARSE_TOLERANCE_METER */
+  static Q_DECL_CONSTEXPR int DETAIL_TILE_SIZE = 1;
+
+  /* Cell size in degree for all other levels */
+  static Q_DECL_CONSTEXPR int COARSE_TILE_SIZE = 5;
+  static Q_DECL_CONSTEXPR float COARSE_TOLERANCE_METER = 1000.f;
+
+private:
+  /* Split line by cells of the size for the tolerance and write a row for each cell */
+  void writeLevel(int boundaryId, int level, float tolerance, const atools::geo::LineString& line);
+
+  int id = 0;
+};
+
+} // namespace writer
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_BOUNDARYTILEWRITER_H
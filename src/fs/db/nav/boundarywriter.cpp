@@ -16,6 +16,7 @@
 *****************************************************************************/
 
 #include "fs/db/nav/boundarywriter.h"
+#include "fs/db/nav/boundarytilewriter.h"
 #include "fs/db/datawriter.h"
 #include "fs/common/binarygeometry.h"
 #include "fs/bgl/util.h"
@@ -80,9 +81,14 @@ void BoundaryWriter::writeObject(const Boundary *type)
   bind(":min_lonx", type->getMinPosition().getLonX());
   bind(":min_laty", type->getMinPosition().getLatY());
 
-  atools::fs::common::BinaryGeometry geo(fetchAirspaceLines(type));
+  int boundaryId = getCurrentId();
+  LineString lines = fetchAirspaceLines(type);
+  atools::fs::common::BinaryGeometry geo(lines);
   bind(":geometry", geo.writeToByteArray());
   executeStatement();
+
+  // Large boundaries like coastline based airspaces get additional simplified tiles
+  getDataWriter().getBoundaryTileWriter()->writeTiles(boundaryId, lines);
 }
 
 atools::geo::LineString BoundaryWriter::fetchAirspaceLines(const Boundary *type)
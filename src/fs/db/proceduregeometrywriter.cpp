@@ -0,0 +1,391 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/proceduregeometrywriter.h"
+
+#include "fs/common/binarygeometry.h"
+#include "geo/calculations.h"
+#include "geo/linestring.h"
+#include "geo/rect.h"
+#include "sql/sqlcolumnindex.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QElapsedTimer>
+
+#include <cmath>
+#include <limits>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlQuery;
+using atools::sql::SqlColumnIndex;
+using atools::geo::Pos;
+using atools::geo::LineString;
+using atools::geo::normalizeCourse;
+
+namespace {
+
+/* Add a point to arcs for each step of this angle */
+const float ARC_STEP_DEG = 5.f;
+
+/* Column ids for leg queries. Fix and recommended fix columns have the same order. */
+enum LegColumn
+{
+  ID, IS_MISSED, TYPE, TURN_DIRECTION,
+  FIX_TYPE, FIX_IDENT, FIX_REGION, FIX_LONX, FIX_LATY,
+  RECOMMENDED_FIX_TYPE, RECOMMENDED_FIX_IDENT, RECOMMENDED_FIX_REGION, RECOMMENDED_FIX_LONX, RECOMMENDED_FIX_LATY
+};
+
+/* Offsets from FIX_TYPE or RECOMMENDED_FIX_TYPE */
+enum FixColumnOffset
+{
+  OFFSET_TYPE, OFFSET_IDENT, OFFSET_REGION, OFFSET_LONX, OFFSET_LATY
+};
+
+const QStringList LEG_COLUMNS({
+  "id", "is_missed", "type", "turn_direction",
+  "fix_type", "fix_ident", "fix_region", "fix_lonx", "fix_laty",
+  "recommended_fix_type", "recommended_fix_ident", "recommended_fix_region", "recommended_fix_lonx",
+  "recommended_fix_laty"
+});
+
+/* Add points between from and to around center excluding the end points. Radius is interpolated between
+ * the distances of from and to to center. Uses the shorter turn if direction is neither left nor right. */
+void appendArc(LineString& line, const Pos& center, const Pos& from, const Pos& to, const QString& turnDirection)
+{
+  float startAngle = center.angleDegTo(from), endAngle = center.angleDegTo(to);
+  float startRadius = center.distanceMeterTo(from), endRadius = center.distanceMeterTo(to);
+
+  float sweepRight = normalizeCourse(endAngle - startAngle);
+  float sweepLeft = -normalizeCourse(startAngle - endAngle);
+
+  float sweep;
+  if(turnDirection == "L")
+    sweep = sweepLeft;
+  else if(turnDirection == "R")
+    sweep = sweepRight;
+  else
+    sweep = sweepRight <= 180.f ? sweepRight : sweepLeft;
+
+  int num = static_cast<int>(std::abs(sweep) / ARC_STEP_DEG);
+  for(int i = 1; i < num; i++)
+  {
+    float fraction = static_cast<float>(i) / static_cast<float>(num);
+    line.append(center.endpoint(startRadius + (endRadius - startRadius) * fraction,
+                                normalizeCourse(startAngle + sweep * fraction)));
+  }
+}
+
+} // namespace
+
+ProcedureGeometryWriter::ProcedureGeometryWriter(atools::sql::SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+ProcedureGeometryWriter::~ProcedureGeometryWriter()
+{
+  deInitQueries();
+}
+
+void ProcedureGeometryWriter::run()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  SqlQuery stmt(db);
+  stmt.exec("delete from procedure_geometry");
+
+  initQueries();
+  numWritten = numFixNotFound = 0;
+
+  // Load airport id and position for all approaches ==========================
+  SqlQuery approachQuery(db);
+  approachQuery.setForwardOnly(true);
+  approachQuery.prepare("select a.approach_id, a.airport_id, p.lonx, p.laty "
+                        "from approach a join airport p on a.airport_id = p.airport_id");
+  approachQuery.exec();
+  while(approachQuery.next())
+    approachAirports.insert(approachQuery.valueInt(0),
+                            std::make_pair(approachQuery.valueInt(1),
+                                           Pos(approachQuery.valueFloat(2), approachQuery.valueFloat(3))));
+
+  // Load approach id for all transitions ==========================
+  QHash<int, int> transitionApproachIds;
+  SqlQuery transitionQuery(db);
+  transitionQuery.setForwardOnly(true);
+  transitionQuery.prepare("select transition_id, approach_id from transition");
+  transitionQuery.exec();
+  while(transitionQuery.next())
+    transitionApproachIds.insert(transitionQuery.valueInt(0), transitionQuery.valueInt(1));
+
+  writeLegs(false /* transitions */, transitionApproachIds);
+  writeLegs(true /* transitions */, transitionApproachIds);
+
+  approachAirports.clear();
+  fixCache.clear();
+  deInitQueries();
+
+  qDebug() << Q_FUNC_INFO << "Procedure geometries written" << numWritten << "fixes not found" << numFixNotFound
+           << timer.elapsed() << "ms";
+}
+
+void ProcedureGeometryWriter::writeLegs(bool transitions, const QHash<int, int>& transitionApproachIds)
+{
+  QString table = transitions ? "transition_leg" : "approach_leg";
+  QString idColumn = transitions ? "transition_id" : "approach_id";
+
+  // Legs are ordered by id and therefore in the order of the flight path
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.prepare("select " + idColumn + " as id, " + (transitions ? "0" : "is_missed") + " as is_missed, "
+                "type, turn_direction, fix_type, fix_ident, fix_region, fix_lonx, fix_laty, "
+                "recommended_fix_type, recommended_fix_ident, recommended_fix_region, "
+                "recommended_fix_lonx, recommended_fix_laty "
+                "from " + table + " order by " + idColumn + ", " + table + "_id");
+  query.exec();
+
+  SqlColumnIndex cols(LEG_COLUMNS);
+  cols.resolve(query);
+
+  LineString line;
+  int curId = -1, approachId = -1, airportId = -1;
+  bool curMissed = false;
+  Pos airportPos;
+  while(query.next())
+  {
+    int id = cols.valueInt(query, ID);
+    bool missed = cols.valueBool(query, IS_MISSED);
+
+    if(id != curId || missed != curMissed)
+    {
+      writeGeometry(line, approachId, transitions ? curId : -1, curMissed);
+
+      // Missed approach starts at the last fix of the approach
+      Pos last = id == curId && !line.isEmpty() ? line.constLast() : Pos();
+      line.clear();
+      if(last.isValid())
+        line.append(last);
+
+      if(id != curId)
+      {
+        approachId = transitions ? transitionApproachIds.value(id, -1) : id;
+        std::pair<int, Pos> airport = approachAirports.value(approachId, std::make_pair(-1, Pos()));
+
+        if(airport.first != airportId)
+          // Cache is only valid for the airport since the nearest fix is used
+          fixCache.clear();
+
+        airportId = airport.first;
+        airportPos = airport.second;
+      }
+
+      curId = id;
+      curMissed = missed;
+    }
+
+    appendLeg(line, query, cols, airportId, airportPos);
+  }
+  writeGeometry(line, approachId, transitions ? curId : -1, curMissed);
+}
+
+void ProcedureGeometryWriter::appendLeg(LineString& line, const SqlQuery& query, const SqlColumnIndex& cols,
+                                        int airportId, const Pos& airportPos)
+{
+  Pos pos = fixPos(query, cols, FIX_TYPE, airportId, airportPos);
+  if(!pos.isValid())
+    // Course to altitude, intercept or manual termination legs
+    return;
+
+  QString type = cols.valueStr(query, TYPE);
+  if((type == "AF" || type == "RF") && !line.isEmpty())
+  {
+    // DME arc or constant radius arc around recommended fix
+    Pos center = fixPos(query, cols, RECOMMENDED_FIX_TYPE, airportId, airportPos);
+    if(center.isValid())
+      appendArc(line, center, line.constLast(), pos, cols.valueStr(query, TURN_DIRECTION));
+  }
+
+  if(line.isEmpty() || !line.constLast().almostEqual(pos))
+    line.append(pos);
+}
+
+void ProcedureGeometryWriter::writeGeometry(const LineString& line, int approachId, int transitionId, bool missed)
+{
+  if(approachId == -1 || line.size() < 2)
+    return;
+
+  atools::geo::Rect rect = line.boundingRect();
+
+  insertQuery->bindValue(":approach_id", approachId);
+  if(transitionId == -1)
+    insertQuery->bindNullInt(":transition_id");
+  else
+    insertQuery->bindValue(":transition_id", transitionId);
+  insertQuery->bindValue(":is_missed", missed);
+  insertQuery->bindValue(":distance", atools::geo::meterToNm(line.lengthMeter()));
+  insertQuery->bindValue(":left_lonx", rect.getTopLeft().getLonX());
+  insertQuery->bindValue(":top_laty", rect.getTopLeft().getLatY());
+  insertQuery->bindValue(":right_lonx", rect.getBottomRight().getLonX());
+  insertQuery->bindValue(":bottom_laty", rect.getBottomRight().getLatY());
+  insertQuery->bindValue(":geometry", atools::fs::common::BinaryGeometry(line).writeToByteArray());
+  insertQuery->exec();
+  numWritten++;
+}
+
+Pos ProcedureGeometryWriter::fixPos(const SqlQuery& query, const SqlColumnIndex& cols, int firstColumn,
+                                    int airportId, const Pos& airportPos)
+{
+  if(!cols.isNull(query, firstColumn + OFFSET_LONX) && !cols.isNull(query, firstColumn + OFFSET_LATY))
+    return Pos(cols.valueFloat(query, firstColumn + OFFSET_LONX), cols.valueFloat(query, firstColumn + OFFSET_LATY));
+
+  return findFix(cols.valueStr(query, firstColumn + OFFSET_TYPE), cols.valueStr(query, firstColumn + OFFSET_IDENT),
+                 cols.valueStr(query, firstColumn + OFFSET_REGION), airportId, airportPos);
+}
+
+Pos ProcedureGeometryWriter::findFix(const QString& type, const QString& ident, const QString& region, int airportId,
+                                     const Pos& airportPos)
+{
+  if(type.isEmpty() || ident.isEmpty() || type == "NONE")
+    return Pos();
+
+  QString key = type + "|" + ident + "|" + region;
+  QHash<QString, Pos>::const_iterator it = fixCache.constFind(key);
+  if(it != fixCache.constEnd())
+    return it.value();
+
+  SqlQuery *query = nullptr;
+  if(type == "W" || type == "TW")
+    query = waypointQuery;
+  else if(type == "V")
+    query = vorQuery;
+  else if(type == "N" || type == "TN")
+    query = ndbQuery;
+  else if(type == "L")
+    query = ilsQuery;
+  else if(type == "A")
+    query = airportQuery;
+  else if(type == "R")
+    query = runwayEndQuery;
+
+  Pos pos;
+  if(query != nullptr)
+  {
+    if(query == runwayEndQuery)
+    {
+      // Runway fixes are prefixed with RW
+      query->bindValue(":name", ident.startsWith("RW") ? ident.mid(2) : ident);
+      query->bindValue(":airportId", airportId);
+    }
+    else
+    {
+      query->bindValue(":ident", ident);
+      if(query != ilsQuery && query != airportQuery)
+        query->bindValue(":region", region.isEmpty() ? "%" : region);
+    }
+    query->exec();
+    pos = nearest(query, airportPos);
+  }
+
+  if(!pos.isValid())
+    numFixNotFound++;
+
+  fixCache.insert(key, pos);
+  return pos;
+}
+
+Pos ProcedureGeometryWriter::nearest(SqlQuery *query, const Pos& airportPos)
+{
+  Pos result;
+  float minDistance = std::numeric_limits<float>::max();
+  while(query->next())
+  {
+    Pos pos(query->valueFloat(0), query->valueFloat(1));
+    float distance = airportPos.isValid() ? pos.distanceMeterTo(airportPos) : 0.f;
+    if(distance < minDistance)
+    {
+      minDistance = distance;
+      result = pos;
+    }
+  }
+  query->finish();
+  return result;
+}
+
+void ProcedureGeometryWriter::initQueries()
+{
+  deInitQueries();
+
+  waypointQuery = new SqlQuery(db);
+  waypointQuery->prepare("select lonx, laty from waypoint where ident = :ident and region like :region");
+
+  vorQuery = new SqlQuery(db);
+  vorQuery->prepare("select lonx, laty from vor where ident = :ident and region like :region");
+
+  ndbQuery = new SqlQuery(db);
+  ndbQuery->prepare("select lonx, laty from ndb where ident = :ident and region like :region");
+
+  ilsQuery = new SqlQuery(db);
+  ilsQuery->prepare("select lonx, laty from ils where ident = :ident");
+
+  airportQuery = new SqlQuery(db);
+  airportQuery->prepare("select lonx, laty from airport where ident = :ident");
+
+  runwayEndQuery = new SqlQuery(db);
+  runwayEndQuery->prepare("select e.lonx, e.laty from runway r "
+                          "join runway_end e on e.runway_end_id = r.primary_end_id or "
+                          "  e.runway_end_id = r.secondary_end_id "
+                          "where r.airport_id = :airportId and e.name = :name");
+
+  insertQuery = new SqlQuery(db);
+  insertQuery->prepare("insert into procedure_geometry (approach_id, transition_id, is_missed, distance, "
+                       "left_lonx, top_laty, right_lonx, bottom_laty, geometry) "
+                       "values(:approach_id, :transition_id, :is_missed, :distance, "
+                       ":left_lonx, :top_laty, :right_lonx, :bottom_laty, :geometry)");
+}
+
+void ProcedureGeometryWriter::deInitQueries()
+{
+  delete waypointQuery;
+  waypointQuery = nullptr;
+
+  delete vorQuery;
+  vorQuery = nullptr;
+
+  delete ndbQuery;
+  ndbQuery = nullptr;
+
+  delete ilsQuery;
+  ilsQuery = nullptr;
+
+  delete airportQuery;
+  airportQuery = nullptr;
+
+  delete runwayEndQuery;
+  runwayEndQuery = nullptr;
+
+  delete insertQuery;
+  insertQuery = nullptr;
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
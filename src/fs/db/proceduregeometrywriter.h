@@ -0,0 +1,105 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_PROCEDUREGEOMETRYWRITER_H
+#define ATOOLS_PROCEDUREGEOMETRYWRITER_H
+
+#include "geo/pos.h"
+
+#include <QCoreApplication>
+#include <QHash>
+
+namespace atools {
+namespace geo {
+class LineString;
+}
+namespace sql {
+class SqlDatabase;
+class SqlQuery;
+class SqlColumnIndex;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Calculates an approximated geometry for all approaches, missed approaches and transitions and fills the
+ * table procedure_geometry. Reads approach, transition and the leg tables.
+ *
+ * Fix positions are taken from the leg coordinates if available or looked up by type, ident and region.
+ * The navaid nearest to the airport is used if the lookup is ambiguous.
+ * DME arcs (AF) and radius to fix (RF) legs are interpolated around the recommended fix. All other legs
+ * are straight lines between fixes. Legs without fix like course to altitude are ignored.
+ */
+class ProcedureGeometryWriter
+{
+  Q_DECLARE_TR_FUNCTIONS(ProcedureGeometryWriter)
+
+public:
+  ProcedureGeometryWriter(atools::sql::SqlDatabase *sqlDb);
+  ~ProcedureGeometryWriter();
+
+  /*
+   * Run the process and fill the procedure_geometry table.
+   * Has to run after all procedures are loaded and the runway ends are assigned.
+   */
+  void run();
+
+private:
+  /* Read all legs of approach or transition table and write geometry for each group of id and missed flag */
+  void writeLegs(bool transitions, const QHash<int, int>& transitionApproachIds);
+
+  /* Append leg to the line string. Interpolates arcs. */
+  void appendLeg(atools::geo::LineString& line, const atools::sql::SqlQuery& query,
+                 const atools::sql::SqlColumnIndex& cols, int airportId, const atools::geo::Pos& airportPos);
+
+  /* Write a line string if it has at least two points */
+  void writeGeometry(const atools::geo::LineString& line, int approachId, int transitionId, bool missed);
+
+  /* Get position from coordinate columns or from navaid tables by type, ident and region.
+   * firstColumn is the column id of the fix type which is followed by ident, region, lonx and laty. */
+  atools::geo::Pos fixPos(const atools::sql::SqlQuery& query, const atools::sql::SqlColumnIndex& cols,
+                          int firstColumn, int airportId, const atools::geo::Pos& airportPos);
+
+  /* Look up the position of a fix and remember it. Returns invalid position if not found. */
+  atools::geo::Pos findFix(const QString& type, const QString& ident, const QString& region, int airportId,
+                           const atools::geo::Pos& airportPos);
+
+  /* Get nearest of all results of the executed query. Needs columns lonx and laty. */
+  static atools::geo::Pos nearest(atools::sql::SqlQuery *query, const atools::geo::Pos& airportPos);
+
+  void initQueries();
+  void deInitQueries();
+
+  atools::sql::SqlDatabase *db;
+
+  /* Key is type, ident and region. Cleared when the airport changes since the nearest fix is used. */
+  QHash<QString, atools::geo::Pos> fixCache;
+
+  /* Airport of approach. Key is approach id. */
+  QHash<int, std::pair<int, atools::geo::Pos> > approachAirports;
+
+  atools::sql::SqlQuery *waypointQuery = nullptr, *vorQuery = nullptr, *ndbQuery = nullptr, *ilsQuery = nullptr,
+                        *airportQuery = nullptr, *runwayEndQuery = nullptr, *insertQuery = nullptr;
+  int numWritten = 0, numFixNotFound = 0;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_PROCEDUREGEOMETRYWRITER_H
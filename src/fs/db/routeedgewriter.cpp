@@ -19,11 +19,12 @@
 
 #include "sql/sqldatabase.h"
 #include "geo/pos.h"
-#include "geo/rect.h"
 #include "geo/calculations.h"
+#include "geo/spatialindex.h"
 #include "sql/sqlutil.h"
 #include "sql/sqlquery.h"
 #include "fs/progresshandler.h"
+#include "util/parallel.h"
 
 #include <QElapsedTimer>
 
@@ -35,7 +36,9 @@ using atools::sql::SqlDatabase;
 using atools::sql::SqlUtil;
 using atools::sql::SqlQuery;
 using atools::geo::Pos;
-using atools::geo::Rect;
+using atools::geo::SpatialIndex;
+using internal::RadioNode;
+using internal::RadioEdge;
 
 /* Added to range of current radio id */
 const int MAX_RADIO_RANGE_METER = atools::geo::nmToMeter(200);
@@ -52,15 +55,18 @@ const int MAX_EDGES_PER_SECTOR = 2;
 /* Increase search radius around a navaid and search again until we find at least this amount of neigbours s  */
 const int MIN_EDGES_PER_SECTOR = 1;
 
-/* Increase rectangle at a maximum of this number */
+/* Increase radius at a maximum of this number */
 const int MAX_ITERATIONS = 2;
 
 /* Prioritize navaids by type - Index VOR=0, VORDME=1, DME=2, NDB=3 */
 const int PRIORITY_BY_TYPE[] = {0 /* None */, 2 /* VOR */, 3 /* VORDME */, 0 /* DME */, 1 /* NDB */};
 
-/* Inflate seach rectangle for each iteration.  */
-const float INFLATE_RECT_LON_DEGREES = 6.f;
-const float INFLATE_RECT_LAT_DEGREES = 4.f;
+/* Increase search radius for each iteration. Roughly the same as the former rectangle inflation by four degrees. */
+const float INFLATE_RADIUS_METER = atools::geo::nmToMeter(240.f);
+
+/* The spatial index uses manhattan distance in 3D space which is always larger than the euclidian distance.
+ * Increase radius to cover the same area as a bounding rectangle. */
+const float MANHATTAN_FACTOR = 1.75f;
 
 // Query result column indexes
 enum ColumnIndex
@@ -68,14 +74,6 @@ enum ColumnIndex
   NODE_ID, RANGE, TYPE, LONX, LATY
 };
 
-enum BindColumnIndex
-{
-  LEFTX,
-  RIGHTX,
-  BOTTOMY,
-  TOPY
-};
-
 RouteEdgeWriter::RouteEdgeWriter(atools::sql::SqlDatabase *sqlDb)
   : db(sqlDb)
 {
@@ -84,19 +82,29 @@ RouteEdgeWriter::RouteEdgeWriter(atools::sql::SqlDatabase *sqlDb)
 
 void RouteEdgeWriter::run()
 {
-  // Iterate over all radio navaids
-  SqlQuery selectNodesQuery("select node_id, range, type, lonx, laty from route_node_radio", db);
+  QElapsedTimer timer;
+  timer.start();
 
-  // Get all nodes nearby this navaids
-  SqlQuery nearestNodesQuery(db);
-  nearestNodesQuery.prepare("select node_id, range, type, lonx, laty from route_node_radio "
-                            "where lonx between ? and ? and laty between ? and ?");
+  // Load all radio navaids into the spatial index ==========================
+  SpatialIndex<RadioNode> index;
+  SqlQuery selectNodesQuery("select node_id, range, type, lonx, laty from route_node_radio", db);
+  selectNodesQuery.exec();
+  while(selectNodesQuery.next())
+  {
+    RadioNode node;
+    node.nodeId = selectNodesQuery.value(NODE_ID).toInt();
+    node.range = selectNodesQuery.value(RANGE).toInt();
+    node.type = selectNodesQuery.value(TYPE).toInt();
+    node.pos = Pos(selectNodesQuery.value(LONX).toFloat(), selectNodesQuery.value(LATY).toFloat());
+    index.append(node);
+  }
+  index.updateIndex();
 
-  // Insert edges into databases
-  SqlQuery insertEdgesQuery(db);
-  insertEdgesQuery.prepare("insert into route_edge_radio "
-                           "(from_node_id, from_node_type, to_node_id, to_node_type, distance) "
-                           "values(?, ?, ?, ?, ?)");
+  // Calculate edges for all nodes in parallel ==========================
+  QVector<QVector<RadioEdge> > nodeEdges(index.size());
+  atools::util::parallelFor(index.size(), [this, &index, &nodeEdges](int i) -> void {
+    edgesForNode(index, i, nodeEdges[i]);
+  }, 100);
 
   // Clean the result table
   SqlQuery stmt(db);
@@ -104,88 +112,87 @@ void RouteEdgeWriter::run()
   int deleted = stmt.numRowsAffected();
   qInfo() << "Removed" << deleted << "from route_edge_radio table";
 
+  // Insert edges into database in one batch ==========================
   QVariantList toNodeIdVars, toNodeTypeVars, toNodeDistanceVars, fromNodeIdVars, fromNodeTypeVars;
-
   int average = 0, total = 0, maximum = 0, numEmpty = 0;
-
-  selectNodesQuery.exec();
-  while(selectNodesQuery.next())
+  for(int i = 0; i < index.size(); i++)
   {
-    // Look at each node
-    int fromRangeMeter = selectNodesQuery.value(RANGE).toInt();
-    int fromNodeId = selectNodesQuery.value(NODE_ID).toInt();
-    int fromNodeType = selectNodesQuery.value(TYPE).toInt();
-
-    Pos pos(selectNodesQuery.value(LONX).toFloat(), selectNodesQuery.value(LATY).toFloat());
-
-    // Clear result lists
-    toNodeIdVars.clear();
-    toNodeTypeVars.clear();
-    toNodeDistanceVars.clear();
-
-    // Get all navaids in bounding rectangle - first iterations
-    Rect queryRect(pos, MAX_RADIO_RANGE_METER);
-    bool nearestSatisfied = nearest(nearestNodesQuery, fromNodeId, pos, queryRect, fromRangeMeter,
-                                    toNodeIdVars, toNodeTypeVars, toNodeDistanceVars);
-
-    // If not all sectors have an edge increase rectangle and try again for MAX_ITERATIONS
-    int maxIter = 0;
-    while(!nearestSatisfied)
-    {
-      toNodeIdVars.clear();
-      toNodeTypeVars.clear();
-      toNodeDistanceVars.clear();
-      queryRect.inflate(INFLATE_RECT_LON_DEGREES, INFLATE_RECT_LAT_DEGREES);
-      nearestSatisfied = nearest(nearestNodesQuery, fromNodeId, pos, queryRect, fromRangeMeter,
-                                 toNodeIdVars, toNodeTypeVars, toNodeDistanceVars);
-      if(maxIter++ > MAX_ITERATIONS)
-        break;
-    }
+    const RadioNode& from = index.at(i);
+    const QVector<RadioEdge>& edges = nodeEdges.at(i);
 
-    // Update from value arrays with values for bind
-    fromNodeIdVars.clear();
-    fromNodeTypeVars.clear();
-    for(int i = 0; i < toNodeIdVars.size(); i++)
+    for(const RadioEdge& edge : edges)
     {
-      fromNodeIdVars.append(fromNodeId);
-      fromNodeTypeVars.append(fromNodeType);
+      fromNodeIdVars.append(from.nodeId);
+      fromNodeTypeVars.append(from.type);
+      toNodeIdVars.append(edge.toNodeId);
+      toNodeTypeVars.append(edge.toNodeType);
+      toNodeDistanceVars.append(edge.distance);
     }
 
+    total += edges.size();
+    average = (average + edges.size()) / 2;
+    maximum = std::max(maximum, edges.size());
+
+    if(edges.isEmpty())
+      numEmpty++;
+  }
+
+  if(!fromNodeIdVars.isEmpty())
+  {
     // Use batch update to insert values into edge table
+    SqlQuery insertEdgesQuery(db);
+    insertEdgesQuery.prepare("insert into route_edge_radio "
+                             "(from_node_id, from_node_type, to_node_id, to_node_type, distance) "
+                             "values(?, ?, ?, ?, ?)");
     insertEdgesQuery.addBindValue(fromNodeIdVars);
     insertEdgesQuery.addBindValue(fromNodeTypeVars);
     insertEdgesQuery.addBindValue(toNodeIdVars);
     insertEdgesQuery.addBindValue(toNodeTypeVars);
     insertEdgesQuery.addBindValue(toNodeDistanceVars);
     insertEdgesQuery.execBatch();
-
-    total += toNodeIdVars.size();
-    average = (average + toNodeIdVars.size()) / 2;
-    maximum = std::max(maximum, toNodeIdVars.size());
-
-    if(toNodeIdVars.size() == 0)
-      numEmpty++;
   }
 
   qDebug() << "Edge writer: total" << total << "average" << average
-           << "max" << maximum << "numEmpty" << numEmpty;
+           << "max" << maximum << "numEmpty" << numEmpty << timer.elapsed() << "ms";
+}
+
+void RouteEdgeWriter::edgesForNode(const SpatialIndex<RadioNode>& index, int nodeIndex,
+                                   QVector<RadioEdge>& edges) const
+{
+  const RadioNode& from = index.at(nodeIndex);
+
+  // Reused for all iterations to avoid allocations
+  atools::geo::SpatialIndexBuffer buffer;
+  QVector<int> indexes;
+
+  // Get all navaids in radius - first iteration
+  float radius = MAX_RADIO_RANGE_METER;
+  bool nearestSatisfied = nearest(index, from, radius, edges, buffer, indexes);
+
+  // If not all sectors have an edge increase radius and try again for MAX_ITERATIONS
+  int maxIter = 0;
+  while(!nearestSatisfied)
+  {
+    edges.clear();
+    radius += INFLATE_RADIUS_METER;
+    nearestSatisfied = nearest(index, from, radius, edges, buffer, indexes);
+    if(maxIter++ > MAX_ITERATIONS)
+      break;
+  }
 }
 
 /*
  * Get nearest neighbours for a navaid
- * @param nearestStmt
- * @param fromNodeId node ID for current navaid
- * @param pos position of current navaid
- * @param queryRect current query rectangle
- * @param fromRangeMeter range for current navaid
- * @param toNodeIds result list
- * @param toNodeTypes result list
- * @param toNodeDistances result list
- * @return
+ * @param index spatial index of all navaids
+ * @param from current navaid
+ * @param radiusMeter search radius
+ * @param edges result list
+ * @param buffer and indexes temporary buffers for spatial search
+ * @return true if all sectors have enough neighbours
  */
-bool RouteEdgeWriter::nearest(SqlQuery& nearestStmt, int fromNodeId, const Pos& pos, const Rect& queryRect,
-                              int fromRangeMeter, QVariantList& toNodeIds,
-                              QVariantList& toNodeTypes, QVariantList& toNodeDistances)
+bool RouteEdgeWriter::nearest(const SpatialIndex<RadioNode>& index, const RadioNode& from, float radiusMeter,
+                              QVector<RadioEdge>& edges, atools::geo::SpatialIndexBuffer& buffer,
+                              QVector<int>& indexes) const
 {
   struct TempNodeTo
   {
@@ -197,80 +204,69 @@ bool RouteEdgeWriter::nearest(SqlQuery& nearestStmt, int fromNodeId, const Pos&
   };
 
   // Nodes with reachable navaids - one list of nodes per sector
-  QVector<QVector<TempNodeTo> > sectorsReachable;
-  for(int i = 0; i < NUM_SECTORS; i++)
-    sectorsReachable.append(QVector<TempNodeTo>());
+  QVector<QVector<TempNodeTo> > sectorsReachable(NUM_SECTORS);
 
   // Nodes with unreachable navaids - one list of nodes per sector
-  QVector<QVector<TempNodeTo> > sectorsOther;
-  for(int i = 0; i < NUM_SECTORS; i++)
-    sectorsOther.append(QVector<TempNodeTo>());
+  QVector<QVector<TempNodeTo> > sectorsOther(NUM_SECTORS);
+
+  // Get all except the node itself
+  indexes.clear();
+  index.getRadiusIndexes(indexes, from.pos, radiusMeter * MANHATTAN_FACTOR, buffer,
+                         [&index, &from](float, int idx) -> bool {
+    return index.at(idx).nodeId != from.nodeId;
+  });
 
-  for(const Rect& rect : queryRect.splitAtAntiMeridian())
+  for(int idx : indexes)
   {
-    bindCoordinatePointInRect(rect, &nearestStmt);
+    const RadioNode& to = index.at(idx);
+    int distanceMeter = static_cast<int>(from.pos.distanceMeterTo(to.pos) + 0.5f);
 
-    nearestStmt.exec();
+    if(distanceMeter < MIN_DISTANCE_METER || distanceMeter > radiusMeter)
+      // Navaid is too close or too far away
+      continue;
 
-    while(nearestStmt.next())
+    int courseDeg = static_cast<int>(from.pos.angleDegTo(to.pos) + 0.5f);
+    if(courseDeg >= 360)
+      courseDeg -= 360;
+
+    // Calculate sector number for this node
+    int sectorNum = courseDeg / (360 / NUM_SECTORS);
+
+    TempNodeTo tmp = {to.nodeId, to.type, to.range, distanceMeter, PRIORITY_BY_TYPE[to.type]};
+
+    bool reachable = from.range + to.range > distanceMeter;
+
+    QVector<TempNodeTo>::iterator it;
+
+    if(reachable)
     {
-      int toNodeId = nearestStmt.value(NODE_ID).toInt();
-      if(toNodeId == fromNodeId)
-        continue;
-
-      int toRangeMeter = nearestStmt.value(RANGE).toInt();
-      Pos toPos(nearestStmt.value(LONX).toFloat(), nearestStmt.value(LATY).toFloat());
-      int distanceMeter = static_cast<int>(pos.distanceMeterTo(toPos) + 0.5f);
-
-      if(distanceMeter < MIN_DISTANCE_METER)
-        // Navaid is too close
-        continue;
-
-      int courseDeg = static_cast<int>(pos.angleDegTo(toPos) + 0.5f);
-      if(courseDeg >= 360)
-        courseDeg -= 360;
-
-      // Calculate sector number for this node
-      int sectorNum = courseDeg / (360 / NUM_SECTORS);
-
-      int toNodeType = nearestStmt.value(TYPE).toInt();
-
-      TempNodeTo tmp = {toNodeId, toNodeType, toRangeMeter, distanceMeter, PRIORITY_BY_TYPE[toNodeType]};
-
-      bool reachable = fromRangeMeter + toRangeMeter > distanceMeter;
-
-      QVector<TempNodeTo>::iterator it;
-
-      if(reachable)
-      {
-        QVector<TempNodeTo>& sector = sectorsReachable[sectorNum];
-
-        // farthest at beginning of list
-        it = std::lower_bound(sector.begin(), sector.end(), tmp,
-                              [](const TempNodeTo& n1, const TempNodeTo& n2) -> bool
-              {
-                if(n1.priority == n2.priority)
-                  return n1.distance > n2.distance;
-                else
-                  return n1.priority > n2.priority;
-              });
-        sector.insert(it, tmp);
-      }
-      else
-      {
-        QVector<TempNodeTo>& sector = sectorsOther[sectorNum];
-
-        // nearest at beginning of list
-        it = std::lower_bound(sector.begin(), sector.end(), tmp,
-                              [](const TempNodeTo& n1, const TempNodeTo& n2) -> bool
-              {
-                if(n1.priority == n2.priority)
-                  return n1.distance < n2.distance;
-                else
-                  return n1.priority > n2.priority;
-              });
-        sector.insert(it, tmp);
-      }
+      QVector<TempNodeTo>& sector = sectorsReachable[sectorNum];
+
+      // farthest at beginning of list
+      it = std::lower_bound(sector.begin(), sector.end(), tmp,
+                            [](const TempNodeTo& n1, const TempNodeTo& n2) -> bool
+            {
+              if(n1.priority == n2.priority)
+                return n1.distance > n2.distance;
+              else
+                return n1.priority > n2.priority;
+            });
+      sector.insert(it, tmp);
+    }
+    else
+    {
+      QVector<TempNodeTo>& sector = sectorsOther[sectorNum];
+
+      // nearest at beginning of list
+      it = std::lower_bound(sector.begin(), sector.end(), tmp,
+                            [](const TempNodeTo& n1, const TempNodeTo& n2) -> bool
+            {
+              if(n1.priority == n2.priority)
+                return n1.distance < n2.distance;
+              else
+                return n1.priority > n2.priority;
+            });
+      sector.insert(it, tmp);
     }
   }
 
@@ -279,8 +275,8 @@ bool RouteEdgeWriter::nearest(SqlQuery& nearestStmt, int fromNodeId, const Pos&
   // Now check for each sector if conditions are met
   for(int sectorNum = 0; sectorNum < NUM_SECTORS; sectorNum++)
   {
-    const QVector<TempNodeTo>& sectorReachable = sectorsReachable.value(sectorNum);
-    const QVector<TempNodeTo>& sectorOther = sectorsOther.value(sectorNum);
+    const QVector<TempNodeTo>& sectorReachable = sectorsReachable.at(sectorNum);
+    const QVector<TempNodeTo>& sectorOther = sectorsOther.at(sectorNum);
     int numOtherEntries = std::min(sectorOther.size(), MAX_EDGES_PER_SECTOR);
     int numReachableEntries = std::min(sectorReachable.size(), MAX_EDGES_PER_SECTOR);
 
@@ -292,31 +288,19 @@ bool RouteEdgeWriter::nearest(SqlQuery& nearestStmt, int fromNodeId, const Pos&
     for(int i = 0; i < numReachableEntries; i++)
     {
       const TempNodeTo& tn = sectorReachable.at(i);
-      toNodeIds.append(tn.nodeId);
-      toNodeTypes.append(tn.type);
-      toNodeDistances.append(tn.distance);
+      edges.append({tn.nodeId, tn.type, tn.distance});
     }
 
     // Then add the unreachable
     for(int i = 0; i < numOtherEntries; i++)
     {
       const TempNodeTo& tn = sectorOther.at(i);
-      toNodeIds.append(tn.nodeId);
-      toNodeTypes.append(tn.type);
-      toNodeDistances.append(tn.distance);
+      edges.append({tn.nodeId, tn.type, tn.distance});
     }
   }
   return retval;
 }
 
-void RouteEdgeWriter::bindCoordinatePointInRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query)
-{
-  query->bindValue(LEFTX, rect.getWest());
-  query->bindValue(RIGHTX, rect.getEast());
-  query->bindValue(BOTTOMY, rect.getSouth());
-  query->bindValue(TOPY, rect.getNorth());
-}
-
 } // namespace writer
 } // namespace fs
 } // namespace atools
@@ -18,6 +18,8 @@
 #ifndef ATOOLS_ROUTEEDGEWRITER_H
 #define ATOOLS_ROUTEEDGEWRITER_H
 
+#include "geo/pos.h"
+
 #include <QVariantList>
 #include <QCoreApplication>
 
@@ -25,21 +27,44 @@ class QString;
 
 namespace atools {
 namespace geo {
-class Rect;
-class Pos;
+template<typename T>
+class SpatialIndex;
+class SpatialIndexBuffer;
 }
 namespace sql {
 class SqlDatabase;
-class SqlQuery;
 }
 
 namespace fs {
 class ProgressHandler;
 namespace db {
 
+/* Internal node and edge types for the edge writer */
+namespace internal {
+struct RadioNode
+{
+  int nodeId = -1, type = 0, range = 0;
+  atools::geo::Pos pos;
+
+  const atools::geo::Pos& getPosition() const
+  {
+    return pos;
+  }
+
+};
+
+struct RadioEdge
+{
+  int toNodeId, toNodeType, distance;
+};
+
+}
+
 /*
  * Creates a routing network from VOR and NDB stations that are reachable from each other.
  * Fills table route_edge_radio and reads from table route_node_radio.
+ *
+ * All nodes are loaded into a spatial index in memory and the nearest neighbours are calculated in parallel.
  */
 class RouteEdgeWriter
 {
@@ -57,11 +82,13 @@ public:
   void run();
 
 private:
-  void bindCoordinatePointInRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query);
-  bool nearest(atools::sql::SqlQuery& nearestStmt, int fromNodeId, const geo::Pos& pos,
-               const geo::Rect& queryRect,
-               int fromRangeMeter, QVariantList& toNodeIds, QVariantList& toNodeTypes,
-               QVariantList& toNodeDistances);
+  /* Get edges for a single node by increasing search radius until all sectors are filled. Thread safe. */
+  void edgesForNode(const atools::geo::SpatialIndex<internal::RadioNode>& index, int nodeIndex,
+                    QVector<internal::RadioEdge>& edges) const;
+
+  bool nearest(const atools::geo::SpatialIndex<internal::RadioNode>& index, const internal::RadioNode& from,
+               float radiusMeter, QVector<internal::RadioEdge>& edges, atools::geo::SpatialIndexBuffer& buffer,
+               QVector<int>& indexes) const;
 
   atools::sql::SqlDatabase *db;
 };
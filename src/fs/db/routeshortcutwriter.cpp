@@ -0,0 +1,249 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/db/routeshortcutwriter.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "atools.h"
+
+#include <QElapsedTimer>
+#include <QSet>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlQuery;
+
+namespace {
+
+/* Directed airway segment in the temporary graph */
+struct Segment
+{
+  int toId; /* Waypoint id of other end */
+  int airway; /* Index into list of combinations of airway name, airway type and route type */
+};
+
+typedef QHash<int, QVector<Segment> > SegmentHash;
+
+/* Stop following a chain after this number of segments to avoid endless loops */
+const int MAX_SEGMENTS = 10000;
+
+/* true if waypoint is connected to exactly two other waypoints by the same airway and every inbound segment
+ * continues on an outbound segment and vice versa. Shortcuts can pass through such a waypoint. */
+bool isChainWaypoint(const SegmentHash& outgoing, const SegmentHash& incoming, int waypointId)
+{
+  SegmentHash::const_iterator outIt = outgoing.constFind(waypointId), inIt = incoming.constFind(waypointId);
+  if(outIt == outgoing.constEnd() || inIt == incoming.constEnd())
+    // Start or end of a one-way airway
+    return false;
+
+  const QVector<Segment>& out = outIt.value();
+  const QVector<Segment>& in = inIt.value();
+  int airway = out.first().airway;
+
+  QSet<int> neighbours;
+  for(const Segment& segment : out)
+  {
+    if(segment.airway != airway)
+      return false;
+
+    neighbours.insert(segment.toId);
+  }
+
+  for(const Segment& segment : in)
+  {
+    if(segment.airway != airway)
+      return false;
+
+    neighbours.insert(segment.toId);
+  }
+
+  if(neighbours.size() != 2)
+    return false;
+
+  // Check if all segments pass through the waypoint
+  for(const Segment& o : out)
+  {
+    if(!std::any_of(in.begin(), in.end(), [&o](const Segment& i) -> bool {
+      return i.toId != o.toId;
+    }))
+      return false;
+  }
+
+  for(const Segment& i : in)
+  {
+    if(!std::any_of(out.begin(), out.end(), [&i](const Segment& o) -> bool {
+      return o.toId != i.toId;
+    }))
+      return false;
+  }
+
+  return true;
+}
+
+}
+
+RouteShortcutWriter::RouteShortcutWriter(atools::sql::SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+void RouteShortcutWriter::run()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Column indexes
+  enum
+  {
+    FROM,
+    TO,
+    NAME,
+    AIRWAY_TYPE,
+    DIRECTION,
+    ROUTE_TYPE
+  };
+
+  // Same selection as in RouteNetworkLoader::readEdgesAirway()
+  QString queryTxt("select from_waypoint_id, to_waypoint_id, airway_name, airway_type, direction, %1 from airway");
+  queryTxt = queryTxt.arg(db->record("airway").contains("route_type") ? "route_type" : "null as route_type");
+
+  // Read all airway segments into the directed graph keyed by waypoint id ==========================
+  SegmentHash outgoing, incoming;
+  QHash<QString, int> airwayIndexMap;
+  QStringList airwayNames;
+
+  SqlQuery query(queryTxt, db);
+  query.exec();
+  while(query.next())
+  {
+    QString name = query.valueStr(NAME);
+
+    // Edges are only combined if name and all types are equal
+    QString key = name + "|" + query.valueStr(AIRWAY_TYPE) + "|" + query.valueStr(ROUTE_TYPE);
+    int airway = airwayIndexMap.value(key, -1);
+    if(airway == -1)
+    {
+      airway = airwayNames.size();
+      airwayIndexMap.insert(key, airway);
+      airwayNames.append(name);
+    }
+
+    int fromId = query.valueInt(FROM);
+    int toId = query.valueInt(TO);
+    char dir = atools::strToChar(query.valueStr(DIRECTION));
+
+    if(dir == '\0' || dir == 'F' || dir == 'N')
+    {
+      // Forward or both directions allowed
+      outgoing[fromId].append({toId, airway});
+      incoming[toId].append({fromId, airway});
+    }
+
+    if(dir == '\0' || dir == 'B' || dir == 'N')
+    {
+      // Backward or both directions allowed
+      outgoing[toId].append({fromId, airway});
+      incoming[fromId].append({toId, airway});
+    }
+  }
+
+  // Find all waypoints which can be skipped ==========================
+  QSet<int> chainWaypoints;
+  for(SegmentHash::const_iterator it = outgoing.constBegin(); it != outgoing.constEnd(); ++it)
+  {
+    if(isChainWaypoint(outgoing, incoming, it.key()))
+      chainWaypoints.insert(it.key());
+  }
+
+  // Follow chains from all other waypoints ==========================
+  QVariantList fromIdVars, viaIdVars, toIdVars, numSegmentVars, nameVars;
+  int maxSegments = 0;
+  for(SegmentHash::const_iterator it = outgoing.constBegin(); it != outgoing.constEnd(); ++it)
+  {
+    int fromId = it.key();
+    if(chainWaypoints.contains(fromId))
+      continue;
+
+    for(const Segment& first : it.value())
+    {
+      if(!chainWaypoints.contains(first.toId))
+        continue;
+
+      int previous = fromId, current = first.toId, numSegments = 1;
+      while(chainWaypoints.contains(current) && numSegments < MAX_SEGMENTS)
+      {
+        // Continue on the segment leading away from the previous waypoint
+        int next = -1;
+        for(const Segment& segment : outgoing.value(current))
+        {
+          if(segment.toId != previous)
+          {
+            next = segment.toId;
+            break;
+          }
+        }
+
+        previous = current;
+        current = next;
+        numSegments++;
+      }
+
+      // Ignore loops back to start
+      if(current != -1 && current != fromId && !chainWaypoints.contains(current))
+      {
+        fromIdVars.append(fromId);
+        viaIdVars.append(first.toId);
+        toIdVars.append(current);
+        numSegmentVars.append(numSegments);
+        nameVars.append(airwayNames.at(first.airway));
+        maxSegments = std::max(maxSegments, numSegments);
+      }
+    }
+  }
+
+  // Clean the result table
+  SqlQuery stmt(db);
+  stmt.exec("delete from route_shortcut_airway");
+
+  if(!fromIdVars.isEmpty())
+  {
+    // Use batch update to insert values into shortcut table
+    SqlQuery insertQuery(db);
+    insertQuery.prepare("insert into route_shortcut_airway "
+                        "(from_waypoint_id, via_waypoint_id, to_waypoint_id, num_segments, airway_name) "
+                        "values(?, ?, ?, ?, ?)");
+    insertQuery.addBindValue(fromIdVars);
+    insertQuery.addBindValue(viaIdVars);
+    insertQuery.addBindValue(toIdVars);
+    insertQuery.addBindValue(numSegmentVars);
+    insertQuery.addBindValue(nameVars);
+    insertQuery.execBatch();
+  }
+
+  qDebug() << Q_FUNC_INFO << "shortcuts" << fromIdVars.size() << "skipped waypoints" << chainWaypoints.size()
+           << "max segments" << maxSegments << timer.elapsed() << "ms";
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
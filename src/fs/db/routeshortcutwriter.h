@@ -0,0 +1,61 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_ROUTESHORTCUTWRITER_H
+#define ATOOLS_ROUTESHORTCUTWRITER_H
+
+#include <QCoreApplication>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Creates shortcuts for airway routing and fills table route_shortcut_airway from table airway.
+ *
+ * A shortcut replaces a chain of segments of the same airway where all waypoints in between are not connected to any
+ * other airway. The route finder can skip these waypoints when searching in pure airway modes.
+ * Combined altitude restrictions and distances are calculated by atools::routing::RouteNetworkLoader which also
+ * drops shortcuts which pass through track waypoints.
+ */
+class RouteShortcutWriter
+{
+  Q_DECLARE_TR_FUNCTIONS(RouteShortcutWriter)
+
+public:
+  RouteShortcutWriter(atools::sql::SqlDatabase *sqlDb);
+
+  /*
+   * Run the process and fill the route_shortcut_airway table.
+   * Has to run after the airway table is complete and waypoint ids are assigned.
+   */
+  void run();
+
+private:
+  atools::sql::SqlDatabase *db;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_ROUTESHORTCUTWRITER_H
@@ -22,6 +22,9 @@
 #include "sql/sqlexception.h"
 
 #include <QDataStream>
+#include <QDebug>
+
+#include <algorithm>
 
 namespace atools {
 namespace fs {
@@ -30,16 +33,22 @@ namespace db {
 using atools::sql::SqlUtil;
 using atools::sql::SqlQuery;
 
+/* Default limit of bind variables per statement for SQLite versions before 3.32 */
+static const int SQLITE_MAX_VARIABLES = 999;
+
 WriterBaseBasic::WriterBaseBasic(atools::sql::SqlDatabase& sqlDb,
                                  DataWriter& writer,
                                  const QString& table,
                                  const QString& sqlParam)
-  : sqlQuery(sqlDb), tablename(table), db(sqlDb), dataWriter(writer)
+  : sqlQuery(sqlDb), tablename(table), batchQuery(sqlDb), db(sqlDb), dataWriter(writer)
 {
   if(sqlParam.isEmpty())
     sqlStatement = SqlUtil(&db).buildInsertStatement(tablename);
   else
+  {
     sqlStatement = sqlParam;
+    customStatement = true;
+  }
   sqlQuery = SqlQuery(db);
 
   sqlQuery.prepare(sqlStatement);
@@ -64,14 +73,19 @@ DbAirportIndex *WriterBaseBasic::getAirportIndex()
   return dataWriter.getAirportIndex();
 }
 
+DbSessionIndex *WriterBaseBasic::getSessionIndex()
+{
+  return dataWriter.getSessionIndex();
+}
+
 void WriterBaseBasic::bindBool(const QString& placeholder, bool val)
 {
-  return sqlQuery.bindValue(placeholder, val ? 1 : 0);
+  bindValue(placeholder, val ? 1 : 0);
 }
 
 void WriterBaseBasic::bind(const QString& placeholder, const QVariant& val)
 {
-  return sqlQuery.bindValue(placeholder, val);
+  bindValue(placeholder, val);
 }
 
 void WriterBaseBasic::bindIntOrNull(const QString& placeholder, const QVariant& val)
@@ -79,7 +93,7 @@ void WriterBaseBasic::bindIntOrNull(const QString& placeholder, const QVariant&
   if(val.toInt() == 0)
     bindNullInt(placeholder);
   else
-    return sqlQuery.bindValue(placeholder, val);
+    bindValue(placeholder, val);
 }
 
 void WriterBaseBasic::bindStrOrNull(const QString& placeholder, const QString& val)
@@ -87,26 +101,114 @@ void WriterBaseBasic::bindStrOrNull(const QString& placeholder, const QString& v
   if(val.isEmpty())
     bindNullString(placeholder);
   else
-    return sqlQuery.bindValue(placeholder, val);
+    bindValue(placeholder, val);
 }
 
 void WriterBaseBasic::bindNullInt(const QString& placeholder)
 {
-  return sqlQuery.bindValue(placeholder, QVariant(QVariant::Int));
+  bindValue(placeholder, QVariant(QVariant::Int));
 }
 
 void WriterBaseBasic::bindNullFloat(const QString& placeholder)
 {
-  return sqlQuery.bindValue(placeholder, QVariant(QVariant::Double));
+  bindValue(placeholder, QVariant(QVariant::Double));
 }
 
 void WriterBaseBasic::bindNullString(const QString& placeholder)
 {
-  return sqlQuery.bindValue(placeholder, QVariant(QVariant::String));
+  bindValue(placeholder, QVariant(QVariant::String));
+}
+
+void WriterBaseBasic::setBatchSize(int numRows)
+{
+  if(customStatement)
+  {
+    qWarning() << Q_FUNC_INFO << "Batching not possible for custom statement" << sqlStatement;
+    return;
+  }
+
+  flush();
+
+  columns = SqlUtil(&db).buildColumnList(tablename);
+  columnIndex.clear();
+  for(int i = 0; i < columns.size(); i++)
+    columnIndex.insert(":" + columns.at(i), i);
+
+  batchSize = std::max(1, std::min(numRows, SQLITE_MAX_VARIABLES / std::max(1, columns.size())));
+  currentRow.fill(QVariant(), columns.size());
+
+  if(batchSize > 1)
+    batchQuery.prepare(buildBatchStatement(batchSize));
+}
+
+QString WriterBaseBasic::buildBatchStatement(int numRows) const
+{
+  QStringList placeholders;
+  for(int i = 0; i < columns.size(); i++)
+    placeholders.append("?");
+  QString row = "(" + placeholders.join(", ") + ")";
+
+  QStringList rows;
+  for(int i = 0; i < numRows; i++)
+    rows.append(row);
+
+  return "insert into " + tablename + " (" + columns.join(", ") + ") values " + rows.join(", ");
+}
+
+void WriterBaseBasic::flush()
+{
+  if(numBatchRows == 0)
+    return;
+
+  SqlQuery partialQuery(db);
+  SqlQuery *query = &batchQuery;
+  if(numBatchRows < batchSize)
+  {
+    // Remaining rows
+    partialQuery.prepare(buildBatchStatement(numBatchRows));
+    query = &partialQuery;
+  }
+
+  for(int i = 0; i < batchValues.size(); i++)
+    query->bindValue(i, batchValues.at(i));
+  query->exec();
+
+  if(query->numRowsAffected() != numBatchRows)
+    throw atools::sql::SqlException(QString("Inserted %1 of %2 rows").
+                                    arg(query->numRowsAffected()).arg(numBatchRows), tablename);
+
+  batchValues.clear();
+  numBatchRows = 0;
+}
+
+void WriterBaseBasic::bindValue(const QString& placeholder, const QVariant& val)
+{
+  if(batchSize > 1)
+  {
+    int index = columnIndex.value(placeholder, -1);
+    if(index == -1)
+      throw atools::sql::SqlException("Unknown placeholder " + placeholder, tablename);
+
+    // Values stay bound for following rows like for a prepared query
+    currentRow[index] = val;
+  }
+  else
+    sqlQuery.bindValue(placeholder, val);
 }
 
 void WriterBaseBasic::executeStatement()
 {
+  if(batchSize > 1)
+  {
+    batchValues.append(currentRow);
+    numBatchRows++;
+    dataWriter.increaseNumObjects();
+
+    if(numBatchRows >= batchSize)
+      flush();
+    return;
+  }
+
   sqlQuery.exec();
   int numUpdated = sqlQuery.numRowsAffected();
   if(numUpdated == 0)
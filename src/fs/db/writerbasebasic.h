@@ -22,6 +22,8 @@
 #include "fs/bgl/bglposition.h"
 
 #include <QDataStream>
+#include <QHash>
+#include <QVector>
 
 namespace atools {
 namespace sql {
@@ -33,6 +35,7 @@ class NavDatabaseOptions;
 namespace db {
 class RunwayIndex;
 class DbAirportIndex;
+class DbSessionIndex;
 class DataWriter;
 
 /*
@@ -56,6 +59,16 @@ public:
 
   virtual ~WriterBaseBasic();
 
+  /*
+   * Buffer up to numRows rows and insert them with one multi row statement. 1 disables batching which is the default.
+   * Only possible for generated insert statements. Number is reduced to the limit of bind variables in SQLite.
+   * Buffered rows are not visible to queries before flush() is called.
+   */
+  void setBatchSize(int numRows);
+
+  /* Insert all buffered rows. Does nothing if batching is disabled. */
+  void flush();
+
 protected:
   atools::fs::db::DataWriter& getDataWriter()
   {
@@ -65,6 +78,7 @@ protected:
   const atools::fs::NavDatabaseOptions& getOptions();
   atools::fs::db::RunwayIndex *getRunwayIndex();
   atools::fs::db::DbAirportIndex *getAirportIndex();
+  atools::fs::db::DbSessionIndex *getSessionIndex();
 
   /*
    * Bind a value to the insert statement
@@ -95,8 +109,22 @@ protected:
   void executeStatement();
 
 private:
+  /* Binds to query or stores value in current row if batching */
+  void bindValue(const QString& placeholder, const QVariant& val);
+
+  /* Insert statement for number of rows using positional bindings */
+  QString buildBatchStatement(int numRows) const;
+
   atools::sql::SqlQuery sqlQuery; // Either custom query or generated insert statement
   QString sqlStatement, tablename;
+  bool customStatement = false;
+
+  /* Batching =============== */
+  atools::sql::SqlQuery batchQuery; // Prepared for batchSize rows
+  int batchSize = 1, numBatchRows = 0;
+  QStringList columns;
+  QHash<QString, int> columnIndex; // Maps placeholder with colon to column index
+  QVector<QVariant> currentRow, batchValues;
   atools::sql::SqlDatabase& db;
   atools::fs::db::DataWriter& dataWriter;
 
@@ -27,6 +27,7 @@
 #include "fs/util/tacanfrequencies.h"
 #include "sql/sqlscript.h"
 #include "sql/sqlquery.h"
+#include "sql/sqlcolumnindex.h"
 #include "fs/navdatabaseoptions.h"
 #include "fs/common/procedurewriter.h"
 #include "geo/calculations.h"
@@ -34,6 +35,8 @@
 #include "fs/common/airportindex.h"
 #include "fs/common/binarygeometry.h"
 #include "fs/common/morareader.h"
+#include "fs/common/globereader.h"
+#include "util/stringinterner.h"
 
 #include <QApplication>
 #include <QDataStream>
@@ -47,6 +50,7 @@ using atools::sql::SqlUtil;
 using atools::sql::SqlScript;
 using atools::sql::SqlRecordVector;
 using atools::sql::SqlRecord;
+using atools::sql::SqlColumnIndex;
 using atools::geo::Pos;
 using atools::geo::LineString;
 using atools::geo::DPos;
@@ -61,6 +65,71 @@ namespace ng {
 static const float ILS_FEATHER_LEN_NM = 9;
 static const float ILS_FEATHER_WIDTH = 4.f;
 
+/* Column ids for tbl_runways. Index in RUNWAY_COLUMNS. */
+enum RunwayColumn
+{
+  RW_AIRPORT_IDENTIFIER,
+  RW_RUNWAY_IDENTIFIER,
+  RW_RUNWAY_LATITUDE,
+  RW_RUNWAY_LONGITUDE,
+  RW_RUNWAY_TRUE_BEARING,
+  RW_LANDING_THRESHOLD_ELEVATION,
+  RW_DISPLACED_THRESHOLD_DISTANCE,
+  RW_RUNWAY_LENGTH,
+  RW_RUNWAY_WIDTH,
+  RW_LLZ_IDENTIFIER
+};
+
+static const QStringList RUNWAY_COLUMNS({
+  "airport_identifier", "runway_identifier", "runway_latitude", "runway_longitude", "runway_true_bearing",
+  "landing_threshold_elevation", "displaced_threshold_distance", "runway_length", "runway_width", "llz_identifier"
+});
+
+/* Column ids for tbl_iaps, tbl_sids and tbl_stars. Index in PROCEDURE_COLUMNS. */
+enum ProcedureColumn
+{
+  PROC_AIRPORT_IDENTIFIER,
+  PROC_AREA_CODE,
+  PROC_PROCEDURE_IDENTIFIER,
+  PROC_TRANSITION_IDENTIFIER,
+  PROC_SEQNO,
+  PROC_ROUTE_TYPE,
+  PROC_WAYPOINT_IDENTIFIER,
+  PROC_WAYPOINT_ICAO_CODE,
+  PROC_WAYPOINT_DESCRIPTION_CODE,
+  PROC_WAYPOINT_LONGITUDE,
+  PROC_WAYPOINT_LATITUDE,
+  PROC_TURN_DIRECTION,
+  PROC_PATH_TERMINATION,
+  PROC_RECOMMANDED_NAVAID,
+  PROC_RECOMMANDED_NAVAID_LONGITUDE,
+  PROC_RECOMMANDED_NAVAID_LATITUDE,
+  PROC_THETA,
+  PROC_RHO,
+  PROC_MAGNETIC_COURSE,
+  PROC_ROUTE_DISTANCE_HOLDING_DISTANCE_TIME,
+  PROC_DISTANCE_TIME, /* Not available in older databases */
+  PROC_ALTITUDE_DESCRIPTION,
+  PROC_ALTITUDE1,
+  PROC_ALTITUDE2,
+  PROC_TRANSITION_ALTITUDE,
+  PROC_SPEED_LIMIT_DESCRIPTION,
+  PROC_SPEED_LIMIT,
+  PROC_CENTER_WAYPOINT,
+  PROC_CENTER_WAYPOINT_LONGITUDE,
+  PROC_CENTER_WAYPOINT_LATITUDE
+};
+
+static const QStringList PROCEDURE_COLUMNS({
+  "airport_identifier", "area_code", "procedure_identifier", "transition_identifier", "seqno", "route_type",
+  "waypoint_identifier", "waypoint_icao_code", "waypoint_description_code", "waypoint_longitude",
+  "waypoint_latitude", "turn_direction", "path_termination", "recommanded_navaid", "recommanded_navaid_longitude",
+  "recommanded_navaid_latitude", "theta", "rho", "magnetic_course", "route_distance_holding_distance_time",
+  "distance_time", "altitude_description", "altitude1", "altitude2", "transition_altitude",
+  "speed_limit_description", "speed_limit", "center_waypoint", "center_waypoint_longitude",
+  "center_waypoint_latitude"
+});
+
 DfdCompiler::DfdCompiler(sql::SqlDatabase& sqlDb, const NavDatabaseOptions& opts,
                          ProgressHandler *progressHandler, NavDatabaseErrors *navdatabaseErrors)
   : options(opts), db(sqlDb), progress(progressHandler), errors(navdatabaseErrors)
@@ -145,7 +214,7 @@ void DfdCompiler::writeAirports()
     airportRectMap.insert(ident, airportRect);
 
     // Needed later for workaround for number or runways with certain surfaces
-    longestRunwaySurfaceMap.insert(ident, airportQuery->valueStr("longest_runway_surface_code"));
+    longestRunwaySurfaceMap.insert(ident, atools::util::intern(airportQuery->valueStr("longest_runway_surface_code")));
 
     airportWriteQuery->bindValue(":airport_id", ++curAirportId);
 
@@ -160,8 +229,8 @@ void DfdCompiler::writeAirports()
       airportWriteQuery->bindValue(":iata", iata);
 
     airportWriteQuery->bindValue(":name", utl::capAirportName(airportQuery->valueStr("airport_name")));
-    airportWriteQuery->bindValue(":country", airportQuery->valueStr("area_code"));
-    airportWriteQuery->bindValue(":region", airportQuery->valueStr("icao_code"));
+    airportWriteQuery->bindValue(":country", atools::util::intern(airportQuery->valueStr("area_code")));
+    airportWriteQuery->bindValue(":region", atools::util::intern(airportQuery->valueStr("icao_code")));
     airportWriteQuery->bindValue(":is_military", utl::isNameMilitary(airportQuery->valueStr("airport_name")));
 
     // Will be extended later when reading runways
@@ -189,25 +258,29 @@ void DfdCompiler::writeRunways()
 
   runwayQuery->exec();
 
+  // Records copied from the query have the same layout
+  SqlColumnIndex cols(RUNWAY_COLUMNS);
+  cols.resolve(*runwayQuery);
+
   SqlRecordVector runways;
   QString lastApt;
   while(runwayQuery->next())
   {
-    QString apt = runwayQuery->valueStr("airport_identifier");
+    QString apt = cols.valueStr(*runwayQuery, RW_AIRPORT_IDENTIFIER);
 
     if(!lastApt.isEmpty() && lastApt != apt)
       // Airport ID has changed write collected runways
-      writeRunwaysForAirport(runways, lastApt);
+      writeRunwaysForAirport(runways, lastApt, cols);
 
     // Collect runways
     runways.append(runwayQuery->record());
     lastApt = apt;
   }
-  writeRunwaysForAirport(runways, lastApt);
+  writeRunwaysForAirport(runways, lastApt, cols);
   db.commit();
 }
 
-void DfdCompiler::writeRunwaysForAirport(SqlRecordVector& runways, const QString& apt)
+void DfdCompiler::writeRunwaysForAirport(SqlRecordVector& runways, const QString& apt, const SqlColumnIndex& cols)
 {
   QVector<std::pair<SqlRecord, SqlRecord> > runwaypairs;
 
@@ -229,7 +302,7 @@ void DfdCompiler::writeRunwaysForAirport(SqlRecordVector& runways, const QString
   // llz_mls_gls_category
 
   // Find matching opposing ends in the list
-  pairRunways(runwaypairs, runways);
+  pairRunways(runwaypairs, runways, cols);
 
   int numRunways = 0, numRunwayIls = 0, longestRunwayLength = 0, longestRunwayWidth = 0;
   float longestRunwayHeading = 0.f;
@@ -244,28 +317,30 @@ void DfdCompiler::writeRunwaysForAirport(SqlRecordVector& runways, const QString
     // Generate new end ids here
     int primaryEndId = ++curRunwayEndId, secondaryEndId = ++curRunwayEndId;
 
-    int length = primaryRec.valueInt("runway_length");
-    int width = primaryRec.valueInt("runway_width");
+    int length = cols.valueInt(primaryRec, RW_RUNWAY_LENGTH);
+    int width = cols.valueInt(primaryRec, RW_RUNWAY_WIDTH);
 
     // Use average threshold elevation for runway elevation
-    int alt = (primaryRec.valueInt("landing_threshold_elevation") +
-               secondaryRec.valueInt("landing_threshold_elevation")) / 2;
+    int alt = (cols.valueInt(primaryRec, RW_LANDING_THRESHOLD_ELEVATION) +
+               cols.valueInt(secondaryRec, RW_LANDING_THRESHOLD_ELEVATION)) / 2;
 
     // Get primary and secondary end coordinates
-    Pos primaryPos(primaryRec.valueFloat("runway_longitude"), primaryRec.valueFloat("runway_latitude"));
-    Pos secondaryPos(secondaryRec.valueFloat("runway_longitude"), secondaryRec.valueFloat("runway_latitude"));
+    Pos primaryPos(cols.valueFloat(primaryRec, RW_RUNWAY_LONGITUDE),
+                   cols.valueFloat(primaryRec, RW_RUNWAY_LATITUDE));
+    Pos secondaryPos(cols.valueFloat(secondaryRec, RW_RUNWAY_LONGITUDE),
+                     cols.valueFloat(secondaryRec, RW_RUNWAY_LATITUDE));
 
     // Calculate center point
     Pos centerPos = primaryPos.interpolate(secondaryPos, 0.5f);
 
-    float heading = primaryRec.valueFloat("runway_true_bearing");
-    float opposedHeading = secondaryRec.valueFloat("runway_true_bearing");
+    float heading = cols.valueFloat(primaryRec, RW_RUNWAY_TRUE_BEARING);
+    float opposedHeading = cols.valueFloat(secondaryRec, RW_RUNWAY_TRUE_BEARING);
 
     // qDebug() << apt << primaryEndId << p.valueStr("runway_identifier")
     // << secondaryEndId << s.valueStr("runway_identifier");
 
     // Count ILS
-    if(primaryRec.valueStr("llz_identifier").isEmpty())
+    if(cols.valueStr(primaryRec, RW_LLZ_IDENTIFIER).isEmpty())
       numRunwayIls++;
 
     // Remember the longest data
@@ -305,9 +380,9 @@ void DfdCompiler::writeRunwaysForAirport(SqlRecordVector& runways, const QString
 
     // Write the primary end =======================================
     runwayEndWriteQuery->bindValue(":runway_end_id", primaryEndId);
-    runwayEndWriteQuery->bindValue(":name", primaryRec.valueStr("runway_identifier").mid(2));
+    runwayEndWriteQuery->bindValue(":name", cols.valueStr(primaryRec, RW_RUNWAY_IDENTIFIER).mid(2));
     runwayEndWriteQuery->bindValue(":end_type", "P");
-    runwayEndWriteQuery->bindValue(":offset_threshold", primaryRec.valueInt("displaced_threshold_distance"));
+    runwayEndWriteQuery->bindValue(":offset_threshold", cols.valueInt(primaryRec, RW_DISPLACED_THRESHOLD_DISTANCE));
     runwayEndWriteQuery->bindValue(":blast_pad", 0);
     runwayEndWriteQuery->bindValue(":overrun", 0);
     runwayEndWriteQuery->bindValue(":has_closed_markings", 0);
@@ -319,18 +394,19 @@ void DfdCompiler::writeRunwaysForAirport(SqlRecordVector& runways, const QString
     runwayEndWriteQuery->bindValue(":has_reils", 0);
     runwayEndWriteQuery->bindValue(":has_touchdown_lights", 0);
     runwayEndWriteQuery->bindValue(":num_strobes", 0);
-    runwayEndWriteQuery->bindValue(":ils_ident", primaryRec.valueStr("llz_identifier"));
+    runwayEndWriteQuery->bindValue(":ils_ident", cols.valueStr(primaryRec, RW_LLZ_IDENTIFIER));
     runwayEndWriteQuery->bindValue(":heading", heading);
-    runwayEndWriteQuery->bindValue(":altitude", primaryRec.valueInt("landing_threshold_elevation"));
+    runwayEndWriteQuery->bindValue(":altitude", cols.valueInt(primaryRec, RW_LANDING_THRESHOLD_ELEVATION));
     runwayEndWriteQuery->bindValue(":lonx", primaryPos.getLonX());
     runwayEndWriteQuery->bindValue(":laty", primaryPos.getLatY());
     runwayEndWriteQuery->exec();
 
     // Write the secondary end =======================================
     runwayEndWriteQuery->bindValue(":runway_end_id", secondaryEndId);
-    runwayEndWriteQuery->bindValue(":name", secondaryRec.valueStr("runway_identifier").mid(2));
+    runwayEndWriteQuery->bindValue(":name", cols.valueStr(secondaryRec, RW_RUNWAY_IDENTIFIER).mid(2));
     runwayEndWriteQuery->bindValue(":end_type", "S");
-    runwayEndWriteQuery->bindValue(":offset_threshold", secondaryRec.valueInt("displaced_threshold_distance"));
+    runwayEndWriteQuery->bindValue(":offset_threshold",
+                                   cols.valueInt(secondaryRec, RW_DISPLACED_THRESHOLD_DISTANCE));
     runwayEndWriteQuery->bindValue(":blast_pad", 0);
     runwayEndWriteQuery->bindValue(":overrun", 0);
     runwayEndWriteQuery->bindValue(":has_closed_markings", 0);
@@ -342,9 +418,9 @@ void DfdCompiler::writeRunwaysForAirport(SqlRecordVector& runways, const QString
     runwayEndWriteQuery->bindValue(":has_reils", 0);
     runwayEndWriteQuery->bindValue(":has_touchdown_lights", 0);
     runwayEndWriteQuery->bindValue(":num_strobes", 0);
-    runwayEndWriteQuery->bindValue(":ils_ident", secondaryRec.valueStr("llz_identifier"));
+    runwayEndWriteQuery->bindValue(":ils_ident", cols.valueStr(secondaryRec, RW_LLZ_IDENTIFIER));
     runwayEndWriteQuery->bindValue(":heading", opposedHeading);
-    runwayEndWriteQuery->bindValue(":altitude", secondaryRec.valueInt("landing_threshold_elevation"));
+    runwayEndWriteQuery->bindValue(":altitude", cols.valueInt(secondaryRec, RW_LANDING_THRESHOLD_ELEVATION));
     runwayEndWriteQuery->bindValue(":lonx", secondaryPos.getLonX());
     runwayEndWriteQuery->bindValue(":laty", secondaryPos.getLatY());
     runwayEndWriteQuery->exec();
@@ -391,15 +467,15 @@ void DfdCompiler::writeRunwaysForAirport(SqlRecordVector& runways, const QString
 }
 
 void DfdCompiler::pairRunways(QVector<std::pair<SqlRecord, SqlRecord> >& runwaypairs,
-                              const SqlRecordVector& runways)
+                              const SqlRecordVector& runways, const SqlColumnIndex& cols)
 {
   // Go through the list of runways and find matching runway ends like 9R / 27L
   QSet<QString> found;
   for(const SqlRecord& rw : runways)
   {
-    float heading = rw.valueFloat("runway_true_bearing");
+    float heading = cols.valueFloat(rw, RW_RUNWAY_TRUE_BEARING);
     float opposedHeading = atools::geo::opposedCourseDeg(heading);
-    QString rwident = rw.valueStr("runway_identifier");
+    QString rwident = cols.valueStr(rw, RW_RUNWAY_IDENTIFIER);
 
     if(found.contains(rwident))
       // Already worked on that runway end
@@ -432,7 +508,7 @@ void DfdCompiler::pairRunways(QVector<std::pair<SqlRecord, SqlRecord> >& runwayp
     bool foundEnd = false;
     for(const SqlRecord& opposed : runways)
     {
-      if(opposed.valueStr("runway_identifier") == opposedRname)
+      if(cols.valueStr(opposed, RW_RUNWAY_IDENTIFIER) == opposedRname)
       {
         // Remember that we already worked on this
         found.insert(opposedRname);
@@ -499,12 +575,43 @@ void DfdCompiler::writeAirspaces()
   if(rec.contains("time_code"))
     newCols.append("time_code");
 
-  SqlQuery controlled("select "
+  SqlQuery controlled(db);
+  controlled.setForwardOnly(true);
+  controlled.prepare("select "
+                     "icao_code, "
+                     "airspace_center, "
+                     "controlled_airspace_name as name, "
+                     "airspace_type as type, "
+                     "airspace_classification, " +
+                     (newCols.isEmpty() ? QString() : (newCols.join(", ") + ", ")) +
+                     "seqno, "
+                     "boundary_via, "
+                     "flightlevel, "
+                     "latitude, "
+                     "longitude, " +
+                     arcCols +
+                     "unit_indicator_lower_limit, "
+                     "lower_limit, "
+                     "unit_indicator_upper_limit, "
+                     "upper_limit "
+                     "from src.tbl_controlled_airspace");
+  writeAirspace(controlled, &DfdCompiler::beginControlledAirspace);
+
+  // Restricted airspaces =================================================================
+  rec = db.record("src.tbl_restrictive_airspace");
+  newCols.clear();
+  if(rec.contains("multiple_code"))
+    newCols.append("multiple_code");
+  if(rec.contains("time_code"))
+    newCols.append("time_code");
+
+  SqlQuery restrictive(db);
+  restrictive.setForwardOnly(true);
+  restrictive.prepare("select "
                       "icao_code, "
-                      "airspace_center, "
-                      "controlled_airspace_name as name, "
-                      "airspace_type as type, "
-                      "airspace_classification, " +
+                      "restrictive_airspace_designation, "
+                      "restrictive_airspace_name as name, "
+                      "restrictive_type as type, " +
                       (newCols.isEmpty() ? QString() : (newCols.join(", ") + ", ")) +
                       "seqno, "
                       "boundary_via, "
@@ -516,34 +623,7 @@ void DfdCompiler::writeAirspaces()
                       "lower_limit, "
                       "unit_indicator_upper_limit, "
                       "upper_limit "
-                      "from src.tbl_controlled_airspace", db);
-  writeAirspace(controlled, &DfdCompiler::beginControlledAirspace);
-
-  // Restricted airspaces =================================================================
-  rec = db.record("src.tbl_restrictive_airspace");
-  newCols.clear();
-  if(rec.contains("multiple_code"))
-    newCols.append("multiple_code");
-  if(rec.contains("time_code"))
-    newCols.append("time_code");
-
-  SqlQuery restrictive("select "
-                       "icao_code, "
-                       "restrictive_airspace_designation, "
-                       "restrictive_airspace_name as name, "
-                       "restrictive_type as type, " +
-                       (newCols.isEmpty() ? QString() : (newCols.join(", ") + ", ")) +
-                       "seqno, "
-                       "boundary_via, "
-                       "flightlevel, "
-                       "latitude, "
-                       "longitude, " +
-                       arcCols +
-                       "unit_indicator_lower_limit, "
-                       "lower_limit, "
-                       "unit_indicator_upper_limit, "
-                       "upper_limit "
-                       "from src.tbl_restrictive_airspace", db);
+                      "from src.tbl_restrictive_airspace");
   writeAirspace(restrictive, &DfdCompiler::beginRestrictiveAirspace);
 
   // FIR / UIR regions =================================================================
@@ -551,53 +631,61 @@ void DfdCompiler::writeAirspaces()
                      "fir_uir_latitude as latitude, fir_uir_longitude as longitude, " + arcCols);
 
   // FIR ===========================
-  SqlQuery fir("select "
-               + firUirCols +
-               "fir_uir_indicator, "
-               "'M' as unit_indicator_lower_limit, "
-               "0 as lower_limit, "
-               "'M' as unit_indicator_upper_limit, "
-               "fir_upper_limit as upper_limit "
-               "from src.tbl_fir_uir where fir_uir_indicator = 'F'", db);
+  SqlQuery fir(db);
+  fir.setForwardOnly(true);
+  fir.prepare("select "
+              + firUirCols +
+              "fir_uir_indicator, "
+              "'M' as unit_indicator_lower_limit, "
+              "0 as lower_limit, "
+              "'M' as unit_indicator_upper_limit, "
+              "fir_upper_limit as upper_limit "
+              "from src.tbl_fir_uir where fir_uir_indicator = 'F'");
   writeAirspace(fir, &DfdCompiler::beginFirUirAirspaceCenter); // Old center
   writeAirspace(fir, &DfdCompiler::beginFirUirAirspaceNew); // new FIR/UIR type
 
   // UIR ===========================
-  SqlQuery uir("select "
-               + firUirCols +
-               "fir_uir_indicator, "
-               "'M' as unit_indicator_lower_limit, "
-               "uir_lower_limit as lower_limit, "
-               "'M' as unit_indicator_upper_limit, "
-               "uir_upper_limit as upper_limit "
-               "from src.tbl_fir_uir where fir_uir_indicator = 'U'", db);
+  SqlQuery uir(db);
+  uir.setForwardOnly(true);
+  uir.prepare("select "
+              + firUirCols +
+              "fir_uir_indicator, "
+              "'M' as unit_indicator_lower_limit, "
+              "uir_lower_limit as lower_limit, "
+              "'M' as unit_indicator_upper_limit, "
+              "uir_upper_limit as upper_limit "
+              "from src.tbl_fir_uir where fir_uir_indicator = 'U'");
   writeAirspace(uir, &DfdCompiler::beginFirUirAirspaceCenter); // Old center
   writeAirspace(uir, &DfdCompiler::beginFirUirAirspaceNew); // new FIR/UIR type
 
   // ==================================================================================================
   // Split all regions with attribute both into one FIR and one UIR record for old centers
   // FIR from regions with attribute both ===========================
-  SqlQuery fir2("select "
-                + firUirCols +
-                "'F' as fir_uir_indicator, "
-                "'M' as unit_indicator_lower_limit, "
-                "0 as lower_limit, "
-                "'M' as unit_indicator_upper_limit, "
-                "fir_upper_limit as upper_limit "
-                "from src.tbl_fir_uir where fir_uir_indicator = 'B'", db);
+  SqlQuery fir2(db);
+  fir2.setForwardOnly(true);
+  fir2.prepare("select "
+               + firUirCols +
+               "'F' as fir_uir_indicator, "
+               "'M' as unit_indicator_lower_limit, "
+               "0 as lower_limit, "
+               "'M' as unit_indicator_upper_limit, "
+               "fir_upper_limit as upper_limit "
+               "from src.tbl_fir_uir where fir_uir_indicator = 'B'");
   writeAirspace(fir2, &DfdCompiler::beginFirUirAirspaceCenter); // Old center
   writeAirspace(fir2, &DfdCompiler::beginFirUirAirspaceNew); // new FIR/UIR type
 
   // UIR from regions with attribute both ===========================
-  SqlQuery uir2("select "
-                + firUirCols +
-                "'U' as fir_uir_indicator, "
-                "fir_uir_indicator, "
-                "'M' as unit_indicator_lower_limit, "
-                "uir_lower_limit as lower_limit, "
-                "'M' as unit_indicator_upper_limit, "
-                "uir_upper_limit as upper_limit "
-                "from src.tbl_fir_uir where fir_uir_indicator = 'B'", db);
+  SqlQuery uir2(db);
+  uir2.setForwardOnly(true);
+  uir2.prepare("select "
+               + firUirCols +
+               "'U' as fir_uir_indicator, "
+               "fir_uir_indicator, "
+               "'M' as unit_indicator_lower_limit, "
+               "uir_lower_limit as lower_limit, "
+               "'M' as unit_indicator_upper_limit, "
+               "uir_upper_limit as upper_limit "
+               "from src.tbl_fir_uir where fir_uir_indicator = 'B'");
   writeAirspace(uir2, &DfdCompiler::beginFirUirAirspaceCenter); // Old center
   writeAirspace(uir2, &DfdCompiler::beginFirUirAirspaceNew); // new FIR/UIR type
 
@@ -615,7 +703,9 @@ void DfdCompiler::writeAirspaceCom()
                               "where boundary_id = :id");
 
   // Select COM joined with FIR/UIR regions.
-  SqlQuery comQuery(
+  SqlQuery comQuery(db);
+  comQuery.setForwardOnly(true);
+  comQuery.prepare(
     "select a.area_code, a.fir_uir_identifier, a.fir_uir_indicator, c.remote_name as name, "
     "min(c.communication_frequency) as frequency "
     "from tbl_fir_uir a join tbl_enroute_communication c on "
@@ -629,7 +719,7 @@ void DfdCompiler::writeAirspaceCom()
     "  frequency_units = 'V' and "
     // Do not include secondary frequencies
     "  (service_indicator is null or substr(service_indicator, 2,1) <> 'S') "
-    "group by a.area_code, a.fir_uir_identifier, a.fir_uir_indicator, c.remote_name", db);
+    "group by a.area_code, a.fir_uir_identifier, a.fir_uir_indicator, c.remote_name");
 
   comQuery.exec();
   while(comQuery.next())
@@ -724,7 +814,8 @@ void DfdCompiler::writeAirspaceGeometry(atools::sql::SqlQuery& query)
 {
   Pos pos(query.valueFloat("longitude"), query.valueFloat("latitude"));
   Pos center(query.valueFloat("arc_origin_longitude"), query.valueFloat("arc_origin_latitude"));
-  airspaceSegments.append({pos, center, query.valueStr("boundary_via"), query.valueFloat("arc_distance")});
+  airspaceSegments.append({pos, center, atools::util::intern(query.valueStr("boundary_via")),
+                           query.valueFloat("arc_distance")});
 }
 
 void DfdCompiler::beginControlledAirspace(atools::sql::SqlQuery& query)
@@ -973,7 +1064,9 @@ void DfdCompiler::writeAirways()
     "  a.waypoint_identifier = w.ident and a.icao_code = w.region and a.waypoint_longitude = w.lonx and "
     "  a.waypoint_latitude = w.laty "
     "order by route_identifier, seqno");
-  SqlQuery airways(query, db);
+  SqlQuery airways(db);
+  airways.setForwardOnly(true);
+  airways.prepare(query);
 
   // Insert into airway and let SQLite autogenerate an ID
   SqlQuery insert(db);
@@ -1101,12 +1194,14 @@ void DfdCompiler::writeMora()
 
   int carryover = 0;
   int lastpos = -1;
+  bool found = false;
   moraQuery->exec();
   // The Grid MORA Table will contain records describing the MORA for each Latitude and Longitude block.
   // Each record will contain thirty blocks and the “Starting Latitude” field defines the
   // lower left corner for the first block of each record.
   while(moraQuery->next())
   {
+    found = true;
     int startLatY = moraQuery->valueInt("starting_latitude"); // 89 to -90
     int startLonX = moraQuery->valueInt("starting_longitude"); // -180 to -150
 
@@ -1170,6 +1265,20 @@ void DfdCompiler::writeMora()
 #endif
 
   MoraReader morareader(db);
+  const QString& globePath = options.getGlobeDataPath();
+  if(!found && !globePath.isEmpty() && atools::fs::common::GlobeReader::isDirValid(globePath))
+  {
+    // Source has no grid MORA - calculate from elevation data
+    atools::fs::common::GlobeReader globeReader(globePath);
+    if(globeReader.openFiles())
+    {
+      qInfo() << Q_FUNC_INFO << "No MORA in source. Calculating from GLOBE data in" << globePath;
+      morareader.writeFromGlobe(globeReader);
+      db.commit();
+      return;
+    }
+  }
+
   morareader.writeToTable(grid, 360, 180);
   db.commit();
 }
@@ -1177,11 +1286,17 @@ void DfdCompiler::writeMora()
 void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode)
 {
   // Get procedures ordered from the table
-  SqlQuery query(SqlUtil(db).buildSelectStatement(table) +
-                 // " where airport_identifier in ('CYBK') "
-                 // "and procedure_identifier = 'R34'"
-                 " order by airport_identifier, procedure_identifier, route_type, transition_identifier, seqno ", db);
+  SqlQuery query(db);
+  query.setForwardOnly(true);
+  query.prepare(SqlUtil(db).buildSelectStatement(table) +
+                // " where airport_identifier in ('CYBK') "
+                // "and procedure_identifier = 'R34'"
+                " order by airport_identifier, procedure_identifier, route_type, transition_identifier, seqno ");
   query.exec();
+
+  SqlColumnIndex cols(PROCEDURE_COLUMNS);
+  cols.resolve(query);
+
   atools::fs::common::ProcedureInput procInput;
 
   QString curAirport;
@@ -1189,8 +1304,8 @@ void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode)
   int num = 0;
   while(query.next())
   {
-    QString airportIdent = query.valueStr("airport_identifier");
-    if(query.valueStr("area_code") == "CTL")
+    QString airportIdent = cols.valueStr(query, PROC_AIRPORT_IDENTIFIER);
+    if(cols.valueStr(query, PROC_AREA_CODE) == "CTL")
       // Ignore artificial circle-to-land duplicates
       continue;
 
@@ -1213,15 +1328,15 @@ void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode)
     // Fill context for error reporting
     procInput.context = QString("File %1, airport %2, procedure %3, transition %4").
                         arg(db.databaseName()).
-                        arg(query.valueStr("airport_identifier")).
-                        arg(query.valueStr("procedure_identifier")).
-                        arg(query.valueStr("transition_identifier"));
+                        arg(cols.valueStr(query, PROC_AIRPORT_IDENTIFIER)).
+                        arg(cols.valueStr(query, PROC_PROCEDURE_IDENTIFIER)).
+                        arg(cols.valueStr(query, PROC_TRANSITION_IDENTIFIER));
 
     procInput.airportIdent = airportIdent;
     procInput.airportId = airportIndex->getAirportId(airportIdent).toInt();
 
     // Fill data for procedure writer
-    fillProcedureInput(procInput, query);
+    fillProcedureInput(procInput, query, cols);
 
     // Leave the complicated states to the procedure writer
     procWriter->write(procInput);
@@ -1232,45 +1347,47 @@ void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode)
   procWriter->reset();
 }
 
-void DfdCompiler::fillProcedureInput(atools::fs::common::ProcedureInput& procInput, const atools::sql::SqlQuery& query)
+void DfdCompiler::fillProcedureInput(atools::fs::common::ProcedureInput& procInput, const atools::sql::SqlQuery& query,
+                                     const SqlColumnIndex& cols)
 {
-  procInput.seqNr = query.valueInt("seqno");
-  procInput.routeType = atools::strToChar(query.valueStr("route_type"));
-  procInput.sidStarAppIdent = query.valueStr("procedure_identifier");
-  procInput.transIdent = query.valueStr("transition_identifier");
-  procInput.fixIdent = query.valueStr("waypoint_identifier").trimmed();
-  procInput.region = query.valueStr("waypoint_icao_code").trimmed();
+  procInput.seqNr = cols.valueInt(query, PROC_SEQNO);
+  procInput.routeType = atools::strToChar(cols.valueStr(query, PROC_ROUTE_TYPE));
+  procInput.sidStarAppIdent = cols.valueStr(query, PROC_PROCEDURE_IDENTIFIER);
+  procInput.transIdent = cols.valueStr(query, PROC_TRANSITION_IDENTIFIER);
+  procInput.fixIdent = cols.valueStr(query, PROC_WAYPOINT_IDENTIFIER).trimmed();
+  procInput.region = cols.valueStr(query, PROC_WAYPOINT_ICAO_CODE).trimmed();
   // procInput.secCode = query.valueStr(""); // Not available
   // procInput.subCode = query.valueStr(""); // Not available
-  procInput.descCode = query.valueStr("waypoint_description_code");
+  procInput.descCode = cols.valueStr(query, PROC_WAYPOINT_DESCRIPTION_CODE);
 
-  if(!query.isNull("waypoint_longitude") && !query.isNull("waypoint_latitude"))
-    procInput.waypointPos = DPos(query.valueDouble("waypoint_longitude"), query.valueDouble("waypoint_latitude"));
+  if(!cols.isNull(query, PROC_WAYPOINT_LONGITUDE) && !cols.isNull(query, PROC_WAYPOINT_LATITUDE))
+    procInput.waypointPos = DPos(cols.valueDouble(query, PROC_WAYPOINT_LONGITUDE),
+                                 cols.valueDouble(query, PROC_WAYPOINT_LATITUDE));
   else
     procInput.waypointPos = DPos();
 
-  procInput.turnDir = query.valueStr("turn_direction");
-  procInput.pathTerm = query.valueStr("path_termination");
-  procInput.recdNavaid = query.valueStr("recommanded_navaid").trimmed();
+  procInput.turnDir = cols.valueStr(query, PROC_TURN_DIRECTION);
+  procInput.pathTerm = cols.valueStr(query, PROC_PATH_TERMINATION);
+  procInput.recdNavaid = cols.valueStr(query, PROC_RECOMMANDED_NAVAID).trimmed();
   // procInput.recdIcaoCode = query.valueStr(""); // Not available
   // procInput.recdSecCode = query.valueStr("");  // Not available
   // procInput.recdSubCode = query.valueStr("");  // Not available
 
-  if(!query.isNull("recommanded_navaid_longitude") && !query.isNull("recommanded_navaid_latitude"))
-    procInput.recdWaypointPos = DPos(query.valueDouble("recommanded_navaid_longitude"),
-                                     query.valueDouble("recommanded_navaid_latitude"));
+  if(!cols.isNull(query, PROC_RECOMMANDED_NAVAID_LONGITUDE) && !cols.isNull(query, PROC_RECOMMANDED_NAVAID_LATITUDE))
+    procInput.recdWaypointPos = DPos(cols.valueDouble(query, PROC_RECOMMANDED_NAVAID_LONGITUDE),
+                                     cols.valueDouble(query, PROC_RECOMMANDED_NAVAID_LATITUDE));
   else
     procInput.recdWaypointPos = DPos();
 
-  procInput.theta = query.valueFloat("theta");
-  procInput.rho = query.valueFloat("rho");
-  procInput.magCourse = query.valueFloat("magnetic_course");
+  procInput.theta = cols.valueFloat(query, PROC_THETA);
+  procInput.rho = cols.valueFloat(query, PROC_RHO);
+  procInput.magCourse = cols.valueFloat(query, PROC_MAGNETIC_COURSE);
 
-  float distTime = query.valueFloat("route_distance_holding_distance_time");
+  float distTime = cols.valueFloat(query, PROC_ROUTE_DISTANCE_HOLDING_DISTANCE_TIME);
   procInput.rteHoldTime = procInput.rteHoldDist = 0.f;
   if(procInput.pathTerm.startsWith("H"))
   {
-    QString distTimeFlag = query.valueStr("distance_time", QString()).trimmed().toUpper();
+    QString distTimeFlag = cols.valueStr(query, PROC_DISTANCE_TIME, QString()).trimmed().toUpper();
     if(distTimeFlag == "D")
       procInput.rteHoldDist = distTime;
     else if(distTimeFlag == "T")
@@ -1287,21 +1404,21 @@ void DfdCompiler::fillProcedureInput(atools::fs::common::ProcedureInput& procInp
   else
     procInput.rteHoldDist = distTime;
 
-  procInput.altDescr = query.valueStr("altitude_description");
-  procInput.altitude = query.valueStr("altitude1");
-  procInput.altitude2 = query.valueStr("altitude2");
-  procInput.transAlt = query.valueStr("transition_altitude");
-  procInput.speedLimitDescr = query.valueStr("speed_limit_description");
-  procInput.speedLimit = query.valueInt("speed_limit");
+  procInput.altDescr = cols.valueStr(query, PROC_ALTITUDE_DESCRIPTION);
+  procInput.altitude = cols.valueStr(query, PROC_ALTITUDE1);
+  procInput.altitude2 = cols.valueStr(query, PROC_ALTITUDE2);
+  procInput.transAlt = cols.valueStr(query, PROC_TRANSITION_ALTITUDE);
+  procInput.speedLimitDescr = cols.valueStr(query, PROC_SPEED_LIMIT_DESCRIPTION);
+  procInput.speedLimit = cols.valueInt(query, PROC_SPEED_LIMIT);
 
-  procInput.centerFixOrTaaPt = query.valueStr("center_waypoint");
+  procInput.centerFixOrTaaPt = cols.valueStr(query, PROC_CENTER_WAYPOINT);
   // procInput.centerIcaoCode = query.valueStr(""); // Not available
   // procInput.centerSecCode = query.valueStr("");  // Not available
   // procInput.centerSubCode = query.valueStr("");  // Not available
 
-  if(!query.isNull("center_waypoint_longitude") && !query.isNull("center_waypoint_latitude"))
-    procInput.centerPos = DPos(query.valueDouble("center_waypoint_longitude"),
-                               query.valueDouble("center_waypoint_latitude"));
+  if(!cols.isNull(query, PROC_CENTER_WAYPOINT_LONGITUDE) && !cols.isNull(query, PROC_CENTER_WAYPOINT_LATITUDE))
+    procInput.centerPos = DPos(cols.valueDouble(query, PROC_CENTER_WAYPOINT_LONGITUDE),
+                               cols.valueDouble(query, PROC_CENTER_WAYPOINT_LATITUDE));
   else
     procInput.centerPos = DPos();
 
@@ -1338,7 +1455,11 @@ void DfdCompiler::readHeader()
 
 void DfdCompiler::compileMagDeclBgl()
 {
-  magDecReader->readFromWmm();
+  if(options.getSharedMagDecReader() != nullptr)
+    // Calculated only once for all compilations
+    magDecReader->readFromReader(*options.getSharedMagDecReader());
+  else
+    magDecReader->readFromWmm();
   magDecReader->writeToTable(db);
   db.commit();
 }
@@ -1438,8 +1559,10 @@ void DfdCompiler::updateTreeLetterAirportCodes()
   }
 
   QHash<QString, QString> codeMap;
-  SqlQuery codeQuery("select airport_identifier, airport_identifier_3letter "
-                     "from src.tbl_airports where airport_identifier_3letter is not null", db);
+  SqlQuery codeQuery(db);
+  codeQuery.setForwardOnly(true);
+  codeQuery.prepare("select airport_identifier, airport_identifier_3letter "
+                    "from src.tbl_airports where airport_identifier_3letter is not null");
   codeQuery.exec();
   while(codeQuery.next())
     codeMap.insert(codeQuery.valueStr("airport_identifier"), codeQuery.valueStr("airport_identifier_3letter"));
@@ -1484,7 +1607,9 @@ void DfdCompiler::initQueries()
   if(metadataWriter != nullptr)
     metadataWriter->initQueries();
 
+  // Source queries are forward only to avoid caching all rows read which keeps memory usage flat
   airportQuery = new SqlQuery(db);
+  airportQuery->setForwardOnly(true);
   airportQuery->prepare("select * from src.tbl_airports order by airport_identifier");
 
   airportWriteQuery = new SqlQuery(db);
@@ -1502,6 +1627,7 @@ void DfdCompiler::initQueries()
   airportFileWriteQuery->prepare(QString("insert into airport_file (file_id, ident) values(%1, :ident)").arg(FILE_ID));
 
   runwayQuery = new SqlQuery(db);
+  runwayQuery->setForwardOnly(true);
   runwayQuery->prepare("select * from src.tbl_runways order by icao_code, airport_identifier, runway_identifier");
 
   runwayWriteQuery = new SqlQuery(db);
@@ -1530,6 +1656,7 @@ void DfdCompiler::initQueries()
                               "bottom_laty = :bottom_laty where airport_id = :aptid");
 
   metadataQuery = new SqlQuery(db);
+  metadataQuery->setForwardOnly(true);
   metadataQuery->prepare(SqlUtil(db).buildSelectStatement("src.tbl_header"));
 
   airspaceWriteQuery = new SqlQuery(db);
@@ -1538,6 +1665,7 @@ void DfdCompiler::initQueries()
         }));
 
   moraQuery = new SqlQuery(db);
+  moraQuery->setForwardOnly(true);
   moraQuery->prepare("select * from src.tbl_grid_mora order by rowid");
 }
 
@@ -28,6 +28,7 @@ namespace sql {
 class SqlDatabase;
 class SqlQuery;
 class SqlRecord;
+class SqlColumnIndex;
 typedef QVector<atools::sql::SqlRecord> SqlRecordVector;
 }
 namespace fs {
@@ -130,14 +131,16 @@ public:
 
 private:
   /* Write all collected runways for an airport */
-  void writeRunwaysForAirport(sql::SqlRecordVector& runways, const QString& apt);
+  void writeRunwaysForAirport(sql::SqlRecordVector& runways, const QString& apt,
+                              const atools::sql::SqlColumnIndex& cols);
 
   /* Match opposing runway ends */
   void pairRunways(QVector<std::pair<atools::sql::SqlRecord, atools::sql::SqlRecord> >& runwaypairs,
-                   const sql::SqlRecordVector& runways);
+                   const sql::SqlRecordVector& runways, const atools::sql::SqlColumnIndex& cols);
 
   /* Fill input structure for ProcedureWriter */
-  void fillProcedureInput(atools::fs::common::ProcedureInput& procInput, const atools::sql::SqlQuery& query);
+  void fillProcedureInput(atools::fs::common::ProcedureInput& procInput, const atools::sql::SqlQuery& query,
+                          const atools::sql::SqlColumnIndex& cols);
 
   /* Write on procedure type - SID, STAR, approaches */
   void writeProcedure(const QString& table, const QString& rowCode);
@@ -19,9 +19,14 @@
 
 #include "settings/settings.h"
 #include "atools.h"
+#include "util/parallel.h"
+#include "util/taskscheduler.h"
+#include "util/trace.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QHash>
+#include <QMutex>
 #include <QDir>
 #include <QStandardPaths>
 #include <QDataStream>
@@ -42,6 +47,13 @@ static QHash<atools::fs::FsPaths::SimulatorType, QString> basePathMap;
 static QHash<atools::fs::FsPaths::SimulatorType, QString> filesPathMap;
 static QHash<atools::fs::FsPaths::SimulatorType, QString> sceneryFilepathMap;
 
+/* Guards the path maps and the loading state below */
+static QMutex pathMutex;
+static bool pathsLoaded = false;
+
+/* Pending loadAllPathsBackground() task. Invalid if not running. */
+static atools::util::TaskHandle pathsLoadTask;
+
 /* All supported simulators */
 static const QVector<atools::fs::FsPaths::SimulatorType> ALL_SIMULATOR_TYPES(
     {
@@ -83,6 +95,7 @@ static const QHash<atools::fs::FsPaths::SimulatorType, QString> ALL_SIMULATOR_NA
     }
   );
 
+/* Written by the MSFS probe in initBasePath() */
 static QString msfsOfficialPath, msfsCommunityPath, msfsSimPath;
 
 /* Platform: FSX, FSX XPack, FSX Gold */
@@ -134,6 +147,9 @@ using atools::settings::Settings;
 
 void FsPaths::logAllPaths()
 {
+  waitForPaths();
+  QMutexLocker locker(&pathMutex);
+
   qDebug() << Q_FUNC_INFO << "====================================================";
 
   // C:\ProgramData
@@ -180,43 +196,116 @@ void FsPaths::logAllPaths()
 
 void FsPaths::loadAllPaths()
 {
-  qDebug() << Q_FUNC_INFO;
+  // Wait for a running background task to avoid loading twice
+  atools::util::TaskHandle task;
+  {
+    QMutexLocker locker(&pathMutex);
+    task = pathsLoadTask;
+  }
+  if(task.isValid())
+    task.wait();
+
+  loadAllPathsInternal();
+}
+
+void FsPaths::loadAllPathsBackground()
+{
+  QMutexLocker locker(&pathMutex);
+  if(!pathsLoadTask.isValid())
+    pathsLoadTask = atools::util::TaskScheduler::instance().run([]() {
+          loadAllPathsInternal();
+
+          QMutexLocker taskLocker(&pathMutex);
+          pathsLoadTask = atools::util::TaskHandle();
+        });
+}
+
+void FsPaths::waitForPaths()
+{
+  atools::util::TaskHandle task;
+  {
+    QMutexLocker locker(&pathMutex);
+    if(pathsLoaded)
+      return;
+    task = pathsLoadTask;
+  }
+
+  if(task.isValid())
+    task.wait();
+  else
+    loadAllPathsInternal();
+}
+
+void FsPaths::loadAllPathsInternal()
+{
+  ATOOLS_TRACE_SCOPE("FsPaths::loadAllPaths", "startup");
+  QElapsedTimer timer;
+  timer.start();
 
+  // Registry and file system access for each simulator is independent and can be slow on network drives
+  struct Paths
+  {
+    QString base, files, scenery;
+  };
+  QVector<Paths> paths(ALL_SIMULATOR_TYPES.size());
+
+  atools::util::parallelFor(ALL_SIMULATOR_TYPES.size(), [&paths](int i) {
+        SimulatorType type = ALL_SIMULATOR_TYPES.at(i);
+        Paths& p = paths[i];
+        p.base = QDir::toNativeSeparators(initBasePath(type));
+        p.files = QDir::toNativeSeparators(initFilesPath(type, p.base));
+        p.scenery = QDir::toNativeSeparators(initSceneryLibraryPath(type, p.base));
+      });
+
+  QMutexLocker locker(&pathMutex);
   basePathMap.clear();
   filesPathMap.clear();
   sceneryFilepathMap.clear();
 
-  for(atools::fs::FsPaths::SimulatorType type : ALL_SIMULATOR_TYPES)
+  for(int i = 0; i < ALL_SIMULATOR_TYPES.size(); i++)
   {
-    basePathMap.insert(type, QDir::toNativeSeparators(initBasePath(type)));
-    filesPathMap.insert(type, QDir::toNativeSeparators(initFilesPath(type)));
-    sceneryFilepathMap.insert(type, QDir::toNativeSeparators(initSceneryLibraryPath(type)));
+    SimulatorType type = ALL_SIMULATOR_TYPES.at(i);
+    basePathMap.insert(type, paths.at(i).base);
+    filesPathMap.insert(type, paths.at(i).files);
+    sceneryFilepathMap.insert(type, paths.at(i).scenery);
   }
+  pathsLoaded = true;
+
+  qDebug() << Q_FUNC_INFO << "Loaded paths in" << timer.elapsed() << "ms";
 }
 
 void FsPaths::intitialize()
 {
+  ATOOLS_TRACE_SCOPE("FsPaths::intitialize", "startup");
   qRegisterMetaTypeStreamOperators<atools::fs::FsPaths::SimulatorType>();
   environment = QProcessEnvironment::systemEnvironment();
 }
 
 QString FsPaths::getBasePath(FsPaths::SimulatorType type)
 {
+  waitForPaths();
+  QMutexLocker locker(&pathMutex);
   return basePathMap.value(type);
 }
 
 QString FsPaths::getFilesPath(FsPaths::SimulatorType type)
 {
+  waitForPaths();
+  QMutexLocker locker(&pathMutex);
   return filesPathMap.value(type);
 }
 
 QString FsPaths::getSceneryLibraryPath(FsPaths::SimulatorType type)
 {
+  waitForPaths();
+  QMutexLocker locker(&pathMutex);
   return sceneryFilepathMap.value(type);
 }
 
 QString FsPaths::getMsfsOfficialPath()
 {
+  waitForPaths();
+  QMutexLocker locker(&pathMutex);
   return msfsOfficialPath;
 }
 
@@ -232,6 +321,8 @@ QString FsPaths::getMsfsOfficialPath(const QString& basePath)
 
 QString FsPaths::getMsfsCommunityPath()
 {
+  waitForPaths();
+  QMutexLocker locker(&pathMutex);
   return msfsCommunityPath;
 }
 
@@ -402,6 +493,10 @@ QString FsPaths::initBasePath(SimulatorType type)
 
 QString FsPaths::nonWindowsPathFull(atools::fs::FsPaths::SimulatorType type)
 {
+  // Settings are not thread safe and simulators are probed in parallel
+  static QMutex settingsMutex;
+  QMutexLocker locker(&settingsMutex);
+
   QString fsPath;
   // from the configuration file
   Settings& s = Settings::instance();
@@ -437,7 +532,7 @@ bool FsPaths::hasAnyMsSimulator()
 {
   for(atools::fs::FsPaths::SimulatorType type : ALL_SIMULATOR_TYPES_MS)
   {
-    if(!basePathMap.value(type).isEmpty())
+    if(!getBasePath(type).isEmpty())
       return true;
   }
   return false;
@@ -445,17 +540,17 @@ bool FsPaths::hasAnyMsSimulator()
 
 bool FsPaths::hasXplaneSimulator()
 {
-  return !basePathMap.value(XPLANE11).isEmpty();
+  return !getBasePath(XPLANE11).isEmpty();
 }
 
-QString FsPaths::initFilesPath(SimulatorType type)
+QString FsPaths::initFilesPath(SimulatorType type, const QString& basePath)
 {
   QString fsFilesDir;
 
   switch(type)
   {
     case atools::fs::FsPaths::XPLANE11:
-      fsFilesDir = atools::buildPathNoCase({getBasePath(type), "Output", "FMS Plans"});
+      fsFilesDir = atools::buildPathNoCase({basePath, "Output", "FMS Plans"});
       break;
 
     case atools::fs::FsPaths::MSFS:
@@ -475,7 +570,7 @@ QString FsPaths::initFilesPath(SimulatorType type)
     case atools::fs::FsPaths::P3D_V5:
 #if defined(Q_OS_WIN32)
       {
-        QString languageDll(getBasePath(type) + SEP + "language.dll");
+        QString languageDll(basePath + SEP + "language.dll");
         qDebug() << "Language DLL" << languageDll;
 
         // Copy to wchar and append null
@@ -529,8 +624,10 @@ QString FsPaths::initFilesPath(SimulatorType type)
   return fsFilesDir;
 }
 
-QString FsPaths::initSceneryLibraryPath(SimulatorType type)
+QString FsPaths::initSceneryLibraryPath(SimulatorType type, const QString& basePath)
 {
+  Q_UNUSED(basePath)
+
 #if defined(Q_OS_WIN32)
   // Win 7+ C:\ProgramData
   QString programData(environment.value("PROGRAMDATA"));
@@ -553,7 +650,7 @@ QString FsPaths::initSceneryLibraryPath(SimulatorType type)
       return programData + SEP + "Microsoft\\FSX\\Scenery.CFG";
 
 #elif defined(DEBUG_FS_PATHS)
-      return getBasePath(type) + SEP + "scenery.cfg";
+      return basePath + SEP + "scenery.cfg";
 
 #endif
 
@@ -563,7 +660,7 @@ QString FsPaths::initSceneryLibraryPath(SimulatorType type)
       return programData + SEP + "Microsoft\\FSX-SE\\Scenery.CFG";
 
 #elif defined(DEBUG_FS_PATHS)
-      return getBasePath(type) + SEP + "scenery.cfg";
+      return basePath + SEP + "scenery.cfg";
 
 #endif
 
@@ -573,7 +670,7 @@ QString FsPaths::initSceneryLibraryPath(SimulatorType type)
       return appData + SEP + "Lockheed Martin\\Prepar3D v2\\Scenery.CFG";
 
 #elif defined(DEBUG_FS_PATHS)
-      return getBasePath(type) + SEP + "scenery.cfg";
+      return basePath + SEP + "scenery.cfg";
 
 #endif
 
@@ -583,7 +680,7 @@ QString FsPaths::initSceneryLibraryPath(SimulatorType type)
       return programData + SEP + "Lockheed Martin\\Prepar3D v3\\Scenery.CFG";
 
 #elif defined(DEBUG_FS_PATHS)
-      return getBasePath(type) + SEP + "scenery.cfg";
+      return basePath + SEP + "scenery.cfg";
 
 #endif
 
@@ -593,7 +690,7 @@ QString FsPaths::initSceneryLibraryPath(SimulatorType type)
       return programData + SEP + "Lockheed Martin\\Prepar3D v4\\Scenery.CFG";
 
 #elif defined(DEBUG_FS_PATHS)
-      return getBasePath(type) + SEP + "scenery.cfg";
+      return basePath + SEP + "scenery.cfg";
 
 #endif
 
@@ -603,7 +700,7 @@ QString FsPaths::initSceneryLibraryPath(SimulatorType type)
       return programData + SEP + "Lockheed Martin\\Prepar3D v5\\Scenery.CFG";
 
 #elif defined(DEBUG_FS_PATHS)
-      return getBasePath(type) + SEP + "scenery.cfg";
+      return basePath + SEP + "scenery.cfg";
 
 #endif
 
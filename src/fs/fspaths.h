@@ -37,9 +37,14 @@ public:
   /* Print paths for all simulators to the info log channel */
   static void logAllPaths();
 
-  /* Load and cache all paths */
+  /* Load and cache all paths. Simulators are probed in parallel. Returns when all paths are loaded. */
   static void loadAllPaths();
 
+  /* Start loading all paths in the background and return immediately. All methods returning paths or
+   * checking for simulators wait until loading is done. Paths are loaded on first access if neither
+   * this nor loadAllPaths() was called. */
+  static void loadAllPathsBackground();
+
   /* Register types and load process environment */
   static void intitialize();
 
@@ -137,10 +142,16 @@ private:
 
   /* Get full path to language dependent "Flight Simulator X Files" or "Flight Simulator X-Dateien",
    * etc. Returns the documents path if FS files cannot be found. */
-  static QString initFilesPath(atools::fs::FsPaths::SimulatorType type);
+  static QString initFilesPath(atools::fs::FsPaths::SimulatorType type, const QString& basePath);
 
   /* Path to scenery.cfg for FSX/P3D or Content.xml for MSFS. Empty for X-Plane. */
-  static QString initSceneryLibraryPath(atools::fs::FsPaths::SimulatorType type);
+  static QString initSceneryLibraryPath(atools::fs::FsPaths::SimulatorType type, const QString& basePath);
+
+  /* Probe all paths and replace the cached ones */
+  static void loadAllPathsInternal();
+
+  /* Wait for the background loading or load paths if not done yet */
+  static void waitForPaths();
 
   static QString settingsKey(atools::fs::FsPaths::SimulatorType type);
   static QString registryPath(atools::fs::FsPaths::SimulatorType type);
@@ -18,6 +18,7 @@
 #include "fs/navdatabase.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlscript.h"
+#include "sql/sqlfulltextindex.h"
 #include "fs/db/datawriter.h"
 #include "sql/sqlutil.h"
 #include "sql/sqltransaction.h"
@@ -25,23 +26,40 @@
 #include "fs/scenery/addoncfg.h"
 #include "fs/db/airwayresolver.h"
 #include "fs/db/routeedgewriter.h"
+#include "fs/db/proceduregeometrywriter.h"
+#include "fs/db/routeshortcutwriter.h"
 #include "fs/progresshandler.h"
 #include "fs/scenery/fileresolver.h"
 #include "fs/scenery/addonpackage.h"
 #include "fs/xp/xpdatacompiler.h"
 #include "fs/dfd/dfdcompiler.h"
 #include "fs/db/databasemeta.h"
+#include "fs/common/globereader.h"
+#include "fs/common/morareader.h"
 #include "atools.h"
 #include "exception.h"
 #include "fs/scenery/layoutjson.h"
 #include "fs/scenery/manifestjson.h"
 #include "fs/scenery/languagejson.h"
 #include "fs/scenery/materiallib.h"
-
+#include "util/parallel.h"
+#include "util/stringinterner.h"
+#include "sql/sqlconnectionpool.h"
+#include "sql/sqlitecompressedvfs.h"
+#include "util/trace.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
 #include <QElapsedTimer>
+#include <QJsonDocument>
 #include <QProcessEnvironment>
 #include <QStandardPaths>
+#include <QThread>
+
+#include <exception>
+#include <functional>
+#include <tuple>
 
 namespace atools {
 namespace fs {
@@ -63,10 +81,25 @@ static const int PROGRESS_NUM_SCHEMA_STEPS = 8;
 
 const static QChar SEP(QDir::separator());
 
+// Indexes which are needed by the delete processor and compilers while loading.
+// All other secondary indexes are created after loading if bulk compile is enabled.
+static const QStringList LOAD_INDEXES({"idx_airport_ident", "idx_waypoint_airport_id", "idx_vor_airport_id",
+                                       "idx_ndb_airport_id", "idx_com_airport_id", "idx_start_airport_id",
+                                       "idx_apron_airport_id", "idx_taxi_path_airport_id", "idx_runway_airport_id",
+                                       "idx_approach_airport_id", "idx_approach_runway_end_id",
+                                       "idx_transition_approach_id", "idx_approach_leg_approach_id",
+                                       "idx_transition_leg_transition_id", "idx_parking_airport_id"});
+
+// Fast but unsafe settings for bulk compilation. Current values are saved and restored afterwards.
+static const QStringList BULK_PRAGMAS({"PRAGMA journal_mode=OFF", "PRAGMA synchronous=OFF",
+                                       "PRAGMA cache_size=-262144", "PRAGMA temp_store=MEMORY",
+                                       "PRAGMA locking_mode=EXCLUSIVE"});
+
 using atools::sql::SqlScript;
 using atools::sql::SqlQuery;
 using atools::sql::SqlUtil;
 using atools::sql::SqlTransaction;
+using atools::sql::SqlFullTextIndex;
 using atools::fs::scenery::SceneryCfg;
 using atools::fs::scenery::AddOnCfg;
 using atools::fs::scenery::AddOnCfgEntry;
@@ -75,6 +108,90 @@ using atools::fs::scenery::AddOnComponent;
 using atools::fs::scenery::AddOnPackage;
 using atools::buildPathNoCase;
 
+namespace {
+
+/* MSFS package directory and its parsed JSON files */
+struct MsfsPackage
+{
+  MsfsPackage()
+  {
+  }
+
+  MsfsPackage(const QString& pathParam, const QString& nameParam)
+    : path(pathParam), name(nameParam)
+  {
+  }
+
+  QString path, name;
+  atools::fs::scenery::ManifestJson manifest;
+  atools::fs::scenery::LayoutJson layout;
+};
+
+/* Independent report or validation query writing to out */
+typedef std::function<void (atools::sql::SqlDatabase *db, QDebug& out)> ReportJob;
+
+/* Run jobs in parallel on read-only connections if possible and print their output in job order.
+ * Rethrows the first exception after all jobs are done. */
+void runReportJobs(atools::sql::SqlDatabase *db, const QVector<ReportJob>& jobs, QDebug& out)
+{
+  bool parallel = jobs.size() > 1 && db->driverName() == "QSQLITE" && QFileInfo(db->databaseName()).isFile();
+
+  if(parallel)
+  {
+    // Other connections cannot read while this one holds an exclusive lock
+    SqlQuery query("PRAGMA locking_mode", db);
+    query.exec();
+    if(query.next() && query.valueStr(0).compare("exclusive", Qt::CaseInsensitive) == 0)
+      parallel = false;
+  }
+
+  if(!parallel)
+  {
+    for(const ReportJob& job : jobs)
+      job(db, out);
+    return;
+  }
+
+  int size = std::min(jobs.size(), std::max(1, QThread::idealThreadCount()));
+  atools::sql::SqlConnectionPool connectionPool(db->databaseName(), "navdb_report", size);
+  QVector<QString> outputs(jobs.size());
+  QVector<std::exception_ptr> exceptions(jobs.size());
+
+  // Detach before accessing from threads
+  QString *outputData = outputs.data();
+  std::exception_ptr *exceptionData = exceptions.data();
+
+  atools::util::parallelFor(jobs.size(), [&](int i) {
+    try
+    {
+      atools::sql::SqlConnectionLease lease(connectionPool);
+
+      // Stream has to be flushed before the connection is released
+      QDebug jobOut(&outputData[i]);
+      jobs.at(i)(lease.db(), jobOut);
+    }
+    catch(...)
+    {
+      exceptionData[i] = std::current_exception();
+    }
+  });
+
+  {
+    QDebugStateSaver saver(out);
+    out.noquote().nospace();
+    for(const QString& output : outputs)
+      out << output << endl;
+  }
+
+  for(const std::exception_ptr& exception : exceptions)
+  {
+    if(exception)
+      std::rethrow_exception(exception);
+  }
+}
+
+} // namespace
+
 NavDatabase::NavDatabase(const NavDatabaseOptions *readerOptions, sql::SqlDatabase *sqlDb,
                          NavDatabaseErrors *databaseErrors, const QString& revision)
   : db(sqlDb), errors(databaseErrors), options(readerOptions), gitRevision(revision)
@@ -87,10 +204,19 @@ void NavDatabase::create(const QString& codec)
   if(options != nullptr)
     qDebug() << Q_FUNC_INFO << *options;
 
-  createInternal(codec);
-  if(aborted)
-    // Remove all (partial) changes
-    db->rollback();
+  try
+  {
+    createInternal(codec);
+    if(aborted)
+      // Remove all (partial) changes
+      db->rollback();
+  }
+  catch(...)
+  {
+    restorePragmas();
+    throw;
+  }
+  restorePragmas();
 }
 
 void NavDatabase::createAirspaceSchema()
@@ -161,6 +287,10 @@ void NavDatabase::createSchemaInternal(ProgressHandler *progress)
     if((aborted = progress->reportOther(tr("Creating Database Schema"))))
       return;
 
+  // Collect indexes not needed for loading if bulk compiling
+  deferredIndexes.clear();
+  script.setDeferIndexes(progress != nullptr && options != nullptr && options->isBulkCompile(), LOAD_INDEXES);
+
   script.executeScript(":/atools/resources/sql/fs/db/create_boundary_schema.sql");
   script.executeScript(":/atools/resources/sql/fs/db/create_nav_schema.sql");
   script.executeScript(":/atools/resources/sql/fs/db/create_ap_schema.sql");
@@ -169,6 +299,9 @@ void NavDatabase::createSchemaInternal(ProgressHandler *progress)
   script.executeScript(":/atools/resources/sql/fs/db/create_meta_schema.sql");
   script.executeScript(":/atools/resources/sql/fs/db/create_views.sql");
   transaction.commit();
+
+  deferredIndexes = script.getDeferredStatements();
+  qDebug() << Q_FUNC_INFO << "Deferred indexes" << deferredIndexes.size();
 }
 
 bool NavDatabase::isSceneryConfigValid(const QString& filename, const QString& codec, QStringList& errors)
@@ -290,19 +423,31 @@ int NavDatabase::countXplaneSteps()
     total += PROGRESS_NUM_TASK_STEPS; // "Clean up"
   total += PROGRESS_NUM_TASK_STEPS; // "Preparing Airways"
   total++; // "Post procecssing Airways" (XpDataCompiler)
+  if(isGlobeMora())
+    total++; // "Calculating MORA"
   if(options->isResolveAirways())
     total += PROGRESS_NUM_RESOLVE_AIRWAY_STEPS; // "Creating airways"
   total += PROGRESS_NUM_TASK_STEPS; // "Updating waypoints"
   total += PROGRESS_NUM_TASK_STEPS; // "Updating approaches"
   total += PROGRESS_NUM_TASK_STEPS; // "Updating Airports"
   total += PROGRESS_NUM_TASK_STEPS; // "Updating ILS Count"
+  if(options->isProcedureGeometry())
+    total++; // "Calculating procedure geometry"
   total += PROGRESS_NUM_TASK_STEPS; // "Collecting navaids for search"
+  if(options->isCreateRouteShortcuts())
+    total++; // "Creating airway shortcuts"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for airport"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for search"
+  if(options->isSpatialIndex())
+    total += PROGRESS_NUM_TASK_STEPS; // "Creating spatial indexes"
+  if(options->isFullTextIndex())
+    total += PROGRESS_NUM_TASK_STEPS; // "Creating full text indexes"
   if(options->isVacuumDatabase())
     total += PROGRESS_NUM_TASK_STEPS; // "Vacuum Database"
   if(options->isAnalyzeDatabase())
     total += PROGRESS_NUM_TASK_STEPS; // "Analyze Database"
+  if(!options->getCompressedDatabaseFile().isEmpty())
+    total += PROGRESS_NUM_TASK_STEPS; // "Compressing Database"
 
   // Not used in production
   // if(options->isDatabaseReport())
@@ -401,6 +546,8 @@ int NavDatabase::countDfdSteps()
   total += PROGRESS_NUM_TASK_STEPS; // "Updating Airports"
   total += PROGRESS_NUM_TASK_STEPS; // "Updating ILS"
   total += PROGRESS_NUM_TASK_STEPS; // "Updating ILS Count"
+  if(options->isProcedureGeometry())
+    total++; // "Calculating procedure geometry"
   total += PROGRESS_NUM_TASK_STEPS; // "Collecting navaids for search"
 
   if(options->isCreateRouteTables())
@@ -409,9 +556,15 @@ int NavDatabase::countDfdSteps()
     total += PROGRESS_NUM_TASK_STEPS; // "Creating route edges for VOR and NDB"
     total += PROGRESS_NUM_TASK_STEPS; // "Creating route edges waypoints"
   }
+  if(options->isCreateRouteShortcuts())
+    total++; // "Creating airway shortcuts"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for airport"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for search"
   total++; // "Creating indexes for route"
+  if(options->isSpatialIndex())
+    total += PROGRESS_NUM_TASK_STEPS; // "Creating spatial indexes"
+  if(options->isFullTextIndex())
+    total += PROGRESS_NUM_TASK_STEPS; // "Creating full text indexes"
   if(options->isDatabaseReport())
     // "Basic Validation"
     // "Creating table statistics" "Creating report on values" "Creating report on duplicates"
@@ -432,6 +585,10 @@ int NavDatabase::countDfdSteps()
   if(options->isAnalyzeDatabase())
     total += PROGRESS_NUM_TASK_STEPS;
 
+  // "Compressing Database"
+  if(!options->getCompressedDatabaseFile().isEmpty())
+    total += PROGRESS_NUM_TASK_STEPS;
+
   total += 4; // Correction value
 
   return total;
@@ -506,6 +663,8 @@ int NavDatabase::countMsfsSteps(const SceneryCfg& cfg)
 int NavDatabase::countMsSimSteps()
 {
   int total = 0;
+  if(isGlobeMora())
+    total++; // "Calculating MORA"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating boundary indexes"
   if(options->isDeduplicate())
@@ -518,14 +677,24 @@ int NavDatabase::countMsSimSteps()
   total += PROGRESS_NUM_TASK_STEPS; // "Updating Airports"
   total += PROGRESS_NUM_TASK_STEPS; // "Updating ILS"
   total += PROGRESS_NUM_TASK_STEPS; // "Updating ILS Count"
+  if(options->isProcedureGeometry())
+    total++; // "Calculating procedure geometry"
   total += PROGRESS_NUM_TASK_STEPS; // "Collecting navaids for search"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for airport"
   total += PROGRESS_NUM_TASK_STEPS; // "Clean up runways"
   total += PROGRESS_NUM_TASK_STEPS; // "Creating indexes for search"
+  if(options->isCreateRouteShortcuts())
+    total++; // "Creating airway shortcuts"
+  if(options->isSpatialIndex())
+    total += PROGRESS_NUM_TASK_STEPS; // "Creating spatial indexes"
+  if(options->isFullTextIndex())
+    total += PROGRESS_NUM_TASK_STEPS; // "Creating full text indexes"
   if(options->isVacuumDatabase())
     total += PROGRESS_NUM_TASK_STEPS; // "Vacuum Database"
   if(options->isAnalyzeDatabase())
     total += PROGRESS_NUM_TASK_STEPS; // "Analyze Database"
+  if(!options->getCompressedDatabaseFile().isEmpty())
+    total += PROGRESS_NUM_TASK_STEPS; // "Compressing Database"
 
   // Not used in production
   // if(options->isDatabaseReport())
@@ -535,6 +704,8 @@ int NavDatabase::countMsSimSteps()
 
 void NavDatabase::createInternal(const QString& sceneryConfigCodec)
 {
+  ATOOLS_TRACE_SCOPE("NavDatabase::createInternal", "navdatabase");
+
   SceneryCfg sceneryCfg(sceneryConfigCodec);
 
   QElapsedTimer timer;
@@ -542,6 +713,10 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
 
   FsPaths::SimulatorType sim = options->getSimulatorType();
 
+  // Read directories again for each compilation to detect changes
+  directoryCache.clear();
+  sceneryFiles.clear();
+
   if(options->isAutocommit())
     db->setAutocommit(true);
 
@@ -570,10 +745,43 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   ProgressHandler progress(options);
   progress.setTotal(total);
 
+  // Count all inserted, updated and deleted rows for the phase profile
+  progress.setRowCountFunc([this]() -> qint64 {
+    SqlQuery query("select total_changes()", db);
+    query.exec();
+    return query.next() ? query.value(0).toLongLong() : 0L;
+  });
+
+  // Collect file states of all areas for FSX, P3D and MSFS to detect changes on next run
+  QVector<SceneryAreaState> areaStates;
+  if(sim != atools::fs::FsPaths::XPLANE11 && sim != atools::fs::FsPaths::NAVIGRAPH)
+  {
+    areaStates = sceneryAreaStates(sceneryCfg.getAreas());
+
+    if(options->isSkipUnchanged() && isSceneryUnchanged(areaStates))
+    {
+      // Nothing to do - keep database as is
+      qInfo() << Q_FUNC_INFO << "No scenery changes found. Skipping loading.";
+      progress.reportFinish();
+      return;
+    }
+  }
+
+  if(options->isBulkCompile())
+    setBulkPragmas();
+
+  setSortThreads();
+
   createSchemaInternal(&progress);
   if(aborted)
     return;
 
+  // Share repeated names like regions, countries or airways between all records of this compilation.
+  // Declared before the writers to outlive them. The scope covers the X-Plane and DFD writers in this thread
+  // and the DataWriter passes the interner to its BGL reader threads.
+  atools::util::StringInterner interner;
+  atools::util::StringInternerScope internerScope(&interner);
+
   // -----------------------------------------------------------------------
   // Create empty data writer pointers which will read all files and fill the database
   // Pointers will be initialized on demand/compilation type and be delete on exit (like thrown exception)
@@ -619,6 +827,8 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   {
     // Load FSX / P3D scenery database ======================================================
     fsDataWriter.reset(new atools::fs::db::DataWriter(*db, *options, &progress));
+    fsDataWriter->setDirectoryCache(&directoryCache);
+    fsDataWriter->setStringInterner(&interner);
 
     // Base is
     // C:\Users\alex\AppData\Local\Packages\Microsoft.FlightSimulator_8wekyb3d8bbwe\LocalCache\Packages
@@ -626,11 +836,11 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
 
     // Load the language index for lookup for airport names and more
     QString packageBase = options->getMsfsOfficialPath();
-    QFileInfo langFile = buildPathNoCase({packageBase, "fs-base", options->getLanguage() + ".locPak"});
-    if(!langFile.exists() || !langFile.isFile())
+    QFileInfo langFile = directoryCache.buildPathNoCase({packageBase, "fs-base", options->getLanguage() + ".locPak"});
+    if(!directoryCache.isFile(langFile.filePath()))
     {
       qWarning() << Q_FUNC_INFO << langFile.absoluteFilePath() << "not found. Falling back to en-US";
-      langFile = buildPathNoCase({packageBase, "fs-base", "en-US.locPak"});
+      langFile = directoryCache.buildPathNoCase({packageBase, "fs-base", "en-US.locPak"});
     }
 
     // Load translation file in current language for airport names ====================================
@@ -651,6 +861,8 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   {
     // Load FSX / P3D scenery database ======================================================
     fsDataWriter.reset(new atools::fs::db::DataWriter(*db, *options, &progress));
+    fsDataWriter->setDirectoryCache(&directoryCache);
+    fsDataWriter->setStringInterner(&interner);
     loadFsxP3d(&progress, fsDataWriter.data(), sceneryCfg);
     fsDataWriter->close();
   }
@@ -658,6 +870,13 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   if(aborted)
     return;
 
+  // Simulators have no MORA - calculate from elevation data if available
+  if(sim != atools::fs::FsPaths::NAVIGRAPH && isGlobeMora())
+  {
+    if((aborted = writeGlobeMora(&progress)))
+      return;
+  }
+
   // ===========================================================================
   // Loading is done here - now continue with the post process steps
 
@@ -665,16 +884,26 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   {
     // All simulators ====================
     // Read tmp_airway_point table, connect all waypoints and write the ordered result into the airway table
+    ATOOLS_TRACE_SCOPE("NavDatabase::resolveAirways", "navdatabase");
     atools::fs::db::AirwayResolver resolver(db, progress);
 
     if(sim != atools::fs::FsPaths::NAVIGRAPH && sim != atools::fs::FsPaths::XPLANE11)
       // Drop large segments only for the borked data of FSX/P3D/MSFS - default is 8000 nm
       resolver.setMaxAirwaySegmentLengthNm(800);
 
-    resolver.assignWaypointIds();
+    if(options->isAirwaysInMemory())
+    {
+      // Waypoint ids are resolved in memory
+      if((aborted = resolver.runInMemory(PROGRESS_NUM_RESOLVE_AIRWAY_STEPS)))
+        return;
+    }
+    else
+    {
+      resolver.assignWaypointIds();
 
-    if((aborted = resolver.run(PROGRESS_NUM_RESOLVE_AIRWAY_STEPS)))
-      return;
+      if((aborted = resolver.run(PROGRESS_NUM_RESOLVE_AIRWAY_STEPS)))
+        return;
+    }
   }
 
   if(sim != atools::fs::FsPaths::XPLANE11 && sim != atools::fs::FsPaths::NAVIGRAPH && sim != atools::fs::FsPaths::MSFS)
@@ -719,6 +948,16 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   if((aborted = runScript(&progress, "fs/db/update_num_ils.sql", tr("Updating ILS Count"))))
     return;
 
+  if(options->isProcedureGeometry())
+  {
+    if((aborted = progress.reportOther(tr("Calculating procedure geometry"))))
+      return;
+
+    // Needs the runway end ids from the approach update
+    atools::fs::db::ProcedureGeometryWriter geometryWriter(db);
+    geometryWriter.run();
+  }
+
   // Prepare the search table
   if((aborted = runScript(&progress, "fs/db/populate_nav_search.sql", tr("Collecting navaids for search"))))
     return;
@@ -740,6 +979,16 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
       return;
   }
 
+  if(options->isCreateRouteShortcuts())
+  {
+    if((aborted = progress.reportOther(tr("Creating airway shortcuts"))))
+      return;
+
+    // Find chains of airway segments which can be skipped by the route finder
+    atools::fs::db::RouteShortcutWriter shortcutWriter(db);
+    shortcutWriter.run();
+  }
+
   if((aborted = runScript(&progress, "fs/db/finish_airport_schema.sql", tr("Creating indexes for airport"))))
     return;
 
@@ -758,6 +1007,29 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
       return;
   }
 
+  if(options->isSpatialIndex())
+  {
+    // R*Tree tables for all tables with coordinates - needs all tables to be complete
+    if((aborted = runScript(&progress, "fs/db/create_spatial_index.sql", tr("Creating spatial indexes"))))
+      return;
+  }
+
+  if(options->isFullTextIndex())
+  {
+    if(SqlFullTextIndex::isFts5Available(db))
+    {
+      // FTS5 tables using airport and nav_search as content
+      if((aborted = runScript(&progress, "fs/db/create_fulltext_index.sql", tr("Creating full text indexes"))))
+        return;
+    }
+    else
+    {
+      qWarning() << Q_FUNC_INFO << "SQLite has no FTS5. Not creating full text indexes.";
+      if((aborted = progress.reportOtherInc(tr("Creating full text indexes"), PROGRESS_NUM_SCRIPT_STEPS)))
+        return;
+    }
+  }
+
   if(sim == atools::fs::FsPaths::MSFS)
   {
     if((aborted = progress.reportOther(tr("Loading translations"))))
@@ -787,6 +1059,9 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
                                       arg(gitRevision));
 
   databaseMetadata.updateAll();
+
+  if(!areaStates.isEmpty())
+    writeSceneryAreaStates(areaStates);
   db->commit();
 
   if(!dfdCompiler.isNull())
@@ -796,6 +1071,14 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   // ================================================================================================
   // Done here - now only some options statistics and reports are left
 
+  if(options->isBulkCompile() && (options->isBasicValidation() || options->isDatabaseReport()))
+  {
+    // Reset bulk pragmas to release the exclusive lock which allows other connections to read in parallel.
+    // Lock is released on the next access after changing the locking mode.
+    restorePragmas();
+    db->exec("select count(1) from sqlite_master");
+  }
+
   if(options->isBasicValidation())
     basicValidation(&progress);
 
@@ -835,14 +1118,53 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
     db->analyze();
   }
 
+  if(!options->getCompressedDatabaseFile().isEmpty())
+  {
+    if((aborted = progress.reportOtherInc(tr("Compressing Database"), PROGRESS_NUM_TASK_STEPS)))
+      return;
+
+    compressDatabase();
+  }
+
   // Send the final progress report
   progress.reportFinish();
 
+  // Print time, rows and bytes read for all phases to find slow steps
+  qInfo().noquote().nospace() << "Compilation phases:" << endl << progress.getPhaseTable();
+  qInfo().noquote() << "Compilation phases JSON:" << progress.getPhaseJson().toJson(QJsonDocument::Compact);
+
   qDebug() << "Time" << timer.elapsed() / 1000 << "seconds";
 }
 
+bool NavDatabase::isGlobeMora() const
+{
+  const QString& path = options->getGlobeDataPath();
+  return !path.isEmpty() && atools::fs::common::GlobeReader::isDirValid(path);
+}
+
+bool NavDatabase::writeGlobeMora(ProgressHandler *progress)
+{
+  ATOOLS_TRACE_SCOPE("NavDatabase::writeGlobeMora", "navdatabase");
+
+  if((aborted = progress->reportOther(tr("Calculating MORA"))))
+    return true;
+
+  // Tiles are scanned in parallel from the memory mapped files
+  atools::fs::common::GlobeReader globeReader(options->getGlobeDataPath());
+  if(globeReader.openFiles())
+  {
+    atools::fs::common::MoraReader(db).writeFromGlobe(globeReader);
+    db->commit();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot open GLOBE files in" << options->getGlobeDataPath();
+  return false;
+}
+
 bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompiler, const scenery::SceneryArea& area)
 {
+  ATOOLS_TRACE_SCOPE("NavDatabase::loadDfd", "navdatabase");
+
   progress->reportSceneryArea(&area);
 
   dfdCompiler->writeFileAndSceneryMetadata();
@@ -875,6 +1197,9 @@ bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompile
 
   dfdCompiler->writeCom();
 
+  if((aborted = createDeferredIndexes(progress)))
+    return true;
+
   if((aborted = runScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
     return true;
 
@@ -903,6 +1228,9 @@ bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompile
     dfdCompiler->writeProcedures();
   db->commit();
 
+  if((aborted = createDeferredIndexes(progress)))
+    return true;
+
   if((aborted = runScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
     return true;
 
@@ -931,6 +1259,8 @@ bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompile
 bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCompiler *xpDataCompiler,
                              const atools::fs::scenery::SceneryArea& area)
 {
+  ATOOLS_TRACE_SCOPE("NavDatabase::loadXplane", "navdatabase");
+
   if((aborted = progress->reportSceneryArea(&area)))
     return true;
 
@@ -993,6 +1323,9 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
       return true;
   }
 
+  if((aborted = createDeferredIndexes(progress)))
+    return true;
+
   if((aborted = runScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
     return true;
 
@@ -1038,6 +1371,8 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
 bool NavDatabase::loadFsxP3d(ProgressHandler *progress, atools::fs::db::DataWriter *fsDataWriter,
                              const SceneryCfg& cfg)
 {
+  ATOOLS_TRACE_SCOPE("NavDatabase::loadFsxP3d", "navdatabase");
+
   // Prepare structure for error collection
   NavDatabaseErrors::SceneryErrors err;
   fsDataWriter->setSceneryErrors(errors != nullptr ? &err : nullptr);
@@ -1056,6 +1391,8 @@ bool NavDatabase::loadFsxP3d(ProgressHandler *progress, atools::fs::db::DataWrit
 
 bool NavDatabase::loadMsfs(ProgressHandler *progress, db::DataWriter *fsDataWriter, const SceneryCfg& cfg)
 {
+  ATOOLS_TRACE_SCOPE("NavDatabase::loadMsfs", "navdatabase");
+
   // Prepare structure for error collection
   NavDatabaseErrors::SceneryErrors err;
   fsDataWriter->setSceneryErrors(errors != nullptr ? &err : nullptr);
@@ -1104,7 +1441,7 @@ bool NavDatabase::loadFsxP3dMsfsSimulator(ProgressHandler *progress, db::DataWri
 
       // Read all BGL files in the scenery area into classes of the bgl namespace and
       // write the contents to the database
-      fsDataWriter->writeSceneryArea(area);
+      fsDataWriter->writeSceneryArea(area, options->isSceneryFileManifest() ? &sceneryAreaFiles(area) : nullptr);
 
       if((!err.fileErrors.isEmpty() || !err.sceneryErrorsMessages.isEmpty()) && errors != nullptr)
       {
@@ -1124,6 +1461,11 @@ bool NavDatabase::loadFsxP3dMsfsSimulator(ProgressHandler *progress, db::DataWri
 
 bool NavDatabase::loadFsxP3dMsfsPost(ProgressHandler *progress)
 {
+  ATOOLS_TRACE_SCOPE("NavDatabase::loadFsxP3dMsfsPost", "navdatabase");
+
+  if((aborted = createDeferredIndexes(progress)))
+    return true;
+
   if((aborted = runScript(progress, "fs/db/create_indexes_post_load.sql", tr("Creating indexes"))))
     return true;
 
@@ -1144,13 +1486,24 @@ bool NavDatabase::basicValidation(ProgressHandler *progress)
   if((aborted = progress->reportOther(tr("Basic Validation"))))
     return true;
 
-  for(const QString& table : options->getBasicValidationTables().keys())
-    basicValidateTable(table, options->getBasicValidationTables().value(table));
+  QVector<ReportJob> jobs;
+  const QMap<QString, int>& tables = options->getBasicValidationTables();
+  for(auto it = tables.constBegin(); it != tables.constEnd(); ++it)
+  {
+    QString table = it.key();
+    int minCount = it.value();
+    jobs.append([table, minCount](atools::sql::SqlDatabase *jobDb, QDebug& out) {
+      basicValidateTable(jobDb, out, table, minCount);
+    });
+  }
+
+  QDebug info(qInfo());
+  runReportJobs(db, jobs, info);
 
   return false;
 }
 
-void NavDatabase::basicValidateTable(const QString& table, int minCount)
+void NavDatabase::basicValidateTable(atools::sql::SqlDatabase *db, QDebug& out, const QString& table, int minCount)
 {
   SqlUtil util(db);
   if(!util.hasTable(table))
@@ -1160,7 +1513,7 @@ void NavDatabase::basicValidateTable(const QString& table, int minCount)
   if((count = util.rowCount(table)) < minCount)
     throw Exception(QString("Table \"%1\" has only %2 rows. Minimum required is %3").arg(table).arg(count).arg(minCount));
 
-  qInfo() << "Table" << table << "is OK. Has" << count << "rows. Minimum required is" << minCount;
+  out << "Table" << table << "is OK. Has" << count << "rows. Minimum required is" << minCount << endl;
 }
 
 void NavDatabase::runPreparationPost245(atools::sql::SqlDatabase& db)
@@ -1187,6 +1540,8 @@ void NavDatabase::runPreparationPost245(atools::sql::SqlDatabase& db)
 
   // Delete legacy center boundaries in favor of new types FIR and UIR
   db.exec("delete from boundary where type = 'C' and name in ('% (FIR)', '% (UIR)', '% (FIR/UIR)')");
+  if(util.hasTable("boundary_tile"))
+    db.exec("delete from boundary_tile where boundary_id not in (select boundary_id from boundary)");
   db.commit();
 }
 
@@ -1228,87 +1583,167 @@ void NavDatabase::createPreparationScript()
   db->commit();
 }
 
-void NavDatabase::dropAllIndexes()
+bool NavDatabase::createDeferredIndexes(ProgressHandler *progress)
 {
-  QStringList stmts;
+  ATOOLS_TRACE_SCOPE("NavDatabase::createDeferredIndexes", "navdatabase");
 
-  {
-    SqlQuery indexQuery("select name from sqlite_master where type = 'index' and sql is not null", db);
-    indexQuery.exec();
-    while(indexQuery.next())
-      stmts.append("drop index if exists " + indexQuery.valueStr("name"));
-  }
+  if(deferredIndexes.isEmpty())
+    return false;
 
-  for(const QString& stmt : stmts)
+  // Report message only since steps are not counted in advance
+  if(progress != nullptr)
+    if((aborted = progress->reportOtherMsg(tr("Creating deferred indexes"))))
+      return true;
+
+  qDebug() << Q_FUNC_INFO << "Creating" << deferredIndexes.size() << "indexes";
+
+  for(const QString& stmt : deferredIndexes)
     db->exec(stmt);
   db->commit();
+
+  deferredIndexes.clear();
+  return false;
 }
 
-bool NavDatabase::createDatabaseReport(ProgressHandler *progress)
+void NavDatabase::setBulkPragmas()
 {
-  QDebug info(qInfo());
-  atools::sql::SqlUtil util(db);
+  savedPragmas.clear();
 
-  if((aborted = progress->reportOther(tr("Creating table statistics"))))
-    return true;
+  SqlQuery query(db);
+  for(const QString& pragma : {"journal_mode", "synchronous", "cache_size", "temp_store", "locking_mode"})
+  {
+    query.exec("PRAGMA " + pragma);
+    if(query.next())
+      savedPragmas.append("PRAGMA " + pragma + "=" + query.valueStr(0));
+  }
+  query.finish();
 
-  info << endl;
-  util.printTableStats(info);
+  qInfo() << Q_FUNC_INFO << "Saved" << savedPragmas;
+  db->executePragmas(BULK_PRAGMAS);
+}
 
-  if((aborted = progress->reportOther(tr("Creating report on values"))))
-    return true;
+void NavDatabase::setSortThreads()
+{
+  int threads = options->getSortThreads();
+  if(threads == 0)
+    // Opt-in only - keep the SQLite default
+    return;
 
-  info << endl;
-  util.createColumnReport(info);
+  if(threads < 0)
+    // SQLite limits this to SQLITE_MAX_WORKER_THREADS which is 8 by default
+    threads = std::max(0, QThread::idealThreadCount() - 1);
 
-  if((aborted = progress->reportOther(tr("Creating report on duplicates"))))
-    return true;
+  // Let SQLite sort in worker threads - this is a per connection setting not affected by transactions
+  SqlQuery query(db);
+  query.exec(QString("PRAGMA threads=%1").arg(threads));
+  if(query.next())
+    qInfo() << Q_FUNC_INFO << "Sort threads" << query.valueStr(0);
+  query.finish();
+}
 
-  info << endl;
+void NavDatabase::restorePragmas()
+{
+  if(savedPragmas.isEmpty())
+    return;
 
-  util.reportDuplicates(info, "airport", "airport_id", {"ident"});
-  info << endl;
+  qInfo() << Q_FUNC_INFO << "Restoring" << savedPragmas;
 
-  util.reportDuplicates(info, "vor", "vor_id", {"ident", "region", "lonx", "laty"});
-  info << endl;
+  // Clear first to avoid repeated attempts if restoring fails
+  QStringList pragmas;
+  pragmas.swap(savedPragmas);
+  db->executePragmas(pragmas);
+}
 
-  util.reportDuplicates(info, "ndb", "ndb_id", {"ident", "type", "frequency", "region", "lonx", "laty"});
-  info << endl;
+void NavDatabase::compressDatabase()
+{
+  // All changes have to be in the database file before reading it
+  restorePragmas();
+  db->commit();
+  if(db->isWalMode())
+    db->walCheckpoint(atools::sql::SqlDatabase::CHECKPOINT_TRUNCATE);
 
-  util.reportDuplicates(info, "waypoint", "waypoint_id", {"ident", "type", "region", "lonx", "laty"});
-  info << endl;
+  atools::sql::SqliteCompressedVfs::compressDatabase(db->databaseName(), options->getCompressedDatabaseFile());
+}
 
-  util.reportDuplicates(info, "ils", "ils_id", {"ident", "lonx", "laty"});
-  info << endl;
+void NavDatabase::dropAllIndexes()
+{
+  QStringList stmts;
 
-  util.reportDuplicates(info, "marker", "marker_id", {"type", "heading", "lonx", "laty"});
-  info << endl;
+  {
+    SqlQuery indexQuery("select name from sqlite_master where type = 'index' and sql is not null", db);
+    indexQuery.exec();
+    while(indexQuery.next())
+      stmts.append("drop index if exists " + indexQuery.valueStr("name"));
+  }
 
-  util.reportDuplicates(info, "helipad", "helipad_id", {"lonx", "laty"});
-  info << endl;
+  for(const QString& stmt : stmts)
+    db->exec(stmt);
+  db->commit();
+}
 
-  util.reportDuplicates(info, "parking", "parking_id", {"lonx", "laty"});
-  info << endl;
+bool NavDatabase::createDatabaseReport(ProgressHandler *progress)
+{
+  if((aborted = progress->reportOther(tr("Creating database report"))))
+    return true;
 
-  util.reportDuplicates(info, "start", "start_id", {"lonx", "laty"});
-  info << endl;
+  createDatabaseReport(db, options->isDatabaseReportFast());
+  return false;
+}
 
-  util.reportDuplicates(info, "runway", "runway_id", {"heading", "lonx", "laty"});
-  info << endl;
+void NavDatabase::createDatabaseReport(atools::sql::SqlDatabase *db, bool fast)
+{
+  QVector<ReportJob> jobs;
 
-  util.reportDuplicates(info, "bgl_file", "bgl_file_id", {"filename"});
-  info << endl;
+  jobs.append([](atools::sql::SqlDatabase *jobDb, QDebug& out) {
+    SqlUtil(jobDb).printTableStats(out);
+  });
 
-  if((aborted = progress->reportOther(tr("Creating report on coordinate duplicates"))))
-    return true;
+  if(!fast)
+  {
+    jobs.append([](atools::sql::SqlDatabase *jobDb, QDebug& out) {
+      SqlUtil(jobDb).createColumnReport(out);
+    });
+
+    // Table, id column and columns identifying a duplicate
+    static const QVector<std::tuple<QString, QString, QStringList> > DUPLICATES({
+      std::make_tuple("airport", "airport_id", QStringList({"ident"})),
+      std::make_tuple("vor", "vor_id", QStringList({"ident", "region", "lonx", "laty"})),
+      std::make_tuple("ndb", "ndb_id", QStringList({"ident", "type", "frequency", "region", "lonx", "laty"})),
+      std::make_tuple("waypoint", "waypoint_id", QStringList({"ident", "type", "region", "lonx", "laty"})),
+      std::make_tuple("ils", "ils_id", QStringList({"ident", "lonx", "laty"})),
+      std::make_tuple("marker", "marker_id", QStringList({"type", "heading", "lonx", "laty"})),
+      std::make_tuple("helipad", "helipad_id", QStringList({"lonx", "laty"})),
+      std::make_tuple("parking", "parking_id", QStringList({"lonx", "laty"})),
+      std::make_tuple("start", "start_id", QStringList({"lonx", "laty"})),
+      std::make_tuple("runway", "runway_id", QStringList({"heading", "lonx", "laty"})),
+      std::make_tuple("bgl_file", "bgl_file_id", QStringList({"filename"}))
+    });
+
+    for(const std::tuple<QString, QString, QStringList>& dup : DUPLICATES)
+    {
+      jobs.append([dup](atools::sql::SqlDatabase *jobDb, QDebug& out) {
+        SqlUtil(jobDb).reportDuplicates(out, std::get<0>(dup), std::get<1>(dup), std::get<2>(dup));
+      });
+    }
 
-  reportCoordinateViolations(info, util, {"airport", "vor", "ndb", "marker", "waypoint"});
+    for(const QString& table : {"airport", "vor", "ndb", "marker", "waypoint"})
+    {
+      jobs.append([table](atools::sql::SqlDatabase *jobDb, QDebug& out) {
+        SqlUtil util(jobDb);
+        reportCoordinateViolations(out, util, {table});
+      });
+    }
+  }
 
-  return false;
+  QDebug info(qInfo());
+  info << endl;
+  runReportJobs(db, jobs, info);
 }
 
 bool NavDatabase::runScript(ProgressHandler *progress, const QString& scriptFile, const QString& message)
 {
+  ATOOLS_TRACE_SCOPE("NavDatabase::runScript", "navdatabase");
+
   SqlScript script(db, true /*options->isVerbose()*/);
 
   if(progress != nullptr)
@@ -1345,47 +1780,45 @@ void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
   areaNav.setNavdata(); // Set flag to allow dummy airport handling
   cfg.appendArea(areaNav);
 
-  scenery::LayoutJson layout;
-  scenery::ManifestJson manifest;
-
   // Read add-on packages in official ===============================
   QDir dir(options->getMsfsOfficialPath(), QString(),
            QDir::Name | QDir::IgnoreCase, QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
   QString baseName = dir.dirName();
+
+  QVector<MsfsPackage> packages;
   for(const QFileInfo& fileinfo : dir.entryInfoList())
   {
-    QString name = fileinfo.fileName();
-
-    if(name == "fs-base-nav" || name == "fs-base")
+    if(fileinfo.fileName() == "fs-base-nav" || fileinfo.fileName() == "fs-base")
       // Already read before
       continue;
+    packages.append(MsfsPackage(fileinfo.filePath(), fileinfo.fileName()));
+  }
 
-    // Read manifest to check type
-    manifest.clear();
-    manifest.read(fileinfo.filePath() + SEP + "manifest.json");
+  // Read manifest to check type and then BGL and material file locations from layout file
+  atools::util::parallelFor(packages.size(), [&packages](int i) {
+    MsfsPackage& package = packages[i];
+    package.manifest.read(package.path + SEP + "manifest.json");
+    if(package.manifest.getContentType() == "SCENERY")
+      package.layout.read(package.path + SEP + "layout.json");
+  });
 
-    if(manifest.getContentType() == "SCENERY")
+  for(const MsfsPackage& package : packages)
+  {
+    if(package.manifest.getContentType() == "SCENERY" && !package.layout.getBglPaths().isEmpty())
     {
-      // Read BGL and material file locations from layout file
-      layout.clear();
-      layout.read(fileinfo.filePath() + SEP + "layout.json");
-
-      if(!layout.getBglPaths().isEmpty())
-      {
-        SceneryArea area(areaNum++, baseName, name);
+      SceneryArea area(areaNum++, baseName, package.name);
 
-        if(name.startsWith("asobo-airport-"))
-          // These will not be indicated as add-on in the GUI
-          area.setAsoboAirport(true);
+      if(package.name.startsWith("asobo-airport-"))
+        // These will not be indicated as add-on in the GUI
+        area.setAsoboAirport(true);
 
-        // Indicate add-on in official path
-        area.setAddOn(true);
+      // Indicate add-on in official path
+      area.setAddOn(true);
 
-        // Detect Navigraph navdata update packages for special handling
-        area.setNavdataThirdPartyUpdate(checkThirdPartyNavdataUpdate(manifest));
+      // Detect Navigraph navdata update packages for special handling
+      area.setNavdataThirdPartyUpdate(checkThirdPartyNavdataUpdate(package.manifest));
 
-        cfg.getAreas().append(area);
-      }
+      cfg.getAreas().append(area);
     }
   }
 
@@ -1394,28 +1827,34 @@ void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
   dir = QDir(options->getMsfsCommunityPath(), QString(),
              QDir::Name | QDir::IgnoreCase, QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
 
+  packages.clear();
   for(const QFileInfo& fileinfo : dir.entryInfoList())
-  {
-    // Read BGL and material file locations from layout file
-    layout.clear();
-    layout.read(fileinfo.filePath() + SEP + "layout.json");
+    packages.append(MsfsPackage(fileinfo.filePath(), fileinfo.fileName()));
 
-    if(!layout.getBglPaths().isEmpty())
+  // Read BGL and material file locations from layout file and manifest for packages containing BGL files
+  atools::util::parallelFor(packages.size(), [&packages](int i) {
+    MsfsPackage& package = packages[i];
+    package.layout.read(package.path + SEP + "layout.json");
+    if(!package.layout.getBglPaths().isEmpty())
+      package.manifest.read(package.path + SEP + "manifest.json");
+  });
+
+  for(const MsfsPackage& package : packages)
+  {
+    if(!package.layout.getBglPaths().isEmpty())
     {
-      SceneryArea area(areaNum++, tr("Community"), fileinfo.fileName());
+      SceneryArea area(areaNum++, tr("Community"), package.name);
       area.setCommunity(true);
 
       // Detect Navigraph navdata update packages for special handling
-      manifest.clear();
-      manifest.read(fileinfo.filePath() + SEP + "manifest.json");
-      area.setNavdataThirdPartyUpdate(checkThirdPartyNavdataUpdate(manifest));
+      area.setNavdataThirdPartyUpdate(checkThirdPartyNavdataUpdate(package.manifest));
 
       cfg.getAreas().append(area);
     }
   }
 }
 
-bool NavDatabase::checkThirdPartyNavdataUpdate(atools::fs::scenery::ManifestJson& manifest)
+bool NavDatabase::checkThirdPartyNavdataUpdate(const atools::fs::scenery::ManifestJson& manifest)
 {
   // "content_type": "SCENERY",
   // "title": "Navigraph Navdata Cycle 2010-revision.10",
@@ -1557,10 +1996,10 @@ void NavDatabase::readSceneryConfigFsxP3d(atools::fs::scenery::SceneryCfg& cfg)
     // Read add-on.xml files from the discovery paths
     for(const QString& addonPath : addonDiscoveryPaths)
     {
-      QDir addonDir(addonPath);
-      if(addonDir.exists())
+      if(directoryCache.isDir(addonPath))
       {
-        QFileInfoList addonEntries(addonDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot));
+        QFileInfoList addonEntries(directoryCache.entryInfoList(addonPath, QStringList(),
+                                                                false /* files */, true /* dirs */));
 
         // Read addon directories as they appear in the file system
         for(QFileInfo addonEntry : addonEntries)
@@ -1616,7 +2055,7 @@ void NavDatabase::readAddOnComponents(int& areaNum, atools::fs::scenery::Scenery
 {
   QFileInfo addonFile = buildAddonFile(addonEntry);
 
-  if(addonFile.exists() && addonFile.isFile())
+  if(directoryCache.isFile(addonFile.filePath()))
   {
     if(addonPaths.contains(addonFile.canonicalFilePath()))
     {
@@ -1650,7 +2089,7 @@ void NavDatabase::readAddOnComponents(int& areaNum, atools::fs::scenery::Scenery
 
       areaNum++;
 
-      if(!compPath.exists())
+      if(!directoryCache.isDir(compPath.path()))
         qWarning() << "Path does not exist" << compPath;
 
       if(component.getLayer() == -1)
@@ -1688,23 +2127,163 @@ int NavDatabase::nextAreaNum(const QList<atools::fs::scenery::SceneryArea>& area
   return areaNum;
 }
 
+QVector<NavDatabase::SceneryAreaState> NavDatabase::sceneryAreaStates(const QList<scenery::SceneryArea>& areas)
+{
+  // Options, simulator and compiler influence the result and are added to each fingerprint
+  QString base;
+  QDebug(&base) << *options << FsPaths::typeToShortName(options->getSimulatorType())
+                << atools::version() << atools::gitRevision() << gitRevision;
+
+  QVector<SceneryAreaState> states;
+  atools::fs::scenery::FileResolver resolver(*options, true);
+  resolver.setDirectoryCache(&directoryCache);
+  for(const SceneryArea& area : areas)
+  {
+    // Same filter as in loadFsxP3dMsfsSimulator()
+    if((area.isActive() || options->isReadInactive()) && options->isIncludedLocalPath(area.getLocalPath()))
+    {
+      SceneryAreaState state;
+      state.layer = area.getLayer();
+      state.title = area.getTitle();
+      state.localPath = area.getLocalPath();
+
+      QCryptographicHash hash(QCryptographicHash::Sha1);
+      hash.addData(base.toUtf8());
+      hash.addData(QString("%1|%2|%3").arg(state.layer).arg(state.title).arg(state.localPath).toUtf8());
+
+      if(options->isSceneryFileManifest())
+      {
+        // Use sizes and times from the manifest
+        const scenery::SceneryAreaFiles& files = sceneryAreaFiles(area);
+        state.numFiles = files.size();
+        for(int i = 0; i < files.size(); i++)
+        {
+          qint64 modified = files.lastModified.at(i);
+          state.size += files.sizes.at(i);
+          state.modificationTime = std::max(state.modificationTime, modified / 1000L);
+          hash.addData(QString("%1|%2|%3").arg(files.filepaths.at(i)).arg(files.sizes.at(i)).arg(modified).toUtf8());
+        }
+      }
+      else
+      {
+        QStringList filepaths;
+        state.numFiles = resolver.getFiles(area, &filepaths);
+        for(const QString& filepath : filepaths)
+        {
+          QFileInfo fileinfo = directoryCache.fileInfo(filepath);
+          qint64 modified = fileinfo.lastModified().toMSecsSinceEpoch();
+          state.size += fileinfo.size();
+          state.modificationTime = std::max(state.modificationTime, modified / 1000L);
+          hash.addData(QString("%1|%2|%3").arg(filepath).arg(fileinfo.size()).arg(modified).toUtf8());
+        }
+      }
+      state.fingerprint = QString::fromLatin1(hash.result().toHex());
+      states.append(state);
+    }
+  }
+  return states;
+}
+
+bool NavDatabase::isSceneryUnchanged(const QVector<SceneryAreaState>& states)
+{
+  SqlUtil util(db);
+  if(!util.hasTableAndRows("scenery_area_state") || !util.hasTableAndRows("airport"))
+    return false;
+
+  atools::fs::db::DatabaseMeta meta(db);
+  if(!meta.isDatabaseCompatible())
+    return false;
+
+  SqlQuery query(db);
+  query.exec("select title, fingerprint from scenery_area_state order by scenery_area_state_id");
+  int index = 0;
+  while(query.next())
+  {
+    if(index >= states.size() || states.at(index).fingerprint != query.valueStr("fingerprint"))
+    {
+      qInfo() << Q_FUNC_INFO << "Scenery area changed" << query.valueStr("title");
+      return false;
+    }
+    index++;
+  }
+
+  if(index != states.size())
+  {
+    qInfo() << Q_FUNC_INFO << "Scenery areas added";
+    return false;
+  }
+  return true;
+}
+
+void NavDatabase::writeSceneryAreaStates(const QVector<SceneryAreaState>& states)
+{
+  SqlQuery query(db);
+  query.exec("delete from scenery_area_state");
+
+  query.prepare("insert into scenery_area_state (scenery_area_state_id, layer, title, local_path, num_files, size, "
+                "file_modification_time, fingerprint) "
+                "values(:id, :layer, :title, :path, :files, :size, :time, :fingerprint)");
+
+  int id = 1;
+  for(const SceneryAreaState& state : states)
+  {
+    query.bindValue(":id", id++);
+    query.bindValue(":layer", state.layer);
+    query.bindValue(":title", state.title);
+    query.bindValue(":path", state.localPath);
+    query.bindValue(":files", state.numFiles);
+    query.bindValue(":size", state.size);
+    query.bindValue(":time", state.modificationTime);
+    query.bindValue(":fingerprint", state.fingerprint);
+    query.exec();
+  }
+}
+
 void NavDatabase::countFiles(const QList<atools::fs::scenery::SceneryArea>& areas, int& numFiles, int& numSceneryAreas)
 {
   qDebug() << Q_FUNC_INFO << "Entry";
   atools::fs::scenery::FileResolver resolver(*options, true);
+  resolver.setDirectoryCache(&directoryCache);
 
   for(const atools::fs::scenery::SceneryArea& area : areas)
   {
-    int num = resolver.getFiles(area);
-
-    if(num > 0)
+    if(options->isSceneryFileManifest())
     {
-      numFiles += num;
-      numSceneryAreas++;
+      // Resolve once and keep files for reading - progress is weighted by file size
+      const scenery::SceneryAreaFiles& files = sceneryAreaFiles(area);
+      if(!files.isEmpty())
+      {
+        numFiles += files.totalProgressSteps;
+        numSceneryAreas++;
+      }
+    }
+    else
+    {
+      int num = resolver.getFiles(area);
+
+      if(num > 0)
+      {
+        numFiles += num;
+        numSceneryAreas++;
+      }
     }
   }
   qDebug() << Q_FUNC_INFO << "Exit";
 }
 
+const scenery::SceneryAreaFiles& NavDatabase::sceneryAreaFiles(const scenery::SceneryArea& area)
+{
+  QHash<int, scenery::SceneryAreaFiles>::const_iterator it = sceneryFiles.constFind(area.getAreaNumber());
+  if(it != sceneryFiles.constEnd())
+    return it.value();
+
+  // Print warnings since this is the only place where files are resolved
+  scenery::SceneryAreaFiles files;
+  atools::fs::scenery::FileResolver resolver(*options);
+  resolver.setDirectoryCache(&directoryCache);
+  resolver.getFiles(area, files);
+  return sceneryFiles.insert(area.getAreaNumber(), files).value();
+}
+
 } // namespace fs
 } // namespace atools
@@ -19,6 +19,8 @@
 #define ATOOLS_FS_NAVDATABASE_H
 
 #include "fs/fspaths.h"
+#include "fs/scenery/directorycache.h"
+#include "fs/scenery/fileresolver.h"
 
 #include <QDebug>
 #include <QCoreApplication>
@@ -121,6 +123,15 @@ public:
   /* Delete all tables that are not used in versions > 2.4.5 */
   static void runPreparationPost245(atools::sql::SqlDatabase& db);
 
+  /*
+   * Print table statistics and reports on values, duplicates and coordinate ranges of a finished database
+   * to the log. Only table row counts are printed if fast is true.
+   *
+   * The independent queries run in parallel on read-only connections if db is a SQLite file database
+   * which is not locked exclusively. Can be called asynchronously after compilation once the database is in use.
+   */
+  static void createDatabaseReport(atools::sql::SqlDatabase *db, bool fast);
+
 private:
   /* Creates database schema only */
   void createSchemaInternal(atools::fs::ProgressHandler *progress = nullptr);
@@ -157,14 +168,24 @@ private:
   bool loadFsxP3dMsfsSimulator(ProgressHandler *progress, db::DataWriter *fsDataWriter,
                                const QList<atools::fs::scenery::SceneryArea>& areas);
 
+  /* Calculate the MORA grid from GLOBE elevation data for simulators which do not provide MORA.
+   * Returns true if aborted. */
+  bool writeGlobeMora(ProgressHandler *progress);
+
+  /* true if the options point to a valid GLOBE directory */
+  bool isGlobeMora() const;
+
   /* Reporting to log file and/or console */
   bool createDatabaseReport(ProgressHandler *progress);
   bool basicValidation(ProgressHandler *progress);
-  void basicValidateTable(const QString& table, int minCount);
-  void reportCoordinateViolations(QDebug& out, atools::sql::SqlUtil& util, const QStringList& tables);
+  static void basicValidateTable(atools::sql::SqlDatabase *db, QDebug& out, const QString& table, int minCount);
+  static void reportCoordinateViolations(QDebug& out, atools::sql::SqlUtil& util, const QStringList& tables);
 
-  /* Count files in FSX/P3D scenery configuration */
+  /* Count files in FSX/P3D scenery configuration. numFiles is weighted by size if the manifest is used. */
   void countFiles(const QList<scenery::SceneryArea>& areas, int& numFiles, int& numSceneryAreas);
+
+  /* Get resolved files of an area from the manifest. Resolves on first access. */
+  const atools::fs::scenery::SceneryAreaFiles& sceneryAreaFiles(const atools::fs::scenery::SceneryArea& area);
   int nextAreaNum(const QList<atools::fs::scenery::SceneryArea>& areas);
 
   /* Run and report SQL script */
@@ -173,6 +194,19 @@ private:
   void createPreparationScript();
   void dropAllIndexes();
 
+  /* Create indexes which were deferred in createSchemaInternal() for bulk compile. Done only once. */
+  bool createDeferredIndexes(atools::fs::ProgressHandler *progress);
+
+  /* Save current pragma values and set fast ones for bulk compile. restorePragmas() sets saved values again. */
+  void setBulkPragmas();
+  void restorePragmas();
+
+  /* Write a page compressed copy of the database to the file given in the options */
+  void compressDatabase();
+
+  /* Set number of SQLite sorter worker threads from options */
+  void setSortThreads();
+
   void readAddOnComponents(int& areaNum, atools::fs::scenery::SceneryCfg& cfg,
                            QVector<scenery::AddOnComponent>& noLayerComponents,
                            QStringList& noLayerPaths, QSet<QString>& addonPaths, const QFileInfo& addonEntry);
@@ -185,8 +219,26 @@ private:
   int countMsfsSteps(const scenery::SceneryCfg& cfg);
   int countMsSimSteps();
 
+  /* State of a scenery area used to detect changes and skip loading if nothing changed */
+  struct SceneryAreaState
+  {
+    int layer = 0, numFiles = 0;
+    QString title, localPath;
+    qint64 size = 0L, modificationTime = 0L;
+    QString fingerprint;
+  };
+
+  /* Collect state of all areas that will be loaded */
+  QVector<SceneryAreaState> sceneryAreaStates(const QList<scenery::SceneryArea>& areas);
+
+  /* true if states are equal to the ones saved by the last compilation into this database */
+  bool isSceneryUnchanged(const QVector<SceneryAreaState>& states);
+
+  /* Save states into table scenery_area_state */
+  void writeSceneryAreaStates(const QVector<SceneryAreaState>& states);
+
   /* Detect Navigraph navdata update packages for special handling */
-  bool checkThirdPartyNavdataUpdate(atools::fs::scenery::ManifestJson& manifest);
+  bool checkThirdPartyNavdataUpdate(const atools::fs::scenery::ManifestJson& manifest);
 
   /* For metadata */
 
@@ -196,6 +248,15 @@ private:
   bool aborted = false;
   QString gitRevision;
 
+  /* Create index statements and original pragmas for bulk compile */
+  QStringList deferredIndexes, savedPragmas;
+
+  /* Directory listings for scenery and add-on file lookups. Cleared for each compilation. */
+  atools::fs::scenery::DirectoryCache directoryCache;
+
+  /* File manifest for all scenery areas. Key is area number. Cleared for each compilation. */
+  QHash<int, atools::fs::scenery::SceneryAreaFiles> sceneryFiles;
+
 };
 
 } // namespace fs
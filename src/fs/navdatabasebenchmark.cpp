@@ -0,0 +1,594 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/navdatabasebenchmark.h"
+
+#include "fs/navdatabase.h"
+#include "fs/navdatabaseerrors.h"
+#include "fs/navdatabaseprogress.h"
+#include "geo/calculations.h"
+#include "geo/pos.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlutil.h"
+#include "atools.h"
+#include "exception.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+using atools::geo::Pos;
+
+namespace atools {
+namespace fs {
+
+namespace {
+
+/* Tables counted after compilation */
+const static QStringList BENCHMARK_TABLES({"airport", "runway", "runway_end", "parking", "taxi_path", "com",
+                                           "approach", "approach_leg", "waypoint", "vor", "ndb", "airway"});
+
+/* Small deterministic generator independent of the standard library implementation */
+class Random
+{
+public:
+  /* Value in range [min, max) */
+  float value(float min, float max)
+  {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return min + (max - min) * static_cast<float>(state >> 40) / static_cast<float>(1 << 24);
+  }
+
+  int intValue(int min, int max)
+  {
+    return std::min(max - 1, static_cast<int>(value(min, max)));
+  }
+
+  Pos pos()
+  {
+    float lonX = value(-175.f, 175.f);
+    return Pos(lonX, value(-55.f, 65.f));
+  }
+
+private:
+  quint64 state = 0x2545f4914f6cdd1dULL;
+};
+
+/* Ident of length letters from A to Z for number. Wraps around if number is too large. */
+QString letters(int number, int length)
+{
+  QString str(length, 'A');
+  for(int i = length - 1; i >= 0; i--)
+  {
+    str[i] = QChar('A' + number % 26);
+    number /= 26;
+  }
+  return str;
+}
+
+struct BenchmarkRunwayEnd
+{
+  QString name;
+  Pos pos;
+  float heading;
+};
+
+struct BenchmarkAirport
+{
+  QString ident;
+  Pos pos;
+  int elevationFt;
+
+  /* Primary and secondary ends of each runway in order */
+  QVector<BenchmarkRunwayEnd> ends;
+};
+
+/* Terminal fix ident for runway end and type 'I' for initial or 'F' for final approach fix */
+QString terminalFix(const BenchmarkAirport& airport, int end, char type)
+{
+  return airport.ident.mid(1) + QChar('A' + end) + type;
+}
+
+QString coord(float value)
+{
+  return QString::number(value, 'f', 8);
+}
+
+/* Create airports with one to three runways. Ends are numbered by heading. */
+QVector<BenchmarkAirport> createAirports(int numAirports)
+{
+  Random random;
+  QVector<BenchmarkAirport> airports;
+  for(int i = 0; i < numAirports; i++)
+  {
+    BenchmarkAirport airport;
+    airport.ident = "Z" + letters(i, 3);
+    airport.pos = random.pos();
+    airport.elevationFt = random.intValue(0, 5000);
+
+    int numRunways = random.intValue(1, 4);
+    float baseHeading = random.intValue(1, 6) * 10.f;
+    for(int r = 0; r < numRunways; r++)
+    {
+      float heading = baseHeading + r * 60.f;
+      float lengthMeter = random.value(1500.f, 3500.f);
+      int number = atools::roundToInt(heading / 10.f);
+
+      // Distinct runways are placed side by side
+      Pos center = airport.pos.endpoint(r * 1000.f, heading + 90.f);
+      airport.ends.append({QString("%1").arg(number, 2, 10, QChar('0')),
+                           center.endpoint(lengthMeter / 2.f, heading + 180.f), heading});
+      airport.ends.append({QString("%1").arg(number + 18, 2, 10, QChar('0')),
+                           center.endpoint(lengthMeter / 2.f, heading), heading + 180.f});
+    }
+    airports.append(airport);
+  }
+  return airports;
+}
+
+/* Airway with waypoints in about 60 NM distance */
+struct BenchmarkAirway
+{
+  QString name;
+  QVector<Pos> positions;
+  QStringList idents;
+};
+
+QVector<BenchmarkAirway> createAirways(int numAirways)
+{
+  Random random;
+  QVector<BenchmarkAirway> airways;
+  int waypointNum = 0;
+  for(int i = 0; i < numAirways; i++)
+  {
+    BenchmarkAirway airway;
+    airway.name = (i % 2 == 0 ? "J" : "V") + QString::number(i + 1);
+
+    Pos pos = random.pos();
+    float course = random.value(0.f, 360.f);
+    for(int w = 0; w < 10; w++)
+    {
+      airway.positions.append(pos);
+      airway.idents.append("W" + letters(waypointNum++, 4));
+      course += random.value(-20.f, 20.f);
+      pos = pos.endpoint(atools::geo::nmToMeter(60.f), course).normalize();
+    }
+    airways.append(airway);
+  }
+  return airways;
+}
+
+/* Open file or throw */
+void openFile(QFile& file, const QString& filename)
+{
+  file.setFileName(filename);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    throw atools::Exception(QString("Cannot open \"%1\" for writing: %2").arg(filename).arg(file.errorString()));
+}
+
+/* X-Plane header with byte order identifier and version */
+void writeHeader(QTextStream& stream, int version)
+{
+  stream << "I" << endl
+         << version << " Version - data cycle 2101, build 20210101, metadata XP" << version
+         << ". Synthetic benchmark data." << endl << endl;
+}
+
+void writeAptDat(const QString& filename, const QVector<BenchmarkAirport>& airports)
+{
+  QFile file;
+  openFile(file, filename);
+  QTextStream stream(&file);
+  stream.setCodec("UTF-8");
+  writeHeader(stream, 1100);
+
+  for(const BenchmarkAirport& airport : airports)
+  {
+    stream << "1 " << airport.elevationFt << " 0 0 " << airport.ident << " Synthetic " << airport.ident << endl;
+    stream << "1302 datum_lat " << coord(airport.pos.getLatY()) << endl;
+    stream << "1302 datum_lon " << coord(airport.pos.getLonX()) << endl;
+
+    // Runways with surface asphalt, edge lights and approach lights ===========================
+    for(int e = 0; e < airport.ends.size(); e += 2)
+    {
+      const BenchmarkRunwayEnd& prim = airport.ends.at(e);
+      const BenchmarkRunwayEnd& sec = airport.ends.at(e + 1);
+      stream << "100 45.00 1 0 0.25 1 2 1 "
+             << prim.name << " " << coord(prim.pos.getLatY()) << " " << coord(prim.pos.getLonX()) << " 0 0 3 8 1 1 "
+             << sec.name << " " << coord(sec.pos.getLatY()) << " " << coord(sec.pos.getLonX()) << " 0 0 3 8 1 1"
+             << endl;
+    }
+
+    // Frequencies
+    stream << "1051 128100 ATIS" << endl << "1053 121900 GND" << endl << "1054 118700 TWR" << endl;
+
+    // Gates and ramp parking in a row beside the first runway ===========================
+    const BenchmarkRunwayEnd& first = airport.ends.first();
+    Pos parkingStart = first.pos.endpoint(400.f, first.heading - 90.f);
+    for(int p = 0; p < 10; p++)
+    {
+      Pos pos = parkingStart.endpoint(p * 60.f, first.heading);
+      stream << "1300 " << coord(pos.getLatY()) << " " << coord(pos.getLonX()) << " "
+             << QString::number(atools::geo::normalizeCourse(first.heading + 90.f), 'f', 2) << " "
+             << (p < 5 ? "gate jets|turboprops" : "tie_down props") << " " << (p < 5 ? "A" : "R") << p + 1 << endl;
+      stream << "1301 " << (p < 5 ? "E" : "B") << (p < 5 ? " airline" : " general_aviation") << endl;
+    }
+
+    // Taxi network parallel to the first runway ===========================
+    stream << "1200" << endl;
+    Pos taxiStart = first.pos.endpoint(200.f, first.heading - 90.f);
+    for(int n = 0; n < 12; n++)
+    {
+      Pos pos = taxiStart.endpoint(n * 200.f, first.heading);
+      stream << "1201 " << coord(pos.getLatY()) << " " << coord(pos.getLonX()) << " both " << n << " n" << n << endl;
+    }
+    for(int n = 0; n < 11; n++)
+      stream << "1202 " << n << " " << n + 1 << " twoway taxiway_E " << (n % 2 == 0 ? "A" : "B") << endl;
+  }
+
+  stream << "99" << endl;
+  stream.flush();
+}
+
+void writeEarthFix(const QString& filename, const QVector<BenchmarkAirport>& airports,
+                   const QVector<BenchmarkAirway>& airways)
+{
+  QFile file;
+  openFile(file, filename);
+  QTextStream stream(&file);
+  stream.setCodec("UTF-8");
+  writeHeader(stream, 1101);
+
+  // Enroute waypoints of airways
+  for(const BenchmarkAirway& airway : airways)
+  {
+    for(int i = 0; i < airway.positions.size(); i++)
+      stream << coord(airway.positions.at(i).getLatY()) << " " << coord(airway.positions.at(i).getLonX()) << " "
+             << airway.idents.at(i) << " ENRT XX 2105430" << endl;
+  }
+
+  // Initial and final approach fixes for each runway end
+  for(const BenchmarkAirport& airport : airports)
+  {
+    for(int e = 0; e < airport.ends.size(); e++)
+    {
+      const BenchmarkRunwayEnd& end = airport.ends.at(e);
+      Pos iaf = end.pos.endpoint(atools::geo::nmToMeter(15.f), end.heading + 180.f);
+      Pos faf = end.pos.endpoint(atools::geo::nmToMeter(5.f), end.heading + 180.f);
+      stream << coord(iaf.getLatY()) << " " << coord(iaf.getLonX()) << " " << terminalFix(airport, e, 'I') << " "
+             << airport.ident << " XX 4530263" << endl;
+      stream << coord(faf.getLatY()) << " " << coord(faf.getLonX()) << " " << terminalFix(airport, e, 'F') << " "
+             << airport.ident << " XX 4530263" << endl;
+    }
+  }
+
+  stream << "99" << endl;
+  stream.flush();
+}
+
+void writeEarthNav(const QString& filename, int numNavaids)
+{
+  QFile file;
+  openFile(file, filename);
+  QTextStream stream(&file);
+  stream.setCodec("UTF-8");
+  writeHeader(stream, 1150);
+
+  Random random;
+  for(int i = 0; i < numNavaids; i++)
+  {
+    // VOR 108.00 to 117.95 MHz and NDB 200 to 999 kHz
+    Pos vor = random.pos(), ndb = random.pos();
+    QString vorIdent = letters(i, 3), ndbIdent = "N" + letters(i, 2);
+    stream << "3 " << coord(vor.getLatY()) << " " << coord(vor.getLonX()) << " 500 "
+           << 10800 + (i % 200) * 5 << " 130 0.0 " << vorIdent << " ENRT XX " << vorIdent << " VOR/DME" << endl;
+    stream << "12 " << coord(vor.getLatY()) << " " << coord(vor.getLonX()) << " 500 "
+           << 10800 + (i % 200) * 5 << " 130 0.000 " << vorIdent << " ENRT XX " << vorIdent << " VOR/DME" << endl;
+    stream << "2 " << coord(ndb.getLatY()) << " " << coord(ndb.getLonX()) << " 0 "
+           << 200 + (i % 800) << " 50 0.0 " << ndbIdent << " ENRT XX " << ndbIdent << " NDB" << endl;
+  }
+
+  stream << "99" << endl;
+  stream.flush();
+}
+
+void writeEarthAwy(const QString& filename, const QVector<BenchmarkAirway>& airways)
+{
+  QFile file;
+  openFile(file, filename);
+  QTextStream stream(&file);
+  stream.setCodec("UTF-8");
+  writeHeader(stream, 1100);
+
+  for(const BenchmarkAirway& airway : airways)
+  {
+    // Jet routes are high and victor airways low
+    bool high = airway.name.startsWith("J");
+    for(int i = 0; i < airway.idents.size() - 1; i++)
+      stream << airway.idents.at(i) << " XX 11 " << airway.idents.at(i + 1) << " XX 11 N "
+             << (high ? "2 180 450 " : "1 20 180 ") << airway.name << endl;
+  }
+
+  stream << "99" << endl;
+  stream.flush();
+}
+
+/* One CIFP procedure line. Fields not given are blank. */
+QString cifpLine(int seqNr, const QString& ident, const QString& fixIdent, const QString& region,
+                 const QString& subCode, const QString& descCode, const QString& pathTerm, int magCourse,
+                 const QString& altDescr, int altitude)
+{
+  QStringList fields;
+  for(int i = 0; i < 37; i++)
+    fields.append(" ");
+
+  // Index in list is field index - 2 since row code and sequence number are joined
+  fields[0] = "R"; // Route type RNAV
+  fields[1] = ident;
+  fields[3] = fixIdent;
+  fields[4] = region;
+  fields[5] = fixIdent.isEmpty() ? " " : "P";
+  fields[6] = fixIdent.isEmpty() ? " " : subCode;
+  fields[7] = descCode;
+  fields[10] = pathTerm;
+  if(magCourse >= 0)
+    fields[19] = QString("%1").arg(magCourse * 10, 4, 10, QChar('0'));
+  fields[21] = altDescr;
+  if(altitude > 0)
+    fields[22] = QString("%1").arg(altitude, 5, 10, QChar('0'));
+
+  return QString("APPCH:%1,").arg(seqNr * 10, 3, 10, QChar('0')) + fields.join(",") + ";";
+}
+
+void writeCifp(const QString& directory, const QVector<BenchmarkAirport>& airports)
+{
+  for(const BenchmarkAirport& airport : airports)
+  {
+    QFile file;
+    openFile(file, QDir(directory).filePath(airport.ident + ".dat"));
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    // RNAV approach for each runway end with missed approach
+    for(int e = 0; e < airport.ends.size(); e++)
+    {
+      const BenchmarkRunwayEnd& end = airport.ends.at(e);
+      QString ident = "R" + end.name;
+      int course = atools::roundToInt(atools::geo::normalizeCourse(end.heading));
+      int elevation = airport.elevationFt;
+
+      stream << cifpLine(1, ident, terminalFix(airport, e, 'I'), "XX", "C", "E  A", "IF", -1, "+",
+                         elevation + 4000) << endl;
+      stream << cifpLine(2, ident, terminalFix(airport, e, 'F'), "XX", "C", "E  F", "TF", -1, "@",
+                         elevation + 1600) << endl;
+      stream << cifpLine(3, ident, "RW" + end.name, "XX", "G", "GY M", "TF", -1, " ", elevation + 50) << endl;
+      stream << cifpLine(4, ident, QString(), " ", " ", "  M ", "CA", course, "+", elevation + 2000) << endl;
+      stream << cifpLine(5, ident, terminalFix(airport, e, 'I'), "XX", "C", "E   ", "DF", -1, "+",
+                         elevation + 4000) << endl;
+    }
+    stream.flush();
+  }
+}
+
+} // namespace
+
+NavDatabaseBenchmark::NavDatabaseBenchmark(const QString& directory)
+  : dir(directory)
+{
+  databaseFile = QDir(dir).filePath("benchmark.sqlite");
+}
+
+void NavDatabaseBenchmark::generate()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QDir base(dir);
+  QString dataDir = base.filePath("Resources/default data");
+  QString aptDir = base.filePath("Resources/default scenery/default apt dat/Earth nav data");
+  QString cifpDir = base.filePath("Resources/default data/CIFP");
+
+  for(const QString& path : {dataDir, aptDir, cifpDir})
+  {
+    if(!QDir().mkpath(path))
+      throw atools::Exception(QString("Cannot create directory \"%1\"").arg(path));
+  }
+
+  QVector<BenchmarkAirport> airports = createAirports(std::min(numAirports, 26 * 26 * 26));
+  QVector<BenchmarkAirway> airways = createAirways(numAirways);
+
+  writeAptDat(QDir(aptDir).filePath("apt.dat"), airports);
+  writeEarthFix(QDir(dataDir).filePath("earth_fix.dat"), airports, airways);
+  writeEarthNav(QDir(dataDir).filePath("earth_nav.dat"), std::min(numNavaids, 26 * 26 * 26));
+  writeEarthAwy(QDir(dataDir).filePath("earth_awy.dat"), airways);
+  writeCifp(cifpDir, airports);
+
+  generated = true;
+  generateMs = timer.elapsed();
+  qDebug() << Q_FUNC_INFO << dir << "airports" << airports.size() << "airways" << airways.size()
+           << "time" << generateMs << "ms";
+}
+
+bool NavDatabaseBenchmark::run()
+{
+  if(!generated)
+    generate();
+
+  phases.clear();
+  tables.clear();
+  numErrors = 0;
+  QFile::remove(databaseFile);
+
+  NavDatabaseOptions opts(options);
+  opts.setBasepath(dir);
+  opts.setSimulatorType(atools::fs::FsPaths::XPLANE11);
+
+  // Time between two progress reports is added to the phase of the earlier report
+  QElapsedTimer phaseTimer;
+  QString phaseName;
+  opts.setProgressCallback([this, &phaseTimer, &phaseName](const NavDatabaseProgress& progress) -> bool {
+    QString name = progress.getOtherAction();
+    if(name.isEmpty())
+      name = progress.getSceneryTitle();
+
+    if(name != phaseName || progress.isLastCall())
+    {
+      if(phaseTimer.isValid())
+        addPhase(phaseName, phaseTimer.restart());
+      else
+        phaseTimer.start();
+      phaseName = name;
+    }
+    return false;
+  });
+
+  const QString connectionName("navdb_benchmark");
+  bool success = true;
+  QElapsedTimer timer;
+  timer.start();
+  try
+  {
+    atools::sql::SqlDatabase db(atools::sql::SqlDatabase::addDatabase("QSQLITE", connectionName));
+    db.setDatabaseName(databaseFile);
+    db.open();
+
+    NavDatabaseErrors errors;
+    NavDatabase navDatabase(&opts, &db, &errors, QString());
+    navDatabase.create("UTF-8");
+    totalMs = timer.elapsed();
+    numErrors = errors.getTotalErrors();
+
+    atools::sql::SqlUtil util(db);
+    for(const QString& table : BENCHMARK_TABLES)
+      tables.append({table, util.hasTable(table) ? util.rowCount(table) : 0});
+    db.close();
+  }
+  catch(std::exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Caught exception" << e.what();
+    totalMs = timer.elapsed();
+    success = false;
+  }
+  atools::sql::SqlDatabase::removeDatabase(connectionName);
+
+  peakRss = peakResidentBytes();
+
+  qDebug() << Q_FUNC_INFO << "total" << totalMs << "ms" << "peak RSS" << peakRss / 1024 / 1024 << "MB"
+           << "errors" << numErrors;
+  for(const NavDatabaseBenchmarkPhase& phase : phases)
+    qDebug() << Q_FUNC_INFO << phase.name << phase.timeMs << "ms";
+  for(const NavDatabaseBenchmarkTable& table : tables)
+    qDebug() << Q_FUNC_INFO << table.name << table.rows << "rows";
+
+  return success;
+}
+
+void NavDatabaseBenchmark::addPhase(const QString& name, qint64 timeMs)
+{
+  // Phases reported more than once are summed up
+  for(NavDatabaseBenchmarkPhase& phase : phases)
+  {
+    if(phase.name == name)
+    {
+      phase.timeMs += timeMs;
+      return;
+    }
+  }
+  phases.append({name, timeMs});
+}
+
+qint64 NavDatabaseBenchmark::peakResidentBytes()
+{
+#if defined(Q_OS_UNIX)
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) == 0)
+#if defined(Q_OS_MACOS)
+    // Bytes on macOS
+    return static_cast<qint64>(usage.ru_maxrss);
+#else
+    // Kilobytes on Linux
+    return static_cast<qint64>(usage.ru_maxrss) * 1024L;
+#endif
+#endif
+  return -1L;
+}
+
+QJsonDocument NavDatabaseBenchmark::toJson() const
+{
+  QJsonObject scale;
+  scale.insert("airports", numAirports);
+  scale.insert("airways", numAirways);
+  scale.insert("navaids", numNavaids);
+
+  QJsonArray phaseArr;
+  for(const NavDatabaseBenchmarkPhase& phase : phases)
+  {
+    QJsonObject obj;
+    obj.insert("name", phase.name);
+    obj.insert("time_ms", static_cast<double>(phase.timeMs));
+    phaseArr.append(obj);
+  }
+
+  int totalRows = 0;
+  QJsonArray tableArr;
+  for(const NavDatabaseBenchmarkTable& table : tables)
+  {
+    QJsonObject obj;
+    obj.insert("name", table.name);
+    obj.insert("rows", table.rows);
+    tableArr.append(obj);
+    totalRows += table.rows;
+  }
+
+  QJsonObject root;
+  root.insert("scale", scale);
+  root.insert("generate_ms", static_cast<double>(generateMs));
+  root.insert("total_ms", static_cast<double>(totalMs));
+  root.insert("peak_rss_bytes", static_cast<double>(peakRss));
+  root.insert("errors", numErrors);
+  root.insert("rows_per_second", totalMs > 0 ? totalRows * 1000. / totalMs : 0.);
+  root.insert("phases", phaseArr);
+  root.insert("tables", tableArr);
+  return QJsonDocument(root);
+}
+
+bool NavDatabaseBenchmark::writeJson(const QString& filename) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(toJson().toJson(QJsonDocument::Indented));
+    file.close();
+    return true;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << ":" << file.errorString();
+  return false;
+}
+
+} // namespace fs
+} // namespace atools
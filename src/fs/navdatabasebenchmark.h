@@ -0,0 +1,126 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_NAVDATABASEBENCHMARK_H
+#define ATOOLS_FS_NAVDATABASEBENCHMARK_H
+
+#include "fs/navdatabaseoptions.h"
+
+#include <QJsonDocument>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+
+/* Time spent in one compilation phase as reported by the progress callback */
+struct NavDatabaseBenchmarkPhase
+{
+  QString name;
+  qint64 timeMs = 0L;
+};
+
+/* Number of rows in a table after compilation */
+struct NavDatabaseBenchmarkTable
+{
+  QString name;
+  int rows = 0;
+};
+
+/*
+ * Reproducible performance measurement for scenery library compilation which does not need licensed scenery.
+ *
+ * Generates a synthetic X-Plane installation with apt.dat containing airports with runways, parking,
+ * taxi paths and frequencies, earth_fix.dat, earth_nav.dat, earth_awy.dat and one CIFP file with approaches
+ * for each airport. Content is deterministic for a given scale.
+ *
+ * run() compiles the corpus with NavDatabase::create() into a new database and collects the time for
+ * each phase, total time, peak resident memory and rows per second for the main tables.
+ */
+class NavDatabaseBenchmark
+{
+public:
+  /* Corpus and database are created in directory */
+  explicit NavDatabaseBenchmark(const QString& directory);
+
+  /* Number of airports. Each one has one to three runways. Default is 2000. */
+  void setNumAirports(int value)
+  {
+    numAirports = value;
+  }
+
+  /* Number of airways. Each one has ten waypoints. Default is 500. */
+  void setNumAirways(int value)
+  {
+    numAirways = value;
+  }
+
+  /* Number of VOR and NDB each. Default is 1000. */
+  void setNumNavaids(int value)
+  {
+    numNavaids = value;
+  }
+
+  /* Options used for compilation. Base path, simulator type and progress callback are replaced. */
+  void setOptions(const atools::fs::NavDatabaseOptions& value)
+  {
+    options = value;
+  }
+
+  /* Write the X-Plane corpus into the directory. Throws Exception on error. */
+  void generate();
+
+  /* Compile the corpus once. Calls generate() if not done before. Returns false if compilation failed. */
+  bool run();
+
+  const QVector<atools::fs::NavDatabaseBenchmarkPhase>& getPhases() const
+  {
+    return phases;
+  }
+
+  const QVector<atools::fs::NavDatabaseBenchmarkTable>& getTables() const
+  {
+    return tables;
+  }
+
+  /* Machine readable report including scale, phases, memory and table rows */
+  QJsonDocument toJson() const;
+
+  /* Write JSON report to file. Returns false on error. */
+  bool writeJson(const QString& filename) const;
+
+  /* Peak resident set size of this process in bytes or -1 if not available on this platform */
+  static qint64 peakResidentBytes();
+
+private:
+  void addPhase(const QString& name, qint64 timeMs);
+
+  QString dir, databaseFile;
+  atools::fs::NavDatabaseOptions options;
+  int numAirports = 2000, numAirways = 500, numNavaids = 1000;
+  bool generated = false;
+
+  QVector<atools::fs::NavDatabaseBenchmarkPhase> phases;
+  QVector<atools::fs::NavDatabaseBenchmarkTable> tables;
+  qint64 generateMs = 0L, totalMs = 0L, peakRss = -1L;
+  int numErrors = 0;
+};
+
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_NAVDATABASEBENCHMARK_H
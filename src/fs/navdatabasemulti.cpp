@@ -0,0 +1,212 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/navdatabasemulti.h"
+
+#include "fs/navdatabase.h"
+#include "fs/navdatabaseprogress.h"
+#include "fs/common/magdecreader.h"
+#include "sql/sqldatabase.h"
+#include "exception.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace atools {
+namespace fs {
+
+namespace {
+
+/* Runs the compilation of one target */
+class NavDatabaseRunnable :
+  public QRunnable
+{
+public:
+  NavDatabaseRunnable(const std::function<void()>& funcParam)
+    : func(funcParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    func();
+  }
+
+private:
+  std::function<void()> func;
+};
+
+} // namespace
+
+NavDatabaseMulti::NavDatabaseMulti(const QString& revision)
+  : gitRevision(revision)
+{
+}
+
+NavDatabaseMulti::~NavDatabaseMulti()
+{
+  delete magDecReader;
+}
+
+int NavDatabaseMulti::addTarget(const NavDatabaseOptions& options, const QString& databaseFile, const QString& codec)
+{
+  NavDatabaseTarget target;
+  target.options = options;
+  target.databaseFile = databaseFile;
+  target.codec = codec;
+  targets.append(target);
+  return targets.size() - 1;
+}
+
+bool NavDatabaseMulti::create(int maxParallel)
+{
+  if(targets.isEmpty())
+    return true;
+
+  canceled.store(false);
+
+  // Calculate shared inputs once ==========================================
+  if(magDecReader == nullptr)
+  {
+    magDecReader = new atools::fs::common::MagDecReader;
+    magDecReader->readFromWmm();
+  }
+
+  for(int i = 0; i < targets.size(); i++)
+  {
+    NavDatabaseTarget& target = targets[i];
+    target.errors = NavDatabaseErrors();
+    target.errorMessage.clear();
+    target.aborted = false;
+    target.elapsedMs = 0L;
+
+    target.options.setSharedMagDecReader(magDecReader);
+
+    // Chain own callback after the one given by the caller
+    NavDatabaseOptions::ProgressCallbackType targetCallback = target.options.getProgressCallback();
+    target.options.setProgressCallback([this, i, targetCallback](const NavDatabaseProgress& progress) -> bool {
+      bool abort = targetCallback ? targetCallback(progress) : false;
+      return reportProgress(i, progress) || abort;
+    });
+  }
+
+  // Run compilations in own threads which do not block the task scheduler used inside the compilers
+  QThreadPool pool;
+  pool.setMaxThreadCount(maxParallel > 0 ? std::min(maxParallel, targets.size()) : targets.size());
+  for(int i = 0; i < targets.size(); i++)
+    pool.start(new NavDatabaseRunnable([this, i]() {
+      createTarget(i);
+    }));
+  pool.waitForDone();
+
+  for(const QString& line : getReport())
+    qInfo().noquote() << Q_FUNC_INFO << line;
+
+  return getNumFailed() == 0;
+}
+
+void NavDatabaseMulti::createTarget(int index)
+{
+  NavDatabaseTarget& target = targets[index];
+  QElapsedTimer timer;
+  timer.start();
+
+  // Connections cannot be shared between threads - use one per target
+  QString connectionName = QString("navdb_multi_%1").arg(index);
+  try
+  {
+    atools::sql::SqlDatabase db(atools::sql::SqlDatabase::addDatabase("QSQLITE", connectionName));
+    db.setDatabaseName(target.databaseFile);
+    db.open();
+
+    NavDatabase navDatabase(&target.options, &db, &target.errors, gitRevision);
+    navDatabase.create(target.codec);
+    target.aborted = navDatabase.isAborted();
+
+    db.close();
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << target.databaseFile << "Caught exception" << e.what();
+    target.errorMessage = e.getMessage();
+  }
+  catch(std::exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << target.databaseFile << "Caught exception" << e.what();
+    target.errorMessage = QString::fromUtf8(e.what());
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << target.databaseFile << "Caught unknown exception";
+    target.errorMessage = tr("Unknown exception");
+  }
+
+  atools::sql::SqlDatabase::removeDatabase(connectionName);
+  target.elapsedMs = timer.elapsed();
+}
+
+bool NavDatabaseMulti::reportProgress(int index, const NavDatabaseProgress& progress)
+{
+  if(progressCallback)
+  {
+    QMutexLocker locker(&progressMutex);
+    if(progressCallback(index, progress))
+      return true;
+  }
+  return canceled.load();
+}
+
+int NavDatabaseMulti::getNumFailed() const
+{
+  int num = 0;
+  for(const NavDatabaseTarget& target : targets)
+  {
+    if(!target.isSuccess())
+      num++;
+  }
+  return num;
+}
+
+int NavDatabaseMulti::getTotalErrors() const
+{
+  int num = 0;
+  for(const NavDatabaseTarget& target : targets)
+    num += target.errors.getTotalErrors();
+  return num;
+}
+
+QStringList NavDatabaseMulti::getReport() const
+{
+  QStringList report;
+  for(const NavDatabaseTarget& target : targets)
+  {
+    QString state = target.aborted ? tr("aborted") :
+                    (target.errorMessage.isEmpty() ? tr("done") : tr("failed: %1").arg(target.errorMessage));
+    report.append(tr("%1 \"%2\" %3 in %4 seconds with %5 errors").
+                  arg(FsPaths::typeToShortName(target.options.getSimulatorType())).
+                  arg(target.databaseFile).arg(state).
+                  arg(target.elapsedMs / 1000.).arg(target.errors.getTotalErrors()));
+  }
+  return report;
+}
+
+} // namespace fs
+} // namespace atools
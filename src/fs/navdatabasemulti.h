@@ -0,0 +1,145 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_NAVDATABASEMULTI_H
+#define ATOOLS_FS_NAVDATABASEMULTI_H
+
+#include "fs/navdatabaseerrors.h"
+#include "fs/navdatabaseoptions.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+namespace atools {
+namespace fs {
+
+namespace common {
+class MagDecReader;
+}
+
+class NavDatabaseProgress;
+
+/* State and result of one compilation in NavDatabaseMulti */
+struct NavDatabaseTarget
+{
+  /* Copy of the options given to NavDatabaseMulti::addTarget() */
+  atools::fs::NavDatabaseOptions options;
+  QString databaseFile, codec;
+
+  /* Errors collected while reading scenery */
+  atools::fs::NavDatabaseErrors errors;
+
+  /* Message of exception if compilation failed */
+  QString errorMessage;
+  bool aborted = false;
+  qint64 elapsedMs = 0L;
+
+  bool isSuccess() const
+  {
+    return !aborted && errorMessage.isEmpty();
+  }
+
+};
+
+/*
+ * Compiles several navigation databases, e.g. for different simulators, concurrently.
+ * Each target is compiled by NavDatabase::create() in its own thread into a separate SQLite database file
+ * using its own connection.
+ *
+ * Inputs which are the same for all targets are prepared only once and shared read-only. This is
+ * currently the declination grid of the world magnetic model.
+ *
+ * Progress reports of all targets are passed to one callback which is never called concurrently.
+ */
+class NavDatabaseMulti
+{
+  Q_DECLARE_TR_FUNCTIONS(NavDatabaseMulti)
+
+public:
+  /* Gets index of target and its progress. Return true to abort this target. */
+  typedef std::function<bool (int target, const atools::fs::NavDatabaseProgress&)> ProgressCallbackType;
+
+  explicit NavDatabaseMulti(const QString& revision);
+  ~NavDatabaseMulti();
+
+  NavDatabaseMulti(const NavDatabaseMulti& other) = delete;
+  NavDatabaseMulti& operator=(const NavDatabaseMulti& other) = delete;
+
+  /* Add a compilation. Options are copied. A progress callback in options is called in the compiling thread
+   * before the callback of this class. databaseFile is created if it does not exist. Returns index of target. */
+  int addTarget(const atools::fs::NavDatabaseOptions& options, const QString& databaseFile,
+                const QString& codec = "UTF-8");
+
+  /* Compile all targets and wait until finished. Runs at most maxParallel compilations at the same time or
+   * one per target if zero. Does not throw. Returns true if all targets were compiled successfully. */
+  bool create(int maxParallel = 0);
+
+  /* Abort all running compilations. Thread safe. */
+  void cancel()
+  {
+    canceled.store(true);
+  }
+
+  void setProgressCallback(const ProgressCallbackType& value)
+  {
+    progressCallback = value;
+  }
+
+  /* States after create() in the order of addTarget() */
+  const QVector<atools::fs::NavDatabaseTarget>& getTargets() const
+  {
+    return targets;
+  }
+
+  /* Number of failed or aborted targets */
+  int getNumFailed() const;
+
+  /* Sum of scenery errors across all targets */
+  int getTotalErrors() const;
+
+  /* Summary of all targets for logging */
+  QStringList getReport() const;
+
+private:
+  /* Compile target at index in the calling thread */
+  void createTarget(int index);
+
+  /* Called from all compilation threads */
+  bool reportProgress(int index, const atools::fs::NavDatabaseProgress& progress);
+
+  QVector<atools::fs::NavDatabaseTarget> targets;
+  QString gitRevision;
+  ProgressCallbackType progressCallback;
+
+  /* Shared input calculated once in create() */
+  atools::fs::common::MagDecReader *magDecReader = nullptr;
+
+  /* Serializes progressCallback */
+  QMutex progressMutex;
+  std::atomic<bool> canceled{false};
+};
+
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_NAVDATABASEMULTI_H
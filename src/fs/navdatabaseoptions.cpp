@@ -18,6 +18,7 @@
 #include "fs/navdatabaseoptions.h"
 #include "scenery/sceneryarea.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QFileInfo>
 #include <QList>
@@ -108,6 +109,11 @@ bool NavDatabaseOptions::isIncludedAirportIdent(const QString& icao) const
   return includeObject(icao, airportIcaoFiltersInc, airportIcaoFiltersExcl);
 }
 
+bool NavDatabaseOptions::isIncludedAirportPos(const geo::Pos& pos) const
+{
+  return !airportBoundingRect.isValid() || airportBoundingRect.contains(pos);
+}
+
 void NavDatabaseOptions::addToFilenameFilterInclude(const QStringList& filter)
 {
   addToFilter(filter, fileFiltersInc);
@@ -214,6 +220,7 @@ void NavDatabaseOptions::loadFromSettings(QSettings& settings)
   setResolveAirways(settings.value("Options/ResolveRoutes", true).toBool());
   setLanguage(settings.value("Options/MsfsAirportLanguage", "en-US").toString());
   setCreateRouteTables(settings.value("Options/CreateRouteTables", false).toBool());
+  setCreateRouteShortcuts(settings.value("Options/CreateRouteShortcuts", false).toBool());
   setDatabaseReport(settings.value("Options/DatabaseReport", true).toBool());
   setDeletes(settings.value("Options/ProcessDelete", true).toBool());
   setDeduplicate(settings.value("Options/Deduplicate", true).toBool());
@@ -224,6 +231,21 @@ void NavDatabaseOptions::loadFromSettings(QSettings& settings)
   setFlag(type::VACUUM_DATABASE, settings.value("Options/VacuumDatabase", true).toBool());
   setFlag(type::ANALYZE_DATABASE, settings.value("Options/AnalyzeDatabase", true).toBool());
   setFlag(type::DROP_INDEXES, settings.value("Options/DropAllIndexes", false).toBool());
+  setSkipUnchanged(settings.value("Options/SkipUnchanged", false).toBool());
+  setBulkCompile(settings.value("Options/BulkCompile", false).toBool());
+  setBatchDeletes(settings.value("Options/BatchDeletes", true).toBool());
+  setParallelAptDat(settings.value("Options/ParallelAptDat", true).toBool());
+  setProcedureGeometry(settings.value("Options/ProcedureGeometry", false).toBool());
+  setAirwaysInMemory(settings.value("Options/AirwaysInMemory", true).toBool());
+  setSceneryFileManifest(settings.value("Options/SceneryFileManifest", true).toBool());
+  setSpatialIndex(settings.value("Options/SpatialIndex", false).toBool());
+  setFullTextIndex(settings.value("Options/FullTextIndex", false).toBool());
+  setDatabaseReportFast(settings.value("Options/DatabaseReportFast", false).toBool());
+  setWriterBatchSize(settings.value("Options/WriterBatchSize", 100).toInt());
+  setSortThreads(settings.value("Options/SortThreads", 0).toInt());
+  setXpNavdataCachePath(settings.value("Options/XPlaneNavdataCache").toString());
+  setBglFileCache(settings.value("Options/BglFileCache").toString());
+  setCompressedDatabaseFile(settings.value("Options/CompressedDatabaseFile").toString());
 
   addToHighPriorityFiltersInc(settings.value("Filter/IncludeHighPriorityFilter").toStringList());
 
@@ -238,6 +260,14 @@ void NavDatabaseOptions::loadFromSettings(QSettings& settings)
   addToBglObjectFilterInclude(settings.value("Filter/IncludeBglObjectFilter").toStringList());
   addToBglObjectFilterExclude(settings.value("Filter/ExcludeBglObjectFilter").toStringList());
 
+  // Rectangle as left, top, right, bottom in degree
+  QStringList rect = settings.value("Filter/IncludeAirportBoundingRect").toStringList();
+  if(rect.size() == 4)
+    setAirportBoundingRect(atools::geo::Rect(rect.at(0).toFloat(), rect.at(1).toFloat(),
+                                             rect.at(2).toFloat(), rect.at(3).toFloat()));
+  else if(!rect.isEmpty())
+    qWarning() << Q_FUNC_INFO << "Invalid airport bounding rectangle" << rect;
+
   settings.beginGroup("BasicValidationTables");
 
   QString simStr = simulatorType == FsPaths::DFD ? "DFD" : FsPaths::typeToShortName(simulatorType);
@@ -325,6 +355,13 @@ QStringList NavDatabaseOptions::fromNativeSeparators(const QStringList& paths) c
   return retval;
 }
 
+QByteArray NavDatabaseOptions::getOptionsHash() const
+{
+  QString str;
+  QDebug(&str) << *this;
+  return QCryptographicHash::hash(str.toUtf8(), QCryptographicHash::Sha1);
+}
+
 QDebug operator<<(QDebug out, const NavDatabaseOptions& opts)
 {
   QDebugStateSaver saver(out);
@@ -394,6 +431,13 @@ QDebug operator<<(QDebug out, const NavDatabaseOptions& opts)
     out << type::navDbObjectTypeToString(type) << ", ";
 
   out << "]";
+  out << ", Airport bounding rectangle " << opts.airportBoundingRect;
+  out << ", Writer batch size " << opts.writerBatchSize;
+  out << ", Sort threads " << opts.sortThreads;
+  out << ", X-Plane navdata cache " << opts.xpNavdataCachePath;
+  out << ", BGL file cache " << opts.bglFileCache;
+  out << ", GLOBE data " << opts.globeDataPath;
+  out << ", Compressed database file " << opts.compressedDatabaseFile;
   out << "]";
   return out;
 }
@@ -19,6 +19,7 @@
 #define ATOOLS_FS_NAVDATABASEOPTIONS_H
 
 #include "fs/fspaths.h"
+#include "geo/rect.h"
 
 #include <functional>
 
@@ -35,6 +36,10 @@ namespace fs {
 
 class NavDatabaseProgress;
 
+namespace common {
+class MagDecReader;
+}
+
 namespace type {
 
 /* Used to enable/disable loading of BGL objects/records and files for X-Plane. */
@@ -134,7 +139,72 @@ enum OptionFlag
   ANALYZE_DATABASE = 1 << 13,
 
   /* Remove all indexes */
-  DROP_INDEXES = 1 << 14
+  DROP_INDEXES = 1 << 14,
+
+  /*
+   * If true create table route_shortcut_airway which speeds up airway routing. Default is false.
+   */
+  CREATE_ROUTE_SHORTCUTS = 1 << 15,
+
+  /*
+   * Skip loading if no scenery area changed since the last compilation into the same database.
+   * Any change still results in a full compilation. Only FSX, P3D and MSFS. Default is false.
+   */
+  SKIP_UNCHANGED = 1 << 16,
+
+  /*
+   * Create secondary indexes not needed during loading only after loading and use fast but unsafe pragmas
+   * (no journal, no sync, exclusive locking) while compiling. Default is false.
+   */
+  BULK_COMPILE = 1 << 17,
+
+  /*
+   * Collect airports replaced by add-ons in a scenery area and delete or update their features
+   * with a few statements per table at the end of the area. Default is true.
+   */
+  BATCH_DELETES = 1 << 18,
+
+  /*
+   * Read and tokenize X-Plane custom scenery apt.dat files in a thread pool. Files are still written in
+   * scenery_packs.ini order. Default is true.
+   */
+  PARALLEL_APT_DAT = 1 << 19,
+
+  /*
+   * Calculate an approximated line geometry for all procedures and store it in table procedure_geometry.
+   * Default is false.
+   */
+  PROCEDURE_GEOMETRY = 1 << 20,
+
+  /*
+   * Resolve airways with hash tables in memory and build fragments in parallel instead of joining
+   * the temporary tables in SQL. Default is true.
+   */
+  AIRWAYS_IN_MEMORY = 1 << 21,
+
+  /*
+   * Resolve the files of all scenery areas once and use the result for progress totals, change detection
+   * and reading. Progress is weighted by file size. Default is true.
+   */
+  SCENERY_FILE_MANIFEST = 1 << 22,
+
+  /*
+   * Create R*Tree virtual tables like "airport_rtree" for all tables with coordinates at the end of
+   * the compilation. See atools::sql::SqlSpatialIndex. Default is false.
+   */
+  SPATIAL_INDEX = 1 << 23,
+
+  /*
+   * Create FTS5 tables "airport_fts" and "nav_search_fts" for prefix searches on idents and names at the end of
+   * the compilation. Skipped if SQLite has no FTS5. See atools::sql::SqlFullTextIndex. Default is false.
+   */
+  FULL_TEXT_INDEX = 1 << 24,
+
+  /*
+   * Print only row counts of all tables in the database report and omit the reports on values,
+   * duplicates and coordinate ranges. Default is false.
+   */
+  DATABASE_REPORT_FAST = 1 << 25
 };
 
 Q_DECLARE_FLAGS(OptionFlags, OptionFlag);
@@ -267,6 +337,74 @@ public:
     flags.setFlag(type::CREATE_ROUTE_TABLES, value);
   }
 
+  /*
+   * If true create table route_shortcut_airway which speeds up airway routing. Default is false.
+   */
+  void setCreateRouteShortcuts(bool value)
+  {
+    flags.setFlag(type::CREATE_ROUTE_SHORTCUTS, value);
+  }
+
+  /* Skip loading if scenery areas did not change since last compilation. Otherwise the database is compiled
+   * fully. Only FSX, P3D and MSFS. */
+  void setSkipUnchanged(bool value)
+  {
+    flags.setFlag(type::SKIP_UNCHANGED, value);
+  }
+
+  /* Defer index creation and use bulk load pragmas. An aborted compilation leaves an incomplete database. */
+  void setBulkCompile(bool value)
+  {
+    flags.setFlag(type::BULK_COMPILE, value);
+  }
+
+  /* Process airport deletes set based for each scenery area instead of per airport */
+  void setBatchDeletes(bool value)
+  {
+    flags.setFlag(type::BATCH_DELETES, value);
+  }
+
+  /* Read several X-Plane custom apt.dat files concurrently */
+  void setParallelAptDat(bool value)
+  {
+    flags.setFlag(type::PARALLEL_APT_DAT, value);
+  }
+
+  /* Fill table procedure_geometry after loading procedures */
+  void setProcedureGeometry(bool value)
+  {
+    flags.setFlag(type::PROCEDURE_GEOMETRY, value);
+  }
+
+  /* Use the in-memory airway resolver */
+  void setAirwaysInMemory(bool value)
+  {
+    flags.setFlag(type::AIRWAYS_IN_MEMORY, value);
+  }
+
+  /* Build the scenery file list only once per compilation */
+  void setSceneryFileManifest(bool value)
+  {
+    flags.setFlag(type::SCENERY_FILE_MANIFEST, value);
+  }
+
+  /* Create R*Tree spatial indexes for all tables with coordinates */
+  void setSpatialIndex(bool value)
+  {
+    flags.setFlag(type::SPATIAL_INDEX, value);
+  }
+
+  /* Create FTS5 full text indexes for airport and navaid search */
+  void setFullTextIndex(bool value)
+  {
+    flags.setFlag(type::FULL_TEXT_INDEX, value);
+  }
+
+  void setDatabaseReportFast(bool value)
+  {
+    flags.setFlag(type::DATABASE_REPORT_FAST, value);
+  }
+
   /* Reads all inactive scenery regions if set to true */
   void setReadInactive(bool value)
   {
@@ -296,6 +434,13 @@ public:
     simulatorType = value;
   }
 
+  /* Precomputed world magnetic model shared between compilations. Not owned and not loaded from config files.
+   * Compilers copy the values instead of calculating the model if set. Null by default. */
+  void setSharedMagDecReader(const atools::fs::common::MagDecReader *value)
+  {
+    sharedMagDecReader = value;
+  }
+
   // -------------------------------- getters below
 
   const QString& getBasepath() const
@@ -390,6 +535,61 @@ public:
     return flags & type::CREATE_ROUTE_TABLES;
   }
 
+  bool isCreateRouteShortcuts() const
+  {
+    return flags & type::CREATE_ROUTE_SHORTCUTS;
+  }
+
+  bool isSkipUnchanged() const
+  {
+    return flags & type::SKIP_UNCHANGED;
+  }
+
+  bool isBulkCompile() const
+  {
+    return flags & type::BULK_COMPILE;
+  }
+
+  bool isBatchDeletes() const
+  {
+    return flags & type::BATCH_DELETES;
+  }
+
+  bool isParallelAptDat() const
+  {
+    return flags & type::PARALLEL_APT_DAT;
+  }
+
+  bool isProcedureGeometry() const
+  {
+    return flags & type::PROCEDURE_GEOMETRY;
+  }
+
+  bool isAirwaysInMemory() const
+  {
+    return flags & type::AIRWAYS_IN_MEMORY;
+  }
+
+  bool isSceneryFileManifest() const
+  {
+    return flags & type::SCENERY_FILE_MANIFEST;
+  }
+
+  bool isSpatialIndex() const
+  {
+    return flags & type::SPATIAL_INDEX;
+  }
+
+  bool isFullTextIndex() const
+  {
+    return flags & type::FULL_TEXT_INDEX;
+  }
+
+  bool isDatabaseReportFast() const
+  {
+    return flags & type::DATABASE_REPORT_FAST;
+  }
+
   bool isReadInactive() const
   {
     return flags & type::READ_INACTIVE;
@@ -407,6 +607,20 @@ public:
   bool isIncludedLocalPath(const QString& filepath) const;
   bool isIncludedAirportIdent(const QString& icao) const;
 
+  /* Airport reference position is within bounding rectangle. Always true if rectangle is not set. */
+  bool isIncludedAirportPos(const atools::geo::Pos& pos) const;
+
+  /* Only airports inside this rectangle are read. Default is an invalid rectangle which includes all. */
+  void setAirportBoundingRect(const atools::geo::Rect& value)
+  {
+    airportBoundingRect = value;
+  }
+
+  const atools::geo::Rect& getAirportBoundingRect() const
+  {
+    return airportBoundingRect;
+  }
+
   /* Options that are not saved with the object */
   bool isIncludedDirectory(const QString& dirpath) const;
   bool isIncludedFilePath(const QString& filepath) const;
@@ -421,6 +635,11 @@ public:
 
   ProgressCallbackType getProgressCallback() const;
 
+  const atools::fs::common::MagDecReader *getSharedMagDecReader() const
+  {
+    return sharedMagDecReader;
+  }
+
   atools::fs::FsPaths::SimulatorType getSimulatorType() const
   {
     return simulatorType;
@@ -450,6 +669,82 @@ public:
     basicValidationTables = value;
   }
 
+  /* Number of rows inserted with one statement for airport features like parking, taxi paths and procedure legs.
+   * 1 disables batching. Default is 100. */
+  int getWriterBatchSize() const
+  {
+    return writerBatchSize;
+  }
+
+  void setWriterBatchSize(int value)
+  {
+    writerBatchSize = value;
+  }
+
+  /* Number of SQLite worker threads used for sorting in index creation and post processing scripts.
+   * -1 uses the number of cores. Default is 0 which does not change the SQLite setting. */
+  int getSortThreads() const
+  {
+    return sortThreads;
+  }
+
+  void setSortThreads(int value)
+  {
+    sortThreads = value;
+  }
+
+  /* Directory for the cache of parsed X-Plane earth_fix.dat, earth_nav.dat and earth_awy.dat files.
+   * Also stores the airport indexes of apt.dat files. Cache is disabled if empty which is the default. */
+  const QString& getXpNavdataCachePath() const
+  {
+    return xpNavdataCachePath;
+  }
+
+  void setXpNavdataCachePath(const QString& value)
+  {
+    xpNavdataCachePath = value;
+  }
+
+  /* File caching the BGL files without relevant content. Cache is disabled if empty which is the default. */
+  const QString& getBglFileCache() const
+  {
+    return bglFileCache;
+  }
+
+  void setBglFileCache(const QString& value)
+  {
+    bglFileCache = value;
+  }
+
+  /* Directory of the GLOBE elevation files. The MORA grid is calculated from these if the source has no MORA data,
+   * i.e. for all simulators and for Navigraph sources without grid MORA. Disabled if empty which is the default. */
+  const QString& getGlobeDataPath() const
+  {
+    return globeDataPath;
+  }
+
+  void setGlobeDataPath(const QString& value)
+  {
+    globeDataPath = value;
+  }
+
+  /* Output file for a page compressed read-only copy of the database written after compilation.
+   * Can be opened by SqlDatabase in read-only mode. No copy is written if empty which is the default.
+   * Needs ATOOLS_SQLITE_NATIVE for reading. */
+  const QString& getCompressedDatabaseFile() const
+  {
+    return compressedDatabaseFile;
+  }
+
+  void setCompressedDatabaseFile(const QString& value)
+  {
+    compressedDatabaseFile = value;
+  }
+
+  /* Hash over all options and filters as printed by the debug output operator.
+   * Used to invalidate caches if options change. */
+  QByteArray getOptionsHash() const;
+
   /* Language for MSFS airport, city and country names like "en-US" or "de-DE" */
   QString getLanguage() const
   {
@@ -485,6 +780,7 @@ private:
   QStringList createFilterList(const QStringList& pathList);
 
   QString sceneryFile, basepath, msfsCommunityPath, msfsOfficialPath, sourceDatabase, language = "en-US";
+  QString xpNavdataCachePath, bglFileCache, compressedDatabaseFile, globeDataPath;
 
   atools::fs::type::OptionFlags flags;
 
@@ -496,7 +792,10 @@ private:
                  filePathExcludesGui /* Not loaded from config file */,
                  addonDirExcludes /* Not loaded from config file */;
   QSet<atools::fs::type::NavDbObjectType> navDbObjectTypeFiltersInc, navDbObjectTypeFiltersExcl;
+  atools::geo::Rect airportBoundingRect;
+  int writerBatchSize = 100, sortThreads = 0;
   ProgressCallbackType progressCallback = nullptr;
+  const atools::fs::common::MagDecReader *sharedMagDecReader = nullptr;
 
   atools::fs::FsPaths::SimulatorType simulatorType = atools::fs::FsPaths::FSX;
 };
@@ -209,6 +209,14 @@ public:
     return numObjectsWritten;
   }
 
+  /*
+   * @return total number of bytes of scenery files read so far
+   */
+  qint64 getNumBytesRead() const
+  {
+    return numBytesRead;
+  }
+
   /*
    * @return total number of errors/exceptions during BGL loading
    */
@@ -222,6 +230,7 @@ private:
 
   int numFiles = 0, numAirports = 0, numNamelists = 0, numVors = 0, numIls = 0, numNdbs = 0, numMarker = 0,
       numBoundaries = 0, numWaypoints = 0, numObjectsWritten = 0, numErrors = 0;
+  qint64 numBytesRead = 0L;
 
   int total = 0, current = 0, lastCurrent = 0;
   bool newFile = false, newSceneryArea = false, newOther = false, firstCall = true, lastCall = false;
@@ -0,0 +1,110 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/ns/aircrafteventpublisher.h"
+
+#include "fs/sc/datareaderthread.h"
+#include "fs/sc/simconnectuseraircraft.h"
+#include "httpserver/httpeventchannel.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace atools {
+namespace fs {
+namespace ns {
+
+AircraftEventPublisher::AircraftEventPublisher(stefanfrings::HttpEventChannel *eventChannel, QObject *parent)
+  : QObject(parent), channel(eventChannel)
+{
+  Q_ASSERT(channel != nullptr);
+}
+
+AircraftEventPublisher::~AircraftEventPublisher()
+{
+  stop();
+}
+
+void AircraftEventPublisher::start(sc::DataReaderThread *dataReaderThread)
+{
+  stop();
+  dataReader = dataReaderThread;
+
+  // Data channel notifies in the reader thread context - convert in the thread of this object
+  connect(&dataChannel, &sc::SimConnectDataChannel::dataAvailable, this, &AircraftEventPublisher::dataAvailable,
+          Qt::QueuedConnection);
+  dataReader->addChannel(&dataChannel);
+}
+
+void AircraftEventPublisher::stop()
+{
+  if(dataReader != nullptr)
+  {
+    dataReader->removeChannel(&dataChannel);
+    dataChannel.disconnect(this);
+    dataReader = nullptr;
+  }
+}
+
+void AircraftEventPublisher::dataAvailable()
+{
+  QVector<sc::SimConnectData> dataList = dataChannel.take();
+
+  // Weather replies come first and are not of interest - the latest packet is last
+  for(int i = dataList.size() - 1; i >= 0; i--)
+  {
+    const sc::SimConnectData& data = dataList.at(i);
+    if(data.getPacketId() > 0 && !data.isEmptyReply())
+    {
+      channel->publish("aircraft", toJson(data));
+      break;
+    }
+  }
+}
+
+QByteArray AircraftEventPublisher::toJson(const sc::SimConnectData& data)
+{
+  QJsonObject root;
+
+  if(data.isUserAircraftValid())
+  {
+    const sc::SimConnectUserAircraft& user = data.getUserAircraftConst();
+    const geo::Pos& pos = user.getPosition();
+    root.insert("user", QJsonArray({pos.getLonX(), pos.getLatY(), pos.getAltitude(),
+                                    user.getHeadingDegTrue(), user.getGroundSpeedKts(),
+                                    user.getVerticalSpeedFeetPerMin(), user.isOnGround(),
+                                    user.getAirplaneModel(), user.getAirplaneRegistration()}));
+  }
+
+  QJsonArray aiArray;
+  for(const sc::SimConnectAircraft& ai : data.getAiAircraftConst())
+  {
+    const geo::Pos& pos = ai.getPosition();
+    aiArray.append(QJsonArray({ai.getId(), pos.getLonX(), pos.getLatY(), pos.getAltitude(),
+                               ai.getHeadingDegTrue(), ai.getGroundSpeedKts(), ai.isOnGround(),
+                               ai.getAirplaneModel(), ai.getAirplaneRegistration()}));
+  }
+  root.insert("ai", aiArray);
+
+  return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+} // namespace ns
+} // namespace fs
+} // namespace atools
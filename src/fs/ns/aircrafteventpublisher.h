@@ -0,0 +1,81 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_NS_AIRCRAFTEVENTPUBLISHER_H
+#define ATOOLS_NS_AIRCRAFTEVENTPUBLISHER_H
+
+#include "fs/sc/simconnectdatachannel.h"
+
+#include <QObject>
+
+namespace stefanfrings {
+class HttpEventChannel;
+}
+
+namespace atools {
+namespace fs {
+namespace sc {
+class DataReaderThread;
+}
+
+namespace ns {
+
+/*
+ * Forwards simulator data from DataReaderThread as Server-Sent Events to web clients of the HTTP server.
+ *
+ * Each data packet is converted once into a compact JSON event "aircraft" which is shared by all subscribers of
+ * the event channel. Packets arriving while the previous one is converted are dropped by the data channel.
+ * Serve the event channel with stefanfrings::EventStreamController.
+ *
+ * JSON format with arrays instead of objects per aircraft to keep events small:
+ * {"user":[lonX,latY,altFt,headingTrue,groundSpeedKts,verticalSpeedFpm,onGround,type,registration],
+ *  "ai":[[id,lonX,latY,altFt,headingTrue,groundSpeedKts,onGround,type,registration],...]}
+ * "user" is missing if the user aircraft is not valid.
+ */
+class AircraftEventPublisher :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  /* Channel is not owned and has to outlive this object */
+  AircraftEventPublisher(stefanfrings::HttpEventChannel *eventChannel, QObject *parent = nullptr);
+  virtual ~AircraftEventPublisher() override;
+
+  /* Start receiving data from the reader */
+  void start(atools::fs::sc::DataReaderThread *dataReaderThread);
+
+  /* Stop receiving data */
+  void stop();
+
+  /* Convert a data packet into the compact JSON format */
+  static QByteArray toJson(const atools::fs::sc::SimConnectData& data);
+
+private:
+  void dataAvailable();
+
+  stefanfrings::HttpEventChannel *channel;
+  atools::fs::sc::SimConnectDataChannel dataChannel;
+  atools::fs::sc::DataReaderThread *dataReader = nullptr;
+};
+
+} // namespace ns
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_NS_AIRCRAFTEVENTPUBLISHER_H
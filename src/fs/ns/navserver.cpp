@@ -18,6 +18,7 @@
 #include "fs/ns/navserver.h"
 
 #include "fs/ns/navservercommon.h"
+#include "fs/ns/navserverframe.h"
 #include "fs/ns/navserverworker.h"
 #include "fs/sc/datareaderthread.h"
 #include "settings/settings.h"
@@ -35,6 +36,7 @@ const QString REDSPAN("<span style=\"color: #ff0000; font-weight:bold\">");
 NavServer::NavServer(QObject *parent, atools::fs::ns::NavServerOptions optionFlags, int inetPort)
   : QTcpServer(parent), options(optionFlags), port(inetPort)
 {
+  codec.setCompression(options.testFlag(COMPRESS));
   qDebug("NavServer created");
 }
 
@@ -51,6 +53,9 @@ void NavServer::stopServer()
   if(isListening())
     close();
 
+  if(dataReader != nullptr)
+    dataReader->removeChannel(&channel);
+
   // Stop all worker threads
   QSet<NavServerWorker *> workersCopy(workers);
   for(NavServerWorker *worker : workersCopy)
@@ -65,6 +70,12 @@ void NavServer::stopServer()
 bool NavServer::startServer(atools::fs::sc::DataReaderThread *dataReaderThread)
 {
   dataReader = dataReaderThread;
+  codec.reset();
+
+  // Data reader will send simconnect packages through this channel into this thread
+  connect(&channel, &atools::fs::sc::SimConnectDataChannel::dataAvailable, this, &NavServer::dataAvailable,
+          static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
+  dataReader->addChannel(&channel);
   qDebug() << "Navserver starting";
 
   QStringList hostNameList, hostIpList;
@@ -154,18 +165,43 @@ void NavServer::incomingConnection(qintptr socketDescriptor)
           threadFinished(worker);
         });
 
-  // Data reader will send simconnect packages through this connection
-  connect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, worker,
-          &NavServerWorker::postSimConnectData);
   connect(worker, &NavServerWorker::postWeatherRequest,
           dataReader, &atools::fs::sc::DataReaderThread::setWeatherRequest);
 
   qDebug() << "Thread" << worker->objectName();
   workerThread->start();
 
+  QMutexLocker locker(&threadsMutex);
   workers.insert(worker);
 }
 
+void NavServer::dataAvailable()
+{
+  for(const atools::fs::sc::SimConnectData& data : channel.take())
+    postSimConnectData(data);
+}
+
+void NavServer::postSimConnectData(const atools::fs::sc::SimConnectData& dataPacket)
+{
+  NavServerFramePtr frame(new NavServerFrame(dataPacket, ++frameNumber, options.testFlag(COMPRESS)));
+
+  QMutexLocker locker(&threadsMutex);
+
+  bool compact = false;
+  for(const NavServerWorker *worker : workers)
+    compact |= worker->isCompactData();
+
+  if(compact)
+    // Build delta once in sequence for all workers
+    frame->buildDeltaBlock(codec);
+  else
+    // Nobody uses the delta sequence - start with a keyframe next time
+    codec.reset();
+
+  for(NavServerWorker *worker : workers)
+    worker->postFrame(frame);
+}
+
 void NavServer::threadFinished(NavServerWorker *worker)
 {
   qDebug() << "Thread" << worker->objectName() << "finished";
@@ -173,9 +209,6 @@ void NavServer::threadFinished(NavServerWorker *worker)
   // A thread has finished - lock the list so the thread can be removed from the list
   QMutexLocker locker(&threadsMutex);
 
-  disconnect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, worker,
-             &NavServerWorker::postSimConnectData);
-
   // TODO crashes when connected
   // disconnect(worker, &NavServerWorker::postCommand,
   // dataReader, &atools::fs::sc::DataReaderThread::postCommand);
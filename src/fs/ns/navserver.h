@@ -19,6 +19,8 @@
 #define LITTLENAVCONNECT_NAVSERVER_H
 
 #include "fs/ns/navservercommon.h"
+#include "fs/sc/simconnectdatacodec.h"
+#include "fs/sc/simconnectdatachannel.h"
 
 #include <QMutex>
 #include <QTcpServer>
@@ -59,17 +61,30 @@ public:
   }
 
 private:
+  /* Takes latest data from the channel and passes it to postSimConnectData */
+  void dataAvailable();
+
+  /* Serializes data once and passes it to all workers */
+  void postSimConnectData(const atools::fs::sc::SimConnectData& dataPacket);
+
   void incomingConnection(qintptr socketDescriptor) override;
   void threadFinished(NavServerWorker *worker);
 
   atools::fs::ns::NavServerOptions options = NONE;
-  atools::fs::sc::DataReaderThread *dataReader;
+  atools::fs::sc::DataReaderThread *dataReader = nullptr;
 
   QSet<NavServerWorker *> workers;
   // Needed to lock for any modifications of the workers set
   mutable QMutex threadsMutex;
 
   int port = 51968;
+
+  /* Latest data from DataReaderThread. Stale packets are dropped if this thread is busy. */
+  atools::fs::sc::SimConnectDataChannel channel;
+
+  /* Codec for delta frames shared by all workers using the compact format */
+  atools::fs::sc::SimConnectDataCodec codec;
+  quint64 frameNumber = 0;
 };
 
 } // namespace ns
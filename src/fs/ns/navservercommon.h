@@ -29,7 +29,8 @@ enum NavServerOption
   NONE = 0x00,
   VERBOSE = 0x01,
   HIDE_HOST = 0x02,
-  NO_HTML = 0x04
+  NO_HTML = 0x04,
+  COMPRESS = 0x08 /* Compress packets for clients using the compact format */
 };
 
 Q_DECLARE_FLAGS(NavServerOptions, NavServerOption);
@@ -0,0 +1,71 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/ns/navserverframe.h"
+
+#include "fs/sc/simconnectdatacodec.h"
+
+namespace atools {
+namespace fs {
+namespace ns {
+
+NavServerFrame::NavServerFrame(const sc::SimConnectData& dataParam, quint64 frameNumberParam, bool compressParam)
+  : data(dataParam), frameNumber(frameNumberParam), compress(compressParam)
+{
+}
+
+QByteArray NavServerFrame::getBlock()
+{
+  QMutexLocker locker(&mutex);
+  if(block.isEmpty())
+    block = data.writeToBlock();
+  return block;
+}
+
+QByteArray NavServerFrame::getCompactBlock(bool previousSent)
+{
+  if(isReply())
+    // Replies are always sent in full format
+    return getBlock();
+
+  QMutexLocker locker(&mutex);
+  if(previousSent && !deltaBlock.isEmpty())
+    return deltaBlock;
+
+  if(keyframeBlock.isEmpty())
+  {
+    // New codec always starts with a keyframe
+    atools::fs::sc::SimConnectDataCodec codec;
+    codec.setCompression(compress);
+    keyframeBlock = data.writeToBlock(codec);
+  }
+  return keyframeBlock;
+}
+
+void NavServerFrame::buildDeltaBlock(sc::SimConnectDataCodec& codec)
+{
+  if(!isReply())
+  {
+    QMutexLocker locker(&mutex);
+    deltaBlock = data.writeToBlock(codec);
+  }
+}
+
+} // namespace ns
+} // namespace fs
+} // namespace atools
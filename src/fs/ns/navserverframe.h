@@ -0,0 +1,91 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_NS_NAVSERVERFRAME_H
+#define ATOOLS_NS_NAVSERVERFRAME_H
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QMutex>
+#include <QSharedPointer>
+
+namespace atools {
+namespace fs {
+namespace sc {
+class SimConnectDataCodec;
+}
+
+namespace ns {
+
+/*
+ * One data packet which is serialized only once and shared between all connection workers.
+ * Blocks for the full and the compact format are built on demand by the first worker which needs them.
+ *
+ * Delta blocks have to be built in frame order by NavServer using one codec for all connections.
+ * Workers which missed the previous frame get a keyframe which is also built only once.
+ */
+class NavServerFrame
+{
+public:
+  NavServerFrame(const atools::fs::sc::SimConnectData& dataParam, quint64 frameNumberParam, bool compressParam);
+
+  /* Consecutive number of frame as created in NavServer */
+  quint64 getFrameNumber() const
+  {
+    return frameNumber;
+  }
+
+  /* Packet id as sent to clients */
+  int getPacketId() const
+  {
+    return data.getPacketId();
+  }
+
+  /* Weather reply or empty packet which must not be skipped by workers */
+  bool isReply() const
+  {
+    return data.getPacketId() == 0;
+  }
+
+  /* Block in full legacy format. Thread safe. */
+  QByteArray getBlock();
+
+  /* Block in compact format. This is a delta if available and previousSent is true. Otherwise a keyframe
+   * is returned. Thread safe. */
+  QByteArray getCompactBlock(bool previousSent);
+
+  /* Build delta block using given codec which is shared for all connections.
+   * Has to be called for each frame in order. */
+  void buildDeltaBlock(atools::fs::sc::SimConnectDataCodec& codec);
+
+private:
+  atools::fs::sc::SimConnectData data;
+  quint64 frameNumber;
+  bool compress;
+
+  QByteArray block, keyframeBlock, deltaBlock;
+  QMutex mutex;
+};
+
+typedef QSharedPointer<atools::fs::ns::NavServerFrame> NavServerFramePtr;
+
+} // namespace ns
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_NS_NAVSERVERFRAME_H
@@ -20,6 +20,7 @@
 #include "fs/ns/navserverworker.h"
 #include "fs/ns/navservercommon.h"
 #include "fs/sc/simconnectreply.h"
+#include "fs/sc/simconnectdatabase.h"
 
 #include <QThread>
 #include <QTcpSocket>
@@ -104,7 +105,7 @@ void NavServerWorker::readyReadReplyFromSocket()
     if(options & VERBOSE)
       qDebug() << "NavServerWorker readyReadReply packet id" << reply.getPacketId();
 
-    if(reply.getCommand() == atools::fs::sc::CMD_WEATHER_REQUEST)
+    if(reply.getCommand().testFlag(atools::fs::sc::CMD_WEATHER_REQUEST))
     {
       if(options & VERBOSE)
         qDebug() << "NavServerWorker::readyReadReply got weather request";
@@ -120,54 +121,114 @@ void NavServerWorker::readyReadReplyFromSocket()
 
       // Normal reply - remove id from sent list
       lastPacketIds.remove(reply.getPacketId());
+
+      if(!isCompactData() && reply.getCommand().testFlag(atools::fs::sc::CMD_COMPACT_DATA))
+      {
+        // Client can read compact format - next packet will be a keyframe
+        qDebug() << "NavServerWorker switching to compact data for" << peerAddr;
+        lastCompactFrame = 0;
+        compactData.storeRelease(1);
+      }
     }
   }
   if(options & VERBOSE)
     qDebug() << "NavServerWorker::readyReadReply leave";
 }
 
-void NavServerWorker::postSimConnectData(atools::fs::sc::SimConnectData dataPacket)
+void NavServerWorker::postFrame(NavServerFramePtr frame)
 {
-  if(options & VERBOSE)
-    qDebug() << "NavServerWorker postSimConnectData" << QThread::currentThread()->objectName()
-             << "last ids" << lastPacketIds;
+  QMutexLocker locker(&framesMutex);
 
-  if(!dataPacket.getMetars().isEmpty())
-  {
-    if(options & VERBOSE)
-      qDebug() << "NavServerWorker::postSimConnectData metars num " << dataPacket.getMetars().size();
+  if(frame->isReply())
+    pendingReplies.append(frame);
+  else
+    // Replace any data frame which was not sent yet
+    pendingFrame = frame;
 
-    if(dataPacket.getUserAircraftConst().getPosition().isValid())
-      qWarning() << "Aircraft and metar mixed";
+  if(!sendQueued)
+  {
+    // Send in this worker's thread context - only one call is queued at a time
+    sendQueued = true;
+    QMetaObject::invokeMethod(this, "sendPendingFrames", Qt::QueuedConnection);
   }
+}
 
-  if(lastPacketIds.size() > 1 && dataPacket.getPacketId() > 0)
+void NavServerWorker::sendPendingFrames()
+{
+  QVector<NavServerFramePtr> replies;
+  NavServerFramePtr frame;
   {
-    // No reply received in the meantime - count it as dropped package and do not send a new package
-    handleDroppedPackages(tr("Missing reply"));
+    QMutexLocker locker(&framesMutex);
+    replies.swap(pendingReplies);
+    frame.swap(pendingFrame);
+    sendQueued = false;
+  }
+
+  if(socket == nullptr)
     return;
+
+  for(const NavServerFramePtr& reply : replies)
+    sendFrame(reply);
+
+  if(!frame.isNull())
+    sendFrame(frame);
+}
+
+void NavServerWorker::sendFrame(NavServerFramePtr frame)
+{
+  if(options & VERBOSE)
+    qDebug() << "NavServerWorker sendFrame" << QThread::currentThread()->objectName()
+             << "last ids" << lastPacketIds;
+
+  if(!frame->isReply())
+  {
+    if(lastPacketIds.size() > 1)
+    {
+      // No reply received in the meantime - count it as dropped package and do not send a new package
+      handleDroppedPackages(tr("Missing reply"));
+      return;
+    }
+
+    if(socket->bytesToWrite() > MAX_BYTES_TO_WRITE)
+    {
+      // Client cannot keep up - skip frame and wait for the buffer to drain
+      handleDroppedPackages(tr("Slow connection"));
+      return;
+    }
   }
 
   if(inPost)
     // We're already posting
     qCritical() << "Nested post";
 
-  if(dataPacket.getPacketId() > 0)
+  if(!frame->isReply())
     // Insert packet id in sent list if this is not a weather request
-    lastPacketIds.insert(dataPacket.getPacketId());
+    lastPacketIds.insert(frame->getPacketId());
 
   inPost = true;
 
-  int written;
-  written = dataPacket.write(socket);
-  if(dataPacket.getStatus() != atools::fs::sc::OK)
-    qWarning(gui).noquote().nospace() << tr("Error writing data: %1.").arg(dataPacket.getStatusText());
+  QByteArray block;
+  if(isCompactData())
+  {
+    // Delta can only be used if the client got the frame before
+    block = frame->getCompactBlock(lastCompactFrame > 0 && lastCompactFrame + 1 == frame->getFrameNumber());
+    if(!frame->isReply())
+      lastCompactFrame = frame->getFrameNumber();
+  }
+  else
+    block = frame->getBlock();
+
+  atools::fs::sc::SimConnectStatus status = atools::fs::sc::OK;
+  int written = atools::fs::sc::SimConnectDataBase::writeBlock(socket, block, status);
+  if(status != atools::fs::sc::OK)
+    qWarning(gui).noquote().nospace() << tr("Error writing data: Wrote only %1 of %2 bytes.").
+      arg(written).arg(block.size());
 
   if(!socket->flush())
     qWarning() << "NavServerWorker Reply to client not flushed";
 
   if(options & VERBOSE)
-    qDebug() << "NavServerWorker written" << written << "flush" << flush << "id" << dataPacket.getPacketId();
+    qDebug() << "NavServerWorker written" << written << "id" << frame->getPacketId();
 
   inPost = false;
 }
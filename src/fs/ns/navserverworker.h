@@ -18,13 +18,15 @@
 #ifndef ATOOLS_NS_NAVSERVERTHREAD_H
 #define ATOOLS_NS_NAVSERVERTHREAD_H
 
-#include "fs/sc/simconnectdata.h"
-
 #include "fs/sc/simconnectreply.h"
 #include "fs/ns/navservercommon.h"
+#include "fs/ns/navserverframe.h"
 
+#include <QAtomicInt>
 #include <QHostInfo>
+#include <QMutex>
 #include <QSet>
+#include <QVector>
 
 class QTcpSocket;
 
@@ -45,8 +47,15 @@ public:
   NavServerWorker(qintptr socketDescriptor, NavServer *parent, atools::fs::ns::NavServerOptions optionFlags);
   virtual ~NavServerWorker();
 
-  /* Receives sim connect data from DataReader thread and writes to socket. */
-  void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
+  /* Called by NavServer in its thread for each new frame. Only the latest data frame is kept if the worker is busy
+   * or the connection is slow. Weather replies are queued and never skipped. Thread safe. */
+  void postFrame(atools::fs::ns::NavServerFramePtr frame);
+
+  /* true if client can read the compact format. Thread safe. */
+  bool isCompactData() const
+  {
+    return compactData.loadAcquire() != 0;
+  }
 
   /* Signal posted by thread to indicate it has started . */
   void threadStarted();
@@ -62,13 +71,19 @@ private:
   /* Read reply from remote end. */
   void readyReadReplyFromSocket();
 
+  /* Write all pending frames to the socket. Called in this thread's context. */
+  Q_INVOKABLE void sendPendingFrames();
+  void sendFrame(atools::fs::ns::NavServerFramePtr frame);
+
   /* Count dropped packages and write a message if too many accumulated. */
   void handleDroppedPackages(const QString& reason);
 
   const int MAX_DROPPED_PACKAGES = 50;
 
+  /* Skip data frames if more than this is waiting in the socket buffer */
+  const qint64 MAX_BYTES_TO_WRITE = 1024 * 1024;
+
   qintptr socketDescr;
-  atools::fs::sc::SimConnectData data;
   QTcpSocket *socket = nullptr;
 
   atools::fs::ns::NavServerOptions options = NONE;
@@ -77,6 +92,18 @@ private:
   int droppedPackages = 0;
   bool inPost = false;
 
+  /* Client announced support for the compact format */
+  QAtomicInt compactData;
+
+  /* Frame number of the last data frame sent in compact format. Used to decide if a delta can be sent. */
+  quint64 lastCompactFrame = 0;
+
+  /* Latest data frame and queued replies waiting to be sent. Guarded by framesMutex. */
+  NavServerFramePtr pendingFrame;
+  QVector<NavServerFramePtr> pendingReplies;
+  bool sendQueued = false;
+  QMutex framesMutex;
+
   /* Add packet id on send and remove when reply is received */
   QSet<int> lastPacketIds;
   QString peerAddr;
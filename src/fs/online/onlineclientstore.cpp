@@ -0,0 +1,200 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/online/onlineclientstore.h"
+
+#include "fs/sc/simconnectaircraft.h"
+
+namespace atools {
+namespace fs {
+namespace online {
+
+OnlineClientStore::OnlineClientStore()
+{
+
+}
+
+OnlineClientStore::~OnlineClientStore()
+{
+
+}
+
+void OnlineClientStore::clear()
+{
+  ids.clear();
+  callsigns.clear();
+  aircraftTypes.clear();
+  fromIdents.clear();
+  toIdents.clear();
+  positions.clear();
+  headings.clear();
+  groundSpeeds.clear();
+  onGround.clear();
+
+  idIndex.clear();
+  callsignIndex.clear();
+
+  index.clear();
+  index.updateIndex();
+}
+
+void OnlineClientStore::update(int id, const OnlineClient& client)
+{
+  int row = idIndex.value(id, -1);
+  if(row == -1)
+  {
+    // Append new row
+    row = ids.size();
+    ids.append(id);
+    callsigns.append(client.callsign);
+    aircraftTypes.append(client.aircraftType);
+    fromIdents.append(client.fromIdent);
+    toIdents.append(client.toIdent);
+    positions.append(client.position);
+    headings.append(client.headingTrueDeg);
+    groundSpeeds.append(client.groundSpeedKts);
+    onGround.append(client.onGround);
+
+    idIndex.insert(id, row);
+    callsignIndex.insert(client.callsign, id);
+  }
+  else
+  {
+    // Replace existing row
+    if(callsigns.at(row) != client.callsign)
+    {
+      callsignIndex.remove(callsigns.at(row), id);
+      callsignIndex.insert(client.callsign, id);
+    }
+
+    callsigns[row] = client.callsign;
+    aircraftTypes[row] = client.aircraftType;
+    fromIdents[row] = client.fromIdent;
+    toIdents[row] = client.toIdent;
+    positions[row] = client.position;
+    headings[row] = client.headingTrueDeg;
+    groundSpeeds[row] = client.groundSpeedKts;
+    onGround[row] = client.onGround;
+  }
+}
+
+void OnlineClientStore::remove(int id)
+{
+  int row = idIndex.value(id, -1);
+  if(row != -1)
+    removeRow(row);
+}
+
+void OnlineClientStore::removeRow(int row)
+{
+  int id = ids.at(row);
+  idIndex.remove(id);
+  callsignIndex.remove(callsigns.at(row), id);
+
+  int last = ids.size() - 1;
+  if(row != last)
+  {
+    ids[row] = ids.at(last);
+    callsigns[row] = callsigns.at(last);
+    aircraftTypes[row] = aircraftTypes.at(last);
+    fromIdents[row] = fromIdents.at(last);
+    toIdents[row] = toIdents.at(last);
+    positions[row] = positions.at(last);
+    headings[row] = headings.at(last);
+    groundSpeeds[row] = groundSpeeds.at(last);
+    onGround[row] = onGround.at(last);
+
+    idIndex.insert(ids.at(row), row);
+  }
+
+  ids.removeLast();
+  callsigns.removeLast();
+  aircraftTypes.removeLast();
+  fromIdents.removeLast();
+  toIdents.removeLast();
+  positions.removeLast();
+  headings.removeLast();
+  groundSpeeds.removeLast();
+  onGround.removeLast();
+}
+
+void OnlineClientStore::updateIndex()
+{
+  index.resize(positions.size());
+  for(int row = 0; row < positions.size(); row++)
+    index[row].position = positions.at(row);
+  index.updateIndex();
+}
+
+bool OnlineClientStore::getAircraftById(sc::SimConnectAircraft& aircraft, int id) const
+{
+  int row = idIndex.value(id, -1);
+  if(row != -1)
+  {
+    getAircraft(aircraft, row);
+    return true;
+  }
+  return false;
+}
+
+void OnlineClientStore::getAircraft(sc::SimConnectAircraft& ac, int row) const
+{
+  // Same defaults as in OnlinedataManager::fillFromClient()
+  ac.headingMagDeg =
+    ac.indicatedAltitudeFt =
+      ac.indicatedSpeedKts =
+        ac.trueAirspeedKts =
+          ac.machSpeed =
+            ac.verticalSpeedFeetPerMin = atools::fs::sc::SC_INVALID_FLOAT;
+
+  ac.modelRadiusFt = ac.wingSpanFt = ac.deckHeight = 0;
+
+  ac.category = atools::fs::sc::AIRPLANE;
+  ac.engineType = atools::fs::sc::UNSUPPORTED;
+  ac.numberOfEngines = 0;
+
+  ac.objectId = static_cast<quint32>(ids.at(row));
+  ac.groundSpeedKts = groundSpeeds.at(row);
+
+  atools::fs::sc::SimConnectAircraftNames names;
+  names.airplaneReg = callsigns.at(row);
+  names.airplaneType = aircraftTypes.at(row);
+  names.fromIdent = fromIdents.at(row);
+  names.toIdent = toIdents.at(row);
+  ac.setNames(names);
+  ac.headingTrueDeg = headings.at(row);
+
+  ac.flags = atools::fs::sc::SIM_ONLINE;
+  if(onGround.at(row))
+    ac.flags |= atools::fs::sc::ON_GROUND;
+
+  ac.position = positions.at(row);
+}
+
+void OnlineClientStore::getCallsignAndPosMap(QHash<QString, geo::Pos>& clientMap) const
+{
+  clientMap.clear();
+  clientMap.reserve(callsigns.size());
+  for(int row = 0; row < callsigns.size(); row++)
+    // Same as the database query which does not return altitude
+    clientMap.insert(callsigns.at(row), geo::Pos(positions.at(row).getLonX(), positions.at(row).getLatY()));
+}
+
+} // namespace online
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,196 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_ONLINECLIENTSTORE_H
+#define ATOOLS_FS_ONLINECLIENTSTORE_H
+
+#include "geo/pos.h"
+#include "geo/spatialindex.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class Rect;
+}
+
+namespace fs {
+namespace sc {
+class SimConnectAircraft;
+}
+
+namespace online {
+
+/* Values of one online pilot client used to update the store */
+struct OnlineClient
+{
+  QString callsign, aircraftType, fromIdent, toIdent;
+
+  /* Includes altitude in feet */
+  atools::geo::Pos position;
+  float headingTrueDeg = 0.f, groundSpeedKts = 0.f;
+  bool onGround = false;
+};
+
+/*
+ * In-memory store for pilot clients of the current whazzup snapshot. Allows map updates and lookups
+ * without database queries.
+ *
+ * Fields are kept in separate vectors which are indexed by row. Rows are identified by the
+ * semi-permanent client ids which are also used for the client table in the database.
+ * Row numbers change on removal and are only valid until the next update.
+ *
+ * Call updateIndex() after inserting, updating or removing clients to make the spatial queries work.
+ * Not thread safe.
+ */
+class OnlineClientStore
+{
+public:
+  OnlineClientStore();
+  ~OnlineClientStore();
+
+  OnlineClientStore(const OnlineClientStore& other) = delete;
+  OnlineClientStore& operator=(const OnlineClientStore& other) = delete;
+
+  /* Remove all clients and clear index */
+  void clear();
+
+  /* Insert new or replace existing client having the same id */
+  void update(int id, const atools::fs::online::OnlineClient& client);
+
+  /* Remove client by id. Does nothing if id is not present. */
+  void remove(int id);
+
+  /* Remove all clients where the id is not contained in the hash keys */
+  template<typename T>
+  void retain(const QHash<int, T>& keepIds);
+
+  /* Rebuild spatial index after changes */
+  void updateIndex();
+
+  /* Fill aircraft from the store. Returns false if id was not found. */
+  bool getAircraftById(atools::fs::sc::SimConnectAircraft& aircraft, int id) const;
+
+  /* Fill aircraft by row in range [0, size()) */
+  void getAircraft(atools::fs::sc::SimConnectAircraft& aircraft, int row) const;
+
+  /* Get ids of all clients that match the callsign. Normally only one. */
+  QVector<int> getIdsByCallsign(const QString& callsign) const
+  {
+    return callsignIndex.values(callsign).toVector();
+  }
+
+  /* Fill the map with callsign as key and position as value. Used for online/simulator deduplication. */
+  void getCallsignAndPosMap(QHash<QString, atools::geo::Pos>& clientMap) const;
+
+  /* Append rows of clients inside rectangle or radius */
+  void getRowsInRect(QVector<int>& rows, const atools::geo::Rect& rect) const
+  {
+    index.getRectIndexes(rows, rect);
+  }
+
+  void getRowsInRadius(QVector<int>& rows, const atools::geo::Pos& pos, float radiusMeter,
+                       atools::geo::SpatialIndexBuffer& buffer) const
+  {
+    index.getRadiusIndexes(rows, pos, radiusMeter, buffer, [](float, int) -> bool {
+      return true;
+    });
+  }
+
+  /* Row for id or -1 if not found */
+  int getRow(int id) const
+  {
+    return idIndex.value(id, -1);
+  }
+
+  int getId(int row) const
+  {
+    return ids.at(row);
+  }
+
+  const QString& getCallsign(int row) const
+  {
+    return callsigns.at(row);
+  }
+
+  const atools::geo::Pos& getPosition(int row) const
+  {
+    return positions.at(row);
+  }
+
+  float getHeadingTrueDeg(int row) const
+  {
+    return headings.at(row);
+  }
+
+  int size() const
+  {
+    return ids.size();
+  }
+
+  bool isEmpty() const
+  {
+    return ids.isEmpty();
+  }
+
+private:
+  /* Point for spatial index. Index in spatial index is row number. */
+  struct ClientPoint
+  {
+    atools::geo::Pos position;
+
+    const atools::geo::Pos& getPosition() const
+    {
+      return position;
+    }
+
+  };
+
+  /* Move last row into the given row and shrink vectors */
+  void removeRow(int row);
+
+  QVector<int> ids;
+  QVector<QString> callsigns, aircraftTypes, fromIdents, toIdents;
+  QVector<atools::geo::Pos> positions;
+  QVector<float> headings, groundSpeeds;
+  QVector<bool> onGround;
+
+  atools::geo::SpatialIndex<ClientPoint> index;
+
+  /* Id to row and callsign to id */
+  QHash<int, int> idIndex;
+  QMultiHash<QString, int> callsignIndex;
+};
+
+template<typename T>
+void OnlineClientStore::retain(const QHash<int, T>& keepIds)
+{
+  // Iterate backwards since removal moves the last row
+  for(int row = ids.size() - 1; row >= 0; row--)
+  {
+    if(!keepIds.contains(ids.at(row)))
+      removeRow(row);
+  }
+}
+
+} // namespace online
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_ONLINECLIENTSTORE_H
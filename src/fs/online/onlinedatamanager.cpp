@@ -17,6 +17,7 @@
 
 #include "fs/online/onlinedatamanager.h"
 
+#include "fs/online/onlineclientstore.h"
 #include "fs/online/statustextparser.h"
 #include "fs/online/whazzuptextparser.h"
 
@@ -27,6 +28,7 @@
 #include "sql/sqlrecord.h"
 #include "sql/sqlscript.h"
 #include "fs/sc/simconnectaircraft.h"
+#include "geo/trailstore.h"
 
 #include <QDebug>
 
@@ -36,6 +38,7 @@ using atools::sql::SqlTransaction;
 using atools::sql::SqlUtil;
 using atools::sql::SqlRecord;
 using atools::sql::SqlScript;
+using atools::geo::TrailStore;
 
 namespace atools {
 namespace fs {
@@ -47,13 +50,18 @@ OnlinedataManager::OnlinedataManager(sql::SqlDatabase *sqlDb, bool verboseErrorR
   status = new StatusTextParser;
   whazzup = new WhazzupTextParser(db, verboseErrorReporting);
   whazzupServers = new WhazzupTextParser(db, verboseErrorReporting);
+  clientStore = new OnlineClientStore;
+  trailStore = new TrailStore;
 }
 
 OnlinedataManager::~OnlinedataManager()
 {
   delete status;
   delete whazzup;
+  delete streamTransaction;
   delete whazzupServers;
+  delete clientStore;
+  delete trailStore;
 }
 
 bool OnlinedataManager::readFromWhazzup(const QString& whazzupTxt, atools::fs::online::Format format,
@@ -68,6 +76,67 @@ bool OnlinedataManager::readFromWhazzup(const QString& whazzupTxt, atools::fs::o
   return retval;
 }
 
+void OnlinedataManager::startReadFromWhazzup(Format format, const QDateTime& lastUpdate)
+{
+  // Rolls back an unfinished read
+  delete streamTransaction;
+  streamTransaction = new SqlTransaction(db);
+  whazzup->beginRead(format, lastUpdate);
+}
+
+bool OnlinedataManager::addWhazzupData(const QByteArray& data)
+{
+  if(streamTransaction == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "Read not started";
+    return false;
+  }
+  return whazzup->addData(data);
+}
+
+bool OnlinedataManager::finishReadFromWhazzup()
+{
+  if(streamTransaction == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "Read not started";
+    return false;
+  }
+
+  bool retval = whazzup->finishRead();
+  if(retval)
+    streamTransaction->commit();
+  else
+    streamTransaction->rollback();
+
+  delete streamTransaction;
+  streamTransaction = nullptr;
+  return retval;
+}
+
+void OnlinedataManager::setDiffUpdates(bool value)
+{
+  whazzup->setDiffMode(value);
+}
+
+void OnlinedataManager::setClientStoreEnabled(bool value)
+{
+  clientStoreEnabled = value;
+  clientStore->clear();
+  whazzup->setClientStore(clientStoreEnabled ? clientStore : nullptr);
+}
+
+void OnlinedataManager::setTrailsEnabled(bool value)
+{
+  trailsEnabled = value;
+  trailStore->clear();
+  whazzup->setTrailStore(trailsEnabled ? trailStore : nullptr);
+}
+
+const WhazzupChanges& OnlinedataManager::getWhazzupChanges() const
+{
+  return whazzup->getChanges();
+}
+
 bool OnlinedataManager::readServersFromWhazzup(const QString& whazzupTxt, Format format, const QDateTime& lastUpdate)
 {
   SqlTransaction transaction(db);
@@ -133,6 +202,7 @@ void OnlinedataManager::createSchema()
 
   script.executeScript(":/atools/resources/sql/fs/online/create_online_schema.sql");
   transaction.commit();
+  whazzup->resetRowHashes();
 }
 
 void OnlinedataManager::clearData()
@@ -142,6 +212,10 @@ void OnlinedataManager::clearData()
   for(const QString& table : tables)
     db->exec("delete from " + table);
   transaction.commit();
+
+  // Tables are empty now - do a full reload on next read
+  whazzup->resetRowHashes();
+  clientStore->clear();
 }
 
 void OnlinedataManager::dropSchema()
@@ -153,6 +227,7 @@ void OnlinedataManager::dropSchema()
 
   script.executeScript(":/atools/resources/sql/fs/online/drop_online_schema.sql");
   transaction.commit();
+  whazzup->resetRowHashes();
 }
 
 void OnlinedataManager::reset()
@@ -171,6 +246,12 @@ void OnlinedataManager::resetForNewOptions()
 
 void OnlinedataManager::getClientAircraftById(atools::fs::sc::SimConnectAircraft& aircraft, int clientId)
 {
+  if(clientStoreEnabled)
+  {
+    clientStore->getAircraftById(aircraft, clientId);
+    return;
+  }
+
   sql::SqlRecord rec = getClientRecordById(clientId);
   if(!rec.isEmpty())
     fillFromClient(aircraft, rec);
@@ -203,6 +284,12 @@ sql::SqlRecordVector OnlinedataManager::getClientRecordsByCallsign(const QString
 
 void OnlinedataManager::getClientCallsignAndPosMap(QHash<QString, geo::Pos>& clientMap)
 {
+  if(clientStoreEnabled)
+  {
+    clientStore->getCallsignAndPosMap(clientMap);
+    return;
+  }
+
   clientMap.clear();
   SqlQuery query("select callsign, lonx, laty from client", db);
   query.exec();
@@ -225,6 +312,11 @@ void OnlinedataManager::setGeometryCallback(GeoCallbackType func)
   whazzup->setGeometryCallback(func);
 }
 
+void OnlinedataManager::clearGeometryCache()
+{
+  whazzup->clearAtcGeometryCache();
+}
+
 void OnlinedataManager::fillFromClient(sc::SimConnectAircraft& ac, const sql::SqlRecord& record)
 {
   if(record.valueBool("prefile") || record.valueStr("client_type") != "PILOT")
@@ -246,7 +338,9 @@ void OnlinedataManager::fillFromClient(sc::SimConnectAircraft& ac, const sql::Sq
   ac.numberOfEngines = 0;
 
   ac.objectId = static_cast<quint32>(record.valueInt("client_id"));
-  ac.airplaneReg = record.valueStr("callsign");
+
+  atools::fs::sc::SimConnectAircraftNames names;
+  names.airplaneReg = record.valueStr("callsign");
 
   // record.valueStr("vid");
   // record.valueStr("name");
@@ -260,15 +354,16 @@ void OnlinedataManager::fillFromClient(sc::SimConnectAircraft& ac, const sql::Sq
   // ac.airplaneFlightnumber,
 
   ac.groundSpeedKts = record.valueFloat("groundspeed");
-  ac.airplaneType = record.valueStr("flightplan_aircraft");
+  names.airplaneType = record.valueStr("flightplan_aircraft");
 
   // record.valueStr("flightplan_cruising_speed");
 
-  ac.fromIdent = record.valueStr("flightplan_departure_aerodrome");
+  names.fromIdent = record.valueStr("flightplan_departure_aerodrome");
 
   // record.valueStr("flightplan_cruising_level");
 
-  ac.toIdent = record.valueStr("flightplan_destination_aerodrome");
+  names.toIdent = record.valueStr("flightplan_destination_aerodrome");
+  ac.setNames(names);
 
   // record.valueStr("server");
   // record.valueStr("protocol");
@@ -23,16 +23,19 @@
 #include <QString>
 
 class QDateTime;
+class QByteArray;
 
 namespace atools {
 namespace geo {
 class Pos;
+class TrailStore;
 }
 
 namespace sql {
 class SqlDatabase;
 class SqlQuery;
 class SqlRecord;
+class SqlTransaction;
 typedef QVector<atools::sql::SqlRecord> SqlRecordVector;
 }
 
@@ -45,6 +48,7 @@ namespace online {
 
 class StatusTextParser;
 class WhazzupTextParser;
+class OnlineClientStore;
 
 /*
  * Facade for online classes that parse whazzup.txt and status.txt files for IVAO, VATSIM or other muultiplayer
@@ -68,6 +72,43 @@ public:
    * Returns true if the file was read and is more recent than lastUpdate. */
   bool readFromWhazzup(const QString& whazzupTxt, Format format, const QDateTime& lastUpdate);
 
+  /* Read whazzup.txt or the JSON feed incrementally while downloading. Call startReadFromWhazzup(), then
+   * addWhazzupData() for each received chunk and finishReadFromWhazzup() when done.
+   * GZIP compressed data is decompressed on the fly. A transaction is kept open between start and finish.
+   * addWhazzupData() returns false if the file is outdated or invalid and the download can be aborted.
+   * finishReadFromWhazzup() commits and returns true if the file was read and is more recent than lastUpdate. */
+  void startReadFromWhazzup(Format format, const QDateTime& lastUpdate);
+  bool addWhazzupData(const QByteArray& data);
+  bool finishReadFromWhazzup();
+
+  /* Keep client and atc tables between reads of whazzup.txt and update only changed rows if true.
+   * Rows are identified by semi-permanent ids. Default is false which rewrites all rows on each read. */
+  void setDiffUpdates(bool value);
+
+  /* Keep pilot clients of the last whazzup read in memory in addition to the client table if true.
+   * Lookups like getClientAircraftById() and getClientCallsignAndPosMap() use the store then and do not
+   * query the database. Default is false. */
+  void setClientStoreEnabled(bool value);
+
+  /* In-memory store of pilot clients or null if not enabled */
+  const atools::fs::online::OnlineClientStore *getClientStore() const
+  {
+    return clientStoreEnabled ? clientStore : nullptr;
+  }
+
+  /* Keep a position history for each pilot client if true. Default is false.
+   * Memory is bounded by the trail store capacity. */
+  void setTrailsEnabled(bool value);
+
+  /* Position history of pilot clients by client id or null if not enabled */
+  const atools::geo::TrailStore *getTrailStore() const
+  {
+    return trailsEnabled ? trailStore : nullptr;
+  }
+
+  /* Ids of clients and atc inserted, updated or deleted by the last successful readFromWhazzup() */
+  const atools::fs::online::WhazzupChanges& getWhazzupChanges() const;
+
   /* Read all servers and voice_servers from whazzup.txt file with file content in string and writes all into the database */
   bool readServersFromWhazzup(const QString& whazzupTxt, Format format, const QDateTime& lastUpdate);
 
@@ -146,12 +187,24 @@ public:
    * Default circle will be used if this returns an empty byte array or a null pointer. */
   void setGeometryCallback(atools::fs::online::GeoCallbackType func);
 
+  /* Geometry of ATC stations is reused across reloads. Call if the geometry callback gives new results,
+   * e.g. after user airspaces were loaded. Rows are updated with the next reload which changes the station. */
+  void clearGeometryCache();
+
 private:
   atools::sql::SqlDatabase *db;
 
   atools::fs::online::WhazzupTextParser *whazzup = nullptr;
   atools::fs::online::WhazzupTextParser *whazzupServers = nullptr;
   atools::fs::online::StatusTextParser *status = nullptr;
+  atools::fs::online::OnlineClientStore *clientStore = nullptr;
+  bool clientStoreEnabled = false;
+
+  atools::geo::TrailStore *trailStore = nullptr;
+  bool trailsEnabled = false;
+
+  /* Open while reading incrementally */
+  atools::sql::SqlTransaction *streamTransaction = nullptr;
 
 };
 
@@ -135,6 +135,35 @@ enum Simulator
 
 }
 
+/* Row ids of clients and ATC which were changed by the last whazzup read.
+ * All rows are reported as inserted if the tables were cleared and filled completely. */
+struct WhazzupChanges
+{
+  QVector<int> clientsInserted, clientsUpdated, clientsDeleted,
+               atcInserted, atcUpdated, atcDeleted;
+
+  /* true if tables were cleared before reading */
+  bool fullReload = false;
+
+  bool isEmpty() const
+  {
+    return clientsInserted.isEmpty() && clientsUpdated.isEmpty() && clientsDeleted.isEmpty() &&
+           atcInserted.isEmpty() && atcUpdated.isEmpty() && atcDeleted.isEmpty() && !fullReload;
+  }
+
+  void clear()
+  {
+    clientsInserted.clear();
+    clientsUpdated.clear();
+    clientsDeleted.clear();
+    atcInserted.clear();
+    atcUpdated.clear();
+    atcDeleted.clear();
+    fullReload = false;
+  }
+
+};
+
 /* Callback which tries to fetch geometry from the user airspace database.
  * Default circle will be used if this returns an empty byte array. */
 typedef std::function<atools::geo::LineString *(const QString& callsign,
@@ -17,12 +17,17 @@
 
 #include "fs/online/whazzuptextparser.h"
 
+#include "fs/online/onlineclientstore.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlutil.h"
 #include "geo/calculations.h"
 #include "sql/sqldatabase.h"
 #include "geo/linestring.h"
 #include "fs/common/binarygeometry.h"
+#include "util/jsonstreamreader.h"
+#include "zip/gzip.h"
+#include "util/trace.h"
+#include "geo/trailstore.h"
 
 #include <QTextCodec>
 
@@ -37,6 +42,17 @@ namespace atools {
 namespace fs {
 namespace online {
 
+/* Number of characters read at once from a text stream */
+const static int STREAM_CHUNK_SIZE = 65536;
+
+/* Convert ISO date and time from JSON to the format used in whazzup.txt */
+static QString jsonDateTime(const QString& str)
+{
+  // Cut off fractional seconds and time zone which is always UTC
+  QDateTime datetime = QDateTime::fromString(str.left(19), "yyyy-MM-dd'T'HH:mm:ss");
+  return datetime.isValid() ? datetime.toString("yyyyMMddhhmmss") : QString();
+}
+
 WhazzupTextParser::WhazzupTextParser(sql::SqlDatabase *sqlDb, bool verboseErrorReporting)
   : db(sqlDb), error(verboseErrorReporting)
 {
@@ -45,6 +61,9 @@ WhazzupTextParser::WhazzupTextParser(sql::SqlDatabase *sqlDb, bool verboseErrorR
 WhazzupTextParser::~WhazzupTextParser()
 {
   deInitQueries();
+  delete decoder;
+  delete gzipReader;
+  delete jsonReader;
 }
 
 bool WhazzupTextParser::read(QString file, Format streamFormat, const QDateTime& lastUpdate)
@@ -54,83 +73,450 @@ bool WhazzupTextParser::read(QString file, Format streamFormat, const QDateTime&
 }
 
 bool WhazzupTextParser::read(QTextStream& stream, Format streamFormat, const QDateTime& lastUpdate)
+{
+  ATOOLS_TRACE_SCOPE("WhazzupTextParser::read", "online");
+
+  beginRead(streamFormat, lastUpdate);
+
+  while(!stream.atEnd() && !outdated && !invalid)
+    addText(stream.read(STREAM_CHUNK_SIZE));
+
+  return finishRead();
+}
+
+void WhazzupTextParser::beginRead(Format streamFormat, const QDateTime& lastUpdate)
 {
   reset();
+  format = streamFormat;
+  lastUpdateTime = lastUpdate;
+
+  sections.clear();
+  input = DETECT;
+  outdated = invalid = gzipChecked = false;
+  detectBytes.clear();
+  pendingText.clear();
+  jsonValues.clear();
+  jsonAtisLines.clear();
+  jsonSection.clear();
+  jsonNestedKey.clear();
+
+  delete gzipReader;
+  gzipReader = nullptr;
+  delete jsonReader;
+  jsonReader = nullptr;
+
+  // Names are fixed later in convertName() which expects ANSI decoding
+  delete decoder;
+  decoder = QTextCodec::codecForName("Windows-1252")->makeDecoder();
+
+  changes.clear();
+  curClientRowHashes.clear();
+  curAtcRowHashes.clear();
+  curAtcGeometryCache.clear();
+
+  // Compare with the rows of the last read only if these are known
+  diffActive = diffMode && (!clientRowHashes.isEmpty() || !atcRowHashes.isEmpty());
+}
 
-  // Read through file to get all sections
-  QSet<QString> sections;
-  while(!stream.atEnd())
+bool WhazzupTextParser::addData(const QByteArray& data)
+{
+  if(outdated || invalid)
+    return false;
+
+  if(!gzipChecked)
   {
-    QString line = stream.readLine().trimmed();
-    if(line.startsWith("!"))
-      // Remember section
-      sections.insert(line.mid(1).toUpper().trimmed().replace(':', ""));
+    // Wait for magic number
+    detectBytes.append(data);
+    if(detectBytes.size() < 2)
+      return true;
+
+    gzipChecked = true;
+    if(atools::zip::isGzipCompressed(detectBytes))
+      gzipReader = new atools::zip::GzipReader;
+
+    QByteArray bytes;
+    bytes.swap(detectBytes);
+    return addData(bytes);
+  }
+
+  if(gzipReader != nullptr)
+  {
+    QByteArray decompressed;
+    if(!gzipReader->decompress(data, decompressed))
+    {
+      qWarning() << Q_FUNC_INFO << "Error decompressing data";
+      invalid = true;
+      return false;
+    }
+    addBytes(decompressed);
+  }
+  else
+    addBytes(data);
+
+  return !outdated && !invalid;
+}
+
+void WhazzupTextParser::addBytes(const QByteArray& bytes)
+{
+  if(input == DETECT)
+  {
+    // Skip leading whitespace and byte order mark
+    int i = 0;
+    while(i < bytes.size() && (QChar::isSpace(static_cast<uchar>(bytes.at(i))) ||
+                               static_cast<uchar>(bytes.at(i)) >= 0x80))
+      i++;
+
+    if(i == bytes.size())
+      return;
+
+    setInput(bytes.at(i) == '{' ? JSON : TEXT);
+  }
+
+  if(input == JSON)
+  {
+    jsonReader->addData(bytes);
+    parseJson();
+  }
+  else
+  {
+    pendingText.append(decoder->toUnicode(bytes));
+    parseLines(false);
+  }
+}
+
+void WhazzupTextParser::addText(const QString& text)
+{
+  if(input == DETECT)
+  {
+    int i = 0;
+    while(i < text.size() && (text.at(i).isSpace() || text.at(i) == QChar(QChar::ByteOrderMark)))
+      i++;
+
+    if(i == text.size())
+      return;
+
+    setInput(text.at(i) == '{' ? JSON : TEXT);
+  }
+
+  if(input == JSON)
+  {
+    jsonReader->addData(text.toUtf8());
+    parseJson();
+  }
+  else
+  {
+    pendingText.append(text);
+    parseLines(false);
+  }
+}
+
+void WhazzupTextParser::setInput(Input value)
+{
+  input = value;
+  if(input == JSON)
+  {
+    // JSON is mapped to the VATSIM text columns
+    jsonReader = new atools::util::JsonStreamReader;
+    format = VATSIM;
+  }
+}
+
+bool WhazzupTextParser::finishRead()
+{
+  if(input == TEXT)
+    parseLines(true);
+  else if(input == JSON && !outdated && !invalid && jsonReader->getDepth() > 0)
+  {
+    qWarning() << Q_FUNC_INFO << "Incomplete JSON document";
+    invalid = true;
+  }
+
+  // Free buffers
+  pendingText.clear();
+  pendingText.squeeze();
+  delete gzipReader;
+  gzipReader = nullptr;
+  delete jsonReader;
+  jsonReader = nullptr;
+
+  if(outdated || invalid)
+  {
+    changes.clear();
+    return false;
   }
 
-  // Delete tables for available sections and keep others
   if(sections.contains("CLIENTS"))
   {
-    db->exec("delete from client");
-    db->exec("delete from atc");
+    if(diffActive)
+    {
+      deleteDeparted(clientDeleteQuery, clientRowHashes, curClientRowHashes, changes.clientsDeleted);
+      deleteDeparted(atcDeleteQuery, atcRowHashes, curAtcRowHashes, changes.atcDeleted);
+    }
+
+    if(clientStore != nullptr)
+    {
+      // Remove departed clients or all not in file after full reload
+      clientStore->retain(curClientRowHashes);
+      clientStore->updateIndex();
+    }
+
+    if(trailStore != nullptr)
+      trailStore->retain(curClientRowHashes);
+
+    // Remember content of database rows only after successful read
+    clientRowHashes.swap(curClientRowHashes);
+    atcRowHashes.swap(curAtcRowHashes);
+
+    // Keep geometry only for stations which are still online
+    atcGeometryCache.swap(curAtcGeometryCache);
+    curAtcGeometryCache.clear();
   }
+  return true;
+}
 
-  if(sections.contains("SERVERS"))
-    db->exec("delete from server where voice_type is null");
+void WhazzupTextParser::parseLines(bool atEnd)
+{
+  int start = 0, end;
+  while(!outdated && (end = pendingText.indexOf('\n', start)) != -1)
+  {
+    parseLine(pendingText.midRef(start, end - start).trimmed().toString());
+    start = end + 1;
+  }
 
-  if(sections.contains("AIRPORTS"))
-    db->exec("delete from airport");
+  if(atEnd && !outdated && start < pendingText.size())
+    // Last line without line end
+    parseLine(pendingText.midRef(start).trimmed().toString());
+
+  pendingText.remove(0, atEnd ? pendingText.size() : start);
+}
+
+void WhazzupTextParser::parseLine(const QString& line)
+{
+  // Skip comments and empty lines
+  if(line.isEmpty() || line.startsWith(";") || line.startsWith("#"))
+    return;
+
+  if(line.startsWith("!"))
+  {
+    // Remember section
+    curSection = line.mid(1).toUpper().trimmed().replace(':', "");
+    startSection(curSection);
+  }
+  else
+  {
+    // Parse the section data  (CSV like with : separator
+    if(curSection == "GENERAL")
+    {
+      QDateTime update = parseGeneralSection(line);
+
+      if(update.isValid())
+        checkUpdate(update);
+    }
+    else if(curSection == "CLIENTS")
+    {
+      QStringList columns = line.split(":");
+
+      // Check client type
+      parseSection(columns, at(columns, 3, error) == "ATC" /*ATC*/, false /* prefile */);
+    }
+    else if(curSection == "PREFILE")
+      parseSection(line.split(":"), false /*ATC*/, true /* prefile */);
+    else if(curSection == "SERVERS")
+      parseServersSection(line.split(":"));
+    else if(curSection == "VOICE" || curSection == "VOICE_SERVERS" || curSection == "VOICE SERVERS")
+      parseVoiceSection(line.split(":"));
+    else if(curSection == "AIRPORTS")
+      parseVoiceSection(line.split(":"));
+  }
+}
+
+void WhazzupTextParser::startSection(const QString& section)
+{
+  if(sections.contains(section))
+    return;
+
+  sections.insert(section);
 
-  if(sections.contains("VOICE") || sections.contains("VOICE_SERVERS") || sections.contains("VOICE SERVERS"))
+  // Delete tables for available sections and keep others
+  // Prefiles are stored in the client table too - clear before the first prefile or client row is written
+  if(section == "CLIENTS" || section == "PREFILE")
+  {
+    if(!diffActive && !changes.fullReload)
+    {
+      db->exec("delete from client");
+      db->exec("delete from atc");
+      changes.fullReload = true;
+    }
+  }
+  else if(section == "SERVERS")
+    db->exec("delete from server where voice_type is null");
+  else if(section == "AIRPORTS")
+    db->exec("delete from airport");
+  else if(section == "VOICE" || section == "VOICE_SERVERS" || section == "VOICE SERVERS")
     db->exec("delete from server where voice_type is not null");
+}
 
-  // Got back and read the whole file
-  stream.seek(0);
-  format = streamFormat;
-  while(!stream.atEnd())
+bool WhazzupTextParser::checkUpdate(const QDateTime& update)
+{
+  if(update <= lastUpdateTime)
   {
-    QString line = stream.readLine().trimmed();
+    // This is older than the last update - bail out
+    outdated = true;
+    return false;
+  }
+
+  updateTimestamp = update;
+  return true;
+}
 
-    // Skip comments and empty lines
-    if(line.isEmpty() || line.startsWith(";") || line.startsWith("#"))
-      continue;
+void WhazzupTextParser::parseJson()
+{
+  while(!outdated)
+  {
+    atools::util::JsonStreamReader::TokenType token = jsonReader->readNext();
+    if(token == atools::util::JsonStreamReader::NONE)
+      break;
 
-    if(line.startsWith("!"))
-      // Remember section
-      curSection = line.mid(1).toUpper().trimmed().replace(':', "");
-    else
+    if(token == atools::util::JsonStreamReader::INVALID)
     {
-      // Parse the section data  (CSV like with : separator
-      if(curSection == "GENERAL")
-      {
-        QDateTime update = parseGeneralSection(line);
+      qWarning() << Q_FUNC_INFO << "Error reading JSON" << jsonReader->getErrorString();
+      invalid = true;
+      break;
+    }
 
-        if(update.isValid())
+    // Depth 1 is the root object, 2 the section, 3 client objects and 4 the nested flight plan
+    int depth = jsonReader->getDepth();
+    const QString& key = jsonReader->getKey();
+
+    switch(token)
+    {
+      case atools::util::JsonStreamReader::START_OBJECT:
+      case atools::util::JsonStreamReader::START_ARRAY:
+        if(depth == 2)
+        {
+          jsonSection = key;
+          if(key == "pilots" || key == "controllers" || key == "atis")
+            startSection("CLIENTS");
+          else if(key == "prefiles")
+            startSection("PREFILE");
+          else if(key == "servers")
+            startSection("SERVERS");
+        }
+        else if(depth == 3)
         {
-          if(update <= lastUpdate)
-            // This is older than the last update - bail out
-            return false;
+          jsonValues.clear();
+          jsonAtisLines.clear();
+        }
+        else if(depth == 4)
+          jsonNestedKey = key;
+        break;
 
-          updateTimestamp = update;
+      case atools::util::JsonStreamReader::END_OBJECT:
+      case atools::util::JsonStreamReader::END_ARRAY:
+        if(depth == 1)
+          jsonSection.clear();
+        else if(depth == 2 && token == atools::util::JsonStreamReader::END_OBJECT && jsonSection != "general")
+          parseJsonObject();
+        else if(depth == 3)
+          jsonNestedKey.clear();
+        break;
+
+      case atools::util::JsonStreamReader::VALUE:
+        {
+          // Use numbers for booleans and empty strings for null like the text format
+          QString value = jsonReader->getValue();
+          if(!jsonReader->isString())
+          {
+            if(jsonReader->isNull())
+              value.clear();
+            else if(value == "true")
+              value = "1";
+            else if(value == "false")
+              value = "0";
+          }
+
+          if(depth == 2 && jsonSection == "general")
+          {
+            QDateTime update = parseGeneralSection(key + "=" + value);
+            if(update.isValid())
+              checkUpdate(update);
+          }
+          else if(depth == 3)
+            jsonValues.insert(key, value);
+          else if(depth == 4)
+          {
+            if(jsonNestedKey == "text_atis")
+              jsonAtisLines.append(value);
+            else
+              jsonValues.insert(jsonNestedKey + "." + key, value);
+          }
         }
-      }
-      else if(curSection == "CLIENTS")
-      {
-        QStringList columns = line.split(":");
-
-        // Check client type
-        parseSection(columns, at(columns, 3, error) == "ATC" /*ATC*/, false /* prefile */);
-      }
-      else if(curSection == "PREFILE")
-        parseSection(line.split(":"), false /*ATC*/, true /* prefile */);
-      else if(curSection == "SERVERS")
-        parseServersSection(line);
-      else if(curSection == "VOICE" || curSection == "VOICE_SERVERS" || curSection == "VOICE SERVERS")
-        parseVoiceSection(line);
-      else if(curSection == "AIRPORTS")
-        parseVoiceSection(line);
+        break;
+
+      case atools::util::JsonStreamReader::NONE:
+      case atools::util::JsonStreamReader::INVALID:
+        break;
+    }
+  }
+}
+
+void WhazzupTextParser::parseJsonObject()
+{
+  const QHash<QString, QString>& values = jsonValues;
+
+  if(jsonSection == "servers")
+  {
+    parseServersSection({values.value("ident"), values.value("hostname_or_ip"), values.value("location"),
+                         values.value("name"), values.value("clients_connection_allowed")});
+    return;
+  }
+
+  bool atc = jsonSection == "controllers" || jsonSection == "atis";
+  bool prefile = jsonSection == "prefiles";
+  if(!atc && !prefile && jsonSection != "pilots")
+    // Facilities, ratings and other lookup tables
+    return;
+
+  // Split "HHMM" into hours and minutes
+  QString enroute = values.value("flight_plan.enroute_time"), fuel = values.value("flight_plan.fuel_time");
+
+  // Build columns in VATSIM text format - see parseSection()
+  QStringList columns;
+  columns.reserve(41);
+  columns << values.value("callsign") << values.value("cid") << values.value("name")
+          << (atc ? "ATC" : "PILOT") << values.value("frequency")
+          << values.value("latitude") << values.value("longitude") << values.value("altitude")
+          << values.value("groundspeed")
+          << values.value("flight_plan.aircraft") << values.value("flight_plan.cruise_tas")
+          << values.value("flight_plan.departure") << values.value("flight_plan.altitude")
+          << values.value("flight_plan.arrival")
+          << values.value("server") << QString() << values.value(atc ? "rating" : "pilot_rating")
+          << values.value("transponder") << values.value("facility") << values.value("visual_range")
+          << values.value("flight_plan.revision_id") << values.value("flight_plan.flight_rules")
+          << values.value("flight_plan.deptime") << QString()
+          << enroute.left(2) << enroute.mid(2) << fuel.left(2) << fuel.mid(2)
+          << values.value("flight_plan.alternate") << values.value("flight_plan.remarks")
+          << values.value("flight_plan.route")
+          << QString() << QString() << QString() << QString()
+          << jsonAtisLines.join("^§") << jsonDateTime(values.value("last_updated"))
+          << jsonDateTime(values.value("logon_time")) << values.value("heading")
+          << values.value("qnh_i_hg") << values.value("qnh_mb");
+
+  parseSection(columns, atc, prefile);
+}
+
+void WhazzupTextParser::deleteDeparted(SqlQuery *deleteQuery, const QHash<int, uint>& oldHashes,
+                                       const QHash<int, uint>& newHashes, QVector<int>& deletedIds)
+{
+  for(auto it = oldHashes.constBegin(); it != oldHashes.constEnd(); ++it)
+  {
+    if(!newHashes.contains(it.key()))
+    {
+      deleteQuery->bindValue(":id", it.key());
+      deleteQuery->exec();
+      deletedIds.append(it.key());
     }
   }
-  return true;
 }
 
 QDateTime WhazzupTextParser::parseGeneralSection(const QString& line)
@@ -214,17 +600,47 @@ void WhazzupTextParser::parseSection(const QStringList& line, bool isAtc, bool i
   // .............................................. // 40 QNH_Mb
   // IVAO format .................................. // VATSIM format
 
+  // =============================================================================
+  // Create sort of a hash key to identify rows with the same data
+  const QString callsign = at(line, 0, error);
+  const QString vid = at(line, 1, error);
+  QString hashKey = callsign + "|" + QString::number(atInt(line, 18, error)) + "|" + vid;
+
+  // Look up recent database id by key or get a new one
+  int id = getSemiPermanentId(isAtc ? atcIdMap : clientIdMap, isAtc ? curAtcId : curClientId, hashKey);
+  // qDebug() << hashKey << id;
+
+  // Detect changed rows by comparing the hash of the whole line
+  uint rowHash = qHash(line.join(':'), isPrefile ? 1u : 0u);
+  const QHash<int, uint>& rowHashes = isAtc ? atcRowHashes : clientRowHashes;
+  QHash<int, uint>& curRowHashes = isAtc ? curAtcRowHashes : curClientRowHashes;
+
+  bool exists = rowHashes.contains(id) || curRowHashes.contains(id);
+  bool unchanged = diffActive && !curRowHashes.contains(id) && rowHashes.contains(id) &&
+                   rowHashes.value(id) == rowHash;
+  curRowHashes.insert(id, rowHash);
+
+  if(unchanged)
+    // Row in database is up to date - nothing to do
+    return;
+
+  if(diffActive && exists)
+    (isAtc ? changes.atcUpdated : changes.clientsUpdated).append(id);
+  else
+    (isAtc ? changes.atcInserted : changes.clientsInserted).append(id);
+
   atools::sql::SqlQuery *insertQuery = isAtc ? atcInsertQuery : clientInsertQuery;
 
-  int index = 0;
+  int index = 1;
   insertQuery->clearBoundValues();
 
-  const QString callsign = at(line, index++, error);
   insertQuery->bindValue(":callsign", callsign);
 
-  const QString vid = at(line, index++, error);
+  index++;
   insertQuery->bindValue(":vid", vid);
-  insertQuery->bindValue(":name", convertName(at(line, index++, error)));
+  // JSON is already proper unicode
+  QString name = at(line, index++, error);
+  insertQuery->bindValue(":name", input == JSON ? name : convertName(name));
 
   if(!isAtc)
     insertQuery->bindValue(":prefile", isPrefile);
@@ -460,49 +876,66 @@ void WhazzupTextParser::parseSection(const QStringList& line, bool isAtc, bool i
   if(atc)
   {
     // Geometry for centers =============================================================================
-    LineString lineString;
-    if(geometryCallback)
-    {
-      // Try to get from callback (i.e. user airspace database)
-      LineString *ptr = geometryCallback(callsign, facilityType);
-      if(ptr != nullptr)
-        // Copy cache object
-        lineString = *ptr;
-    }
+    AtcGeometryKey key = {callsign, facilityType, circleRadius, lonx, laty};
 
-    if(lineString.isEmpty())
+    // Station might appear twice in one file or was already present in the last read
+    AtcGeometry geometry;
+    QHash<AtcGeometryKey, AtcGeometry>::const_iterator it = curAtcGeometryCache.constFind(key);
+    if(it != curAtcGeometryCache.constEnd())
+      geometry = it.value();
+    else
     {
-      // Nothing found or no callback - create a circle shape
-      // Create a circular polygon with 10 degree segments
-      Pos center(lonx, laty);
-
-      // at least 1/10 nm radius
-      lineString = LineString(center,
-                              atools::geo::nmToMeter(std::min(1000.f, std::max(1.f, static_cast<float>(circleRadius)))),
-                              36);
+      it = atcGeometryCache.constFind(key);
+      geometry = it != atcGeometryCache.constEnd() ? it.value() : createAtcGeometry(key);
+      curAtcGeometryCache.insert(key, geometry);
     }
 
     // Add bounding rectangle
-    Rect bounding = lineString.boundingRect();
-    insertQuery->bindValue(":max_lonx", bounding.getEast());
-    insertQuery->bindValue(":max_laty", bounding.getNorth());
-    insertQuery->bindValue(":min_lonx", bounding.getWest());
-    insertQuery->bindValue(":min_laty", bounding.getSouth());
-
-    // Store geometry in same format as boundaries
-    insertQuery->bindValue(":geometry", atools::fs::common::BinaryGeometry(lineString).writeToByteArray());
+    insertQuery->bindValue(":max_lonx", geometry.east);
+    insertQuery->bindValue(":max_laty", geometry.north);
+    insertQuery->bindValue(":min_lonx", geometry.west);
+    insertQuery->bindValue(":min_laty", geometry.south);
+    insertQuery->bindValue(":geometry", geometry.geometry);
   }
 
-  // =============================================================================
-  // Create sort of a hash key to identify rows with the same data
-  QString hashKey = callsign + "|" + QString::number(facilityType) + "|" + vid;
-  // Look up recent database id by key or get a new one
-  int id = getSemiPermanentId(isAtc ? atcIdMap : clientIdMap, isAtc ? curAtcId : curClientId, hashKey);
-
-  // qDebug() << hashKey << id;
   insertQuery->bindValue(isAtc ? ":atc_id" : ":client_id", id);
 
   insertQuery->exec();
+
+  if(clientStore != nullptr && !isAtc)
+    updateClientStore(id, isPrefile);
+
+  if(trailStore != nullptr && !isAtc && !isPrefile)
+  {
+    // Use time of the file since clients report only with each update
+    qint64 timestampMs = updateTimestamp.isValid() ? updateTimestamp.toMSecsSinceEpoch() :
+                         QDateTime::currentMSecsSinceEpoch();
+    trailStore->append(static_cast<quint64>(id), timestampMs,
+                       Pos(lonx, laty, insertQuery->boundValue(":altitude", true).toFloat()));
+  }
+}
+
+void WhazzupTextParser::updateClientStore(int id, bool isPrefile)
+{
+  // Store only aircraft like OnlinedataManager::fillFromClient()
+  if(isPrefile || clientInsertQuery->boundValue(":client_type", true).toString() != "PILOT")
+  {
+    clientStore->remove(id);
+    return;
+  }
+
+  OnlineClient client;
+  client.callsign = clientInsertQuery->boundValue(":callsign", true).toString();
+  client.aircraftType = clientInsertQuery->boundValue(":flightplan_aircraft", true).toString();
+  client.fromIdent = clientInsertQuery->boundValue(":flightplan_departure_aerodrome", true).toString();
+  client.toIdent = clientInsertQuery->boundValue(":flightplan_destination_aerodrome", true).toString();
+  client.position = Pos(clientInsertQuery->boundValue(":lonx", true).toFloat(),
+                        clientInsertQuery->boundValue(":laty", true).toFloat(),
+                        clientInsertQuery->boundValue(":altitude", true).toFloat());
+  client.headingTrueDeg = clientInsertQuery->boundValue(":heading", true).toFloat();
+  client.groundSpeedKts = clientInsertQuery->boundValue(":groundspeed", true).toFloat();
+  client.onGround = clientInsertQuery->boundValue(":on_ground", true).toBool();
+  clientStore->update(id, client);
 }
 
 int WhazzupTextParser::getSemiPermanentId(QHash<QString, int>& idMap, int& curId, const QString& key)
@@ -530,7 +963,7 @@ QDateTime WhazzupTextParser::parseDateTime(const QStringList& line, int index)
     return QDateTime();
 }
 
-void WhazzupTextParser::parseServersSection(const QString& line)
+void WhazzupTextParser::parseServersSection(const QStringList& columns)
 {
   // IVAO
   // Ident    The identification of the server (unique).    n/a
@@ -543,7 +976,6 @@ void WhazzupTextParser::parseServersSection(const QString& line)
   // VATSIM
   // ident:hostname_or_IP:location:name:clients_connection_allowed:
   // CZECH:212.67.73.150:Czech Republic:CenterEast Europe Server - sponsored by VACC-CZ:1:
-  QStringList columns = line.split(":");
   int index = 0;
   serverInsertQuery->clearBoundValues();
   serverInsertQuery->bindValue(":ident", at(columns, index++, error));
@@ -557,13 +989,12 @@ void WhazzupTextParser::parseServersSection(const QString& line)
   serverInsertQuery->exec();
 }
 
-void WhazzupTextParser::parseVoiceSection(const QString& line)
+void WhazzupTextParser::parseVoiceSection(const QStringList& columns)
 {
   // VATSIM
   // hostname_or_IP:location:name:clients_connection_allowed:type_of_voice_server:
   // canada.voice.vatsim.net:Canada:VATSIM Server - Canada:1:R:
 
-  QStringList columns = line.split(":");
   int index = 0;
   serverInsertQuery->clearBoundValues();
   serverInsertQuery->bindValue(":hostname", at(columns, index++, error));
@@ -574,13 +1005,12 @@ void WhazzupTextParser::parseVoiceSection(const QString& line)
   serverInsertQuery->exec();
 }
 
-void WhazzupTextParser::parseAirportSection(const QString& line)
+void WhazzupTextParser::parseAirportSection(const QStringList& columns)
 {
   // IVAO
   // Name   Description   Unit
   // ICAO   The ICAO code of the airport.   n/a
   // ATIS   The ATIS of the airport.  n/a
-  QStringList columns = line.split(":");
   int index = 0;
   airportInsertQuery->clearBoundValues();
   airportInsertQuery->bindValue(":ident", at(columns, index++, error));
@@ -605,6 +1035,12 @@ void WhazzupTextParser::initQueries()
 
   airportInsertQuery = new SqlQuery(db);
   airportInsertQuery->prepare(util.buildInsertStatement("airport", QString(), {"airport_id"}));
+
+  clientDeleteQuery = new SqlQuery(db);
+  clientDeleteQuery->prepare("delete from client where client_id = :id");
+
+  atcDeleteQuery = new SqlQuery(db);
+  atcDeleteQuery->prepare("delete from atc where atc_id = :id");
 }
 
 void WhazzupTextParser::deInitQueries()
@@ -620,6 +1056,50 @@ void WhazzupTextParser::deInitQueries()
 
   delete airportInsertQuery;
   airportInsertQuery = nullptr;
+
+  delete clientDeleteQuery;
+  clientDeleteQuery = nullptr;
+
+  delete atcDeleteQuery;
+  atcDeleteQuery = nullptr;
+}
+
+WhazzupTextParser::AtcGeometry WhazzupTextParser::createAtcGeometry(const AtcGeometryKey& key) const
+{
+  LineString lineString;
+  if(geometryCallback)
+  {
+    // Try to get from callback (i.e. user airspace database)
+    LineString *ptr = geometryCallback(key.callsign,
+                                       static_cast<atools::fs::online::fac::FacilityType>(key.facilityType));
+    if(ptr != nullptr)
+      // Copy cache object
+      lineString = *ptr;
+  }
+
+  if(lineString.isEmpty())
+  {
+    // Nothing found or no callback - create a circle shape
+    // Create a circular polygon with 10 degree segments
+    Pos center(key.lonX, key.latY);
+
+    // at least 1/10 nm radius
+    lineString = LineString(center,
+                            atools::geo::nmToMeter(std::min(1000.f, std::max(1.f, static_cast<float>(key.radius)))),
+                            36);
+  }
+
+  AtcGeometry geometry;
+  Rect bounding = lineString.boundingRect();
+  geometry.west = bounding.getWest();
+  geometry.east = bounding.getEast();
+  geometry.south = bounding.getSouth();
+  geometry.north = bounding.getNorth();
+
+  // Online data is not persistent - use compact format which is read like the boundaries
+  geometry.geometry = atools::fs::common::BinaryGeometry(lineString).
+                      writeToByteArray(atools::fs::common::BinaryGeometry::FORMAT_COMPACT);
+  return geometry;
 }
 
 void WhazzupTextParser::resetForNewOptions()
@@ -627,9 +1107,19 @@ void WhazzupTextParser::resetForNewOptions()
   // Clear the id maps but do not reset the current ids to avoid overlaps
   atcIdMap.clear();
   clientIdMap.clear();
+  clearAtcGeometryCache();
+
+  // Options like ATC radius change the rows - force full reload
+  resetRowHashes();
   reset();
 }
 
+void WhazzupTextParser::resetRowHashes()
+{
+  clientRowHashes.clear();
+  atcRowHashes.clear();
+}
+
 void WhazzupTextParser::reset()
 {
   curSection.clear();
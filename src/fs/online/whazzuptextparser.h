@@ -22,9 +22,11 @@
 #include "fs/online/onlinetypes.h"
 
 #include <QDateTime>
+#include <QSet>
 #include <QString>
 
 class QTextStream;
+class QTextDecoder;
 
 namespace atools {
 namespace sql {
@@ -32,14 +34,29 @@ class SqlDatabase;
 class SqlQuery;
 }
 
+namespace util {
+class JsonStreamReader;
+}
+
+namespace geo {
+class TrailStore;
+}
+
+namespace zip {
+class GzipReader;
+}
+
 namespace fs {
 namespace online {
 
+class OnlineClientStore;
+
 /*
  * Reads a "whazzup.txt" file and stores all found data in the database.
  * Schema has to be created before.
  *
- * Supported formats are the ones used by VATSIM and IVAO.
+ * Supported formats are the ones used by VATSIM and IVAO. The VATSIM JSON feed is detected automatically
+ * and mapped to the columns of the VATSIM text format.
  */
 class WhazzupTextParser
 {
@@ -55,6 +72,18 @@ public:
    *  Returns true if the file was read and is more recent than lastUpdate. */
   bool read(QTextStream& stream, atools::fs::online::Format streamFormat, const QDateTime& lastUpdate);
 
+  /* Read file incrementally while downloading. Call beginRead(), then addData() for each received chunk and
+   * finishRead() when done. Rows are written while reading. Caller has to handle the transaction.
+   * Text and JSON format are detected automatically. GZIP compressed data is decompressed on the fly.
+   * lastUpdate is used like in read(). */
+  void beginRead(atools::fs::online::Format streamFormat, const QDateTime& lastUpdate);
+
+  /* Returns false if the file is older than lastUpdate or has errors. Reading can be aborted then. */
+  bool addData(const QByteArray& data);
+
+  /* Process remaining data. Returns true if the file was read and is more recent than lastUpdate. */
+  bool finishRead();
+
   /* Create all queries */
   void initQueries();
 
@@ -82,6 +111,43 @@ public:
   void reset();
   void resetForNewOptions();
 
+  /* Enable diff mode which keeps the client and atc tables between reads. Rows are identified by their
+   * semi-permanent ids. Only new or changed rows are written and rows of departed clients are deleted.
+   * First read after resetRowHashes() or resetForNewOptions() always clears and fills the tables. */
+  void setDiffMode(bool value)
+  {
+    diffMode = value;
+  }
+
+  bool isDiffMode() const
+  {
+    return diffMode;
+  }
+
+  /* Forget the content of the rows in the database. Has to be called if tables were modified elsewhere. */
+  void resetRowHashes();
+
+  /* Set a store which will be filled with pilot clients in parallel to the client table. Not owned.
+   * Forces a full reload on the next read. Use nullptr to disable. */
+  void setClientStore(atools::fs::online::OnlineClientStore *store)
+  {
+    clientStore = store;
+    resetRowHashes();
+  }
+
+  /* Set a store which gets a trail sample for each changed pilot client keyed by the semi-permanent client id.
+   * Trails of clients not in the file are removed after each successful read. Not owned. Use nullptr to disable. */
+  void setTrailStore(atools::geo::TrailStore *store)
+  {
+    trailStore = store;
+  }
+
+  /* Rows changed by the last successful read */
+  const atools::fs::online::WhazzupChanges& getChanges() const
+  {
+    return changes;
+  }
+
   /* Set default circle radii for certain ATC types where visual range is unusable */
   void setAtcSize(const QHash<atools::fs::online::fac::FacilityType, int>& value)
   {
@@ -93,14 +159,79 @@ public:
   void setGeometryCallback(GeoCallbackType func)
   {
     geometryCallback = func;
+    clearAtcGeometryCache();
+  }
+
+  /* Forget cached ATC geometry. Has to be called if the result of the geometry callback changes,
+   * e.g. after loading new user airspaces. */
+  void clearAtcGeometryCache()
+  {
+    atcGeometryCache.clear();
+    curAtcGeometryCache.clear();
   }
 
 private:
+  /* Identifies ATC stations with the same geometry. Position is compared as read from the file. */
+  struct AtcGeometryKey
+  {
+    QString callsign;
+    int facilityType, radius;
+    float lonX, latY;
+
+    bool operator==(const AtcGeometryKey& other) const
+    {
+      return facilityType == other.facilityType && radius == other.radius && lonX == other.lonX &&
+             latY == other.latY && callsign == other.callsign;
+    }
+
+    friend uint qHash(const AtcGeometryKey& key, uint seed)
+    {
+      return qHash(key.callsign, seed) ^ qHash(key.facilityType) ^ qHash(key.radius) ^
+             qHash(key.lonX) * 31u ^ qHash(key.latY);
+    }
+  };
+
+  /* Geometry blob and bounding rectangle ready for binding */
+  struct AtcGeometry
+  {
+    QByteArray geometry;
+    float west, east, south, north;
+  };
+
+  /* Input type detected from first bytes */
+  enum Input
+  {
+    DETECT,
+    TEXT,
+    JSON
+  };
+
+  /* Append decoded text or raw UTF-8 bytes and parse all complete lines or tokens */
+  void addText(const QString& text);
+  void addBytes(const QByteArray& bytes);
+  void setInput(Input value);
+
+  /* Parse all complete lines in pending text */
+  void parseLines(bool atEnd);
+  void parseLine(const QString& line);
+
+  /* Parse all complete tokens from the JSON reader */
+  void parseJson();
+
+  /* Convert JSON object of a client, prefile or server to text format columns and write it */
+  void parseJsonObject();
+
+  /* Called on first occurence of a section. Clears tables for the section. */
+  void startSection(const QString& section);
+
+  /* Returns false if the file is outdated */
+  bool checkUpdate(const QDateTime& update);
+
   QDateTime parseGeneralSection(const QString& line);
   void parseSection(const QStringList& line, bool isAtc, bool isPrefile);
-  void parseServersSection(const QString& line);
-  void parseVoiceSection(const QString& line);
-  void parseAirportSection(const QString& line);
+  void parseServersSection(const QStringList& columns);
+  void parseVoiceSection(const QStringList& columns);
+  void parseAirportSection(const QStringList& columns);
 
   /* Remove special characters from ATC text */
   QString convertAtisText(QString atis);
@@ -112,6 +243,16 @@ private:
   QString convertName(QString name);
   int getSemiPermanentId(QHash<QString, int>& idMap, int& curId, const QString& key);
 
+  /* Fetch geometry from callback or create a circle and encode it */
+  AtcGeometry createAtcGeometry(const AtcGeometryKey& key) const;
+
+  /* Copy pilot client from the bound values of the insert query into the store */
+  void updateClientStore(int id, bool isPrefile);
+
+  /* Delete rows from table which were present in the last read but not in the current one */
+  void deleteDeparted(atools::sql::SqlQuery *deleteQuery, const QHash<int, uint>& oldHashes,
+                      const QHash<int, uint>& newHashes, QVector<int>& deletedIds);
+
   QString curSection;
   atools::fs::online::Format format = atools::fs::online::UNKNOWN;
 
@@ -129,7 +270,8 @@ private:
 
   atools::sql::SqlDatabase *db;
   atools::sql::SqlQuery *clientInsertQuery = nullptr, *atcInsertQuery = nullptr,
-                        *serverInsertQuery = nullptr, *airportInsertQuery = nullptr;
+                        *serverInsertQuery = nullptr, *airportInsertQuery = nullptr,
+                        *clientDeleteQuery = nullptr, *atcDeleteQuery = nullptr;
 
   // Assign row ids manually
   int curClientId = 1, curAtcId = 1;
@@ -139,10 +281,42 @@ private:
   QHash<QString, int> clientIdMap, atcIdMap;
   QHash<atools::fs::online::fac::FacilityType, int> atcRadius;
 
+  // Map of row id to hash of the whazzup line for rows in the database and for the rows of the current read
+  QHash<int, uint> clientRowHashes, atcRowHashes, curClientRowHashes, curAtcRowHashes;
+  atools::fs::online::WhazzupChanges changes;
+  bool diffMode = false, diffActive = false;
+
   // Report errors on warning channel
   bool error = false;
 
   GeoCallbackType geometryCallback;
+
+  // Geometry of ATC stations from the last successful read and the current read.
+  // Avoids fetching or tessellating the geometry again for unchanged stations.
+  QHash<AtcGeometryKey, AtcGeometry> atcGeometryCache, curAtcGeometryCache;
+  atools::fs::online::OnlineClientStore *clientStore = nullptr;
+  atools::geo::TrailStore *trailStore = nullptr;
+
+  // State for incremental reading =========================
+  QDateTime lastUpdateTime;
+  QSet<QString> sections;
+  Input input = DETECT;
+  bool outdated = false, invalid = false;
+
+  // Collects first bytes until GZIP magic number can be checked
+  bool gzipChecked = false;
+  QByteArray detectBytes;
+
+  // Text which has no line end yet
+  QString pendingText;
+  QTextDecoder *decoder = nullptr;
+  atools::zip::GzipReader *gzipReader = nullptr;
+  atools::util::JsonStreamReader *jsonReader = nullptr;
+
+  // Values of the current JSON client, prefile or server. Keys of nested objects are prefixed with "key.".
+  QHash<QString, QString> jsonValues;
+  QStringList jsonAtisLines;
+  QString jsonSection, jsonNestedKey;
 };
 
 } // namespace online
@@ -0,0 +1,290 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/perf/aircraftperfcatalog.h"
+
+#include "fs/perf/aircraftperf.h"
+#include "util/parallel.h"
+#include "exception.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace perf {
+
+/* Index file format */
+static Q_DECL_CONSTEXPR quint32 INDEX_MAGIC_NUMBER = 0x50E3F2A7;
+static Q_DECL_CONSTEXPR quint16 INDEX_VERSION = 1;
+
+/* Normalized absolute path used as key */
+static QString cleanPath(const QString& path)
+{
+  return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+}
+
+AircraftPerfCatalog::AircraftPerfCatalog(const QString& indexFilename)
+  : indexFile(indexFilename)
+{
+  readIndex();
+}
+
+AircraftPerfCatalog::~AircraftPerfCatalog()
+{
+  save();
+}
+
+int AircraftPerfCatalog::update(const QString& directory, bool recursive, const QStringList& nameFilters)
+{
+  QString dir = cleanPath(directory);
+  QVector<AircraftPerfCatalogEntry> changed;
+  QSet<QString> found;
+
+  QDirIterator it(dir, nameFilters, QDir::Files,
+                  recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+  while(it.hasNext())
+  {
+    it.next();
+    QFileInfo fi = it.fileInfo();
+    QString filepath = QDir::cleanPath(fi.absoluteFilePath());
+    found.insert(filepath);
+
+    // Compare only file stats - no need to open unchanged files
+    QHash<QString, AircraftPerfCatalogEntry>::const_iterator entryIt = index.constFind(filepath);
+    if(entryIt == index.constEnd() || entryIt->size != fi.size() || entryIt->lastModified != fi.lastModified())
+    {
+      AircraftPerfCatalogEntry entry;
+      entry.filepath = filepath;
+      entry.size = fi.size();
+      entry.lastModified = fi.lastModified();
+      changed.append(entry);
+    }
+  }
+
+  // Remove deleted files =========================
+  for(QHash<QString, AircraftPerfCatalogEntry>::iterator entryIt = index.begin(); entryIt != index.end();)
+  {
+    if(isInDirectory(entryIt.key(), dir, recursive) && !found.contains(entryIt.key()))
+    {
+      entryIt = index.erase(entryIt);
+      indexChanged = true;
+    }
+    else
+      ++entryIt;
+  }
+
+  // Load new and changed files in parallel =========================
+  atools::util::parallelFor(changed.size(), [&changed](int i) {
+    loadEntry(changed[i]);
+  }, 4);
+
+  for(const AircraftPerfCatalogEntry& entry : changed)
+    index.insert(entry.filepath, entry);
+
+  if(!changed.isEmpty())
+    indexChanged = true;
+
+  qDebug() << Q_FUNC_INFO << dir << "files" << found.size() << "loaded" << changed.size();
+  return changed.size();
+}
+
+AircraftPerfCatalogEntryVector AircraftPerfCatalog::getEntries(const QString& directory, bool recursive) const
+{
+  QString dir = cleanPath(directory);
+  AircraftPerfCatalogEntryVector entries;
+  for(const AircraftPerfCatalogEntry& entry : index)
+  {
+    if(entry.valid && isInDirectory(entry.filepath, dir, recursive))
+      entries.append(entry);
+  }
+  sortByName(entries);
+  return entries;
+}
+
+AircraftPerfCatalogEntryVector AircraftPerfCatalog::search(const QString& directory, const QString& text,
+                                                           bool recursive) const
+{
+  AircraftPerfCatalogEntryVector entries = getEntries(directory, recursive);
+  if(!text.isEmpty())
+  {
+    auto notMatching = [&text](const AircraftPerfCatalogEntry& entry) -> bool {
+      return !entry.name.contains(text, Qt::CaseInsensitive) &&
+             !entry.aircraftType.contains(text, Qt::CaseInsensitive) &&
+             !entry.description.contains(text, Qt::CaseInsensitive) &&
+             !QFileInfo(entry.filepath).fileName().contains(text, Qt::CaseInsensitive);
+    };
+    entries.erase(std::remove_if(entries.begin(), entries.end(), notMatching), entries.end());
+  }
+  return entries;
+}
+
+bool AircraftPerfCatalog::getEntry(const QString& filepath, AircraftPerfCatalogEntry& entry) const
+{
+  QHash<QString, AircraftPerfCatalogEntry>::const_iterator it = index.constFind(cleanPath(filepath));
+  if(it != index.constEnd() && it->valid)
+  {
+    entry = it.value();
+    return true;
+  }
+  return false;
+}
+
+void AircraftPerfCatalog::updateEntry(const QString& filepath, const QString& name, const QString& aircraftType,
+                                      const QString& description)
+{
+  QFileInfo fi(filepath);
+  AircraftPerfCatalogEntry entry;
+  entry.filepath = cleanPath(filepath);
+  entry.name = name;
+  entry.aircraftType = aircraftType;
+  entry.description = description;
+  entry.size = fi.size();
+  entry.lastModified = fi.lastModified();
+  entry.valid = fi.exists();
+  index.insert(entry.filepath, entry);
+  indexChanged = true;
+}
+
+void AircraftPerfCatalog::clear()
+{
+  index.clear();
+  indexChanged = true;
+}
+
+void AircraftPerfCatalog::save()
+{
+  if(indexChanged)
+    writeIndex();
+}
+
+bool AircraftPerfCatalog::isInDirectory(const QString& filepath, const QString& directory, bool recursive)
+{
+  if(recursive)
+    return filepath.startsWith(directory) && filepath.size() > directory.size() &&
+           (directory.endsWith('/') || filepath.at(directory.size()) == '/');
+  else
+    return QFileInfo(filepath).path() == directory;
+}
+
+void AircraftPerfCatalog::loadEntry(AircraftPerfCatalogEntry& entry)
+{
+  try
+  {
+    AircraftPerf perf;
+    perf.load(entry.filepath);
+    entry.name = perf.getName();
+    entry.aircraftType = perf.getAircraftType();
+    entry.description = perf.getDescription();
+    entry.valid = true;
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot load" << entry.filepath << e.what();
+    entry.valid = false;
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot load" << entry.filepath;
+    entry.valid = false;
+  }
+}
+
+void AircraftPerfCatalog::sortByName(AircraftPerfCatalogEntryVector& entries)
+{
+  std::sort(entries.begin(), entries.end(), [](const AircraftPerfCatalogEntry& e1,
+                                               const AircraftPerfCatalogEntry& e2) -> bool {
+    int cmp = e1.name.compare(e2.name, Qt::CaseInsensitive);
+    return cmp == 0 ? e1.filepath < e2.filepath : cmp < 0;
+  });
+}
+
+void AircraftPerfCatalog::readIndex()
+{
+  index.clear();
+
+  QFile file(indexFile);
+  if(!file.exists())
+    return;
+
+  if(file.open(QIODevice::ReadOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    quint32 magic;
+    quint16 version;
+    qint32 size;
+    stream >> magic >> version >> size;
+
+    if(magic == INDEX_MAGIC_NUMBER && version == INDEX_VERSION)
+    {
+      for(qint32 i = 0; i < size && stream.status() == QDataStream::Ok; i++)
+      {
+        AircraftPerfCatalogEntry entry;
+        stream >> entry.filepath >> entry.name >> entry.aircraftType >> entry.description >> entry.lastModified >>
+          entry.size >> entry.valid;
+
+        if(stream.status() == QDataStream::Ok)
+          index.insert(entry.filepath, entry);
+      }
+    }
+    else
+    {
+      qWarning() << Q_FUNC_INFO << "Invalid catalog index" << file.fileName() << "magic" << magic
+                 << "version" << version;
+      indexChanged = true;
+    }
+    file.close();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot read catalog index" << file.fileName() << file.errorString();
+}
+
+void AircraftPerfCatalog::writeIndex()
+{
+  QSaveFile file(indexFile);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    stream << INDEX_MAGIC_NUMBER << INDEX_VERSION << static_cast<qint32>(index.size());
+    for(const AircraftPerfCatalogEntry& entry : index)
+      stream << entry.filepath << entry.name << entry.aircraftType << entry.description << entry.lastModified
+             << entry.size << entry.valid;
+
+    if(file.commit())
+      indexChanged = false;
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot write catalog index" << file.fileName() << file.errorString();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write catalog index" << file.fileName() << file.errorString();
+}
+
+} // namespace perf
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,118 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_AIRCRAFTPERFCATALOG_H
+#define ATOOLS_AIRCRAFTPERFCATALOG_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace perf {
+
+/* Header fields of an aircraft performance file as stored in the catalog */
+struct AircraftPerfCatalogEntry
+{
+  QString filepath, name, aircraftType, description;
+
+  /* Used to detect changed files */
+  QDateTime lastModified;
+  qint64 size = 0;
+
+  /* false if the file could not be loaded. Kept to avoid loading it again until it changes. */
+  bool valid = false;
+};
+
+typedef QVector<AircraftPerfCatalogEntry> AircraftPerfCatalogEntryVector;
+
+/*
+ * Catalog of aircraft performance files which keeps name, aircraft type and description of each file.
+ *
+ * The catalog is stored in an index file together with modification time and size of each performance file.
+ * update() loads only new or changed files and drops removed ones. Listing and searching profiles
+ * does not need to parse any file then.
+ *
+ * Not thread safe. Changed files are loaded in parallel by update().
+ */
+class AircraftPerfCatalog
+{
+public:
+  /* Opens catalog and reads indexFilename if it exists. Index is written on destruction if changed. */
+  explicit AircraftPerfCatalog(const QString& indexFilename);
+  ~AircraftPerfCatalog();
+
+  AircraftPerfCatalog(const AircraftPerfCatalog& other) = delete;
+  AircraftPerfCatalog& operator=(const AircraftPerfCatalog& other) = delete;
+
+  /* Bring entries for files in directory matching the name filters up to date.
+   * Loads new and changed files and removes entries of deleted files. Sub-directories are included if recursive.
+   * Returns the number of loaded files. */
+  int update(const QString& directory, bool recursive = false,
+             const QStringList& nameFilters = {"*.lnmperf"});
+
+  /* Get all entries for files in directory sorted by name. Includes entries in sub-directories if recursive.
+   * Files which could not be loaded are omitted. Call update() before to get the current state. */
+  AircraftPerfCatalogEntryVector getEntries(const QString& directory, bool recursive = false) const;
+
+  /* Find entries in directory containing text case insensitive in file name, name, type or description.
+   * Result is sorted by name. */
+  AircraftPerfCatalogEntryVector search(const QString& directory, const QString& text, bool recursive = false) const;
+
+  /* Get entry for a single file. Returns false if not in catalog or not valid. */
+  bool getEntry(const QString& filepath, AircraftPerfCatalogEntry& entry) const;
+
+  /* Update a single entry after saving a performance file. Does not load the file. */
+  void updateEntry(const QString& filepath, const QString& name, const QString& aircraftType,
+                   const QString& description);
+
+  /* Remove all entries */
+  void clear();
+
+  /* Write index file now if changed */
+  void save();
+
+  int size() const
+  {
+    return index.size();
+  }
+
+private:
+  void readIndex();
+  void writeIndex();
+
+  /* true if filepath is in directory or one of its sub-directories if recursive */
+  static bool isInDirectory(const QString& filepath, const QString& directory, bool recursive);
+
+  /* Load header fields from file and fill entry. Does not throw */
+  static void loadEntry(AircraftPerfCatalogEntry& entry);
+
+  static void sortByName(AircraftPerfCatalogEntryVector& entries);
+
+  /* Canonical file path to entry */
+  QHash<QString, AircraftPerfCatalogEntry> index;
+  QString indexFile;
+  bool indexChanged = false;
+};
+
+} // namespace perf
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_AIRCRAFTPERFCATALOG_H
@@ -54,6 +54,12 @@ void AircraftPerfHandler::start()
 
   lastSampleTimeMs = lastCruiseSampleTimeMs = lastClimbSampleTimeMs = lastDescentSampleTimeMs = 0L;
 
+  // Evaluate first packet immediately
+  timer.start();
+  lastEvaluationMs = -sampleIntervalMs;
+  ringHead = ringCount = packetCount = 0;
+  smoothed = Sample();
+
   aircraftClimb = aircraftDescent = aircraftFuelFlow = aircraftGround = aircraftFlying = false;
   aircraftCruise = 0;
 
@@ -75,16 +81,73 @@ void AircraftPerfHandler::stop()
 
 void AircraftPerfHandler::simDataChanged(const sc::SimConnectData& simulatorData)
 {
-  *curSimAircraft = simulatorData.getUserAircraftConst();
-  if(!active || !curSimAircraft->isFullyValid() || curSimAircraft->isSimPaused() || curSimAircraft->isSimReplay())
+  const SimConnectUserAircraft& aircraft = simulatorData.getUserAircraftConst();
+  if(!active || !aircraft.isFullyValid() || aircraft.isSimPaused() || aircraft.isSimReplay())
+    return;
+
+  // Decimate packets ===============================================
+  if(++packetCount < decimation)
     return;
+  packetCount = 0;
+
+  // Store raw sample - overwrites oldest if full ===================
+  Sample& sample = ring[static_cast<size_t>((ringHead + ringCount) % RING_SIZE)];
+  sample.trueAirspeedKts = aircraft.getTrueAirspeedKts();
+  sample.verticalSpeedFtPerMin = aircraft.getVerticalSpeedFeetPerMin();
+  sample.fuelFlowPph = aircraft.getFuelFlowPPH();
+  sample.indicatedAltitudeFt = aircraft.getIndicatedAltitudeFt();
+  sample.fuelTotalWeightLbs = aircraft.getFuelTotalWeightLbs();
+  sample.fuelTotalQuantityGal = aircraft.getFuelTotalQuantityGallons();
+  sample.onGround = aircraft.isOnGround();
+  sample.flying = aircraft.isFlying();
+  sample.fuelFlow = aircraft.hasFuelFlow();
+
+  if(ringCount < RING_SIZE)
+    ringCount++;
+  else
+    ringHead = (ringHead + 1) % RING_SIZE;
+
+  // Evaluate at fixed interval only ================================
+  qint64 now = timer.elapsed();
+  if(now >= lastEvaluationMs + sampleIntervalMs)
+  {
+    *curSimAircraft = aircraft;
+    aggregateSamples();
+    evaluate(now);
+    lastEvaluationMs = now;
+  }
+}
 
+void AircraftPerfHandler::aggregateSamples()
+{
+  // Average continuous values and use latest state for others
+  double tas = 0., vs = 0., fuelFlow = 0., alt = 0.;
+  for(int i = 0; i < ringCount; i++)
+  {
+    const Sample& sample = ring[static_cast<size_t>((ringHead + i) % RING_SIZE)];
+    tas += sample.trueAirspeedKts;
+    vs += sample.verticalSpeedFtPerMin;
+    fuelFlow += sample.fuelFlowPph;
+    alt += sample.indicatedAltitudeFt;
+  }
+
+  smoothed = ring[static_cast<size_t>((ringHead + ringCount - 1) % RING_SIZE)];
+  smoothed.trueAirspeedKts = static_cast<float>(tas / ringCount);
+  smoothed.verticalSpeedFtPerMin = static_cast<float>(vs / ringCount);
+  smoothed.fuelFlowPph = static_cast<float>(fuelFlow / ringCount);
+  smoothed.indicatedAltitudeFt = static_cast<float>(alt / ringCount);
+
+  ringHead = ringCount = 0;
+}
+
+void AircraftPerfHandler::evaluate(qint64 now)
+{
   aircraftClimb = isClimbing();
   aircraftDescent = isDescending();
   aircraftCruise = isAtCruise();
-  aircraftFuelFlow = curSimAircraft->hasFuelFlow();
-  aircraftGround = curSimAircraft->isOnGround();
-  aircraftFlying = curSimAircraft->isFlying();
+  aircraftFuelFlow = smoothed.fuelFlow;
+  aircraftGround = smoothed.onGround;
+  aircraftFlying = smoothed.flying;
 
   // Fill metadata if still empty
   if(perf->getAircraftType().isEmpty())
@@ -96,8 +159,7 @@ void AircraftPerfHandler::simDataChanged(const sc::SimConnectData& simulatorData
   // Determine fuel type ========================================================
   if(atools::almostEqual(weightVolRatio, 0.f))
   {
-    bool jetfuel = atools::geo::isJetFuel(curSimAircraft->getFuelTotalWeightLbs(),
-                                          curSimAircraft->getFuelTotalQuantityGallons(), weightVolRatio);
+    bool jetfuel = atools::geo::isJetFuel(smoothed.fuelTotalWeightLbs, smoothed.fuelTotalQuantityGal, weightVolRatio);
 
     if(weightVolRatio > 0.f)
     {
@@ -112,84 +174,80 @@ void AircraftPerfHandler::simDataChanged(const sc::SimConnectData& simulatorData
   // in fuel amount before flight
   if(startFuel < 0.1f && aircraftFuelFlow)
   {
-    startFuel = curSimAircraft->getFuelTotalWeightLbs();
+    startFuel = smoothed.fuelTotalWeightLbs;
     qDebug() << Q_FUNC_INFO << "startFuel" << startFuel;
   }
 
   if(aircraftFuelFlow)
-    totalFuelConsumed = startFuel - curSimAircraft->getFuelTotalWeightLbs();
+    totalFuelConsumed = startFuel - smoothed.fuelTotalWeightLbs;
 
   // Determine current flight sement ================================================================
   FlightSegment flightSegment = currentFlightSegment;
-  if(curSimAircraft->isFullyValid())
+  switch(currentFlightSegment)
   {
-    switch(currentFlightSegment)
-    {
-      case INVALID:
-        break;
-
-      case NONE:
-        // Nothing sampled yet - start from scratch ==============
-        if(aircraftGround)
-          flightSegment = aircraftFuelFlow ? DEPARTURE_TAXI : DEPARTURE_PARKING;
-        else if(aircraftCruise >= 0)
-          flightSegment = CRUISE;
-        else if(isClimbing() && aircraftCruise == -1)
-          flightSegment = CLIMB;
-        else if(isDescending() && aircraftCruise == -1)
-          flightSegment = DESCENT;
-        break;
-
-      case DEPARTURE_PARKING:
-        if(aircraftFuelFlow)
-          flightSegment = DEPARTURE_TAXI;
-        if(aircraftFlying)
-          // Skip directly to climb if in the air
-          flightSegment = CLIMB;
-        break;
-
-      case DEPARTURE_TAXI:
-        if(aircraftFlying)
-          flightSegment = CLIMB;
-        break;
-
-      case CLIMB:
-        if(aircraftCruise >= 0)
-          // At cruise - 200 ft or above
-          flightSegment = CRUISE;
-        break;
-
-      case CRUISE:
-        if(aircraftCruise < 0)
-          // Below cruise - start descent
-          flightSegment = DESCENT;
-        break;
-
-      case DESCENT:
-        if(!aircraftFlying)
-          // Landed
-          flightSegment = DESTINATION_TAXI;
-
-        if(aircraftCruise >= 0)
-          // Momentary deviation  go back to cruise
-          flightSegment = CRUISE;
-        break;
-
-      case DESTINATION_TAXI:
-        if(!aircraftFuelFlow)
-          // Engine shutdown
-          flightSegment = DESTINATION_PARKING;
-        break;
-
-      case DESTINATION_PARKING:
-        // Finish on engine shutdown - stop collecting
-        active = false;
-        break;
-    }
+    case INVALID:
+      break;
+
+    case NONE:
+      // Nothing sampled yet - start from scratch ==============
+      if(aircraftGround)
+        flightSegment = aircraftFuelFlow ? DEPARTURE_TAXI : DEPARTURE_PARKING;
+      else if(aircraftCruise >= 0)
+        flightSegment = CRUISE;
+      else if(isClimbing() && aircraftCruise == -1)
+        flightSegment = CLIMB;
+      else if(isDescending() && aircraftCruise == -1)
+        flightSegment = DESCENT;
+      break;
+
+    case DEPARTURE_PARKING:
+      if(aircraftFuelFlow)
+        flightSegment = DEPARTURE_TAXI;
+      if(aircraftFlying)
+        // Skip directly to climb if in the air
+        flightSegment = CLIMB;
+      break;
+
+    case DEPARTURE_TAXI:
+      if(aircraftFlying)
+        flightSegment = CLIMB;
+      break;
+
+    case CLIMB:
+      if(aircraftCruise >= 0)
+        // At cruise - 200 ft or above
+        flightSegment = CRUISE;
+      break;
+
+    case CRUISE:
+      if(aircraftCruise < 0)
+        // Below cruise - start descent
+        flightSegment = DESCENT;
+      break;
+
+    case DESCENT:
+      if(!aircraftFlying)
+        // Landed
+        flightSegment = DESTINATION_TAXI;
+
+      if(aircraftCruise >= 0)
+        // Momentary deviation  go back to cruise
+        flightSegment = CRUISE;
+      break;
+
+    case DESTINATION_TAXI:
+      if(!aircraftFuelFlow)
+        // Engine shutdown
+        flightSegment = DESTINATION_PARKING;
+      break;
+
+    case DESTINATION_PARKING:
+      // Finish on engine shutdown - stop collecting
+      active = false;
+      break;
   }
 
   // Remember segment dependent sample time to allow averaging =============
-  qint64 now = QDateTime::currentMSecsSinceEpoch();
   if(flightSegment != currentFlightSegment)
   {
     if(flightSegment == CLIMB)
@@ -202,14 +260,11 @@ void AircraftPerfHandler::simDataChanged(const sc::SimConnectData& simulatorData
 
   // Sum up taxi fuel  ========================================================
   if(currentFlightSegment == DEPARTURE_TAXI && aircraftFuelFlow)
-    perf->setTaxiFuel(startFuel - curSimAircraft->getFuelTotalWeightLbs());
+    perf->setTaxiFuel(startFuel - smoothed.fuelTotalWeightLbs);
 
-  // Sample every 500 ms ========================================
-  if(now > lastSampleTimeMs + SAMPLE_TIME_MS)
-  {
-    samplePhase(flightSegment, now, now - lastSampleTimeMs);
-    lastSampleTimeMs = now;
-  }
+  // Sample once per evaluation ========================================
+  samplePhase(flightSegment, now, now - lastSampleTimeMs);
+  lastSampleTimeMs = now;
 
   // Send message is flight segment has changed  ========================
   if(flightSegment != currentFlightSegment)
@@ -297,11 +352,11 @@ void AircraftPerfHandler::samplePhase(FlightSegment flightSegment, qint64 now, q
       {
         qint64 lastSampleDuration = now - lastClimbSampleTimeMs;
         perf->setClimbSpeed(sampleValue(lastSampleDuration, curSampleDuration, perf->getClimbSpeed(),
-                                        curSimAircraft->getTrueAirspeedKts()));
+                                        smoothed.trueAirspeedKts));
         perf->setClimbVertSpeed(sampleValue(lastSampleDuration, curSampleDuration, perf->getClimbVertSpeed(),
-                                            curSimAircraft->getVerticalSpeedFeetPerMin()));
+                                            smoothed.verticalSpeedFtPerMin));
         perf->setClimbFuelFlow(sampleValue(lastSampleDuration, curSampleDuration, perf->getClimbFuelFlow(),
-                                           curSimAircraft->getFuelFlowPPH()));
+                                           smoothed.fuelFlowPph));
       }
       break;
 
@@ -309,9 +364,9 @@ void AircraftPerfHandler::samplePhase(FlightSegment flightSegment, qint64 now, q
       {
         qint64 lastSampleDuration = now - lastCruiseSampleTimeMs;
         perf->setCruiseSpeed(sampleValue(lastSampleDuration, curSampleDuration, perf->getCruiseSpeed(),
-                                         curSimAircraft->getTrueAirspeedKts()));
+                                         smoothed.trueAirspeedKts));
         perf->setCruiseFuelFlow(sampleValue(lastSampleDuration, curSampleDuration, perf->getCruiseFuelFlow(),
-                                            curSimAircraft->getFuelFlowPPH()));
+                                            smoothed.fuelFlowPph));
 
         // Use cruise as default for alternate - user can adjust manually
         perf->setAlternateFuelFlow(perf->getCruiseFuelFlow());
@@ -323,12 +378,12 @@ void AircraftPerfHandler::samplePhase(FlightSegment flightSegment, qint64 now, q
       {
         qint64 lastSampleDuration = now - lastDescentSampleTimeMs;
         perf->setDescentSpeed(sampleValue(lastSampleDuration, curSampleDuration, perf->getDescentSpeed(),
-                                          curSimAircraft->getTrueAirspeedKts()));
+                                          smoothed.trueAirspeedKts));
         perf->setDescentVertSpeed(sampleValue(lastSampleDuration, curSampleDuration,
                                               perf->getDescentVertSpeed(),
-                                              std::abs(curSimAircraft->getVerticalSpeedFeetPerMin())));
+                                              std::abs(smoothed.verticalSpeedFtPerMin)));
         perf->setDescentFuelFlow(sampleValue(lastSampleDuration, curSampleDuration, perf->getDescentFuelFlow(),
-                                             curSimAircraft->getFuelFlowPPH()));
+                                             smoothed.fuelFlowPph));
       }
       break;
   }
@@ -336,28 +391,28 @@ void AircraftPerfHandler::samplePhase(FlightSegment flightSegment, qint64 now, q
 
 bool AircraftPerfHandler::isClimbing() const
 {
-  return curSimAircraft->getVerticalSpeedFeetPerMin() > 150.f;
+  return smoothed.verticalSpeedFtPerMin > 150.f;
 }
 
 bool AircraftPerfHandler::isDescending() const
 {
-  return curSimAircraft->getVerticalSpeedFeetPerMin() < -150.f;
+  return smoothed.verticalSpeedFtPerMin < -150.f;
 }
 
 int AircraftPerfHandler::isAtCruise() const
 {
   float buffer = std::max(cruiseAltitude * 0.01f, 200.f);
-  int result = !(curSimAircraft->getIndicatedAltitudeFt() > cruiseAltitude - buffer &&
-                 curSimAircraft->getIndicatedAltitudeFt() < cruiseAltitude + buffer);
+  int result = !(smoothed.indicatedAltitudeFt > cruiseAltitude - buffer &&
+                 smoothed.indicatedAltitudeFt < cruiseAltitude + buffer);
 
   if(result == 1)
   {
     // Use a larger buffer for deviations
     float buffer2 = std::max(cruiseAltitude * 0.02f, 200.f);
-    if(curSimAircraft->getIndicatedAltitudeFt() < cruiseAltitude - buffer2)
+    if(smoothed.indicatedAltitudeFt < cruiseAltitude - buffer2)
       result = -1;
 
-    if(curSimAircraft->getIndicatedAltitudeFt() > cruiseAltitude + buffer2)
+    if(smoothed.indicatedAltitudeFt > cruiseAltitude + buffer2)
       result = 1;
   }
   return result;
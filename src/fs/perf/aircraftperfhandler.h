@@ -18,10 +18,14 @@
 #ifndef ATOOLS_AIRCRAFTPERFORMANCE_H
 #define ATOOLS_AIRCRAFTPERFORMANCE_H
 
+#include <QElapsedTimer>
 #include <QObject>
 
 #include "fs/perf/aircraftperfconstants.h"
 
+#include <algorithm>
+#include <array>
+
 namespace atools {
 namespace fs {
 namespace sc {
@@ -44,6 +48,9 @@ class AircraftPerf;
  *
  * All fuel numbers collected are lbs.
  *
+ * Simulator packets are only stored as raw samples in a fixed size ring buffer. Averaging and flight segment
+ * detection is done at a fixed interval on the averaged samples which makes the load independent of the
+ * simulator update rate.
  */
 class AircraftPerfHandler
   : public QObject
@@ -63,6 +70,18 @@ public:
   /* Stops collection process */
   void stop();
 
+  /* Use only every n-th simulator data packet as sample. Default is 1 which uses all packets. */
+  void setDecimation(int value)
+  {
+    decimation = std::max(value, 1);
+  }
+
+  /* Interval in ms for averaging samples and detecting flight segments. Default is SAMPLE_TIME_MS. */
+  void setSampleIntervalMs(qint64 value)
+  {
+    sampleIntervalMs = std::max<qint64>(value, 1L);
+  }
+
   /* Flight plan cruise altitude. Value in ft */
   void setCruiseAltitude(float value)
   {
@@ -111,6 +130,7 @@ public:
   /* Get a list describing aircraft status, like cruise, fuel flow, etc */
   QStringList getAircraftStatusTexts();
 
+  /* Aircraft of the last evaluation while collecting */
   const atools::fs::sc::SimConnectUserAircraft& getCurSimAircraft() const
   {
     return *curSimAircraft;
@@ -120,6 +140,20 @@ signals:
   void flightSegmentChanged(const atools::fs::perf::FlightSegment& flightSegment);
 
 private:
+  /* Raw values from one simulator packet */
+  struct Sample
+  {
+    float trueAirspeedKts, verticalSpeedFtPerMin, fuelFlowPph, indicatedAltitudeFt,
+          fuelTotalWeightLbs, fuelTotalQuantityGal;
+    bool onGround, flying, fuelFlow;
+  };
+
+  /* Average samples in ring buffer into smoothed and empty buffer */
+  void aggregateSamples();
+
+  /* Detect flight segment and sample performance from smoothed values */
+  void evaluate(qint64 now);
+
   /* -1 if below, 0 if at and 1 if above flight plan cruise altitude. Uses a altitude dependent buffer to avoid jitters. */
   int isAtCruise() const;
 
@@ -141,10 +175,25 @@ private:
   /* Check lbs/gal ratio if jetfuel or avgas */
   float weightVolRatio = 0.f;
 
-  /* Do not calculate values more often than this */
+  /* Default for sampleIntervalMs */
   const static qint64 SAMPLE_TIME_MS = 500L;
 
-  /* Last detected aircraft status - aggregated and therefore never null */
+  /* Number of raw samples kept between evaluations. Older samples are overwritten. */
+  const static int RING_SIZE = 64;
+
+  std::array<Sample, RING_SIZE> ring;
+  int ringHead = 0, ringCount = 0;
+
+  /* Averaged values of last evaluation */
+  Sample smoothed = Sample();
+
+  qint64 sampleIntervalMs = SAMPLE_TIME_MS, lastEvaluationMs = 0L;
+  int decimation = 1, packetCount = 0;
+
+  /* Monotonic time source for sample times */
+  QElapsedTimer timer;
+
+  /* Last detected aircraft status - copied at each evaluation and therefore never null */
   atools::fs::sc::SimConnectUserAircraft *curSimAircraft;
 
   /* Collecting data if true. Set to false after landing. */
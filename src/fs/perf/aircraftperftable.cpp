@@ -0,0 +1,147 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/perf/aircraftperftable.h"
+
+#include "fs/perf/aircraftperf.h"
+#include "geo/calculations.h"
+#include "geo/linestring.h"
+#include "grib/windquery.h"
+#include "util/parallel.h"
+#include "atools.h"
+
+#include <cmath>
+
+namespace ageo = atools::geo;
+
+namespace atools {
+namespace fs {
+namespace perf {
+
+void AircraftPerfTable::build(const AircraftPerf& perf, const geo::LineString& route, const grib::WindQuery *windQuery,
+                              float maxAltFt)
+{
+  clear();
+
+  if(route.size() < 2)
+    return;
+
+  trueAirspeeds[0] = perf.getClimbSpeed();
+  trueAirspeeds[1] = perf.getCruiseSpeed();
+  trueAirspeeds[2] = perf.getDescentSpeed();
+  fuelFlows[0] = perf.getClimbFuelFlow();
+  fuelFlows[1] = perf.getCruiseFuelFlow();
+  fuelFlows[2] = perf.getDescentFuelFlow();
+
+  // First band is at ground level
+  numBands = std::max(1, static_cast<int>(std::ceil(maxAltFt / ALT_BAND_FT))) + 1;
+
+  int numLegs = route.size() - 1;
+  distancesNm.resize(numLegs);
+  groundSpeeds.resize(numLegs * numBands * NUM_PHASES);
+
+  // Detach before writing from multiple threads
+  float *distanceData = distancesNm.data();
+  float *groundSpeedData = groundSpeeds.data();
+  bool hasWind = windQuery != nullptr && windQuery->hasWindData();
+
+  // Wind queries are thread safe - calculate legs in parallel
+  atools::util::parallelFor(numLegs, [&](int leg) -> void {
+    const ageo::Pos& from = route.at(leg);
+    const ageo::Pos& to = route.at(leg + 1);
+    distanceData[leg] = ageo::meterToNm(from.distanceMeterTo(to));
+    float course = from.angleDegTo(to);
+
+    for(int band = 0; band < numBands; band++)
+    {
+      grib::Wind wind;
+      if(hasWind && from.isValid() && to.isValid())
+      {
+        float alt = band * ALT_BAND_FT;
+        wind = windQuery->getWindAverageForLine(from.alt(alt), to.alt(alt));
+      }
+
+      for(int phase = 0; phase < NUM_PHASES; phase++)
+      {
+        float gs = trueAirspeeds[phase];
+        if(wind.isValid() && !wind.isNull())
+          gs = ageo::windCorrectedGroundSpeed(wind.speed, wind.dir, course, trueAirspeeds[phase]);
+
+        // Invalid if head wind exceeds airspeed
+        if(!(gs < ageo::INVALID_FLOAT / 2.f) || gs < MIN_GROUND_SPEED_KTS)
+          gs = MIN_GROUND_SPEED_KTS;
+        groundSpeedData[index(leg, band, phase)] = gs;
+      }
+    }
+  });
+}
+
+void AircraftPerfTable::clear()
+{
+  distancesNm.clear();
+  groundSpeeds.clear();
+  numBands = 0;
+}
+
+int AircraftPerfTable::phaseIndex(FlightSegment segment)
+{
+  switch(segment)
+  {
+    case CLIMB:
+      return 0;
+
+    case DESCENT:
+      return 2;
+
+    case NONE:
+    case DEPARTURE_PARKING:
+    case DEPARTURE_TAXI:
+    case CRUISE:
+    case DESTINATION_TAXI:
+    case DESTINATION_PARKING:
+    case INVALID:
+      break;
+  }
+  return 1;
+}
+
+float AircraftPerfTable::getGroundSpeed(int leg, float altFt, FlightSegment segment) const
+{
+  int phase = phaseIndex(segment);
+
+  // Interpolate linearly between the two bands enclosing the altitude
+  float band = atools::minmax(0.f, static_cast<float>(numBands - 1), altFt / ALT_BAND_FT);
+  int lower = static_cast<int>(band);
+  int upper = std::min(lower + 1, numBands - 1);
+  float lowerSpeed = groundSpeeds.at(index(leg, lower, phase));
+  return lowerSpeed + (groundSpeeds.at(index(leg, upper, phase)) - lowerSpeed) * (band - lower);
+}
+
+float AircraftPerfTable::getTimeHours(int leg, float distanceNm, float altFt, FlightSegment segment) const
+{
+  return distanceNm / getGroundSpeed(leg, altFt, segment);
+}
+
+float AircraftPerfTable::getFuel(int leg, float distanceNm, float altFt, FlightSegment segment) const
+{
+  return fuelFlows[phaseIndex(segment)] * getTimeHours(leg, distanceNm, altFt, segment);
+}
+
+} // namespace perf
+} // namespace fs
+} // namespace atools
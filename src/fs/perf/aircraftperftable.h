@@ -0,0 +1,130 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_AIRCRAFTPERFTABLE_H
+#define ATOOLS_AIRCRAFTPERFTABLE_H
+
+#include "fs/perf/aircraftperfconstants.h"
+
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class LineString;
+}
+namespace grib {
+class WindQuery;
+}
+namespace fs {
+namespace perf {
+
+class AircraftPerf;
+
+/*
+ * Precomputed lookup table for route profile calculation using aircraft performance and wind.
+ *
+ * Keeps the wind corrected ground speed for each leg of a route, each altitude band and the flight phases
+ * climb, cruise and descent. Ground speed, time and fuel for legs are then calculated by interpolating
+ * between the bands without further wind queries or wind triangle calculations.
+ *
+ * Call build() again if the route, the performance or the wind data changes. Changes of cruise altitude or
+ * top of climb and descent positions need no rebuild as long as the altitude is below the maximum.
+ *
+ * A built table can be queried from multiple threads.
+ */
+class AircraftPerfTable
+{
+public:
+  /* Build table for the legs of route where leg n goes from point n to point n + 1.
+   * Uses wind from windQuery if not null and wind data is available. Otherwise assumes no wind.
+   * Altitudes above maxAltFt use the values of the highest band. Legs are calculated in parallel. */
+  void build(const atools::fs::perf::AircraftPerf& perf, const atools::geo::LineString& route,
+             const atools::grib::WindQuery *windQuery, float maxAltFt);
+
+  void clear();
+
+  /* Wind corrected ground speed in knots interpolated for altitude.
+   * Segment can be CLIMB, CRUISE or DESCENT. All other values use cruise. */
+  float getGroundSpeed(int leg, float altFt, atools::fs::perf::FlightSegment segment) const;
+
+  /* Time in decimal hours for a part of a leg with the given distance */
+  float getTimeHours(int leg, float distanceNm, float altFt, atools::fs::perf::FlightSegment segment) const;
+
+  /* Fuel in lbs or gallons depending on performance for a part of a leg with the given distance */
+  float getFuel(int leg, float distanceNm, float altFt, atools::fs::perf::FlightSegment segment) const;
+
+  /* Same as above for the whole leg */
+  float getLegTimeHours(int leg, float altFt, atools::fs::perf::FlightSegment segment) const
+  {
+    return getTimeHours(leg, distancesNm.at(leg), altFt, segment);
+  }
+
+  float getLegFuel(int leg, float altFt, atools::fs::perf::FlightSegment segment) const
+  {
+    return getFuel(leg, distancesNm.at(leg), altFt, segment);
+  }
+
+  /* Great circle distance of leg */
+  float getLegDistanceNm(int leg) const
+  {
+    return distancesNm.at(leg);
+  }
+
+  int getNumLegs() const
+  {
+    return distancesNm.size();
+  }
+
+  bool isEmpty() const
+  {
+    return distancesNm.isEmpty();
+  }
+
+  /* Height of altitude bands */
+  static Q_DECL_CONSTEXPR float ALT_BAND_FT = 1000.f;
+
+  /* Ground speed is not lower than this value even if the head wind exceeds the airspeed */
+  static Q_DECL_CONSTEXPR float MIN_GROUND_SPEED_KTS = 10.f;
+
+private:
+  /* Climb, cruise and descent */
+  static Q_DECL_CONSTEXPR int NUM_PHASES = 3;
+
+  static int phaseIndex(atools::fs::perf::FlightSegment segment);
+
+  int index(int leg, int band, int phase) const
+  {
+    return (leg * numBands + band) * NUM_PHASES + phase;
+  }
+
+  /* Indexed by leg */
+  QVector<float> distancesNm;
+
+  /* Ground speed by leg, band and phase */
+  QVector<float> groundSpeeds;
+
+  /* True airspeed and fuel flow by phase */
+  float trueAirspeeds[NUM_PHASES] = {0.f, 0.f, 0.f}, fuelFlows[NUM_PHASES] = {0.f, 0.f, 0.f};
+  int numBands = 0;
+};
+
+} // namespace perf
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_AIRCRAFTPERFTABLE_H
@@ -17,6 +17,8 @@
 
 #include "fs/pln/flightplanentry.h"
 
+#include "atools.h"
+
 namespace atools {
 namespace fs {
 namespace pln {
@@ -50,6 +52,27 @@ bool FlightplanEntry::operator==(const FlightplanEntry& other)
          name == other.name;
 }
 
+bool FlightplanEntry::isIdentical(const FlightplanEntry& other) const
+{
+  return waypointType == other.waypointType &&
+         flags == other.flags &&
+         frequency == other.frequency &&
+         atools::almostEqual(magvar, other.magvar) &&
+         position == other.position &&
+         ident == other.ident &&
+         region == other.region &&
+         name == other.name &&
+         airway == other.airway &&
+         comment == other.comment &&
+         sid == other.sid &&
+         star == other.star &&
+         approach == other.approach &&
+         approachSuffix == other.approachSuffix &&
+         runway == other.runway &&
+         designator == other.designator &&
+         airport == other.airport;
+}
+
 const QString& FlightplanEntry::waypointTypeToFsxString(entry::WaypointType type)
 {
   static const QString airportName("Airport"), unknownName("Unknown"), isecName("Intersection"),
@@ -163,6 +163,9 @@ public:
     return !operator==(other);
   }
 
+  /* Compares all fields other than operator== which compares only type, region, ident and name */
+  bool isIdentical(const atools::fs::pln::FlightplanEntry& other) const;
+
   /* Name is not saved with PLN file */
   QString getName() const
   {
@@ -27,8 +27,10 @@
 #include "fs/pln/flightplan.h"
 #include "util/xmlstream.h"
 #include "zip/gzip.h"
+#include "util/parallel.h"
 
 #include <QBitArray>
+#include <QBuffer>
 #include <QDataStream>
 #include <QDateTime>
 #include <QFile>
@@ -36,6 +38,8 @@
 #include <QRegularExpression>
 #include <QXmlStreamReader>
 
+#include <atomic>
+
 using atools::geo::Pos;
 
 namespace atools {
@@ -49,6 +53,53 @@ static const QRegularExpression FS9_MATCH(
   "(^appversion\\s*=|^title\\s*=|^description\\s*=|^type\\s*=|"
   "^routetype\\s*=|^cruising_altitude\\s*=|^departure_id\\s*=|^destination_id\\s*=)");
 
+/* Element ids and name tables for the XML waypoint lists. Allow to switch on the element name
+ * instead of comparing against string literals. */
+enum LnmWaypointElement
+{
+  LNM_NAME, LNM_IDENT, LNM_REGION, LNM_AIRWAY, LNM_TRACK, LNM_TYPE, LNM_COMMENT, LNM_POS
+};
+
+static const atools::util::XmlNameTable LNM_WAYPOINT_NAMES({
+  {"Name", LNM_NAME}, {"Ident", LNM_IDENT}, {"Region", LNM_REGION}, {"Airway", LNM_AIRWAY},
+  {"Track", LNM_TRACK}, {"Type", LNM_TYPE}, {"Comment", LNM_COMMENT}, {"Pos", LNM_POS}
+});
+
+enum GpxElement
+{
+  GPX_RTE, GPX_RTEPT, GPX_TRK, GPX_TRKSEG, GPX_TRKPT, GPX_NAME
+};
+
+static const atools::util::XmlNameTable GPX_NAMES({
+  {"rte", GPX_RTE}, {"rtept", GPX_RTEPT}, {"trk", GPX_TRK}, {"trkseg", GPX_TRKSEG}, {"trkpt", GPX_TRKPT},
+  {"name", GPX_NAME}
+});
+
+enum GarminWaypointElement
+{
+  FPL_IDENTIFIER, FPL_TYPE, FPL_COUNTRY_CODE, FPL_LAT, FPL_LON, FPL_COMMENT, FPL_ELEVATION
+};
+
+static const atools::util::XmlNameTable GARMIN_WAYPOINT_NAMES({
+  {"identifier", FPL_IDENTIFIER}, {"type", FPL_TYPE}, {"country-code", FPL_COUNTRY_CODE}, {"lat", FPL_LAT},
+  {"lon", FPL_LON}, {"comment", FPL_COMMENT}, {"elevation", FPL_ELEVATION}
+});
+
+enum PlnWaypointElement
+{
+  PLN_ATC_WAYPOINT_TYPE, PLN_WORLD_POSITION, PLN_ATC_AIRWAY, PLN_RUNWAY_NUMBER, PLN_RUNWAY_DESIGNATOR,
+  PLN_DEPARTURE, PLN_ARRIVAL, PLN_APPROACH_TYPE, PLN_SUFFIX, PLN_ICAO,
+  PLN_ICAO_REGION, PLN_ICAO_IDENT, PLN_ICAO_AIRPORT
+};
+
+static const atools::util::XmlNameTable PLN_WAYPOINT_NAMES({
+  {"ATCWaypointType", PLN_ATC_WAYPOINT_TYPE}, {"WorldPosition", PLN_WORLD_POSITION}, {"ATCAirway", PLN_ATC_AIRWAY},
+  {"RunwayNumberFP", PLN_RUNWAY_NUMBER}, {"RunwayDesignatorFP", PLN_RUNWAY_DESIGNATOR},
+  {"DepartureFP", PLN_DEPARTURE}, {"ArrivalFP", PLN_ARRIVAL}, {"ApproachTypeFP", PLN_APPROACH_TYPE},
+  {"SuffixFP", PLN_SUFFIX}, {"ICAO", PLN_ICAO}, {"ICAORegion", PLN_ICAO_REGION}, {"ICAOIdent", PLN_ICAO_IDENT},
+  {"ICAOAirport", PLN_ICAO_AIRPORT}
+});
+
 /* Format structs for the Majestic Software MJC8 Q400.
  * Structs need to be packed to avoid padding. */
 namespace fpr {
@@ -118,7 +169,9 @@ FlightplanIO::~FlightplanIO()
 
 atools::fs::pln::FileFormat FlightplanIO::load(atools::fs::pln::Flightplan& plan, const QString& file)
 {
-  FileFormat format = detectFormat(file);
+  // Read file only once and use the buffer for detection and loading
+  QByteArray bytes = readFile(file);
+  FileFormat format = detectFormat(bytes, file);
 
   plan.entries.clear();
 
@@ -130,44 +183,50 @@ atools::fs::pln::FileFormat FlightplanIO::load(atools::fs::pln::Flightplan& plan
                          "FlightGear FGFP.").arg(file));
 
     case atools::fs::pln::LNM_PLN:
-      loadLnm(plan, file);
+      {
+        atools::util::XmlStream xmlStream(bytes, file);
+        loadLnmInternal(plan, xmlStream);
+      }
       plan.setLnmFormat(true); // Indicate that plan was loaded using new native format
       break;
 
     case atools::fs::pln::MSFS_PLN:
     case atools::fs::pln::FSX_PLN:
-      loadPln(plan, file);
+      loadPln(plan, bytes, file);
       plan.setLnmFormat(false); // Indicate that a "foreign" format was user to load which cannot be saved directly
       break;
 
     case atools::fs::pln::FS9_PLN:
-      loadFs9(plan, file);
+      loadFs9(plan, bytes, file);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::FMS11:
     case atools::fs::pln::FMS3:
-      loadFms(plan, file);
+      loadFms(plan, bytes, file);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::FLP:
-      loadFlp(plan, file);
+      loadFlp(plan, bytes, file);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::FSC_PLN:
-      loadFsc(plan, file);
+      loadFsc(plan, bytes, file);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::FLIGHTGEAR:
-      loadFlightGear(plan, file);
+      loadFlightGear(plan, bytes, file);
       plan.setLnmFormat(false);
       break;
 
     case atools::fs::pln::GARMIN_FPL:
-      loadGarminFpl(plan, file);
+      {
+        atools::util::XmlStream xmlStream(bytes, file);
+        loadGarminFplInternal(plan, xmlStream);
+      }
       plan.setLnmFormat(false);
       break;
   }
@@ -176,8 +235,23 @@ atools::fs::pln::FileFormat FlightplanIO::load(atools::fs::pln::Flightplan& plan
 
 FileFormat FlightplanIO::detectFormat(const QString& file)
 {
-  // Get first 30 non empty lines - always returns a list of 30
-  QStringList lines = probeFile(file, 30 /* numLinesRead */);
+  QFile testFile(file);
+  if(!testFile.open(QIODevice::ReadOnly))
+    throw Exception(tr("Error reading \"%1\": %2").arg(file).arg(testFile.errorString()));
+
+  // Read only the beginning of the file if not compressed
+  QByteArray bytes = testFile.read(PROBE_SIZE);
+  if(atools::zip::isGzipCompressed(bytes))
+    bytes = atools::zip::gzipDecompress(bytes + testFile.readAll());
+  testFile.close();
+
+  return detectFormat(bytes, file);
+}
+
+FileFormat FlightplanIO::detectFormat(const QByteArray& bytes, const QString& file)
+{
+  // Get first 30 non empty lines from the prefix - always returns a list of 30
+  QStringList lines = atools::probeBytes(bytes.left(PROBE_SIZE), 30 /* numLinesRead */);
 
   if(lines.isEmpty())
     throw Exception(tr("Cannot open empty flight plan file \"%1\".").arg(file));
@@ -247,7 +321,55 @@ FileFormat FlightplanIO::detectFormat(const QString& file)
     return NONE;
 }
 
-void FlightplanIO::loadFlp(atools::fs::pln::Flightplan& plan, const QString& filename)
+QByteArray FlightplanIO::readFile(const QString& filename)
+{
+  QFile file(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    throw Exception(errorMsg.arg(filename).arg(file.errorString()));
+
+  QByteArray bytes = file.readAll();
+  file.close();
+
+  if(atools::zip::isGzipCompressed(bytes))
+    // Compressed LNMPLN
+    bytes = atools::zip::gzipDecompress(bytes);
+  return bytes;
+}
+
+int FlightplanIO::loadBatch(const QStringList& files, QStringList& errors, const BatchFunctionType& func)
+{
+  QVector<QString> errorVector(files.size());
+  QString *errorData = errorVector.data();
+  std::atomic<int> numLoaded(0);
+
+  atools::util::parallelFor(files.size(), [&](int i) -> void {
+    try
+    {
+      FlightplanIO flightplanIO;
+      Flightplan plan;
+      FileFormat format = flightplanIO.load(plan, files.at(i));
+      func(i, plan, format);
+      numLoaded++;
+    }
+    catch(atools::Exception& e)
+    {
+      errorData[i] = e.getMessage();
+    }
+    catch(std::exception& e)
+    {
+      errorData[i] = e.what();
+    }
+    catch(...)
+    {
+      errorData[i] = tr("Unknown error loading \"%1\"").arg(files.at(i));
+    }
+  });
+
+  errors = QStringList(errorVector.toList());
+  return numLoaded;
+}
+
+void FlightplanIO::loadFlp(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
@@ -267,127 +389,118 @@ void FlightplanIO::loadFlp(atools::fs::pln::Flightplan& plan, const QString& fil
   // DctWpt15=DEGAB
   // DctWpt15Coordinates=48.705685,13.931495
 
-  QFile flpFile(filename);
+  FlightplanEntry entry, departure, destination;
+  int wptNum = -1;
 
-  if(flpFile.open(QIODevice::ReadOnly))
+  QTextStream stream(bytes);
+  stream.setCodec("UTF-8");
+  stream.setAutoDetectUnicode(true);
+  while(!stream.atEnd())
   {
-    FlightplanEntry entry, departure, destination;
-    int wptNum = -1;
-
-    QTextStream stream(&flpFile);
-    stream.setCodec("UTF-8");
-    stream.setAutoDetectUnicode(true);
-    while(!stream.atEnd())
+    QString line = stream.readLine().simplified();
+    if(!line.isEmpty())
     {
-      QString line = stream.readLine().simplified();
-      if(!line.isEmpty())
+      QString key = line.section('=', 0, 0).toLower().trimmed();
+      QString value = line.section('=', 1, 1).trimmed();
+
+      if(key == "arptdep")
+      {
+        plan.departureIdent = value;
+        departure.setIdent(value);
+        departure.setWaypointType(atools::fs::pln::entry::AIRPORT);
+      }
+      else if(key == "arptarr")
       {
-        QString key = line.section('=', 0, 0).toLower().trimmed();
-        QString value = line.section('=', 1, 1).trimmed();
+        plan.destinationIdent = value;
+        destination.setIdent(value);
+        destination.setWaypointType(atools::fs::pln::entry::AIRPORT);
+      }
+      else if(key.startsWith("dctwpt"))
+      {
+        QRegularExpressionMatch localMatch = FLP_DCT_WPT.match(key);
+        int num = localMatch.captured(1).toInt();
+        QString coords = localMatch.captured(2);
 
-        if(key == "arptdep")
-        {
-          plan.departureIdent = value;
-          departure.setIdent(value);
-          departure.setWaypointType(atools::fs::pln::entry::AIRPORT);
-        }
-        else if(key == "arptarr")
+        if(num > wptNum)
         {
-          plan.destinationIdent = value;
-          destination.setIdent(value);
-          destination.setWaypointType(atools::fs::pln::entry::AIRPORT);
-        }
-        else if(key.startsWith("dctwpt"))
-        {
-          QRegularExpressionMatch localMatch = FLP_DCT_WPT.match(key);
-          int num = localMatch.captured(1).toInt();
-          QString coords = localMatch.captured(2);
-
-          if(num > wptNum)
+          // Number has changed - add new one
+          if(wptNum != -1)
           {
-            // Number has changed - add new one
-            if(wptNum != -1)
-            {
-              // not the first iteration
-              plan.entries.append(entry);
-              entry = FlightplanEntry();
-            }
-            wptNum = num;
+            // not the first iteration
+            plan.entries.append(entry);
+            entry = FlightplanEntry();
           }
-
-          if(coords.isEmpty())
-            entry.setIdent(value);
-          else if(coords.toLower() == "coordinates")
-            entry.setPosition(Pos(value.section(',', 1, 1).toFloat(),
-                                  value.section(',', 0, 0).toFloat()));
+          wptNum = num;
         }
-        else if(key.startsWith("airway"))
-        {
-          QRegularExpressionMatch match = FLP_DCT_AWY.match(key);
-          int num = match.captured(1).toInt();
-          QString fromTo = match.captured(2);
 
-          if(num > wptNum)
-          {
-            if(wptNum != -1)
-            {
-              plan.entries.append(entry);
-              entry = FlightplanEntry();
-            }
-            wptNum = num;
-          }
+        if(coords.isEmpty())
+          entry.setIdent(value);
+        else if(coords.toLower() == "coordinates")
+          entry.setPosition(Pos(value.section(',', 1, 1).toFloat(),
+                                value.section(',', 0, 0).toFloat()));
+      }
+      else if(key.startsWith("airway"))
+      {
+        QRegularExpressionMatch match = FLP_DCT_AWY.match(key);
+        int num = match.captured(1).toInt();
+        QString fromTo = match.captured(2);
 
-          if(fromTo.isEmpty())
-            entry.setAirway(value);
-          else if(fromTo.toLower() == "from")
+        if(num > wptNum)
+        {
+          if(wptNum != -1)
           {
-            if(plan.entries.isEmpty() || plan.entries.last().getIdent() != value)
-            {
-              FlightplanEntry from;
-              from.setIdent(value);
-              plan.entries.append(from);
-            }
+            plan.entries.append(entry);
+            entry = FlightplanEntry();
           }
-          else if(fromTo.toLower() == "to")
-            entry.setIdent(value);
+          wptNum = num;
         }
-        else if(!value.isEmpty())
+
+        if(fromTo.isEmpty())
+          entry.setAirway(value);
+        else if(fromTo.toLower() == "from")
         {
-          if(key == "rwydep")
-            insertPropertyIf(plan, SIDAPPRRW, value.mid(plan.departureIdent.size()));
-          else if(key == "sid")
-            insertPropertyIf(plan, SIDAPPR, value);
-          else if(key == "sid_trans")
-            insertPropertyIf(plan, SIDTRANS, value);
-          else if(key == STAR)
-            insertPropertyIf(plan, STAR, value);
-          else if(key == "star_trans")
-            insertPropertyIf(plan, STARTRANS, value);
-          else if(key == "rwyarr")
-            insertPropertyIf(plan, APPROACHRW, value.mid(plan.destinationIdent.size()));
-          else if(key == "rwyarrfinal")
-            insertPropertyIf(plan, APPROACH, value);
-          else if(key == "appr_trans")
-            insertPropertyIf(plan, TRANSITION, value);
+          if(plan.entries.isEmpty() || plan.entries.last().getIdent() != value)
+          {
+            FlightplanEntry from;
+            from.setIdent(value);
+            plan.entries.append(from);
+          }
         }
+        else if(fromTo.toLower() == "to")
+          entry.setIdent(value);
+      }
+      else if(!value.isEmpty())
+      {
+        if(key == "rwydep")
+          insertPropertyIf(plan, SIDAPPRRW, value.mid(plan.departureIdent.size()));
+        else if(key == "sid")
+          insertPropertyIf(plan, SIDAPPR, value);
+        else if(key == "sid_trans")
+          insertPropertyIf(plan, SIDTRANS, value);
+        else if(key == STAR)
+          insertPropertyIf(plan, STAR, value);
+        else if(key == "star_trans")
+          insertPropertyIf(plan, STARTRANS, value);
+        else if(key == "rwyarr")
+          insertPropertyIf(plan, APPROACHRW, value.mid(plan.destinationIdent.size()));
+        else if(key == "rwyarrfinal")
+          insertPropertyIf(plan, APPROACH, value);
+        else if(key == "appr_trans")
+          insertPropertyIf(plan, TRANSITION, value);
       }
     }
-    plan.entries.append(entry);
-    plan.entries.prepend(departure);
-    plan.entries.append(destination);
+  }
+  plan.entries.append(entry);
+  plan.entries.prepend(departure);
+  plan.entries.append(destination);
 
-    flpFile.close();
-    plan.flightplanType = IFR;
-    plan.cruisingAlt = 0.f; // Use either GUI value or calculate from airways
+  plan.flightplanType = IFR;
+  plan.cruisingAlt = 0.f; // Use either GUI value or calculate from airways
 
-    adjustDepartureAndDestination(plan);
-    flpFile.close();
-  }
-  else
-    throw Exception(errorMsg.arg(filename).arg(flpFile.errorString()));
+  adjustDepartureAndDestination(plan);
 }
 
-void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
@@ -422,189 +535,180 @@ void FlightplanIO::loadFms(atools::fs::pln::Flightplan& plan, const QString& fil
   // 3 RDU V155 0.000000 35.872520 -78.783340
   // 1 KRDU ADES 435.000000 35.877640 -78.787476
 
-  QFile fmsFile(filename);
   int version = 0;
   bool v11Format = false;
   int minListSize = 5;
   int fieldOffset = 0;
 
-  if(fmsFile.open(QIODevice::ReadOnly))
-  {
-    QTextStream stream(&fmsFile);
-    stream.setCodec("UTF-8");
-    stream.setAutoDetectUnicode(true);
+  QTextStream stream(bytes);
+  stream.setCodec("UTF-8");
+  stream.setAutoDetectUnicode(true);
 
-    stream.readLine(); // I
-    bool ok = false;
-    version = stream.readLine().section(" ", 0, 0).toInt(&ok); // 3 version
-    if(!ok)
-      throw Exception(tr("Invalid FMS file. Cannot read version number: %1").arg(fmsFile.fileName()));
+  stream.readLine(); // I
+  bool ok = false;
+  version = stream.readLine().section(" ", 0, 0).toInt(&ok); // 3 version
+  if(!ok)
+    throw Exception(tr("Invalid FMS file. Cannot read version number: %1").arg(filename));
 
-    if(version == 3)
-    {
-      v11Format = false;
-      minListSize = 5;
-      fieldOffset = 0;
-    }
-    else if(version == 1100)
-    {
-      v11Format = true;
-      minListSize = 6;
-      fieldOffset = 1;
-    }
-    else
-      throw Exception(tr("Invalid FMS file. Invalid version %2: %1").arg(fmsFile.fileName()).arg(version));
+  if(version == 3)
+  {
+    v11Format = false;
+    minListSize = 5;
+    fieldOffset = 0;
+  }
+  else if(version == 1100)
+  {
+    v11Format = true;
+    minListSize = 6;
+    fieldOffset = 1;
+  }
+  else
+    throw Exception(tr("Invalid FMS file. Invalid version %2: %1").arg(filename).arg(version));
 
-    float maxAlt = std::numeric_limits<float>::min();
-    QString destinationRwy;
+  float maxAlt = std::numeric_limits<float>::min();
+  QString destinationRwy;
 
-    while(!stream.atEnd())
+  while(!stream.atEnd())
+  {
+    QString line = stream.readLine().simplified();
+    if(line.size() > 4)
     {
-      QString line = stream.readLine().simplified();
-      if(line.size() > 4)
-      {
-        if(line.startsWith("0 ----")) // End of file indicator
-          break;
+      if(line.startsWith("0 ----")) // End of file indicator
+        break;
 
-        QList<QString> list = line.split(" ");
+      QList<QString> list = line.split(" ");
 
-        QString airway;
-        if(v11Format)
+      QString airway;
+      if(v11Format)
+      {
+        // Read keywords from version 11
+        QString key = list.value(0);
+        QString value = list.value(1);
+        if(key == "CYCLE")
         {
-          // Read keywords from version 11
-          QString key = list.value(0);
-          QString value = list.value(1);
-          if(key == "CYCLE")
-          {
-            qInfo() << "Flight plan cycle" << value;
-            continue;
-          }
-          else if(key == "DEPRWY")
-          {
-            insertPropertyIf(plan, SIDAPPRRW, value.mid(2));
-            continue;
-          }
-          else if(key == "SID")
-          {
-            insertPropertyIf(plan, SIDAPPR, value);
-            continue;
-          }
-          else if(key == "SIDTRANS")
-          {
-            insertPropertyIf(plan, SIDTRANS, value);
-            continue;
-          }
-          else if(key == "STAR")
-          {
-            insertPropertyIf(plan, STAR, value);
-            continue;
-          }
-          else if(key == "STARTRANS")
-          {
-            insertPropertyIf(plan, STARTRANS, value);
-            continue;
-          }
-          else if(key == "APP")
-          {
-            insertPropertyIf(plan, APPROACH_ARINC, value);
-            continue;
-          }
-          else if(key == "APPTRANS")
-          {
-            insertPropertyIf(plan, TRANSITION, value);
-            continue;
-          }
-          else if(key == "DESRWY")
-          {
-            destinationRwy = value.mid(2);
-            continue;
-          }
-          else if(key == "ADES" || key == "DES" || key == "ADEP" || key == "DEP" || key == "NUMENR")
-            // Ignored keywords
-            continue;
-
-          // Airway column
-          QString col2 = list.value(2);
-          if(!col2.isEmpty() && col2 != "DRCT" && col2 != "DIRECT" &&
-             col2 != "ADEP" && col2 != "DEP" && col2 != "ADES" && col2 != "DES")
-            airway = col2;
+          qInfo() << "Flight plan cycle" << value;
+          continue;
         }
-
-        if(list.size() >= minListSize)
+        else if(key == "DEPRWY")
         {
-          float altitude = list.at(2 + fieldOffset).toFloat();
-          if(altitude > 1000000.f)
-            // Avoid excessive altitudes
-            altitude = 0.f;
+          insertPropertyIf(plan, SIDAPPRRW, value.mid(2));
+          continue;
+        }
+        else if(key == "SID")
+        {
+          insertPropertyIf(plan, SIDAPPR, value);
+          continue;
+        }
+        else if(key == "SIDTRANS")
+        {
+          insertPropertyIf(plan, SIDTRANS, value);
+          continue;
+        }
+        else if(key == "STAR")
+        {
+          insertPropertyIf(plan, STAR, value);
+          continue;
+        }
+        else if(key == "STARTRANS")
+        {
+          insertPropertyIf(plan, STARTRANS, value);
+          continue;
+        }
+        else if(key == "APP")
+        {
+          insertPropertyIf(plan, APPROACH_ARINC, value);
+          continue;
+        }
+        else if(key == "APPTRANS")
+        {
+          insertPropertyIf(plan, TRANSITION, value);
+          continue;
+        }
+        else if(key == "DESRWY")
+        {
+          destinationRwy = value.mid(2);
+          continue;
+        }
+        else if(key == "ADES" || key == "DES" || key == "ADEP" || key == "DEP" || key == "NUMENR")
+          // Ignored keywords
+          continue;
 
-          Pos position(list.at(4 + fieldOffset).toFloat(), list.at(3 + fieldOffset).toFloat(), altitude);
-          if(!position.isValid() || position.isNull())
-            break;
+        // Airway column
+        QString col2 = list.value(2);
+        if(!col2.isEmpty() && col2 != "DRCT" && col2 != "DIRECT" &&
+           col2 != "ADEP" && col2 != "DEP" && col2 != "ADES" && col2 != "DES")
+          airway = col2;
+      }
 
-          FlightplanEntry entry;
-          const QString& ident = list.at(1);
+      if(list.size() >= minListSize)
+      {
+        float altitude = list.at(2 + fieldOffset).toFloat();
+        if(altitude > 1000000.f)
+          // Avoid excessive altitudes
+          altitude = 0.f;
 
-          maxAlt = std::max(maxAlt, altitude);
+        Pos position(list.at(4 + fieldOffset).toFloat(), list.at(3 + fieldOffset).toFloat(), altitude);
+        if(!position.isValid() || position.isNull())
+          break;
 
-          entry.setPosition(position);
+        FlightplanEntry entry;
+        const QString& ident = list.at(1);
 
-          int type = list.at(0).toInt();
-          switch(type)
-          {
-            case 1: // - Airport ICAO
-              entry.setWaypointType(atools::fs::pln::entry::AIRPORT);
-              break;
+        maxAlt = std::max(maxAlt, altitude);
 
-            case 2: // - NDB
-              entry.setWaypointType(atools::fs::pln::entry::NDB);
-              break;
+        entry.setPosition(position);
 
-            case 3: // - VOR
-              entry.setWaypointType(atools::fs::pln::entry::VOR);
-              break;
+        int type = list.at(0).toInt();
+        switch(type)
+        {
+          case 1: // - Airport ICAO
+            entry.setWaypointType(atools::fs::pln::entry::AIRPORT);
+            break;
 
-            case 11: // - Fix
-              entry.setWaypointType(atools::fs::pln::entry::WAYPOINT);
-              break;
+          case 2: // - NDB
+            entry.setWaypointType(atools::fs::pln::entry::NDB);
+            break;
 
-            case 28: // - Lat/Lon Position
-            case 13: // - Lat/Lon Position
-              entry.setWaypointType(atools::fs::pln::entry::USER);
-              break;
-          }
+          case 3: // - VOR
+            entry.setWaypointType(atools::fs::pln::entry::VOR);
+            break;
 
-          entry.setIdent(ident);
-          entry.setAirway(airway);
+          case 11: // - Fix
+            entry.setWaypointType(atools::fs::pln::entry::WAYPOINT);
+            break;
 
-          plan.entries.append(entry);
+          case 28: // - Lat/Lon Position
+          case 13: // - Lat/Lon Position
+            entry.setWaypointType(atools::fs::pln::entry::USER);
+            break;
         }
-        else
-          throw Exception(tr("Invalid FMS file. Number of sections is not %2: %1").
-                          arg(fmsFile.fileName()).arg(minListSize));
-      }
-    }
-    fmsFile.close();
 
-    if(!destinationRwy.isEmpty())
-    {
-      if(plan.properties.contains(APPROACH))
-        insertPropertyIf(plan, APPROACHRW, destinationRwy);
-      else if(plan.properties.contains(STAR))
-        insertPropertyIf(plan, STARRW, destinationRwy);
-    }
+        entry.setIdent(ident);
+        entry.setAirway(airway);
 
-    plan.flightplanType = IFR;
-    plan.cruisingAlt = atools::roundToInt(maxAlt > 0.f ? maxAlt : 0.f); // Use value from GUI
-    adjustDepartureAndDestination(plan);
-    assignAltitudeToAllEntries(plan);
+        plan.entries.append(entry);
+      }
+      else
+        throw Exception(tr("Invalid FMS file. Number of sections is not %2: %1").
+                        arg(filename).arg(minListSize));
+    }
+  }
 
-    fmsFile.close();
+  if(!destinationRwy.isEmpty())
+  {
+    if(plan.properties.contains(APPROACH))
+      insertPropertyIf(plan, APPROACHRW, destinationRwy);
+    else if(plan.properties.contains(STAR))
+      insertPropertyIf(plan, STARRW, destinationRwy);
   }
-  else
-    throw Exception(errorMsg.arg(filename).arg(fmsFile.errorString()));
+
+  plan.flightplanType = IFR;
+  plan.cruisingAlt = atools::roundToInt(maxAlt > 0.f ? maxAlt : 0.f); // Use value from GUI
+  adjustDepartureAndDestination(plan);
+  assignAltitudeToAllEntries(plan);
 }
 
-void FlightplanIO::loadFsc(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFsc(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
   // [FSCFP]
@@ -622,83 +726,73 @@ void FlightplanIO::loadFsc(atools::fs::pln::Flightplan& plan, const QString& fil
   // WP=24,Int,RONAG,RONAG,46.77942,10.25900,0.00,252.4302,2.587,1,0,0,,0,0,22797
   // WP=25,Int,ARDED,ARDED,46.73528,10.12778,0.00,243.8965,2.587,1,0,0,,0,0,22725
 
-  QFile plnFile(filename);
+  QTextStream stream(bytes);
+  FlightplanEntry departure, destination;
 
-  if(plnFile.open(QIODevice::ReadOnly))
+  while(!stream.atEnd())
   {
-    QTextStream stream(&plnFile);
-    FlightplanEntry departure, destination;
-
-    while(!stream.atEnd())
+    QString line = stream.readLine().simplified();
+    if(!line.isEmpty())
     {
-      QString line = stream.readLine().simplified();
-      if(!line.isEmpty())
-      {
-        QString key = line.section('=', 0, 0).toLower().trimmed();
-        QStringList values = line.section('=', 1).simplified().split(",");
-
-        if(values.isEmpty())
-          continue;
-
-        if(key == "departapcode")
-        {
-          departure.setIdent(values.first());
-          departure.setWaypointType(atools::fs::pln::entry::AIRPORT);
-        }
-        else if(key == "destapcode")
-        {
-          destination.setIdent(values.first());
-          destination.setWaypointType(atools::fs::pln::entry::AIRPORT);
-        }
-        // Ignored keys
-        // else if(key == "DepartNum")
-        // else if(key == "DepartID")
-        // else if(key == "DepartType")
-        // else if(key == "SID")
-        // else if(key == "STAR")
-        // else if(key == "Transition")
-        else if(key == "wp")
-        {
-          QString type = values.value(1).toLower();
-          QString ident = values.value(2);
-          QString name = values.value(3);
-          QString airway = values.value(16);
-
-          FlightplanEntry entry;
-          entry.setIdent(ident);
-          entry.setName(name);
-          entry.setAirway(airway);
+      QString key = line.section('=', 0, 0).toLower().trimmed();
+      QStringList values = line.section('=', 1).simplified().split(",");
 
-          float latY = values.value(4).toFloat();
-          float lonX = values.value(5).toFloat();
-          entry.setPosition(Pos(lonX, latY));
-
-          if(type == "fix" || type == "int")
-            entry.setWaypointType(atools::fs::pln::entry::WAYPOINT);
-          else if(type == "uwp" || !atools::fs::util::isValidIdent(ident))
-            entry.setWaypointType(atools::fs::pln::entry::USER);
+      if(values.isEmpty())
+        continue;
 
-          plan.entries.append(entry);
-        }
+      if(key == "departapcode")
+      {
+        departure.setIdent(values.first());
+        departure.setWaypointType(atools::fs::pln::entry::AIRPORT);
+      }
+      else if(key == "destapcode")
+      {
+        destination.setIdent(values.first());
+        destination.setWaypointType(atools::fs::pln::entry::AIRPORT);
+      }
+      // Ignored keys
+      // else if(key == "DepartNum")
+      // else if(key == "DepartID")
+      // else if(key == "DepartType")
+      // else if(key == "SID")
+      // else if(key == "STAR")
+      // else if(key == "Transition")
+      else if(key == "wp")
+      {
+        QString type = values.value(1).toLower();
+        QString ident = values.value(2);
+        QString name = values.value(3);
+        QString airway = values.value(16);
+
+        FlightplanEntry entry;
+        entry.setIdent(ident);
+        entry.setName(name);
+        entry.setAirway(airway);
+
+        float latY = values.value(4).toFloat();
+        float lonX = values.value(5).toFloat();
+        entry.setPosition(Pos(lonX, latY));
+
+        if(type == "fix" || type == "int")
+          entry.setWaypointType(atools::fs::pln::entry::WAYPOINT);
+        else if(type == "uwp" || !atools::fs::util::isValidIdent(ident))
+          entry.setWaypointType(atools::fs::pln::entry::USER);
+
+        plan.entries.append(entry);
       }
     }
+  }
 
-    plan.entries.prepend(departure);
-    plan.entries.append(destination);
-
-    plnFile.close();
+  plan.entries.prepend(departure);
+  plan.entries.append(destination);
 
-    plan.flightplanType = IFR;
-    plan.cruisingAlt = 0.f; // Use either GUI value or calculate from airways
-    adjustDepartureAndDestination(plan);
 
-    plnFile.close();
-  }
-  else
-    throw Exception(errorMsg.arg(filename).arg(plnFile.errorString()));
+  plan.flightplanType = IFR;
+  plan.cruisingAlt = 0.f; // Use either GUI value or calculate from airways
+  adjustDepartureAndDestination(plan);
 }
 
-void FlightplanIO::loadFs9(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFs9(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
   // [flightplan]
@@ -736,100 +830,93 @@ void FlightplanIO::loadFs9(atools::fs::pln::Flightplan& plan, const QString& fil
   // waypoint.1=D205T, I, N56* 59.87', W2* 28.54', +000000.00,
   // waypoint.2=LUK, V, N56* 22.37', W2* 51.82', +000000.00,
 
-  QFile plnFile(filename);
-
-  if(plnFile.open(QIODevice::ReadOnly))
+  QTextStream stream(bytes);
+  while(!stream.atEnd())
   {
-    QTextStream stream(&plnFile);
-    while(!stream.atEnd())
+    QString line = stream.readLine().simplified();
+    if(!line.isEmpty() && !line.startsWith("[flightplan]"))
     {
-      QString line = stream.readLine().simplified();
-      if(!line.isEmpty() && !line.startsWith("[flightplan]"))
+      QString key = line.section('=', 0, 0).toLower().trimmed();
+      QString value = line.section('=', 1, 1).trimmed();
+
+      if(key == "type")
+        // type=IFR
+        plan.flightplanType = stringFlightplanType(value);
+      else if(key == "cruising_altitude")
+        plan.cruisingAlt = value.toInt();
+      else if(key == "departure_id")
       {
-        QString key = line.section('=', 0, 0).toLower().trimmed();
-        QString value = line.section('=', 1, 1).trimmed();
-
-        if(key == "type")
-          // type=IFR
-          plan.flightplanType = stringFlightplanType(value);
-        else if(key == "cruising_altitude")
-          plan.cruisingAlt = value.toInt();
-        else if(key == "departure_id")
-        {
-          // departure_id=EGPB, N59* 52.88', W001* 17.63', +000020.00
-          plan.departureIdent = value.section(',', 0, 0).trimmed();
-          plan.departurePos = Pos(value.section(',', 1, 3).trimmed());
-        }
-        else if(key == "departure_position")
-          // departure_position=1
-          plan.departureParkingName = value;
-        else if(key == "departure_name")
-          // departure_name=SUMBURGH
-          plan.departureName = value;
-        else if(key == "destination_id")
+        // departure_id=EGPB, N59* 52.88', W001* 17.63', +000020.00
+        plan.departureIdent = value.section(',', 0, 0).trimmed();
+        plan.departurePos = Pos(value.section(',', 1, 3).trimmed());
+      }
+      else if(key == "departure_position")
+        // departure_position=1
+        plan.departureParkingName = value;
+      else if(key == "departure_name")
+        // departure_name=SUMBURGH
+        plan.departureName = value;
+      else if(key == "destination_id")
+      {
+        // destination_id=EISG, N54* 16.82', W008* 35.95', +000011.00
+        plan.destinationIdent = value.section(',', 0, 0).trimmed();
+        plan.destinationPos = Pos(value.section(',', 1, 3).trimmed());
+      }
+      else if(key == "destination_name")
+        // destination_name=SLIGO
+        plan.destinationName = value;
+      else if(key.startsWith("waypoint."))
+      {
+        FlightplanEntry entry;
+
+        Pos pos(value.section(',', 5, 7).trimmed(), false);
+        if(pos.isValid())
         {
-          // destination_id=EISG, N54* 16.82', W008* 35.95', +000011.00
-          plan.destinationIdent = value.section(',', 0, 0).trimmed();
-          plan.destinationPos = Pos(value.section(',', 1, 3).trimmed());
+          // waypoint.0=   , EGPB, , EGPB, A, N59* 52.88', W001* 17.63', +000020.00,
+          // waypoint.1= KK, WIK , , WIK , V, N58* 27.53', W003* 06.02', +000000.00,
+          // ----------- 0   1    2  3     4  5            6             7          8
+          entry.setRegion(value.section(',', 0, 0).trimmed());
+          entry.setIdent(value.section(',', 1, 1).trimmed());
+          // ignore airport name at 2
+          // entry.setWaypointId(value.section(',', 3, 3).trimmed());
+          entry.setWaypointType(value.section(',', 4, 4).trimmed());
+          entry.setPosition(pos);
+          entry.setAirway(value.section(',', 8, 8).trimmed());
         }
-        else if(key == "destination_name")
-          // destination_name=SLIGO
-          plan.destinationName = value;
-        else if(key.startsWith("waypoint."))
+        else
         {
-          FlightplanEntry entry;
+          // waypoint.1= D205T, I, N56* 59.87', W2* 28.54', +000000.00,
+          // ----------- 0      1  2            3           4           5
+          pos = Pos(value.section(',', 2, 4).trimmed(), false);
 
-          Pos pos(value.section(',', 5, 7).trimmed(), false);
           if(pos.isValid())
           {
-            // waypoint.0=   , EGPB, , EGPB, A, N59* 52.88', W001* 17.63', +000020.00,
-            // waypoint.1= KK, WIK , , WIK , V, N58* 27.53', W003* 06.02', +000000.00,
-            // ----------- 0   1    2  3     4  5            6             7          8
-            entry.setRegion(value.section(',', 0, 0).trimmed());
-            entry.setIdent(value.section(',', 1, 1).trimmed());
+            // No region
+            entry.setIdent(value.section(',', 0, 0).trimmed());
             // ignore airport name at 2
-            // entry.setWaypointId(value.section(',', 3, 3).trimmed());
-            entry.setWaypointType(value.section(',', 4, 4).trimmed());
+            // entry.setWaypointId(value.section(',', 0, 0).trimmed());
+            entry.setWaypointType(value.section(',', 1, 1).trimmed());
             entry.setPosition(pos);
-            entry.setAirway(value.section(',', 8, 8).trimmed());
+            entry.setAirway(value.section(',', 5, 5).trimmed());
           }
           else
-          {
-            // waypoint.1= D205T, I, N56* 59.87', W2* 28.54', +000000.00,
-            // ----------- 0      1  2            3           4           5
-            pos = Pos(value.section(',', 2, 4).trimmed(), false);
-
-            if(pos.isValid())
-            {
-              // No region
-              entry.setIdent(value.section(',', 0, 0).trimmed());
-              // ignore airport name at 2
-              // entry.setWaypointId(value.section(',', 0, 0).trimmed());
-              entry.setWaypointType(value.section(',', 1, 1).trimmed());
-              entry.setPosition(pos);
-              entry.setAirway(value.section(',', 5, 5).trimmed());
-            }
-            else
-              throw Exception(tr("Invalid flight plan file \"%1\".").arg(filename));
-          }
-
-          plan.entries.append(entry);
+            throw Exception(tr("Invalid flight plan file \"%1\".").arg(filename));
         }
-        // else if(key == "alternate_name") ignore
+
+        plan.entries.append(entry);
       }
+      // else if(key == "alternate_name") ignore
     }
-    plnFile.close();
   }
-  else
-    throw Exception(errorMsg.arg(filename).arg(plnFile.errorString()));
 }
 
 atools::geo::Pos FlightplanIO::readPosLnm(QXmlStreamReader& reader)
 {
   bool lonOk, latOk, altOk;
-  float lon = reader.attributes().value("Lon").toFloat(&lonOk);
-  float lat = reader.attributes().value("Lat").toFloat(&latOk);
-  float alt = reader.attributes().value("Alt").toFloat(&altOk);
+  const QXmlStreamAttributes attributes = reader.attributes();
+  float lon = attributes.value(QLatin1String("Lon")).toFloat(&lonOk);
+  float lat = attributes.value(QLatin1String("Lat")).toFloat(&latOk);
+  float alt = attributes.value(QLatin1String("Alt")).toFloat(&altOk);
 
   // Read only attributes
   reader.skipCurrentElement();
@@ -866,8 +953,8 @@ void FlightplanIO::readPosGpx(atools::geo::Pos& pos, QString& name, atools::util
 {
   bool lonOk, latOk;
   QXmlStreamReader& reader = xmlStream.getReader();
-  float lon = reader.attributes().value("lon").toFloat(&lonOk);
-  float lat = reader.attributes().value("lat").toFloat(&latOk);
+  float lon = xmlStream.readAttributeFloat(QLatin1String("lon"), 0.f, &lonOk);
+  float lat = xmlStream.readAttributeFloat(QLatin1String("lat"), 0.f, &latOk);
 
   if(lonOk && latOk)
   {
@@ -893,7 +980,7 @@ void FlightplanIO::readPosGpx(atools::geo::Pos& pos, QString& name, atools::util
 
   while(xmlStream.readNextStartElement())
   {
-    if(reader.name() == "name")
+    if(xmlStream.elementId(GPX_NAMES) == GPX_NAME)
       name = reader.readElementText();
     else
       xmlStream.skipCurrentElement(false /* warn */);
@@ -920,30 +1007,38 @@ void FlightplanIO::readWaypointsLnm(atools::util::XmlStream& xmlStream, QList<Fl
       FlightplanEntry entry;
       while(xmlStream.readNextStartElement())
       {
-        if(reader.name() == "Name")
-          entry.setName(reader.readElementText());
-        else if(reader.name() == "Ident")
-          entry.setIdent(reader.readElementText());
-        else if(reader.name() == "Region")
-          entry.setRegion(reader.readElementText());
-        else if(reader.name() == "Name")
-          entry.setName(reader.readElementText());
-        else if(reader.name() == "Airway")
-          entry.setAirway(reader.readElementText());
-        else if(reader.name() == "Track")
+        switch(xmlStream.elementId(LNM_WAYPOINT_NAMES))
         {
-          // NAT, PACOTS or AUSOTS track
-          entry.setAirway(reader.readElementText());
-          entry.setFlag(atools::fs::pln::entry::TRACK);
+          case LNM_NAME:
+            entry.setName(reader.readElementText());
+            break;
+          case LNM_IDENT:
+            entry.setIdent(reader.readElementText());
+            break;
+          case LNM_REGION:
+            entry.setRegion(reader.readElementText());
+            break;
+          case LNM_AIRWAY:
+            entry.setAirway(reader.readElementText());
+            break;
+          case LNM_TRACK:
+            // NAT, PACOTS or AUSOTS track
+            entry.setAirway(reader.readElementText());
+            entry.setFlag(atools::fs::pln::entry::TRACK);
+            break;
+          case LNM_TYPE:
+            entry.setWaypointTypeFromLnm(reader.readElementText());
+            break;
+          case LNM_COMMENT:
+            entry.setComment(reader.readElementText());
+            break;
+          case LNM_POS:
+            entry.setPosition(readPosLnm(reader));
+            break;
+          default:
+            xmlStream.skipCurrentElement(true /* warn */);
+            break;
         }
-        else if(reader.name() == "Type")
-          entry.setWaypointTypeFromLnm(reader.readElementText());
-        else if(reader.name() == "Comment")
-          entry.setComment(reader.readElementText());
-        else if(reader.name() == "Pos")
-          entry.setPosition(readPosLnm(reader));
-        else
-          xmlStream.skipCurrentElement(true /* warn */);
       }
       entries.append(entry);
     }
@@ -964,21 +1059,28 @@ void FlightplanIO::loadLnmStr(Flightplan& plan, const QString& string)
 
 void FlightplanIO::loadLnmGz(Flightplan& plan, const QByteArray& bytes)
 {
-  loadLnmStr(plan, QString(atools::zip::gzipDecompress(bytes)));
+  plan.entries.clear();
+  if(!bytes.isEmpty())
+  {
+    // Parse while decompressing instead of inflating the whole plan into a string first
+    QBuffer buffer;
+    buffer.setData(bytes);
+    buffer.open(QIODevice::ReadOnly);
+
+    atools::zip::GzipDevice gzipDevice(&buffer);
+    if(gzipDevice.open(QIODevice::ReadOnly))
+    {
+      atools::util::XmlStream xmlStream(&gzipDevice);
+      loadLnmInternal(plan, xmlStream);
+    }
+  }
 }
 
 void FlightplanIO::loadLnm(atools::fs::pln::Flightplan& plan, const QString& filename)
 {
   plan.entries.clear();
-  QFile xmlFile(filename);
-  if(xmlFile.open(QIODevice::ReadOnly))
-  {
-    atools::util::XmlStream xmlStream(&xmlFile);
-    loadLnmInternal(plan, xmlStream);
-    xmlFile.close();
-  }
-  else
-    throw Exception(tr("Cannot open file \"%1\". Reason: %2").arg(filename).arg(xmlFile.errorString()));
+  atools::util::XmlStream xmlStream(readFile(filename), filename);
+  loadLnmInternal(plan, xmlStream);
 }
 
 void FlightplanIO::loadLnmInternal(Flightplan& plan, atools::util::XmlStream& xmlStream)
@@ -1151,163 +1253,155 @@ void FlightplanIO::loadLnmInternal(Flightplan& plan, atools::util::XmlStream& xm
     plan.departurePos = waypoints.first().getPosition();
 }
 
-void FlightplanIO::loadPln(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadPln(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
-  QFile xmlFile(filename);
+  plan.entries.clear();
+  atools::util::XmlStream xmlStream(bytes, filename);
+  QXmlStreamReader& reader = xmlStream.getReader();
 
-  if(xmlFile.open(QIODevice::ReadOnly))
+  // Skip all the useless entries until we hit the document
+  xmlStream.readUntilElement("SimBase.Document");
+  xmlStream.readUntilElement("Descr");
+  while(!reader.atEnd())
   {
-    plan.entries.clear();
-    atools::util::XmlStream xmlStream(&xmlFile);
-    QXmlStreamReader& reader = xmlStream.getReader();
-
-    // Skip all the useless entries until we hit the document
-    xmlStream.readUntilElement("SimBase.Document");
-    xmlStream.readUntilElement("Descr");
-    while(!reader.atEnd())
+    reader.readNext();
+    if(reader.isComment())
     {
-      reader.readNext();
-      if(reader.isComment())
+      QString comment = reader.text().toString().trimmed();
+      if(comment.startsWith("LNMDATA"))
       {
-        QString comment = reader.text().toString().trimmed();
-        if(comment.startsWith("LNMDATA"))
-        {
-          comment.remove(0, 7);
-          QStringList data = comment.split("|");
-          for(const QString& prop : data)
-            insertPropertyIf(plan, prop.section("=", 0, 0).trimmed(), prop.section("=", 1, 1).trimmed());
-        }
+        comment.remove(0, 7);
+        QStringList data = comment.split("|");
+        for(const QString& prop : data)
+          insertPropertyIf(plan, prop.section("=", 0, 0).trimmed(), prop.section("=", 1, 1).trimmed());
       }
-      if(reader.isStartElement())
-        break;
     }
-    // Skip all until the flightplan is found
-    xmlStream.readUntilElement("FlightPlan.FlightPlan");
-    int appVersionMajor = 0, appVersionBuild = 0;
+    if(reader.isStartElement())
+      break;
+  }
+  // Skip all until the flightplan is found
+  xmlStream.readUntilElement("FlightPlan.FlightPlan");
+  int appVersionMajor = 0, appVersionBuild = 0;
 
-    while(xmlStream.readNextStartElement())
+  while(xmlStream.readNextStartElement())
+  {
+    QStringRef name = reader.name();
+    // if(name == "Title")
+    // plan.title = reader.readElementText();
+    // else
+    if(name == "FPType")
+      plan.flightplanType = stringFlightplanType(reader.readElementText());
+    else if(name == "CruisingAlt")
+      plan.cruisingAlt = atools::roundToInt(reader.readElementText().toFloat());
+    else if(name == "DepartureID")
+      plan.departureIdent = reader.readElementText();
+    else if(name == "DepartureLLA")
     {
-      QStringRef name = reader.name();
-      // if(name == "Title")
-      // plan.title = reader.readElementText();
-      // else
-      if(name == "FPType")
-        plan.flightplanType = stringFlightplanType(reader.readElementText());
-      else if(name == "CruisingAlt")
-        plan.cruisingAlt = atools::roundToInt(reader.readElementText().toFloat());
-      else if(name == "DepartureID")
-        plan.departureIdent = reader.readElementText();
-      else if(name == "DepartureLLA")
-      {
-        QString txt = reader.readElementText();
-        if(!txt.isEmpty())
-          plan.departurePos = geo::Pos(txt);
-      }
-      else if(name == "DestinationID")
-        plan.destinationIdent = reader.readElementText();
-      else if(name == "DestinationLLA")
-      {
-        QString txt = reader.readElementText();
-        if(!txt.isEmpty())
-          plan.destinationPos = geo::Pos(txt);
-      }
-      // else if(name == "Descr")
-      // plan.description = reader.readElementText();
-      else if(name == "DeparturePosition")
-        plan.departureParkingName = reader.readElementText();
-      else if(name == "DepartureName")
-        plan.departureName = reader.readElementText();
-      else if(name == "DestinationName")
-        plan.destinationName = reader.readElementText();
-      else if(name == "AppVersion")
-        readAppVersionPln(appVersionMajor, appVersionBuild, xmlStream);
-      else if(name == "ATCWaypoint")
-        readWaypointPln(plan, xmlStream);
-      else
-        reader.skipCurrentElement();
+      QString txt = reader.readElementText();
+      if(!txt.isEmpty())
+        plan.departurePos = geo::Pos(txt);
     }
+    else if(name == "DestinationID")
+      plan.destinationIdent = reader.readElementText();
+    else if(name == "DestinationLLA")
+    {
+      QString txt = reader.readElementText();
+      if(!txt.isEmpty())
+        plan.destinationPos = geo::Pos(txt);
+    }
+    // else if(name == "Descr")
+    // plan.description = reader.readElementText();
+    else if(name == "DeparturePosition")
+      plan.departureParkingName = reader.readElementText();
+    else if(name == "DepartureName")
+      plan.departureName = reader.readElementText();
+    else if(name == "DestinationName")
+      plan.destinationName = reader.readElementText();
+    else if(name == "AppVersion")
+      readAppVersionPln(appVersionMajor, appVersionBuild, xmlStream);
+    else if(name == "ATCWaypoint")
+      readWaypointPln(plan, xmlStream);
+    else
+      reader.skipCurrentElement();
+  }
 
-    xmlFile.close();
 
-    if(!plan.isEmpty())
+  if(!plan.isEmpty())
+  {
+    // Clear airway of departure airport to avoid problems from third party tools
+    // like PFPX that abuse the airway name to add approach procedures
+    plan.entries.first().setAirway(QString());
+
+    if(plan.entries.size() > 1)
     {
-      // Clear airway of departure airport to avoid problems from third party tools
-      // like PFPX that abuse the airway name to add approach procedures
-      plan.entries.first().setAirway(QString());
+      // Clear airway to first waypoint
+      plan.entries[1].setAirway(QString());
 
-      if(plan.entries.size() > 1)
-      {
-        // Clear airway to first waypoint
-        plan.entries[1].setAirway(QString());
+      if(plan.entries.last().getWaypointType() == entry::AIRPORT)
+        // Clear airway to destination
+        plan.entries.last().setAirway(QString());
+    }
 
-        if(plan.entries.last().getWaypointType() == entry::AIRPORT)
-          // Clear airway to destination
-          plan.entries.last().setAirway(QString());
+    // Collect MSFS procedure information from all legs ========================================
+    QString sid, sidRunway, sidRunwayDesignator, star, starRunway, starRunwayDesignator, approach, approachSuffix,
+            approachRunway, approachRunwayDesignator;
+    for(int i = 0; i < plan.entries.size(); i++)
+    {
+      FlightplanEntry& entry = plan.entries[i];
+      if(!entry.getSid().isEmpty())
+      {
+        // Leg is part of a SID ==========
+        sid = entry.getSid();
+        sidRunway = entry.getRunwayNumber();
+        sidRunwayDesignator = entry.getRunwayDesignator();
       }
-
-      // Collect MSFS procedure information from all legs ========================================
-      QString sid, sidRunway, sidRunwayDesignator, star, starRunway, starRunwayDesignator, approach, approachSuffix,
-              approachRunway, approachRunwayDesignator;
-      for(int i = 0; i < plan.entries.size(); i++)
+      else if(!entry.getStar().isEmpty())
       {
-        FlightplanEntry& entry = plan.entries[i];
-        if(!entry.getSid().isEmpty())
-        {
-          // Leg is part of a SID ==========
-          sid = entry.getSid();
-          sidRunway = entry.getRunwayNumber();
-          sidRunwayDesignator = entry.getRunwayDesignator();
-        }
-        else if(!entry.getStar().isEmpty())
-        {
-          // Leg is part of a STAR ==========
-          star = entry.getStar();
-          starRunway = entry.getRunwayNumber();
-          starRunwayDesignator = entry.getRunwayDesignator();
-        }
-        else if(!entry.getApproach().isEmpty())
-        {
-          // Leg is part of an approach ==========
-          approach = entry.getApproach();
-          approachSuffix = entry.getApproachSuffix();
-          approachRunway = entry.getRunwayNumber();
-          approachRunwayDesignator = entry.getRunwayDesignator();
-        }
-
-        if(i == plan.entries.size() - 1)
-        {
-          // Clear procedure information in destination airport to prevent deletion further down
-          entry.setApproach(QString(), QString());
-          entry.setRunway(QString(), QString());
-        }
+        // Leg is part of a STAR ==========
+        star = entry.getStar();
+        starRunway = entry.getRunwayNumber();
+        starRunwayDesignator = entry.getRunwayDesignator();
+      }
+      else if(!entry.getApproach().isEmpty())
+      {
+        // Leg is part of an approach ==========
+        approach = entry.getApproach();
+        approachSuffix = entry.getApproachSuffix();
+        approachRunway = entry.getRunwayNumber();
+        approachRunwayDesignator = entry.getRunwayDesignator();
       }
 
-      // Add MSFS procedure information to properties ========================================
-      insertPropertyIf(plan, SIDAPPR, sid);
-      insertPropertyIf(plan, SIDAPPRRW, sidRunway + strAt(sidRunwayDesignator, 0));
-      // insertPropertyIf(plan, SIDTRANS, );
-      insertPropertyIf(plan, STAR, star);
-      insertPropertyIf(plan, STARRW, starRunway + strAt(starRunwayDesignator, 0));
-      // insertPropertyIf(plan, STARTRANS, );
-      // insertPropertyIf(plan, TRANSITION, );
-      // insertPropertyIf(plan, TRANSITIONTYPE, );
-      // insertPropertyIf(plan, APPROACH, approach);
-      // insertPropertyIf(plan, APPROACH_ARINC, approach);
-      insertPropertyIf(plan, APPROACHTYPE, approach);
-      insertPropertyIf(plan, APPROACHSUFFIX, approachSuffix);
-      insertPropertyIf(plan, APPROACHRW, approachRunway + strAt(approachRunwayDesignator, 0));
-
-      // Remove the procedure legs ============================
-      plan.entries.erase(std::remove_if(plan.entries.begin(), plan.entries.end(),
-                                        [ = ](const FlightplanEntry& entry) -> bool {
-              return !entry.getSid().isEmpty() || !entry.getStar().isEmpty() || !entry.getApproach().isEmpty();
-            }), plan.entries.end());
+      if(i == plan.entries.size() - 1)
+      {
+        // Clear procedure information in destination airport to prevent deletion further down
+        entry.setApproach(QString(), QString());
+        entry.setRunway(QString(), QString());
+      }
     }
+
+    // Add MSFS procedure information to properties ========================================
+    insertPropertyIf(plan, SIDAPPR, sid);
+    insertPropertyIf(plan, SIDAPPRRW, sidRunway + strAt(sidRunwayDesignator, 0));
+    // insertPropertyIf(plan, SIDTRANS, );
+    insertPropertyIf(plan, STAR, star);
+    insertPropertyIf(plan, STARRW, starRunway + strAt(starRunwayDesignator, 0));
+    // insertPropertyIf(plan, STARTRANS, );
+    // insertPropertyIf(plan, TRANSITION, );
+    // insertPropertyIf(plan, TRANSITIONTYPE, );
+    // insertPropertyIf(plan, APPROACH, approach);
+    // insertPropertyIf(plan, APPROACH_ARINC, approach);
+    insertPropertyIf(plan, APPROACHTYPE, approach);
+    insertPropertyIf(plan, APPROACHSUFFIX, approachSuffix);
+    insertPropertyIf(plan, APPROACHRW, approachRunway + strAt(approachRunwayDesignator, 0));
+
+    // Remove the procedure legs ============================
+    plan.entries.erase(std::remove_if(plan.entries.begin(), plan.entries.end(),
+                                      [ = ](const FlightplanEntry& entry) -> bool {
+            return !entry.getSid().isEmpty() || !entry.getStar().isEmpty() || !entry.getApproach().isEmpty();
+          }), plan.entries.end());
   }
-  else
-    throw Exception(tr("Cannot open file \"%1\". Reason: %2").arg(filename).arg(xmlFile.errorString()));
 }
 
 // <PropertyList>
@@ -1331,167 +1425,159 @@ void FlightplanIO::loadPln(atools::fs::pln::Flightplan& plan, const QString& fil
 // <ident type="string">29</ident>
 // <icao type="string">KOAK</icao>
 // </wp>
-void FlightplanIO::loadFlightGear(atools::fs::pln::Flightplan& plan, const QString& filename)
+void FlightplanIO::loadFlightGear(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
-  QFile xmlFile(filename);
-
-  if(xmlFile.open(QIODevice::ReadOnly))
-  {
-    plan.entries.clear();
-    atools::util::XmlStream xmlStream(&xmlFile);
-    QXmlStreamReader& reader = xmlStream.getReader();
+  plan.entries.clear();
+  atools::util::XmlStream xmlStream(bytes, filename);
+  QXmlStreamReader& reader = xmlStream.getReader();
 
-    QString departureIcao, departureRunway, sid, sidTransition,
-            destinationIcao, destinationRunway, star, starTransition;
-    float maxAlt = std::numeric_limits<float>::min();
+  QString departureIcao, departureRunway, sid, sidTransition,
+          destinationIcao, destinationRunway, star, starTransition;
+  float maxAlt = std::numeric_limits<float>::min();
 
-    xmlStream.readUntilElement("PropertyList");
+  xmlStream.readUntilElement("PropertyList");
 
-    while(xmlStream.readNextStartElement())
+  while(xmlStream.readNextStartElement())
+  {
+    QStringRef name = reader.name();
+    if(name == "version")
     {
-      QStringRef name = reader.name();
-      if(name == "version")
-      {
-        // Skip these elements without warning
-        xmlStream.skipCurrentElement();
-        continue;
-      }
+      // Skip these elements without warning
+      xmlStream.skipCurrentElement();
+      continue;
+    }
 
-      if(name == "departure")
+    if(name == "departure")
+    {
+      // Read sub elements for departure =====================================
+      while(xmlStream.readNextStartElement())
       {
-        // Read sub elements for departure =====================================
-        while(xmlStream.readNextStartElement())
-        {
-          QStringRef depname = reader.name();
-          if(depname == "airport")
-            departureIcao = reader.readElementText();
-          else if(depname == "runway")
-            departureRunway = reader.readElementText();
-          else if(depname == "sid")
-            sid = reader.readElementText();
-          else if(depname == "transition")
-            sidTransition = reader.readElementText();
-          else
-            reader.skipCurrentElement();
-        }
+        QStringRef depname = reader.name();
+        if(depname == "airport")
+          departureIcao = reader.readElementText();
+        else if(depname == "runway")
+          departureRunway = reader.readElementText();
+        else if(depname == "sid")
+          sid = reader.readElementText();
+        else if(depname == "transition")
+          sidTransition = reader.readElementText();
+        else
+          reader.skipCurrentElement();
       }
-      else if(name == "destination")
+    }
+    else if(name == "destination")
+    {
+      // Read sub elements for destination =====================================
+      while(xmlStream.readNextStartElement())
       {
-        // Read sub elements for destination =====================================
-        while(xmlStream.readNextStartElement())
-        {
-          QStringRef destname = reader.name();
-          if(destname == "airport")
-            destinationIcao = reader.readElementText();
-          else if(destname == "runway")
-            destinationRunway = reader.readElementText();
-          else if(destname == "star")
-            star = reader.readElementText();
-          else if(destname == "transition")
-            starTransition = reader.readElementText();
-          else
-            reader.skipCurrentElement();
-        }
+        QStringRef destname = reader.name();
+        if(destname == "airport")
+          destinationIcao = reader.readElementText();
+        else if(destname == "runway")
+          destinationRunway = reader.readElementText();
+        else if(destname == "star")
+          star = reader.readElementText();
+        else if(destname == "transition")
+          starTransition = reader.readElementText();
+        else
+          reader.skipCurrentElement();
       }
-      else if(name == "route")
+    }
+    else if(name == "route")
+    {
+      // Read wp elements for route =====================================
+      while(xmlStream.readNextStartElement())
       {
-        // Read wp elements for route =====================================
-        while(xmlStream.readNextStartElement())
+        FlightplanEntry entry;
+
+        QStringRef destname = reader.name();
+        if(destname == "wp")
         {
-          FlightplanEntry entry;
+          QString wptype, wpicao, wpident, wplon, wplat, wpalt;
 
-          QStringRef destname = reader.name();
-          if(destname == "wp")
+          while(xmlStream.readNextStartElement())
           {
-            QString wptype, wpicao, wpident, wplon, wplat, wpalt;
-
-            while(xmlStream.readNextStartElement())
-            {
-              QStringRef wpname = reader.name();
-
-              if(wpname == "type")
-                wptype = reader.readElementText();
-              else if(wpname == "icao")
-                wpicao = reader.readElementText();
-              else if(wpname == "ident")
-                wpident = reader.readElementText();
-              else if(wpname == "lon")
-                wplon = reader.readElementText();
-              else if(wpname == "lat")
-                wplat = reader.readElementText();
-              else if(wpname == "altitude-ft")
-                wpalt = reader.readElementText();
-              else
-                reader.skipCurrentElement();
-            }
+            QStringRef wpname = reader.name();
+
+            if(wpname == "type")
+              wptype = reader.readElementText();
+            else if(wpname == "icao")
+              wpicao = reader.readElementText();
+            else if(wpname == "ident")
+              wpident = reader.readElementText();
+            else if(wpname == "lon")
+              wplon = reader.readElementText();
+            else if(wpname == "lat")
+              wplat = reader.readElementText();
+            else if(wpname == "altitude-ft")
+              wpalt = reader.readElementText();
+            else
+              reader.skipCurrentElement();
+          }
 
-            float altitude = wpalt.toFloat();
-            if(altitude > 1000000.f)
-              // Avoid excessive altitudes
-              altitude = 0.f;
+          float altitude = wpalt.toFloat();
+          if(altitude > 1000000.f)
+            // Avoid excessive altitudes
+            altitude = 0.f;
 
-            maxAlt = std::max(maxAlt, altitude);
+          maxAlt = std::max(maxAlt, altitude);
 
-            entry.setPosition(Pos(wplon.toFloat(), wplat.toFloat(), altitude));
+          entry.setPosition(Pos(wplon.toFloat(), wplat.toFloat(), altitude));
 
-            if(wptype == "runway")
-            {
-              // Runway entry for airport =================================================
-              QString id = wpicao.isEmpty() ? wpident : wpicao;
-              entry.setIdent(id);
-              plan.getEntries().append(entry);
-            }
-            else if(wptype == "navaid")
-            {
-              // Normal navaid =================================
-              entry.setIdent(wpident);
-              plan.getEntries().append(entry);
-            }
+          if(wptype == "runway")
+          {
+            // Runway entry for airport =================================================
+            QString id = wpicao.isEmpty() ? wpident : wpicao;
+            entry.setIdent(id);
+            plan.getEntries().append(entry);
+          }
+          else if(wptype == "navaid")
+          {
+            // Normal navaid =================================
+            entry.setIdent(wpident);
+            plan.getEntries().append(entry);
           }
-          else
-            reader.skipCurrentElement();
         }
+        else
+          reader.skipCurrentElement();
       }
-      else
-        reader.skipCurrentElement();
     }
+    else
+      reader.skipCurrentElement();
+  }
 
-    if(!plan.entries.isEmpty())
-    {
-      // Correct start and destination entry types ================================================
-      plan.entries.first().setWaypointType(atools::fs::pln::entry::AIRPORT);
-      plan.entries.last().setWaypointType(atools::fs::pln::entry::AIRPORT);
-    }
+  if(!plan.entries.isEmpty())
+  {
+    // Correct start and destination entry types ================================================
+    plan.entries.first().setWaypointType(atools::fs::pln::entry::AIRPORT);
+    plan.entries.last().setWaypointType(atools::fs::pln::entry::AIRPORT);
+  }
 
-    plan.setDepartureIdent(departureIcao);
-    plan.setDestinationIdent(destinationIcao);
-
-    // Set departure procedure =========================================================
-    if(!departureRunway.isEmpty())
-      plan.getProperties().insert(SIDAPPRRW, departureRunway);
-    if(!sid.isEmpty())
-      plan.getProperties().insert(SIDAPPR, sid);
-    if(!sidTransition.isEmpty())
-      plan.getProperties().insert(SIDTRANS, sidTransition);
-
-    // Set arrival procedure =========================================================
-    if(!destinationRunway.isEmpty())
-      plan.getProperties().insert(STARRW, destinationRunway);
-    if(!star.isEmpty())
-      plan.getProperties().insert(STAR, star);
-    if(!starTransition.isEmpty())
-      plan.getProperties().insert(STARTRANS, starTransition);
+  plan.setDepartureIdent(departureIcao);
+  plan.setDestinationIdent(destinationIcao);
 
-    xmlFile.close();
+  // Set departure procedure =========================================================
+  if(!departureRunway.isEmpty())
+    plan.getProperties().insert(SIDAPPRRW, departureRunway);
+  if(!sid.isEmpty())
+    plan.getProperties().insert(SIDAPPR, sid);
+  if(!sidTransition.isEmpty())
+    plan.getProperties().insert(SIDTRANS, sidTransition);
 
-    plan.cruisingAlt = atools::roundToInt(maxAlt > 0.f ? maxAlt : 0.f); // Use value from GUI
-    adjustDepartureAndDestination(plan);
-    assignAltitudeToAllEntries(plan);
-  }
-  else
-    throw Exception(tr("Cannot open FlightGear file \"%1\". Reason: %2").arg(filename).arg(xmlFile.errorString()));
+  // Set arrival procedure =========================================================
+  if(!destinationRunway.isEmpty())
+    plan.getProperties().insert(STARRW, destinationRunway);
+  if(!star.isEmpty())
+    plan.getProperties().insert(STAR, star);
+  if(!starTransition.isEmpty())
+    plan.getProperties().insert(STARTRANS, starTransition);
+
+
+  plan.cruisingAlt = atools::roundToInt(maxAlt > 0.f ? maxAlt : 0.f); // Use value from GUI
+  adjustDepartureAndDestination(plan);
+  assignAltitudeToAllEntries(plan);
 }
 
 void FlightplanIO::writeElementIf(QXmlStreamWriter& writer, const QString& name, const QString& value)
@@ -2988,18 +3074,18 @@ void FlightplanIO::loadGpx(atools::geo::LineString *route, QStringList *routenam
 void FlightplanIO::loadGpxInternal(atools::geo::LineString *route, QStringList *routenames,
                                    atools::geo::LineString *track, atools::util::XmlStream& xmlStream)
 {
-  QXmlStreamReader& reader = xmlStream.getReader();
   xmlStream.readUntilElement("gpx");
   Pos pos;
   QString name;
   while(xmlStream.readNextStartElement())
   {
     // Read route elements if needed ======================================================
-    if(reader.name() == "rte" && (route != nullptr || routenames != nullptr))
+    int id = xmlStream.elementId(GPX_NAMES);
+    if(id == GPX_RTE && (route != nullptr || routenames != nullptr))
     {
       while(xmlStream.readNextStartElement())
       {
-        if(reader.name() == "rtept")
+        if(xmlStream.elementId(GPX_NAMES) == GPX_RTEPT)
         {
           readPosGpx(pos, name, xmlStream);
           if(pos.isValidRange())
@@ -3015,15 +3101,15 @@ void FlightplanIO::loadGpxInternal(atools::geo::LineString *route, QStringList *
       }
     }
     // Read track elements if needed ======================================================
-    else if(reader.name() == "trk" && track != nullptr)
+    else if(id == GPX_TRK && track != nullptr)
     {
       while(xmlStream.readNextStartElement())
       {
-        if(reader.name() == "trkseg")
+        if(xmlStream.elementId(GPX_NAMES) == GPX_TRKSEG)
         {
           while(xmlStream.readNextStartElement())
           {
-            if(reader.name() == "trkpt")
+            if(xmlStream.elementId(GPX_NAMES) == GPX_TRKPT)
             {
               readPosGpx(pos, name, xmlStream);
               if(pos.isValidRange())
@@ -3797,16 +3883,9 @@ void FlightplanIO::saveGarminFpl(const atools::fs::pln::Flightplan& plan, const
 
 void FlightplanIO::loadGarminFpl(Flightplan& plan, const QString& filename)
 {
-  QFile xmlFile(filename);
-  if(xmlFile.open(QIODevice::ReadOnly))
-  {
-    plan.entries.clear();
-    atools::util::XmlStream xmlStream(&xmlFile);
-    loadGarminFplInternal(plan, xmlStream);
-    xmlFile.close();
-  }
-  else
-    throw Exception(tr("Cannot open file \"%1\". Reason: %2").arg(filename).arg(xmlFile.errorString()));
+  plan.entries.clear();
+  atools::util::XmlStream xmlStream(readFile(filename), filename);
+  loadGarminFplInternal(plan, xmlStream);
 }
 
 void FlightplanIO::loadGarminFplStr(Flightplan& plan, const QString& string)
@@ -3861,22 +3940,33 @@ void FlightplanIO::loadGarminFplInternal(Flightplan& plan, atools::util::XmlStre
             // .   <elevation>173.4312</elevation>
             // . </waypoint>
 
-            if(reader.name() == "identifier")
-              entry.setIdent(reader.readElementText());
-            else if(reader.name() == "type")
-              type = reader.readElementText();
-            else if(reader.name() == "country-code")
-              entry.setRegion(reader.readElementText());
-            else if(reader.name() == "lat")
-              pos.setLatY(reader.readElementText().toFloat());
-            else if(reader.name() == "lon")
-              pos.setLonX(reader.readElementText().toFloat());
-            else if(reader.name() == "comment")
-              entry.setComment(reader.readElementText());
-            else if(reader.name() == "elevation")
-              pos.setAltitude(reader.readElementText().toFloat());
-            else
-              xmlStream.skipCurrentElement(false /* warn */);
+            switch(xmlStream.elementId(GARMIN_WAYPOINT_NAMES))
+            {
+              case FPL_IDENTIFIER:
+                entry.setIdent(reader.readElementText());
+                break;
+              case FPL_TYPE:
+                type = reader.readElementText();
+                break;
+              case FPL_COUNTRY_CODE:
+                entry.setRegion(reader.readElementText());
+                break;
+              case FPL_LAT:
+                pos.setLatY(xmlStream.readElementTextFloat());
+                break;
+              case FPL_LON:
+                pos.setLonX(xmlStream.readElementTextFloat());
+                break;
+              case FPL_COMMENT:
+                entry.setComment(reader.readElementText());
+                break;
+              case FPL_ELEVATION:
+                pos.setAltitude(xmlStream.readElementTextFloat());
+                break;
+              default:
+                xmlStream.skipCurrentElement(false /* warn */);
+                break;
+            }
           }
           entry.setPosition(pos);
           entry.setWaypointType(garminToWaypointType(type));
@@ -4069,6 +4159,9 @@ void FlightplanIO::adjustDepartureAndDestination(atools::fs::pln::Flightplan& pl
 
 int FlightplanIO::numEntriesSave(const atools::fs::pln::Flightplan& plan)
 {
+  if(numEntriesCachePlan == &plan)
+    return numEntriesCache;
+
   int num = 0;
   for(const FlightplanEntry& entry : plan.entries)
   {
@@ -4188,43 +4281,60 @@ void FlightplanIO::readWaypointPln(atools::fs::pln::Flightplan& plan, atools::ut
 
   while(xmlStream.readNextStartElement())
   {
-    QString name = reader.name().toString();
-    if(name == "ATCWaypointType")
-      entry.setWaypointType(reader.readElementText());
-    else if(name == "WorldPosition")
-      entry.setPosition(geo::Pos(reader.readElementText()));
-    else if(name == "ATCAirway")
-      entry.setAirway(reader.readElementText());
-
-    else if(name == "RunwayNumberFP") // MSFS
-      runway = reader.readElementText();
-    else if(name == "RunwayDesignatorFP") // MSFS
-      designator = reader.readElementText();
-    else if(name == "DepartureFP") // MSFS
-      entry.setSid(reader.readElementText());
-    else if(name == "ArrivalFP") // MSFS
-      entry.setStar(reader.readElementText());
-    else if(name == "ApproachTypeFP") // MSFS
-      approach = reader.readElementText();
-    else if(name == "SuffixFP") // MSFS
-      suffix = reader.readElementText();
-    else if(name == "ICAO")
+    switch(xmlStream.elementId(PLN_WAYPOINT_NAMES))
     {
-      while(xmlStream.readNextStartElement())
-      {
-        QStringRef iName = reader.name();
-        if(iName == "ICAORegion")
-          entry.setRegion(reader.readElementText());
-        else if(iName == "ICAOIdent")
-          entry.setIdent(reader.readElementText());
-        else if(iName == "ICAOAirport") // MSFS
-          entry.setAirport(reader.readElementText());
-        else
-          reader.skipCurrentElement();
-      }
+      case PLN_ATC_WAYPOINT_TYPE:
+        entry.setWaypointType(reader.readElementText());
+        break;
+      case PLN_WORLD_POSITION:
+        entry.setPosition(geo::Pos(reader.readElementText()));
+        break;
+      case PLN_ATC_AIRWAY:
+        entry.setAirway(reader.readElementText());
+        break;
+
+      case PLN_RUNWAY_NUMBER: // MSFS
+        runway = reader.readElementText();
+        break;
+      case PLN_RUNWAY_DESIGNATOR: // MSFS
+        designator = reader.readElementText();
+        break;
+      case PLN_DEPARTURE: // MSFS
+        entry.setSid(reader.readElementText());
+        break;
+      case PLN_ARRIVAL: // MSFS
+        entry.setStar(reader.readElementText());
+        break;
+      case PLN_APPROACH_TYPE: // MSFS
+        approach = reader.readElementText();
+        break;
+      case PLN_SUFFIX: // MSFS
+        suffix = reader.readElementText();
+        break;
+      case PLN_ICAO:
+        while(xmlStream.readNextStartElement())
+        {
+          switch(xmlStream.elementId(PLN_WAYPOINT_NAMES))
+          {
+            case PLN_ICAO_REGION:
+              entry.setRegion(reader.readElementText());
+              break;
+            case PLN_ICAO_IDENT:
+              entry.setIdent(reader.readElementText());
+              break;
+            case PLN_ICAO_AIRPORT: // MSFS
+              entry.setAirport(reader.readElementText());
+              break;
+            default:
+              reader.skipCurrentElement();
+              break;
+          }
+        }
+        break;
+      default:
+        reader.skipCurrentElement();
+        break;
     }
-    else
-      reader.skipCurrentElement();
   }
   entry.setRunway(runway, designator);
   entry.setApproach(approach, suffix);
@@ -4268,11 +4378,142 @@ QString FlightplanIO::identOrDegMinFormat(const atools::fs::pln::FlightplanEntry
 {
   if(entry.getWaypointType() == atools::fs::pln::entry::USER ||
      entry.getWaypointType() == atools::fs::pln::entry::UNKNOWN)
-    return atools::fs::util::toDegMinFormat(entry.getPosition());
+  {
+    // Use value calculated by saveMulti() if available
+    QHash<const FlightplanEntry *, QString>::const_iterator it = identCache.constFind(&entry);
+    return it != identCache.constEnd() ? it.value() : atools::fs::util::toDegMinFormat(entry.getPosition());
+  }
   else
     return entry.getIdent();
 }
 
+void FlightplanIO::saveMulti(const Flightplan& plan, const QVector<SaveTarget>& targets)
+{
+  // Calculate shared data once for all formats ==========================
+  identCache.clear();
+  for(const FlightplanEntry& entry : plan.entries)
+  {
+    if(entry.getWaypointType() == atools::fs::pln::entry::USER ||
+       entry.getWaypointType() == atools::fs::pln::entry::UNKNOWN)
+      identCache.insert(&entry, atools::fs::util::toDegMinFormat(entry.getPosition()));
+  }
+  numEntriesCache = numEntriesSave(plan);
+  numEntriesCachePlan = &plan;
+
+  // Write all files - each task writes its own file and uses the cache read only
+  QVector<QString> errors(targets.size());
+  QString *errorData = errors.data();
+  atools::util::parallelFor(targets.size(), [&](int i) -> void {
+    try
+    {
+      saveTarget(plan, targets.at(i));
+    }
+    catch(atools::Exception& e)
+    {
+      errorData[i] = e.getMessage();
+    }
+    catch(std::exception& e)
+    {
+      errorData[i] = e.what();
+    }
+    catch(...)
+    {
+      errorData[i] = tr("Unknown error saving \"%1\"").arg(targets.at(i).filename);
+    }
+  });
+
+  identCache.clear();
+  numEntriesCachePlan = nullptr;
+
+  QStringList messages;
+  for(const QString& error : errors)
+  {
+    if(!error.isEmpty())
+      messages.append(error);
+  }
+
+  if(!messages.isEmpty())
+    throw Exception(messages.join("\n"));
+}
+
+void FlightplanIO::saveTarget(const Flightplan& plan, const SaveTarget& target)
+{
+  switch(target.format)
+  {
+    case LNMPLN:
+      saveLnm(plan, target.filename);
+      break;
+
+    case PLN:
+      savePln(plan, target.filename);
+      break;
+
+    case PLN_MSFS:
+      savePlnMsfs(plan, target.filename);
+      break;
+
+    case PLN_ANNOTATED:
+      savePlnAnnotated(plan, target.filename);
+      break;
+
+    case FLIGHTGEAR_FGFP:
+      saveFlightGear(plan, target.filename);
+      break;
+
+    case RTE:
+      saveRte(plan, target.filename);
+      break;
+
+    case FLP_AEROSOFT:
+      saveFlp(plan, target.filename);
+      break;
+
+    case FLP_CRJ:
+      saveCrjFlp(plan, target.filename);
+      break;
+
+    case FMS_3:
+      saveFms3(plan, target.filename);
+      break;
+
+    case FMS_11:
+      saveFms11(plan, target.filename);
+      break;
+
+    case FPL_GARMIN:
+      saveGarminFpl(plan, target.filename, target.options);
+      break;
+
+    case FPR:
+      saveFpr(plan, target.filename);
+      break;
+
+    case FLTPLAN:
+      saveFltplan(plan, target.filename);
+      break;
+
+    case PLN_BBS:
+      saveBbsPln(plan, target.filename);
+      break;
+
+    case FPL_FEELTHERE:
+      saveFeelthereFpl(plan, target.filename, target.groundSpeed);
+      break;
+
+    case RTE_LEVELD:
+      saveLeveldRte(plan, target.filename);
+      break;
+
+    case RTE_QW:
+      saveQwRte(plan, target.filename);
+      break;
+
+    case MDR:
+      saveMdr(plan, target.filename);
+      break;
+  }
+}
+
 } // namespace pln
 } // namespace fs
 } // namespace atools
@@ -21,6 +21,9 @@
 #include "fs/pln/flightplanconstants.h"
 
 #include <QApplication>
+#include <QHash>
+
+#include <functional>
 
 class QXmlStreamReader;
 class QXmlStreamWriter;
@@ -60,9 +63,26 @@ public:
    */
   FileFormat load(atools::fs::pln::Flightplan& plan, const QString& file);
 
+  /* Called by loadBatch() for each loaded flight plan with the index in the file list */
+  typedef std::function<void (int index, atools::fs::pln::Flightplan& plan,
+                              atools::fs::pln::FileFormat format)> BatchFunctionType;
+
+  /* Load all files in parallel using all cores and call func for each loaded plan in a worker thread.
+   * func has to be thread safe and can e.g. save the plan into another format using its own FlightplanIO.
+   * errors is filled with one message per file which is empty if loading and func succeeded.
+   * Exceptions are caught and stored in errors. Returns number of successfully processed files. */
+  static int loadBatch(const QStringList& files, QStringList& errors, const BatchFunctionType& func);
+
   /* Detect format by reading the first few lines */
   static atools::fs::pln::FileFormat detectFormat(const QString& file);
 
+  /* Detect format from the first few lines of file content already loaded into memory.
+   * Only the first PROBE_SIZE bytes are inspected. file is used for error messages only. */
+  static atools::fs::pln::FileFormat detectFormat(const QByteArray& bytes, const QString& file = QString());
+
+  /* Number of bytes at the beginning of a file that are used for format detection */
+  static const int PROBE_SIZE = 65536;
+
   /* LNM own XML format
    * Save a flightplan. An exception is thrown if the flight plan contents are not valid.
    * Although the flight simulator cannot deal with flight plans that have no valid start
@@ -170,6 +190,44 @@ public:
   /* TFDi Design 717 XML */
   void saveTfdi(const Flightplan& plan, const QString& filename, const QBitArray& jetAirways);
 
+  /* Export formats for saveMulti() */
+  enum SaveFormat
+  {
+    LNMPLN, /* saveLnm() */
+    PLN, /* savePln() */
+    PLN_MSFS, /* savePlnMsfs() */
+    PLN_ANNOTATED, /* savePlnAnnotated() */
+    FLIGHTGEAR_FGFP, /* saveFlightGear() */
+    RTE, /* saveRte() */
+    FLP_AEROSOFT, /* saveFlp() */
+    FLP_CRJ, /* saveCrjFlp() */
+    FMS_3, /* saveFms3() */
+    FMS_11, /* saveFms11() */
+    FPL_GARMIN, /* saveGarminFpl() using options */
+    FPR, /* saveFpr() */
+    FLTPLAN, /* saveFltplan() */
+    PLN_BBS, /* saveBbsPln() */
+    FPL_FEELTHERE, /* saveFeelthereFpl() using groundSpeed */
+    RTE_LEVELD, /* saveLeveldRte() */
+    RTE_QW, /* saveQwRte() */
+    MDR /* saveMdr() */
+  };
+
+  /* One output file for saveMulti() */
+  struct SaveTarget
+  {
+    SaveFormat format;
+    QString filename;
+    atools::fs::pln::SaveOptions options = atools::fs::pln::SAVE_NO_OPTIONS;
+    int groundSpeed = 0;
+  };
+
+  /* Save the plan into all given targets at once. Data shared by the formats like coordinate formatted
+   * user waypoint names is calculated only once. Files are written in parallel using the task scheduler.
+   * All targets are written even if one fails. An exception containing all error messages is thrown afterwards.
+   * Use the methods above for formats needing additional parameters like GPX, EFBR or TFDi. */
+  void saveMulti(const atools::fs::pln::Flightplan& plan, const QVector<SaveTarget>& targets);
+
   /* Version number to save into LNMPLN files */
   static const int LNMPLN_VERSION_MAJOR = 1;
   static const int LNMPLN_VERSION_MINOR = 0;
@@ -187,13 +245,16 @@ private:
   void loadGarminFplInternal(Flightplan& plan, util::XmlStream& xmlStream);
   atools::fs::pln::entry::WaypointType garminToWaypointType(const QString& typeStr) const;
 
-  /* Load specific formats after content detection */
-  void loadPln(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFs9(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFlp(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFms(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFsc(atools::fs::pln::Flightplan& plan, const QString& filename);
-  void loadFlightGear(atools::fs::pln::Flightplan& plan, const QString& filename);
+  /* Load specific formats after content detection from file content. filename is used for messages. */
+  void loadPln(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename);
+  void loadFs9(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename);
+  void loadFlp(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename);
+  void loadFms(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename);
+  void loadFsc(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename);
+  void loadFlightGear(atools::fs::pln::Flightplan& plan, const QByteArray& bytes, const QString& filename);
+
+  /* Read whole file and decompress it if Gzip compressed. Throws exception on error. */
+  QByteArray readFile(const QString& filename);
 
   /* Write string into memory location, truncate if needed and fill up to length with null */
   void writeBinaryString(char *mem, QString str, int length);
@@ -251,8 +312,17 @@ private:
 
   QString msfsApproachType(const QString& type);
 
+  /* Save a single target of saveMulti() */
+  void saveTarget(const atools::fs::pln::Flightplan& plan, const SaveTarget& target);
+
   QString errorMsg;
 
+  /* Filled by saveMulti() for the duration of the call. Key is the address of the flight plan entry and
+   * value the coordinate name of user waypoints as returned by identOrDegMinFormat(). Read only while saving. */
+  QHash<const atools::fs::pln::FlightplanEntry *, QString> identCache;
+  const atools::fs::pln::Flightplan *numEntriesCachePlan = nullptr;
+  int numEntriesCache = 0;
+
 };
 
 } // namespace pln
@@ -0,0 +1,225 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/pln/flightplansnapshot.h"
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace pln {
+
+FlightplanSnapshot::FlightplanSnapshot()
+  : header(new Flightplan), offsets({0})
+{
+}
+
+FlightplanSnapshot::FlightplanSnapshot(const Flightplan& flightplan)
+  : header(createHeader(flightplan))
+{
+  appendChunks(flightplan.getEntries(), 0, flightplan.getEntries().size());
+  updateOffsets();
+}
+
+FlightplanSnapshot::FlightplanSnapshot(const Flightplan& flightplan, const FlightplanSnapshot& previous)
+  : header(createHeader(flightplan))
+{
+  const FlightplanEntryListType& entries = flightplan.getEntries();
+  const QVector<ChunkPtr>& prevChunks = previous.chunks;
+
+  // Share unchanged chunks at the start ==========================
+  int from = 0, first = 0;
+  while(first < prevChunks.size() && from + prevChunks.at(first)->size() <= entries.size() &&
+        isChunkEqual(*prevChunks.at(first), entries, from))
+  {
+    chunks.append(prevChunks.at(first));
+    from += prevChunks.at(first)->size();
+    first++;
+  }
+
+  // Share unchanged chunks at the end ==========================
+  int to = entries.size(), last = prevChunks.size() - 1;
+  while(last >= first && to - prevChunks.at(last)->size() >= from &&
+        isChunkEqual(*prevChunks.at(last), entries, to - prevChunks.at(last)->size()))
+  {
+    to -= prevChunks.at(last)->size();
+    last--;
+  }
+
+  // Copy changed entries in the middle
+  appendChunks(entries, from, to);
+  for(int i = last + 1; i < prevChunks.size(); i++)
+    chunks.append(prevChunks.at(i));
+
+  updateOffsets();
+}
+
+Flightplan FlightplanSnapshot::toFlightplan() const
+{
+  Flightplan flightplan(*header);
+  FlightplanEntryListType& entries = flightplan.getEntries();
+  entries.reserve(size());
+  for(const ChunkPtr& chunk : chunks)
+  {
+    for(const FlightplanEntry& entry : *chunk)
+      entries.append(entry);
+  }
+  return flightplan;
+}
+
+const FlightplanEntry& FlightplanSnapshot::at(int index) const
+{
+  int idx = chunkIndex(index);
+  return chunks.at(idx)->at(index - offsets.at(idx));
+}
+
+FlightplanSnapshot FlightplanSnapshot::withEntry(int index, const FlightplanEntry& entry) const
+{
+  FlightplanSnapshot snapshot(*this);
+  int idx = chunkIndex(index);
+  Chunk *chunk = new Chunk(*chunks.at(idx));
+  (*chunk)[index - offsets.at(idx)] = entry;
+  snapshot.chunks[idx] = ChunkPtr(chunk);
+  return snapshot;
+}
+
+FlightplanSnapshot FlightplanSnapshot::withInsertedEntry(int index, const FlightplanEntry& entry) const
+{
+  Q_ASSERT(index >= 0 && index <= size());
+
+  FlightplanSnapshot snapshot(*this);
+  if(chunks.isEmpty())
+    snapshot.chunks.append(ChunkPtr(new Chunk({entry})));
+  else
+  {
+    // Append to last chunk if index is at the end
+    int idx = index == size() ? chunks.size() - 1 : chunkIndex(index);
+    Chunk chunk(*chunks.at(idx));
+    chunk.insert(index - offsets.at(idx), entry);
+
+    if(chunk.size() > MAX_CHUNK_SIZE)
+    {
+      // Split into two halves
+      int half = chunk.size() / 2;
+      snapshot.chunks[idx] = ChunkPtr(new Chunk(chunk.mid(0, half)));
+      snapshot.chunks.insert(idx + 1, ChunkPtr(new Chunk(chunk.mid(half))));
+    }
+    else
+      snapshot.chunks[idx] = ChunkPtr(new Chunk(chunk));
+  }
+  snapshot.updateOffsets();
+  return snapshot;
+}
+
+FlightplanSnapshot FlightplanSnapshot::withRemovedEntry(int index) const
+{
+  FlightplanSnapshot snapshot(*this);
+  int idx = chunkIndex(index);
+  if(chunks.at(idx)->size() == 1)
+    snapshot.chunks.remove(idx);
+  else
+  {
+    Chunk *chunk = new Chunk(*chunks.at(idx));
+    chunk->remove(index - offsets.at(idx));
+    snapshot.chunks[idx] = ChunkPtr(chunk);
+  }
+  snapshot.updateOffsets();
+  return snapshot;
+}
+
+FlightplanSnapshot FlightplanSnapshot::withHeader(const Flightplan& flightplan) const
+{
+  FlightplanSnapshot snapshot(*this);
+  snapshot.header = createHeader(flightplan);
+  return snapshot;
+}
+
+int FlightplanSnapshot::getNumSharedChunks(const FlightplanSnapshot& other) const
+{
+  int num = 0;
+  for(const ChunkPtr& chunk : chunks)
+  {
+    for(const ChunkPtr& otherChunk : other.chunks)
+    {
+      if(chunk == otherChunk)
+      {
+        num++;
+        break;
+      }
+    }
+  }
+  return num;
+}
+
+void FlightplanSnapshot::appendChunks(const FlightplanEntryListType& entries, int from, int to)
+{
+  // Leave room for inserts to avoid splitting on the next edit
+  const int chunkSize = MAX_CHUNK_SIZE / 2;
+  for(int start = from; start < to; start += chunkSize)
+  {
+    int end = std::min(start + chunkSize, to);
+    Chunk *chunk = new Chunk;
+    chunk->reserve(end - start);
+    for(int i = start; i < end; i++)
+      chunk->append(entries.at(i));
+    chunks.append(ChunkPtr(chunk));
+  }
+}
+
+void FlightplanSnapshot::updateOffsets()
+{
+  offsets.clear();
+  offsets.reserve(chunks.size() + 1);
+  int offset = 0;
+  for(const ChunkPtr& chunk : chunks)
+  {
+    offsets.append(offset);
+    offset += chunk->size();
+  }
+  offsets.append(offset);
+}
+
+int FlightplanSnapshot::chunkIndex(int index) const
+{
+  Q_ASSERT(index >= 0 && index < size());
+
+  // First offset greater than index follows the chunk containing index
+  return static_cast<int>(std::upper_bound(offsets.constBegin(), offsets.constEnd(), index) - offsets.constBegin()) - 1;
+}
+
+QSharedPointer<const Flightplan> FlightplanSnapshot::createHeader(const Flightplan& flightplan)
+{
+  // Copy is cheap since the entry list is implicitly shared and not detached by clear()
+  Flightplan *plan = new Flightplan(flightplan);
+  plan->getEntries().clear();
+  return QSharedPointer<const Flightplan>(plan);
+}
+
+bool FlightplanSnapshot::isChunkEqual(const Chunk& chunk, const FlightplanEntryListType& entries, int from)
+{
+  for(int i = 0; i < chunk.size(); i++)
+  {
+    if(!chunk.at(i).isIdentical(entries.at(from + i)))
+      return false;
+  }
+  return true;
+}
+
+} // namespace pln
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,119 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FLIGHTPLANSNAPSHOT_H
+#define ATOOLS_FLIGHTPLANSNAPSHOT_H
+
+#include "fs/pln/flightplan.h"
+
+#include <QSharedPointer>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace pln {
+
+/*
+ * Immutable copy of a flight plan for undo stacks and for passing to background computations.
+ *
+ * Entries are stored in chunks of up to MAX_CHUNK_SIZE entries which are shared between snapshots.
+ * A snapshot created from a modified plan and its previous snapshot shares all chunks at the start and end
+ * which are unchanged. The edit methods return a new snapshot which copies only the affected chunk.
+ * Thus an edit of a long plan costs a copy of one chunk instead of a copy of all entries.
+ *
+ * Snapshots can be copied and read from any thread.
+ */
+class FlightplanSnapshot
+{
+public:
+  /* Empty plan */
+  FlightplanSnapshot();
+
+  /* Copies all entries */
+  explicit FlightplanSnapshot(const atools::fs::pln::Flightplan& flightplan);
+
+  /* Shares unchanged leading and trailing chunks with previous and copies only the changed entries */
+  FlightplanSnapshot(const atools::fs::pln::Flightplan& flightplan,
+                     const atools::fs::pln::FlightplanSnapshot& previous);
+
+  /* Create a full flight plan */
+  atools::fs::pln::Flightplan toFlightplan() const;
+
+  /* Plan with all properties but without entries */
+  const atools::fs::pln::Flightplan& getHeader() const
+  {
+    return *header;
+  }
+
+  int size() const
+  {
+    return offsets.last();
+  }
+
+  bool isEmpty() const
+  {
+    return size() == 0;
+  }
+
+  const atools::fs::pln::FlightplanEntry& at(int index) const;
+
+  /* Replace entry at index */
+  FlightplanSnapshot withEntry(int index, const atools::fs::pln::FlightplanEntry& entry) const;
+
+  /* Insert entry before index. Appends if index is equal to size(). */
+  FlightplanSnapshot withInsertedEntry(int index, const atools::fs::pln::FlightplanEntry& entry) const;
+
+  FlightplanSnapshot withRemovedEntry(int index) const;
+
+  /* Replace all properties except entries by the ones of flightplan */
+  FlightplanSnapshot withHeader(const atools::fs::pln::Flightplan& flightplan) const;
+
+  /* Number of chunks which are shared with other. Useful for diagnostics. */
+  int getNumSharedChunks(const FlightplanSnapshot& other) const;
+
+  /* Chunks are split when exceeding this size */
+  static const int MAX_CHUNK_SIZE = 64;
+
+private:
+  typedef QVector<atools::fs::pln::FlightplanEntry> Chunk;
+  typedef QSharedPointer<const Chunk> ChunkPtr;
+
+  /* Append new chunks of half the maximum size for entries in range [from, to) */
+  void appendChunks(const atools::fs::pln::FlightplanEntryListType& entries, int from, int to);
+
+  /* Recalculate start index of all chunks */
+  void updateOffsets();
+
+  /* Index of chunk containing the entry at index */
+  int chunkIndex(int index) const;
+
+  static QSharedPointer<const atools::fs::pln::Flightplan> createHeader(const atools::fs::pln::Flightplan& flightplan);
+  static bool isChunkEqual(const Chunk& chunk, const atools::fs::pln::FlightplanEntryListType& entries, int from);
+
+  QSharedPointer<const atools::fs::pln::Flightplan> header;
+  QVector<ChunkPtr> chunks;
+
+  /* Start index of each chunk and the total size as last value */
+  QVector<int> offsets;
+};
+
+} // namespace pln
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FLIGHTPLANSNAPSHOT_H
@@ -20,6 +20,9 @@
 #include "fs/scenery/sceneryarea.h"
 
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 namespace atools {
 namespace fs {
@@ -37,17 +40,20 @@ void ProgressHandler::increaseCurrent(int increase)
 
 bool ProgressHandler::reportOtherMsg(const QString& otherAction)
 {
+  nextPhase(otherAction);
   info.otherAction = otherAction;
   info.newFile = false;
   info.newSceneryArea = false;
   info.newOther = true;
 
-  return callHandler();
+  return callHandler(false);
 }
 
 bool ProgressHandler::reportOther(const QString& otherAction, int current, bool silent)
 {
-  info.lastCurrent = info.current;
+  // Throttle repeated messages like for large X-Plane files
+  bool repeated = info.newOther && otherAction == info.otherAction;
+  nextPhase(otherAction);
   if(current != -1)
     info.current = current;
   else
@@ -61,12 +67,13 @@ bool ProgressHandler::reportOther(const QString& otherAction, int current, bool
   if(silent)
     return false;
   else
-    return callHandler();
+    return callHandler(repeated);
 }
 
 bool ProgressHandler::reportOtherInc(const QString& otherAction, int increment)
 {
-  info.lastCurrent = info.current;
+  bool repeated = info.newOther && otherAction == info.otherAction;
+  nextPhase(otherAction);
   info.current += increment;
   info.otherAction = otherAction;
 
@@ -74,34 +81,34 @@ bool ProgressHandler::reportOtherInc(const QString& otherAction, int increment)
   info.newSceneryArea = false;
   info.newOther = true;
 
-  return callHandler();
+  return callHandler(repeated);
 }
 
 void ProgressHandler::reportError()
 {
-  info.numErrors++;
+  counters.numErrors.fetch_add(1, std::memory_order_relaxed);
 }
 
 void ProgressHandler::reportErrors(int num)
 {
-  info.numErrors += num;
+  counters.numErrors.fetch_add(num, std::memory_order_relaxed);
 }
 
-bool ProgressHandler::reportBglFile(const QString& bglFilepath)
+bool ProgressHandler::reportBglFile(const QString& bglFilepath, int increment)
 {
-  info.lastCurrent = info.current;
-  info.current++;
+  info.current += increment;
   info.bglFilepath = bglFilepath;
 
   info.newFile = true;
   info.newSceneryArea = false;
   info.newOther = false;
 
-  return callHandler();
+  return callHandler(true);
 }
 
 bool ProgressHandler::reportFinish()
 {
+  nextPhase(QString());
   info.lastCall = true;
   info.newFile = false;
   info.newSceneryArea = false;
@@ -109,7 +116,7 @@ bool ProgressHandler::reportFinish()
 
   qDebug() << Q_FUNC_INFO << "info.current" << info.current;
 
-  return callHandler();
+  return callHandler(false);
 }
 
 void ProgressHandler::setTotal(int total)
@@ -119,7 +126,9 @@ void ProgressHandler::setTotal(int total)
 
 void ProgressHandler::reset()
 {
-  info.numErrors = 0;
+  counters.numErrors.store(0, std::memory_order_relaxed);
+  aborted.store(false, std::memory_order_relaxed);
+  reportTimer.invalidate();
   info.current = 0;
   info.lastCurrent = 0;
   info.sceneryArea = nullptr;
@@ -133,7 +142,7 @@ void ProgressHandler::reset()
 
 bool ProgressHandler::reportSceneryArea(const scenery::SceneryArea *sceneryArea)
 {
-  info.lastCurrent = info.current;
+  nextPhase(sceneryArea != nullptr ? QString("Scenery: %1").arg(sceneryArea->getTitle()) : QString());
   info.current++;
   info.sceneryArea = sceneryArea;
 
@@ -141,24 +150,121 @@ bool ProgressHandler::reportSceneryArea(const scenery::SceneryArea *sceneryArea)
   info.newSceneryArea = true;
   info.newOther = false;
 
-  return callHandler();
+  return callHandler(false);
+}
+
+void ProgressHandler::nextPhase(const QString& name)
+{
+  if(phaseTimer.isValid() && name == phaseName)
+    // Repeated progress messages like for large X-Plane files - continue phase
+    return;
+
+  qint64 rows = rowCount();
+
+  if(phaseTimer.isValid())
+  {
+    ProgressPhase phase;
+    phase.name = phaseName;
+    phase.timeMs = phaseTimer.nsecsElapsed() / 1000000.;
+    phase.rows = rows - phaseRows;
+    phase.bytesRead = counters.numBytesRead.load(std::memory_order_relaxed) - phaseBytesRead;
+    phases.append(phase);
+    phaseTimer.invalidate();
+  }
+
+  if(!name.isEmpty())
+  {
+    phaseName = name;
+    phaseRows = rows;
+    phaseBytesRead = counters.numBytesRead.load(std::memory_order_relaxed);
+    phaseTimer.start();
+  }
+}
+
+qint64 ProgressHandler::rowCount() const
+{
+  if(rowCountFunc)
+    return rowCountFunc();
+  else
+    return counters.numObjectsWritten.load(std::memory_order_relaxed);
 }
 
-bool ProgressHandler::callHandler()
+QString ProgressHandler::getPhaseTable() const
 {
-  bool retval = false;
+  QString table = QString("%1 %2 %3 %4\n").arg("Phase", -60).arg("Time ms", 12).arg("Rows", 12).arg("Bytes read", 14);
+
+  double totalTime = 0.;
+  qint64 totalRows = 0L, totalBytes = 0L;
+  for(const ProgressPhase& phase : phases)
+  {
+    table += QString("%1 %2 %3 %4\n").
+             arg(phase.name.left(60), -60).arg(phase.timeMs, 12, 'f', 1).arg(phase.rows, 12).arg(phase.bytesRead, 14);
+    totalTime += phase.timeMs;
+    totalRows += phase.rows;
+    totalBytes += phase.bytesRead;
+  }
+
+  table += QString("%1 %2 %3 %4\n").arg("Total", -60).arg(totalTime, 12, 'f', 1).arg(totalRows, 12).arg(totalBytes, 14);
+  return table;
+}
+
+QJsonDocument ProgressHandler::getPhaseJson() const
+{
+  QJsonArray array;
+  for(const ProgressPhase& phase : phases)
+  {
+    QJsonObject obj;
+    obj.insert("name", phase.name);
+    obj.insert("time_ms", phase.timeMs);
+    obj.insert("rows", static_cast<double>(phase.rows));
+    obj.insert("bytes_read", static_cast<double>(phase.bytesRead));
+    array.append(obj);
+  }
+
+  QJsonObject root;
+  root.insert("phases", array);
+  return QJsonDocument(root);
+}
+
+bool ProgressHandler::callHandler(bool throttle)
+{
+  if(throttle && reportIntervalMs > 0 && reportTimer.isValid() && reportTimer.elapsed() < reportIntervalMs)
+    // Keep state for the next report and do not format messages
+    return aborted.load(std::memory_order_relaxed);
+
+  reportTimer.start();
+  copyCounters();
 
   // Alway call default handler - this one cannot call cancel
   defaultHandler(info);
 
-  if(handler != nullptr)
-    // Call user handler
-    retval = handler(info);
+  // Call user handler
+  if(handler != nullptr && handler(info))
+    aborted.store(true, std::memory_order_relaxed);
 
   if(info.firstCall)
     info.firstCall = false;
 
-  return retval;
+  // Increment shown in the next message covers all throttled reports
+  info.lastCurrent = info.current;
+
+  return aborted.load(std::memory_order_relaxed);
+}
+
+void ProgressHandler::copyCounters()
+{
+  info.numFiles = counters.numFiles.load(std::memory_order_relaxed);
+  info.numAirports = counters.numAirports.load(std::memory_order_relaxed);
+  info.numNamelists = counters.numNamelists.load(std::memory_order_relaxed);
+  info.numVors = counters.numVors.load(std::memory_order_relaxed);
+  info.numIls = counters.numIls.load(std::memory_order_relaxed);
+  info.numNdbs = counters.numNdbs.load(std::memory_order_relaxed);
+  info.numMarker = counters.numMarker.load(std::memory_order_relaxed);
+  info.numBoundaries = counters.numBoundaries.load(std::memory_order_relaxed);
+  info.numWaypoints = counters.numWaypoints.load(std::memory_order_relaxed);
+  info.numObjectsWritten = counters.numObjectsWritten.load(std::memory_order_relaxed);
+  info.numErrors = counters.numErrors.load(std::memory_order_relaxed);
+  info.numBytesRead = counters.numBytesRead.load(std::memory_order_relaxed);
 }
 
 /*
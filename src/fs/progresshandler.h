@@ -21,14 +21,41 @@
 #include "fs/navdatabaseprogress.h"
 #include "fs/navdatabaseoptions.h"
 
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+class QJsonDocument;
+
 namespace atools {
 namespace fs {
 namespace scenery {
 class SceneryArea;
 }
 
+/*
+ * Profile of one compilation phase. A phase starts with a scenery area or other message and ends with the next one.
+ */
+struct ProgressPhase
+{
+  QString name;
+  double timeMs = 0.;
+  qint64 rows = 0L, bytesRead = 0L;
+};
+
 /*
  * Progress handler. Fills the NavDatabaseProgress object with information and calls the progress callback.
+ *
+ * Counters like number of airports, errors or bytes read are atomic and can be incremented cheaply from any thread.
+ * They are copied into the progress object only when the callback is called.
+ *
+ * Reports for BGL files and repeated reports for the same other action are throttled. The callback is called and
+ * the message is formatted at most once per report interval. Throttled calls only update the state and return
+ * the abort flag. Scenery areas, new actions and the finish report are always passed to the callback.
+ *
+ * Report methods, the current progress and the total have to be used from the compiling thread only.
  */
 class ProgressHandler
 {
@@ -41,9 +68,10 @@ public:
   bool reportSceneryArea(const atools::fs::scenery::SceneryArea *sceneryArea);
 
   /*
-   * Increment progress by one and send message about new BGL file
+   * Increment progress by increment and send message about new BGL file.
+   * Increment is larger than one if progress is weighted by file size.
    */
-  bool reportBglFile(const QString& bglFilepath);
+  bool reportBglFile(const QString& bglFilepath, int increment = 1);
 
   /*
    * Increase number of errors for BGL reading exceptions or scenery errors (directory not found or others).
@@ -78,107 +106,149 @@ public:
   /* Increase current progress counter without sending a message */
   void increaseCurrent(int increase);
 
+  /* Minimum time between two calls of the callback for throttled reports. 0 disables throttling. */
+  void setReportIntervalMs(int value)
+  {
+    reportIntervalMs = value;
+  }
+
+  /* Set the abort flag. Can be called from any thread. All following reports return true until reset() is called. */
+  void abort()
+  {
+    aborted.store(true, std::memory_order_relaxed);
+  }
+
+  /* true if the callback returned true once or abort() was called. Can be called from any thread. */
+  bool isAborted() const
+  {
+    return aborted.load(std::memory_order_relaxed);
+  }
+
+  static const int DEFAULT_REPORT_INTERVAL_MS = 50;
+
   /* Set current number of BGL files */
   void setNumFiles(int value)
   {
-    info.numFiles = value;
+    counters.numFiles.store(value, std::memory_order_relaxed);
   }
 
   void setNumAirports(int value)
   {
-    info.numAirports = value;
+    counters.numAirports.store(value, std::memory_order_relaxed);
   }
 
   void setNumNamelists(int value)
   {
-    info.numNamelists = value;
+    counters.numNamelists.store(value, std::memory_order_relaxed);
   }
 
   void setNumVors(int value)
   {
-    info.numVors = value;
+    counters.numVors.store(value, std::memory_order_relaxed);
   }
 
   void setNumIls(int value)
   {
-    info.numIls = value;
+    counters.numIls.store(value, std::memory_order_relaxed);
   }
 
   void setNumNdbs(int value)
   {
-    info.numNdbs = value;
+    counters.numNdbs.store(value, std::memory_order_relaxed);
   }
 
   void setNumMarker(int value)
   {
-    info.numMarker = value;
+    counters.numMarker.store(value, std::memory_order_relaxed);
   }
 
   void setNumBoundaries(int value)
   {
-    info.numBoundaries = value;
+    counters.numBoundaries.store(value, std::memory_order_relaxed);
   }
 
   void setNumWaypoints(int value)
   {
-    info.numWaypoints = value;
+    counters.numWaypoints.store(value, std::memory_order_relaxed);
   }
 
   void setNumObjectsWritten(int value)
   {
-    info.numObjectsWritten = value;
+    counters.numObjectsWritten.store(value, std::memory_order_relaxed);
   }
 
   void incNumFiles(int value = 1)
   {
-    info.numFiles += value;
+    counters.numFiles.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumAirports(int value = 1)
   {
-    info.numAirports += value;
+    counters.numAirports.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumNamelists(int value = 1)
   {
-    info.numNamelists += value;
+    counters.numNamelists.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumVors(int value = 1)
   {
-    info.numVors += value;
+    counters.numVors.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumIls(int value = 1)
   {
-    info.numIls += value;
+    counters.numIls.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumNdbs(int value = 1)
   {
-    info.numNdbs += value;
+    counters.numNdbs.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumMarker(int value = 1)
   {
-    info.numMarker += value;
+    counters.numMarker.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumBoundaries(int value = 1)
   {
-    info.numBoundaries += value;
+    counters.numBoundaries.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumWaypoints(int value = 1)
   {
-    info.numWaypoints += value;
+    counters.numWaypoints.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumObjectsWritten(int value = 1)
   {
-    info.numObjectsWritten += value;
+    counters.numObjectsWritten.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /* Add size of a scenery file read for profiling */
+  void incBytesRead(qint64 value)
+  {
+    counters.numBytesRead.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /* Function returning the total number of rows changed in the database so far. Used to profile phases. */
+  void setRowCountFunc(const std::function<qint64()>& func)
+  {
+    rowCountFunc = func;
   }
 
+  /* Time, rows and bytes read for all finished phases in order of execution */
+  const QVector<atools::fs::ProgressPhase>& getPhases() const
+  {
+    return phases;
+  }
+
+  /* Phases as text table with a total line and as JSON document */
+  QString getPhaseTable() const;
+  QJsonDocument getPhaseJson() const;
+
 private:
   void defaultHandler(const atools::fs::NavDatabaseProgress& inf);
 
@@ -186,7 +256,36 @@ private:
 
   atools::fs::NavDatabaseProgress info;
 
-  bool callHandler();
+  /* Call callback if not throttled. Returns the abort flag. */
+  bool callHandler(bool throttle);
+
+  /* Copy atomic counters into info */
+  void copyCounters();
+
+  /* Counters which can be increased from any thread */
+  struct Counters
+  {
+    std::atomic<int> numFiles{0}, numAirports{0}, numNamelists{0}, numVors{0}, numIls{0}, numNdbs{0},
+                     numMarker{0}, numBoundaries{0}, numWaypoints{0}, numObjectsWritten{0}, numErrors{0};
+    std::atomic<qint64> numBytesRead{0};
+  };
+  Counters counters;
+
+  std::atomic<bool> aborted{false};
+
+  /* Time since last call of the callback */
+  QElapsedTimer reportTimer;
+  int reportIntervalMs = DEFAULT_REPORT_INTERVAL_MS;
+
+  /* Finish current phase if any and start a new one if name is not empty */
+  void nextPhase(const QString& name);
+  qint64 rowCount() const;
+
+  std::function<qint64()> rowCountFunc;
+  QVector<atools::fs::ProgressPhase> phases;
+  QElapsedTimer phaseTimer;
+  QString phaseName;
+  qint64 phaseRows = 0L, phaseBytesRead = 0L;
 
   static QString numbersAsString(const atools::fs::NavDatabaseProgress& inf);
 
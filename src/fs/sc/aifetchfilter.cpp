@@ -0,0 +1,132 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/sc/aifetchfilter.h"
+
+#include "geo/calculations.h"
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+void AiFetchFilter::setPolicy(const AiFetchPolicy& value)
+{
+  policy = value;
+  nearDistanceMeter = atools::geo::nmToMeter(policy.nearDistanceNm);
+  positionOnlyDistanceMeter = atools::geo::nmToMeter(policy.positionOnlyDistanceNm);
+
+  // Force full update with new policy
+  lastAircraft.clear();
+  curAircraft.clear();
+}
+
+void AiFetchFilter::startFetch(const atools::geo::Pos& userPosition)
+{
+  user = userPosition;
+  cycle++;
+  curAircraft.clear();
+}
+
+AiDetail AiFetchFilter::getDetail(unsigned int objectId, const atools::geo::Pos& pos) const
+{
+  if(!policy.isActive())
+    return AI_FULL;
+
+  if(policy.viewport.isValid() && !policy.viewport.contains(pos))
+    return AI_SKIP;
+
+  if(!user.isValid() || !pos.isValid() || (nearDistanceMeter <= 0.f && positionOnlyDistanceMeter <= 0.f))
+    return AI_FULL;
+
+  float distMeter = user.distanceMeterTo(pos);
+
+  if(nearDistanceMeter > 0.f && distMeter > nearDistanceMeter && policy.farUpdateInterval > 1 &&
+     (cycle + objectId) % static_cast<quint32>(policy.farUpdateInterval) != 0)
+    return AI_LAST;
+
+  if(positionOnlyDistanceMeter > 0.f && distMeter > positionOnlyDistanceMeter)
+    return AI_POSITION;
+
+  return AI_FULL;
+}
+
+const SimConnectAircraft *AiFetchFilter::getLastAircraft(unsigned int objectId) const
+{
+  QHash<unsigned int, SimConnectAircraft>::const_iterator it = lastAircraft.constFind(objectId);
+  return it != lastAircraft.constEnd() ? &it.value() : nullptr;
+}
+
+void AiFetchFilter::addAircraft(const SimConnectAircraft& aircraft)
+{
+  if(policy.nearDistanceNm > 0.f)
+    // Remember only if needed for far objects
+    curAircraft.insert(aircraft.getObjectId(), aircraft);
+}
+
+void AiFetchFilter::finishFetch()
+{
+  lastAircraft.swap(curAircraft);
+  curAircraft.clear();
+}
+
+void AiFetchFilter::filter(QVector<SimConnectAircraft>& aircraft, const atools::geo::Pos& userPosition)
+{
+  if(!policy.isActive())
+    return;
+
+  startFetch(userPosition);
+
+  int num = 0;
+  for(int i = 0; i < aircraft.size(); i++)
+  {
+    const SimConnectAircraft& ac = aircraft.at(i);
+    AiDetail detail = getDetail(ac.getObjectId(), ac.getPosition());
+    if(detail == AI_SKIP)
+      continue;
+
+    const SimConnectAircraft *last = detail == AI_LAST ? getLastAircraft(ac.getObjectId()) : nullptr;
+    if(last != nullptr)
+      aircraft[num] = *last;
+    else
+    {
+      if(num != i)
+        aircraft[num] = ac;
+
+      if(detail == AI_POSITION)
+        reduceToPosition(aircraft[num]);
+    }
+
+    addAircraft(aircraft.at(num));
+    num++;
+  }
+  aircraft.resize(num);
+
+  finishFetch();
+}
+
+void AiFetchFilter::reduceToPosition(SimConnectAircraft& aircraft)
+{
+  // Keeps only the type
+  SimConnectAircraftNames names;
+  names.airplaneType = aircraft.names->airplaneType;
+  aircraft.setNames(names);
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
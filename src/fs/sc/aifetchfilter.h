@@ -0,0 +1,118 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_SC_AIFETCHFILTER_H
+#define ATOOLS_FS_SC_AIFETCHFILTER_H
+
+#include "fs/sc/simconnectaircraft.h"
+#include "geo/rect.h"
+
+#include <QHash>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+/* Level of detail policy for AI aircraft and ships. Default values disable all filtering. */
+struct AiFetchPolicy
+{
+  /* Only objects inside this rectangle are passed if valid. Usually the client's viewport with a margin. */
+  atools::geo::Rect viewport;
+
+  /* Objects farther away from the user aircraft are updated only every farUpdateInterval fetches.
+   * The last state is sent in between. 0 disables distance bands. */
+  float nearDistanceNm = 0.f;
+  int farUpdateInterval = 4;
+
+  /* Objects farther away than this get only type, position, heading and speeds. Names and
+   * departure/destination are cleared. 0 disables. */
+  float positionOnlyDistanceNm = 0.f;
+
+  bool isActive() const
+  {
+    return viewport.isValid() || nearDistanceNm > 0.f || positionOnlyDistanceNm > 0.f;
+  }
+};
+
+/* Detail level for an AI object in one fetch */
+enum AiDetail
+{
+  AI_SKIP, /* Filtered out */
+  AI_LAST, /* Reuse state from last fetch if available */
+  AI_POSITION, /* Convert but reduce to position fields */
+  AI_FULL /* Convert all fields */
+};
+
+/*
+ * Applies an AiFetchPolicy while converting AI objects in connect handlers.
+ * Keeps the last state of each object to allow reduced update frequency for far objects.
+ *
+ * Call startFetch(), then getDetail() and addAircraft() for each object and finally finishFetch().
+ */
+class AiFetchFilter
+{
+public:
+  void setPolicy(const atools::fs::sc::AiFetchPolicy& value);
+
+  const atools::fs::sc::AiFetchPolicy& getPolicy() const
+  {
+    return policy;
+  }
+
+  bool isActive() const
+  {
+    return policy.isActive();
+  }
+
+  /* Start a new fetch cycle. Distance bands are disabled if user position is not valid. */
+  void startFetch(const atools::geo::Pos& userPosition);
+
+  /* Get detail for the object with the given id and position in the current cycle */
+  atools::fs::sc::AiDetail getDetail(unsigned int objectId, const atools::geo::Pos& pos) const;
+
+  /* Get state from last cycle or null if not available */
+  const atools::fs::sc::SimConnectAircraft *getLastAircraft(unsigned int objectId) const;
+
+  /* Remember object state for the next cycles */
+  void addAircraft(const atools::fs::sc::SimConnectAircraft& aircraft);
+
+  /* Drops state of objects which were not added in this cycle */
+  void finishFetch();
+
+  /* Filter an already converted list in place. Used for handlers which get the complete list. */
+  void filter(QVector<atools::fs::sc::SimConnectAircraft>& aircraft, const atools::geo::Pos& userPosition);
+
+  /* Clear all fields except type, position, heading and speeds */
+  static void reduceToPosition(atools::fs::sc::SimConnectAircraft& aircraft);
+
+private:
+  atools::fs::sc::AiFetchPolicy policy;
+  atools::geo::Pos user;
+  float nearDistanceMeter = 0.f, positionOnlyDistanceMeter = 0.f;
+
+  /* Objects are updated if (cycle + objectId) % farUpdateInterval is null to spread the load */
+  quint32 cycle = 0;
+
+  QHash<unsigned int, atools::fs::sc::SimConnectAircraft> lastAircraft, curAircraft;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_AIFETCHFILTER_H
@@ -17,6 +17,8 @@
 
 #include "fs/sc/connecthandler.h"
 
+#include <QThread>
+
 namespace atools {
 namespace fs {
 namespace sc {
@@ -31,6 +33,17 @@ ConnectHandler::~ConnectHandler()
   qDebug() << Q_FUNC_INFO;
 }
 
+bool ConnectHandler::waitForData(unsigned long timeoutMs)
+{
+  QThread::msleep(timeoutMs);
+  return true;
+}
+
+void ConnectHandler::setAiFetchPolicy(const AiFetchPolicy& policy)
+{
+  Q_UNUSED(policy);
+}
+
 } // namespace sc
 } // namespace fs
 } // namespace atools
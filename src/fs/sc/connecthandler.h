@@ -26,6 +26,7 @@ namespace sc {
 
 class SimConnectData;
 class WeatherRequest;
+struct AiFetchPolicy;
 
 /* Status of the last operation when fetching data. */
 enum State
@@ -70,6 +71,14 @@ public:
   /* Get state of last call. */
   virtual sc::State getState() const = 0;
 
+  /* Block until the simulator signals new data or timeoutMs elapsed.
+   * Returns true if new data is available. The default implementation sleeps for the whole timeout and returns
+   * true which results in polling. */
+  virtual bool waitForData(unsigned long timeoutMs);
+
+  /* Set filter and level of detail for AI objects. Default implementation ignores the policy. */
+  virtual void setAiFetchPolicy(const atools::fs::sc::AiFetchPolicy& policy);
+
   /* Name which can be used when saving options */
   virtual QString getName() const = 0;
 
@@ -17,6 +17,8 @@
 
 #include "fs/sc/datareaderthread.h"
 
+#include "fs/sc/replayfile.h"
+#include "fs/sc/simconnectdatachannel.h"
 #include "fs/sc/simconnecthandler.h"
 #include "fs/sc/xpconnecthandler.h"
 #include "settings/settings.h"
@@ -38,6 +40,8 @@ DataReaderThread::DataReaderThread(QObject *parent, bool verboseLog)
   setObjectName("DataReaderThread");
 
   options = atools::fs::sc::FETCH_AI_AIRCRAFT | atools::fs::sc::FETCH_AI_BOAT;
+  replaySeekMs = -1;
+  replayDurationMs = 0;
 }
 
 DataReaderThread::~DataReaderThread()
@@ -102,7 +106,7 @@ void DataReaderThread::run()
 
   // Try to connect first ============================================
 
-  if(loadReplayFile == nullptr)
+  if(loadReplayFile == nullptr && loadReplay == nullptr)
     // Connect to the simulator
     connectToSimulator();
   else
@@ -114,14 +118,32 @@ void DataReaderThread::run()
   waitMutex.lock();
 
   // Main loop  ============================================
+  QElapsedTimer fetchTimer;
   while(!terminate)
   {
+    fetchTimer.start();
     atools::fs::sc::SimConnectData data;
     atools::fs::sc::Options opts = options;
 
-    if(loadReplayFile != nullptr)
+    if(loadReplay != nullptr)
     {
-      // Do replay ============================================
+      // Do indexed replay ============================================
+      if(readReplayFrame(data))
+      {
+        filterReplayAircraft(data, opts);
+        postData(data);
+      }
+      else
+      {
+        emit postStatus(data.getStatus(), loadReplay->getErrorString());
+        emit postLogMessage(tr("Error reading \"%1\": %2.").
+                            arg(loadReplayFilepath).arg(loadReplay->getErrorString()), false, true);
+        closeReplay();
+      }
+    }
+    else if(loadReplayFile != nullptr)
+    {
+      // Do legacy replay ============================================
       data.read(loadReplayFile);
 
       if(data.getStatus() == OK)
@@ -129,31 +151,8 @@ void DataReaderThread::run()
         if(loadReplayFile->atEnd())
           loadReplayFile->seek(REPLAY_FILE_DATA_START_OFFSET);
 
-        // Remove boat and ship traffic depending on settings for testing purposes
-        QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
-        if(!(opts & atools::fs::sc::FETCH_AI_AIRCRAFT))
-        {
-          QVector<SimConnectAircraft>::iterator it =
-            std::remove_if(aiAircraft.begin(), aiAircraft.end(), [](const SimConnectAircraft& aircraft) -> bool
-                {
-                  return !aircraft.isUser() && !aircraft.isAnyBoat();
-                });
-          if(it != aiAircraft.end())
-            aiAircraft.erase(it, aiAircraft.end());
-        }
-
-        if(!(opts & atools::fs::sc::FETCH_AI_BOAT))
-        {
-          QVector<SimConnectAircraft>::iterator it =
-            std::remove_if(aiAircraft.begin(), aiAircraft.end(), [](const SimConnectAircraft& aircraft) -> bool
-                {
-                  return !aircraft.isUser() && aircraft.isAnyBoat();
-                });
-          if(it != aiAircraft.end())
-            aiAircraft.erase(it, aiAircraft.end());
-        }
-
-        emit postSimConnectData(data);
+        filterReplayAircraft(data, opts);
+        postData(data);
       }
       else
       {
@@ -169,11 +168,11 @@ void DataReaderThread::run()
       if(verbose && !data.getMetars().isEmpty())
         qDebug() << "DataReaderThread::run() num metars" << data.getMetars().size();
 
-      emit postSimConnectData(data);
+      postData(data);
 
-      if(saveReplayFile != nullptr && saveReplayFile->isOpen() && data.getPacketId() > 0)
+      if(saveReplay != nullptr && data.getPacketId() > 0)
         // Save only simulator packets, not weather replays
-        data.write(saveReplayFile);
+        saveReplay->addFrame(data);
     }
     else
     {
@@ -228,8 +227,17 @@ void DataReaderThread::run()
       // qWarning() << "No data fetched";
     }
 
+    if(eventDriven && loadReplayFile == nullptr && loadReplay == nullptr && handler->isLoaded())
+    {
+      waitForSimulator(fetchTimer);
+      continue;
+    }
+
     unsigned long sleepMs = 500;
-    if(loadReplayFile != nullptr)
+    if(loadReplay != nullptr)
+      // Speed is applied by advancing the replay time
+      sleepMs = replayUpdateRateMs;
+    else if(loadReplayFile != nullptr)
       sleepMs = static_cast<unsigned long>(static_cast<float>(replayUpdateRateMs) /
                                            static_cast<float>(replaySpeed));
     else
@@ -253,6 +261,31 @@ void DataReaderThread::run()
   qDebug() << Q_FUNC_INFO << "leave";
 }
 
+void DataReaderThread::waitForSimulator(const QElapsedTimer& fetchTimer)
+{
+  // Rate limiting - wait for the remaining interval or until woken up by a weather request
+  qint64 remainingMs = static_cast<qint64>(updateRate) - fetchTimer.elapsed();
+  if(remainingMs > 0 && waitCondition.wait(&waitMutex, static_cast<unsigned long>(remainingMs)))
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "wakeUpSignalled";
+    return;
+  }
+
+  // Wait for new data from simulator
+  qint64 maxWaitMs = std::max(MAX_EVENT_WAIT_MS, static_cast<qint64>(updateRate));
+  while(!terminate && fetchTimer.elapsed() < maxWaitMs)
+  {
+    QMutexLocker locker(&handlerMutex);
+    if(handler->getWeatherRequest().isValid())
+      break;
+
+    qint64 sliceMs = std::min(EVENT_WAIT_SLICE_MS, maxWaitMs - fetchTimer.elapsed());
+    if(sliceMs <= 0 || handler->waitForData(static_cast<unsigned long>(sliceMs)))
+      break;
+  }
+}
+
 bool DataReaderThread::fetchData(atools::fs::sc::SimConnectData& data, int radiusKm, Options options)
 {
   if(verbose)
@@ -306,9 +339,74 @@ bool DataReaderThread::fetchData(atools::fs::sc::SimConnectData& data, int radiu
   return retval;
 }
 
+void DataReaderThread::filterReplayAircraft(atools::fs::sc::SimConnectData& data, atools::fs::sc::Options opts)
+{
+  QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
+  if(!(opts & atools::fs::sc::FETCH_AI_AIRCRAFT))
+  {
+    QVector<SimConnectAircraft>::iterator it =
+      std::remove_if(aiAircraft.begin(), aiAircraft.end(), [](const SimConnectAircraft& aircraft) -> bool
+          {
+            return !aircraft.isUser() && !aircraft.isAnyBoat();
+          });
+    if(it != aiAircraft.end())
+      aiAircraft.erase(it, aiAircraft.end());
+  }
+
+  if(!(opts & atools::fs::sc::FETCH_AI_BOAT))
+  {
+    QVector<SimConnectAircraft>::iterator it =
+      std::remove_if(aiAircraft.begin(), aiAircraft.end(), [](const SimConnectAircraft& aircraft) -> bool
+          {
+            return !aircraft.isUser() && aircraft.isAnyBoat();
+          });
+    if(it != aiAircraft.end())
+      aiAircraft.erase(it, aiAircraft.end());
+  }
+}
+
+bool DataReaderThread::readReplayFrame(atools::fs::sc::SimConnectData& data)
+{
+  qint64 durationMs = loadReplay->getDurationMs();
+
+  qint64 seekMs = replaySeekMs.exchange(-1);
+  if(seekMs >= 0)
+    replayTimeMs = std::min(seekMs, durationMs);
+  else
+  {
+    // Advance and loop at the end or the start
+    qint64 stepMs = static_cast<qint64>(replayUpdateRateMs) * replaySpeed;
+    replayTimeMs += replayReverse ? -stepMs : stepMs;
+    if(replayTimeMs > durationMs)
+      replayTimeMs = 0;
+    else if(replayTimeMs < 0)
+      replayTimeMs = durationMs;
+  }
+
+  return loadReplay->readFrame(data, replayTimeMs);
+}
+
 void DataReaderThread::setupReplay()
 {
-  if(!loadReplayFilepath.isEmpty())
+  if(!loadReplayFilepath.isEmpty() && ReplayFile::getFileVersion(loadReplayFilepath) == ReplayFile::FILE_VERSION)
+  {
+    loadReplay = new ReplayFile;
+    if(!loadReplay->open(loadReplayFilepath))
+    {
+      emit postLogMessage(tr("Cannot open \"%1\": %2.").
+                          arg(loadReplayFilepath).arg(loadReplay->getErrorString()), false, true);
+      closeReplay();
+      return;
+    }
+
+    replayUpdateRateMs = loadReplay->getUpdateRateMs();
+    replayTimeMs = replayReverse ? loadReplay->getDurationMs() : 0;
+    replayDurationMs = loadReplay->getDurationMs();
+
+    emit postLogMessage(tr("Replaying from \"%1\".").arg(loadReplayFilepath), false, false);
+    emit connectedToSimulator();
+  }
+  else if(!loadReplayFilepath.isEmpty())
   {
     loadReplayFile = new QFile(loadReplayFilepath);
 
@@ -356,32 +454,28 @@ void DataReaderThread::setupReplay()
   }
   else if(!saveReplayFilepath.isEmpty())
   {
-    saveReplayFile = new QFile(saveReplayFilepath);
-    if(!saveReplayFile->open(QIODevice::WriteOnly))
+    saveReplay = new ReplayFile;
+    if(!saveReplay->create(saveReplayFilepath, updateRate))
     {
-      emit postLogMessage(tr("Cannot open \"%1\".").arg(saveReplayFilepath), false, true);
-      delete saveReplayFile;
-      saveReplayFile = nullptr;
+      emit postLogMessage(tr("Cannot open \"%1\": %2.").
+                          arg(saveReplayFilepath).arg(saveReplay->getErrorString()), false, true);
+      delete saveReplay;
+      saveReplay = nullptr;
     }
     else
-    {
       emit postLogMessage(tr("Saving replay to \"%1\".").arg(saveReplayFilepath), false, false);
-
-      // Save file header
-      QDataStream out(saveReplayFile);
-      out << REPLAY_FILE_MAGIC_NUMBER << REPLAY_FILE_VERSION << static_cast<quint32>(updateRate);
-    }
   }
 }
 
 void DataReaderThread::closeReplay()
 {
-  if(saveReplayFile != nullptr)
-  {
-    saveReplayFile->close();
-    delete saveReplayFile;
-    saveReplayFile = nullptr;
-  }
+  // Writes index on close
+  delete saveReplay;
+  saveReplay = nullptr;
+
+  delete loadReplay;
+  loadReplay = nullptr;
+  replayDurationMs = 0;
 
   if(loadReplayFile != nullptr)
   {
@@ -419,10 +513,10 @@ void DataReaderThread::setWeatherRequest(atools::fs::sc::WeatherRequest request)
   if(!canFetchWeather())
     return;
 
-  if(saveReplayFile != nullptr)
+  if(saveReplay != nullptr)
   {
     // Post a dummy weather reply if replaying, do not pass to handler
-    emit postSimConnectData(atools::fs::sc::SimConnectData());
+    postData(atools::fs::sc::SimConnectData());
     return;
   }
 
@@ -434,9 +528,39 @@ void DataReaderThread::setWeatherRequest(atools::fs::sc::WeatherRequest request)
   waitCondition.wakeAll();
 }
 
+void DataReaderThread::setAiFetchPolicy(const AiFetchPolicy& policy)
+{
+  QMutexLocker locker(&handlerMutex);
+  if(handler != nullptr)
+    handler->setAiFetchPolicy(policy);
+}
+
+void DataReaderThread::addChannel(SimConnectDataChannel *channel)
+{
+  QMutexLocker locker(&channelsMutex);
+  if(!channels.contains(channel))
+    channels.append(channel);
+}
+
+void DataReaderThread::removeChannel(SimConnectDataChannel *channel)
+{
+  QMutexLocker locker(&channelsMutex);
+  channels.removeAll(channel);
+}
+
+void DataReaderThread::postData(const SimConnectData& data)
+{
+  emit postSimConnectData(data);
+
+  QMutexLocker locker(&channelsMutex);
+  for(SimConnectDataChannel *channel : channels)
+    channel->publish(data);
+}
+
 void DataReaderThread::terminateThread()
 {
   setTerminate(true);
+  waitCondition.wakeAll();
   wait();
   setTerminate(false);
 }
@@ -18,13 +18,17 @@
 #ifndef LITTLENAVCONNECT_DATAREADERTHREAD_H
 #define LITTLENAVCONNECT_DATAREADERTHREAD_H
 
+#include "fs/sc/aifetchfilter.h"
 #include "fs/sc/simconnectdata.h"
 #include "fs/sc/simconnectreply.h"
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
 #include <QWaitCondition>
 
+#include <atomic>
+
 class QFile;
 
 namespace atools {
@@ -32,6 +36,8 @@ namespace fs {
 namespace sc {
 
 class ConnectHandler;
+class ReplayFile;
+class SimConnectDataChannel;
 
 /* Actively reads flight simulator data using the simconnect interface in background and sends a
  * signal for each data package. */
@@ -61,6 +67,13 @@ public:
     updateRate = updateRateMs;
   }
 
+  /* Wait for new data signalled by the simulator instead of polling. The update rate is used as the minimum
+   * interval between packets in this mode. Has to be set before starting the thread. */
+  void setEventDriven(bool value)
+  {
+    eventDriven = value;
+  }
+
   /* If simulator connection is lost try to reconnect every reconnectSec seconds. */
   void setReconnectRateSec(int reconnectSec)
   {
@@ -94,6 +107,24 @@ public:
     replaySpeed = std::max(1, value);
   }
 
+  /* Play indexed replay files backwards */
+  void setReplayReverse(bool value)
+  {
+    replayReverse = value;
+  }
+
+  /* Jump to position in milliseconds for indexed replay files on next iteration. Thread safe. */
+  void seekReplay(qint64 timeMs)
+  {
+    replaySeekMs = timeMs;
+  }
+
+  /* Duration of indexed replay file in milliseconds or 0 if not available */
+  qint64 getReplayDurationMs() const
+  {
+    return replayDurationMs;
+  }
+
   void closeReplay();
 
   bool isSimconnectAvailable() const;
@@ -113,6 +144,9 @@ public:
     aiFetchRadiusKm = radiusKm;
   }
 
+  /* Filter and level of detail for AI objects. Applied in the handler on the next fetch. Thread safe. */
+  void setAiFetchPolicy(const atools::fs::sc::AiFetchPolicy& policy);
+
   /* What type of handler is set now */
   bool isFsxHandler();
   bool isXplaneHandler();
@@ -122,6 +156,11 @@ public:
     return handler;
   }
 
+  /* Register a latest value channel which receives all data packets in addition to the signal
+   * postSimConnectData. Channel is not owned. Thread safe. */
+  void addChannel(atools::fs::sc::SimConnectDataChannel *channel);
+  void removeChannel(atools::fs::sc::SimConnectDataChannel *channel);
+
 signals:
   /* Send on each received data package from the simconnect interface */
   void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
@@ -142,8 +181,21 @@ private:
   void connectToSimulator();
   virtual void run() override;
   void setupReplay();
+
+  /* Remove boat and ship traffic depending on settings for testing purposes */
+  void filterReplayAircraft(atools::fs::sc::SimConnectData& data, atools::fs::sc::Options opts);
+
+  /* Read next frame from indexed replay file depending on speed and direction */
+  bool readReplayFrame(atools::fs::sc::SimConnectData& data);
   bool fetchData(atools::fs::sc::SimConnectData& data, int radiusKm, atools::fs::sc::Options options);
 
+  /* Emit signal and publish to all channels */
+  void postData(const atools::fs::sc::SimConnectData& data);
+
+  /* Wait for the remaining update interval and then for the simulator to signal new data.
+   * Returns early for weather requests or termination. fetchTimer is started before each fetch. */
+  void waitForSimulator(const QElapsedTimer& fetchTimer);
+
   atools::fs::sc::ConnectHandler *handler = nullptr;
 
   /* Have to protect options since they will be modified from outside the thread */
@@ -157,17 +209,31 @@ private:
   int numErrors = 0;
   const int MAX_NUMBER_OF_ERRORS = 50;
 
+  /* Send a packet at least this often in event driven mode even if the simulator does not signal new data */
+  const qint64 MAX_EVENT_WAIT_MS = 1000;
+
+  /* Wait for the simulator in slices of this to allow weather requests and termination */
+  const qint64 EVENT_WAIT_SLICE_MS = 50;
+
   const quint32 REPLAY_FILE_MAGIC_NUMBER = 0XCACF4F27;
+
+  /* Legacy format which is a plain sequence of data blocks. Only used for reading. */
   const quint32 REPLAY_FILE_VERSION = 1;
   const int REPLAY_FILE_DATA_START_OFFSET = sizeof(REPLAY_FILE_MAGIC_NUMBER) + sizeof(REPLAY_FILE_VERSION) +
                                             sizeof(quint32);
 
   QString saveReplayFilepath, loadReplayFilepath;
   int replaySpeed = 1;
-  QFile *saveReplayFile = nullptr, *loadReplayFile = nullptr;
+  bool replayReverse = false;
+  QFile *loadReplayFile = nullptr;
   quint32 replayUpdateRateMs = 500;
 
-  bool terminate = false, verbose = false;
+  /* Indexed replay files for writing and reading */
+  ReplayFile *saveReplay = nullptr, *loadReplay = nullptr;
+  qint64 replayTimeMs = 0;
+  std::atomic<qint64> replaySeekMs, replayDurationMs;
+
+  bool terminate = false, verbose = false, eventDriven = false;
   unsigned int updateRate = 500;
   int reconnectRateSec = 10;
   bool connected = false, reconnecting = false;
@@ -178,6 +244,10 @@ private:
   /* Needed to lock for any modifications of the handler's data (weather) */
   mutable QMutex handlerMutex;
 
+  /* Registered consumer channels */
+  QVector<atools::fs::sc::SimConnectDataChannel *> channels;
+  mutable QMutex channelsMutex;
+
   /* Threads waits on this for each iteration - used to wake up early for weather requests */
   mutable QMutex waitMutex;
   mutable QWaitCondition waitCondition;
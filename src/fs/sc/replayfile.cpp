@@ -0,0 +1,368 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/sc/replayfile.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+static const quint32 CHUNK_MAGIC_NUMBER = 0x52504348;
+static const quint32 INDEX_MAGIC_NUMBER = 0x52504958;
+static const quint32 TRAILER_MAGIC_NUMBER = 0x52505452;
+
+/* Chunk header: magic, number of frames, start and end time and compressed size */
+static const int CHUNK_HEADER_SIZE = 4 + 4 + 8 + 8 + 4;
+
+/* Trailer at end of file: index offset and magic */
+static const int TRAILER_SIZE = 8 + 4;
+
+/* Close chunk when any of these is exceeded */
+static const int CHUNK_MAX_FRAMES = 120;
+static const int CHUNK_MAX_BYTES = 1024 * 1024;
+
+ReplayFile::ReplayFile()
+{
+  // Chunks are compressed as a whole
+  codec.setCompression(false);
+}
+
+ReplayFile::~ReplayFile()
+{
+  close();
+}
+
+bool ReplayFile::create(const QString& filepath, quint32 updateRateMs)
+{
+  close();
+
+  file = new QFile(filepath);
+  if(!file->open(QIODevice::WriteOnly))
+  {
+    errorString = file->errorString();
+    delete file;
+    file = nullptr;
+    return false;
+  }
+
+  writing = true;
+  updateRate = updateRateMs;
+  chunks.clear();
+  chunkData.clear();
+  chunkFrames = 0;
+  chunkStartMs = lastFrameMs = 0;
+  codec.reset();
+
+  QDataStream out(file);
+  out << FILE_MAGIC_NUMBER << FILE_VERSION << updateRate;
+
+  timer.start();
+  return true;
+}
+
+bool ReplayFile::open(const QString& filepath)
+{
+  close();
+
+  file = new QFile(filepath);
+  if(!file->open(QIODevice::ReadOnly))
+  {
+    errorString = file->errorString();
+    delete file;
+    file = nullptr;
+    return false;
+  }
+
+  writing = false;
+  chunks.clear();
+  loadedChunk = -1;
+
+  QDataStream in(file);
+  quint32 magicNumber = 0, version = 0;
+  in >> magicNumber >> version >> updateRate;
+
+  if(magicNumber != FILE_MAGIC_NUMBER || version != FILE_VERSION)
+    errorString = QObject::tr("Not a replay file or wrong version");
+  else if(!readIndex() && !scanChunks())
+    errorString = QObject::tr("No data found");
+  else
+    return true;
+
+  close();
+  return false;
+}
+
+void ReplayFile::close()
+{
+  if(file == nullptr)
+    return;
+
+  if(writing)
+  {
+    writeChunk();
+    writeIndex();
+  }
+
+  file->close();
+  delete file;
+  file = nullptr;
+  writing = false;
+
+  loadedChunk = -1;
+  frames.clear();
+  frameTimes.clear();
+}
+
+bool ReplayFile::isOpen() const
+{
+  return file != nullptr;
+}
+
+void ReplayFile::addFrame(const SimConnectData& data)
+{
+  if(file == nullptr || !writing)
+    return;
+
+  qint64 timeMs = timer.elapsed();
+  if(chunkFrames == 0)
+  {
+    // Start every chunk with a keyframe
+    codec.reset();
+    chunkStartMs = timeMs;
+  }
+
+  QDataStream out(&chunkData, QIODevice::WriteOnly | QIODevice::Append);
+  QByteArray block = data.writeToBlock(codec);
+  out << static_cast<quint32>(timeMs - chunkStartMs);
+  out.writeRawData(block.constData(), block.size());
+
+  lastFrameMs = timeMs;
+  chunkFrames++;
+
+  if(chunkFrames >= CHUNK_MAX_FRAMES || chunkData.size() >= CHUNK_MAX_BYTES)
+    writeChunk();
+}
+
+void ReplayFile::writeChunk()
+{
+  if(chunkFrames == 0)
+    return;
+
+  QByteArray compressed = qCompress(chunkData);
+
+  Chunk chunk;
+  chunk.startMs = chunkStartMs;
+  chunk.endMs = lastFrameMs;
+  chunk.offset = file->pos();
+  chunk.numFrames = chunkFrames;
+
+  QDataStream out(file);
+  out << CHUNK_MAGIC_NUMBER << static_cast<quint32>(chunk.numFrames) << chunk.startMs << chunk.endMs
+      << static_cast<quint32>(compressed.size());
+  out.writeRawData(compressed.constData(), compressed.size());
+
+  chunks.append(chunk);
+  chunkData.clear();
+  chunkFrames = 0;
+}
+
+void ReplayFile::writeIndex()
+{
+  qint64 indexOffset = file->pos();
+
+  QDataStream out(file);
+  out << INDEX_MAGIC_NUMBER << static_cast<quint32>(chunks.size());
+  for(const Chunk& chunk : chunks)
+    out << chunk.startMs << chunk.endMs << chunk.offset << static_cast<quint32>(chunk.numFrames);
+
+  out << indexOffset << TRAILER_MAGIC_NUMBER;
+}
+
+bool ReplayFile::readIndex()
+{
+  if(file->size() < FILE_HEADER_SIZE + TRAILER_SIZE)
+    return false;
+
+  QDataStream in(file);
+  file->seek(file->size() - TRAILER_SIZE);
+
+  qint64 indexOffset = 0;
+  quint32 magicNumber = 0;
+  in >> indexOffset >> magicNumber;
+  if(magicNumber != TRAILER_MAGIC_NUMBER || indexOffset < FILE_HEADER_SIZE || indexOffset >= file->size())
+    return false;
+
+  file->seek(indexOffset);
+  quint32 numChunks = 0;
+  in >> magicNumber >> numChunks;
+  if(magicNumber != INDEX_MAGIC_NUMBER)
+    return false;
+
+  chunks.clear();
+  for(quint32 i = 0; i < numChunks && in.status() == QDataStream::Ok; i++)
+  {
+    Chunk chunk;
+    quint32 numFrames;
+    in >> chunk.startMs >> chunk.endMs >> chunk.offset >> numFrames;
+    chunk.numFrames = static_cast<int>(numFrames);
+    chunks.append(chunk);
+  }
+
+  if(in.status() != QDataStream::Ok)
+  {
+    chunks.clear();
+    return false;
+  }
+  return !chunks.isEmpty();
+}
+
+bool ReplayFile::scanChunks()
+{
+  qWarning() << Q_FUNC_INFO << "Index missing in" << file->fileName() << "- scanning";
+
+  QDataStream in(file);
+  file->seek(FILE_HEADER_SIZE);
+
+  chunks.clear();
+  while(file->pos() + CHUNK_HEADER_SIZE <= file->size())
+  {
+    Chunk chunk;
+    chunk.offset = file->pos();
+
+    quint32 magicNumber, numFrames, size;
+    in >> magicNumber >> numFrames >> chunk.startMs >> chunk.endMs >> size;
+    if(magicNumber != CHUNK_MAGIC_NUMBER || file->pos() + size > file->size())
+      // Index or truncated chunk
+      break;
+
+    chunk.numFrames = static_cast<int>(numFrames);
+    chunks.append(chunk);
+    file->seek(file->pos() + size);
+  }
+  return !chunks.isEmpty();
+}
+
+bool ReplayFile::loadChunk(int chunkIndex)
+{
+  if(chunkIndex == loadedChunk)
+    return true;
+
+  loadedChunk = -1;
+  frames.clear();
+  frameTimes.clear();
+
+  const Chunk& chunk = chunks.at(chunkIndex);
+  file->seek(chunk.offset);
+
+  QDataStream in(file);
+  quint32 magicNumber, numFrames, size;
+  qint64 startMs, endMs;
+  in >> magicNumber >> numFrames >> startMs >> endMs >> size;
+  if(magicNumber != CHUNK_MAGIC_NUMBER)
+  {
+    errorString = QObject::tr("Invalid chunk");
+    return false;
+  }
+
+  QByteArray data = qUncompress(file->read(size));
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+  QDataStream frameIn(&buffer);
+
+  // Each chunk starts with a keyframe
+  SimConnectDataCodec decoder;
+  while(!buffer.atEnd())
+  {
+    quint32 relMs;
+    frameIn >> relMs;
+
+    SimConnectData frame;
+    if(!frame.read(&buffer, &decoder) || frame.getStatus() != OK)
+    {
+      errorString = frame.getStatusText();
+      break;
+    }
+    frameTimes.append(startMs + relMs);
+    frames.append(frame);
+  }
+
+  if(frames.isEmpty())
+    return false;
+
+  loadedChunk = chunkIndex;
+  return true;
+}
+
+qint64 ReplayFile::getDurationMs() const
+{
+  return chunks.isEmpty() ? 0 : chunks.constLast().endMs;
+}
+
+int ReplayFile::getNumFrames() const
+{
+  int num = 0;
+  for(const Chunk& chunk : chunks)
+    num += chunk.numFrames;
+  return num;
+}
+
+bool ReplayFile::readFrame(SimConnectData& data, qint64 timeMs)
+{
+  if(file == nullptr || writing || chunks.isEmpty())
+    return false;
+
+  // Find last chunk starting at or before time
+  QVector<Chunk>::const_iterator it =
+    std::upper_bound(chunks.constBegin(), chunks.constEnd(), timeMs, [](qint64 time, const Chunk& chunk) -> bool {
+          return time < chunk.startMs;
+        });
+  int chunkIndex = std::max(0, static_cast<int>(std::distance(chunks.constBegin(), it)) - 1);
+
+  if(!loadChunk(chunkIndex))
+    return false;
+
+  // Find last frame at or before time
+  int frameIndex = static_cast<int>(std::distance(frameTimes.constBegin(),
+                                                  std::upper_bound(frameTimes.constBegin(), frameTimes.constEnd(),
+                                                                   timeMs))) - 1;
+  data = frames.at(std::max(0, frameIndex));
+  return true;
+}
+
+quint32 ReplayFile::getFileVersion(const QString& filepath)
+{
+  QFile replay(filepath);
+  if(replay.size() < FILE_HEADER_SIZE || !replay.open(QIODevice::ReadOnly))
+    return 0;
+
+  QDataStream in(&replay);
+  quint32 magicNumber = 0, version = 0;
+  in >> magicNumber >> version;
+  return magicNumber == FILE_MAGIC_NUMBER ? version : 0;
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
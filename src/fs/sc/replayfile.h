@@ -0,0 +1,132 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_SC_REPLAYFILE_H
+#define ATOOLS_FS_SC_REPLAYFILE_H
+
+#include "fs/sc/simconnectdata.h"
+#include "fs/sc/simconnectdatacodec.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+
+class QFile;
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+/*
+ * Chunked and indexed replay file for simulator data.
+ *
+ * Frames are collected into chunks. Each chunk starts with a keyframe followed by delta frames using
+ * SimConnectDataCodec and is compressed as a whole with zlib. An index with the time range and file offset of
+ * each chunk is appended when closing the file. The index is rebuilt by scanning the chunks if it
+ * is missing, e.g. after a crash.
+ *
+ * This allows seeking in O(log n) and playback in both directions since only one chunk has to be decoded.
+ *
+ * Header is compatible with the legacy version 1 format which is a plain sequence of SimConnectData blocks:
+ * magic number, version and update rate in milliseconds.
+ */
+class ReplayFile
+{
+public:
+  ReplayFile();
+  ~ReplayFile();
+
+  /* Create file for writing. Returns false on error. */
+  bool create(const QString& filepath, quint32 updateRateMs);
+
+  /* Open a version 2 file for reading. Returns false on error. */
+  bool open(const QString& filepath);
+
+  /* Writes pending frames and index if writing */
+  void close();
+
+  bool isOpen() const;
+
+  QString getErrorString() const
+  {
+    return errorString;
+  }
+
+  /* Append a frame. Time is taken from the elapsed time since creation. Only for writing. */
+  void addFrame(const atools::fs::sc::SimConnectData& data);
+
+  /* Total duration in milliseconds */
+  qint64 getDurationMs() const;
+
+  /* Update rate as given when the file was created */
+  quint32 getUpdateRateMs() const
+  {
+    return updateRate;
+  }
+
+  /* Total number of frames */
+  int getNumFrames() const;
+
+  /* Get last frame at or before timeMs. Time is clamped to the file duration. Only for reading. */
+  bool readFrame(atools::fs::sc::SimConnectData& data, qint64 timeMs);
+
+  /* Returns version of a replay file or 0 if the file cannot be read or is not a replay file */
+  static quint32 getFileVersion(const QString& filepath);
+
+  static const quint32 FILE_MAGIC_NUMBER = 0XCACF4F27;
+  static const quint32 FILE_VERSION = 2;
+
+  /* Size of magic number, version and update rate */
+  static const int FILE_HEADER_SIZE = 12;
+
+private:
+  struct Chunk
+  {
+    qint64 startMs, endMs, offset;
+    int numFrames;
+  };
+
+  void writeChunk();
+  void writeIndex();
+  bool readIndex();
+  bool scanChunks();
+  bool loadChunk(int chunkIndex);
+
+  QFile *file = nullptr;
+  bool writing = false;
+  quint32 updateRate = 500;
+  QString errorString;
+  QVector<Chunk> chunks;
+
+  /* Writer state */
+  atools::fs::sc::SimConnectDataCodec codec;
+  QByteArray chunkData;
+  int chunkFrames = 0;
+  qint64 chunkStartMs = 0, lastFrameMs = 0;
+  QElapsedTimer timer;
+
+  /* Reader state - frames of the currently decoded chunk */
+  int loadedChunk = -1;
+  QVector<qint64> frameTimes;
+  QVector<atools::fs::sc::SimConnectData> frames;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_REPLAYFILE_H
@@ -0,0 +1,181 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/sc/sharedmemoryring.h"
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QAtomicInteger>
+#include <QBuffer>
+#include <QDebug>
+
+#include <atomic>
+#include <cstring>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+struct SharedMemoryRing::Header
+{
+  quint32 magicNumber;
+  quint32 version;
+  quint32 numSlots;
+  quint32 slotSize;
+  QAtomicInteger<quint32> frameNumber;
+  QAtomicInteger<quint32> terminate;
+};
+
+struct SharedMemoryRing::SlotHeader
+{
+  QAtomicInteger<quint32> sequence;
+  quint32 size;
+};
+
+SharedMemoryRing::SharedMemoryRing(void *memoryParam, int memorySizeParam)
+  : memory(static_cast<char *>(memoryParam)), memorySize(memorySizeParam)
+{
+}
+
+int SharedMemoryRing::requiredSize(int numSlots, int slotSize)
+{
+  return static_cast<int>(sizeof(Header)) + numSlots * slotSize;
+}
+
+bool SharedMemoryRing::initialize(int numSlots, int slotSize)
+{
+  if(memory == nullptr || numSlots < 2 || slotSize <= static_cast<int>(sizeof(SlotHeader)) ||
+     requiredSize(numSlots, slotSize) > memorySize)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid layout" << numSlots << slotSize << "for size" << memorySize;
+    return false;
+  }
+
+  std::memset(memory, 0, static_cast<size_t>(requiredSize(numSlots, slotSize)));
+
+  Header *hdr = header();
+  hdr->version = VERSION;
+  hdr->numSlots = static_cast<quint32>(numSlots);
+  // Keep slots aligned for the atomic sequence
+  hdr->slotSize = static_cast<quint32>(slotSize) & ~3u;
+
+  // Publish magic number last
+  std::atomic_thread_fence(std::memory_order_release);
+  hdr->magicNumber = MAGIC_NUMBER;
+  return true;
+}
+
+bool SharedMemoryRing::isValid() const
+{
+  if(memory == nullptr || memorySize < static_cast<int>(sizeof(Header)))
+    return false;
+
+  const Header *hdr = header();
+  return hdr->magicNumber == MAGIC_NUMBER && hdr->version == VERSION && hdr->numSlots >= 2 &&
+         requiredSize(static_cast<int>(hdr->numSlots), static_cast<int>(hdr->slotSize)) <= memorySize;
+}
+
+bool SharedMemoryRing::write(const QByteArray& block)
+{
+  Header *hdr = header();
+  if(block.size() > static_cast<int>(hdr->slotSize - sizeof(SlotHeader)))
+  {
+    qWarning() << Q_FUNC_INFO << "Block too large" << block.size();
+    return false;
+  }
+
+  quint32 next = hdr->frameNumber.loadAcquire() + 1;
+  SlotHeader *slt = slot(next % hdr->numSlots);
+
+  // Odd sequence marks slot as being updated
+  quint32 seq = slt->sequence.loadAcquire();
+  slt->sequence.storeRelease(seq | 1);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slt->size = static_cast<quint32>(block.size());
+  std::memcpy(reinterpret_cast<char *>(slt) + sizeof(SlotHeader), block.constData(), static_cast<size_t>(block.size()));
+
+  slt->sequence.storeRelease((seq | 1) + 1);
+  hdr->frameNumber.storeRelease(next);
+  return true;
+}
+
+void SharedMemoryRing::setTerminate(bool terminate)
+{
+  header()->terminate.storeRelease(terminate ? 1 : 0);
+}
+
+bool SharedMemoryRing::isTerminate() const
+{
+  return header()->terminate.loadAcquire() != 0;
+}
+
+quint32 SharedMemoryRing::getFrameNumber() const
+{
+  return header()->frameNumber.loadAcquire();
+}
+
+bool SharedMemoryRing::read(SimConnectData& data, quint32& frameNumber)
+{
+  Header *hdr = header();
+  quint32 latest = hdr->frameNumber.loadAcquire();
+  if(latest == 0 || latest == frameNumber)
+    // Nothing new
+    return false;
+
+  SlotHeader *slt = slot(latest % hdr->numSlots);
+  quint32 seqBefore = slt->sequence.loadAcquire();
+  if(seqBefore & 1)
+    // Writer is updating - skip frame
+    return false;
+
+  quint32 size = slt->size;
+  if(size > hdr->slotSize - sizeof(SlotHeader))
+    return false;
+
+  // Copy raw bytes before parsing since parsing may fail on inconsistent data
+  readBuffer.resize(static_cast<int>(size));
+  std::memcpy(readBuffer.data(), reinterpret_cast<const char *>(slt) + sizeof(SlotHeader), size);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if(slt->sequence.loadAcquire() != seqBefore)
+    // Overwritten while copying
+    return false;
+
+  QBuffer buffer(&readBuffer);
+  buffer.open(QIODevice::ReadOnly);
+  if(!data.read(&buffer) || data.getStatus() != OK)
+    return false;
+
+  frameNumber = latest;
+  return true;
+}
+
+SharedMemoryRing::Header *SharedMemoryRing::header() const
+{
+  return reinterpret_cast<Header *>(memory);
+}
+
+SharedMemoryRing::SlotHeader *SharedMemoryRing::slot(quint32 index) const
+{
+  return reinterpret_cast<SlotHeader *>(memory + sizeof(Header) + index * header()->slotSize);
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,94 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_SC_SHAREDMEMORYRING_H
+#define ATOOLS_FS_SC_SHAREDMEMORYRING_H
+
+#include <QByteArray>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+class SimConnectData;
+
+/*
+ * Versioned ring buffer of SimConnectData blocks in a shared memory segment. Does not own the memory.
+ *
+ * Used between the X-Plane plugin (writer) and XpConnectHandler (reader) without locking the shared memory.
+ * Each slot is protected by a sequence lock: Sequence is odd while the writer updates the slot. The reader
+ * discards a frame if the sequence was odd or changed while reading.
+ *
+ * Layout: header followed by numSlots slots of slotSize bytes each. A slot starts with sequence and size.
+ * All values are in native byte order since writer and reader run on the same machine.
+ * The magic number allows to distinguish the ring from the legacy format which starts with a big endian size.
+ */
+class SharedMemoryRing
+{
+public:
+  /* memory has to be aligned to at least four bytes which is always true for QSharedMemory */
+  SharedMemoryRing(void *memoryParam, int memorySizeParam);
+
+  /* Size in bytes needed for the given layout */
+  static int requiredSize(int numSlots, int slotSize);
+
+  /* Writer only: Initialize header and clear all slots. Returns false if memory is too small. */
+  bool initialize(int numSlots, int slotSize);
+
+  /* true if the memory contains a ring of a matching version */
+  bool isValid() const;
+
+  /* Writer only: Copy block into the next slot and publish it. Returns false if the block does not fit into a slot. */
+  bool write(const QByteArray& block);
+
+  /* Writer only: Set on plugin shutdown to notify reader */
+  void setTerminate(bool terminate);
+  bool isTerminate() const;
+
+  /* Number of the last published frame. Increments with each write. Reader can use this to detect new data. */
+  quint32 getFrameNumber() const;
+
+  /*
+   * Reader only: Read the latest frame into data if it is newer than frameNumber.
+   * Updates frameNumber and returns true if a consistent frame was read.
+   * Returns false if no new frame is available or the writer was updating it while reading.
+   */
+  bool read(atools::fs::sc::SimConnectData& data, quint32& frameNumber);
+
+  static const quint32 MAGIC_NUMBER = 0x58504d52;
+  static const quint32 VERSION = 1;
+
+private:
+  struct Header;
+  struct SlotHeader;
+
+  Header *header() const;
+  SlotHeader *slot(quint32 index) const;
+
+  char *memory;
+  int memorySize;
+
+  /* Reader keeps a copy of the slot for parsing, reused to avoid allocations */
+  QByteArray readBuffer;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_SHAREDMEMORYRING_H
@@ -19,12 +19,38 @@
 
 #include <QDebug>
 #include <QDataStream>
+#include <QHash>
+#include <QMutex>
 
 namespace atools {
 namespace fs {
 namespace sc {
 
+namespace {
+
+/* Interned names by object id for all aircraft in this process */
+QMutex namesMutex;
+QHash<quint32, SimConnectAircraftNamesPtr> namesTable;
+
+/* Unused entries are removed when the table grows beyond this size */
+int namesPurgeSize = 1024;
+
+}
+
+bool SimConnectAircraftNames::operator==(const SimConnectAircraftNames& other) const
+{
+  return airplaneTitle == other.airplaneTitle &&
+         airplaneType == other.airplaneType &&
+         airplaneModel == other.airplaneModel &&
+         airplaneReg == other.airplaneReg &&
+         airplaneAirline == other.airplaneAirline &&
+         airplaneFlightnumber == other.airplaneFlightnumber &&
+         fromIdent == other.fromIdent &&
+         toIdent == other.toIdent;
+}
+
 SimConnectAircraft::SimConnectAircraft()
+  : names(emptyNames())
 {
 
 }
@@ -47,14 +73,16 @@ void SimConnectAircraft::read(QDataStream& in)
   in >> intFlags;
   flags = AircraftFlags(intFlags);
 
-  readString(in, airplaneTitle);
-  readString(in, airplaneModel);
-  readString(in, airplaneReg);
-  readString(in, airplaneType);
-  readString(in, airplaneAirline);
-  readString(in, airplaneFlightnumber);
-  readString(in, fromIdent);
-  readString(in, toIdent);
+  SimConnectAircraftNames readNames;
+  readString(in, readNames.airplaneTitle);
+  readString(in, readNames.airplaneModel);
+  readString(in, readNames.airplaneReg);
+  readString(in, readNames.airplaneType);
+  readString(in, readNames.airplaneAirline);
+  readString(in, readNames.airplaneFlightnumber);
+  readString(in, readNames.fromIdent);
+  readString(in, readNames.toIdent);
+  setNames(readNames);
 
   float lonx, laty, altitude;
   quint8 categoryByte, engineTypeByte;
@@ -107,14 +135,14 @@ void SimConnectAircraft::write(QDataStream& out) const
 {
   out << objectId << static_cast<quint16>(flags);
 
-  writeString(out, airplaneTitle);
-  writeString(out, airplaneModel);
-  writeString(out, airplaneReg);
-  writeString(out, airplaneType);
-  writeString(out, airplaneAirline);
-  writeString(out, airplaneFlightnumber);
-  writeString(out, fromIdent);
-  writeString(out, toIdent);
+  writeString(out, names->airplaneTitle);
+  writeString(out, names->airplaneModel);
+  writeString(out, names->airplaneReg);
+  writeString(out, names->airplaneType);
+  writeString(out, names->airplaneAirline);
+  writeString(out, names->airplaneFlightnumber);
+  writeString(out, names->fromIdent);
+  writeString(out, names->toIdent);
 
   out << position.getLonX() << position.getLatY() << position.getAltitude() << headingTrueDeg << headingMagDeg
       << groundSpeedKts << indicatedSpeedKts << verticalSpeedFeetPerMin
@@ -125,21 +153,58 @@ void SimConnectAircraft::write(QDataStream& out) const
 
 bool SimConnectAircraft::isSameAircraft(const SimConnectAircraft& other) const
 {
-  return airplaneTitle == other.airplaneTitle &&
-         airplaneModel == other.airplaneModel &&
-         airplaneReg == other.airplaneReg &&
-         airplaneType == other.airplaneType &&
-         airplaneAirline == other.airplaneAirline &&
-         airplaneFlightnumber == other.airplaneFlightnumber;
+  if(names == other.names)
+    return true;
+
+  return names->airplaneTitle == other.names->airplaneTitle &&
+         names->airplaneModel == other.names->airplaneModel &&
+         names->airplaneReg == other.names->airplaneReg &&
+         names->airplaneType == other.names->airplaneType &&
+         names->airplaneAirline == other.names->airplaneAirline &&
+         names->airplaneFlightnumber == other.names->airplaneFlightnumber;
 }
 
 void SimConnectAircraft::updateAircraftNames(const QString& airplaneTypeParam, const QString& airplaneAirlineParam,
                                              const QString& airplaneTitleParam, const QString& airplaneModelParam)
 {
-  airplaneType = airplaneTypeParam;
-  airplaneAirline = airplaneAirlineParam;
-  airplaneTitle = airplaneTitleParam;
-  airplaneModel = airplaneModelParam;
+  SimConnectAircraftNames updated(*names);
+  updated.airplaneType = airplaneTypeParam;
+  updated.airplaneAirline = airplaneAirlineParam;
+  updated.airplaneTitle = airplaneTitleParam;
+  updated.airplaneModel = airplaneModelParam;
+  setNames(updated);
+}
+
+void SimConnectAircraft::setNames(const SimConnectAircraftNames& value)
+{
+  QMutexLocker locker(&namesMutex);
+
+  SimConnectAircraftNamesPtr& interned = namesTable[objectId];
+  if(!interned || *interned != value)
+  {
+    // New object or names changed - the old instance stays valid for all copies still referencing it
+    interned = new SimConnectAircraftNames(value);
+
+    if(namesTable.size() > namesPurgeSize)
+    {
+      // Remove entries which are referenced by the table only
+      for(QHash<quint32, SimConnectAircraftNamesPtr>::iterator it = namesTable.begin(); it != namesTable.end();)
+      {
+        if(it.key() != objectId && it.value()->ref.load() == 1)
+          it = namesTable.erase(it);
+        else
+          ++it;
+      }
+      namesPurgeSize = qMax(1024, namesTable.size() * 2);
+    }
+  }
+  names = namesTable.value(objectId);
+}
+
+const SimConnectAircraftNamesPtr& SimConnectAircraft::emptyNames()
+{
+  static const SimConnectAircraftNamesPtr EMPTY_NAMES(new SimConnectAircraftNames);
+  return EMPTY_NAMES;
 }
 
 } // namespace sc
@@ -22,6 +22,8 @@
 #include "fs/sc/simconnectdatabase.h"
 
 #include <QString>
+#include <QSharedData>
+#include <QExplicitlySharedDataPointer>
 
 class QIODevice;
 
@@ -33,13 +35,16 @@ namespace atools {
 namespace fs {
 namespace online {
 class OnlinedataManager;
+class OnlineClientStore;
 }
 
 namespace sc {
 
+class AiFetchFilter;
 class SimConnectHandler;
 class SimConnectHandlerPrivate;
 class SimConnectData;
+class SimConnectDataCodec;
 
 // quint8
 enum Category
@@ -67,6 +72,28 @@ enum EngineType
   TURBOPROP = 5
 };
 
+/*
+ * Descriptive strings of an aircraft which usually do not change between frames.
+ * Interned per object id by SimConnectAircraft and shared between all copies of an aircraft which avoids
+ * reference counting of all the strings for each copy. Not modified once interned.
+ */
+struct SimConnectAircraftNames :
+  public QSharedData
+{
+  QString airplaneTitle, airplaneType, airplaneModel, airplaneReg,
+          airplaneAirline, airplaneFlightnumber, fromIdent, toIdent;
+
+  bool operator==(const SimConnectAircraftNames& other) const;
+
+  bool operator!=(const SimConnectAircraftNames& other) const
+  {
+    return !operator==(other);
+  }
+
+};
+
+typedef QExplicitlySharedDataPointer<SimConnectAircraftNames> SimConnectAircraftNamesPtr;
+
 /*
  * Base aircraft that is used to transfer across network links. For user and AI aircraft.
  */
@@ -86,35 +113,35 @@ public:
   /* Mooney, Boeing, Actually aircraft model. */
   const QString& getAirplaneType() const
   {
-    return airplaneType;
+    return names->airplaneType;
   }
 
   const QString& getAirplaneAirline() const
   {
-    return airplaneAirline;
+    return names->airplaneAirline;
   }
 
   const QString& getAirplaneFlightnumber() const
   {
-    return airplaneFlightnumber;
+    return names->airplaneFlightnumber;
   }
 
   /* Beech Baron 58 Paint 1 */
   const QString& getAirplaneTitle() const
   {
-    return airplaneTitle;
+    return names->airplaneTitle;
   }
 
   /* Short ICAO code MD80, BE58, etc. Actually type designator. */
   const QString& getAirplaneModel() const
   {
-    return airplaneModel;
+    return names->airplaneModel;
   }
 
   /* N71FS */
   const QString& getAirplaneRegistration() const
   {
-    return airplaneReg;
+    return names->airplaneReg;
   }
 
   /* Includes actual altitude in feet */
@@ -236,12 +263,12 @@ public:
 
   const QString& getFromIdent() const
   {
-    return fromIdent;
+    return names->fromIdent;
   }
 
   const QString& getToIdent() const
   {
-    return toIdent;
+    return names->toIdent;
   }
 
   bool isOnGround() const
@@ -316,14 +343,23 @@ public:
                            const QString& airplaneTitleParam, const QString& airplaneModelParam);
 
 private:
+  friend class atools::fs::sc::AiFetchFilter;
   friend class atools::fs::sc::SimConnectHandler;
   friend class atools::fs::sc::SimConnectHandlerPrivate;
   friend class atools::fs::sc::SimConnectData;
+  friend class atools::fs::sc::SimConnectDataCodec;
   friend class xpc::XpConnect;
   friend class atools::fs::online::OnlinedataManager;
+  friend class atools::fs::online::OnlineClientStore;
 
-  QString airplaneTitle, airplaneType, airplaneModel, airplaneReg,
-          airplaneAirline, airplaneFlightnumber, fromIdent, toIdent;
+  /* Replace names with the interned instance for objectId which has to be set before */
+  void setNames(const SimConnectAircraftNames& value);
+
+  /* Shared instance without any names */
+  static const SimConnectAircraftNamesPtr& emptyNames();
+
+  /* Never null */
+  SimConnectAircraftNamesPtr names;
 
   atools::geo::Pos position;
   float headingTrueDeg = 0.f, headingMagDeg = 0.f, groundSpeedKts = 0.f, indicatedAltitudeFt = 0.f,
@@ -17,7 +17,9 @@
 
 #include "fs/sc/simconnectdata.h"
 
+#include "fs/sc/simconnectdatacodec.h"
 #include "geo/calculations.h"
+#include "geo/trailstore.h"
 
 #include <QDebug>
 #include <QDataStream>
@@ -43,7 +45,7 @@ SimConnectData::~SimConnectData()
 
 }
 
-bool SimConnectData::read(QIODevice *ioDevice)
+bool SimConnectData::read(QIODevice *ioDevice, SimConnectDataCodec *codec)
 {
   status = OK;
 
@@ -78,6 +80,24 @@ bool SimConnectData::read(QIODevice *ioDevice)
     return false;
 
   in >> version;
+  if(version == COMPACT_DATA_VERSION && codec != nullptr)
+  {
+    quint8 packetFlags;
+    in >> packetId >> packetTs >> packetFlags;
+
+    // Remaining size after version, id, timestamp and flags
+    int bodySize = static_cast<int>(packetSize) - 13;
+    QByteArray body(std::max(bodySize, 0), '\0');
+    in.readRawData(body.data(), body.size());
+
+    if(!codec->decode(*this, body, packetFlags))
+    {
+      status = DECODE_ERROR;
+      return false;
+    }
+    return true;
+  }
+
   if(version != DATA_VERSION)
   {
     qWarning() << "SimConnectData::read: version mismatch" << version << "!=" << DATA_VERSION;
@@ -100,28 +120,7 @@ bool SimConnectData::read(QIODevice *ioDevice)
     aiAircraft.append(ap);
   }
 
-  quint16 numMetar = 0;
-  in >> numMetar;
-  for(quint16 i = 0; i < numMetar; i++)
-  {
-
-    MetarResult result;
-    readString(in, result.requestIdent);
-
-    float lonx, laty, altitude;
-    quint32 minSinceEpoch;
-    in >> lonx >> laty >> altitude >> minSinceEpoch;
-    result.requestPos.setAltitude(altitude);
-    result.requestPos.setLonX(lonx);
-    result.requestPos.setLatY(laty);
-    result.timestamp = QDateTime::fromMSecsSinceEpoch(minSinceEpoch * 1000);
-
-    readLongString(in, result.metarForStation);
-    readLongString(in, result.metarForNearest);
-    readLongString(in, result.metarForInterpolated);
-
-    metarResults.append(result);
-  }
+  readMetars(in);
 
   return true;
 }
@@ -129,7 +128,17 @@ bool SimConnectData::read(QIODevice *ioDevice)
 int SimConnectData::write(QIODevice *ioDevice)
 {
   status = OK;
+  return SimConnectDataBase::writeBlock(ioDevice, writeToBlock(), status);
+}
+
+int SimConnectData::write(QIODevice *ioDevice, SimConnectDataCodec& codec)
+{
+  status = OK;
+  return SimConnectDataBase::writeBlock(ioDevice, writeToBlock(codec), status);
+}
 
+QByteArray SimConnectData::writeToBlock() const
+{
   QByteArray block;
   QDataStream out(&block, QIODevice::WriteOnly);
   out.setVersion(QDataStream::Qt_5_5);
@@ -148,6 +157,38 @@ int SimConnectData::write(QIODevice *ioDevice)
   for(int i = 0; i < numAi; i++)
     aiAircraft.at(i).write(out);
 
+  writeMetars(out);
+
+  // Go back and update size
+  out.device()->seek(sizeof(MAGIC_NUMBER_DATA));
+  int size = block.size() - static_cast<int>(sizeof(packetSize)) - static_cast<int>(sizeof(MAGIC_NUMBER_DATA));
+  out << static_cast<quint32>(size);
+
+  return block;
+}
+
+QByteArray SimConnectData::writeToBlock(SimConnectDataCodec& codec) const
+{
+  if(packetId == 0)
+    // Weather and empty replies do not change the codec state
+    return writeToBlock();
+
+  QByteArray body;
+  quint8 packetFlags = codec.encode(body, *this);
+
+  QByteArray block;
+  QDataStream out(&block, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+
+  out << MAGIC_NUMBER_DATA << static_cast<quint32>(body.size() + 13) << COMPACT_DATA_VERSION
+      << packetId << packetTs << packetFlags;
+  out.writeRawData(body.constData(), body.size());
+
+  return block;
+}
+
+void SimConnectData::writeMetars(QDataStream& out) const
+{
   int numMetar = std::min(65535, metarResults.size());
   out << static_cast<quint16>(numMetar);
 
@@ -161,13 +202,44 @@ int SimConnectData::write(QIODevice *ioDevice)
     writeLongString(out, result.metarForNearest);
     writeLongString(out, result.metarForInterpolated);
   }
+}
 
-  // Go back and update size
-  out.device()->seek(sizeof(MAGIC_NUMBER_DATA));
-  int size = block.size() - static_cast<int>(sizeof(packetSize)) - static_cast<int>(sizeof(MAGIC_NUMBER_DATA));
-  out << static_cast<quint32>(size);
+void SimConnectData::readMetars(QDataStream& in)
+{
+  quint16 numMetar = 0;
+  in >> numMetar;
+  for(quint16 i = 0; i < numMetar; i++)
+  {
 
-  return SimConnectDataBase::writeBlock(ioDevice, block, status);
+    MetarResult result;
+    readString(in, result.requestIdent);
+
+    float lonx, laty, altitude;
+    quint32 minSinceEpoch;
+    in >> lonx >> laty >> altitude >> minSinceEpoch;
+    result.requestPos.setAltitude(altitude);
+    result.requestPos.setLonX(lonx);
+    result.requestPos.setLatY(laty);
+    result.timestamp = QDateTime::fromMSecsSinceEpoch(minSinceEpoch * 1000);
+
+    readLongString(in, result.metarForStation);
+    readLongString(in, result.metarForNearest);
+    readLongString(in, result.metarForInterpolated);
+
+    metarResults.append(result);
+  }
+}
+
+void SimConnectData::updateAiTrails(geo::TrailStore& store, qint64 timestampMs) const
+{
+  QHash<quint64, bool> objectIds;
+  objectIds.reserve(aiAircraft.size());
+  for(const SimConnectAircraft& aircraft : aiAircraft)
+  {
+    store.append(aircraft.getObjectId(), timestampMs, aircraft.getPosition());
+    objectIds.insert(aircraft.getObjectId(), true);
+  }
+  store.retain(objectIds);
 }
 
 SimConnectData SimConnectData::buildDebugForPosition(const geo::Pos& pos, const geo::Pos& lastPos, bool ground,
@@ -199,17 +271,19 @@ SimConnectData SimConnectData::buildDebugForPosition(const geo::Pos& pos, const
   data.userAircraft.zuluDateTime = QDateTime::currentDateTimeUtc();
   data.userAircraft.localDateTime = QDateTime::currentDateTime();
 
-  data.userAircraft.airplaneTitle = "Airplane Title";
-  data.userAircraft.airplaneType = "Airplane Type";
-  data.userAircraft.airplaneModel = "MODEL";
-  data.userAircraft.airplaneReg = "Airplane Registration";
-  data.userAircraft.airplaneAirline = "Airline";
-  data.userAircraft.airplaneFlightnumber = "965";
-  data.userAircraft.fromIdent = "EDDF";
+  SimConnectAircraftNames names;
+  names.airplaneTitle = "Airplane Title";
+  names.airplaneType = "Airplane Type";
+  names.airplaneModel = "MODEL";
+  names.airplaneReg = "Airplane Registration";
+  names.airplaneAirline = "Airline";
+  names.airplaneFlightnumber = "965";
+  names.fromIdent = "EDDF";
+  names.toIdent = "LIRF";
+  data.userAircraft.setNames(names);
 
   data.userAircraft.verticalSpeedFeetPerMin = vertSpeed;
 
-  data.userAircraft.toIdent = "LIRF";
   data.userAircraft.altitudeAboveGroundFt = pos.getAltitude();
   data.userAircraft.indicatedAltitudeFt = pos.getAltitude();
   data.userAircraft.airplaneEmptyWeightLbs = 1500.f;
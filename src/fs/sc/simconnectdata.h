@@ -27,16 +27,21 @@
 #include <QDateTime>
 
 class QIODevice;
+class QDataStream;
 
 namespace xpc {
 class XpConnect;
 }
 
 namespace atools {
+namespace geo {
+class TrailStore;
+}
 namespace fs {
 namespace sc {
 
 class SimConnectHandler;
+class SimConnectDataCodec;
 
 /*
  * Class that transfers flight simulator data read using the simconnect interface across the network to
@@ -51,10 +56,11 @@ public:
   virtual ~SimConnectData();
 
   /*
-   * Read from IO device.
+   * Read from IO device. Packets in compact format can only be read if a codec is given.
+   * The codec has to be kept for the whole connection.
    * @return true if it was fully read. False if not or an error occured.
    */
-  bool read(QIODevice *ioDevice);
+  bool read(QIODevice *ioDevice, atools::fs::sc::SimConnectDataCodec *codec = nullptr);
 
   /*
    * Write to IO device.
@@ -62,6 +68,19 @@ public:
    */
   int write(QIODevice *ioDevice);
 
+  /*
+   * Write to IO device using the compact delta format. Empty packets and weather replies are written
+   * in the full format. Codec has to be kept for the whole connection.
+   * @return number of bytes written
+   */
+  int write(QIODevice *ioDevice, atools::fs::sc::SimConnectDataCodec& codec);
+
+  /* Serialize into a block in the full format which can be written to several devices using writeBlock() */
+  QByteArray writeToBlock() const;
+
+  /* Serialize into a block in the compact format. Updates codec state. Same as write() above. */
+  QByteArray writeToBlock(atools::fs::sc::SimConnectDataCodec& codec) const;
+
   // metadata ----------------------------------------------------
   /* Serial number for data packet. */
   int getPacketId() const
@@ -94,6 +113,14 @@ public:
     return DATA_VERSION;
   }
 
+  /*
+   * @return data version for the compact delta format
+   */
+  static int getCompactDataVersion()
+  {
+    return COMPACT_DATA_VERSION;
+  }
+
   // fs data ----------------------------------------------------
 
   const atools::fs::sc::SimConnectUserAircraft& getUserAircraftConst() const
@@ -116,6 +143,10 @@ public:
     return aiAircraft;
   }
 
+  /* Append a sample for each AI aircraft to the store keyed by object id and remove trails of
+   * aircraft which are gone. timestampMs should be the real time since simulator time can jump. */
+  void updateAiTrails(atools::geo::TrailStore& store, qint64 timestampMs) const;
+
   const QVector<atools::fs::weather::MetarResult>& getMetars() const
   {
     return metarResults;
@@ -142,11 +173,18 @@ public:
 
 private:
   friend class atools::fs::sc::SimConnectHandler;
+  friend class atools::fs::sc::SimConnectDataCodec;
   friend class xpc::XpConnect;
 
+  void writeMetars(QDataStream& out) const;
+  void readMetars(QDataStream& in);
+
   const static quint32 MAGIC_NUMBER_DATA = 0xF75E0AF3;
   const static quint32 DATA_VERSION = 10;
 
+  /* Keyframes and deltas. Used only if client sends CMD_COMPACT_DATA. */
+  const static quint32 COMPACT_DATA_VERSION = 11;
+
   quint32 packetId = 0, packetTs = 0;
   quint32 magicNumber = 0, packetSize = 0, version = 0;
 
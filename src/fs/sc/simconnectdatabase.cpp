@@ -52,6 +52,9 @@ QString SimConnectDataBase::getStatusText() const
 
     case atools::fs::sc::WRITE_ERROR:
       return QObject::tr("Write error");
+
+    case atools::fs::sc::DECODE_ERROR:
+      return QObject::tr("Decode error");
   }
   return QObject::tr("Unknown Status");
 }
@@ -0,0 +1,84 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/sc/simconnectdatachannel.h"
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+SimConnectDataChannel::SimConnectDataChannel(QObject *parent)
+  : QObject(parent)
+{
+}
+
+SimConnectDataChannel::~SimConnectDataChannel()
+{
+}
+
+void SimConnectDataChannel::publish(const SimConnectData& data)
+{
+  bool notify = false;
+  {
+    QMutexLocker locker(&mutex);
+    if(data.getPacketId() == 0)
+      replies.append(data);
+    else
+    {
+      if(hasLatest)
+        numDropped++;
+
+      // Copy is cheap since vectors are implicitly shared
+      latest = data;
+      hasLatest = true;
+    }
+
+    notify = !notified;
+    notified = true;
+  }
+
+  if(notify)
+    emit dataAvailable();
+}
+
+QVector<SimConnectData> SimConnectDataChannel::take()
+{
+  QMutexLocker locker(&mutex);
+  QVector<SimConnectData> retval;
+  retval.swap(replies);
+
+  if(hasLatest)
+  {
+    retval.append(latest);
+    latest = SimConnectData();
+    hasLatest = false;
+  }
+
+  notified = false;
+  return retval;
+}
+
+quint64 SimConnectDataChannel::getNumDropped() const
+{
+  QMutexLocker locker(&mutex);
+  return numDropped;
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,76 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_SC_SIMCONNECTDATACHANNEL_H
+#define ATOOLS_FS_SC_SIMCONNECTDATACHANNEL_H
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+/*
+ * Latest value handoff of simulator data from DataReaderThread to one consumer.
+ *
+ * The producer replaces any data packet which was not taken yet. The consumer is notified by dataAvailable()
+ * only once until it calls take(). This avoids queues backing up if the consumer stalls and stale
+ * packets are dropped. Weather replies (packet id 0) are never dropped.
+ *
+ * Create one channel per consumer and register it with DataReaderThread::addChannel().
+ */
+class SimConnectDataChannel :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit SimConnectDataChannel(QObject *parent = nullptr);
+  virtual ~SimConnectDataChannel() override;
+
+  /* Called by producer thread. Thread safe. */
+  void publish(const atools::fs::sc::SimConnectData& data);
+
+  /* Get all pending weather replies followed by the latest data packet and clear.
+   * Allows the next notification. Thread safe. */
+  QVector<atools::fs::sc::SimConnectData> take();
+
+  /* Number of packets which were replaced before the consumer took them */
+  quint64 getNumDropped() const;
+
+signals:
+  /* Emitted in producer thread context. Connect using a queued connection. */
+  void dataAvailable();
+
+private:
+  mutable QMutex mutex;
+  QVector<atools::fs::sc::SimConnectData> replies;
+  atools::fs::sc::SimConnectData latest;
+  bool hasLatest = false, notified = false;
+  quint64 numDropped = 0;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_SIMCONNECTDATACHANNEL_H
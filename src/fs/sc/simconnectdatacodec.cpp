@@ -0,0 +1,409 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/sc/simconnectdatacodec.h"
+
+#include "atools.h"
+#include "fs/sc/simconnectdata.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <limits>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+namespace {
+
+/* Packet flags */
+const quint8 PACKET_KEYFRAME = 0x01;
+const quint8 PACKET_COMPRESSED = 0x02;
+
+/* Field groups of AI aircraft */
+const quint16 FIELD_FLAGS = 0x0001;
+const quint16 FIELD_NAMES = 0x0002;
+const quint16 FIELD_POSITION = 0x0004;
+const quint16 FIELD_HEADING = 0x0008;
+const quint16 FIELD_SPEED = 0x0010;
+const quint16 FIELD_STATIC = 0x0020;
+const quint16 FIELD_ALL = 0x003f;
+
+/* Do not compress small packets */
+const int MIN_COMPRESS_SIZE = 256;
+
+/* Coordinates in 1/100000 degree which is about one meter */
+const float COORD_FACTOR = 100000.f;
+
+const qint32 INVALID_INT32 = std::numeric_limits<qint32>::min();
+const qint16 INVALID_INT16 = std::numeric_limits<qint16>::min();
+const quint16 INVALID_UINT16 = std::numeric_limits<quint16>::max();
+
+/* Values of SC_INVALID_FLOAT and Pos::INVALID_VALUE are the same */
+bool isInvalid(float value)
+{
+  return value >= SC_INVALID_FLOAT / 2.f;
+}
+
+qint32 toInt32(float value, float factor)
+{
+  if(isInvalid(value))
+    return INVALID_INT32;
+  return static_cast<qint32>(atools::roundToInt(value * factor));
+}
+
+float fromInt32(qint32 value, float factor, float invalid)
+{
+  return value == INVALID_INT32 ? invalid : static_cast<float>(value) / factor;
+}
+
+qint16 toInt16(float value, float factor)
+{
+  if(isInvalid(value))
+    return INVALID_INT16;
+  return static_cast<qint16>(std::max(-32767, std::min(32767, atools::roundToInt(value * factor))));
+}
+
+float fromInt16(qint16 value, float factor)
+{
+  return value == INVALID_INT16 ? SC_INVALID_FLOAT : static_cast<float>(value) / factor;
+}
+
+/* Heading in 1/100 degree */
+quint16 toHeading(float value)
+{
+  if(isInvalid(value))
+    return INVALID_UINT16;
+  return static_cast<quint16>((atools::roundToInt(value * 100.f) % 36000 + 36000) % 36000);
+}
+
+float fromHeading(quint16 value)
+{
+  return value == INVALID_UINT16 ? SC_INVALID_FLOAT : static_cast<float>(value) / 100.f;
+}
+
+} // namespace
+
+SimConnectDataCodec::SimConnectDataCodec()
+{
+
+}
+
+SimConnectDataCodec::~SimConnectDataCodec()
+{
+
+}
+
+void SimConnectDataCodec::reset()
+{
+  aircraft.clear();
+  packetsSinceKeyframe = 0;
+  keyframePending = true;
+  keyframeReceived = false;
+}
+
+quint8 SimConnectDataCodec::encode(QByteArray& body, const SimConnectData& data)
+{
+  quint8 packetFlags = 0;
+  if(keyframePending || packetsSinceKeyframe >= keyframeInterval)
+  {
+    // All aircraft are sent with all fields
+    aircraft.clear();
+    packetFlags |= PACKET_KEYFRAME;
+    packetsSinceKeyframe = 0;
+    keyframePending = false;
+  }
+  else
+    packetsSinceKeyframe++;
+
+  QDataStream out(&body, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+  out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  // User aircraft changes with every frame - send complete
+  bool userValid = data.userAircraft.getPosition().isValid();
+  out << static_cast<quint8>(userValid);
+  if(userValid)
+    data.userAircraft.write(out);
+
+  // AI aircraft - all ids are listed to keep the order. Missing ones are removed.
+  int numAi = std::min(65535, data.aiAircraft.size());
+  out << static_cast<quint16>(numAi);
+
+  QHash<quint32, CompactAircraft> nextAircraft;
+  nextAircraft.reserve(numAi);
+  for(int i = 0; i < numAi; i++)
+  {
+    const SimConnectAircraft& ac = data.aiAircraft.at(i);
+    CompactAircraft compact = toCompact(ac);
+
+    auto it = aircraft.constFind(ac.objectId);
+    quint16 fields = it == aircraft.constEnd() ? FIELD_ALL : changedFields(it.value(), compact);
+
+    out << ac.objectId << fields;
+    writeFields(out, compact, fields);
+    nextAircraft.insert(ac.objectId, compact);
+  }
+  aircraft.swap(nextAircraft);
+
+  data.writeMetars(out);
+
+  if(compression && body.size() > MIN_COMPRESS_SIZE)
+  {
+    QByteArray compressed = qCompress(body);
+    if(compressed.size() < body.size())
+    {
+      body.swap(compressed);
+      packetFlags |= PACKET_COMPRESSED;
+    }
+  }
+
+  return packetFlags;
+}
+
+bool SimConnectDataCodec::decode(SimConnectData& data, QByteArray body, quint8 packetFlags)
+{
+  if(packetFlags & PACKET_COMPRESSED)
+  {
+    body = qUncompress(body);
+    if(body.isEmpty())
+    {
+      qWarning() << Q_FUNC_INFO << "Error uncompressing packet";
+      return false;
+    }
+  }
+
+  if(packetFlags & PACKET_KEYFRAME)
+  {
+    aircraft.clear();
+    keyframeReceived = true;
+  }
+  else if(!keyframeReceived)
+  {
+    qWarning() << Q_FUNC_INFO << "Delta packet without keyframe";
+    return false;
+  }
+
+  QDataStream in(&body, QIODevice::ReadOnly);
+  in.setVersion(QDataStream::Qt_5_5);
+  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  quint8 hasUser = 0;
+  in >> hasUser;
+  if(hasUser == 1)
+    data.userAircraft.read(in);
+
+  quint16 numAi = 0;
+  in >> numAi;
+
+  QHash<quint32, CompactAircraft> nextAircraft;
+  nextAircraft.reserve(numAi);
+  data.aiAircraft.reserve(numAi);
+  for(quint16 i = 0; i < numAi; i++)
+  {
+    quint32 id;
+    quint16 fields;
+    in >> id >> fields;
+
+    // Start from last state for deltas
+    auto it = aircraft.constFind(id);
+    if(it == aircraft.constEnd() && fields != FIELD_ALL)
+    {
+      qWarning() << Q_FUNC_INFO << "Delta for unknown aircraft" << id;
+      aircraft.clear();
+      keyframeReceived = false;
+      return false;
+    }
+
+    CompactAircraft compact = it == aircraft.constEnd() ? CompactAircraft() : it.value();
+    readFields(in, compact, fields);
+    nextAircraft.insert(id, compact);
+
+    SimConnectAircraft ac;
+    fromCompact(ac, id, compact);
+    data.aiAircraft.append(ac);
+  }
+  aircraft.swap(nextAircraft);
+
+  data.readMetars(in);
+
+  return in.status() == QDataStream::Ok;
+}
+
+SimConnectDataCodec::CompactAircraft SimConnectDataCodec::toCompact(const SimConnectAircraft& ac)
+{
+  CompactAircraft compact;
+  compact.flags = static_cast<quint16>(ac.flags);
+
+  compact.names = ac.names;
+
+  compact.lonX = toInt32(ac.position.getLonX(), COORD_FACTOR);
+  compact.latY = toInt32(ac.position.getLatY(), COORD_FACTOR);
+  compact.altitudeFt = toInt32(ac.position.getAltitude(), 1.f);
+  compact.indicatedAltitudeFt = toInt32(ac.indicatedAltitudeFt, 1.f);
+
+  compact.headingTrue = toHeading(ac.headingTrueDeg);
+  compact.headingMag = toHeading(ac.headingMagDeg);
+
+  // Speeds in 1/10 knots, vertical speed in feet per minute and mach in 1/1000
+  compact.groundSpeed = toInt16(ac.groundSpeedKts, 10.f);
+  compact.indicatedSpeed = toInt16(ac.indicatedSpeedKts, 10.f);
+  compact.trueAirspeed = toInt16(ac.trueAirspeedKts, 10.f);
+  compact.verticalSpeed = toInt16(ac.verticalSpeedFeetPerMin, 1.f);
+  compact.mach = toInt16(ac.machSpeed, 1000.f);
+
+  compact.wingSpanFt = ac.wingSpanFt;
+  compact.modelRadiusFt = ac.modelRadiusFt;
+  compact.deckHeight = ac.deckHeight;
+  compact.numberOfEngines = ac.numberOfEngines;
+  compact.category = static_cast<quint8>(ac.category);
+  compact.engineType = static_cast<quint8>(ac.engineType);
+  return compact;
+}
+
+void SimConnectDataCodec::fromCompact(SimConnectAircraft& ac, quint32 id, const CompactAircraft& compact)
+{
+  ac.objectId = id;
+  ac.flags = AircraftFlags(compact.flags);
+
+  // Names are shared with the decoder state which keeps one instance per object id
+  ac.names = !compact.names ? SimConnectAircraft::emptyNames() : compact.names;
+
+  const float INVALID_POS = atools::geo::Pos::INVALID_VALUE;
+  ac.position = atools::geo::Pos(fromInt32(compact.lonX, COORD_FACTOR, INVALID_POS),
+                                 fromInt32(compact.latY, COORD_FACTOR, INVALID_POS),
+                                 fromInt32(compact.altitudeFt, 1.f, INVALID_POS));
+  ac.indicatedAltitudeFt = fromInt32(compact.indicatedAltitudeFt, 1.f, SC_INVALID_FLOAT);
+
+  ac.headingTrueDeg = fromHeading(compact.headingTrue);
+  ac.headingMagDeg = fromHeading(compact.headingMag);
+
+  ac.groundSpeedKts = fromInt16(compact.groundSpeed, 10.f);
+  ac.indicatedSpeedKts = fromInt16(compact.indicatedSpeed, 10.f);
+  ac.trueAirspeedKts = fromInt16(compact.trueAirspeed, 10.f);
+  ac.verticalSpeedFeetPerMin = fromInt16(compact.verticalSpeed, 1.f);
+  ac.machSpeed = fromInt16(compact.mach, 1000.f);
+
+  ac.wingSpanFt = compact.wingSpanFt;
+  ac.modelRadiusFt = compact.modelRadiusFt;
+  ac.deckHeight = compact.deckHeight;
+  ac.numberOfEngines = compact.numberOfEngines;
+  ac.category = static_cast<Category>(compact.category);
+  ac.engineType = static_cast<EngineType>(compact.engineType);
+}
+
+quint16 SimConnectDataCodec::changedFields(const CompactAircraft& last, const CompactAircraft& cur)
+{
+  quint16 fields = 0;
+  if(last.flags != cur.flags)
+    fields |= FIELD_FLAGS;
+
+  // Interned names are usually the same instance
+  if(last.names != cur.names && (!last.names || !cur.names || *last.names != *cur.names))
+    fields |= FIELD_NAMES;
+
+  if(last.lonX != cur.lonX || last.latY != cur.latY || last.altitudeFt != cur.altitudeFt ||
+     last.indicatedAltitudeFt != cur.indicatedAltitudeFt)
+    fields |= FIELD_POSITION;
+
+  if(last.headingTrue != cur.headingTrue || last.headingMag != cur.headingMag)
+    fields |= FIELD_HEADING;
+
+  if(last.groundSpeed != cur.groundSpeed || last.indicatedSpeed != cur.indicatedSpeed ||
+     last.trueAirspeed != cur.trueAirspeed || last.verticalSpeed != cur.verticalSpeed || last.mach != cur.mach)
+    fields |= FIELD_SPEED;
+
+  if(last.wingSpanFt != cur.wingSpanFt || last.modelRadiusFt != cur.modelRadiusFt ||
+     last.deckHeight != cur.deckHeight || last.numberOfEngines != cur.numberOfEngines ||
+     last.category != cur.category || last.engineType != cur.engineType)
+    fields |= FIELD_STATIC;
+
+  return fields;
+}
+
+void SimConnectDataCodec::writeFields(QDataStream& out, const CompactAircraft& compact, quint16 fields)
+{
+  if(fields & FIELD_FLAGS)
+    out << compact.flags;
+
+  if(fields & FIELD_NAMES)
+  {
+    const SimConnectAircraftNames& names = !compact.names ? *SimConnectAircraft::emptyNames() : *compact.names;
+    SimConnectDataBase::writeString(out, names.airplaneTitle);
+    SimConnectDataBase::writeString(out, names.airplaneModel);
+    SimConnectDataBase::writeString(out, names.airplaneReg);
+    SimConnectDataBase::writeString(out, names.airplaneType);
+    SimConnectDataBase::writeString(out, names.airplaneAirline);
+    SimConnectDataBase::writeString(out, names.airplaneFlightnumber);
+    SimConnectDataBase::writeString(out, names.fromIdent);
+    SimConnectDataBase::writeString(out, names.toIdent);
+  }
+
+  if(fields & FIELD_POSITION)
+    out << compact.lonX << compact.latY << compact.altitudeFt << compact.indicatedAltitudeFt;
+
+  if(fields & FIELD_HEADING)
+    out << compact.headingTrue << compact.headingMag;
+
+  if(fields & FIELD_SPEED)
+    out << compact.groundSpeed << compact.indicatedSpeed << compact.trueAirspeed << compact.verticalSpeed
+        << compact.mach;
+
+  if(fields & FIELD_STATIC)
+    out << compact.wingSpanFt << compact.modelRadiusFt << compact.deckHeight << compact.numberOfEngines
+        << compact.category << compact.engineType;
+}
+
+void SimConnectDataCodec::readFields(QDataStream& in, CompactAircraft& compact, quint16 fields)
+{
+  if(fields & FIELD_FLAGS)
+    in >> compact.flags;
+
+  if(fields & FIELD_NAMES)
+  {
+    // New instance since the last one may be shared with decoded aircraft
+    SimConnectAircraftNames *names = new SimConnectAircraftNames;
+    compact.names = SimConnectAircraftNamesPtr(names);
+    SimConnectDataBase::readString(in, names->airplaneTitle);
+    SimConnectDataBase::readString(in, names->airplaneModel);
+    SimConnectDataBase::readString(in, names->airplaneReg);
+    SimConnectDataBase::readString(in, names->airplaneType);
+    SimConnectDataBase::readString(in, names->airplaneAirline);
+    SimConnectDataBase::readString(in, names->airplaneFlightnumber);
+    SimConnectDataBase::readString(in, names->fromIdent);
+    SimConnectDataBase::readString(in, names->toIdent);
+  }
+
+  if(fields & FIELD_POSITION)
+    in >> compact.lonX >> compact.latY >> compact.altitudeFt >> compact.indicatedAltitudeFt;
+
+  if(fields & FIELD_HEADING)
+    in >> compact.headingTrue >> compact.headingMag;
+
+  if(fields & FIELD_SPEED)
+    in >> compact.groundSpeed >> compact.indicatedSpeed >> compact.trueAirspeed >> compact.verticalSpeed
+    >> compact.mach;
+
+  if(fields & FIELD_STATIC)
+    in >> compact.wingSpanFt >> compact.modelRadiusFt >> compact.deckHeight >> compact.numberOfEngines
+    >> compact.category >> compact.engineType;
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,110 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_SC_SIMCONNECTDATACODEC_H
+#define ATOOLS_FS_SC_SIMCONNECTDATACODEC_H
+
+#include <QHash>
+#include <QString>
+
+class QByteArray;
+class QDataStream;
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+class SimConnectData;
+class SimConnectAircraft;
+
+/*
+ * Keeps the state for the compact SimConnectData protocol on the sending or receiving side of one connection.
+ *
+ * The compact protocol sends keyframes containing all aircraft and delta frames in between.
+ * Delta frames contain only changed field groups per AI aircraft id. Positions, headings and speeds are quantized.
+ * The whole packet can optionally be compressed using zlib.
+ *
+ * One object has to be used per connection and direction. Encoder and decoder state are the same after each packet.
+ * The protocol is used if the client announces support by sending CMD_COMPACT_DATA in its replies.
+ * Weather replies and empty packets are always sent using the full legacy format.
+ */
+class SimConnectDataCodec
+{
+public:
+  SimConnectDataCodec();
+  ~SimConnectDataCodec();
+
+  /* Forget state which forces a keyframe for the next encoded packet */
+  void reset();
+
+  /* Use zlib compression for packets larger than a few hundred bytes */
+  void setCompression(bool value)
+  {
+    compression = value;
+  }
+
+  bool isCompression() const
+  {
+    return compression;
+  }
+
+  /* Send a keyframe after this number of delta frames */
+  void setKeyframeInterval(int value)
+  {
+    keyframeInterval = value;
+  }
+
+private:
+  friend class atools::fs::sc::SimConnectData;
+
+  /* Quantized fields of one AI aircraft as sent across the network */
+  struct CompactAircraft
+  {
+    quint16 flags = 0;
+    atools::fs::sc::SimConnectAircraftNamesPtr names;
+
+    qint32 lonX = 0, latY = 0, altitudeFt = 0, indicatedAltitudeFt = 0;
+    quint16 headingTrue = 0, headingMag = 0;
+    qint16 groundSpeed = 0, indicatedSpeed = 0, trueAirspeed = 0, verticalSpeed = 0, mach = 0;
+    quint16 wingSpanFt = 0, modelRadiusFt = 0, deckHeight = 0;
+    quint8 numberOfEngines = 0, category = 0, engineType = 0;
+  };
+
+  /* Encode user and AI aircraft of data into body and update state. Returns packet flags. */
+  quint8 encode(QByteArray& body, const atools::fs::sc::SimConnectData& data);
+
+  /* Decode body and update state. Returns false on error or if a delta was received without keyframe before. */
+  bool decode(atools::fs::sc::SimConnectData& data, QByteArray body, quint8 packetFlags);
+
+  static CompactAircraft toCompact(const atools::fs::sc::SimConnectAircraft& aircraft);
+  static void fromCompact(atools::fs::sc::SimConnectAircraft& aircraft, quint32 id, const CompactAircraft& compact);
+  static quint16 changedFields(const CompactAircraft& last, const CompactAircraft& cur);
+  static void writeFields(QDataStream& out, const CompactAircraft& compact, quint16 fields);
+  static void readFields(QDataStream& in, CompactAircraft& compact, quint16 fields);
+
+  /* Last sent or received state by aircraft object id */
+  QHash<quint32, CompactAircraft> aircraft;
+  int packetsSinceKeyframe = 0, keyframeInterval = 50;
+  bool compression = false, keyframePending = true, keyframeReceived = false;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_SIMCONNECTDATACODEC_H
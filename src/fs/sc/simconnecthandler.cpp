@@ -17,6 +17,7 @@
 
 #include "fs/sc/simconnecthandler.h"
 
+#include "fs/sc/aifetchfilter.h"
 #include "fs/sc/simconnectapi.h"
 #include "fs/sc/weatherrequest.h"
 #include "fs/sc/simconnectdata.h"
@@ -28,10 +29,12 @@
 #include <QDateTime>
 #include <QThread>
 #include <QSet>
+#include <QHash>
 #include <QCache>
 #include <QLatin1Literal>
 #include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
 
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 
@@ -44,7 +47,8 @@ namespace sc {
 enum EventIds
 {
   EVENT_SIM_STATE,
-  EVENT_SIM_PAUSE
+  EVENT_SIM_PAUSE,
+  EVENT_SIM_FRAME
 };
 
 enum DataRequestId
@@ -55,7 +59,12 @@ enum DataRequestId
   DATA_REQUEST_ID_AI_BOAT = 4,
   DATA_REQUEST_ID_WEATHER_INTERPOLATED = 5,
   DATA_REQUEST_ID_WEATHER_NEAREST_STATION = 6,
-  DATA_REQUEST_ID_WEATHER_STATION = 7
+  DATA_REQUEST_ID_WEATHER_STATION = 7,
+  DATA_REQUEST_ID_USER_AIRCRAFT_STATIC = 8,
+
+  /* Range of ids used round robin for the one time requests of static AI object data */
+  DATA_REQUEST_ID_AI_STATIC_FIRST = 1000,
+  DATA_REQUEST_ID_AI_STATIC_LAST = 9999
 };
 
 enum DataDefinitionId
@@ -63,11 +72,16 @@ enum DataDefinitionId
   DATA_DEFINITION_USER_AIRCRAFT = 10,
   DATA_DEFINITION_AI_AIRCRAFT = 20,
   DATA_DEFINITION_AI_HELICOPTER = 30,
-  DATA_DEFINITION_AI_BOAT = 40
+  DATA_DEFINITION_AI_BOAT = 40,
+  DATA_DEFINITION_AIRCRAFT_STATIC = 50
 };
 
-/* Struct that will be filled with raw data from the simconnect interface. */
-struct SimDataAircraft
+/* Number of simulator frames between updates of the user aircraft. Values are only sent if changed. */
+const DWORD USER_AIRCRAFT_FRAME_INTERVAL = 5;
+
+/* Struct that will be filled with raw data from the simconnect interface.
+ * Contains values which do not change during the lifetime of a simulator object. */
+struct SimDataAircraftStatic
 {
   char aircraftTitle[256];
   char aircraftAtcType[256];
@@ -84,6 +98,14 @@ struct SimDataAircraft
   char aiFrom[32];
   char aiTo[32];
 
+  qint32 numEngines;
+  qint32 engineType; // 0 = Piston 1 = Jet 2 = None 3 = Helo(Bell) turbine 4 = Unsupported 5 = Turboprop
+};
+
+/* Struct that will be filled with raw data from the simconnect interface.
+ * Contains only values which change while moving. All fields have to be 4 bytes wide. */
+struct SimDataAircraft
+{
   float altitudeFt;
   float latitudeDeg;
   float longitudeDeg;
@@ -99,12 +121,10 @@ struct SimDataAircraft
   float airspeedIndicatedKts;
   float airspeedMach;
   float verticalSpeedFps;
-
-  qint32 numEngines;
-  qint32 engineType; // 0 = Piston 1 = Jet 2 = None 3 = Helo(Bell) turbine 4 = Unsupported 5 = Turboprop
 };
 
-/* Struct that will be filled with raw data from the simconnect interface. */
+/* Struct that will be filled with raw data from the simconnect interface.
+ * Received in tagged format where the datum id is the index of the 4 byte field. */
 struct SimData
 {
   SimDataAircraft aircraft;
@@ -154,6 +174,8 @@ struct SimData
   qint32 timeZoneOffsetSeconds;
 };
 
+static_assert(sizeof(SimData) % sizeof(DWORD) == 0, "SimData fields have to be 4 bytes wide");
+
 class SimConnectHandlerPrivate
 {
 public:
@@ -172,19 +194,45 @@ public:
   /* Static method will pass call to object which is passed in pContext. */
   static void CALLBACK dispatchCallback(SIMCONNECT_RECV *pData, DWORD cbData, void *pContext);
 
+  /* Adds a variable to the definition. Uses the index of the variable as datum id which is needed to find
+   * the field when receiving data in tagged format. */
+  void addToDataDefinition(DataDefinitionId definitionId, const char *datumName, const char *unitsName,
+                           SIMCONNECT_DATATYPE datumType);
+
   void fillDataDefinitionAicraft(DataDefinitionId definitionId);
-  void copyToSimData(const SimDataAircraft& simDataUserAircraft,
+  void fillDataDefinitionAicraftStatic(DataDefinitionId definitionId);
+  void copyToSimData(const SimDataAircraftStatic& simDataStatic, const SimDataAircraft& simDataUserAircraft,
                      atools::fs::sc::SimConnectAircraft& aircraft);
 
+  /* Copy data in tagged format into the struct at data having the given size.
+   * Returns false if the message is malformed. */
+  bool copyTaggedData(void *data, size_t size, const SIMCONNECT_RECV_SIMOBJECT_DATA *objData, DWORD cbData);
+
+  /* Request static data once for all AI objects which are neither cached nor requested yet */
+  bool requestAiStaticData();
+
   bool checkCall(HRESULT hr, const QString& message);
   bool callDispatch(bool& dataFetched, const QString& message);
 
+  /* Wait until SimConnect signals the event handle or timeoutMs passed. Sleeps if no event handle is available. */
+  void waitForEvent(unsigned long timeoutMs);
+
+  /* Latest values pushed by the simulator for the user aircraft */
   SimData simData;
-  unsigned long simDataObjectId;
+  SimDataAircraftStatic simDataStatic;
+  unsigned long simDataObjectId = 0;
 
   QVector<SimDataAircraft> simDataAircraft;
   QVector<unsigned long> simDataAircraftObjectIds;
 
+  /* Static data of AI objects by object id and ids of objects where static data is requested but not received */
+  QHash<unsigned long, SimDataAircraftStatic> aiStaticCache;
+  QSet<unsigned long> aiStaticRequested;
+  DWORD nextAiStaticRequestId = DATA_REQUEST_ID_AI_STATIC_FIRST;
+
+  /* Next datum id for each data definition */
+  QHash<int, DWORD> datumIds;
+
   sc::State state = sc::STATEOK;
 
   atools::fs::sc::WeatherRequest weatherRequest;
@@ -192,14 +240,21 @@ public:
   SIMCONNECT_EXCEPTION simconnectException;
   SIMCONNECT_RECV_OPEN openData;
 
+  AiFetchFilter aiFilter;
+
+  /* Signalled by SimConnect when messages are available */
+  HANDLE eventHandle = NULL;
+
   bool simRunning = true, simPaused = false, verbose = false, simConnectLoaded = false,
-       userDataFetched = false, aiDataFetched = false, weatherDataFetched = false;
+       userDataFetched = false, aiDataFetched = false, weatherDataFetched = false,
+       frameSubscribed = false, frameReceived = false;
+
+  /* userDataReceived is set for each message for the user aircraft while the others are kept once received */
+  bool userDataReceived = false, userDynamicValid = false, userStaticValid = false, aiStaticFetched = false;
 };
 
 void SimConnectHandlerPrivate::dispatchProcedure(SIMCONNECT_RECV *pData, DWORD cbData)
 {
-  Q_UNUSED(cbData);
-
   if(verbose)
     qDebug() << "DispatchProcedure entered";
 
@@ -259,74 +314,117 @@ void SimConnectHandlerPrivate::dispatchProcedure(SIMCONNECT_RECV *pData, DWORD c
               qDebug() << "EVENT_SIM_STATE" << evt->dwData;
             simRunning = evt->dwData == 1;
             break;
+
+          case EVENT_SIM_FRAME:
+            frameReceived = true;
+            break;
         }
         break;
       }
 
-    case SIMCONNECT_RECV_ID_SIMOBJECT_DATA_BYTYPE:
+    case SIMCONNECT_RECV_ID_SIMOBJECT_DATA:
       {
-        SIMCONNECT_RECV_SIMOBJECT_DATA_BYTYPE *pObjData = static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA_BYTYPE *>(pData);
+        // Data from period or one time requests for single objects
+        SIMCONNECT_RECV_SIMOBJECT_DATA *pObjData = static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA *>(pData);
+
+        if(verbose)
+          qDebug() << "SIMCONNECT_RECV_ID_SIMOBJECT_DATA"
+                   << "pObjData->dwDefineCount" << pObjData->dwDefineCount
+                   << "pObjData->dwDefineID" << pObjData->dwDefineID
+                   << "pObjData->dwFlags" << pObjData->dwFlags
+                   << "pObjData->dwObjectID" << pObjData->dwObjectID
+                   << "pObjData->dwRequestID" << pObjData->dwRequestID;
 
         if(pObjData->dwRequestID == DATA_REQUEST_ID_USER_AIRCRAFT)
         {
+          // Changed values only - update the fields of the last received data
+          if(pObjData->dwFlags & SIMCONNECT_DATA_REQUEST_FLAG_TAGGED)
+          {
+            if(!copyTaggedData(&simData, sizeof(simData), pObjData, cbData))
+            {
+              qWarning() << Q_FUNC_INFO << "Invalid tagged data for user aircraft";
+              break;
+            }
+          }
+          else
+            simData = *reinterpret_cast<SimData *>(&pObjData->dwData);
+
           if(verbose)
-            qDebug() << "DATA_REQUEST_ID_USER_AIRCRAFT"
-                     << "pObjData->dwDefineCount" << pObjData->dwDefineCount
-                     << "pObjData->dwDefineID" << pObjData->dwDefineID
-                     << "pObjData->dwID" << pObjData->dwID
-                     << "pObjData->dwObjectID" << pObjData->dwObjectID
-                     << "pObjData->dwRequestID" << pObjData->dwRequestID
-                     << "pObjData->dwentrynumber" << pObjData->dwentrynumber
-                     << "pObjData->dwoutof" << pObjData->dwoutof;
+            qDebug() << "ObjectID" << pObjData->dwObjectID
+                     << "Lat" << simData.aircraft.latitudeDeg
+                     << "Lon" << simData.aircraft.longitudeDeg
+                     << "Alt" << simData.aircraft.altitudeFt
+                     << "ias" << simData.aircraft.airspeedIndicatedKts
+                     << "gs" << simData.aircraft.groundVelocityKts
+                     << "vs" << simData.aircraft.verticalSpeedFps
+                     << "course " << simData.aircraft.planeHeadingMagneticDeg
+                     << "M" << simData.aircraft.planeHeadingTrueDeg << "T"
+                     << "track " << simData.planeTrackMagneticDeg
+                     << "M" << simData.planeTrackTrueDeg << "T"
+                     << "wind" << simData.ambientWindDirectionDegT
+                     << "/" << simData.ambientWindVelocityKts
+                     << "magvar" << simData.magVarDeg
+                     << "local time" << simData.localTime
+                     << "local year" << simData.localYear
+                     << "local month" << simData.localMonth
+                     << "local day" << simData.localDay
+                     << "zulu time" << simData.zuluTimeSeconds
+                     << "zulu year" << simData.zuluYear
+                     << "zulu month" << simData.zuluMonth
+                     << "zulu day" << simData.zuluDay;
+
+          simDataObjectId = pObjData->dwObjectID;
+          userDynamicValid = userDataReceived = true;
+        }
+        else if(pObjData->dwRequestID == DATA_REQUEST_ID_USER_AIRCRAFT_STATIC ||
+                (pObjData->dwRequestID >= DATA_REQUEST_ID_AI_STATIC_FIRST &&
+                 pObjData->dwRequestID <= DATA_REQUEST_ID_AI_STATIC_LAST))
+        {
+          SimDataAircraftStatic *staticPtr = reinterpret_cast<SimDataAircraftStatic *>(&pObjData->dwData);
 
-          DWORD objectID = pObjData->dwObjectID;
-          SimData *simDataPtr = reinterpret_cast<SimData *>(&pObjData->dwData);
+          if(FAILED(StringCbLengthA(&staticPtr->aircraftTitle[0], sizeof(staticPtr->aircraftTitle), NULL)))
+            // security check
+            break;
 
           if(verbose)
-            qDebug() << "ObjectID" << objectID
-                     << "Title" << simDataPtr->aircraft.aircraftTitle
-                     << "atcType" << simDataPtr->aircraft.aircraftAtcType
-                     << "atcModel" << simDataPtr->aircraft.aircraftAtcModel
-                     << "atcId" << simDataPtr->aircraft.aircraftAtcId
-                     << "atcAirline" << simDataPtr->aircraft.aircraftAtcAirline
-                     << "atcFlightNumber" << simDataPtr->aircraft.aircraftAtcFlightNumber
-                     << "category" << simDataPtr->aircraft.category
-                     << "userSim" << simDataPtr->aircraft.userSim
-                     << "modelRadius" << simDataPtr->aircraft.modelRadius
-                     << "wingSpan" << simDataPtr->aircraft.wingSpan
-                     << "aiFrom" << simDataPtr->aircraft.aiFrom
-                     << "aiTo" << simDataPtr->aircraft.aiTo
-                     << "numEngines" << simDataPtr->aircraft.numEngines
-                     << "engineType" << simDataPtr->aircraft.engineType
-                     << "Lat" << simDataPtr->aircraft.latitudeDeg
-                     << "Lon" << simDataPtr->aircraft.longitudeDeg
-                     << "Alt" << simDataPtr->aircraft.altitudeFt
-                     << "ias" << simDataPtr->aircraft.airspeedIndicatedKts
-                     << "gs" << simDataPtr->aircraft.groundVelocityKts
-                     << "vs" << simDataPtr->aircraft.verticalSpeedFps
-                     << "course " << simDataPtr->aircraft.planeHeadingMagneticDeg
-                     << "M" << simDataPtr->aircraft.planeHeadingTrueDeg << "T"
-                     << "track " << simDataPtr->planeTrackMagneticDeg
-                     << "M" << simDataPtr->planeTrackTrueDeg << "T"
-                     << "wind" << simDataPtr->ambientWindDirectionDegT
-                     << "/" << simDataPtr->ambientWindVelocityKts
-                     << "magvar" << simDataPtr->magVarDeg
-                     << "local time" << simDataPtr->localTime
-                     << "local year" << simDataPtr->localYear
-                     << "local month" << simDataPtr->localMonth
-                     << "local day" << simDataPtr->localDay
-                     << "zulu time" << simDataPtr->zuluTimeSeconds
-                     << "zulu year" << simDataPtr->zuluYear
-                     << "zulu month" << simDataPtr->zuluMonth
-                     << "zulu day" << simDataPtr->zuluDay
-            ;
-          simData = *simDataPtr;
-          simDataObjectId = objectID;
-          userDataFetched = true;
+            qDebug() << "ObjectID" << pObjData->dwObjectID
+                     << "Title" << staticPtr->aircraftTitle
+                     << "atcType" << staticPtr->aircraftAtcType
+                     << "atcModel" << staticPtr->aircraftAtcModel
+                     << "atcId" << staticPtr->aircraftAtcId
+                     << "atcAirline" << staticPtr->aircraftAtcAirline
+                     << "atcFlightNumber" << staticPtr->aircraftAtcFlightNumber
+                     << "category" << staticPtr->category
+                     << "userSim" << staticPtr->userSim
+                     << "modelRadius" << staticPtr->modelRadius
+                     << "wingSpan" << staticPtr->wingSpan
+                     << "aiFrom" << staticPtr->aiFrom
+                     << "aiTo" << staticPtr->aiTo
+                     << "numEngines" << staticPtr->numEngines
+                     << "engineType" << staticPtr->engineType;
+
+          if(pObjData->dwRequestID == DATA_REQUEST_ID_USER_AIRCRAFT_STATIC)
+          {
+            simDataStatic = *staticPtr;
+            userStaticValid = userDataReceived = true;
+          }
+          else
+          {
+            aiStaticCache.insert(pObjData->dwObjectID, *staticPtr);
+            aiStaticRequested.remove(pObjData->dwObjectID);
+            aiStaticFetched = true;
+          }
         }
-        else if(pObjData->dwRequestID == DATA_REQUEST_ID_AI_AIRCRAFT ||
-                pObjData->dwRequestID == DATA_REQUEST_ID_AI_HELICOPTER ||
-                pObjData->dwRequestID == DATA_REQUEST_ID_AI_BOAT)
+        break;
+      }
+
+    case SIMCONNECT_RECV_ID_SIMOBJECT_DATA_BYTYPE:
+      {
+        SIMCONNECT_RECV_SIMOBJECT_DATA_BYTYPE *pObjData = static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA_BYTYPE *>(pData);
+
+        if(pObjData->dwRequestID == DATA_REQUEST_ID_AI_AIRCRAFT ||
+           pObjData->dwRequestID == DATA_REQUEST_ID_AI_HELICOPTER ||
+           pObjData->dwRequestID == DATA_REQUEST_ID_AI_BOAT)
         {
           if(verbose)
             qDebug() << "DATA_REQUEST_ID_AI_AIRCRAFT/HELICOPTER/BOAT"
@@ -340,44 +438,26 @@ void SimConnectHandlerPrivate::dispatchProcedure(SIMCONNECT_RECV *pData, DWORD c
 
           if(pObjData->dwObjectID > 0)
           {
+            // Only dynamic values - static data is requested separately once per object and user aircraft
+            // is filtered out later using the static data
             DWORD objectID = pObjData->dwObjectID;
             SimDataAircraft *simDataAircraftPtr = reinterpret_cast<SimDataAircraft *>(&pObjData->dwData);
 
-            if(simDataAircraftPtr->userSim == 0 && // Do not add user aircraft to list
-               SUCCEEDED(StringCbLengthA(&simDataAircraftPtr->aircraftTitle[0],
-                                         sizeof(simDataAircraftPtr->aircraftTitle),
-                                         NULL))) // security check
-            {
-              if(verbose)
-                qDebug() << "ObjectID" << objectID
-                         << "Title" << simDataAircraftPtr->aircraftTitle
-                         << "atcType" << simDataAircraftPtr->aircraftAtcType
-                         << "atcModel" << simDataAircraftPtr->aircraftAtcModel
-                         << "atcId" << simDataAircraftPtr->aircraftAtcId
-                         << "atcAirline" << simDataAircraftPtr->aircraftAtcAirline
-                         << "atcFlightNumber" << simDataAircraftPtr->aircraftAtcFlightNumber
-                         << "category" << simDataAircraftPtr->category
-                         << "userSim" << simDataAircraftPtr->userSim
-                         << "modelRadius" << simDataAircraftPtr->modelRadius
-                         << "wingSpan" << simDataAircraftPtr->wingSpan
-                         << "aiFrom" << simDataAircraftPtr->aiFrom
-                         << "aiTo" << simDataAircraftPtr->aiTo
-                         << "numEngines" << simDataAircraftPtr->numEngines
-                         << "engineType" << simDataAircraftPtr->engineType
-                         << "Lat" << simDataAircraftPtr->latitudeDeg
-                         << "Lon" << simDataAircraftPtr->longitudeDeg
-                         << "Alt" << simDataAircraftPtr->altitudeFt
-                         << "ias" << simDataAircraftPtr->airspeedIndicatedKts
-                         << "gs" << simDataAircraftPtr->groundVelocityKts
-                         << "vs" << simDataAircraftPtr->verticalSpeedFps
-                         << "course " << simDataAircraftPtr->planeHeadingMagneticDeg << "M"
-                         << simDataAircraftPtr->planeHeadingTrueDeg << "T"
-                ;
-
-              simDataAircraft.append(*simDataAircraftPtr);
-              simDataAircraftObjectIds.append(objectID);
-              aiDataFetched = true;
-            }
+            if(verbose)
+              qDebug() << "ObjectID" << objectID
+                       << "Lat" << simDataAircraftPtr->latitudeDeg
+                       << "Lon" << simDataAircraftPtr->longitudeDeg
+                       << "Alt" << simDataAircraftPtr->altitudeFt
+                       << "ias" << simDataAircraftPtr->airspeedIndicatedKts
+                       << "gs" << simDataAircraftPtr->groundVelocityKts
+                       << "vs" << simDataAircraftPtr->verticalSpeedFps
+                       << "course " << simDataAircraftPtr->planeHeadingMagneticDeg << "M"
+                       << simDataAircraftPtr->planeHeadingTrueDeg << "T"
+              ;
+
+            simDataAircraft.append(*simDataAircraftPtr);
+            simDataAircraftObjectIds.append(objectID);
+            aiDataFetched = true;
           }
         }
 
@@ -424,19 +504,24 @@ void CALLBACK SimConnectHandlerPrivate::dispatchCallback(SIMCONNECT_RECV *pData,
   handlerClass->dispatchProcedure(pData, cbData);
 }
 
-void SimConnectHandlerPrivate::copyToSimData(const SimDataAircraft& simDataUserAircraft, SimConnectAircraft& aircraft)
+void SimConnectHandlerPrivate::copyToSimData(const SimDataAircraftStatic& simDataStatic,
+                                             const SimDataAircraft& simDataUserAircraft, SimConnectAircraft& aircraft)
 {
   aircraft.flags = atools::fs::sc::SIM_FSX_P3D;
-  aircraft.airplaneTitle = simDataUserAircraft.aircraftTitle;
-  aircraft.airplaneModel = simDataUserAircraft.aircraftAtcModel;
-  aircraft.airplaneReg = simDataUserAircraft.aircraftAtcId;
-  aircraft.airplaneType = simDataUserAircraft.aircraftAtcType;
-  aircraft.airplaneAirline = simDataUserAircraft.aircraftAtcAirline;
-  aircraft.airplaneFlightnumber = simDataUserAircraft.aircraftAtcFlightNumber;
-  aircraft.fromIdent = simDataUserAircraft.aiFrom;
-  aircraft.toIdent = simDataUserAircraft.aiTo;
-
-  QString cat = QString(simDataUserAircraft.category).toLower().trimmed();
+
+  // Returns the already interned names for the object id if unchanged
+  SimConnectAircraftNames names;
+  names.airplaneTitle = simDataStatic.aircraftTitle;
+  names.airplaneModel = simDataStatic.aircraftAtcModel;
+  names.airplaneReg = simDataStatic.aircraftAtcId;
+  names.airplaneType = simDataStatic.aircraftAtcType;
+  names.airplaneAirline = simDataStatic.aircraftAtcAirline;
+  names.airplaneFlightnumber = simDataStatic.aircraftAtcFlightNumber;
+  names.fromIdent = simDataStatic.aiFrom;
+  names.toIdent = simDataStatic.aiTo;
+  aircraft.setNames(names);
+
+  QString cat = QString(simDataStatic.category).toLower().trimmed();
   if(cat == "airplane")
     aircraft.category = AIRPLANE;
   else if(cat == "helicopter")
@@ -452,11 +537,11 @@ void SimConnectHandlerPrivate::copyToSimData(const SimDataAircraft& simDataUserA
   else if(cat == "viewer")
     aircraft.category = VIEWER;
 
-  aircraft.wingSpanFt = static_cast<quint16>(simDataUserAircraft.wingSpan);
-  aircraft.modelRadiusFt = static_cast<quint16>(simDataUserAircraft.modelRadius);
+  aircraft.wingSpanFt = static_cast<quint16>(simDataStatic.wingSpan);
+  aircraft.modelRadiusFt = static_cast<quint16>(simDataStatic.modelRadius);
 
-  aircraft.numberOfEngines = static_cast<quint8>(simDataUserAircraft.numEngines);
-  aircraft.engineType = static_cast<EngineType>(simDataUserAircraft.engineType);
+  aircraft.numberOfEngines = static_cast<quint8>(simDataStatic.numEngines);
+  aircraft.engineType = static_cast<EngineType>(simDataStatic.engineType);
 
   aircraft.position.setLonX(simDataUserAircraft.longitudeDeg);
   aircraft.position.setLatY(simDataUserAircraft.latitudeDeg);
@@ -474,7 +559,7 @@ void SimConnectHandlerPrivate::copyToSimData(const SimDataAircraft& simDataUserA
 
   if(simDataUserAircraft.isSimOnGround > 0)
     aircraft.flags |= atools::fs::sc::ON_GROUND;
-  if(simDataUserAircraft.userSim > 0)
+  if(simDataStatic.userSim > 0)
     aircraft.flags |= atools::fs::sc::IS_USER;
 
   if(simPaused > 0)
@@ -521,7 +606,9 @@ bool SimConnectHandlerPrivate::callDispatch(bool& dataFetched, const QString& me
         qDebug() << "SimConnect_CallDispatch during " << message << ": Exception" << simconnectException;
     }
 
-    QThread::msleep(5);
+    if(!dataFetched)
+      // Returns early if the next message arrives
+      waitForEvent(5);
     dispatchCycles++;
   } while(!dataFetched && dispatchCycles < 50 && simconnectException == SIMCONNECT_EXCEPTION_NONE);
 
@@ -531,9 +618,29 @@ bool SimConnectHandlerPrivate::callDispatch(bool& dataFetched, const QString& me
   return true;
 }
 
-void SimConnectHandlerPrivate::fillDataDefinitionAicraft(DataDefinitionId definitionId)
+void SimConnectHandlerPrivate::waitForEvent(unsigned long timeoutMs)
 {
-  // Set up the data definition, but do not yet do anything with it
+#if defined(SIMCONNECT_BUILD)
+  if(eventHandle != NULL)
+  {
+    WaitForSingleObject(eventHandle, static_cast<DWORD>(timeoutMs));
+    return;
+  }
+#endif
+  QThread::msleep(timeoutMs);
+}
+
+void SimConnectHandlerPrivate::addToDataDefinition(DataDefinitionId definitionId, const char *datumName,
+                                                   const char *unitsName, SIMCONNECT_DATATYPE datumType)
+{
+  DWORD& datumId = datumIds[definitionId];
+  api.AddToDataDefinition(definitionId, datumName, unitsName, datumType, 0.f, datumId);
+  datumId++;
+}
+
+void SimConnectHandlerPrivate::fillDataDefinitionAicraftStatic(DataDefinitionId definitionId)
+{
+  // Variables which do not change for an object - requested once for AI and on change only for the user
   api.AddToDataDefinition(definitionId, "Title", NULL, SIMCONNECT_DATATYPE_STRING256);
 
   api.AddToDataDefinition(definitionId, "ATC Type", NULL, SIMCONNECT_DATATYPE_STRING256);
@@ -557,27 +664,78 @@ void SimConnectHandlerPrivate::fillDataDefinitionAicraft(DataDefinitionId defini
   api.AddToDataDefinition(definitionId, "AI Traffic Fromairport", NULL, SIMCONNECT_DATATYPE_STRING32);
   api.AddToDataDefinition(definitionId, "AI Traffic Toairport", NULL, SIMCONNECT_DATATYPE_STRING32);
 
-  api.AddToDataDefinition(definitionId, "Plane Altitude", "feet", SIMCONNECT_DATATYPE_FLOAT32);
-  api.AddToDataDefinition(definitionId, "Plane Latitude", "degrees", SIMCONNECT_DATATYPE_FLOAT32);
-  api.AddToDataDefinition(definitionId, "Plane Longitude", "degrees", SIMCONNECT_DATATYPE_FLOAT32);
+  api.AddToDataDefinition(definitionId, "Number of Engines", "number", SIMCONNECT_DATATYPE_INT32);
 
-  api.AddToDataDefinition(definitionId, "Ground Velocity", "knots", SIMCONNECT_DATATYPE_FLOAT32);
-  api.AddToDataDefinition(definitionId, "Indicated Altitude", "feet", SIMCONNECT_DATATYPE_FLOAT32);
+  api.AddToDataDefinition(definitionId, "Engine Type", "number", SIMCONNECT_DATATYPE_INT32);
+}
 
-  api.AddToDataDefinition(definitionId, "Plane Heading Degrees Magnetic", "degrees", SIMCONNECT_DATATYPE_FLOAT32);
+void SimConnectHandlerPrivate::fillDataDefinitionAicraft(DataDefinitionId definitionId)
+{
+  // Set up the data definition, but do not yet do anything with it
+  addToDataDefinition(definitionId, "Plane Altitude", "feet", SIMCONNECT_DATATYPE_FLOAT32);
+  addToDataDefinition(definitionId, "Plane Latitude", "degrees", SIMCONNECT_DATATYPE_FLOAT32);
+  addToDataDefinition(definitionId, "Plane Longitude", "degrees", SIMCONNECT_DATATYPE_FLOAT32);
 
-  api.AddToDataDefinition(definitionId, "Plane Heading Degrees True", "degrees", SIMCONNECT_DATATYPE_FLOAT32);
+  addToDataDefinition(definitionId, "Ground Velocity", "knots", SIMCONNECT_DATATYPE_FLOAT32);
+  addToDataDefinition(definitionId, "Indicated Altitude", "feet", SIMCONNECT_DATATYPE_FLOAT32);
 
-  api.AddToDataDefinition(definitionId, "Sim On Ground", "bool", SIMCONNECT_DATATYPE_INT32);
+  addToDataDefinition(definitionId, "Plane Heading Degrees Magnetic", "degrees", SIMCONNECT_DATATYPE_FLOAT32);
 
-  api.AddToDataDefinition(definitionId, "Airspeed True", "knots", SIMCONNECT_DATATYPE_FLOAT32);
-  api.AddToDataDefinition(definitionId, "Airspeed Indicated", "knots", SIMCONNECT_DATATYPE_FLOAT32);
-  api.AddToDataDefinition(definitionId, "Airspeed Mach", "mach", SIMCONNECT_DATATYPE_FLOAT32);
-  api.AddToDataDefinition(definitionId, "Vertical Speed", "feet per second", SIMCONNECT_DATATYPE_FLOAT32);
+  addToDataDefinition(definitionId, "Plane Heading Degrees True", "degrees", SIMCONNECT_DATATYPE_FLOAT32);
 
-  api.AddToDataDefinition(definitionId, "Number of Engines", "number", SIMCONNECT_DATATYPE_INT32);
+  addToDataDefinition(definitionId, "Sim On Ground", "bool", SIMCONNECT_DATATYPE_INT32);
 
-  api.AddToDataDefinition(definitionId, "Engine Type", "number", SIMCONNECT_DATATYPE_INT32);
+  addToDataDefinition(definitionId, "Airspeed True", "knots", SIMCONNECT_DATATYPE_FLOAT32);
+  addToDataDefinition(definitionId, "Airspeed Indicated", "knots", SIMCONNECT_DATATYPE_FLOAT32);
+  addToDataDefinition(definitionId, "Airspeed Mach", "mach", SIMCONNECT_DATATYPE_FLOAT32);
+  addToDataDefinition(definitionId, "Vertical Speed", "feet per second", SIMCONNECT_DATATYPE_FLOAT32);
+}
+
+bool SimConnectHandlerPrivate::copyTaggedData(void *data, size_t size, const SIMCONNECT_RECV_SIMOBJECT_DATA *objData,
+                                              DWORD cbData)
+{
+  const char *end = reinterpret_cast<const char *>(objData) + cbData;
+  const DWORD *datum = &objData->dwData;
+
+  // Each datum is the datum id followed by the 4 byte value
+  for(DWORD i = 0; i < objData->dwDefineCount; i++)
+  {
+    if(reinterpret_cast<const char *>(datum + 2) > end)
+      return false;
+
+    size_t offset = static_cast<size_t>(datum[0]) * sizeof(DWORD);
+    if(offset + sizeof(DWORD) > size)
+      return false;
+
+    memcpy(static_cast<char *>(data) + offset, &datum[1], sizeof(DWORD));
+    datum += 2;
+  }
+  return true;
+}
+
+bool SimConnectHandlerPrivate::requestAiStaticData()
+{
+  bool requested = false;
+  for(unsigned long objectId : simDataAircraftObjectIds)
+  {
+    if(aiStaticCache.contains(objectId) || aiStaticRequested.contains(objectId))
+      continue;
+
+    HRESULT hr = api.RequestDataOnSimObject(nextAiStaticRequestId, DATA_DEFINITION_AIRCRAFT_STATIC,
+                                            static_cast<SIMCONNECT_OBJECT_ID>(objectId), SIMCONNECT_PERIOD_ONCE);
+    if(!checkCall(hr, "DATA_REQUEST_ID_AI_STATIC"))
+      return false;
+
+    if(++nextAiStaticRequestId > DATA_REQUEST_ID_AI_STATIC_LAST)
+      nextAiStaticRequestId = DATA_REQUEST_ID_AI_STATIC_FIRST;
+
+    aiStaticRequested.insert(objectId);
+    requested = true;
+  }
+
+  if(requested)
+    callDispatch(aiStaticFetched, "DATA_REQUEST_ID_AI_STATIC");
+  return true;
 }
 
 // ===============================================================================================
@@ -596,6 +754,11 @@ SimConnectHandler::~SimConnectHandler()
   if(hr != S_OK)
     qWarning() << "Error closing SimConnect";
 
+#if defined(SIMCONNECT_BUILD)
+  if(p->eventHandle != NULL)
+    CloseHandle(p->eventHandle);
+#endif
+
   p->context.freeLibrary("SimConnect.dll");
   p->context.deactivate();
   p->context.release();
@@ -675,124 +838,147 @@ bool SimConnectHandler::connect()
   if(p->verbose)
     qDebug() << "Before open";
 
-  hr = p->api.Open("Little Navconnect", NULL, 0, 0, 0);
+#if defined(SIMCONNECT_BUILD)
+  if(p->eventHandle == NULL)
+    // Auto reset event which is signalled by SimConnect for each new message
+    p->eventHandle = CreateEvent(NULL, FALSE, FALSE, NULL);
+#endif
+
+  p->frameSubscribed = false;
+  hr = p->api.Open("Little Navconnect", NULL, 0, p->eventHandle, 0);
   if(hr == S_OK)
   {
     if(p->verbose)
       qDebug() << "Connected to Flight Simulator";
 
+    // Definitions are valid for this connection only
+    p->datumIds.clear();
+    p->aiStaticCache.clear();
+    p->aiStaticRequested.clear();
+    p->userDynamicValid = p->userStaticValid = p->userDataFetched = false;
+
+    p->fillDataDefinitionAicraftStatic(DATA_DEFINITION_AIRCRAFT_STATIC);
     p->fillDataDefinitionAicraft(DATA_DEFINITION_AI_AIRCRAFT);
     p->fillDataDefinitionAicraft(DATA_DEFINITION_AI_HELICOPTER);
     p->fillDataDefinitionAicraft(DATA_DEFINITION_AI_BOAT);
     p->fillDataDefinitionAicraft(DATA_DEFINITION_USER_AIRCRAFT);
 
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Magvar",
-                               "degrees", SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "GPS Ground Magnetic Track",
-                               "degrees", SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "GPS Ground True Track",
-                               "degrees",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Plane Alt Above Ground",
-                               "feet",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ground Altitude", "feet",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Temperature",
-                               "celsius",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Total Air Temperature",
-                               "celsius",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Wind Velocity",
-                               "knots",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Wind Direction",
-                               "degrees",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Precip State",
-                               "mask",
-                               SIMCONNECT_DATATYPE_INT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient In Cloud", "bool",
-                               SIMCONNECT_DATATYPE_INT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Visibility",
-                               "meters",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Sea Level Pressure",
-                               "millibars",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Pitot Ice Pct", "percent",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Structural Ice Pct",
-                               "percent",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Total Weight", "pounds",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Max Gross Weight",
-                               "pounds",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Empty Weight", "pounds",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Fuel Total Quantity",
-                               "gallons",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT,
-                               "Fuel Total Quantity Weight",
-                               "pounds",
-                               SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow PPH:1",
-                               "Pounds per hour", SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow PPH:2",
-                               "Pounds per hour", SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow PPH:3",
-                               "Pounds per hour", SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow PPH:4",
-                               "Pounds per hour", SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow GPH:1",
-                               "Gallons per hour", SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow GPH:2",
-                               "Gallons per hour", SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow GPH:3",
-                               "Gallons per hour", SIMCONNECT_DATATYPE_FLOAT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow GPH:4",
-                               "Gallons per hour", SIMCONNECT_DATATYPE_FLOAT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Local Time",
-                               "seconds", SIMCONNECT_DATATYPE_INT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Local Year",
-                               "number", SIMCONNECT_DATATYPE_INT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Local Month of Year",
-                               "number", SIMCONNECT_DATATYPE_INT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Local Day of Month",
-                               "number", SIMCONNECT_DATATYPE_INT32);
-
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Zulu Time",
-                               "seconds", SIMCONNECT_DATATYPE_INT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Zulu Year",
-                               "number", SIMCONNECT_DATATYPE_INT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Zulu Month of Year",
-                               "number", SIMCONNECT_DATATYPE_INT32);
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Zulu Day of Month",
-                               "number", SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Magvar",
+                           "degrees", SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "GPS Ground Magnetic Track",
+                           "degrees", SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "GPS Ground True Track",
+                           "degrees",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Plane Alt Above Ground",
+                           "feet",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ground Altitude", "feet",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Temperature",
+                           "celsius",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Total Air Temperature",
+                           "celsius",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Wind Velocity",
+                           "knots",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Wind Direction",
+                           "degrees",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Precip State",
+                           "mask",
+                           SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient In Cloud", "bool",
+                           SIMCONNECT_DATATYPE_INT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Ambient Visibility",
+                           "meters",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Sea Level Pressure",
+                           "millibars",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Pitot Ice Pct", "percent",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Structural Ice Pct",
+                           "percent",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Total Weight", "pounds",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Max Gross Weight",
+                           "pounds",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Empty Weight", "pounds",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Fuel Total Quantity",
+                           "gallons",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT,
+                           "Fuel Total Quantity Weight",
+                           "pounds",
+                           SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow PPH:1",
+                           "Pounds per hour", SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow PPH:2",
+                           "Pounds per hour", SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow PPH:3",
+                           "Pounds per hour", SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow PPH:4",
+                           "Pounds per hour", SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow GPH:1",
+                           "Gallons per hour", SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow GPH:2",
+                           "Gallons per hour", SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow GPH:3",
+                           "Gallons per hour", SIMCONNECT_DATATYPE_FLOAT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Eng Fuel Flow GPH:4",
+                           "Gallons per hour", SIMCONNECT_DATATYPE_FLOAT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Local Time",
+                           "seconds", SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Local Year",
+                           "number", SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Local Month of Year",
+                           "number", SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Local Day of Month",
+                           "number", SIMCONNECT_DATATYPE_INT32);
+
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Zulu Time",
+                           "seconds", SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Zulu Year",
+                           "number", SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Zulu Month of Year",
+                           "number", SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Zulu Day of Month",
+                           "number", SIMCONNECT_DATATYPE_INT32);
 
     // Measured in seconds, positive west of GMT.
-    p->api.AddToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Time Zone Offset",
-                               "seconds", SIMCONNECT_DATATYPE_INT32);
+    p->addToDataDefinition(DATA_DEFINITION_USER_AIRCRAFT, "Time Zone Offset",
+                           "seconds", SIMCONNECT_DATATYPE_INT32);
+
+    // Let the simulator push changed values for the user aircraft instead of polling the whole definition
+    p->api.RequestDataOnSimObject(DATA_REQUEST_ID_USER_AIRCRAFT, DATA_DEFINITION_USER_AIRCRAFT,
+                                  SIMCONNECT_OBJECT_ID_USER, SIMCONNECT_PERIOD_SIM_FRAME,
+                                  SIMCONNECT_DATA_REQUEST_FLAG_CHANGED | SIMCONNECT_DATA_REQUEST_FLAG_TAGGED,
+                                  0, USER_AIRCRAFT_FRAME_INTERVAL);
+    p->api.RequestDataOnSimObject(DATA_REQUEST_ID_USER_AIRCRAFT_STATIC, DATA_DEFINITION_AIRCRAFT_STATIC,
+                                  SIMCONNECT_OBJECT_ID_USER, SIMCONNECT_PERIOD_SECOND,
+                                  SIMCONNECT_DATA_REQUEST_FLAG_CHANGED);
 
     // Request an event when the simulation starts or pauses
     p->api.SubscribeToSystemEvent(EVENT_SIM_STATE, "Sim");
@@ -811,6 +997,40 @@ bool SimConnectHandler::connect()
   }
 }
 
+bool SimConnectHandler::waitForData(unsigned long timeoutMs)
+{
+  if(p->eventHandle == NULL || p->state != sc::STATEOK)
+    return ConnectHandler::waitForData(timeoutMs);
+
+  if(!p->frameSubscribed)
+  {
+    // Subscribe on first call only to avoid the overhead for polling clients
+    p->api.SubscribeToSystemEvent(EVENT_SIM_FRAME, "Frame");
+    p->frameSubscribed = true;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  p->frameReceived = false;
+  p->simconnectException = SIMCONNECT_EXCEPTION_NONE;
+
+  // Process all messages until a frame event arrives - also updates pause and running state
+  while(!p->frameReceived && timer.elapsed() < static_cast<qint64>(timeoutMs))
+  {
+    p->waitForEvent(timeoutMs - static_cast<unsigned long>(timer.elapsed()));
+
+    if(p->api.CallDispatch(SimConnectHandlerPrivate::dispatchCallback, p) != S_OK &&
+       p->simconnectException != SIMCONNECT_EXCEPTION_NONE)
+      break;
+  }
+  return p->frameReceived;
+}
+
+void SimConnectHandler::setAiFetchPolicy(const AiFetchPolicy& policy)
+{
+  p->aiFilter.setPolicy(policy);
+}
+
 bool SimConnectHandler::fetchData(atools::fs::sc::SimConnectData& data, int radiusKm, atools::fs::sc::Options options)
 {
   if(p->verbose)
@@ -819,7 +1039,6 @@ bool SimConnectHandler::fetchData(atools::fs::sc::SimConnectData& data, int radi
   // === Get AI aircraft =======================================================
   p->simDataAircraft.clear();
   p->simDataAircraftObjectIds.clear();
-  p->simDataObjectId = 0;
 
   HRESULT hr = 0;
 
@@ -850,38 +1069,93 @@ bool SimConnectHandler::fetchData(atools::fs::sc::SimConnectData& data, int radi
   p->callDispatch(p->aiDataFetched,
                   "DATA_REQUEST_ID_AI_HELICOPTER, DATA_REQUEST_ID_AI_BOAT and DATA_REQUEST_ID_AI_AIRCRAFT");
 
-  // === Get user aircraft =======================================================
-  hr = p->api.RequestDataOnSimObjectType(
-    DATA_REQUEST_ID_USER_AIRCRAFT, DATA_DEFINITION_USER_AIRCRAFT, 0,
-    SIMCONNECT_SIMOBJECT_TYPE_USER);
-  if(!p->checkCall(hr, "DATA_REQUEST_ID_USER_AIRCRAFT"))
+  // Static data like title or registration is requested only for objects not seen before
+  if(p->aiDataFetched && !p->requestAiStaticData())
     return false;
 
-  p->callDispatch(p->userDataFetched, "DATA_REQUEST_ID_USER_AIRCRAFT");
+  // === Get user aircraft =======================================================
+  // Values are pushed by the simulator on change - wait only if nothing was received yet after connecting
+  if(!(p->userDynamicValid && p->userStaticValid))
+    p->callDispatch(p->userDataReceived, "DATA_REQUEST_ID_USER_AIRCRAFT");
+  else
+    // Process pushed messages without waiting
+    p->api.CallDispatch(SimConnectHandlerPrivate::dispatchCallback, p);
+  p->userDataFetched = p->userDynamicValid && p->userStaticValid;
 
   p->state = sc::STATEOK;
 
   // Get user aircraft =======================================================================
   QSet<unsigned long> objectIds;
+
+  // Use user position from last fetch for distance bands
+  p->aiFilter.startFetch(p->userDataFetched ?
+                         atools::geo::Pos(p->simData.aircraft.longitudeDeg, p->simData.aircraft.latitudeDeg) :
+                         atools::geo::Pos());
   for(int i = 0; i < p->simDataAircraft.size(); i++)
   {
     unsigned long oid = p->simDataAircraftObjectIds.at(i);
     // Avoid duplicates
     if(!objectIds.contains(oid))
     {
-      atools::fs::sc::SimConnectAircraft aircraft;
-      p->copyToSimData(p->simDataAircraft.at(i), aircraft);
-      aircraft.objectId = static_cast<unsigned int>(oid);
-      data.aiAircraft.append(aircraft);
-      objectIds.insert(aircraft.objectId);
+      objectIds.insert(oid);
+
+      // Skip objects where static data did not arrive yet and the user aircraft
+      QHash<unsigned long, SimDataAircraftStatic>::const_iterator staticIt = p->aiStaticCache.constFind(oid);
+      if(staticIt == p->aiStaticCache.constEnd() || staticIt->userSim != 0)
+        continue;
+
+      const SimDataAircraft& simAircraft = p->simDataAircraft.at(i);
+      unsigned int objectId = static_cast<unsigned int>(oid);
+      AiDetail detail = p->aiFilter.getDetail(objectId, atools::geo::Pos(simAircraft.longitudeDeg,
+                                                                         simAircraft.latitudeDeg));
+      if(detail == AI_SKIP)
+        continue;
+
+      const SimConnectAircraft *last = detail == AI_LAST ? p->aiFilter.getLastAircraft(objectId) : nullptr;
+      if(last != nullptr)
+        // Far object which is not updated in this cycle
+        data.aiAircraft.append(*last);
+      else
+      {
+        atools::fs::sc::SimConnectAircraft aircraft;
+        aircraft.objectId = objectId;
+        p->copyToSimData(staticIt.value(), simAircraft, aircraft);
+
+        if(detail == AI_POSITION)
+          AiFetchFilter::reduceToPosition(aircraft);
+        data.aiAircraft.append(aircraft);
+      }
+      p->aiFilter.addAircraft(data.aiAircraft.constLast());
+    }
+  }
+  p->aiFilter.finishFetch();
+
+  if(p->aiDataFetched)
+  {
+    // Drop static data of objects which are gone or out of range
+    for(QHash<unsigned long, SimDataAircraftStatic>::iterator it = p->aiStaticCache.begin();
+        it != p->aiStaticCache.end();)
+    {
+      if(objectIds.contains(it.key()))
+        ++it;
+      else
+        it = p->aiStaticCache.erase(it);
+    }
+
+    for(QSet<unsigned long>::iterator it = p->aiStaticRequested.begin(); it != p->aiStaticRequested.end();)
+    {
+      if(objectIds.contains(*it))
+        ++it;
+      else
+        it = p->aiStaticRequested.erase(it);
     }
   }
 
   // Get user aircraft =======================================================================
   if(p->userDataFetched)
   {
-    p->copyToSimData(p->simData.aircraft, data.userAircraft);
     data.userAircraft.objectId = static_cast<unsigned int>(p->simDataObjectId);
+    p->copyToSimData(p->simDataStatic, p->simData.aircraft, data.userAircraft);
 
     data.userAircraft.groundAltitudeFt = p->simData.groundAltitudeFt;
     data.userAircraft.altitudeAboveGroundFt = p->simData.planeAboveGroundFt;
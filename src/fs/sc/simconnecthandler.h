@@ -32,6 +32,8 @@ class SimConnectAircraft;
 class SimConnectHandlerPrivate;
 
 /* Reads data synchronously from Fs simconnect interfaces.
+ *  Changed values of the user aircraft are pushed by the simulator and static AI data like titles is
+ *  requested only once per object id.
  *  For non windows platforms contains also a simple aircraft simulation. */
 class SimConnectHandler :
   public atools::fs::sc::ConnectHandler
@@ -64,6 +66,13 @@ public:
   /* Get state of last call. */
   virtual sc::State getState() const override;
 
+  /* Waits for the SimConnect frame event. Subscribes to the event on first call.
+   * Falls back to sleeping if no event handle is available. */
+  virtual bool waitForData(unsigned long timeoutMs) override;
+
+  /* Objects are filtered before conversion */
+  virtual void setAiFetchPolicy(const atools::fs::sc::AiFetchPolicy& policy) override;
+
   virtual QString getName() const override;
 
 private:
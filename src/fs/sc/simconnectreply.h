@@ -34,8 +34,12 @@ namespace sc {
 // quint16
 enum CommandEnum
 {
-  CMD_NONE,
-  CMD_WEATHER_REQUEST
+  CMD_NONE = 0,
+  CMD_WEATHER_REQUEST = 1 << 0,
+
+  /* Set in normal replies by clients which can read the compact data format using SimConnectDataCodec.
+   * Server switches to compact format after receiving this. */
+  CMD_COMPACT_DATA = 1 << 1
 };
 
 Q_DECLARE_FLAGS(Command, CommandEnum);
@@ -38,7 +38,8 @@ enum SimConnectStatus
   INVALID_MAGIC_NUMBER, /* Packet data does not start with expected magic number */
   VERSION_MISMATCH, /* Client and server data version does not match for either data or reply */
   INSUFFICIENT_WRITE, /* Wrote less than block */
-  WRITE_ERROR /* Error from IO device */
+  WRITE_ERROR, /* Error from IO device */
+  DECODE_ERROR /* Compact packet could not be decoded */
 };
 
 enum Option
@@ -17,12 +17,15 @@
 
 #include "fs/sc/xpconnecthandler.h"
 
+#include "fs/sc/sharedmemoryring.h"
 #include "fs/sc/weatherrequest.h"
 
 #include "fs/sc/simconnectdata.h"
 
 #include <QBuffer>
 #include <QDataStream>
+#include <QElapsedTimer>
+#include <QThread>
 
 namespace atools {
 namespace fs {
@@ -59,6 +62,17 @@ bool XpConnectHandler::connect()
   else
   {
     qInfo() << Q_FUNC_INFO << "Attached to" << sharedMemory.key() << "native" << sharedMemory.nativeKey();
+
+    SharedMemoryRing *sharedRing = new SharedMemoryRing(sharedMemory.data(), sharedMemory.size());
+    if(sharedRing->isValid())
+    {
+      qInfo() << Q_FUNC_INFO << "Using ring buffer format";
+      ring = sharedRing;
+      ringFrameNumber = 0;
+    }
+    else
+      delete sharedRing;
+
     state = STATEOK;
     return true;
   }
@@ -75,6 +89,9 @@ bool XpConnectHandler::fetchData(fs::sc::SimConnectData& data, int radiusKm, fs:
     return false;
   }
 
+  if(ring != nullptr)
+    return fetchRingData(data, options);
+
   if(sharedMemory.lock())
   {
     quint32 size;
@@ -93,6 +110,8 @@ bool XpConnectHandler::fetchData(fs::sc::SimConnectData& data, int radiusKm, fs:
 
       buffer.seek(sizeof(size) + sizeof(terminate));
       data.read(&buffer);
+      lastFetchHash = qHash(QByteArray::fromRawData(static_cast<const char *>(sharedMemory.data()),
+                                                    static_cast<int>(size)));
       sharedMemory.unlock();
 
       if(terminate)
@@ -106,6 +125,8 @@ bool XpConnectHandler::fetchData(fs::sc::SimConnectData& data, int radiusKm, fs:
         if(!(options & atools::fs::sc::FETCH_AI_AIRCRAFT))
           // Have to clear this here since the X-Plane plugin has no configuration option
           data.getAiAircraft().clear();
+        else
+          aiFilter.filter(data.getAiAircraft(), data.getUserAircraftConst().getPosition());
 
         return true;
       }
@@ -119,6 +140,81 @@ bool XpConnectHandler::fetchData(fs::sc::SimConnectData& data, int radiusKm, fs:
   return false;
 }
 
+bool XpConnectHandler::fetchRingData(SimConnectData& data, Options options)
+{
+  if(ring->isTerminate())
+  {
+    disconnect();
+    return false;
+  }
+
+  // Always read the latest frame even if it was read before like the legacy format
+  quint32 frameNumber = 0;
+  if(ring->read(data, frameNumber) && data.isUserAircraftValid())
+  {
+    ringFrameNumber = frameNumber;
+
+    if(!(options & atools::fs::sc::FETCH_AI_AIRCRAFT))
+      // Have to clear this here since the X-Plane plugin has no configuration option
+      data.getAiAircraft().clear();
+    else
+      aiFilter.filter(data.getAiAircraft(), data.getUserAircraftConst().getPosition());
+    return true;
+  }
+
+  // Skipped since writer was updating or nothing written yet
+  return false;
+}
+
+void XpConnectHandler::setAiFetchPolicy(const AiFetchPolicy& policy)
+{
+  aiFilter.setPolicy(policy);
+}
+
+bool XpConnectHandler::waitForData(unsigned long timeoutMs)
+{
+  if(!sharedMemory.isAttached())
+    return ConnectHandler::waitForData(timeoutMs);
+
+  QElapsedTimer timer;
+  timer.start();
+  while(timer.elapsed() < static_cast<qint64>(timeoutMs))
+  {
+    if(ring != nullptr)
+    {
+      // Frame counter can be checked without locking
+      if(ring->getFrameNumber() != ringFrameNumber)
+        return true;
+
+      QThread::msleep(std::min(2UL, timeoutMs));
+    }
+    else
+    {
+      if(sharedMemoryHash() != lastFetchHash)
+        return true;
+
+      QThread::msleep(std::min(10UL, timeoutMs));
+    }
+  }
+  return false;
+}
+
+uint XpConnectHandler::sharedMemoryHash()
+{
+  uint hash = 0;
+  if(sharedMemory.lock())
+  {
+    quint32 size;
+    QDataStream stream(QByteArray::fromRawData(static_cast<const char *>(sharedMemory.data()), sizeof(size)));
+    stream >> size;
+
+    if(size > 0 && size <= static_cast<quint32>(sharedMemory.size()))
+      hash = qHash(QByteArray::fromRawData(static_cast<const char *>(sharedMemory.data()), static_cast<int>(size)));
+    sharedMemory.unlock();
+  }
+  return hash;
+}
+
 bool XpConnectHandler::fetchWeatherData(fs::sc::SimConnectData& data)
 {
   Q_UNUSED(data);
@@ -163,6 +259,9 @@ QString XpConnectHandler::getName() const
 
 void XpConnectHandler::disconnect()
 {
+  delete ring;
+  ring = nullptr;
+
   bool result = sharedMemory.detach();
   qDebug() << Q_FUNC_INFO << "result" << result;
   state = DISCONNECTED;
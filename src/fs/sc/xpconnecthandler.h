@@ -19,6 +19,7 @@
 #define ATOOLS_XPCONNECTHANDLER_H
 
 #include "fs/sc/connecthandler.h"
+#include "fs/sc/aifetchfilter.h"
 
 #include <QSharedMemory>
 #include <functional>
@@ -31,6 +32,12 @@ namespace sc {
 static const int SHARED_MEMORY_SIZE = 8196;
 static const QLatin1Literal SHARED_MEMORY_KEY("LittleXpconnect");
 
+/* Layout for the lock free ring buffer format. See SharedMemoryRing. */
+static const int SHARED_MEMORY_RING_SLOTS = 4;
+static const int SHARED_MEMORY_RING_SLOT_SIZE = 256 * 1024;
+
+class SharedMemoryRing;
+
 /*
  * Reads data from a callback function into SimConnectData.
  */
@@ -45,7 +52,7 @@ public:
   XpConnectHandler();
   virtual ~XpConnectHandler();
 
-  /* Attach to shared memory if available */
+  /* Attach to shared memory if available. Detects ring buffer or legacy format. */
   virtual bool connect() override;
 
   /* Always loaded since X-Plane is always available */
@@ -74,13 +81,34 @@ public:
   /* State shows if we are attached or not */
   virtual atools::fs::sc::State getState() const override;
 
+  /* Polls the shared memory at a short interval and returns true as soon as the plugin wrote a new packet.
+   * Cheaper than fetching since only a hash of the memory is calculated. */
+  virtual bool waitForData(unsigned long timeoutMs) override;
+
+  /* Applied after reading since X-Plane plugin sends all objects */
+  virtual void setAiFetchPolicy(const atools::fs::sc::AiFetchPolicy& policy) override;
+
   /* Symbolic name for logging */
   QString getName() const override;
 
 private:
   void disconnect();
 
+  /* Hash of shared memory content or 0 if it cannot be read */
+  uint sharedMemoryHash();
+
+  /* Fetch from ring buffer without locking */
+  bool fetchRingData(SimConnectData& data, Options options);
+
   QSharedMemory sharedMemory;
+  atools::fs::sc::AiFetchFilter aiFilter;
+
+  /* Hash of shared memory at the time of the last fetch */
+  uint lastFetchHash = 0;
+
+  /* Not null if the plugin uses the ring buffer format */
+  SharedMemoryRing *ring = nullptr;
+  quint32 ringFrameNumber = 0;
   atools::fs::sc::State state = DISCONNECTED;
 
 };
@@ -49,11 +49,11 @@ void AddOnCfg::onEndDocument(const QString& filename)
 
 void AddOnCfg::onStartSection(const QString& section, const QString& sectionSuffix)
 {
-  if(section == "package" || section == "discoverypath")
+  if(section == QLatin1String("package") || section == QLatin1String("discoverypath"))
   {
     bool ok = false;
     currentEntry.packageNum = sectionSuffix.toInt(&ok);
-    currentEntry.discoveryPath = section == "discoverypath";
+    currentEntry.discoveryPath = section == QLatin1String("discoverypath");
     if(!ok)
     {
       qWarning() << "Entry number" << sectionSuffix << "not valid in section" << section;
@@ -65,7 +65,7 @@ void AddOnCfg::onStartSection(const QString& section, const QString& sectionSuff
 void AddOnCfg::onEndSection(const QString& section, const QString& sectionSuffix)
 {
   Q_UNUSED(sectionSuffix)
-  if(section == "package" || section == "discoverypath")
+  if(section == QLatin1String("package") || section == QLatin1String("discoverypath"))
   {
     if(currentEntry.discoveryPath)
       entriesDiscovery.append(currentEntry);
@@ -80,11 +80,11 @@ void AddOnCfg::onKeyValue(const QString& section, const QString& sectionSuffix,
                           const QString& value)
 {
   Q_UNUSED(sectionSuffix)
-  if(section == "package" || section == "discoverypath")
+  if(section == QLatin1String("package") || section == QLatin1String("discoverypath"))
   {
-    if(key == "title")
+    if(key == QLatin1String("title"))
       currentEntry.title = value;
-    else if(key == "path")
+    else if(key == QLatin1String("path"))
     {
 #ifdef Q_OS_UNIX
       currentEntry.path = QString(value).replace("\\", "/");
@@ -92,9 +92,9 @@ void AddOnCfg::onKeyValue(const QString& section, const QString& sectionSuffix,
       currentEntry.path = value;
 #endif
     }
-    else if(key == "active")
+    else if(key == QLatin1String("active"))
       currentEntry.active = toBool(value);
-    else if(key == "required")
+    else if(key == QLatin1String("required"))
       currentEntry.required = toBool(value);
     else
       qWarning() << "Unexpected key" << key << "in section" << section << "file" << filepath;
@@ -0,0 +1,123 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/scenery/directorycache.h"
+
+#include <QDir>
+
+namespace atools {
+namespace fs {
+namespace scenery {
+
+DirectoryCache::DirectoryCache()
+{
+
+}
+
+DirectoryCache::~DirectoryCache()
+{
+
+}
+
+void DirectoryCache::clear()
+{
+  listings.clear();
+}
+
+const DirectoryCache::Listing& DirectoryCache::listing(const QString& dir)
+{
+  QString key = QDir::cleanPath(QFileInfo(dir).absoluteFilePath());
+
+  QHash<QString, Listing>::const_iterator it = listings.constFind(key);
+  if(it != listings.constEnd())
+    return it.value();
+
+  // Not cached yet - read directory once
+  Listing listing;
+  listing.entries = QDir(key).entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+                                            QDir::Name | QDir::IgnoreCase);
+  for(int i = 0; i < listing.entries.size(); i++)
+    listing.index.insert(listing.entries.at(i).fileName(), i);
+
+  return listings.insert(key, listing).value();
+}
+
+QFileInfo DirectoryCache::fileInfo(const QString& path)
+{
+  QFileInfo fileinfo(QDir::cleanPath(QFileInfo(path).absoluteFilePath()));
+
+  if(fileinfo.fileName().isEmpty())
+    // Root directory which has no parent listing
+    return fileinfo;
+
+  const Listing& dirListing = listing(fileinfo.path());
+  QHash<QString, int>::const_iterator it = dirListing.index.constFind(fileinfo.fileName());
+  return it != dirListing.index.constEnd() ? dirListing.entries.at(it.value()) : QFileInfo();
+}
+
+QFileInfoList DirectoryCache::entryInfoList(const QString& dir, const QStringList& nameFilters, bool files, bool dirs)
+{
+  QFileInfoList retval;
+  for(const QFileInfo& entry : listing(dir).entries)
+  {
+    if(((files && entry.isFile()) || (dirs && entry.isDir())) &&
+       (nameFilters.isEmpty() || QDir::match(nameFilters, entry.fileName())))
+      retval.append(entry);
+  }
+  return retval;
+}
+
+QString DirectoryCache::buildPathNoCase(const QStringList& paths)
+{
+#if defined(Q_OS_WIN32)
+  return paths.join(QDir::separator());
+
+#else
+  QString retval;
+  for(int i = 0; i < paths.size(); i++)
+  {
+    const QString& path = paths.at(i);
+    if(i == 0)
+      // First path element
+      retval = path;
+    else
+    {
+      QString name = path;
+      const Listing& dirListing = listing(retval);
+      if(!dirListing.index.contains(path))
+      {
+        // No exact match - compare ignoring case
+        for(const QFileInfo& entry : dirListing.entries)
+        {
+          if(entry.fileName().compare(path, Qt::CaseInsensitive) == 0)
+          {
+            name = entry.fileName();
+            break;
+          }
+        }
+      }
+      retval += QDir::separator() + name;
+    }
+  }
+  return retval;
+
+#endif
+}
+
+} // namespace scenery
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,97 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SCENERY_DIRECTORYCACHE_H
+#define ATOOLS_SCENERY_DIRECTORYCACHE_H
+
+#include <QFileInfo>
+#include <QHash>
+
+namespace atools {
+namespace fs {
+namespace scenery {
+
+/*
+ * Caches directory listings to avoid repeated file system access when resolving scenery paths.
+ * Each directory is listed only once on first access and all exists, file type and case insensitive
+ * name checks are answered from the listing. Speeds up loading on network drives and Wine.
+ *
+ * Changes in the file system are not detected. Call clear() before each compilation.
+ * Not thread safe.
+ */
+class DirectoryCache
+{
+public:
+  DirectoryCache();
+  ~DirectoryCache();
+
+  /* Remove all cached listings */
+  void clear();
+
+  /* Get file information from listing of parent directory. Returns a default constructed QFileInfo
+   * for which exists() is false if not found. */
+  QFileInfo fileInfo(const QString& path);
+
+  bool exists(const QString& path)
+  {
+    return fileInfo(path).exists();
+  }
+
+  bool isFile(const QString& path)
+  {
+    return fileInfo(path).isFile();
+  }
+
+  bool isDir(const QString& path)
+  {
+    return fileInfo(path).isDir();
+  }
+
+  /* Get all entries of a directory which are matching the wildcard name filters ignoring case or all if filters
+   * is empty. Sorted by name ignoring case. Includes hidden and system files but not "." and "..".
+   * Returns an empty list if the directory does not exist. */
+  QFileInfoList entryInfoList(const QString& dir, const QStringList& nameFilters = QStringList(),
+                              bool files = true, bool dirs = true);
+
+  /* Same as atools::buildPathNoCase() but uses the cached directory listings */
+  QString buildPathNoCase(const QStringList& paths);
+
+  int getNumListings() const
+  {
+    return listings.size();
+  }
+
+private:
+  struct Listing
+  {
+    QFileInfoList entries;
+
+    /* Index into entries by file name */
+    QHash<QString, int> index;
+  };
+
+  const Listing& listing(const QString& dir);
+
+  /* Key is cleaned absolute directory path */
+  QHash<QString, Listing> listings;
+};
+
+} // namespace scenery
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_SCENERY_DIRECTORYCACHE_H
@@ -19,8 +19,10 @@
 #include "fs/scenery/sceneryarea.h"
 #include "fs/navdatabaseoptions.h"
 #include "fs/scenery/layoutjson.h"
+#include "fs/scenery/directorycache.h"
 
 #include <QtDebug>
+#include <QDateTime>
 #include <QFile>
 #include <QDir>
 
@@ -40,6 +42,20 @@ FileResolver::~FileResolver()
 }
 
 int FileResolver::getFiles(const SceneryArea& area, QStringList *filepaths, QStringList *filenames)
+{
+  return getFilesInternal(area, filepaths, filenames, nullptr);
+}
+
+int FileResolver::getFiles(const SceneryArea& area, SceneryAreaFiles& files)
+{
+  files = SceneryAreaFiles();
+  int numFiles = getFilesInternal(area, &files.filepaths, &files.filenames, &files);
+  files.errorMessages = errorMessages;
+  return numFiles;
+}
+
+int FileResolver::getFilesInternal(const SceneryArea& area, QStringList *filepaths, QStringList *filenames,
+                                   SceneryAreaFiles *files)
 {
   if((!area.isActive() && !options.isReadInactive()) || !options.isIncludedLocalPath(area.getLocalPath()))
     return 0;
@@ -74,7 +90,9 @@ int FileResolver::getFiles(const SceneryArea& area, QStringList *filepaths, QStr
   // Remove any .. in the path but do not change symlinks
   qInfo() << "Scenery path" << sceneryAreaDirStr;
 
-  QFileInfo sceneryArea(QFileInfo(sceneryAreaDirStr).absoluteFilePath());
+  QFileInfo sceneryArea = directoryCache != nullptr ?
+                          directoryCache->fileInfo(sceneryAreaDirStr) :
+                          QFileInfo(QFileInfo(sceneryAreaDirStr).absoluteFilePath());
   if(sceneryArea.exists())
   {
     if(sceneryArea.isDir())
@@ -88,9 +106,13 @@ int FileResolver::getFiles(const SceneryArea& area, QStringList *filepaths, QStr
         // Get all scenery folders for FSX and P3D
         QDir sceneryAreaDir(sceneryArea.filePath());
 
-        sceneryDirs.append(sceneryAreaDir.entryInfoList({"scenery"},
-                                                        QDir::Dirs | QDir::Hidden | QDir::System |
-                                                        QDir::NoDotAndDotDot));
+        if(directoryCache != nullptr)
+          sceneryDirs.append(directoryCache->entryInfoList(sceneryArea.filePath(), {"scenery"},
+                                                           false /* files */, true /* dirs */));
+        else
+          sceneryDirs.append(sceneryAreaDir.entryInfoList({"scenery"},
+                                                          QDir::Dirs | QDir::Hidden | QDir::System |
+                                                          QDir::NoDotAndDotDot));
 
         if(sceneryDirs.isEmpty() && sceneryAreaDir.dirName().toLower() == "scenery")
           // Special case where entry points to scenery directory which is allowed by P3D
@@ -116,15 +138,27 @@ int FileResolver::getFiles(const SceneryArea& area, QStringList *filepaths, QStr
               layout.read(scenery.absoluteFilePath() + SEP + "layout.json");
 
               for(const QString& path : layout.getBglPaths())
-                bglFiles.append(sceneryArea.filePath() + SEP + path);
+              {
+                if(directoryCache != nullptr)
+                  bglFiles.append(directoryCache->fileInfo(sceneryArea.filePath() + SEP + path));
+                else
+                  bglFiles.append(sceneryArea.filePath() + SEP + path);
+              }
             }
             else
             {
               // Read all BGL files from directory structure ==============
-              QDir sceneryAreaDirObj(scenery.absoluteFilePath());
-              bglFiles = sceneryAreaDirObj.entryInfoList({"*.bgl"},
-                                                         QDir::Files | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
-                                                         QDir::Name | QDir::IgnoreCase);
+              if(directoryCache != nullptr)
+                bglFiles = directoryCache->entryInfoList(scenery.absoluteFilePath(), {"*.bgl"},
+                                                         true /* files */, false /* dirs */);
+              else
+              {
+                QDir sceneryAreaDirObj(scenery.absoluteFilePath());
+                bglFiles = sceneryAreaDirObj.entryInfoList({"*.bgl"},
+                                                           QDir::Files | QDir::Hidden | QDir::System |
+                                                           QDir::NoDotAndDotDot,
+                                                           QDir::Name | QDir::IgnoreCase);
+              }
             }
 
             // Get all BGL files
@@ -143,6 +177,14 @@ int FileResolver::getFiles(const SceneryArea& area, QStringList *filepaths, QStr
                     filepaths->append(filepath);
                   if(filenames != nullptr)
                     filenames->append(filename);
+                  if(files != nullptr)
+                  {
+                    files->sizes.append(bglFile.size());
+                    files->lastModified.append(bglFile.lastModified().toMSecsSinceEpoch());
+                    files->progressSteps.append(SceneryAreaFiles::progressStepsForSize(bglFile.size()));
+                    files->totalSize += bglFile.size();
+                    files->totalProgressSteps += files->progressSteps.last();
+                  }
                 }
               }
               else
@@ -19,6 +19,7 @@
 #define ATOOLS_SCENERY_FILERESOLVER_H
 
 #include <QList>
+#include <QVector>
 #include <QStringList>
 #include <QApplication>
 
@@ -28,6 +29,46 @@ class NavDatabaseOptions;
 namespace scenery {
 
 class SceneryArea;
+class DirectoryCache;
+
+/*
+ * Manifest of the resolved BGL files of one scenery area. Built once and used for progress totals,
+ * scenery area fingerprints and reading.
+ */
+struct SceneryAreaFiles
+{
+  /* Size of a file giving one additional progress step */
+  static Q_DECL_CONSTEXPR qint64 PROGRESS_BYTES_PER_STEP = 1024L * 1024L;
+
+  /* Progress steps for a file. Weighted by size but at least one. */
+  static int progressStepsForSize(qint64 size)
+  {
+    return 1 + static_cast<int>(size / PROGRESS_BYTES_PER_STEP);
+  }
+
+  int size() const
+  {
+    return filepaths.size();
+  }
+
+  bool isEmpty() const
+  {
+    return filepaths.isEmpty();
+  }
+
+  /* Path including filename and filename only */
+  QStringList filepaths, filenames;
+
+  /* Size in bytes, modification time as milliseconds since epoch and progress steps for each file */
+  QVector<qint64> sizes, lastModified;
+  QVector<int> progressSteps;
+
+  /* Errors like missing directories found while resolving */
+  QStringList errorMessages;
+
+  qint64 totalSize = 0L;
+  int totalProgressSteps = 0;
+};
 
 /*
  * Collects all BGL files for a scenery area considering include and exclude configuration options.
@@ -54,15 +95,28 @@ public:
   int getFiles(const atools::fs::scenery::SceneryArea& area, QStringList *filepaths = nullptr,
                QStringList *filenames = nullptr);
 
+  /* Resolve files and get paths, sizes and progress weights. Error messages are copied to files. */
+  int getFiles(const atools::fs::scenery::SceneryArea& area, atools::fs::scenery::SceneryAreaFiles& files);
+
   const QStringList& getErrorMessages() const
   {
     return errorMessages;
   }
 
+  /* Use cached directory listings for all file system access if not null. Cache is not owned. */
+  void setDirectoryCache(atools::fs::scenery::DirectoryCache *value)
+  {
+    directoryCache = value;
+  }
+
 private:
+  int getFilesInternal(const atools::fs::scenery::SceneryArea& area, QStringList *filepaths,
+                       QStringList *filenames, atools::fs::scenery::SceneryAreaFiles *files);
+
   QStringList errorMessages;
   const atools::fs::NavDatabaseOptions& options;
   bool quiet = false;
+  atools::fs::scenery::DirectoryCache *directoryCache = nullptr;
 };
 
 } // namespace scenery
@@ -19,16 +19,41 @@
 
 #include "exception.h"
 
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
 #include <QDebug>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMutex>
 
 namespace atools {
 namespace fs {
 namespace scenery {
 
+namespace {
+
+/* Parsed layout file and file state at time of reading */
+struct LayoutCacheEntry
+{
+  QDateTime lastModified;
+  qint64 size;
+  QStringList bglPaths, materialPaths;
+};
+
+QMutex cacheMutex;
+QHash<QString, LayoutCacheEntry> cache;
+
+} // namespace
+
+void LayoutJson::clearCache()
+{
+  QMutexLocker locker(&cacheMutex);
+  cache.clear();
+}
+
 /*
  *  {
  *  "content": [
@@ -53,22 +78,48 @@ namespace scenery {
  */
 void LayoutJson::read(const QString& filename)
 {
+  QFileInfo fileinfo(filename);
+  QDateTime lastModified = fileinfo.lastModified();
+  qint64 size = fileinfo.size();
+
+  {
+    // Use cached paths if file is not changed
+    QMutexLocker locker(&cacheMutex);
+    QHash<QString, LayoutCacheEntry>::const_iterator it = cache.constFind(filename);
+    if(it != cache.constEnd() && it->lastModified == lastModified && it->size == size)
+    {
+      bglPaths.append(it->bglPaths);
+      materialPaths.append(it->materialPaths);
+      return;
+    }
+  }
+
   QFile file(filename);
   if(file.open(QIODevice::ReadOnly))
   {
     QJsonParseError error;
     QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
 
+    LayoutCacheEntry entry;
+    entry.lastModified = lastModified;
+    entry.size = size;
+
     QJsonArray arr = doc.object().value("content").toArray();
     for(int i = 0; i < arr.count(); i++)
     {
       QString path = arr.at(i).toObject().value("path").toString();
       if(path.endsWith(".bgl", Qt::CaseInsensitive))
-        bglPaths.append(path);
+        entry.bglPaths.append(path);
       else if(path.endsWith("Library.xml", Qt::CaseInsensitive))
-        materialPaths.append(path);
+        entry.materialPaths.append(path);
     }
     file.close();
+
+    bglPaths.append(entry.bglPaths);
+    materialPaths.append(entry.materialPaths);
+
+    QMutexLocker locker(&cacheMutex);
+    cache.insert(filename, entry);
   }
   else
     qWarning() << Q_FUNC_INFO << "Cannot open file" << filename << file.errorString();
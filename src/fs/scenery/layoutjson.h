@@ -27,12 +27,20 @@ namespace scenery {
 /*
  * Reads MSFS layout file and extracts the locations for BGL and material "Library.xml" files.
  * Paths are kept relative as read from file.
+ *
+ * Parsed files are kept in a process wide cache which is keyed by file path and checked against
+ * the last modification time and size. The layout of a package is read several times during loading
+ * and again for each incremental load. Reading is thread safe.
  */
 class LayoutJson
 {
 public:
+  /* Read file or take paths from cache. Appends paths to the lists. */
   void read(const QString& filename);
 
+  /* Remove all cached files */
+  static void clearCache();
+
   void clear()
   {
     bglPaths.clear();
@@ -76,7 +76,7 @@ void SceneryCfg::setAreaHighPriority(int index, bool value)
 
 void SceneryCfg::onStartSection(const QString& section, const QString& sectionSuffix)
 {
-  if(section == "area")
+  if(section == QLatin1String("area"))
   {
     bool ok = false;
     currentArea.setAreaNumber(sectionSuffix.toInt(&ok));
@@ -91,7 +91,7 @@ void SceneryCfg::onStartSection(const QString& section, const QString& sectionSu
 void SceneryCfg::onEndSection(const QString& section, const QString& sectionSuffix)
 {
   Q_UNUSED(sectionSuffix);
-  if(section == "area")
+  if(section == QLatin1String("area"))
   {
     currentArea.fixTitle();
     if(!currentArea.getTitle().isEmpty() && currentArea.getAreaNumber() != -1 &&
@@ -108,26 +108,26 @@ void SceneryCfg::onKeyValue(const QString& section, const QString& sectionSuffix
                             const QString& value)
 {
   Q_UNUSED(sectionSuffix);
-  if(section == "general")
+  if(section == QLatin1String("general"))
   {
-    if(key == "title")
-      title = key;
-    else if(key == "description")
+    if(key == QLatin1String("title"))
+      title = value;
+    else if(key == QLatin1String("description"))
       description = value;
-    else if(key == "clean_on_exit")
+    else if(key == QLatin1String("clean_on_exit"))
       cleanOnExit = toBool(value);
     else
       qWarning() << "Unexpected key" << key << "in section" << section << "file" << filepath;
   }
-  else if(section == "area")
+  else if(section == QLatin1String("area"))
   {
-    if(key == "title")
+    if(key == QLatin1String("title"))
       currentArea.setTitle(value);
-    else if(key == "texture_id")
+    else if(key == QLatin1String("texture_id"))
       currentArea.setTextureId(toInt(value));
-    else if(key == "remote")
+    else if(key == QLatin1String("remote"))
       currentArea.setRemotePath(value);
-    else if(key == "local")
+    else if(key == QLatin1String("local"))
     {
 #ifdef Q_OS_UNIX
       currentArea.setLocalPath(QString(value).replace("\\", "/"));
@@ -135,13 +135,13 @@ void SceneryCfg::onKeyValue(const QString& section, const QString& sectionSuffix
       currentArea.setLocalPath(value);
 #endif
     }
-    else if(key == "layer")
+    else if(key == QLatin1String("layer"))
       currentArea.setLayer(toInt(value));
-    else if(key == "active")
+    else if(key == QLatin1String("active"))
       currentArea.setActive(toBool(value));
-    else if(key == "required")
+    else if(key == QLatin1String("required"))
       currentArea.setRequired(toBool(value));
-    else if(key == "exclude")
+    else if(key == QLatin1String("exclude"))
       currentArea.setExclude(value);
     else
       qWarning() << "Unexpected key" << key << "in section" << section << "file" << filepath;
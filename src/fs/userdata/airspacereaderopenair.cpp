@@ -21,9 +21,13 @@
 #include "fs/util/coordinates.h"
 #include "fs/common/binarygeometry.h"
 #include "exception.h"
+#include "atools.h"
 #include "sql/sqlquery.h"
+#include "sql/sqldatabase.h"
 
+#include <cmath>
 #include <QFile>
+#include <QTextStream>
 #include <QRegularExpression>
 
 using atools::sql::SqlQuery;
@@ -39,9 +43,50 @@ namespace userdata {
 // Extract values from AH and AL values
 static QRegularExpression MATCH_ALT("^(FL)?\\s*([0-9]+)\\s*(FL|FT|M[ $])?\\s*(AMSL|MSL|AGL|GND|AAGL|ASFC)?");
 
+/* Maximum distance between the tessellated and the exact arc or circle */
+static Q_DECL_CONSTEXPR double MAX_CHORD_ERROR_METER = 100.;
+static Q_DECL_CONSTEXPR int MIN_CIRCLE_SEGMENTS = 12;
+static Q_DECL_CONSTEXPR int MAX_CIRCLE_SEGMENTS = 180;
+
+/* Douglas-Peucker tolerance for removing nearly collinear polygon points */
+static Q_DECL_CONSTEXPR float SIMPLIFY_TOLERANCE_METER = 25.f;
+
+/* Number of airspaces to insert at once */
+static Q_DECL_CONSTEXPR int BOUNDARY_BATCH_SIZE = 250;
+
+/* Number of segments for a full circle so that the chord error is below MAX_CHORD_ERROR_METER */
+static int numCircleSegments(float radiusMeter)
+{
+  if(radiusMeter <= MAX_CHORD_ERROR_METER)
+    return MIN_CIRCLE_SEGMENTS;
+
+  // Chord error is r * (1 - cos(a / 2)) for the angle a of a segment
+  double segmentAngle = 2. * std::acos(1. - MAX_CHORD_ERROR_METER / radiusMeter);
+  int numSegments = static_cast<int>(std::ceil(2. * M_PI / segmentAngle));
+  return atools::minmax(MIN_CIRCLE_SEGMENTS, MAX_CIRCLE_SEGMENTS, numSegments);
+}
+
+/* Get trimmed comma separated field at index without allocations. Null if not present. */
+static QStringRef field(const QStringRef& str, int index)
+{
+  int start = 0;
+  for(int i = 0; i < index; i++)
+  {
+    start = str.indexOf(QChar(','), start);
+    if(start == -1)
+      return QStringRef();
+    start++;
+  }
+
+  int end = str.indexOf(QChar(','), start);
+  return str.mid(start, end == -1 ? -1 : end - start).trimmed();
+}
+
 AirspaceReaderOpenAir::AirspaceReaderOpenAir(atools::sql::SqlDatabase *sqlDb)
-  : AirspaceReaderBase(sqlDb)
+  : AirspaceReaderBase(sqlDb), boundaryRecord(sqlDb->record("boundary", ":"))
 {
+  curRecord = boundaryRecord;
+  boundaryRecords.reserve(BOUNDARY_BATCH_SIZE);
 }
 
 AirspaceReaderOpenAir::~AirspaceReaderOpenAir()
@@ -62,20 +107,28 @@ void AirspaceReaderOpenAir::readFile(int fileIdParam, const QString& filenamePar
   {
     QTextStream stream(&file);
 
-    int lineNum = 0;
-    while(!stream.atEnd())
+    // Line buffer is reused and all fields are references into it
+    QString line;
+    lineNumber = 0;
+    while(stream.readLineInto(&line))
     {
-      QString line = stream.readLine().trimmed();
+      QStringRef lineRef = line.midRef(0).trimmed();
 
-      if(!line.startsWith("AN"))
+      if(!lineRef.startsWith("AN"))
       {
         // Strip OpenAirport file comments except for airport names
-        int idx = line.indexOf("*");
+        int idx = lineRef.indexOf(QChar('*'));
         if(idx != -1)
-          line = line.left(line.indexOf("*"));
+          lineRef = lineRef.left(idx).trimmed();
       }
-      readLine(line.simplified().split(" "), fileId, filename, lineNum);
-      lineNum++;
+
+      // Split into key and value at first whitespace
+      int idx = 0;
+      while(idx < lineRef.size() && !lineRef.at(idx).isSpace())
+        idx++;
+
+      readLine(lineRef.left(idx), lineRef.mid(idx).trimmed());
+      lineNumber++;
     }
     finish();
 
@@ -93,44 +146,46 @@ void AirspaceReaderOpenAir::readLine(const QStringList& line, int fileIdParam, c
   lineNumber = lineNumberParam;
   fileId = fileIdParam;
 
-  QString key = at(line, 0);
+  QString key = line.value(0);
+  QString value = mid(line, 1, true /* ignoreError */);
+  readLine(QStringRef(&key), QStringRef(&value));
+}
 
-  if(writingCoordinates && !key.startsWith("D") && key != "V")
+void AirspaceReaderOpenAir::readLine(const QStringRef& key, const QStringRef& value)
+{
+  bool coordinate = key.startsWith('D') || key == "V";
+
+  if(writingCoordinates && !coordinate)
   {
     // Done with coordinates - write old boundary and start a new one
     writingCoordinates = false;
     writeBoundary();
   }
 
-  if(key.startsWith("D") || key == "V")
+  if(coordinate)
   {
     // Geomety or variables
     writingCoordinates = true;
-    bindCoordinate(line);
+    bindCoordinate(key, value);
   }
   else if(key == "AC")
-    // Class
-    bindClass(line.value(1));
+    // Class - first word only
+    bindClass(value.left(value.indexOf(QChar(' '))));
   else if(key == "AN")
     // Name
-    bindName(mid(line, 1));
+    bindName(value);
   else if(key == "AH")
     // Upper limit
-    bindAltitude(line, true /* max altitude */);
+    bindAltitude(value, true /* max altitude */);
   else if(key == "AL")
     // Lower limit
-    bindAltitude(line, false /* min altitude */);
+    bindAltitude(value, false /* min altitude */);
 }
 
 void AirspaceReaderOpenAir::writeBoundary()
 {
-  // insertAirspaceQuery->bindValue(":com_type", );
-  // insertAirspaceQuery->bindValue(":com_frequency", );
-  // insertAirspaceQuery->bindValue(":com_name", );
-  // insertAirspaceQuery->bindValue(":comment", );
-
-  insertAirspaceQuery->bindValue(":boundary_id", ++curAirspaceId);
-  insertAirspaceQuery->bindValue(":file_id", fileId);
+  curRecord.setValue(":boundary_id", ++curAirspaceId);
+  curRecord.setValue(":file_id", fileId);
 
   // Remove all remaining invalid points
   LineString::iterator it = std::remove_if(curLine.begin(), curLine.end(), [](const Pos& p) -> bool
@@ -144,6 +199,9 @@ void AirspaceReaderOpenAir::writeBoundary()
     curLine.erase(it, curLine.end());
   }
 
+  // Remove points which do not change the shape like duplicates at arc joins
+  curLine = curLine.simplified(SIMPLIFY_TOLERANCE_METER);
+
   if(curLine.size() > 2)
   {
     // calculate bounding rectangle
@@ -151,22 +209,24 @@ void AirspaceReaderOpenAir::writeBoundary()
 
     if(!bounding.isPoint())
     {
-      insertAirspaceQuery->bindValue(":max_lonx", bounding.getEast());
-      insertAirspaceQuery->bindValue(":max_laty", bounding.getNorth());
-      insertAirspaceQuery->bindValue(":min_lonx", bounding.getWest());
-      insertAirspaceQuery->bindValue(":min_laty", bounding.getSouth());
+      curRecord.setValue(":max_lonx", bounding.getEast());
+      curRecord.setValue(":max_laty", bounding.getNorth());
+      curRecord.setValue(":min_lonx", bounding.getWest());
+      curRecord.setValue(":min_laty", bounding.getSouth());
 
       // Create geometry blob
       atools::fs::common::BinaryGeometry geo(curLine);
-      insertAirspaceQuery->bindValue(":geometry", geo.writeToByteArray());
+      curRecord.setValue(":geometry", geo.writeToByteArray());
 
       // Fields not used by X-Plane
-      insertAirspaceQuery->bindValue(":restrictive_designation", QVariant(QVariant::String));
-      insertAirspaceQuery->bindValue(":restrictive_type", QVariant(QVariant::String));
-      insertAirspaceQuery->bindValue(":multiple_code", QVariant(QVariant::String));
-      insertAirspaceQuery->bindValue(":time_code", "U");
+      curRecord.setNull(":restrictive_designation");
+      curRecord.setNull(":restrictive_type");
+      curRecord.setNull(":multiple_code");
+      curRecord.setValue(":time_code", "U");
 
-      insertAirspaceQuery->exec();
+      boundaryRecords.append(curRecord);
+      if(boundaryRecords.size() >= BOUNDARY_BATCH_SIZE)
+        writeBoundaries();
 
       numAirspacesRead++;
     }
@@ -178,11 +238,14 @@ void AirspaceReaderOpenAir::writeBoundary()
   reset();
 }
 
-void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
+void AirspaceReaderOpenAir::writeBoundaries()
 {
-  QString key = at(line, 0).toUpper();
-  QString value = mid(line, 1).trimmed().toUpper();
+  insertAirspaceQuery->bindAndExecRecords(boundaryRecords);
+  boundaryRecords.clear();
+}
 
+void AirspaceReaderOpenAir::bindCoordinate(const QStringRef& key, const QStringRef& value)
+{
   if(key == "DP")
   {
     // DP coordinate - add polygon point
@@ -190,45 +253,45 @@ void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
     if(pos.isValidRange())
       curLine.append(pos);
     else
-      errWarn("Found invalid coordinates in airspace record DP: \"" + value + "\"");
+      errWarn("Found invalid coordinates in airspace record DP: \"" + value.toString() + "\"");
   }
   else if(key == "DA")
   {
     // DA radius, angleStart, angleEnd - add an arc, angles in degrees, radius in nm (set center using V X=...)
-    float radius = value.section(',', 0, 0).trimmed().toFloat();
-    float angleStart = value.section(',', 1, 1).trimmed().toFloat();
-    float angleEnd = value.section(',', 2, 2).trimmed().toFloat();
+    float radius = atools::geo::nmToMeter(field(value, 0).toFloat());
+    float angleStart = field(value, 1).toFloat();
+    float angleEnd = field(value, 2).toFloat();
 
     // Check minimum radius since some use it for color definitions
-    if(radius > 0.2f)
+    if(radius > atools::geo::nmToMeter(0.2f))
     {
-      Pos pos1 = center.endpoint(atools::geo::nmToMeter(radius), angleStart);
-      Pos pos2 = center.endpoint(atools::geo::nmToMeter(radius), angleEnd);
+      Pos pos1 = center.endpoint(radius, angleStart);
+      Pos pos2 = center.endpoint(radius, angleEnd);
       if(pos1.isValid() && pos2.isValid() && center.isValidRange())
-        curLine.append(LineString(center, pos1, pos2, clockwise, 24));
+        curLine.append(LineString(center, pos1, pos2, clockwise, numCircleSegments(radius)));
       else
-        errWarn("Found invalid coordinates in airspace record DA: \"" + value + "\"");
+        errWarn("Found invalid coordinates in airspace record DA: \"" + value.toString() + "\"");
     }
     clockwise = true;
   }
   else if(key == "DB")
   {
     // DB coordinate1, coordinate2 - add an arc, from coordinate1 to coordinate2 (set center using V X=...)
-    Pos pos1 = fromOpenAirFormat(value.section(',', 0, 0).trimmed());
-    Pos pos2 = fromOpenAirFormat(value.section(',', 1, 1).trimmed());
+    Pos pos1 = fromOpenAirFormat(field(value, 0));
+    Pos pos2 = fromOpenAirFormat(field(value, 1));
 
     if(pos1.isValid() && pos2.isValid() && center.isValidRange())
-      curLine.append(LineString(center, pos1, pos2, clockwise, 24));
+      curLine.append(LineString(center, pos1, pos2, clockwise, numCircleSegments(center.distanceMeterTo(pos1))));
     else
-      errWarn("Found invalid coordinates in airspace record DB: \"" + value + "\"");
+      errWarn("Found invalid coordinates in airspace record DB: \"" + value.toString() + "\"");
     clockwise = true;
   }
   else if(key == "DC")
   {
     // DC radius - draw a circle (center taken from the previous V X=... record, radius in nm
-    float radius = value.toFloat();
-    if(radius > 0.2f && center.isValidRange())
-      curLine.append(LineString(center, atools::geo::nmToMeter(radius), 24));
+    float radius = atools::geo::nmToMeter(value.toFloat());
+    if(radius > atools::geo::nmToMeter(0.2f) && center.isValidRange())
+      curLine.append(LineString(center, radius, numCircleSegments(radius)));
     else
       // Small values are apparently used to define colors
       qWarning() << filename << ":" << lineNumber <<
@@ -238,10 +301,11 @@ void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
   else if(key == "V")
   {
     // V x=n - Variable assignment. Currently the following variables are supported:
-    QString variableName = value.section('=', 0, 0).trimmed();
-    QString variableValue = value.section('=', 1).trimmed();
+    int idx = value.indexOf(QChar('='));
+    QStringRef variableName = value.left(idx).trimmed();
+    QStringRef variableValue = idx == -1 ? QStringRef() : value.mid(idx + 1).trimmed();
 
-    if(variableName == "D")
+    if(variableName.compare(QLatin1String("D"), Qt::CaseInsensitive) == 0)
     {
       if(variableValue == "+" || variableValue == "-")
         // D={+|-} sets direction for: DA and DB records
@@ -249,24 +313,24 @@ void AirspaceReaderOpenAir::bindCoordinate(const QStringList& line)
         // automatically reset to '+' at the begining of new airspace segment
         clockwise = variableValue == "+";
       else
-        errWarn("Invalid direction value in airspace record D: \"" + variableValue + "\"");
+        errWarn("Invalid direction value in airspace record D: \"" + variableValue.toString() + "\"");
     }
-    else if(variableName == "X")
+    else if(variableName.compare(QLatin1String("X"), Qt::CaseInsensitive) == 0)
     {
       // X=coordinate : sets the center for the following records: DA, DB, and DC
       center = fromOpenAirFormat(variableValue);
       if(!center.isValidRange())
-        errWarn("Invalid center coordinate in airspace record D: \"" + variableValue + "\"");
+        errWarn("Invalid center coordinate in airspace record D: \"" + variableValue.toString() + "\"");
     }
   }
 }
 
-void AirspaceReaderOpenAir::bindName(const QString& name)
+void AirspaceReaderOpenAir::bindName(const QStringRef& name)
 {
-  insertAirspaceQuery->bindValue(":name", name);
+  curRecord.setValue(":name", name.toString().simplified());
 }
 
-void AirspaceReaderOpenAir::bindClass(const QString& cls)
+void AirspaceReaderOpenAir::bindClass(const QStringRef& cls)
 {
   QString type;
 
@@ -302,19 +366,17 @@ void AirspaceReaderOpenAir::bindClass(const QString& cls)
     type = "MC"; // Mode C
   else
     qWarning() << filename << ":" << lineNumber << "Unknown airspace class" << cls;
-  insertAirspaceQuery->bindValue(":type", type);
+  curRecord.setValue(":type", type);
 }
 
-void AirspaceReaderOpenAir::bindAltitude(const QStringList& line, bool isMax)
+void AirspaceReaderOpenAir::bindAltitude(const QStringRef& value, bool isMax)
 {
   QString prefix = isMax ? ":max" : ":min";
   int unlimited = isMax ? 100000 : 0;
   int altitude = unlimited;
 
-  QString altStr, type;
-  if(line.size() > 1)
-    // Leave unknown if not given
-    altStr = mid(line, 1).toUpper();
+  // Leave unknown if not given
+  QString altStr = value.toString().simplified().toUpper(), type;
 
   if(altStr.startsWith("UN"))
   {
@@ -379,19 +441,22 @@ void AirspaceReaderOpenAir::bindAltitude(const QStringList& line, bool isMax)
     }
   }
 
-  insertAirspaceQuery->bindValue(prefix + "_altitude_type", type);
-  insertAirspaceQuery->bindValue(prefix + "_altitude", altitude);
+  curRecord.setValue(prefix + "_altitude_type", type);
+  curRecord.setValue(prefix + "_altitude", altitude);
 }
 
 void AirspaceReaderOpenAir::finish()
 {
   writeBoundary();
+  writeBoundaries();
 }
 
 void AirspaceReaderOpenAir::reset()
 {
   AirspaceReaderBase::reset();
 
+  // Queued airspaces are kept until written by finish()
+  curRecord.clearValues();
   curLine.clear();
   clockwise = true;
   writingCoordinates = false;
@@ -19,6 +19,7 @@
 #define ATOOLS_AIRSPACEREADER_OPENAIR_H
 
 #include "geo/linestring.h"
+#include "sql/sqlrecord.h"
 
 #include "fs/userdata/airspacereaderbase.h"
 
@@ -34,6 +35,10 @@ namespace userdata {
 /*
  * Reads OpenAir files containing airspaces and writes them to the boundary table.
  *
+ * Lines are parsed in place without splitting or regular expressions. Arcs and circles are tessellated
+ * depending on radius so that the chord error stays below a fixed limit. Boundaries are simplified and
+ * inserted in batches. Call finish() to write all remaining boundaries.
+ *
  * http://www.winpilot.com/UsersGuide/UserAirspace.asp
  */
 class AirspaceReaderOpenAir :
@@ -46,22 +51,38 @@ public:
   /* Read a whole file and write airspaces into table */
   virtual void readFile(int fileIdParam, const QString& filenameParam) override;
 
-  /* Read a line from a file and write to file if end of airspace detected */
+  /* Read a line from a file and write to file if end of airspace detected.
+   * Fields are joined and parsed like a line read by readFile(). */
   virtual void readLine(const QStringList& line, int fileIdParam, const QString& filenameParam,
                         int lineNumberParam) override;
 
-  /* Writes last airspace to table */
+  /* Writes last airspace and all queued ones to table */
   virtual void finish() override;
 
   /* reset internal values back */
   virtual void reset() override;
 
 private:
+  /* Process a line split into key and the trimmed rest */
+  void readLine(const QStringRef& key, const QStringRef& value);
+
+  /* Queue current airspace for batch insert and write batch if full */
   void writeBoundary();
-  void bindAltitude(const QStringList& line, bool isMax);
-  void bindClass(const QString& cls);
-  void bindName(const QString& name);
-  void bindCoordinate(const QStringList& line);
+
+  /* Insert all queued airspaces */
+  void writeBoundaries();
+
+  void bindAltitude(const QStringRef& value, bool isMax);
+  void bindClass(const QStringRef& cls);
+  void bindName(const QStringRef& name);
+  void bindCoordinate(const QStringRef& key, const QStringRef& value);
+
+  /* Empty record with all boundary columns and the current airspace */
+  const atools::sql::SqlRecord boundaryRecord;
+  atools::sql::SqlRecord curRecord;
+
+  /* Airspaces waiting for batch insert */
+  atools::sql::SqlRecordVector boundaryRecords;
 
   bool writingCoordinates = false;
   atools::geo::LineString curLine;
@@ -0,0 +1,409 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/userdata/bulkimporter.h"
+
+#include "exception.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "util/csvfilereader.h"
+#include "util/csvreader.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QQueue>
+#include <QTextStream>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <atomic>
+
+namespace atools {
+namespace fs {
+namespace userdata {
+
+/* Number of records passed at once from the reader to the writer */
+static const int RECORD_BATCH_SIZE = 1000;
+
+/* Maximum number of batches waiting for the writer */
+static const int MAX_QUEUED_BATCHES = 16;
+
+/* SQLite default limit for number of bound values in a statement */
+static const int MAX_BOUND_VALUES = 999;
+static const int MAX_ROWS_PER_STATEMENT = 100;
+
+void ImportRow::bindValue(const QString& name, const QVariant& value)
+{
+  QHash<QString, int>::const_iterator it = columnIndex->constFind(name);
+  if(it != columnIndex->constEnd())
+    values[it.value()] = value;
+  else
+    qWarning() << Q_FUNC_INFO << "Column not found" << name;
+}
+
+QVariant ImportRow::boundValue(const QString& name) const
+{
+  return values.value(columnIndex->value(name, -1));
+}
+
+/*
+ * Reads and splits the file in a separate thread. Passes batches of records to the writer.
+ */
+class BulkImportReader :
+  public QThread
+{
+public:
+  BulkImportReader(const BulkImporter *importerParam, QFile *fileParam)
+    : importer(importerParam), file(fileParam)
+  {
+  }
+
+  virtual ~BulkImportReader() override
+  {
+    stop();
+  }
+
+  /* Get next batch. Waits until data is available. Returns false if file is read completely. */
+  bool take(QVector<ImportRecord>& batch);
+
+  /* Stop reading and wait for thread termination */
+  void stop();
+
+  qint64 getBytesRead() const
+  {
+    return bytesRead;
+  }
+
+private:
+  virtual void run() override;
+
+  /* Read CSV from memory mapped file if separator and escape are single byte characters */
+  void readCsvFile();
+
+  /* Read lines using QTextStream */
+  void readLines();
+
+  void push(QVector<ImportRecord>& batch);
+
+  /* Returns true if stopped */
+  bool pushBatch(QVector<ImportRecord>& batch);
+  void finish(QVector<ImportRecord>& batch);
+
+  const BulkImporter *importer;
+  QFile *file;
+  std::atomic<qint64> bytesRead{0};
+
+  QQueue<QVector<ImportRecord> > queue;
+  bool finished = false, terminate = false;
+  QMutex mutex;
+  QWaitCondition notEmpty, notFull;
+};
+
+void BulkImportReader::run()
+{
+  if(importer->csv && importer->separator.unicode() < 128 && importer->escape.unicode() < 128)
+    readCsvFile();
+  else
+    readLines();
+}
+
+void BulkImportReader::readCsvFile()
+{
+  atools::util::CsvFileReader reader(importer->separator.toLatin1(), importer->escape.toLatin1(), importer->trim);
+  reader.open(file);
+
+  QVector<ImportRecord> batch;
+  batch.reserve(RECORD_BATCH_SIZE);
+  ImportRecord record;
+  while(reader.readRecord())
+  {
+    if(reader.getLineNumber() < importer->skipLines)
+      continue;
+
+    record.lineNumber = reader.getLineNumber();
+    record.line = reader.record();
+    reader.values(record.values);
+    batch.append(record);
+
+    if(batch.size() >= RECORD_BATCH_SIZE)
+    {
+      bytesRead = reader.getPosition();
+      if(pushBatch(batch))
+        return;
+    }
+  }
+
+  bytesRead = reader.getPosition();
+  finish(batch);
+}
+
+void BulkImportReader::readLines()
+{
+  QTextStream stream(file);
+  stream.setCodec("UTF-8");
+
+  atools::util::CsvReader reader(importer->separator, importer->escape, importer->trim);
+  QVector<ImportRecord> batch;
+  batch.reserve(RECORD_BATCH_SIZE);
+  ImportRecord record;
+  int lineNum = 0;
+
+  while(!stream.atEnd())
+  {
+    QString line = stream.readLine();
+    int curLineNum = lineNum++;
+
+    if(curLineNum < importer->skipLines)
+      continue;
+
+    if(importer->csv)
+    {
+      // Skip empty lines but add them if within an escaped field
+      if(line.isEmpty() && !reader.isInEscape())
+        continue;
+
+      if(!reader.isInEscape())
+      {
+        record.lineNumber = curLineNum;
+        record.line = line;
+      }
+      else
+        record.line.append('\n').append(line);
+
+      reader.readCsvLine(line);
+      if(reader.isInEscape())
+        // Still in an escaped line so continue to read unchanged until " shows the end of the field
+        continue;
+
+      record.values = reader.getValues();
+    }
+    else
+    {
+      QString simplified = line.simplified();
+      if(simplified.isEmpty())
+        continue;
+
+      record.lineNumber = curLineNum;
+      record.line = line;
+      record.values = simplified.split(importer->separator);
+    }
+
+    batch.append(record);
+    if(batch.size() >= RECORD_BATCH_SIZE)
+    {
+      bytesRead = file->pos();
+      if(pushBatch(batch))
+        return;
+    }
+  }
+
+  bytesRead = file->pos();
+  finish(batch);
+}
+
+bool BulkImportReader::pushBatch(QVector<ImportRecord>& batch)
+{
+  push(batch);
+
+  QMutexLocker locker(&mutex);
+  return terminate;
+}
+
+void BulkImportReader::finish(QVector<ImportRecord>& batch)
+{
+  push(batch);
+
+  QMutexLocker locker(&mutex);
+  finished = true;
+  notEmpty.wakeAll();
+}
+
+void BulkImportReader::push(QVector<ImportRecord>& batch)
+{
+  if(batch.isEmpty())
+    return;
+
+  QMutexLocker locker(&mutex);
+  while(queue.size() >= MAX_QUEUED_BATCHES && !terminate)
+    notFull.wait(&mutex);
+
+  if(!terminate)
+  {
+    queue.enqueue(batch);
+    notEmpty.wakeAll();
+  }
+  batch.clear();
+}
+
+bool BulkImportReader::take(QVector<ImportRecord>& batch)
+{
+  QMutexLocker locker(&mutex);
+  while(queue.isEmpty() && !finished)
+    notEmpty.wait(&mutex);
+
+  if(queue.isEmpty())
+    return false;
+
+  batch = queue.dequeue();
+  notFull.wakeAll();
+  return true;
+}
+
+void BulkImportReader::stop()
+{
+  {
+    QMutexLocker locker(&mutex);
+    terminate = true;
+    notFull.wakeAll();
+  }
+  wait();
+}
+
+// =====================================================================================
+BulkImporter::BulkImporter(sql::SqlDatabase *sqlDb, const QString& table, const QStringList& excludeColumns)
+  : db(sqlDb), tableName(table)
+{
+  atools::sql::SqlRecord record = db->record(tableName);
+  for(int i = 0; i < record.count(); i++)
+  {
+    QString name = record.fieldName(i);
+    if(!excludeColumns.contains(name))
+    {
+      columnIndex.insert(':' + name, columns.size());
+      columns.append(name);
+    }
+  }
+}
+
+void BulkImporter::setCsv(QChar separatorChar, QChar escapeChar, bool trimValues)
+{
+  csv = true;
+  separator = separatorChar;
+  escape = escapeChar;
+  trim = trimValues;
+}
+
+void BulkImporter::setSplit(QChar separatorChar)
+{
+  csv = false;
+  separator = separatorChar;
+}
+
+int BulkImporter::import(const QString& filepath, const ConvertFunc& convert)
+{
+  errors.clear();
+  cancelled = false;
+
+  QFile file(filepath);
+  if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
+
+  qint64 bytesTotal = file.size();
+  int rowsPerStatement = std::max(1, std::min(MAX_ROWS_PER_STATEMENT, MAX_BOUND_VALUES / columns.size()));
+
+  // Reader is stopped by destructor if an exception is thrown
+  BulkImportReader reader(this, &file);
+  reader.start();
+
+  int numImported = 0;
+  bool stopped = false;
+  QVector<QVariantList> rows;
+  rows.reserve(rowsPerStatement);
+  QVector<ImportRecord> batch;
+  while(!stopped && reader.take(batch))
+  {
+    for(const ImportRecord& record : batch)
+    {
+      ImportRow row(&columnIndex);
+      Result result = SKIP;
+      try
+      {
+        result = convert(record, row);
+      }
+      catch(atools::Exception& e)
+      {
+        if(strict)
+          throw;
+
+        qWarning() << Q_FUNC_INFO << "Skipping line" << (record.lineNumber + 1) << e.what();
+        errors.append(tr("Line %1: %2").arg(record.lineNumber + 1).arg(e.what()));
+      }
+
+      if(result == STOP)
+      {
+        stopped = true;
+        break;
+      }
+      else if(result == INSERT)
+      {
+        rows.append(row.values);
+        numImported++;
+        if(rows.size() >= rowsPerStatement)
+        {
+          insertRows(rows);
+          rows.clear();
+        }
+      }
+    }
+
+    if(progress && !progress(reader.getBytesRead(), bytesTotal, numImported))
+    {
+      cancelled = true;
+      break;
+    }
+  }
+  reader.stop();
+
+  if(!cancelled)
+    insertRows(rows);
+
+  file.close();
+  return numImported;
+}
+
+void BulkImporter::insertRows(const QVector<QVariantList>& rows)
+{
+  if(rows.isEmpty())
+    return;
+
+  QString row = "(" + QString("?, ").repeated(columns.size() - 1) + "?)";
+  QStringList rowList;
+  for(int i = 0; i < rows.size(); i++)
+    rowList.append(row);
+
+  // Full size statement is prepared only once
+  atools::sql::SqlQuery query = db->cachedQuery("insert into " + tableName + " (" + columns.join(", ") + ") values " +
+                                                rowList.join(", "));
+  int index = 0;
+  for(const QVariantList& values : rows)
+  {
+    for(const QVariant& value : values)
+      query.bindValue(index++, value);
+  }
+  query.exec();
+
+  if(query.numRowsAffected() != rows.size())
+    qWarning() << Q_FUNC_INFO << "query.numRowsAffected() != " << rows.size();
+}
+
+} // namespace userdata
+} // namespace fs
+} // namespace atools
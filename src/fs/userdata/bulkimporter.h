@@ -0,0 +1,180 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_BULKIMPORTER_H
+#define ATOOLS_FS_BULKIMPORTER_H
+
+#include <QApplication>
+#include <QHash>
+#include <QStringList>
+#include <QVariantList>
+
+#include <functional>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace userdata {
+
+/* A complete record read from an import file */
+struct ImportRecord
+{
+  /* CSV fields or the simplified line split by the separator */
+  QStringList values;
+
+  /* Text as read which contains all lines of a multi-line CSV record. Used for messages. */
+  QString line;
+
+  /* Number of the first line of the record in the file starting at 0 */
+  int lineNumber = 0;
+};
+
+/*
+ * Values for one row of the insert statement. Bound by column name like SqlQuery but names are resolved
+ * to positions using a precomputed index. All values are null for each new row.
+ */
+class ImportRow
+{
+public:
+  /* name is the column name prefixed with a colon like used for SqlQuery */
+  void bindValue(const QString& name, const QVariant& value);
+  QVariant boundValue(const QString& name) const;
+
+  const QVariantList& getValues() const
+  {
+    return values;
+  }
+
+private:
+  friend class BulkImporter;
+
+  ImportRow(const QHash<QString, int> *columnIndexParam)
+    : columnIndex(columnIndexParam)
+  {
+    values.reserve(columnIndex->size());
+    for(int i = 0; i < columnIndex->size(); i++)
+      values.append(QVariant());
+  }
+
+  const QHash<QString, int> *columnIndex;
+  QVariantList values;
+};
+
+/*
+ * Streaming import pipeline for text files.
+ *
+ * A parser thread reads and splits the file while the calling thread converts the records into rows and writes
+ * them using multi-row insert statements with positional bindings. Reading and writing overlap and memory usage is
+ * limited by a bounded queue.
+ *
+ * Does not open a transaction. Call in a transaction to have all rows written at once and rolled back on errors.
+ */
+class BulkImporter
+{
+  Q_DECLARE_TR_FUNCTIONS(BulkImporter)
+
+public:
+  enum Result
+  {
+    INSERT, /* Insert row */
+    SKIP, /* Ignore record, e.g. header */
+    STOP /* Ignore record and all following, e.g. end of file marker */
+  };
+
+  /* Called in the calling thread for each record. Has to bind the values for the row.
+   * Throw an atools::Exception for invalid records which either stops the import or skips the record
+   * depending on the strict flag. */
+  typedef std::function<Result(const ImportRecord& record, ImportRow& row)> ConvertFunc;
+
+  /* Called in the calling thread regularly. Return false to cancel. */
+  typedef std::function<bool(qint64 bytesRead, qint64 bytesTotal, int numImported)> ProgressFunc;
+
+  /* Rows are inserted into all columns of the table except excludeColumns */
+  BulkImporter(atools::sql::SqlDatabase *sqlDb, const QString& table, const QStringList& excludeColumns);
+
+  /* Parse lines as CSV using the given characters. This is the default with ',' and '"'.
+   * trimValues: Trims only text which is not escaped */
+  void setCsv(QChar separatorChar = ',', QChar escapeChar = '"', bool trimValues = true);
+
+  /* Simplify lines and split them by the given separator. Empty lines are ignored. */
+  void setSplit(QChar separatorChar);
+
+  /* Ignore the given number of lines at the start of the file */
+  void setSkipLines(int value)
+  {
+    skipLines = value;
+  }
+
+  /* true: Errors stop the import by an exception. This is the default.
+   * false: Invalid records are skipped and errors are collected. */
+  void setStrict(bool value)
+  {
+    strict = value;
+  }
+
+  void setProgressCallback(const ProgressFunc& callback)
+  {
+    progress = callback;
+  }
+
+  /* Read the file and insert all converted records. Returns number of inserted rows.
+   * Throws an exception if file cannot be read or if a record is not valid in strict mode. */
+  int import(const QString& filepath, const ConvertFunc& convert);
+
+  /* Errors for skipped records if not strict */
+  const QStringList& getErrors() const
+  {
+    return errors;
+  }
+
+  /* Progress callback returned false */
+  bool isCancelled() const
+  {
+    return cancelled;
+  }
+
+private:
+  friend class BulkImportReader;
+
+  /* Write batch of rows using a statement prepared for the number of rows */
+  void insertRows(const QVector<QVariantList>& rows);
+
+  atools::sql::SqlDatabase *db;
+  QString tableName;
+  QStringList columns;
+  QHash<QString, int> columnIndex;
+
+  /* Configuration */
+  bool csv = true, trim = true, strict = true;
+  QChar separator = ',', escape = '"';
+  int skipLines = 0;
+  ProgressFunc progress;
+
+  /* Result */
+  QStringList errors;
+  bool cancelled = false;
+};
+
+} // namespace userdata
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_BULKIMPORTER_H
@@ -21,11 +21,13 @@
 #include "sql/sqlscript.h"
 #include "sql/sqltransaction.h"
 #include "sql/sqlexport.h"
+#include "sql/sqlexportwriter.h"
 #include "geo/pos.h"
 #include "settings/settings.h"
 #include "io/fileroller.h"
 #include "exception.h"
 #include "sql/sqldatabase.h"
+#include "sql/sqlwriterthread.h"
 
 #include <QDir>
 
@@ -39,6 +41,7 @@ using atools::sql::SqlScript;
 using atools::sql::SqlQuery;
 using atools::sql::SqlRecord;
 using atools::sql::SqlExport;
+using atools::sql::SqlExportWriter;
 using atools::sql::SqlTransaction;
 
 DataManagerBase::DataManagerBase(sql::SqlDatabase *sqlDb, const QString& tableNameParam,
@@ -52,7 +55,8 @@ DataManagerBase::DataManagerBase(sql::SqlDatabase *sqlDb, const QString& tableNa
 
 DataManagerBase::~DataManagerBase()
 {
-
+  stopWriterThread();
+  delete writerThread;
 }
 
 bool DataManagerBase::hasSchema()
@@ -118,11 +122,11 @@ void DataManagerBase::backup()
     QFile file(filePath);
     if(file.open(QIODevice::WriteOnly | QIODevice::Text))
     {
-      QTextStream out(&file);
-      out.setCodec("UTF-8");
       SqlQuery query("select * from " + tableName, db);
       SqlExport sqlExport;
-      sqlExport.printResultSet(query, out);
+      SqlExportWriter writer(sqlExport, &file);
+      writer.writeResultSet(query);
+      writer.close();
       file.close();
     }
     else
@@ -131,18 +135,36 @@ void DataManagerBase::backup()
   }
 }
 
+void DataManagerBase::rowsChanging(const QVector<int>&)
+{
+  //
+}
+
+void DataManagerBase::rowsChanged(const QVector<int>&)
+{
+  //
+}
+
+void DataManagerBase::tableChanged()
+{
+  //
+}
+
 void DataManagerBase::updateCoordinates(int id, const geo::Pos& position)
 {
-  SqlQuery query(db);
-  query.prepare("update " + tableName + " set lonx = ?, laty = ? where " + idColumnName + " = ?");
+  rowsChanging({id});
+  SqlQuery query = db->cachedQuery("update " + tableName + " set lonx = ?, laty = ? where " + idColumnName + " = ?");
   query.bindValue(0, position.getLonX());
   query.bindValue(1, position.getLatY());
   query.bindValue(2, id);
   query.exec();
+  rowsChanged({id});
 }
 
 void DataManagerBase::updateField(const QString& column, const QVector<int>& ids, const QVariant& value)
 {
+  rowsChanging(ids);
+
   SqlQuery query(db);
   query.prepare("update " + tableName + " set " + column + " = ? where " + idColumnName + " = ?");
 
@@ -155,6 +177,8 @@ void DataManagerBase::updateField(const QString& column, const QVector<int>& ids
     if(query.numRowsAffected() != 1)
       qWarning() << Q_FUNC_INFO << "query.numRowsAffected() != 1";
   }
+
+  rowsChanged(ids);
 }
 
 void DataManagerBase::insertByRecordId(const sql::SqlRecord& record)
@@ -182,6 +206,9 @@ void DataManagerBase::insertRecords(const sql::SqlRecordVector& records, const Q
     if(query.numRowsAffected() != 1)
       qWarning() << Q_FUNC_INFO << "query.numRowsAffected() != 1";
   }
+
+  if(table == tableName)
+    tableChanged();
 }
 
 void DataManagerBase::insertByRecord(sql::SqlRecord record, int *lastInsertedRowid)
@@ -204,12 +231,12 @@ void DataManagerBase::insertByRecordInternal(const sql::SqlRecord& record, int *
   query.exec();
   if(query.numRowsAffected() != 1)
     qWarning() << Q_FUNC_INFO << "query.numRowsAffected() != 1";
-  else if(lastInsertedRowid != nullptr)
+  else
   {
-    SqlQuery rowidQuery(db);
-    rowidQuery.exec("select max(rowid) from " + tableName);
-    if(rowidQuery.next())
-      *lastInsertedRowid = rowidQuery.valueInt(0);
+    int rowid = query.lastInsertId().toInt();
+    if(lastInsertedRowid != nullptr)
+      *lastInsertedRowid = rowid;
+    rowsChanged({rowid});
   }
 }
 
@@ -219,6 +246,8 @@ void DataManagerBase::updateByRecord(sql::SqlRecord record, const QVector<int>&
     // Get rid of id column - it is not needed here
     record.remove(record.indexOf(idColumnName));
 
+  rowsChanging(ids);
+
   SqlQuery query(db);
   query.prepare("update " + tableName + " set " + record.fieldNames().join(
                   " = ?, ") + " = ? where " + idColumnName + " = ?");
@@ -235,6 +264,8 @@ void DataManagerBase::updateByRecord(sql::SqlRecord record, const QVector<int>&
     if(query.numRowsAffected() != 1)
       qWarning() << Q_FUNC_INFO << "query.numRowsAffected() != 1";
   }
+
+  rowsChanged(ids);
 }
 
 void DataManagerBase::clearData()
@@ -264,10 +295,16 @@ void DataManagerBase::removeRows(const QString& column, QVariant value)
 void DataManagerBase::removeRows(const QString& table)
 {
   SqlQuery("delete from " + table, db).exec();
+
+  if(table == tableName)
+    tableChanged();
 }
 
 void DataManagerBase::removeRows(const QString& table, const QVector<int> ids)
 {
+  if(table == tableName)
+    rowsChanging(ids);
+
   SqlQuery query(db);
   query.prepare("delete from " + table + " where " + idColumnName + " = ?");
 
@@ -286,12 +323,14 @@ void DataManagerBase::removeRows(const QString& table, const QString& column, QV
   query.prepare("delete from " + table + " where " + column + " = ?");
   query.bindValue(0, value);
   query.exec();
+
+  if(table == tableName)
+    tableChanged();
 }
 
 void DataManagerBase::getValues(QVariantList& values, const QVector<int> ids, const QString& colName)
 {
-  SqlQuery query(db);
-  query.prepare("select " + colName + " from " + tableName + " where " + idColumnName + " = ?");
+  SqlQuery query = db->cachedQuery("select " + colName + " from " + tableName + " where " + idColumnName + " = ?");
 
   for(int id : ids)
   {
@@ -302,6 +341,7 @@ void DataManagerBase::getValues(QVariantList& values, const QVector<int> ids, co
     else
       qWarning() << Q_FUNC_INFO << "nothing found for id" << id;
   }
+  query.finish();
 }
 
 QVariant DataManagerBase::getValue(int id, const QString& colName)
@@ -315,8 +355,7 @@ QVariant DataManagerBase::getValue(int id, const QString& colName)
 
 void DataManagerBase::getRecords(QVector<SqlRecord>& records, const QVector<int> ids)
 {
-  SqlQuery query(db);
-  query.prepare("select * from " + tableName + " where " + idColumnName + " = ?");
+  SqlQuery query = db->cachedQuery("select * from " + tableName + " where " + idColumnName + " = ?");
 
   for(int id : ids)
   {
@@ -327,6 +366,7 @@ void DataManagerBase::getRecords(QVector<SqlRecord>& records, const QVector<int>
     else
       qWarning() << Q_FUNC_INFO << "nothing found for id" << id;
   }
+  query.finish();
 }
 
 SqlRecord DataManagerBase::getRecord(int id)
@@ -384,11 +424,52 @@ QString DataManagerBase::at(const QStringList& line, int index, bool nowarn)
 
 bool DataManagerBase::hasBlob(int id, const QString& colName)
 {
-  SqlQuery query(db);
-  query.prepare("select 1 from " + tableName + " where " + idColumnName + " = ? and length(" + colName + ") > 0");
+  SqlQuery query = db->cachedQuery("select 1 from " + tableName + " where " + idColumnName +
+                                   " = ? and length(" + colName + ") > 0");
   query.bindValue(0, id);
   query.exec();
-  return query.next();
+  bool retval = query.next();
+  query.finish();
+  return retval;
+}
+
+void DataManagerBase::setWalMode(bool enable)
+{
+  db->setWalMode(enable);
+}
+
+bool DataManagerBase::checkpoint(atools::sql::SqlDatabase::WalCheckpoint mode)
+{
+  return db->walCheckpoint(mode);
+}
+
+int DataManagerBase::runImport(BulkImporter& importer, const QString& filepath,
+                               const BulkImporter::ConvertFunc& convert)
+{
+  importer.setStrict(importStrict);
+  importer.setProgressCallback(importProgress);
+
+  int numImported = importer.import(filepath, convert);
+  importErrors = importer.getErrors();
+  return importer.isCancelled() ? -1 : numImported;
+}
+
+int DataManagerBase::postWrite(const std::function<void(sql::SqlDatabase *writerDb)>& writeFunc)
+{
+  return getWriterThread()->post(writeFunc);
+}
+
+atools::sql::SqlWriterThread *DataManagerBase::getWriterThread()
+{
+  if(writerThread == nullptr)
+    writerThread = new atools::sql::SqlWriterThread(db, db->connectionName() + "_" + tableName + "_writer");
+  return writerThread;
+}
+
+void DataManagerBase::stopWriterThread()
+{
+  if(writerThread != nullptr)
+    writerThread->terminateThread();
 }
 
 } // namespace userdata
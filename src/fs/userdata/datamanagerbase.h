@@ -21,13 +21,17 @@
 #include <QApplication>
 #include <QVector>
 
+#include "fs/userdata/bulkimporter.h"
+#include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 
+#include <functional>
+
 namespace atools {
 
 namespace sql {
-class SqlDatabase;
 class SqlRecord;
+class SqlWriterThread;
 }
 
 namespace geo {
@@ -128,6 +132,45 @@ public:
   /* true if row with the given id and column name has a BLOB larger than 0 */
   bool hasBlob(int id, const QString& colName);
 
+  /* Switch database to write ahead log mode which allows readers to continue while the writer thread works.
+   * Rolls back the current transaction. */
+  void setWalMode(bool enable = true);
+
+  /* Copy write ahead log back into the database. Commits the current transaction.
+   * Returns false if other connections prevented a complete checkpoint. */
+  bool checkpoint(atools::sql::SqlDatabase::WalCheckpoint mode = atools::sql::SqlDatabase::CHECKPOINT_PASSIVE);
+
+  /* Runs writeFunc in the background writer thread on a separate connection to the same database file.
+   * The function runs in a transaction which is committed afterwards. Create a manager on the given
+   * connection to use the import methods, e.g. LogdataManager(writerDb).importCsv(filepath).
+   * Starts the thread on first call. Returns a job id. Connect to SqlWriterThread::jobFinished for results. */
+  int postWrite(const std::function<void(atools::sql::SqlDatabase *writerDb)>& writeFunc);
+
+  /* Get writer thread. Creates a stopped thread if not done yet. */
+  atools::sql::SqlWriterThread *getWriterThread();
+
+  /* Execute all queued write jobs and stop the thread */
+  void stopWriterThread();
+
+  /* Options for all import methods. Strict mode is default where an invalid line stops the import.
+   * Otherwise invalid lines are skipped and errors can be fetched by getImportErrors() after import. */
+  void setImportStrict(bool value)
+  {
+    importStrict = value;
+  }
+
+  /* Called regularly by all import methods. Return false to cancel the import which rolls back all changes. */
+  void setImportProgressCallback(const atools::fs::userdata::BulkImporter::ProgressFunc& callback)
+  {
+    importProgress = callback;
+  }
+
+  /* Errors for skipped lines of the last import if not in strict mode */
+  const QStringList& getImportErrors() const
+  {
+    return importErrors;
+  }
+
 protected:
   /*
    * Simple SqlQuery wrapper which can be used to export all rows or a list of rows by id
@@ -180,9 +223,26 @@ private:
 
   void insertByRecordInternal(const sql::SqlRecord& record, int *lastInsertedRowid);
 
+  /* Run importer with the import options. Returns number of imported rows or -1 if cancelled. */
+  int runImport(atools::fs::userdata::BulkImporter& importer, const QString& filepath,
+                const atools::fs::userdata::BulkImporter::ConvertFunc& convert);
+
+  /* Called by all methods changing the table before rows are updated or removed and after rows are
+   * inserted or updated. Called in the transaction of the change. Default implementations do nothing. */
+  virtual void rowsChanging(const QVector<int>& ids);
+  virtual void rowsChanged(const QVector<int>& ids);
+
+  /* Called after an unknown number of rows were changed, e.g. by bulk inserts or removing all rows */
+  virtual void tableChanged();
+
   atools::sql::SqlDatabase *db = nullptr;
+  atools::sql::SqlWriterThread *writerThread = nullptr;
   QString tableName, idColumnName, /* id column name */
           createScript, dropScript, backupFilename;
+
+  bool importStrict = true;
+  atools::fs::userdata::BulkImporter::ProgressFunc importProgress;
+  QStringList importErrors;
 };
 
 } // namespace userdata
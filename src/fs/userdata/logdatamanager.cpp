@@ -19,18 +19,25 @@
 
 #include "sql/sqlutil.h"
 #include "sql/sqlexport.h"
+#include "sql/sqlexportwriter.h"
 #include "sql/sqltransaction.h"
 #include "sql/sqldatabase.h"
-#include "util/csvreader.h"
+#include "sql/sqlwriterthread.h"
 #include "geo/pos.h"
 #include "zip/gzip.h"
 #include "geo/calculations.h"
 #include "exception.h"
 #include "geo/linestring.h"
 #include "fs/pln/flightplanio.h"
+#include "fs/common/binarygeometry.h"
+#include "util/memorybudget.h"
 
 #include <QDateTime>
 #include <QDir>
+#include <QMutexLocker>
+#include <QtEndian>
+
+#include <limits>
 
 namespace atools {
 namespace fs {
@@ -41,6 +48,7 @@ using atools::sql::SqlUtil;
 using atools::sql::SqlDatabase;
 using atools::sql::SqlQuery;
 using atools::sql::SqlExport;
+using atools::sql::SqlExportWriter;
 using atools::sql::SqlRecord;
 using atools::sql::SqlTransaction;
 
@@ -137,18 +145,103 @@ const static QHash<int, std::pair<QString,QString>> COL_MAP =
 }
 /* *INDENT-ON* */
 
+namespace stats {
+/* Column indexes in table logbook_stats and in the aggregate query */
+enum Index
+{
+  NUM_ENTRIES,             // num_entries
+  DISTANCE_SUM,            // distance_sum
+  DISTANCE_MAX,            // distance_max
+  DISTANCE_NUM,            // distance_num
+  DEPARTURE_TIME_MIN,      // departure_time_min
+  DEPARTURE_TIME_MAX,      // departure_time_max
+  DEPARTURE_TIME_SIM_MIN,  // departure_time_sim_min
+  DEPARTURE_TIME_SIM_MAX,  // departure_time_sim_max
+  TIME_REAL_MAX,           // time_real_max
+  TIME_REAL_SUM,           // time_real_sum
+  TIME_REAL_NUM,           // time_real_num
+  TIME_SIM_MAX,            // time_sim_max
+  TIME_SIM_SUM,            // time_sim_sum
+  TIME_SIM_NUM,            // time_sim_num
+  NUM_COLUMNS
+};
+
+/* How values of rows are combined */
+enum Type
+{
+  SUM, MIN, MAX
+};
+
+static const std::pair<const char *, Type> COLUMNS[NUM_COLUMNS] =
+{
+  std::make_pair("num_entries",            SUM),
+  std::make_pair("distance_sum",           SUM),
+  std::make_pair("distance_max",           MAX),
+  std::make_pair("distance_num",           SUM),
+  std::make_pair("departure_time_min",     MIN),
+  std::make_pair("departure_time_max",     MAX),
+  std::make_pair("departure_time_sim_min", MIN),
+  std::make_pair("departure_time_sim_max", MAX),
+  std::make_pair("time_real_max",          MAX),
+  std::make_pair("time_real_sum",          SUM),
+  std::make_pair("time_real_num",          SUM),
+  std::make_pair("time_sim_max",           MAX),
+  std::make_pair("time_sim_sum",           SUM),
+  std::make_pair("time_sim_num",           SUM)
+};
+
+/* Columns in logbook where the number of distinct values is kept in logbook_stats_value */
+static const char *VALUE_COLUMNS[] =
+{
+  "departure_ident", "destination_ident", "aircraft_type", "aircraft_registration", "aircraft_name", "simulator"
+};
+
+/* Number of ids for each "in" clause */
+static const int ID_BATCH_SIZE = 500;
+
+static int compare(const QVariant& value1, const QVariant& value2)
+{
+  if(value1.type() == QVariant::String || value2.type() == QVariant::String)
+    // Date and time are stored as ISO strings
+    return value1.toString().compare(value2.toString());
+
+  double d1 = value1.toDouble(), d2 = value2.toDouble();
+  return d1 < d2 ? -1 : (d1 > d2 ? 1 : 0);
+}
+
+static QVariant add(const QVariant& value1, const QVariant& value2, int sign)
+{
+  if(value1.type() == QVariant::Double || value2.type() == QVariant::Double)
+    return value1.toDouble() + sign * value2.toDouble();
+  else
+    return value1.toLongLong() + sign * value2.toLongLong();
+}
+
+} // namespace stats
+
 LogdataManager::LogdataManager(sql::SqlDatabase *sqlDb)
   : DataManagerBase(sqlDb, "logbook", "logbook_id",
                     ":/atools/resources/sql/fs/logbook/create_logbook_schema.sql",
                     ":/atools/resources/sql/fs/logbook/drop_logbook_schema.sql",
-                    "little_navmap_logbook_backup.csv"), cache(MAX_CACHE_ENTRIES)
+                    "little_navmap_logbook_backup.csv"), cache(DEFAULT_CACHE_BYTES), prefetchGeneration(0),
+  spatialIndexValid(false)
 {
 
 }
 
 LogdataManager::~LogdataManager()
 {
+  if(loaderThread != nullptr)
+  {
+    // Let queued jobs return early
+    prefetchGeneration++;
+    loaderThread->terminateThread();
+    delete loaderThread;
+  }
+  qDeleteAll(prefetched);
 
+  if(memoryBudgetId != 0)
+    atools::util::MemoryBudget::instance().remove(memoryBudgetId);
 }
 
 int LogdataManager::importCsv(const QString& filepath)
@@ -156,149 +249,123 @@ int LogdataManager::importCsv(const QString& filepath)
   SqlTransaction transaction(db);
 
   // Autogenerate id - exclude logbook_id from insert
-  SqlQuery insertQuery(db);
-  insertQuery.prepare(SqlUtil(db).buildInsertStatement(tableName, QString(), {idColumnName}, true));
+  BulkImporter importer(db, tableName, {idColumnName});
 
-  int numImported = 0;
-  QFile file(filepath);
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
-  {
-    atools::util::CsvReader reader;
-
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
-
-    int lineNum = 0;
-    while(!stream.atEnd())
+  bool first = true;
+  auto convert = [&](const ImportRecord& record, ImportRow& row) -> BulkImporter::Result {
+    if(first)
     {
-      QString line = stream.readLine();
-
-      if(lineNum == 0)
-      {
-        QString header = QString(line).replace(" ", QString()).toLower();
-        if(header.startsWith(csv::HEADER_LINE) || header.startsWith(csv::HEADER_LINE2))
-        {
-          lineNum++;
-          // Ignore header
-          continue;
-        }
-      }
-
-      // Skip empty lines but add them if within an escaped field
-      if(line.isEmpty() && !reader.isInEscape())
-        continue;
+      first = false;
+      QString header = QString(record.line).replace(" ", QString()).toLower();
+      if(header.startsWith(csv::HEADER_LINE) || header.startsWith(csv::HEADER_LINE2))
+        // Ignore header
+        return BulkImporter::SKIP;
+    }
 
-      reader.readCsvLine(line);
-      if(reader.isInEscape())
-        // Still in an escaped line so continue to read unchanged until " shows the end of the field
-        continue;
+    const QStringList& values = record.values;
+
+    // Aircraft ===============================================================
+    row.bindValue(":aircraft_name", at(values, csv::AIRCRAFT_NAME));
+    row.bindValue(":aircraft_type", at(values, csv::AIRCRAFT_TYPE));
+    row.bindValue(":aircraft_registration", at(values, csv::AIRCRAFT_REGISTRATION));
+
+    // Flightplan ===============================================================
+    row.bindValue(":flightplan_number", at(values, csv::FLIGHTPLAN_NUMBER));
+    if(!at(values, csv::FLIGHTPLAN_CRUISE_ALTITUDE).isEmpty())
+      row.bindValue(":flightplan_cruise_altitude", atFloat(values, csv::FLIGHTPLAN_CRUISE_ALTITUDE, true));
+    row.bindValue(":flightplan_file", at(values, csv::FLIGHTPLAN_FILE));
+
+    // Trip ===============================================================
+    row.bindValue(":performance_file", at(values, csv::PERFORMANCE_FILE));
+    if(!at(values, csv::BLOCK_FUEL).isEmpty())
+      row.bindValue(":block_fuel", atFloat(values, csv::BLOCK_FUEL, true));
+    if(!at(values, csv::TRIP_FUEL).isEmpty())
+      row.bindValue(":trip_fuel", atFloat(values, csv::TRIP_FUEL, true));
+    if(!at(values, csv::USED_FUEL).isEmpty())
+      row.bindValue(":used_fuel", atFloat(values, csv::USED_FUEL, true));
+    if(!at(values, csv::IS_JETFUEL).isEmpty())
+      row.bindValue(":is_jetfuel", atInt(values, csv::IS_JETFUEL, true));
+    if(!at(values, csv::GROSSWEIGHT).isEmpty())
+      row.bindValue(":grossweight", atFloat(values, csv::GROSSWEIGHT, true));
+    if(!at(values, csv::DISTANCE).isEmpty())
+      row.bindValue(":distance", atFloat(values, csv::DISTANCE, true));
+    if(!at(values, csv::DISTANCE_FLOWN).isEmpty())
+      row.bindValue(":distance_flown", atFloat(values, csv::DISTANCE_FLOWN, true));
+
+    // Departure ===============================================================
+    row.bindValue(":departure_ident", at(values, csv::DEPARTURE_IDENT));
+    row.bindValue(":departure_name", at(values, csv::DEPARTURE_NAME));
+    row.bindValue(":departure_runway", at(values, csv::DEPARTURE_RUNWAY));
+
+    if(!at(values, csv::DEPARTURE_LONX).isEmpty() && !at(values, csv::DEPARTURE_LATY).isEmpty())
+    {
+      Pos departPos = validateCoordinates(record.line, at(values, csv::DEPARTURE_LONX),
+                                          at(values, csv::DEPARTURE_LATY));
 
-      const QStringList& values = reader.getValues();
-
-      // Aircraft ===============================================================
-      insertQuery.bindValue(":aircraft_name", at(values, csv::AIRCRAFT_NAME));
-      insertQuery.bindValue(":aircraft_type", at(values, csv::AIRCRAFT_TYPE));
-      insertQuery.bindValue(":aircraft_registration", at(values, csv::AIRCRAFT_REGISTRATION));
-
-      // Flightplan ===============================================================
-      insertQuery.bindValue(":flightplan_number", at(values, csv::FLIGHTPLAN_NUMBER));
-      if(!at(values, csv::FLIGHTPLAN_CRUISE_ALTITUDE).isEmpty())
-        insertQuery.bindValue(":flightplan_cruise_altitude", atFloat(values, csv::FLIGHTPLAN_CRUISE_ALTITUDE, true));
-      insertQuery.bindValue(":flightplan_file", at(values, csv::FLIGHTPLAN_FILE));
-
-      // Trip ===============================================================
-      insertQuery.bindValue(":performance_file", at(values, csv::PERFORMANCE_FILE));
-      if(!at(values, csv::BLOCK_FUEL).isEmpty())
-        insertQuery.bindValue(":block_fuel", atFloat(values, csv::BLOCK_FUEL, true));
-      if(!at(values, csv::TRIP_FUEL).isEmpty())
-        insertQuery.bindValue(":trip_fuel", atFloat(values, csv::TRIP_FUEL, true));
-      if(!at(values, csv::USED_FUEL).isEmpty())
-        insertQuery.bindValue(":used_fuel", atFloat(values, csv::USED_FUEL, true));
-      if(!at(values, csv::IS_JETFUEL).isEmpty())
-        insertQuery.bindValue(":is_jetfuel", atInt(values, csv::IS_JETFUEL, true));
-      if(!at(values, csv::GROSSWEIGHT).isEmpty())
-        insertQuery.bindValue(":grossweight", atFloat(values, csv::GROSSWEIGHT, true));
-      if(!at(values, csv::DISTANCE).isEmpty())
-        insertQuery.bindValue(":distance", atFloat(values, csv::DISTANCE, true));
-      if(!at(values, csv::DISTANCE_FLOWN).isEmpty())
-        insertQuery.bindValue(":distance_flown", atFloat(values, csv::DISTANCE_FLOWN, true));
-
-      // Departure ===============================================================
-      insertQuery.bindValue(":departure_ident", at(values, csv::DEPARTURE_IDENT));
-      insertQuery.bindValue(":departure_name", at(values, csv::DEPARTURE_NAME));
-      insertQuery.bindValue(":departure_runway", at(values, csv::DEPARTURE_RUNWAY));
-
-      if(!at(values, csv::DEPARTURE_LONX).isEmpty() && !at(values, csv::DEPARTURE_LATY).isEmpty())
+      if(departPos.isValid())
       {
-        Pos departPos = validateCoordinates(line, at(values, csv::DEPARTURE_LONX), at(values, csv::DEPARTURE_LATY));
-
-        if(departPos.isValid())
-        {
-          insertQuery.bindValue(":departure_lonx", departPos.getLonX());
-          insertQuery.bindValue(":departure_laty", departPos.getLatY());
-        }
+        row.bindValue(":departure_lonx", departPos.getLonX());
+        row.bindValue(":departure_laty", departPos.getLatY());
       }
-      if(!at(values, csv::DEPARTURE_ALT).isEmpty())
-        insertQuery.bindValue(":departure_alt", atFloat(values, csv::DEPARTURE_ALT, true));
+    }
+    if(!at(values, csv::DEPARTURE_ALT).isEmpty())
+      row.bindValue(":departure_alt", atFloat(values, csv::DEPARTURE_ALT, true));
 
-      insertQuery.bindValue(":departure_time",
-                            QDateTime::fromString(at(values, csv::DEPARTURE_TIME, true), Qt::ISODate));
-      insertQuery.bindValue(":departure_time_sim",
-                            QDateTime::fromString(at(values, csv::DEPARTURE_TIME_SIM, true), Qt::ISODate));
+    row.bindValue(":departure_time",
+                  QDateTime::fromString(at(values, csv::DEPARTURE_TIME, true), Qt::ISODate));
+    row.bindValue(":departure_time_sim",
+                  QDateTime::fromString(at(values, csv::DEPARTURE_TIME_SIM, true), Qt::ISODate));
 
-      // Destination ===============================================================
-      insertQuery.bindValue(":destination_ident", at(values, csv::DESTINATION_IDENT));
-      insertQuery.bindValue(":destination_name", at(values, csv::DESTINATION_NAME));
-      insertQuery.bindValue(":destination_runway", at(values, csv::DESTINATION_RUNWAY));
+    // Destination ===============================================================
+    row.bindValue(":destination_ident", at(values, csv::DESTINATION_IDENT));
+    row.bindValue(":destination_name", at(values, csv::DESTINATION_NAME));
+    row.bindValue(":destination_runway", at(values, csv::DESTINATION_RUNWAY));
 
-      if(!at(values, csv::DESTINATION_LONX).isEmpty() && !at(values, csv::DESTINATION_LATY).isEmpty())
+    if(!at(values, csv::DESTINATION_LONX).isEmpty() && !at(values, csv::DESTINATION_LATY).isEmpty())
+    {
+      Pos destPos = validateCoordinates(record.line, at(values, csv::DESTINATION_LONX),
+                                        at(values, csv::DESTINATION_LATY));
+      if(destPos.isValid())
       {
-        Pos destPos = validateCoordinates(line, at(values, csv::DESTINATION_LONX), at(values, csv::DESTINATION_LATY));
-        if(destPos.isValid())
-        {
-          insertQuery.bindValue(":destination_lonx", destPos.getLonX());
-          insertQuery.bindValue(":destination_laty", destPos.getLatY());
-        }
+        row.bindValue(":destination_lonx", destPos.getLonX());
+        row.bindValue(":destination_laty", destPos.getLatY());
       }
+    }
 
-      if(!at(values, csv::DESTINATION_ALT).isEmpty())
-        insertQuery.bindValue(":destination_alt", atFloat(values, csv::DESTINATION_ALT, true));
-
-      insertQuery.bindValue(":destination_time",
-                            QDateTime::fromString(at(values, csv::DESTINATION_TIME, true), Qt::ISODate));
-      insertQuery.bindValue(":destination_time_sim",
-                            QDateTime::fromString(at(values, csv::DESTINATION_TIME_SIM, true), Qt::ISODate));
-
-      // Other ===============================================================
-      insertQuery.bindValue(":route_string", at(values, csv::ROUTE_STRING));
-      insertQuery.bindValue(":simulator", at(values, csv::SIMULATOR));
-      insertQuery.bindValue(":description", at(values, csv::DESCRIPTION));
-
-      // Add files as Gzipped BLOBS ===========================================
-      insertQuery.bindValue(":flightplan", atools::zip::gzipCompress(at(values, csv::FLIGHTPLAN,
-                                                                        true /* nowarn */).toUtf8()));
-      insertQuery.bindValue(":aircraft_perf", atools::zip::gzipCompress(at(values, csv::AIRCRAFT_PERF,
-                                                                           true /* nowarn */).toUtf8()));
-      insertQuery.bindValue(":aircraft_trail", atools::zip::gzipCompress(at(values, csv::AIRCRAFT_TRAIL,
-                                                                            true /* nowarn */).toUtf8()));
-
-      // Fill null fields with empty strings to avoid issues when searching
-      // Also turn empty BLOBs to NULL
-      fixEmptyFields(insertQuery);
-
-      insertQuery.exec();
-
-      // Reset unassigned fields to null
-      insertQuery.clearBoundValues();
+    if(!at(values, csv::DESTINATION_ALT).isEmpty())
+      row.bindValue(":destination_alt", atFloat(values, csv::DESTINATION_ALT, true));
+
+    row.bindValue(":destination_time",
+                  QDateTime::fromString(at(values, csv::DESTINATION_TIME, true), Qt::ISODate));
+    row.bindValue(":destination_time_sim",
+                  QDateTime::fromString(at(values, csv::DESTINATION_TIME_SIM, true), Qt::ISODate));
+
+    // Other ===============================================================
+    row.bindValue(":route_string", at(values, csv::ROUTE_STRING));
+    row.bindValue(":simulator", at(values, csv::SIMULATOR));
+    row.bindValue(":description", at(values, csv::DESCRIPTION));
+
+    // Add files as Gzipped BLOBS ===========================================
+    row.bindValue(":flightplan", atools::zip::gzipCompress(at(values, csv::FLIGHTPLAN,
+                                                              true /* nowarn */).toUtf8()));
+    row.bindValue(":aircraft_perf", atools::zip::gzipCompress(at(values, csv::AIRCRAFT_PERF,
+                                                                 true /* nowarn */).toUtf8()));
+    row.bindValue(":aircraft_trail", atools::zip::gzipCompress(at(values, csv::AIRCRAFT_TRAIL,
+                                                                  true /* nowarn */).toUtf8()));
+
+    // Fill null fields with empty strings to avoid issues when searching
+    // Also turn empty BLOBs to NULL
+    fixEmptyFields(row);
+    return BulkImporter::INSERT;
+  };
 
-      lineNum++;
-      numImported++;
-    }
-    file.close();
-  }
-  else
-    throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
+  int numImported = runImport(importer, filepath, convert);
+  if(numImported == -1)
+    // Cancelled - roll back
+    return 0;
 
+  // Inserted by own query
+  invalidateStatistics();
   transaction.commit();
   return numImported;
 }
@@ -357,132 +424,119 @@ int LogdataManager::importXplane(const QString& filepath,
   SqlTransaction transaction(db);
 
   // Autogenerate id
-  SqlQuery insertQuery(db);
-  insertQuery.prepare(SqlUtil(db).buildInsertStatement(tableName, QString(), {idColumnName}, true));
+  BulkImporter importer(db, tableName, {idColumnName});
+  importer.setSplit(' ');
 
-  int numImported = 0;
-  QFile file(filepath);
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
-  {
-    QString filename = QFileInfo(filepath).fileName();
+  QString filename = QFileInfo(filepath).fileName();
 
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
+  auto convert = [&](const ImportRecord& record, ImportRow& row) -> BulkImporter::Result {
+    if(record.line == "99") // Check for end of file marker
+      return BulkImporter::STOP;
 
-    int lineNum = 0;
-    while(!stream.atEnd())
-    {
-      QString readline = stream.readLine();
-      if(readline == "99") // Check for end of file marker
-        break;
+    const QStringList& line = record.values;
+    if(line.size() < 9) // Reg and type might be omitted
+      return BulkImporter::SKIP;
 
-      QStringList line = readline.simplified().split(" ");
+    // 2 190620    FHAW    FHAW   0   0.1   0.0   0.0   0.0  N7779E  Car_B1900D
+    if(line.at(PREFIX) != "2")
+      qWarning() << Q_FUNC_INFO << "Unknown prefix" << line.at(PREFIX) << "at line" << record.lineNumber;
 
-      if(line.size() >= 9) // Reg and type might be omitted
-      {
-        // 2 190620    FHAW    FHAW   0   0.1   0.0   0.0   0.0  N7779E  Car_B1900D
-        if(line.at(PREFIX) != "2")
-          qWarning() << Q_FUNC_INFO << "Unknown prefix" << line.at(PREFIX) << "at line" << lineNum;
-
-        // Time ========================
-        int travelTimeSecs = atools::roundToInt(atFloat(line, TIME, true) * 3600.f);
-        QDateTime departureTime = QDateTime::fromString("20" + at(line, DATE), "yyyyMMdd");
-        QDateTime destinationTime = departureTime.addSecs(travelTimeSecs);
+    // Time ========================
+    int travelTimeSecs = atools::roundToInt(atFloat(line, TIME, true) * 3600.f);
+    QDateTime departureTime = QDateTime::fromString("20" + at(line, DATE), "yyyyMMdd");
+    QDateTime destinationTime = departureTime.addSecs(travelTimeSecs);
 
-        // Resolve departure and destination ================================
-        QString departure = at(line, DEPARTURE), departureName;
-        atools::geo::Pos departurePos;
+    // Resolve departure and destination ================================
+    QString departure = at(line, DEPARTURE), departureName;
+    atools::geo::Pos departurePos;
 
-        if(departure == "BIDV")
-          qDebug() << Q_FUNC_INFO;
+    if(departure == "BIDV")
+      qDebug() << Q_FUNC_INFO;
 
-        // Get name and coordinates from database
-        fetchAirport(departurePos, departureName, departure);
+    // Get name and coordinates from database
+    fetchAirport(departurePos, departureName, departure);
 
-        // Departure =====================================================
-        insertQuery.bindValue(":departure_ident", departure);
-        insertQuery.bindValue(":departure_name", departureName);
+    // Departure =====================================================
+    row.bindValue(":departure_ident", departure);
+    row.bindValue(":departure_name", departureName);
 
-        if(departurePos.isValid())
-        {
-          // Leave position null, otherwise
-          insertQuery.bindValue(":departure_lonx", departurePos.getLonX());
-          insertQuery.bindValue(":departure_laty", departurePos.getLatY());
-          insertQuery.bindValue(":departure_alt", departurePos.getAltitude());
-        }
+    if(departurePos.isValid())
+    {
+      // Leave position null, otherwise
+      row.bindValue(":departure_lonx", departurePos.getLonX());
+      row.bindValue(":departure_laty", departurePos.getLatY());
+      row.bindValue(":departure_alt", departurePos.getAltitude());
+    }
 
-        insertQuery.bindValue(":departure_time_sim", departureTime);
-        insertQuery.bindValue(":departure_time", departureTime);
+    row.bindValue(":departure_time_sim", departureTime);
+    row.bindValue(":departure_time", departureTime);
 
-        // Destination =====================================================
-        // Get name and coordinates from database
-        QString destination = at(line, DESTINATION), destinationName;
-        atools::geo::Pos destinationPos;
-        fetchAirport(destinationPos, destinationName, destination);
+    // Destination =====================================================
+    // Get name and coordinates from database
+    QString destination = at(line, DESTINATION), destinationName;
+    atools::geo::Pos destinationPos;
+    fetchAirport(destinationPos, destinationName, destination);
 
-        insertQuery.bindValue(":destination_ident", destination);
-        insertQuery.bindValue(":destination_name", destinationName);
+    row.bindValue(":destination_ident", destination);
+    row.bindValue(":destination_name", destinationName);
 
-        if(destinationPos.isValid())
-        {
-          insertQuery.bindValue(":destination_lonx", destinationPos.getLonX());
-          insertQuery.bindValue(":destination_laty", destinationPos.getLatY());
-          insertQuery.bindValue(":destination_alt", destinationPos.getAltitude());
-        }
-        insertQuery.bindValue(":destination_time_sim", destinationTime);
-        insertQuery.bindValue(":destination_time", destinationTime);
+    if(destinationPos.isValid())
+    {
+      row.bindValue(":destination_lonx", destinationPos.getLonX());
+      row.bindValue(":destination_laty", destinationPos.getLatY());
+      row.bindValue(":destination_alt", destinationPos.getAltitude());
+    }
+    row.bindValue(":destination_time_sim", destinationTime);
+    row.bindValue(":destination_time", destinationTime);
 
-        // Aircraft ====================================================
-        if(TAIL_NUMBER < line.size())
-        {
-          QString tailNum = at(line, TAIL_NUMBER);
-          insertQuery.bindValue(":aircraft_registration", tailNum.replace("_", " "));
-        }
+    // Aircraft ====================================================
+    if(TAIL_NUMBER < line.size())
+    {
+      QString tailNum = at(line, TAIL_NUMBER);
+      row.bindValue(":aircraft_registration", tailNum.replace("_", " "));
+    }
 
-        if(AIRCRAFT_TYPE < line.size())
-        {
-          QString aircraftType = at(line, AIRCRAFT_TYPE);
-          insertQuery.bindValue(":aircraft_type", aircraftType.replace("_", " "));
-        }
+    if(AIRCRAFT_TYPE < line.size())
+    {
+      QString aircraftType = at(line, AIRCRAFT_TYPE);
+      row.bindValue(":aircraft_type", aircraftType.replace("_", " "));
+    }
 
-        // ===================================================================
-        if(departurePos.isValid() && destinationPos.isValid())
-          insertQuery.bindValue(":distance", atools::geo::meterToNm(departurePos.distanceMeterTo(destinationPos)));
-
-        insertQuery.bindValue(":simulator", "X-Plane 11");
-
-        // Description ===================================================================
-        /*: The text "Imported from X-Plane logbook" has to match the one in LogdataController::importXplane */
-        QString description(tr("Imported from X-Plane logbook %1\n"
-                               "Number of landings: %2\n"
-                               "Cross country time: %3\n"
-                               "IFR time: %4\n"
-                               "Night time: %5").
-                            arg(filename).
-                            arg(atInt(line, NUM_LANDINGS, true)).
-                            arg(atFloat(line, TIME_CROSS_COUNTRY, true), 0, 'f', 1).
-                            arg(atFloat(line, TIME_IFR, true), 0, 'f', 1).
-                            arg(atFloat(line, TIME_NIGHT, true), 0, 'f', 1));
-        insertQuery.bindValue(":description", description);
-
-        // Fill null fields with empty strings to avoid issues when searching
-        // Also turn empty BLOBs to NULL
-        fixEmptyFields(insertQuery);
+    // ===================================================================
+    if(departurePos.isValid() && destinationPos.isValid())
+      row.bindValue(":distance", atools::geo::meterToNm(departurePos.distanceMeterTo(destinationPos)));
+
+    row.bindValue(":simulator", "X-Plane 11");
+
+    // Description ===================================================================
+    /*: The text "Imported from X-Plane logbook" has to match the one in LogdataController::importXplane */
+    QString description(tr("Imported from X-Plane logbook %1\n"
+                           "Number of landings: %2\n"
+                           "Cross country time: %3\n"
+                           "IFR time: %4\n"
+                           "Night time: %5").
+                        arg(filename).
+                        arg(atInt(line, NUM_LANDINGS, true)).
+                        arg(atFloat(line, TIME_CROSS_COUNTRY, true), 0, 'f', 1).
+                        arg(atFloat(line, TIME_IFR, true), 0, 'f', 1).
+                        arg(atFloat(line, TIME_NIGHT, true), 0, 'f', 1));
+    row.bindValue(":description", description);
+
+    // Fill null fields with empty strings to avoid issues when searching
+    // Also turn empty BLOBs to NULL
+    fixEmptyFields(row);
+    return BulkImporter::INSERT;
+  };
 
-        insertQuery.exec();
-        insertQuery.clearBoundValues();
-      } // if(line.size() >= 10)
-
-      lineNum++;
-    }
-    file.close();
-  }
-  else
-    throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
+  int numImported = runImport(importer, filepath, convert);
+  if(numImported == -1)
+    // Cancelled - roll back
+    return 0;
 
+  // Inserted by own query
+  invalidateStatistics();
   transaction.commit();
   return numImported;
-
 }
 
 int LogdataManager::exportCsv(const QString& filepath, const QVector<int>& ids, bool exportPlan, bool exportPerf,
@@ -507,14 +561,6 @@ int LogdataManager::exportCsv(const QString& filepath, const QVector<int>& ids,
     SqlUtil util(db);
     QueryWrapper query(util.buildSelectStatement(tableName, columns), db, ids, idColumnName);
 
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
-    stream.setRealNumberNotation(QTextStream::FixedNotation);
-
-    if(!endsWithEol && append)
-      // Add needed linefeed for append
-      stream << endl;
-
     SqlExport sqlExport;
     sqlExport.setEndline(false);
     sqlExport.setHeader(header);
@@ -529,22 +575,26 @@ int LogdataManager::exportCsv(const QString& filepath, const QVector<int>& ids,
     sqlExport.addConversionFunc(exportGpx ? blobConversionFunction : blobConversionFunctionEmpty,
                                 csv::COL_MAP.value(csv::AIRCRAFT_TRAIL).second);
 
+    // Write rows directly into the file without building strings
+    SqlExportWriter writer(sqlExport, &file);
+    if(!endsWithEol && append)
+      // Add needed linefeed for append
+      writer.writeLinefeed();
+
     bool first = true;
     query.exec();
     while(query.next())
     {
       if(first && header)
-      {
         // Write header
-        first = false;
-        stream << sqlExport.getResultSetHeader(query.q.record()) << endl;
-      }
-      SqlRecord record = query.q.record();
+        writer.writeHeader(query.q.record());
+      first = false;
 
       // Write row
-      stream << sqlExport.getResultSetRow(record) << endl;
-      numExported++;
+      writer.writeRow(query.q);
     }
+    writer.close();
+    numExported = writer.getNumRows();
 
     file.close();
   }
@@ -572,11 +622,204 @@ void LogdataManager::updateSchema()
   addColumnIf("flightplan", "blob");
   addColumnIf("aircraft_perf", "blob");
   addColumnIf("aircraft_trail", "blob");
+  updateGeometrySchema();
+  updateStatisticsSchema();
+}
+
+void LogdataManager::updateGeometrySchema()
+{
+  SqlTransaction transaction(db);
+  SqlUtil util(db);
+  if(!util.hasTable("logbook_geometry"))
+    db->exec("create table logbook_geometry (logbook_id integer primary key, trail_size integer not null, "
+             "west double, north double, east double, south double, geometry blob)");
+  else
+  {
+    // Bounding rectangle for spatial index
+    util.addColumnIf("logbook_geometry", "west", "double");
+    util.addColumnIf("logbook_geometry", "north", "double");
+    util.addColumnIf("logbook_geometry", "east", "double");
+    util.addColumnIf("logbook_geometry", "south", "double");
+
+    // Remove leftovers from deleted logbook entries
+    db->exec("delete from logbook_geometry where logbook_id not in (select logbook_id from " + tableName + ")");
+  }
+  transaction.commit();
+  geometryTableState = 1;
+}
+
+bool LogdataManager::hasGeometryTable()
+{
+  if(geometryTableState == -1)
+    geometryTableState = SqlUtil(db).hasTable("logbook_geometry") ? 1 : 0;
+  return geometryTableState == 1;
 }
 
 void LogdataManager::clearGeometryCache()
 {
   cache.clear();
+  updateMemoryCost();
+
+  // Cancel running jobs and drop their results
+  prefetchGeneration++;
+  spatialIndexValid = false;
+
+  QMutexLocker locker(&prefetchMutex);
+  qDeleteAll(prefetched);
+  prefetched.clear();
+}
+
+void LogdataManager::setGeometryCacheSize(int bytes)
+{
+  cache.setMaxCost(bytes);
+  updateMemoryCost();
+}
+
+void LogdataManager::updateMemoryCost()
+{
+  atools::util::MemoryBudget& budget = atools::util::MemoryBudget::instance();
+
+  // Register on first use only since temporary instances are used for loading in the background
+  if(memoryBudgetId == 0)
+    memoryBudgetId = budget.add("Logbook geometry", atools::util::MEMORY_NORMAL, [this](qint64 bytes) {
+          shrinkGeometryCache(bytes);
+        }, &notifier);
+
+  budget.setCost(memoryBudgetId, cache.totalCost());
+}
+
+void LogdataManager::shrinkGeometryCache(qint64 bytes)
+{
+  // QCache drops least recently used entries when lowering the limit
+  int maxCost = cache.maxCost();
+  cache.setMaxCost(static_cast<int>(std::max(cache.totalCost() - bytes, qint64(0))));
+  cache.setMaxCost(maxCost);
+  updateMemoryCost();
+}
+
+int LogdataManager::geometryCost(const LogEntryGeometry& entry)
+{
+  qint64 cost = sizeof(LogEntryGeometry) + (entry.route.size() + entry.track.size()) * sizeof(atools::geo::Pos);
+  for(const QString& name : entry.names)
+    cost += sizeof(QString) + name.size() * sizeof(QChar);
+  return static_cast<int>(std::min(cost, static_cast<qint64>(std::numeric_limits<int>::max())));
+}
+
+void LogdataManager::prefetchGeometry(const atools::geo::Rect& rect)
+{
+  if(!rect.isValid())
+    return;
+
+  int generation = ++prefetchGeneration;
+
+  // Snapshot of ids which do not need to be loaded
+  QSet<int> cachedIds = cache.keys().toSet();
+  {
+    QMutexLocker locker(&prefetchMutex);
+    for(auto it = prefetched.constBegin(); it != prefetched.constEnd(); ++it)
+      cachedIds.insert(it.key());
+  }
+
+  if(loaderThread == nullptr)
+    loaderThread = new atools::sql::SqlWriterThread(db, db->connectionName() + "_" + tableName + "_geometry");
+
+  int maxCost = cache.maxCost();
+  loaderThread->post([this, rect, cachedIds, maxCost, generation](atools::sql::SqlDatabase *loaderDb) -> void {
+    LogdataManager loader(loaderDb);
+    prefetchJob(loader, rect, cachedIds, maxCost, generation);
+  });
+}
+
+void LogdataManager::prefetchJob(LogdataManager& loader, const atools::geo::Rect& rect, const QSet<int>& cachedIds,
+                                 int maxCost, int generation)
+{
+  if(!spatialIndexValid)
+    buildSpatialIndex(loader);
+
+  QVector<int> loadedIds;
+  qint64 totalCost = 0;
+  for(const std::pair<int, atools::geo::Rect>& indexEntry : spatialIndex)
+  {
+    if(generation != prefetchGeneration)
+      // Cancelled by a new request or cache clear
+      return;
+
+    if(totalCost > maxCost)
+      break;
+
+    if(cachedIds.contains(indexEntry.first) || !indexEntry.second.overlaps(rect))
+      continue;
+
+    LogEntryGeometry *entry = new LogEntryGeometry;
+    loader.readGeometry(indexEntry.first, *entry);
+    totalCost += geometryCost(*entry);
+
+    QMutexLocker locker(&prefetchMutex);
+    if(generation != prefetchGeneration)
+    {
+      delete entry;
+      return;
+    }
+    delete prefetched.value(indexEntry.first);
+    prefetched.insert(indexEntry.first, entry);
+    loadedIds.append(indexEntry.first);
+  }
+
+  if(!loadedIds.isEmpty())
+    emit notifier.geometryLoaded(loadedIds);
+}
+
+void LogdataManager::buildSpatialIndex(LogdataManager& loader)
+{
+  spatialIndex.clear();
+
+  // Use the bounding rectangle of the binary geometry if available or departure and destination otherwise
+  SqlQuery query(loader.db);
+  if(loader.hasGeometryTable())
+    query.exec("select l." + idColumnName + ", g.west, g.north, g.east, g.south, "
+               "l.departure_lonx, l.departure_laty, l.destination_lonx, l.destination_laty "
+               "from " + tableName + " l left outer join logbook_geometry g on g.logbook_id = l." + idColumnName);
+  else
+    query.exec("select " + idColumnName + ", null, null, null, null, "
+               "departure_lonx, departure_laty, destination_lonx, destination_laty from " + tableName);
+
+  while(query.next())
+  {
+    atools::geo::Rect rect;
+    if(!query.isNull(1))
+      rect = atools::geo::Rect(query.valueDouble(1), query.valueDouble(2), query.valueDouble(3),
+                               query.valueDouble(4));
+    else
+    {
+      if(!query.isNull(5) && !query.isNull(6))
+        rect.extend(atools::geo::Pos(query.valueDouble(5), query.valueDouble(6)));
+      if(!query.isNull(7) && !query.isNull(8))
+        rect.extend(atools::geo::Pos(query.valueDouble(7), query.valueDouble(8)));
+    }
+
+    if(rect.isValid())
+      spatialIndex.append(std::make_pair(query.valueInt(0), rect));
+  }
+  spatialIndexValid = true;
+}
+
+void LogdataManager::takePrefetched()
+{
+  QMutexLocker locker(&prefetchMutex);
+  for(auto it = prefetched.begin(); it != prefetched.end(); ++it)
+  {
+    if(cache.contains(it.key()))
+      delete it.value();
+    else
+      cache.insert(it.key(), it.value(), geometryCost(*it.value()));
+  }
+
+  if(!prefetched.isEmpty())
+  {
+    prefetched.clear();
+    locker.unlock();
+    updateMemoryCost();
+  }
 }
 
 bool LogdataManager::hasRouteAttached(int id)
@@ -596,6 +839,7 @@ bool LogdataManager::hasTrackAttached(int id)
 
 const LogEntryGeometry *LogdataManager::getGeometry(int id)
 {
+  takePrefetched();
   loadGpx(id);
   return cache.object(id);
 }
@@ -605,73 +849,433 @@ void LogdataManager::loadGpx(int id)
   if(!cache.contains(id))
   {
     LogEntryGeometry *entry = new LogEntryGeometry;
-    atools::fs::pln::FlightplanIO().loadGpxGz(&entry->route, &entry->names, &entry->track,
-                                              getValue(id, "aircraft_trail").toByteArray());
-    entry->routeRect = entry->route.boundingRect();
-    entry->trackRect = entry->track.boundingRect();
-    cache.insert(id, entry);
+    SqlTransaction transaction(db);
+    readGeometry(id, *entry);
+    transaction.commit();
+    cache.insert(id, entry, geometryCost(*entry));
+    updateMemoryCost();
   }
 }
 
-void LogdataManager::getFlightStatsTime(QDateTime& earliest, QDateTime& latest, QDateTime& earliestSim,
-                                        QDateTime& latestSim)
+void LogdataManager::readGeometry(int id, LogEntryGeometry& entry)
 {
-  SqlQuery query("select min(departure_time), max(departure_time), "
-                 "min(departure_time_sim), max(departure_time_sim) from " + tableName, db);
+  QByteArray trail;
+  bool binary = loadBinaryGeometry(id, entry);
+  if(!binary)
+  {
+    // Binary geometry not available or outdated - parse GPX and store the result for the next time
+    trail = getValue(id, "aircraft_trail").toByteArray();
+    atools::fs::pln::FlightplanIO().loadGpxGz(&entry.route, &entry.names, &entry.track, trail);
+  }
+
+  entry.routeRect = entry.route.boundingRect();
+  entry.trackRect = entry.track.boundingRect();
+
+  if(!binary)
+    saveBinaryGeometry(id, entry, trail.size());
+}
+
+bool LogdataManager::loadBinaryGeometry(int id, LogEntryGeometry& entry)
+{
+  if(!hasGeometryTable())
+    return false;
+
+  // Geometry is valid only if the trail was not changed since
+  SqlQuery query(db);
+  query.prepare("select g.geometry from logbook_geometry g join " + tableName + " l on g.logbook_id = l." +
+                idColumnName + " where g.logbook_id = :id and g.trail_size = coalesce(length(l.aircraft_trail), 0)");
+  query.bindValue(":id", id);
   query.exec();
-  if(query.next())
+  if(query.next() && geometryFromBytes(query.value(0).toByteArray(), entry))
+    return true;
+
+  entry = LogEntryGeometry();
+  return false;
+}
+
+void LogdataManager::saveBinaryGeometry(int id, const LogEntryGeometry& entry, int trailSize)
+{
+  if(!hasGeometryTable())
+    return;
+
+  atools::geo::Rect rect = entry.routeRect;
+  if(entry.trackRect.isValid())
   {
-    earliest = query.valueDateTime(0);
-    latest = query.valueDateTime(1);
-    earliestSim = query.valueDateTime(2);
-    latestSim = query.valueDateTime(3);
+    if(rect.isValid())
+      rect.extend(entry.trackRect);
+    else
+      rect = entry.trackRect;
   }
+
+  SqlQuery query(db);
+  query.prepare("insert or replace into logbook_geometry (logbook_id, trail_size, west, north, east, south, geometry) "
+                "values(:id, :size, :west, :north, :east, :south, :geometry)");
+  query.bindValue(":id", id);
+  query.bindValue(":size", trailSize);
+  query.bindValue(":west", rect.isValid() ? QVariant(rect.getWest()) : QVariant(QVariant::Double));
+  query.bindValue(":north", rect.isValid() ? QVariant(rect.getNorth()) : QVariant(QVariant::Double));
+  query.bindValue(":east", rect.isValid() ? QVariant(rect.getEast()) : QVariant(QVariant::Double));
+  query.bindValue(":south", rect.isValid() ? QVariant(rect.getSouth()) : QVariant(QVariant::Double));
+  query.bindValue(":geometry", geometryToBytes(entry));
+  query.exec();
+}
+
+QByteArray LogdataManager::geometryToBytes(const LogEntryGeometry& entry)
+{
+  QByteArray bytes;
+  bytes.append(static_cast<char>(GEOMETRY_VERSION));
+  atools::fs::common::BinaryGeometry::writeDelta(entry.route, bytes);
+
+  // Number of names and zero terminated UTF-8 strings - usually same number as route points
+  quint32 numNames = qToLittleEndian(static_cast<quint32>(entry.names.size()));
+  bytes.append(reinterpret_cast<const char *>(&numNames), sizeof(numNames));
+  for(const QString& name : entry.names)
+  {
+    bytes.append(name.toUtf8());
+    bytes.append('\0');
+  }
+
+  atools::fs::common::BinaryGeometry::writeDelta(entry.track, bytes);
+  return bytes;
+}
+
+bool LogdataManager::geometryFromBytes(const QByteArray& bytes, LogEntryGeometry& entry)
+{
+  if(bytes.isEmpty() || static_cast<quint8>(bytes.at(0)) != GEOMETRY_VERSION)
+    return false;
+
+  int offset = 1;
+  if(!atools::fs::common::BinaryGeometry::readDelta(bytes, offset, entry.route))
+    return false;
+
+  entry.names.clear();
+  if(offset + static_cast<int>(sizeof(quint32)) > bytes.size())
+    return false;
+  quint32 numNames = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(bytes.constData() + offset));
+  offset += sizeof(quint32);
+
+  for(quint32 i = 0; i < numNames; i++)
+  {
+    int end = bytes.indexOf('\0', offset);
+    if(end == -1)
+      return false;
+    entry.names.append(QString::fromUtf8(bytes.constData() + offset, end - offset));
+    offset = end + 1;
+  }
+
+  return atools::fs::common::BinaryGeometry::readDelta(bytes, offset, entry.track);
+}
+
+void LogdataManager::getFlightStatsTime(QDateTime& earliest, QDateTime& latest, QDateTime& earliestSim,
+                                        QDateTime& latestSim)
+{
+  QVariantList values = getStatistics();
+  earliest = values.at(stats::DEPARTURE_TIME_MIN).toDateTime();
+  latest = values.at(stats::DEPARTURE_TIME_MAX).toDateTime();
+  earliestSim = values.at(stats::DEPARTURE_TIME_SIM_MIN).toDateTime();
+  latestSim = values.at(stats::DEPARTURE_TIME_SIM_MAX).toDateTime();
 }
 
 void LogdataManager::getFlightStatsDistance(float& distTotal, float& distMax, float& distAverage)
 {
-  SqlQuery query("select sum(distance), max(distance), avg(distance) from " + tableName, db);
+  QVariantList values = getStatistics();
+  distTotal = values.at(stats::DISTANCE_SUM).toFloat();
+  distMax = values.at(stats::DISTANCE_MAX).toFloat();
+  int num = values.at(stats::DISTANCE_NUM).toInt();
+  distAverage = num > 0 ? distTotal / num : 0.f;
+}
+
+void LogdataManager::getFlightStatsAirports(int& numDepartAirports, int& numDestAirports)
+{
+  numDepartAirports = getStatisticsNumDistinct("departure_ident");
+  numDestAirports = getStatisticsNumDistinct("destination_ident");
+}
+
+void LogdataManager::getFlightStatsAircraft(int& numTypes, int& numRegistrations, int& numNames, int& numSimulators)
+{
+  numTypes = getStatisticsNumDistinct("aircraft_type");
+  numRegistrations = getStatisticsNumDistinct("aircraft_registration");
+  numNames = getStatisticsNumDistinct("aircraft_name");
+  numSimulators = getStatisticsNumDistinct("simulator");
+}
+
+void LogdataManager::getFlightStatsSimulator(QVector<std::pair<int, QString> >& numSimulators)
+{
+  SqlQuery query(db);
+  if(hasStatisticsTable())
+  {
+    getStatistics();
+    query.exec("select num, value from logbook_stats_value where type = 'simulator' order by num desc");
+  }
+  else
+    query.exec("select count(1), simulator from " + tableName + " group by simulator order by count(1) desc");
+
+  while(query.next())
+    numSimulators.append(std::make_pair(query.valueInt(0), query.valueStr(1)));
+}
+
+void LogdataManager::getFlightStatsTripTime(float& timeMaximum, float& timeAverage, float& timeMaximumSim,
+                                            float& timeAverageSim)
+{
+  QVariantList values = getStatistics();
+  int num = values.at(stats::TIME_REAL_NUM).toInt();
+  timeMaximum = values.at(stats::TIME_REAL_MAX).toFloat() / 3600.f;
+  timeAverage = num > 0 ? values.at(stats::TIME_REAL_SUM).toFloat() / num / 3600.f : 0.f;
+
+  int numSim = values.at(stats::TIME_SIM_NUM).toInt();
+  timeMaximumSim = values.at(stats::TIME_SIM_MAX).toFloat() / 3600.f;
+  timeAverageSim = numSim > 0 ? values.at(stats::TIME_SIM_SUM).toFloat() / numSim / 3600.f : 0.f;
+}
+
+void LogdataManager::rowsChanging(const QVector<int>& ids)
+{
+  updateStatistics(ids, -1);
+}
+
+void LogdataManager::rowsChanged(const QVector<int>& ids)
+{
+  updateStatistics(ids, 1);
+}
+
+void LogdataManager::tableChanged()
+{
+  invalidateStatistics();
+}
+
+void LogdataManager::updateStatisticsSchema()
+{
+  if(!SqlUtil(db).hasTable("logbook_stats"))
+  {
+    SqlTransaction transaction(db);
+    db->exec("create table logbook_stats (num_entries integer not null, "
+             "distance_sum double, distance_max double, distance_num integer, "
+             "departure_time_min varchar(100), departure_time_max varchar(100), "
+             "departure_time_sim_min varchar(100), departure_time_sim_max varchar(100), "
+             "time_real_max integer, time_real_sum integer, time_real_num integer, "
+             "time_sim_max integer, time_sim_sum integer, time_sim_num integer)");
+    db->exec("create table logbook_stats_value (type varchar(50) not null, value varchar(1024), "
+             "num integer not null)");
+    db->exec("create index if not exists idx_logbook_stats_value_type on logbook_stats_value(type)");
+    transaction.commit();
+  }
+  statisticsTableState = 1;
+}
+
+bool LogdataManager::hasStatisticsTable()
+{
+  if(statisticsTableState == -1)
+    statisticsTableState = SqlUtil(db).hasTable("logbook_stats") ? 1 : 0;
+  return statisticsTableState == 1;
+}
+
+void LogdataManager::invalidateStatistics()
+{
+  // Missing row means invalid
+  if(hasStatisticsTable())
+    SqlQuery("delete from logbook_stats", db).exec();
+}
+
+void LogdataManager::rebuildStatistics()
+{
+  if(!hasStatisticsTable())
+    return;
+
+  qDebug() << Q_FUNC_INFO;
+
+  SqlTransaction transaction(db);
+  SqlQuery("delete from logbook_stats_value", db).exec();
+  writeStatistics(aggregateStatistics(QString()));
+
+  for(const char *column : stats::VALUE_COLUMNS)
+    SqlQuery("insert into logbook_stats_value (type, value, num) select '" + QString(column) + "', " + column +
+             ", count(1) from " + tableName + " group by " + column, db).exec();
+  transaction.commit();
+}
+
+void LogdataManager::updateStatistics(const QVector<int>& ids, int sign)
+{
+  QVariantList values;
+  if(ids.isEmpty() || !hasStatisticsTable() || !readStatistics(values))
+    // Nothing to do or will be rebuilt on next access anyway
+    return;
+
+  bool valid = true;
+  for(int i = 0; i < ids.size() && valid; i += stats::ID_BATCH_SIZE)
+  {
+    QStringList idStrs;
+    for(int id : ids.mid(i, stats::ID_BATCH_SIZE))
+      idStrs.append(QString::number(id));
+    QString where = " where " + idColumnName + " in (" + idStrs.join(", ") + ")";
+
+    QVariantList delta = aggregateStatistics(where);
+    if(delta.at(stats::NUM_ENTRIES).toInt() == 0)
+      continue;
+
+    for(int col = 0; col < stats::NUM_COLUMNS && valid; col++)
+    {
+      QVariant value = values.at(col), deltaValue = delta.at(col);
+      if(deltaValue.isNull())
+        continue;
+
+      stats::Type type = stats::COLUMNS[col].second;
+      if(type == stats::SUM)
+      {
+        if(value.isNull() && sign < 0)
+          valid = false;
+        else
+          values[col] = value.isNull() ? deltaValue : stats::add(value, deltaValue, sign);
+      }
+      else
+      {
+        // Compare delta with current minimum or maximum
+        int cmp = value.isNull() ? 0 : stats::compare(deltaValue, value);
+        if(type == stats::MIN)
+          cmp = -cmp;
+
+        if(sign > 0)
+        {
+          if(value.isNull() || cmp > 0)
+            values[col] = deltaValue;
+        }
+        else if(value.isNull() || cmp >= 0)
+          // Removed the current minimum or maximum - the next one is not known
+          valid = false;
+      }
+    }
+
+    if(valid)
+      updateStatisticsValues(where, sign);
+  }
+
+  if(valid && values.at(stats::NUM_ENTRIES).toLongLong() > 0)
+    writeStatistics(values);
+  else
+    invalidateStatistics();
+}
+
+void LogdataManager::updateStatisticsValues(const QString& where, int sign)
+{
+  SqlQuery updateQuery(db);
+  updateQuery.prepare("update logbook_stats_value set num = num + ? where type = ? and value is ?");
+  SqlQuery insertQuery(db);
+  insertQuery.prepare("insert into logbook_stats_value (type, value, num) values(?, ?, ?)");
+
+  for(const char *column : stats::VALUE_COLUMNS)
+  {
+    SqlQuery query("select " + QString(column) + ", count(1) from " + tableName + where + " group by " + column, db);
+    query.exec();
+    while(query.next())
+    {
+      int num = query.valueInt(1) * sign;
+      updateQuery.bindValue(0, num);
+      updateQuery.bindValue(1, column);
+      updateQuery.bindValue(2, query.value(0));
+      updateQuery.exec();
+
+      if(updateQuery.numRowsAffected() == 0 && num > 0)
+      {
+        insertQuery.bindValue(0, column);
+        insertQuery.bindValue(1, query.value(0));
+        insertQuery.bindValue(2, num);
+        insertQuery.exec();
+      }
+    }
+  }
+
+  if(sign < 0)
+    SqlQuery("delete from logbook_stats_value where num <= 0", db).exec();
+}
+
+QVariantList LogdataManager::aggregateStatistics(const QString& where)
+{
+  // Order has to match stats::Index
+  SqlQuery query("select count(1), sum(distance), max(distance), count(distance), "
+                 "min(departure_time), max(departure_time), min(departure_time_sim), max(departure_time_sim), "
+                 "max(time_real), sum(time_real), count(time_real), max(time_sim), sum(time_sim), count(time_sim) "
+                 "from (select distance, departure_time, departure_time_sim, "
+                 "strftime('%s', destination_time) - strftime('%s', departure_time) as time_real, "
+                 "strftime('%s', destination_time_sim) - strftime('%s', departure_time_sim) as time_sim "
+                 "from " + tableName + where + ")", db);
   query.exec();
+
+  QVariantList values;
   if(query.next())
   {
-    distTotal = query.valueFloat(0);
-    distMax = query.valueFloat(1);
-    distAverage = query.valueFloat(2);
+    for(int i = 0; i < stats::NUM_COLUMNS; i++)
+      values.append(query.value(i));
+  }
+  else
+  {
+    for(int i = 0; i < stats::NUM_COLUMNS; i++)
+      values.append(QVariant());
   }
+  return values;
 }
 
-void LogdataManager::getFlightStatsAirports(int& numDepartAirports, int& numDestAirports)
+bool LogdataManager::readStatistics(QVariantList& values)
 {
-  SqlQuery query("select count(distinct departure_ident), count(distinct destination_ident) from " + tableName, db);
+  QStringList columns;
+  for(const std::pair<const char *, stats::Type>& column : stats::COLUMNS)
+    columns.append(column.first);
+
+  SqlQuery query("select " + columns.join(", ") + " from logbook_stats", db);
   query.exec();
   if(query.next())
   {
-    numDepartAirports = query.valueInt(0);
-    numDestAirports = query.valueInt(1);
+    values.clear();
+    for(int i = 0; i < stats::NUM_COLUMNS; i++)
+      values.append(query.value(i));
+    return true;
   }
+  return false;
 }
 
-void LogdataManager::getFlightStatsAircraft(int& numTypes, int& numRegistrations, int& numNames, int& numSimulators)
+void LogdataManager::writeStatistics(const QVariantList& values)
 {
-  SqlQuery query("select count(distinct aircraft_type), count(distinct aircraft_registration), "
-                 "count(distinct aircraft_name), count(distinct simulator) "
-                 "from " + tableName, db);
+  QStringList columns;
+  for(const std::pair<const char *, stats::Type>& column : stats::COLUMNS)
+    columns.append(column.first);
+
+  SqlQuery("delete from logbook_stats", db).exec();
+
+  SqlQuery query(db);
+  query.prepare("insert into logbook_stats (" + columns.join(", ") + ") values(" +
+                QString("?, ").repeated(stats::NUM_COLUMNS - 1) + "?)");
+  for(int i = 0; i < stats::NUM_COLUMNS; i++)
+    query.bindValue(i, values.at(i));
   query.exec();
-  if(query.next())
+}
+
+QVariantList LogdataManager::getStatistics()
+{
+  if(!hasStatisticsTable())
+    // Old schema - calculate on the fly
+    return aggregateStatistics(QString());
+
+  QVariantList values;
+  if(!readStatistics(values))
   {
-    numTypes = query.valueInt(0);
-    numRegistrations = query.valueInt(1);
-    numNames = query.valueInt(2);
-    numSimulators = query.valueInt(3);
+    rebuildStatistics();
+    readStatistics(values);
   }
+  return values;
 }
 
-void LogdataManager::getFlightStatsSimulator(QVector<std::pair<int, QString> >& numSimulators)
+int LogdataManager::getStatisticsNumDistinct(const QString& column)
 {
-  SqlQuery query("select count(1), simulator from " + tableName + " group by simulator order by count(1) desc", db);
+  SqlQuery query(db);
+  if(hasStatisticsTable())
+  {
+    // Rebuild if needed
+    getStatistics();
+    query.prepare("select count(value) from logbook_stats_value where type = ?");
+    query.bindValue(0, column);
+  }
+  else
+    query.prepare("select count(distinct " + column + ") from " + tableName);
+
   query.exec();
-  while(query.next())
-    numSimulators.append(std::make_pair(query.valueInt(0), query.valueStr(1)));
+  return query.next() ? query.valueInt(0) : 0;
 }
 
 void LogdataManager::fixEmptyStrField(sql::SqlRecord& rec, const QString& name)
@@ -698,6 +1302,18 @@ void LogdataManager::fixEmptyBlobField(sql::SqlQuery& query, const QString& name
     query.bindValue(name, QVariant(QVariant::ByteArray));
 }
 
+void LogdataManager::fixEmptyStrField(ImportRow& row, const QString& name)
+{
+  if(row.boundValue(name).isNull())
+    row.bindValue(name, "");
+}
+
+void LogdataManager::fixEmptyBlobField(ImportRow& row, const QString& name)
+{
+  if(row.boundValue(name).toByteArray().isEmpty())
+    row.bindValue(name, QVariant(QVariant::ByteArray));
+}
+
 void LogdataManager::fixEmptyFields(sql::SqlRecord& rec)
 {
   if(rec.contains("distance") && rec.isNull("distance"))
@@ -717,6 +1333,25 @@ void LogdataManager::fixEmptyFields(sql::SqlRecord& rec)
   fixEmptyBlobField(rec, "aircraft_trail");
 }
 
+void LogdataManager::fixEmptyFields(ImportRow& row)
+{
+  if(row.boundValue(":distance").isNull())
+    row.bindValue(":distance", 0.f);
+
+  fixEmptyStrField(row, ":aircraft_name");
+  fixEmptyStrField(row, ":aircraft_type");
+  fixEmptyStrField(row, ":aircraft_registration");
+  fixEmptyStrField(row, ":route_string");
+  fixEmptyStrField(row, ":description");
+  fixEmptyStrField(row, ":simulator");
+  fixEmptyStrField(row, ":departure_ident");
+  fixEmptyStrField(row, ":destination_ident");
+
+  fixEmptyBlobField(row, ":flightplan");
+  fixEmptyBlobField(row, ":aircraft_perf");
+  fixEmptyBlobField(row, ":aircraft_trail");
+}
+
 void LogdataManager::fixEmptyFields(sql::SqlQuery& query)
 {
   if(query.boundValue(":distance", true).isNull())
@@ -736,23 +1371,6 @@ void LogdataManager::fixEmptyFields(sql::SqlQuery& query)
   fixEmptyBlobField(query, ":aircraft_trail");
 }
 
-void LogdataManager::getFlightStatsTripTime(float& timeMaximum, float& timeAverage, float& timeMaximumSim,
-                                            float& timeAverageSim)
-{
-  SqlQuery query("select max(time_real), avg(time_real), max(time_sim), avg(time_sim) from (select "
-                 "strftime('%s', destination_time) - strftime('%s', departure_time) as time_real, "
-                 "strftime('%s', destination_time_sim) - strftime('%s', departure_time_sim) as time_sim "
-                 "from " + tableName + ")", db);
-  query.exec();
-  if(query.next())
-  {
-    timeMaximum = query.valueFloat(0) / 3600.f;
-    timeAverage = query.valueFloat(1) / 3600.f;
-    timeMaximumSim = query.valueFloat(2) / 3600.f;
-    timeAverageSim = query.valueFloat(3) / 3600.f;
-  }
-}
-
 } // namespace userdata
 } // namespace fs
 } // namespace atools
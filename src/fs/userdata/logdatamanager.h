@@ -20,8 +20,14 @@
 
 #include "fs/userdata/datamanagerbase.h"
 #include "geo/linestring.h"
+#include "geo/rect.h"
 
 #include <QCache>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+
+#include <atomic>
 
 namespace atools {
 namespace geo {
@@ -29,6 +35,7 @@ class LineString;
 }
 namespace sql {
 class SqlDatabase;
+class SqlWriterThread;
 }
 
 namespace fs {
@@ -44,6 +51,19 @@ struct LogEntryGeometry
   atools::geo::Rect routeRect, trackRect;
 };
 
+/* Publishes geometries loaded in background by LogdataManager::prefetchGeometry() */
+class LogdataGeometryNotifier :
+  public QObject
+{
+  Q_OBJECT
+
+signals:
+  /* Sent from the loader thread. Geometries for ids can be fetched by LogdataManager::getGeometry() without
+   * database access. */
+  void geometryLoaded(const QVector<int>& ids);
+
+};
+
 /*
  * Contains special functionality around the logbook database.
  */
@@ -74,9 +94,28 @@ public:
    *  Also includes route waypoint names. */
   const atools::fs::userdata::LogEntryGeometry *getGeometry(int id);
 
-  /* Clear cache used by getRouteGeometry and getTrackGeometry */
+  /* Clear cache used by getRouteGeometry and getTrackGeometry. Cancels prefetching and rebuilds the spatial index. */
   void clearGeometryCache();
 
+  /*
+   * Load geometries of all entries overlapping rect in a background thread on a separate database connection.
+   * Cached entries are skipped and loading stops when the cache size is reached.
+   * A new call cancels the remaining work of the previous call.
+   * Connect to getGeometryNotifier() to get notified about loaded entries.
+   *
+   * Entries are found using a spatial index built from route and track bounding rectangles.
+   * Departure and destination are used for entries which were never loaded before.
+   */
+  void prefetchGeometry(const atools::geo::Rect& rect);
+
+  LogdataGeometryNotifier *getGeometryNotifier()
+  {
+    return &notifier;
+  }
+
+  /* Maximum memory of all cached geometries in bytes */
+  void setGeometryCacheSize(int bytes);
+
   /* true if any of the files/BLOBs is present (length > 0) for the dataset */
   bool hasRouteAttached(int id);
   bool hasPerfAttached(int id);
@@ -98,17 +137,37 @@ public:
   /* Simulator to number of logbook entries */
   void getFlightStatsSimulator(QVector<std::pair<int, QString> >& numSimulators);
 
+  /* The statistics above are read from the table logbook_stats which is updated incrementally by all methods
+   * changing the logbook. Tables are rebuilt from all logbook entries if a change cannot be applied
+   * incrementally, like removing the entry with the longest distance. */
+
+  /* Recalculate statistics from all logbook entries */
+  void rebuildStatistics();
+
+  /* Statistics will be rebuilt on next access. Call after changing the logbook table directly. */
+  void invalidateStatistics();
+
   /* Fills null fields with empty strings to avoid issue when searching */
   static void fixEmptyFields(atools::sql::SqlRecord& rec);
   static void fixEmptyFields(atools::sql::SqlQuery& query);
+  static void fixEmptyFields(atools::fs::userdata::ImportRow& row);
 
   static const int MAX_CACHE_ENTRIES = 100;
+  static const int DEFAULT_CACHE_BYTES = 64 * 1024 * 1024;
+
+protected:
+  /* Update statistics */
+  virtual void rowsChanging(const QVector<int>& ids) override;
+  virtual void rowsChanged(const QVector<int>& ids) override;
+  virtual void tableChanged() override;
 
 private:
   static void fixEmptyStrField(atools::sql::SqlRecord& rec, const QString& name);
   static void fixEmptyStrField(atools::sql::SqlQuery& query, const QString& name);
   static void fixEmptyBlobField(atools::sql::SqlRecord& rec, const QString& name);
   static void fixEmptyBlobField(atools::sql::SqlQuery& query, const QString& name);
+  static void fixEmptyStrField(atools::fs::userdata::ImportRow& row, const QString& name);
+  static void fixEmptyBlobField(atools::fs::userdata::ImportRow& row, const QString& name);
 
   /* Convert Gzipped BLOB to text (file) */
   static QString blobConversionFunction(const QVariant& value);
@@ -119,9 +178,93 @@ private:
   /* Prime cache by loading the GpxCacheEntry */
   void loadGpx(int id);
 
-  /* Cache to avoid reading BLOBs */
+  /* Read binary geometry from table logbook_geometry. Returns false if missing or outdated. */
+  bool loadBinaryGeometry(int id, LogEntryGeometry& entry);
+
+  /* Load geometry from binary or GPX and store binary geometry if missing. Needs an open transaction. */
+  void readGeometry(int id, LogEntryGeometry& entry);
+
+  /* Store binary geometry for id. trailSize is the size of the GPX BLOB used to check if it is current.
+   * Needs an open transaction. */
+  void saveBinaryGeometry(int id, const LogEntryGeometry& entry, int trailSize);
+
+  /* Approximate memory usage of a cache entry in bytes */
+  static int geometryCost(const LogEntryGeometry& entry);
+
+  /* Move entries loaded by the prefetch thread into the cache */
+  void takePrefetched();
+
+  /* Report cache size to the memory budget and register if needed */
+  void updateMemoryCost();
+
+  /* Called by the memory budget in the thread of the notifier */
+  void shrinkGeometryCache(qint64 bytes);
+
+  /* Called in loader thread with the manager for the loader connection */
+  void prefetchJob(LogdataManager& loader, const atools::geo::Rect& rect, const QSet<int>& cachedIds,
+                   int maxCost, int generation);
+  void buildSpatialIndex(LogdataManager& loader);
+
+  /* Convert geometry to compact binary format and back */
+  static QByteArray geometryToBytes(const LogEntryGeometry& entry);
+  static bool geometryFromBytes(const QByteArray& bytes, LogEntryGeometry& entry);
+
+  /* Create table for binary geometry if missing and remove orphaned rows */
+  void updateGeometrySchema();
+
+  /* Format version of the binary geometry */
+  static const quint8 GEOMETRY_VERSION = 1;
+
+  /* true if table logbook_geometry exists - checked once */
+  bool hasGeometryTable();
+  int geometryTableState = -1;
+
+  /* Statistics ===================================== */
+  /* Create tables for statistics if missing */
+  void updateStatisticsSchema();
+
+  /* true if table logbook_stats exists - checked once */
+  bool hasStatisticsTable();
+  int statisticsTableState = -1;
+
+  /* Add (sign = 1) or remove (sign = -1) the given rows to or from the statistics */
+  void updateStatistics(const QVector<int>& ids, int sign);
+  void updateStatisticsValues(const QString& where, int sign);
+
+  /* Get aggregates for all or the given rows in the order of the columns in logbook_stats */
+  QVariantList aggregateStatistics(const QString& where);
+
+  /* Read and write the single row of logbook_stats. Returns false if not valid. */
+  bool readStatistics(QVariantList& values);
+  void writeStatistics(const QVariantList& values);
+
+  /* Get current statistics. Rebuilds tables if needed. */
+  QVariantList getStatistics();
+
+  /* Get number of distinct values for columns in the statistics */
+  int getStatisticsNumDistinct(const QString& column);
+
+  /* Cache to avoid reading BLOBs. Cost is size in bytes. */
   QCache<int, LogEntryGeometry> cache;
 
+  /* Id in atools::util::MemoryBudget or 0 if not registered yet */
+  int memoryBudgetId = 0;
+
+  /* Background loading ===================================== */
+  atools::sql::SqlWriterThread *loaderThread = nullptr;
+  LogdataGeometryNotifier notifier;
+
+  /* Loaded geometries not yet moved into the cache. Guarded by prefetchMutex. */
+  QHash<int, LogEntryGeometry *> prefetched;
+  QMutex prefetchMutex;
+
+  /* Incremented to cancel running prefetch jobs */
+  std::atomic<int> prefetchGeneration;
+
+  /* Bounding rectangle for each logbook entry. Accessed in loader thread only. */
+  QVector<std::pair<int, atools::geo::Rect> > spatialIndex;
+  std::atomic<bool> spatialIndexValid;
+
 };
 
 } // namespace userdata
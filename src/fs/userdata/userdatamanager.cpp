@@ -19,11 +19,13 @@
 
 #include "sql/sqlutil.h"
 #include "sql/sqlexport.h"
+#include "sql/sqlexportwriter.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqltransaction.h"
-#include "util/csvreader.h"
 #include "atools.h"
 #include "geo/pos.h"
+#include "geo/rect.h"
+#include "geo/linestring.h"
 #include "fs/common/magdecreader.h"
 #include "fs/util/fsutil.h"
 #include "exception.h"
@@ -41,12 +43,16 @@ using atools::sql::SqlUtil;
 using atools::sql::SqlDatabase;
 using atools::sql::SqlQuery;
 using atools::sql::SqlExport;
+using atools::sql::SqlExportWriter;
 using atools::sql::SqlRecord;
 using atools::sql::SqlTransaction;
 
 /* Default visibility. Waypoint is shown on the map at a view distance below this value  */
 const static int VISIBLE_FROM_DEFAULT_NM = 250;
 
+/* Rebuild spatial index instead of updating it if more rows are changed at once */
+const static int MAX_SPATIAL_INDEX_UPDATE = 1000;
+
 namespace csv {
 /* Column indexes in CSV format */
 enum Index
@@ -118,6 +124,7 @@ void UserdataManager::updateSchema()
     // Add missing column and index
     db->exec("alter table " + tableName + " add column temp integer");
     db->exec("create index if not exists idx_userdata_temp on " + tableName + "(temp)");
+    db->clearQueryCache();
     transaction.commit();
   }
 }
@@ -134,6 +141,7 @@ void UserdataManager::clearTemporary()
     SqlQuery deleteQuery("delete from " + tableName + " where temp = 1", db);
     deleteQuery.exec();
     transaction.commit();
+    tableChanged();
   }
 }
 
@@ -145,86 +153,62 @@ int UserdataManager::importCsv(const QString& filepath, atools::fs::userdata::Fl
   SqlTransaction transaction(db);
 
   // Autogenerate id
-  QString insert = SqlUtil(db).buildInsertStatement(tableName, QString(), {idColumnName}, true);
-  SqlQuery insertQuery(db);
-  insertQuery.prepare(insert);
+  BulkImporter importer(db, tableName, {idColumnName});
+  importer.setCsv(separator, escape, true /* trim */);
 
   QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-  QDateTime now = QDateTime::currentDateTime();
-
-  int numImported = 0;
-  QFile file(filepath);
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
-  {
-    atools::util::CsvReader reader(separator, escape, true /* trim */);
-
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
+  QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
 
-    int lineNum = 0;
-    while(!stream.atEnd())
+  bool first = true;
+  auto convert = [&](const ImportRecord& record, ImportRow& row) -> BulkImporter::Result {
+    if(first)
     {
-      QString line = stream.readLine();
+      first = false;
+      QString header = QString(record.line).replace(" ", QString()).toLower();
+      if(flags & CSV_HEADER || header.startsWith("type,name,ident,latitude,longitude,elevation"))
+        // Ignore header
+        return BulkImporter::SKIP;
+    }
 
-      if(lineNum == 0)
-      {
-        QString header = QString(line).replace(" ", QString()).toLower();
-        if(flags & CSV_HEADER || header.startsWith("type,name,ident,latitude,longitude,elevation"))
-        {
-          lineNum++;
-          // Ignore header
-          continue;
-        }
-      }
+    const QStringList& values = record.values;
+    row.bindValue(":type", at(values, csv::TYPE));
+    row.bindValue(":name", at(values, csv::NAME));
+    row.bindValue(":ident", at(values, csv::IDENT));
+    row.bindValue(":region", at(values, csv::REGION, true /* no warning */));
+    row.bindValue(":description", at(values, csv::DESCRIPTION));
+    row.bindValue(":tags", at(values, csv::TAGS));
+    row.bindValue(":import_file_path", absfilepath);
+    row.bindValue(":temp", 0);
+
+    // YYYY-MM-DDTHH:mm:ss
+    QDateTime lastEdit = QDateTime::fromString(at(values, csv::LAST_EDIT, true /* no warning */), Qt::ISODate);
+    if(lastEdit.isValid())
+      row.bindValue(":last_edit_timestamp", lastEdit.toString(Qt::ISODate));
+    else
+      row.bindValue(":last_edit_timestamp", now);
 
-      // Skip empty lines but add them if within an escaped field
-      if(line.isEmpty() && !reader.isInEscape())
-        continue;
-
-      reader.readCsvLine(line);
-      if(reader.isInEscape())
-        // Still in an escaped line so continue to read unchanged until " shows the end of the field
-        continue;
-
-      const QStringList& values = reader.getValues();
-
-      insertQuery.bindValue(":type", at(values, csv::TYPE));
-      insertQuery.bindValue(":name", at(values, csv::NAME));
-      insertQuery.bindValue(":ident", at(values, csv::IDENT));
-      insertQuery.bindValue(":region", at(values, csv::REGION, true /* no warning */));
-      insertQuery.bindValue(":description", at(values, csv::DESCRIPTION));
-      insertQuery.bindValue(":tags", at(values, csv::TAGS));
-      insertQuery.bindValue(":import_file_path", absfilepath);
-      insertQuery.bindValue(":temp", 0);
-
-      // YYYY-MM-DDTHH:mm:ss
-      QDateTime lastEdit = QDateTime::fromString(at(values, csv::LAST_EDIT, true /* no warning */), Qt::ISODate);
-      if(lastEdit.isValid())
-        insertQuery.bindValue(":last_edit_timestamp", lastEdit.toString(Qt::ISODate));
-      else
-        insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
+    bool ok;
+    int visibleFrom = atools::roundToInt(at(values, csv::VISIBLE_FROM, true /* no warning */).toFloat(&ok));
+    if(visibleFrom > 0 && ok)
+      row.bindValue(":visible_from", visibleFrom);
+    else
+      row.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
 
-      bool ok;
-      int visibleFrom = atools::roundToInt(at(values, csv::VISIBLE_FROM, true /* no warning */).toFloat(&ok));
-      if(visibleFrom > 0 && ok)
-        insertQuery.bindValue(":visible_from", visibleFrom);
-      else
-        insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
+    row.bindValue(":altitude", at(values, csv::ALT));
 
-      insertQuery.bindValue(":altitude", at(values, csv::ALT));
+    validateCoordinates(record.line, at(values, csv::LONX), at(values, csv::LATY));
+    row.bindValue(":lonx", atFloat(values, csv::LONX, true));
+    row.bindValue(":laty", atFloat(values, csv::LATY, true));
+    return BulkImporter::INSERT;
+  };
+
+  int numImported = runImport(importer, filepath, convert);
+  if(numImported == -1)
+    // Cancelled - roll back
+    return 0;
 
-      validateCoordinates(line, at(values, csv::LONX), at(values, csv::LATY));
-      insertQuery.bindValue(":lonx", atFloat(values, csv::LONX, true));
-      insertQuery.bindValue(":laty", atFloat(values, csv::LATY, true));
-      insertQuery.exec();
-      lineNum++;
-      numImported++;
-    }
-    file.close();
-  }
-  else
-    throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
   transaction.commit();
+  tableChanged();
   return numImported;
 }
 
@@ -236,16 +220,7 @@ int UserdataManager::importCsv(const QString& filepath, atools::fs::userdata::Fl
 // 37.770908333 -122.082811111 AAAME ENRT  K2 4530263
 int UserdataManager::importXplane(const QString& filepath)
 {
-  SqlTransaction transaction(db);
-  QString insert = SqlUtil(db).buildInsertStatement(tableName,
-                                                    QString(), {idColumnName, "description", "altitude"}, true);
-  SqlQuery insertQuery(db);
-  insertQuery.prepare(insert);
-
-  QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-  QDateTime now = QDateTime::currentDateTime();
-
-  int numImported = 0;
+  // Check header before reading the file in background
   QFile file(filepath);
   if(file.open(QIODevice::ReadOnly | QIODevice::Text))
   {
@@ -263,39 +238,46 @@ int UserdataManager::importXplane(const QString& filepath)
     line = stream.readLine().simplified();
     if(!line.isEmpty())
       throw atools::Exception("File is not an X-Plane user_fix.dat file.");
-
-    int lineNum = 0;
-    while(!stream.atEnd())
-    {
-      line = stream.readLine().simplified();
-      if(line.isEmpty())
-        continue;
-      if(line == "99")
-        break;
-
-      QStringList cols = line.split(" ");
-
-      insertQuery.bindValue(":type", "Waypoint");
-      insertQuery.bindValue(":ident", at(cols, xp::IDENT));
-      insertQuery.bindValue(":region", at(cols, xp::REGION));
-      insertQuery.bindValue(":tags", at(cols, xp::AIRPORT));
-      insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
-      insertQuery.bindValue(":import_file_path", absfilepath);
-      insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
-      insertQuery.bindValue(":temp", 0);
-
-      validateCoordinates(line, at(cols, xp::LONX), at(cols, xp::LATY));
-      insertQuery.bindValue(":lonx", at(cols, xp::LONX));
-      insertQuery.bindValue(":laty", at(cols, xp::LATY));
-      insertQuery.exec();
-      lineNum++;
-      numImported++;
-    }
     file.close();
   }
   else
     throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
+
+  SqlTransaction transaction(db);
+  BulkImporter importer(db, tableName, {idColumnName, "description", "altitude"});
+  importer.setSplit(' ');
+  importer.setSkipLines(3);
+
+  QString absfilepath = QFileInfo(filepath).absoluteFilePath();
+  QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+  auto convert = [&](const ImportRecord& record, ImportRow& row) -> BulkImporter::Result {
+    const QStringList& cols = record.values;
+    if(cols.size() == 1 && cols.first() == "99")
+      return BulkImporter::STOP;
+
+    row.bindValue(":type", "Waypoint");
+    row.bindValue(":ident", at(cols, xp::IDENT));
+    row.bindValue(":region", at(cols, xp::REGION));
+    row.bindValue(":tags", at(cols, xp::AIRPORT));
+    row.bindValue(":last_edit_timestamp", now);
+    row.bindValue(":import_file_path", absfilepath);
+    row.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
+    row.bindValue(":temp", 0);
+
+    validateCoordinates(record.line, at(cols, xp::LONX), at(cols, xp::LATY));
+    row.bindValue(":lonx", at(cols, xp::LONX));
+    row.bindValue(":laty", at(cols, xp::LATY));
+    return BulkImporter::INSERT;
+  };
+
+  int numImported = runImport(importer, filepath, convert);
+  if(numImported == -1)
+    // Cancelled - roll back
+    return 0;
+
   transaction.commit();
+  tableChanged();
   return numImported;
 }
 
@@ -323,51 +305,35 @@ int UserdataManager::importXplane(const QString& filepath)
 int UserdataManager::importGarmin(const QString& filepath)
 {
   SqlTransaction transaction(db);
-  QString insert = SqlUtil(db).buildInsertStatement(tableName,
-                                                    QString(), {idColumnName, "description", "altitude", "region"},
-                                                    true);
-  SqlQuery insertQuery(db);
-  insertQuery.prepare(insert);
+  BulkImporter importer(db, tableName, {idColumnName, "description", "altitude", "region"});
+  importer.setSplit(',');
 
   QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-  QDateTime now = QDateTime::currentDateTime();
-
-  int numImported = 0;
-  QFile file(filepath);
-  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
-  {
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
+  QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+  auto convert = [&](const ImportRecord& record, ImportRow& row) -> BulkImporter::Result {
+    const QStringList& cols = record.values;
+    row.bindValue(":type", "Waypoint");
+    row.bindValue(":name", at(cols, gm::NAME));
+    row.bindValue(":ident", at(cols, gm::IDENT));
+    row.bindValue(":last_edit_timestamp", now);
+    row.bindValue(":import_file_path", absfilepath);
+    row.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
+    row.bindValue(":temp", 0);
+
+    validateCoordinates(record.line, at(cols, gm::LONX), at(cols, gm::LATY));
+    row.bindValue(":lonx", at(cols, gm::LONX));
+    row.bindValue(":laty", at(cols, gm::LATY));
+    return BulkImporter::INSERT;
+  };
+
+  int numImported = runImport(importer, filepath, convert);
+  if(numImported == -1)
+    // Cancelled - roll back
+    return 0;
 
-    int lineNum = 0;
-    while(!stream.atEnd())
-    {
-      QString line = stream.readLine().simplified();
-      if(line.isEmpty())
-        continue;
-
-      QStringList cols = line.split(",");
-
-      insertQuery.bindValue(":type", "Waypoint");
-      insertQuery.bindValue(":name", at(cols, gm::NAME));
-      insertQuery.bindValue(":ident", at(cols, gm::IDENT));
-      insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
-      insertQuery.bindValue(":import_file_path", absfilepath);
-      insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
-      insertQuery.bindValue(":temp", 0);
-
-      validateCoordinates(line, at(cols, gm::LONX), at(cols, gm::LATY));
-      insertQuery.bindValue(":lonx", at(cols, gm::LONX));
-      insertQuery.bindValue(":laty", at(cols, gm::LATY));
-      insertQuery.exec();
-      lineNum++;
-      numImported++;
-    }
-    file.close();
-  }
-  else
-    throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
   transaction.commit();
+  tableChanged();
   return numImported;
 }
 
@@ -381,9 +347,6 @@ int UserdataManager::exportCsv(const QString& filepath, const QVector<int>& ids,
   QFile file(filepath);
   if(file.open((flags & APPEND ? QIODevice::Append : QIODevice::WriteOnly) | QIODevice::Text))
   {
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
-
     SqlExport sqlExport;
     sqlExport.setSeparatorChar(separator);
     sqlExport.setEscapeChar(escape);
@@ -406,9 +369,11 @@ int UserdataManager::exportCsv(const QString& filepath, const QVector<int>& ids,
                        db, ids,
                        idColumnName);
 
+    // Write rows directly into the file without building strings
+    SqlExportWriter writer(sqlExport, &file);
     if(!endsWithEol && (flags & APPEND))
       // Add needed linefeed for append
-      stream << endl;
+      writer.writeLinefeed();
 
     bool first = true;
 
@@ -416,11 +381,9 @@ int UserdataManager::exportCsv(const QString& filepath, const QVector<int>& ids,
     while(query.next())
     {
       if(first && flags & CSV_HEADER)
-      {
         // Write header
-        first = false;
-        stream << sqlExport.getResultSetHeader(query.q.record()) << endl;
-      }
+        writer.writeHeader(query.q.record());
+      first = false;
       SqlRecord record = query.q.record();
 
       float magvar = 0.f;
@@ -432,9 +395,10 @@ int UserdataManager::exportCsv(const QString& filepath, const QVector<int>& ids,
       record.setValue("Magnetic Declination", static_cast<double>(magvar));
 
       // Write row
-      stream << sqlExport.getResultSetRow(record) << endl;
-      numExported++;
+      writer.writeRow(record);
     }
+    writer.close();
+    numExported = writer.getNumRows();
 
     file.close();
   }
@@ -637,6 +601,148 @@ int UserdataManager::exportBgl(const QString& filepath, const QVector<int>& ids)
   return numExported;
 }
 
+void UserdataManager::getIdsInRect(QVector<int>& ids, const atools::geo::Rect& rect)
+{
+  buildSpatialIndex();
+  QVector<int> indexes;
+  spatialIndex.getRectIndexes(indexes, rect);
+  appendIds(ids, indexes);
+}
+
+void UserdataManager::getIdsInRadius(QVector<int>& ids, const atools::geo::Pos& pos, float radiusMeter)
+{
+  buildSpatialIndex();
+  QVector<int> indexes;
+  spatialIndex.getRadiusIndexes(indexes, pos, radiusMeter);
+  appendIds(ids, indexes);
+}
+
+void UserdataManager::getIdsInCorridor(QVector<int>& ids, const atools::geo::LineString& line, float distanceMeter)
+{
+  buildSpatialIndex();
+  QVector<int> indexes;
+  spatialIndex.getCorridorIndexes(indexes, line, distanceMeter);
+  appendIds(ids, indexes);
+}
+
+void UserdataManager::getNearestIds(QVector<int>& ids, const atools::geo::Pos& pos, int number)
+{
+  buildSpatialIndex();
+  if(spatialIndex.size() - spatialIndex.getNumRemoved() > 0 && number > 0)
+  {
+    QVector<int> indexes;
+    spatialIndex.getNearestIndexes(indexes, pos, number);
+    appendIds(ids, indexes);
+  }
+}
+
+void UserdataManager::appendIds(QVector<int>& ids, const QVector<int>& indexes) const
+{
+  ids.reserve(ids.size() + indexes.size());
+  for(int index : indexes)
+    ids.append(spatialIndex.at(index).id);
+}
+
+void UserdataManager::invalidateSpatialIndex()
+{
+  spatialIndexValid = false;
+  spatialIndex.clear();
+  spatialIndexIds.clear();
+}
+
+void UserdataManager::buildSpatialIndex()
+{
+  if(spatialIndexValid)
+    return;
+
+  spatialIndex.clear();
+  spatialIndexIds.clear();
+
+  SqlQuery query("select " + idColumnName + ", lonx, laty from " + tableName, db);
+  query.exec();
+  while(query.next())
+  {
+    Pos pos(query.valueFloat(1), query.valueFloat(2));
+    if(pos.isValid())
+    {
+      spatialIndexIds.insert(query.valueInt(0), spatialIndex.size());
+      spatialIndex.append({query.valueInt(0), pos});
+    }
+  }
+  spatialIndex.updateIndex();
+  spatialIndexValid = true;
+
+  qDebug() << Q_FUNC_INFO << "Indexed" << spatialIndex.size() << "userpoints";
+}
+
+void UserdataManager::rowsChanging(const QVector<int>& ids)
+{
+  if(!spatialIndexValid)
+    return;
+
+  if(ids.size() > MAX_SPATIAL_INDEX_UPDATE)
+    // Cheaper to rebuild later
+    invalidateSpatialIndex();
+  else
+  {
+    // Remove changed rows - these are added again in rowsChanged() if still present
+    for(int id : ids)
+    {
+      QHash<int, int>::iterator it = spatialIndexIds.find(id);
+      if(it != spatialIndexIds.end())
+      {
+        spatialIndex.remove(it.value());
+        spatialIndexIds.erase(it);
+      }
+    }
+
+    if(spatialIndex.needsCompaction())
+    {
+      // Compaction changes indexes - rebuild id mapping
+      spatialIndex.compact();
+      spatialIndexIds.clear();
+      for(int i = 0; i < spatialIndex.size(); i++)
+        spatialIndexIds.insert(spatialIndex.at(i).id, i);
+    }
+  }
+}
+
+void UserdataManager::rowsChanged(const QVector<int>& ids)
+{
+  if(!spatialIndexValid)
+    return;
+
+  if(ids.size() > MAX_SPATIAL_INDEX_UPDATE)
+  {
+    invalidateSpatialIndex();
+    return;
+  }
+
+  // Called in the transaction of the change - read new positions of inserted or updated rows
+  SqlQuery query = db->cachedQuery("select lonx, laty from " + tableName + " where " + idColumnName + " = ?");
+  for(int id : ids)
+  {
+    if(spatialIndexIds.contains(id))
+      // Already present if caller did not announce change - remove old position
+      rowsChanging({id});
+
+    query.bindValue(0, id);
+    query.exec();
+    if(query.next())
+    {
+      Pos pos(query.valueFloat(0), query.valueFloat(1));
+      if(pos.isValid())
+        spatialIndexIds.insert(id, spatialIndex.insert({id, pos}));
+    }
+    query.finish();
+  }
+}
+
+void UserdataManager::tableChanged()
+{
+  invalidateSpatialIndex();
+}
+
 } // namespace userdata
 } // namespace fs
 } // namespace atools
@@ -19,12 +19,20 @@
 #define ATOOLS_FS_USERDATAMANAGER_H
 
 #include "fs/userdata/datamanagerbase.h"
+#include "geo/spatialindex.h"
+#include "geo/pos.h"
+
+#include <QHash>
 
 namespace atools {
 
 namespace sql {
 class SqlDatabase;
 }
+namespace geo {
+class LineString;
+class Rect;
+}
 namespace fs {
 namespace common {
 class MagDecReader;
@@ -48,6 +56,9 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(atools::fs::userdata::Flags);
 /*
  * Contains functionality around the userdata database which keeps user defined waypoints, bookmarks and others.
  * Uses SqlRecord as a base structure to exchange data.
+ *
+ * Keeps an in-memory spatial index of all userpoint positions for map and nearest queries. The index is built
+ * on first query and updated by all changes done through this manager. Bulk changes cause a rebuild on next query.
  */
 class UserdataManager :
   public DataManagerBase
@@ -88,8 +99,53 @@ public:
     magDec = reader;
   }
 
+  /* Spatial queries using the in-memory index. Ids of matching userpoints are appended to ids.
+   * Rectangle and corridor results are sorted by index order. Radius and nearest use the inaccurate
+   * distance of SpatialIndex and should be checked for exact distance if needed. */
+  void getIdsInRect(QVector<int>& ids, const atools::geo::Rect& rect);
+  void getIdsInRadius(QVector<int>& ids, const atools::geo::Pos& pos, float radiusMeter);
+  void getIdsInCorridor(QVector<int>& ids, const atools::geo::LineString& line, float distanceMeter);
+
+  /* Get the number nearest userpoints sorted by distance */
+  void getNearestIds(QVector<int>& ids, const atools::geo::Pos& pos, int number);
+
+  /* Rebuild index on next query. Call this after changing the table outside of this manager, e.g. after a
+   * job of the writer thread is finished or after rolling back a transaction. */
+  void invalidateSpatialIndex();
+
+protected:
+  /* Keep spatial index in sync */
+  virtual void rowsChanging(const QVector<int>& ids) override;
+  virtual void rowsChanged(const QVector<int>& ids) override;
+  virtual void tableChanged() override;
+
 private:
+  /* Point for spatial index */
+  struct IndexPoint
+  {
+    int id;
+    atools::geo::Pos position;
+
+    const atools::geo::Pos& getPosition() const
+    {
+      return position;
+    }
+
+  };
+
+  /* Build index if not valid */
+  void buildSpatialIndex();
+
+  /* Translate indexes of the spatial index to userpoint ids */
+  void appendIds(QVector<int>& ids, const QVector<int>& indexes) const;
+
   atools::fs::common::MagDecReader *magDec;
+
+  atools::geo::SpatialIndex<IndexPoint> spatialIndex;
+
+  /* Userpoint id to index in spatialIndex */
+  QHash<int, int> spatialIndexIds;
+  bool spatialIndexValid = false;
 };
 
 } // namespace userdata
@@ -22,6 +22,7 @@
 #include "exception.h"
 
 #include <cmath>
+#include <cstring>
 #include <QRegularExpression>
 
 using atools::geo::Pos;
@@ -32,49 +33,117 @@ namespace util {
 
 // N48194W123096
 const static QString COORDS_FLIGHTPLAN_FORMAT_GFP("%1%2%3%4%5%6");
-const static QRegularExpression LONG_FORMAT_REGEXP_GFP("^([NS])([0-9]{2})([0-9]{3})"
-                                                       "([EW])([0-9]{3})([0-9]{3})$");
-
-// 46N078W
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG("^([0-9]{2})([NS])"
-                                                       "([0-9]{3})([EW])$");
 
 // 4510N06810W
 const static QString COORDS_FLIGHTPLAN_FORMAT_DEG_MIN("%1%2%3%4%5%6");
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG_MIN("^([0-9]{2})([0-9]{2})([NS])"
-                                                           "([0-9]{3})([0-9]{2})([EW])$");
 
 // 481200N0112842E
 const static QString COORDS_FLIGHTPLAN_FORMAT_DEG_MIN_SEC("%1%2%3%4%5%6%7%8");
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG_MIN_SEC("^([0-9]{2})([0-9]{2})([0-9]{2})([NS])"
-                                                               "([0-9]{3})([0-9]{2})([0-9]{2})([EW])$");
 
-// Pattern allows trailing garbage
-// 50:40:42 N 003:13:30 E
-// 31:30:00 N 086:44:59 W
-static QRegularExpression MATCH_COORD_OPENAIR_MIN_SEC("^([\\d]+):([\\d]+):([\\d\\.]+)\\s*([NS])\\s*"
-                                                      "([\\d]+):([\\d]+):([\\d\\.]+)\\s*([EW])");
+// N6400 W07000 or N6400/W07000
+const static QString COORDS_FLIGHTPLAN_FORMAT_PAIR("%1%2/%3%4");
 
-// Pattern allows trailing garbage
-// 39:06.2 N 121:35.5 W
-static QRegularExpression MATCH_COORD_OPENAIR_MIN("^([\\d]+):([\\d\\.]+)\\s*([NS])\\s*"
-                                                  "([\\d]+):([\\d\\.]+)\\s*([EW])");
+/* Patterns for the fixed width formats which are parsed without regular expressions.
+ * '9' is a digit, 'n' is N or S, 'e' is E or W, '/' is space or slash and all others are literal characters. */
+const static char *PATTERN_GFP = "n99999e999999"; // N48194W123096
+const static char *PATTERN_DEG = "99n999e"; // 46N078W
+const static char *PATTERN_DEG_MIN = "9999n99999e"; // 4510N06810W
+const static char *PATTERN_DEG_MIN_SEC = "999999n9999999e"; // 481200N0112842E
+const static char *PATTERN_NAT = "9999N"; // 5020N
+const static char *PATTERN_PAIR = "n9999/e99999"; // N6400 W07000 or N6400/W07000
+const static char *PATTERN_PAIR2 = "9999n/99999e"; // 6400N 07000W or 6400N/07000W
+
+/* Longest pattern above */
+const static int MAX_PATTERN_SIZE = 15;
+
+/* Fixed width coordinate string in upper case and simplified without allocating. */
+class FixedCoord
+{
+public:
+  /* Copy like str.simplified().toUpper(). Strings which cannot match any pattern are left empty. */
+  explicit FixedCoord(const QString& str)
+  {
+    bool space = false;
+    for(QChar c : str)
+    {
+      if(c.isSpace())
+      {
+        // Collapse and trim whitespace
+        space = size > 0;
+        continue;
+      }
 
-// 5020N
-const static QRegularExpression LONG_FORMAT_REGEXP_NAT("^([0-9]{2})"
-                                                       "([0-9]{2})N$");
+      if(size + space >= MAX_PATTERN_SIZE || c.unicode() > 127)
+      {
+        // Too long or non ASCII
+        size = 0;
+        return;
+      }
 
-// N6400 W07000 or N6400/W07000
-const static QString COORDS_FLIGHTPLAN_FORMAT_PAIR("%1%2/%3%4");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR("^([NS])([0-9]{2})([0-9]{2})[ /]"
-                                                        "([EW])([0-9]{3})([0-9]{2})$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR2("^([0-9]{2})([0-9]{2})([NS])[ /]"
-                                                         "([0-9]{3})([0-9]{2})([EW])$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR_LAT("^([NS])([0-9]{2})([0-9]{2})$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR_LON("^([EW])([0-9]{3})([0-9]{2})$");
+      if(space)
+        buf[size++] = ' ';
+      space = false;
+      buf[size++] = atools::latin1ToUpper(c.toLatin1());
+    }
+  }
+
+  /* true if the string matches all characters of the pattern */
+  bool matches(const char *pattern) const
+  {
+    if(static_cast<int>(std::strlen(pattern)) != size)
+      return false;
 
-atools::geo::Pos degMinSecFormatFromCapture(const QStringList& captured);
-atools::geo::Pos degMinFormatFromCapture(const QStringList& captured);
+    for(int i = 0; i < size; i++)
+    {
+      char c = buf[i];
+      switch(pattern[i])
+      {
+        case '9':
+          if(!atools::isAsciiDigit(c))
+            return false;
+          break;
+
+        case 'n':
+          if(c != 'N' && c != 'S')
+            return false;
+          break;
+
+        case 'e':
+          if(c != 'E' && c != 'W')
+            return false;
+          break;
+
+        case '/':
+          if(c != ' ' && c != '/')
+            return false;
+          break;
+
+        default:
+          if(c != pattern[i])
+            return false;
+      }
+    }
+    return true;
+  }
+
+  /* Integer value of the digits at position. Digits have to be checked by matches() before. */
+  int number(int pos, int len) const
+  {
+    int value = 0;
+    for(int i = pos; i < pos + len; i++)
+      value = value * 10 + (buf[i] - '0');
+    return value;
+  }
+
+  char at(int pos) const
+  {
+    return buf[pos];
+  }
+
+private:
+  char buf[MAX_PATTERN_SIZE];
+  int size = 0;
+};
 
 // N48194W123096
 // Examples:
@@ -130,31 +199,20 @@ QString toDegMinSecFormat(const atools::geo::Pos& pos)
 // Garmin format N48194W123096
 atools::geo::Pos fromGfpFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_GFP.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
+  FixedCoord coord(str);
+  if(coord.matches(PATTERN_GFP))
   {
-    QStringList captured = match.capturedTexts();
+    int latYDeg = coord.number(1, 2);
+    float latYMin = coord.number(3, 3) / 10.f;
+    float latYSec = (latYMin - std::floor(latYMin)) * 60.f;
 
-    if(captured.size() == 7)
-    {
-      bool latOk, lonOk, latMinOk, lonMinOk;
-      QString ns = captured.at(1);
-      int latYDeg = captured.at(2).toInt(&latOk);
-      float latYMin = captured.at(3).toFloat(&latMinOk) / 10.f;
-      float latYSec = (latYMin - std::floor(latYMin)) * 60.f;
-
-      QString ew = captured.at(4);
-      int lonXDeg = captured.at(5).toInt(&lonOk);
-      float lonXMin = captured.at(6).toFloat(&lonMinOk) / 10.f;
-      float lonXSec = (lonXMin - std::floor(lonXMin)) * 60.f;
-
-      if(latOk && lonOk && latMinOk && lonMinOk &&
-         -90 <= latYDeg && latYDeg <= 90 &&
-         -180 <= lonXDeg && lonXDeg <= 180)
-        return atools::geo::Pos(lonXDeg, static_cast<int>(lonXMin), lonXSec, ew == "W",
-                                latYDeg, static_cast<int>(latYMin), latYSec, ns == "S");
-    }
+    int lonXDeg = coord.number(7, 3);
+    float lonXMin = coord.number(10, 3) / 10.f;
+    float lonXSec = (lonXMin - std::floor(lonXMin)) * 60.f;
+
+    if(latYDeg <= 90 && lonXDeg <= 180)
+      return atools::geo::Pos(lonXDeg, static_cast<int>(lonXMin), lonXSec, coord.at(6) == 'W',
+                              latYDeg, static_cast<int>(latYMin), latYSec, coord.at(0) == 'S');
   }
   return atools::geo::EMPTY_POS;
 }
@@ -162,27 +220,15 @@ atools::geo::Pos fromGfpFormat(const QString& str)
 // Degrees only 46N078W
 atools::geo::Pos fromDegFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
+  FixedCoord coord(str);
+  if(coord.matches(PATTERN_DEG))
   {
-    QStringList captured = match.capturedTexts();
+    int latYDeg = coord.number(0, 2);
+    int lonXDeg = coord.number(3, 3);
 
-    if(captured.size() == 5)
-    {
-      bool latOk, lonOk;
-      int latYDeg = captured.at(1).toInt(&latOk);
-      QString ns = captured.at(2);
-
-      int lonXDeg = captured.at(3).toInt(&lonOk);
-      QString ew = captured.at(4);
-
-      if(latOk && lonOk &&
-         -90.f <= latYDeg && latYDeg <= 90.f &&
-         -180.f <= lonXDeg && lonXDeg <= 180.f)
-        return atools::geo::Pos(lonXDeg, 0, 0.f, ew == "W",
-                                latYDeg, 0, 0.f, ns == "S");
-    }
+    if(latYDeg <= 90 && lonXDeg <= 180)
+      return atools::geo::Pos(lonXDeg, 0, 0.f, coord.at(6) == 'W',
+                              latYDeg, 0, 0.f, coord.at(2) == 'S');
   }
   return atools::geo::EMPTY_POS;
 }
@@ -190,29 +236,18 @@ atools::geo::Pos fromDegFormat(const QString& str)
 // Degrees and minutes 4510N06810W
 atools::geo::Pos fromDegMinFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG_MIN.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
+  FixedCoord coord(str);
+  if(coord.matches(PATTERN_DEG_MIN))
   {
-    QStringList captured = match.capturedTexts();
+    int latYDeg = coord.number(0, 2);
+    int latYMin = coord.number(2, 2);
 
-    if(captured.size() == 7)
-    {
-      bool latOk, lonOk, latMinOk, lonMinOk;
-      int latYDeg = captured.at(1).toInt(&latOk);
-      int latYMin = captured.at(2).toInt(&latMinOk);
-      QString ns = captured.at(3);
-
-      int lonXDeg = captured.at(4).toInt(&lonOk);
-      int lonXMin = captured.at(5).toInt(&lonMinOk);
-      QString ew = captured.at(6);
-
-      if(latOk && lonOk && latMinOk && lonMinOk &&
-         -90 <= latYDeg && latYDeg <= 90 &&
-         -180 <= lonXDeg && lonXDeg <= 180)
-        return atools::geo::Pos(lonXDeg, lonXMin, 0.f, ew == "W",
-                                latYDeg, latYMin, 0.f, ns == "S");
-    }
+    int lonXDeg = coord.number(5, 3);
+    int lonXMin = coord.number(8, 2);
+
+    if(latYDeg <= 90 && lonXDeg <= 180)
+      return atools::geo::Pos(lonXDeg, lonXMin, 0.f, coord.at(10) == 'W',
+                              latYDeg, latYMin, 0.f, coord.at(4) == 'S');
   }
 
   return atools::geo::EMPTY_POS;
@@ -221,10 +256,21 @@ atools::geo::Pos fromDegMinFormat(const QString& str)
 // Degrees, minutes and seconds 481200N0112842E
 atools::geo::Pos fromDegMinSecFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG_MIN_SEC.match(str.simplified().toUpper());
+  FixedCoord coord(str);
+  if(coord.matches(PATTERN_DEG_MIN_SEC))
+  {
+    int latYDeg = coord.number(0, 2);
+    int latYMin = coord.number(2, 2);
+    float latYSec = coord.number(4, 2);
 
-  if(match.hasMatch())
-    return degMinSecFormatFromCapture(match.capturedTexts());
+    int lonXDeg = coord.number(7, 3);
+    int lonXMin = coord.number(10, 2);
+    float lonXSec = coord.number(12, 2);
+
+    if(latYDeg <= 90 && lonXDeg <= 180)
+      return atools::geo::Pos(lonXDeg, lonXMin, lonXSec, coord.at(14) == 'W',
+                              latYDeg, latYMin, latYSec, coord.at(6) == 'S');
+  }
 
   return atools::geo::EMPTY_POS;
 }
@@ -232,49 +278,34 @@ atools::geo::Pos fromDegMinSecFormat(const QString& str)
 // Degrees and minutes in pair N6400 W07000 or N6400/W07000
 atools::geo::Pos fromDegMinPairFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_PAIR.match(str.simplified().toUpper());
-
-  bool latOk = false, lonOk = false, latMinOk = false, lonMinOk = false;
-  QString ns, ew;
+  FixedCoord coord(str);
   int latYDeg = 0, latYMin = 0, lonXDeg = 0, lonXMin = 0;
+  char ns, ew;
 
-  if(match.hasMatch())
+  if(coord.matches(PATTERN_PAIR))
   {
-    QStringList captured = match.capturedTexts();
-    if(captured.size() == 7)
-    {
-      ns = captured.at(1);
-      latYDeg = captured.at(2).toInt(&latOk);
-      latYMin = captured.at(3).toInt(&latMinOk);
-      ew = captured.at(4);
-      lonXDeg = captured.at(5).toInt(&lonOk);
-      lonXMin = captured.at(6).toInt(&lonMinOk);
-    }
+    ns = coord.at(0);
+    latYDeg = coord.number(1, 2);
+    latYMin = coord.number(3, 2);
+    ew = coord.at(6);
+    lonXDeg = coord.number(7, 3);
+    lonXMin = coord.number(10, 2);
   }
-  else
+  else if(coord.matches(PATTERN_PAIR2))
   {
-    QRegularExpressionMatch match2 = LONG_FORMAT_REGEXP_PAIR2.match(str.simplified().toUpper());
-
-    if(match2.hasMatch())
-    {
-      QStringList captured = match2.capturedTexts();
-      if(captured.size() == 7)
-      {
-        latYDeg = captured.at(1).toInt(&latOk);
-        latYMin = captured.at(2).toInt(&latMinOk);
-        ns = captured.at(3);
-        lonXDeg = captured.at(4).toInt(&lonOk);
-        lonXMin = captured.at(5).toInt(&lonMinOk);
-        ew = captured.at(6);
-      }
-    }
+    latYDeg = coord.number(0, 2);
+    latYMin = coord.number(2, 2);
+    ns = coord.at(4);
+    lonXDeg = coord.number(6, 3);
+    lonXMin = coord.number(9, 2);
+    ew = coord.at(11);
   }
+  else
+    return atools::geo::EMPTY_POS;
 
-  if(latOk && lonOk && latMinOk && lonMinOk &&
-     -90 <= latYDeg && latYDeg <= 90 &&
-     -180 <= lonXDeg && lonXDeg <= 180)
-    return atools::geo::Pos(lonXDeg, lonXMin, 0.f, ew == "W",
-                            latYDeg, latYMin, 0.f, ns == "S");
+  if(latYDeg <= 90 && lonXDeg <= 180)
+    return atools::geo::Pos(lonXDeg, lonXMin, 0.f, ew == 'W',
+                            latYDeg, latYMin, 0.f, ns == 'S');
   else
     return atools::geo::EMPTY_POS;
 }
@@ -283,23 +314,14 @@ atools::geo::Pos fromDegMinPairFormat(const QString& str)
 // first two figures are the latitude north and the second two figures are the longitude west
 atools::geo::Pos fromNatFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_NAT.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
+  FixedCoord coord(str);
+  if(coord.matches(PATTERN_NAT))
   {
-    QStringList captured = match.capturedTexts();
+    int latYDeg = coord.number(0, 2);
+    int lonXDeg = coord.number(2, 2);
 
-    if(captured.size() == 3)
-    {
-      bool latOk, lonOk;
-      int latYDeg = captured.at(1).toInt(&latOk);
-      int lonXDeg = captured.at(2).toInt(&lonOk);
-
-      if(latOk && lonOk &&
-         0 <= latYDeg && latYDeg <= 90 &&
-         0 <= lonXDeg && lonXDeg <= 180)
-        return atools::geo::Pos(lonXDeg, 0, 0.f, true, latYDeg, 0, 0.f, false);
-    }
+    if(latYDeg <= 90 && lonXDeg <= 180)
+      return atools::geo::Pos(lonXDeg, 0, 0.f, true, latYDeg, 0, 0.f, false);
   }
   return atools::geo::EMPTY_POS;
 }
@@ -328,67 +350,80 @@ atools::geo::Pos fromAnyWaypointFormat(const QString& str)
   return atools::geo::EMPTY_POS;
 }
 
-geo::Pos fromOpenAirFormat(const QString& coordStr)
+/* Read one coordinate like "50:40:42 N" or "39:06.2 N" starting at index without allocations.
+ * Only the last of the colon separated fields can have decimals. Index is set after the hemisphere character. */
+static bool readOpenAirCoord(const QStringRef& str, int& index, char positive, char negative, float maxDegrees,
+                             int& numFields, float& value)
 {
-  QRegularExpressionMatch match = MATCH_COORD_OPENAIR_MIN_SEC.match(coordStr.toUpper());
-  if(match.hasMatch())
-    return degMinSecFormatFromCapture(match.capturedTexts());
-  else
+  float fields[3];
+  bool decimal = false;
+  numFields = 0;
+  while(numFields < 3 && !decimal)
   {
-    match = MATCH_COORD_OPENAIR_MIN.match(coordStr);
-    if(match.hasMatch())
-      return degMinFormatFromCapture(match.capturedTexts());
+    int start = index;
+    while(index < str.size() && (str.at(index).isDigit() || str.at(index) == '.'))
+    {
+      if(str.at(index) == '.')
+        decimal = true;
+      index++;
+    }
+
+    bool ok;
+    fields[numFields++] = str.mid(start, index - start).toFloat(&ok);
+    if(!ok)
+      return false;
+
+    if(index < str.size() && str.at(index) == ':')
+      index++;
+    else
+      break;
   }
 
-  return atools::geo::EMPTY_POS;
+  // Colon after a decimal field or missing minutes
+  if(numFields < 2 || str.at(index - 1) == ':')
+    return false;
+
+  // Allow spaces between value and hemisphere
+  while(index < str.size() && str.at(index).isSpace())
+    index++;
+
+  if(index >= str.size() || fields[0] > maxDegrees)
+    return false;
+
+  char hemisphere = str.at(index++).toUpper().toLatin1();
+  if(hemisphere != positive && hemisphere != negative)
+    return false;
+
+  value = fields[0] + fields[1] / 60.f + (numFields == 3 ? fields[2] / 3600.f : 0.f);
+  if(hemisphere == negative)
+    value = -value;
+  return true;
 }
 
-atools::geo::Pos degMinFormatFromCapture(const QStringList& captured)
+geo::Pos fromOpenAirFormat(const QString& coordStr)
 {
-  if(captured.size() == 7)
-  {
-    bool latOk, lonOk, latMinOk, lonMinOk;
-    int latYDeg = captured.at(1).toInt(&latOk);
-    float latYMin = captured.at(2).toFloat(&latMinOk);
-    QString ns = captured.at(3);
-
-    int lonXDeg = captured.at(4).toInt(&lonOk);
-    float lonXMin = captured.at(5).toFloat(&lonMinOk);
-    QString ew = captured.at(6);
-
-    if(latOk && lonOk && latMinOk && lonMinOk &&
-       -90 <= latYDeg && latYDeg <= 90 &&
-       -180 <= lonXDeg && lonXDeg <= 180)
-      return atools::geo::Pos((lonXDeg + lonXMin / 60.f) * (ew == "W" ? -1.f : 1.f),
-                              (latYDeg + latYMin / 60.f) * (ns == "S" ? -1.f : 1.f));
-  }
-  return atools::geo::EMPTY_POS;
+  return fromOpenAirFormat(QStringRef(&coordStr));
 }
 
-atools::geo::Pos degMinSecFormatFromCapture(const QStringList& captured)
+geo::Pos fromOpenAirFormat(const QStringRef& coordStr)
 {
-  if(captured.size() == 9)
+  // Trailing garbage is allowed
+  int index = 0, numLatFields, numLonFields;
+  float latY, lonX;
+  if(readOpenAirCoord(coordStr, index, 'N', 'S', 90, numLatFields, latY))
   {
-    bool latOk, lonOk, latMinOk, lonMinOk, latSecOk, lonSecOk;
-    int latYDeg = captured.at(1).toInt(&latOk);
-    int latYMin = captured.at(2).toInt(&latMinOk);
-    float latYSec = captured.at(3).toFloat(&latSecOk);
-    QString ns = captured.at(4);
-
-    int lonXDeg = captured.at(5).toInt(&lonOk);
-    int lonXMin = captured.at(6).toInt(&lonMinOk);
-    float lonXSec = captured.at(7).toFloat(&lonSecOk);
-    QString ew = captured.at(8);
-
-    if(latOk && lonOk && latMinOk && lonMinOk && latSecOk && lonSecOk &&
-       -90 <= latYDeg && latYDeg <= 90 &&
-       -180 <= lonXDeg && lonXDeg <= 180)
-      return atools::geo::Pos(lonXDeg, lonXMin, lonXSec, ew == "W",
-                              latYDeg, latYMin, latYSec, ns == "S");
+    while(index < coordStr.size() && coordStr.at(index).isSpace())
+      index++;
+
+    // Both have to use the same format - either degrees, minutes and seconds or degrees and decimal minutes
+    if(readOpenAirCoord(coordStr, index, 'E', 'W', 180, numLonFields, lonX) && numLatFields == numLonFields)
+      return atools::geo::Pos(lonX, latY);
   }
+
   return atools::geo::EMPTY_POS;
 }
 
+
 QRegularExpressionMatch safeMatch(const QRegularExpression& regexp, const QString& str)
 {
   if(!regexp.isValid())
@@ -66,8 +66,10 @@ atools::geo::Pos fromNatFormat(const QString& str);
 
 /* OpenAir airspace format
 *  50:40:42 N 003:13:30 E
-*  39:06.2 N 121:35.5 E */
+*  39:06.2 N 121:35.5 E
+*  Parsed without regular expressions and allocations. Trailing garbage is ignored. */
 atools::geo::Pos fromOpenAirFormat(const QString& coordStr);
+atools::geo::Pos fromOpenAirFormat(const QStringRef& coordStr);
 
 } // namespace util
 } // namespace fs
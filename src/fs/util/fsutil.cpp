@@ -26,60 +26,21 @@ namespace atools {
 namespace fs {
 namespace util {
 
-// Closed airport by name
-static const QRegularExpression REGEXP_CLOSED(QLatin1Literal("(\\[X\\]|\\bCLSD\\b|\\bCLOSED\\b)"));
-const static QRegularExpression REGEXP_DIGIT("\\d");
-const static QRegularExpression REGEXP_WHITESPACE("\\s");
-
-/* ICAO speed and altitude matches */
-const static QRegularExpression REGEXP_SPDALT("^([NMK])(\\d{2,4})(([FSAM])(\\d{2,4}))?$");
-const static QRegularExpression REGEXP_SPDALT_ALL("^([NMK])(\\d{3,4})([FSAM])(\\d{3,4})$");
-
-// Look for military designator words
-static const QVector<QRegularExpression> REGEXP_MIL({
+// Look for military designator words. Matched as whole words ignoring case.
+static const QVector<QLatin1String> MIL_WORDS({
         // "AAF", "AB", "AF", "AFB", "AFS", "AHP", "ANGB", "ARB", "GTS", "LRRS", "PMRF", "MCAF", "MCALF", "MCAS", "NAF",
         // "NALF", "NAS", "NWS", "NAWS", "NOLF", "NS", "NSB", "NSY", "NSWC", "NSF", "RAF", "RNAS", "AFLD", "AAC",
-
-        QRegularExpression(QLatin1Literal("(\\[M\\]|\\[MIL\\])")), // X-Plane special
-        QRegularExpression(QLatin1Literal("\\bAAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bAB\\b")),
-        QRegularExpression(QLatin1Literal("\\bAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bAFB\\b")),
-        QRegularExpression(QLatin1Literal("\\bAFS\\b")),
-        QRegularExpression(QLatin1Literal("\\bAHP\\b")),
-        QRegularExpression(QLatin1Literal("\\bAIR BASE\\b")),
-        QRegularExpression(QLatin1Literal("\\bAIRBASE\\b")),
-        QRegularExpression(QLatin1Literal("\\bAIR FORCE\\b")),
-        QRegularExpression(QLatin1Literal("\\bANGB\\b")),
-        QRegularExpression(QLatin1Literal("\\bARB\\b")),
-        QRegularExpression(QLatin1Literal("\\bARMY\\b")),
-        // QRegularExpression(QLatin1Literal("\\bGTS\\b")), not an airbase
-        QRegularExpression(QLatin1Literal("\\bLRRS\\b")),
-        QRegularExpression(QLatin1Literal("\\bPMRF\\b")),
-        QRegularExpression(QLatin1Literal("\\bMCAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bMCALF\\b")),
-        QRegularExpression(QLatin1Literal("\\bMCAS\\b")),
-        QRegularExpression(QLatin1Literal("\\bMIL\\b")),
-        QRegularExpression(QLatin1Literal("\\bMILITARY\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bNALF\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAS\\b")),
-        QRegularExpression(QLatin1Literal("\\bNWS\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAVAL\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAVY\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAWS\\b")),
-        QRegularExpression(QLatin1Literal("\\bNOLF\\b")),
-        QRegularExpression(QLatin1Literal("\\bNS\\b")),
-        QRegularExpression(QLatin1Literal("\\bNSF\\b")),
-        QRegularExpression(QLatin1Literal("\\bNSB\\b")),
-        QRegularExpression(QLatin1Literal("\\bNSY\\b")),
-        QRegularExpression(QLatin1Literal("\\bRAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bNSWC\\b")),
-        QRegularExpression(QLatin1Literal("\\bRNAS\\b")),
-        QRegularExpression(QLatin1Literal("\\bROYAL MARINES\\b")),
-        QRegularExpression(QLatin1Literal("\\bAFLD\\b")),
-        QRegularExpression(QLatin1Literal("\\bAAC\\b"))
-
+        // "GTS" is not an airbase
+        QLatin1String("AAF"), QLatin1String("AB"), QLatin1String("AF"), QLatin1String("AFB"),
+        QLatin1String("AFS"), QLatin1String("AHP"), QLatin1String("AIR BASE"), QLatin1String("AIRBASE"),
+        QLatin1String("AIR FORCE"), QLatin1String("ANGB"), QLatin1String("ARB"), QLatin1String("ARMY"),
+        QLatin1String("LRRS"), QLatin1String("PMRF"), QLatin1String("MCAF"), QLatin1String("MCALF"),
+        QLatin1String("MCAS"), QLatin1String("MIL"), QLatin1String("MILITARY"), QLatin1String("NAF"),
+        QLatin1String("NALF"), QLatin1String("NAS"), QLatin1String("NWS"), QLatin1String("NAVAL"),
+        QLatin1String("NAVY"), QLatin1String("NAWS"), QLatin1String("NOLF"), QLatin1String("NS"),
+        QLatin1String("NSF"), QLatin1String("NSB"), QLatin1String("NSY"), QLatin1String("RAF"),
+        QLatin1String("NSWC"), QLatin1String("RNAS"), QLatin1String("ROYAL MARINES"), QLatin1String("AFLD"),
+        QLatin1String("AAC")
       });
 
 static const QHash<QString, QString> NAME_CODE_MAP(
@@ -386,17 +347,38 @@ int calculateAirportRatingXp(bool isAddon, bool is3D, bool hasTower, int numTaxi
   return rating;
 }
 
+/* Same as "\\bword\\b" in a case insensitive regular expression but does not copy or convert the string */
+static bool containsWord(const QString& str, QLatin1String word)
+{
+  for(int index = str.indexOf(word, 0, Qt::CaseInsensitive); index != -1;
+      index = str.indexOf(word, index + 1, Qt::CaseInsensitive))
+  {
+    // Word characters are letters, digits and underscore in ASCII
+    char before = atools::latin1CharAt(str, index - 1), after = atools::latin1CharAt(str, index + word.size());
+    if(!atools::isAsciiLetterOrNumber(before) && before != '_' && !atools::isAsciiLetterOrNumber(after) &&
+       after != '_')
+      return true;
+  }
+  return false;
+}
+
 bool isNameClosed(const QString& airportName)
 {
-  return REGEXP_CLOSED.match(airportName.toUpper()).hasMatch();
+  return airportName.contains(QLatin1String("[X]"), Qt::CaseInsensitive) ||
+         containsWord(airportName, QLatin1String("CLSD")) || containsWord(airportName, QLatin1String("CLOSED"));
 }
 
 bool isNameMilitary(const QString& airportName)
 {
+  // X-Plane special
+  if(airportName.contains(QLatin1String("[M]"), Qt::CaseInsensitive) ||
+     airportName.contains(QLatin1String("[MIL]"), Qt::CaseInsensitive))
+    return true;
+
   // Check if airport is military
-  for(const QRegularExpression& s : REGEXP_MIL)
+  for(QLatin1String word : MIL_WORDS)
   {
-    if(s.match(airportName.toUpper()).hasMatch())
+    if(containsWord(airportName, word))
       return true;
   }
   return false;
@@ -404,7 +386,14 @@ bool isNameMilitary(const QString& airportName)
 
 QString capNavString(const QString& str)
 {
-  if(str.contains(REGEXP_DIGIT) && !str.contains(REGEXP_WHITESPACE))
+  bool digit = false, space = false;
+  for(QChar c : str)
+  {
+    digit |= atools::isAsciiDigit(c.toLatin1());
+    space |= atools::isAsciiSpace(c.toLatin1());
+  }
+
+  if(digit && !space)
     // Do not capitalize words that contains numbers but not spaces (airspace names)
     return str;
 
@@ -451,39 +440,114 @@ QString adjustFsxUserWpName(QString name, int length)
   return name;
 }
 
+/* Convert to upper case, remove all characters except A-Z and 0-9 and limit length */
+static QString cleanIdent(const QString& ident, int length)
+{
+  if(atools::isAscii(ident))
+  {
+    // Fast path without temporary strings
+    QString retval;
+    retval.reserve(std::min(ident.size(), length));
+    for(QChar c : ident)
+    {
+      if(retval.size() >= length)
+        break;
+
+      char upper = atools::latin1ToUpper(c.toLatin1());
+      if(atools::isAsciiUpper(upper) || atools::isAsciiDigit(upper))
+        retval.append(QChar(upper));
+    }
+    return retval;
+  }
+  else
+  {
+    static const QRegularExpression IDENT_REGEXP("[^A-Z0-9]");
+    return ident.toUpper().replace(IDENT_REGEXP, QString()).left(length);
+  }
+}
+
 QString adjustIdent(QString ident, int length, int id)
 {
-  static const QRegularExpression IDENT_REGEXP("[^A-Z0-9]");
-  ident = ident.toUpper().replace(IDENT_REGEXP, "").left(length);
+  ident = cleanIdent(ident, length);
   if(ident.isEmpty() && id != -1)
-    ident = QString("N%1").arg(id, 4, 36, QChar('0')).left(length);
-  return ident.toUpper();
+    ident = QString("N%1").arg(id, 4, 36, QChar('0')).left(length).toUpper();
+  return ident;
 }
 
 QString adjustRegion(QString region)
 {
-  static const QRegularExpression IDENT_REGEXP("[^A-Z0-9]");
-  region = region.toUpper().replace(IDENT_REGEXP, "").left(2);
+  region = cleanIdent(region, 2);
   if(region.length() != 2)
     region = "ZZ";
-  return region.toUpper();
+  return region;
+}
+
+/* true if all characters are A-Z or 0-9 */
+static bool isUpperAlnum(const QString& str)
+{
+  for(QChar c : str)
+  {
+    char ch = c.toLatin1();
+    if(!atools::isAsciiUpper(ch) && !atools::isAsciiDigit(ch))
+      return false;
+  }
+  return true;
 }
 
 bool isValidIdent(const QString& ident)
 {
-  static const QRegularExpression IDENT_REGEXP("^[A-Z0-9]{1,5}$");
-  return IDENT_REGEXP.match(ident).hasMatch();
+  return ident.size() >= 1 && ident.size() <= 5 && isUpperAlnum(ident);
 }
 
 bool isValidRegion(const QString& region)
 {
-  static const QRegularExpression REGION_REGEXP("^[A-Z0-9]$");
-  return REGION_REGEXP.match(region).hasMatch();
+  return region.size() == 1 && isUpperAlnum(region);
+}
+
+/* Number of ASCII digits starting at index */
+static int numDigits(const QString& str, int index)
+{
+  int num = 0;
+  while(atools::isAsciiDigit(atools::latin1CharAt(str, index + num)))
+    num++;
+  return num;
+}
+
+/* Parse without regular expression like "^([NMK])(\\d{x,4})(([FSAM])(\\d{x,4}))?$" where x is minDigits.
+ * Alt unit is 0 if altitude is missing and altRequired is false. */
+static bool parseSpeedAndAltitude(const QString& item, int minDigits, bool altRequired,
+                                  char& speedUnit, float& speed, char& altUnit, float& alt)
+{
+  speedUnit = atools::latin1CharAt(item, 0);
+  if(speedUnit != 'N' && speedUnit != 'M' && speedUnit != 'K')
+    return false;
+
+  int spdDigits = numDigits(item, 1);
+  if(spdDigits < minDigits || spdDigits > 4)
+    return false;
+  speed = item.midRef(1, spdDigits).toFloat();
+
+  int index = 1 + spdDigits;
+  altUnit = '\0';
+  if(index == item.size())
+    return !altRequired;
+
+  altUnit = item.at(index).toLatin1();
+  if(altUnit != 'F' && altUnit != 'S' && altUnit != 'A' && altUnit != 'M')
+    return false;
+
+  int altDigits = numDigits(item, index + 1);
+  if(altDigits < minDigits || altDigits > 4 || index + 1 + altDigits != item.size())
+    return false;
+  alt = item.midRef(index + 1, altDigits).toFloat();
+  return true;
 }
 
 bool speedAndAltitudeMatch(const QString& item)
 {
-  return REGEXP_SPDALT_ALL.match(item).hasMatch();
+  char speedUnit, altUnit;
+  float speed, alt;
+  return parseSpeedAndAltitude(item, 3, true, speedUnit, speed, altUnit, alt);
 }
 
 bool extractSpeedAndAltitude(const QString& item, float& speedKnots, float& altFeet, bool *speedOk, bool *altitudeOk)
@@ -504,34 +568,28 @@ bool extractSpeedAndAltitude(const QString& item, float& speedKnots, float& altF
   speedKnots = 0.f;
   altFeet = 0.f;
 
-  // const static QRegularExpression SPDALT(""^([NMK])(\\d{3,4})(([FSAM])(\\d{3,4}))?$"");
-  QRegularExpressionMatch match = REGEXP_SPDALT.match(item);
-  if(match.hasMatch())
+  char speedUnit, altUnit;
+  float speed = 0.f, alt = 0.f;
+  if(parseSpeedAndAltitude(item, 2, false, speedUnit, speed, altUnit, alt))
   {
-    QString speedUnit = match.captured(1);
-    float speed = match.captured(2).toFloat(&spdOk);
-
-    QString altUnit = match.captured(4);
-    float alt = match.captured(5).toFloat(&altOk);
-
     // Altitude ==============================
-    if(altUnit == "F") // Flight Level
+    if(altUnit == 'F') // Flight Level
       altFeet = alt >= 1000.f ? alt : alt * 100.f;
-    else if(altUnit == "S") // Standard Metric Level in tens of meters
+    else if(altUnit == 'S') // Standard Metric Level in tens of meters
       altFeet = atools::geo::meterToFeet(alt * 10.f);
-    else if(altUnit == "A") // Altitude in hundreds of feet
+    else if(altUnit == 'A') // Altitude in hundreds of feet
       altFeet = alt >= 1000.f ? alt : alt * 100.f;
-    else if(altUnit == "M") // Altitude in tens of meters
+    else if(altUnit == 'M') // Altitude in tens of meters
       altFeet = atools::geo::meterToFeet(alt * 10.f);
     else
       altOk = false;
 
     // Speed ==============================
-    if(speedUnit == "K") // km/h
+    if(speedUnit == 'K') // km/h
       speedKnots = atools::geo::meterToNm(speed * 1000.f);
-    else if(speedUnit == "N") // knots
+    else if(speedUnit == 'N') // knots
       speedKnots = speed;
-    else if(speedUnit == "M") // mach
+    else if(speedUnit == 'M') // mach
       speedKnots = atools::geo::machToTasFromAlt(altFeet, speed / 100.f);
     else
       spdOk = false;
@@ -0,0 +1,805 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/util/fsutilbenchmark.h"
+
+#include "fs/util/coordinates.h"
+#include "fs/util/fsutil.h"
+#include "geo/calculations.h"
+#include "geo/pos.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLocale>
+#include <QRegularExpression>
+#include <QSet>
+
+#include <cmath>
+
+using atools::geo::Pos;
+
+namespace atools {
+namespace fs {
+namespace util {
+
+namespace {
+
+/* Former implementations based on regular expressions. Kept unchanged to detect changed behavior. */
+namespace ref {
+
+const static QRegularExpression REGEXP_CLOSED(QLatin1Literal("(\\[X\\]|\\bCLSD\\b|\\bCLOSED\\b)"));
+const static QRegularExpression REGEXP_DIGIT("\\d");
+const static QRegularExpression REGEXP_WHITESPACE("\\s");
+const static QRegularExpression REGEXP_SPDALT("^([NMK])(\\d{2,4})(([FSAM])(\\d{2,4}))?$");
+const static QRegularExpression REGEXP_SPDALT_ALL("^([NMK])(\\d{3,4})([FSAM])(\\d{3,4})$");
+const static QRegularExpression REGEXP_IDENT_CLEAN("[^A-Z0-9]");
+const static QRegularExpression REGEXP_IDENT("^[A-Z0-9]{1,5}$");
+const static QRegularExpression REGEXP_REGION("^[A-Z0-9]$");
+
+const static QVector<QRegularExpression> REGEXP_MIL({
+        QRegularExpression(QLatin1Literal("(\\[M\\]|\\[MIL\\])")),
+        QRegularExpression(QLatin1Literal("\\bAAF\\b")), QRegularExpression(QLatin1Literal("\\bAB\\b")),
+        QRegularExpression(QLatin1Literal("\\bAF\\b")), QRegularExpression(QLatin1Literal("\\bAFB\\b")),
+        QRegularExpression(QLatin1Literal("\\bAFS\\b")), QRegularExpression(QLatin1Literal("\\bAHP\\b")),
+        QRegularExpression(QLatin1Literal("\\bAIR BASE\\b")), QRegularExpression(QLatin1Literal("\\bAIRBASE\\b")),
+        QRegularExpression(QLatin1Literal("\\bAIR FORCE\\b")), QRegularExpression(QLatin1Literal("\\bANGB\\b")),
+        QRegularExpression(QLatin1Literal("\\bARB\\b")), QRegularExpression(QLatin1Literal("\\bARMY\\b")),
+        QRegularExpression(QLatin1Literal("\\bLRRS\\b")), QRegularExpression(QLatin1Literal("\\bPMRF\\b")),
+        QRegularExpression(QLatin1Literal("\\bMCAF\\b")), QRegularExpression(QLatin1Literal("\\bMCALF\\b")),
+        QRegularExpression(QLatin1Literal("\\bMCAS\\b")), QRegularExpression(QLatin1Literal("\\bMIL\\b")),
+        QRegularExpression(QLatin1Literal("\\bMILITARY\\b")), QRegularExpression(QLatin1Literal("\\bNAF\\b")),
+        QRegularExpression(QLatin1Literal("\\bNALF\\b")), QRegularExpression(QLatin1Literal("\\bNAS\\b")),
+        QRegularExpression(QLatin1Literal("\\bNWS\\b")), QRegularExpression(QLatin1Literal("\\bNAVAL\\b")),
+        QRegularExpression(QLatin1Literal("\\bNAVY\\b")), QRegularExpression(QLatin1Literal("\\bNAWS\\b")),
+        QRegularExpression(QLatin1Literal("\\bNOLF\\b")), QRegularExpression(QLatin1Literal("\\bNS\\b")),
+        QRegularExpression(QLatin1Literal("\\bNSF\\b")), QRegularExpression(QLatin1Literal("\\bNSB\\b")),
+        QRegularExpression(QLatin1Literal("\\bNSY\\b")), QRegularExpression(QLatin1Literal("\\bRAF\\b")),
+        QRegularExpression(QLatin1Literal("\\bNSWC\\b")), QRegularExpression(QLatin1Literal("\\bRNAS\\b")),
+        QRegularExpression(QLatin1Literal("\\bROYAL MARINES\\b")), QRegularExpression(QLatin1Literal("\\bAFLD\\b")),
+        QRegularExpression(QLatin1Literal("\\bAAC\\b"))
+      });
+
+const static QRegularExpression LONG_FORMAT_REGEXP_GFP("^([NS])([0-9]{2})([0-9]{3})([EW])([0-9]{3})([0-9]{3})$");
+const static QRegularExpression LONG_FORMAT_REGEXP_DEG("^([0-9]{2})([NS])([0-9]{3})([EW])$");
+const static QRegularExpression LONG_FORMAT_REGEXP_DEG_MIN("^([0-9]{2})([0-9]{2})([NS])([0-9]{3})([0-9]{2})([EW])$");
+const static QRegularExpression LONG_FORMAT_REGEXP_DEG_MIN_SEC("^([0-9]{2})([0-9]{2})([0-9]{2})([NS])"
+                                                               "([0-9]{3})([0-9]{2})([0-9]{2})([EW])$");
+const static QRegularExpression LONG_FORMAT_REGEXP_NAT("^([0-9]{2})([0-9]{2})N$");
+const static QRegularExpression LONG_FORMAT_REGEXP_PAIR("^([NS])([0-9]{2})([0-9]{2})[ /]([EW])([0-9]{3})([0-9]{2})$");
+const static QRegularExpression LONG_FORMAT_REGEXP_PAIR2("^([0-9]{2})([0-9]{2})([NS])[ /]([0-9]{3})([0-9]{2})([EW])$");
+
+void capWord(QString& lastWord, QChar last, const QSet<QString>& toUpper)
+{
+  static QLocale locale;
+  if(toUpper.contains(lastWord.toUpper()))
+    lastWord = locale.toUpper(lastWord);
+  else
+  {
+    if(last == '\'' && lastWord.size() == 1)
+      lastWord[0] = lastWord.at(0).toLower();
+    else
+    {
+      lastWord = lastWord.toLower();
+      lastWord[0] = lastWord.at(0).toUpper();
+    }
+  }
+}
+
+QString capString(const QString& str, const QSet<QString>& toUpper)
+{
+  if(str.isEmpty())
+    return str;
+
+  QString retval, lastWord;
+  QChar last, lastSep;
+  for(QChar c : str)
+  {
+    if(!c.isLetterOrNumber())
+    {
+      if(last.isLetterOrNumber())
+      {
+        capWord(lastWord, lastSep, toUpper);
+        retval += lastWord;
+        lastWord.clear();
+      }
+      retval += c;
+      lastSep = c;
+    }
+    else
+      lastWord += c;
+
+    last = c;
+  }
+  if(!lastWord.isEmpty())
+  {
+    QChar lastC = str.at(str.size() >= 2 ? str.size() - 2 : 0);
+    capWord(lastWord, lastC, toUpper);
+    retval += lastWord;
+  }
+
+  return retval.replace('_', ' ');
+}
+
+QString capNavString(const QString& str)
+{
+  if(str.contains(REGEXP_DIGIT) && !str.contains(REGEXP_WHITESPACE))
+    return str;
+
+  const static QSet<QString> FORCE_UPPER({
+          "VOR", "VORDME", "TACAN", "VOT", "VORTAC", "DME", "NDB", "GA", "RNAV", "GPS",
+          "ILS", "NDBDME",
+          "ATIS", "AWOS", "ASOS", "AWIS", "CTAF", "FSS", "CAT", "LOC", "I", "II", "III",
+          "H", "HH", "MH", "VASI", "PAPI",
+          "ALS", "ATZ", "CAE", "CTA", "CTR", "FIR", "UIR", "FIZ", "FTZ",
+          "MATZ", "MOA", "RMZ", "TIZ", "TMA", "TMZ", "TRA", "TRSA", "TWEB", "ARSA",
+          "AAS", "CARS", "FIS", "AFIS", "ATF", "VDF", "PCL", "RCO", "RCAG",
+          "NOTAM", "CERAP", "ARTCC",
+        });
+
+  return capString(str, FORCE_UPPER);
+}
+
+QString capAirportName(const QString& str)
+{
+  const static QSet<QString> FORCE_UPPER({
+          "AAF", "AB", "AF", "AFB", "AFS", "AHP", "ANGB", "ARB", "GTS", "LRRS", "PMRF", "MCAF", "MCALF", "MCAS", "NAF",
+          "NALF", "NAS", "NWS", "NAWS", "NOLF", "NS", "NSB", "NSY", "NSWC", "NSF", "RAF", "RNAS", "AFLD", "AAC",
+          "USFS"
+        });
+
+  return capString(str, FORCE_UPPER);
+}
+
+bool isNameClosed(const QString& airportName)
+{
+  return REGEXP_CLOSED.match(airportName.toUpper()).hasMatch();
+}
+
+bool isNameMilitary(const QString& airportName)
+{
+  for(const QRegularExpression& s : REGEXP_MIL)
+  {
+    if(s.match(airportName.toUpper()).hasMatch())
+      return true;
+  }
+  return false;
+}
+
+QString adjustIdent(QString ident, int length, int id)
+{
+  ident = ident.toUpper().replace(REGEXP_IDENT_CLEAN, "").left(length);
+  if(ident.isEmpty() && id != -1)
+    ident = QString("N%1").arg(id, 4, 36, QChar('0')).left(length);
+  return ident.toUpper();
+}
+
+QString adjustRegion(QString region)
+{
+  region = region.toUpper().replace(REGEXP_IDENT_CLEAN, "").left(2);
+  if(region.length() != 2)
+    region = "ZZ";
+  return region.toUpper();
+}
+
+bool isValidIdent(const QString& ident)
+{
+  return REGEXP_IDENT.match(ident).hasMatch();
+}
+
+bool isValidRegion(const QString& region)
+{
+  return REGEXP_REGION.match(region).hasMatch();
+}
+
+bool speedAndAltitudeMatch(const QString& item)
+{
+  return REGEXP_SPDALT_ALL.match(item).hasMatch();
+}
+
+bool extractSpeedAndAltitude(const QString& item, float& speedKnots, float& altFeet, bool *speedOk, bool *altitudeOk)
+{
+  bool spdOk = true, altOk = true;
+  speedKnots = 0.f;
+  altFeet = 0.f;
+
+  QRegularExpressionMatch match = REGEXP_SPDALT.match(item);
+  if(match.hasMatch())
+  {
+    QString speedUnit = match.captured(1);
+    float speed = match.captured(2).toFloat(&spdOk);
+
+    QString altUnit = match.captured(4);
+    float alt = match.captured(5).toFloat(&altOk);
+
+    if(altUnit == "F")
+      altFeet = alt >= 1000.f ? alt : alt * 100.f;
+    else if(altUnit == "S")
+      altFeet = atools::geo::meterToFeet(alt * 10.f);
+    else if(altUnit == "A")
+      altFeet = alt >= 1000.f ? alt : alt * 100.f;
+    else if(altUnit == "M")
+      altFeet = atools::geo::meterToFeet(alt * 10.f);
+    else
+      altOk = false;
+
+    if(speedUnit == "K")
+      speedKnots = atools::geo::meterToNm(speed * 1000.f);
+    else if(speedUnit == "N")
+      speedKnots = speed;
+    else if(speedUnit == "M")
+      speedKnots = atools::geo::machToTasFromAlt(altFeet, speed / 100.f);
+    else
+      spdOk = false;
+  }
+  else
+    spdOk = altOk = false;
+
+  if(speedOk != nullptr)
+    *speedOk = spdOk;
+  if(altitudeOk != nullptr)
+    *altitudeOk = altOk;
+
+  return spdOk && altOk;
+}
+
+Pos fromGfpFormat(const QString& str)
+{
+  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_GFP.match(str.simplified().toUpper());
+  if(match.hasMatch())
+  {
+    QStringList captured = match.capturedTexts();
+    if(captured.size() == 7)
+    {
+      bool latOk, lonOk, latMinOk, lonMinOk;
+      QString ns = captured.at(1);
+      int latYDeg = captured.at(2).toInt(&latOk);
+      float latYMin = captured.at(3).toFloat(&latMinOk) / 10.f;
+      float latYSec = (latYMin - std::floor(latYMin)) * 60.f;
+
+      QString ew = captured.at(4);
+      int lonXDeg = captured.at(5).toInt(&lonOk);
+      float lonXMin = captured.at(6).toFloat(&lonMinOk) / 10.f;
+      float lonXSec = (lonXMin - std::floor(lonXMin)) * 60.f;
+
+      if(latOk && lonOk && latMinOk && lonMinOk && -90 <= latYDeg && latYDeg <= 90 &&
+         -180 <= lonXDeg && lonXDeg <= 180)
+        return Pos(lonXDeg, static_cast<int>(lonXMin), lonXSec, ew == "W",
+                   latYDeg, static_cast<int>(latYMin), latYSec, ns == "S");
+    }
+  }
+  return atools::geo::EMPTY_POS;
+}
+
+Pos fromDegFormat(const QString& str)
+{
+  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG.match(str.simplified().toUpper());
+  if(match.hasMatch())
+  {
+    QStringList captured = match.capturedTexts();
+    if(captured.size() == 5)
+    {
+      bool latOk, lonOk;
+      int latYDeg = captured.at(1).toInt(&latOk);
+      QString ns = captured.at(2);
+      int lonXDeg = captured.at(3).toInt(&lonOk);
+      QString ew = captured.at(4);
+
+      if(latOk && lonOk && -90.f <= latYDeg && latYDeg <= 90.f && -180.f <= lonXDeg && lonXDeg <= 180.f)
+        return Pos(lonXDeg, 0, 0.f, ew == "W", latYDeg, 0, 0.f, ns == "S");
+    }
+  }
+  return atools::geo::EMPTY_POS;
+}
+
+Pos fromDegMinFormat(const QString& str)
+{
+  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG_MIN.match(str.simplified().toUpper());
+  if(match.hasMatch())
+  {
+    QStringList captured = match.capturedTexts();
+    if(captured.size() == 7)
+    {
+      bool latOk, lonOk, latMinOk, lonMinOk;
+      int latYDeg = captured.at(1).toInt(&latOk);
+      int latYMin = captured.at(2).toInt(&latMinOk);
+      QString ns = captured.at(3);
+      int lonXDeg = captured.at(4).toInt(&lonOk);
+      int lonXMin = captured.at(5).toInt(&lonMinOk);
+      QString ew = captured.at(6);
+
+      if(latOk && lonOk && latMinOk && lonMinOk && -90 <= latYDeg && latYDeg <= 90 &&
+         -180 <= lonXDeg && lonXDeg <= 180)
+        return Pos(lonXDeg, lonXMin, 0.f, ew == "W", latYDeg, latYMin, 0.f, ns == "S");
+    }
+  }
+  return atools::geo::EMPTY_POS;
+}
+
+Pos fromDegMinSecFormat(const QString& str)
+{
+  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG_MIN_SEC.match(str.simplified().toUpper());
+  if(match.hasMatch())
+  {
+    QStringList captured = match.capturedTexts();
+    if(captured.size() == 9)
+    {
+      bool latOk, lonOk, latMinOk, lonMinOk, latSecOk, lonSecOk;
+      int latYDeg = captured.at(1).toInt(&latOk);
+      int latYMin = captured.at(2).toInt(&latMinOk);
+      float latYSec = captured.at(3).toFloat(&latSecOk);
+      QString ns = captured.at(4);
+      int lonXDeg = captured.at(5).toInt(&lonOk);
+      int lonXMin = captured.at(6).toInt(&lonMinOk);
+      float lonXSec = captured.at(7).toFloat(&lonSecOk);
+      QString ew = captured.at(8);
+
+      if(latOk && lonOk && latMinOk && lonMinOk && latSecOk && lonSecOk && -90 <= latYDeg && latYDeg <= 90 &&
+         -180 <= lonXDeg && lonXDeg <= 180)
+        return Pos(lonXDeg, lonXMin, lonXSec, ew == "W", latYDeg, latYMin, latYSec, ns == "S");
+    }
+  }
+  return atools::geo::EMPTY_POS;
+}
+
+Pos fromDegMinPairFormat(const QString& str)
+{
+  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_PAIR.match(str.simplified().toUpper());
+
+  bool latOk = false, lonOk = false, latMinOk = false, lonMinOk = false;
+  QString ns, ew;
+  int latYDeg = 0, latYMin = 0, lonXDeg = 0, lonXMin = 0;
+
+  if(match.hasMatch())
+  {
+    QStringList captured = match.capturedTexts();
+    if(captured.size() == 7)
+    {
+      ns = captured.at(1);
+      latYDeg = captured.at(2).toInt(&latOk);
+      latYMin = captured.at(3).toInt(&latMinOk);
+      ew = captured.at(4);
+      lonXDeg = captured.at(5).toInt(&lonOk);
+      lonXMin = captured.at(6).toInt(&lonMinOk);
+    }
+  }
+  else
+  {
+    QRegularExpressionMatch match2 = LONG_FORMAT_REGEXP_PAIR2.match(str.simplified().toUpper());
+    if(match2.hasMatch())
+    {
+      QStringList captured = match2.capturedTexts();
+      if(captured.size() == 7)
+      {
+        latYDeg = captured.at(1).toInt(&latOk);
+        latYMin = captured.at(2).toInt(&latMinOk);
+        ns = captured.at(3);
+        lonXDeg = captured.at(4).toInt(&lonOk);
+        lonXMin = captured.at(5).toInt(&lonMinOk);
+        ew = captured.at(6);
+      }
+    }
+  }
+
+  if(latOk && lonOk && latMinOk && lonMinOk && -90 <= latYDeg && latYDeg <= 90 && -180 <= lonXDeg && lonXDeg <= 180)
+    return Pos(lonXDeg, lonXMin, 0.f, ew == "W", latYDeg, latYMin, 0.f, ns == "S");
+  else
+    return atools::geo::EMPTY_POS;
+}
+
+Pos fromNatFormat(const QString& str)
+{
+  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_NAT.match(str.simplified().toUpper());
+  if(match.hasMatch())
+  {
+    QStringList captured = match.capturedTexts();
+    if(captured.size() == 3)
+    {
+      bool latOk, lonOk;
+      int latYDeg = captured.at(1).toInt(&latOk);
+      int lonXDeg = captured.at(2).toInt(&lonOk);
+
+      if(latOk && lonOk && 0 <= latYDeg && latYDeg <= 90 && 0 <= lonXDeg && lonXDeg <= 180)
+        return Pos(lonXDeg, 0, 0.f, true, latYDeg, 0, 0.f, false);
+    }
+  }
+  return atools::geo::EMPTY_POS;
+}
+
+} // namespace ref
+
+/* Small deterministic generator independent of the standard library implementation */
+class Random
+{
+public:
+  /* Value in range [0, max) */
+  int value(int max)
+  {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return static_cast<int>((state >> 33) % static_cast<quint64>(max));
+  }
+
+  template<typename TYPE>
+  const TYPE& pick(const QVector<TYPE>& values)
+  {
+    return values.at(value(values.size()));
+  }
+
+private:
+  quint64 state = 0x2545f4914f6cdd1dULL;
+};
+
+/* Result of extractSpeedAndAltitude() */
+struct SpeedAltitude
+{
+  bool ok = false, speedOk = false, altOk = false;
+  float speedKnots = 0.f, altFeet = 0.f;
+
+  bool operator==(const SpeedAltitude& other) const
+  {
+    return ok == other.ok && speedOk == other.speedOk && altOk == other.altOk &&
+           speedKnots == other.speedKnots && altFeet == other.altFeet;
+  }
+
+};
+
+/* Exact comparison since both implementations have to call the same constructors with the same values */
+bool equal(const Pos& pos1, const Pos& pos2)
+{
+  return (!pos1.isValid() && !pos2.isValid()) ||
+         (pos1.isValid() && pos2.isValid() && pos1.getLonX() == pos2.getLonX() && pos1.getLatY() == pos2.getLatY());
+}
+
+template<typename TYPE>
+bool equal(const TYPE& value1, const TYPE& value2)
+{
+  return value1 == value2;
+}
+
+/* Values to sum up to avoid removal of unused results */
+double weight(const QString& value)
+{
+  return value.size();
+}
+
+double weight(bool value)
+{
+  return value;
+}
+
+double weight(const Pos& value)
+{
+  return value.isValid() ? value.getLonX() + value.getLatY() : 0.;
+}
+
+double weight(const SpeedAltitude& value)
+{
+  return value.speedKnots + value.altFeet;
+}
+
+QString toString(const QString& value)
+{
+  return "\"" + value + "\"";
+}
+
+QString toString(bool value)
+{
+  return value ? "true" : "false";
+}
+
+QString toString(const Pos& value)
+{
+  return value.isValid() ? QString("%1 %2").arg(value.getLonX(), 0, 'f', 6).arg(value.getLatY(), 0, 'f', 6) : "invalid";
+}
+
+QString toString(const SpeedAltitude& value)
+{
+  return QString("ok %1 speed %2 %3 alt %4 %5").arg(value.ok).
+         arg(value.speedOk).arg(value.speedKnots).arg(value.altOk).arg(value.altFeet);
+}
+
+/* Compare current implementation and reference for all corpus entries and time both */
+template<typename FUNC, typename REF>
+FsUtilBenchmarkResult measure(const QString& name, const QStringList& corpus, int repetitions, FUNC func, REF ref)
+{
+  FsUtilBenchmarkResult result;
+  result.name = name;
+  result.size = corpus.size();
+  result.operations = static_cast<qint64>(corpus.size()) * repetitions;
+
+  for(const QString& str : corpus)
+  {
+    auto value = func(str);
+    auto refValue = ref(str);
+    if(!equal(value, refValue))
+    {
+      if(result.mismatches < 10)
+        qWarning() << Q_FUNC_INFO << name << "mismatch for" << str << ":" << toString(value)
+                   << "reference" << toString(refValue);
+      result.mismatches++;
+    }
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  for(int i = 0; i < repetitions; i++)
+  {
+    for(const QString& str : corpus)
+      result.checksum += weight(func(str));
+  }
+  result.timeNs = timer.nsecsElapsed();
+
+  double refChecksum = 0.;
+  timer.start();
+  for(int i = 0; i < repetitions; i++)
+  {
+    for(const QString& str : corpus)
+      refChecksum += weight(ref(str));
+  }
+  result.referenceTimeNs = timer.nsecsElapsed();
+
+  if(std::abs(refChecksum - result.checksum) > 0.001)
+    qWarning() << Q_FUNC_INFO << name << "checksum differs" << result.checksum << refChecksum;
+
+  return result;
+}
+
+}
+
+FsUtilBenchmark::FsUtilBenchmark()
+{
+}
+
+void FsUtilBenchmark::run()
+{
+  results.clear();
+  runNames();
+  runIdents();
+  runCoordinates();
+
+  for(const FsUtilBenchmarkResult& result : results)
+    qDebug() << Q_FUNC_INFO << result.name << result.size << result.nsPerOperation() << "ns/op"
+             << "reference" << result.referenceNsPerOperation() << "ns/op" << "mismatches" << result.mismatches;
+}
+
+int FsUtilBenchmark::getNumMismatches() const
+{
+  int num = 0;
+  for(const FsUtilBenchmarkResult& result : results)
+    num += result.mismatches;
+  return num;
+}
+
+void FsUtilBenchmark::runNames()
+{
+  // Fixed corpus. Do not change to keep results comparable.
+  const QVector<QString> words({
+          "FRANKFURT", "main", "Intl", "st.", "mary's", "o'hare", "AFB", "afb", "air force", "Air Base", "airbase",
+          "[MIL]", "[m]", "[X]", "[x]", "CLSD", "closed", "Closedown", "usfs", "RAF", "raf_station", "NAS", "nasa",
+          "Royal Marines", "MCAS", "ab1", "_AB_", "ILS", "vor/dme", "NDB", "TMA", "ctr", "CAT", "II", "iii", "A",
+          "i", "2", "25L", "RWY", "ED-R", "123A", "São", "Paulo/Guarulhos", "ZÜRICH", "Münster-Osnabrück",
+          "Île-d'Yeu", "ĀĒĪ", "Straße", "DES", "MOINES", "'s", "-", "(", ")", "/", "  ", "\t", "army", "NAVAL"
+        });
+  const QVector<QString> separators({" ", " ", " ", "-", "/", "_", ", ", " (", ") ", "'", ""});
+
+  Random random;
+  QStringList corpus;
+  for(const QString& word : words)
+    corpus.append(word);
+  for(int i = 0; i < 2000; i++)
+  {
+    QString name;
+    int numWords = 1 + random.value(5);
+    for(int j = 0; j < numWords; j++)
+    {
+      if(j > 0)
+        name += random.pick(separators);
+      name += random.pick(words);
+    }
+    corpus.append(name);
+  }
+
+  results.append(measure("cap_airport_name", corpus, repetitions, capAirportName, ref::capAirportName));
+  results.append(measure("cap_nav_string", corpus, repetitions, capNavString, ref::capNavString));
+  results.append(measure("is_name_military", corpus, repetitions, isNameMilitary, ref::isNameMilitary));
+  results.append(measure("is_name_closed", corpus, repetitions, isNameClosed, ref::isNameClosed));
+}
+
+void FsUtilBenchmark::runIdents()
+{
+  // Fixed corpus. Do not change to keep results comparable.
+  const QVector<QString> chars({
+          "A", "B", "K", "Z", "a", "e", "z", "0", "1", "9", " ", "-", "_", "/", ".", "é", "ü", "ß", "Ö", "\t"
+        });
+  const QVector<QString> fixed({
+          "", "EDDF", "eddf", "K JFK", "KJFK1", "123456", "AB", "Z", "ü", "a_b", "ED", "E", "1", "e", "ZZZZZZ"
+        });
+
+  Random random;
+  QStringList corpus;
+  for(const QString& str : fixed)
+    corpus.append(str);
+  for(int i = 0; i < 2000; i++)
+  {
+    QString ident;
+    int size = random.value(8);
+    for(int j = 0; j < size; j++)
+      ident += random.pick(chars);
+    corpus.append(ident);
+  }
+
+  results.append(measure("adjust_ident", corpus, repetitions, [](const QString& str) -> QString {
+    return adjustIdent(str);
+  }, [](const QString& str) -> QString {
+    return ref::adjustIdent(str, 5, -1);
+  }));
+
+  QStringList idCorpus;
+  for(int i = 0; i < corpus.size(); i++)
+    idCorpus.append(corpus.at(i).left(i % 3));
+  results.append(measure("adjust_ident_id", idCorpus, repetitions, [](const QString& str) -> QString {
+    return adjustIdent(str, 4, static_cast<int>(qHash(str) % 100000));
+  }, [](const QString& str) -> QString {
+    return ref::adjustIdent(str, 4, static_cast<int>(qHash(str) % 100000));
+  }));
+
+  results.append(measure("adjust_region", corpus, repetitions, adjustRegion, ref::adjustRegion));
+  results.append(measure("is_valid_ident", corpus, repetitions, isValidIdent, ref::isValidIdent));
+  results.append(measure("is_valid_region", corpus, repetitions, isValidRegion, ref::isValidRegion));
+
+  // Speed and altitude ============================================
+  const QVector<QString> speedUnits({"N", "M", "K", "X", "n", ""});
+  const QVector<QString> altUnits({"F", "S", "A", "M", "X", "f", ""});
+  const QVector<QString> digits({"0", "1", "3", "4", "9", "٣"});
+
+  QStringList spdAltCorpus({"N0490F360", "M084F330", "K0800S1260", "N490A100", "M082", "N0450", "N04F3",
+                            "N0490F36", "N0490F3600", "N00490F360", "N49", "m084f330", "N0490 F360", "N0490/F360"});
+  for(int i = 0; i < 2000; i++)
+  {
+    QString str = random.pick(speedUnits);
+    int numSpeedDigits = random.value(6);
+    for(int j = 0; j < numSpeedDigits; j++)
+      str += random.pick(digits);
+    str += random.pick(altUnits);
+    int numAltDigits = random.value(6);
+    for(int j = 0; j < numAltDigits; j++)
+      str += random.pick(digits);
+    spdAltCorpus.append(str);
+  }
+
+  results.append(measure("speed_altitude_match", spdAltCorpus, repetitions, speedAndAltitudeMatch,
+                         ref::speedAndAltitudeMatch));
+  results.append(measure("extract_speed_altitude", spdAltCorpus, repetitions, [](const QString& str) -> SpeedAltitude {
+    SpeedAltitude value;
+    value.ok = extractSpeedAndAltitude(str, value.speedKnots, value.altFeet, &value.speedOk, &value.altOk);
+    return value;
+  }, [](const QString& str) -> SpeedAltitude {
+    SpeedAltitude value;
+    value.ok = ref::extractSpeedAndAltitude(str, value.speedKnots, value.altFeet, &value.speedOk, &value.altOk);
+    return value;
+  }));
+}
+
+void FsUtilBenchmark::runCoordinates()
+{
+  Random random;
+  QStringList gfp, deg, degMin, degMinSec, nat, pair;
+
+  auto number = [&random](int width) -> QString {
+                  QString str;
+                  for(int i = 0; i < width; i++)
+                    str += QChar('0' + random.value(10));
+                  return str;
+                };
+
+  // Valid, out of range and changed strings ======================================
+  for(int i = 0; i < 1000; i++)
+  {
+    Pos pos(static_cast<float>(random.value(360000)) / 1000.f - 180.f,
+            static_cast<float>(random.value(180000)) / 1000.f - 90.f);
+    QString ns = pos.getLatY() > 0.f ? "N" : "S", ew = pos.getLonX() > 0.f ? "E" : "W";
+
+    gfp.append(toGfpFormat(pos));
+    degMin.append(toDegMinFormat(pos));
+    degMinSec.append(toDegMinSecFormat(pos));
+    deg.append(number(2) + ns + number(3) + ew);
+    nat.append(number(4) + (i % 10 == 0 ? "S" : "N"));
+    pair.append(ns + number(4) + (i % 2 ? " " : "/") + ew + number(5));
+    pair.append(number(4) + ns + (i % 2 ? "/" : " ") + number(5) + ew);
+  }
+
+  QVector<QStringList *> lists({&gfp, &deg, &degMin, &degMinSec, &nat, &pair});
+  for(QStringList *list : lists)
+  {
+    int size = list->size();
+    for(int i = 0; i < size; i += 4)
+    {
+      QString str = list->at(i);
+      list->append(str.toLower());
+      list->append("  " + str + " ");
+      list->append(str.left(str.size() - 1));
+      list->append(str + "1");
+
+      QString changed(str);
+      changed[random.value(changed.size())] = QChar(random.pick(QVector<ushort>({'X', '5', ' ', '/', 0xe9})));
+      list->append(changed);
+
+      // Space in the middle which is collapsed
+      list->append(str.left(4) + "  " + str.mid(4));
+    }
+  }
+  pair.append({"N6400 W07000", "N6400/W07000", "6400N/07000W", "6400N  07000W", "N6400\tW07000"});
+  nat.append({"5020N", "9999N", "0000N", " 5020n"});
+  deg.append({"46N078W", "99N999E", "00S000E"});
+
+  results.append(measure("from_gfp_format", gfp, repetitions, fromGfpFormat, ref::fromGfpFormat));
+  results.append(measure("from_deg_format", deg, repetitions, fromDegFormat, ref::fromDegFormat));
+  results.append(measure("from_deg_min_format", degMin, repetitions, fromDegMinFormat, ref::fromDegMinFormat));
+  results.append(measure("from_deg_min_sec_format", degMinSec, repetitions, fromDegMinSecFormat,
+                         ref::fromDegMinSecFormat));
+  results.append(measure("from_nat_format", nat, repetitions, fromNatFormat, ref::fromNatFormat));
+  results.append(measure("from_deg_min_pair_format", pair, repetitions, fromDegMinPairFormat,
+                         ref::fromDegMinPairFormat));
+}
+
+QJsonDocument FsUtilBenchmark::toJson() const
+{
+  QJsonArray resultArr;
+  for(const FsUtilBenchmarkResult& result : results)
+  {
+    QJsonObject obj;
+    obj.insert("name", result.name);
+    obj.insert("size", result.size);
+    obj.insert("operations", static_cast<double>(result.operations));
+    obj.insert("time_ns", static_cast<double>(result.timeNs));
+    obj.insert("ns_per_op", result.nsPerOperation());
+    obj.insert("reference_time_ns", static_cast<double>(result.referenceTimeNs));
+    obj.insert("reference_ns_per_op", result.referenceNsPerOperation());
+    obj.insert("mismatches", result.mismatches);
+    obj.insert("checksum", result.checksum);
+    resultArr.append(obj);
+  }
+
+  QJsonObject root;
+  root.insert("repetitions", repetitions);
+  root.insert("mismatches", getNumMismatches());
+  root.insert("results", resultArr);
+  return QJsonDocument(root);
+}
+
+bool FsUtilBenchmark::writeJson(const QString& filename) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(toJson().toJson(QJsonDocument::Indented));
+    file.close();
+    return true;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << ":" << file.errorString();
+  return false;
+}
+
+} // namespace util
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,112 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_UTIL_FSUTILBENCHMARK_H
+#define ATOOLS_FS_UTIL_FSUTILBENCHMARK_H
+
+#include <QJsonDocument>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace util {
+
+/* Result of one benchmark case */
+struct FsUtilBenchmarkResult
+{
+  QString name; /* Case name like "cap_airport_name" */
+  int size = 0; /* Number of distinct inputs in the corpus */
+  qint64 operations = 0L; /* Number of measured calls for each implementation */
+  qint64 timeNs = 0L, /* Total wall time of the current implementation */
+         referenceTimeNs = 0L; /* Total wall time of the regular expression based reference */
+  int mismatches = 0; /* Number of corpus entries where current and reference results differ */
+  double checksum = 0.; /* Sum of results of the current implementation to avoid dead code removal */
+
+  double nsPerOperation() const
+  {
+    return operations > 0 ? static_cast<double>(timeNs) / static_cast<double>(operations) : 0.;
+  }
+
+  double referenceNsPerOperation() const
+  {
+    return operations > 0 ? static_cast<double>(referenceTimeNs) / static_cast<double>(operations) : 0.;
+  }
+
+};
+
+/*
+ * Micro-benchmark for the name, ident and coordinate string helpers in fsutil and coordinates.
+ *
+ * Each case runs the current implementation and a copy of the former implementation based on regular
+ * expressions on the same fixed corpus. The results of both are compared for every corpus entry and the number
+ * of differences is reported as mismatches. Differences are also logged.
+ *
+ * The corpus contains generated coordinates in all fixed width waypoint formats, names with military and
+ * closed designators, acronyms, apostrophes, underscores and non ASCII characters as well as valid and invalid
+ * idents, regions and speed/altitude strings. It is created by a fixed pseudo random generator so runs are
+ * comparable across platforms. Strings ending with a line feed are not part of the corpus since "$" in the former
+ * expressions also matched before a trailing line feed.
+ *
+ * Covers capAirportName, capNavString, isNameMilitary, isNameClosed, adjustIdent, adjustRegion, isValidIdent,
+ * isValidRegion, speedAndAltitudeMatch, extractSpeedAndAltitude and the GFP, degrees, degrees/minutes, DMS,
+ * NAT and pair coordinate formats.
+ *
+ * Results can be saved as JSON.
+ */
+class FsUtilBenchmark
+{
+public:
+  FsUtilBenchmark();
+
+  /* Run all cases. Can be repeated. */
+  void run();
+
+  const QVector<atools::fs::util::FsUtilBenchmarkResult>& getResults() const
+  {
+    return results;
+  }
+
+  /* Total number of mismatches in all cases. 0 if current and former implementations agree. */
+  int getNumMismatches() const;
+
+  /* Machine readable report containing all results */
+  QJsonDocument toJson() const;
+
+  /* Write JSON report to file. Returns false on error. */
+  bool writeJson(const QString& filename) const;
+
+  /* Number of passes over the corpus for each case. Default is 20. */
+  void setRepetitions(int value)
+  {
+    repetitions = value;
+  }
+
+private:
+  void runNames();
+  void runIdents();
+  void runCoordinates();
+
+  QVector<atools::fs::util::FsUtilBenchmarkResult> results;
+  int repetitions = 20;
+};
+
+} // namespace util
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_UTIL_FSUTILBENCHMARK_H
@@ -17,52 +17,41 @@
 
 #include "fs/util/morsecode.h"
 
-#include <QHash>
-
 namespace atools {
 namespace fs {
 namespace util {
 
-/* *INDENT-OFF* */
-const QHash<QChar, QString> CODES {
-  { 'A', "·−" },
-  { 'B', "−···" },
-  { 'C', "−·−·" },
-  { 'D', "−··" },
-  { 'E', "·" },
-  { 'F', "··−·" },
-  { 'G', "−−·" },
-  { 'H', "····" },
-  { 'I', "··" },
-  { 'J', "·−−−" },
-  { 'K', "−·−" },
-  { 'L', "·−··" },
-  { 'M', "−−" },
-  { 'N', "−·" },
-  { 'O', "−−−" },
-  { 'P', "·−−·" },
-  { 'Q', "−−·−" },
-  { 'R', "·−·" },
-  { 'S', "···" },
-  { 'T', "−" },
-  { 'U', "··−" },
-  { 'V', "···−" },
-  { 'W', "·−−" },
-  { 'X', "−··−" },
-  { 'Y', "−·−−" },
-  { 'Z', "−−··" },
-  { '1', "·−−−−" },
-  { '2', "··−−−" },
-  { '3', "···−−" },
-  { '4', "····−" },
-  { '5', "·····" },
-  { '6', "−····" },
-  { '7', "−−···" },
-  { '8', "−−−··" },
-  { '9', "−−−−·" },
-  { '0', "−−−−−" }
+namespace {
+
+/* Dot is "·" and dash is "−" in the result */
+const QChar DOT(0x00B7), DASH(0x2212);
+
+/* Codes for A-Z using '.' and '-' */
+constexpr const char *LETTER_CODES[26] = {
+  ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---", "-.-", ".-..", "--",
+  "-.", "---", ".--.", "--.-", ".-.", "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--.."
+};
+
+/* Codes for 0-9 */
+constexpr const char *DIGIT_CODES[10] = {
+  "-----", ".----", "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----."
 };
-/* *INDENT-ON* */
+
+/* Code for character or empty string if not available */
+const char *codeForChar(QChar c)
+{
+  ushort u = c.unicode();
+  if(u >= 'A' && u <= 'Z')
+    return LETTER_CODES[u - 'A'];
+  else if(u >= 'a' && u <= 'z')
+    return LETTER_CODES[u - 'a'];
+  else if(u >= '0' && u <= '9')
+    return DIGIT_CODES[u - '0'];
+  else
+    return "";
+}
+
+}
 
 MorseCode::MorseCode(const QString& signSeparator, const QString& charSeparator)
   : signSep(signSeparator), charSep(charSeparator)
@@ -75,22 +64,21 @@ MorseCode::~MorseCode()
 
 QString MorseCode::getCode(const QString& text)
 {
-  QString txt = text.toUpper();
   QString retval;
+  retval.reserve(text.size() * (5 * (1 + signSep.size()) + charSep.size()));
 
-  for(QChar c : txt)
+  for(QChar c : text)
   {
-    QString codeStr;
-    QString code = CODES.value(c);
-    for(QChar cc : code)
-    {
-      if(!codeStr.isEmpty())
-        codeStr.append(signSep);
-      codeStr.append(cc);
-    }
     if(!retval.isEmpty())
       retval.append(charSep);
-    retval.append(codeStr);
+
+    const char *start = codeForChar(c);
+    for(const char *code = start; *code != '\0'; code++)
+    {
+      if(code != start)
+        retval.append(signSep);
+      retval.append(*code == '.' ? DOT : DASH);
+    }
   }
   return retval;
 }
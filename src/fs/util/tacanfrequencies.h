@@ -24,7 +24,8 @@ namespace atools {
 namespace fs {
 namespace util {
 
-/* VOR frequency for TACAN DME multiplied by 100 and vice versa */
+/* VOR frequency for TACAN DME multiplied by 100 and vice versa. Channels are calculated from the frequency bands.
+ * Returns 0 or an empty string if channel or frequency are not valid. */
 int frequencyForTacanChannel(const QString& channel);
 QString tacanChannelForFrequency(int frequency);
 
@@ -0,0 +1,234 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/weather/metargrid.h"
+
+#include "atools.h"
+#include "geo/calculations.h"
+#include "geo/spatialindex.h"
+#include "util/parallel.h"
+
+#include <QDateTime>
+
+namespace atools {
+namespace fs {
+namespace weather {
+
+/* Number of stations used for interpolation of each cell */
+static const int NUM_NEIGHBOURS = 6;
+
+/* Stations farther away are not used */
+static const float MAX_DISTANCE_METER = atools::geo::nmToMeter(300.f);
+
+/* Ceiling used for missing BKN or OVC layers when interpolating */
+static const float UNLIMITED_CEILING_METER = atools::geo::feetToMeter(12000.f);
+
+/* Visibility reported as 9999 */
+static const float MAX_VISIBILITY_METER = 10000.f;
+
+/* Number of grid rows calculated by a task */
+static const int MIN_ROWS_PER_TASK = 4;
+
+namespace {
+
+inline bool valid(float value)
+{
+  return value < INVALID_METAR_VALUE / 2.f;
+}
+
+/* Weighted sum of one parameter */
+struct WeightedSum
+{
+  void add(float value, float weight)
+  {
+    if(valid(value))
+    {
+      sum += value * weight;
+      weights += weight;
+    }
+  }
+
+  float get() const
+  {
+    return weights > 0.f ? sum / weights : INVALID_METAR_VALUE;
+  }
+
+  float sum = 0.f, weights = 0.f;
+};
+
+} // namespace
+
+MetarGridValue MetarGridValue::fromMetar(const MetarParser& metar, const atools::geo::Pos& pos)
+{
+  MetarGridValue value;
+  value.pos = pos;
+  value.windDirDeg = metar.getPrevailingWindDir();
+  value.windSpeedKts = metar.getPrevailingWindSpeedKnots();
+  value.pressureMbar = metar.getPressureMbar();
+
+  float visibility = metar.getMinVisibility().getVisibilityMeter();
+  if(metar.getCavok())
+    visibility = MAX_VISIBILITY_METER;
+  value.visibilityMeter = valid(visibility) ? std::min(visibility, MAX_VISIBILITY_METER) : INVALID_METAR_VALUE;
+
+  // The lowest "BKN" or "OVC" layer specifies the cloud ceiling
+  value.ceilingMeter = UNLIMITED_CEILING_METER;
+  for(const MetarCloud& cloud : metar.getClouds())
+  {
+    if((cloud.getCoverage() == MetarCloud::COVERAGE_BROKEN || cloud.getCoverage() == MetarCloud::COVERAGE_OVERCAST) &&
+       cloud.getAltitudeMeter() < value.ceilingMeter)
+      value.ceilingMeter = cloud.getAltitudeMeter();
+  }
+  return value;
+}
+
+bool MetarGridValue::isValid() const
+{
+  return pos.isValid() && (valid(windSpeedKts) || valid(visibilityMeter) || valid(pressureMbar));
+}
+
+QString MetarGridValue::toMetarString(const QString& ident, const QDateTime& timestamp) const
+{
+  QStringList metar({ident, timestamp.toUTC().toString("ddhhmm") + "Z"});
+
+  if(valid(windSpeedKts))
+  {
+    int speed = atools::roundToInt(windSpeedKts);
+    if(windDirDeg >= 0 && speed > 0)
+      metar.append(QString("%1%2KT").arg(windDirDeg == 0 ? 360 : windDirDeg, 3, 10, QChar('0')).
+                   arg(speed, 2, 10, QChar('0')));
+    else
+      metar.append(QString("VRB%1KT").arg(speed, 2, 10, QChar('0')));
+  }
+
+  if(valid(visibilityMeter))
+    metar.append(QString("%1").arg(std::min(atools::roundToInt(visibilityMeter / 100.f) * 100, 9999), 4, 10,
+                                   QChar('0')));
+
+  if(valid(ceilingMeter) && ceilingMeter < UNLIMITED_CEILING_METER * 0.9f)
+    metar.append(QString("BKN%1").arg(atools::roundToInt(atools::geo::meterToFeet(ceilingMeter) / 100.f), 3, 10,
+                                      QChar('0')));
+
+  if(valid(pressureMbar))
+    metar.append(QString("Q%1").arg(atools::roundToInt(pressureMbar), 4, 10, QChar('0')));
+
+  return metar.join(' ');
+}
+
+// ====================================================================================================
+MetarGrid::MetarGrid(float cellSizeDegParam)
+  : cellSizeDeg(cellSizeDegParam)
+{
+}
+
+bool MetarGrid::build(const QVector<MetarGridValue>& stations, const std::function<bool()>& isAborted)
+{
+  values.clear();
+  numCols = atools::roundToInt(360.f / cellSizeDeg);
+  numRows = atools::roundToInt(180.f / cellSizeDeg);
+
+  atools::geo::SpatialIndex<MetarGridValue> index;
+  for(const MetarGridValue& station : stations)
+  {
+    if(station.isValid())
+      index.append(station);
+  }
+
+  if(index.isEmpty())
+    return true;
+
+  index.updateIndex();
+
+  QVector<MetarGridValue> grid(numCols * numRows);
+  QAtomicInt aborted(0);
+
+  atools::util::parallelFor(numRows, [&](int row) {
+    if(aborted.loadAcquire() || (isAborted && isAborted()))
+    {
+      aborted.storeRelease(1);
+      return;
+    }
+
+    atools::geo::SpatialIndexBuffer buffer;
+    QVector<MetarGridValue> nearest;
+    float latY = -90.f + (row + 0.5f) * cellSizeDeg;
+
+    for(int col = 0; col < numCols; col++)
+    {
+      atools::geo::Pos pos(-180.f + (col + 0.5f) * cellSizeDeg, latY);
+      nearest.clear();
+      index.getNearest(nearest, pos, NUM_NEIGHBOURS, buffer);
+
+      WeightedSum windU, windV, windSpeed, visibility, ceiling, pressure;
+      for(const MetarGridValue& station : nearest)
+      {
+        float distance = pos.distanceMeterTo(station.pos);
+        if(distance > MAX_DISTANCE_METER)
+          continue;
+
+        // Inverse distance squared weight. Limit to avoid the singularity at the station position.
+        float weight = 1.f / std::max(distance * distance, 1.f);
+
+        if(valid(station.windSpeedKts) && station.windDirDeg >= 0)
+        {
+          float rad = atools::geo::toRadians(static_cast<float>(station.windDirDeg));
+          windU.add(std::sin(rad) * station.windSpeedKts, weight);
+          windV.add(std::cos(rad) * station.windSpeedKts, weight);
+        }
+        windSpeed.add(station.windSpeedKts, weight);
+        visibility.add(station.visibilityMeter, weight);
+        ceiling.add(station.ceilingMeter, weight);
+        pressure.add(station.pressureMbar, weight);
+      }
+
+      MetarGridValue& value = grid[row * numCols + col];
+      value.windSpeedKts = windSpeed.get();
+      value.visibilityMeter = visibility.get();
+      value.ceilingMeter = ceiling.get();
+      value.pressureMbar = pressure.get();
+
+      if(valid(windU.get()) && (windU.get() != 0.f || windV.get() != 0.f))
+        value.windDirDeg = atools::roundToInt(atools::geo::normalizeCourse(
+                                                atools::geo::toDegree(std::atan2(windU.get(), windV.get()))));
+
+      if(valid(value.windSpeedKts) || valid(value.visibilityMeter) || valid(value.pressureMbar))
+        value.pos = pos;
+    }
+  }, MIN_ROWS_PER_TASK);
+
+  if(aborted.loadAcquire())
+    return false;
+
+  values.swap(grid);
+  return true;
+}
+
+const MetarGridValue& MetarGrid::getValue(const atools::geo::Pos& pos) const
+{
+  if(values.isEmpty() || !pos.isValid())
+    return invalidValue;
+
+  int col = static_cast<int>((atools::geo::normalizeLonXDeg(pos.getLonX()) + 180.f) / cellSizeDeg);
+  int row = static_cast<int>((pos.getLatY() + 90.f) / cellSizeDeg);
+
+  return values.at(atools::minmax(0, numRows - 1, row) * numCols + atools::minmax(0, numCols - 1, col));
+}
+
+} // namespace weather
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,92 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_METARGRID_H
+#define ATOOLS_METARGRID_H
+
+#include "fs/weather/metarparser.h"
+#include "geo/pos.h"
+
+#include <QVector>
+
+#include <functional>
+
+namespace atools {
+namespace fs {
+namespace weather {
+
+/* Weather parameters for a station or an interpolated position.
+ * Values are INVALID_METAR_VALUE or -1 for direction if not available. */
+struct MetarGridValue
+{
+  /* Fill from parsed METAR */
+  static MetarGridValue fromMetar(const atools::fs::weather::MetarParser& metar, const atools::geo::Pos& pos);
+
+  bool isValid() const;
+
+  /* Build a METAR string like "EDDF 141220Z 27012KT 9999 BKN045 Q1013" which can be read by the parser */
+  QString toMetarString(const QString& ident, const QDateTime& timestamp) const;
+
+  atools::geo::Pos pos;
+  int windDirDeg = -1;
+  float windSpeedKts = INVALID_METAR_VALUE, visibilityMeter = INVALID_METAR_VALUE, ceilingMeter = INVALID_METAR_VALUE,
+        pressureMbar = INVALID_METAR_VALUE;
+
+  const atools::geo::Pos& getPosition() const
+  {
+    return pos;
+  }
+
+};
+
+/*
+ * Global grid of weather parameters interpolated from the nearest stations using inverse distance weighting.
+ * Built once per METAR update which reduces interpolated lookups to one grid access.
+ *
+ * Wind is interpolated as a vector. Missing ceiling is interpolated as unlimited.
+ * Cells without any station within the maximum distance are invalid.
+ */
+class MetarGrid
+{
+public:
+  explicit MetarGrid(float cellSizeDegParam = 1.f);
+
+  /* Calculate grid values from stations. Uses all threads of the shared task scheduler.
+   * Stops and returns false if isAborted returns true. */
+  bool build(const QVector<MetarGridValue>& stations, const std::function<bool()>& isAborted = nullptr);
+
+  /* Interpolated value for the position. Invalid if no stations are nearby. */
+  const MetarGridValue& getValue(const atools::geo::Pos& pos) const;
+
+  bool isEmpty() const
+  {
+    return values.isEmpty();
+  }
+
+private:
+  float cellSizeDeg;
+  int numCols = 0, numRows = 0;
+  QVector<MetarGridValue> values;
+  MetarGridValue invalidValue;
+};
+
+} // namespace weather
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_METARGRID_H
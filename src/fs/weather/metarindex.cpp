@@ -18,34 +18,49 @@
 #include "fs/weather/metarindex.h"
 
 #include "geo/spatialindex.h"
+#include "fs/weather/metargrid.h"
+#include "fs/weather/metarparser.h"
 #include "fs/weather/weathertypes.h"
+#include "util/flathashmap.h"
+#include "util/parallel.h"
+#include "util/trace.h"
 
-#include <QTimeZone>
-#include <QRegularExpression>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+#include <limits>
 
 namespace atools {
 namespace fs {
 namespace weather {
 
-/* Internal struct for METAR data. Stored in the spatial index */
+using atools::util::packIdent;
+using atools::util::unpackIdent;
+
+/* Marks missing timestamp */
+static const qint64 INVALID_TIMESTAMP = std::numeric_limits<qint64>::min();
+
+/* Number of parsed METARs kept in cache */
+static const int PARSED_CACHE_SIZE = 64;
+
+/* Internal compact struct for METAR data. Stored in the spatial index. Text is kept in the buffer of the index. */
 struct MetarData
 {
-  MetarData(const QString& identParam, const QString& metarParam, QDateTime timestampParam,
-            const atools::geo::Pos& posParam)
-    : ident(identParam), metar(metarParam), timestamp(timestampParam), pos(posParam)
-  {
-  }
+  /* Ident packed by atools::util::packIdent() */
+  quint64 ident = 0;
 
-  MetarData()
-  {
-  }
+  /* Seconds since epoch in UTC or INVALID_TIMESTAMP */
+  qint64 timestamp = INVALID_TIMESTAMP;
 
-  QString ident, metar;
-  QDateTime timestamp;
+  /* Location of UTF-8 METAR text in buffer */
+  int offset = 0, length = 0;
 
   bool isValid() const
   {
-    return !ident.isEmpty();
+    return ident != 0;
   }
 
   atools::geo::Pos pos;
@@ -57,40 +72,178 @@ struct MetarData
 
 };
 
-// ====================================================================================================
-MetarIndex::MetarIndex(MetarFormat formatParam, bool verboseLogging)
-  : verbose(verboseLogging), format(formatParam)
+/* Interpolation grid shared between index and the background build task which might outlive the index */
+struct MetarGridState
 {
-  spatialIndex = new atools::geo::SpatialIndex<MetarData>;
+  QMutex mutex;
+  QSharedPointer<const MetarGrid> grid;
+
+  /* Incremented for each build. Builds of older generations stop and discard their result. */
+  QAtomicInt generation;
+};
+
+namespace {
+
+/* Parses METARs and builds the interpolation grid. Publishes the result if no newer build has been started. */
+class MetarGridRunnable :
+  public QRunnable
+{
+public:
+  MetarGridRunnable(const QSharedPointer<MetarGridState>& stateParam,
+                    const QVector<QPair<atools::geo::Pos, QString> >& metarsParam, int generationParam)
+    : state(stateParam), metars(metarsParam), generation(generationParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    QVector<MetarGridValue> stations(metars.size());
+    atools::util::parallelFor(metars.size(), [&](int i) {
+      // Parser throws for invalid METARs which are left out of the grid
+      try
+      {
+        stations[i] = MetarGridValue::fromMetar(MetarParser(metars.at(i).second), metars.at(i).first);
+      }
+      catch(const std::exception&)
+      {
+      }
+    }, 256);
+
+    QSharedPointer<MetarGrid> grid(new MetarGrid);
+    if(grid->build(stations, [this]() -> bool {
+      return state->generation.loadAcquire() != generation;
+    }))
+    {
+      QMutexLocker locker(&state->mutex);
+      if(state->generation.loadAcquire() == generation)
+        state->grid = grid;
+    }
+  }
+
+private:
+  QSharedPointer<MetarGridState> state;
+  QVector<QPair<atools::geo::Pos, QString> > metars;
+  int generation;
+};
+
+/* Minimum number of lines for each chunk when parsing in parallel */
+const int MIN_CHUNK_LINES = 2000;
+
+/* Julian day of 1970-01-01 */
+const qint64 EPOCH_JULIAN_DAY = 2440588;
+
+/* One METAR line as found by the parsers */
+struct ParsedMetar
+{
+  QString ident;
+  QByteArray metar;
+  qint64 timestamp;
+};
+
+/* Line which could not be parsed. Logged after parsing to keep the order. */
+struct InvalidLine
+{
+  int lineNum;
+  QString line;
+  bool badDate;
+};
+
+/* Result of parsing a range of lines */
+struct ParsedChunk
+{
+  QVector<ParsedMetar> metars;
+  QVector<InvalidLine> invalidLines;
+  int futureDates = 0;
+};
+
+inline bool isDigit(QChar c)
+{
+  return c >= '0' && c <= '9';
 }
 
-MetarIndex::~MetarIndex()
+/* Value of count digits at pos. Does not check for digits. */
+inline int digits(const QStringRef& str, int pos, int count)
 {
-  delete spatialIndex;
+  int value = 0;
+  for(int i = pos; i < pos + count; i++)
+    value = value * 10 + (str.at(i).unicode() - '0');
+  return value;
 }
 
-int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
+/* Replaces regular expression "^[A-Z0-9]{2,5}$" */
+bool isIdent(const QStringRef& ident)
 {
-  Q_ASSERT(format != UNKNOWN);
-  Q_ASSERT(fetchAirportCoords);
+  if(ident.size() < 2 || ident.size() > 5)
+    return false;
+
+  for(QChar c : ident)
+  {
+    if(!isDigit(c) && !(c >= 'A' && c <= 'Z'))
+      return false;
+  }
+  return true;
+}
 
-  switch(format)
+/* Replaces regular expression "^[\\d]{4}/[\\d]{2}/[\\d]{2}" */
+bool isNoaaDate(const QStringRef& line)
+{
+  if(line.size() < 10)
+    return false;
+
+  for(int i = 0; i < 10; i++)
   {
-    case atools::fs::weather::UNKNOWN:
-      break;
+    if(i == 4 || i == 7 ? line.at(i) != '/' : !isDigit(line.at(i)))
+      return false;
+  }
+  return true;
+}
+
+inline qint64 secondsSinceEpoch(const QDate& date, int hour, int minute)
+{
+  return (date.toJulianDay() - EPOCH_JULIAN_DAY) * 86400 + hour * 3600 + minute * 60;
+}
 
-    case atools::fs::weather::NOAA:
-    case atools::fs::weather::XPLANE:
-      return readNoaaXplane(stream, fileOrUrl, merge);
+/* Get seconds since epoch for a date line like "2017/10/29 11:45". Invalid if the format does not match. */
+qint64 noaaTimestamp(const QStringRef& line)
+{
+  if(line.size() != 16 || line.at(10) != ' ' || line.at(13) != ':' || !isDigit(line.at(11)) ||
+     !isDigit(line.at(12)) || !isDigit(line.at(14)) || !isDigit(line.at(15)))
+    return INVALID_TIMESTAMP;
+
+  QDate date(digits(line, 0, 4), digits(line, 5, 2), digits(line, 8, 2));
+  int hour = digits(line, 11, 2), minute = digits(line, 14, 2);
 
-      break;
+  if(!date.isValid() || hour > 23 || minute > 59)
+    return INVALID_TIMESTAMP;
 
-    case atools::fs::weather::FLAT:
-      return readFlat(stream, fileOrUrl, merge);
+  return secondsSinceEpoch(date, hour, minute);
+}
 
-      break;
+/* Get seconds since epoch for a day and time string like "100906Z". Month and year are taken from the latest
+ * date not after today which has the day. Invalid if the format does not match. */
+qint64 flatTimestamp(const QStringRef& dateStr, const QDate& today)
+{
+  if(dateStr.size() < 7 || dateStr.at(6) != 'Z')
+    return INVALID_TIMESTAMP;
+
+  for(int i = 0; i < 6; i++)
+  {
+    if(!isDigit(dateStr.at(i)))
+      return INVALID_TIMESTAMP;
   }
-  return 0;
+
+  int day = digits(dateStr, 0, 2), hour = digits(dateStr, 2, 2), minute = digits(dateStr, 4, 2);
+
+  // Go back month by month until the day exists and is not in the future but not more than one year
+  QDate month(today.year(), today.month(), 1);
+  for(int i = 0; i <= 12; i++, month = month.addMonths(-1))
+  {
+    QDate date(month.year(), month.month(), day);
+    if(date.isValid() && date <= today)
+      return secondsSinceEpoch(date, hour, minute);
+  }
+  return INVALID_TIMESTAMP;
 }
 
 // 2017/07/30 18:45
@@ -98,203 +251,284 @@ int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
 //
 // 2017/07/30 18:55
 // KPRO 301855Z AUTO 11003KT 10SM CLR 26/14 A3022 RMK AO2 T02570135
-//
-// 2017/07/30 18:47
-// KADS 301847Z 06005G14KT 13SM SKC 32/19 A3007
-int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bool merge)
+/* Parse lines [from, to) of NOAA or X-Plane format */
+void parseNoaaXplane(ParsedChunk& chunk, const QVector<QStringRef>& lines, int from, int to, const QDateTime& now,
+                     bool xplane)
 {
-  // Recognize METAR airport ident
-  static const QRegularExpression IDENT_REGEXP("^[A-Z0-9]{2,5}$");
+  qint64 nowSecs = now.toSecsSinceEpoch(), lastTimestamp = INVALID_TIMESTAMP;
 
-  // Recognize date part
-  static const QRegularExpression DATE_REGEXP("^[\\d]{4}/[\\d]{2}/[\\d]{2}");
-
-  if(!merge)
+  for(int i = from; i < to; i++)
   {
-    spatialIndex->clear();
-    identIndexMap.clear();
-  }
+    QStringRef line = lines.at(i).trimmed();
 
-  QDateTime latest, oldest;
-  QString latestIdent, oldestIdent;
-
-  int lineNum = 1;
-  QString line;
-  QDateTime lastTimestamp, now = QDateTime::currentDateTimeUtc();
-  int futureDates = 0, found = 0;
-
-  while(!stream.atEnd())
-  {
-    line = stream.readLine().trimmed();
+    // Ignore X-Plane's special coordinate format
+    if(line.size() < 4 || (xplane && (line.startsWith(QLatin1String("MDEG ")) || line.startsWith(QLatin1String("DEG ")))))
+      continue;
 
-    if(line.isEmpty())
+    if(isNoaaDate(line))
     {
-      lineNum++;
+      // Found line containing date like "2017/10/29 11:45"
+      lastTimestamp = noaaTimestamp(line);
       continue;
     }
 
-    if(format == XPLANE && (line.startsWith("MDEG ") || line.startsWith("DEG ")))
+    if(lastTimestamp != INVALID_TIMESTAMP && lastTimestamp > nowSecs)
     {
-      lineNum++;
-      // Ignore X-Plane's special coordinate format
+      // Ignore METARs with future UTC time
+      chunk.futureDates++;
       continue;
     }
 
-    if(line.size() >= 4)
-    {
+    int space = line.indexOf(' ');
+    QString ident = (space == -1 ? line : line.left(space)).toString().toUpper();
+    if(isIdent(QStringRef(&ident)))
+      // Found METAR line
+      chunk.metars.append({ident, line.toUtf8(), lastTimestamp});
+    else
+      chunk.invalidLines.append({i + 1, line.toString(), false});
+  }
+}
 
-      if(DATE_REGEXP.match(line).hasMatch())
-      {
-        // Found line containing date like "2017/10/29 11:45"
-        lastTimestamp = QDateTime::fromString(line, "yyyy/MM/dd hh:mm");
-        lastTimestamp.setTimeZone(QTimeZone::utc());
-        lineNum++;
-        continue;
-      }
+// KC99 100906Z AUTO 30022G42KT 10SM CLR M01/M04 A3035 RMK AO2
+// LCEN 100920Z 16004KT 090V230 CAVOK 31/10 Q1010 NOSIG
+/* Parse lines [from, to) of flat format like IVAO or VATSIM */
+void parseFlat(ParsedChunk& chunk, const QVector<QStringRef>& lines, int from, int to, const QDateTime& now)
+{
+  qint64 nowSecs = now.toSecsSinceEpoch();
+  QDate today = now.date();
 
-      if(lastTimestamp > now)
-      {
-        // Ignore METARs with future UTC time
-        futureDates++;
-        lineNum++;
-        continue;
-      }
+  for(int i = from; i < to; i++)
+  {
+    QString line = lines.at(i).toString().simplified().toUpper();
+    if(line.size() < 4)
+      continue;
 
-      QString ident = line.section(' ', 0, 0).simplified().toUpper();
-      if(IDENT_REGEXP.match(ident).hasMatch())
-      {
-        // Found METAR line
-        if(verbose)
-        {
-          if(!latest.isValid() || lastTimestamp > latest)
-          {
-            latest = lastTimestamp;
-            latestIdent = ident;
-          }
-          if(!oldest.isValid() || lastTimestamp < oldest)
-          {
-            oldest = lastTimestamp;
-            oldestIdent = ident;
-          }
-        }
+    int space = line.indexOf(' ');
+    QStringRef ident = line.leftRef(space);
+    QStringRef dateStr = space == -1 ? QStringRef() : line.midRef(space + 1, line.indexOf(' ', space + 1) - space - 1);
+
+    qint64 timestamp = flatTimestamp(dateStr, today);
+    if(timestamp == INVALID_TIMESTAMP)
+      chunk.invalidLines.append({i + 1, line, true});
+    else if(timestamp > nowSecs)
+      // Ignore METARs with future UTC time
+      chunk.futureDates++;
+    else if(isIdent(ident))
+      // Found METAR line
+      chunk.metars.append({ident.toString(), line.toUtf8(), timestamp});
+    else
+      chunk.invalidLines.append({i + 1, line, false});
+  }
+}
 
-        found++;
-        updateOrInsert(line, ident, lastTimestamp);
-      }
-      else
-        qWarning() << "Ident in METAR does not match in file/URL"
-                   << fileOrUrl << "line num" << lineNum << "line" << line;
-    }
-    lineNum++;
+} // namespace
+
+// ====================================================================================================
+MetarIndex::MetarIndex(MetarFormat formatParam, bool verboseLogging)
+  : verbose(verboseLogging), format(formatParam)
+{
+  spatialIndex = new atools::geo::SpatialIndex<MetarData>;
+  parsedCache = new QCache<quint64, QSharedPointer<const MetarParser> >(PARSED_CACHE_SIZE);
+  gridState = QSharedPointer<MetarGridState>(new MetarGridState);
+}
+
+MetarIndex::~MetarIndex()
+{
+  if(gridThreadPool != nullptr)
+  {
+    // Stop running build
+    gridState->generation.fetchAndAddOrdered(1);
+    gridThreadPool->clear();
+    gridThreadPool->waitForDone();
+    delete gridThreadPool;
   }
 
-  updateIndex();
+  delete spatialIndex;
+  delete parsedCache;
+}
 
-  if(verbose)
+void MetarIndex::setInterpolationGrid(bool enabled)
+{
+  if(interpolationGrid == enabled)
+    return;
+
+  interpolationGrid = enabled;
+  if(interpolationGrid)
+    startGridBuild();
+  else
+    resetGrid();
+}
+
+void MetarIndex::resetGrid()
+{
+  // Stop running build and drop grid
+  QMutexLocker locker(&gridState->mutex);
+  gridState->generation.fetchAndAddOrdered(1);
+  gridState->grid.reset();
+}
+
+MetarGridValue MetarIndex::getInterpolatedValue(const atools::geo::Pos& pos) const
+{
+  QSharedPointer<const MetarGrid> grid;
   {
-    qDebug() << "index->size()" << spatialIndex->size();
-    qDebug() << "metarMap.size()" << identIndexMap.size();
-    qDebug() << "found " << found << "futureDates " << futureDates;
-    qDebug() << "Latest" << latestIdent << latest;
-    qDebug() << "Oldest" << oldestIdent << oldest;
+    QMutexLocker locker(&gridState->mutex);
+    grid = gridState->grid;
   }
 
-  qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
-  return found;
+  return grid.isNull() ? MetarGridValue() : grid->getValue(pos);
 }
 
-// KC99 100906Z AUTO 30022G42KT 10SM CLR M01/M04 A3035 RMK AO2
-// LCEN 100920Z 16004KT 090V230 CAVOK 31/10 Q1010 NOSIG
-// GMFO 100930Z 34004KT 240V010 9999 FEW030 26/00 Q1017 NOSIG
-// KBLI 100922Z AUTO VRB04KT 10SM FEW017 FEW025 OVC037 13/11 A3015 RMK
-// AGGH 100900Z 16003KT 9999 FEW016 FEW017CB SCT300 27/25 Q1010
-// ANYN 100900Z 08005KT 9999 FEW020 27/23 Q1010
-// AYMH 100800Z 16015KT 9999 SHRA BKN090 18/16 Q1018 RMK
-int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool merge)
+void MetarIndex::startGridBuild()
 {
-  // Recognize METAR airport
-  static const QRegularExpression IDENT_REGEXP("^[A-Z0-9]{2,5}$");
+  if(spatialIndex->isEmpty())
+  {
+    resetGrid();
+    return;
+  }
 
-  // Recognize date part
-  static const QRegularExpression DATE_REGEXP("^[\\d]{6}Z");
+  int generation = gridState->generation.fetchAndAddOrdered(1) + 1;
 
-  if(!merge)
+  // Copy text and position of all stations which can be located
+  QVector<QPair<atools::geo::Pos, QString> > metars;
+  metars.reserve(spatialIndex->size());
+  for(const MetarData& data : *spatialIndex)
   {
-    spatialIndex->clear();
-    identIndexMap.clear();
+    if(data.pos.isValid())
+      metars.append(qMakePair(data.pos, metarText(data)));
   }
 
-  QDateTime latest, oldest;
-  QString latestIdent, oldestIdent;
+  if(gridThreadPool == nullptr)
+  {
+    // Own pool with one thread which runs only the latest build
+    gridThreadPool = new QThreadPool;
+    gridThreadPool->setMaxThreadCount(1);
+  }
 
-  int lineNum = 1;
-  QString line;
-  QDateTime lastTimestamp, now = QDateTime::currentDateTimeUtc();
-  int futureDates = 0, found = 0;
+  // Remove waiting builds which are outdated anyway
+  gridThreadPool->clear();
+  gridThreadPool->start(new MetarGridRunnable(gridState, metars, generation));
+}
 
-  while(!stream.atEnd())
+int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
+{
+  ATOOLS_TRACE_SCOPE("MetarIndex::read", "weather");
+
+  Q_ASSERT(format != UNKNOWN);
+  Q_ASSERT(fetchAirportCoords || fetchAirportCoordsBulk);
+
+  if(format == UNKNOWN)
+    return 0;
+
+  if(!merge)
+    clear();
+  parsedCache->clear();
+
+  // Split text into lines and lines into chunks at record boundaries ===========================
+  const QString text = stream.readAll();
+  QVector<QStringRef> lines;
+  lines.reserve(text.size() / 60);
+  int lineStart = 0;
+  for(int i = 0; i < text.size(); i++)
   {
-    line = stream.readLine().simplified().toUpper();
+    if(text.at(i) == '\n')
+    {
+      lines.append(text.midRef(lineStart, i - lineStart));
+      lineStart = i + 1;
+    }
+  }
+  if(lineStart < text.size())
+    lines.append(text.midRef(lineStart));
 
-    if(line.isEmpty())
+  QVector<int> chunkStarts({0});
+  int chunkLines = std::max(MIN_CHUNK_LINES, lines.size() / std::max(1, QThread::idealThreadCount()) + 1);
+  for(int start = chunkLines; start < lines.size(); start += chunkLines)
+  {
+    // NOAA and X-Plane chunks have to start with a date line since the date is valid for all following METARs
+    if(format == NOAA || format == XPLANE)
     {
-      lineNum++;
-      continue;
+      while(start < lines.size() && !isNoaaDate(lines.at(start).trimmed()))
+        start++;
     }
 
-    if(line.size() >= 4)
+    if(start < lines.size() && start > chunkStarts.constLast())
+      chunkStarts.append(start);
+  }
+  chunkStarts.append(lines.size());
+
+  // Parse chunks in parallel ===========================
+  const QDateTime now = QDateTime::currentDateTimeUtc();
+  QVector<ParsedChunk> chunks(chunkStarts.size() - 1);
+  atools::util::parallelFor(chunks.size(), [&](int i) {
+    if(format == FLAT)
+      parseFlat(chunks[i], lines, chunkStarts.at(i), chunkStarts.at(i + 1), now);
+    else
+      parseNoaaXplane(chunks[i], lines, chunkStarts.at(i), chunkStarts.at(i + 1), now, format == XPLANE);
+  });
+
+  // Merge results in file order ===========================
+  int found = 0, futureDates = 0, numNew = 0;
+  for(const ParsedChunk& chunk : chunks)
+  {
+    found += chunk.metars.size();
+    futureDates += chunk.futureDates;
+
+    if(merge)
     {
-      QString ident = line.section(' ', 0, 0).simplified().toUpper();
-      QString dateStr = line.section(' ', 1, 1).simplified().toUpper();
+      for(const ParsedMetar& metar : chunk.metars)
+      {
+        if(!identIndexMap.contains(packIdent(metar.ident)))
+          numNew++;
+      }
+    }
+  }
 
-      if(DATE_REGEXP.match(dateStr).hasMatch())
+  // Resolve coordinates of all stations not known from previous reads at once ===========================
+  QStringList unresolved;
+  QSet<quint64> unresolvedKeys;
+  for(const ParsedChunk& chunk : chunks)
+  {
+    for(const ParsedMetar& metar : chunk.metars)
+    {
+      quint64 key = packIdent(metar.ident);
+      if(!coordCache.contains(key) && !identIndexMap.contains(key) && !unresolvedKeys.contains(key))
       {
-        int day = dateStr.left(2).toInt();
-        QDate date = QDate(QDate::currentDate().year(), QDate::currentDate().month(), day);
+        unresolvedKeys.insert(key);
+        unresolved.append(metar.ident);
+      }
+    }
+  }
+  resolveAirportCoords(unresolved);
 
-        // Keep substracting months until it is not in the future and the day matches
-        // but not more than one year to avoid endless loops
-        int months = 0;
-        while((date > QDate::currentDate() || day != date.day()) && months < 12)
-          date = date.addMonths(-(++months));
+  // Add new stations to the existing index in place when merging and only a few stations are new.
+  // Updated stations keep their position. Otherwise build the index once at the end.
+  incremental = merge && !spatialIndex->isEmpty() && numNew < spatialIndex->size() / 4;
 
-        if(lastTimestamp > now)
+  qint64 latest = INVALID_TIMESTAMP, oldest = INVALID_TIMESTAMP;
+  QString latestIdent, oldestIdent;
+  for(const ParsedChunk& chunk : chunks)
+  {
+    for(const InvalidLine& invalid : chunk.invalidLines)
+      qWarning() << (invalid.badDate ? "Date" : "Ident") << "in METAR does not match in file/URL"
+                 << fileOrUrl << "line num" << invalid.lineNum << "line" << invalid.line;
+
+    for(const ParsedMetar& metar : chunk.metars)
+    {
+      if(verbose && metar.timestamp != INVALID_TIMESTAMP)
+      {
+        if(latest == INVALID_TIMESTAMP || metar.timestamp > latest)
         {
-          // Ignore METARs with future UTC time
-          futureDates++;
-          lineNum++;
-          continue;
+          latest = metar.timestamp;
+          latestIdent = metar.ident;
         }
-
-        if(IDENT_REGEXP.match(ident).hasMatch())
+        if(oldest == INVALID_TIMESTAMP || metar.timestamp < oldest)
         {
-          // Found METAR line
-          if(verbose)
-          {
-            if(!latest.isValid() || lastTimestamp > latest)
-            {
-              latest = lastTimestamp;
-              latestIdent = ident;
-            }
-            if(!oldest.isValid() || lastTimestamp < oldest)
-            {
-              oldest = lastTimestamp;
-              oldestIdent = ident;
-            }
-          }
-
-          found++;
-          updateOrInsert(line, ident, lastTimestamp);
+          oldest = metar.timestamp;
+          oldestIdent = metar.ident;
         }
-        else
-          qWarning() << "Ident in METAR does not match in file/URL"
-                     << fileOrUrl << "line num" << lineNum << "line" << line;
       }
-      else
-        qWarning() << "Date in METAR does not match in file/URL"
-                   << fileOrUrl << "line num" << lineNum << "line" << line;
+
+      updateOrInsert(metar.metar, metar.ident, metar.timestamp);
     }
-    lineNum++;
   }
 
   updateIndex();
@@ -303,42 +537,150 @@ int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool mer
   {
     qDebug() << "index->size()" << spatialIndex->size();
     qDebug() << "metarMap.size()" << identIndexMap.size();
-    qDebug() << "found " << found << "futureDates " << futureDates;
-    qDebug() << "Latest" << latestIdent << latest;
-    qDebug() << "Oldest" << oldestIdent << oldest;
+    qDebug() << "found " << found << "futureDates " << futureDates << "chunks" << chunks.size();
+    qDebug() << "Latest" << latestIdent << QDateTime::fromSecsSinceEpoch(latest, Qt::UTC);
+    qDebug() << "Oldest" << oldestIdent << QDateTime::fromSecsSinceEpoch(oldest, Qt::UTC);
   }
 
+  if(interpolationGrid)
+    startGridBuild();
+
   qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
   return found;
 }
 
-void MetarIndex::updateOrInsert(const QString& metar, const QString& ident, const QDateTime& lastTimestamp)
+void MetarIndex::updateOrInsert(const QByteArray& metar, const QString& ident, qint64 timestamp)
 {
-  int idx = identIndexMap.value(ident, -1);
+  quint64 key = packIdent(ident);
+
+  int idx = identIndexMap.value(key, -1);
   if(idx != -1)
   {
     // Already in list - get writeable reference to entry
     MetarData& md = (*spatialIndex)[idx];
-    if(!md.timestamp.isValid() || md.timestamp < lastTimestamp)
+    if(md.timestamp == INVALID_TIMESTAMP || md.timestamp < timestamp)
     {
-      // This one is newer - update
-      md.metar = metar;
-      md.timestamp = lastTimestamp;
+      // This one is newer - update and leave old text in buffer until compaction
+      unusedBufferBytes += md.length;
+      md.offset = metarBuffer.size();
+      md.length = metar.size();
+      md.timestamp = timestamp;
+      metarBuffer.append(metar);
     }
     // else leave as is
   }
   else
   {
     // Insert new record
-    spatialIndex->append(MetarData(ident, metar, lastTimestamp, fetchAirportCoords(ident)));
-    identIndexMap.insert(ident, spatialIndex->size() - 1);
+    MetarData data;
+    data.ident = key;
+    data.timestamp = timestamp;
+    data.offset = metarBuffer.size();
+    data.length = metar.size();
+    data.pos = coordCache.value(key);
+    metarBuffer.append(metar);
+
+    if(incremental)
+      spatialIndex->insert(data);
+    else
+      spatialIndex->append(data);
+    identIndexMap.insert(key, spatialIndex->size() - 1);
   }
 }
 
+void MetarIndex::resolveAirportCoords(const QStringList& idents)
+{
+  if(idents.isEmpty())
+    return;
+
+  if(fetchAirportCoordsBulk)
+  {
+    QHash<QString, atools::geo::Pos> coords;
+    coords.reserve(idents.size());
+    fetchAirportCoordsBulk(idents, coords);
+
+    // Remember unknown stations too
+    for(const QString& ident : idents)
+      coordCache.insert(packIdent(ident), coords.value(ident));
+  }
+  else if(fetchAirportCoords)
+  {
+    for(const QString& ident : idents)
+      coordCache.insert(packIdent(ident), fetchAirportCoords(ident));
+  }
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "resolved" << idents.size() << "cached" << coordCache.size();
+}
+
+void MetarIndex::compactBuffer()
+{
+  if(unusedBufferBytes < metarBuffer.size() / 2)
+    return;
+
+  QByteArray buffer;
+  buffer.reserve(metarBuffer.size() - unusedBufferBytes);
+  for(MetarData& data : *spatialIndex)
+  {
+    int offset = buffer.size();
+    buffer.append(metarBuffer.constData() + data.offset, data.length);
+    data.offset = offset;
+  }
+  metarBuffer.swap(buffer);
+  unusedBufferBytes = 0;
+}
+
+QString MetarIndex::metarText(const MetarData& data) const
+{
+  return data.isValid() ? QString::fromUtf8(metarBuffer.constData() + data.offset, data.length) : QString();
+}
+
+QSharedPointer<const MetarParser> MetarIndex::getParsedMetar(const QString& station)
+{
+  quint64 key = packIdent(station);
+  QSharedPointer<const MetarParser> *cached = parsedCache->object(key);
+  if(cached != nullptr)
+    return *cached;
+
+  MetarData data = metarData(station);
+  if(!data.isValid())
+    return QSharedPointer<const MetarParser>();
+
+  QSharedPointer<const MetarParser> parsed;
+  try
+  {
+    parsed.reset(new MetarParser(metarText(data)));
+  }
+  catch(const std::exception& e)
+  {
+    qWarning() << "Exception while parsing metar" << metarText(data) << ":" << e.what();
+    parsed.reset(new MetarParser(QString()));
+  }
+
+  parsedCache->insert(key, new QSharedPointer<const MetarParser>(parsed));
+  return parsed;
+}
+
+MetarSummary MetarIndex::getMetarSummary(const QString& station) const
+{
+  int idx = identIndexMap.value(packIdent(station), -1);
+  if(idx == -1)
+    return MetarSummary();
+
+  const MetarData& data = spatialIndex->at(idx);
+  return MetarSummary(metarBuffer.constData() + data.offset, data.length);
+}
+
 void MetarIndex::clear()
 {
   spatialIndex->clear();
   identIndexMap.clear();
+  metarBuffer.clear();
+  unusedBufferBytes = 0;
+  parsedCache->clear();
+
+  if(interpolationGrid)
+    resetGrid();
 }
 
 bool MetarIndex::isEmpty() const
@@ -357,7 +699,7 @@ atools::fs::weather::MetarResult MetarIndex::getMetar(const QString& station, co
   result.init(station, pos);
 
   if(!station.isEmpty())
-    result.metarForStation = metarData(station).metar;
+    result.metarForStation = metarText(metarData(station));
 
   if(result.metarForStation.isEmpty() && pos.isValid())
   {
@@ -366,37 +708,50 @@ atools::fs::weather::MetarResult MetarIndex::getMetar(const QString& station, co
     if(data.isValid())
     {
       // Found a METAR
-      if(data.ident == station)
+      if(data.ident == packIdent(station))
       {
         // Found exact match
-        result.metarForStation = data.metar;
+        result.metarForStation = metarText(data);
 
         if(station.isEmpty())
-          result.requestIdent = data.ident;
+          result.requestIdent = unpackIdent(data.ident);
       }
       else
       {
         // Found a station nearby
-        result.metarForNearest = data.metar;
+        result.metarForNearest = metarText(data);
 
         if(station.isEmpty())
-          result.requestIdent = data.ident;
+          result.requestIdent = unpackIdent(data.ident);
       }
     }
   }
 
+  if(interpolationGrid && pos.isValid())
+  {
+    MetarGridValue value = getInterpolatedValue(pos);
+    if(value.isValid())
+      result.metarForInterpolated = value.toMetarString(result.requestIdent.isEmpty() ? "XXXX" : result.requestIdent,
+                                                        QDateTime::currentDateTimeUtc());
+  }
+
   return result;
 }
 
 void MetarIndex::updateIndex()
 {
   Q_ASSERT(spatialIndex->size() == identIndexMap.size());
-  spatialIndex->updateIndex();
+
+  compactBuffer();
+
+  // Index is already up to date if stations were inserted incrementally
+  if(!incremental)
+    spatialIndex->updateIndex();
 }
 
 MetarData MetarIndex::metarData(const QString& ident)
 {
-  int idx = identIndexMap.value(ident, -1);
+  int idx = identIndexMap.value(packIdent(ident), -1);
 
   if(idx != -1)
     return spatialIndex->at(idx);
@@ -18,9 +18,14 @@
 #ifndef ATOOLS_METARINDEX_H
 #define ATOOLS_METARINDEX_H
 
+#include "fs/weather/metarsummary.h"
 #include "fs/weather/weathertypes.h"
 
+#include <QCache>
+#include <QSharedPointer>
+
 class QTextStream;
+class QThreadPool;
 
 namespace atools {
 
@@ -33,6 +38,9 @@ namespace weather {
 
 struct MetarResult;
 struct MetarData;
+class MetarParser;
+struct MetarGridState;
+struct MetarGridValue;
 
 /*
  * Reads, caches and indexes (by position) METAR reports in NOAA style as also used by X-Plane.
@@ -53,6 +61,11 @@ struct MetarData;
  *
  * KC99 100906Z AUTO 30022G42KT 10SM CLR M01/M04 A3035 RMK AO2
  * LCEN 100920Z 16004KT 090V230 CAVOK 31/10 Q1010 NOSIG
+ *
+ * Stations are stored compact with packed idents, epoch second timestamps and all METAR text in one contiguous
+ * UTF-8 buffer. METARs are parsed only on request and the parsed results are kept in a small LRU cache.
+ *
+ * Optionally builds a global grid of interpolated weather in the background after each read.
  */
 class MetarIndex
 {
@@ -62,6 +75,7 @@ public:
 
   /* Read METARs from stream and add them to the index. Merges into current list or clears list before.
    * Older of duplicates are ignored/removed.
+   * The text is split into chunks at record boundaries which are parsed in parallel.
    * Returns number of METARs read. */
   int read(QTextStream& stream, const QString& fileName, bool merge);
 
@@ -78,40 +92,111 @@ public:
    * Also keeps position and ident of original request.*/
   atools::fs::weather::MetarResult getMetar(const QString& station, const atools::geo::Pos& pos);
 
-  /* Set to a function that returns the coordinates for an airport ident. Needed to find the nearest. */
+  /* Get parsed METAR for station. Null if station is not available. Parsed results are cached until the next read. */
+  QSharedPointer<const atools::fs::weather::MetarParser> getParsedMetar(const QString& station);
+
+  /* Get flight rules, wind and ceiling for station without allocations. Invalid if station is not available.
+   * Much faster than getParsedMetar() when processing many stations. */
+  atools::fs::weather::MetarSummary getMetarSummary(const QString& station) const;
+
+  /* Enable the precomputed grid of interpolated weather which is built in a background thread after each read.
+   * getMetar() fills metarForInterpolated from the grid if enabled and the grid is ready. Disabled by default. */
+  void setInterpolationGrid(bool enabled);
+
+  bool isInterpolationGrid() const
+  {
+    return interpolationGrid;
+  }
+
+  /* Get interpolated weather at position with one grid lookup. Invalid if the grid is disabled or not ready yet. */
+  atools::fs::weather::MetarGridValue getInterpolatedValue(const atools::geo::Pos& pos) const;
+
+  /* Set to a function that returns the coordinates for an airport ident. Needed to find the nearest.
+   * Clears the coordinate cache. */
   void setFetchAirportCoords(const std::function<atools::geo::Pos(const QString&)>& value)
   {
     fetchAirportCoords = value;
+    coordCache.clear();
+  }
+
+  /* Set to a function that returns the coordinates for a list of airport idents. Used instead of
+   * fetchAirportCoords if set. Called once per read for all stations without cached coordinates.
+   * Clears the coordinate cache. */
+  void setFetchAirportCoordsBulk(const atools::fs::weather::FetchAirportCoordsBulkFunc& value)
+  {
+    fetchAirportCoordsBulk = value;
+    coordCache.clear();
+  }
+
+  /* Coordinates of stations are cached across reads and clear(). Call this if the airport coordinates
+   * change, e.g. after switching the simulator database. Positions of stations already in the index are kept. */
+  void clearAirportCoordsCache()
+  {
+    coordCache.clear();
   }
 
 private:
-  /* Get a METAR string. Empty if not available */
+  /* Get a METAR entry. Invalid if not available */
   MetarData metarData(const QString& ident);
 
-  /* Read NOAA or XPLANE format */
-  int readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bool merge);
+  /* Get METAR text for entry from buffer */
+  QString metarText(const MetarData& data) const;
 
-  /* Read flat file format like IVAO or VATSIM */
-  int readFlat(QTextStream& stream, const QString& fileOrUrl, bool merge);
+  /* Rebuild text buffer if more than half of it is occupied by replaced METARs */
+  void compactBuffer();
 
   /* Copy airports from the complete list to the index with coordinates.
    * Copies only airports that exist in the current simulator database, i.e. where fetchAirportCoords returns
    * a valid coordinate. */
   void updateIndex();
 
-  /* Update or insert a METAR entry */
-  void updateOrInsert(const QString& metar, const QString& ident, const QDateTime& lastTimestamp);
+  /* Collect METARs with valid positions and start building the interpolation grid in the background.
+   * Cancels a running build. */
+  void startGridBuild();
+
+  /* Cancel running build and remove grid */
+  void resetGrid();
+
+  /* Update or insert a METAR entry. Position is taken from the coordinate cache. */
+  void updateOrInsert(const QByteArray& metar, const QString& ident, qint64 timestamp);
+
+  /* Get coordinates for idents using the bulk or single callback and add them to the coordinate cache */
+  void resolveAirportCoords(const QStringList& idents);
 
   /* Callback to get airport coodinates by ICAO ident */
   std::function<atools::geo::Pos(const QString&)> fetchAirportCoords;
+  atools::fs::weather::FetchAirportCoordsBulkFunc fetchAirportCoordsBulk;
+
+  /* Resolved positions by packed ident. Includes invalid positions for unknown stations to avoid repeated lookups.
+   * Not cleared with the METARs. */
+  QHash<quint64, atools::geo::Pos> coordCache;
 
-  /* Map containing all found METARs airport idents mapped to the position in the spatial index */
-  QHash<QString, int> identIndexMap;
+  /* Map containing all found METARs packed airport idents mapped to the position in the spatial index */
+  QHash<quint64, int> identIndexMap;
+
+  /* UTF-8 text of all METARs. Entries refer to it by offset and length. */
+  QByteArray metarBuffer;
+
+  /* Bytes in buffer used by replaced METARs */
+  int unusedBufferBytes = 0;
+
+  /* Parsed METARs by packed ident */
+  QCache<quint64, QSharedPointer<const atools::fs::weather::MetarParser> > *parsedCache = nullptr;
 
   /* Index containing all stations. Stations without valid position will be located at x/y/z = 0/0/0 and therfore
    * not considered in the index. */
   atools::geo::SpatialIndex<MetarData> *spatialIndex = nullptr;
 
+  /* Current interpolation grid shared with the background build task */
+  QSharedPointer<atools::fs::weather::MetarGridState> gridState;
+
+  /* Runs one grid build at a time */
+  QThreadPool *gridThreadPool = nullptr;
+  bool interpolationGrid = false;
+
+  /* true if the current read merges new stations into the existing index without rebuilding it */
+  bool incremental = false;
+
   bool verbose = false;
   atools::fs::weather::MetarFormat format = atools::fs::weather::UNKNOWN;
 
@@ -564,18 +564,7 @@ void MetarParser::postProcess()
     }
   }
 
-  // Calculate the flight rules depending on ceiling and visiblity
-  float ceilingFt = atools::geo::meterToFeet(minAltitudeMeter);
-  float visibilityMi = atools::geo::meterToMi(getMinVisibility().getVisibilityMeter());
-
-  if(visibilityMi < 1.f || ceilingFt < 500.f)
-    flightRules = LIFR;
-  else if(visibilityMi < 3.f || ceilingFt < 1000.f)
-    flightRules = IFR;
-  else if(visibilityMi <= 5.f || ceilingFt <= 3000.f)
-    flightRules = MVFR;
-  else
-    flightRules = VFR;
+  flightRules = calculateFlightRules(getMinVisibility().getVisibilityMeter(), minAltitudeMeter);
 
   if(getWindDir() >= 0)
     prevailingWindDir = getWindDir();
@@ -593,6 +582,22 @@ void MetarParser::postProcess()
   prevailingWindSpeed = getWindSpeedMeterPerSec();
 }
 
+MetarParser::FlightRules MetarParser::calculateFlightRules(float visibilityMeter, float ceilingMeter)
+{
+  // Calculate the flight rules depending on ceiling and visiblity
+  float ceilingFt = atools::geo::meterToFeet(ceilingMeter);
+  float visibilityMi = atools::geo::meterToMi(visibilityMeter);
+
+  if(visibilityMi < 1.f || ceilingFt < 500.f)
+    return LIFR;
+  else if(visibilityMi < 3.f || ceilingFt < 1000.f)
+    return IFR;
+  else if(visibilityMi <= 5.f || ceilingFt <= 3000.f)
+    return MVFR;
+  else
+    return VFR;
+}
+
 QString MetarParser::getReportTypeString() const
 {
   ReportType t = static_cast<ReportType>(_report_type);
@@ -489,6 +489,9 @@ public:
   QString getFlightRulesStringLong() const;
   QString getFlightRulesString() const;
 
+  /* Flight rules for minimum visibility and ceiling. Values can be INVALID_METAR_VALUE if not given. */
+  static FlightRules calculateFlightRules(float visibilityMeter, float ceilingMeter);
+
   /* Direction might be average of varable wind */
   int getPrevailingWindDir() const
   {
@@ -0,0 +1,362 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/weather/metarsummary.h"
+
+#include <cstring>
+
+namespace atools {
+namespace fs {
+namespace weather {
+
+namespace {
+
+const float KT_TO_MPS = 0.5144444444f;
+const float KMH_TO_MPS = 0.2777777778f;
+const float SM_TO_METER = 1609.3412196f;
+const float FEET_TO_METER = 0.3048f;
+
+/* Points into the METAR text. Not null terminated. */
+struct Group
+{
+  const char *str = nullptr;
+  int len = 0;
+
+  bool equals(const char *text) const
+  {
+    return static_cast<int>(std::strlen(text)) == len && std::strncmp(str, text, len) == 0;
+  }
+
+  bool startsWith(const char *text, int pos = 0) const
+  {
+    int textLen = static_cast<int>(std::strlen(text));
+    return pos + textLen <= len && std::strncmp(str + pos, text, textLen) == 0;
+  }
+
+  bool isDigit(int pos) const
+  {
+    return pos < len && str[pos] >= '0' && str[pos] <= '9';
+  }
+
+};
+
+/* Splits text into space separated groups */
+class GroupScanner
+{
+public:
+  GroupScanner(const char *text, int size)
+    : pos(text), end(text + size)
+  {
+  }
+
+  bool next(Group& group)
+  {
+    while(pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n'))
+      pos++;
+
+    if(pos >= end)
+      return false;
+
+    group.str = pos;
+    while(pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n')
+      pos++;
+    group.len = static_cast<int>(pos - group.str);
+    return true;
+  }
+
+  /* Get next group without consuming it */
+  bool peek(Group& group) const
+  {
+    GroupScanner copy(*this);
+    return copy.next(group);
+  }
+
+private:
+  const char *pos, *end;
+};
+
+/* Read between min and max digits at pos. Returns number of digits or 0 if less than min. */
+int scanNumber(const Group& group, int& pos, int& num, int min, int max)
+{
+  int i = 0, value = 0, cur = pos;
+  for(; i < max && group.isDigit(cur); i++, cur++)
+    value = value * 10 + (group.str[cur] - '0');
+
+  if(i < min)
+    return 0;
+
+  num = value;
+  pos = cur;
+  return i;
+}
+
+// \d\d\d\d/\d\d/\d\d
+bool isPreambleDate(const Group& group)
+{
+  int pos = 0, num;
+  return group.len == 10 && scanNumber(group, pos, num, 4, 4) && group.str[pos++] == '/' &&
+         scanNumber(group, pos, num, 2, 2) && group.str[pos++] == '/' && scanNumber(group, pos, num, 2, 2);
+}
+
+// \d\d:\d\d
+bool isPreambleTime(const Group& group)
+{
+  int pos = 0, num;
+  return group.len == 5 && scanNumber(group, pos, num, 2, 2) && group.str[pos++] == ':' &&
+         scanNumber(group, pos, num, 2, 2);
+}
+
+// [A-Z0-9]{1,4}
+bool isIdent(const Group& group)
+{
+  if(group.len < 1 || group.len > 4)
+    return false;
+
+  for(int i = 0; i < group.len; i++)
+  {
+    char c = group.str[i];
+    if(!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')))
+      return false;
+  }
+  return true;
+}
+
+// \d{6}Z
+bool isDate(const Group& group)
+{
+  int pos = 0, num;
+  return group.len == 7 && scanNumber(group, pos, num, 6, 6) && group.str[pos] == 'Z';
+}
+
+// (\d{3}|VRB|///)(\d{2,3}|//)(G\d{2,3})?(KT|KMH|KPH|MPS)
+bool scanWind(const Group& group, int& dir, float& speed, float& gust)
+{
+  int pos = 0, windDir = -1, windSpeed = -1, windGust = -1;
+  if(group.startsWith("VRB") || group.startsWith("///"))
+    pos += 3;
+  else if(!scanNumber(group, pos, windDir, 3, 3))
+    return false;
+
+  if(group.startsWith("//", pos))
+    pos += 2;
+  else if(!scanNumber(group, pos, windSpeed, 2, 3))
+    return false;
+
+  if(pos < group.len && group.str[pos] == 'G')
+  {
+    pos++;
+    if(!scanNumber(group, pos, windGust, 2, 3))
+      return false;
+  }
+
+  float factor;
+  if(group.startsWith("KT", pos))
+    pos += 2, factor = KT_TO_MPS;
+  else if(group.startsWith("KMH", pos) || group.startsWith("KPH", pos))
+    pos += 3, factor = KMH_TO_MPS;
+  else if(group.startsWith("MPS", pos))
+    pos += 3, factor = 1.f;
+  else
+    return false;
+
+  if(pos != group.len)
+    return false;
+
+  dir = windDir;
+  speed = windSpeed == -1 ? INVALID_METAR_VALUE : windSpeed * factor;
+  gust = windGust == -1 ? INVALID_METAR_VALUE : windGust * factor;
+  return true;
+}
+
+// \d{3}V\d{3}
+bool scanVariability(const Group& group, int& from, int& to)
+{
+  int pos = 0;
+  return group.len == 7 && scanNumber(group, pos, from, 3, 3) && group.str[pos++] == 'V' &&
+         scanNumber(group, pos, to, 3, 3);
+}
+
+// \d{4}(N|NE|E|SE|S|SW|W|NW|NDV)?
+// Returns false if not a visibility and sets distance to invalid for directional visibility
+bool scanVisibilityMeter(const Group& group, float& distance)
+{
+  int pos = 0, num;
+  if(!scanNumber(group, pos, num, 4, 4))
+    return false;
+
+  const char *suffix = group.str + pos;
+  int suffixLen = group.len - pos;
+  if(suffixLen == 0 || (suffixLen == 3 && std::strncmp(suffix, "NDV", 3) == 0))
+    distance = num == 0 ? 50.f : (num == 9999 ? 10000.f : num);
+  else if((suffixLen == 1 && std::strchr("NESW", suffix[0]) != nullptr) ||
+          (suffixLen == 2 && std::strchr("NS", suffix[0]) != nullptr && std::strchr("EW", suffix[1]) != nullptr))
+    distance = INVALID_METAR_VALUE;
+  else
+    return false;
+
+  return true;
+}
+
+// M?(\d{1,2}|\d{1,2}/\d{1,2})(SM|KM) with an optional whole number in the previous group
+bool scanVisibilityDistance(const Group& group, float& distance)
+{
+  int pos = 0, num, denom;
+  if(pos < group.len && (group.str[pos] == 'M' || group.str[pos] == 'P'))
+    pos++;
+
+  if(!scanNumber(group, pos, num, 1, 2))
+    return false;
+
+  float value = num;
+  if(pos < group.len && group.str[pos] == '/')
+  {
+    pos++;
+    if(!scanNumber(group, pos, denom, 1, 2) || denom == 0)
+      return false;
+    value /= denom;
+  }
+
+  if(group.len - pos != 2)
+    return false;
+
+  if(group.startsWith("SM", pos))
+    distance = value * SM_TO_METER;
+  else if(group.startsWith("KM", pos))
+    distance = value * 1000.f;
+  else
+    return false;
+
+  return true;
+}
+
+// \d{1,2}
+bool scanWholeNumber(const Group& group, int& num)
+{
+  int pos = 0;
+  return scanNumber(group, pos, num, 1, 2) && pos == group.len;
+}
+
+// (FEW|SCT|BKN|OVC)\d{2,3}.*
+bool scanCloud(const Group& group, bool& ceiling, float& altitudeMeter)
+{
+  if(group.startsWith("BKN") || group.startsWith("OVC"))
+    ceiling = true;
+  else if(group.startsWith("FEW") || group.startsWith("SCT"))
+    ceiling = false;
+  else
+    return false;
+
+  int pos = 3, num;
+  altitudeMeter = scanNumber(group, pos, num, 2, 3) ? num * 100.f * FEET_TO_METER : INVALID_METAR_VALUE;
+  return true;
+}
+
+/* Groups which end the scan */
+bool isEnd(const Group& group)
+{
+  return group.equals("RMK") || group.equals("TEMPO") || group.equals("BECMG") || group.equals("NIL") ||
+         group.startsWith("PROB");
+}
+
+} // namespace
+
+MetarSummary::MetarSummary(const char *metar, int size)
+{
+  GroupScanner scanner(metar, size);
+  Group group;
+
+  // Header ===================================
+  if(!scanner.next(group))
+    return;
+
+  // NOAA preamble
+  if(isPreambleDate(group) && !scanner.next(group))
+    return;
+
+  if(isPreambleTime(group) && !scanner.next(group))
+    return;
+
+  if((group.equals("METAR") || group.equals("SPECI")) && !scanner.next(group))
+    return;
+
+  if(!isIdent(group) || !scanner.next(group) || !isDate(group))
+    return;
+
+  valid = true;
+
+  // Body ===================================
+  bool windFound = false, lastWasWind = false, cloudFound = false;
+  int rangeFrom = -1, rangeTo = -1;
+
+  while(scanner.next(group))
+  {
+    if(isEnd(group))
+      break;
+
+    bool wasWind = lastWasWind;
+    lastWasWind = false;
+    float value;
+    bool isCeiling;
+    int whole;
+    Group fraction;
+
+    if(!windFound && scanWind(group, windDir, windSpeed, gustSpeed))
+      windFound = lastWasWind = true;
+    else if(wasWind && scanVariability(group, rangeFrom, rangeTo))
+      ;
+    else if(group.equals("CAVOK"))
+      cavok = true;
+    else if(!cloudFound && scanVisibilityMeter(group, value))
+    {
+      if(value < INVALID_METAR_VALUE && !(visibilityMeter < INVALID_METAR_VALUE))
+        visibilityMeter = value;
+    }
+    else if(!cloudFound && scanVisibilityDistance(group, value))
+    {
+      if(!(visibilityMeter < INVALID_METAR_VALUE))
+        visibilityMeter = value;
+    }
+    else if(!cloudFound && scanWholeNumber(group, whole) && scanner.peek(fraction) &&
+            std::memchr(fraction.str, '/', fraction.len) != nullptr && scanVisibilityDistance(fraction, value))
+    {
+      // Whole number followed by fraction like "1 1/2SM"
+      scanner.next(fraction);
+      if(!(visibilityMeter < INVALID_METAR_VALUE))
+        visibilityMeter = value + whole * (fraction.startsWith("KM", fraction.len - 2) ? 1000.f : SM_TO_METER);
+    }
+    else if(scanCloud(group, isCeiling, value))
+    {
+      cloudFound = true;
+      if(isCeiling && value < ceilingMeter)
+        ceilingMeter = value;
+    }
+  }
+
+  // Average of variable wind if no direction is given
+  if(windDir < 0 && rangeFrom != -1 && rangeTo != -1)
+  {
+    int to = rangeFrom < rangeTo ? rangeTo : rangeTo + 360;
+    windDir = (rangeFrom + (to - rangeFrom) / 2) % 360;
+  }
+
+  flightRules = MetarParser::calculateFlightRules(visibilityMeter, ceilingMeter);
+}
+
+} // namespace weather
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,116 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_METARSUMMARY_H
+#define ATOOLS_METARSUMMARY_H
+
+#include "fs/weather/metarparser.h"
+
+namespace atools {
+namespace fs {
+namespace weather {
+
+/*
+ * Lightweight partial METAR parser which extracts only flight rules, wind, visibility and ceiling.
+ * Scans the text once without allocating memory and is meant for bulk use like coloring thousands of
+ * airports on the map. Use MetarParser for all other information.
+ *
+ * Covers the subset of the METAR grammar used by MetarParser::getFlightRules():
+ * optional NOAA preamble, METAR/SPECI, ident, date, wind, variable wind, visibility in meter, SM or KM,
+ * CAVOK and cloud layers. Scanning stops at remarks and trend forecasts.
+ *
+ * Units are the same as in MetarParser. Missing values are INVALID_METAR_VALUE or -1 for directions.
+ */
+class MetarSummary
+{
+public:
+  MetarSummary()
+  {
+  }
+
+  /* Scan UTF-8 or Latin-1 METAR text. Text does not need to be null terminated. */
+  MetarSummary(const char *metar, int size);
+
+  explicit MetarSummary(const QByteArray& metar)
+    : MetarSummary(metar.constData(), metar.size())
+  {
+  }
+
+  /* Scan METAR text. Converts to Latin-1 which needs one allocation. */
+  explicit MetarSummary(const QString& metar)
+    : MetarSummary(metar.toLatin1())
+  {
+  }
+
+  /* true if ident and date were found */
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  MetarParser::FlightRules getFlightRules() const
+  {
+    return flightRules;
+  }
+
+  /* Wind direction or average of variable wind in degree true. -1 if not given or variable. */
+  int getPrevailingWindDir() const
+  {
+    return windDir;
+  }
+
+  float getWindSpeedMeterPerSec() const
+  {
+    return windSpeed;
+  }
+
+  float getGustSpeedMeterPerSec() const
+  {
+    return gustSpeed;
+  }
+
+  /* First visibility without direction */
+  float getMinVisibilityMeter() const
+  {
+    return visibilityMeter;
+  }
+
+  /* Lowest broken or overcast layer */
+  float getCeilingMeter() const
+  {
+    return ceilingMeter;
+  }
+
+  bool isCavok() const
+  {
+    return cavok;
+  }
+
+private:
+  bool valid = false, cavok = false;
+  MetarParser::FlightRules flightRules = MetarParser::UNKNOWN;
+  int windDir = -1;
+  float windSpeed = INVALID_METAR_VALUE, gustSpeed = INVALID_METAR_VALUE, visibilityMeter = INVALID_METAR_VALUE,
+        ceilingMeter = INVALID_METAR_VALUE;
+};
+
+} // namespace weather
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_METARSUMMARY_H
@@ -26,11 +26,15 @@ namespace weather {
 
 using atools::util::HttpDownloader;
 
+/* Cycle files are considered final and not downloaded again this number of seconds after the cycle hour */
+static const int FINAL_CYCLE_SECONDS = 5400;
+
 NoaaWeatherDownloader::NoaaWeatherDownloader(QObject *parent, bool verbose)
   : WeatherDownloadBase(parent, atools::fs::weather::NOAA, verbose)
 {
   connect(downloader, &HttpDownloader::downloadFinished, this, &NoaaWeatherDownloader::downloadFinished);
   connect(downloader, &HttpDownloader::downloadFailed, this, &NoaaWeatherDownloader::downloadFailed);
+  connect(downloader, &HttpDownloader::downloadNotModified, this, &NoaaWeatherDownloader::downloadNotModified);
 
   // Use own timer for recurring updates since the one in HttpDownloader cannot be used here
   updateTimer.setSingleShot(true);
@@ -85,6 +89,8 @@ void NoaaWeatherDownloader::downloadFinished(const QByteArray& data, QString url
   if(verbose)
     qDebug() << Q_FUNC_INFO << "url" << url << "downloadQueue" << downloadQueue;
 
+  cycleDownloaded();
+
   if(read(data, url) && downloadQueue.isEmpty())
     // Notification only if no outstanding downloads
     emit weatherUpdated();
@@ -96,6 +102,30 @@ void NoaaWeatherDownloader::downloadFinished(const QByteArray& data, QString url
   QTimer::singleShot(0, this, &NoaaWeatherDownloader::download);
 }
 
+void NoaaWeatherDownloader::downloadNotModified(QString url)
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "url" << url << "downloadQueue" << downloadQueue;
+
+  cycleDownloaded();
+
+  // Index is up to date for this file
+  if(downloadQueue.isEmpty())
+    startTimer();
+
+  // Start later in the event queue to allow the download to finish
+  QTimer::singleShot(0, this, &NoaaWeatherDownloader::download);
+}
+
+void NoaaWeatherDownloader::cycleDownloaded()
+{
+  QString url = downloader->getUrl();
+  QDateTime cycle = jobCycles.take(url);
+
+  if(cycle.isValid() && cycle.secsTo(QDateTime::currentDateTimeUtc()) >= FINAL_CYCLE_SECONDS)
+    finalCycles.insert(url, cycle);
+}
+
 void NoaaWeatherDownloader::downloadFailed(const QString& error, int errorCode, QString url)
 {
   if(verbose)
@@ -104,6 +134,7 @@ void NoaaWeatherDownloader::downloadFailed(const QString& error, int errorCode,
   emit weatherDownloadFailed(error, errorCode, url);
 
   downloadQueue.clear();
+  jobCycles.clear();
 
   startTimer();
 
@@ -132,7 +163,11 @@ void NoaaWeatherDownloader::startDownload()
     appendJob(datetime, startOffset--); // UTC - current
     appendJob(datetime, startOffset--); // UTC - 1 hour - older which might be still populated
 
-    download();
+    if(downloadQueue.isEmpty())
+      // All files are final - check again later
+      startTimer();
+    else
+      download();
   }
 }
 
@@ -141,9 +176,20 @@ void NoaaWeatherDownloader::appendJob(QDateTime datetime, int timeOffsetHour)
   datetime = datetime.addSecs(timeOffsetHour * 3600);
   QString url = baseUrl.arg(datetime.time().hour(), 2, 10, QChar('0'));
 
+  // Skip files which were already downloaded completely for this cycle
+  if(finalCycles.value(url) == datetime)
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "Skipping final" << url;
+    return;
+  }
+
   // Do not append duplicates
   if(!downloadQueue.contains(url))
+  {
     downloadQueue.append(url);
+    jobCycles.insert(url, datetime);
+  }
 }
 
 void NoaaWeatherDownloader::download()
@@ -20,6 +20,8 @@
 
 #include "fs/weather/weatherdownloadbase.h"
 
+#include <QDateTime>
+#include <QHash>
 #include <QTimer>
 
 namespace atools {
@@ -39,6 +41,7 @@ struct MetarResult;
 /*
  * Downloads the three latest METAR files from https://tgftp.nws.noaa.gov/data/observations/metar/cycles/00Z.TXT and
  * merges the METAR entries into an index.
+ * Unchanged files are detected by conditional requests and older cycle files are not fetched again once final.
  */
 class NoaaWeatherDownloader :
   public WeatherDownloadBase
@@ -62,6 +65,10 @@ private:
 
   void downloadFinished(const QByteArray& data, QString url);
   void downloadFailed(const QString& error, int errorCode, QString url);
+  void downloadNotModified(QString url);
+
+  /* Remember cycle file of the current download as complete if it will not change anymore */
+  void cycleDownloaded();
 
   /* Read downloaded METAR file contents */
   bool read(const QByteArray& data, const QString& url);
@@ -80,6 +87,12 @@ private:
   /* https://tgftp.nws.noaa.gov/data/observations/metar/cycles/%1Z.TXT */
   QString baseUrl;
   QStringList downloadQueue;
+
+  /* Maps URL to cycle time of the queued job */
+  QHash<QString, QDateTime> jobCycles;
+
+  /* Maps URL to cycle time of files which were downloaded after they were final. These are not fetched again. */
+  QHash<QString, QDateTime> finalCycles;
   int updatePeriodSeconds = 600;
 };
 
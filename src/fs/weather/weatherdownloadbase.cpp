@@ -18,6 +18,7 @@
 #include "fs/weather/weatherdownloadbase.h"
 
 #include "util/httpdownloader.h"
+#include "util/httpscheduler.h"
 #include "fs/weather/weathertypes.h"
 #include "fs/weather/metarindex.h"
 
@@ -30,6 +31,7 @@ WeatherDownloadBase::WeatherDownloadBase(QObject *parent, MetarFormat format, bo
 {
   metarIndex = new MetarIndex(format, verboseLogging);
   downloader = new atools::util::HttpDownloader(parent, verboseLogging);
+  downloader->setConditionalRequests(true);
   connect(downloader, &atools::util::HttpDownloader::downloadSslErrors,
           this, &WeatherDownloadBase::weatherDownloadSslErrors);
 }
@@ -73,6 +75,16 @@ void WeatherDownloadBase::setFetchAirportCoords(const std::function<geo::Pos(con
   metarIndex->setFetchAirportCoords(value);
 }
 
+void WeatherDownloadBase::setFetchAirportCoordsBulk(const FetchAirportCoordsBulkFunc& value)
+{
+  metarIndex->setFetchAirportCoordsBulk(value);
+}
+
+void WeatherDownloadBase::clearAirportCoordsCache()
+{
+  metarIndex->clearAirportCoordsCache();
+}
+
 int WeatherDownloadBase::size() const
 {
   return metarIndex->size();
@@ -83,6 +95,22 @@ void WeatherDownloadBase::setIgnoreSslErrors(bool value)
   downloader->setIgnoreSslErrors(value);
 }
 
+void WeatherDownloadBase::setConditionalRequests(bool value)
+{
+  downloader->setConditionalRequests(value);
+}
+
+void WeatherDownloadBase::setDiskCache(atools::util::HttpCache *cache)
+{
+  downloader->setDiskCache(cache);
+}
+
+void WeatherDownloadBase::setScheduler(atools::util::HttpScheduler *scheduler)
+{
+  // Weather is shown to the user
+  downloader->setScheduler(scheduler, atools::util::PRIORITY_USER);
+}
+
 void WeatherDownloadBase::startDownload()
 {
   if(!downloader->isDownloading())
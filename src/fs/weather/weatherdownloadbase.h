@@ -25,6 +25,8 @@
 namespace atools {
 namespace util {
 class HttpDownloader;
+class HttpCache;
+class HttpScheduler;
 }
 namespace fs {
 namespace weather {
@@ -64,6 +66,12 @@ public:
   /* Set to a function that returns the coordinates for an airport ident. Needed to find the nearest. */
   virtual void setFetchAirportCoords(const std::function<atools::geo::Pos(const QString&)>& value);
 
+  /* Set to a function that returns the coordinates for many airport idents at once. Preferred if set. */
+  virtual void setFetchAirportCoordsBulk(const atools::fs::weather::FetchAirportCoordsBulkFunc& value);
+
+  /* Forget cached station coordinates, e.g. after the airport database changed */
+  void clearAirportCoordsCache();
+
   /* Number of unique METAR entries in the list */
   virtual int size() const;
 
@@ -71,6 +79,15 @@ public:
    * downloadSslErrors is emitted in case of SSL errors. */
   void setIgnoreSslErrors(bool value);
 
+  /* Use ETag and Last-Modified headers to avoid downloading and reading unchanged files. Enabled by default. */
+  void setConditionalRequests(bool value);
+
+  /* Use the persistent disk cache for downloads. Cache is not owned. Set to null to disable. */
+  void setDiskCache(atools::util::HttpCache *cache);
+
+  /* Use the shared download scheduler. Scheduler is not owned. Set to null to disable. */
+  void setScheduler(atools::util::HttpScheduler *scheduler);
+
 signals:
   /* Emitted when file was downloaded and udpated */
   void weatherUpdated();
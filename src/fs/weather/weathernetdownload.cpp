@@ -29,6 +29,8 @@ WeatherNetDownload::WeatherNetDownload(QObject *parent, atools::fs::weather::Met
 {
   connect(downloader, &atools::util::HttpDownloader::downloadFinished, this, &WeatherNetDownload::downloadFinished);
   connect(downloader, &atools::util::HttpDownloader::downloadFailed, this, &WeatherNetDownload::downloadFailed);
+  connect(downloader, &atools::util::HttpDownloader::downloadNotModified,
+          this, &WeatherNetDownload::downloadNotModified);
 }
 
 WeatherNetDownload::~WeatherNetDownload()
@@ -44,7 +46,7 @@ void WeatherNetDownload::downloadFinished(const QByteArray& data, QString url)
   // AYNZ 160800Z 09005G10KT 9999 SCT030 BKN ABV050 27/24 Q1007 RMK
   // AYPY 160700Z 28010KT 9999 SCT025 OVC050 28/23 Q1008 RMK/ BUILD UPS TO S/W
   QTextStream stream(data, QIODevice::ReadOnly | QIODevice::Text);
-  metarIndex->read(stream, downloader->getUrl(), false /* merge */);
+  metarIndex->read(stream, downloader->getUrl(), mergeUpdates);
 
   if(verbose)
     qDebug() << Q_FUNC_INFO << "Loaded" << data.size() << "bytes and" << metarIndex->size()
@@ -53,6 +55,13 @@ void WeatherNetDownload::downloadFinished(const QByteArray& data, QString url)
   emit weatherUpdated();
 }
 
+void WeatherNetDownload::downloadNotModified(QString url)
+{
+  // Nothing to read - index is up to date
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "url" << url;
+}
+
 void WeatherNetDownload::downloadFailed(const QString& error, int errorCode, QString url)
 {
   qWarning() << Q_FUNC_INFO << "Error downloading from" << url << ":" << error << errorCode;
@@ -43,9 +43,25 @@ public:
   WeatherNetDownload(QObject *parent, atools::fs::weather::MetarFormat format, bool verbose);
   virtual ~WeatherNetDownload();
 
+  /* Merge downloaded files into the index instead of replacing it. Only stations with newer timestamps
+   * are updated and the spatial index is not rebuilt if no new stations appear.
+   * Stations missing in later files are kept. Default is false. */
+  void setMergeUpdates(bool value)
+  {
+    mergeUpdates = value;
+  }
+
+  bool isMergeUpdates() const
+  {
+    return mergeUpdates;
+  }
+
 private:
   void downloadFinished(const QByteArray& data, QString url);
   void downloadFailed(const QString& error, int errorCode, QString url);
+  void downloadNotModified(QString url);
+
+  bool mergeUpdates = false;
 
 };
 
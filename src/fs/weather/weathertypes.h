@@ -21,6 +21,10 @@
 #include "geo/pos.h"
 
 #include <QDateTime>
+#include <QHash>
+#include <QStringList>
+
+#include <functional>
 
 namespace atools {
 namespace fs {
@@ -34,6 +38,11 @@ enum MetarFormat
   FLAT /* Simple text of "ICAO METAR" strings */
 };
 
+/* Callback resolving coordinates for many airport idents at once, e.g. with a single query.
+ * Idents which are not found are left out of coords. */
+typedef std::function<void(const QStringList& idents, QHash<QString, atools::geo::Pos>& coords)>
+  FetchAirportCoordsBulkFunc;
+
 /*
  * Collects METAR information for station, nearest and interpolated values.
  * Also keeps position and ident of original request.
@@ -21,6 +21,7 @@
 #include "fs/weather/metarindex.h"
 
 #include <QFileInfo>
+#include <QTextStream>
 
 namespace atools {
 namespace fs {
@@ -28,6 +29,9 @@ namespace weather {
 
 using atools::util::FileSystemWatcher;
 
+/* METAR files in X-Plane 12 real weather directory */
+static const QStringList XP12_METAR_FILTERS({"metar*.txt"});
+
 XpWeatherReader::XpWeatherReader(QObject *parent, bool verboseLogging)
   : QObject(parent), verbose(verboseLogging)
 {
@@ -56,10 +60,16 @@ void XpWeatherReader::readWeatherFile()
     metarIndex->clear();
     deleteFsWatcher();
 
+    QFileInfo fileinfo(weatherFile);
+    directoryMode = fileinfo.isDir();
     createFsWatcher();
 
-    QFileInfo fileinfo(weatherFile);
-    if(fileinfo.exists() && fileinfo.isFile())
+    if(directoryMode)
+    {
+      // Load all files initially
+      readFiles(fsWatcher->getDirectoryFiles(), false /* merge */);
+    }
+    else if(fileinfo.exists() && fileinfo.isFile())
       read();
     // else wait for file created
   }
@@ -78,6 +88,16 @@ void XpWeatherReader::setFetchAirportCoords(const std::function<geo::Pos(const Q
   metarIndex->setFetchAirportCoords(value);
 }
 
+void XpWeatherReader::setFetchAirportCoordsBulk(const FetchAirportCoordsBulkFunc& value)
+{
+  metarIndex->setFetchAirportCoordsBulk(value);
+}
+
+void XpWeatherReader::clearAirportCoordsCache()
+{
+  metarIndex->clearAirportCoordsCache();
+}
+
 bool XpWeatherReader::read()
 {
   QFile file(weatherFile);
@@ -94,6 +114,41 @@ bool XpWeatherReader::read()
   return metarIndex->size();
 }
 
+void XpWeatherReader::readFiles(const QStringList& filenames, bool merge)
+{
+  // Concatenate all files to have the index updated only once
+  QString text;
+  for(const QString& filename : filenames)
+  {
+    QFile file(filename);
+    if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+      QTextStream stream(&file);
+      stream.setCodec("UTF-8");
+      text.append(stream.readAll());
+      text.append('\n');
+      file.close();
+    }
+    else
+      qWarning() << "cannot open" << file.fileName() << "reason" << file.errorString();
+  }
+
+  qDebug() << Q_FUNC_INFO << weatherFile << "files" << filenames.size() << "merge" << merge;
+
+  QTextStream stream(&text, QIODevice::ReadOnly);
+  metarIndex->read(stream, weatherFile, merge);
+}
+
+void XpWeatherReader::filesChanged(const QStringList& filenames)
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << filenames;
+
+  // Older duplicates are ignored by the index
+  readFiles(filenames, true /* merge */);
+  emit weatherUpdated();
+}
+
 atools::fs::weather::MetarResult XpWeatherReader::getXplaneMetar(const QString& station, const atools::geo::Pos& pos)
 {
   readWeatherFile();
@@ -128,6 +183,7 @@ void XpWeatherReader::deleteFsWatcher()
   if(fsWatcher != nullptr)
   {
     fsWatcher->disconnect(fsWatcher, &FileSystemWatcher::fileUpdated, this, &XpWeatherReader::pathChanged);
+    fsWatcher->disconnect(fsWatcher, &FileSystemWatcher::filesUpdated, this, &XpWeatherReader::filesChanged);
     fsWatcher->deleteLater();
     fsWatcher = nullptr;
   }
@@ -143,6 +199,14 @@ void XpWeatherReader::createFsWatcher()
     // Set to smaller value to deal with ASX weather files
     fsWatcher->setMinFileSize(1000);
     fsWatcher->connect(fsWatcher, &FileSystemWatcher::fileUpdated, this, &XpWeatherReader::pathChanged);
+    fsWatcher->connect(fsWatcher, &FileSystemWatcher::filesUpdated, this, &XpWeatherReader::filesChanged);
+  }
+
+  if(directoryMode)
+  {
+    // Start watching for new and changed files - initial load is done by caller
+    fsWatcher->setDirectoryAndStart(weatherFile, XP12_METAR_FILTERS);
+    return;
   }
 
   // Load initially
@@ -18,6 +18,8 @@
 #ifndef ATOOLS_XPWEATHERREADER_H
 #define ATOOLS_XPWEATHERREADER_H
 
+#include "fs/weather/weathertypes.h"
+
 #include <QObject>
 #include <functional>
 
@@ -37,6 +39,9 @@ class MetarIndex;
 
 /*
  * Reads the X-Plane METAR.rwx the watches the file for changes.
+ *
+ * Alternatively reads all METAR files in a directory like the X-Plane 12 "Output/real weather" folder.
+ * Only new or changed files are read and merged into the index when watching a directory.
  */
 class XpWeatherReader
   : public QObject
@@ -52,7 +57,7 @@ public:
   /* Get station and/or nearest METAR */
   atools::fs::weather::MetarResult getXplaneMetar(const QString& station, const atools::geo::Pos& pos);
 
-  /* File is loaded on demand on first access */
+  /* File is loaded on demand on first access. Directory mode is used if file is a directory. */
   void setWeatherFile(const QString& file);
 
   /* Remove METARs and stop watching the file */
@@ -61,6 +66,12 @@ public:
   /* Set to a function that returns the coordinates for an airport ident. Needed to find the nearest. */
   void setFetchAirportCoords(const std::function<atools::geo::Pos(const QString&)>& value);
 
+  /* Set to a function that returns the coordinates for many airport idents at once. Preferred if set. */
+  void setFetchAirportCoordsBulk(const atools::fs::weather::FetchAirportCoordsBulkFunc& value);
+
+  /* Forget cached station coordinates, e.g. after the airport database changed */
+  void clearAirportCoordsCache();
+
 signals:
   void weatherUpdated();
 
@@ -73,10 +84,19 @@ private:
   void pathChanged(const QString& filename);
   bool read();
 
+  /* Directory mode: read changed files and merge them into the index */
+  void filesChanged(const QStringList& filenames);
+
+  /* Read all files into the index at once. Either merge or replace content. */
+  void readFiles(const QStringList& filenames, bool merge);
+
   atools::fs::weather::MetarIndex *metarIndex = nullptr;
   atools::util::FileSystemWatcher *fsWatcher = nullptr;
   QString weatherFile;
 
+  /* weatherFile is a directory with METAR files */
+  bool directoryMode = false;
+
   bool verbose;
 };
 
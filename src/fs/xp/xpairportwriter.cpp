@@ -1021,13 +1021,13 @@ void XpAirportWriter::bindMetadata(const QStringList& line, const atools::fs::xp
   else if(key == "iata_code")
     airportIata = value;
   else if(key == "city")
-    insertAirportQuery->bindValue(":city", value);
+    insertAirportQuery->bindValue(":city", atools::util::intern(value));
   else if(key == "country")
-    insertAirportQuery->bindValue(":country", value);
+    insertAirportQuery->bindValue(":country", atools::util::intern(value));
   else if(key == "flatten")
     insertAirportQuery->bindValue(":flatten", value);
   else if(key.startsWith("region") && !value.isEmpty()) // Documentation is not clear - region_id or region_code
-    insertAirportQuery->bindValue(":region", value);
+    insertAirportQuery->bindValue(":region", atools::util::intern(value));
   else if(key == "datum_lat" && atools::almostNotEqual(value.toFloat(), 0.f))
     airportDatumPos.setLatY(value.toFloat());
   else if(key == "datum_lon" && atools::almostNotEqual(value.toFloat(), 0.f))
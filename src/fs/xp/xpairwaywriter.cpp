@@ -67,18 +67,18 @@ void XpAirwayWriter::write(const QStringList& line, const XpWriterContext& conte
   {
     // Split dash separated airway list
     insertAirwayQuery->bindValue(":airway_temp_id", ++curAirwayId);
-    insertAirwayQuery->bindValue(":name", name);
+    insertAirwayQuery->bindValue(":name", atools::util::intern(name));
     insertAirwayQuery->bindValue(":type", at(line, TYPE).toInt());
     insertAirwayQuery->bindValue(":direction", at(line, DIRECTION));
     insertAirwayQuery->bindValue(":minimum_altitude", at(line, MIN_ALT).toInt());
     insertAirwayQuery->bindValue(":maximum_altitude", at(line, MAX_ALT).toInt());
 
     insertAirwayQuery->bindValue(":previous_ident", at(line, FROM_IDENT));
-    insertAirwayQuery->bindValue(":previous_region", at(line, FROM_REGION));
+    insertAirwayQuery->bindValue(":previous_region", atShared(line, FROM_REGION));
     insertAirwayQuery->bindValue(":previous_type", at(line, FROM_TYPE).toInt());
 
     insertAirwayQuery->bindValue(":next_ident", at(line, TO_IDENT));
-    insertAirwayQuery->bindValue(":next_region", at(line, TO_REGION));
+    insertAirwayQuery->bindValue(":next_region", atShared(line, TO_REGION));
     insertAirwayQuery->bindValue(":next_type", at(line, TO_TYPE).toInt());
 
     insertAirwayQuery->exec();
@@ -0,0 +1,122 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/xp/xpaptindex.h"
+
+#include <QDataStream>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace xp {
+
+void XpAptIndex::startAirport(const QString& ident, qint64 offset, int lineNumber)
+{
+  closeLast(offset, lineNumber);
+  identIndex.insert(ident, entries.size());
+  entries.append({ident, offset, 0L, lineNumber, 0});
+}
+
+void XpAptIndex::finish(qint64 endOffset, int endLineNumber)
+{
+  closeLast(endOffset, endLineNumber);
+}
+
+void XpAptIndex::closeLast(qint64 endOffset, int endLineNumber)
+{
+  if(!entries.isEmpty())
+  {
+    Entry& last = entries.last();
+    if(last.size == 0L)
+    {
+      last.size = endOffset - last.offset;
+      last.numLines = endLineNumber - last.lineNumber;
+    }
+  }
+}
+
+void XpAptIndex::clear()
+{
+  entries.clear();
+  identIndex.clear();
+}
+
+QVector<int> XpAptIndex::findAirports(const QString& ident) const
+{
+  QVector<int> retval = identIndex.values(ident).toVector();
+  std::sort(retval.begin(), retval.end());
+  return retval;
+}
+
+QVector<int> XpAptIndex::chunks(int numChunks) const
+{
+  QVector<int> retval;
+  if(entries.isEmpty() || numChunks < 1)
+    return retval;
+
+  const Entry& last = entries.last();
+  qint64 totalSize = last.offset + last.size - entries.first().offset;
+  qint64 chunkSize = totalSize / numChunks + 1;
+
+  retval.append(0);
+  qint64 nextOffset = entries.first().offset + chunkSize;
+  for(int i = 1; i < entries.size(); i++)
+  {
+    if(entries.at(i).offset >= nextOffset)
+    {
+      retval.append(i);
+      nextOffset = entries.at(i).offset + chunkSize;
+    }
+  }
+  return retval;
+}
+
+QDataStream& operator<<(QDataStream& out, const XpAptIndex& index)
+{
+  out << static_cast<qint32>(index.entries.size());
+  for(const XpAptIndex::Entry& entry : index.entries)
+    out << entry.ident << entry.offset << entry.size << static_cast<qint32>(entry.lineNumber)
+        << static_cast<qint32>(entry.numLines);
+  return out;
+}
+
+QDataStream& operator>>(QDataStream& in, XpAptIndex& index)
+{
+  index.clear();
+
+  qint32 num;
+  in >> num;
+  index.entries.reserve(num);
+  for(qint32 i = 0; i < num && in.status() == QDataStream::Ok; i++)
+  {
+    XpAptIndex::Entry entry;
+    qint32 lineNumber, numLines;
+    in >> entry.ident >> entry.offset >> entry.size >> lineNumber >> numLines;
+    entry.lineNumber = lineNumber;
+    entry.numLines = numLines;
+
+    index.identIndex.insert(entry.ident, index.entries.size());
+    index.entries.append(entry);
+  }
+  return in;
+}
+
+} // namespace xp
+} // namespace fs
+} // namespace atools
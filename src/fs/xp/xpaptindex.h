@@ -0,0 +1,94 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_XP_XPAPTINDEX_H
+#define ATOOLS_FS_XP_XPAPTINDEX_H
+
+#include <QMultiHash>
+#include <QVector>
+
+class QDataStream;
+
+namespace atools {
+namespace fs {
+namespace xp {
+
+/*
+ * Index of the airports in an apt.dat file. Contains byte offset and line range for each airport
+ * which allows to seek directly to an airport or to split a file on airport boundaries.
+ *
+ * Built while reading an apt.dat file. Saved and loaded by XpDataCache.
+ */
+class XpAptIndex
+{
+public:
+  struct Entry
+  {
+    QString ident; /* X-Plane ident from row code 1, 16 or 17 */
+    qint64 offset, size; /* Byte offset of the airport header line and size including all lines up to the next */
+    int lineNumber, numLines; /* One based line number of the airport header line */
+  };
+
+  /* Start a new airport in the index and end the previous one */
+  void startAirport(const QString& ident, qint64 offset, int lineNumber);
+
+  /* End the last airport. endOffset and endLineNumber are the first ones not belonging to the airport. */
+  void finish(qint64 endOffset, int endLineNumber);
+
+  void clear();
+
+  /* Index into getEntries() for all airports with the given ident in file order. Empty if not found. */
+  QVector<int> findAirports(const QString& ident) const;
+
+  /* Split the file into at most numChunks ranges on airport boundaries having about the same size.
+   * Returns the entry indexes where each chunk starts. */
+  QVector<int> chunks(int numChunks) const;
+
+  const QVector<Entry>& getEntries() const
+  {
+    return entries;
+  }
+
+  bool isEmpty() const
+  {
+    return entries.isEmpty();
+  }
+
+  int size() const
+  {
+    return entries.size();
+  }
+
+private:
+  friend QDataStream& operator<<(QDataStream& out, const atools::fs::xp::XpAptIndex& index);
+  friend QDataStream& operator>>(QDataStream& in, atools::fs::xp::XpAptIndex& index);
+
+  void closeLast(qint64 endOffset, int endLineNumber);
+
+  QVector<Entry> entries;
+  QMultiHash<QString, int> identIndex;
+};
+
+QDataStream& operator<<(QDataStream& out, const atools::fs::xp::XpAptIndex& index);
+QDataStream& operator>>(QDataStream& in, atools::fs::xp::XpAptIndex& index);
+
+} // namespace xp
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_XP_XPAPTINDEX_H
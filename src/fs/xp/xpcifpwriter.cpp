@@ -19,7 +19,7 @@
 
 #include "fs/common/airportindex.h"
 #include "fs/common/procedurewriter.h"
- #include "atools.h"
+#include "atools.h"
 
 namespace atools {
 namespace fs {
@@ -70,6 +70,16 @@ enum ProcedureFieldIndex
 };
 /* *INDENT-ON* */
 
+/* Same as XpWriter::at() but without using writer state to allow calling it from other threads */
+static const QString& field(const QStringList& line, const XpWriterContext& context, int index)
+{
+  if(index < line.size())
+    return line.at(index);
+  else
+    throw atools::Exception(context.messagePrefix() +
+                            QString(": Index out of bounds: Index: %1, size: %2").arg(index).arg(line.size()));
+}
+
 XpCifpWriter::XpCifpWriter(atools::sql::SqlDatabase& sqlDb, atools::fs::common::AirportIndex *airportIndexParam,
                            const NavDatabaseOptions& opts, ProgressHandler *progressHandler,
                            atools::fs::NavDatabaseErrors *navdatabaseErrors)
@@ -86,43 +96,55 @@ XpCifpWriter::~XpCifpWriter()
 void XpCifpWriter::write(const QStringList& line, const XpWriterContext& context)
 {
   ctx = &context;
+
+  atools::fs::common::ProcedureInput procInput;
+  if(toProcedureInput(procInput, line, context))
+    procWriter->write(procInput);
+}
+
+void XpCifpWriter::writeProcedureInput(const common::ProcedureInput& procInput)
+{
+  procWriter->write(procInput);
+}
+
+bool XpCifpWriter::toProcedureInput(common::ProcedureInput& procInput, const QStringList& line,
+                                    const XpWriterContext& context)
+{
   if(line.isEmpty())
-    return;
+    return false;
 
   QString rowCode = line.at(PROC_ROW_CODE);
   if(!(rowCode == "SID" || rowCode == "STAR" || rowCode == "APPCH"))
     // Skip all unknown row codes
-    return;
-
-  atools::fs::common::ProcedureInput procInput;
+    return false;
 
   procInput.context = context.messagePrefix();
   procInput.airportIdent = context.cifpAirportIdent;
   procInput.airportId = context.cifpAirportId;
 
-  procInput.rowCode = at(line, PROC_ROW_CODE).trimmed();
-  procInput.seqNr = at(line, SEQ_NR).toInt();
-  procInput.routeType = atools::strToChar(at(line, RT_TYPE));
-  procInput.sidStarAppIdent = at(line, SID_STAR_APP_IDENT).trimmed();
-  procInput.transIdent = at(line, TRANS_IDENT).trimmed();
-  procInput.fixIdent = at(line, FIX_IDENT).trimmed();
-  procInput.region = at(line, ICAO_CODE).trimmed();
-  procInput.secCode = at(line, SEC_CODE);
-  procInput.subCode = at(line, SUB_CODE);
-  procInput.descCode = at(line, DESC_CODE);
-  procInput.turnDir = at(line, TURN_DIR).trimmed();
-  procInput.pathTerm = at(line, PATH_TERM).trimmed();
-  procInput.recdNavaid = at(line, RECD_NAVAID).trimmed();
-  procInput.recdRegion = at(line, RECD_ICAO_CODE).trimmed();
-  procInput.recdSecCode = at(line, RECD_SEC_CODE);
-  procInput.recdSubCode = at(line, RECD_SUB_CODE);
-
-  procInput.theta = at(line, THETA).toFloat() / 10.f;
-  procInput.rho = at(line, RHO).toFloat() / 10.f;
-  procInput.magCourse = at(line, MAG_CRS).toFloat() / 10.f;
+  procInput.rowCode = field(line, context, PROC_ROW_CODE).trimmed();
+  procInput.seqNr = field(line, context, SEQ_NR).toInt();
+  procInput.routeType = atools::strToChar(field(line, context, RT_TYPE));
+  procInput.sidStarAppIdent = field(line, context, SID_STAR_APP_IDENT).trimmed();
+  procInput.transIdent = field(line, context, TRANS_IDENT).trimmed();
+  procInput.fixIdent = field(line, context, FIX_IDENT).trimmed();
+  procInput.region = field(line, context, ICAO_CODE).trimmed();
+  procInput.secCode = field(line, context, SEC_CODE);
+  procInput.subCode = field(line, context, SUB_CODE);
+  procInput.descCode = field(line, context, DESC_CODE);
+  procInput.turnDir = field(line, context, TURN_DIR).trimmed();
+  procInput.pathTerm = field(line, context, PATH_TERM).trimmed();
+  procInput.recdNavaid = field(line, context, RECD_NAVAID).trimmed();
+  procInput.recdRegion = field(line, context, RECD_ICAO_CODE).trimmed();
+  procInput.recdSecCode = field(line, context, RECD_SEC_CODE);
+  procInput.recdSubCode = field(line, context, RECD_SUB_CODE);
+
+  procInput.theta = field(line, context, THETA).toFloat() / 10.f;
+  procInput.rho = field(line, context, RHO).toFloat() / 10.f;
+  procInput.magCourse = field(line, context, MAG_CRS).toFloat() / 10.f;
 
   procInput.rteHoldTime = procInput.rteHoldDist = 0.f;
-  QString distTime = at(line, RTE_DIST_HOLD_DIST_TIME).trimmed();
+  QString distTime = field(line, context, RTE_DIST_HOLD_DIST_TIME).trimmed();
   if(distTime.startsWith("T"))
     // time minutes/10
     procInput.rteHoldTime = distTime.mid(1).toFloat() / 10.f;
@@ -130,19 +152,18 @@ void XpCifpWriter::write(const QStringList& line, const XpWriterContext& context
     // distance nm/10
     procInput.rteHoldDist = distTime.toFloat() / 10.f;
 
-  procInput.altDescr = at(line, ALT_DESCR).trimmed();
-  procInput.altitude = at(line, ALTITUDE).trimmed();
-  procInput.altitude2 = at(line, ALTITUDE2).trimmed();
-  procInput.transAlt = at(line, TRANS_ALT).trimmed();
-  procInput.speedLimitDescr = at(line, SPD_LIMIT_DESCR).trimmed();
-  procInput.speedLimit = at(line, SPEED_LIMIT).toInt();
-  procInput.centerFixOrTaaPt = at(line, CENTER_FIX_OR_TAA_PT).trimmed();
-  procInput.centerIcaoCode = at(line, CENTER_ICAO_CODE).trimmed();
-  procInput.centerSecCode = at(line, CENTER_SEC_CODE);
-  procInput.centerSubCode = at(line, CENTER_SUB_CODE);
-  procInput.gnssFmsIndicator = at(line, GNSS_FMS_IND);
-
-  procWriter->write(procInput);
+  procInput.altDescr = field(line, context, ALT_DESCR).trimmed();
+  procInput.altitude = field(line, context, ALTITUDE).trimmed();
+  procInput.altitude2 = field(line, context, ALTITUDE2).trimmed();
+  procInput.transAlt = field(line, context, TRANS_ALT).trimmed();
+  procInput.speedLimitDescr = field(line, context, SPD_LIMIT_DESCR).trimmed();
+  procInput.speedLimit = field(line, context, SPEED_LIMIT).toInt();
+  procInput.centerFixOrTaaPt = field(line, context, CENTER_FIX_OR_TAA_PT).trimmed();
+  procInput.centerIcaoCode = field(line, context, CENTER_ICAO_CODE).trimmed();
+  procInput.centerSecCode = field(line, context, CENTER_SEC_CODE);
+  procInput.centerSubCode = field(line, context, CENTER_SUB_CODE);
+  procInput.gnssFmsIndicator = field(line, context, GNSS_FMS_IND);
+  return true;
 }
 
 void XpCifpWriter::finish(const XpWriterContext& context)
@@ -37,6 +37,7 @@ class ProgressHandler;
 namespace common {
 class AirportIndex;
 class ProcedureWriter;
+struct ProcedureInput;
 }
 
 namespace xp {
@@ -57,6 +58,16 @@ public:
   virtual void finish(const XpWriterContext& context) override;
   virtual void reset() override;
 
+  /*
+   * Convert a line of a CIFP file to procedure input. Returns false if the line is not a procedure.
+   * Does not use any writer state and can be called from other threads. Throws Exception on errors.
+   */
+  static bool toProcedureInput(atools::fs::common::ProcedureInput& procInput, const QStringList& line,
+                               const atools::fs::xp::XpWriterContext& context);
+
+  /* Write procedure input which was converted before using toProcedureInput() */
+  void writeProcedureInput(const atools::fs::common::ProcedureInput& procInput);
+
 private:
 
   atools::fs::common::ProcedureWriter *procWriter = nullptr;
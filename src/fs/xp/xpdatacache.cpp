@@ -0,0 +1,217 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/xp/xpdatacache.h"
+
+#include "fs/xp/xpaptindex.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace atools {
+namespace fs {
+namespace xp {
+
+static const quint32 CACHE_MAGIC_NUMBER = 0x58504443; // "XPDC"
+static const quint32 APT_INDEX_MAGIC_NUMBER = 0x58504149; // "XPAI"
+static const quint16 CACHE_VERSION = 1;
+
+/* Number of bytes at the start of the file used for the hash */
+static const qint64 HASH_BYTES = 64 * 1024;
+
+XpDataCache::XpDataCache(const QString& directory)
+  : cacheDir(directory)
+{
+  if(!QDir().mkpath(cacheDir))
+    qWarning() << Q_FUNC_INFO << "Cannot create cache directory" << cacheDir;
+}
+
+QString XpDataCache::cacheFilename(const QString& filepath, const QString& suffix) const
+{
+  // Prefix with path hash to allow the same filename in different X-Plane installations
+  QString path = QFileInfo(filepath).absoluteFilePath();
+  QByteArray pathHash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex().left(16);
+  return QDir(cacheDir).filePath(QString::fromLatin1(pathHash) + "_" + QFileInfo(filepath).fileName() + suffix);
+}
+
+QByteArray XpDataCache::fileHash(const QString& filepath)
+{
+  QFile file(filepath);
+  if(file.open(QIODevice::ReadOnly))
+    return QCryptographicHash::hash(file.read(HASH_BYTES), QCryptographicHash::Sha1);
+  else
+    return QByteArray();
+}
+
+void XpDataCache::writeKey(QDataStream& stream, const QString& filepath, quint32 magic)
+{
+  QFileInfo source(filepath);
+  stream << magic << CACHE_VERSION << static_cast<qint64>(source.size())
+         << static_cast<qint64>(source.lastModified().toMSecsSinceEpoch()) << fileHash(filepath);
+}
+
+bool XpDataCache::readKey(QDataStream& stream, const QString& filepath, quint32 magic)
+{
+  quint32 fileMagic;
+  quint16 version;
+  stream >> fileMagic >> version;
+
+  if(fileMagic != magic || version != CACHE_VERSION)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid cache file for" << filepath << "magic" << fileMagic << "version" << version;
+    return false;
+  }
+
+  QFileInfo source(filepath);
+  qint64 size, lastModified;
+  QByteArray hash;
+  stream >> size >> lastModified >> hash;
+
+  if(size != source.size() || lastModified != source.lastModified().toMSecsSinceEpoch() ||
+     hash != fileHash(filepath))
+  {
+    qInfo() << Q_FUNC_INFO << "Cache outdated for" << filepath;
+    return false;
+  }
+  return stream.status() == QDataStream::Ok;
+}
+
+bool XpDataCache::load(const QString& filepath, QString& header, LineVector& lines) const
+{
+  QFile file(cacheFilename(filepath, ".cache"));
+  if(!file.exists())
+    return false;
+
+  bool valid = false;
+  if(file.open(QIODevice::ReadOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    if(readKey(stream, filepath, CACHE_MAGIC_NUMBER))
+    {
+      qint32 numLines;
+      stream >> header >> numLines;
+
+      lines.clear();
+      lines.reserve(numLines);
+      for(qint32 i = 0; i < numLines && stream.status() == QDataStream::Ok; i++)
+      {
+        Line line;
+        qint32 lineNumber;
+        stream >> lineNumber >> line.fields;
+        line.lineNumber = lineNumber;
+        lines.append(line);
+      }
+      valid = stream.status() == QDataStream::Ok && lines.size() == numLines;
+    }
+    file.close();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot read cache file" << file.fileName() << file.errorString();
+
+  if(valid)
+    qInfo() << Q_FUNC_INFO << "Using cache" << file.fileName() << "for" << filepath << lines.size() << "lines";
+  else
+  {
+    header.clear();
+    lines.clear();
+  }
+  return valid;
+}
+
+void XpDataCache::save(const QString& filepath, const QString& header, const LineVector& lines) const
+{
+  QSaveFile file(cacheFilename(filepath, ".cache"));
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    writeKey(stream, filepath, CACHE_MAGIC_NUMBER);
+    stream << header << static_cast<qint32>(lines.size());
+
+    for(const Line& line : lines)
+      stream << static_cast<qint32>(line.lineNumber) << line.fields;
+
+    if(file.commit())
+      qInfo() << Q_FUNC_INFO << "Saved cache" << file.fileName() << "for" << filepath << lines.size() << "lines";
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot write cache file" << file.fileName() << file.errorString();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write cache file" << file.fileName() << file.errorString();
+}
+
+bool XpDataCache::loadAptIndex(const QString& filepath, XpAptIndex& index) const
+{
+  QFile file(cacheFilename(filepath, ".aptidx"));
+  if(!file.exists())
+    return false;
+
+  bool valid = false;
+  if(file.open(QIODevice::ReadOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    if(readKey(stream, filepath, APT_INDEX_MAGIC_NUMBER))
+    {
+      stream >> index;
+      valid = stream.status() == QDataStream::Ok;
+    }
+    file.close();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot read index file" << file.fileName() << file.errorString();
+
+  if(valid)
+    qInfo() << Q_FUNC_INFO << "Using index" << file.fileName() << "for" << filepath << index.size() << "airports";
+  else
+    index.clear();
+  return valid;
+}
+
+void XpDataCache::saveAptIndex(const QString& filepath, const XpAptIndex& index) const
+{
+  QSaveFile file(cacheFilename(filepath, ".aptidx"));
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    writeKey(stream, filepath, APT_INDEX_MAGIC_NUMBER);
+    stream << index;
+
+    if(file.commit())
+      qInfo() << Q_FUNC_INFO << "Saved index" << file.fileName() << "for" << filepath << index.size() << "airports";
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot write index file" << file.fileName() << file.errorString();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write index file" << file.fileName() << file.errorString();
+}
+
+} // namespace xp
+} // namespace fs
+} // namespace atools
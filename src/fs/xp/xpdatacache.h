@@ -0,0 +1,104 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_XP_XPDATACACHE_H
+#define ATOOLS_FS_XP_XPDATACACHE_H
+
+#include <QStringList>
+#include <QVector>
+
+class QDataStream;
+
+namespace atools {
+namespace fs {
+namespace xp {
+
+class XpAptIndex;
+
+/*
+ * Binary cache for the split lines of the large X-Plane navdata files like earth_fix.dat, earth_nav.dat and
+ * earth_awy.dat which change only with AIRAC updates.
+ *
+ * One cache file is stored per source file in the cache directory. A cache file is valid if size and
+ * modification time of the source file are unchanged and the hash of the first 64 kB including the header
+ * with the AIRAC cycle matches.
+ *
+ * Only the parsed fields are cached and not database rows since these depend on airport ids,
+ * magnetic declination and the other files of the compilation.
+ *
+ * Also stores the airport index of apt.dat files using the same validity check.
+ */
+class XpDataCache
+{
+public:
+  /* One line which was passed to the writer */
+  struct Line
+  {
+    int lineNumber;
+    QStringList fields;
+  };
+
+  typedef QVector<Line> LineVector;
+
+  /* Cache files are stored in directory which is created if missing */
+  explicit XpDataCache(const QString& directory);
+
+  /*
+   * Load header and lines of the given source file.
+   * @return false if there is no valid cache file for the source file
+   */
+  bool load(const QString& filepath, QString& header, LineVector& lines) const;
+
+  /* Save header and lines for the given source file. Errors are only logged. */
+  void save(const QString& filepath, const QString& header, const LineVector& lines) const;
+
+  /*
+   * Load airport index of the given apt.dat file.
+   * @return false if there is no valid index file for the source file
+   */
+  bool loadAptIndex(const QString& filepath, atools::fs::xp::XpAptIndex& index) const;
+
+  /* Save airport index for the given apt.dat file. Errors are only logged. */
+  void saveAptIndex(const QString& filepath, const atools::fs::xp::XpAptIndex& index) const;
+
+  const QString& getDirectory() const
+  {
+    return cacheDir;
+  }
+
+private:
+  /* Name of the cache file for the source file */
+  QString cacheFilename(const QString& filepath, const QString& suffix) const;
+
+  /* Write magic number, version, size, modification time and hash of the source file */
+  static void writeKey(QDataStream& stream, const QString& filepath, quint32 magic);
+
+  /* Read and compare values written by writeKey(). Returns false if the cache file is not valid for the source. */
+  static bool readKey(QDataStream& stream, const QString& filepath, quint32 magic);
+
+  /* Hash of the first bytes of the file */
+  static QByteArray fileHash(const QString& filepath);
+
+  QString cacheDir;
+};
+
+} // namespace xp
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_XP_XPDATACACHE_H
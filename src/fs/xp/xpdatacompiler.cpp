@@ -24,6 +24,8 @@
 #include "fs/xp/xpairportwriter.h"
 #include "fs/xp/xpcifpwriter.h"
 #include "fs/xp/xpairspacewriter.h"
+#include "fs/common/procedurewriter.h"
+#include "fs/xp/xplinereader.h"
 #include "fs/xp/scenerypacks.h"
 #include "fs/common/magdecreader.h"
 #include "sql/sqldatabase.h"
@@ -39,6 +41,7 @@
 #include "fs/common/airportindex.h"
 #include "fs/common/metadatawriter.h"
 #include "fs/navdatabaseerrors.h"
+#include "util/trace.h"
 
 #include <QFileInfo>
 #include <QDir>
@@ -48,6 +51,10 @@
 #include <QRegularExpression>
 #include <QStandardPaths>
 #include <QTextCodec>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QThread>
 
 using atools::sql::SqlQuery;
 using atools::sql::SqlUtil;
@@ -79,6 +86,186 @@ const static QRegularExpression CIFP_MATCH("^[A-Z0-9]{3,8}$");
 // 1100 Version - data cycle 1709, build 20170910, metadata AwyXP1101. Copyright (c) 2017 Navdata Provider
 static QRegularExpression CYCLE_MATCH("data\\s+cycle\\s+([0-9]+)");
 
+namespace {
+
+/* Reads and converts all procedure lines of a CIFP file in a pool thread. Does not access the database,
+ * options or the airport index. */
+class CifpReadTask :
+  public QRunnable
+{
+public:
+  CifpReadTask(const XpWriterContext& contextParam)
+    : context(contextParam)
+  {
+    setAutoDelete(false);
+  }
+
+  virtual void run() override
+  {
+    try
+    {
+      read();
+    }
+    catch(std::exception& e)
+    {
+      error = e.what();
+      hasError = true;
+    }
+    catch(...)
+    {
+      error = "Unknown exception";
+      hasError = true;
+    }
+    done.release();
+  }
+
+  void waitForDone()
+  {
+    done.acquire();
+  }
+
+  /* Context has line number of error if any */
+  XpWriterContext context;
+  QVector<atools::fs::common::ProcedureInput> procedures;
+  qint64 fileSize = 0L;
+  QString error;
+  bool hasError = false;
+
+private:
+  void read()
+  {
+    if(!CIFP_MATCH.match(context.cifpAirportIdent).hasMatch())
+      throw atools::Exception("CIFP file has no valid name which should match airport ident.");
+
+    QFile file(context.filePath);
+    if(!file.open(QIODevice::ReadOnly))
+      throw atools::Exception("Cannot open file. Reason: " + file.errorString() + ".");
+    fileSize = file.size();
+
+    XpLineReader reader;
+    reader.open(&file);
+
+    QStringList fields;
+    atools::fs::common::ProcedureInput procInput;
+    context.lineNumber = 1;
+    while(!reader.atEnd() && !reader.lineEquals("99"))
+    {
+      reader.readLine();
+      if(!reader.isLineEmpty())
+      {
+        reader.split(fields, ',');
+
+        // Extract colon separated row code
+        QString first = fields.takeFirst();
+        QStringList rowCode = first.split(":");
+        if(rowCode.size() == 2)
+        {
+          fields.prepend(rowCode.at(1));
+          fields.prepend(rowCode.at(0));
+        }
+
+        if(XpCifpWriter::toProcedureInput(procInput, fields, context))
+          procedures.append(procInput);
+      }
+      context.lineNumber++;
+    }
+  }
+
+  QSemaphore done;
+};
+
+/* Reads and tokenizes a whole dat file like apt.dat in a pool thread. Comments and empty lines are skipped.
+ * Does not access the database, options or writers. */
+class DatReadTask :
+  public QRunnable
+{
+public:
+  DatReadTask(const QString& filepathParam, ContextFlags flagsParam)
+    : filepath(filepathParam), flags(flagsParam)
+  {
+    setAutoDelete(false);
+  }
+
+  virtual void run() override
+  {
+    try
+    {
+      read();
+    }
+    catch(std::exception& e)
+    {
+      error = e.what();
+      hasError = true;
+    }
+    catch(...)
+    {
+      error = "Unknown exception";
+      hasError = true;
+    }
+    done.release();
+  }
+
+  void waitForDone()
+  {
+    done.acquire();
+  }
+
+  QString filepath, header, error;
+  ContextFlags flags;
+  qint64 fileSize = 0L;
+
+  /* Line number after header or of error */
+  int lineNum = 1;
+  bool hasError = false;
+
+  /* Fields and line numbers of all lines not being comments or empty */
+  QVector<QStringList> lines;
+  QVector<int> lineNumbers;
+
+private:
+  void read()
+  {
+    QFile file(filepath);
+    if(!file.open(QIODevice::ReadOnly))
+      throw atools::Exception("Cannot open file. Reason: " + file.errorString() + ".");
+    fileSize = file.size();
+
+    XpLineReader reader;
+    reader.open(&file);
+
+    // Byte order identifier
+    reader.readLine();
+    lineNum++;
+
+    // Metadata and copyright
+    reader.readLine();
+    lineNum++;
+    header = reader.line();
+
+    int headerLineNum = lineNum;
+    while(!reader.atEnd() && !reader.lineEquals("99"))
+    {
+      reader.readLine();
+      if(!reader.lineStartsWith("#") && !reader.isLineEmpty())
+      {
+        QStringList fields;
+        reader.split(fields, ' ');
+        if(!fields.isEmpty())
+        {
+          lines.append(fields);
+          lineNumbers.append(lineNum);
+        }
+      }
+      lineNum++;
+    }
+    lineNum = headerLineNum;
+  }
+
+  QSemaphore done;
+};
+
+} // namespace
+
 XpDataCompiler::XpDataCompiler(sql::SqlDatabase& sqlDb, const NavDatabaseOptions& opts,
                                ProgressHandler *progressHandler, NavDatabaseErrors *navdatabaseErrors)
   : options(opts), db(sqlDb), progress(progressHandler), errors(navdatabaseErrors)
@@ -99,6 +286,9 @@ XpDataCompiler::XpDataCompiler(sql::SqlDatabase& sqlDb, const NavDatabaseOptions
   metadataWriter = new MetadataWriter(db);
   magDecReader = new MagDecReader();
 
+  if(!options.getXpNavdataCachePath().isEmpty())
+    dataCache = new XpDataCache(options.getXpNavdataCachePath());
+
   initQueries();
 }
 
@@ -178,12 +368,21 @@ bool XpDataCompiler::compileCustomApt()
   // X-Plane 11/Custom Scenery/KSEA Demo Area/Earth nav data/apt.dat
   // X-Plane 11/Custom Scenery/LFPG Paris - Charles de Gaulle/Earth Nav data/apt.dat
   QStringList localFindCustomAptDatFiles = findCustomAptDatFiles(options, errors, progress);
-  for(const QString& aptdat : localFindCustomAptDatFiles)
+
+  if(options.isParallelAptDat())
   {
-    // Only one progress report per file
-    if(readDataFile(aptdat, 1, airportWriter, IS_ADDON | READ_SHORT_REPORT, 1))
+    if(readDataFilesParallel(localFindCustomAptDatFiles, airportWriter, IS_ADDON | READ_SHORT_REPORT))
       return true;
   }
+  else
+  {
+    for(const QString& aptdat : localFindCustomAptDatFiles)
+    {
+      // Only one progress report per file
+      if(readDataFile(aptdat, 1, airportWriter, IS_ADDON | READ_SHORT_REPORT, 1))
+        return true;
+    }
+  }
   db.commit();
   return false;
 }
@@ -315,28 +514,109 @@ bool XpDataCompiler::compileDefaultApt()
 
 bool XpDataCompiler::compileCifp()
 {
-  QStringList cifpFiles = findCifpFiles(options);
+  QStringList cifpFiles;
+  for(const QString& file : findCifpFiles(options))
+  {
+    // Check filters here since regular expressions in options are not thread safe
+    if(options.isIncludedFilename(file) && includeFile(QFileInfo(file)))
+      cifpFiles.append(file);
+  }
 
   int rowsPerStep =
     static_cast<int>(std::ceil(static_cast<float>(cifpFiles.size()) / static_cast<float>(NUM_REPORT_STEPS_CIFP)));
-  int row = 0, steps = 0;
+  int steps = 0;
+  bool aborted = false;
+
+  // Parse files in a thread pool and write them in the original order in this thread ===========
+  int numThreads = std::max(1, QThread::idealThreadCount());
+  int maxQueued = numThreads * 4;
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(numThreads);
 
-  for(const QString& file : cifpFiles)
+  QVector<CifpReadTask *> tasks(cifpFiles.size(), nullptr);
+  int nextTask = 0;
+
+  for(int i = 0; i < cifpFiles.size() && !aborted; i++)
   {
-    if(options.isIncludedFilename(file))
+    // Fill queue - airport index is not thread safe and is read only here
+    for(; nextTask < cifpFiles.size() && nextTask < i + maxQueued; nextTask++)
     {
-      if(readDataFile(file, 1, cifpWriter, READ_CIFP | READ_SHORT_REPORT, 0))
-        return true;
+      QFileInfo fileinfo(cifpFiles.at(nextTask));
+
+      XpWriterContext context;
+      context.curFileId = curFileId;
+      context.fileName = fileinfo.fileName();
+      context.filePath = fileinfo.filePath();
+      context.localPath = QDir(options.getBasepath()).relativeFilePath(fileinfo.path());
+      context.flags = READ_CIFP | READ_SHORT_REPORT | flagsFromOptions();
+      context.magDecReader = magDecReader;
+      context.cifpAirportIdent = fileinfo.baseName().toUpper();
+      context.cifpAirportId = airportIndex->getAirportId(context.cifpAirportIdent).toInt();
+
+      tasks[nextTask] = new CifpReadTask(context);
+      pool.start(tasks.at(nextTask));
+    }
+
+    CifpReadTask *task = tasks.at(i);
+    task->waitForDone();
+
+    progress->incBytesRead(task->fileSize);
+
+    try
+    {
+      // Write procedures read up to an error to keep the behavior of the serial reader
+      for(const atools::fs::common::ProcedureInput& procInput : task->procedures)
+        cifpWriter->writeProcedureInput(procInput);
+
+      if(task->hasError)
+        throw atools::Exception(task->error);
+
+      cifpWriter->finish(task->context);
+    }
+    catch(std::exception& e)
+    {
+      QString filepath = task->context.filePath;
+      int lineNum = task->context.lineNumber;
 
-      if((row % rowsPerStep) == 0)
+      if(errors != nullptr)
+      {
+        progress->reportError();
+        errors->sceneryErrors.first().fileErrors.append({filepath, e.what(), lineNum});
+        qWarning() << Q_FUNC_INFO << "Error in file" << filepath << "line" << lineNum << ":" << e.what();
+      }
+      else
       {
-        progress->reportOther(tr("Reading: %1").arg(file));
-        steps++;
+        cifpWriter->reset();
+        pool.clear();
+        pool.waitForDone();
+        qDeleteAll(tasks);
+
+        // Enrich error message and rethrow a new one
+        throw atools::Exception(QString("Caught exception in file \"%1\" in line %2. Message: %3").
+                                arg(filepath).arg(lineNum).arg(e.what()));
       }
-      row++;
+    }
+    cifpWriter->reset();
+
+    delete task;
+    tasks[i] = nullptr;
+
+    if((i % rowsPerStep) == 0)
+    {
+      aborted = progress->reportOther(tr("Reading: %1").arg(cifpFiles.at(i)));
+      steps++;
     }
   }
 
+  // Remove tasks not started yet in case of abort and wait for running ones before deleting
+  pool.clear();
+  pool.waitForDone();
+  qDeleteAll(tasks);
+
+  if(aborted)
+    return true;
+
   // Consume remaining progress steps
   progress->increaseCurrent(NUM_REPORT_STEPS_CIFP - steps);
 
@@ -417,7 +697,11 @@ bool XpDataCompiler::compileUserFix()
 
 bool XpDataCompiler::compileMagDeclBgl()
 {
-  magDecReader->readFromWmm();
+  if(options.getSharedMagDecReader() != nullptr)
+    // Calculated only once for all compilations
+    magDecReader->readFromReader(*options.getSharedMagDecReader());
+  else
+    magDecReader->readFromWmm();
   magDecReader->writeToTable(db);
   db.commit();
   return false;
@@ -426,9 +710,10 @@ bool XpDataCompiler::compileMagDeclBgl()
 bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWriter *writer,
                                   atools::fs::xp::ContextFlags flags, int numReportSteps)
 {
+  ATOOLS_TRACE_SCOPE("XpDataCompiler::readDataFile", "xplane");
+
   QFile file;
-  QTextStream stream;
-  stream.setCodec("UTF-8");
+  XpLineReader reader;
   bool aborted = false;
 
   QString progressMsg = tr("Reading: %1").arg(filepath);
@@ -441,14 +726,35 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
     // Clear add-on flag if directory is excluded
     flags &= ~atools::fs::xp::IS_ADDON;
 
+  // Use cache only for the large navdata files which have the cycle in the header
+  bool useCache = dataCache != nullptr && flags & UPDATE_CYCLE && !(flags & READ_CIFP) && !(flags & READ_AIRSPACE);
+  XpDataCache::LineVector cachedLines;
+  QString header;
+
+  if(useCache && dataCache->load(filepath, header, cachedLines))
+    return readCachedDataFile(fileinfo, header, cachedLines, writer, flags, numReportSteps);
+
+  // Build airport index while reading if not found in cache
+  XpAptIndex *aptIndex = nullptr;
+  if(dataCache != nullptr && writer == airportWriter)
+  {
+    XpAptIndex& index = aptIndexes[fileinfo.absoluteFilePath()];
+    if(!dataCache->loadAptIndex(filepath, index))
+      aptIndex = &index;
+  }
+
   int lineNum = 1, totalNumLines, fileVersion = 0;
 
   try
   {
     // Open file and read header
-    if(openFile(stream, file, filepath, flags, lineNum, totalNumLines, fileVersion))
+    if(openFile(reader, file, filepath, flags, lineNum, totalNumLines, fileVersion, &header))
     {
+      if(useCache)
+        cachedLines.reserve(totalNumLines);
+
       // qInfo() << "=P==== Opened:" << filepath;
+      progress->incBytesRead(fileinfo.size());
 
       XpWriterContext context;
       context.curFileId = curFileId;
@@ -477,7 +783,6 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
         context.cifpAirportId = airportIndex->getAirportId(context.cifpAirportIdent).toInt();
       }
 
-      QString line;
       QStringList fields;
 
       QElapsedTimer timer;
@@ -492,9 +797,9 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
       int row = 0, steps = 0;
 
       // Read lines
-      while(!stream.atEnd() && line != "99")
+      while(!reader.atEnd() && !reader.lineEquals("99"))
       {
-        line = stream.readLine().trimmed();
+        reader.readLine();
 
         if(!(flags & READ_SHORT_REPORT) && numReportSteps > 0)
         {
@@ -512,26 +817,23 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
           }
         }
 
-        if(flags & READ_AIRSPACE && !line.startsWith("AN"))
-        {
+        if(flags & READ_AIRSPACE && !reader.lineStartsWith("AN"))
           // Strip OpenAirport file comments except for airport names
-          int idx = line.indexOf("*");
-          if(idx != -1)
-            line = line.left(line.indexOf("*"));
-        }
+          reader.truncateLine('*');
         else if(!(flags & READ_CIFP))
         {
-          // Strip dat-file comments
-          if(line.startsWith("#"))
-            line.clear();
+          // Skip dat-file comments
+          if(reader.lineStartsWith("#"))
+          {
+            lineNum++;
+            continue;
+          }
         }
 
-        if(!line.isEmpty())
+        if(!reader.isLineEmpty())
         {
-          if(flags & READ_CIFP)
-            fields = line.split(",");
-          else
-            fields = line.simplified().split(" ");
+          // Convert only fields to strings
+          reader.split(fields, flags & READ_CIFP ? ',' : ' ');
 
           if(fields.size() >= minColumns)
           {
@@ -548,8 +850,16 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
             }
             context.lineNumber = lineNum;
 
+            if(aptIndex != nullptr && fields.size() > 4 &&
+               (fields.first() == "1" || fields.first() == "16" || fields.first() == "17"))
+              // Land airport, seaplane base or heliport header
+              aptIndex->startAirport(fields.at(4), reader.linePos(), lineNum);
+
             // Call writer
             writer->write(fields, context);
+
+            if(useCache)
+              cachedLines.append({lineNum, fields});
           }
         }
         lineNum++;
@@ -557,14 +867,135 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
       if(!aborted)
         writer->finish(context);
 
+      if(aptIndex != nullptr)
+      {
+        // Last airport ends at the terminating "99" line or the end of file
+        if(reader.lineEquals("99"))
+          aptIndex->finish(reader.linePos(), lineNum - 1);
+        else
+          aptIndex->finish(reader.filePos(), lineNum);
+      }
+
+      reader.close();
       file.close();
 
+      if(useCache && !aborted)
+        dataCache->save(filepath, header, cachedLines);
+
+      if(aptIndex != nullptr)
+      {
+        if(aborted)
+          aptIndex->clear();
+        else
+          dataCache->saveAptIndex(filepath, *aptIndex);
+      }
+
       if(!(flags & READ_SHORT_REPORT) && numReportSteps > 0)
         // Eat up any remaining progress steps
         progress->increaseCurrent(numReportSteps - steps);
     }
   }
   catch(std::exception& e)
+  {
+    // Do not keep incomplete index
+    if(aptIndex != nullptr)
+      aptIndex->clear();
+
+    if(errors != nullptr)
+    {
+      progress->reportError();
+      errors->sceneryErrors.first().fileErrors.append({fileinfo.filePath(), e.what(), lineNum});
+      qWarning() << Q_FUNC_INFO << "Error in file" << fileinfo.filePath() << "line" << lineNum << ":" << e.what();
+    }
+    else
+    {
+      writer->reset();
+      // Enrich error message and rethrow a new one
+      throw atools::Exception(QString("Caught exception in file \"%1\" in line %2. Message: %3").
+                              arg(fileinfo.filePath()).arg(lineNum).arg(e.what()));
+    }
+  }
+  writer->reset();
+  return aborted;
+}
+
+const XpAptIndex *XpDataCompiler::getAptIndex(const QString& filepath) const
+{
+  auto it = aptIndexes.constFind(QFileInfo(filepath).absoluteFilePath());
+  return it != aptIndexes.constEnd() && !it.value().isEmpty() ? &it.value() : nullptr;
+}
+
+bool XpDataCompiler::readCachedDataFile(const QFileInfo& fileinfo, const QString& header,
+                                        const XpDataCache::LineVector& lines, XpWriter *writer,
+                                        atools::fs::xp::ContextFlags flags, int numReportSteps)
+{
+  bool aborted = false;
+  QString progressMsg = tr("Reading: %1").arg(fileinfo.filePath());
+
+  // Header is in the third line after byte order mark
+  int lineNum = 3, fileVersion = 0;
+
+  try
+  {
+    progress->incBytesRead(fileinfo.size());
+    readHeader(header, fileinfo.filePath(), flags, lineNum, fileVersion);
+
+    XpWriterContext context;
+    context.curFileId = curFileId;
+    context.fileName = fileinfo.fileName();
+    context.filePath = fileinfo.filePath();
+    context.localPath = QDir(options.getBasepath()).relativeFilePath(fileinfo.path());
+    context.flags = flags | flagsFromOptions();
+    context.fileVersion = fileVersion;
+    context.magDecReader = magDecReader;
+
+    if(flags & READ_SHORT_REPORT && numReportSteps > 0)
+    {
+      if(progress->reportOther(progressMsg))
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 elapsed = timer.elapsed();
+
+    int rowsPerStep = 0;
+    if(numReportSteps > 0)
+      rowsPerStep = static_cast<int>(std::ceil(static_cast<float>(lines.size()) /
+                                               static_cast<float>(numReportSteps)));
+    int row = 0, steps = 0;
+
+    for(const XpDataCache::Line& line : lines)
+    {
+      if(!(flags & READ_SHORT_REPORT) && numReportSteps > 0)
+      {
+        if((row++ % rowsPerStep) == 0)
+        {
+          qint64 elapsed2 = timer.elapsed();
+
+          // Update only every 500 ms - otherwise update only progress count
+          bool silent = !(elapsed + MIN_PROGRESS_REPORT_MS < elapsed2);
+          if(!silent)
+            elapsed = elapsed2;
+          steps++;
+          if((aborted = progress->reportOther(progressMsg, -1, silent)) == true)
+            break;
+        }
+      }
+
+      lineNum = line.lineNumber;
+      context.lineNumber = lineNum;
+      writer->write(line.fields, context);
+    }
+
+    if(!aborted)
+      writer->finish(context);
+
+    if(!(flags & READ_SHORT_REPORT) && numReportSteps > 0)
+      // Eat up any remaining progress steps
+      progress->increaseCurrent(numReportSteps - steps);
+  }
+  catch(std::exception& e)
   {
     if(errors != nullptr)
     {
@@ -584,72 +1015,148 @@ bool XpDataCompiler::readDataFile(const QString& filepath, int minColumns, XpWri
   return aborted;
 }
 
-bool XpDataCompiler::openFile(QTextStream& stream, QFile& filepath, const QString& filename,
+bool XpDataCompiler::readDataFilesParallel(const QStringList& filepaths, XpWriter *writer, ContextFlags flags)
+{
+  // Build task list in the main thread since options and file filters are not thread safe
+  QVector<DatReadTask *> tasks;
+  for(const QString& filepath : filepaths)
+  {
+    QFileInfo fileinfo(filepath);
+    if(includeFile(fileinfo))
+    {
+      ContextFlags fileFlags = flags;
+      if(!options.isAddonDirectory(fileinfo.absolutePath()))
+        // Clear add-on flag if directory is excluded
+        fileFlags &= ~atools::fs::xp::IS_ADDON;
+      tasks.append(new DatReadTask(filepath, fileFlags));
+    }
+  }
+
+  // Limit number of files kept in memory
+  int numThreads = std::max(1, QThread::idealThreadCount());
+  int maxQueued = numThreads * 2;
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(numThreads);
+
+  bool aborted = false;
+  int nextTask = 0;
+  for(int i = 0; i < tasks.size() && !aborted; i++)
+  {
+    for(; nextTask < tasks.size() && nextTask < i + maxQueued; nextTask++)
+      pool.start(tasks.at(nextTask));
+
+    DatReadTask *task = tasks.at(i);
+    task->waitForDone();
+
+    QFileInfo fileinfo(task->filepath);
+    int lineNum = task->lineNum;
+
+    // Write the file in order in this thread =====================
+    try
+    {
+      if(task->hasError)
+        throw atools::Exception(task->error);
+
+      int fileVersion = 0;
+      readHeader(task->header, task->filepath, task->flags, lineNum, fileVersion);
+      progress->incBytesRead(task->fileSize);
+
+      XpWriterContext context;
+      context.curFileId = curFileId;
+      context.fileName = fileinfo.fileName();
+      context.filePath = fileinfo.filePath();
+      context.localPath = QDir(options.getBasepath()).relativeFilePath(fileinfo.path());
+      context.flags = task->flags | flagsFromOptions();
+      context.fileVersion = fileVersion;
+      context.magDecReader = magDecReader;
+
+      // One progress report per file
+      if((aborted = progress->reportOther(tr("Reading: %1").arg(task->filepath))) == false)
+      {
+        for(int j = 0; j < task->lines.size(); j++)
+        {
+          context.lineNumber = lineNum = task->lineNumbers.at(j);
+          writer->write(task->lines.at(j), context);
+        }
+        writer->finish(context);
+      }
+    }
+    catch(std::exception& e)
+    {
+      if(errors != nullptr)
+      {
+        progress->reportError();
+        errors->sceneryErrors.first().fileErrors.append({fileinfo.filePath(), e.what(), lineNum});
+        qWarning() << Q_FUNC_INFO << "Error in file" << fileinfo.filePath() << "line" << lineNum << ":" << e.what();
+      }
+      else
+      {
+        writer->reset();
+        pool.clear();
+        pool.waitForDone();
+        qDeleteAll(tasks);
+
+        // Enrich error message and rethrow a new one
+        throw atools::Exception(QString("Caught exception in file \"%1\" in line %2. Message: %3").
+                                arg(fileinfo.filePath()).arg(lineNum).arg(e.what()));
+      }
+    }
+    writer->reset();
+
+    // Free memory early
+    delete task;
+    tasks[i] = nullptr;
+  }
+
+  // Remove tasks not started yet in case of abort and wait for running ones before deleting
+  pool.clear();
+  pool.waitForDone();
+  qDeleteAll(tasks);
+
+  return aborted;
+}
+
+bool XpDataCompiler::openFile(XpLineReader& reader, QFile& filepath, const QString& filename,
                               atools::fs::xp::ContextFlags flags,
-                              int& lineNum, int& totalNumLines, int& fileVersion)
+                              int& lineNum, int& totalNumLines, int& fileVersion, QString *header)
 {
   filepath.setFileName(filename);
   lineNum = 1;
+  totalNumLines = 0;
 
-  if(filepath.open(QIODevice::ReadOnly | QIODevice::Text))
+  if(filepath.open(QIODevice::ReadOnly))
   {
     if(flags & READ_AIRSPACE)
     {
       // Try to detect code using the BOM for airspaces only - use ANSI as fallback
-      stream.setDevice(&filepath);
+      // Files are small - decode all into memory
+      QTextStream stream(&filepath);
       stream.setCodec(atools::codecForFile(filepath, QTextCodec::codecForName("Windows-1252")));
+      stream.setAutoDetectUnicode(true);
+      reader.open(stream.readAll());
     }
     else
-    {
-      stream.setDevice(&filepath);
-      stream.setCodec("UTF-8");
-    }
-    stream.setAutoDetectUnicode(true);
-
-    QString line;
+      // UTF-8 is read directly from the mapped file
+      reader.open(&filepath);
 
     if(!(flags & READ_CIFP) && !(flags & READ_AIRSPACE))
     {
       // Read file header =============================
       // Byte order identifier
-      line = stream.readLine();
+      reader.readLine();
       lineNum++;
-      qInfo() << line;
+      qInfo() << reader.line();
 
       // Metadata and copyright
-      line = stream.readLine();
+      reader.readLine();
       lineNum++;
-      qInfo() << line;
-
-      QStringList fields = line.simplified().split(" ");
-      if(!fields.isEmpty())
-        fileVersion = fields.first().toInt();
+      readHeader(reader.line(), filename, flags, lineNum, fileVersion);
+      if(header != nullptr)
+        *header = reader.line();
 
-      if(!fields.isEmpty() && fileVersion < minFileVersion)
-      {
-        qWarning() << "Version of" << filename << "is" << fields.first() << "but expected a minimum of" <<
-          minFileVersion;
-        throw atools::Exception(QString("Found file version %1. Minimum supported is %2.").
-                                arg(fields.first()).arg(minFileVersion));
-      }
-
-      metadataWriter->writeFile(filename, QString(), curSceneryId, ++curFileId);
-      progress->incNumFiles();
-
-      if(flags & UPDATE_CYCLE)
-        updateAiracCycleFromHeader(line, filename, lineNum);
-
-      qDebug() << "Counting lines for" << filename;
-      qint64 pos = stream.pos();
-      int lines = 0;
-      while(!stream.atEnd())
-      {
-        stream.readLine();
-        lines++;
-      }
-      totalNumLines = lines;
-      stream.seek(pos);
-      qDebug() << lines;
+      totalNumLines = reader.countRemainingLines();
+      qDebug() << "Counted lines for" << filename << totalNumLines;
     }
     else
     {
@@ -662,6 +1169,30 @@ bool XpDataCompiler::openFile(QTextStream& stream, QFile& filepath, const QStrin
   return true;
 }
 
+void XpDataCompiler::readHeader(const QString& header, const QString& filename, ContextFlags flags, int lineNum,
+                                int& fileVersion)
+{
+  qInfo() << header;
+
+  QStringList fields = header.simplified().split(" ");
+  if(!fields.isEmpty())
+    fileVersion = fields.first().toInt();
+
+  if(!fields.isEmpty() && fileVersion < minFileVersion)
+  {
+    qWarning() << "Version of" << filename << "is" << fields.first() << "but expected a minimum of" <<
+      minFileVersion;
+    throw atools::Exception(QString("Found file version %1. Minimum supported is %2.").
+                            arg(fields.first()).arg(minFileVersion));
+  }
+
+  metadataWriter->writeFile(filename, QString(), curSceneryId, ++curFileId);
+  progress->incNumFiles();
+
+  if(flags & UPDATE_CYCLE)
+    updateAiracCycleFromHeader(header, filename, lineNum);
+}
+
 void XpDataCompiler::close()
 {
 
@@ -695,6 +1226,9 @@ void XpDataCompiler::close()
   delete metadataWriter;
   metadataWriter = nullptr;
 
+  delete dataCache;
+  dataCache = nullptr;
+
   deInitQueries();
 }
 
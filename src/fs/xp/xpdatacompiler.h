@@ -19,10 +19,11 @@
 #define ATOOLS_XP_DATAWRITER_H
 
 #include "fs/xp/xpconstants.h"
+#include "fs/xp/xpdatacache.h"
+#include "fs/xp/xpaptindex.h"
 
 #include <QApplication>
 
-class QTextStream;
 class QFile;
 class QFileInfo;
 
@@ -53,6 +54,7 @@ class XpAirportWriter;
 class XpCifpWriter;
 class XpAirspaceWriter;
 class XpWriter;
+class XpLineReader;
 class AirwayPostProcess;
 
 /*
@@ -210,17 +212,35 @@ public:
     return airacCycle;
   }
 
+  /* Airport index of an apt.dat file loaded from the navdata cache or built while reading the file.
+   * Null if not available or cache is disabled. */
+  const atools::fs::xp::XpAptIndex *getAptIndex(const QString& filepath) const;
+
 private:
   void initQueries();
   void deInitQueries();
 
-  /* Open file and read header */
-  bool openFile(QTextStream& stream, QFile& filepath, const QString& filename, ContextFlags flags,
-                int& lineNum, int& totalNumLines, int& fileVersion);
+  /* Open file and read header. Header line is copied to header if not null. */
+  bool openFile(atools::fs::xp::XpLineReader& reader, QFile& filepath, const QString& filename, ContextFlags flags,
+                int& lineNum, int& totalNumLines, int& fileVersion, QString *header = nullptr);
 
   /* Read file line by line and call writer for each one */
   bool readDataFile(const QString& filepath, int minColumns, atools::fs::xp::XpWriter *writer,
                     atools::fs::xp::ContextFlags flags, int numReportSteps);
+
+  /* Read and tokenize files in a thread pool and call writer for each line in the order of the list.
+   * Behaves like readDataFile() with one progress report per file. */
+  bool readDataFilesParallel(const QStringList& filepaths, atools::fs::xp::XpWriter *writer,
+                             atools::fs::xp::ContextFlags flags);
+
+  /* Call writer for each line loaded from the navdata cache. Behaves like readDataFile(). */
+  bool readCachedDataFile(const QFileInfo& fileinfo, const QString& header,
+                          const atools::fs::xp::XpDataCache::LineVector& lines, atools::fs::xp::XpWriter *writer,
+                          atools::fs::xp::ContextFlags flags, int numReportSteps);
+
+  /* Check version in file header, add file to metadata and update cycle if requested */
+  void readHeader(const QString& header, const QString& filename, ContextFlags flags, int lineNum, int& fileVersion);
+
   static QString buildBasePath(const NavDatabaseOptions& opts);
 
   /* FInd custom apt.dat like X-Plane 11/Custom Scenery/LFPG Paris - Charles de Gaulle/Earth Nav data/apt.dat */
@@ -264,11 +284,15 @@ private:
   atools::fs::common::AirportIndex *airportIndex = nullptr;
   atools::fs::common::MagDecReader *magDecReader = nullptr;
   atools::fs::common::MetadataWriter *metadataWriter = nullptr;
+  atools::fs::xp::XpDataCache *dataCache = nullptr; // Null if disabled
 
   int minFileVersion = 850;
   atools::fs::NavDatabaseErrors *errors = nullptr;
   QString airacCycle;
 
+  /* Airport indexes of apt.dat files by absolute file path. Only filled if the cache is enabled. */
+  QHash<QString, atools::fs::xp::XpAptIndex> aptIndexes;
+
 };
 
 } // namespace xp
@@ -0,0 +1,215 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "fs/xp/xplinereader.h"
+
+#include <QFile>
+
+#include <cstring>
+
+namespace atools {
+namespace fs {
+namespace xp {
+
+XpLineReader::XpLineReader()
+{
+
+}
+
+XpLineReader::~XpLineReader()
+{
+  close();
+}
+
+void XpLineReader::open(QFile *file)
+{
+  close();
+
+  basePos = file->pos();
+  qint64 fileSize = file->size() - basePos;
+  if(fileSize > 0)
+    mapped = file->map(file->pos(), fileSize);
+
+  if(mapped != nullptr)
+  {
+    mappedFile = file;
+    data = reinterpret_cast<const char *>(mapped);
+    size = fileSize;
+  }
+  else
+  {
+    // Fall back to reading the whole file
+    buffer = file->readAll();
+    data = buffer.constData();
+    size = buffer.size();
+  }
+
+  // Skip UTF-8 byte order mark
+  if(size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    pos = 3;
+}
+
+void XpLineReader::open(const QString& text)
+{
+  close();
+  buffer = text.toUtf8();
+  data = buffer.constData();
+  size = buffer.size();
+}
+
+void XpLineReader::close()
+{
+  if(mappedFile != nullptr && mapped != nullptr)
+    mappedFile->unmap(mapped);
+
+  mappedFile = nullptr;
+  mapped = nullptr;
+  buffer.clear();
+  data = lineData = nullptr;
+  size = pos = lineStart = basePos = 0L;
+  lineSize = 0;
+}
+
+bool XpLineReader::seek(qint64 filePosition)
+{
+  qint64 newPos = filePosition - basePos;
+  if(newPos < 0 || newPos > size)
+    return false;
+
+  pos = lineStart = newPos;
+  lineData = nullptr;
+  lineSize = 0;
+  return true;
+}
+
+bool XpLineReader::readLine()
+{
+  if(atEnd())
+  {
+    lineData = nullptr;
+    lineSize = 0;
+    return false;
+  }
+
+  lineStart = pos;
+  const char *start = data + pos;
+  const char *end = static_cast<const char *>(std::memchr(start, '\n', static_cast<size_t>(size - pos)));
+  if(end == nullptr)
+    end = data + size;
+
+  pos = end - data + 1;
+
+  // Trim whitespace including carriage return
+  while(start < end && isSpace(*start))
+    start++;
+  while(end > start && isSpace(*(end - 1)))
+    end--;
+
+  lineData = start;
+  lineSize = static_cast<int>(end - start);
+  return true;
+}
+
+int XpLineReader::countRemainingLines() const
+{
+  int lines = 0;
+  const char *cur = data + pos, *end = data + size;
+  while(cur < end)
+  {
+    const char *next = static_cast<const char *>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+    lines++;
+    if(next == nullptr)
+      break;
+    cur = next + 1;
+  }
+  return lines;
+}
+
+bool XpLineReader::lineStartsWith(const char *str) const
+{
+  size_t len = std::strlen(str);
+  return static_cast<size_t>(lineSize) >= len && std::memcmp(lineData, str, len) == 0;
+}
+
+bool XpLineReader::lineEquals(const char *str) const
+{
+  size_t len = std::strlen(str);
+  return static_cast<size_t>(lineSize) == len && std::memcmp(lineData, str, len) == 0;
+}
+
+void XpLineReader::truncateLine(char c)
+{
+  const char *found = static_cast<const char *>(std::memchr(lineData, c, static_cast<size_t>(lineSize)));
+  if(found != nullptr)
+  {
+    lineSize = static_cast<int>(found - lineData);
+    while(lineSize > 0 && isSpace(lineData[lineSize - 1]))
+      lineSize--;
+  }
+}
+
+void XpLineReader::split(QStringList& fields, char separator) const
+{
+  int num = 0;
+  const char *cur = lineData, *end = lineData + lineSize;
+
+  if(separator == ' ')
+  {
+    while(cur < end)
+    {
+      while(cur < end && isSpace(*cur))
+        cur++;
+
+      const char *start = cur;
+      while(cur < end && !isSpace(*cur))
+        cur++;
+
+      if(cur > start)
+        setField(fields, num++, start, static_cast<int>(cur - start));
+    }
+  }
+  else
+  {
+    while(true)
+    {
+      const char *next = static_cast<const char *>(std::memchr(cur, separator, static_cast<size_t>(end - cur)));
+      if(next == nullptr)
+      {
+        setField(fields, num++, cur, static_cast<int>(end - cur));
+        break;
+      }
+      setField(fields, num++, cur, static_cast<int>(next - cur));
+      cur = next + 1;
+    }
+  }
+
+  while(fields.size() > num)
+    fields.removeLast();
+}
+
+void XpLineReader::setField(QStringList& fields, int index, const char *data, int len)
+{
+  if(index < fields.size())
+    fields[index] = QString::fromUtf8(data, len);
+  else
+    fields.append(QString::fromUtf8(data, len));
+}
+
+} // namespace xp
+} // namespace fs
+} // namespace atools
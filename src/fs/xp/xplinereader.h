@@ -0,0 +1,129 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_FS_XP_LINEREADER_H
+#define ATOOLS_FS_XP_LINEREADER_H
+
+#include <QByteArray>
+#include <QStringList>
+
+class QFile;
+
+namespace atools {
+namespace fs {
+namespace xp {
+
+/*
+ * Fast line reader for X-Plane dat and CIFP files. Works on the raw UTF-8 bytes of a memory mapped file
+ * and avoids the UTF-16 conversion of whole lines, trimming and splitting done by QTextStream and QString.
+ * Only the fields of a line are converted to QString when splitting.
+ *
+ * Current line is only valid until the next call of readLine().
+ */
+class XpLineReader
+{
+public:
+  XpLineReader();
+  ~XpLineReader();
+
+  XpLineReader(const XpLineReader& other) = delete;
+  XpLineReader& operator=(const XpLineReader& other) = delete;
+
+  /* Memory maps the opened file or reads it into memory if mapping is not possible. Skips a UTF-8 BOM. */
+  void open(QFile *file);
+
+  /* Use already decoded text. Converts to UTF-8 internally. */
+  void open(const QString& text);
+
+  void close();
+
+  bool atEnd() const
+  {
+    return pos >= size;
+  }
+
+  /* Read next line and remove line end and leading and trailing whitespace. Returns false if at end. */
+  bool readLine();
+
+  /* Number of lines from current position to the end of the file */
+  int countRemainingLines() const;
+
+  /* Byte offset of the current line in the file */
+  qint64 linePos() const
+  {
+    return basePos + lineStart;
+  }
+
+  /* Byte offset of the next line in the file */
+  qint64 filePos() const
+  {
+    return basePos + pos;
+  }
+
+  /* Move to the given byte offset in the file which has to be the start of a line. Returns false if out of range. */
+  bool seek(qint64 filePosition);
+
+  /* Current line as QString - creates a copy */
+  QString line() const
+  {
+    return QString::fromUtf8(lineData, lineSize);
+  }
+
+  bool isLineEmpty() const
+  {
+    return lineSize == 0;
+  }
+
+  bool lineStartsWith(const char *str) const;
+  bool lineEquals(const char *str) const;
+
+  /* Cut current line at first occurrence of character c and remove trailing whitespace */
+  void truncateLine(char c);
+
+  /*
+   * Split current line into fields. Reuses the strings in the list.
+   * If separator is a space, all whitespace sequences are treated as one separator like QString::simplified().
+   * Otherwise empty fields are kept like QString::split() does.
+   */
+  void split(QStringList& fields, char separator) const;
+
+private:
+  static bool isSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  static void setField(QStringList& fields, int index, const char *data, int len);
+
+  QFile *mappedFile = nullptr;
+  uchar *mapped = nullptr;
+  QByteArray buffer;
+
+  const char *data = nullptr, *lineData = nullptr;
+  qint64 size = 0L, pos = 0L, lineStart = 0L;
+
+  /* Offset of the mapped or read data in the file */
+  qint64 basePos = 0L;
+  int lineSize = 0;
+};
+
+} // namespace xp
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_XP_LINEREADER_H
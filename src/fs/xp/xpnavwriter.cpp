@@ -111,7 +111,7 @@ void XpNavWriter::writeVor(const QStringList& line, int curFileId, bool dmeOnly)
   insertVorQuery->bindValue(":file_id", curFileId);
   insertVorQuery->bindValue(":ident", at(line, IDENT));
   insertVorQuery->bindValue(":name", line.mid(RW, line.size() - 11).join(" "));
-  insertVorQuery->bindValue(":region", at(line, REGION));
+  insertVorQuery->bindValue(":region", atShared(line, REGION));
   insertVorQuery->bindValue(":type", type);
   insertVorQuery->bindValue(":frequency", frequency * 10);
   insertVorQuery->bindValue(":mag_var", at(line, MAGVAR).toFloat());
@@ -171,7 +171,7 @@ void XpNavWriter::writeNdb(const QStringList& line, int curFileId, const XpWrite
   insertNdbQuery->bindValue(":file_id", curFileId);
   insertNdbQuery->bindValue(":ident", at(line, IDENT));
   insertNdbQuery->bindValue(":name", line.mid(RW, line.size() - 11).join(" "));
-  insertNdbQuery->bindValue(":region", at(line, REGION));
+  insertNdbQuery->bindValue(":region", atShared(line, REGION));
   insertNdbQuery->bindValue(":type", type);
   insertNdbQuery->bindValue(":frequency", at(line, FREQ).toInt() * 100);
   insertNdbQuery->bindValue(":range", range);
@@ -202,7 +202,7 @@ void XpNavWriter::writeMarker(const QStringList& line, int curFileId, NavRowCode
 
   insertMarkerQuery->bindValue(":marker_id", ++curMarkerId);
   insertMarkerQuery->bindValue(":file_id", curFileId);
-  insertMarkerQuery->bindValue(":region", at(line, REGION));
+  insertMarkerQuery->bindValue(":region", atShared(line, REGION));
   insertMarkerQuery->bindValue(":type", type);
   insertMarkerQuery->bindValue(":ident", at(line, IDENT));
   insertMarkerQuery->bindValue(":heading", at(line, HDG).toFloat());
@@ -241,7 +241,7 @@ void XpNavWriter::writeIls(const QStringList& line, int curFileId, const XpWrite
   insertIlsQuery->bindValue(":loc_heading", at(line, HDG).toFloat());
   insertIlsQuery->bindValue(":ident", ilsIdent);
   insertIlsQuery->bindValue(":loc_airport_ident", airportIdent);
-  insertIlsQuery->bindValue(":region", at(line, REGION));
+  insertIlsQuery->bindValue(":region", atShared(line, REGION));
   insertIlsQuery->bindValue(":loc_runway_name", runwayName);
   insertIlsQuery->bindValue(":name", line.mid(NAME).join(" ").toUpper());
   insertIlsQuery->bindValue(":loc_runway_end_id", airportIndex->getRunwayEndId(airportIdent, runwayName));
@@ -20,6 +20,7 @@
 
 #include "exception.h"
 #include "fs/xp/xpconstants.h"
+#include "util/stringinterner.h"
 
 #include <QStringList>
 
@@ -72,6 +73,13 @@ protected:
                               QString(": Index out of bounds: Index: %1, size: %2").arg(index).arg(line.size()));
   }
 
+  /* Same as at() but returns an instance shared by the whole compilation for values repeating often like regions.
+   * Avoids keeping a copy for each row. */
+  QString atShared(const QStringList& line, int index)
+  {
+    return atools::util::intern(at(line, index));
+  }
+
   QString mid(const QStringList& line, int index, bool ignoreError = false)
   {
     if(index < line.size())
@@ -0,0 +1,297 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+// Allow vectorization of loops containing conditional expressions for all build types.
+// Has to be placed before includes to allow inlining of standard library functions
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("tree-vectorize", "no-trapping-math")
+#endif
+
+#include "geo/batchcalculations.h"
+
+#include "geo/calculations.h"
+#include "geo/pos.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace atools {
+namespace geo {
+
+namespace {
+
+const float PI_F = static_cast<float>(M_PI);
+const float PI_2_F = PI_F / 2.f;
+const float DEG_TO_RAD_F = PI_F / 180.f;
+const float RAD_TO_DEG_F = 180.f / PI_F;
+const float EARTH_RADIUS_METER_F = Pos::EARTH_RADIUS_METER_FLOAT;
+
+/* Number of positions copied into local arrays at once */
+const int CHUNK_SIZE = 256;
+
+/* Sine for x in range [-pi, pi]. Mirrors into range [-pi/2, pi/2] and uses Taylor series. Error below 1e-7. */
+inline float sinApprox(float x)
+{
+  x = x > PI_2_F ? PI_F - x : (x < -PI_2_F ? -PI_F - x : x);
+  float x2 = x * x;
+
+  float poly = -2.505210839e-8f;
+  poly = poly * x2 + 2.755731922e-6f;
+  poly = poly * x2 - 1.984126984e-4f;
+  poly = poly * x2 + 8.333333333e-3f;
+  poly = poly * x2 - 1.666666667e-1f;
+  return x + x * x2 * poly;
+}
+
+/* Cosine for x in range [-pi, pi] */
+inline float cosApprox(float x)
+{
+  return sinApprox(PI_2_F - std::abs(x));
+}
+
+/* Square root for x >= 0 based on the inverse square root bit approximation and three Newton iterations.
+ * Relative error below 1e-7. Avoids std::sqrt which is not vectorized by GCC if errno has to be set. */
+inline float sqrtApprox(float x)
+{
+  qint32 bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  bits = 0x5f3759df - (bits >> 1);
+
+  float inv;
+  std::memcpy(&inv, &bits, sizeof(inv));
+
+  float halfX = 0.5f * x;
+  inv = inv * (1.5f - halfX * inv * inv);
+  inv = inv * (1.5f - halfX * inv * inv);
+  inv = inv * (1.5f - halfX * inv * inv);
+  return x * inv;
+}
+
+/* Arc sine for x in range [0, 1]. Uses Taylor series for small values to avoid cancellation and
+ * Abramowitz/Stegun 4.4.46 otherwise. Error below 1e-7. */
+inline float asinApprox(float x)
+{
+  float x2 = x * x;
+  float small = 105.f / 3456.f;
+  small = small * x2 + 15.f / 336.f;
+  small = small * x2 + 3.f / 40.f;
+  small = small * x2 + 1.f / 6.f;
+  small = x + x * x2 * small;
+
+  float large = -0.0012624911f;
+  large = large * x + 0.0066700901f;
+  large = large * x - 0.0170881256f;
+  large = large * x + 0.0308918810f;
+  large = large * x - 0.0501743046f;
+  large = large * x + 0.0889789874f;
+  large = large * x - 0.2145988016f;
+  large = large * x + 1.5707963050f;
+  large = PI_2_F - sqrtApprox(std::max(1.f - x, 0.f)) * large;
+
+  return x < 0.1f ? small : large;
+}
+
+/* Arc tangent of y/x in range [-pi, pi] using a minimax polynomial for the first octant. Error below 1e-5. */
+inline float atan2Approx(float y, float x)
+{
+  float absX = std::abs(x), absY = std::abs(y);
+  float t = std::min(absX, absY) / std::max(std::max(absX, absY), 1.e-30f);
+  float t2 = t * t;
+
+  float poly = -0.01172120f;
+  poly = poly * t2 + 0.05265332f;
+  poly = poly * t2 - 0.11643287f;
+  poly = poly * t2 + 0.19354346f;
+  poly = poly * t2 - 0.33262347f;
+  poly = poly * t2 + 0.99997726f;
+  float r = t * poly;
+
+  r = absY > absX ? PI_2_F - r : r;
+  r = x < 0.f ? PI_F - r : r;
+  return y < 0.f ? -r : r;
+}
+
+/* Coordinates in degree for a chunk of positions in separate arrays. Invalid positions have null
+ * coordinates and valid set to false. Differences are taken in degree before converting to radians
+ * to avoid losing precision for short distances. */
+struct Chunk
+{
+  float lon1[CHUNK_SIZE], lat1[CHUNK_SIZE], lon2[CHUNK_SIZE], lat2[CHUNK_SIZE];
+  bool valid[CHUNK_SIZE];
+};
+
+/* Copy coordinates of num positions into chunk arrays */
+inline void gather(float *lon, float *lat, bool *valid, const Pos *positions, int num)
+{
+  for(int i = 0; i < num; i++)
+  {
+    const Pos& pos = positions[i];
+    bool ok = pos.isValid();
+    valid[i] = valid[i] && ok;
+    lon[i] = ok ? pos.getLonX() : 0.f;
+    lat[i] = ok ? pos.getLatY() : 0.f;
+  }
+}
+
+/* Fill first coordinates of chunk with origin */
+inline void fillOrigin(Chunk& chunk, const Pos& origin, int num)
+{
+  std::fill(chunk.lon1, chunk.lon1 + num, origin.getLonX());
+  std::fill(chunk.lat1, chunk.lat1 + num, origin.getLatY());
+  std::fill(chunk.valid, chunk.valid + num, true);
+}
+
+/* Set result to invalid where chunk is not valid. Keeps conditions on the bool array out of the kernel loops
+ * which would prevent vectorization. */
+inline void setInvalid(float *result, const Chunk& chunk, int num)
+{
+  for(int i = 0; i < num; i++)
+  {
+    if(!chunk.valid[i])
+      result[i] = INVALID_FLOAT;
+  }
+}
+
+/* Great circle distance between first and second coordinates. Haversine formula which uses the distance to
+ * the antipode for long distances to keep precision. */
+void distanceKernel(float *result, const Chunk& chunk, int num)
+{
+  for(int i = 0; i < num; i++)
+  {
+    float halfDLon = (chunk.lon1[i] - chunk.lon2[i]) * (DEG_TO_RAD_F * 0.5f);
+    float sinLat = sinApprox((chunk.lat1[i] - chunk.lat2[i]) * (DEG_TO_RAD_F * 0.5f));
+    float sinLon = sinApprox(halfDLon);
+    float cosLat = cosApprox(chunk.lat1[i] * DEG_TO_RAD_F) * cosApprox(chunk.lat2[i] * DEG_TO_RAD_F);
+    float a = sinLat * sinLat + cosLat * sinLon * sinLon;
+
+    // Same for the antipode of the second position
+    float sinLatAnti = sinApprox((chunk.lat1[i] + chunk.lat2[i]) * (DEG_TO_RAD_F * 0.5f));
+    float cosLon = cosApprox(halfDLon);
+    float b = std::min(sinLatAnti * sinLatAnti + cosLat * cosLon * cosLon, 1.f);
+
+    float angle = a < 0.5f ? 2.f * asinApprox(sqrtApprox(a)) : PI_F - 2.f * asinApprox(sqrtApprox(b));
+    result[i] = angle * EARTH_RADIUS_METER_F;
+  }
+}
+
+/* Initial course from first to second coordinates in degree */
+void courseKernel(float *result, const Chunk& chunk, int num)
+{
+  for(int i = 0; i < num; i++)
+  {
+    float dLon = chunk.lon2[i] - chunk.lon1[i];
+    dLon = (dLon > 180.f ? dLon - 360.f : (dLon < -180.f ? dLon + 360.f : dLon)) * DEG_TO_RAD_F;
+    float lat1 = chunk.lat1[i] * DEG_TO_RAD_F, lat2 = chunk.lat2[i] * DEG_TO_RAD_F;
+    float sinHalfDLon = sinApprox(dLon * 0.5f);
+
+    // cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(dLon) rewritten to avoid cancellation for short distances
+    float cosLat2 = cosApprox(lat2);
+    float course = atan2Approx(sinApprox(dLon) * cosLat2,
+                               sinApprox((chunk.lat2[i] - chunk.lat1[i]) * DEG_TO_RAD_F) +
+                               2.f * sinApprox(lat1) * cosLat2 * sinHalfDLon * sinHalfDLon);
+    course = course < 0.f ? course + 2.f * PI_F : course;
+    result[i] = course * RAD_TO_DEG_F;
+  }
+}
+
+} // namespace
+
+void batchDistanceMeter(float *distances, const Pos& origin, const Pos *positions, int size)
+{
+  if(!origin.isValid())
+  {
+    std::fill(distances, distances + size, INVALID_FLOAT);
+    return;
+  }
+
+  Chunk chunk;
+  for(int start = 0; start < size; start += CHUNK_SIZE)
+  {
+    int num = std::min(CHUNK_SIZE, size - start);
+    fillOrigin(chunk, origin, num);
+    gather(chunk.lon2, chunk.lat2, chunk.valid, positions + start, num);
+    distanceKernel(distances + start, chunk, num);
+    setInvalid(distances + start, chunk, num);
+  }
+}
+
+void batchDistanceMeter(QVector<float>& distances, const Pos& origin, const QVector<Pos>& positions)
+{
+  distances.resize(positions.size());
+  batchDistanceMeter(distances.data(), origin, positions.constData(), positions.size());
+}
+
+void batchSegmentLengthMeter(float *lengths, const Pos *positions, int size)
+{
+  Chunk chunk;
+  int numSegments = size - 1;
+  for(int start = 0; start < numSegments; start += CHUNK_SIZE)
+  {
+    int num = std::min(CHUNK_SIZE, numSegments - start);
+    std::fill(chunk.valid, chunk.valid + num, true);
+    gather(chunk.lon1, chunk.lat1, chunk.valid, positions + start, num);
+    gather(chunk.lon2, chunk.lat2, chunk.valid, positions + start + 1, num);
+    distanceKernel(lengths + start, chunk, num);
+    setInvalid(lengths + start, chunk, num);
+  }
+}
+
+float batchLengthMeter(const Pos *positions, int size)
+{
+  float lengths[CHUNK_SIZE];
+  float total = 0.f;
+
+  // Process in pieces of chunk size segments which overlap by one position
+  for(int start = 0; start < size - 1; start += CHUNK_SIZE)
+  {
+    int num = std::min(CHUNK_SIZE + 1, size - start);
+    batchSegmentLengthMeter(lengths, positions + start, num);
+
+    for(int i = 0; i < num - 1; i++)
+      total += lengths[i];
+  }
+  return total;
+}
+
+void batchCourseDeg(float *courses, const Pos& origin, const Pos *positions, int size)
+{
+  if(!origin.isValid())
+  {
+    std::fill(courses, courses + size, INVALID_FLOAT);
+    return;
+  }
+
+  Chunk chunk;
+  for(int start = 0; start < size; start += CHUNK_SIZE)
+  {
+    int num = std::min(CHUNK_SIZE, size - start);
+    fillOrigin(chunk, origin, num);
+
+    // Course is not defined for equal positions
+    for(int i = 0; i < num; i++)
+      chunk.valid[i] = !(origin == positions[start + i]);
+
+    gather(chunk.lon2, chunk.lat2, chunk.valid, positions + start, num);
+    courseKernel(courses + start, chunk, num);
+    setInvalid(courses + start, chunk, num);
+  }
+}
+
+} // namespace geo
+} // namespace atools
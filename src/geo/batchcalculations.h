@@ -0,0 +1,61 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_GEO_BATCHCALCULATIONS_H
+#define ATOOLS_GEO_BATCHCALCULATIONS_H
+
+#include <QVector>
+
+namespace atools {
+namespace geo {
+
+class Pos;
+
+/*
+ * Great circle calculations on contiguous arrays of positions. Coordinates are processed in chunks and the
+ * inner loops are written to allow auto vectorization by the compiler (SSE, AVX or NEON).
+ *
+ * Calculations use single precision and polynomial approximations of sine, arc sine and arc tangent.
+ * Distance error is below 1e-5 relative or ten meters absolute and course error below 0.01 degree
+ * compared to the scalar double precision methods in Pos which stay the reference implementation.
+ *
+ * Invalid positions result in INVALID_FLOAT values.
+ */
+
+/* Distances in meter from origin to each of the size positions. */
+void batchDistanceMeter(float *distances, const atools::geo::Pos& origin, const atools::geo::Pos *positions,
+                        int size);
+
+/* Same as above resizing distances to the number of positions */
+void batchDistanceMeter(QVector<float>& distances, const atools::geo::Pos& origin,
+                        const QVector<atools::geo::Pos>& positions);
+
+/* Lengths in meter of the size - 1 segments between consecutive positions */
+void batchSegmentLengthMeter(float *lengths, const atools::geo::Pos *positions, int size);
+
+/* Total length in meter of the line formed by the positions. Invalid positions are not allowed. */
+float batchLengthMeter(const atools::geo::Pos *positions, int size);
+
+/* Initial course in degree true from origin to each of the size positions.
+ * Result is INVALID_FLOAT for positions which are equal to origin like in Pos::angleDegTo(). */
+void batchCourseDeg(float *courses, const atools::geo::Pos& origin, const atools::geo::Pos *positions, int size);
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_BATCHCALCULATIONS_H
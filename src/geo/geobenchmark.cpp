@@ -0,0 +1,307 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "geo/geobenchmark.h"
+
+#include "geo/batchcalculations.h"
+#include "geo/calculations.h"
+#include "geo/line.h"
+#include "geo/linestring.h"
+#include "geo/rect.h"
+#include "geo/spatialindex.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+
+namespace atools {
+namespace geo {
+
+namespace {
+
+/* Number of elements for primitive cases. Do not change to keep results comparable. */
+const static int NUM_PRIMITIVES = 100000;
+
+/* Small deterministic generator independent of the standard library implementation */
+class Random
+{
+public:
+  /* Value in range [min, max) */
+  float value(float min, float max)
+  {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return min + (max - min) * static_cast<float>(state >> 40) / static_cast<float>(1 << 24);
+  }
+
+  Pos pos()
+  {
+    float lonX = value(-180.f, 180.f);
+    return Pos(lonX, value(-85.f, 85.f));
+  }
+
+private:
+  quint64 state = 0x2545f4914f6cdd1dULL;
+};
+
+/* Object for spatial index */
+struct BenchmarkPoint
+{
+  Pos pos;
+
+  const Pos& getPosition() const
+  {
+    return pos;
+  }
+
+};
+
+}
+
+GeoBenchmark::GeoBenchmark()
+{
+  indexSizes = {10000, 100000, 1000000};
+}
+
+void GeoBenchmark::run()
+{
+  results.clear();
+  runPrimitives();
+  for(int size : indexSizes)
+    runIndex(size);
+
+  for(const GeoBenchmarkResult& result : results)
+    qDebug() << Q_FUNC_INFO << result.name << result.precision << result.size
+             << result.nsPerOperation() << "ns/op" << "checksum" << result.checksum;
+}
+
+void GeoBenchmark::runPrimitives()
+{
+  Random random;
+  QVector<Pos> positions1, positions2;
+  for(int i = 0; i < NUM_PRIMITIVES; i++)
+  {
+    positions1.append(random.pos());
+    positions2.append(random.pos());
+  }
+
+  QElapsedTimer timer;
+  GeoBenchmarkResult result;
+  auto finish = [&result, &timer, this](const QString& name, const QString& precision, qint64 operations) -> void {
+                  result.timeNs = timer.nsecsElapsed();
+                  result.name = name;
+                  result.precision = precision;
+                  result.size = NUM_PRIMITIVES;
+                  result.operations = operations;
+                  results.append(result);
+                  result = GeoBenchmarkResult();
+                };
+
+  // Distance ==================================================
+  timer.start();
+  for(int i = 0; i < NUM_PRIMITIVES; i++)
+    result.checksum += positions1.at(i).distanceMeterTo(positions2.at(i));
+  finish("pos_distance", "double", NUM_PRIMITIVES);
+
+  QVector<float> distances(NUM_PRIMITIVES);
+  timer.start();
+  for(int i = 0; i < NUM_PRIMITIVES; i += 1000)
+  {
+    batchDistanceMeter(distances.data(), positions1.at(i), positions2.constData(), NUM_PRIMITIVES);
+    result.checksum += distances.at(i);
+  }
+  finish("batch_distance", "float", static_cast<qint64>(NUM_PRIMITIVES) * (NUM_PRIMITIVES / 1000));
+
+  QVector<Point3D> points1, points2;
+  for(int i = 0; i < NUM_PRIMITIVES; i++)
+  {
+    points1.append(positions1.at(i).toCartesian());
+    points2.append(positions2.at(i).toCartesian());
+  }
+  timer.start();
+  for(int i = 0; i < NUM_PRIMITIVES; i++)
+    result.checksum += points1.at(i).gcDistanceMeter(points2.at(i));
+  finish("point3d_gc_distance", "float", NUM_PRIMITIVES);
+
+  // Endpoint ==================================================
+  timer.start();
+  for(int i = 0; i < NUM_PRIMITIVES; i++)
+    result.checksum += positions1.at(i).endpoint(static_cast<float>(i % 1000) * 1000.f,
+                                                 static_cast<float>(i % 360)).getLatY();
+  finish("pos_endpoint", "double", NUM_PRIMITIVES);
+
+  // Line interpolation and cross track ==================================================
+  QList<Pos> interpolated;
+  timer.start();
+  for(int i = 0; i < NUM_PRIMITIVES / 10; i++)
+  {
+    Line line(positions1.at(i), positions2.at(i));
+    interpolated.clear();
+    line.interpolatePoints(line.lengthMeter(), 50, interpolated);
+    if(!interpolated.isEmpty())
+      result.checksum += interpolated.last().getLonX();
+  }
+  finish("line_interpolate_points", "double", NUM_PRIMITIVES / 10);
+
+  LineDistance lineDistance;
+  timer.start();
+  for(int i = 0; i < NUM_PRIMITIVES - 1; i++)
+  {
+    Line(positions1.at(i), positions2.at(i)).distanceMeterToLine(positions1.at(i + 1), lineDistance);
+    result.checksum += lineDistance.distance;
+  }
+  finish("line_distance_to_line", "double", NUM_PRIMITIVES - 1);
+
+  // Line string length ==================================================
+  LineString lineString;
+  for(int i = 0; i < 1000; i++)
+    lineString.append(positions1.at(i));
+  timer.start();
+  for(int i = 0; i < 100; i++)
+    result.checksum += lineString.lengthMeter();
+  finish("linestring_length", "double", 100 * 1000);
+
+  timer.start();
+  for(int i = 0; i < 100; i++)
+    result.checksum += batchLengthMeter(lineString.constData(), lineString.size());
+  finish("batch_linestring_length", "float", 100 * 1000);
+
+  // Rectangles ==================================================
+  QVector<Rect> rects, antiMeridianRects;
+  for(int i = 0; i < 1000; i++)
+  {
+    float lonX = random.value(-180.f, 170.f), latY = random.value(-80.f, 80.f);
+    rects.append(Rect(lonX, latY + random.value(0.f, 10.f), lonX + random.value(0.f, 10.f), latY));
+
+    // Rectangles crossing the anti-meridian
+    float west = random.value(170.f, 180.f), east = random.value(-180.f, -170.f);
+    antiMeridianRects.append(Rect(west, latY + random.value(0.f, 10.f), east, latY));
+  }
+
+  timer.start();
+  for(const Rect& rect1 : rects)
+  {
+    for(const Rect& rect2 : rects)
+      result.checksum += rect1.overlaps(rect2);
+  }
+  finish("rect_overlaps", "float", rects.size() * rects.size());
+
+  timer.start();
+  for(const Rect& rect1 : antiMeridianRects)
+  {
+    for(const Rect& rect2 : rects)
+      result.checksum += rect1.overlaps(rect2) + rect2.overlaps(rect1);
+  }
+  finish("rect_overlaps_antimeridian", "float", antiMeridianRects.size() * rects.size() * 2);
+}
+
+void GeoBenchmark::runIndex(int size)
+{
+  Random random;
+  SpatialIndex<BenchmarkPoint> index;
+  for(int i = 0; i < size; i++)
+    index.append({random.pos()});
+
+  QVector<Pos> queries;
+  for(int i = 0; i < 1000; i++)
+    queries.append(random.pos());
+
+  QElapsedTimer timer;
+  GeoBenchmarkResult result;
+  auto finish = [&result, &timer, size, this](const QString& name, qint64 operations) -> void {
+                  result.timeNs = timer.nsecsElapsed();
+                  result.name = name;
+                  result.precision = "float";
+                  result.size = size;
+                  result.operations = operations;
+                  results.append(result);
+                  result = GeoBenchmarkResult();
+                };
+
+  timer.start();
+  index.updateIndex();
+  result.checksum = index.size();
+  finish("index_build", 1);
+
+  timer.start();
+  for(const Pos& pos : queries)
+    result.checksum += index.getNearestIndex(pos);
+  finish("index_nearest", queries.size());
+
+  QVector<int> indexes;
+  timer.start();
+  for(const Pos& pos : queries)
+  {
+    indexes.clear();
+    index.getNearestIndexes(indexes, pos, 10);
+    result.checksum += indexes.size();
+  }
+  finish("index_nearest_10", queries.size());
+
+  SpatialIndexBuffer buffer;
+  timer.start();
+  for(const Pos& pos : queries)
+  {
+    indexes.clear();
+    index.getRadiusIndexes(indexes, pos, atools::geo::nmToMeter(100.f), buffer, [](float, int) -> bool {
+      return true;
+    });
+    result.checksum += indexes.size();
+  }
+  finish("index_radius_100nm", queries.size());
+}
+
+QJsonDocument GeoBenchmark::toJson() const
+{
+  QJsonArray resultArr;
+  for(const GeoBenchmarkResult& result : results)
+  {
+    QJsonObject obj;
+    obj.insert("name", result.name);
+    obj.insert("precision", result.precision);
+    obj.insert("size", result.size);
+    obj.insert("operations", static_cast<double>(result.operations));
+    obj.insert("time_ns", static_cast<double>(result.timeNs));
+    obj.insert("ns_per_op", result.nsPerOperation());
+    obj.insert("checksum", result.checksum);
+    resultArr.append(obj);
+  }
+
+  QJsonObject root;
+  root.insert("results", resultArr);
+  return QJsonDocument(root);
+}
+
+bool GeoBenchmark::writeJson(const QString& filename) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(toJson().toJson(QJsonDocument::Indented));
+    file.close();
+    return true;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << ":" << file.errorString();
+  return false;
+}
+
+} // namespace geo
+} // namespace atools
@@ -0,0 +1,91 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_GEO_GEOBENCHMARK_H
+#define ATOOLS_GEO_GEOBENCHMARK_H
+
+#include <QJsonDocument>
+#include <QVector>
+
+namespace atools {
+namespace geo {
+
+/* Result of one benchmark case */
+struct GeoBenchmarkResult
+{
+  QString name, /* Case name like "pos_distance" */
+          precision; /* "float" or "double" for the internal calculation path */
+  int size = 0; /* Number of input elements */
+  qint64 operations = 0L; /* Number of measured calls */
+  qint64 timeNs = 0L; /* Total wall time */
+  double checksum = 0.; /* Sum of results to detect changed behavior and avoid dead code removal */
+
+  double nsPerOperation() const
+  {
+    return operations > 0 ? static_cast<double>(timeNs) / static_cast<double>(operations) : 0.;
+  }
+
+};
+
+/*
+ * Micro-benchmark for heavily used geo primitives and the spatial index.
+ *
+ * Inputs are generated by a fixed pseudo random generator so runs are comparable across platforms.
+ * Covers distance, endpoint, interpolation, cross track distance, line string length,
+ * rectangle overlap including anti-meridian cases as well as spatial index build and queries.
+ * Both the scalar double precision methods and the single precision batch and cartesian methods are measured.
+ *
+ * Results can be saved as JSON.
+ */
+class GeoBenchmark
+{
+public:
+  GeoBenchmark();
+
+  /* Run all cases. Can be repeated. */
+  void run();
+
+  const QVector<atools::geo::GeoBenchmarkResult>& getResults() const
+  {
+    return results;
+  }
+
+  /* Machine readable report containing all results */
+  QJsonDocument toJson() const;
+
+  /* Write JSON report to file. Returns false on error. */
+  bool writeJson(const QString& filename) const;
+
+  /* Number of points for spatial index cases. Default is 10000, 100000 and 1000000. */
+  void setIndexSizes(const QVector<int>& value)
+  {
+    indexSizes = value;
+  }
+
+private:
+  void runPrimitives();
+  void runIndex(int size);
+
+  QVector<atools::geo::GeoBenchmarkResult> results;
+  QVector<int> indexSizes;
+};
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_GEOBENCHMARK_H
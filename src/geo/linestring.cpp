@@ -200,6 +200,78 @@ void LineString::removeDuplicates()
   removeDuplicates(std::numeric_limits<float>::epsilon());
 }
 
+LineString LineString::simplified(float toleranceMeter) const
+{
+  if(size() < 3 || toleranceMeter <= 0.f)
+    return *this;
+
+  QVector<bool> keep(size(), false);
+  keep[0] = keep[size() - 1] = true;
+
+  // Ranges between kept positions which still have to be checked
+  QVector<std::pair<int, int> > ranges;
+
+  if(isClosed())
+  {
+    // Segment from first to last is degenerated - split at the position farthest from start
+    int farthest = 1;
+    float maxDist = 0.f;
+    for(int i = 1; i < size() - 1; i++)
+    {
+      float dist = first().distanceMeterTo(at(i));
+      if(dist > maxDist)
+      {
+        maxDist = dist;
+        farthest = i;
+      }
+    }
+    keep[farthest] = true;
+    ranges.append(std::make_pair(0, farthest));
+    ranges.append(std::make_pair(farthest, size() - 1));
+  }
+  else
+    ranges.append(std::make_pair(0, size() - 1));
+
+  LineDistance result;
+  while(!ranges.isEmpty())
+  {
+    std::pair<int, int> range = ranges.takeLast();
+    const Pos& start = at(range.first);
+    const Pos& end = at(range.second);
+
+    int maxIndex = -1;
+    float maxDist = toleranceMeter;
+    for(int i = range.first + 1; i < range.second; i++)
+    {
+      // Returns invalid distance for invalid positions which keeps them
+      at(i).distanceMeterToLine(start, end, result);
+      float dist = std::abs(result.distance);
+      if(dist > maxDist)
+      {
+        maxDist = dist;
+        maxIndex = i;
+      }
+    }
+
+    if(maxIndex != -1)
+    {
+      keep[maxIndex] = true;
+      if(maxIndex - range.first > 1)
+        ranges.append(std::make_pair(range.first, maxIndex));
+      if(range.second - maxIndex > 1)
+        ranges.append(std::make_pair(maxIndex, range.second));
+    }
+  }
+
+  LineString line;
+  for(int i = 0; i < size(); i++)
+  {
+    if(keep.at(i))
+      line.append(at(i));
+  }
+  return line;
+}
+
 void LineString::distanceMeterToLineString(const Pos& pos, LineDistance& result, int *index) const
 {
   LineDistance lineResult, closestLineResult;
@@ -93,6 +93,11 @@ public:
   void removeDuplicates(float epsilon);
   void removeDuplicates();
 
+  /* Douglas-Peucker simplification. No removed position is farther than toleranceMeter from the resulting line.
+   * First and last positions are kept. Closed line strings stay closed.
+   * Invalid positions are always kept. */
+  atools::geo::LineString simplified(float toleranceMeter) const;
+
   /* Calculate status, cross track distance and more to this line. */
   void distanceMeterToLineString(const atools::geo::Pos& pos, atools::geo::LineDistance& result,
                                  int *index = nullptr) const;
@@ -0,0 +1,55 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "geo/linestringlod.h"
+
+namespace atools {
+namespace geo {
+
+LineStringLod::LineStringLod(const LineString& line, float minToleranceMeter, float factor, int maxLevels)
+{
+  levels.append(line);
+  tolerances.append(0.f);
+
+  float tolerance = minToleranceMeter;
+  for(int i = 1; i < maxLevels && levels.last().size() > 2; i++, tolerance *= factor)
+  {
+    // Errors add up since each level is built from the previous one - use only the remaining tolerance
+    LineString simplified = levels.last().simplified(tolerance - tolerances.last());
+
+    // Skip levels which do not remove positions
+    if(simplified.size() < levels.last().size())
+    {
+      levels.append(simplified);
+      tolerances.append(tolerance);
+    }
+  }
+}
+
+const LineString& LineStringLod::getLine(float toleranceMeter) const
+{
+  for(int i = levels.size() - 1; i > 0; i--)
+  {
+    if(tolerances.at(i) <= toleranceMeter)
+      return levels.at(i);
+  }
+  return getFullLine();
+}
+
+} // namespace geo
+} // namespace atools
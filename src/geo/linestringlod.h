@@ -0,0 +1,89 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_GEO_LINESTRINGLOD_H
+#define ATOOLS_GEO_LINESTRINGLOD_H
+
+#include "geo/linestring.h"
+
+namespace atools {
+namespace geo {
+
+/*
+ * Level of detail pyramid for a line string like an airspace boundary or a track.
+ *
+ * Level zero is the full resolution line. Each further level is simplified with a tolerance
+ * multiplied by factor. Levels which do not remove any positions are skipped.
+ * Levels are simplified from the previous one with the remaining tolerance, so the error of each
+ * level stays below its tolerance.
+ */
+class LineStringLod
+{
+public:
+  LineStringLod()
+  {
+  }
+
+  /* minToleranceMeter: Tolerance of level one.
+   * factor: Tolerance multiplier for each following level.
+   * maxLevels: Maximum number of levels including the full resolution line. */
+  explicit LineStringLod(const atools::geo::LineString& line, float minToleranceMeter = 10.f, float factor = 4.f,
+                         int maxLevels = 8);
+
+  /* Get the coarsest line with a tolerance not larger than toleranceMeter.
+   * Use for example a fraction of the size of a screen pixel in meter for drawing. */
+  const atools::geo::LineString& getLine(float toleranceMeter) const;
+
+  /* Full resolution line */
+  const atools::geo::LineString& getFullLine() const
+  {
+    return levels.isEmpty() ? EMPTY_LINESTRING : levels.first();
+  }
+
+  const atools::geo::LineString& getLevel(int level) const
+  {
+    return levels.at(level);
+  }
+
+  /* Maximum error in meter for level */
+  float getLevelTolerance(int level) const
+  {
+    return tolerances.at(level);
+  }
+
+  int getNumLevels() const
+  {
+    return levels.size();
+  }
+
+  bool isEmpty() const
+  {
+    return levels.isEmpty() || levels.first().isEmpty();
+  }
+
+private:
+  QVector<atools::geo::LineString> levels;
+
+  /* Tolerance for each level. Zero for level zero. */
+  QVector<float> tolerances;
+};
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_LINESTRINGLOD_H
@@ -54,7 +54,9 @@
 #include <cstdio>  // for fwrite()
 #include <cstdlib> // for abs()
 #include <functional>
+#include <future>
 #include <limits> // std::reference_wrapper
+#include <mutex>
 #include <stdexcept>
 #include <vector>
 
@@ -545,10 +547,13 @@ struct metric_SO3 : public Metric {
 
 /**  Parameters (see README.md) */
 struct KDTreeSingleIndexAdaptorParams {
-  KDTreeSingleIndexAdaptorParams(size_t _leaf_max_size = 10)
-      : leaf_max_size(_leaf_max_size) {}
+  KDTreeSingleIndexAdaptorParams(size_t _leaf_max_size = 10,
+                                 unsigned int _n_thread_build = 1)
+      : leaf_max_size(_leaf_max_size), n_thread_build(_n_thread_build) {}
 
   size_t leaf_max_size;
+  unsigned int n_thread_build; //!< Number of threads used to build the
+                               //!< static index. 1 builds sequentially.
 };
 
 /** Search options for KDTreeSingleIndexAdaptor::findNeighbors() */
@@ -907,6 +912,85 @@ public:
     return node;
   }
 
+  /**
+   * Same as divideTree() but builds the two sub-trees of the top depth levels
+   * in separate threads. Allocation from the pool is serialized by the mutex.
+   * The resulting tree is identical to the one built by divideTree().
+   */
+  NodePtr divideTreeConcurrent(Derived &obj, const IndexType left,
+                               const IndexType right, BoundingBox &bbox,
+                               int depth, std::mutex &mutex) {
+    // Do not start threads for small sub-trees
+    const IndexType MIN_THREAD_SIZE = 10000;
+
+    NodePtr node;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      node = obj.pool.template allocate<Node>(); // allocate memory
+    }
+
+    /* If too few exemplars remain, then make this a leaf node. */
+    if ((right - left) <= static_cast<IndexType>(obj.m_leaf_max_size)) {
+      node->child1 = node->child2 = NULL; /* Mark as leaf node. */
+      node->node_type.lr.left = left;
+      node->node_type.lr.right = right;
+
+      // compute bounding-box of leaf points
+      for (int i = 0; i < (DIM > 0 ? DIM : obj.dim); ++i) {
+        bbox[i].low = dataset_get(obj, obj.vind[left], i);
+        bbox[i].high = dataset_get(obj, obj.vind[left], i);
+      }
+      for (IndexType k = left + 1; k < right; ++k) {
+        for (int i = 0; i < (DIM > 0 ? DIM : obj.dim); ++i) {
+          if (bbox[i].low > dataset_get(obj, obj.vind[k], i))
+            bbox[i].low = dataset_get(obj, obj.vind[k], i);
+          if (bbox[i].high < dataset_get(obj, obj.vind[k], i))
+            bbox[i].high = dataset_get(obj, obj.vind[k], i);
+        }
+      }
+    } else {
+      IndexType idx;
+      int cutfeat;
+      DistanceType cutval;
+      middleSplit_(obj, &obj.vind[0] + left, right - left, idx, cutfeat, cutval,
+                   bbox);
+
+      node->node_type.sub.divfeat = cutfeat;
+
+      BoundingBox left_bbox(bbox);
+      left_bbox[cutfeat].high = cutval;
+      BoundingBox right_bbox(bbox);
+      right_bbox[cutfeat].low = cutval;
+
+      if (depth > 0 && (right - left) > MIN_THREAD_SIZE) {
+        // Left sub-tree in new thread and right one in this thread
+        std::future<NodePtr> child1 =
+            std::async(std::launch::async, [&, left, idx, depth]() -> NodePtr {
+              return divideTreeConcurrent(obj, left, left + idx, left_bbox,
+                                          depth - 1, mutex);
+            });
+        node->child2 = divideTreeConcurrent(obj, left + idx, right, right_bbox,
+                                            depth - 1, mutex);
+        node->child1 = child1.get();
+      } else {
+        node->child1 = divideTreeConcurrent(obj, left, left + idx, left_bbox, 0,
+                                            mutex);
+        node->child2 = divideTreeConcurrent(obj, left + idx, right, right_bbox,
+                                            0, mutex);
+      }
+
+      node->node_type.sub.divlow = left_bbox[cutfeat].high;
+      node->node_type.sub.divhigh = right_bbox[cutfeat].low;
+
+      for (int i = 0; i < (DIM > 0 ? DIM : obj.dim); ++i) {
+        bbox[i].low = std::min(left_bbox[i].low, right_bbox[i].low);
+        bbox[i].high = std::max(left_bbox[i].high, right_bbox[i].high);
+      }
+    }
+
+    return node;
+  }
+
   void middleSplit_(Derived &obj, IndexType *ind, IndexType count,
                     IndexType &index, int &cutfeat, DistanceType &cutval,
                     const BoundingBox &bbox) {
@@ -1197,9 +1281,19 @@ public:
     if (BaseClassRef::m_size == 0)
       return;
     computeBoundingBox(BaseClassRef::root_bbox);
-    BaseClassRef::root_node =
-        this->divideTree(*this, 0, BaseClassRef::m_size,
-                         BaseClassRef::root_bbox); // construct the tree
+    if (index_params.n_thread_build > 1) {
+      // One thread per sub-tree for the top log2(n_thread_build) levels
+      int depth = 0;
+      while ((1U << depth) < index_params.n_thread_build)
+        depth++;
+      std::mutex mutex;
+      BaseClassRef::root_node = this->divideTreeConcurrent(
+          *this, 0, BaseClassRef::m_size, BaseClassRef::root_bbox, depth,
+          mutex); // construct the tree
+    } else
+      BaseClassRef::root_node =
+          this->divideTree(*this, 0, BaseClassRef::m_size,
+                           BaseClassRef::root_bbox); // construct the tree
   }
 
   /** \name Query methods
@@ -0,0 +1,102 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "geo/packedlinestring.h"
+#include "geo/linestring.h"
+
+#include <cmath>
+
+namespace atools {
+namespace geo {
+
+PackedLineString::PackedLineString(const LineString& line)
+{
+  append(line);
+  squeeze();
+}
+
+void PackedLineString::append(const Pos& pos)
+{
+  qint64 lonX = INVALID_COORD, latY = INVALID_COORD;
+  if(pos.isValid())
+  {
+    lonX = static_cast<qint64>(std::lround(static_cast<double>(pos.getLonX()) * UNITS_PER_DEGREE));
+    latY = static_cast<qint64>(std::lround(static_cast<double>(pos.getLatY()) * UNITS_PER_DEGREE));
+  }
+
+  writeDelta(lonX - lastLonX);
+  writeDelta(latY - lastLatY);
+  lastLonX = lonX;
+  lastLatY = latY;
+  numPositions++;
+}
+
+void PackedLineString::append(const LineString& line)
+{
+  // Rough guess for typical boundary geometry
+  data.reserve(data.size() + line.size() * 4);
+  for(const Pos& pos : line)
+    append(pos);
+}
+
+void PackedLineString::fromLineString(const LineString& line)
+{
+  clear();
+  append(line);
+  squeeze();
+}
+
+LineString PackedLineString::toLineString() const
+{
+  LineString line;
+  toLineString(line);
+  return line;
+}
+
+void PackedLineString::toLineString(LineString& line) const
+{
+  line.clear();
+  line.reserve(numPositions);
+  forEach([&line](const Pos& pos) -> void {
+    line.append(pos);
+  });
+}
+
+void PackedLineString::clear()
+{
+  data.clear();
+  numPositions = 0;
+  lastLonX = lastLatY = 0;
+}
+
+void PackedLineString::writeDelta(qint64 delta)
+{
+  // Zig-zag encoding maps small negative and positive values to small unsigned values
+  quint64 value = (static_cast<quint64>(delta) << 1) ^ static_cast<quint64>(delta >> 63);
+
+  // Seven bits per byte and highest bit set if more bytes follow
+  while(value >= 0x80)
+  {
+    data.append(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  data.append(static_cast<char>(value));
+}
+
+} // namespace geo
+} // namespace atools
@@ -0,0 +1,156 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_GEO_PACKEDLINESTRING_H
+#define ATOOLS_GEO_PACKEDLINESTRING_H
+
+#include "geo/pos.h"
+
+#include <QByteArray>
+
+namespace atools {
+namespace geo {
+
+class LineString;
+
+/*
+ * Compact list of 2D positions for bulk geometry like airspace boundaries or trails kept in memory.
+ *
+ * Coordinates are stored as micro degree fixed point values (about 0.1 meter resolution).
+ * Each value is saved as zig-zag encoded variable length delta to the previous one which needs usually two to six
+ * bytes per position instead of the twelve bytes of Pos. Altitude is not stored.
+ *
+ * Only sequential access is possible. Use forEach() or toLineString() to read positions.
+ * Invalid positions are preserved.
+ */
+class PackedLineString
+{
+public:
+  PackedLineString()
+  {
+  }
+
+  explicit PackedLineString(const atools::geo::LineString& line);
+
+  /* Append one position. Altitude is dropped. */
+  void append(const atools::geo::Pos& pos);
+  void append(const atools::geo::LineString& line);
+
+  /* Replace all positions with the ones from line */
+  void fromLineString(const atools::geo::LineString& line);
+
+  /* Decode all positions */
+  atools::geo::LineString toLineString() const;
+  void toLineString(atools::geo::LineString& line) const;
+
+  /* Calls func(const Pos& pos) for each position in order */
+  template<typename FUNC>
+  void forEach(FUNC func) const;
+
+  void clear();
+
+  /* Release unused memory */
+  void squeeze()
+  {
+    data.squeeze();
+  }
+
+  int size() const
+  {
+    return numPositions;
+  }
+
+  bool isEmpty() const
+  {
+    return numPositions == 0;
+  }
+
+  /* Number of bytes used for encoded coordinates */
+  int getMemoryBytes() const
+  {
+    return data.size();
+  }
+
+  bool operator==(const PackedLineString& other) const
+  {
+    return numPositions == other.numPositions && data == other.data;
+  }
+
+  bool operator!=(const PackedLineString& other) const
+  {
+    return !operator==(other);
+  }
+
+  /* Fixed point units per degree */
+  Q_DECL_CONSTEXPR static double UNITS_PER_DEGREE = 1000000.;
+
+private:
+  /* Read one variable length zig-zag encoded value and advance pointer */
+  static qint64 readDelta(const unsigned char *& ptr)
+  {
+    quint64 value = 0;
+    int shift = 0;
+    unsigned char byte;
+    do
+    {
+      byte = *ptr++;
+      value |= static_cast<quint64>(byte & 0x7f) << shift;
+      shift += 7;
+    } while(byte & 0x80);
+
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+  }
+
+  static atools::geo::Pos toPos(qint64 lonX, qint64 latY)
+  {
+    if(lonX == INVALID_COORD || latY == INVALID_COORD)
+      return atools::geo::EMPTY_POS;
+    else
+      return atools::geo::Pos(static_cast<double>(lonX) / UNITS_PER_DEGREE,
+                              static_cast<double>(latY) / UNITS_PER_DEGREE);
+  }
+
+  void writeDelta(qint64 delta);
+
+  /* Used for invalid positions */
+  Q_DECL_CONSTEXPR static qint64 INVALID_COORD = std::numeric_limits<qint32>::min();
+
+  QByteArray data;
+  int numPositions = 0;
+
+  /* Last appended coordinates needed to calculate the delta for the next one */
+  qint64 lastLonX = 0, lastLatY = 0;
+};
+
+template<typename FUNC>
+void PackedLineString::forEach(FUNC func) const
+{
+  const unsigned char *ptr = reinterpret_cast<const unsigned char *>(data.constData());
+  qint64 lonX = 0, latY = 0;
+  for(int i = 0; i < numPositions; i++)
+  {
+    lonX += readDelta(ptr);
+    latY += readDelta(ptr);
+    func(toPos(lonX, latY));
+  }
+}
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_PACKEDLINESTRING_H
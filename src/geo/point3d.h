@@ -19,6 +19,7 @@
 #define ATOOLS_POINT3D_H
 
 #include <QTypeInfo>
+#include <algorithm>
 #include <cmath>
 
 namespace atools {
@@ -123,15 +124,89 @@ public:
 
 private:
   friend QDebug operator<<(QDebug out, const atools::geo::Point3D& pt);
+  friend class Point3DTarget;
 
   float x, y, z;
   static constexpr float RADIUS2 = 6371.f * 1000.f * 2.f; // 2∗average  radius  of  earth in km
   static constexpr float INV_RADIUS2 = 1.0f / RADIUS2;
 };
 
+/*
+ * Evaluates distances from many points to one fixed target like the A* heuristic to the destination.
+ * Stores the target once and replaces std::asin with a polynomial approximation.
+ *
+ * The chord is calculated from coordinate differences and not from the dot product of normalized vectors
+ * since the latter cancels out in float precision for distances below a few kilometers.
+ *
+ * Error of the approximation is below 2e-8 radians. The result differs from Point3D::gcDistanceMeter()
+ * by less than 5e-6 relative or 5 meters absolute which is the float resolution for long distances.
+ * Use as a heuristic is safe since the error is in the range of the rounding to integer meter costs.
+ */
+class Point3DTarget
+{
+public:
+  Point3DTarget()
+  {
+  }
+
+  explicit Point3DTarget(const Point3D& targetParam) : target(targetParam)
+  {
+  }
+
+  /* Great circle distance from point to target in meters. See class documentation for error bound. */
+  float gcDistanceMeter(const Point3D& point) const
+  {
+    return Point3D::RADIUS2 * asinApprox(std::min(1.f, std::sqrt(target.comparableDistance(point)) *
+                                                  Point3D::INV_RADIUS2));
+  }
+
+  /* Direct tunnel-though distance in meters. Same as Point3D::directDistanceMeter(). */
+  float directDistanceMeter(const Point3D& point) const
+  {
+    return target.directDistanceMeter(point);
+  }
+
+  const Point3D& getTarget() const
+  {
+    return target;
+  }
+
+  bool isValid() const
+  {
+    return target.isValid();
+  }
+
+private:
+  /* Arc sine for x in range [0, 1]. Taylor series for small values to avoid cancellation and
+   * Abramowitz/Stegun 4.4.46 otherwise. Error below 2e-8. */
+  static float asinApprox(float x)
+  {
+    if(x < 0.1f)
+    {
+      float x2 = x * x;
+      return x + x * x2 * (1.f / 6.f + x2 * (3.f / 40.f + x2 * (15.f / 336.f + x2 * (105.f / 3456.f))));
+    }
+    else
+    {
+      float poly = -0.0012624911f;
+      poly = poly * x + 0.0066700901f;
+      poly = poly * x - 0.0170881256f;
+      poly = poly * x + 0.0308918810f;
+      poly = poly * x - 0.0501743046f;
+      poly = poly * x + 0.0889789874f;
+      poly = poly * x - 0.2145988016f;
+      poly = poly * x + 1.5707963050f;
+      return static_cast<float>(M_PI / 2.) - std::sqrt(1.f - x) * poly;
+    }
+  }
+
+  Point3D target;
+};
+
 } // namespace geo
 } // namespace atools
 
 Q_DECLARE_TYPEINFO(atools::geo::Point3D, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(atools::geo::Point3DTarget, Q_PRIMITIVE_TYPE);
 
 #endif // ATOOLS_POINT3D_H
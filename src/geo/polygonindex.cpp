@@ -0,0 +1,214 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "geo/polygonindex.h"
+#include "geo/linestring.h"
+
+#include <cmath>
+#include <functional>
+
+namespace atools {
+namespace geo {
+
+void PolygonIndex::addPolygon(int id, const LineString& line)
+{
+  Polygon polygon;
+  polygon.id = id;
+
+  for(const Pos& pos : line)
+  {
+    if(pos.isValid())
+    {
+      polygon.x.append(pos.getLonX());
+      polygon.y.append(pos.getLatY());
+    }
+  }
+
+  if(polygon.x.size() < 3)
+    // Needs at least a triangle
+    return;
+
+  // Close ring if needed
+  if(polygon.x.first() != polygon.x.last() || polygon.y.first() != polygon.y.last())
+  {
+    polygon.x.append(polygon.x.first());
+    polygon.y.append(polygon.y.first());
+  }
+
+  // Shift negative longitudes if any edge crosses the anti-meridian
+  for(int i = 0; i < polygon.x.size() - 1; i++)
+  {
+    if(std::abs(polygon.x.at(i + 1) - polygon.x.at(i)) > 180.f)
+    {
+      polygon.shifted = true;
+      break;
+    }
+  }
+  if(polygon.shifted)
+  {
+    for(float& lonX : polygon.x)
+    {
+      if(lonX < 0.f)
+        lonX += 360.f;
+    }
+  }
+
+  polygon.west = *std::min_element(polygon.x.constBegin(), polygon.x.constEnd());
+  polygon.east = *std::max_element(polygon.x.constBegin(), polygon.x.constEnd());
+  polygon.south = *std::min_element(polygon.y.constBegin(), polygon.y.constEnd());
+  polygon.north = *std::max_element(polygon.y.constBegin(), polygon.y.constEnd());
+
+  // Use about eight edges per band
+  int numEdges = polygon.x.size() - 1;
+  int numBands = std::max(1, std::min(1024, numEdges / 8));
+  polygon.bandHeight = std::max((polygon.north - polygon.south) / numBands, 1.e-6f);
+
+  // Count edges per band
+  polygon.bandOffsets.fill(0, numBands + 1);
+  for(int i = 0; i < numEdges; i++)
+  {
+    int band1 = polygon.band(std::min(polygon.y.at(i), polygon.y.at(i + 1)));
+    int band2 = polygon.band(std::max(polygon.y.at(i), polygon.y.at(i + 1)));
+    for(int b = band1; b <= band2; b++)
+      polygon.bandOffsets[b + 1]++;
+  }
+
+  // Convert counts to offsets
+  for(int i = 0; i < numBands; i++)
+    polygon.bandOffsets[i + 1] += polygon.bandOffsets.at(i);
+
+  // Fill edge indexes using a running insert position for each band
+  QVector<int> insertPos(polygon.bandOffsets);
+  polygon.bandEdges.resize(polygon.bandOffsets.last());
+  for(int i = 0; i < numEdges; i++)
+  {
+    int band1 = polygon.band(std::min(polygon.y.at(i), polygon.y.at(i + 1)));
+    int band2 = polygon.band(std::max(polygon.y.at(i), polygon.y.at(i + 1)));
+    for(int b = band1; b <= band2; b++)
+      polygon.bandEdges[insertPos[b]++] = i;
+  }
+
+  polygons.append(polygon);
+}
+
+void PolygonIndex::build()
+{
+  int numCells = GRID_ROWS * GRID_COLUMNS;
+  gridOffsets.fill(0, numCells + 1);
+  gridPolygons.clear();
+
+  // Cell ranges for each polygon - columns can wrap around the anti-meridian for shifted polygons
+  auto forEachCell = [](const Polygon& poly, const std::function<void(int cell)>& func) -> void {
+    int rowMin = gridRow(poly.south), rowMax = gridRow(poly.north);
+    int colMin = gridColumn(poly.west);
+    int numCols = std::min(GRID_COLUMNS, static_cast<int>(std::floor((poly.east + 180.f) / GRID_CELL_DEG)) -
+                           static_cast<int>(std::floor((poly.west + 180.f) / GRID_CELL_DEG)) + 1);
+
+    for(int row = rowMin; row <= rowMax; row++)
+    {
+      for(int c = 0; c < numCols; c++)
+        func(row * GRID_COLUMNS + (colMin + c) % GRID_COLUMNS);
+    }
+  };
+
+  // Count polygons per cell
+  for(const Polygon& polygon : polygons)
+    forEachCell(polygon, [this](int cell) -> void {
+      gridOffsets[cell + 1]++;
+    });
+
+  // Convert counts to offsets
+  for(int i = 0; i < numCells; i++)
+    gridOffsets[i + 1] += gridOffsets.at(i);
+
+  // Fill polygon indexes using a running insert position for each cell
+  QVector<int> insertPos(gridOffsets);
+  gridPolygons.resize(gridOffsets.last());
+  for(int i = 0; i < polygons.size(); i++)
+    forEachCell(polygons.at(i), [this, &insertPos, i](int cell) -> void {
+      gridPolygons[insertPos[cell]++] = i;
+    });
+}
+
+void PolygonIndex::clear()
+{
+  polygons.clear();
+  gridPolygons.clear();
+  gridOffsets.clear();
+}
+
+void PolygonIndex::getPolygonIds(QVector<int>& ids, const Pos& pos) const
+{
+  if(!pos.isValid() || gridOffsets.isEmpty())
+    return;
+
+  int cell = gridRow(pos.getLatY()) * GRID_COLUMNS + gridColumn(pos.getLonX());
+  for(int i = gridOffsets.at(cell); i < gridOffsets.at(cell + 1); i++)
+  {
+    const Polygon& polygon = polygons.at(gridPolygons.at(i));
+    if(containsInternal(polygon, pos.getLonX(), pos.getLatY()))
+      ids.append(polygon.id);
+  }
+}
+
+bool PolygonIndex::contains(int index, const Pos& pos) const
+{
+  return pos.isValid() && containsInternal(polygons.at(index), pos.getLonX(), pos.getLatY());
+}
+
+bool PolygonIndex::containsInternal(const Polygon& polygon, float lonX, float latY) const
+{
+  if(polygon.shifted && lonX < 0.f)
+    lonX += 360.f;
+
+  if(lonX < polygon.west || lonX > polygon.east || latY < polygon.south || latY > polygon.north)
+    return false;
+
+  // Even-odd rule with a ray to the east using only edges in the band of the position
+  const float *x = polygon.x.constData(), *y = polygon.y.constData();
+  int band = polygon.band(latY);
+  bool inside = false;
+  for(int i = polygon.bandOffsets.at(band); i < polygon.bandOffsets.at(band + 1); i++)
+  {
+    int e = polygon.bandEdges.at(i);
+    float y1 = y[e], y2 = y[e + 1];
+    if((y1 > latY) != (y2 > latY))
+    {
+      float x1 = x[e], x2 = x[e + 1];
+      if(lonX < x1 + (latY - y1) * (x2 - x1) / (y2 - y1))
+        inside = !inside;
+    }
+  }
+  return inside;
+}
+
+int PolygonIndex::gridRow(float laty)
+{
+  return std::max(0, std::min(GRID_ROWS - 1, static_cast<int>((laty + 90.f) / GRID_CELL_DEG)));
+}
+
+int PolygonIndex::gridColumn(float lonx)
+{
+  // Normalize shifted longitudes
+  if(lonx >= 180.f)
+    lonx -= 360.f;
+  return std::max(0, std::min(GRID_COLUMNS - 1, static_cast<int>((lonx + 180.f) / GRID_CELL_DEG)));
+}
+
+} // namespace geo
+} // namespace atools
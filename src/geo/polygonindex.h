@@ -0,0 +1,121 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_GEO_POLYGONINDEX_H
+#define ATOOLS_GEO_POLYGONINDEX_H
+
+#include <QVector>
+
+#include <algorithm>
+
+namespace atools {
+namespace geo {
+
+class LineString;
+class Pos;
+
+/*
+ * Index for fast point in polygon tests for many polygons like airspace boundaries.
+ *
+ * Polygon bounding rectangles are sorted into a bucket grid of GRID_CELL_DEG cells. Each polygon keeps its
+ * edges sorted into latitude bands. A query checks only the polygons of one grid cell and only the edges of
+ * one band using the even-odd rule in the lon/lat plane.
+ *
+ * Polygons crossing the anti-meridian are supported. Polygons containing a pole are not.
+ *
+ * A built index can be queried from multiple threads.
+ */
+class PolygonIndex
+{
+public:
+  /* Add polygon with a caller defined id like a boundary id. The line string is treated as closed.
+   * Invalid positions are ignored. Geometry can be taken from e.g. BinaryGeometry::getGeometry().
+   * Call build() after adding all polygons. */
+  void addPolygon(int id, const atools::geo::LineString& line);
+
+  /* Build grid after adding polygons */
+  void build();
+
+  void clear();
+
+  /* Appends the ids of all polygons containing pos */
+  void getPolygonIds(QVector<int>& ids, const atools::geo::Pos& pos) const;
+
+  /* true if the polygon with the given internal index contains pos */
+  bool contains(int index, const atools::geo::Pos& pos) const;
+
+  /* Number of polygons */
+  int size() const
+  {
+    return polygons.size();
+  }
+
+  bool isEmpty() const
+  {
+    return polygons.isEmpty();
+  }
+
+  /* Grid cell size in degree */
+  static Q_DECL_CONSTEXPR int GRID_CELL_DEG = 2;
+  static Q_DECL_CONSTEXPR int GRID_COLUMNS = 360 / GRID_CELL_DEG;
+  static Q_DECL_CONSTEXPR int GRID_ROWS = 180 / GRID_CELL_DEG;
+
+private:
+  /* Polygon edges in lon/lat plane. Longitudes of polygons crossing the anti-meridian are shifted by 360 degree
+   * for negative values to get a continuous range. */
+  struct Polygon
+  {
+    int id;
+    bool shifted = false;
+    float west, east, south, north;
+
+    /* Edge i goes from x[i]/y[i] to x[i + 1]/y[i + 1] */
+    QVector<float> x, y;
+
+    /* Latitude bands. Edges overlapping band i are in bandEdges in the range bandOffsets[i] to bandOffsets[i + 1]. */
+    float bandHeight;
+    QVector<int> bandEdges, bandOffsets;
+
+    int numBands() const
+    {
+      return bandOffsets.size() - 1;
+    }
+
+    int band(float latY) const
+    {
+      return std::max(0, std::min(numBands() - 1, static_cast<int>((latY - south) / bandHeight)));
+    }
+  };
+
+  bool containsInternal(const Polygon& polygon, float lonX, float latY) const;
+
+  static int gridRow(float laty);
+  static int gridColumn(float lonx);
+
+  QVector<Polygon> polygons;
+
+  /* Polygon indexes sorted by cell are in gridPolygons and the polygons for cell i
+   * can be found in the range gridOffsets[i] to gridOffsets[i + 1]. */
+  QVector<int> gridPolygons;
+  QVector<int> gridOffsets;
+};
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_POLYGONINDEX_H
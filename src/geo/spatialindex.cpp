@@ -19,6 +19,10 @@
 #include "geo/nanoflann.h"
 #include "geo/pos.h"
 #include "geo/calculations.h"
+#include "geo/linestring.h"
+#include "geo/rect.h"
+
+#include <QThread>
 
 using namespace std;
 using namespace nanoflann;
@@ -28,11 +32,83 @@ namespace atools {
 namespace geo {
 namespace internal {
 
-/* Private wrapper to keep nanoflann structures out of the header */
+/* Half-space in cartesian coordinates defined by normal * point >= offset.
+ * Used to prune KD-tree nodes for corridor and rectangle queries. */
+struct HalfSpace
+{
+  double x, y, z, offset;
+
+  bool contains(const Point3D& pt) const
+  {
+    return x * pt.getX() + y * pt.getY() + z * pt.getZ() >= offset;
+  }
+};
+
+/* Axis aligned bounding box of a KD-tree node */
+struct Box
+{
+  float low[3], high[3];
+
+  /* true if any point of the box can be in the half-space */
+  bool intersects(const HalfSpace& space) const
+  {
+    return space.x * (space.x > 0. ? high[0] : low[0]) +
+           space.y * (space.y > 0. ? high[1] : low[1]) +
+           space.z * (space.z > 0. ? high[2] : low[2]) >= space.offset;
+  }
+};
+
+/* Visits all points in the KD-tree nodes intersecting all half-spaces. Leaf points are not checked. */
+template<typename NODE, typename INDEX, typename FUNC>
+void traverseNode(const NODE *node, const Box& box, const std::vector<INDEX>& vind, const HalfSpace *spaces,
+                  int numSpaces, const FUNC& func)
+{
+  for(int i = 0; i < numSpaces; i++)
+  {
+    if(!box.intersects(spaces[i]))
+      return;
+  }
+
+  if(node->child1 == nullptr && node->child2 == nullptr)
+  {
+    for(size_t i = node->node_type.lr.left; i < node->node_type.lr.right; i++)
+      func(static_cast<int>(vind[i]));
+  }
+  else
+  {
+    // Children boxes are bound by the last coordinate on the left and the first on the right of the split
+    int divfeat = node->node_type.sub.divfeat;
+    Box box1(box), box2(box);
+    box1.high[divfeat] = node->node_type.sub.divlow;
+    box2.low[divfeat] = node->node_type.sub.divhigh;
+    traverseNode(node->child1, box1, vind, spaces, numSpaces, func);
+    traverseNode(node->child2, box2, vind, spaces, numSpaces, func);
+  }
+}
+
+/* Traverse one tree from root */
+template<typename TREE, typename FUNC>
+void traverseTree(const TREE& tree, const HalfSpace *spaces, int numSpaces, const FUNC& func)
+{
+  if(tree.root_node != nullptr && !tree.vind.empty())
+  {
+    Box box;
+    for(int i = 0; i < 3; i++)
+    {
+      box.low[i] = tree.root_bbox[i].low;
+      box.high[i] = tree.root_bbox[i].high;
+    }
+    traverseNode(tree.root_node, box, tree.vind, spaces, numSpaces, func);
+  }
+}
+
+/* Private wrapper to keep nanoflann structures out of the header.
+ * Uses a static KD-tree after a full build and switches to the nanoflann dynamic index
+ * consisting of log n sub-trees once points are inserted or removed. */
 struct DataSource
 {
   DataSource()
-    : index(DIMENSIONS, *this, KDTreeSingleIndexAdaptorParams(MAX_LEAF_SIZE))
+    : index(DIMENSIONS, *this, KDTreeSingleIndexAdaptorParams(MAX_LEAF_SIZE, buildThreads()))
   {
   }
 
@@ -44,21 +120,75 @@ struct DataSource
   void init(int size)
   {
     free();
-    points = new Point3D[static_cast<size_t>(size)];
-    pointsSize = size;
+    points.resize(size);
   }
 
   void free()
   {
-    delete[] points;
-    points = nullptr;
-    pointsSize = 0;
+    freeDynamic();
+    points.clear();
+    points.squeeze();
+  }
+
+  void freeDynamic()
+  {
+    delete dynamicIndex;
+    dynamicIndex = nullptr;
+    removed.clear();
+    numRemoved = 0;
+  }
+
+  /* Switch to dynamic index if not already done. Adds all points to the new dynamic index. */
+  void initDynamic()
+  {
+    if(dynamicIndex == nullptr)
+    {
+      dynamicIndex = new DynamicIndex(DIMENSIONS, *this, KDTreeSingleIndexAdaptorParams(MAX_LEAF_SIZE));
+      removed.fill(false, points.size());
+      numRemoved = 0;
+
+      // Static tree is not needed anymore
+      index.freeIndex(index);
+    }
+  }
+
+  /* Visit all points of the static or dynamic index which are in nodes intersecting all half-spaces.
+   * Removed points are skipped. */
+  template<typename FUNC>
+  void traverse(const HalfSpace *spaces, int numSpaces, const FUNC& func) const
+  {
+    if(dynamicIndex != nullptr)
+    {
+      for(const auto& tree : dynamicIndex->getAllIndices())
+        traverseTree(tree, spaces, numSpaces, [this, &func](int index) -> void {
+          if(!removed.at(index))
+            func(index);
+        });
+    }
+    else
+      traverseTree(index, spaces, numSpaces, func);
+  }
+
+  /* Number of threads for building the static index. Result is the same for any number. */
+  static unsigned int buildThreads()
+  {
+    return static_cast<unsigned int>(std::max(1, QThread::idealThreadCount()));
+  }
+
+  /* Search in static or dynamic index */
+  template<typename RESULTSET>
+  void findNeighbors(RESULTSET& result, const float *pt, const SearchParams& params) const
+  {
+    if(dynamicIndex != nullptr)
+      dynamicIndex->findNeighbors(result, pt, params);
+    else
+      index.findNeighbors(result, pt, params);
   }
 
   // Must return the number of data points
   size_t kdtree_get_point_count() const
   {
-    return static_cast<size_t>(pointsSize);
+    return static_cast<size_t>(points.size());
   }
 
   // Returns the dim'th component of the idx'th point in the class:
@@ -66,12 +196,13 @@ struct DataSource
   // "if/else's" are actually solved at compile time.
   float kdtree_get_pt(const size_t idx, const size_t dim) const
   {
+    const Point3D& pt = points.at(static_cast<int>(idx));
     if(dim == 0)
-      return points[idx].getX();
+      return pt.getX();
     else if(dim == 1)
-      return points[idx].getY();
+      return pt.getY();
     else
-      return points[idx].getZ();
+      return pt.getZ();
   }
 
   // Optional bounding-box computation: return false to default to a standard bbox computation loop.
@@ -86,9 +217,16 @@ struct DataSource
   constexpr static int DIMENSIONS = 3;
   constexpr static int MAX_LEAF_SIZE = 20;
 
-  int pointsSize = 0;
-  Point3D *points = nullptr; // Must be initialized before the index
-  KDTreeSingleIndexAdaptor<L1_Adaptor<float, DataSource>, DataSource, DIMENSIONS, int> index;
+  typedef KDTreeSingleIndexAdaptor<L1_Adaptor<float, DataSource>, DataSource, DIMENSIONS, int> StaticIndex;
+  typedef KDTreeSingleIndexDynamicAdaptor<L1_Adaptor<float, DataSource>, DataSource, DIMENSIONS, int> DynamicIndex;
+
+  QVector<Point3D> points; // Must be initialized before the index
+  StaticIndex index;
+
+  /* Only used after insert or remove */
+  DynamicIndex *dynamicIndex = nullptr;
+  QVector<bool> removed;
+  int numRemoved = 0;
 };
 
 /* Methods *************************************************************************************/
@@ -100,41 +238,54 @@ int SpatialIndexPrivate::nearestPoint(const Pos& pos) const
 
   int resultIndex;
   float resultSqDist;
-  size_t num = p->index.knnSearch(pt, 1, &resultIndex, &resultSqDist);
+  KNNResultSet<float, int> resultSet(1);
+  resultSet.init(&resultIndex, &resultSqDist);
+  p->findNeighbors(resultSet, pt, SearchParams());
 
-  return num == 1 ? static_cast<int>(resultIndex) : -1;
+  return resultSet.size() == 1 ? resultIndex : -1;
 }
 
 void SpatialIndexPrivate::nearestPoints(QVector<int>& indexes, const Pos& pos, int number) const
+{
+  QVector<float> resultSqDist;
+  nearestPoints(indexes, resultSqDist, pos, number);
+}
+
+void SpatialIndexPrivate::nearestPoints(QVector<int>& indexes, QVector<float>& distances, const Pos& pos,
+                                        int number) const
 {
   float pt[3];
   pos.toCartesian(pt[0], pt[1], pt[2]);
 
-  QVector<float> resultSqDist(number);
-  indexes.clear();
-  indexes.fill(0.f, number);
-  size_t numFound = p->index.knnSearch(pt, static_cast<size_t>(number), indexes.data(), resultSqDist.data());
-  indexes.resize(static_cast<int>(numFound));
-}
+  // Resize keeps capacity if vectors are reused
+  indexes.resize(number);
+  distances.resize(number);
+  KNNResultSet<float, int> resultSet(static_cast<size_t>(number));
+  resultSet.init(indexes.data(), distances.data());
+  p->findNeighbors(resultSet, pt, SearchParams());
 
-struct IndexEntry
-{
-  int index;
-  float distance;
-};
+  int numFound = static_cast<int>(resultSet.size());
+  indexes.resize(numFound);
+  distances.resize(numFound);
+}
 
-/* Callback for radius searches. Does min and max distance comparison. All distances in meter. */
+/* Callback for radius searches. Does min and max distance comparison. All distances in meter.
+ * Distances are only collected if a vector is given. */
 class RadiusResults
 {
 public:
-  RadiusResults(QVector<IndexEntry>& resultParam, float radiusMaxParam, const RadiusCallbackType& radiusCallback)
-    : radiusMax(radiusMaxParam), result(resultParam), callback(radiusCallback)
+  typedef float DistanceType;
+  typedef int IndexType;
+
+  RadiusResults(QVector<int>& indexesParam, QVector<float> *distancesParam, float radiusMaxParam,
+                const RadiusCallbackType *radiusCallback)
+    : radiusMax(radiusMaxParam), indexes(indexesParam), distances(distancesParam), callback(radiusCallback)
   {
   }
 
   size_t size() const
   {
-    return static_cast<size_t>(result.size());
+    return static_cast<size_t>(numFound);
   }
 
   bool full() const
@@ -149,8 +300,13 @@ public:
    */
   bool addPoint(float dist, int index)
   {
-    if(dist < radiusMax && (!callback || callback(dist, index)))
-      result.push_back({index, dist});
+    if(dist < radiusMax && (callback == nullptr || (*callback)(dist, index)))
+    {
+      indexes.append(index);
+      if(distances != nullptr)
+        distances->append(dist);
+      numFound++;
+    }
 
     // keep adding points
     return true;
@@ -163,8 +319,10 @@ public:
 
 private:
   float radiusMax;
-  QVector<IndexEntry>& result;
-  RadiusCallbackType callback;
+  int numFound = 0;
+  QVector<int>& indexes;
+  QVector<float> *distances;
+  const RadiusCallbackType *callback;
 };
 
 void SpatialIndexPrivate::pointsInRadius(QVector<int>& indexes, const Pos& origin, float radiusMaxMeter,
@@ -172,23 +330,195 @@ void SpatialIndexPrivate::pointsInRadius(QVector<int>& indexes, const Pos& origi
 {
   float originPtArr[3];
   origin.toCartesian(originPtArr[0], originPtArr[1], originPtArr[2]);
-  Point3D originPt(originPtArr[0], originPtArr[1], originPtArr[2]);
 
-  QVector<IndexEntry> indicesDists;
-  indicesDists.reserve(100000);
-  RadiusResults resultCallback(indicesDists, radiusMaxMeter, callback);
+  // Append indexes directly to the result
+  RadiusResults resultCallback(indexes, nullptr, radiusMaxMeter, callback ? &callback : nullptr);
 
   nanoflann::SearchParams params;
   params.sorted = false;
 
-  int num = static_cast<int>(p->index.radiusSearchCustomCallback(originPtArr, resultCallback, params));
+  p->findNeighbors(resultCallback, originPtArr, params);
+}
+
+void SpatialIndexPrivate::pointsInRadius(QVector<int>& indexes, QVector<float>& distances, const Pos& origin,
+                                         float radiusMaxMeter) const
+{
+  float originPtArr[3];
+  origin.toCartesian(originPtArr[0], originPtArr[1], originPtArr[2]);
 
-  for(int i = 0; i < num; i++)
-    indexes.append(indicesDists.at(i).index);
+  // Clear keeps capacity if vectors are reused
+  indexes.clear();
+  distances.clear();
+  RadiusResults resultCallback(indexes, &distances, radiusMaxMeter, nullptr);
+
+  nanoflann::SearchParams params;
+  params.sorted = false;
+
+  p->findNeighbors(resultCallback, originPtArr, params);
+}
+
+namespace {
+
+void cartesianUnit(double *vec, const Pos& pos)
+{
+  pos.toCartesian(vec[0], vec[1], vec[2]);
+  double len = std::sqrt(vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]);
+  vec[0] /= len;
+  vec[1] /= len;
+  vec[2] /= len;
+}
+
+void crossProduct(double *result, const double *v1, const double *v2)
+{
+  result[0] = v1[1] * v2[2] - v1[2] * v2[1];
+  result[1] = v1[2] * v2[0] - v1[0] * v2[2];
+  result[2] = v1[0] * v2[1] - v1[1] * v2[0];
+}
+
+double dotProduct(const double *v1, const Point3D& pt)
+{
+  return v1[0] * pt.getX() + v1[1] * pt.getY() + v1[2] * pt.getZ();
+}
+
+/* Great circle segment with precalculated planes for corridor searches.
+ * Half-spaces bound the corridor and the caps at the ends by planes. contains() does the exact check. */
+struct CorridorSegment
+{
+  CorridorSegment(const Pos& pos1, const Pos& pos2, double distanceMeter)
+  {
+    cartesianUnit(start, pos1);
+    cartesianUnit(end, pos2);
+
+    // Limit to quarter earth circumference since sine is not monotonic beyond
+    double angle = std::min(distanceMeter / Pos::EARTH_RADIUS_METER, M_PI / 2.);
+    sinDist = std::sin(angle);
+    cosDist = std::cos(angle);
+    double offset = -sinDist * Pos::EARTH_RADIUS_METER;
+
+    crossProduct(normal, start, end);
+    double len = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+    if(len < 1.e-9)
+    {
+      // Points are equal or antipodal - use a cap around the start point
+      point = true;
+      spaces[0] = {start[0], start[1], start[2], cosDist * Pos::EARTH_RADIUS_METER};
+      numSpaces = 1;
+    }
+    else
+    {
+      normal[0] /= len;
+      normal[1] /= len;
+      normal[2] /= len;
+
+      // Tangents at start pointing to end and at end pointing to start
+      crossProduct(startTangent, normal, start);
+      crossProduct(endTangent, end, normal);
+
+      // Slab around the great circle plane and both ends of the segment
+      spaces[0] = {normal[0], normal[1], normal[2], offset};
+      spaces[1] = {-normal[0], -normal[1], -normal[2], offset};
+      spaces[2] = {startTangent[0], startTangent[1], startTangent[2], offset};
+      spaces[3] = {endTangent[0], endTangent[1], endTangent[2], offset};
+      numSpaces = 4;
+    }
+  }
+
+  bool contains(const Point3D& pt) const
+  {
+    double len = std::sqrt(static_cast<double>(pt.getX()) * pt.getX() +
+                           static_cast<double>(pt.getY()) * pt.getY() +
+                           static_cast<double>(pt.getZ()) * pt.getZ());
+    if(len < 1.)
+      // Invalid position at earth center
+      return false;
+
+    if(!point && dotProduct(startTangent, pt) >= 0. && dotProduct(endTangent, pt) >= 0.)
+      // Between start and end - check cross track distance
+      return std::abs(dotProduct(normal, pt)) <= sinDist * len;
+    else
+      // Before start or after end - check distance to end points
+      return dotProduct(start, pt) >= cosDist * len || (!point && dotProduct(end, pt) >= cosDist * len);
+  }
+
+  double start[3], end[3], normal[3], startTangent[3], endTangent[3];
+  double sinDist, cosDist;
+  bool point = false;
+  HalfSpace spaces[4];
+  int numSpaces;
+};
+
+/* Sort indexes from start and remove duplicates */
+void sortUnique(QVector<int>& indexes, int start)
+{
+  std::sort(indexes.begin() + start, indexes.end());
+  indexes.erase(std::unique(indexes.begin() + start, indexes.end()), indexes.end());
+}
+
+} // namespace
+
+void SpatialIndexPrivate::pointsInCorridor(QVector<int>& indexes, const LineString& line, float distanceMeter) const
+{
+  int start = indexes.size();
+
+  // Use a single point if line has only one position
+  int numSegments = std::max(1, line.size() - 1);
+  for(int i = 0; i < numSegments && !line.isEmpty(); i++)
+  {
+    const Pos& pos1 = line.at(i);
+    const Pos& pos2 = line.at(std::min(i + 1, line.size() - 1));
+    if(!pos1.isValid() || !pos2.isValid())
+      continue;
+
+    CorridorSegment segment(pos1, pos2, distanceMeter);
+    p->traverse(segment.spaces, segment.numSpaces, [this, &segment, &indexes](int index) -> void {
+      if(segment.contains(p->points.at(index)))
+        indexes.append(index);
+    });
+  }
+  sortUnique(indexes, start);
+}
+
+void SpatialIndexPrivate::pointsInRect(QVector<int>& indexes, const Rect& rect) const
+{
+  int start = indexes.size();
+  for(const Rect& r : rect.splitAtAntiMeridian())
+  {
+    // Split into parts not wider than 180 degree which allows to use half-spaces for the meridians
+    QVector<std::pair<float, float> > ranges;
+    float west = r.getWest(), east = r.getEast();
+    if(east - west > 180.f)
+      ranges << std::make_pair(west, (west + east) / 2.f) << std::make_pair((west + east) / 2.f, east);
+    else
+      ranges << std::make_pair(west, east);
+
+    double zSouth = Pos::EARTH_RADIUS_METER * sinDeg(static_cast<double>(r.getSouth()));
+    double zNorth = Pos::EARTH_RADIUS_METER * sinDeg(static_cast<double>(r.getNorth()));
+
+    for(const std::pair<float, float>& range : ranges)
+    {
+      double westRad = toRadians(static_cast<double>(range.first)), eastRad = toRadians(static_cast<double>(range.second));
+      HalfSpace spaces[4] = {
+        {0., 0., 1., zSouth},
+        {0., 0., -1., -zNorth},
+        {-std::sin(westRad), std::cos(westRad), 0., 0.},
+        {std::sin(eastRad), -std::cos(eastRad), 0., 0.}
+      };
+
+      p->traverse(spaces, 4, [this, &spaces, &indexes](int index) -> void {
+        const Point3D& pt = p->points.at(index);
+        if(pt.isValid() && spaces[0].contains(pt) && spaces[1].contains(pt) && spaces[2].contains(pt) &&
+           spaces[3].contains(pt))
+          indexes.append(index);
+      });
+    }
+  }
+  sortUnique(indexes, start);
 }
 
 void SpatialIndexPrivate::buildIndex()
 {
+  p->freeDynamic();
   p->index.buildIndex();
 }
 
@@ -197,6 +527,42 @@ void SpatialIndexPrivate::set(const Point3D& point, int index)
   p->points[index] = point;
 }
 
+void SpatialIndexPrivate::insert(const Point3D& point)
+{
+  p->initDynamic();
+  p->points.append(point);
+  p->removed.append(false);
+
+  int index = p->points.size() - 1;
+  p->dynamicIndex->addPoints(index, index);
+}
+
+void SpatialIndexPrivate::remove(int index)
+{
+  p->initDynamic();
+  if(index >= 0 && index < p->removed.size() && !p->removed.at(index))
+  {
+    p->dynamicIndex->removePoint(static_cast<size_t>(index));
+    p->removed[index] = true;
+    p->numRemoved++;
+  }
+}
+
+bool SpatialIndexPrivate::isRemoved(int index) const
+{
+  return p->dynamicIndex != nullptr && p->removed.at(index);
+}
+
+int SpatialIndexPrivate::numRemoved() const
+{
+  return p->numRemoved;
+}
+
+int SpatialIndexPrivate::size() const
+{
+  return p->points.size();
+}
+
 void SpatialIndexPrivate::clear()
 {
   p->free();
@@ -209,7 +575,7 @@ void SpatialIndexPrivate::reserve(int size)
 
 const atools::geo::Point3D *SpatialIndexPrivate::points3D()
 {
-  return p->points;
+  return p->points.constData();
 }
 
 SpatialIndexPrivate::SpatialIndexPrivate()
@@ -227,4 +593,3 @@ SpatialIndexPrivate::~SpatialIndexPrivate()
 } // namespace geo
 } // namespace atools
 
-Q_DECLARE_TYPEINFO(atools::geo::internal::IndexEntry, Q_PRIMITIVE_TYPE);
@@ -19,6 +19,7 @@
 #define ATOOLS_GEO_SPATIALINDEX_H
 
 #include "geo/point3d.h"
+#include "util/parallel.h"
 
 #include <QVector>
 #include <functional>
@@ -27,6 +28,8 @@ namespace atools {
 namespace geo {
 
 class Pos;
+class LineString;
+class Rect;
 template<typename T>
 class SpatialIndex;
 
@@ -34,6 +37,29 @@ class SpatialIndex;
  * after filtering by manhattan distance to origin. */
 typedef std::function<bool (float, int)> RadiusCallbackType;
 
+/* Caller owned buffer for temporary results of radius and nearest searches. Memory is kept between searches
+ * to avoid allocations when doing repeated queries, e.g. once per map frame.
+ * Not thread safe. Use one buffer per thread. */
+class SpatialIndexBuffer
+{
+  template<typename T>
+  friend class atools::geo::SpatialIndex;
+
+public:
+  /* Release memory */
+  void squeeze()
+  {
+    indexes.clear();
+    indexes.squeeze();
+    distances.clear();
+    distances.squeeze();
+  }
+
+private:
+  QVector<int> indexes;
+  QVector<float> distances;
+};
+
 /* Private parts *************************************************************************************/
 
 namespace internal {
@@ -53,8 +79,26 @@ class SpatialIndexPrivate
   void nearestPoints(QVector<int>& indexes, const atools::geo::Pos& pos, int number) const;
   void pointsInRadius(QVector<int>& indexes, const atools::geo::Pos& origin, float radiusMaxMeter,
                       const RadiusCallbackType& callback) const;
+
+  /* Clear vectors and fill with found indexes and distances. Keeps the capacity of the vectors. */
+  void nearestPoints(QVector<int>& indexes, QVector<float>& distances, const atools::geo::Pos& pos,
+                     int number) const;
+  void pointsInRadius(QVector<int>& indexes, QVector<float>& distances, const atools::geo::Pos& origin,
+                      float radiusMaxMeter) const;
+
+  /* Append indexes sorted and without duplicates */
+  void pointsInCorridor(QVector<int>& indexes, const atools::geo::LineString& line, float distanceMeter) const;
+  void pointsInRect(QVector<int>& indexes, const atools::geo::Rect& rect) const;
   void set(const Point3D& point, int index);
   void buildIndex();
+
+  /* Incremental changes. Switch to the dynamic index on first call. */
+  void insert(const Point3D& point);
+  void remove(int index);
+  bool isRemoved(int index) const;
+  int numRemoved() const;
+  int size() const;
+
   void clear();
   void reserve(int size);
   const Point3D *points3D();
@@ -71,6 +115,7 @@ class SpatialIndexPrivate
  * Spatial index wrapping the nanoflann library which uses KD-tree for nearest neighbor search.
  *
  * Changing the underlying vector needs a call of buildIndex() afterwards.
+ * Use insert() and remove() for small changes to an existing index which avoids a full rebuild.
  *
  * Note that squared distance is used internally for lookup and resulting distances are therefore not accurate.
  */
@@ -127,9 +172,85 @@ public:
     p->pointsInRadius(indexes, pos, radiusMaxMeter, RadiusCallbackType());
   }
 
-  /* Rebuild the KD-tree and Point3D vector. Call this after changing the base class vector. */
+  /* Variants of the methods above which do not allocate memory if the buffer and result vectors are reused.
+   * Results are appended to objects or indexes.
+   * filter is any callable with signature bool(float distance, int index) which can be inlined by the compiler.
+   * Distance is the internal manhattan distance. */
+  template<typename FUNC>
+  void getRadius(QVector<T>& objects, const atools::geo::Pos& pos, float radiusMeter, SpatialIndexBuffer& buffer,
+                 FUNC filter) const;
+
+  void getRadius(QVector<T>& objects, const atools::geo::Pos& pos, float radiusMeter,
+                 SpatialIndexBuffer& buffer) const
+  {
+    getRadius(objects, pos, radiusMeter, buffer, [](float, int) -> bool {
+      return true;
+    });
+  }
+
+  template<typename FUNC>
+  void getRadiusIndexes(QVector<int>& indexes, const atools::geo::Pos& pos, float radiusMeter,
+                        SpatialIndexBuffer& buffer, FUNC filter) const;
+
+  /* Calls func(const T& object, float distance) for each object in radius without copying */
+  template<typename FUNC>
+  void forEachInRadius(const atools::geo::Pos& pos, float radiusMeter, SpatialIndexBuffer& buffer, FUNC func) const;
+
+  void getNearest(QVector<T>& objects, const atools::geo::Pos& pos, int number, SpatialIndexBuffer& buffer) const;
+
+  /* Get all objects or indexes within distanceMeter of the great circle segments of line.
+   * Traverses the tree once per segment. Results are appended, sorted by index and contain no duplicates.
+   * distanceMeter is limited to a quarter of the earth circumference. */
+  void getCorridor(QVector<T>& objects, const atools::geo::LineString& line, float distanceMeter) const;
+
+  void getCorridorIndexes(QVector<int>& indexes, const atools::geo::LineString& line, float distanceMeter) const
+  {
+    p->pointsInCorridor(indexes, line, distanceMeter);
+  }
+
+  /* Get all objects or indexes inside the rectangle which can cross the anti-meridian.
+   * Results are appended, sorted by index and contain no duplicates. */
+  void getRect(QVector<T>& objects, const atools::geo::Rect& rect) const;
+
+  void getRectIndexes(QVector<int>& indexes, const atools::geo::Rect& rect) const
+  {
+    p->pointsInRect(indexes, rect);
+  }
+
+  /* Rebuild the KD-tree and Point3D vector. Call this after changing the base class vector.
+   * Large vectors are converted and built using all cores. */
   void updateIndex();
 
+  /* Append object to the vector and add it to the index without a full rebuild.
+   * The index switches to a set of sub-trees on first call which allows insertion in amortized O(log n).
+   * Does a full rebuild if the index is not in sync with the vector. Returns the index of the new object. */
+  int insert(const T& obj);
+
+  /* Exclude object from all search results. The object stays in the vector to keep indexes stable. */
+  void remove(int index)
+  {
+    p->remove(index);
+  }
+
+  bool isRemoved(int index) const
+  {
+    return p->isRemoved(index);
+  }
+
+  int getNumRemoved() const
+  {
+    return p->numRemoved();
+  }
+
+  /* True if more than a quarter of all objects are removed and compact() should be called */
+  bool needsCompaction() const
+  {
+    return p->numRemoved() > QVector<T>::size() / 4;
+  }
+
+  /* Delete removed objects from the vector and rebuild the index. Changes indexes of objects. */
+  void compact();
+
   /* Get points converted to 3D euclidian space from base vector.
    * Size is the same as in the underlying parent QVector. */
   const Point3D *getPoints3D() const
@@ -144,7 +265,7 @@ public:
 
 private:
   /* Copy objects from base vector to result set. */
-  void copyData(QVector<T>& objects, QVector<int>& indexes) const
+  void copyData(QVector<T>& objects, const QVector<int>& indexes) const
   {
     for(int idx : indexes)
       objects.append(this->at(idx));
@@ -196,14 +317,107 @@ void SpatialIndex<T>::getRadius(QVector<T>& objects, const Pos& pos, float radiu
   copyData(objects, indexes);
 }
 
+template<typename T>
+template<typename FUNC>
+void SpatialIndex<T>::getRadius(QVector<T>& objects, const Pos& pos, float radiusMeter, SpatialIndexBuffer& buffer,
+                                FUNC filter) const
+{
+  p->pointsInRadius(buffer.indexes, buffer.distances, pos, radiusMeter);
+  for(int i = 0; i < buffer.indexes.size(); i++)
+  {
+    int idx = buffer.indexes.at(i);
+    if(filter(buffer.distances.at(i), idx))
+      objects.append(this->at(idx));
+  }
+}
+
+template<typename T>
+template<typename FUNC>
+void SpatialIndex<T>::getRadiusIndexes(QVector<int>& indexes, const Pos& pos, float radiusMeter,
+                                       SpatialIndexBuffer& buffer, FUNC filter) const
+{
+  p->pointsInRadius(buffer.indexes, buffer.distances, pos, radiusMeter);
+  for(int i = 0; i < buffer.indexes.size(); i++)
+  {
+    int idx = buffer.indexes.at(i);
+    if(filter(buffer.distances.at(i), idx))
+      indexes.append(idx);
+  }
+}
+
+template<typename T>
+template<typename FUNC>
+void SpatialIndex<T>::forEachInRadius(const Pos& pos, float radiusMeter, SpatialIndexBuffer& buffer, FUNC func) const
+{
+  p->pointsInRadius(buffer.indexes, buffer.distances, pos, radiusMeter);
+  for(int i = 0; i < buffer.indexes.size(); i++)
+    func(this->at(buffer.indexes.at(i)), buffer.distances.at(i));
+}
+
+template<typename T>
+void SpatialIndex<T>::getNearest(QVector<T>& objects, const Pos& pos, int number, SpatialIndexBuffer& buffer) const
+{
+  p->nearestPoints(buffer.indexes, buffer.distances, pos, number);
+  copyData(objects, buffer.indexes);
+}
+
+template<typename T>
+void SpatialIndex<T>::getCorridor(QVector<T>& objects, const LineString& line, float distanceMeter) const
+{
+  QVector<int> indexes;
+  p->pointsInCorridor(indexes, line, distanceMeter);
+  copyData(objects, indexes);
+}
+
+template<typename T>
+void SpatialIndex<T>::getRect(QVector<T>& objects, const Rect& rect) const
+{
+  QVector<int> indexes;
+  p->pointsInRect(indexes, rect);
+  copyData(objects, indexes);
+}
+
+template<typename T>
+int SpatialIndex<T>::insert(const T& obj)
+{
+  QVector<T>::append(obj);
+
+  if(p->size() == QVector<T>::size() - 1)
+    p->insert(obj.getPosition().toCartesian());
+  else
+    // Vector was changed outside - rebuild all
+    updateIndex();
+
+  return QVector<T>::size() - 1;
+}
+
+template<typename T>
+void SpatialIndex<T>::compact()
+{
+  if(p->numRemoved() > 0)
+  {
+    QVector<T> objects;
+    objects.reserve(QVector<T>::size() - p->numRemoved());
+    for(int i = 0; i < QVector<T>::size(); i++)
+    {
+      if(!p->isRemoved(i))
+        objects.append(QVector<T>::at(i));
+    }
+    QVector<T>::swap(objects);
+  }
+  updateIndex();
+}
+
 template<typename T>
 void SpatialIndex<T>::updateIndex()
 {
   QVector<T>::squeeze();
   p->reserve(QVector<T>::size());
 
-  for(int i = 0; i < QVector<T>::size(); i++)
+  // Convert to cartesian coordinates in parallel for large vectors
+  atools::util::parallelFor(QVector<T>::size(), [this](int i) -> void {
     p->set(QVector<T>::at(i).getPosition().toCartesian(), i);
+  }, 10000);
 
   p->buildIndex();
 }
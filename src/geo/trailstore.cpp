@@ -0,0 +1,198 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "geo/trailstore.h"
+#include "geo/linestring.h"
+
+#include <QDebug>
+
+#include <cmath>
+
+namespace atools {
+namespace geo {
+
+/* Units per degree and per millisecond for quantization */
+static Q_DECL_CONSTEXPR double UNITS_PER_DEGREE = 1000000.;
+static Q_DECL_CONSTEXPR qint64 MS_PER_TIME_UNIT = 100;
+
+TrailStore::TrailStore(int samplesPerTrail, int maxTrails)
+  : samplesPerTrail(std::max(2, samplesPerTrail)), maxTrails(std::max(1, maxTrails))
+{
+}
+
+qint32 TrailStore::toTime(qint64 timestampMs) const
+{
+  return static_cast<qint32>((timestampMs - baseTimeMs) / MS_PER_TIME_UNIT);
+}
+
+qint64 TrailStore::fromTime(qint32 time) const
+{
+  return baseTimeMs + static_cast<qint64>(time) * MS_PER_TIME_UNIT;
+}
+
+void TrailStore::append(quint64 key, qint64 timestampMs, const Pos& pos)
+{
+  if(!pos.isValid())
+    return;
+
+  // Allows about six years around the first sample with 32 bit times
+  if(baseTimeMs == -1)
+    baseTimeMs = timestampMs;
+
+  Sample sample;
+  sample.time = toTime(timestampMs);
+  sample.lonX = static_cast<qint32>(std::round(pos.getLonX() * UNITS_PER_DEGREE));
+  sample.latY = static_cast<qint32>(std::round(pos.getLatY() * UNITS_PER_DEGREE));
+  sample.altitude = static_cast<qint32>(std::round(pos.getAltitude()));
+
+  int slot = slotIndex.value(key, -1);
+  if(slot == -1)
+  {
+    slot = allocateSlot();
+    slots[slot].key = key;
+    slots[slot].used = true;
+    slotIndex.insert(key, slot);
+  }
+
+  Slot& s = slots[slot];
+  Sample *samples = arena.data() + slot * samplesPerTrail;
+  if(s.count > 0)
+  {
+    const Sample& last = samples[(s.next + samplesPerTrail - 1) % samplesPerTrail];
+    if(sample.time <= last.time)
+      // Not newer - happens with unchanged whazzup files
+      return;
+
+    if(sample.lonX == last.lonX && sample.latY == last.latY && sample.altitude == last.altitude)
+    {
+      // Parked or paused - only note the update
+      s.lastTimestampMs = timestampMs;
+      return;
+    }
+  }
+
+  samples[s.next] = sample;
+  s.next = (s.next + 1) % samplesPerTrail;
+  s.count = std::min(s.count + 1, samplesPerTrail);
+  s.lastTimestampMs = timestampMs;
+}
+
+int TrailStore::allocateSlot()
+{
+  if(!freeSlots.isEmpty())
+    return freeSlots.takeLast();
+
+  if(slots.size() < maxTrails)
+  {
+    // Grow arena by one trail
+    slots.append(Slot());
+    arena.resize(slots.size() * samplesPerTrail);
+    return slots.size() - 1;
+  }
+
+  // All slots used - take the one with the oldest update
+  int oldest = 0;
+  for(int i = 1; i < slots.size(); i++)
+  {
+    if(slots.at(i).lastTimestampMs < slots.at(oldest).lastTimestampMs)
+      oldest = i;
+  }
+  freeSlot(oldest);
+  return freeSlots.takeLast();
+}
+
+void TrailStore::freeSlot(int slot)
+{
+  Slot& s = slots[slot];
+  if(s.used)
+  {
+    slotIndex.remove(s.key);
+    s = Slot();
+    freeSlots.append(slot);
+  }
+}
+
+void TrailStore::getSamples(QVector<TrailSample>& samples, quint64 key, qint64 fromMs, qint64 toMs) const
+{
+  int slot = slotIndex.value(key, -1);
+  if(slot != -1)
+  {
+    forEachSample(slot, [&](const Sample& sample) -> void {
+                    qint64 timestampMs = fromTime(sample.time);
+                    if(timestampMs >= fromMs && timestampMs <= toMs)
+                      samples.append({timestampMs, Pos(sample.lonX / UNITS_PER_DEGREE,
+                                                       sample.latY / UNITS_PER_DEGREE,
+                                                       static_cast<double>(sample.altitude))});
+                  });
+  }
+}
+
+void TrailStore::getLine(LineString& line, quint64 key, qint64 fromMs, qint64 toMs) const
+{
+  int slot = slotIndex.value(key, -1);
+  if(slot != -1)
+  {
+    forEachSample(slot, [&](const Sample& sample) -> void {
+                    qint64 timestampMs = fromTime(sample.time);
+                    if(timestampMs >= fromMs && timestampMs <= toMs)
+                      line.append(Pos(sample.lonX / UNITS_PER_DEGREE, sample.latY / UNITS_PER_DEGREE,
+                                      static_cast<double>(sample.altitude)));
+                  });
+  }
+}
+
+qint64 TrailStore::getLastTimestampMs(quint64 key) const
+{
+  int slot = slotIndex.value(key, -1);
+  return slot != -1 ? slots.at(slot).lastTimestampMs : -1;
+}
+
+int TrailStore::getNumSamples(quint64 key) const
+{
+  int slot = slotIndex.value(key, -1);
+  return slot != -1 ? slots.at(slot).count : 0;
+}
+
+void TrailStore::remove(quint64 key)
+{
+  int slot = slotIndex.value(key, -1);
+  if(slot != -1)
+    freeSlot(slot);
+}
+
+void TrailStore::removeOutdated(qint64 timestampMs)
+{
+  for(int i = 0; i < slots.size(); i++)
+  {
+    if(slots.at(i).used && slots.at(i).lastTimestampMs < timestampMs)
+      freeSlot(i);
+  }
+}
+
+void TrailStore::clear()
+{
+  arena.clear();
+  arena.squeeze();
+  slots.clear();
+  freeSlots.clear();
+  slotIndex.clear();
+  baseTimeMs = -1;
+}
+
+} // namespace geo
+} // namespace atools
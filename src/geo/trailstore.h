@@ -0,0 +1,180 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_GEO_TRAILSTORE_H
+#define ATOOLS_GEO_TRAILSTORE_H
+
+#include "geo/pos.h"
+
+#include <QHash>
+#include <QVector>
+
+#include <limits>
+
+namespace atools {
+namespace geo {
+
+class LineString;
+
+/* Decoded trail position. Altitude of position is in feet. */
+struct TrailSample
+{
+  qint64 timestampMs;
+  atools::geo::Pos position;
+};
+
+/*
+ * Position history for many moving objects like online clients or AI aircraft with bounded memory.
+ *
+ * Each trail is a fixed capacity ring buffer which overwrites its oldest samples. All ring buffers are slots in
+ * one contiguous arena which grows up to maxTrails slots. If all slots are used a new trail takes the slot of
+ * the trail with the oldest update. Memory is limited to about maxTrails * samplesPerTrail * 16 bytes.
+ *
+ * Samples are quantized to 100 milliseconds, micro degrees and full feet.
+ * Trails are identified by a caller defined key like the semi-permanent client id of the online data or
+ * the object id of AI aircraft. Use one store for each key space.
+ *
+ * Not thread safe.
+ */
+class TrailStore
+{
+public:
+  explicit TrailStore(int samplesPerTrail = 256, int maxTrails = 2048);
+
+  TrailStore(const TrailStore& other) = delete;
+  TrailStore& operator=(const TrailStore& other) = delete;
+
+  /* Append a sample to the trail for key which is created if needed. Altitude is in feet.
+   * Samples which are not newer than the last one of the trail are ignored. Samples with unchanged position
+   * only update the time of the last update. */
+  void append(quint64 key, qint64 timestampMs, const atools::geo::Pos& pos);
+
+  /* Appends samples of the trail with timestamps in the range [fromMs, toMs] ordered by time */
+  void getSamples(QVector<atools::geo::TrailSample>& samples, quint64 key, qint64 fromMs = 0,
+                  qint64 toMs = std::numeric_limits<qint64>::max()) const;
+
+  /* Appends the positions of the trail with timestamps in the range [fromMs, toMs] ordered by time */
+  void getLine(atools::geo::LineString& line, quint64 key, qint64 fromMs = 0,
+               qint64 toMs = std::numeric_limits<qint64>::max()) const;
+
+  /* Timestamp of the last sample or -1 if key is not found */
+  qint64 getLastTimestampMs(quint64 key) const;
+
+  /* Number of samples in the trail */
+  int getNumSamples(quint64 key) const;
+
+  bool contains(quint64 key) const
+  {
+    return slotIndex.contains(key);
+  }
+
+  /* Remove trail for key. Does nothing if key is not present. */
+  void remove(quint64 key);
+
+  /* Remove all trails where the key is not contained in the hash keys */
+  template<typename KEY, typename T>
+  void retain(const QHash<KEY, T>& keepKeys);
+
+  /* Remove all trails which were not updated at or after timestampMs */
+  void removeOutdated(qint64 timestampMs);
+
+  /* Remove all trails and release the arena */
+  void clear();
+
+  /* Number of trails */
+  int size() const
+  {
+    return slotIndex.size();
+  }
+
+  bool isEmpty() const
+  {
+    return slotIndex.isEmpty();
+  }
+
+  /* Allocated bytes of the arena */
+  qint64 getArenaBytes() const
+  {
+    return static_cast<qint64>(arena.capacity()) * static_cast<qint64>(sizeof(Sample));
+  }
+
+private:
+  /* Quantized sample. Time is relative to baseTimeMs. */
+  struct Sample
+  {
+    qint32 time; /* 100 ms */
+    qint32 lonX, latY; /* Micro degree */
+    qint32 altitude; /* Feet */
+  };
+
+  /* Ring buffer state for the slot at the same index in the arena */
+  struct Slot
+  {
+    quint64 key = 0;
+    qint64 lastTimestampMs = -1;
+    int next = 0; /* Index of the next sample to write */
+    int count = 0; /* Number of used samples */
+    bool used = false;
+  };
+
+  /* Get free or oldest slot for a new trail */
+  int allocateSlot();
+  void freeSlot(int slot);
+
+  /* Calls func(const Sample&) for all samples of slot from oldest to newest */
+  template<typename FUNC>
+  void forEachSample(int slot, FUNC func) const;
+
+  qint32 toTime(qint64 timestampMs) const;
+  qint64 fromTime(qint32 time) const;
+
+  int samplesPerTrail, maxTrails;
+  qint64 baseTimeMs = -1;
+
+  QVector<Sample> arena;
+  QVector<Slot> slots;
+  QVector<int> freeSlots;
+  QHash<quint64, int> slotIndex;
+};
+
+template<typename KEY, typename T>
+void TrailStore::retain(const QHash<KEY, T>& keepKeys)
+{
+  for(int i = 0; i < slots.size(); i++)
+  {
+    if(slots.at(i).used && !keepKeys.contains(static_cast<KEY>(slots.at(i).key)))
+      freeSlot(i);
+  }
+}
+
+template<typename FUNC>
+void TrailStore::forEachSample(int slot, FUNC func) const
+{
+  const Slot& s = slots.at(slot);
+  const Sample *samples = arena.constData() + slot * samplesPerTrail;
+
+  // Oldest sample is at next if the ring buffer is full
+  int start = s.count < samplesPerTrail ? 0 : s.next;
+  for(int i = 0; i < s.count; i++)
+    func(samples[(start + i) % samplesPerTrail]);
+}
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_TRAILSTORE_H
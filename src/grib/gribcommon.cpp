@@ -17,11 +17,20 @@
 
 #include "gribcommon.h"
 
+#include "grib/gribreader.h"
+
 #include <QDebug>
 
 namespace atools {
 namespace grib {
 
+const QVector<float>& GribDataset::getData() const
+{
+  if(data.isEmpty() && !source.isNull())
+    GribReader::decodeField(data, *source, messageOffset, fieldNumber);
+  return data;
+}
+
 } // namespace grib
 } // namespace atools
 
@@ -36,7 +45,10 @@ QDebug operator<<(QDebug out, const atools::grib::GribDataset& type)
                           << ", param type " << type.getParameterType()
                           << ", alt round " << type.getAltFeetRounded()
                           << ", alt calc " << type.getAltFeetCalculated()
-                          << ", size " << type.getData().size()
+                          << ", grid " << type.getGrid().ni << "x" << type.getGrid().nj
+                          << " first " << type.getGrid().firstLonX << "/" << type.getGrid().firstLatY
+                          << " increment " << type.getGrid().incrementLonX << "/" << type.getGrid().incrementLatY
+                          << ", decoded " << type.isDecoded()
                           << "]";
 
   return out;
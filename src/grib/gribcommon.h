@@ -19,12 +19,16 @@
 #define ATOOLS_GRIBCOMMON_H
 
 #include <QDateTime>
+#include <QSharedPointer>
 #include <QVector>
 
+#include <cmath>
+
 namespace atools {
 namespace grib {
 
 class GribReader;
+class GribSource;
 
 /* Momentum parameters. Here wind speed.
  * https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table4-2-0-2.shtml
@@ -44,8 +48,52 @@ enum SurfaceType
   METER_AGL = 103 /* surface is meter above ground level */
 };
 
+/*
+ * Regular latitude/longitude grid of a dataset. Points are ordered from west to east in rows from north to south.
+ * Default is the global one-degree grid.
+ */
+struct GribGrid
+{
+  /* Ni — number of points along a parallel and Nj — number of points along a meridian */
+  int ni = 360, nj = 181;
+
+  /* Coordinates of the first, north-west grid point in degrees */
+  float firstLonX = 0.f, firstLatY = 90.f;
+
+  /* Distance between grid points in degrees */
+  float incrementLonX = 1.f, incrementLatY = 1.f;
+
+  /* true if the grid covers all longitudes and wraps around at the anti-meridian */
+  bool isGlobalLonX() const
+  {
+    return std::abs(ni * incrementLonX - 360.f) < 0.001f;
+  }
+
+  int getSize() const
+  {
+    return ni * nj;
+  }
+
+  bool operator==(const GribGrid& other) const
+  {
+    return ni == other.ni && nj == other.nj &&
+           std::abs(firstLonX - other.firstLonX) < 0.0001f && std::abs(firstLatY - other.firstLatY) < 0.0001f &&
+           std::abs(incrementLonX - other.incrementLonX) < 0.0001f &&
+           std::abs(incrementLatY - other.incrementLatY) < 0.0001f;
+  }
+
+  bool operator!=(const GribGrid& other) const
+  {
+    return !operator==(other);
+  }
+
+};
+
 /*
  * Contains a decoded GRIB2 dataset based on U and V wind vectors.
+ *
+ * Datasets read by GribReader in indexed mode keep only a reference to the raw GRIB message
+ * and decode the data on first call of getData(). Not thread safe.
  */
 class GribDataset
 {
@@ -68,18 +116,36 @@ public:
     return datetime;
   }
 
-  /* Wind vectors in meters per second organized in 360 columns (0-359) and 181 rows (0-180)
-   * Index 0,0 contains information for 90° North and 0° E/W
+  /* Wind vectors in meters per second organized in grid.ni columns and grid.nj rows.
+   * Index 0,0 contains information for the first grid point which is 90° North and 0° E/W for global grids.
    *
    *  Ni — number of points along a parallel - 360
    *  Nj — number of points along a meridian - 181
    *  multiplying Ni (octets 31-34) by Nj (octets 35-38) yields the total number of points
    *  i direction - west to east along a parallel or left to right along an x-axis.
    *  j direction - south to north along a meridian, or bottom to top along a y-axis.
+   *
+   *  Decodes the field on first call if not already done. Data is empty if decoding failed.
    */
-  const QVector<float>& getData() const
+  const QVector<float>& getData() const;
+
+  /* true if data is decoded or does not need decoding */
+  bool isDecoded() const
   {
-    return data;
+    return !data.isEmpty() || source.isNull();
+  }
+
+  /* Free decoded data if it can be decoded again from the raw GRIB message in indexed mode */
+  void releaseData() const
+  {
+    if(!source.isNull())
+      data.clear();
+  }
+
+  /* Grid dimensions and coordinates */
+  const atools::grib::GribGrid& getGrid() const
+  {
+    return grid;
   }
 
   /* Altitude calculated from surface based on ISA atmosphere */
@@ -111,7 +177,13 @@ private:
   atools::grib::SurfaceType surfaceType;
 
   QDateTime datetime;
-  QVector<float> data;
+  atools::grib::GribGrid grid;
+
+  /* Filled on demand from the message in source. Source is kept to allow decoding again after releaseData(). */
+  mutable QVector<float> data;
+  QSharedPointer<const atools::grib::GribSource> source;
+  qint64 messageOffset = 0L;
+  int fieldNumber = 0;
 };
 
 typedef  QVector<GribDataset> GribDatasetVector;
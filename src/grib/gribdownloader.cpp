@@ -130,8 +130,9 @@ void GribDownloader::downloadFinished(const QByteArray& data, QString downloadUr
 
   try
   {
-    // Decode and copy the data
+    // Build catalog - fields are decoded on first access
     GribReader reader(verbose);
+    reader.setIndexed(true);
     reader.readData(data);
     datasets = reader.getDatasets();
   }
@@ -176,5 +177,15 @@ void GribDownloader::setIgnoreSslErrors(bool value)
   downloader->setIgnoreSslErrors(value);
 }
 
+void GribDownloader::setDiskCache(atools::util::HttpCache *cache)
+{
+  downloader->setDiskCache(cache);
+}
+
+void GribDownloader::setScheduler(atools::util::HttpScheduler *scheduler)
+{
+  downloader->setScheduler(scheduler, atools::util::PRIORITY_NORMAL);
+}
+
 } // namespace grib
 } // namespace atools
@@ -28,6 +28,8 @@ namespace atools {
 
 namespace util {
 class HttpDownloader;
+class HttpCache;
+class HttpScheduler;
 }
 namespace grib {
 
@@ -100,6 +102,12 @@ public:
    * downloadSslErrors is emitted in case of SSL errors. */
   void setIgnoreSslErrors(bool value);
 
+  /* Use the persistent disk cache for downloads. Cache is not owned. Set to null to disable. */
+  void setDiskCache(atools::util::HttpCache *cache);
+
+  /* Use the shared download scheduler. Scheduler is not owned. Set to null to disable. */
+  void setScheduler(atools::util::HttpScheduler *scheduler);
+
 signals:
   /* Sent if download finished successfully */
   void gribDownloadFinished(const atools::grib::GribDatasetVector& datasets, QString downloadUrl);
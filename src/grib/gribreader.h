@@ -22,15 +22,51 @@
 
 #include <QVector>
 #include <QApplication>
+#include <QFile>
+
+struct gribfield;
 
 namespace atools {
 namespace grib {
 
+/*
+ * Raw GRIB data which is kept in memory for datasets that are decoded on demand.
+ * Uses either a memory mapped file, a file read into memory or a shared copy of a byte array.
+ *
+ * Note that a mapped file must not be truncated or changed in place while the source is alive.
+ */
+class GribSource
+{
+public:
+  explicit GribSource(const QString& filename, bool memoryMapped);
+  explicit GribSource(const QByteArray& bytesParam);
+  ~GribSource();
+
+  /* false if file could not be opened or read */
+  bool isValid() const
+  {
+    return getBytes() != nullptr;
+  }
+
+  const unsigned char *getBytes() const;
+  qint64 getSize() const;
+
+private:
+  Q_DISABLE_COPY(GribSource)
+
+  QFile file;
+  uchar *mapped = nullptr;
+  QByteArray bytes;
+};
+
 /*
  * Reads and decodes a GRIB2 data file into a GribDatasetVector.
- * Only U/V wind, full earth bounding rectangle and one-degree raster supported.
+ * Only U/V wind on regular latitude/longitude grids (global or regional, any resolution) supported.
  * Throws atools::Exception if parameters are not correct.
  *
+ * Only metadata is read for unsupported fields. Supported fields are decoded while reading
+ * or on first access of GribDataset::getData() in indexed mode.
+ *
  * https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/
  * https://www.nco.ncep.noaa.gov/pmb/docs/grib2/grib2_doc/grib2_table3-1.shtml
  */
@@ -49,6 +85,37 @@ public:
   /* Clear dataset for reuse */
   void clear();
 
+  /* Build only a catalog of fields while reading and decode datasets on first access.
+   * The raw GRIB data is kept in memory until all datasets are decoded or deleted. Default is false. */
+  void setIndexed(bool value)
+  {
+    indexed = value;
+  }
+
+  bool isIndexed() const
+  {
+    return indexed;
+  }
+
+  /* Map files into memory instead of reading them in indexed mode. Default is false.
+   * Do not use this if the file might be overwritten while datasets are not decoded yet. */
+  void setMemoryMapped(bool value)
+  {
+    memoryMapped = value;
+  }
+
+  bool isMemoryMapped() const
+  {
+    return memoryMapped;
+  }
+
+  /* Decode all not yet decoded datasets starting at index from in parallel using the shared task scheduler.
+   * Useful to decode a catalog read in indexed mode at once. Datasets must not be accessed while decoding. */
+  static void decodeDatasets(const atools::grib::GribDatasetVector& datasetsToDecode, int from = 0);
+
+  /* Decode field number from message at offset into data. Data is cleared on error. */
+  static void decodeField(QVector<float>& data, const GribSource& source, qint64 messageOffset, int fieldNumber);
+
   /* Get decoded datasets for read file */
   const atools::grib::GribDatasetVector& getDatasets() const
   {
@@ -60,8 +127,14 @@ public:
   static bool validateGribData(QByteArray bytes);
 
 private:
+  /* Scan all messages in source and add catalog entries or decoded datasets */
+  void readSource(const QSharedPointer<const GribSource>& source, const QString& name);
+
+  /* Read metadata and check for supported raster and parameters. Returns false if field is not supported. */
+  bool readMetadata(GribDataset& dataset, const gribfield *gribField) const;
+
   atools::grib::GribDatasetVector datasets;
-  bool verbose = false;
+  bool verbose = false, indexed = false, memoryMapped = false;
 };
 
 } // namespace grib
@@ -15,6 +15,12 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *****************************************************************************/
 
+// Allow vectorization of the batch interpolation loops for all build types.
+// Has to be placed before includes to allow inlining of standard library functions
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("tree-vectorize", "no-trapping-math")
+#endif
+
 #include "grib/windquery.h"
 
 #include "grib/gribdownloader.h"
@@ -26,6 +32,12 @@
 #include "util/filesystemwatcher.h"
 #include "exception.h"
 #include "geo/line.h"
+#include "util/trace.h"
+#include "util/lrucache.h"
+
+#include <QMutexLocker>
+#include <QSet>
+#include <QThreadPool>
 
 using atools::grib::GribDownloader;
 using atools::geo::Rect;
@@ -33,7 +45,6 @@ using atools::geo::Pos;
 using atools::geo::Line;
 using atools::geo::LineString;
 using atools::geo::normalizeCourse;
-using atools::interpolate;
 using atools::geo::windSpeedFromUV;
 using atools::geo::windUComponent;
 using atools::geo::windVComponent;
@@ -45,6 +56,16 @@ namespace grib {
 /* Allowed altitude inaccuracy when comparing layer altitudes. */
 Q_CONSTEXPR static int ALTITUDE_EPSILON = 50.f;
 
+/* Number of grid points along each side of a tile */
+const int TILE_SIZE = 64;
+
+/* Grids up to this size are loaded completely on first access. This covers the global one-degree grid. */
+const int FULL_LOAD_GRID_SIZE = 360 * 181;
+
+/* Maximum number of cached line averages and number of shards for concurrent queries */
+const int LINE_CACHE_SIZE = 10000;
+const int LINE_CACHE_SHARDS = 8;
+
 struct WindData
 {
   /* Use U and V components for calculation. */
@@ -72,12 +93,43 @@ struct WindData
 
 const static atools::grib::WindData EMPTY_WIND_DATA = {0.f, 0.f};
 
-/* Internal data structure for wind direction and speed computed from U/V speeds */
+/* Internal data structure for wind U/V components converted to knots for one altitude.
+ * Grid points are stored in square tiles which are loaded from the GRIB datasets on demand. */
 struct WindAltLayer
 {
   int altitude = 0;
-  QVector<WindData> winds;
   float surface;
+  atools::grib::GribGrid grid;
+
+  /* Tiles of TILE_SIZE x TILE_SIZE grid points in rows from north to south. Empty if not loaded yet. */
+  QVector<QVector<WindData> > tiles;
+  int tileColumns = 0;
+
+  /* Source for tiles. Decoded data is released after loading tiles but raw GRIB data is kept
+   * to allow loading other tiles when the region changes. */
+  GribDataset datasetU, datasetV;
+  bool loadable = false;
+
+  /* Set grid and create empty tiles */
+  void initTiles(const atools::grib::GribGrid& gridParam)
+  {
+    grid = gridParam;
+    tileColumns = (grid.ni + TILE_SIZE - 1) / TILE_SIZE;
+    tiles.clear();
+    tiles.resize(tileColumns * ((grid.nj + TILE_SIZE - 1) / TILE_SIZE));
+  }
+
+  int tileIndex(int col, int row) const
+  {
+    return (row / TILE_SIZE) * tileColumns + col / TILE_SIZE;
+  }
+
+  /* Wind at grid point or null if tile is not loaded */
+  const WindData *windAt(int col, int row) const
+  {
+    const QVector<WindData>& tile = tiles.at(tileIndex(col, row));
+    return tile.isEmpty() ? nullptr : &tile.at((row % TILE_SIZE) * TILE_SIZE + col % TILE_SIZE);
+  }
 
   bool operator<(const WindAltLayer& l) const
   {
@@ -96,83 +148,584 @@ struct WindAltLayer
 
   bool isValid() const
   {
-    return !winds.isEmpty();
+    return !tiles.isEmpty();
   }
 
 };
 
-/* One grid cell with all wind values at the corners for interpolation. top left corresponds to queried position. */
-struct WindRect
+/* Complete set of wind layers. Immutable once published by WindQuery and shared between queries.
+ * Updates create a new set which replaces the published one. */
+struct WindLayerSet
 {
-  WindData topLeft, topRight, bottomRight, bottomLeft;
+  /* Maps rounded altitude to wind layer data. Sorted by altitude. */
+  QMap<int, WindAltLayer> layers;
+  QDateTime analysisTime;
+
+  /* Unique for each created set. Used to key cached results which are never valid for another set. */
+  const quint64 serial = nextSerial.fetchAndAddRelaxed(1) + 1;
+
+  WindLayerSet() = default;
+  WindLayerSet(const WindLayerSet& other) = delete;
+
+  /* Copies data but keeps serial */
+  WindLayerSet& operator=(const WindLayerSet& other)
+  {
+    layers = other.layers;
+    analysisTime = other.analysisTime;
+    return *this;
+  }
+
+private:
+  static QAtomicInteger<quint64> nextSerial;
 };
 
-/* One grid cell with all grid positions values at the corners for interpolation. top left corresponds to queried position. */
-struct GridRect
+QAtomicInteger<quint64> WindLayerSet::nextSerial;
+
+/* Key for cached average winds of a line. Positions including altitude are compared exactly. */
+struct WindLineKey
 {
-  QPoint topLeft, topRight, bottomRight, bottomLeft;
+  float lonX1, latY1, alt1, lonX2, latY2, alt2;
+  int samplesPerDegree;
+  quint64 layerSetSerial;
+
+  bool operator==(const WindLineKey& other) const
+  {
+    return lonX1 == other.lonX1 && latY1 == other.latY1 && alt1 == other.alt1 &&
+           lonX2 == other.lonX2 && latY2 == other.latY2 && alt2 == other.alt2 &&
+           samplesPerDegree == other.samplesPerDegree && layerSetSerial == other.layerSetSerial;
+  }
 };
 
-// Debug IO =======================================================================
-QDebug operator<<(QDebug out, const WindPos& windPos)
+inline uint qHash(const WindLineKey& key)
 {
-  QDebugStateSaver saver(out);
-  out.noquote().nospace() << "WindPos(" << windPos.wind << ", " << windPos.pos << ")";
-  return out;
+  return qHash(key.lonX1) ^ qHash(key.latY1) ^ (qHash(key.alt1) << 1) ^ (qHash(key.lonX2) << 2) ^
+         (qHash(key.latY2) << 3) ^ (qHash(key.alt2) << 4) ^ qHash(key.samplesPerDegree) ^ qHash(key.layerSetSerial);
 }
 
-QDebug operator<<(QDebug out, const Wind& wind)
+/* State shared between WindQuery and the background tasks */
+struct WindLayerState
 {
-  QDebugStateSaver saver(out);
-  out.noquote().nospace() << "Wind(speed " << wind.speed << ", dir " << wind.dir << ")";
-  return out;
+  /* Protects result and error - not used for queries */
+  QMutex mutex;
+  std::shared_ptr<const WindLayerSet> result;
+  QString error;
+  int resultGeneration = 0;
+
+  /* Incremented for each update. Tasks of older generations discard their result. */
+  QAtomicInt generation;
+};
+
+/* Calculates columns and rows of the grid cell containing pos and the interpolation factors within the cell.
+ * Longitudes wrap around for global grids. Returns false if pos is outside of the grid. */
+inline bool gridCell(const GribGrid& grid, const Pos& pos, int& col0, int& col1, int& row0, int& row1,
+                     float& fx, float& fy)
+{
+  float x = std::fmod(pos.getLonX() - grid.firstLonX, 360.f);
+  if(x < 0.f)
+    x += 360.f;
+  x /= grid.incrementLonX;
+
+  // Allow small rounding errors at the grid borders
+  float y = (grid.firstLatY - pos.getLatY()) / grid.incrementLatY;
+  if(y < -0.01f || y > grid.nj - 1 + 0.01f)
+    return false;
+  y = atools::minmax(0.f, static_cast<float>(grid.nj - 1), y);
+
+  if(grid.isGlobalLonX())
+  {
+    col0 = static_cast<int>(x) % grid.ni;
+    col1 = (col0 + 1) % grid.ni;
+  }
+  else
+  {
+    if(x > grid.ni - 1 + 0.01f)
+      return false;
+    x = std::min(x, static_cast<float>(grid.ni - 1));
+    col0 = static_cast<int>(x);
+    col1 = std::min(col0 + 1, grid.ni - 1);
+  }
+  fx = x - std::floor(x);
+
+  row0 = static_cast<int>(y);
+  row1 = std::min(row0 + 1, grid.nj - 1);
+  fy = y - row0;
+  return true;
+}
+
+/* Number of positions processed at once in batch interpolation */
+const int BATCH_CHUNK_SIZE = 256;
+
+/* Layer, grid cell, interpolation factors and cell corner values in one layer for a chunk of positions */
+struct WindBatchLayer
+{
+  const WindAltLayer *layer[BATCH_CHUNK_SIZE];
+  int col0[BATCH_CHUNK_SIZE], col1[BATCH_CHUNK_SIZE], row0[BATCH_CHUNK_SIZE], row1[BATCH_CHUNK_SIZE];
+  bool inside[BATCH_CHUNK_SIZE];
+
+  /* Factors within the cell from west to east and from north to south */
+  float fx[BATCH_CHUNK_SIZE], fy[BATCH_CHUNK_SIZE];
+
+  /* U and V components at top left, top right, bottom left and bottom right corners */
+  float u[4][BATCH_CHUNK_SIZE], v[4][BATCH_CHUNK_SIZE];
+};
+
+/* All values for a chunk of positions in separate arrays */
+struct WindBatchChunk
+{
+  WindBatchLayer lower, upper;
+
+  /* Factor from lower to upper layer */
+  float fz[BATCH_CHUNK_SIZE];
+
+  float resultU[BATCH_CHUNK_SIZE], resultV[BATCH_CHUNK_SIZE];
+};
+
+/* Find grid cell in layer for position at index. A null layer denotes zero wind. */
+inline void prepareCell(WindBatchLayer& batch, int index, const WindAltLayer *layer, const Pos& pos, bool interpolate)
+{
+  batch.layer[index] = layer;
+  batch.inside[index] = layer != nullptr && layer->isValid() &&
+                        gridCell(layer->grid, pos, batch.col0[index], batch.col1[index],
+                                 batch.row0[index], batch.row1[index], batch.fx[index], batch.fy[index]);
+
+  if(!batch.inside[index])
+    batch.fx[index] = batch.fy[index] = 0.f;
+  else if(!interpolate)
+  {
+    // Use nearest grid point
+    if(batch.fx[index] >= 0.5f)
+      batch.col0[index] = batch.col1[index];
+    if(batch.fy[index] >= 0.5f)
+      batch.row0[index] = batch.row1[index];
+    batch.col1[index] = batch.col0[index];
+    batch.row1[index] = batch.row0[index];
+    batch.fx[index] = batch.fy[index] = 0.f;
+  }
 }
 
-/* Column number in grid */
-inline int colNum(const atools::geo::Pos& pos)
+/* Copy wind components at the four cell corners into the chunk arrays. Missing tiles give zero wind. */
+void gatherCorners(WindBatchLayer& batch, int num)
 {
-  return static_cast<int>(pos.getLonX() < 0.f ? 360.f + pos.getLonX() : pos.getLonX());
+  for(int i = 0; i < num; i++)
+  {
+    const WindData *corners[4] = {nullptr, nullptr, nullptr, nullptr};
+    if(batch.inside[i])
+    {
+      const WindAltLayer *layer = batch.layer[i];
+      corners[0] = layer->windAt(batch.col0[i], batch.row0[i]);
+      corners[1] = layer->windAt(batch.col1[i], batch.row0[i]);
+      corners[2] = layer->windAt(batch.col0[i], batch.row1[i]);
+      corners[3] = layer->windAt(batch.col1[i], batch.row1[i]);
+    }
+
+    for(int c = 0; c < 4; c++)
+    {
+      const WindData& wind = corners[c] != nullptr ? *corners[c] : EMPTY_WIND_DATA;
+      batch.u[c][i] = wind.u;
+      batch.v[c][i] = wind.v;
+    }
+  }
 }
 
-/* Row number in grid */
-inline int rowNum(const atools::geo::Pos& pos)
+inline float bilinear(float topLeft, float topRight, float bottomLeft, float bottomRight, float fx, float fy)
 {
-  return static_cast<int>(180.f - (pos.getLatY() + 90.f));
+  float top = topLeft + (topRight - topLeft) * fx;
+  float bottom = bottomLeft + (bottomRight - bottomLeft) * fx;
+  return top + (bottom - top) * fy;
 }
 
-/* Get colum and row number for position at one degree boundary. */
-inline QPoint gridPos(const atools::geo::Pos& pos)
+/* Bilinear interpolation in both layers and linear interpolation between layers */
+void windBatchKernel(WindBatchChunk& chunk, int num)
 {
-  return QPoint(colNum(pos), rowNum(pos));
+  const WindBatchLayer& lo = chunk.lower, & up = chunk.upper;
+  for(int i = 0; i < num; i++)
+  {
+    float lowerU = bilinear(lo.u[0][i], lo.u[1][i], lo.u[2][i], lo.u[3][i], lo.fx[i], lo.fy[i]);
+    float lowerV = bilinear(lo.v[0][i], lo.v[1][i], lo.v[2][i], lo.v[3][i], lo.fx[i], lo.fy[i]);
+    float upperU = bilinear(up.u[0][i], up.u[1][i], up.u[2][i], up.u[3][i], up.fx[i], up.fy[i]);
+    float upperV = bilinear(up.v[0][i], up.v[1][i], up.v[2][i], up.v[3][i], up.fx[i], up.fy[i]);
+    chunk.resultU[i] = lowerU + (upperU - lowerU) * chunk.fz[i];
+    chunk.resultV[i] = lowerV + (upperV - lowerV) * chunk.fz[i];
+  }
 }
 
-/* A rectangle at one degree cell boundaries covering the given position */
-inline atools::geo::Rect globalRect(const atools::geo::Pos& pos)
+/* Create grid with all tiles filled with the same wind */
+void fillLayer(WindAltLayer& layer, const WindData& wind)
 {
-  atools::geo::Rect rect;
-  rect.setNorth(std::ceil(pos.getLatY()));
-  rect.setWest(std::floor(pos.getLonX()));
-  rect.setSouth(std::floor(pos.getLatY()));
-  rect.setEast(std::ceil(pos.getLonX()));
+  layer.initTiles(GribGrid());
+  for(QVector<WindData>& tile : layer.tiles)
+    tile.fill(wind, TILE_SIZE * TILE_SIZE);
+}
 
-  // Return at least a one degree width or height
-  if(atools::almostEqual(rect.getWidthDegree(), 0.f))
-    rect.setEast(rect.getEast() + 1.f);
-  if(atools::almostEqual(rect.getHeightMeter(), 0.f))
-    rect.setSouth(rect.getNorth() - 1.f);
+/* Get layer above and below (or at) altitude. lower is null for the zero wind ground layer.
+ * Both are null if there are no layers. */
+void layerPtrsByAlt(const QMap<int, WindAltLayer>& layers, const WindAltLayer *& lower, const WindAltLayer *& upper,
+                    float altitude)
+{
+  lower = upper = nullptr;
 
-  return rect;
+  if(layers.size() == 1)
+    // Only one wind layer
+    lower = upper = &layers.first();
+  else if(layers.size() > 1)
+  {
+    // Returns an iterator pointing to the first item with key key in the map.
+    // If the map contains no item with key key, the function returns an iterator to the nearest item with a greater key.
+    QMap<int, WindAltLayer>::const_iterator it = layers.lowerBound(atools::roundToInt(altitude));
+    if(it != layers.end())
+    {
+      if(atools::almostEqual(it->altitude, atools::roundToInt(altitude), ALTITUDE_EPSILON))
+        // Layer is at requested altitude - no need to interpolate
+        lower = upper = &(*it);
+      else if(it == layers.begin())
+        // First layer - lower is zero wind at ground
+        upper = &(*it);
+      else
+      {
+        lower = &(*(it - 1));
+        upper = &(*it);
+      }
+    }
+    else
+      lower = upper = &layers.last();
+  }
 }
 
-/* Gives a rectangle for grid positions for the given world coordinate rect */
-inline GridRect gridRect(const atools::geo::Rect& rect)
+/* Interpolate U/V components for size positions into result. Uses nearest grid point if interpolate is false.
+ * Only reads the layers. */
+void windDataForPosBatch(const QMap<int, WindAltLayer>& layers, WindData *result, const Pos *positions, int size,
+                         bool interpolate = true)
 {
-  GridRect retval;
-  retval.topLeft = gridPos(rect.getTopLeft());
-  retval.topRight = gridPos(rect.getTopRight());
-  retval.bottomRight = gridPos(rect.getBottomRight());
-  retval.bottomLeft = gridPos(rect.getBottomLeft());
-  return retval;
+  if(layers.isEmpty())
+  {
+    std::fill(result, result + size, EMPTY_WIND_DATA);
+    return;
+  }
+
+  WindBatchChunk chunk;
+  for(int start = 0; start < size; start += BATCH_CHUNK_SIZE)
+  {
+    int num = std::min(BATCH_CHUNK_SIZE, size - start);
+
+    // Find layers and grid cells - layer lookup is not vectorized
+    for(int i = 0; i < num; i++)
+    {
+      const Pos& pos = positions[start + i];
+      const WindAltLayer *lower = nullptr, *upper = nullptr;
+      chunk.fz[i] = 0.f;
+
+      if(pos.isValid())
+      {
+        layerPtrsByAlt(layers, lower, upper, pos.getAltitude());
+
+        // Lower layer is zero wind at ground level if null
+        float lowerAlt = lower != nullptr ? lower->altitude : 0.f;
+        float altRange = upper->altitude - lowerAlt;
+        if(lower != upper && std::abs(altRange) > 0.f)
+          chunk.fz[i] = (pos.getAltitude() - lowerAlt) / altRange;
+      }
+
+      prepareCell(chunk.lower, i, lower, pos, interpolate);
+      prepareCell(chunk.upper, i, upper, pos, interpolate);
+    }
+
+    gatherCorners(chunk.lower, num);
+    gatherCorners(chunk.upper, num);
+
+    windBatchKernel(chunk, num);
+
+    for(int i = 0; i < num; i++)
+    {
+      result[start + i].u = chunk.resultU[i];
+      result[start + i].v = chunk.resultV[i];
+    }
+  }
+}
+
+/* Convert U/V datasets to tiles of winds. Loads all tiles if tileIndexes is empty or for small grids. */
+void loadTiles(WindAltLayer& layer, const QSet<int>& tileIndexes)
+{
+  if(!layer.loadable)
+    return;
+
+  const GribGrid& grid = layer.grid;
+  bool all = tileIndexes.isEmpty() || grid.getSize() <= FULL_LOAD_GRID_SIZE;
+
+  // Collect tiles which are not loaded yet
+  QVector<int> indexes;
+  for(int i = 0; i < layer.tiles.size(); i++)
+  {
+    if(layer.tiles.at(i).isEmpty() && (all || tileIndexes.contains(i)))
+      indexes.append(i);
+  }
+
+  if(indexes.isEmpty())
+    return;
+
+  // Decode complete fields - GRIB does not allow to decode parts
+  const QVector<float>& dataU = layer.datasetU.getData();
+  const QVector<float>& dataV = layer.datasetV.getData();
+
+  if(dataU.size() < grid.getSize() || dataV.size() < grid.getSize())
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot decode layer" << layer.altitude << "size" << dataU.size() << dataV.size();
+
+    // Do not try again - missing tiles give zero wind
+    layer.loadable = false;
+    layer.datasetU = layer.datasetV = GribDataset();
+    return;
+  }
+
+  for(int index : indexes)
+  {
+    QVector<WindData>& tile = layer.tiles[index];
+    tile.resize(TILE_SIZE * TILE_SIZE);
+    int colStart = (index % layer.tileColumns) * TILE_SIZE, rowStart = (index / layer.tileColumns) * TILE_SIZE;
+    int colEnd = std::min(colStart + TILE_SIZE, grid.ni), rowEnd = std::min(rowStart + TILE_SIZE, grid.nj);
+
+    for(int row = rowStart; row < rowEnd; row++) // y
+    {
+      for(int col = colStart; col < colEnd; col++) // x
+      {
+        WindData& wind = tile[(row - rowStart) * TILE_SIZE + col - colStart];
+        wind.u = atools::geo::meterPerSecToKnots(dataU.at(col + row * grid.ni));
+        wind.v = atools::geo::meterPerSecToKnots(dataV.at(col + row * grid.ni));
+      }
+    }
+  }
+
+  // Free decoded data but keep raw GRIB data for other tiles
+  layer.datasetU.releaseData();
+  layer.datasetV.releaseData();
+}
+
+/* Get indexes of all tiles touching the rectangles */
+QSet<int> tilesForRects(const WindAltLayer& layer, const QVector<Rect>& rects)
+{
+  const GribGrid& grid = layer.grid;
+  QSet<int> tileIndexes;
+
+  for(const Rect& rect : rects)
+  {
+    for(const Rect& r : rect.splitAtAntiMeridian())
+    {
+      // Rows including one more grid point at each border for interpolation
+      int rowNorth = static_cast<int>(std::floor((grid.firstLatY - r.getNorth()) / grid.incrementLatY)) - 1;
+      int rowSouth = static_cast<int>(std::ceil((grid.firstLatY - r.getSouth()) / grid.incrementLatY)) + 1;
+      rowNorth = std::max(rowNorth, 0);
+      rowSouth = std::min(rowSouth, grid.nj - 1);
+
+      // Columns relative to first grid point
+      float offsetWest = r.getWest() - grid.firstLonX;
+      if(offsetWest < -180.f)
+        offsetWest += 360.f;
+      else if(grid.isGlobalLonX() && offsetWest < 0.f)
+        offsetWest += 360.f;
+
+      int colWest = static_cast<int>(std::floor(offsetWest / grid.incrementLonX)) - 1;
+      int numCols = static_cast<int>(std::ceil(r.getWidthDegree() / grid.incrementLonX)) + 3;
+      int colEast;
+
+      if(grid.isGlobalLonX())
+      {
+        colWest = (colWest + grid.ni) % grid.ni;
+        colEast = colWest + std::min(numCols, grid.ni) - 1;
+      }
+      else
+      {
+        colEast = std::min(colWest + numCols - 1, grid.ni - 1);
+        colWest = std::max(colWest, 0);
+      }
+
+      if(rowNorth > rowSouth || colWest > colEast)
+        continue;
+
+      for(int tileRow = rowNorth / TILE_SIZE; tileRow <= rowSouth / TILE_SIZE; tileRow++)
+      {
+        // Advance to start of next tile while wrapping at the anti-meridian for global grids
+        for(int c = colWest; c <= colEast;)
+        {
+          int col = c % grid.ni;
+          tileIndexes.insert(tileRow * layer.tileColumns + col / TILE_SIZE);
+          c += TILE_SIZE - col % TILE_SIZE;
+        }
+      }
+    }
+  }
+  return tileIndexes;
+}
+
+/* Load all tiles or only tiles for region if not empty. Unloads all tiles outside of region. */
+void loadRegion(WindAltLayer& layer, const QVector<Rect>& region)
+{
+  if(!layer.loadable)
+    return;
+
+  if(region.isEmpty() || layer.grid.getSize() <= FULL_LOAD_GRID_SIZE)
+    loadTiles(layer, QSet<int>());
+  else
+  {
+    QSet<int> tileIndexes = tilesForRects(layer, region);
+
+    // Unload tiles outside of region
+    for(int i = 0; i < layer.tiles.size(); i++)
+    {
+      if(!tileIndexes.contains(i))
+        layer.tiles[i].clear();
+    }
+
+    if(!tileIndexes.isEmpty())
+      loadTiles(layer, tileIndexes);
+  }
+}
+
+// Required GRIB parameters:
+// shapeOfTheEarth = 6;
+// iScansNegatively = 0;
+// jScansPositively = 0;
+// jPointsAreConsecutive = 0;
+// alternativeRowScanning = 0;
+// Example for global one degree grid - other resolutions and regional grids are supported too:
+// Ni = 360;
+// Nj = 181;
+// latitudeOfFirstGridPointInDegrees = 90;
+// longitudeOfFirstGridPointInDegrees = 0;
+// latitudeOfLastGridPointInDegrees = -90;
+// longitudeOfLastGridPointInDegrees = 359;
+// iDirectionIncrementInDegrees = 1;
+// jDirectionIncrementInDegrees = 1;
+// Ni — number of points along a parallel
+// Nj — number of points along a meridian
+// multiplying Ni (octets 31-34) by Nj (octets 35-38) yields the total number of points
+// i direction - west to east along a parallel or left to right along an x-axis.
+// j direction - south to north along a meridian, or bottom to top along a y-axis.
+// V component of wind; northward_wind;
+// U component of wind; eastward_wind;
+/* Create layers from U/V datasets. Tiles are not loaded. Throws atools::Exception for invalid datasets. */
+void convertDataset(WindLayerSet& layerSet, const GribDatasetVector& datasets)
+{
+  ATOOLS_TRACE_SCOPE("WindQuery::convertDataset", "grib");
+
+  for(int dsidx = 0; dsidx + 1 < datasets.size(); dsidx += 2)
+  {
+    const GribDataset& datasetUWind = datasets.at(dsidx);
+    const GribDataset& datasetVWind = datasets.at(dsidx + 1);
+
+    // Need parametes ordered by U and V
+    if(datasetUWind.getParameterType() == atools::grib::U_WIND &&
+       datasetVWind.getParameterType() == atools::grib::V_WIND)
+    {
+      if(datasetUWind.getGrid() != datasetVWind.getGrid())
+        throw atools::Exception("Different grids for U and V wind component");
+
+      if(datasetUWind.getDatetime().isValid())
+        layerSet.analysisTime = datasetUWind.getDatetime();
+
+      WindAltLayer layer;
+      layer.altitude = roundToInt(datasetUWind.getAltFeetRounded());
+      layer.surface = datasetUWind.getSurface();
+      layer.initTiles(datasetUWind.getGrid());
+      layer.datasetU = datasetUWind;
+      layer.datasetV = datasetVWind;
+      layer.loadable = true;
+      layerSet.layers.insert(atools::roundToInt(layer.altitude), layer);
+    }
+    else
+      throw atools::Exception("Invalid dataset order for  U and V wind component");
+  }
+}
+
+/* Reads or converts GRIB data and loads tiles in the background. Passes the result to WindQuery::windLayersReady()
+ * using the event queue. */
+class WindLayerRunnable :
+  public QRunnable
+{
+public:
+  WindLayerRunnable(WindQuery *queryParam, const QSharedPointer<WindLayerState>& stateParam, int generationParam,
+                    const QVector<Rect>& regionParam, bool verboseParam)
+    : query(queryParam), state(stateParam), region(regionParam), generation(generationParam), verbose(verboseParam)
+  {
+    setAutoDelete(true);
+  }
+
+  /* One of the three sources */
+  QString filename;
+  GribDatasetVector datasets;
+  std::shared_ptr<const WindLayerSet> base;
+
+  virtual void run() override
+  {
+    std::shared_ptr<WindLayerSet> layerSet(new WindLayerSet);
+    QString error;
+
+    try
+    {
+      if(!filename.isEmpty())
+      {
+        // Decode only layers which are used
+        GribReader reader(verbose);
+        reader.setIndexed(true);
+        reader.readFile(filename);
+        convertDataset(*layerSet, reader.getDatasets());
+      }
+      else if(base)
+        // Copy base to reload tiles for a changed region - tiles and GRIB data are implicitly shared
+        *layerSet = *base;
+      else
+        convertDataset(*layerSet, datasets);
+
+      for(WindAltLayer& layer : layerSet->layers)
+      {
+        if(state->generation.loadAcquire() != generation)
+          return;
+
+        loadRegion(layer, region);
+      }
+    }
+    catch(atools::Exception& e)
+    {
+      error = e.getMessage();
+    }
+    catch(...)
+    {
+      error = WindQuery::tr("Unknown error.");
+    }
+
+    {
+      QMutexLocker locker(&state->mutex);
+      if(state->generation.loadAcquire() != generation)
+        return;
+
+      state->result = layerSet;
+      state->error = error;
+      state->resultGeneration = generation;
+    }
+
+    // WindQuery waits in destructor for all tasks - pointer is valid here
+    QMetaObject::invokeMethod(query, "windLayersReady", Qt::QueuedConnection, Q_ARG(int, generation));
+  }
+
+private:
+  WindQuery *query;
+  QSharedPointer<WindLayerState> state;
+  QVector<Rect> region;
+  int generation;
+  bool verbose;
+};
+
+// Debug IO =======================================================================
+QDebug operator<<(QDebug out, const WindPos& windPos)
+{
+  QDebugStateSaver saver(out);
+  out.noquote().nospace() << "WindPos(" << windPos.wind << ", " << windPos.pos << ")";
+  return out;
+}
+
+QDebug operator<<(QDebug out, const Wind& wind)
+{
+  QDebugStateSaver saver(out);
+  out.noquote().nospace() << "Wind(speed " << wind.speed << ", dir " << wind.dir << ")";
+  return out;
 }
 
 // ===============================================================
@@ -195,12 +748,26 @@ WindQuery::WindQuery(QObject *parentObject, bool logVerbose)
   fileWatcher = new atools::util::FileSystemWatcher(parentObject, logVerbose);
   fileWatcher->setMinFileSize(180000);
   connect(fileWatcher, &atools::util::FileSystemWatcher::fileUpdated, this, &WindQuery::gribFileUpdated);
+
+  // Decoding is done in one separate thread to keep the global pool free
+  state = QSharedPointer<WindLayerState>(new WindLayerState);
+  threadPool = new QThreadPool;
+  threadPool->setMaxThreadCount(1);
+
+  lineCache = new atools::util::LruCache<WindLineKey, WindData>(LINE_CACHE_SIZE, 0, LINE_CACHE_SHARDS);
 }
 
 WindQuery::~WindQuery()
 {
+  // Stop running tasks and wait for them since they keep a pointer to this
+  state->generation.fetchAndAddOrdered(1);
+  threadPool->clear();
+  threadPool->waitForDone();
+  delete threadPool;
+
   delete downloader;
   delete fileWatcher;
+  delete lineCache;
 }
 
 void WindQuery::initFromUrl(const QString& baseUrl)
@@ -233,83 +800,84 @@ void WindQuery::initFromFixedModel(float dirLower, float speedLower, float altit
 {
   deinit();
 
+  std::shared_ptr<WindLayerSet> layerSet(new WindLayerSet);
+
   // Add lower layer ==========================
   WindAltLayer groundLayer;
   groundLayer.altitude = roundToInt(altitudeLower);
-  groundLayer.winds.fill(WindData{windUComponent(speedLower, dirLower),
-                                  windVComponent(speedLower, dirLower)}, 360 * 181);
-  windLayers.insert(atools::roundToInt(groundLayer.altitude), groundLayer);
+  fillLayer(groundLayer, WindData{windUComponent(speedLower, dirLower), windVComponent(speedLower, dirLower)});
+  layerSet->layers.insert(atools::roundToInt(groundLayer.altitude), groundLayer);
 
   // Add upper layer ==========================
   WindAltLayer altLayer;
   altLayer.altitude = roundToInt(altitudeUpper);
-  altLayer.winds.fill(WindData{windUComponent(speedUpper, dirUpper),
-                               windVComponent(speedUpper, dirUpper)}, 360 * 181);
-  windLayers.insert(atools::roundToInt(altLayer.altitude), altLayer);
+  fillLayer(altLayer, WindData{windUComponent(speedUpper, dirUpper), windVComponent(speedUpper, dirUpper)});
+  layerSet->layers.insert(atools::roundToInt(altLayer.altitude), altLayer);
+
+  // Small enough to be created in this thread
+  std::atomic_store(&windLayers, std::shared_ptr<const WindLayerSet>(layerSet));
+  lineCache->clear();
 }
 
 void WindQuery::deinit()
 {
+  // Discard results of running tasks
+  state->generation.fetchAndAddOrdered(1);
+  threadPool->clear();
+
   analyisTime = QDateTime();
-  windLayers.clear();
+  std::atomic_store(&windLayers, std::shared_ptr<const WindLayerSet>());
+  lineCache->clear();
   downloader->stopDownload();
   fileWatcher->stopWatching();
 }
 
-Wind WindQuery::getWindForPos(const Pos& pos, bool interpolateValue) const
+bool WindQuery::hasWindData() const
 {
-  if(!pos.isValid())
-  {
-    qWarning() << Q_FUNC_INFO << "invalid pos";
-    return EMPTY_WIND;
-  }
-  // Calculate grid position
-  QPoint gPos = gridPos(pos);
-
-  if(verbose)
-    qDebug() << Q_FUNC_INFO << pos << gPos;
+  std::shared_ptr<const WindLayerSet> layerSet = std::atomic_load(&windLayers);
+  return layerSet && !layerSet->layers.isEmpty();
+}
 
-  // Get next layers below and above altitude
-  WindAltLayer lower, upper;
-  layersByAlt(lower, upper, pos.getAltitude());
+void WindQuery::setRegion(const QVector<atools::geo::Rect>& rects)
+{
+  region = rects;
 
-  if(!interpolateValue || pos.nearGrid())
+  // Reload tiles in background if there are large grids
+  std::shared_ptr<const WindLayerSet> layerSet = std::atomic_load(&windLayers);
+  if(layerSet)
   {
-    // No need to interpolate within grid - use position as is
-    WindData lW = windForLayer(lower, gPos);
-
-    if(upper != lower)
+    for(const WindAltLayer& layer : layerSet->layers)
     {
-      WindData uW = windForLayer(upper, gPos);
-      // Interpolate between upper and lower layer
-      return interpolateWind(lW, uW, lower.altitude, upper.altitude, pos.getAltitude()).toWind();
+      if(layer.loadable && layer.grid.getSize() > FULL_LOAD_GRID_SIZE)
+      {
+        WindLayerRunnable *runnable = createRunnable();
+        runnable->base = layerSet;
+        threadPool->start(runnable);
+        break;
+      }
     }
-    else
-      return lW.toWind();
   }
-  else
+}
+
+Wind WindQuery::getWindForPos(const Pos& pos, bool interpolateValue) const
+{
+  if(!pos.isValid())
   {
-    Rect global = globalRect(pos);
-    GridRect grid = gridRect(global);
+    qWarning() << Q_FUNC_INFO << "invalid pos";
+    return EMPTY_WIND;
+  }
 
-    // Interpolate wind within a grid rectangle for the lower layer
-    WindRect windRectLower;
-    windRectForLayer(windRectLower, lower, grid);
-    WindData lWind = interpolateRect(windRectLower, global, pos);
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << pos;
 
-    if(upper != lower)
-    {
-      // Interpolate wind within a grid rectangle for the upper layer if layers differ
-      WindRect windRectUpper;
-      windRectForLayer(windRectUpper, upper, grid);
-      WindData uWind = interpolateRect(windRectUpper, global, pos);
+  std::shared_ptr<const WindLayerSet> layerSet = std::atomic_load(&windLayers);
+  if(!layerSet)
+    return EMPTY_WIND;
 
-      // Interpolate between upper and lower wind
-      return interpolateWind(lWind, uWind, lower.altitude, upper.altitude, pos.getAltitude()).toWind();
-    }
-    else
-      return lWind.toWind();
-  }
+  // No need to interpolate within grid if position is at a grid point
+  WindData windData;
+  windDataForPosBatch(layerSet->layers, &windData, &pos, 1, interpolateValue && !pos.nearGrid());
+  return windData.toWind();
 }
 
 atools::grib::WindPosVector WindQuery::getWindForRect(const Rect& rect, float altFeet) const
@@ -321,67 +889,86 @@ atools::grib::WindPosVector WindQuery::getWindForRect(const Rect& rect, float al
 
 void WindQuery::getWindForRect(WindPosVector& result, const Rect& rect, float altFeet) const
 {
-  if(windLayers.isEmpty())
+  // Keep a reference to the current layers while querying - updates do not affect this
+  std::shared_ptr<const WindLayerSet> layerSet = std::atomic_load(&windLayers);
+  if(!layerSet || layerSet->layers.isEmpty())
     return;
 
   if(rect.isPoint(atools::geo::Pos::POS_EPSILON_100M))
   {
     // No need to interpolate for single point and very small rectangles
     WindPos wp;
-    wp.wind = getWindForPos(rect.getCenter().alt(altFeet)); // Set altitude into pos
+    Pos pos = rect.getCenter().alt(altFeet); // Set altitude into pos
+    WindData windData;
+    windDataForPosBatch(layerSet->layers, &windData, &pos, 1, !pos.nearGrid());
+    wp.wind = windData.toWind();
     wp.pos = rect.getTopLeft();
     result.append(wp);
   }
   else
   {
+    // Use grid of the finer layer at the altitude
+    const WindAltLayer *lower = nullptr, *upper = nullptr;
+    layerPtrsByAlt(layerSet->layers, lower, upper, altFeet);
+    GribGrid grid = upper->grid;
+    if(lower != nullptr && lower->grid.incrementLonX < grid.incrementLonX)
+      grid = lower->grid;
+
+    QVector<Pos> positions;
+
     // Split rectangle if it crosses the anti-meridian (date line)
     for(const atools::geo::Rect& r : rect.splitAtAntiMeridian())
     {
-      // Get next layers below and above altitude
-      WindAltLayer lower, upper;
-      layersByAlt(lower, upper, altFeet);
+      // Start at grid points west and north of the rectangle
+      float west = grid.firstLonX + std::floor((r.getWest() - grid.firstLonX) / grid.incrementLonX) * grid.incrementLonX;
+      float north = grid.firstLatY - std::floor((grid.firstLatY - r.getNorth()) / grid.incrementLatY) * grid.incrementLatY;
 
-      for(float lonx = std::floor(r.getWest()); lonx <= r.getEast(); lonx += 1.f)
+      for(float lonx = west; lonx <= r.getEast(); lonx += grid.incrementLonX)
       {
-        for(float laty = std::ceil(r.getNorth()); laty >= r.getSouth(); laty -= 1.f)
-        {
-          Pos cell(lonx, laty);
-          QPoint gPos = gridPos(cell);
-
-          WindPos wp;
-          // Calcualte grid cell upper left position (position for value)
-          wp.pos = cell;
-          wp.pos.setAltitude(altFeet);
-
-          if(upper != lower)
-            // Interpolate wind within a grid rectangle for the upper layer if layers differ
-            wp.wind = interpolateWind(windForLayer(lower, gPos), windForLayer(upper, gPos),
-                                      lower.altitude, upper.altitude, altFeet).toWind();
-          else
-            wp.wind = windForLayer(lower, gPos).toWind();
-
-          result.append(wp);
-        }
+        for(float laty = north; laty >= r.getSouth(); laty -= grid.incrementLatY)
+          positions.append(Pos(atools::geo::normalizeLonXDeg(lonx), laty, altFeet));
       }
     }
+
+    // Positions are at grid points of the finer grid and interpolated for the other layer
+    QVector<WindData> winds(positions.size());
+    windDataForPosBatch(layerSet->layers, winds.data(), positions.constData(), positions.size());
+
+    for(int i = 0; i < positions.size(); i++)
+    {
+      WindPos wp;
+      wp.pos = positions.at(i);
+      wp.wind = winds.at(i).toWind();
+      result.append(wp);
+    }
   }
 }
 
 Wind WindQuery::getWindAverageForLineString(const geo::LineString& linestring) const
 {
+  std::shared_ptr<const WindLayerSet> layerSet = std::atomic_load(&windLayers);
+  if(!layerSet)
+    return EMPTY_WIND;
+
   if(linestring.size() == 1)
+  {
     // Only one position
-    return getWindForPos(linestring.getPos1());
+    Pos pos = linestring.getPos1();
+    WindData windData;
+    windDataForPosBatch(layerSet->layers, &windData, &pos, 1);
+    return windData.toWind();
+  }
   else if(linestring.size() == 2)
     // Only one line
-    return getWindAverageForLine(linestring.toLine());
+    return cachedWindAverageForLine(*layerSet, linestring.getPos1(), linestring.getPos2()).toWind();
   else
   {
     WindData windData = EMPTY_WIND_DATA;
     // Sum up values
     for(int i = 0; i < linestring.size() - 1; i++)
     {
-      WindData wd = windAverageForLine(linestring.at(i), linestring.at(i + 1));
+      // Legs which were not changed since the last call are taken from the cache
+      WindData wd = cachedWindAverageForLine(*layerSet, linestring.at(i), linestring.at(i + 1));
       windData.u += wd.u;
       windData.v += wd.v;
     }
@@ -402,14 +989,22 @@ QString WindQuery::getDebug(const geo::Pos& pos) const
   out.setRealNumberPrecision(2);
   out.setRealNumberNotation(QTextStream::FixedNotation);
   out << "=================" << endl;
-  for(int altitude : windLayers.keys())
-  {
-    WindAltLayer layer = windLayers.value(altitude);
-    QPoint grid = gridPos(pos);
-    WindData wind = windForLayer(layer, grid);
 
-    out << "altitude " << altitude << " surface " << layer.surface
-        << " grid x " << grid.x() << " y " << grid.y() << endl;
+  std::shared_ptr<const WindLayerSet> layerSet = std::atomic_load(&windLayers);
+  if(!layerSet)
+    return retval;
+
+  for(const WindAltLayer& layer : layerSet->layers)
+  {
+    // Get nearest grid point
+    WindBatchLayer batch;
+    prepareCell(batch, 0, &layer, pos, false /* interpolate */);
+    gatherCorners(batch, 1);
+    WindData wind = {batch.u[0][0], batch.v[0][0]};
+
+    out << "altitude " << layer.altitude << " surface " << layer.surface
+        << " grid x " << batch.col0[0] << " y " << batch.row0[0] << " inside " << batch.inside[0]
+        << " size " << layer.grid.ni << "x" << layer.grid.nj << endl;
     out << "wind u " << wind.u << " v " << wind.v << " kts "
         << " dir " << windDirectionFromUV(wind.u, wind.v) << " deg T"
         << " speed " << windSpeedFromUV(wind.u, wind.v) << " kts" << endl;
@@ -429,11 +1024,6 @@ void WindQuery::getValidity(QDateTime& from, QDateTime& to) const
   to = analyisTime.addSecs(3600 * 6);
 }
 
-WindData WindQuery::windForLayer(const WindAltLayer& layer, const QPoint& point) const
-{
-  return layer.isValid() ? layer.winds.at(point.x() + point.y() * 360) : EMPTY_WIND_DATA;
-}
-
 Wind WindQuery::getWindAverageForLine(const Line& line) const
 {
   return getWindAverageForLine(line.getPos1(), line.getPos2());
@@ -441,10 +1031,32 @@ Wind WindQuery::getWindAverageForLine(const Line& line) const
 
 Wind WindQuery::getWindAverageForLine(const Pos& pos1, const Pos& pos2) const
 {
-  return windAverageForLine(pos1, pos2).toWind();
+  std::shared_ptr<const WindLayerSet> layerSet = std::atomic_load(&windLayers);
+  if(!layerSet)
+    return EMPTY_WIND;
+
+  return cachedWindAverageForLine(*layerSet, pos1, pos2).toWind();
 }
 
-WindData WindQuery::windAverageForLine(const Pos& pos1, const Pos& pos2) const
+WindData WindQuery::cachedWindAverageForLine(const WindLayerSet& layerSet, const Pos& pos1, const Pos& pos2) const
+{
+  if(!pos1.isValid() || !pos2.isValid())
+    // Let the calculation print the warning
+    return windAverageForLine(layerSet, pos1, pos2);
+
+  WindLineKey key = {pos1.getLonX(), pos1.getLatY(), pos1.getAltitude(), pos2.getLonX(), pos2.getLatY(),
+                     pos2.getAltitude(), samplesPerDegree, layerSet.serial};
+
+  WindData windData;
+  if(!lineCache->find(key, windData))
+  {
+    windData = windAverageForLine(layerSet, pos1, pos2);
+    lineCache->insert(key, windData);
+  }
+  return windData;
+}
+
+WindData WindQuery::windAverageForLine(const WindLayerSet& layerSet, const Pos& pos1, const Pos& pos2) const
 {
   WindData windData = EMPTY_WIND_DATA;
 
@@ -478,34 +1090,13 @@ WindData WindQuery::windAverageForLine(const Pos& pos1, const Pos& pos2) const
     // Only start and end needed
     positions << pos1 << pos2;
 
-  WindRect windRectLower, windRectUpper;
+  // Interpolate all samples at once
+  QVector<Pos> samples = positions.toVector();
+  QVector<WindData> winds(samples.size());
+  windDataForPosBatch(layerSet.layers, winds.data(), samples.constData(), samples.size());
 
-  for(const atools::geo::Pos& pos : positions)
+  for(const WindData& w : winds)
   {
-    Rect global = globalRect(pos);
-    GridRect grid = gridRect(global);
-
-    // Get next layers below and above altitude
-    WindAltLayer lower, upper;
-    layersByAlt(lower, upper, pos.getAltitude());
-
-    // Get interpolated wind in grid cell at lower layer
-    windRectForLayer(windRectLower, lower, grid);
-    WindData lW = interpolateRect(windRectLower, global, pos);
-
-    WindData w;
-    if(upper != lower)
-    {
-      // Get interpolated wind in grid cell at upper layer
-      windRectForLayer(windRectUpper, upper, grid);
-
-      // Interpolate at altitude between layers
-      w = interpolateWind(lW, interpolateRect(windRectUpper, global, pos),
-                          lower.altitude, upper.altitude, pos.getAltitude());
-    }
-    else
-      w = lW;
-
     windData.u += w.u;
     windData.v += w.v;
   }
@@ -515,67 +1106,68 @@ WindData WindQuery::windAverageForLine(const Pos& pos1, const Pos& pos2) const
   return windData;
 }
 
-void WindQuery::layersByAlt(WindAltLayer& lower, WindAltLayer& upper, float altitude) const
+void WindQuery::getWindForPosBatch(QVector<Wind>& winds, const QVector<Pos>& positions) const
 {
-  if(windLayers.size() == 1)
-    // Only one wind layer
-    lower = upper = windLayers.first();
-  else if(windLayers.size() > 1)
-  {
-    // Returns an iterator pointing to the first item with key key in the map.
-    // If the map contains no item with key key, the function returns an iterator to the nearest item with a greater key.
-    QMap<int, WindAltLayer>::const_iterator it = windLayers.lowerBound(atools::roundToInt(altitude));
-    if(it != windLayers.end())
-    {
-      if(atools::almostEqual(it->altitude, atools::roundToInt(altitude), ALTITUDE_EPSILON))
-        // Layer is at requested altitude - no need to interpolate
-        lower = upper = *it;
-      else if(it == windLayers.begin())
-      {
-        // First layer - add a zero wind layer for interpolation between layer and ground
-        upper = *it;
+  QVector<WindData> windData(positions.size());
 
-        lower.altitude = 0.f;
-        lower.winds.fill(EMPTY_WIND_DATA, 360 * 181);
-      }
-      else
-      {
-        lower = *(it - 1);
-        upper = *it;
-      }
-    }
-    else
-      lower = upper = windLayers.last();
-  }
+  std::shared_ptr<const WindLayerSet> layerSet = std::atomic_load(&windLayers);
+  if(layerSet)
+    windDataForPosBatch(layerSet->layers, windData.data(), positions.constData(), positions.size());
+
+  winds.resize(positions.size());
+  for(int i = 0; i < positions.size(); i++)
+    winds[i] = positions.at(i).isValid() ? windData.at(i).toWind() : EMPTY_WIND;
 }
 
-WindData WindQuery::interpolateRect(const WindRect& windRect, const atools::geo::Rect& rect, const geo::Pos& pos) const
+WindLayerRunnable *WindQuery::createRunnable()
 {
-  float left = rect.getWest(), right = rect.getEast(), top = rect.getNorth(), bottom = rect.getSouth();
+  // Invalidate all older tasks
+  int generation = state->generation.fetchAndAddOrdered(1) + 1;
+  threadPool->clear();
 
-  // Interpolate at top and bottom between left and right
-  WindData wTop = interpolateWind(windRect.topLeft, windRect.topRight, left, right, pos.getLonX());
-  WindData wBottom = interpolateWind(windRect.bottomLeft, windRect.bottomRight, left, right, pos.getLonX());
-
-  // Interpolate between top and bottom
-  return interpolateWind(wTop, wBottom, top, bottom, pos.getLatY());
+  return new WindLayerRunnable(this, state, generation, region, verbose);
 }
 
-void WindQuery::windRectForLayer(WindRect& windRect, const WindAltLayer& layer, const GridRect& rect) const
+void WindQuery::windLayersReady(int generation)
 {
-  windRect.topLeft = windForLayer(layer, rect.topLeft);
-  windRect.topRight = windForLayer(layer, rect.topRight);
-  windRect.bottomRight = windForLayer(layer, rect.bottomRight);
-  windRect.bottomLeft = windForLayer(layer, rect.bottomLeft);
+  std::shared_ptr<const WindLayerSet> layerSet;
+  QString error;
+  {
+    QMutexLocker locker(&state->mutex);
+    if(state->resultGeneration != generation || state->generation.loadAcquire() != generation)
+      // Outdated
+      return;
+
+    layerSet = state->result;
+    error = state->error;
+    state->result.reset();
+  }
+
+  if(!error.isEmpty())
+  {
+    emit windDownloadFailed(error, 0);
+    return;
+  }
+
+  if(layerSet->analysisTime.isValid())
+    analyisTime = layerSet->analysisTime;
+
+  // Publish new layers - running queries keep their reference to the old set
+  std::atomic_store(&windLayers, layerSet);
+
+  // Cached results of the old set cannot be hit anymore - release memory
+  lineCache->clear();
+  emit windDataUpdated();
 }
 
 void WindQuery::gribDownloadFinished(const GribDatasetVector& datasets, QString downloadUrl)
 {
   qDebug() << Q_FUNC_INFO << downloadUrl;
 
-  // Download finished - update coordinates
-  convertDataset(datasets);
-  emit windDataUpdated();
+  // Download finished - decode and update coordinates in background
+  WindLayerRunnable *runnable = createRunnable();
+  runnable->datasets = datasets;
+  threadPool->start(runnable);
 }
 
 void WindQuery::gribDownloadFailed(const QString& error, int errorCode, QString downloadUrl)
@@ -587,103 +1179,11 @@ void WindQuery::gribDownloadFailed(const QString& error, int errorCode, QString
 void WindQuery::gribFileUpdated(const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
-  try
-  {
-    GribReader reader(verbose);
-
-    reader.readFile(filename);
-    convertDataset(reader.getDatasets());
-  }
-  catch(atools::Exception& e)
-  {
-    emit windDownloadFailed(e.getMessage(), 0);
-    return;
-  }
-  catch(...)
-  {
-    emit windDownloadFailed(tr("Unknown error."), 0);
-    return;
-  }
 
-  emit windDataUpdated();
-}
-
-// Required GRIB parameters:
-// shapeOfTheEarth = 6;
-// Ni = 360;
-// Nj = 181;
-// iScansNegatively = 0;
-// jScansPositively = 0;
-// jPointsAreConsecutive = 0;
-// alternativeRowScanning = 0;
-// latitudeOfFirstGridPointInDegrees = 90;
-// longitudeOfFirstGridPointInDegrees = 0;
-// latitudeOfLastGridPointInDegrees = -90;
-// longitudeOfLastGridPointInDegrees = 359;
-// iDirectionIncrementInDegrees = 1;
-// jDirectionIncrementInDegrees = 1;
-// Ni — number of points along a parallel - 360
-// Nj — number of points along a meridian - 181
-// multiplying Ni (octets 31-34) by Nj (octets 35-38) yields the total number of points
-// i direction - west to east along a parallel or left to right along an x-axis.
-// j direction - south to north along a meridian, or bottom to top along a y-axis.
-// V component of wind; northward_wind;
-// U component of wind; eastward_wind;
-void WindQuery::convertDataset(const GribDatasetVector& datasets)
-{
-  windLayers.clear();
-
-  for(int dsidx = 0; dsidx < datasets.size(); dsidx += 2)
-  {
-    const GribDataset& datasetUWind = datasets.at(dsidx);
-    const GribDataset& datasetVWind = datasets.at(dsidx + 1);
-
-    // Need parametes ordered by U and V
-    if(datasetUWind.getParameterType() == atools::grib::U_WIND &&
-       datasetVWind.getParameterType() == atools::grib::V_WIND)
-    {
-      if(datasetUWind.getDatetime().isValid())
-        analyisTime = datasetUWind.getDatetime();
-
-      const QVector<float>& dataU = datasetUWind.getData();
-      const QVector<float>& dataV = datasetVWind.getData();
-      WindAltLayer layer;
-      layer.altitude = roundToInt(datasetUWind.getAltFeetRounded());
-      layer.surface = datasetUWind.getSurface();
-
-      for(int j = 0; j < 181; j++) // y
-      {
-        for(int i = 0; i < 360; i++) // x
-        {
-          WindData wind;
-          wind.u = atools::geo::meterPerSecToKnots(dataU.at(i + j * 360));
-          wind.v = atools::geo::meterPerSecToKnots(dataV.at(i + j * 360));
-          layer.winds.append(wind);
-        }
-      }
-      windLayers.insert(atools::roundToInt(layer.altitude), layer);
-    }
-    else
-      throw atools::Exception("Invalid dataset order for  U and V wind component");
-  }
-}
-
-/* Interpolate wind speed and direction between two altitude layers */
-WindData WindQuery::interpolateWind(const WindData& w0, const WindData& w1, float alt0, float alt1, float alt) const
-{
-  if(w0 == w1)
-    return w0;
-  else if(atools::almostEqual(alt0, alt))
-    return w0;
-  else if(atools::almostEqual(alt1, alt))
-    return w1;
-  else
-  {
-    WindData w;
-    w.u = interpolate(w0.u, w1.u, alt0, alt1, alt);
-    w.v = interpolate(w0.v, w1.v, alt0, alt1, alt);
-    return w;
-  }
+  // Read, decode and update coordinates in background
+  WindLayerRunnable *runnable = createRunnable();
+  runnable->filename = filename;
+  threadPool->start(runnable);
 }
 
 Wind WindData::toWind() const
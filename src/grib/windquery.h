@@ -21,15 +21,23 @@
 #include "grib/gribcommon.h"
 
 #include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <memory>
 
 #include "geo/pos.h"
 #include "atools.h"
 
 class QObject;
+class QThreadPool;
 
 namespace atools {
 namespace util {
 class FileSystemWatcher;
+
+template<typename KEY, typename TYPE>
+class LruCache;
 }
 
 namespace geo {
@@ -116,10 +124,12 @@ const atools::grib::WindPos EMPTY_WIND_POS;
 typedef QVector<WindPos> WindPosVector;
 typedef QList<WindPos> WindPosList;
 
-struct WindRect;
-struct GridRect;
 struct WindData;
 struct WindAltLayer;
+struct WindLayerSet;
+struct WindLayerState;
+struct WindLineKey;
+class WindLayerRunnable;
 
 /*
  * Takes care for downloading/reading and decoding of GRIB2 wind files. Provides a query API to calculate and interpolate
@@ -131,6 +141,8 @@ struct WindAltLayer;
  *
  * Data is updated automatically every 30 minutes.
  * Files are checked for changes.
+ * Reading, decoding and converting is done in a background thread. The finished layers replace the current ones
+ * atomically and windDataUpdated() is emitted. Query methods are lock free and can be called from any thread.
  *
  * All internal calculations the U and V components of the wind instead of speed and direction.
  * Most query methods use the altitude from the Pos parameter.
@@ -178,22 +190,33 @@ public:
   /* Get interpolated wind data for single position. Altitude in feet is used from position. */
   Wind getWindForPos(const atools::geo::Pos& pos, bool interpolateValue = true) const;
 
+  /* Get interpolated winds for a list of positions. Altitude in feet is used from each position.
+   * Same as getWindForPos() with interpolation for each position but processes the positions in vectorized chunks.
+   * winds is resized to the number of positions and contains EMPTY_WIND for invalid positions. */
+  void getWindForPosBatch(QVector<atools::grib::Wind>& winds, const QVector<atools::geo::Pos>& positions) const;
+
   /* Get an array of wind data for the given rectangle at the given altitude from the data grid.
-   * Data is only interpolated between layers. Result is sorted by y and x coordinates.*/
+   * Uses the points of the finer grid of the two layers at altitude. Data is only interpolated between layers
+   * and in the coarser layer if grids differ. Result is sorted by y and x coordinates.*/
   void getWindForRect(atools::grib::WindPosVector& result, const geo::Rect& rect, float altFeet) const;
   atools::grib::WindPosVector getWindForRect(const atools::geo::Rect& rect, float altFeet) const;
 
   /* Get average wind for the great circle line between the two given positions at the given altitude.
    *  Wind data is fetched for a certain number of spots along the line and thus not perfectly accurate.
-   * Uses altitude from positions and interpolates between altitudes too if they are different. */
+   * Uses altitude from positions and interpolates between altitudes too if they are different.
+   * Results are cached per line until the wind data changes. Unchanged legs of a line string are not
+   * calculated again. */
   Wind getWindAverageForLine(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2) const;
   Wind getWindAverageForLine(const atools::geo::Line& line) const;
   Wind getWindAverageForLineString(const atools::geo::LineString& linestring) const;
 
-  bool hasWindData() const
-  {
-    return !windLayers.isEmpty();
-  }
+  bool hasWindData() const;
+
+  /* Limit wind data in memory to tiles covering the rectangles like the map view or a flight plan corridor.
+   * Tiles are reloaded from the kept raw GRIB data in background and published with windDataUpdated().
+   * Queries outside of the region give zero wind. Empty list loads all tiles.
+   * Only used for large grids like global 0.5 or 0.25 degree. Smaller grids are always loaded completely. */
+  void setRegion(const QVector<atools::geo::Rect>& rects);
 
   /* Samples per degree for wind interpolation along lines and line strings */
   void setSamplesPerDegree(int value)
@@ -227,30 +250,23 @@ signals:
   void windDownloadSslErrors(const QStringList& errors, const QString& downloadUrl);
 
 private:
-  /* Wind for grid position */
-  WindData windForLayer(const WindAltLayer& layer, const QPoint& point) const;
-
-  /* Get layer above and below (or at) altitude */
-  void layersByAlt(WindAltLayer& lower, WindAltLayer& upper, float altitude) const;
+  /* Create task for a new update with the current region. Invalidates all running tasks. */
+  atools::grib::WindLayerRunnable *createRunnable();
 
-  /* Fill cell rectangle with wind values at corners */
-  void windRectForLayer(WindRect& windRect, const WindAltLayer& layer, const atools::grib::GridRect& rect) const;
-
-  /* Quadratic interpolation- Returns wind for position in the grid cell */
-  WindData interpolateRect(const WindRect& windRect, const geo::Rect& rect, const geo::Pos& pos) const;
-
-  /* Convert data from U/V components to speed/heading */
-  void convertDataset(const atools::grib::GribDatasetVector& datasets);
+  /* Called by background task through the event queue to publish the new layers */
+  Q_INVOKABLE void windLayersReady(int generation);
 
   void gribDownloadFinished(const atools::grib::GribDatasetVector& datasets, QString downloadUrl);
   void gribDownloadFailed(const QString& error, int errorCode, QString downloadUrl);
   void gribFileUpdated(const QString& filename);
 
-  /* get interpolated wind for two sets at two altitudes */
-  WindData interpolateWind(const WindData& w0, const WindData& w1, float alt0, float alt1, float alt) const;
-
   /* Get average wind for a line between two points. Uses only U and V components */
-  WindData windAverageForLine(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2) const;
+  WindData windAverageForLine(const WindLayerSet& layerSet, const atools::geo::Pos& pos1,
+                              const atools::geo::Pos& pos2) const;
+
+  /* As above but uses lineCache */
+  WindData cachedWindAverageForLine(const WindLayerSet& layerSet, const atools::geo::Pos& pos1,
+                                    const atools::geo::Pos& pos2) const;
 
   /* Surfaces to download from NOAA. Negative value denotes AGL in ft and positive is millibar */
   const QVector<int> SURFACES = {-80, 150, 200, 250, 300, 450, 700};
@@ -268,9 +284,21 @@ private:
 
   bool verbose = false;
 
-  /* Maps rounded altitude to wind layer data. Sorted by altitude. */
-  QMap<int, WindAltLayer> windLayers;
+  /* Current immutable layers. Replaced atomically on updates. Queries keep a reference while running
+   * and do not need any locking. Null if not initialized. */
+  std::shared_ptr<const atools::grib::WindLayerSet> windLayers;
+
+  /* Keep only tiles for these rectangles in memory if not empty */
+  QVector<atools::geo::Rect> region;
+
+  /* Background reading and decoding with one thread */
+  QSharedPointer<atools::grib::WindLayerState> state;
+  QThreadPool *threadPool = nullptr;
   QDateTime analyisTime;
+
+  /* Thread safe LRU cache for average winds of lines keyed by positions, samples and layer set.
+   * Cleared whenever the layers are replaced. */
+  atools::util::LruCache<atools::grib::WindLineKey, atools::grib::WindData> *lineCache = nullptr;
 };
 
 QDebug operator<<(QDebug out, const atools::grib::Wind& wind);
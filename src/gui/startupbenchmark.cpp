@@ -0,0 +1,168 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "gui/startupbenchmark.h"
+
+#include "fs/common/magdecreader.h"
+#include "fs/fspaths.h"
+#include "gui/translator.h"
+#include "logging/logginghandler.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+
+namespace atools {
+namespace gui {
+
+StartupBenchmark::StartupBenchmark()
+{
+}
+
+void StartupBenchmark::run()
+{
+  steps.clear();
+
+  // Simulator paths from registry, settings and file system ================================
+  measure("fspaths_load", []() {
+    atools::fs::FsPaths::loadAllPaths();
+  });
+
+  // Magnetic declination ================================
+  measure("magdec_wmm", []() {
+    atools::fs::common::MagDecReader reader;
+    reader.readFromWmm();
+  });
+
+  measure("magdec_wmm_deferred", []() {
+    atools::fs::common::MagDecReader reader;
+    reader.readFromWmmDeferred();
+  });
+
+  // Translations ================================
+  if(translation)
+  {
+    QString lang = language;
+    measure("translator_load", [lang]() {
+      atools::gui::Translator::load(lang);
+      atools::gui::Translator::unload();
+    });
+  }
+  else
+    steps.append({"translator_load", -1L, -1L, false});
+
+  // Logging ================================
+  if(!logConfiguration.isEmpty())
+  {
+    QString configuration = logConfiguration, directory = logDirectory;
+    measure("logging_setup", [configuration, directory]() {
+      atools::logging::LoggingHandler::initialize(configuration, directory, "startupbenchmark");
+      atools::logging::LoggingHandler::shutdown();
+    });
+  }
+  else
+    steps.append({"logging_setup", -1L, -1L, false});
+
+  // Databases ================================
+  for(const QString& filename : databaseFiles)
+  {
+    measure("database_open_" + QFileInfo(filename).baseName(), [filename]() {
+      const QString connectionName("startup_benchmark");
+      {
+        atools::sql::SqlDatabase db(atools::sql::SqlDatabase::addDatabase("QSQLITE", connectionName));
+        db.setDatabaseName(filename);
+        db.setReadonly();
+        db.open();
+
+        // Read the schema which is done by all applications after opening
+        atools::sql::SqlQuery query(db);
+        query.exec("select count(1) from sqlite_master");
+        db.close();
+      }
+      atools::sql::SqlDatabase::removeDatabase(connectionName);
+    });
+  }
+
+  for(const StartupBenchmarkStep& step : steps)
+    qDebug() << Q_FUNC_INFO << step.name << "cold" << step.coldUs << "us" << "warm" << step.warmUs << "us"
+             << (step.error ? "error" : "");
+}
+
+void StartupBenchmark::measure(const QString& name, const std::function<void()>& func)
+{
+  StartupBenchmarkStep step;
+  step.name = name;
+
+  QElapsedTimer timer;
+  try
+  {
+    timer.start();
+    func();
+    step.coldUs = timer.nsecsElapsed() / 1000L;
+
+    timer.start();
+    func();
+    step.warmUs = timer.nsecsElapsed() / 1000L;
+  }
+  catch(std::exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << name << "Caught exception" << e.what();
+    step.error = true;
+  }
+  steps.append(step);
+}
+
+QJsonDocument StartupBenchmark::toJson() const
+{
+  QJsonArray stepArr;
+  for(const StartupBenchmarkStep& step : steps)
+  {
+    QJsonObject obj;
+    obj.insert("name", step.name);
+    obj.insert("cold_us", static_cast<double>(step.coldUs));
+    obj.insert("warm_us", static_cast<double>(step.warmUs));
+    obj.insert("skipped", step.coldUs < 0L && !step.error);
+    obj.insert("error", step.error);
+    stepArr.append(obj);
+  }
+
+  QJsonObject root;
+  root.insert("steps", stepArr);
+  return QJsonDocument(root);
+}
+
+bool StartupBenchmark::writeJson(const QString& filename) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(toJson().toJson(QJsonDocument::Indented));
+    file.close();
+    return true;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << ":" << file.errorString();
+  return false;
+}
+
+} // namespace gui
+} // namespace atools
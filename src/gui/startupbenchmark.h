@@ -0,0 +1,106 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GUI_STARTUPBENCHMARK_H
+#define ATOOLS_GUI_STARTUPBENCHMARK_H
+
+#include <QJsonDocument>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+namespace atools {
+namespace gui {
+
+/* Time of one startup step for the first and a repeated run */
+struct StartupBenchmarkStep
+{
+  QString name; /* Step name like "fspaths_load" */
+  qint64 coldUs = -1L, /* First run in this process. -1 if skipped. */
+         warmUs = -1L; /* Second run with caches, loaded libraries and drivers in place. -1 if skipped. */
+  bool error = false; /* Step threw an exception */
+};
+
+/*
+ * Reproducible measurement of the steps an application runs on startup.
+ *
+ * Measures simulator path probing in FsPaths, WMM magnetic declination calculation in MagDecReader
+ * (the immediate and the deferred variant), translation loading, logging setup and opening databases.
+ * Each step is run twice. The first run is cold for this process, the second one is warm.
+ * Caches of the operating system are not flushed, so cold does not mean a cold file system cache.
+ *
+ * Translation and logging steps change application wide state and restore it after measuring.
+ * They are skipped unless enabled, and should only be used in a benchmark program which does not set up
+ * translations or logging itself. A QCoreApplication has to exist.
+ *
+ * Results can be saved as JSON.
+ */
+class StartupBenchmark
+{
+public:
+  StartupBenchmark();
+
+  /* Run all steps. Can be repeated but cold values are only cold for the first call. */
+  void run();
+
+  const QVector<atools::gui::StartupBenchmarkStep>& getSteps() const
+  {
+    return steps;
+  }
+
+  /* Machine readable report containing all steps */
+  QJsonDocument toJson() const;
+
+  /* Write JSON report to file. Returns false on error. */
+  bool writeJson(const QString& filename) const;
+
+  /* SQLite database files opened read only. Default is none. */
+  void setDatabaseFiles(const QStringList& value)
+  {
+    databaseFiles = value;
+  }
+
+  /* Load and unload translations for language. Skipped if not set. */
+  void setTranslation(bool enable, const QString& languageParam = QString())
+  {
+    translation = enable;
+    language = languageParam;
+  }
+
+  /* Initialize logging with the configuration file and log directory and shut it down afterwards.
+   * Skipped if configuration is empty. */
+  void setLogging(const QString& configuration, const QString& directory)
+  {
+    logConfiguration = configuration;
+    logDirectory = directory;
+  }
+
+private:
+  /* Run function twice and add the result */
+  void measure(const QString& name, const std::function<void()>& func);
+
+  QVector<atools::gui::StartupBenchmarkStep> steps;
+  QStringList databaseFiles;
+  QString language, logConfiguration, logDirectory;
+  bool translation = false;
+};
+
+} // namespace gui
+} // namespace atools
+
+#endif // ATOOLS_GUI_STARTUPBENCHMARK_H
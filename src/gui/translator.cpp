@@ -17,6 +17,8 @@
 
 #include "gui/translator.h"
 
+#include "util/trace.h"
+
 #include <QDebug>
 #include <QFileInfo>
 #include <QCoreApplication>
@@ -35,6 +37,7 @@ bool Translator::loaded = false;
 
 void Translator::load(const QString& language)
 {
+  ATOOLS_TRACE_SCOPE("Translator::load", "startup");
   if(!loaded)
   {
     QFileInfo appFilePath(QCoreApplication::applicationFilePath());
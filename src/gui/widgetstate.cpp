@@ -42,12 +42,56 @@
 #include <QTableWidget>
 #include <QTreeWidget>
 #include <QListWidget>
+#include <QSettings>
+#include <QTimer>
+#include <QCoreApplication>
 
 namespace atools {
 namespace gui {
 
 using atools::settings::Settings;
 
+namespace {
+
+/* Delay for coalescing syncSettings() calls */
+const int SYNC_DELAY_MS = 500;
+
+/* Dynamic property set on widgets which wait for a deferred restore */
+const char *RESTORE_PENDING_PROPERTY = "atoolsWidgetStateRestorePending";
+
+bool syncPending = false;
+
+/* Restores a widget when shown the first time and deletes itself. Child of the widget. */
+class DeferredRestore :
+  public QObject
+{
+public:
+  DeferredRestore(const WidgetState& state, QWidget *widget)
+    : QObject(widget), widgetState(state)
+  {
+    widget->installEventFilter(this);
+  }
+
+  virtual bool eventFilter(QObject *object, QEvent *event) override
+  {
+    if(object == parent() && event->type() == QEvent::Show)
+    {
+      object->removeEventFilter(this);
+
+      // Widget might have been restored explicitly in the meantime
+      if(object->property(RESTORE_PENDING_PROPERTY).toBool())
+        widgetState.restore(object);
+      deleteLater();
+    }
+    return false;
+  }
+
+private:
+  WidgetState widgetState;
+};
+
+} // namespace
+
 WidgetState::WidgetState(const QString& settingsKeyPrefix, bool saveVisibility, bool blockSignals)
   : keyPrefix(settingsKeyPrefix), visibility(saveVisibility), block(blockSignals)
 {
@@ -58,6 +102,10 @@ void WidgetState::save(const QObject *widget) const
 {
   if(widget != nullptr)
   {
+    if(widget->property(RESTORE_PENDING_PROPERTY).toBool())
+      // Was never shown and restored - keep the values in the settings
+      return;
+
     Settings& s = Settings::instance();
 
     if(const QLayout *layout = dynamic_cast<const QLayout *>(widget))
@@ -189,6 +237,9 @@ void WidgetState::restore(QObject *widget) const
     if(block)
       widget->blockSignals(true);
 
+    if(widget->property(RESTORE_PENDING_PROPERTY).toBool())
+      widget->setProperty(RESTORE_PENDING_PROPERTY, QVariant());
+
     Settings& s = Settings::instance();
 
     if(const QLayout *layout = dynamic_cast<const QLayout *>(widget))
@@ -363,19 +414,19 @@ void WidgetState::restore(QObject *widget) const
       {
         mw->restoreState(v.toByteArray());
         if(positionRestoreMainWindow)
-          mw->move(s.valueVar(keyPrefix + "_" + mw->objectName() + "_pos", mw->pos()).toPoint());
+          mw->move(valueKey(s, keyPrefix + "_" + mw->objectName() + "_pos", mw->pos()).toPoint());
         if(sizeRestoreMainWindow)
-          mw->resize(s.valueVar(keyPrefix + "_" + mw->objectName() + "_size", mw->sizeHint()).toSize());
+          mw->resize(valueKey(s, keyPrefix + "_" + mw->objectName() + "_size", mw->sizeHint()).toSize());
 
         if(stateRestoreMainWindow)
-          if(s.valueVar(keyPrefix + "_" + mw->objectName() + "_maximized", false).toBool())
+          if(valueKey(s, keyPrefix + "_" + mw->objectName() + "_maximized", false).toBool())
             mw->setWindowState(mw->windowState() | Qt::WindowMaximized);
       }
     }
     else if(QDialog *dlg = dynamic_cast<QDialog *>(widget))
     {
       // dlg->move(s.valueVar(keyPrefix + "_" + dlg->objectName() + "_pos", dlg->pos()).toPoint());
-      dlg->resize(s.valueVar(keyPrefix + "_" + dlg->objectName() + "_size", dlg->sizeHint()).toSize());
+      dlg->resize(valueKey(s, keyPrefix + "_" + dlg->objectName() + "_size", dlg->sizeHint()).toSize());
     }
     else if(QSplitter *sp = dynamic_cast<QSplitter *>(widget))
     {
@@ -428,7 +479,20 @@ QString WidgetState::getSettingsKey(QObject *widget) const
 
 void WidgetState::syncSettings()
 {
-  Settings::instance().syncSettings();
+  if(QCoreApplication::instance() == nullptr)
+    Settings::syncSettings();
+  else if(!syncPending)
+  {
+    // Several instances usually save and sync one after the other - write file only once
+    syncPending = true;
+    QTimer::singleShot(SYNC_DELAY_MS, QCoreApplication::instance(), [] {
+        syncPending = false;
+
+        // Do not create a new instance after shutdown which writes the file already
+        if(Settings::isInitialized())
+          Settings::syncSettings();
+      });
+  }
 }
 
 void WidgetState::setMainWindowsRestoreOptions(bool position, bool size, bool state)
@@ -446,8 +510,74 @@ void WidgetState::save(const QList<QObject *>& widgets) const
 
 void WidgetState::restore(const QList<QObject *>& widgets) const
 {
+  fillCache();
+
   for(QObject *w : widgets)
-    restore(w);
+  {
+    if(deferHidden && isHiddenInWindow(w))
+      restoreWhenShown(static_cast<QWidget *>(w));
+    else
+      restore(w);
+  }
+
+  cache.clear();
+  cacheValid = false;
+}
+
+void WidgetState::fillCache() const
+{
+  cache.clear();
+
+  // Split prefix into group and start of key names
+  int groupEnd = keyPrefix.lastIndexOf('/');
+  QString group = groupEnd >= 0 ? keyPrefix.left(groupEnd) : QString();
+  QString groupPrefix = groupEnd >= 0 ? group + "/" : QString();
+  QString namePrefix = keyPrefix.mid(groupEnd + 1) + "_";
+
+  QSettings *qs = Settings::getQSettings();
+  qs->beginGroup(group);
+  const QStringList keys = qs->childKeys();
+  for(const QString& key : keys)
+  {
+    if(key.startsWith(namePrefix))
+      cache.insert(groupPrefix + key, qs->value(key));
+  }
+  qs->endGroup();
+
+  cacheValid = true;
+}
+
+bool WidgetState::isHiddenInWindow(QObject *widget) const
+{
+  QWidget *w = dynamic_cast<QWidget *>(widget);
+  return w != nullptr && !w->isWindow() && !w->isVisibleTo(w->window());
+}
+
+void WidgetState::restoreWhenShown(QWidget *widget) const
+{
+  if(!widget->property(RESTORE_PENDING_PROPERTY).toBool())
+  {
+    widget->setProperty(RESTORE_PENDING_PROPERTY, true);
+
+    // Copy reads values from settings when shown
+    WidgetState state(*this);
+    state.cache.clear();
+    state.cacheValid = false;
+    new DeferredRestore(state, widget);
+  }
+}
+
+bool WidgetState::containsKey(Settings& settings, const QString& key) const
+{
+  return cacheValid ? cache.contains(key) : settings.contains(key);
+}
+
+QVariant WidgetState::valueKey(Settings& settings, const QString& key, const QVariant& defaultValue) const
+{
+  if(cacheValid)
+    return cache.value(key, defaultValue);
+  else
+    return settings.valueVar(key, defaultValue);
 }
 
 void WidgetState::saveWidgetVisible(Settings& settings, const QWidget *w) const
@@ -477,7 +607,7 @@ bool WidgetState::containsWidget(Settings& settings, QObject *w, const QString&
 {
   QString name = objName.isEmpty() ? w->objectName() : objName;
   if(!name.isEmpty())
-    return settings.contains(keyPrefix + "_" + name);
+    return containsKey(settings, keyPrefix + "_" + name);
   else
     qWarning() << Q_FUNC_INFO << "Found widget with empty name";
   return false;
@@ -489,8 +619,8 @@ QVariant WidgetState::loadWidget(Settings& settings, QObject *w, const QString&
   if(!oname.isEmpty())
   {
     QString name = keyPrefix + "_" + oname;
-    if(settings.contains(name))
-      return settings.valueVar(name);
+    if(containsKey(settings, name))
+      return valueKey(settings, name);
   }
   else
     qWarning() << Q_FUNC_INFO << "Found widget with empty name";
@@ -504,9 +634,9 @@ void WidgetState::loadWidgetVisible(Settings& settings, QWidget *w) const
     if(!w->objectName().isEmpty())
     {
       QString name = keyPrefix + "_" + "_visible_" + w->objectName();
-      if(settings.contains(name))
+      if(containsKey(settings, name))
       {
-        bool visible = settings.valueBool(name);
+        bool visible = valueKey(settings, name).toBool();
         if(!visible)
           w->setVisible(visible);
       }
@@ -18,11 +18,12 @@
 #ifndef ATOOLS_WIDGETSTATESAVER_H
 #define ATOOLS_WIDGETSTATESAVER_H
 
+#include <QHash>
 #include <QString>
+#include <QVariant>
 
 class QObject;
 class QWidget;
-class QVariant;
 
 namespace atools {
 namespace settings {
@@ -56,6 +57,10 @@ namespace gui {
  * QAbstractButton
  * QFrame
  *
+ * restore() for a list of widgets reads all keys below the settings group of the prefix in one pass.
+ * If deferHidden is set, widgets which will not be visible when their window is shown, like pages of
+ * inactive tabs or widgets in closed dock windows, are restored when they are shown the first time.
+ * These are not saved until restored to keep their settings.
  */
 class WidgetState
 {
@@ -70,6 +75,8 @@ public:
               bool saveVisibility = true, bool blockSignals = false);
 
   void save(const QList<QObject *>& widgets) const;
+
+  /* Restore all widgets using values read in one pass. Restoring of hidden widgets is delayed if deferHidden is set. */
   void restore(const QList<QObject *>& widgets) const;
 
   void save(const QObject *widget) const;
@@ -81,7 +88,8 @@ public:
   /* Get prefix and widget name as stored in the file */
   QString getSettingsKey(QObject *widget) const;
 
-  /* Write settings to disk */
+  /* Write settings to disk. Calls within a short time from all instances are coalesced into one write.
+   * Pending writes are done by Settings::shutdown() at the latest. */
   void syncSettings();
 
   bool getSaveVisibility() const
@@ -104,6 +112,17 @@ public:
     block = value;
   }
 
+  bool getDeferHidden() const
+  {
+    return deferHidden;
+  }
+
+  /* Restore widgets which are not visible in their window when shown the first time */
+  void setDeferHidden(bool value)
+  {
+    deferHidden = value;
+  }
+
   /*
    * @param position if true save position of QMainWindow widgets
    * @param size if true save size of QMainWindow widgets
@@ -131,8 +150,27 @@ private:
   void saveWidgetVisible(atools::settings::Settings& settings, const QWidget *w) const;
   void loadWidgetVisible(atools::settings::Settings& settings, QWidget *w) const;
 
+  /* Read from cache if filled by restore() for a list or from settings otherwise */
+  bool containsKey(atools::settings::Settings& settings, const QString& key) const;
+  QVariant valueKey(atools::settings::Settings& settings, const QString& key,
+                    const QVariant& defaultValue = QVariant()) const;
+
+  /* Read all keys of the settings group of keyPrefix into the cache */
+  void fillCache() const;
+
+  /* Widget is not visible in its window and has to be restored when shown */
+  bool isHiddenInWindow(QObject *widget) const;
+
+  /* Install event filter restoring the widget when shown */
+  void restoreWhenShown(QWidget *widget) const;
+
   QString keyPrefix;
-  bool visibility = true, block = false;
+  bool visibility = true, block = false, deferHidden = false;
+
+  /* Settings values below keyPrefix by full key. Only valid while restoring a list of widgets. */
+  mutable QHash<QString, QVariant> cache;
+  mutable bool cacheValid = false;
+
   bool positionRestoreMainWindow = true, sizeRestoreMainWindow = true, stateRestoreMainWindow = true;
 };
 
@@ -0,0 +1,66 @@
+/**
+ *  @file
+ */
+
+#include "eventstreamcontroller.h"
+#include "httpeventchannel.h"
+
+using namespace stefanfrings;
+
+EventStreamController::EventStreamController(QHash<QString, QVariant> settings, HttpEventChannel *channel,
+                                             QObject *parent)
+  : HttpRequestHandler(parent)
+{
+  Q_ASSERT(channel != nullptr);
+  this->channel = channel;
+  maxSubscribers = settings.value("maxSubscribers", 20).toInt();
+  keepAliveInterval = settings.value("keepAliveInterval", 15000).toInt();
+}
+
+void EventStreamController::service(HttpRequest& request, HttpResponse& response)
+{
+  if(response.isBuffered())
+  {
+    qWarning("EventStreamController: event streams are not supported in event loop mode");
+    response.setStatus(501, "not implemented");
+    response.write("501 not implemented", true);
+    return;
+  }
+
+  if(!channel->subscribe(maxSubscribers))
+  {
+    qWarning("EventStreamController: too many event streams");
+    response.setStatus(503, "service unavailable");
+    response.write("503 too many event streams", true);
+    return;
+  }
+
+  qDebug("EventStreamController: start event stream for %s", qPrintable(request.getPeerAddress().toString()));
+  response.setHeader("Content-Type", "text/event-stream");
+  response.setHeader("Cache-Control", "no-cache");
+
+  // Start with the latest event. Last-Event-ID of reconnecting browsers is ignored since older events are dropped.
+  quint64 lastId = 0;
+
+  // Sends the headers
+  response.write(": stream\n\n");
+  response.flush();
+
+  QByteArray event;
+  while(response.isConnected() && !channel->isClosed())
+  {
+    if(channel->waitForEvent(lastId, event, static_cast<unsigned long>(keepAliveInterval)))
+    {
+      response.write(event);
+    }
+    else
+    {
+      // Keep alive comment which also detects lost connections
+      response.write(": keepalive\n\n");
+    }
+    response.flush();
+  }
+
+  channel->unsubscribe();
+  qDebug("EventStreamController: event stream closed");
+}
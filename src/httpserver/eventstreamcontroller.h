@@ -0,0 +1,69 @@
+/**
+ *  @file
+ */
+
+#ifndef EVENTSTREAMCONTROLLER_H
+#define EVENTSTREAMCONTROLLER_H
+
+#include "httpglobal.h"
+#include "httprequest.h"
+#include "httpresponse.h"
+#include "httprequesthandler.h"
+
+namespace stefanfrings {
+
+class HttpEventChannel;
+
+/**
+ *  Pushes the events of a HttpEventChannel to the web browser as Server-Sent Events (text/event-stream).
+ *  Browsers receive the events with the JavaScript EventSource API and reconnect automatically.
+ *  <p>
+ *  The following settings are optional:
+ *  <code><pre>
+ *  maxSubscribers=20
+ *  keepAliveInterval=15000
+ *  </pre></code>
+ *  Each stream occupies one connection handler thread while the client is connected. Therefore the number of
+ *  streams is limited by maxSubscribers which should be well below maxThreads of the listener.
+ *  A comment line is sent after keepAliveInterval milliseconds without events to detect lost clients.
+ *  <p>
+ *  Clients that cannot receive events as fast as they are published skip to the latest event. Writing
+ *  waits while the socket has more than the response buffer size pending which limits the memory per client.
+ *  <p>
+ *  Streams need the thread per connection mode. The event loop mode buffers responses and is rejected
+ *  with 501.
+ *  @see HttpEventChannel
+ */
+
+class DECLSPEC EventStreamController :
+  public HttpRequestHandler
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(EventStreamController)
+
+public:
+  /**
+   *  Constructor.
+   *  @param settings Configuration settings
+   *  @param channel Source of the events. Not owned and has to outlive this object.
+   *  @param parent Parent object
+   */
+  EventStreamController(QHash<QString, QVariant> settings, HttpEventChannel *channel, QObject *parent = nullptr);
+
+  /** Streams events until the client disconnects or the channel is closed */
+  void service(HttpRequest& request, HttpResponse& response);
+
+private:
+  HttpEventChannel *channel;
+
+  /** Maximum number of concurrent streams */
+  int maxSubscribers;
+
+  /** Time in milliseconds without events until a keep alive comment is sent */
+  int keepAliveInterval;
+
+};
+
+} // end of namespace
+
+#endif // EVENTSTREAMCONTROLLER_H
@@ -0,0 +1,504 @@
+/**
+ *  @file
+ */
+
+#include "httpbenchmark.h"
+#include "httplistener.h"
+#include "staticfilecontroller.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+
+using namespace stefanfrings;
+
+namespace {
+
+/** Timeout for connecting and for each read of a client */
+const int SOCKET_TIMEOUT_MS = 10000;
+
+/** Interval for sampling the number of server threads */
+const int THREAD_SAMPLE_MS = 50;
+
+/**
+ *  Passes all paths below "/static/" to the static file controller and answers all others with a generated
+ *  JSON document of about 2 kB.
+ */
+class BenchmarkRequestHandler :
+  public HttpRequestHandler
+{
+public:
+  BenchmarkRequestHandler(StaticFileController *controller)
+    : staticFileController(controller)
+  {
+  }
+
+  void service(HttpRequest& request, HttpResponse& response) override
+  {
+    QByteArray path = request.getPath();
+    if(path.startsWith("/static/"))
+    {
+      staticFileController->service(request, response);
+    }
+    else
+    {
+      QJsonArray arr;
+      for(int i = 0; i < 50; i++)
+      {
+        QJsonObject obj;
+        obj.insert("id", i);
+        obj.insert("path", QString::fromLatin1(path));
+        obj.insert("value", static_cast<double>(qHash(path) % 1000) / (i + 1));
+        arr.append(obj);
+      }
+      response.setHeader("Content-Type", "application/json");
+      response.write(QJsonDocument(arr).toJson(QJsonDocument::Compact), true);
+    }
+  }
+
+private:
+  StaticFileController *staticFileController;
+};
+
+/**
+ *  Sends requests over one keep-alive connection and waits for each response before sending the next one.
+ *  Understands responses with Content-Length and chunked transfer encoding.
+ */
+class BenchmarkClient :
+  public QThread
+{
+public:
+  BenchmarkClient(quint16 portParam, const QVector<QByteArray>& pathsParam, int offsetParam, int numRequestsParam)
+    : port(portParam), paths(pathsParam), offset(offsetParam), numRequests(numRequestsParam)
+  {
+  }
+
+  /** Latency of each successful request in microseconds */
+  QVector<quint64> latencies;
+  quint64 staticRequests = 0, dynamicRequests = 0, errors = 0, bytes = 0;
+
+protected:
+  void run() override
+  {
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, port);
+    if(!socket.waitForConnected(SOCKET_TIMEOUT_MS))
+    {
+      qWarning("HttpBenchmark: cannot connect: %s", qPrintable(socket.errorString()));
+      errors++;
+      return;
+    }
+
+    latencies.reserve(numRequests);
+    QElapsedTimer timer;
+    for(int i = 0; i < numRequests; i++)
+    {
+      const QByteArray& path = paths.at((offset + i) % paths.size());
+      timer.start();
+      socket.write("GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n");
+
+      int status = 0;
+      if(!readResponse(socket, status))
+      {
+        qWarning("HttpBenchmark: error reading response for %s: %s", path.constData(),
+                 qPrintable(socket.errorString()));
+        errors++;
+
+        // Connection is not usable anymore
+        break;
+      }
+
+      if(status != 200)
+      {
+        errors++;
+      }
+      else
+      {
+        latencies.append(static_cast<quint64>(timer.nsecsElapsed() / 1000));
+        if(path.startsWith("/static/"))
+        {
+          staticRequests++;
+        }
+        else
+        {
+          dynamicRequests++;
+        }
+      }
+    }
+    socket.disconnectFromHost();
+  }
+
+private:
+  /** Wait until the buffer contains at least size bytes */
+  bool fill(QTcpSocket& socket, int size)
+  {
+    while(buffer.size() < size)
+    {
+      if(socket.bytesAvailable() == 0 && !socket.waitForReadyRead(SOCKET_TIMEOUT_MS))
+      {
+        return false;
+      }
+      buffer.append(socket.readAll());
+    }
+    return true;
+  }
+
+  /** Wait until the buffer contains the separator and return its index */
+  int fillUntil(QTcpSocket& socket, const char *separator, int from = 0)
+  {
+    int index;
+    while((index = buffer.indexOf(separator, from)) == -1)
+    {
+      if(!fill(socket, buffer.size() + 1))
+      {
+        return -1;
+      }
+    }
+    return index;
+  }
+
+  /** Read one complete response, remove it from the buffer and return the status code */
+  bool readResponse(QTcpSocket& socket, int& status)
+  {
+    int headerEnd = fillUntil(socket, "\r\n\r\n");
+    if(headerEnd == -1)
+    {
+      return false;
+    }
+
+    QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    QList<QByteArray> statusLine = lines.first().split(' ');
+    status = statusLine.size() > 1 ? statusLine.at(1).toInt() : 0;
+
+    int contentLength = 0;
+    bool chunked = false;
+    for(const QByteArray& line : lines)
+    {
+      QByteArray lower = line.trimmed().toLower();
+      if(lower.startsWith("content-length:"))
+      {
+        contentLength = lower.mid(15).trimmed().toInt();
+      }
+      else if(lower.startsWith("transfer-encoding:") && lower.contains("chunked"))
+      {
+        chunked = true;
+      }
+    }
+
+    int pos = headerEnd + 4;
+    if(chunked)
+    {
+      while(true)
+      {
+        int lineEnd = fillUntil(socket, "\r\n", pos);
+        if(lineEnd == -1)
+        {
+          return false;
+        }
+        int chunkSize = buffer.mid(pos, lineEnd - pos).trimmed().toInt(nullptr, 16);
+        pos = lineEnd + 2;
+
+        // Chunk data and the line feed after it. The last chunk is empty and followed by an empty line.
+        if(!fill(socket, pos + chunkSize + 2))
+        {
+          return false;
+        }
+        pos += chunkSize + 2;
+        if(chunkSize == 0)
+        {
+          break;
+        }
+      }
+    }
+    else
+    {
+      if(!fill(socket, pos + contentLength))
+      {
+        return false;
+      }
+      pos += contentLength;
+    }
+
+    bytes += static_cast<quint64>(pos);
+    buffer.remove(0, pos);
+    return true;
+  }
+
+  quint16 port;
+  QVector<QByteArray> paths;
+  int offset, numRequests;
+
+  /** Received data not yet consumed */
+  QByteArray buffer;
+};
+
+/** Deterministic file content. Text files are repeated lines and binary files a xorshift sequence. */
+QByteArray createContent(int size, bool binary)
+{
+  QByteArray data;
+  data.reserve(size);
+  if(binary)
+  {
+    quint32 state = 0x9e3779b9;
+    while(data.size() < size)
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      data.append(static_cast<char>(state & 0xff));
+    }
+  }
+  else
+  {
+    for(int i = 0; data.size() < size; i++)
+    {
+      data.append("<p>Line " + QByteArray::number(i) + " of the HTTP server benchmark document.</p>\n");
+    }
+  }
+  data.truncate(size);
+  return data;
+}
+
+quint64 percentile(const QVector<quint64>& sorted, double percent)
+{
+  if(sorted.isEmpty())
+  {
+    return 0;
+  }
+  int index = static_cast<int>(static_cast<double>(sorted.size()) * percent / 100.);
+  return sorted.at(std::min(index, sorted.size() - 1));
+}
+
+} // end of anonymous namespace
+
+HttpBenchmark::HttpBenchmark(const QString& directory)
+  : dir(directory)
+{
+  docroot = QDir(dir).filePath("docroot");
+
+  // Fixed order of static and dynamic requests. Do not change to keep results comparable.
+  paths = {"/static/index.html", "/api/status", "/static/style.css", "/api/items?page=1",
+           "/static/data.json", "/api/items?page=2", "/static/large.bin", "/api/status"};
+}
+
+bool HttpBenchmark::generate()
+{
+  QDir staticDir(QDir(docroot).filePath("static"));
+  if(!staticDir.mkpath("."))
+  {
+    qWarning("HttpBenchmark: cannot create %s", qPrintable(staticDir.path()));
+    return false;
+  }
+
+  // Large file exceeds maxCachedFileSize and is memory mapped
+  struct File
+  {
+    const char *name;
+    int size;
+    bool binary;
+  };
+  const File files[] = {
+    {"index.html", 4096, false},
+    {"style.css", 16384, false},
+    {"data.json", 32768, false},
+    {"large.bin", 262144, true}
+  };
+
+  for(const File& f : files)
+  {
+    QFile file(staticDir.filePath(f.name));
+    if(!file.open(QIODevice::WriteOnly) || file.write(createContent(f.size, f.binary)) != f.size)
+    {
+      qWarning("HttpBenchmark: cannot write %s: %s", qPrintable(file.fileName()), qPrintable(file.errorString()));
+      return false;
+    }
+    file.close();
+  }
+  generated = true;
+  return true;
+}
+
+void HttpBenchmark::run()
+{
+  results.clear();
+  if(!generated && !generate())
+  {
+    return;
+  }
+
+  QHash<QString, QVariant> settings;
+  settings.insert("port", 0);
+  settings.insert("readTimeout", 60000);
+  settings.insert("maxRequestSize", 16000);
+
+  // One handler thread for each client
+  QHash<QString, QVariant> poolSettings(settings);
+  poolSettings.insert("minThreads", numClients);
+  poolSettings.insert("maxThreads", numClients + 4);
+  poolSettings.insert("cleanupInterval", 1000);
+  results.append(runMode("thread_pool", poolSettings));
+
+  QHash<QString, QVariant> loopSettings(settings);
+  loopSettings.insert("ioThreads", ioThreads);
+  loopSettings.insert("workerThreads", workerThreads);
+  loopSettings.insert("maxConnections", numClients * 2);
+  results.append(runMode("event_loop", loopSettings));
+
+  for(const HttpBenchmarkResult& result : results)
+  {
+    qDebug("HttpBenchmark: %s %.0f req/s p50 %llu us p99 %llu us errors %llu threads %d peak %d",
+           qPrintable(result.mode), result.requestsPerSecond, result.p50Us, result.p99Us, result.errors,
+           result.threads, result.peakThreads);
+  }
+}
+
+HttpBenchmarkResult HttpBenchmark::runMode(const QString& mode, QHash<QString, QVariant> settings)
+{
+  HttpBenchmarkResult result;
+  result.mode = mode;
+  result.clients = numClients;
+
+  QHash<QString, QVariant> fileSettings;
+  fileSettings.insert("path", docroot);
+  fileSettings.insert("cacheTime", 60000);
+  fileSettings.insert("cacheSize", 1000000);
+  fileSettings.insert("maxCachedFileSize", 65536);
+
+  StaticFileController staticFileController(fileSettings);
+  BenchmarkRequestHandler handler(&staticFileController);
+  HttpStatisticsHandler statistics(&handler);
+
+  HttpListener listener(settings, &statistics);
+  if(!listener.isListening())
+  {
+    result.errors = static_cast<quint64>(numClients);
+    return result;
+  }
+
+  QVector<BenchmarkClient *> clients;
+  for(int i = 0; i < numClients; i++)
+  {
+    clients.append(new BenchmarkClient(listener.serverPort(), paths, i, requestsPerClient));
+  }
+
+  // Run the event loop of the listener until all clients are done
+  QEventLoop loop;
+  int running = clients.size();
+  for(BenchmarkClient *client : clients)
+  {
+    QObject::connect(client, &QThread::finished, &loop, [&running, &loop]() {
+      if(--running == 0)
+      {
+        loop.quit();
+      }
+    });
+  }
+
+  QTimer sampleTimer;
+  QObject::connect(&sampleTimer, &QTimer::timeout, &loop, [&result, &listener]() {
+    result.peakThreads = std::max(result.peakThreads, listener.getNumThreads());
+  });
+  sampleTimer.start(THREAD_SAMPLE_MS);
+
+  QElapsedTimer timer;
+  timer.start();
+  statistics.reset();
+  for(BenchmarkClient *client : clients)
+  {
+    client->start();
+  }
+  loop.exec();
+  result.timeMs = timer.elapsed();
+  sampleTimer.stop();
+
+  result.threads = listener.getNumThreads();
+  result.peakThreads = std::max(result.peakThreads, result.threads);
+  result.server = statistics.getStatistics();
+
+  QVector<quint64> latencies;
+  for(BenchmarkClient *client : clients)
+  {
+    client->wait();
+    latencies.append(client->latencies);
+    result.staticRequests += client->staticRequests;
+    result.dynamicRequests += client->dynamicRequests;
+    result.errors += client->errors;
+    result.bytes += client->bytes;
+    delete client;
+  }
+
+  // Stop server before handlers are destroyed
+  listener.close();
+
+  std::sort(latencies.begin(), latencies.end());
+  result.requests = static_cast<quint64>(latencies.size());
+  result.requestsPerSecond = result.timeMs > 0 ? static_cast<double>(result.requests) * 1000. / result.timeMs : 0.;
+  result.p50Us = percentile(latencies, 50.);
+  result.p99Us = percentile(latencies, 99.);
+  result.maxUs = latencies.isEmpty() ? 0 : latencies.last();
+  return result;
+}
+
+QJsonDocument HttpBenchmark::toJson() const
+{
+  QJsonArray resultArr;
+  for(const HttpBenchmarkResult& result : results)
+  {
+    QJsonObject server;
+    server.insert("requests", static_cast<double>(result.server.requests));
+    server.insert("requests_per_second", result.server.requestsPerSecond);
+    server.insert("p50_us", static_cast<double>(result.server.p50Us));
+    server.insert("p99_us", static_cast<double>(result.server.p99Us));
+    server.insert("max_us", static_cast<double>(result.server.maxUs));
+    server.insert("peak_active_requests", result.server.peakActiveRequests);
+
+    QJsonObject obj;
+    obj.insert("mode", result.mode);
+    obj.insert("clients", result.clients);
+    obj.insert("requests", static_cast<double>(result.requests));
+    obj.insert("static_requests", static_cast<double>(result.staticRequests));
+    obj.insert("dynamic_requests", static_cast<double>(result.dynamicRequests));
+    obj.insert("errors", static_cast<double>(result.errors));
+    obj.insert("bytes", static_cast<double>(result.bytes));
+    obj.insert("time_ms", static_cast<double>(result.timeMs));
+    obj.insert("requests_per_second", result.requestsPerSecond);
+    obj.insert("p50_us", static_cast<double>(result.p50Us));
+    obj.insert("p99_us", static_cast<double>(result.p99Us));
+    obj.insert("max_us", static_cast<double>(result.maxUs));
+    obj.insert("threads", result.threads);
+    obj.insert("peak_threads", result.peakThreads);
+    obj.insert("server", server);
+    resultArr.append(obj);
+  }
+
+  QJsonObject root;
+  root.insert("clients", numClients);
+  root.insert("requests_per_client", requestsPerClient);
+  root.insert("io_threads", ioThreads);
+  root.insert("worker_threads", workerThreads);
+  root.insert("results", resultArr);
+  return QJsonDocument(root);
+}
+
+bool HttpBenchmark::writeJson(const QString& filename) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(toJson().toJson(QJsonDocument::Indented));
+    file.close();
+    return true;
+  }
+  else
+  {
+    qWarning("HttpBenchmark: cannot write %s: %s", qPrintable(filename), qPrintable(file.errorString()));
+  }
+  return false;
+}
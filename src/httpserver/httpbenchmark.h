@@ -0,0 +1,118 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPBENCHMARK_H
+#define HTTPBENCHMARK_H
+
+#include <QJsonDocument>
+#include <QString>
+#include <QVector>
+#include "httpglobal.h"
+#include "httpstatisticshandler.h"
+
+namespace stefanfrings {
+
+/**
+ *  Result of one benchmark run for a server mode.
+ *  Client latencies are measured from sending the request to receiving the last byte of the response
+ *  including the network stack. Server latencies are the time spent in the request handler.
+ */
+
+struct DECLSPEC HttpBenchmarkResult
+{
+  /** "thread_pool" or "event_loop" */
+  QString mode;
+  int clients = 0;
+  quint64 requests = 0, staticRequests = 0, dynamicRequests = 0, errors = 0, bytes = 0;
+  qint64 timeMs = 0;
+  double requestsPerSecond = 0.;
+  quint64 p50Us = 0, p99Us = 0, maxUs = 0;
+
+  /** Threads serving connections at the end and the highest number seen while running */
+  int threads = 0, peakThreads = 0;
+
+  /** Statistics collected in the server */
+  HttpStatistics server;
+};
+
+/**
+ *  Reproducible load test for the HTTP server which does not need a web application or external tools.
+ *  <p>
+ *  Starts a HttpListener in-process once in thread pool mode (HttpConnectionHandlerPool) and once in event
+ *  loop mode (HttpEventLoopPool). Both use the same synthetic request handler which passes paths below
+ *  "/static/" to a StaticFileController and answers all others with a generated JSON document.
+ *  The static file root is created in the given directory and contains small cached files and one file
+ *  which is too large for the cache.
+ *  <p>
+ *  A number of client threads connect with QTcpSocket and send requests over one keep-alive connection
+ *  each. Static and dynamic requests alternate in a fixed order so runs are comparable.
+ *  <p>
+ *  run() needs a QCoreApplication and has to be called from a thread without a running event loop
+ *  since it runs its own while the clients are active. Results can be saved as JSON.
+ */
+
+class DECLSPEC HttpBenchmark
+{
+  Q_DISABLE_COPY(HttpBenchmark)
+
+public:
+  /** Static file root is created in directory */
+  explicit HttpBenchmark(const QString& directory);
+
+  /** Write the static files. Returns false on error. */
+  bool generate();
+
+  /** Run all server modes once. Calls generate() if not done before. Can be repeated. */
+  void run();
+
+  const QVector<HttpBenchmarkResult>& getResults() const
+  {
+    return results;
+  }
+
+  /** Machine readable report including configuration and all results */
+  QJsonDocument toJson() const;
+
+  /** Write JSON report to file. Returns false on error. */
+  bool writeJson(const QString& filename) const;
+
+  /** Number of concurrent keep-alive clients. Default is 16. */
+  void setNumClients(int value)
+  {
+    numClients = value;
+  }
+
+  /** Number of requests sent by each client. Default is 2000. */
+  void setRequestsPerClient(int value)
+  {
+    requestsPerClient = value;
+  }
+
+  /** Event loop threads in event loop mode. Default is 2. */
+  void setIoThreads(int value)
+  {
+    ioThreads = value;
+  }
+
+  /** Worker threads in event loop mode. 0 runs the handler in the event loops. Default is 4. */
+  void setWorkerThreads(int value)
+  {
+    workerThreads = value;
+  }
+
+private:
+  /** Start a listener with the given settings and run all clients against it */
+  HttpBenchmarkResult runMode(const QString& mode, QHash<QString, QVariant> settings);
+
+  QString dir, docroot;
+  QVector<QByteArray> paths;
+  int numClients = 16, requestsPerClient = 2000, ioThreads = 2, workerThreads = 4;
+  bool generated = false;
+
+  QVector<HttpBenchmarkResult> results;
+};
+
+} // end of namespace
+
+#endif // HTTPBENCHMARK_H
@@ -0,0 +1,165 @@
+/**
+ *  @file
+ */
+
+#include "httpcompressor.h"
+#include <QSharedPointer>
+#include <zlib.h>
+
+using namespace stefanfrings;
+
+namespace {
+
+/** Reused compressors of this thread, one for each encoding */
+thread_local QSharedPointer<HttpCompressor> threadGzip, threadDeflate;
+
+} // namespace
+
+HttpCompressor::HttpCompressor(Encoding encoding)
+{
+  this->encoding = encoding;
+  leased = false;
+  threadOwned = false;
+  stream = new z_stream;
+  stream->zalloc = Z_NULL;
+  stream->zfree = Z_NULL;
+  stream->opaque = Z_NULL;
+  stream->avail_in = 0;
+  stream->next_in = Z_NULL;
+
+  // Window bits with 16 added write a gzip header and trailer instead of the zlib format
+  valid = deflateInit2(stream, LEVEL, Z_DEFLATED, encoding == gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+  if(!valid)
+  {
+    qWarning("HttpCompressor: cannot initialize zlib stream");
+  }
+}
+
+HttpCompressor::~HttpCompressor()
+{
+  if(valid)
+  {
+    deflateEnd(stream);
+  }
+  delete stream;
+}
+
+HttpCompressor::Encoding HttpCompressor::selectEncoding(const QByteArray& acceptEncoding)
+{
+  bool acceptGzip = false, acceptDeflate = false;
+  foreach(QByteArray coding, acceptEncoding.split(','))
+  {
+    // Split "gzip;q=0.5" into name and weight
+    QByteArray name = coding;
+    int semicolon = coding.indexOf(';');
+    if(semicolon >= 0)
+    {
+      name = coding.left(semicolon);
+      QByteArray param = coding.mid(semicolon + 1).trimmed();
+      if(param.startsWith("q=") && param.mid(2).toDouble() <= 0.)
+      {
+        continue;
+      }
+    }
+    name = name.trimmed().toLower();
+
+    if(name == "gzip" || name == "x-gzip" || name == "*")
+    {
+      acceptGzip = true;
+    }
+    else if(name == "deflate")
+    {
+      acceptDeflate = true;
+    }
+  }
+  return acceptGzip ? gzip : (acceptDeflate ? deflate : identity);
+}
+
+QByteArray HttpCompressor::encodingName(Encoding encoding)
+{
+  return encoding == gzip ? "gzip" : (encoding == deflate ? "deflate" : "identity");
+}
+
+HttpCompressor *HttpCompressor::acquire(Encoding encoding)
+{
+  if(encoding == identity)
+  {
+    return nullptr;
+  }
+
+  QSharedPointer<HttpCompressor>& threadCompressor = encoding == gzip ? threadGzip : threadDeflate;
+  if(threadCompressor.isNull())
+  {
+    threadCompressor.reset(new HttpCompressor(encoding));
+    threadCompressor->threadOwned = true;
+  }
+
+  HttpCompressor *compressor = threadCompressor.data();
+  if(compressor->leased)
+  {
+    // Another response in this thread is compressing - use a temporary one
+    compressor = new HttpCompressor(encoding);
+  }
+  else if(!compressor->reset())
+  {
+    return nullptr;
+  }
+
+  if(!compressor->valid)
+  {
+    release(compressor);
+    return nullptr;
+  }
+  compressor->leased = true;
+  return compressor;
+}
+
+void HttpCompressor::release(HttpCompressor *compressor)
+{
+  if(compressor != nullptr)
+  {
+    compressor->leased = false;
+    if(!compressor->threadOwned)
+    {
+      delete compressor;
+    }
+  }
+}
+
+bool HttpCompressor::reset()
+{
+  return valid && deflateReset(stream) == Z_OK;
+}
+
+QByteArray HttpCompressor::compress(const char *data, int size, Flush flush)
+{
+  QByteArray output;
+  if(!valid)
+  {
+    return output;
+  }
+
+  stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  stream->avail_in = static_cast<uInt>(size);
+  int mode = flush == finish ? Z_FINISH : (flush == syncFlush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+
+  // Text usually compresses to less than a third
+  int chunkSize = qMax(1024, size / 3);
+  do
+  {
+    int offset = output.size();
+    output.resize(offset + chunkSize);
+    stream->next_out = reinterpret_cast<Bytef *>(output.data() + offset);
+    stream->avail_out = static_cast<uInt>(chunkSize);
+
+    if(deflate(stream, mode) == Z_STREAM_ERROR)
+    {
+      qWarning("HttpCompressor: zlib stream error");
+      valid = false;
+      return QByteArray();
+    }
+    output.resize(offset + chunkSize - static_cast<int>(stream->avail_out));
+  } while(stream->avail_out == 0);
+
+  return output;
+}
@@ -0,0 +1,92 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPCOMPRESSOR_H
+#define HTTPCOMPRESSOR_H
+
+#include <QByteArray>
+#include "httpglobal.h"
+
+struct z_stream_s;
+
+namespace stefanfrings {
+
+/**
+ *  Incremental gzip or deflate compression of dynamic response bodies.
+ *  <p>
+ *  Setting up a zlib stream allocates several hundred kilobytes. Therefore each thread keeps one
+ *  compressor per encoding which is reset and reused for the next response.
+ *  @see HttpResponse::setCompression()
+ */
+
+class DECLSPEC HttpCompressor
+{
+  Q_DISABLE_COPY(HttpCompressor)
+
+public:
+  /** Content codings in the order of preference */
+  enum Encoding
+  {
+    identity, gzip, deflate
+  };
+
+  /** Flush modes for compress() */
+  enum Flush
+  {
+    noFlush, syncFlush, finish
+  };
+
+  /**
+   *  Select the encoding from the value of an Accept-Encoding request header.
+   *  Codings with a weight of zero are excluded. gzip is preferred if several are accepted.
+   */
+  static Encoding selectEncoding(const QByteArray& acceptEncoding);
+
+  /** Name for the Content-Encoding header */
+  static QByteArray encodingName(Encoding encoding);
+
+  /**
+   *  Get the compressor of the calling thread reset for a new response.
+   *  Creates a new compressor if the one of this thread is in use. The caller has to release() it.
+   */
+  static HttpCompressor *acquire(Encoding encoding);
+
+  /** Return a compressor to its thread or delete it if it was not the thread's one */
+  static void release(HttpCompressor *compressor);
+
+  /**
+   *  Compress data and return the compressed output produced so far.
+   *  syncFlush forces all data out which is needed before sending a chunk of a streaming response.
+   *  finish writes the trailer. The compressor must be reset before using it again after finish.
+   */
+  QByteArray compress(const char *data, int size, Flush flush);
+
+  QByteArray compress(const QByteArray& data, Flush flush)
+  {
+    return compress(data.constData(), data.size(), flush);
+  }
+
+  /** Compression level for new streams */
+  static const int LEVEL = 6;
+
+  ~HttpCompressor();
+
+private:
+  explicit HttpCompressor(Encoding encoding);
+
+  /** Prepare the stream for a new response */
+  bool reset();
+
+  z_stream_s *stream;
+  Encoding encoding;
+  bool valid;
+
+  /** Owned by a thread and currently used by a response */
+  bool leased;
+  bool threadOwned;
+};
+
+} // end of namespace
+
+#endif // HTTPCOMPRESSOR_H
@@ -0,0 +1,353 @@
+/**
+ *  @file
+ */
+
+#include "httpconnection.h"
+#include "httpresponse.h"
+#include "util/trace.h"
+#include <QBuffer>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#ifndef QT_NO_OPENSSL
+  #include <QSslSocket>
+#endif
+
+using namespace stefanfrings;
+
+namespace {
+
+/**
+ *  Calls the request handler for one request in a thread of the worker pool and passes the buffered
+ *  response back to the connection through the event queue.
+ *  The connection is not deleted while a request is in service.
+ */
+class ServiceRunnable :
+  public QRunnable
+{
+public:
+  ServiceRunnable(HttpRequestHandler *requestHandler, HttpRequest *request, QObject *connection, int bufferSize,
+                  int compressionMinSize)
+  {
+    this->requestHandler = requestHandler;
+    this->bufferSize = bufferSize;
+    this->compressionMinSize = compressionMinSize;
+    this->request = request;
+    this->connection = connection;
+    setAutoDelete(true);
+  }
+
+  virtual ~ServiceRunnable()
+  {
+    delete request;
+  }
+
+  virtual void run()
+  {
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    HttpResponse response(&buffer, bufferSize);
+    response.setCompression(request->getHeader("Accept-Encoding"), compressionMinSize);
+    bool closeConnection = HttpConnection::serviceRequest(requestHandler, *request, response);
+
+    QMetaObject::invokeMethod(connection, "serviceFinished", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, buffer.data()), Q_ARG(bool, closeConnection));
+  }
+
+private:
+  HttpRequestHandler *requestHandler;
+  HttpRequest *request;
+  QObject *connection;
+  int bufferSize, compressionMinSize;
+};
+
+} // namespace
+
+HttpConnection::HttpConnection(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler,
+                               QThreadPool *workerPool, const QSslConfiguration *sslConfiguration, QObject *parent)
+  : QObject(parent)
+{
+  Q_ASSERT(requestHandler != nullptr);
+  this->settings = settings;
+  this->requestHandler = requestHandler;
+  this->workerPool = workerPool;
+  this->sslConfiguration = sslConfiguration;
+  currentRequest = nullptr;
+  busy = false;
+  disconnectedWhileBusy = false;
+  handshakeOnly = false;
+  readTimer.setSingleShot(true);
+
+  createSocket();
+  connect(socket, SIGNAL(readyRead()), SLOT(read()));
+  connect(socket, SIGNAL(disconnected()), SLOT(disconnected()));
+  connect(&readTimer, SIGNAL(timeout()), SLOT(readTimeout()));
+
+#ifdef SUPERVERBOSE
+  qDebug("HttpConnection (%p): constructed", static_cast<void *>(this));
+#endif
+}
+
+HttpConnection::~HttpConnection()
+{
+  readTimer.stop();
+  // Do not receive the disconnected signal while being destroyed
+  socket->disconnect(this);
+  socket->abort();
+  delete socket;
+  delete currentRequest;
+#ifdef SUPERVERBOSE
+  qDebug("HttpConnection (%p): destroyed", static_cast<void *>(this));
+#endif
+}
+
+void HttpConnection::createSocket()
+{
+  // If SSL is supported and configured, then create an instance of QSslSocket
+#ifndef QT_NO_OPENSSL
+  if(sslConfiguration)
+  {
+    QSslSocket *sslSocket = new QSslSocket();
+    sslSocket->setSslConfiguration(*sslConfiguration);
+    socket = sslSocket;
+    return;
+  }
+#endif
+  // else create an instance of QTcpSocket
+  socket = new QTcpSocket();
+}
+
+bool HttpConnection::open(tSocketDescriptor socketDescriptor)
+{
+  if(!socket->setSocketDescriptor(socketDescriptor))
+  {
+    qCritical("HttpConnection (%p): cannot initialize socket: %s",
+              static_cast<void *>(this), qPrintable(socket->errorString()));
+    return false;
+  }
+
+#ifndef QT_NO_OPENSSL
+  // Switch on encryption, if SSL is configured
+  if(sslConfiguration)
+  {
+    connect(socket, SIGNAL(encrypted()), SIGNAL(encrypted()));
+    (static_cast<QSslSocket *>(socket))->startServerEncryption();
+  }
+#endif
+
+  // Start timer for read timeout
+  readTimer.start(settings.value("readTimeout", 10000).toInt());
+  return true;
+}
+
+void HttpConnection::readTimeout()
+{
+  qDebug("HttpConnection (%p): read timeout occured", static_cast<void *>(this));
+  socket->disconnectFromHost();
+  delete currentRequest;
+  currentRequest = nullptr;
+}
+
+void HttpConnection::disconnected()
+{
+#ifdef SUPERVERBOSE
+  qDebug("HttpConnection (%p): disconnected", static_cast<void *>(this));
+#endif
+  readTimer.stop();
+  if(busy)
+  {
+    // Worker pool still references this connection - wait for serviceFinished()
+    disconnectedWhileBusy = true;
+  }
+  else
+  {
+    emit closed();
+  }
+}
+
+void HttpConnection::read()
+{
+  // The loop adds support for HTTP pipelinig. Remaining data is read after the response was sent.
+  // Stop reading once the connection is closing.
+  while(!busy && !handshakeOnly && socket->state() == QAbstractSocket::ConnectedState && socket->bytesAvailable())
+  {
+    // Create new HttpRequest object if necessary
+    if(!currentRequest)
+    {
+      currentRequest = new HttpRequest(settings, requestHandler);
+    }
+
+    // Collect data for the request object
+    while(socket->bytesAvailable() && currentRequest->getStatus() != HttpRequest::complete &&
+          currentRequest->getStatus() != HttpRequest::abort)
+    {
+      currentRequest->readFromSocket(socket);
+      if(currentRequest->getStatus() == HttpRequest::waitForBody)
+      {
+        // Restart timer for read timeout, otherwise it would
+        // expire during large file uploads.
+        readTimer.start(settings.value("readTimeout", 10000).toInt());
+      }
+    }
+
+    // If the request is aborted, return error message and close the connection
+    if(currentRequest->getStatus() == HttpRequest::abort)
+    {
+      socket->write("HTTP/1.1 413 entity too large\r\nConnection: close\r\n\r\n413 Entity too large\r\n");
+      socket->disconnectFromHost();
+      delete currentRequest;
+      currentRequest = nullptr;
+      return;
+    }
+
+    // If the request is complete, let the request mapper dispatch it
+    if(currentRequest->getStatus() == HttpRequest::complete)
+    {
+      readTimer.stop();
+
+      if(workerPool)
+      {
+        // The runnable takes the request and passes the response back through serviceFinished()
+        busy = true;
+        workerPool->start(new ServiceRunnable(requestHandler, currentRequest, this, responseBufferSize(),
+                                              compressionMinSize()));
+        currentRequest = nullptr;
+      }
+      else
+      {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        HttpResponse response(&buffer, responseBufferSize());
+        response.setCompression(currentRequest->getHeader("Accept-Encoding"), compressionMinSize());
+        bool closeConnection = serviceRequest(requestHandler, *currentRequest, response);
+        delete currentRequest;
+        currentRequest = nullptr;
+        sendResponse(buffer.data(), closeConnection);
+      }
+    }
+  }
+}
+
+void HttpConnection::moveToLoop(QObject *loop)
+{
+  // Socket and timer are no children and have to be moved separately. An active timer is restarted in the new thread.
+  setParent(nullptr);
+  QThread *thread = loop->thread();
+  readTimer.moveToThread(thread);
+  socket->moveToThread(thread);
+  moveToThread(thread);
+
+  // Posted to this object and therefore discarded if the connection is deleted before
+  QMetaObject::invokeMethod(this, "attach", Qt::QueuedConnection, Q_ARG(QObject *, loop));
+}
+
+void HttpConnection::attach(QObject *loop)
+{
+  setParent(loop);
+  handshakeOnly = false;
+
+  // Data which arrived during the move was not read yet
+  read();
+}
+
+int HttpConnection::responseBufferSize() const
+{
+  return settings.value("responseBufferSize", HttpResponse::DEFAULT_BUFFER_SIZE).toInt();
+}
+
+int HttpConnection::compressionMinSize() const
+{
+  return settings.value("compressionMinSize", HttpResponse::DEFAULT_COMPRESSION_MIN_SIZE).toInt();
+}
+
+void HttpConnection::serviceFinished(QByteArray output, bool closeConnection)
+{
+  busy = false;
+  if(disconnectedWhileBusy)
+  {
+    emit closed();
+    return;
+  }
+
+  sendResponse(output, closeConnection);
+
+  // Continue with pipelined requests that arrived in the meantime
+  read();
+}
+
+void HttpConnection::sendResponse(const QByteArray& output, bool closeConnection)
+{
+  if(!socket->isOpen())
+  {
+    return;
+  }
+
+  // The socket buffers the data and sends it when the event loop is idle
+  socket->write(output);
+
+  // Close the connection or prepare for the next request on the same connection.
+  if(closeConnection)
+  {
+    // Closes the connection after all pending data was written
+    socket->disconnectFromHost();
+  }
+  else
+  {
+    // Start timer for next request
+    readTimer.start(settings.value("readTimeout", 10000).toInt());
+  }
+}
+
+bool HttpConnection::serviceRequest(HttpRequestHandler *requestHandler, HttpRequest& request,
+                                    HttpResponse& response)
+{
+  // Copy the Connection:close header to the response
+  bool closeConnection = QString::compare(request.getHeader("Connection"), "close", Qt::CaseInsensitive) == 0;
+  if(closeConnection)
+  {
+    response.setHeader("Connection", "close");
+  }
+  // In case of HTTP 1.0 protocol add the Connection:close header.
+  // This ensures that the HttpResponse does not activate chunked mode, which is not spported by HTTP 1.0.
+  else if(QString::compare(request.getVersion(), "HTTP/1.0", Qt::CaseInsensitive) == 0)
+  {
+    closeConnection = true;
+    response.setHeader("Connection", "close");
+  }
+
+  // Call the request mapper
+  try
+  {
+    ATOOLS_TRACE_SCOPE("HttpRequestHandler::service", "http");
+    requestHandler->service(request, response);
+  }
+  catch(...)
+  {
+    qCritical("HttpConnection: An uncatched exception occured in the request handler");
+  }
+
+  // Finalize sending the response if not already done
+  if(!response.hasSentLastPart())
+  {
+    response.write(QByteArray(), true);
+  }
+
+  // Find out whether the connection must be closed
+  if(!closeConnection)
+  {
+    // Maybe the request handler or mapper added a Connection:close header in the meantime
+    if(QString::compare(response.getHeaders().value("Connection"), "close", Qt::CaseInsensitive) == 0)
+    {
+      closeConnection = true;
+    }
+    // If we have no Content-Length header and did not use chunked mode, then we have to close the
+    // connection to tell the HTTP client that the end of the response has been reached.
+    else if(!response.getHeaders().contains("Content-Length") &&
+            QString::compare(response.getHeaders().value("Transfer-Encoding"), "chunked",
+                             Qt::CaseInsensitive) != 0)
+    {
+      closeConnection = true;
+    }
+  }
+  return closeConnection;
+}
@@ -0,0 +1,164 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPCONNECTION_H
+#define HTTPCONNECTION_H
+
+#include <QTcpSocket>
+#include <QTimer>
+#include "httpglobal.h"
+#include "httpconnectionhandler.h"
+#include "httprequest.h"
+#include "httprequesthandler.h"
+
+class QThreadPool;
+
+namespace stefanfrings {
+
+class HttpResponse;
+
+/**
+ *  A single client connection used by the event loop mode of the server.
+ *  Other than the HttpConnectionHandler this class does not own a thread. Many connections share
+ *  the thread of one HttpEventLoop which multiplexes all their sockets.
+ *  <p>
+ *  Requests are read in the event loop thread. The request handler is either called in the event loop
+ *  thread or, if a worker pool is given, in a thread of the worker pool which allows CPU bound handlers
+ *  to run without blocking all other connections of the event loop.
+ *  The response is always generated into a buffer and then passed to the socket without blocking.
+ *  <p>
+ *  Pipelined requests are processed one after the other. Reading of the next request is suspended
+ *  until the response for the current request has been passed to the socket.
+ *  @see HttpConnectionHandler for description of the readTimeout
+ *  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize
+ */
+
+class DECLSPEC HttpConnection :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpConnection)
+
+public:
+  /**
+   *  Constructor. Has to be called in the thread of the event loop.
+   *  @param settings Configuration settings of the HTTP server
+   *  @param requestHandler Handler that will process each incoming HTTP request
+   *  @param workerPool Thread pool for the request handler or 0 to call the handler in the event loop thread
+   *  @param sslConfiguration SSL (HTTPS) will be used if not NULL
+   *  @param parent Parent object which has to live in the event loop thread
+   */
+  HttpConnection(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler, QThreadPool *workerPool,
+                 const QSslConfiguration *sslConfiguration, QObject *parent);
+
+  /** Destructor */
+  virtual ~HttpConnection();
+
+  /**
+   *  Initialize the socket and start reading requests.
+   *  @param socketDescriptor references the accepted connection.
+   *  @return false if the socket could not be initialized
+   */
+  bool open(tSocketDescriptor socketDescriptor);
+
+  /**
+   *  Calls the request handler and finalizes the response.
+   *  Adds the Connection:close header to the response for HTTP 1.0 and if requested by the client.
+   *  @return true if the connection must be closed after sending the response
+   */
+  static bool serviceRequest(HttpRequestHandler *requestHandler, HttpRequest& request, HttpResponse& response);
+
+  /**
+   *  Only do the SSL handshake and do not read requests until the connection was moved by moveToLoop().
+   *  Used by event loops which terminate SSL for other event loops.
+   */
+  void setHandshakeOnly(bool value)
+  {
+    handshakeOnly = value;
+  }
+
+  /**
+   *  Move the connection and its socket to the thread of another event loop which becomes the parent.
+   *  Reading continues in the new thread. Has to be called in the current thread of the connection.
+   *  @param loop The new parent. Must not be deleted before the connection.
+   */
+  void moveToLoop(QObject *loop);
+
+  /** true if the socket is still connected */
+  bool isConnected() const
+  {
+    return socket->state() == QAbstractSocket::ConnectedState;
+  }
+
+signals:
+  /** Sent once the connection is closed and no request is in service anymore. The connection can be deleted. */
+  void closed();
+
+  /** Sent when the SSL handshake is finished */
+  void encrypted();
+
+private:
+  /** Configuration settings */
+  QHash<QString, QVariant> settings;
+
+  /** TCP or SSL socket for the current connection */
+  QTcpSocket *socket;
+
+  /** Time for read timeout detection */
+  QTimer readTimer;
+
+  /** Storage for the current incoming HTTP request */
+  HttpRequest *currentRequest;
+
+  /** Dispatches received requests to services */
+  HttpRequestHandler *requestHandler;
+
+  /** Runs the request handler if not null */
+  QThreadPool *workerPool;
+
+  /** Configuration for SSL */
+  const QSslConfiguration *sslConfiguration;
+
+  /** The current request is in service in the worker pool */
+  bool busy;
+
+  /** The socket was disconnected while the request was in service */
+  bool disconnectedWhileBusy;
+
+  /** Requests are not read before the connection is moved to another event loop */
+  bool handshakeOnly;
+
+  /** Create SSL or TCP socket */
+  void createSocket();
+
+  /** Value of the setting responseBufferSize */
+  int responseBufferSize() const;
+
+  /** Value of the setting compressionMinSize */
+  int compressionMinSize() const;
+
+  /** Pass the response for the current request to the socket and prepare for the next request */
+  void sendResponse(const QByteArray& output, bool closeConnection);
+
+private slots:
+  /** Received from the socket when a read-timeout occured */
+  void readTimeout();
+
+  /** Received from the socket when incoming data can be read */
+  void read();
+
+  /** Received from the socket when a connection has been closed */
+  void disconnected();
+
+  /** Called by the worker pool through the event queue when the response of the current request is done */
+  void serviceFinished(QByteArray output, bool closeConnection);
+
+  /** Called through the event queue in the new thread after moveToLoop() */
+  void attach(QObject *loop);
+
+};
+
+} // end of namespace
+
+#endif // HTTPCONNECTION_H
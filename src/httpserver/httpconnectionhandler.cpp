@@ -5,6 +5,7 @@
 
 #include "httpconnectionhandler.h"
 #include "httpresponse.h"
+#include "util/trace.h"
 
 using namespace stefanfrings;
 
@@ -152,7 +153,7 @@ void HttpConnectionHandler::read()
     // Create new HttpRequest object if necessary
     if(!currentRequest)
     {
-      currentRequest = new HttpRequest(settings);
+      currentRequest = new HttpRequest(settings, requestHandler);
     }
 
     // Collect data for the request object
@@ -188,7 +189,11 @@ void HttpConnectionHandler::read()
       qDebug("HttpConnectionHandler (%p): received request", static_cast<void *>(this));
 
       // Copy the Connection:close header to the response
-      HttpResponse response(socket);
+      int responseBufferSize = settings.value("responseBufferSize", HttpResponse::DEFAULT_BUFFER_SIZE).toInt();
+      HttpResponse response(socket, responseBufferSize);
+      response.setCompression(currentRequest->getHeader("Accept-Encoding"),
+                              settings.value("compressionMinSize",
+                                             HttpResponse::DEFAULT_COMPRESSION_MIN_SIZE).toInt());
       bool closeConnection =
         QString::compare(currentRequest->getHeader("Connection"), "close", Qt::CaseInsensitive) == 0;
       if(closeConnection)
@@ -210,6 +215,7 @@ void HttpConnectionHandler::read()
       // Call the request mapper
       try
       {
+        ATOOLS_TRACE_SCOPE("HttpRequestHandler::service", "http");
         requestHandler->service(*currentRequest, response);
       }
       catch(...)
@@ -270,4 +276,10 @@ void HttpConnectionHandler::read()
       currentRequest = nullptr;
     }
   }
+
+  // Send the responses of all pipelined requests at once
+  if(socket->isOpen())
+  {
+    socket->flush();
+  }
 }
@@ -38,11 +38,17 @@ typedef int tSocketDescriptor;
  *  Example for the required configuration settings:
  *  <code><pre>
  *  readTimeout=60000
+ *  responseBufferSize=65536
+ *  compressionMinSize=1024
  *  maxRequestSize=16000
  *  maxMultiPartSize=1000000
  *  </pre></code>
  *  <p>
  *  The readTimeout value defines the maximum time to wait for a complete HTTP request.
+ *  The responseBufferSize is the size of the output buffer of each response.
+ *  Text responses of at least compressionMinSize bytes are compressed if the client accepts it.
+ *  A negative value disables compression.
+ *  @see HttpResponse for the buffering of responses
  *  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize.
  */
 class DECLSPEC HttpConnectionHandler :
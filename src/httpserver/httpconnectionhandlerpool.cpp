@@ -15,8 +15,7 @@ HttpConnectionHandlerPool::HttpConnectionHandlerPool(QHash<QString, QVariant> se
 {
   this->settings = settings;
   this->requestHandler = requestHandler;
-  this->sslConfiguration = NULL;
-  loadSslConfig();
+  this->sslConfiguration = loadSslConfig(settings);
   cleanupTimer.start(settings.value("cleanupInterval", 1000).toInt());
   connect(&cleanupTimer, SIGNAL(timeout()), SLOT(cleanup()));
 }
@@ -82,8 +81,18 @@ void HttpConnectionHandlerPool::cleanup()
   mutex.unlock();
 }
 
-void HttpConnectionHandlerPool::loadSslConfig()
+int HttpConnectionHandlerPool::getNumThreads()
 {
+  mutex.lock();
+  int size = pool.size();
+  mutex.unlock();
+  return size;
+}
+
+QSslConfiguration *HttpConnectionHandlerPool::loadSslConfig(const QHash<QString, QVariant>& settings)
+{
+  QSslConfiguration *sslConfiguration = nullptr;
+
   // If certificate and key files are configured, then load them
   QString sslKeyFileName = settings.value("sslKeyFile", "").toString();
   QString sslCertFileName = settings.value("sslCertFile", "").toString();
@@ -108,7 +117,7 @@ void HttpConnectionHandlerPool::loadSslConfig()
     if(!certFile.open(QIODevice::ReadOnly))
     {
       qCritical("HttpConnectionHandlerPool: cannot open sslCertFile %s", qPrintable(sslCertFileName));
-      return;
+      return nullptr;
     }
     QSslCertificate certificate(&certFile, QSsl::Pem);
     certFile.close();
@@ -118,7 +127,7 @@ void HttpConnectionHandlerPool::loadSslConfig()
     if(!keyFile.open(QIODevice::ReadOnly))
     {
       qCritical("HttpConnectionHandlerPool: cannot open sslKeyFile %s", qPrintable(sslKeyFileName));
-      return;
+      return nullptr;
     }
     QSslKey sslKey(&keyFile, QSsl::Rsa, QSsl::Pem);
     keyFile.close();
@@ -133,4 +142,5 @@ void HttpConnectionHandlerPool::loadSslConfig()
     qDebug("HttpConnectionHandlerPool: SSL settings loaded");
          #endif
   }
+  return sslConfiguration;
 }
@@ -66,6 +66,15 @@ public:
   /** Get a free connection handler, or 0 if not available. */
   HttpConnectionHandler *getConnectionHandler();
 
+  /** Number of connection handlers and their threads, including idle ones */
+  int getNumThreads();
+
+  /**
+   *  Load the SSL configuration from the sslKeyFile and sslCertFile settings.
+   *  @return New SSL configuration which is owned by the caller or 0 if SSL is not configured.
+   */
+  static QSslConfiguration *loadSslConfig(const QHash<QString, QVariant>& settings);
+
 private:
   /** Settings for this pool */
   QHash<QString, QVariant> settings;
@@ -85,9 +94,6 @@ private:
   /** The SSL configuration (certificate, key and other settings) */
   QSslConfiguration *sslConfiguration;
 
-  /** Load SSL configuration */
-  void loadSslConfig();
-
 private slots:
   /** Received from the clean-up timer.  */
   void cleanup();
@@ -0,0 +1,98 @@
+/**
+ *  @file
+ */
+
+#include "httpeventchannel.h"
+#include <QList>
+
+using namespace stefanfrings;
+
+HttpEventChannel::HttpEventChannel()
+{
+  latestId = 0;
+  numSubscribers = 0;
+  closed = false;
+}
+
+void HttpEventChannel::publish(const QByteArray& eventName, const QByteArray& data)
+{
+  // Format outside of the lock once for all subscribers
+  QByteArray event;
+  event.reserve(data.size() + eventName.size() + 32);
+  if(!eventName.isEmpty())
+  {
+    event.append("event: ");
+    event.append(eventName);
+    event.append('\n');
+  }
+  foreach(const QByteArray& line, data.split('\n'))
+  {
+    event.append("data: ");
+    event.append(line);
+    event.append('\n');
+  }
+
+  mutex.lock();
+  latestId++;
+  event.prepend("id: " + QByteArray::number(latestId) + '\n');
+  event.append('\n');
+  latestEvent = event;
+  condition.wakeAll();
+  mutex.unlock();
+}
+
+bool HttpEventChannel::waitForEvent(quint64& lastId, QByteArray& event, unsigned long timeoutMs)
+{
+  QMutexLocker locker(&mutex);
+  if(!closed && latestId <= lastId)
+  {
+    condition.wait(&mutex, timeoutMs);
+  }
+
+  if(closed || latestId <= lastId)
+  {
+    return false;
+  }
+
+  // Skips all events between lastId and latestId
+  lastId = latestId;
+  event = latestEvent;
+  return true;
+}
+
+void HttpEventChannel::close()
+{
+  mutex.lock();
+  closed = true;
+  condition.wakeAll();
+  mutex.unlock();
+}
+
+bool HttpEventChannel::isClosed() const
+{
+  QMutexLocker locker(&mutex);
+  return closed;
+}
+
+bool HttpEventChannel::subscribe(int maxSubscribers)
+{
+  QMutexLocker locker(&mutex);
+  if(closed || numSubscribers >= maxSubscribers)
+  {
+    return false;
+  }
+  numSubscribers++;
+  return true;
+}
+
+void HttpEventChannel::unsubscribe()
+{
+  QMutexLocker locker(&mutex);
+  numSubscribers--;
+}
+
+int HttpEventChannel::getNumSubscribers() const
+{
+  QMutexLocker locker(&mutex);
+  return numSubscribers;
+}
@@ -0,0 +1,76 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPEVENTCHANNEL_H
+#define HTTPEVENTCHANNEL_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include "httpglobal.h"
+
+namespace stefanfrings {
+
+/**
+ *  Latest value channel for Server-Sent Events which are pushed to many clients.
+ *  <p>
+ *  The producer publishes events which are formatted only once. Subscribers wait for a newer event
+ *  and send it. Subscribers which are slower than the producer skip intermediate events and always
+ *  get the latest one. This limits the memory used for slow clients to one event.
+ *  This class is thread safe.
+ *  @see EventStreamController
+ */
+
+class DECLSPEC HttpEventChannel
+{
+  Q_DISABLE_COPY(HttpEventChannel)
+
+public:
+  /** Constructor */
+  HttpEventChannel();
+
+  /**
+   *  Format and publish a new event and wake up all waiting subscribers.
+   *  @param eventName Event type for the "event:" field. Not sent if empty.
+   *  @param data Event data. Must be text. Line breaks are split into several "data:" fields.
+   */
+  void publish(const QByteArray& eventName, const QByteArray& data);
+
+  /**
+   *  Wait until an event newer than lastId is available.
+   *  @param lastId Id of the last event sent by the caller. Updated to the id of the returned event.
+   *  @param event Formatted event ready to be written to the response.
+   *  @param timeoutMs Maximum time to wait
+   *  @return false on timeout or if the channel was closed
+   */
+  bool waitForEvent(quint64& lastId, QByteArray& event, unsigned long timeoutMs);
+
+  /** Wake up all subscribers and let waitForEvent() return false. Used on shutdown. */
+  void close();
+
+  /** true after close() */
+  bool isClosed() const;
+
+  /** Register and unregister subscribers. subscribe() returns false if maxSubscribers is reached. */
+  bool subscribe(int maxSubscribers);
+  void unsubscribe();
+
+  /** Number of currently connected subscribers */
+  int getNumSubscribers() const;
+
+private:
+  mutable QMutex mutex;
+  QWaitCondition condition;
+
+  /** Latest formatted event and its id. Id 0 means there is no event yet. */
+  QByteArray latestEvent;
+  quint64 latestId;
+
+  int numSubscribers;
+  bool closed;
+};
+
+} // end of namespace
+
+#endif // HTTPEVENTCHANNEL_H
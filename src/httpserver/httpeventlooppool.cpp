@@ -0,0 +1,210 @@
+/**
+ *  @file
+ */
+
+#include "httpeventlooppool.h"
+#include "httpconnection.h"
+#include "httpconnectionhandlerpool.h"
+#include <algorithm>
+
+using namespace stefanfrings;
+
+HttpEventLoop::HttpEventLoop(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler,
+                             QThreadPool *workerPool, const QSslConfiguration *sslConfiguration,
+                             bool handshakeOnly)
+  : QObject()
+{
+  this->settings = settings;
+  this->requestHandler = requestHandler;
+  this->workerPool = workerPool;
+  this->sslConfiguration = sslConfiguration;
+  this->handshakeOnly = handshakeOnly;
+}
+
+int HttpEventLoop::getNumConnections() const
+{
+  return numConnections.load();
+}
+
+void HttpEventLoop::addConnection()
+{
+  numConnections.ref();
+}
+
+void HttpEventLoop::handleConnection(tSocketDescriptor socketDescriptor)
+{
+  HttpConnection *connection = new HttpConnection(settings, requestHandler, workerPool, sslConfiguration, this);
+  connect(connection, SIGNAL(closed()), SLOT(connectionClosed()));
+  if(handshakeOnly)
+  {
+    // Queued to move the socket after it finished emitting its signals
+    connection->setHandshakeOnly(true);
+    connect(connection, SIGNAL(encrypted()), SLOT(connectionEncrypted()), Qt::QueuedConnection);
+  }
+  if(!connection->open(socketDescriptor))
+  {
+    delete connection;
+    numConnections.deref();
+  }
+}
+
+void HttpEventLoop::connectionClosed()
+{
+  HttpConnection *connection = qobject_cast<HttpConnection *>(sender());
+  if(connection)
+  {
+    // Signal is sent from a slot of the connection
+    connection->deleteLater();
+    numConnections.deref();
+  }
+}
+
+void HttpEventLoop::connectionEncrypted()
+{
+  HttpConnection *connection = qobject_cast<HttpConnection *>(sender());
+  // Ignore connections which were closed after the signal was queued
+  if(connection && connection->parent() == this && connection->isConnected())
+  {
+    connection->disconnect(this);
+    numConnections.deref();
+    emit handshakeFinished(connection);
+  }
+}
+
+void HttpEventLoop::closeConnections()
+{
+  foreach(HttpConnection * connection, findChildren<HttpConnection *>(QString(), Qt::FindDirectChildrenOnly))
+  {
+    delete connection;
+  }
+  numConnections.store(0);
+}
+
+HttpEventLoopPool::HttpEventLoopPool(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler)
+  : QObject()
+{
+  Q_ASSERT(requestHandler != nullptr);
+  sslConfiguration = HttpConnectionHandlerPool::loadSslConfig(settings);
+  maxConnections = settings.value("maxConnections", 1000).toInt();
+
+  int numWorkerThreads = settings.value("workerThreads", 0).toInt();
+  workerPool = nullptr;
+  if(numWorkerThreads > 0)
+  {
+    workerPool = new QThreadPool();
+    workerPool->setMaxThreadCount(numWorkerThreads);
+  }
+
+  int numIoThreads = std::max(settings.value("ioThreads", 1).toInt(), 1);
+  for(int i = 0; i < numIoThreads; i++)
+  {
+    startLoop(new HttpEventLoop(settings, requestHandler, workerPool, sslConfiguration), loops, threads);
+  }
+
+  int numSslThreads = sslConfiguration != nullptr ? settings.value("sslThreads", 0).toInt() : 0;
+  for(int i = 0; i < numSslThreads; i++)
+  {
+    HttpEventLoop *loop = new HttpEventLoop(settings, requestHandler, workerPool, sslConfiguration, true);
+    connect(loop, SIGNAL(handshakeFinished(HttpConnection *)), SLOT(handshakeFinished(HttpConnection *)),
+            Qt::DirectConnection);
+    startLoop(loop, sslLoops, sslThreads);
+  }
+
+  qDebug("HttpEventLoopPool (%p): started %i event loops, %i SSL event loops and %i worker threads",
+         static_cast<void *>(this), numIoThreads, numSslThreads, numWorkerThreads);
+}
+
+void HttpEventLoopPool::startLoop(HttpEventLoop *loop, QVector<HttpEventLoop *>& loopList,
+                                  QVector<QThread *>& threadList)
+{
+  QThread *thread = new QThread();
+  loop->moveToThread(thread);
+  thread->start();
+  threadList.append(thread);
+  loopList.append(loop);
+}
+
+void HttpEventLoopPool::stopLoops(QVector<HttpEventLoop *>& loopList, QVector<QThread *>& threadList)
+{
+  for(int i = 0; i < loopList.size(); i++)
+  {
+    // Sockets have to be deleted in the thread they live in
+    QMetaObject::invokeMethod(loopList.at(i), "closeConnections", Qt::BlockingQueuedConnection);
+    threadList.at(i)->quit();
+    threadList.at(i)->wait();
+    delete loopList.at(i);
+    delete threadList.at(i);
+  }
+  loopList.clear();
+  threadList.clear();
+}
+
+HttpEventLoopPool::~HttpEventLoopPool()
+{
+  // Requests in service post their responses to connections which must still exist
+  if(workerPool)
+  {
+    workerPool->waitForDone();
+  }
+
+  // SSL event loops first since these pass connections to the other event loops
+  stopLoops(sslLoops, sslThreads);
+  stopLoops(loops, threads);
+  delete workerPool;
+  delete sslConfiguration;
+  qDebug("HttpEventLoopPool (%p): destroyed", static_cast<void *>(this));
+}
+
+int HttpEventLoopPool::getNumWorkerThreads() const
+{
+  return workerPool != nullptr ? workerPool->activeThreadCount() : 0;
+}
+
+HttpEventLoop *HttpEventLoopPool::leastLoaded(const QVector<HttpEventLoop *>& loopList, int& numConnections)
+{
+  HttpEventLoop *freeLoop = nullptr;
+  int freeNum = 0;
+  foreach(HttpEventLoop * loop, loopList)
+  {
+    int num = loop->getNumConnections();
+    numConnections += num;
+    if(freeLoop == nullptr || num < freeNum)
+    {
+      freeLoop = loop;
+      freeNum = num;
+    }
+  }
+  return freeLoop;
+}
+
+void HttpEventLoopPool::handshakeFinished(HttpConnection *connection)
+{
+  // Called in the thread of the SSL event loop which is the current thread of the connection
+  int numConnections = 0;
+  HttpEventLoop *loop = leastLoaded(loops, numConnections);
+  loop->addConnection();
+  connect(connection, SIGNAL(closed()), loop, SLOT(connectionClosed()));
+  connection->moveToLoop(loop);
+}
+
+bool HttpEventLoopPool::handleConnection(tSocketDescriptor socketDescriptor)
+{
+  // Find the least loaded event loop. New SSL connections go to the SSL event loops if configured.
+  int numConnections = 0;
+  HttpEventLoop *freeLoop = leastLoaded(loops, numConnections);
+  if(!sslLoops.isEmpty())
+  {
+    freeLoop = leastLoaded(sslLoops, numConnections);
+  }
+
+  if(freeLoop == nullptr || numConnections >= maxConnections)
+  {
+    return false;
+  }
+
+  // The descriptor is passed via event queue because the event loop lives in another thread
+  freeLoop->addConnection();
+  QMetaObject::invokeMethod(freeLoop, "handleConnection", Qt::QueuedConnection,
+                            Q_ARG(tSocketDescriptor, socketDescriptor));
+  return true;
+}
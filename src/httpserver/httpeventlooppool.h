@@ -0,0 +1,182 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPEVENTLOOPPOOL_H
+#define HTTPEVENTLOOPPOOL_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include "httpglobal.h"
+#include "httpconnectionhandler.h"
+#include "httprequesthandler.h"
+
+namespace stefanfrings {
+
+class HttpConnection;
+
+/**
+ *  One event loop thread which multiplexes the sockets of many HttpConnection instances.
+ *  Lives in its own thread and is used by HttpEventLoopPool only.
+ */
+class DECLSPEC HttpEventLoop :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpEventLoop)
+
+public:
+  /**
+   *  Constructor.
+   *  @param settings Configuration settings of the HTTP server
+   *  @param requestHandler Handler that will process each incoming HTTP request
+   *  @param workerPool Thread pool for the request handler or 0 to call the handler in the event loop thread
+   *  @param sslConfiguration SSL (HTTPS) will be used if not NULL
+   *  @param handshakeOnly Only do the SSL handshake and pass the connections on by handshakeFinished()
+   */
+  HttpEventLoop(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler, QThreadPool *workerPool,
+                const QSslConfiguration *sslConfiguration, bool handshakeOnly = false);
+
+  /** Number of open connections in this event loop. Thread safe. */
+  int getNumConnections() const;
+
+  /** Called from another thread to reserve a connection before passing the descriptor to handleConnection() */
+  void addConnection();
+
+public slots:
+  /**
+   *  Creates a new connection for the descriptor in the thread of this event loop.
+   *  @param socketDescriptor references the accepted connection.
+   */
+  void handleConnection(tSocketDescriptor socketDescriptor);
+
+  /** Close and delete all connections. Has to be called in the thread of this event loop. */
+  void closeConnections();
+
+signals:
+  /**
+   *  Sent in the thread of this event loop if handshakeOnly is set and the SSL handshake of a connection is done.
+   *  The connection is not owned by this event loop anymore and has to be moved with HttpConnection::moveToLoop()
+   *  by a directly connected receiver.
+   */
+  void handshakeFinished(HttpConnection *connection);
+
+private slots:
+  /** Received from a connection when it is closed */
+  void connectionClosed();
+
+  /** Received from a connection when the SSL handshake is done */
+  void connectionEncrypted();
+
+private:
+  QHash<QString, QVariant> settings;
+  HttpRequestHandler *requestHandler;
+  QThreadPool *workerPool;
+  const QSslConfiguration *sslConfiguration;
+  bool handshakeOnly;
+
+  /** Number of connections including the ones not yet created from a queued descriptor */
+  QAtomicInt numConnections;
+};
+
+/**
+ *  Event loop mode of the HTTP server which replaces the thread per connection handlers of the
+ *  HttpConnectionHandlerPool. A fixed number of event loop threads multiplexes all client sockets.
+ *  New connections are assigned to the event loop with the lowest number of connections.
+ *  <p>
+ *  The request handler is called in the event loop thread if workerThreads is 0. This is efficient for
+ *  fast handlers. Set workerThreads to run CPU bound or blocking handlers in a separate
+ *  thread pool which keeps the event loops responsive.
+ *  <p>
+ *  The SSL handshake is CPU bound and delays all other connections of an event loop. Set sslThreads
+ *  to do the handshakes of new HTTPS connections in separate event loop threads. Connections are moved
+ *  to the least loaded of the ioThreads once the handshake is done.
+ *  <p>
+ *  Example for the required configuration settings:
+ *  <code><pre>
+ *  ioThreads=2
+ *  workerThreads=4
+ *  ;sslThreads=2
+ *  maxConnections=1000
+ *  readTimeout=60000
+ *  ;sslKeyFile=ssl/my.key
+ *  ;sslCertFile=ssl/my.cert
+ *  maxRequestSize=16000
+ *  maxMultiPartSize=1000000
+ *  </pre></code>
+ *  @see HttpConnectionHandlerPool for description of the ssl settings
+ *  @see HttpConnectionHandler for description of the readTimeout
+ *  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize
+ */
+
+class DECLSPEC HttpEventLoopPool :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpEventLoopPool)
+
+public:
+  /**
+   *  Constructor. Starts the event loop threads.
+   *  @param settings Configuration settings for the HTTP server. Must not be 0.
+   *  @param requestHandler The handler that will process each received HTTP request.
+   */
+  HttpEventLoopPool(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler);
+
+  /** Destructor. Waits for all requests in service, then closes all connections and stops the threads. */
+  virtual ~HttpEventLoopPool();
+
+  /**
+   *  Pass a new connection to the least loaded event loop.
+   *  @param socketDescriptor references the accepted connection.
+   *  @return false if the maximum number of connections is reached. The caller has to reject the connection.
+   */
+  bool handleConnection(tSocketDescriptor socketDescriptor);
+
+  /** Number of event loop threads */
+  int getNumIoThreads() const
+  {
+    return threads.size() + sslThreads.size();
+  }
+
+  /** Number of worker threads which are currently running or 0 if no worker pool is used */
+  int getNumWorkerThreads() const;
+
+private slots:
+  /** Received directly in the thread of an SSL event loop. Moves the connection to an event loop. */
+  void handshakeFinished(HttpConnection *connection);
+
+private:
+  /** Event loops and their threads at the same index */
+  QVector<HttpEventLoop *> loops;
+  QVector<QThread *> threads;
+
+  /** Event loops for SSL handshakes if sslThreads is configured */
+  QVector<HttpEventLoop *> sslLoops;
+  QVector<QThread *> sslThreads;
+
+  /** Start an event loop in a new thread */
+  void startLoop(HttpEventLoop *loop, QVector<HttpEventLoop *>& loopList, QVector<QThread *>& threadList);
+
+  /** Stop and delete the event loops */
+  void stopLoops(QVector<HttpEventLoop *>& loopList, QVector<QThread *>& threadList);
+
+  /** Event loop with the fewest connections or null if the list is empty. Sum of all connections in numConnections. */
+  static HttpEventLoop *leastLoaded(const QVector<HttpEventLoop *>& loopList, int& numConnections);
+
+  /** Runs request handlers if workerThreads is greater than 0. Otherwise null. */
+  QThreadPool *workerPool;
+
+  /** The SSL configuration (certificate, key and other settings) */
+  QSslConfiguration *sslConfiguration;
+
+  /** Maximum number of connections for all event loops */
+  int maxConnections;
+};
+
+} // end of namespace
+
+#endif // HTTPEVENTLOOPPOOL_H
@@ -0,0 +1,65 @@
+/**
+ *  @file
+ */
+
+#include "httpheaderlist.h"
+
+using namespace stefanfrings;
+
+int HttpHeaderList::indexOf(const QByteArray& name) const
+{
+  for(int i = 0; i < headers.size(); i++)
+  {
+    const QByteArray& key = headers.at(i).first;
+    if(key.size() == name.size() && qstricmp(key.constData(), name.constData()) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void HttpHeaderList::insert(const QByteArray& name, const QByteArray& value)
+{
+  int index = indexOf(name);
+  if(index >= 0)
+  {
+    headers[index].second = value;
+  }
+  else
+  {
+    headers.append(Header(name, value));
+  }
+}
+
+QByteArray HttpHeaderList::value(const QByteArray& name, const QByteArray& defaultValue) const
+{
+  int index = indexOf(name);
+  return index >= 0 ? headers.at(index).second : defaultValue;
+}
+
+bool HttpHeaderList::contains(const QByteArray& name) const
+{
+  return indexOf(name) >= 0;
+}
+
+int HttpHeaderList::remove(const QByteArray& name)
+{
+  int index = indexOf(name);
+  if(index >= 0)
+  {
+    headers.remove(index);
+    return 1;
+  }
+  return 0;
+}
+
+QList<QByteArray> HttpHeaderList::keys() const
+{
+  QList<QByteArray> names;
+  for(const Header& header : headers)
+  {
+    names.append(header.first);
+  }
+  return names;
+}
@@ -0,0 +1,74 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPHEADERLIST_H
+#define HTTPHEADERLIST_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QVarLengthArray>
+#include "httpglobal.h"
+
+namespace stefanfrings {
+
+/**
+ *  List of HTTP response headers which is stored in place for the usual small number of headers.
+ *  Replaces a map since linear search in a few entries is faster than tree lookups and allocations.
+ *  <p>
+ *  Header names are compared case-insensitive as required by HTTP. The insertion order is kept
+ *  when writing the headers.
+ */
+
+class DECLSPEC HttpHeaderList
+{
+public:
+  typedef QPair<QByteArray, QByteArray> Header;
+  typedef QVarLengthArray<Header, 16>::const_iterator const_iterator;
+
+  /** Set a header. Replaces the value if a header with the same name already exists. */
+  void insert(const QByteArray& name, const QByteArray& value);
+
+  /** Get the value of a header or defaultValue if not found */
+  QByteArray value(const QByteArray& name, const QByteArray& defaultValue = QByteArray()) const;
+
+  /** true if the header exists */
+  bool contains(const QByteArray& name) const;
+
+  /** Remove a header. Returns the number of removed headers which is 0 or 1. */
+  int remove(const QByteArray& name);
+
+  /** Get all header names in insertion order */
+  QList<QByteArray> keys() const;
+
+  int size() const
+  {
+    return headers.size();
+  }
+
+  bool isEmpty() const
+  {
+    return headers.isEmpty();
+  }
+
+  const_iterator begin() const
+  {
+    return headers.constBegin();
+  }
+
+  const_iterator end() const
+  {
+    return headers.constEnd();
+  }
+
+private:
+  /** Index of the header or -1 if not found */
+  int indexOf(const QByteArray& name) const;
+
+  QVarLengthArray<Header, 16> headers;
+};
+
+} // end of namespace
+
+#endif // HTTPHEADERLIST_H
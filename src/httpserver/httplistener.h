@@ -11,6 +11,7 @@
 #include "httpglobal.h"
 #include "httpconnectionhandler.h"
 #include "httpconnectionhandlerpool.h"
+#include "httpeventlooppool.h"
 #include "httprequesthandler.h"
 
 namespace stefanfrings {
@@ -31,11 +32,18 @@ namespace stefanfrings {
  *  ;sslCertFile=ssl/my.cert
  *  maxRequestSize=16000
  *  maxMultiPartSize=1000000
+ *  ;ioThreads=2
+ *  ;workerThreads=4
+ *  ;maxConnections=1000
  *  </pre></code>
  *  The optional host parameter binds the listener to one network interface.
  *  The listener handles all network interfaces if no host is configured.
  *  The port number specifies the incoming TCP port that this listener listens to.
+ *  If ioThreads is greater than 0 the listener uses the event loop mode where a fixed number of threads
+ *  multiplexes all connections instead of one thread per connection. The thread settings
+ *  minThreads, maxThreads and cleanupInterval are ignored in this mode.
  *  @see HttpConnectionHandlerPool for description of config settings minThreads, maxThreads, cleanupInterval and ssl settings
+ *  @see HttpEventLoopPool for description of config settings ioThreads, workerThreads, sslThreads and maxConnections
  *  @see HttpConnectionHandler for description of the readTimeout
  *  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize
  */
@@ -76,6 +84,12 @@ public:
    */
   void close();
 
+  /**
+   *  Number of threads serving connections. These are the connection handler threads or
+   *  the event loop threads plus the currently active worker threads in event loop mode.
+   */
+  int getNumThreads() const;
+
 protected:
   /** Serves new incoming connection requests */
   void incomingConnection(tSocketDescriptor socketDescriptor);
@@ -87,9 +101,15 @@ private:
   /** Point to the reuqest handler which processes all HTTP requests */
   HttpRequestHandler *requestHandler;
 
+  /** Send 503 and close the connection */
+  void rejectConnection(tSocketDescriptor socketDescriptor);
+
   /** Pool of connection handlers */
   HttpConnectionHandlerPool *pool;
 
+  /** Event loops used instead of the pool if ioThreads is configured */
+  HttpEventLoopPool *loopPool;
+
 signals:
   /**
    *  Sent to the connection handler to process a new incoming connection.
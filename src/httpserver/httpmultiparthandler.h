@@ -0,0 +1,60 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPMULTIPARTHANDLER_H
+#define HTTPMULTIPARTHANDLER_H
+
+#include <QByteArray>
+#include "httpglobal.h"
+
+class QIODevice;
+
+namespace stefanfrings {
+
+class HttpRequest;
+
+/**
+ *  Receives the parts of a multipart/form-data request while the body is still arriving.
+ *  Created by HttpRequestHandler::createMultiPartHandler() once the request headers are complete
+ *  and deleted together with the request.
+ *  <p>
+ *  Form fields are always collected into the request parameters. The content of file parts is written
+ *  in blocks as received to the device returned by partStarted() which allows to store uploads directly
+ *  at their destination without an intermediate copy of the whole body.
+ *  <p>
+ *  Methods are called in the thread reading the request.
+ */
+
+class DECLSPEC HttpMultiPartHandler
+{
+public:
+  virtual ~HttpMultiPartHandler()
+  {
+  }
+
+  /**
+   *  Called when the headers of a file part were received.
+   *  @param request The request which is being received. Only headers and previous parts are available.
+   *  @param fieldName Name of the form field
+   *  @param fileName File name as given by the web browser
+   *  @param contentType Content type of the part or empty if not given
+   *  @return A device opened for writing which stays owned by the handler or null to store the content
+   *  in a temporary file available by HttpRequest::getUploadedFile()
+   */
+  virtual QIODevice *partStarted(const HttpRequest& request, const QByteArray& fieldName, const QByteArray& fileName,
+                                 const QByteArray& contentType) = 0;
+
+  /**
+   *  Called when a form field or file part is complete.
+   *  @param size Number of bytes of the content
+   *  @return false to abort the request
+   */
+  virtual bool partFinished(const HttpRequest& request, const QByteArray& fieldName, const QByteArray& fileName,
+                            qint64 size) = 0;
+
+};
+
+} // end of namespace
+
+#endif // HTTPMULTIPARTHANDLER_H
@@ -7,17 +7,25 @@
 #include <QList>
 #include <QDir>
 #include "httpcookie.h"
+#include "httpmultiparthandler.h"
+#include "httprequesthandler.h"
 
 using namespace stefanfrings;
 
-HttpRequest::HttpRequest(QHash<QString, QVariant> settings)
+HttpRequest::HttpRequest(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler)
 {
+  this->requestHandler = requestHandler;
   status = waitForRequest;
   currentSize = 0;
   expectedBodySize = 0;
   maxSize = settings.value("maxRequestSize", "16000").toInt();
   maxMultiPartSize = settings.value("maxMultiPartSize", "1000000").toInt();
-  tempFile = nullptr;
+  multiPartHandler = nullptr;
+  multiPartState = partPreamble;
+  multiPartReceived = 0;
+  partDevice = nullptr;
+  partFile = nullptr;
+  partSize = 0;
 }
 
 void HttpRequest::readRequest(QTcpSocket *socket)
@@ -143,6 +151,15 @@ void HttpRequest::readHeader(QTcpSocket *socket)
       qDebug("HttpRequest: expect %i bytes body", expectedBodySize);
             #endif
       status = waitForBody;
+      if(!boundary.isEmpty())
+      {
+        // Body starts with the boundary - add the line break which belongs to all following delimiters
+        multiPartBuffer = "\r\n";
+        if(requestHandler != nullptr)
+        {
+          multiPartHandler = requestHandler->createMultiPartHandler(*this);
+        }
+      }
     }
   }
 }
@@ -167,44 +184,36 @@ void HttpRequest::readBody(QTcpSocket *socket)
   }
   else
   {
-    // multipart body, store into temp file
+    // multipart body, parse while receiving
         #ifdef SUPERVERBOSE
     qDebug("HttpRequest: receiving multipart body");
         #endif
-    // Create an object for the temporary file, if not already present
-    if(tempFile == nullptr)
-    {
-      tempFile = new QTemporaryFile;
-    }
-    if(!tempFile->isOpen())
-    {
-      tempFile->open();
-    }
     // Transfer data in 64kb blocks
-    qint64 fileSize = tempFile->size();
-    qint64 toRead = expectedBodySize - fileSize;
+    qint64 toRead = expectedBodySize - multiPartReceived;
     if(toRead > 65536)
     {
       toRead = 65536;
     }
-    fileSize += tempFile->write(socket->read(toRead));
-    if(fileSize >= maxMultiPartSize)
+    QByteArray newData = socket->read(toRead);
+    multiPartReceived += newData.size();
+    if(multiPartReceived > maxMultiPartSize)
     {
       qWarning("HttpRequest: received too many multipart bytes");
       status = abort;
     }
-    else if(fileSize >= expectedBodySize)
+    else if(!parseMultiPart(newData))
+    {
+      status = abort;
+    }
+    else if(multiPartReceived >= expectedBodySize)
     {
         #ifdef SUPERVERBOSE
       qDebug("HttpRequest: received whole multipart body");
         #endif
-      tempFile->flush();
-      if(tempFile->error())
+      if(multiPartState != partEpilogue)
       {
-        qCritical("HttpRequest: Error writing temp file for multipart body");
+        qWarning("HttpRequest: format error, unexpected end of multipart body");
       }
-      parseMultiPartFile();
-      tempFile->close();
       status = complete;
     }
   }
@@ -396,130 +405,242 @@ QByteArray HttpRequest::urlDecode(const QByteArray source)
   return buffer;
 }
 
-void HttpRequest::parseMultiPartFile()
+bool HttpRequest::parseMultiPart(const QByteArray& data)
 {
-  qDebug("HttpRequest: parsing multipart temp file");
-  tempFile->seek(0);
-  bool finished = false;
-  while(!tempFile->atEnd() && !finished && !tempFile->error())
+  multiPartBuffer.append(data);
+
+  // The line break before a boundary belongs to the delimiter
+  const QByteArray delimiter = "\r\n--" + boundary;
+  while(true)
   {
-        #ifdef SUPERVERBOSE
-    qDebug("HttpRequest: reading multpart headers");
-        #endif
-    QByteArray fieldName;
-    QByteArray fileName;
-    while(!tempFile->atEnd() && !finished && !tempFile->error())
+    switch(multiPartState)
     {
-      QByteArray line = tempFile->readLine(65536).trimmed();
-      if(line.startsWith("Content-Disposition:"))
-      {
-        if(line.contains("form-data"))
+      case partPreamble:
         {
-          int start = line.indexOf(" name=\"");
-          int end = line.indexOf("\"", start + 7);
-          if(start >= 0 && end >= start)
-          {
-            fieldName = line.mid(start + 7, end - start - 7);
-          }
-          start = line.indexOf(" filename=\"");
-          end = line.indexOf("\"", start + 11);
-          if(start >= 0 && end >= start)
+          int pos = multiPartBuffer.indexOf(delimiter);
+          if(pos < 0)
           {
-            fileName = line.mid(start + 11, end - start - 11);
+            // Keep a possibly incomplete delimiter at the end
+            if(multiPartBuffer.size() >= delimiter.size())
+            {
+              multiPartBuffer.remove(0, multiPartBuffer.size() - delimiter.size() + 1);
+            }
+            return true;
           }
-                    #ifdef SUPERVERBOSE
-          qDebug("HttpRequest: multipart field=%s, filename=%s", fieldName.data(), fileName.data());
-                    #endif
+          multiPartBuffer.remove(0, pos + delimiter.size());
+          multiPartState = partBoundary;
         }
-        else
-        {
-          qDebug("HttpRequest: ignoring unsupported content part %s", line.data());
-        }
-      }
-      else if(line.isEmpty())
-      {
         break;
-      }
-    }
 
-        #ifdef SUPERVERBOSE
-    qDebug("HttpRequest: reading multpart data");
-        #endif
-    QTemporaryFile *uploadedFile = nullptr;
-    QByteArray fieldValue;
-    while(!tempFile->atEnd() && !finished && !tempFile->error())
-    {
-      QByteArray line = tempFile->readLine(65536);
-      if(line.startsWith("--" + boundary))
-      {
-        // Boundary found. Until now we have collected 2 bytes too much,
-        // so remove them from the last result
-        if(fileName.isEmpty() && !fieldName.isEmpty())
+      case partBoundary:
         {
-          // last field was a form field
-          fieldValue.remove(fieldValue.size() - 2, 2);
-          parameters.insert(fieldName, fieldValue);
-          qDebug("HttpRequest: set parameter %s=%s", fieldName.data(), fieldValue.data());
+          // Rest of the boundary line which is "--" after the last part
+          if(multiPartBuffer.size() < 2)
+          {
+            return true;
+          }
+          if(multiPartBuffer.startsWith("--"))
+          {
+            multiPartBuffer.clear();
+            multiPartState = partEpilogue;
+            return true;
+          }
+          int eol = multiPartBuffer.indexOf("\r\n");
+          if(eol < 0)
+          {
+            if(multiPartBuffer.size() > 1024)
+            {
+              qWarning("HttpRequest: format error, invalid multipart boundary line");
+              return false;
+            }
+            return true;
+          }
+          multiPartBuffer.remove(0, eol + 2);
+          partFieldName.clear();
+          partFileName.clear();
+          partContentType.clear();
+          multiPartState = partHeader;
         }
-        else if(!fileName.isEmpty() && !fieldName.isEmpty())
+        break;
+
+      case partHeader:
         {
-          // last field was a file
-          if(uploadedFile)
+          int eol = multiPartBuffer.indexOf("\r\n");
+          if(eol < 0)
+          {
+            if(multiPartBuffer.size() > 65536)
+            {
+              qWarning("HttpRequest: format error, multipart header line too long");
+              return false;
+            }
+            return true;
+          }
+          QByteArray line = multiPartBuffer.left(eol).trimmed();
+          multiPartBuffer.remove(0, eol + 2);
+          if(!line.isEmpty())
           {
-                        #ifdef SUPERVERBOSE
-            qDebug("HttpRequest: finishing writing to uploaded file");
-                        #endif
-            uploadedFile->resize(uploadedFile->size() - 2);
-            uploadedFile->flush();
-            uploadedFile->seek(0);
-            parameters.insert(fieldName, fileName);
-            qDebug("HttpRequest: set parameter %s=%s", fieldName.data(), fileName.data());
-            uploadedFiles.insert(fieldName, uploadedFile);
-            qDebug("HttpRequest: uploaded file size is %lli", uploadedFile->size());
+            parsePartHeader(line);
+          }
+          else if(beginPart())
+          {
+            multiPartState = partData;
           }
           else
           {
-            qWarning("HttpRequest: format error, unexpected end of file data");
+            return false;
           }
         }
-        if(line.contains(boundary + "--"))
-        {
-          finished = true;
-        }
         break;
-      }
-      else
-      {
-        if(fileName.isEmpty() && !fieldName.isEmpty())
-        {
-          // this is a form field.
-          currentSize += line.size();
-          fieldValue.append(line);
-        }
-        else if(!fileName.isEmpty() && !fieldName.isEmpty())
+
+      case partData:
         {
-          // this is a file
-          if(!uploadedFile)
+          int pos = multiPartBuffer.indexOf(delimiter);
+          if(pos < 0)
           {
-            uploadedFile = new QTemporaryFile();
-            uploadedFile->open();
+            // Pass all data except a possibly incomplete delimiter at the end
+            int size = multiPartBuffer.size() - delimiter.size() + 1;
+            if(size > 0)
+            {
+              if(!writePart(multiPartBuffer.constData(), size))
+              {
+                return false;
+              }
+              multiPartBuffer.remove(0, size);
+            }
+            return true;
           }
-          uploadedFile->write(line);
-          if(uploadedFile->error())
+          if(!writePart(multiPartBuffer.constData(), pos) || !finishPart())
           {
-            qCritical("HttpRequest: error writing temp file, %s", qPrintable(uploadedFile->errorString()));
+            return false;
           }
+          multiPartBuffer.remove(0, pos + delimiter.size());
+          multiPartState = partBoundary;
         }
+        break;
+
+      case partEpilogue:
+        multiPartBuffer.clear();
+        return true;
+    }
+  }
+}
+
+void HttpRequest::parsePartHeader(const QByteArray& line)
+{
+  QByteArray lower = line.toLower();
+  if(lower.startsWith("content-disposition:"))
+  {
+    if(lower.contains("form-data"))
+    {
+      int start = line.indexOf(" name=\"");
+      int end = line.indexOf("\"", start + 7);
+      if(start >= 0 && end >= start)
+      {
+        partFieldName = line.mid(start + 7, end - start - 7);
       }
+      start = line.indexOf(" filename=\"");
+      end = line.indexOf("\"", start + 11);
+      if(start >= 0 && end >= start)
+      {
+        partFileName = line.mid(start + 11, end - start - 11);
+      }
+            #ifdef SUPERVERBOSE
+      qDebug("HttpRequest: multipart field=%s, filename=%s", partFieldName.data(), partFileName.data());
+            #endif
+    }
+    else
+    {
+      qDebug("HttpRequest: ignoring unsupported content part %s", line.data());
     }
   }
-  if(tempFile->error())
+  else if(lower.startsWith("content-type:"))
   {
-    qCritical("HttpRequest: cannot read temp file, %s", qPrintable(tempFile->errorString()));
+    partContentType = line.mid(13).trimmed();
   }
-    #ifdef SUPERVERBOSE
-  qDebug("HttpRequest: finished parsing multipart temp file");
-    #endif
+}
+
+bool HttpRequest::beginPart()
+{
+  partSize = 0;
+  partValue.clear();
+  partDevice = nullptr;
+  if(partFieldName.isEmpty() || partFileName.isEmpty())
+  {
+    return true;
+  }
+
+  // File content goes to the device of the handler or into a temporary file
+  if(multiPartHandler != nullptr)
+  {
+    partDevice = multiPartHandler->partStarted(*this, partFieldName, partFileName, partContentType);
+  }
+  if(partDevice == nullptr)
+  {
+    partFile = new QTemporaryFile();
+    if(!partFile->open())
+    {
+      qCritical("HttpRequest: cannot open temp file, %s", qPrintable(partFile->errorString()));
+      delete partFile;
+      partFile = nullptr;
+      return false;
+    }
+    partDevice = partFile;
+  }
+  return true;
+}
+
+bool HttpRequest::writePart(const char *data, int size)
+{
+  if(size == 0 || partFieldName.isEmpty())
+  {
+    return true;
+  }
+
+  partSize += size;
+  if(partFileName.isEmpty())
+  {
+    // Form fields count against the request size
+    currentSize += size;
+    partValue.append(data, size);
+  }
+  else if(partDevice->write(data, size) != size)
+  {
+    qCritical("HttpRequest: error writing uploaded file, %s", qPrintable(partDevice->errorString()));
+    return false;
+  }
+  return true;
+}
+
+bool HttpRequest::finishPart()
+{
+  if(partFieldName.isEmpty())
+  {
+    return true;
+  }
+
+  if(partFileName.isEmpty())
+  {
+    parameters.insert(partFieldName, partValue);
+    qDebug("HttpRequest: set parameter %s=%s", partFieldName.data(), partValue.data());
+  }
+  else
+  {
+    parameters.insert(partFieldName, partFileName);
+    qDebug("HttpRequest: set parameter %s=%s", partFieldName.data(), partFileName.data());
+    if(partFile != nullptr)
+    {
+      partFile->flush();
+      partFile->seek(0);
+      delete uploadedFiles.value(partFieldName);
+      uploadedFiles.insert(partFieldName, partFile);
+      qDebug("HttpRequest: uploaded file size is %lli", partFile->size());
+      partFile = nullptr;
+    }
+    partDevice = nullptr;
+  }
+  partValue.clear();
+
+  return multiPartHandler == nullptr || multiPartHandler->partFinished(*this, partFieldName, partFileName, partSize);
 }
 
 HttpRequest::~HttpRequest()
@@ -533,14 +654,9 @@ HttpRequest::~HttpRequest()
     }
     delete file;
   }
-  if(tempFile != nullptr)
-  {
-    if(tempFile->isOpen())
-    {
-      tempFile->close();
-    }
-    delete tempFile;
-  }
+  // File of an incomplete upload
+  delete partFile;
+  delete multiPartHandler;
 }
 
 QTemporaryFile *HttpRequest::getUploadedFile(const QByteArray fieldName) const
@@ -15,8 +15,13 @@
 #include <QUuid>
 #include "httpglobal.h"
 
+class QIODevice;
+
 namespace stefanfrings {
 
+class HttpMultiPartHandler;
+class HttpRequestHandler;
+
 /**
  *  This object represents a single HTTP request. It reads the request
  *  from a TCP socket and provides getters for the individual parts
@@ -32,6 +37,11 @@ namespace stefanfrings {
  *  multipart/form-data requests (also known as file-upload), the maximum
  *  size of the body must not exceed maxMultiPartSize.
  *  The body is always a little larger than the file itself.
+ *  <p>
+ *  Multipart bodies are parsed while they arrive. Form fields are collected in memory and count
+ *  against maxMultiPartSize together with the headers. File content is written block by block
+ *  either to a temporary file or to the device given by a HttpMultiPartHandler.
+ *  @see HttpRequestHandler::createMultiPartHandler()
  */
 
 class DECLSPEC HttpRequest
@@ -49,8 +59,9 @@ public:
   /**
    *  Constructor.
    *  @param settings Configuration settings
+   *  @param requestHandler Used to get a handler for multipart bodies. Can be null.
    */
-  HttpRequest(QHash<QString, QVariant> settings);
+  HttpRequest(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler = nullptr);
 
   /**
    *  Destructor.
@@ -209,11 +220,56 @@ private:
   /** Boundary of multipart/form-data body. Empty if there is no such header */
   QByteArray boundary;
 
-  /** Temp file, that is used to store the multipart/form-data body */
-  QTemporaryFile *tempFile;
+  /** States of the multipart parser */
+  enum MultiPartState
+  {
+    partPreamble, partBoundary, partHeader, partData, partEpilogue
+  };
+
+  /** Creates handlers for multipart bodies or null */
+  HttpRequestHandler *requestHandler;
+
+  /** Receives parts of a multipart body or null */
+  HttpMultiPartHandler *multiPartHandler;
+
+  /** State of the multipart parser */
+  MultiPartState multiPartState;
+
+  /** Received multipart data which is not processed yet. Never larger than a header line or a boundary. */
+  QByteArray multiPartBuffer;
+
+  /** Number of multipart body bytes received */
+  qint64 multiPartReceived;
+
+  /** Field name, file name and content type of the current part */
+  QByteArray partFieldName, partFileName, partContentType;
+
+  /** Value of the current form field */
+  QByteArray partValue;
+
+  /** Destination of the current file part or null */
+  QIODevice *partDevice;
+
+  /** Temporary file of the current file part if not written to a device of the multipart handler */
+  QTemporaryFile *partFile;
+
+  /** Size of the current part */
+  qint64 partSize;
+
+  /** Parse the given block of a multipart body. Returns false on format or write errors. */
+  bool parseMultiPart(const QByteArray& data);
+
+  /** Parse a header line of a part */
+  void parsePartHeader(const QByteArray& line);
+
+  /** Begin a part after its headers were read */
+  bool beginPart();
+
+  /** Add content to the current part */
+  bool writePart(const char *data, int size);
 
-  /** Parse the multipart body, that has been stored in the temp file. */
-  void parseMultiPartFile();
+  /** Finish the current part */
+  bool finishPart();
 
   /** Sub-procedure of readFromSocket(), read the first line of a request. */
   void readRequest(QTcpSocket *socket);
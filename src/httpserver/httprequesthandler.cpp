@@ -24,3 +24,9 @@ void HttpRequestHandler::service(HttpRequest& request, HttpResponse& response)
   response.setStatus(501, "not implemented");
   response.write("501 not implemented", true);
 }
+
+HttpMultiPartHandler *HttpRequestHandler::createMultiPartHandler(const HttpRequest& request)
+{
+  Q_UNUSED(request)
+  return nullptr;
+}
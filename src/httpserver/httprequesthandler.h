@@ -7,6 +7,7 @@
 #define HTTPREQUESTHANDLER_H
 
 #include "httpglobal.h"
+#include "httpmultiparthandler.h"
 #include "httprequest.h"
 #include "httpresponse.h"
 
@@ -48,6 +49,16 @@ public:
    */
   virtual void service(HttpRequest& request, HttpResponse& response);
 
+  /**
+   *  Called once the headers of a multipart/form-data request are received to get a handler which
+   *  processes the parts while the body arrives. The default implementation returns null which stores
+   *  uploaded files in temporary files.
+   *  @param request The request with method, path and headers
+   *  @return A new handler which is deleted with the request or null
+   *  @warning This method must be thread safe
+   */
+  virtual HttpMultiPartHandler *createMultiPartHandler(const HttpRequest& request);
+
 };
 
 } // end of namespace
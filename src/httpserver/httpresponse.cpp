@@ -7,14 +7,63 @@
 
 using namespace stefanfrings;
 
-HttpResponse::HttpResponse(QTcpSocket *socket)
+HttpResponse::HttpResponse(QIODevice *socket, int bufferSize)
 {
   this->socket = socket;
+  this->bufferSize = bufferSize;
   statusCode = 200;
   statusText = "OK";
   sentHeaders = false;
   sentLastPart = false;
   chunkedMode = false;
+  encoding = HttpCompressor::identity;
+  compressionMinSize = -1;
+  compressor = nullptr;
+}
+
+HttpResponse::~HttpResponse()
+{
+  HttpCompressor::release(compressor);
+}
+
+void HttpResponse::setCompression(const QByteArray& acceptEncoding, int minSize)
+{
+  Q_ASSERT(sentHeaders == false);
+  encoding = minSize >= 0 ? HttpCompressor::selectEncoding(acceptEncoding) : HttpCompressor::identity;
+  compressionMinSize = minSize;
+}
+
+bool HttpResponse::isCompressibleType() const
+{
+  QByteArray contentType = headers.value("Content-Type").toLower();
+
+  // Event streams are sent unchanged to avoid delays by buffering proxies and clients
+  return (contentType.startsWith("text/") && !contentType.startsWith("text/event-stream")) ||
+         contentType.contains("json") || contentType.contains("javascript") || contentType.contains("xml");
+}
+
+void HttpResponse::startCompression(int contentLength)
+{
+  if(compressionMinSize < 0 || statusCode < 200 || statusCode == 204 || statusCode == 304 ||
+     headers.contains("Content-Encoding") || headers.contains("Content-Length") || !isCompressibleType())
+  {
+    return;
+  }
+
+  // Caches have to keep compressed and uncompressed variants apart
+  if(!headers.contains("Vary"))
+  {
+    headers.insert("Vary", "Accept-Encoding");
+  }
+
+  if(encoding != HttpCompressor::identity && (contentLength < 0 || contentLength >= compressionMinSize))
+  {
+    compressor = HttpCompressor::acquire(encoding);
+    if(compressor != nullptr)
+    {
+      headers.insert("Content-Encoding", HttpCompressor::encodingName(encoding));
+    }
+  }
 }
 
 void HttpResponse::setHeader(QByteArray name, QByteArray value)
@@ -29,7 +78,7 @@ void HttpResponse::setHeader(QByteArray name, int value)
   headers.insert(name, QByteArray::number(value));
 }
 
-QMap<QByteArray, QByteArray>& HttpResponse::getHeaders()
+HttpHeaderList& HttpResponse::getHeaders()
 {
   return headers;
 }
@@ -45,42 +94,58 @@ int HttpResponse::getStatusCode() const
   return this->statusCode;
 }
 
-void HttpResponse::writeHeaders()
+void HttpResponse::writeHeaders(int contentLength)
 {
   Q_ASSERT(sentHeaders == false);
-  QByteArray buffer;
-  buffer.append("HTTP/1.1 ");
-  buffer.append(QByteArray::number(statusCode));
-  buffer.append(' ');
-  buffer.append(statusText);
-  buffer.append("\r\n");
-  foreach(QByteArray name, headers.keys())
-  {
-    buffer.append(name);
-    buffer.append(": ");
-    buffer.append(headers.value(name));
-    buffer.append("\r\n");
+
+  if(contentLength >= 0)
+  {
+    // The whole body is known - set the Content-Length header automatically
+    headers.insert("Content-Length", QByteArray::number(contentLength));
+  }
+  // else if we will not close the connection at the end, them we must use the chunked mode.
+  // Not needed if the caller set the Content-Length header.
+  else if(!headers.contains("Content-Length"))
+  {
+    bool connectionClose = QString::compare(headers.value("Connection"), "close", Qt::CaseInsensitive) == 0;
+    if(!connectionClose)
+    {
+      headers.insert("Transfer-Encoding", "chunked");
+      chunkedMode = true;
+    }
+  }
+
+  output.append("HTTP/1.1 ");
+  output.append(QByteArray::number(statusCode));
+  output.append(' ');
+  output.append(statusText);
+  output.append("\r\n");
+  for(const HttpHeaderList::Header& header : headers)
+  {
+    output.append(header.first);
+    output.append(": ");
+    output.append(header.second);
+    output.append("\r\n");
   }
   foreach(HttpCookie cookie, cookies.values())
   {
-    buffer.append("Set-Cookie: ");
-    buffer.append(cookie.toByteArray());
-    buffer.append("\r\n");
+    output.append("Set-Cookie: ");
+    output.append(cookie.toByteArray());
+    output.append("\r\n");
   }
-  buffer.append("\r\n");
-  writeToSocket(buffer);
-  socket->flush();
+  output.append("\r\n");
   sentHeaders = true;
 }
 
-bool HttpResponse::writeToSocket(QByteArray data)
+bool HttpResponse::writeToSocket(const QByteArray& data)
 {
   int remaining = data.size();
-  char *ptr = data.data();
+  // Read only access avoids a deep copy of raw data like memory mapped files
+  const char *ptr = data.constData();
   while(socket->isOpen() && remaining > 0)
   {
     // If the output buffer has become large, then wait until it has been sent.
-    if(socket->bytesToWrite() > 16384)
+    if(socket->bytesToWrite() > bufferSize)
     {
       socket->waitForBytesWritten(-1);
     }
@@ -96,64 +161,123 @@ bool HttpResponse::writeToSocket(QByteArray data)
   return true;
 }
 
+bool HttpResponse::sendOutput()
+{
+  if(output.isEmpty())
+  {
+    return true;
+  }
+  bool ok = writeToSocket(output);
+  output.clear();
+  return ok;
+}
+
+void HttpResponse::appendBody(const QByteArray& data)
+{
+  if(data.isEmpty())
+  {
+    return;
+  }
+
+  if(chunkedMode)
+  {
+    output.append(QByteArray::number(data.size(), 16));
+    output.append("\r\n");
+  }
+
+  if(data.size() >= bufferSize)
+  {
+    // Pass large blocks directly to the socket without copying them into the output buffer
+    sendOutput();
+    writeToSocket(data);
+  }
+  else
+  {
+    output.append(data);
+  }
+
+  if(chunkedMode)
+  {
+    output.append("\r\n");
+  }
+}
+
 void HttpResponse::write(QByteArray data, bool lastPart)
 {
   Q_ASSERT(sentLastPart == false);
 
-  // Send HTTP headers, if not already done (that happens only on the first call to write())
+  // Send HTTP headers, if not already done
   if(sentHeaders == false)
   {
-    // If the whole response is generated with a single call to write(), then we know the total
-    // size of the response and therefore can set the Content-Length header automatically.
-    if(lastPart)
+    // Collect small pieces until the buffer is full. If the response is complete by then
+    // we know its total size and therefore can set the Content-Length header automatically.
+    if(!lastPart && body.size() + data.size() < bufferSize)
     {
-      // Automatically set the Content-Length header
-      headers.insert("Content-Length", QByteArray::number(data.size()));
+      body.append(data);
+      return;
     }
-    // else if we will not close the connection at the end, them we must use the chunked mode.
-    else
+
+    startCompression(lastPart ? body.size() + data.size() : -1);
+    if(compressor != nullptr)
     {
-      QByteArray connectionValue = headers.value("Connection", headers.value("connection"));
-      bool connectionClose = QString::compare(connectionValue, "close", Qt::CaseInsensitive) == 0;
-      if(!connectionClose)
-      {
-        headers.insert("Transfer-Encoding", "chunked");
-        chunkedMode = true;
-      }
+      // Continue with the compressed data which gives the Content-Length for complete responses
+      QByteArray compressed = compressor->compress(body, HttpCompressor::noFlush);
+      compressed.append(compressor->compress(data, lastPart ? HttpCompressor::finish : HttpCompressor::noFlush));
+      body.clear();
+      data = compressed;
     }
-
-    writeHeaders();
+    writeHeaders(lastPart ? body.size() + data.size() : -1);
+  }
+  else if(compressor != nullptr)
+  {
+    data = compressor->compress(data, lastPart ? HttpCompressor::finish : HttpCompressor::noFlush);
   }
 
-  // Send data
-  if(data.size() > 0)
+  if(chunkedMode)
   {
-    if(chunkedMode)
+    if(body.isEmpty() && data.size() >= bufferSize)
+    {
+      // Large block makes its own chunk
+      appendBody(data);
+    }
+    else
     {
-      if(data.size() > 0)
+      // Collect small pieces into chunks of buffer size
+      body.append(data);
+      if(body.size() >= bufferSize || lastPart)
       {
-        QByteArray size = QByteArray::number(data.size(), 16);
-        writeToSocket(size);
-        writeToSocket("\r\n");
-        writeToSocket(data);
-        writeToSocket("\r\n");
+        appendBody(body);
+        body.clear();
       }
     }
-    else
+
+    // Terminating marker
+    if(lastPart)
     {
-      writeToSocket(data);
+      output.append("0\r\n\r\n");
     }
   }
-
-  // Only for the last chunk, send the terminating marker and flush the buffer.
-  if(lastPart)
+  else
   {
-    if(chunkedMode)
+    if(!body.isEmpty())
     {
-      writeToSocket("0\r\n\r\n");
+      appendBody(body);
+      body.clear();
     }
-    socket->flush();
+    appendBody(data);
+  }
+
+  // Only for the last part send all buffered data. The connection handler flushes the socket.
+  if(lastPart || output.size() >= bufferSize)
+  {
+    sendOutput();
+  }
+
+  if(lastPart)
+  {
     sentLastPart = true;
+    HttpCompressor::release(compressor);
+    compressor = nullptr;
   }
 }
 
@@ -185,10 +309,44 @@ void HttpResponse::redirect(const QByteArray& url)
 
 void HttpResponse::flush()
 {
-  socket->flush();
+  if(!sentLastPart)
+  {
+    if(!sentHeaders)
+    {
+      // Sent uncompressed since the receiver wants to see the data now
+      writeHeaders(-1);
+    }
+    else if(compressor != nullptr)
+    {
+      body.append(compressor->compress(nullptr, 0, HttpCompressor::syncFlush));
+    }
+    if(!body.isEmpty())
+    {
+      appendBody(body);
+      body.clear();
+    }
+  }
+  sendOutput();
+
+  // Buffers have nothing to flush
+  QAbstractSocket *abstractSocket = qobject_cast<QAbstractSocket *>(socket);
+  if(abstractSocket)
+  {
+    abstractSocket->flush();
+  }
 }
 
 bool HttpResponse::isConnected() const
 {
+  QAbstractSocket *abstractSocket = qobject_cast<QAbstractSocket *>(socket);
+  if(abstractSocket)
+  {
+    return abstractSocket->state() == QAbstractSocket::ConnectedState;
+  }
   return socket->isOpen();
 }
+
+bool HttpResponse::isBuffered() const
+{
+  return qobject_cast<QAbstractSocket *>(socket) == nullptr;
+}
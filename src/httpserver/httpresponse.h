@@ -10,7 +10,9 @@
 #include <QString>
 #include <QTcpSocket>
 #include "httpglobal.h"
+#include "httpcompressor.h"
 #include "httpcookie.h"
+#include "httpheaderlist.h"
 
 namespace stefanfrings {
 
@@ -31,6 +33,19 @@ namespace stefanfrings {
  *  <p>
  *  In case of large responses (e.g. file downloads), a Content-Length header should be set
  *  before calling write(). Web Browsers use that information to display a progress bar.
+ *  <p>
+ *  Output is collected in a buffer and passed to the socket in large blocks once the buffer
+ *  reaches its size. Headers are not sent before the buffer is full or the last part is written.
+ *  Therefore responses written in several small pieces get a Content-Length header instead of using
+ *  chunked mode. Large generated responses are sent in chunks of the buffer size.
+ *  <p>
+ *  The socket is not flushed after the last part. The connection handler flushes once for all
+ *  responses of pipelined requests.
+ *  <p>
+ *  Text responses are compressed with gzip or deflate if enabled by setCompression() and accepted by
+ *  the client. Small complete responses are sent uncompressed. Responses with a Content-Length or
+ *  Content-Encoding header set by the caller are never compressed. Compression works in chunked mode too
+ *  where flush() forces all compressed data out.
  */
 
 class DECLSPEC HttpResponse
@@ -40,9 +55,28 @@ class DECLSPEC HttpResponse
 public:
   /**
    *  Constructor.
-   *  @param socket used to write the response
+   *  @param socket used to write the response. This is usually a QTcpSocket but can also be
+   *  a QBuffer if the response is generated in a worker thread and sent later by the connection.
+   *  @param bufferSize Size of the output buffer and maximum chunk size. Also used as
+   *  high-water mark for the socket. Writing waits while the socket has more bytes pending.
+   */
+  HttpResponse(QIODevice *socket, int bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /** Releases the compressor if the response was not completed */
+  ~HttpResponse();
+
+  /** Default for the setting responseBufferSize */
+  static const int DEFAULT_BUFFER_SIZE = 65536;
+
+  /** Default for the setting compressionMinSize */
+  static const int DEFAULT_COMPRESSION_MIN_SIZE = 1024;
+
+  /**
+   *  Enable compression of the body. Call before the first write().
+   *  @param acceptEncoding Value of the Accept-Encoding request header
+   *  @param minSize Complete responses smaller than this are not compressed. Compression is disabled if negative.
    */
-  HttpResponse(QTcpSocket *socket);
+  void setCompression(const QByteArray& acceptEncoding, int minSize = DEFAULT_COMPRESSION_MIN_SIZE);
 
   /**
    *  Set a HTTP response header.
@@ -60,8 +94,8 @@ public:
    */
   void setHeader(const QByteArray name, const int value);
 
-  /** Get the map of HTTP response headers */
-  QMap<QByteArray, QByteArray>& getHeaders();
+  /** Get the list of HTTP response headers */
+  HttpHeaderList& getHeaders();
 
   /** Get the map of cookies */
   QMap<QByteArray, HttpCookie>& getCookies();
@@ -80,13 +114,13 @@ public:
    *  <p>
    *  The HTTP status line, headers and cookies are sent automatically before the body.
    *  <p>
-   *  If the response contains only a single chunk (indicated by lastPart=true),
+   *  If the whole response fits into the buffer (indicated by lastPart=true),
    *  then a Content-Length header is automatically set.
    *  <p>
-   *  Chunked mode is automatically selected if there is no Content-Length header
-   *  and also no Connection:close header.
+   *  Chunked mode is automatically selected if the response exceeds the buffer and there
+   *  is no Content-Length header and also no Connection:close header.
    *  @param data Data bytes of the body
-   *  @param lastPart Indicates that this is the last chunk of data and flushes the output buffer.
+   *  @param lastPart Indicates that this is the last chunk of data and sends the output buffer.
    */
   void write(const QByteArray data, const bool lastPart = false);
 
@@ -109,7 +143,8 @@ public:
   void redirect(const QByteArray& url);
 
   /**
-   * Flush the output buffer (of the underlying socket).
+   * Send the output buffer and flush the underlying socket.
+   * Sends the headers if not already done which selects chunked mode if no Content-Length is set.
    * You normally don't need to call this method because flush is
    * automatically called after HttpRequestHandler::service() returns.
    */
@@ -121,12 +156,19 @@ public:
    */
   bool isConnected() const;
 
+  /**
+   * true if the response is written into a buffer which is sent after HttpRequestHandler::service()
+   * returns. This is the case for the event loop mode. Streaming responses like Server-Sent Events
+   * cannot be used then.
+   */
+  bool isBuffered() const;
+
 private:
   /** Request headers */
-  QMap<QByteArray, QByteArray> headers;
+  HttpHeaderList headers;
 
-  /** Socket for writing output */
-  QTcpSocket *socket;
+  /** Socket or buffer for writing output */
+  QIODevice *socket;
 
   /** HTTP status code*/
   int statusCode;
@@ -146,15 +188,49 @@ private:
   /** Cookies */
   QMap<QByteArray, HttpCookie> cookies;
 
+  /** Size of buffers */
+  int bufferSize;
+
+  /** Headers and framed body data waiting to be written to the socket */
+  QByteArray output;
+
+  /** Body data not added to output yet. Used to defer the header decision and to collect chunks. */
+  QByteArray body;
+
+  /** Encoding accepted by the client */
+  HttpCompressor::Encoding encoding;
+
+  /** Minimum size for compression of complete responses */
+  int compressionMinSize;
+
+  /** Not null while the body is compressed */
+  HttpCompressor *compressor;
+
+  /** true if the content type is worth compressing */
+  bool isCompressibleType() const;
+
+  /**
+   *  Start compression if accepted, possible and useful and add the headers. Called once before sending headers.
+   *  @param contentLength Length of the complete uncompressed body or -1 if not known yet.
+   */
+  void startCompression(int contentLength);
+
   /** Write raw data to the socket. This method blocks until all bytes have been passed to the TCP buffer */
-  bool writeToSocket(QByteArray data);
+  bool writeToSocket(const QByteArray& data);
+
+  /** Write and clear the output buffer */
+  bool sendOutput();
+
+  /** Add body data to the output or pass it directly to the socket if large. Frames it in chunked mode. */
+  void appendBody(const QByteArray& data);
 
   /**
-   *  Write the response HTTP status and headers to the socket.
+   *  Add the response HTTP status and headers to the output.
    *  Calling this method is optional, because writeBody() calls
    *  it automatically when required.
+   *  @param contentLength Length of the complete body or -1 if not known yet.
    */
-  void writeHeaders();
+  void writeHeaders(int contentLength);
 
 };
 
@@ -13,9 +13,13 @@ HttpSessionStore::HttpSessionStore(QHash<QString, QVariant> settings, QObject *p
   : QObject(parent)
 {
   this->settings = settings;
+  cleanupShard = 0;
   connect(&cleanupTimer, SIGNAL(timeout()), this, SLOT(sessionTimerEvent()));
-  cleanupTimer.start(60000);
+  cleanupTimer.start(60000 / NUM_SHARDS);
   cookieName = settings.value("cookieName", "sessionid").toByteArray();
+  cookiePath = settings.value("cookiePath").toByteArray();
+  cookieComment = settings.value("cookieComment").toByteArray();
+  cookieDomain = settings.value("cookieDomain").toByteArray();
   expirationTime = settings.value("expirationTime", 3600000).toInt();
   qDebug("HttpSessionStore: Sessions expire after %i milliseconds", expirationTime);
 }
@@ -25,10 +29,20 @@ HttpSessionStore::~HttpSessionStore()
   cleanupTimer.stop();
 }
 
+HttpSessionStore::Shard& HttpSessionStore::shard(const QByteArray& id)
+{
+  return shards[qHash(id) % NUM_SHARDS];
+}
+
+void HttpSessionStore::setCookie(const HttpSession& session, HttpResponse& response) const
+{
+  response.setCookie(HttpCookie(cookieName, session.getId(), expirationTime / 1000, cookiePath, cookieComment,
+                                cookieDomain));
+}
+
 QByteArray HttpSessionStore::getSessionId(HttpRequest& request, HttpResponse& response)
 {
   // The session ID in the response has priority because this one will be used in the next request.
-  mutex.lock();
   // Get the session ID from the response cookie
   QByteArray sessionId = response.getCookies().value(cookieName).getValue();
   if(sessionId.isEmpty())
@@ -39,33 +53,32 @@ QByteArray HttpSessionStore::getSessionId(HttpRequest& request, HttpResponse& re
   // Clear the session ID if there is no such session in the storage.
   if(!sessionId.isEmpty())
   {
-    if(!sessions.contains(sessionId))
+    Shard& sessionShard = shard(sessionId);
+    sessionShard.mutex.lock();
+    bool found = sessionShard.sessions.contains(sessionId);
+    sessionShard.mutex.unlock();
+    if(!found)
     {
       qDebug("HttpSessionStore: received invalid session cookie with ID %s", sessionId.data());
       sessionId.clear();
     }
   }
-  mutex.unlock();
   return sessionId;
 }
 
 HttpSession HttpSessionStore::getSession(HttpRequest& request, HttpResponse& response, bool allowCreate)
 {
   QByteArray sessionId = getSessionId(request, response);
-  mutex.lock();
   if(!sessionId.isEmpty())
   {
-    HttpSession session = sessions.value(sessionId);
+    Shard& sessionShard = shard(sessionId);
+    sessionShard.mutex.lock();
+    HttpSession session = sessionShard.sessions.value(sessionId);
+    sessionShard.mutex.unlock();
     if(!session.isNull())
     {
-      mutex.unlock();
       // Refresh the session cookie
-      QByteArray cookieName = settings.value("cookieName", "sessionid").toByteArray();
-      QByteArray cookiePath = settings.value("cookiePath").toByteArray();
-      QByteArray cookieComment = settings.value("cookieComment").toByteArray();
-      QByteArray cookieDomain = settings.value("cookieDomain").toByteArray();
-      response.setCookie(HttpCookie(cookieName, session.getId(), expirationTime / 1000, cookiePath, cookieComment,
-                                    cookieDomain));
+      setCookie(session, response);
       session.setLastAccess();
       return session;
     }
@@ -73,56 +86,59 @@ HttpSession HttpSessionStore::getSession(HttpRequest& request, HttpResponse& res
   // Need to create a new session
   if(allowCreate)
   {
-    QByteArray cookieName = settings.value("cookieName", "sessionid").toByteArray();
-    QByteArray cookiePath = settings.value("cookiePath").toByteArray();
-    QByteArray cookieComment = settings.value("cookieComment").toByteArray();
-    QByteArray cookieDomain = settings.value("cookieDomain").toByteArray();
     HttpSession session(true);
     qDebug("HttpSessionStore: create new session with ID %s", session.getId().data());
-    sessions.insert(session.getId(), session);
-    response.setCookie(HttpCookie(cookieName, session.getId(), expirationTime / 1000, cookiePath, cookieComment,
-                                  cookieDomain));
-    mutex.unlock();
+    Shard& sessionShard = shard(session.getId());
+    sessionShard.mutex.lock();
+    sessionShard.sessions.insert(session.getId(), session);
+    sessionShard.mutex.unlock();
+    setCookie(session, response);
     return session;
   }
   // Return a null session
-  mutex.unlock();
   return HttpSession();
 }
 
 HttpSession HttpSessionStore::getSession(const QByteArray id)
 {
-  mutex.lock();
-  HttpSession session = sessions.value(id);
-  mutex.unlock();
+  Shard& sessionShard = shard(id);
+  sessionShard.mutex.lock();
+  HttpSession session = sessionShard.sessions.value(id);
+  sessionShard.mutex.unlock();
   session.setLastAccess();
   return session;
 }
 
 void HttpSessionStore::sessionTimerEvent()
 {
-  mutex.lock();
+  // Check only one shard in each interval
+  Shard& sessionShard = shards[cleanupShard];
+  cleanupShard = (cleanupShard + 1) % NUM_SHARDS;
+
+  sessionShard.mutex.lock();
   qint64 now = QDateTime::currentMSecsSinceEpoch();
-  QMap<QByteArray, HttpSession>::iterator i = sessions.begin();
-  while(i != sessions.end())
+  QHash<QByteArray, HttpSession>::iterator i = sessionShard.sessions.begin();
+  while(i != sessionShard.sessions.end())
   {
-    QMap<QByteArray, HttpSession>::iterator prev = i;
-    ++i;
-    HttpSession session = prev.value();
-    qint64 lastAccess = session.getLastAccess();
-    if(now - lastAccess > expirationTime)
+    HttpSession session = i.value();
+    if(now - session.getLastAccess() > expirationTime)
     {
       qDebug("HttpSessionStore: session %s expired", session.getId().data());
-      sessions.erase(prev);
+      i = sessionShard.sessions.erase(i);
+    }
+    else
+    {
+      ++i;
     }
   }
-  mutex.unlock();
+  sessionShard.mutex.unlock();
 }
 
 /** Delete a session */
 void HttpSessionStore::removeSession(HttpSession session)
 {
-  mutex.lock();
-  sessions.remove(session.getId());
-  mutex.unlock();
+  Shard& sessionShard = shard(session.getId());
+  sessionShard.mutex.lock();
+  sessionShard.sessions.remove(session.getId());
+  sessionShard.mutex.unlock();
 }
@@ -7,7 +7,7 @@
 #define HTTPSESSIONSTORE_H
 
 #include <QObject>
-#include <QMap>
+#include <QHash>
 #include <QTimer>
 #include <QMutex>
 #include "httpglobal.h"
@@ -30,6 +30,10 @@ namespace stefanfrings {
  *  cookieComment=Session ID
  *  ;cookieDomain=stefanfrings.de
  *  </pre></code>
+ *  <p>
+ *  Sessions are distributed over shards by the hash of their ID. Each shard has its own lock, so
+ *  requests of different sessions do not wait for each other. Expired sessions are removed
+ *  incrementally, one shard per timer interval, to avoid locking all sessions at once.
  */
 
 class DECLSPEC HttpSessionStore :
@@ -89,11 +93,26 @@ public:
   /** Delete a session */
   void removeSession(const HttpSession session);
 
-protected:
+private:
+  /** Number of independently locked parts of the session storage */
+  static const int NUM_SHARDS = 16;
+
+  /** Part of the session storage */
+  struct Shard
+  {
+    /** Used to synchronize threads */
+    QMutex mutex;
+
+    /** Storage for the sessions */
+    QHash<QByteArray, HttpSession> sessions;
+  };
+
   /** Storage for the sessions */
-  QMap<QByteArray, HttpSession> sessions;
+  Shard shards[NUM_SHARDS];
+
+  /** Next shard to check for expired sessions */
+  int cleanupShard;
 
-private:
   /** Configuration settings */
   QHash<QString, QVariant> settings;
 
@@ -103,14 +122,20 @@ private:
   /** Name of the session cookie */
   QByteArray cookieName;
 
+  /** Other cookie settings */
+  QByteArray cookiePath, cookieComment, cookieDomain;
+
   /** Time when sessions expire (in ms)*/
   int expirationTime;
 
-  /** Used to synchronize threads */
-  QMutex mutex;
+  /** Get the shard for a session ID */
+  Shard& shard(const QByteArray& id);
+
+  /** Set the session cookie in the response */
+  void setCookie(const HttpSession& session, HttpResponse& response) const;
 
 private slots:
-  /** Called every minute to cleanup expired sessions. */
+  /** Called periodically to cleanup expired sessions of one shard. All shards are checked every minute. */
   void sessionTimerEvent();
 
 };
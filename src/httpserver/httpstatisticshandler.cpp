@@ -0,0 +1,135 @@
+/**
+ *  @file
+ */
+
+#include "httpstatisticshandler.h"
+#include <algorithm>
+
+using namespace stefanfrings;
+
+HttpStatisticsHandler::HttpStatisticsHandler(HttpRequestHandler *requestHandler, QObject *parent)
+  : HttpRequestHandler(parent)
+{
+  Q_ASSERT(requestHandler != nullptr);
+  this->requestHandler = requestHandler;
+  activeRequests.store(0);
+  reset();
+}
+
+void HttpStatisticsHandler::service(HttpRequest& request, HttpResponse& response)
+{
+  int active = ++activeRequests;
+  int peak = peakActiveRequests.load(std::memory_order_relaxed);
+  while(active > peak && !peakActiveRequests.compare_exchange_weak(peak, active, std::memory_order_relaxed))
+  {
+  }
+
+  QElapsedTimer serviceTimer;
+  serviceTimer.start();
+  requestHandler->service(request, response);
+  quint64 micros = static_cast<quint64>(serviceTimer.nsecsElapsed() / 1000);
+
+  buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+  quint64 max = maxMicros.load(std::memory_order_relaxed);
+  while(micros > max && !maxMicros.compare_exchange_weak(max, micros, std::memory_order_relaxed))
+  {
+  }
+  --activeRequests;
+}
+
+HttpStatistics HttpStatisticsHandler::getStatistics() const
+{
+  HttpStatistics stats;
+
+  // Copy the histogram first to get consistent percentiles while requests are served
+  quint64 counts[NUM_BUCKETS];
+  quint64 total = 0;
+  for(int i = 0; i < NUM_BUCKETS; i++)
+  {
+    counts[i] = buckets[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+
+  stats.requests = total;
+  timerMutex.lock();
+  stats.elapsedMs = timer.elapsed();
+  timerMutex.unlock();
+  if(stats.elapsedMs > 0)
+  {
+    stats.requestsPerSecond = static_cast<double>(total) * 1000. / static_cast<double>(stats.elapsedMs);
+  }
+  stats.p50Us = percentile(counts, total, 50.);
+  stats.p99Us = percentile(counts, total, 99.);
+  stats.maxUs = maxMicros.load(std::memory_order_relaxed);
+  stats.activeRequests = activeRequests.load(std::memory_order_relaxed);
+  stats.peakActiveRequests = peakActiveRequests.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void HttpStatisticsHandler::reset()
+{
+  for(int i = 0; i < NUM_BUCKETS; i++)
+  {
+    buckets[i].store(0, std::memory_order_relaxed);
+  }
+  maxMicros.store(0, std::memory_order_relaxed);
+
+  // Requests in service keep their count
+  peakActiveRequests.store(activeRequests.load());
+
+  timerMutex.lock();
+  timer.start();
+  timerMutex.unlock();
+}
+
+int HttpStatisticsHandler::bucketIndex(quint64 micros)
+{
+  if(micros < LINEAR_BUCKETS)
+  {
+    return static_cast<int>(micros);
+  }
+
+  // Position of the highest bit which is at least 4 here
+  int exponent = 63;
+  while(!(micros & (Q_UINT64_C(1) << exponent)))
+  {
+    exponent--;
+  }
+
+  // Next three bits select the sub-bucket
+  int sub = static_cast<int>((micros >> (exponent - 3)) & (SUB_BUCKETS - 1));
+  int index = LINEAR_BUCKETS + (exponent - 4) * SUB_BUCKETS + sub;
+  return std::min(index, NUM_BUCKETS - 1);
+}
+
+quint64 HttpStatisticsHandler::bucketUpperBound(int index)
+{
+  if(index < LINEAR_BUCKETS)
+  {
+    return static_cast<quint64>(index);
+  }
+  int exponent = (index - LINEAR_BUCKETS) / SUB_BUCKETS + 4;
+  quint64 sub = static_cast<quint64>((index - LINEAR_BUCKETS) % SUB_BUCKETS);
+  return (Q_UINT64_C(1) << exponent) + ((sub + 1) << (exponent - 3)) - 1;
+}
+
+quint64 HttpStatisticsHandler::percentile(const quint64 *counts, quint64 total, double percent) const
+{
+  if(total == 0)
+  {
+    return 0;
+  }
+
+  // Rank of the requested value, at least the first one
+  quint64 rank = std::max(static_cast<quint64>(static_cast<double>(total) * percent / 100. + 0.5), Q_UINT64_C(1));
+  quint64 sum = 0;
+  for(int i = 0; i < NUM_BUCKETS; i++)
+  {
+    sum += counts[i];
+    if(sum >= rank)
+    {
+      return std::min(bucketUpperBound(i), maxMicros.load(std::memory_order_relaxed));
+    }
+  }
+  return maxMicros.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,100 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPSTATISTICSHANDLER_H
+#define HTTPSTATISTICSHANDLER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <atomic>
+#include "httpglobal.h"
+#include "httprequesthandler.h"
+
+namespace stefanfrings {
+
+/**
+ *  Snapshot of the request statistics.
+ *  Latencies are the time spent in the request handler in microseconds. Percentiles are upper bounds of a
+ *  histogram bucket and have an error of less than 12.5 percent.
+ */
+
+struct DECLSPEC HttpStatistics
+{
+  quint64 requests = 0;
+  qint64 elapsedMs = 0;
+  double requestsPerSecond = 0.;
+  quint64 p50Us = 0, p99Us = 0, maxUs = 0;
+  int activeRequests = 0, peakActiveRequests = 0;
+};
+
+/**
+ *  Request handler which passes all requests to another handler and measures throughput and latency.
+ *  Used to get a baseline for load tests with external HTTP benchmark tools and to compare
+ *  the thread per connection and the event loop modes or the effect of caching.
+ *  <p>
+ *  Recording is lock free and adds only a few atomic operations per request.
+ *  Use HttpListener::getNumThreads() to get the number of threads serving requests.
+ *  HttpBenchmark uses this handler to drive both server modes with in-process clients.
+ *  <p>
+ *  Example:
+ *  <code><pre>
+ *  HttpStatisticsHandler *stats = new HttpStatisticsHandler(new RequestMapper(app), app);
+ *  HttpListener *listener = new HttpListener(settings, stats, app);
+ *  ...
+ *  HttpStatistics s = stats->getStatistics();
+ *  qDebug("%.0f req/s p50 %llu us p99 %llu us threads %d", s.requestsPerSecond, s.p50Us, s.p99Us,
+ *         listener->getNumThreads());
+ *  </pre></code>
+ */
+
+class DECLSPEC HttpStatisticsHandler :
+  public HttpRequestHandler
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpStatisticsHandler)
+
+public:
+  /**
+   *  Constructor.
+   *  @param requestHandler Handler which processes the requests. Not owned.
+   *  @param parent Parent object.
+   */
+  HttpStatisticsHandler(HttpRequestHandler *requestHandler, QObject *parent = nullptr);
+
+  /** Pass the request to the wrapped handler and record the time */
+  void service(HttpRequest& request, HttpResponse& response) override;
+
+  /** Get statistics since construction or the last reset() */
+  HttpStatistics getStatistics() const;
+
+  /** Clear all counters and restart the time measurement */
+  void reset();
+
+private:
+  /** Latency histogram with 8 sub-buckets for each power of two */
+  static const int LINEAR_BUCKETS = 16;
+  static const int SUB_BUCKETS = 8;
+  static const int NUM_BUCKETS = LINEAR_BUCKETS + 36 * SUB_BUCKETS;
+
+  /** Bucket index for a latency and the highest latency of a bucket */
+  static int bucketIndex(quint64 micros);
+  static quint64 bucketUpperBound(int index);
+
+  /** Value of the histogram percentile in microseconds. percent is 0 to 100. */
+  quint64 percentile(const quint64 *counts, quint64 total, double percent) const;
+
+  HttpRequestHandler *requestHandler;
+
+  std::atomic<quint64> buckets[NUM_BUCKETS];
+  std::atomic<quint64> maxMicros;
+  std::atomic<int> activeRequests, peakActiveRequests;
+
+  /** Start of measurement. Guarded by timerMutex since reset() can be called while serving. */
+  QElapsedTimer timer;
+  mutable QMutex timerMutex;
+};
+
+} // end of namespace
+
+#endif // HTTPSTATISTICSHANDLER_H
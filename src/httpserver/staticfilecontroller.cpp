@@ -4,12 +4,37 @@
  */
 
 #include "staticfilecontroller.h"
+#include "zip/gzip.h"
+#include "util/memorybudget.h"
 #include <QFileInfo>
 #include <QDir>
 #include <QDateTime>
+#include <algorithm>
+#include <limits>
 
 using namespace stefanfrings;
 
+namespace {
+
+/** Compressed variants are only kept if they save at least this ratio */
+const double MIN_COMPRESSION_RATIO = 0.9;
+
+/** Files smaller than this are not compressed */
+const int MIN_COMPRESS_SIZE = 256;
+
+/** Read a precompressed file next to the original or return an empty array if not available */
+QByteArray readVariant(const QString& fileName)
+{
+  QFile file(fileName);
+  if(file.exists() && file.open(QIODevice::ReadOnly))
+  {
+    return file.readAll();
+  }
+  return QByteArray();
+}
+
+} // namespace
+
 StaticFileController::StaticFileController(QHash<QString, QVariant> settings, QObject *parent)
   : HttpRequestHandler(parent)
 {
@@ -27,31 +52,38 @@ StaticFileController::StaticFileController(QHash<QString, QVariant> settings, QO
   }
   qDebug("StaticFileController: docroot=%s, encoding=%s, maxAge=%i", qPrintable(docroot), qPrintable(encoding), maxAge);
   maxCachedFileSize = settings.value("maxCachedFileSize", "65536").toInt();
-  cache.setMaxCost(settings.value("cacheSize", "1000000").toInt());
+  maxCacheSize = settings.value("cacheSize", "1000000").toInt();
   cacheTimeout = settings.value("cacheTime", "60000").toInt();
-  qDebug("StaticFileController: cache timeout=%i, size=%i", cacheTimeout, cache.maxCost());
+  compress = settings.value("compress", true).toBool();
+  cache = std::make_shared<const CacheMap>();
+  qDebug("StaticFileController: cache timeout=%i, size=%i, compress=%i", cacheTimeout, maxCacheSize, compress);
+
+  // No context object since the cache is used by all connection threads - shrink() locks the cache
+  memoryBudgetId = atools::util::MemoryBudget::instance().add("Static files", atools::util::MEMORY_LOW,
+                                                              [this](qint64 bytes) {
+        shrink(bytes);
+      });
+}
+
+StaticFileController::~StaticFileController()
+{
+  atools::util::MemoryBudget::instance().remove(memoryBudgetId);
 }
 
 void StaticFileController::service(HttpRequest& request, HttpResponse& response)
 {
   QByteArray path = request.getPath();
-  // Check if we have the file in cache
+  // Check if we have the file in cache. The snapshot stays valid even if other threads replace the cache.
   qint64 now = QDateTime::currentMSecsSinceEpoch();
-  mutex.lock();
-  CacheEntry *entry = cache.object(path);
+  std::shared_ptr<const CacheMap> snapshot = std::atomic_load(&cache);
+  CacheEntryPtr entry = snapshot->value(path);
   if(entry && (cacheTimeout == 0 || entry->created > now - cacheTimeout))
   {
-    QByteArray document = entry->document;   // copy the cached document, because other threads may destroy the cached entry immediately after mutex unlock.
-    QByteArray filename = entry->filename;
-    mutex.unlock();
     qDebug("StaticFileController: Cache hit for %s", path.data());
-    setContentType(filename, response);
-    response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
-    response.write(document);
+    sendEntry(*entry, request, response);
   }
   else
   {
-    mutex.unlock();
     // The file is not in cache.
     qDebug("StaticFileController: Cache miss for %s", path.data());
     // Forbid access to files outside the docroot directory
@@ -72,31 +104,33 @@ void StaticFileController::service(HttpRequest& request, HttpResponse& response)
     qDebug("StaticFileController: Open file %s", qPrintable(file.fileName()));
     if(file.open(QIODevice::ReadOnly))
     {
-      setContentType(path, response);
-      response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
+      QFileInfo fileInfo(file);
       if(file.size() <= maxCachedFileSize)
       {
         // Return the file content and store it also in the cache
-        entry = new CacheEntry();
-        while(!file.atEnd() && !file.error())
+        std::shared_ptr<CacheEntry> newEntry = std::make_shared<CacheEntry>();
+        newEntry->document = file.readAll();
+        newEntry->brotliDocument = readVariant(file.fileName() + ".br");
+        newEntry->gzipDocument = readVariant(file.fileName() + ".gz");
+        if(newEntry->gzipDocument.isEmpty() && compress && isCompressible(path) &&
+           newEntry->document.size() >= MIN_COMPRESS_SIZE)
         {
-          QByteArray buffer = file.read(65536);
-          response.write(buffer);
-          entry->document.append(buffer);
+          QByteArray gzipped = atools::zip::gzipCompress(newEntry->document);
+          if(gzipped.size() < newEntry->document.size() * MIN_COMPRESSION_RATIO)
+          {
+            newEntry->gzipDocument = gzipped;
+          }
         }
-        entry->created = now;
-        entry->filename = path;
-        mutex.lock();
-        cache.insert(request.getPath(), entry, entry->document.size());
-        mutex.unlock();
+        newEntry->etag = createEtag(fileInfo, newEntry->document);
+        newEntry->created = now;
+        newEntry->filename = path;
+        insert(request.getPath(), newEntry);
+        sendEntry(*newEntry, request, response);
       }
       else
       {
         // Return the file content, do not store in cache
-        while(!file.atEnd() && !file.error())
-        {
-          response.write(file.read(65536));
-        }
+        sendFile(file, path, createEtag(fileInfo, QByteArray()), request, response);
       }
       file.close();
     }
@@ -117,6 +151,234 @@ void StaticFileController::service(HttpRequest& request, HttpResponse& response)
   }
 }
 
+void StaticFileController::insert(const QString& key, const CacheEntryPtr& entry)
+{
+  if(entry->cost() > maxCacheSize)
+  {
+    return;
+  }
+
+  int totalCost;
+  {
+    QMutexLocker locker(&mutex);
+
+    // Copy the current snapshot since readers might still use it
+    std::shared_ptr<CacheMap> newCache = std::make_shared<CacheMap>(*std::atomic_load(&cache));
+    newCache->insert(key, entry);
+    totalCost = removeOldest(*newCache, cacheCost(*newCache), maxCacheSize, key);
+    std::atomic_store(&cache, std::shared_ptr<const CacheMap>(newCache));
+  }
+
+  // Report outside of the lock since this might call shrink()
+  atools::util::MemoryBudget::instance().setCost(memoryBudgetId, totalCost);
+}
+
+void StaticFileController::shrink(qint64 bytes)
+{
+  int totalCost;
+  {
+    QMutexLocker locker(&mutex);
+    std::shared_ptr<CacheMap> newCache = std::make_shared<CacheMap>(*std::atomic_load(&cache));
+    int oldCost = cacheCost(*newCache);
+    totalCost = removeOldest(*newCache, oldCost, static_cast<int>(std::max(oldCost - bytes, qint64(0))), QString());
+    std::atomic_store(&cache, std::shared_ptr<const CacheMap>(newCache));
+  }
+  atools::util::MemoryBudget::instance().setCost(memoryBudgetId, totalCost);
+}
+
+int StaticFileController::cacheCost(const CacheMap& map)
+{
+  int totalCost = 0;
+  foreach(const CacheEntryPtr& cached, map)
+  {
+    totalCost += cached->cost();
+  }
+  return totalCost;
+}
+
+int StaticFileController::removeOldest(CacheMap& map, int totalCost, int maxCost, const QString& keepKey)
+{
+  // Remove the oldest entries until the cache fits
+  while(totalCost > maxCost)
+  {
+    CacheMap::iterator oldest = map.end();
+    for(CacheMap::iterator it = map.begin(); it != map.end(); ++it)
+    {
+      if(it.key() != keepKey && (oldest == map.end() || it.value()->created < oldest.value()->created))
+      {
+        oldest = it;
+      }
+    }
+    if(oldest == map.end())
+    {
+      break;
+    }
+    totalCost -= oldest.value()->cost();
+    map.erase(oldest);
+  }
+  return totalCost;
+}
+
+void StaticFileController::sendEntry(const CacheEntry& entry, HttpRequest& request, HttpResponse& response) const
+{
+  setHeaders(entry.filename, !entry.gzipDocument.isEmpty() || !entry.brotliDocument.isEmpty(), response);
+
+  // Use the best variant accepted by the client. Each variant needs its own entity tag.
+  const QByteArray *document = &entry.document;
+  QByteArray etag = entry.etag;
+  if(!entry.brotliDocument.isEmpty() && acceptsEncoding(request, "br"))
+  {
+    document = &entry.brotliDocument;
+    etag.insert(etag.size() - 1, "-br");
+    response.setHeader("Content-Encoding", "br");
+  }
+  else if(!entry.gzipDocument.isEmpty() && acceptsEncoding(request, "gzip"))
+  {
+    document = &entry.gzipDocument;
+    etag.insert(etag.size() - 1, "-gz");
+    response.setHeader("Content-Encoding", "gzip");
+  }
+
+  if(!sendNotModified(etag, request, response))
+  {
+    response.write(*document, true);
+  }
+}
+
+void StaticFileController::sendFile(QFile& file, const QByteArray& path, const QByteArray& etag,
+                                    HttpRequest& request, HttpResponse& response) const
+{
+  // Use a precompressed variant if available
+  QFile variant;
+  QByteArray variantEtag = etag;
+  if(acceptsEncoding(request, "br") && QFile::exists(file.fileName() + ".br"))
+  {
+    variant.setFileName(file.fileName() + ".br");
+    variantEtag.insert(variantEtag.size() - 1, "-br");
+  }
+  else if(acceptsEncoding(request, "gzip") && QFile::exists(file.fileName() + ".gz"))
+  {
+    variant.setFileName(file.fileName() + ".gz");
+    variantEtag.insert(variantEtag.size() - 1, "-gz");
+  }
+
+  QFile *source = &file;
+  if(!variant.fileName().isEmpty() && variant.open(QIODevice::ReadOnly))
+  {
+    source = &variant;
+    response.setHeader("Content-Encoding", variant.fileName().endsWith(".br") ? "br" : "gzip");
+  }
+  else
+  {
+    variantEtag = etag;
+  }
+
+  setHeaders(path, !variant.fileName().isEmpty(), response);
+  if(sendNotModified(variantEtag, request, response))
+  {
+    return;
+  }
+
+  // Map the file into memory and pass it to the socket without intermediate copies.
+  // Resources and special files cannot be mapped, read these in chunks.
+  qint64 size = source->size();
+  uchar *mapped = size > 0 && size < std::numeric_limits<int>::max() ? source->map(0, size) : nullptr;
+  if(mapped)
+  {
+    response.write(QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), static_cast<int>(size)), true);
+    source->unmap(mapped);
+  }
+  else
+  {
+    response.setHeader("Content-Length", size);
+    while(!source->atEnd() && !source->error())
+    {
+      response.write(source->read(65536));
+    }
+  }
+}
+
+bool StaticFileController::sendNotModified(const QByteArray& etag, HttpRequest& request,
+                                           HttpResponse& response) const
+{
+  response.setHeader("ETag", etag);
+
+  QByteArray ifNoneMatch = request.getHeader("If-None-Match");
+  if(!ifNoneMatch.isEmpty())
+  {
+    foreach(QByteArray tag, ifNoneMatch.split(','))
+    {
+      tag = tag.trimmed();
+      // Weak comparison as required for If-None-Match
+      if(tag.startsWith("W/"))
+      {
+        tag = tag.mid(2);
+      }
+      if(tag == "*" || tag == etag)
+      {
+        response.setStatus(304, "Not Modified");
+        response.write(QByteArray(), true);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void StaticFileController::setHeaders(const QByteArray& filename, bool hasVariants, HttpResponse& response) const
+{
+  setContentType(filename, response);
+  response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
+  if(hasVariants)
+  {
+    response.setHeader("Vary", "Accept-Encoding");
+  }
+}
+
+QByteArray StaticFileController::createEtag(const QFileInfo& fileInfo, const QByteArray& document)
+{
+  QDateTime lastModified = fileInfo.lastModified();
+  if(lastModified.isValid())
+  {
+    return '"' + QByteArray::number(fileInfo.size(), 16) + '-' +
+           QByteArray::number(lastModified.toMSecsSinceEpoch(), 16) + '"';
+  }
+  else
+  {
+    // Resources have no modification time
+    return '"' + QByteArray::number(document.size(), 16) + '-' + QByteArray::number(qHash(document), 16) + '"';
+  }
+}
+
+bool StaticFileController::acceptsEncoding(const HttpRequest& request, const QByteArray& encoding)
+{
+  foreach(const QByteArray& value, request.getHeader("Accept-Encoding").split(','))
+  {
+    QList<QByteArray> params = value.split(';');
+    if(params.first().trimmed().toLower() == encoding)
+    {
+      // Check for explicit rejection like "gzip;q=0"
+      for(int i = 1; i < params.size(); i++)
+      {
+        QByteArray param = params.at(i).trimmed();
+        if(param.startsWith("q=") && param.mid(2).toDouble() <= 0.)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool StaticFileController::isCompressible(const QString& fileName)
+{
+  return fileName.endsWith(".html") || fileName.endsWith(".htm") || fileName.endsWith(".css") ||
+         fileName.endsWith(".js") || fileName.endsWith(".json") || fileName.endsWith(".svg") ||
+         fileName.endsWith(".xml") || fileName.endsWith(".txt");
+}
+
 void StaticFileController::setContentType(const QString fileName, HttpResponse& response) const
 {
   if(fileName.endsWith(".png"))
@@ -6,13 +6,17 @@
 #ifndef STATICFILECONTROLLER_H
 #define STATICFILECONTROLLER_H
 
-#include <QCache>
+#include <QHash>
 #include <QMutex>
+#include <memory>
 #include "httpglobal.h"
 #include "httprequest.h"
 #include "httpresponse.h"
 #include "httprequesthandler.h"
 
+class QFile;
+class QFileInfo;
+
 namespace stefanfrings {
 
 /**
@@ -27,6 +31,7 @@ namespace stefanfrings {
  *  cacheTime=60000
  *  cacheSize=1000000
  *  maxCachedFileSize=65536
+ *  compress=true
  *  </pre></code>
  *  The path is relative to the directory of the config file. In case of windows, if the
  *  settings are in the registry, the path is relative to the current working directory.
@@ -37,6 +42,20 @@ namespace stefanfrings {
  *  drive. Large files are not cached. Files are cached as long as possible,
  *  when cacheTime=0. The maxAge value (in msec!) controls the remote browsers cache.
  *  <p>
+ *  Cached text files are additionally stored gzip compressed if compress=true and sent compressed
+ *  to clients that accept it. Precompressed files with the extension ".br" and ".gz" next to the
+ *  original file are used for the brotli and gzip variants if present. This works for cached and
+ *  large files.
+ *  <p>
+ *  All responses contain an ETag header built from file size and modification time. Requests
+ *  with a matching If-None-Match header are answered with 304 Not Modified without a body.
+ *  <p>
+ *  Large files are memory mapped and passed to the socket without copying them into
+ *  intermediate buffers.
+ *  <p>
+ *  Cache lookups do not lock. Readers get an immutable snapshot of the cache which is
+ *  replaced by a new copy when a file is added.
+ *  <p>
  *  Do not instantiate this class in each request, because this would make the file cache
  *  useless. Better create one instance during start-up and call it when the application
  *  received a related HTTP request.
@@ -61,6 +80,9 @@ public:
    */
   StaticFileController(QHash<QString, QVariant> settings, QObject *parent = nullptr);
 
+  /** Destructor */
+  virtual ~StaticFileController();
+
   /** Generates the response */
   void service(HttpRequest& request, HttpResponse& response);
 
@@ -74,25 +96,88 @@ private:
   /** Maximum age of files in the browser cache */
   int maxAge;
 
+  /** Immutable cache entry which can be shared between threads */
   struct CacheEntry
   {
     QByteArray document;
+    /** Compressed variants or empty if not available */
+    QByteArray gzipDocument, brotliDocument;
+    /** Quoted entity tag without variant suffix */
+    QByteArray etag;
     qint64 created;
     QByteArray filename;
+
+    int cost() const
+    {
+      return document.size() + gzipDocument.size() + brotliDocument.size();
+    }
+
   };
 
+  typedef std::shared_ptr<const CacheEntry> CacheEntryPtr;
+  typedef QHash<QString, CacheEntryPtr> CacheMap;
+
   /** Timeout for each cached file */
   int cacheTimeout;
 
   /** Maximum size of files in cache, larger files are not cached */
   int maxCachedFileSize;
 
-  /** Cache storage */
-  QCache<QString, CacheEntry> cache;
+  /** Maximum total size of all cached documents including compressed variants */
+  int maxCacheSize;
+
+  /** Create gzip compressed variants of text files in the cache */
+  bool compress;
+
+  /** Cache snapshot. Readers use std::atomic_load and writers replace it with std::atomic_store. */
+  std::shared_ptr<const CacheMap> cache;
 
-  /** Used to synchronize cache access for threads */
+  /** Used to synchronize threads adding files to the cache. Not needed for reading. */
   QMutex mutex;
 
+  /** Id of the cache in atools::util::MemoryBudget */
+  int memoryBudgetId;
+
+  /** Add entry and remove the oldest entries if the cache exceeds its size */
+  void insert(const QString& key, const CacheEntryPtr& entry);
+
+  /** Remove the oldest entries to free the given number of bytes. Called by the memory budget. */
+  void shrink(qint64 bytes);
+
+  /** Total size of all entries */
+  static int cacheCost(const CacheMap& map);
+
+  /**
+   *  Remove the oldest entries except keepKey until the total cost is not larger than maxCost.
+   *  @return The new total cost
+   */
+  static int removeOldest(CacheMap& map, int totalCost, int maxCost, const QString& keepKey);
+
+  /** Send the cached document or a compressed variant of it */
+  void sendEntry(const CacheEntry& entry, HttpRequest& request, HttpResponse& response) const;
+
+  /** Send a large file from disk which is not cached */
+  void sendFile(QFile& file, const QByteArray& path, const QByteArray& etag, HttpRequest& request,
+                HttpResponse& response) const;
+
+  /**
+   *  Sets the ETag header and sends 304 Not Modified if the request contains a matching If-None-Match header.
+   *  @return true if 304 was sent
+   */
+  bool sendNotModified(const QByteArray& etag, HttpRequest& request, HttpResponse& response) const;
+
+  /** Sets Content-Type, Cache-Control and Vary headers */
+  void setHeaders(const QByteArray& filename, bool hasVariants, HttpResponse& response) const;
+
+  /** Entity tag built from size and modification time of the file or from the content if not available */
+  static QByteArray createEtag(const QFileInfo& fileInfo, const QByteArray& document);
+
+  /** true if the Accept-Encoding header contains the encoding without q=0 */
+  static bool acceptsEncoding(const HttpRequest& request, const QByteArray& encoding);
+
+  /** true if the file type benefits from compression */
+  static bool isCompressible(const QString& fileName);
+
   /** Set a content-type header in the response depending on the ending of the filename */
   void setContentType(const QString file, HttpResponse& response) const;
 
@@ -19,7 +19,7 @@
 #include "exception.h"
 
 #include <QDebug>
-#include <QTextStream>
+#include <QTextCodec>
 #include <QIODevice>
 #include <QFile>
 
@@ -47,22 +47,19 @@ void AbstractIniReader::handleComment()
 
 void AbstractIniReader::handleKeyValue()
 {
-  QString name, value;
-
-  int c = currentLine.indexOf('=');
+  int c = currentLine.indexOf(QLatin1Char('='));
   if(c >= 0)
   {
-    name = changeCase(currentLine.left(c));
+    QString name = changeCase(currentLine.left(c));
     if(name.isEmpty())
       qWarning() << "Missing key name before \"=\":" << currentLine;
     else
     {
-      value = currentLine.mid(c + 1);
+      QString value = currentLine.mid(c + 1).toString();
 
       // Call both - implementor can choose to ignore one
       onKeyValue(currentSection, currentSectionSuffix, name, value);
-      onKeyValue(currentSection + (currentSectionSuffix.isEmpty() ?
-                                   QString() : "." + currentSectionSuffix), name, value);
+      onKeyValue(currentSectionFull, name, value);
     }
   }
   else
@@ -71,9 +68,9 @@ void AbstractIniReader::handleKeyValue()
 
 void AbstractIniReader::handleSection()
 {
-  QString tempSection, tempSectionSuffix;
+  QStringRef tempSection, tempSectionSuffix;
 
-  if(currentLine.at(currentLine.size() - 1) == ']')
+  if(currentLine.at(currentLine.size() - 1) == QLatin1Char(']'))
     tempSection = currentLine.mid(1, currentLine.size() - 2);
   else
   {
@@ -81,18 +78,16 @@ void AbstractIniReader::handleSection()
     qWarning() << "Missing closing \"]\":" << currentLine;
   }
 
-  int dotPos = tempSection.indexOf('.');
+  int dotPos = tempSection.indexOf(QLatin1Char('.'));
   if(dotPos >= 0)
   {
-    QString sectPrefix = changeCase(tempSection.mid(0, dotPos));
-    if(sectPrefix.isEmpty())
-      qWarning() << "Missing section name before \".\":" << currentLine;
+    tempSectionSuffix = tempSection.mid(dotPos + 1);
+    tempSection = tempSection.left(dotPos);
 
-    tempSectionSuffix = changeCase(tempSection.mid(dotPos + 1));
+    if(tempSection.isEmpty())
+      qWarning() << "Missing section name before \".\":" << currentLine;
     if(tempSectionSuffix.isEmpty())
       qWarning() << "Missing section suffix after \".\":" << currentLine;
-
-    tempSection = sectPrefix;
   }
 
   if(!currentSection.isEmpty())
@@ -100,6 +95,7 @@ void AbstractIniReader::handleSection()
 
   currentSection = changeCase(tempSection);
   currentSectionSuffix = changeCase(tempSectionSuffix);
+  currentSectionFull = currentSectionSuffix.isEmpty() ? currentSection : currentSection + "." + currentSectionSuffix;
   onStartSection(currentSection, currentSectionSuffix);
 }
 
@@ -107,6 +103,7 @@ void AbstractIniReader::read(const QString& iniFilename)
 {
   currentSection.clear();
   currentSectionSuffix.clear();
+  currentSectionFull.clear();
   currentLine.clear();
   currentLineNum = 0;
 
@@ -114,19 +111,32 @@ void AbstractIniReader::read(const QString& iniFilename)
 
   QFile sceneryCfgFile(filepath);
 
-  if(sceneryCfgFile.open(QIODevice::ReadOnly | QIODevice::Text))
+  if(sceneryCfgFile.open(QIODevice::ReadOnly))
   {
-    QTextStream sceneryCfg(&sceneryCfgFile);
+    QTextCodec *textCodec = codec.isEmpty() ? QTextCodec::codecForLocale() : QTextCodec::codecForName(codec.toLatin1());
+    if(textCodec == nullptr)
+    {
+      qWarning() << Q_FUNC_INFO << "Unknown codec" << codec;
+      textCodec = QTextCodec::codecForLocale();
+    }
 
-    if(!codec.isEmpty())
-      sceneryCfg.setCodec(codec.toLatin1().constData());
+    // Decode all at once - a byte order mark overrides the codec like in QTextStream
+    const QByteArray bytes = sceneryCfgFile.readAll();
+    sceneryCfgFile.close();
+    const QString text = QTextCodec::codecForUtfText(bytes, textCodec)->toUnicode(bytes);
 
     onStartDocument(filepath);
 
-    currentLine.clear();
-    while(sceneryCfg.readLineInto(&currentLine, 1024))
+    int pos = 0;
+    while(pos < text.size())
     {
-      currentLine = currentLine.trimmed();
+      int end = text.indexOf(QLatin1Char('\n'), pos);
+      if(end == -1)
+        end = text.size();
+
+      // Trimming removes the carriage return too
+      currentLine = text.midRef(pos, end - pos).trimmed();
+      pos = end + 1;
       currentLineNum++;
 
       handleComment();
@@ -134,17 +144,17 @@ void AbstractIniReader::read(const QString& iniFilename)
       if(currentLine.isEmpty())
         continue;
 
-      if(currentLine.at(0) == '[')
+      if(currentLine.at(0) == QLatin1Char('['))
         handleSection();
       else
         handleKeyValue();
     }
+    currentLine.clear();
 
     if(!currentSection.isEmpty())
       onEndSection(currentSection, currentSectionSuffix);
 
     onEndDocument(filepath);
-    sceneryCfgFile.close();
   }
   else
     throw Exception(tr("Cannot open file %1. Reason: %2").arg(iniFilename).arg(sceneryCfgFile.errorString()));
@@ -191,17 +201,27 @@ void AbstractIniReader::onKeyValue(const QString& section, const QString& key, c
 void AbstractIniReader::throwException(const QString& message)
 {
   throw Exception(tr("%1. File \"%2\", line %3:\"%4\"").
-                  arg(message).arg(filepath).arg(currentLineNum).arg(currentLine));
+                  arg(message).arg(filepath).arg(currentLineNum).arg(currentLine.toString()));
 }
 
 bool AbstractIniReader::toBool(const QString& str)
 {
-  QString tmp = str.toLower().trimmed();
+  static const QLatin1String TRUE_VALUES[] = {QLatin1String("true"), QLatin1String("t"), QLatin1String("y"),
+                                              QLatin1String("yes"), QLatin1String("1")};
+  static const QLatin1String FALSE_VALUES[] = {QLatin1String("false"), QLatin1String("f"), QLatin1String("n"),
+                                               QLatin1String("no"), QLatin1String("0")};
 
-  if(tmp == "true" || tmp == "t" || tmp == "y" || tmp == "yes" || tmp == "1")
-    return true;
-  else if(tmp == "false" || tmp == "f" || tmp == "n" || tmp == "no" || tmp == "0")
-    return false;
+  const QStringRef tmp = QStringRef(&str).trimmed();
+  for(const QLatin1String& value : TRUE_VALUES)
+  {
+    if(tmp.compare(value, Qt::CaseInsensitive) == 0)
+      return true;
+  }
+  for(const QLatin1String& value : FALSE_VALUES)
+  {
+    if(tmp.compare(value, Qt::CaseInsensitive) == 0)
+      return false;
+  }
 
   qWarning() << "Boolean value not valid in scenery area line" << currentLineNum << "file" << filepath;
   return false;
@@ -217,9 +237,9 @@ int AbstractIniReader::toInt(const QString& str)
   return retval;
 }
 
-QString AbstractIniReader::changeCase(const QString& str)
+QString AbstractIniReader::changeCase(const QStringRef& str)
 {
-  return preserveCase ? str : str.toLower();
+  return preserveCase ? str.toString() : str.toString().toLower();
 }
 
 } // namespace io
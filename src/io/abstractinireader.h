@@ -27,6 +27,9 @@ namespace io {
 /*
  * Abstract class that can read ini files and supports numbered sections like [area.001].
  * Line comments starting with ";" are supported per default.
+ *
+ * The file is read and decoded at once and split into lines, sections, keys and values in place.
+ * Strings are only created for the names and values passed to the on* methods.
  */
 class AbstractIniReader
 {
@@ -111,12 +114,17 @@ protected:
 
 private:
   int currentLineNum;
-  QString currentLine, currentSection, currentSectionSuffix;
+
+  /* Line of the file buffer which is only valid while reading */
+  QStringRef currentLine;
+
+  /* Section name including suffix like "area.001" - built once per section */
+  QString currentSection, currentSectionSuffix, currentSectionFull;
 
   void handleComment();
   void handleKeyValue();
   void handleSection();
-  QString changeCase(const QString& str);
+  QString changeCase(const QStringRef& str);
 
   QString codec;
   QStringList commentCharacters;
@@ -22,6 +22,8 @@
 #include <QUuid>
 #include "exception.h"
 
+#include <algorithm>
+
 namespace atools {
 namespace io {
 
@@ -29,31 +31,48 @@ namespace io {
  * Big endian 1A2B3C4D = 1A 2B 3C 4D in mem
  * Little endian 1A2B3C4D =  4D 3C 2B 1A in mem
  */
-BinaryStream::BinaryStream(QFile *binaryFile, QDataStream::ByteOrder order)
+BinaryStream::BinaryStream(QFile *binaryFile, QDataStream::ByteOrder order, bool memoryMapped)
   : file(binaryFile)
 {
-  this->is = new QDataStream(file);
-  this->is->setByteOrder(order);
-  checkStream("constructor");
+  if(memoryMapped && order == QDataStream::LittleEndian && file->isOpen())
+  {
+    mappedSize = file->size();
+    if(mappedSize > 0)
+      mapped = file->map(0, mappedSize);
+
+    if(mapped == nullptr && mappedSize > 0)
+      qWarning() << Q_FUNC_INFO << "Cannot map file" << file->fileName() << file->errorString()
+                 << "Falling back to stream";
+  }
+
+  if(mapped == nullptr)
+  {
+    mappedSize = 0;
+    this->is = new QDataStream(file);
+    this->is->setByteOrder(order);
+    checkStream("constructor");
+  }
 }
 
 BinaryStream::~BinaryStream()
 {
+  if(mapped != nullptr && file->isOpen())
+    file->unmap(const_cast<uchar *>(mapped));
   delete is;
 }
 
-quint32 BinaryStream::readUInt()
+int BinaryStream::readBytes(char bytes[], int size)
 {
-  quint32 retval;
-  (*is) >> retval;
-
-  checkStream("readInt");
+  if(mapped != nullptr)
+  {
+    if(mappedPos + size > mappedSize)
+      throwReadPastEnd("readBytes");
 
-  return retval;
-}
+    std::memcpy(bytes, mapped + mappedPos, static_cast<size_t>(size));
+    mappedPos += size;
+    return size;
+  }
 
-int BinaryStream::readBytes(char bytes[], int size)
-{
   int numRead = is->readRawData(bytes, size);
   checkStream("readBytes");
   return numRead;
@@ -73,18 +92,34 @@ QUuid BinaryStream::readUuid()
 
 qint64 BinaryStream::tellg() const
 {
+  if(mapped != nullptr)
+    return mappedPos;
+
   checkStream("tellg");
   return is->device()->pos();
 }
 
 void BinaryStream::skip(qint64 bytes)
 {
+  if(mapped != nullptr)
+  {
+    // Position beyond the end is allowed like for QIODevice and fails on the next read
+    mappedPos = std::max(mappedPos + bytes, 0LL);
+    return;
+  }
+
   checkStream("skip");
   is->device()->seek(tellg() + bytes);
 }
 
 void BinaryStream::seekg(qint64 pos)
 {
+  if(mapped != nullptr)
+  {
+    mappedPos = std::max(pos, 0LL);
+    return;
+  }
+
   checkStream("seekg");
   is->device()->seek(pos);
 }
@@ -99,71 +134,6 @@ QString BinaryStream::getFilename() const
   return file->fileName();
 }
 
-float BinaryStream::readFloat()
-{
-  union
-  {
-    int intValue;
-    float floatValue;
-  } u;
-
-  u.intValue = readInt();
-
-  checkStream("readFloat");
-
-  return u.floatValue;
-}
-
-quint16 BinaryStream::readUShort()
-{
-  quint16 retval;
-  (*is) >> retval;
-
-  checkStream("readShort");
-
-  return retval;
-}
-
-quint8 BinaryStream::readUByte()
-{
-  quint8 retval;
-  (*is) >> retval;
-
-  checkStream("readByte");
-
-  return retval;
-}
-
-qint32 BinaryStream::readInt()
-{
-  qint32 retval;
-  (*is) >> retval;
-
-  checkStream("readInt");
-
-  return retval;
-}
-
-qint16 BinaryStream::readShort()
-{
-  qint16 retval;
-  (*is) >> retval;
-
-  checkStream("readShort");
-
-  return retval;
-}
-
-qint8 BinaryStream::readByte()
-{
-  qint8 retval;
-  (*is) >> retval;
-
-  checkStream("readByte");
-
-  return retval;
-}
-
 QChar BinaryStream::readChar()
 {
   return QChar::fromLatin1(readByte());
@@ -172,14 +142,29 @@ QChar BinaryStream::readChar()
 QString BinaryStream::readString(Encoding encoding)
 {
   QByteArray retval;
-  char c = 0;
-  do
+  if(mapped != nullptr)
   {
-    c = readByte();
-    retval.append(c);
-  } while(c != '\0');
-
-  checkStream("readString");
+    // Find terminating NUL in mapped memory and copy string at once
+    qint64 remaining = std::max(mappedSize - mappedPos, 0LL);
+    const void *end = std::memchr(mapped + mappedPos, '\0', static_cast<size_t>(remaining));
+    if(end == nullptr)
+      throwReadPastEnd("readString");
+
+    qint64 length = static_cast<const uchar *>(end) - (mapped + mappedPos);
+    retval = QByteArray(reinterpret_cast<const char *>(mapped + mappedPos), static_cast<int>(length));
+    mappedPos += length + 1;
+  }
+  else
+  {
+    char c = 0;
+    do
+    {
+      c = readByte();
+      retval.append(c);
+    } while(c != '\0');
+
+    checkStream("readString");
+  }
 
   if(encoding == UTF8)
     return QString::fromUtf8(retval);
@@ -211,9 +196,18 @@ QString BinaryStream::readString(int length, Encoding encoding)
     return QString::fromLocal8Bit(retval);
 }
 
+void BinaryStream::throwReadPastEnd(const char *what) const
+{
+  QString msg = QString("%1 for file \"%2\" failed. Reason %3").
+                arg(what).arg(getFilename()).arg(QDataStream::ReadPastEnd);
+
+  qWarning() << msg << "Position" << hex << "0x" << mappedPos << dec << mappedPos;
+  throw Exception(msg);
+}
+
 void BinaryStream::checkStream(const QString& what) const
 {
-  if(is->status() != QDataStream::Ok)
+  if(is != nullptr && is->status() != QDataStream::Ok)
   {
     QString msg = QString("%1 for file \"%2\" failed. Reason %3").arg(what).arg(getFilename()).arg(is->status());
 
@@ -19,6 +19,9 @@
 #define ATOOLS_IO_BINARYSTREAM_H
 
 #include <QDataStream>
+#include <QtEndian>
+
+#include <cstring>
 
 class QFile;
 
@@ -35,22 +38,54 @@ enum Encoding
  * Simple wrapper for binary file reading around QDataStream
  * that will throw an Exception in case of
  * errors.
+ *
+ * Optionally reads from a memory mapped file which avoids a call into QDataStream and QIODevice for each value.
+ * Falls back to QDataStream if the file cannot be mapped or byte order is not little endian.
  */
 class BinaryStream
 {
 public:
-  BinaryStream(QFile *binaryFile, QDataStream::ByteOrder order = QDataStream::LittleEndian);
+  /* Reads from a memory mapped file if memoryMapped is true. File has to be opened before. */
+  BinaryStream(QFile *binaryFile, QDataStream::ByteOrder order = QDataStream::LittleEndian, bool memoryMapped = false);
   virtual ~BinaryStream();
 
-  qint8 readByte();
-  qint16 readShort();
-  qint32 readInt();
-
-  quint8 readUByte();
-  quint16 readUShort();
-  quint32 readUInt();
-
-  float readFloat();
+  qint8 readByte()
+  {
+    return mapped != nullptr ? static_cast<qint8>(readMapped<quint8>("readByte")) : readStream<qint8>("readByte");
+  }
+
+  qint16 readShort()
+  {
+    return mapped != nullptr ? readMapped<qint16>("readShort") : readStream<qint16>("readShort");
+  }
+
+  qint32 readInt()
+  {
+    return mapped != nullptr ? readMapped<qint32>("readInt") : readStream<qint32>("readInt");
+  }
+
+  quint8 readUByte()
+  {
+    return mapped != nullptr ? readMapped<quint8>("readByte") : readStream<quint8>("readByte");
+  }
+
+  quint16 readUShort()
+  {
+    return mapped != nullptr ? readMapped<quint16>("readShort") : readStream<quint16>("readShort");
+  }
+
+  quint32 readUInt()
+  {
+    return mapped != nullptr ? readMapped<quint32>("readInt") : readStream<quint32>("readInt");
+  }
+
+  float readFloat()
+  {
+    quint32 intValue = readUInt();
+    float floatValue;
+    std::memcpy(&floatValue, &intValue, sizeof(floatValue));
+    return floatValue;
+  }
 
   /* reads a null terminated latin-1 or UTF-8 string and also stops reading at NUL */
   QString readString(Encoding encoding);
@@ -74,11 +109,44 @@ public:
   qint64 getFileSize() const;
   QString getFilename() const;
 
+  /* true if reading from a memory mapped file */
+  bool isMemoryMapped() const
+  {
+    return mapped != nullptr;
+  }
+
 private:
   void checkStream(const QString& what) const;
 
-  QDataStream *is;
+  /* Throws exception with the same message as checkStream() for read past end */
+  [[noreturn]] void throwReadPastEnd(const char *what) const;
+
+  template<typename TYPE>
+  TYPE readStream(const char *what)
+  {
+    TYPE retval;
+    (*is) >> retval;
+    checkStream(what);
+    return retval;
+  }
+
+  template<typename TYPE>
+  TYPE readMapped(const char *what)
+  {
+    if(Q_UNLIKELY(mappedPos + static_cast<qint64>(sizeof(TYPE)) > mappedSize))
+      throwReadPastEnd(what);
+
+    TYPE retval = qFromLittleEndian<TYPE>(mapped + mappedPos);
+    mappedPos += static_cast<qint64>(sizeof(TYPE));
+    return retval;
+  }
+
+  QDataStream *is = nullptr;
   QFile *file;
+
+  /* Mapped file content or null if stream is used */
+  const uchar *mapped = nullptr;
+  qint64 mappedSize = 0, mappedPos = 0;
 };
 
 } /* namespace io */
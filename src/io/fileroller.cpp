@@ -16,15 +16,55 @@
 *****************************************************************************/
 
 #include "io/fileroller.h"
+#include "zip/gzip.h"
 
+#include <QDateTime>
+#include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QRunnable>
 #include <QStringList>
+#include <QThreadPool>
+
+#include <atomic>
 
 namespace atools {
 namespace io {
 
+/* Single thread pool to run all background rolls in order. Not deleted to avoid issues with destruction order. */
+static QThreadPool *rollerPool()
+{
+  static QThreadPool *pool = [] () -> QThreadPool *
+                             {
+                               QThreadPool *threadPool = new QThreadPool;
+                               threadPool->setMaxThreadCount(1);
+                               return threadPool;
+                             } ();
+  return pool;
+}
+
+/* Runs compression in the background on a copy of the roller */
+class FileRollerRunnable :
+  public QRunnable
+{
+public:
+  FileRollerRunnable(const FileRoller& fileRoller, const QString& pendingFilename, const QString& filenameParam)
+    : roller(fileRoller), pending(pendingFilename), filename(filenameParam)
+  {
+    setAutoDelete(true);
+  }
+
+  virtual void run() override
+  {
+    roller.rollCompressed(pending, filename);
+  }
+
+private:
+  FileRoller roller;
+  QString pending, filename;
+};
+
 FileRoller::FileRoller(int maxNumFiles)
   : maxFiles(maxNumFiles)
 {
@@ -45,24 +85,109 @@ void FileRoller::rollFiles(const QStringList& filenames)
 
 void FileRoller::rollFile(const QString& filename)
 {
-  for(int i = maxFiles; i >= 1; --i)
+  if(maxFiles <= 0)
+    return;
+
+  if(compress)
   {
-    QFile oldFile(buildFilename(filename, i));
-    QFile newFile(buildFilename(filename, i + 1));
+    // Move file out of the way quickly using a unique name and leave all other work to the background thread
+    static std::atomic<int> counter(0);
+    QString pending = filename + "." + QString::number(QDateTime::currentMSecsSinceEpoch()) + "-" +
+                      QString::number(counter.fetch_add(1)) + ".rolling";
+    if(QFile(filename).rename(pending))
+      rollerPool()->start(new FileRollerRunnable(*this, pending, filename));
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot rename" << filename;
+  }
+  else
+  {
+    shiftBackups(filename);
+    renameSafe(filename, buildFilename(filename, 1));
+    removeExceedingBackups(filename);
+  }
+}
+
+void FileRoller::waitForBackgroundTasks()
+{
+  rollerPool()->waitForDone();
+}
 
-    if(oldFile.exists())
+void FileRoller::shiftBackups(const QString& filename)
+{
+  for(int i = maxFiles; i >= 1; --i)
+  {
+    // Shift plain and compressed backups
+    for(const QString& suffix : {QString(), QString(".gz")})
     {
-      if(i == maxFiles)
-        // Remove oldest
-        oldFile.remove();
-      else
-        // Move all other to higher number
-        renameSafe(oldFile.fileName(), newFile.fileName());
+      QFile oldFile(buildFilename(filename, i) + suffix);
+      QFile newFile(buildFilename(filename, i + 1) + suffix);
+
+      if(oldFile.exists())
+      {
+        if(i == maxFiles)
+          // Remove oldest
+          oldFile.remove();
+        else
+          // Move all other to higher number
+          renameSafe(oldFile.fileName(), newFile.fileName());
+      }
     }
   }
+}
 
-  if(maxFiles > 0)
-    renameSafe(filename, buildFilename(filename, 1));
+void FileRoller::rollCompressed(const QString& pendingFilename, const QString& filename)
+{
+  shiftBackups(filename);
+
+  QString backup = buildFilename(filename, 1);
+  QFile input(pendingFilename);
+  QFile output(backup + ".gz");
+  bool ok = false;
+  if(input.open(QIODevice::ReadOnly) && output.open(QIODevice::WriteOnly))
+  {
+    // Stream in chunks to avoid loading huge log files into memory
+    atools::zip::GzipWriter writer(&output);
+    ok = true;
+    while(ok && !input.atEnd())
+      ok = writer.write(input.read(1024 * 1024));
+    ok = writer.close() && ok;
+    output.close();
+    input.close();
+  }
+
+  if(ok)
+    input.remove();
+  else
+  {
+    // Keep uncompressed backup
+    qWarning() << Q_FUNC_INFO << "Cannot compress" << pendingFilename << input.errorString() << output.errorString();
+    output.remove();
+    renameSafe(pendingFilename, backup);
+  }
+
+  removeExceedingBackups(filename);
+}
+
+void FileRoller::removeExceedingBackups(const QString& filename)
+{
+  if(maxTotalSize <= 0)
+    return;
+
+  // Sum up from newest to oldest and remove all backups once the budget is exceeded
+  qint64 total = 0;
+  for(int i = 1; i <= maxFiles; i++)
+  {
+    for(const QString& suffix : {QString(), QString(".gz")})
+    {
+      QFileInfo backup(buildFilename(filename, i) + suffix);
+      if(backup.exists())
+      {
+        total += backup.size();
+        if(total > maxTotalSize && i > 1)
+          QFile::remove(backup.filePath());
+      }
+    }
+  }
 }
 
 QString FileRoller::buildFilename(const QString& filename, int num) const
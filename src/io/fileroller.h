@@ -28,6 +28,12 @@ namespace io {
 
 /*
  * Creates numbered backups from e.g. log files.
+ *
+ * Backups can optionally be compressed to "file.log.1.gz" and so on. Compression is done in a background
+ * thread and rollFile() returns after renaming the file. All background rolls are done one after the other.
+ *
+ * A total size budget for all backups removes the oldest backups until the sum of sizes fits.
+ * The newest backup is always kept.
  */
 class FileRoller
 {
@@ -61,11 +67,39 @@ public:
    */
   void rollFiles(const QStringList& filenames);
 
+  /* Compress backups with GZIP in a background thread. Adds ".gz" to the backup filenames. */
+  void setCompress(bool value)
+  {
+    compress = value;
+  }
+
+  /* Maximum size in bytes for all backups of a file. 0 or negative for no limit. */
+  void setMaxTotalSize(qint64 bytes)
+  {
+    maxTotalSize = bytes;
+  }
+
+  /* Wait until all background compression is finished. Call before exiting the application. */
+  static void waitForBackgroundTasks();
+
 private:
+  friend class FileRollerRunnable;
+
   void renameSafe(const QString& oldFile, const QString& newFile) const;
   QString buildFilename(const QString& filename, int num) const;
 
+  /* Shift all numbered backups including compressed ones by one and remove the oldest */
+  void shiftBackups(const QString& filename);
+
+  /* Called in background thread. Shifts backups and compresses the renamed file into backup number one. */
+  void rollCompressed(const QString& pendingFilename, const QString& filename);
+
+  /* Remove oldest backups exceeding the budget */
+  void removeExceedingBackups(const QString& filename);
+
   int maxFiles = 0;
+  bool compress = false;
+  qint64 maxTotalSize = 0;
 
   // "${base}${sep}${num}.${ext}"
   QString pattern = "${base}.${ext}.${num}";
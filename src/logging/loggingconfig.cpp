@@ -89,6 +89,9 @@ LoggingConfig::~LoggingConfig()
 
   // Delete channels
   qDeleteAll(channels);
+
+  // Finish compression of rolled files
+  io::FileRoller::waitForBackgroundTasks();
 }
 
 void LoggingConfig::closeStreams(QSet<Channel *>& channels, const ChannelMap& channelMap)
@@ -164,6 +167,14 @@ void LoggingConfig::collectFileNames(QSet<QString>& filenames, const ChannelVect
   }
 }
 
+void LoggingConfig::rollFile(const QString& filename)
+{
+  io::FileRoller roller(maximumBackupFiles);
+  roller.setCompress(compressBackups);
+  roller.setMaxTotalSize(maximumTotalBackupSizeBytes);
+  roller.rollFile(filename);
+}
+
 void LoggingConfig::checkStreamSize(Channel *channel)
 {
   // This needs to be called withing mutex lock
@@ -182,7 +193,7 @@ void LoggingConfig::checkStreamSize(Channel *channel)
     channel->file = nullptr;
 
     // Backup and delete log
-    io::FileRoller(maximumBackupFiles).rollFile(filename);
+    rollFile(filename);
 
     // Create new log file
     QFile *file = new QFile(filename);
@@ -297,6 +308,9 @@ void LoggingConfig::readConfigurationSection(QSettings *settings)
   narrow = settings->value("configuration/narrow").toBool();
 #endif
 
+  async = settings->value("configuration/async", false).toBool();
+  asyncQueueSize = settings->value("configuration/asyncqueuesize", 10000).toInt();
+
   QString filesParameter = settings->value("configuration/files").toString();
   if(filesParameter == "truncate" || filesParameter == "roll")
     mode = QIODevice::WriteOnly | QIODevice::Text;
@@ -315,6 +329,8 @@ void LoggingConfig::readConfigurationSection(QSettings *settings)
 
   rolling = settings->value("configuration/files").toString() == "roll";
   maximumBackupFiles = settings->value("configuration/maxfiles").toInt();
+  compressBackups = settings->value("configuration/compress", false).toBool();
+  maximumTotalBackupSizeBytes = settings->value("configuration/maxtotalsize").toLongLong();
 
   QString abortOn = settings->value("configuration/abort", QVariant("fatal")).toString();
   if(abortOn == "warning")
@@ -373,7 +389,7 @@ void LoggingConfig::readChannels(QSettings *settings, QHash<QString, Channel *>&
 
       if(rolling && maximumFileSizeBytes <= 0)
         // Create log file backups
-        io::FileRoller(maximumBackupFiles).rollFile(filename);
+        rollFile(filename);
 
       QFile *file = new QFile(filename);
       if(file->open(mode))
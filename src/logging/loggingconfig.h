@@ -31,6 +31,7 @@ namespace atools {
 namespace logging {
 class LoggingHandler;
 namespace internal {
+class LoggingWriter;
 
 /* Internal logging class that reads the configuration and sets up all the
  * streams. */
@@ -42,6 +43,7 @@ public:
 
 private:
   friend class atools::logging::LoggingHandler;
+  friend class atools::logging::internal::LoggingWriter;
 
   /* get a list of log files (excluding stdout and stderr) */
   QStringList getLogFiles();
@@ -107,6 +109,9 @@ private:
   /* Check if file size exceeds limit. Rolls files, creates a new one and replaces device in text stream */
   void checkStreamSize(Channel *channel);
 
+  /* Create backups of the file using the backup settings */
+  void rollFile(const QString& filename);
+
   QIODevice::OpenMode mode = QIODevice::NotOpen;
   bool rolling = false;
   int maximumBackupFiles = 0;
@@ -114,9 +119,17 @@ private:
   /* 0 of -1 if not used */
   qint64 maximumFileSizeBytes = 0;
 
+  /* Compress backups in background and limit the size of all backups of a file. 0 if not used. */
+  bool compressBackups = false;
+  qint64 maximumTotalBackupSizeBytes = 0;
+
   /* Shorten file and method names if true. */
   bool narrow = false;
 
+  /* Write messages in a background thread. Queue size limits the number of debug and info messages waiting. */
+  bool async = false;
+  int asyncQueueSize = 10000;
+
   QString logConfig, logDir, logPrefix;
 
   // Messages of this type or worse cause a call to abort()
@@ -52,6 +52,9 @@ void LoggingGuiAbortHandler::guiAbortFunction(const QString& msg)
                          arg(atools::gui::Application::getReportPathHtml())
                          );
 
+  // Write messages logged while the dialog was shown
+  LoggingHandler::flush();
+
 #ifdef Q_OS_WIN32
   // Will not call any crash handler on windows - is not helpful anyway
   std::exit(1);
@@ -17,6 +17,8 @@
 
 #include "logging/logginghandler.h"
 #include "logging/loggingconfig.h"
+#include "logging/loggingwriter.h"
+#include "util/trace.h"
 
 #include <QDebug>
 #include <QDir>
@@ -38,8 +40,12 @@ LoggingHandler::LoggingHandler(const QString& logConfiguration,
                                const QString& logDirectory,
                                const QString& logFilePrefix)
 {
+  ATOOLS_TRACE_SCOPE("LoggingHandler::LoggingHandler", "startup");
   logConfig = new LoggingConfig(logConfiguration, logDirectory, logFilePrefix);
 
+  if(logConfig->async)
+    writer = new internal::LoggingWriter(logConfig, logConfig->asyncQueueSize);
+
   // Override category filter since some systems disable debug logging in the qtlogging.ini
   oldCategoryFilter = QLoggingCategory::installFilter(categoryFilter);
 
@@ -54,6 +60,9 @@ LoggingHandler::~LoggingHandler()
 {
   qInstallMessageHandler(oldMessageHandler);
   QLoggingCategory::installFilter(oldCategoryFilter);
+
+  // Write all remaining messages before closing the files
+  delete writer;
   delete logConfig;
 }
 
@@ -106,6 +115,12 @@ QStringList LoggingHandler::getLogFiles()
     return QStringList();
 }
 
+void LoggingHandler::flush()
+{
+  if(instance != nullptr && instance->writer != nullptr)
+    instance->writer->flush();
+}
+
 void LoggingHandler::setLogFunction(LoggingHandler::LogFunctionType loggingFunction)
 {
   logFunc = loggingFunction;
@@ -126,10 +141,27 @@ void LoggingHandler::resetAbortFunction()
   parentWidget = nullptr;
 }
 
-void LoggingHandler::logToCatChannels(internal::ChannelMap& streamListCat,
+void LoggingHandler::logToCatChannels(QtMsgType type, internal::ChannelMap& streamListCat,
                                       internal::ChannelVector& streamList, const QString& message,
                                       const QString& category)
 {
+  if(writer != nullptr)
+  {
+    // Asynchronous mode - channel lists do not change while logging
+    if(category.isEmpty())
+    {
+      if(!streamList.isEmpty())
+        writer->push(type, message, &streamList);
+    }
+    else
+    {
+      internal::ChannelMap::const_iterator it = streamListCat.constFind(category);
+      if(it != streamListCat.constEnd() && !it.value().isEmpty())
+        writer->push(type, message, &it.value());
+    }
+    return;
+  }
+
   mutex.lock();
 
   if(category.isEmpty())
@@ -176,6 +208,9 @@ void LoggingHandler::checkAbortType(QtMsgType type, const QMessageLogContext& co
 
   if(doAbort)
   {
+    // Make sure the message causing the abort is written
+    flush();
+
     if(abortFunc)
       abortFunc(type, context, msg);
     else
@@ -194,7 +229,7 @@ void LoggingHandler::messageHandler(QtMsgType type, const QMessageLogContext& co
   if(category == DEFAULT)
     category.clear();
 
-  instance->logToCatChannels(instance->logConfig->getCatStream(type),
+  instance->logToCatChannels(type, instance->logConfig->getCatStream(type),
                              instance->logConfig->getStream(type),
                              qFormatLogMessage(type, context, msg),
                              category);
@@ -284,7 +319,7 @@ void LoggingHandler::messageHandlerNarrow(QtMsgType type, const QMessageLogConte
   if(category == DEFAULT)
     category.clear();
 
-  instance->logToCatChannels(instance->logConfig->getCatStream(type),
+  instance->logToCatChannels(type, instance->logConfig->getCatStream(type),
                              instance->logConfig->getStream(type),
                              qFormatLogMessage(type, ctx, message),
                              category);
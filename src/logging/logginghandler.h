@@ -34,6 +34,7 @@ namespace atools {
 namespace logging {
 namespace internal {
 class LoggingConfig;
+class LoggingWriter;
 }
 
 class LoggingGuiAbortHandler;
@@ -53,7 +54,11 @@ class LoggingGuiAbortHandler;
  *
  * files = roll
  * maxfiles = 2
+ * compress = true
+ * maxtotalsize = 1000000000
  * abort = fatal
+ * async = true
+ * asyncqueuesize = 10000
  *
  * [channels]
  * console     = stdio
@@ -67,6 +72,12 @@ class LoggingGuiAbortHandler;
  * critical.default = console-err,log
  * fatal.default    = console-err,log
  *
+ * If compress is true rolled log files are compressed to ".gz" files in a background thread.
+ * maxtotalsize limits the size in bytes of all rolled files of a log by removing the oldest ones.
+ *
+ * If async is true messages are formatted on the calling thread and written by a background thread.
+ * Debug and info messages are dropped if more than asyncqueuesize messages are waiting.
+ * All pending messages are written before an abort.
  */
 class LoggingHandler :
   public QObject
@@ -107,6 +118,9 @@ public:
    */
   static QStringList getLogFiles();
 
+  /* Wait until all messages are written in asynchronous mode. Does nothing in synchronous mode. */
+  static void flush();
+
   typedef std::function<void (QtMsgType type, const QMessageLogContext& context, const QString& msg)> LogFunctionType;
   /* Function will be called on the calling thread context */
   static void setLogFunction(LogFunctionType loggingFunction);
@@ -128,7 +142,7 @@ private:
   LoggingHandler(const QString& logConfiguration, const QString& logDirectory, const QString& logFilePrefix);
   ~LoggingHandler();
 
-  void logToCatChannels(atools::logging::internal::ChannelMap& streamListCat,
+  void logToCatChannels(QtMsgType type, atools::logging::internal::ChannelMap& streamListCat,
                         atools::logging::internal::ChannelVector& streamList,
                         const QString& message, const QString& category = QString());
 
@@ -141,6 +155,9 @@ private:
   static LoggingHandler *instance;
 
   atools::logging::internal::LoggingConfig *logConfig;
+
+  /* Writer thread if asynchronous mode is enabled - otherwise null */
+  atools::logging::internal::LoggingWriter *writer = nullptr;
   QtMessageHandler oldMessageHandler = nullptr;
   QLoggingCategory::CategoryFilter oldCategoryFilter = nullptr;
 
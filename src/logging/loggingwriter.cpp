@@ -0,0 +1,211 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "logging/loggingwriter.h"
+#include "logging/loggingconfig.h"
+
+#include <QTextStream>
+
+namespace atools {
+namespace logging {
+namespace internal {
+
+LoggingWriter::LoggingWriter(LoggingConfig *loggingConfig, int maxQueueSize)
+  : config(loggingConfig), maxSize(maxQueueSize)
+{
+  stub.channels = nullptr;
+  stub.next.store(nullptr);
+  head.store(&stub);
+  tail = &stub;
+
+  size.store(0);
+  dropped.store(0);
+  pushed.store(0);
+  written.store(0);
+  waiting.store(false);
+  terminate.store(false);
+
+  setObjectName("LoggingWriter");
+  start(QThread::LowPriority);
+}
+
+LoggingWriter::~LoggingWriter()
+{
+  mutex.lock();
+  terminate.store(true);
+  writerCondition.wakeOne();
+  mutex.unlock();
+
+  // Thread writes all remaining messages before finishing
+  wait();
+}
+
+void LoggingWriter::push(QtMsgType type, const QString& message, const ChannelVector *channels)
+{
+  // Drop less important messages if the writer cannot keep up
+  if(maxSize > 0 && size.load(std::memory_order_relaxed) >= maxSize && (type == QtDebugMsg || type == QtInfoMsg))
+  {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Record *record = new Record;
+  record->message = message;
+  record->channels = channels;
+  size.fetch_add(1, std::memory_order_relaxed);
+  enqueue(record);
+  pushed.fetch_add(1);
+  wakeWriter();
+}
+
+void LoggingWriter::flush()
+{
+  // Messages from the writer thread itself are written after returning
+  if(QThread::currentThread() == this)
+    return;
+
+  quint64 target = pushed.load();
+  wakeWriter();
+
+  mutex.lock();
+  while(written.load() < target && isRunning())
+    flushCondition.wait(&mutex, 100);
+  mutex.unlock();
+}
+
+void LoggingWriter::wakeWriter()
+{
+  if(waiting.load())
+  {
+    mutex.lock();
+    writerCondition.wakeOne();
+    mutex.unlock();
+  }
+}
+
+void LoggingWriter::enqueue(Record *record)
+{
+  record->next.store(nullptr, std::memory_order_relaxed);
+  Record *prev = head.exchange(record, std::memory_order_acq_rel);
+  prev->next.store(record, std::memory_order_release);
+}
+
+LoggingWriter::Record *LoggingWriter::dequeue()
+{
+  Record *first = tail;
+  Record *next = first->next.load(std::memory_order_acquire);
+
+  if(first == &stub)
+  {
+    // Skip stub
+    if(next == nullptr)
+      return nullptr;
+
+    tail = next;
+    first = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if(next != nullptr)
+  {
+    tail = next;
+    return first;
+  }
+
+  // A producer is between exchange and linking - try again later
+  if(first != head.load(std::memory_order_acquire))
+    return nullptr;
+
+  // Last record - push stub behind to be able to remove it
+  enqueue(&stub);
+  next = first->next.load(std::memory_order_acquire);
+  if(next != nullptr)
+  {
+    tail = next;
+    return first;
+  }
+  return nullptr;
+}
+
+bool LoggingWriter::writeBatch()
+{
+  ChannelVector touched;
+  quint64 numWritten = 0;
+
+  Record *record;
+  while((record = dequeue()) != nullptr)
+  {
+    int numDropped = dropped.exchange(0, std::memory_order_relaxed);
+    for(Channel *channel : *record->channels)
+    {
+      if(numDropped > 0)
+        (*channel->stream) << "[" << numDropped << " log messages dropped]\n";
+      (*channel->stream) << record->message << '\n';
+
+      if(!touched.contains(channel))
+        touched.append(channel);
+    }
+
+    delete record;
+    size.fetch_sub(1, std::memory_order_relaxed);
+    numWritten++;
+  }
+
+  // Flush and roll files only once per batch
+  for(Channel *channel : touched)
+  {
+    channel->stream->flush();
+    config->checkStreamSize(channel);
+  }
+
+  if(numWritten > 0)
+  {
+    mutex.lock();
+    written.fetch_add(numWritten);
+    flushCondition.wakeAll();
+    mutex.unlock();
+  }
+  return numWritten > 0;
+}
+
+void LoggingWriter::run()
+{
+  while(true)
+  {
+    if(writeBatch())
+      continue;
+
+    mutex.lock();
+    if(terminate.load() && pushed.load() == written.load())
+    {
+      mutex.unlock();
+      break;
+    }
+
+    waiting.store(true);
+    // Recheck after announcing the wait to avoid missing a wakeup. Timeout covers a producer between enqueue and count.
+    if(pushed.load() == written.load() && !terminate.load())
+      writerCondition.wait(&mutex, 100);
+    waiting.store(false);
+    mutex.unlock();
+  }
+}
+
+} // namespace internal
+} // namespace logging
+} // namespace atools
@@ -0,0 +1,103 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_LOGGING_LOGGINGWRITER_H
+#define ATOOLS_LOGGING_LOGGINGWRITER_H
+
+#include "logging/loggingtypes.h"
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+
+namespace atools {
+namespace logging {
+namespace internal {
+
+class LoggingConfig;
+
+/*
+ * Background thread which writes preformatted log messages for the asynchronous logging mode.
+ *
+ * Producers push messages into a lock free multi producer single consumer queue and return immediately.
+ * The thread writes all queued messages in batches, flushes the streams once per batch and rolls files
+ * using LoggingConfig::checkStreamSize().
+ *
+ * The queue is bounded by maxQueueSize for debug and info messages. These are dropped if the queue is full
+ * and the number of dropped messages is written to the channels later. Warnings and worse are never dropped.
+ */
+class LoggingWriter :
+  public QThread
+{
+  Q_OBJECT
+
+public:
+  LoggingWriter(LoggingConfig *loggingConfig, int maxQueueSize);
+
+  /* Writes all remaining messages and stops the thread */
+  virtual ~LoggingWriter() override;
+
+  /* Queue a message for the channels. Thread safe and lock free. channels has to be valid until written. */
+  void push(QtMsgType type, const QString& message, const ChannelVector *channels);
+
+  /* Wait until all messages pushed before this call are written. Thread safe. */
+  void flush();
+
+private:
+  struct Record
+  {
+    QString message;
+    const ChannelVector *channels;
+    std::atomic<Record *> next;
+  };
+
+  virtual void run() override;
+
+  /* Lock free queue operations. Vyukov's intrusive MPSC queue using a stub record. */
+  void enqueue(Record *record);
+  Record *dequeue();
+
+  /* Write messages until queue is empty. Returns true if something was written. */
+  bool writeBatch();
+
+  /* Wake up writer if it is waiting */
+  void wakeWriter();
+
+  LoggingConfig *config;
+  int maxSize;
+
+  Record stub;
+  std::atomic<Record *> head; // Producers
+  Record *tail; // Consumer only
+
+  std::atomic<int> size;
+  std::atomic<int> dropped;
+  std::atomic<quint64> pushed, written;
+  std::atomic<bool> waiting, terminate;
+
+  QMutex mutex;
+  QWaitCondition writerCondition, flushCondition;
+};
+
+} // namespace internal
+} // namespace logging
+} // namespace atools
+
+#endif // ATOOLS_LOGGING_LOGGINGWRITER_H
@@ -0,0 +1,176 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "routing/routebenchmark.h"
+
+#include "routing/routefinder.h"
+#include "routing/routenetwork.h"
+#include "routing/routenetworkloader.h"
+#include "geo/calculations.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+
+namespace atools {
+namespace routing {
+
+namespace {
+
+struct CityPair
+{
+  const char *name, *category;
+  float fromLonX, fromLatY, toLonX, toLatY;
+};
+
+/* Fixed corpus. Do not change to keep results comparable. */
+const static CityPair CITY_PAIRS[] =
+{
+  {"EDDF-EDDM", "short", 8.5706f, 50.0333f, 11.7861f, 48.3538f},
+  {"KJFK-KBOS", "short", -73.7789f, 40.6398f, -71.0096f, 42.3656f},
+  {"LFPG-EGLL", "short", 2.5479f, 49.0097f, -0.4614f, 51.4700f},
+  {"EGLL-LIRF", "medium", -0.4614f, 51.4700f, 12.2508f, 41.8003f},
+  {"KLAX-KORD", "medium", -118.4085f, 33.9416f, -87.9048f, 41.9786f},
+  {"YSSY-NZAA", "medium", 151.1772f, -33.9461f, 174.7850f, -37.0082f},
+  {"EGLL-KJFK", "long", -0.4614f, 51.4700f, -73.7789f, 40.6398f},
+  {"KLAX-RJAA", "long", -118.4085f, 33.9416f, 140.3929f, 35.7720f},
+  {"EDDF-VHHH", "long", 8.5706f, 50.0333f, 113.9185f, 22.3080f},
+  {"YSSY-WSSS", "long", 151.1772f, -33.9461f, 103.9915f, 1.3644f}
+};
+
+struct ModeDef
+{
+  const char *name;
+  Modes mode;
+  int altitudeFt;
+  bool radio;
+};
+
+const static ModeDef MODES[] =
+{
+  {"jet", MODE_JET, 35000, false},
+  {"victor", MODE_VICTOR, 9000, false},
+  {"airway_track", MODE_AIRWAY_TRACK, 35000, false},
+  {"airway_waypoint", MODE_AIRWAY_WAYPOINT, 0, false},
+  {"direct", MODE_WAYPOINT, 0, false},
+  {"radionav", MODE_RADIONAV, 0, true}
+};
+
+}
+
+RouteBenchmark::RouteBenchmark(atools::sql::SqlDatabase *sqlDbNav, atools::sql::SqlDatabase *sqlDbTrack)
+  : dbNav(sqlDbNav), dbTrack(sqlDbTrack)
+{
+}
+
+void RouteBenchmark::run()
+{
+  results.clear();
+
+  QElapsedTimer timer;
+  RouteNetworkLoader loader(dbNav, dbTrack);
+
+  // Load networks ===================================
+  timer.start();
+  RouteNetwork radioNetwork(SOURCE_RADIO);
+  loader.load(&radioNetwork);
+  loadRadioMs = timer.restart();
+
+  RouteNetwork airwayNetwork(SOURCE_AIRWAY);
+  loader.load(&airwayNetwork);
+  loadAirwayMs = timer.restart();
+
+  // Calculate all combinations ===================================
+  for(const ModeDef& modeDef : MODES)
+  {
+    RouteFinder finder(modeDef.radio ? &radioNetwork : &airwayNetwork);
+    finder.setBidirectional(bidirectional);
+
+    for(const CityPair& pair : CITY_PAIRS)
+    {
+      RouteBenchmarkResult result;
+      result.name = pair.name;
+      result.category = pair.category;
+      result.mode = modeDef.name;
+
+      timer.restart();
+      result.found = finder.calculateRoute(atools::geo::Pos(pair.fromLonX, pair.fromLatY),
+                                           atools::geo::Pos(pair.toLonX, pair.toLatY),
+                                           modeDef.altitudeFt, modeDef.mode);
+      result.timeMs = timer.elapsed();
+      result.numExpandedNodes = finder.getNumExpandedNodes();
+      result.maxHeapSize = finder.getMaxHeapSize();
+
+      if(result.found)
+      {
+        QVector<RouteLeg> legs;
+        float distanceMeter;
+        finder.extractLegs(legs, distanceMeter);
+        result.numLegs = legs.size();
+        result.distanceNm = atools::geo::meterToNm(distanceMeter);
+      }
+
+      qDebug() << Q_FUNC_INFO << result.name << result.mode << "found" << result.found
+               << "expanded" << result.numExpandedNodes << "heap" << result.maxHeapSize << result.timeMs << "ms";
+      results.append(result);
+    }
+  }
+}
+
+QJsonDocument RouteBenchmark::toJson() const
+{
+  QJsonArray resultArr;
+  for(const RouteBenchmarkResult& result : results)
+  {
+    QJsonObject obj;
+    obj.insert("name", result.name);
+    obj.insert("category", result.category);
+    obj.insert("mode", result.mode);
+    obj.insert("found", result.found);
+    obj.insert("legs", result.numLegs);
+    obj.insert("distance_nm", static_cast<double>(result.distanceNm));
+    obj.insert("expanded_nodes", result.numExpandedNodes);
+    obj.insert("heap_peak", result.maxHeapSize);
+    obj.insert("time_ms", static_cast<double>(result.timeMs));
+    resultArr.append(obj);
+  }
+
+  QJsonObject root;
+  root.insert("bidirectional", bidirectional);
+  root.insert("load_radio_ms", static_cast<double>(loadRadioMs));
+  root.insert("load_airway_ms", static_cast<double>(loadAirwayMs));
+  root.insert("results", resultArr);
+  return QJsonDocument(root);
+}
+
+bool RouteBenchmark::writeJson(const QString& filename) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    file.write(toJson().toJson(QJsonDocument::Indented));
+    file.close();
+    return true;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << ":" << file.errorString();
+  return false;
+}
+
+} // namespace routing
+} // namespace atools
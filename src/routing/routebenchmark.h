@@ -0,0 +1,91 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ROUTEBENCHMARK_H
+#define ATOOLS_ROUTEBENCHMARK_H
+
+#include "routing/routenetworktypes.h"
+
+#include <QJsonDocument>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace routing {
+
+/* Result of one benchmark run for a city pair and mode */
+struct RouteBenchmarkResult
+{
+  QString name, /* Name of city pair like "EDDF-EDDM" */
+          category, /* short, medium or long */
+          mode; /* Mode name like "jet" or "radionav" */
+  bool found = false;
+  int numLegs = 0, /* Number of legs in route */
+      numExpandedNodes = 0, /* Number of nodes expanded by RouteFinder */
+      maxHeapSize = 0; /* Peak number of nodes in open heap */
+  float distanceNm = 0.f;
+  qint64 timeMs = 0L;
+};
+
+/*
+ * Reproducible performance measurement for route calculation.
+ *
+ * Loads the airway and radio networks from the given databases and runs RouteFinder for a fixed
+ * corpus of short, medium and long city pairs in several mode combinations (jet, victor, airways with tracks,
+ * radionav and direct waypoints).
+ *
+ * Results can be saved as JSON to detect regressions in network filtering or cost factors.
+ */
+class RouteBenchmark
+{
+public:
+  /* Track database is optional */
+  RouteBenchmark(atools::sql::SqlDatabase *sqlDbNav, atools::sql::SqlDatabase *sqlDbTrack);
+
+  /* Load networks and run all calculations. Can be repeated. */
+  void run();
+
+  const QVector<atools::routing::RouteBenchmarkResult>& getResults() const
+  {
+    return results;
+  }
+
+  /* Machine readable report including load times and all results */
+  QJsonDocument toJson() const;
+
+  /* Write JSON report to file. Returns false on error. */
+  bool writeJson(const QString& filename) const;
+
+  /* Use bidirectional search in RouteFinder. Default is false. */
+  void setBidirectional(bool value)
+  {
+    bidirectional = value;
+  }
+
+private:
+  atools::sql::SqlDatabase *dbNav, *dbTrack;
+  QVector<atools::routing::RouteBenchmarkResult> results;
+  qint64 loadRadioMs = 0L, loadAirwayMs = 0L;
+  bool bidirectional = false;
+};
+
+} // namespace routing
+} // namespace atools
+
+#endif // ATOOLS_ROUTEBENCHMARK_H
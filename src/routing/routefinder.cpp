@@ -19,11 +19,16 @@
 
 #include "routing/routenetwork.h"
 #include "routing/routenetworkloader.h"
+#include "routing/routewindcache.h"
 #include "atools.h"
 #include "geo/calculations.h"
+#include "util/trace.h"
 
 #include <QDateTime>
 #include <QElapsedTimer>
+#include <QHash>
+
+#include <algorithm>
 
 using atools::geo::Pos;
 
@@ -38,22 +43,36 @@ inline TYPE& at(TYPE *arr, int index)
 }
 
 RouteFinder::RouteFinder(RouteNetwork *routeNetwork)
-  : network(routeNetwork), openNodesHeap(10000)
+  : network(routeNetwork), openNodesHeap(10000), openNodesHeapReverse(10000)
 {
   successors.reserve(500);
+  predecessors.reserve(500);
+}
+
+RouteFinder::RouteFinder(const RouteNetwork& sharedNetwork)
+  : RouteFinder(new RouteNetwork(sharedNetwork))
+{
+  ownedNetwork = network;
 }
 
 RouteFinder::~RouteFinder()
 {
   freeArrays();
+  freeTree();
+  atools::freeArray(bannedNodesArr);
+  delete ownedNetwork;
 }
 
 bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo::Pos& to, int flownAltitude,
                                  atools::routing::Modes mode)
 {
+  ATOOLS_TRACE_SCOPE("RouteFinder::calculateRoute", "routing");
+
   qDebug() << Q_FUNC_INFO << "from" << from << "to" << to << "altitude" << flownAltitude << "mode" << mode;
 
   allocArrays();
+  freeTree();
+  numExpandedNodes = maxHeapSize = 0;
 
   QElapsedTimer timer;
   timer.start();
@@ -62,45 +81,770 @@ bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo
   network->setParameters(from, to, altitude, mode);
   startNode = network->getDepartureNode();
   destNode = network->getDestinationNode();
+  startTarget = network->getDistanceTarget(startNode);
+  destTarget = network->getDistanceTarget(destNode);
+  initWindCosts();
   totalDist = atools::roundToInt(network->getDirectDistanceMeter(startNode, destNode));
   lastDist = totalDist;
 
+  touch(startNode.index);
   openNodesHeap.pushData(startNode.index, 0);
   at(nodeAltRangeMaxArr, startNode.index) = std::numeric_limits<quint16>::max();
 
   time = QDateTime::currentSecsSinceEpoch();
 
+  if(bidirectional)
+  {
+    bool found = calculateRouteBidirectional();
+
+    if(found && incremental)
+    {
+      allocTree();
+      updateTree(true);
+    }
+
+    qDebug() << Q_FUNC_INFO << "bidirectional found" << found << "heap sizes" << openNodesHeap.size()
+             << openNodesHeapReverse.size() << timer.restart() << "ms";
+    return found;
+  }
+
+  bool destinationFound = search();
+
+  if(destinationFound && incremental)
+  {
+    meetingIndex = destNode.index;
+    meetingCost = at(nodeCostArr, destNode.index);
+    allocTree();
+    updateTree(false);
+  }
+
+  qDebug() << Q_FUNC_INFO << "found" << destinationFound << "heap size" << openNodesHeap.size()
+           << timer.restart() << "ms";
+
+  return destinationFound;
+}
+
+bool RouteFinder::recalculateRoute(const atools::geo::Pos& from)
+{
+  Pos to = network->getDestinationNode().pos;
+  Modes mode = network->getMode();
+
+  if(treeCostArr == nullptr || treeSize != network->getNumNodes() + 3 || at(treeCostArr, destNode.index) != 0)
+  {
+    qDebug() << Q_FUNC_INFO << "No destination tree - doing full calculation";
+    return calculateRoute(from, to, altitude, mode);
+  }
+
+  qDebug() << Q_FUNC_INFO << "from" << from << "to" << to << "altitude" << altitude << "mode" << mode;
+
+  allocArrays();
+  numExpandedNodes = maxHeapSize = 0;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  network->setParameters(from, to, altitude, mode);
+  startNode = network->getDepartureNode();
+  destNode = network->getDestinationNode();
+  startTarget = network->getDistanceTarget(startNode);
+  destTarget = network->getDistanceTarget(destNode);
+  totalDist = atools::roundToInt(network->getDirectDistanceMeter(startNode, destNode));
+  lastDist = totalDist;
+  initWindCosts();
+
+  // Costs of departure belong to the previous departure position
+  at(treeCostArr, startNode.index) = std::numeric_limits<int>::max();
+
+  meetingIndex = Node::INVALID_INDEX;
+  meetingCost = std::numeric_limits<int>::max();
+
+  touch(startNode.index);
+  openNodesHeap.pushData(startNode.index, 0);
+  at(nodeAltRangeMaxArr, startNode.index) = std::numeric_limits<quint16>::max();
+
+  time = QDateTime::currentSecsSinceEpoch();
+
+  useTree = true;
+  bool destinationFound = search();
+  useTree = false;
+
+  if(destinationFound)
+  {
+    if(meetingIndex == Node::INVALID_INDEX)
+    {
+      // Reached destination before any tree node
+      meetingIndex = destNode.index;
+      meetingCost = at(nodeCostArr, destNode.index);
+    }
+
+    joinTree();
+    updateTree(false);
+  }
+
+  qDebug() << Q_FUNC_INFO << "found" << destinationFound << "expanded" << numExpandedNodes
+           << "heap size" << openNodesHeap.size() << timer.restart() << "ms";
+
+  return destinationFound;
+}
+
+void RouteFinder::invalidateNodes(const QVector<int>& nodeIndexes)
+{
+  if(treeCostArr == nullptr)
+    return;
+
+  // State per node: 0 unknown, 1 reaches destination and 2 passes an invalid node
+  QVector<char> state(treeSize, 0);
+  for(int index : nodeIndexes)
+    state[index + 3] = 2;
+  state[destNode.index + 3] = 1;
+
+  // Follow each chain until a node with known state is found and assign this to all nodes of the chain
+  QVector<int> chain;
+  for(int start = -3; start < treeSize - 3; start++)
+  {
+    if(at(treeCostArr, start) == std::numeric_limits<int>::max() || state.at(start + 3) != 0)
+      continue;
+
+    chain.clear();
+    int current = start;
+    char result = 2;
+    while(current != -1 && at(treeCostArr, current) != std::numeric_limits<int>::max())
+    {
+      if(state.at(current + 3) != 0)
+      {
+        result = state.at(current + 3);
+        break;
+      }
+
+      // Mark as invalid temporarily to stop on loops
+      state[current + 3] = 2;
+      chain.append(current);
+      current = at(treeNextArr, current);
+    }
+
+    for(int index : chain)
+      state[index + 3] = result;
+  }
+
+  int removed = 0;
+  for(int index = -3; index < treeSize - 3; index++)
+  {
+    if(state.at(index + 3) == 2 && at(treeCostArr, index) != std::numeric_limits<int>::max())
+    {
+      at(treeCostArr, index) = std::numeric_limits<int>::max();
+      at(treeNextArr, index) = -1;
+      removed++;
+    }
+  }
+  qDebug() << Q_FUNC_INFO << "removed" << removed << "nodes";
+}
+
+void RouteFinder::clearIncremental()
+{
+  freeTree();
+}
+
+void RouteFinder::updateTreeConnection(int index)
+{
+  int treeCost = at(treeCostArr, index);
+  if(treeCost == std::numeric_limits<int>::max())
+    return;
+
+  int cost = at(nodeCostArr, index) + treeCost;
+  if(cost < meetingCost)
+  {
+    if(bannedNodesArr != nullptr)
+    {
+      // Spur search for alternative routes - tree path has to avoid the root path and match altitude restrictions
+      quint16 altRangeMin = at(nodeAltRangeMinArr, index), altRangeMax = at(nodeAltRangeMaxArr, index);
+      if(!combineRanges(altRangeMin, altRangeMax, at(treeAltRangeMinArr, index), at(treeAltRangeMaxArr, index)) ||
+         !isTreePathValid(index))
+        return;
+    }
+
+    meetingCost = cost;
+    meetingIndex = index;
+  }
+}
+
+void RouteFinder::joinTree()
+{
+  // Follow tree from meeting point to destination and link nodes as predecessors
+  int current = meetingIndex, steps = 0;
+  while(current != destNode.index && steps++ < treeSize)
+  {
+    int next = at(treeNextArr, current);
+    if(next == -1)
+      break;
+
+    touch(next);
+    at(nodePredecessorArr, next) = current;
+    at(edgePredecessorArr, next) = at(treeEdgeArr, current);
+    current = next;
+  }
+}
+
+void RouteFinder::updateTree(bool reverseSearched)
+{
+  if(reverseSearched)
+  {
+    // Nodes settled by the backward search have the lowest costs to the destination
+    for(int index = -3; index < treeSize - 3; index++)
+    {
+      if(index != startNode.index && isTouchedReverse(index) && at(closedNodesReverse, index) &&
+         at(nodeCostArrReverse, index) < at(treeCostArr, index))
+      {
+        at(treeCostArr, index) = at(nodeCostArrReverse, index);
+        at(treeNextArr, index) = at(nodeSuccessorArr, index);
+        at(treeEdgeArr, index) = at(edgeSuccessorArr, index);
+      }
+    }
+
+    // Remaining part of the route from meeting point to destination
+    for(int current = meetingIndex; current != destNode.index && current != -1;
+        current = at(nodeSuccessorArr, current))
+    {
+      at(treeCostArr, current) = at(nodeCostArrReverse, current);
+      at(treeNextArr, current) = at(nodeSuccessorArr, current);
+      at(treeEdgeArr, current) = at(edgeSuccessorArr, current);
+    }
+  }
+
+  at(treeCostArr, destNode.index) = 0;
+  at(treeNextArr, destNode.index) = -1;
+
+  // Route from departure to meeting point - departure is not added since it changes for each calculation
+  int current = meetingIndex;
+  while(current != -1)
+  {
+    int pred = at(nodePredecessorArr, current);
+    if(pred == -1 || pred == startNode.index)
+      break;
+
+    at(treeCostArr, pred) = meetingCost - at(nodeCostArr, pred);
+    at(treeNextArr, pred) = current;
+    at(treeEdgeArr, pred) = at(edgePredecessorArr, current);
+    current = pred;
+  }
+}
+
+void RouteFinder::allocTree(bool alternatives)
+{
+  freeTree();
+  treeSize = network->getNumNodes() + 3;
+  treeCostArr = atools::allocArray<int>(treeSize, std::numeric_limits<int>::max());
+  treeNextArr = atools::allocArray<int>(treeSize, -1);
+  treeEdgeArr = atools::allocArray<Edge>(treeSize, Edge());
+
+  if(alternatives)
+  {
+    treeAltRangeMinArr = atools::allocArray<quint16>(treeSize);
+    treeAltRangeMaxArr = atools::allocArray<quint16>(treeSize);
+    treeStampArr = atools::allocArray<quint32>(treeSize);
+    treeValidArr = atools::allocArray<bool>(treeSize);
+    treeStamp = 0;
+  }
+}
+
+void RouteFinder::freeTree()
+{
+  atools::freeArray(treeCostArr);
+  atools::freeArray(treeNextArr);
+  atools::freeArray(treeEdgeArr);
+  atools::freeArray(treeAltRangeMinArr);
+  atools::freeArray(treeAltRangeMaxArr);
+  atools::freeArray(treeStampArr);
+  atools::freeArray(treeValidArr);
+  treeSize = 0;
+}
+
+bool RouteFinder::search()
+{
   Node currentNode;
-  bool destinationFound = false;
   while(!openNodesHeap.isEmpty())
   {
+    // Stop if no path through any of the open nodes can be cheaper than the best connection into the tree
+    if(useTree && meetingIndex != Node::INVALID_INDEX && openNodesHeap.peekCost() >= meetingCost)
+      return true;
+
     // Contains known nodes
     int currentIndex = openNodesHeap.popData();
 
     if(currentIndex == destNode.index)
-    {
-      destinationFound = true;
-      break;
-    }
+      return true;
 
     currentNode = network->getNode(currentIndex);
 
     // Invoke user callback if set
     if(!invokeCallback(currentNode))
-      break;
+      return false;
 
     // Contains nodes with known shortest path
     at(closedNodes, currentNode.index) = true;
 
     // Work on successors
     if(!expandNode(currentNode, at(edgePredecessorArr, currentNode.index)))
+      return false;
+  }
+  return false;
+}
+
+bool RouteFinder::calculateAlternativeRoutes(const atools::geo::Pos& from, const atools::geo::Pos& to,
+                                             int flownAltitude, atools::routing::Modes mode, int numRoutes)
+{
+  ATOOLS_TRACE_SCOPE("RouteFinder::calculateAlternativeRoutes", "routing");
+
+  qDebug() << Q_FUNC_INFO << "from" << from << "to" << to << "altitude" << flownAltitude << "mode" << mode
+           << "numRoutes" << numRoutes;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  alternativePaths.clear();
+
+  // Shortest route first - bidirectional search does not fill costs for backward part
+  // Shortcuts cannot be used since spur searches have to branch off at every node
+  bool bidirectionalSaved = bidirectional, shortcutsSaved = network->isShortcutsEnabled();
+  bidirectional = false;
+  network->setShortcutsEnabled(false);
+
+  bool found = calculateRoute(from, to, flownAltitude, mode);
+  if(found)
+  {
+    alternativePaths.append(pathFromArrays(startNode.index, destNode.index));
+
+    // Costs to destination for all nodes which can be part of a reasonable alternative
+    if(numRoutes > 1)
+      found = buildAlternativeTree(static_cast<int>(alternativePaths.first().costs.last() *
+                                                    ALTERNATIVE_TREE_COST_FACTOR));
+  }
+
+  if(!found)
+  {
+    bidirectional = bidirectionalSaved;
+    network->setShortcutsEnabled(shortcutsSaved);
+    return false;
+  }
+
+  // Yen's algorithm - candidates sorted by costs, cheapest at end
+  QVector<Path> candidates;
+  bannedNodesArr = atools::allocArray<bool>(network->getNumNodes() + 3);
+  int numSpurSearches = 0, numSpurExpanded = 0;
+
+  bool canceled = false;
+  for(int k = 1; k < numRoutes && !canceled; k++)
+  {
+    const Path& previous = alternativePaths.last();
+
+    // Each node of the previous path except the destination is a spur node
+    for(int i = 0; i < previous.nodes.size() - 1 && !canceled; i++)
+    {
+      spurNodeIndex = previous.nodes.at(i);
+
+      // Remove edges which are part of previous paths sharing the same root path
+      bannedEdges.clear();
+      for(const Path& path : alternativePaths)
+      {
+        if(path.nodes.size() > i + 1 && std::equal(path.nodes.begin(), path.nodes.begin() + i + 1,
+                                                   previous.nodes.begin()))
+          bannedEdges.insert(edgeKey(path.nodes.at(i), path.nodes.at(i + 1)));
+      }
+
+      // Remove root path nodes to get loopless paths
+      std::fill(bannedNodesArr, bannedNodesArr + network->getNumNodes() + 3, false);
+      for(int j = 0; j < i; j++)
+        at(bannedNodesArr, previous.nodes.at(j)) = true;
+
+      // Validity of tree paths changes with the root path
+      treeStamp++;
+
+      // Search from spur node using the root path costs and restrictions until it connects to the tree ==========
+      allocArrays();
+      meetingIndex = Node::INVALID_INDEX;
+      meetingCost = std::numeric_limits<int>::max();
+      touch(spurNodeIndex);
+      at(nodeCostArr, spurNodeIndex) = previous.costs.at(i);
+      at(nodeAltRangeMinArr, spurNodeIndex) = previous.altRangeMin.at(i);
+      at(nodeAltRangeMaxArr, spurNodeIndex) = previous.altRangeMax.at(i);
+      at(edgePredecessorArr, spurNodeIndex) = previous.edges.at(i);
+      at(edgeNameHashArr, spurNodeIndex) = previous.edges.at(i).airwayHash;
+      openNodesHeap.pushData(spurNodeIndex, previous.costs.at(i));
+
+      int expandedBefore = numExpandedNodes;
+      useTree = true;
+      bool spurFound = search();
+      useTree = false;
+      numSpurSearches++;
+      numSpurExpanded += numExpandedNodes - expandedBefore;
+
+      if(spurFound)
+      {
+        if(meetingIndex == Node::INVALID_INDEX)
+          // Reached destination before any valid tree node
+          meetingIndex = destNode.index;
+
+        // Join root path, spur path and tree path
+        Path spurPath = pathFromArrays(spurNodeIndex, meetingIndex);
+        appendTreePath(spurPath);
+
+        Path candidate;
+        candidate.nodes = previous.nodes.mid(0, i) + spurPath.nodes;
+        candidate.edges = previous.edges.mid(0, i) + spurPath.edges;
+        candidate.costs = previous.costs.mid(0, i) + spurPath.costs;
+        candidate.altRangeMin = previous.altRangeMin.mid(0, i) + spurPath.altRangeMin;
+        candidate.altRangeMax = previous.altRangeMax.mid(0, i) + spurPath.altRangeMax;
+        removeLoops(candidate);
+
+        auto sameNodes = [&candidate](const Path& path) -> bool {
+                           return path.nodes == candidate.nodes;
+                         };
+
+        if(candidate.nodes.last() == destNode.index &&
+           std::none_of(candidates.begin(), candidates.end(), sameNodes) &&
+           std::none_of(alternativePaths.begin(), alternativePaths.end(), sameNodes))
+          candidates.append(candidate);
+      }
+      else if(!openNodesHeap.isEmpty())
+        // Callback canceled
+        canceled = true;
+    }
+
+    if(candidates.isEmpty())
       break;
+
+    // Move cheapest candidate to result
+    std::sort(candidates.begin(), candidates.end(), [](const Path& p1, const Path& p2) -> bool {
+      return p1.costs.last() > p2.costs.last();
+    });
+    alternativePaths.append(candidates.takeLast());
   }
 
-  qDebug() << Q_FUNC_INFO << "found" << destinationFound << "heap size" << openNodesHeap.size()
-           << timer.restart() << "ms";
+  bannedEdges.clear();
+  atools::freeArray(bannedNodesArr);
+  spurNodeIndex = Node::INVALID_INDEX;
+  bidirectional = bidirectionalSaved;
+  network->setShortcutsEnabled(shortcutsSaved);
 
-  return destinationFound;
+  // Tree of the reverse search is valid for the destination
+  if(!incremental)
+    freeTree();
+
+  qDebug() << Q_FUNC_INFO << "found" << alternativePaths.size() << "routes" << "spur searches" << numSpurSearches
+           << "expanded" << numSpurExpanded << timer.restart() << "ms";
+
+  return !canceled;
+}
+
+bool RouteFinder::buildAlternativeTree(int maxCost)
+{
+  // Reverse arrays are only allocated for bidirectional search
+  bidirectional = true;
+  allocArrays();
+  bidirectional = false;
+
+  touchReverse(destNode.index);
+  openNodesHeapReverse.pushData(destNode.index, 0);
+  at(nodeCostArrReverse, destNode.index) = 0;
+  at(nodeAltRangeMaxArrReverse, destNode.index) = std::numeric_limits<quint16>::max();
+
+  while(!openNodesHeapReverse.isEmpty() && openNodesHeapReverse.peekCost() <= maxCost)
+  {
+    Node currentNode = network->getNode(openNodesHeapReverse.popData());
+
+    if(!invokeCallback(currentNode))
+      return false;
+
+    at(closedNodesReverse, currentNode.index) = true;
+
+    if(currentNode.index != startNode.index &&
+       !expandNodeReverse(currentNode, at(edgeSuccessorArr, currentNode.index)))
+      return false;
+  }
+
+  // Copy settled nodes into the tree - the departure is not used since spur searches never reach it again
+  allocTree(true);
+  int numTreeNodes = 0;
+  for(int index = -3; index < treeSize - 3; index++)
+  {
+    if(index != startNode.index && isTouchedReverse(index) && at(closedNodesReverse, index))
+    {
+      at(treeCostArr, index) = at(nodeCostArrReverse, index);
+      at(treeNextArr, index) = at(nodeSuccessorArr, index);
+      at(treeEdgeArr, index) = at(edgeSuccessorArr, index);
+      at(treeAltRangeMinArr, index) = at(nodeAltRangeMinArrReverse, index);
+      at(treeAltRangeMaxArr, index) = at(nodeAltRangeMaxArrReverse, index);
+      numTreeNodes++;
+    }
+  }
+  at(treeCostArr, destNode.index) = 0;
+  at(treeNextArr, destNode.index) = -1;
+
+  qDebug() << Q_FUNC_INFO << "tree nodes" << numTreeNodes;
+  return true;
+}
+
+void RouteFinder::appendTreePath(Path& path) const
+{
+  int current = path.nodes.last();
+  int cost = path.costs.last();
+  quint16 altRangeMin = path.altRangeMin.last(), altRangeMax = path.altRangeMax.last();
+
+  while(current != destNode.index)
+  {
+    int next = at(treeNextArr, current);
+    if(next == -1)
+      break;
+
+    const Edge& edge = at(treeEdgeArr, current);
+    cost += at(treeCostArr, current) - at(treeCostArr, next);
+
+    // Ranges were checked for the whole tree path by updateTreeConnection()
+    altRangeMin = std::max(altRangeMin, edge.minAltFt);
+    altRangeMax = std::min(altRangeMax, edge.maxAltFt);
+
+    path.nodes.append(next);
+    path.edges.append(edge);
+    path.costs.append(cost);
+    path.altRangeMin.append(altRangeMin);
+    path.altRangeMax.append(altRangeMax);
+    current = next;
+  }
+}
+
+void RouteFinder::removeLoops(Path& path)
+{
+  QHash<int, int> positions;
+  for(int i = 0; i < path.nodes.size(); i++)
+  {
+    int first = positions.value(path.nodes.at(i), -1);
+    if(first == -1)
+    {
+      positions.insert(path.nodes.at(i), i);
+      continue;
+    }
+
+    // Remove the part after the first visit up to and including the second one and correct the costs
+    int removedCost = path.costs.at(i) - path.costs.at(first);
+    int num = i - first;
+    for(int j = first + 1; j <= i; j++)
+      positions.remove(path.nodes.at(j));
+
+    path.nodes.remove(first + 1, num);
+    path.edges.remove(first + 1, num);
+    path.costs.remove(first + 1, num);
+    path.altRangeMin.remove(first + 1, num);
+    path.altRangeMax.remove(first + 1, num);
+
+    for(int j = first + 1; j < path.costs.size(); j++)
+      path.costs[j] -= removedCost;
+
+    positions.insert(path.nodes.at(first), first);
+    i = first;
+  }
+}
+
+bool RouteFinder::isTreePathValid(int index)
+{
+  // Follow tree until the destination, a node checked already for this spur search or an invalid node
+  treeChain.clear();
+  bool valid = true;
+  int current = index;
+  while(current != destNode.index)
+  {
+    if(at(treeStampArr, current) == treeStamp)
+    {
+      valid = at(treeValidArr, current);
+      break;
+    }
+
+    if(current == -1 || current == spurNodeIndex || at(bannedNodesArr, current) ||
+       at(treeCostArr, current) == std::numeric_limits<int>::max())
+    {
+      valid = false;
+      break;
+    }
+
+    // Mark as invalid temporarily to stop on loops
+    at(treeStampArr, current) = treeStamp;
+    at(treeValidArr, current) = false;
+    treeChain.append(current);
+    current = at(treeNextArr, current);
+  }
+
+  for(int chainIndex : treeChain)
+    at(treeValidArr, chainIndex) = valid;
+  return valid;
+}
+
+RouteFinder::Path RouteFinder::pathFromArrays(int fromIndex, int toIndex) const
+{
+  Path path;
+  int current = toIndex;
+  while(current != -1)
+  {
+    path.nodes.prepend(current);
+    path.edges.prepend(at(edgePredecessorArr, current));
+    path.costs.prepend(at(nodeCostArr, current));
+    path.altRangeMin.prepend(at(nodeAltRangeMinArr, current));
+    path.altRangeMax.prepend(at(nodeAltRangeMaxArr, current));
+
+    if(current == fromIndex)
+      break;
+
+    current = at(nodePredecessorArr, current);
+  }
+  return path;
+}
+
+void RouteFinder::extractAlternativeLegs(int routeIndex, QVector<RouteLeg>& routeLegs, float& distanceMeter) const
+{
+  distanceMeter = 0.f;
+  routeLegs.clear();
+
+  if(routeIndex < 0 || routeIndex >= alternativePaths.size())
+    return;
+
+  const Path& path = alternativePaths.at(routeIndex);
+  routeLegs.reserve(path.nodes.size());
+
+  for(int i = 0; i < path.nodes.size(); i++)
+  {
+    const Node& node = network->getNode(path.nodes.at(i));
+
+    if(i > 0)
+      distanceMeter += network->getNode(path.nodes.at(i - 1)).pos.distanceMeterTo(node.pos);
+
+    if(node.type != NODE_DEPARTURE && node.type != NODE_DESTINATION)
+    {
+      RouteLeg leg;
+      leg.navId = node.id;
+      leg.type = node.type;
+      leg.airwayId = path.edges.at(i).id;
+      leg.pos = node.pos;
+      routeLegs.append(leg);
+    }
+  }
+}
+
+float RouteFinder::getAlternativeRouteCost(int routeIndex) const
+{
+  return routeIndex >= 0 && routeIndex < alternativePaths.size() ? alternativePaths.at(routeIndex).costs.last() : 0.f;
+}
+
+bool RouteFinder::calculateRouteBidirectional()
+{
+  meetingIndex = Node::INVALID_INDEX;
+  meetingCost = std::numeric_limits<int>::max();
+
+  touchReverse(destNode.index);
+  openNodesHeapReverse.pushData(destNode.index, 0);
+  at(nodeCostArrReverse, destNode.index) = 0;
+  at(nodeAltRangeMaxArrReverse, destNode.index) = std::numeric_limits<quint16>::max();
+
+  Node currentNode;
+  while(!openNodesHeap.isEmpty() && !openNodesHeapReverse.isEmpty())
+  {
+    // Stop if no path through any of the open nodes can be cheaper than the best known connection
+    if(meetingIndex != Node::INVALID_INDEX &&
+       std::max(openNodesHeap.peekCost(), openNodesHeapReverse.peekCost()) >= meetingCost)
+      break;
+
+    // Expand the smaller frontier first
+    if(openNodesHeap.size() <= openNodesHeapReverse.size())
+    {
+      currentNode = network->getNode(openNodesHeap.popData());
+
+      if(!invokeCallback(currentNode))
+        return false;
+
+      at(closedNodes, currentNode.index) = true;
+
+      // Do not continue beyond the destination - connection is already recorded in updateMeetingNode()
+      if(currentNode.index != destNode.index && !expandNode(currentNode, at(edgePredecessorArr, currentNode.index)))
+        return false;
+    }
+    else
+    {
+      currentNode = network->getNode(openNodesHeapReverse.popData());
+
+      if(!invokeCallback(currentNode))
+        return false;
+
+      at(closedNodesReverse, currentNode.index) = true;
+
+      if(currentNode.index != startNode.index &&
+         !expandNodeReverse(currentNode, at(edgeSuccessorArr, currentNode.index)))
+        return false;
+    }
+  }
+
+  if(meetingIndex != Node::INVALID_INDEX)
+  {
+    joinPaths();
+    return true;
+  }
+  return false;
+}
+
+void RouteFinder::updateMeetingNode(int index)
+{
+  // Node might be reached by one search only so far
+  touch(index);
+  touchReverse(index);
+
+  // Reached by backward search?
+  int reverseCost = at(nodeCostArrReverse, index);
+  if(reverseCost == std::numeric_limits<int>::max())
+    return;
+
+  // Reached by forward search?
+  if(index != startNode.index && at(nodePredecessorArr, index) == -1)
+    return;
+
+  int cost = at(nodeCostArr, index) + reverseCost;
+  if(cost < meetingCost)
+  {
+    // Check if altitude restrictions of both halves allow a connection
+    quint16 altRangeMin = at(nodeAltRangeMinArr, index);
+    quint16 altRangeMax = at(nodeAltRangeMaxArr, index);
+    if(combineRanges(altRangeMin, altRangeMax, at(nodeAltRangeMinArrReverse, index),
+                     at(nodeAltRangeMaxArrReverse, index)))
+    {
+      meetingCost = cost;
+      meetingIndex = index;
+    }
+  }
+}
+
+void RouteFinder::joinPaths()
+{
+  // Collect the forward chain from meeting point back to start
+  QSet<int> forwardChain;
+  for(int index = meetingIndex; index != -1 && !forwardChain.contains(index); index = at(nodePredecessorArr, index))
+  {
+    forwardChain.insert(index);
+    if(index == startNode.index)
+      break;
+  }
+
+  // Follow successors from meeting point to destination and link them as predecessors
+  int current = meetingIndex;
+  while(current != destNode.index)
+  {
+    int next = at(nodeSuccessorArr, current);
+    if(next == -1)
+      break;
+
+    // Keep the forward predecessor of nodes which are on both chains. Overwriting it would create a cycle.
+    // The path continues from there which cuts out the loop through the meeting point.
+    if(!forwardChain.contains(next))
+    {
+      touch(next);
+      at(nodePredecessorArr, next) = current;
+      at(edgePredecessorArr, next) = at(edgeSuccessorArr, current);
+    }
+    current = next;
+  }
 }
 
 bool RouteFinder::invokeCallback(const atools::routing::Node& currentNode)
@@ -124,6 +868,8 @@ bool RouteFinder::invokeCallback(const atools::routing::Node& currentNode)
 
 bool RouteFinder::expandNode(const atools::routing::Node& currentNode, const atools::routing::Edge& prevEdge)
 {
+  updateStatistics();
+
   successors.clear();
   network->getNeighbours(successors, currentNode, &prevEdge);
 
@@ -134,11 +880,17 @@ bool RouteFinder::expandNode(const atools::routing::Node& currentNode, const ato
   for(int i = 0; i < successors.nodes.size(); i++)
   {
     int successorIndex = successors.nodes.at(i);
+    touch(successorIndex);
 
     if(at(closedNodes, successorIndex))
       // Already has a shortest path
       continue;
 
+    // Exclude nodes and edges removed for the calculation of alternative routes
+    if(bannedNodesArr != nullptr &&
+       (at(bannedNodesArr, successorIndex) || bannedEdges.contains(edgeKey(currentNode.index, successorIndex))))
+      continue;
+
     const Node& successor = network->getNode(successorIndex);
     const Edge& edge = successors.edges.at(i);
 
@@ -146,17 +898,13 @@ bool RouteFinder::expandNode(const atools::routing::Node& currentNode, const ato
     if(!invokeCallback(successor))
       return false;
 
-    int successorEdgeCosts = calculateEdgeCost(currentNode, successor, edge, currentEdgeAirwayHash);
+    int successorEdgeCosts = calculateEdgeCost(currentNode, successor, edge, successors.edgeIndexes.at(i),
+                                               currentEdgeAirwayHash);
 
     int successorNodeCosts = at(nodeCostArr, currentNode.index) + successorEdgeCosts;
-    bool contains = true;
-    if(successorNodeCosts >= at(nodeCostArr, successorIndex))
-    {
-      contains = openNodesHeap.contains(successorIndex);
-      if(contains)
-        // New path is not cheaper
-        continue;
-    }
+    if(successorNodeCosts >= at(nodeCostArr, successorIndex) && openNodesHeap.contains(successorIndex))
+      // New path is not cheaper
+      continue;
 
     quint16 successorNodeAltRangeMin = at(nodeAltRangeMinArr, currentNode.index);
     quint16 successorNodeAltRangeMax = at(nodeAltRangeMaxArr, currentNode.index);
@@ -174,23 +922,145 @@ bool RouteFinder::expandNode(const atools::routing::Node& currentNode, const ato
     at(nodeAltRangeMaxArr, successorIndex) = successorNodeAltRangeMax;
 
     // Costs from start to successor + estimate to destination = sort order in heap
-    int totalCost = successorNodeCosts + network->getGcDistanceMeter(successor, destNode);
+    int totalCost = successorNodeCosts +
+                    static_cast<int>(network->getGcDistanceMeter(successor, destTarget) * heuristicFactor);
 
-    if(contains)
-      // Update node and resort heap or add node if not exists
-      openNodesHeap.changeOrPush(successorIndex, totalCost);
-    else
-      openNodesHeap.push(successorIndex, totalCost);
+    // Update node and resort heap or add node if not exists
+    openNodesHeap.changeOrPush(successorIndex, totalCost);
+
+    if(useTree)
+      updateTreeConnection(successorIndex);
+    else if(bidirectional)
+      updateMeetingNode(successorIndex);
   }
   return true;
 }
 
+bool RouteFinder::expandNodeReverse(const atools::routing::Node& currentNode, const atools::routing::Edge& nextEdge)
+{
+  updateStatistics();
+
+  predecessors.clear();
+  network->getNeighboursReverse(predecessors, currentNode, &nextEdge);
+
+  quint32 currentEdgeAirwayHash = 0;
+  if(network->isAirwayRouting())
+    currentEdgeAirwayHash = at(edgeNameHashArrReverse, currentNode.index);
+
+  for(int i = 0; i < predecessors.nodes.size(); i++)
+  {
+    int predecessorIndex = predecessors.nodes.at(i);
+    touchReverse(predecessorIndex);
+
+    if(at(closedNodesReverse, predecessorIndex))
+      // Already has a shortest path to destination
+      continue;
+
+    const Node& predecessor = network->getNode(predecessorIndex);
+    const Edge& edge = predecessors.edges.at(i);
+
+    if(!invokeCallback(predecessor))
+      return false;
+
+    // Edge leads from predecessor to current node
+    int predecessorNodeCosts = at(nodeCostArrReverse, currentNode.index) +
+                               calculateEdgeCost(predecessor, currentNode, edge, predecessors.edgeIndexes.at(i),
+                                                 currentEdgeAirwayHash);
+
+    if(predecessorNodeCosts >= at(nodeCostArrReverse, predecessorIndex))
+      // New path is not cheaper
+      continue;
+
+    quint16 predecessorAltRangeMin = at(nodeAltRangeMinArrReverse, currentNode.index);
+    quint16 predecessorAltRangeMax = at(nodeAltRangeMaxArrReverse, currentNode.index);
+
+    if(!combineRanges(predecessorAltRangeMin, predecessorAltRangeMax, edge.minAltFt, edge.maxAltFt))
+      continue;
+
+    // New path is cheaper - update node
+    at(edgeSuccessorArr, predecessorIndex) = edge;
+    if(network->isAirwayRouting())
+      at(edgeNameHashArrReverse, predecessorIndex) = edge.airwayHash;
+    at(nodeSuccessorArr, predecessorIndex) = currentNode.index;
+    at(nodeCostArrReverse, predecessorIndex) = predecessorNodeCosts;
+    at(nodeAltRangeMinArrReverse, predecessorIndex) = predecessorAltRangeMin;
+    at(nodeAltRangeMaxArrReverse, predecessorIndex) = predecessorAltRangeMax;
+
+    // Costs from predecessor to destination + estimate to departure
+    int totalCost = predecessorNodeCosts +
+                    static_cast<int>(network->getGcDistanceMeter(predecessor, startTarget) * heuristicFactor);
+    openNodesHeapReverse.changeOrPush(predecessorIndex, totalCost);
+
+    updateMeetingNode(predecessorIndex);
+  }
+  return true;
+}
+
+bool RouteFinder::isWindCosts() const
+{
+  return windCache != nullptr && !windCache->isEmpty() && trueAirspeed > 0.f;
+}
+
+void RouteFinder::initWindCosts()
+{
+  departureWind = destinationWind = atools::geo::Point3D();
+  heuristicFactor = 1.f;
+  useWindCosts = isWindCosts();
+
+  if(useWindCosts)
+  {
+    if(altitude > 0 && std::abs(windCache->getAltitude() - altitude) > 1000.f)
+      qWarning() << Q_FUNC_INFO << "Wind cache altitude" << windCache->getAltitude() << "differs from" << altitude;
+
+    departureWind = windCache->getWindVector(network->getNearestNode(startNode.pos).index);
+    destinationWind = windCache->getWindVector(network->getNearestNode(destNode.pos).index);
+
+    // Costs for an edge cannot get lower than for the maximum tail wind
+    heuristicFactor = trueAirspeed / (trueAirspeed + windCache->getMaxWindSpeed());
+  }
+}
+
+atools::geo::Point3D RouteFinder::nodePoint(const atools::routing::Node& node) const
+{
+  if(node.isDeparture())
+    return startTarget.getTarget();
+  else if(node.isDestination())
+    return destTarget.getTarget();
+  else
+    return network->getDistanceTarget(node).getTarget();
+}
+
+atools::geo::Point3D RouteFinder::nodeWind(const atools::routing::Node& node) const
+{
+  if(node.isDeparture())
+    return departureWind;
+  else if(node.isDestination())
+    return destinationWind;
+  else
+    return windCache->getWindVector(node.index);
+}
+
+float RouteFinder::windCostFactor(const atools::routing::Node& currentNode,
+                                  const atools::routing::Node& successorNode, int edgeIndex) const
+{
+  // Stored edges use precalculated values and generated edges the average of the node winds
+  float headWind = edgeIndex != -1 ? windCache->getHeadWind(edgeIndex) :
+                   RouteWindCache::getHeadWind(nodePoint(currentNode), nodePoint(successorNode),
+                                               nodeWind(currentNode), nodeWind(successorNode));
+
+  return trueAirspeed / std::max(trueAirspeed - headWind, trueAirspeed * MIN_GROUND_SPEED_FACTOR);
+}
+
 int RouteFinder::calculateEdgeCost(const atools::routing::Node& currentNode,
                                    const atools::routing::Node& successorNode,
-                                   const atools::routing::Edge& edge, quint32 currentEdgeAirwayHash)
+                                   const atools::routing::Edge& edge, int edgeIndex, quint32 currentEdgeAirwayHash)
 {
   float costs = edge.lengthMeter;
 
+  if(useWindCosts)
+    // Use air distance which is proportional to flying time
+    costs *= windCostFactor(currentNode, successorNode, edgeIndex);
+
   if(currentNode.type == NODE_DEPARTURE && successorNode.type == NODE_DESTINATION)
     // Avoid direct connections between departure and destination
     costs *= COST_FACTOR_DIRECT;
@@ -258,30 +1128,73 @@ void RouteFinder::extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter
   Node pred = network->getDestinationNode();
   while(pred.index != -1)
   {
-    if(pred.type != NODE_DEPARTURE && pred.type != NODE_DESTINATION)
+    const Edge& predEdge = at(edgePredecessorArr, pred.index);
+    Node next = network->getNode(at(nodePredecessorArr, pred.index));
+
+    if(predEdge.shortcut)
     {
-      RouteLeg leg;
-      leg.navId = pred.id;
-      leg.type = pred.type;
-      leg.airwayId = at(edgePredecessorArr, pred.index).id;
-      leg.pos = pred.pos;
-      routeLegs.prepend(leg);
+      // Add all nodes skipped by the shortcut edge from end to start - start node is added as next predecessor
+      EdgeRange chainEdges = network->getShortcutEdges(predEdge);
+      for(const Edge *edge = chainEdges.end(); edge != chainEdges.begin();)
+      {
+        --edge;
+        const Node& node = network->getNode(edge->toIndex);
+        RouteLeg leg;
+        leg.navId = node.id;
+        leg.type = node.type;
+        leg.airwayId = edge->id;
+        leg.pos = node.pos;
+        routeLegs.prepend(leg);
+
+        const Node& chainPred = edge == chainEdges.begin() ? next : network->getNode((edge - 1)->toIndex);
+        distanceMeter += node.pos.distanceMeterTo(chainPred.pos);
+      }
     }
+    else
+    {
+      if(pred.type != NODE_DEPARTURE && pred.type != NODE_DESTINATION)
+      {
+        RouteLeg leg;
+        leg.navId = pred.id;
+        leg.type = pred.type;
+        leg.airwayId = predEdge.id;
+        leg.pos = pred.pos;
+        routeLegs.prepend(leg);
+      }
 
-    Node next = network->getNode(at(nodePredecessorArr, pred.index));
-    if(next.pos.isValid())
-      distanceMeter += pred.pos.distanceMeterTo(next.pos);
+      if(next.pos.isValid())
+        distanceMeter += pred.pos.distanceMeterTo(next.pos);
+    }
     pred = next;
   }
 }
 
 void RouteFinder::allocArrays()
 {
-  freeArrays();
   // Reserve space at beginning for start and destination node
   // Relies on RouteNetwork::DEPARTURE_NODE_INDEX and RouteNetwork::DESTINATION_NODE_INDEX
-  int num = network->getNodes().size() + 3;
+  int num = network->getNumNodes() + 3;
+
+  if(num == arraySize && (!bidirectional || closedNodesReverse != nullptr) &&
+     generation < std::numeric_limits<quint32>::max())
+  {
+    // Reuse arrays of the last calculation. Values of all nodes become invalid and are reset by touch()
+    // when accessed for the first time.
+    generation++;
+    openNodesHeap.clear();
+    if(bidirectional)
+      openNodesHeapReverse.clear();
+    return;
+  }
+
+  freeArrays();
+  arraySize = num;
+  generation = 1;
 
+  // Position map of heap uses same offset as arrays
+  openNodesHeap.resize(num, 3);
+
+  nodeGenerationArr = atools::allocArray<quint32>(num);
   edgeNameHashArr = atools::allocArray<quint32>(num);
   nodeCostArr = atools::allocArray<int>(num);
   nodeAltRangeMinArr = atools::allocArray<quint16>(num);
@@ -289,10 +1202,64 @@ void RouteFinder::allocArrays()
   nodePredecessorArr = atools::allocArray<int>(num, -1);
   edgePredecessorArr = atools::allocArray<Edge>(num, Edge());
   closedNodes = atools::allocArray<bool>(num);
+
+  if(bidirectional)
+  {
+    openNodesHeapReverse.resize(num, 3);
+    nodeGenerationArrReverse = atools::allocArray<quint32>(num);
+    edgeNameHashArrReverse = atools::allocArray<quint32>(num);
+    nodeCostArrReverse = atools::allocArray<int>(num, std::numeric_limits<int>::max());
+    nodeAltRangeMinArrReverse = atools::allocArray<quint16>(num);
+    nodeAltRangeMaxArrReverse = atools::allocArray<quint16>(num);
+    nodeSuccessorArr = atools::allocArray<int>(num, -1);
+    edgeSuccessorArr = atools::allocArray<Edge>(num, Edge());
+    closedNodesReverse = atools::allocArray<bool>(num);
+  }
+}
+
+void RouteFinder::touch(int index)
+{
+  quint32& nodeGeneration = at(nodeGenerationArr, index);
+  if(nodeGeneration != generation)
+  {
+    // First access in this calculation - reset values left from previous calculations
+    nodeGeneration = generation;
+    at(edgeNameHashArr, index) = 0;
+    at(nodeCostArr, index) = 0;
+    at(nodeAltRangeMinArr, index) = 0;
+    at(nodeAltRangeMaxArr, index) = 0;
+    at(nodePredecessorArr, index) = -1;
+    at(edgePredecessorArr, index) = Edge();
+    at(closedNodes, index) = false;
+  }
+}
+
+void RouteFinder::touchReverse(int index)
+{
+  quint32& nodeGeneration = at(nodeGenerationArrReverse, index);
+  if(nodeGeneration != generation)
+  {
+    nodeGeneration = generation;
+    at(edgeNameHashArrReverse, index) = 0;
+    at(nodeCostArrReverse, index) = std::numeric_limits<int>::max();
+    at(nodeAltRangeMinArrReverse, index) = 0;
+    at(nodeAltRangeMaxArrReverse, index) = 0;
+    at(nodeSuccessorArr, index) = -1;
+    at(edgeSuccessorArr, index) = Edge();
+    at(closedNodesReverse, index) = false;
+  }
+}
+
+bool RouteFinder::isTouchedReverse(int index) const
+{
+  return nodeGenerationArrReverse != nullptr && at(nodeGenerationArrReverse, index) == generation;
 }
 
 void RouteFinder::freeArrays()
 {
+  arraySize = 0;
+  atools::freeArray(nodeGenerationArr);
+  atools::freeArray(nodeGenerationArrReverse);
   atools::freeArray(edgeNameHashArr);
   atools::freeArray(nodeCostArr);
   atools::freeArray(nodeAltRangeMinArr);
@@ -300,6 +1267,14 @@ void RouteFinder::freeArrays()
   atools::freeArray(nodePredecessorArr);
   atools::freeArray(edgePredecessorArr);
   atools::freeArray(closedNodes);
+
+  atools::freeArray(edgeNameHashArrReverse);
+  atools::freeArray(nodeCostArrReverse);
+  atools::freeArray(nodeAltRangeMinArrReverse);
+  atools::freeArray(nodeAltRangeMaxArrReverse);
+  atools::freeArray(nodeSuccessorArr);
+  atools::freeArray(edgeSuccessorArr);
+  atools::freeArray(closedNodesReverse);
 }
 
 QDebug operator<<(QDebug out, const RouteLeg& obj)
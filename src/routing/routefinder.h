@@ -19,12 +19,16 @@
 #define ATOOLS_ROUTEFINDER_H
 
 #include "util/heap.h"
+#include "geo/point3d.h"
 #include "routing/routenetworktypes.h"
 
+#include <QSet>
+
 namespace atools {
 namespace routing {
 
 class RouteNetwork;
+class RouteWindCache;
 
 struct RouteLeg
 {
@@ -40,16 +44,27 @@ struct RouteLeg
 /*
  * Calculates flight plans within a route network which can be an airway or radio navaid network.
  * Uses A* algorithm and several cost factor adjustments to get reasonable routes.
+ * Shortcut edges of the network are used for pure airway modes and expanded to the skipped nodes in extractLegs().
  *
  * The class has a state (i.e. start and destination) and is not re-entrant.
+ * Use the constructor taking a const network reference to run several route finders concurrently on the same
+ * loaded network.
  */
 class RouteFinder
 {
 public:
-  /* Creates a route finder that uses the given network */
+  /* Creates a route finder that uses the given network. Parameters are set in the given network. */
   RouteFinder(RouteNetwork *routeNetwork);
+
+  /* Creates a route finder that uses a private copy of the network sharing the read-only graph.
+   * Instances created this way can be used in parallel from different threads. */
+  RouteFinder(const RouteNetwork& sharedNetwork);
+
   virtual ~RouteFinder();
 
+  RouteFinder(const RouteFinder& other) = delete;
+  RouteFinder& operator=(const RouteFinder& other) = delete;
+
   /*
    * Calculates a flight plan between two points. The points are added to the network but will not be returned
    * in extractRoute.
@@ -63,6 +78,30 @@ public:
   /* Extract legs of shortest route and distance not including departure and destination. */
   void extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter) const;
 
+  /*
+   * Calculates up to numRoutes cheapest loopless flight plans using Yen's algorithm. The first route is the same
+   * as returned by calculateRoute(). Alternatives deviate from previous routes at one or more nodes.
+   * A reverse shortest path tree from the destination is built once after the first route. Spur searches stop
+   * as soon as no open node can give a cheaper connection into this tree than the best one found so far,
+   * i.e. they explore only the area around the deviation. Tree paths passing the root path are not used.
+   * Bidirectional search is not used. The tree is kept for recalculateRoute() if incremental.
+   * @return true if at least one route was found and callback did not cancel
+   */
+  bool calculateAlternativeRoutes(const atools::geo::Pos& from, const atools::geo::Pos& to, int flownAltitude,
+                                  Modes mode, int numRoutes);
+
+  /* Number of routes found by calculateAlternativeRoutes(). Sorted by costs ascending. */
+  int getNumAlternativeRoutes() const
+  {
+    return alternativePaths.size();
+  }
+
+  /* Same as extractLegs() for a route calculated by calculateAlternativeRoutes(). */
+  void extractAlternativeLegs(int routeIndex, QVector<RouteLeg>& routeLegs, float& distanceMeter) const;
+
+  /* Costs used for ranking of a route found by calculateAlternativeRoutes(). */
+  float getAlternativeRouteCost(int routeIndex) const;
+
   const RouteNetwork *getNetwork() const
   {
     return network;
@@ -84,14 +123,150 @@ public:
     costFactorForceAirways = value;
   }
 
+  /* Statistics of the last calculation. Reset when calling calculateRoute(). */
+  int getNumExpandedNodes() const
+  {
+    return numExpandedNodes;
+  }
+
+  /* Maximum number of open nodes in heap or heaps for bidirectional search */
+  int getMaxHeapSize() const
+  {
+    return maxHeapSize;
+  }
+
+  /* Search forward from departure and backward from destination at the same time and meet in the middle.
+   * Reduces the number of expanded nodes on long routes. Default is false. */
+  void setBidirectional(bool value)
+  {
+    bidirectional = value;
+  }
+
+  bool isBidirectional() const
+  {
+    return bidirectional;
+  }
+
+  /* Use flying time instead of distance as base for edge costs. Distance is multiplied with true airspeed
+   * divided by ground speed using the head wind components from the cache.
+   * The cache should be built for the flown altitude and is not owned. Disabled if cache is null or speed is 0. */
+  void setWindCosts(const atools::routing::RouteWindCache *cache, float trueAirspeedKts)
+  {
+    windCache = cache;
+    trueAirspeed = trueAirspeedKts;
+  }
+
+  bool isWindCosts() const;
+
+  /* Keep the costs to the destination for all nodes of the found route and nodes settled by the backward search
+   * after each calculation. These form a tree of known paths to the destination which allows recalculateRoute()
+   * to search only from a new departure until it reaches the tree. Needs three more arrays over all nodes.
+   * Default is false. */
+  void setIncremental(bool value)
+  {
+    incremental = value;
+  }
+
+  bool isIncremental() const
+  {
+    return incremental;
+  }
+
+  /*
+   * Calculates a route from a new departure position like the current aircraft position to the destination
+   * of the last calculation using the same altitude and mode. See setIncremental().
+   * The search stops as soon as no open node can give a cheaper route than the best connection into the tree.
+   * Costs in the tree are not recalculated. Call invalidateNodes() or clearIncremental() if costs have changed.
+   * Falls back to calculateRoute() if no tree is available.
+   * @return true if a route was found and callback did not cancel
+   */
+  bool recalculateRoute(const atools::geo::Pos& from);
+
+  /* Remove nodes from the destination tree, e.g. if costs of attached edges changed or a track was removed.
+   * Also removes all nodes which lead to the destination through one of these. Uses network node indexes. */
+  void invalidateNodes(const QVector<int>& nodeIndexes);
+
+  /* Remove the destination tree. Call if costs changed for the whole network like for new wind data. */
+  void clearIncremental();
+
 private:
+  /* Path found by the search in node order. Vectors have the same size and values are taken from the arrays.
+   * Edge at index i leads to node at index i. */
+  struct Path
+  {
+    QVector<int> nodes, costs;
+    QVector<atools::routing::Edge> edges;
+    QVector<quint16> altRangeMin, altRangeMax;
+  };
+
+  /* Main A* loop working on contents of openNodesHeap. Returns true if destination was found. */
+  bool search();
+
+  /* Build path from node toIndex back to node fromIndex using predecessor arrays */
+  Path pathFromArrays(int fromIndex, int toIndex) const;
+
+  /* Reverse search from destination filling the tree for alternative routes. Covers all nodes with costs up to
+   * maxCost including the estimate to the departure. Returns false if callback canceled. */
+  bool buildAlternativeTree(int maxCost);
+
+  /* Append the tree path from the last node of path to the destination */
+  void appendTreePath(Path& path) const;
+
+  /* Remove loops which can appear if a tree path crosses the spur path due to airway change costs */
+  static void removeLoops(Path& path);
+
+  /* true if the tree path from node index to destination does not pass the spur node or a banned node.
+   * Results are cached per spur search using treeStamp. */
+  bool isTreePathValid(int index);
+
+  static quint64 edgeKey(int fromIndex, int toIndex)
+  {
+    return (static_cast<quint64>(static_cast<quint32>(fromIndex)) << 32) | static_cast<quint32>(toIndex);
+  }
+
+  /* Loop for bidirectional search. Returns true if a route was found and callback did not cancel. */
+  bool calculateRouteBidirectional();
+
   /* Expands a node by investigating all successors */
   bool expandNode(const atools::routing::Node& node, const Edge& prevEdge);
 
+  /* Expands a node in the backward search by investigating all predecessors */
+  bool expandNodeReverse(const atools::routing::Node& node, const Edge& nextEdge);
+
+  /* Check if node was reached by both searches and remember it if path costs are lower */
+  void updateMeetingNode(int index);
+
+  /* Copy backward path from meeting node to destination into predecessor arrays for extractLegs */
+  void joinPaths();
+
+  /* Remember connection into the destination tree if it gives the cheapest route so far */
+  void updateTreeConnection(int index);
+
+  /* Copy path from meeting node to destination as given by the tree into predecessor arrays */
+  void joinTree();
+
+  /* Add nodes of the found route and the settled nodes of the backward search to the destination tree */
+  void updateTree(bool reverseSearched);
+
+  /* Allocate tree arrays. Altitude ranges and validity are needed only for alternative routes. */
+  void allocTree(bool alternatives = false);
+  void freeTree();
+
   /* Calculates the costs to travel from current to successor. Base is the distance between the nodes in meter that
    * will have several factors applied to get reasonable routes */
   int calculateEdgeCost(const atools::routing::Node& node, const atools::routing::Node& successorNode,
-                        const Edge& edge, quint32 currentEdgeAirwayHash);
+                        const Edge& edge, int edgeIndex, quint32 currentEdgeAirwayHash);
+
+  /* Prepare winds for departure and destination and the heuristic factor for wind costs */
+  void initWindCosts();
+
+  /* Factor for edge length to get air distance. edgeIndex is -1 for generated edges. */
+  float windCostFactor(const atools::routing::Node& node, const atools::routing::Node& successorNode,
+                       int edgeIndex) const;
+
+  /* Position in 3D space and wind vector including departure and destination */
+  atools::geo::Point3D nodePoint(const atools::routing::Node& node) const;
+  atools::geo::Point3D nodeWind(const atools::routing::Node& node) const;
 
   bool combineRanges(quint16& min1, quint16& max1, quint16 min, quint16 max)
   {
@@ -105,6 +280,14 @@ private:
 
   void freeArrays();
   void allocArrays();
+
+  /* Reset values of node in arrays for forward or backward search if not accessed yet in this calculation.
+   * Has to be called before first access of a node. */
+  void touch(int index);
+  void touchReverse(int index);
+
+  /* true if node was accessed by backward search in this calculation */
+  bool isTouchedReverse(int index) const;
   bool invokeCallback(const Node& currentNode);
 
   /* Avoid direct waypoint connections when using airways */
@@ -133,20 +316,51 @@ private:
   /* Avoid airway changes during routing */
   static Q_DECL_CONSTEXPR float COST_FACTOR_AIRWAY_CHANGE = 1.1f;
 
+  /* Reverse tree for alternative routes covers nodes up to this factor of the costs of the shortest route */
+  static Q_DECL_CONSTEXPR float ALTERNATIVE_TREE_COST_FACTOR = 1.5f;
+
+  /* Lowest ground speed as fraction of true airspeed for wind costs */
+  static Q_DECL_CONSTEXPR float MIN_GROUND_SPEED_FACTOR = 0.25f;
+
+  /* Winds for costs or null if not used */
+  const atools::routing::RouteWindCache *windCache = nullptr;
+  float trueAirspeed = 0.f;
+
+  /* Wind costs enabled for the current calculation */
+  bool useWindCosts = false;
+
+  /* Winds at the nodes nearest to departure and destination */
+  atools::geo::Point3D departureWind, destinationWind;
+
+  /* Scales the distance heuristic to keep it below the costs for maximum tail wind */
+  float heuristicFactor = 1.f;
+
   /* Altitude to use  for airway selection of 0 if not used */
   int altitude = 0;
 
   /* Used network */
   atools::routing::RouteNetwork *network;
 
+  /* Private copy if created with a shared network. Deleted in destructor. */
+  atools::routing::RouteNetwork *ownedNetwork = nullptr;
+
   /* Heap structure storing the index of open nodes. Costs are based on meters plus factors as integer.
-   * Sort order is defined by costs from start to node + estimate to destination */
-  atools::util::Heap<int, int> openNodesHeap;
+   * Sort order is defined by costs from start to node + estimate to destination.
+   * Indexed to allow fast lookup and cost updates of contained nodes. */
+  atools::util::IndexedHeap<int> openNodesHeap;
 
   /* Using plain arrays below to speed up access compared to hash tables
    * Positions 0 and 1 are reserved for departure and destination. 2 is invalid.
    * 3 corresponds to first index in nodeIndex.*/
 
+  /* Size of all arrays below. Arrays are reused by allocArrays() if the size of the network does not change. */
+  int arraySize = 0;
+
+  /* Incremented for each calculation. Values for a node are only valid if the generation stored for the node is
+   * equal. Otherwise these are reset on first access by touch() which avoids clearing all arrays. */
+  quint32 generation = 0;
+  quint32 *nodeGenerationArr = nullptr, *nodeGenerationArrReverse = nullptr;
+
   /* Nodes that have been processed already and have a known shortest path */
   bool *closedNodes = nullptr;
 
@@ -167,10 +381,74 @@ private:
   /* Airway name hash value for edge at index */
   quint32 *edgeNameHashArr = nullptr;
 
+  /* Same as above for the backward search from destination if bidirectional.
+   * Costs are from node to destination and initialized with max int for unknown. */
+  atools::util::IndexedHeap<int> openNodesHeapReverse;
+  bool *closedNodesReverse = nullptr;
+  int *nodeCostArrReverse = nullptr;
+  quint16 *nodeAltRangeMinArrReverse = nullptr;
+  quint16 *nodeAltRangeMaxArrReverse = nullptr;
+
+  /* Maps node index to successor node id and edge on the way to the destination */
+  int *nodeSuccessorArr = nullptr;
+  atools::routing::Edge *edgeSuccessorArr = nullptr;
+  quint32 *edgeNameHashArrReverse = nullptr;
+
+  /* Node where both searches met with lowest total costs */
+  int meetingIndex = Node::INVALID_INDEX;
+  int meetingCost = std::numeric_limits<int>::max();
+
+  bool bidirectional = false;
+
+  /* Known costs from node to destination and next node and edge on the way. Null if not used.
+   * Costs are max int for nodes not in the tree. */
+  int *treeCostArr = nullptr;
+  int *treeNextArr = nullptr;
+  atools::routing::Edge *treeEdgeArr = nullptr;
+  int treeSize = 0;
+
+  /* Altitude range of the path from node to destination. Only allocated for alternative routes. */
+  quint16 *treeAltRangeMinArr = nullptr, *treeAltRangeMaxArr = nullptr;
+
+  /* Result of isTreePathValid() which is valid if the stamp for a node is equal to treeStamp */
+  quint32 *treeStampArr = nullptr;
+  bool *treeValidArr = nullptr;
+  quint32 treeStamp = 0;
+
+  /* Node where the current spur search starts */
+  int spurNodeIndex = Node::INVALID_INDEX;
+
+  /* Avoids allocations in isTreePathValid() */
+  QVector<int> treeChain;
+
+  bool incremental = false;
+
+  /* Search connects to the destination tree */
+  bool useTree = false;
+
+  /* Routes found by calculateAlternativeRoutes() */
+  QVector<Path> alternativePaths;
+
+  /* Nodes and edges not to be used in spur searches for alternative routes. Array is null if not used. */
+  bool *bannedNodesArr = nullptr;
+  QSet<quint64> bannedEdges;
+
   atools::routing::Node startNode, destNode;
 
-  /* For RouteNetwork::getNeighbours to avoid instantiations */
-  atools::routing::Result successors;
+  /* Precalculated targets for the distance heuristic of the forward and reverse search */
+  atools::geo::Point3DTarget startTarget, destTarget;
+
+  /* For RouteNetwork::getNeighbours and getNeighboursReverse to avoid instantiations */
+  atools::routing::Result successors, predecessors;
+
+  /* Statistics */
+  int numExpandedNodes = 0, maxHeapSize = 0;
+
+  void updateStatistics()
+  {
+    numExpandedNodes++;
+    maxHeapSize = std::max(maxHeapSize, openNodesHeap.size() + openNodesHeapReverse.size());
+  }
 
   RouteFinderCallbackType callback;
   int totalDist = 0;
@@ -0,0 +1,129 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "routing/routematrix.h"
+
+#include "routing/routenetwork.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <algorithm>
+
+namespace atools {
+namespace routing {
+
+RouteMatrix::RouteMatrix(const RouteNetwork& routeNetwork)
+  : network(routeNetwork)
+{
+}
+
+QVector<RouteMatrixResult> RouteMatrix::calculate(const QVector<RouteMatrixPair>& pairs, int flownAltitude,
+                                                  Modes mode)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QVector<RouteMatrixResult> results(pairs.size());
+
+  // Group pair indexes by destination ==========================================
+  QVector<QVector<int> > groups;
+  if(reuseTrees)
+  {
+    QHash<atools::geo::Pos, int> destGroupMap;
+    for(int i = 0; i < pairs.size(); i++)
+    {
+      auto it = destGroupMap.constFind(pairs.at(i).to);
+      if(it == destGroupMap.constEnd())
+      {
+        destGroupMap.insert(pairs.at(i).to, groups.size());
+        groups.append(QVector<int>({i}));
+      }
+      else
+        groups[it.value()].append(i);
+    }
+  }
+  else
+  {
+    for(int i = 0; i < pairs.size(); i++)
+      groups.append(QVector<int>({i}));
+  }
+
+  numGroups = groups.size();
+  numThreads = std::max(1, std::min(QThread::idealThreadCount(), numGroups));
+
+  // Distribute groups to threads - largest first to the thread having the least pairs ====================
+  std::sort(groups.begin(), groups.end(), [](const QVector<int>& group1, const QVector<int>& group2) -> bool {
+    return group1.size() > group2.size();
+  });
+
+  QVector<QVector<const QVector<int> *> > threadGroups(numThreads);
+  QVector<int> threadLoad(numThreads, 0);
+  for(const QVector<int>& group : groups)
+  {
+    int thread = static_cast<int>(std::min_element(threadLoad.constBegin(), threadLoad.constEnd()) -
+                                  threadLoad.constBegin());
+    threadGroups[thread].append(&group);
+    threadLoad[thread] += group.size();
+  }
+
+  // Calculate ==========================================
+  // Pointers are captured before starting threads - each result index is written by one thread only
+  RouteMatrixResult *resultsPtr = results.data();
+  const RouteMatrixPair *pairsPtr = pairs.constData();
+  const QVector<QVector<const QVector<int> *> > *threadGroupsPtr = &threadGroups;
+
+  atools::util::parallelFor(numThreads, [this, resultsPtr, pairsPtr, threadGroupsPtr, flownAltitude,
+                                         mode](int thread) -> void {
+    // Finder keeps its arrays and uses a private copy of the network sharing the graph
+    RouteFinder finder(network);
+    finder.setBidirectional(bidirectional);
+    finder.setCostFactorForceAirways(costFactorForceAirways);
+    finder.setWindCosts(windCache, trueAirspeed);
+    finder.setIncremental(reuseTrees);
+
+    for(const QVector<int> *group : threadGroupsPtr->at(thread))
+    {
+      for(int i = 0; i < group->size(); i++)
+      {
+        int pairIndex = group->at(i);
+        const RouteMatrixPair& pair = pairsPtr[pairIndex];
+        RouteMatrixResult& result = resultsPtr[pairIndex];
+
+        if(i == 0 || !reuseTrees)
+          result.found = finder.calculateRoute(pair.from, pair.to, flownAltitude, mode);
+        else
+          // Same destination as before
+          result.found = finder.recalculateRoute(pair.from);
+
+        result.numExpandedNodes = finder.getNumExpandedNodes();
+        if(result.found)
+          finder.extractLegs(result.legs, result.distanceMeter);
+      }
+    }
+  }, 1);
+
+  qDebug() << Q_FUNC_INFO << "pairs" << pairs.size() << "groups" << numGroups << "threads" << numThreads
+           << timer.elapsed() << "ms";
+
+  return results;
+}
+
+} // namespace routing
+} // namespace atools
@@ -0,0 +1,122 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ROUTEMATRIX_H
+#define ATOOLS_ROUTEMATRIX_H
+
+#include "routing/routefinder.h"
+
+namespace atools {
+namespace routing {
+
+class RouteNetwork;
+class RouteWindCache;
+
+/* Departure and destination for one route of a batch */
+struct RouteMatrixPair
+{
+  RouteMatrixPair()
+  {
+  }
+
+  RouteMatrixPair(const atools::geo::Pos& fromParam, const atools::geo::Pos& toParam)
+    : from(fromParam), to(toParam)
+  {
+  }
+
+  atools::geo::Pos from, to;
+};
+
+/* Result for one pair. Same as RouteFinder::extractLegs() returns. */
+struct RouteMatrixResult
+{
+  bool found = false;
+  QVector<atools::routing::RouteLeg> legs;
+  float distanceMeter = 0.f;
+  int numExpandedNodes = 0;
+};
+
+/*
+ * Calculates routes for many departure and destination pairs on a shared loaded network.
+ *
+ * Pairs are grouped by destination and groups are distributed over the shared task scheduler. Each thread uses
+ * its own RouteFinder on a private copy of the network which keeps its arrays between calculations.
+ * Pairs of one group reuse the tree of known paths to the destination using RouteFinder::recalculateRoute().
+ *
+ * The network must not be changed or reloaded while calculate() runs.
+ */
+class RouteMatrix
+{
+public:
+  /* Network is not copied and must be valid until calculate() returns */
+  RouteMatrix(const atools::routing::RouteNetwork& routeNetwork);
+
+  RouteMatrix(const RouteMatrix& other) = delete;
+  RouteMatrix& operator=(const RouteMatrix& other) = delete;
+
+  /* Calculates routes for all pairs at the given altitude and mode. Results are in the same order as pairs. */
+  QVector<atools::routing::RouteMatrixResult> calculate(const QVector<atools::routing::RouteMatrixPair>& pairs,
+                                                        int flownAltitude, atools::routing::Modes mode);
+
+  /* Options passed to each RouteFinder. See there. */
+  void setBidirectional(bool value)
+  {
+    bidirectional = value;
+  }
+
+  void setCostFactorForceAirways(float value)
+  {
+    costFactorForceAirways = value;
+  }
+
+  void setWindCosts(const atools::routing::RouteWindCache *cache, float trueAirspeedKts)
+  {
+    windCache = cache;
+    trueAirspeed = trueAirspeedKts;
+  }
+
+  /* Reuse search results for pairs having the same destination. Default is true.
+   * Routes can differ in rare cases from a full calculation since airway change penalties and altitude restrictions
+   * are not evaluated again for the reused part of a path. */
+  void setReuseTrees(bool value)
+  {
+    reuseTrees = value;
+  }
+
+  /* Statistics of the last calculation */
+  int getNumGroups() const
+  {
+    return numGroups;
+  }
+
+  int getNumThreads() const
+  {
+    return numThreads;
+  }
+
+private:
+  const atools::routing::RouteNetwork& network;
+  const atools::routing::RouteWindCache *windCache = nullptr;
+  float trueAirspeed = 0.f, costFactorForceAirways = 1.3f;
+  bool bidirectional = false, reuseTrees = true;
+  int numGroups = 0, numThreads = 0;
+};
+
+} // namespace routing
+} // namespace atools
+
+#endif // ATOOLS_ROUTEMATRIX_H
@@ -19,6 +19,8 @@
 
 #include "geo/calculations.h"
 
+#include <QDebug>
+
 using atools::geo::nmToMeter;
 using atools::geo::Point3D;
 
@@ -26,7 +28,7 @@ namespace atools {
 namespace routing {
 
 RouteNetwork::RouteNetwork(atools::routing::DataSource dataSource)
-  : source(dataSource)
+  : data(new RouteNetworkData), source(dataSource)
 {
   // Default values
   nearestDepartureDistanceM = nmToMeter(500.f);
@@ -41,6 +43,8 @@ RouteNetwork::RouteNetwork(atools::routing::DataSource dataSource)
   directDistanceFactorRadio = 1.2f;
   directDistanceFactorWp = 1.05f;
   directDistanceFactorAirway = 1.2f;
+
+  updateMatchTables();
 }
 
 RouteNetwork::~RouteNetwork()
@@ -59,59 +63,49 @@ void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge
   // Check for track/non-track or non-track/track tansition if true
   // Limits neighbours if origin is in the middle of a track and not an endpoint
   bool originNotTrackEnd = source == SOURCE_AIRWAY && mode & MODE_TRACK &&
-                           prevEdge != nullptr && !origin.isTrackStartEnd();
+                           prevEdge != nullptr && !(getNodeConnections(origin) & CONNECTION_TRACK_START_END);
 
   if(source == SOURCE_AIRWAY)
   {
     // Add airway edges =======================================
-    result.nodes.reserve(origin.edges.size());
-    result.edges.reserve(origin.edges.size());
+    EdgeRange edges = getEdges(origin);
+    result.reserve(edges.size());
 
     // Avoid duplicates with direct neighbor search
     QSet<int> nodeIndexes;
 
     if(mode & MODE_AIRWAY)
     {
+      // Skip nodes in the middle of airways if direct connections are not needed
+      bool useShortcuts = shortcutsEnabled && !data->edgeShortcuts.isEmpty() && !(mode & MODE_WAYPOINT);
+
       // Look at all node edges/airways
-      for(const Edge& edge : origin.edges)
+      for(const Edge& airwayEdge : edges)
       {
-        // Check if edge type matches criteria (altitude, RNAV and airway type)
-        if(!matchEdge(edge))
-          continue;
-
-        const Node& node = nodeIndex.at(edge.toIndex);
-        // Check if node type matches like airway type
-        if(!matchNode(node))
-          continue;
-
-        // Avoid track transitions at the wrong points
-        if(originNotTrackEnd &&
-           // Do not traverse between track and airway
-           (prevEdge->isTrack() != edge.isTrack() ||
-            // and not between different tracks
-            (prevEdge->isTrack() && edge.isTrack() && prevEdge->airwayHash != edge.airwayHash)))
-          continue;
-
-        // Edge can have only another node - not departure or destination
-        Point3D curPoint = nodeIndex.atPoint3D(edge.toIndex);
-        float curToDestDist = curPoint.directDistanceMeter(destinationPoint);
-
-        // Add only nodes/edges that are ahead of the current node and lead towards the destination
-        if(curToDestDist < originToDestDist)
+        const Edge *edgePtr = &airwayEdge;
+        if(useShortcuts)
         {
-          float curToOriginDist = curPoint.directDistanceMeter(originPoint);
-          if(curToDestDist + curToOriginDist < originToDestDist * directDistanceFactorAirway)
-          {
-            result.nodes.append(edge.toIndex);
-            result.edges.append(edge);
+          int shortcut = data->edgeShortcuts.at(static_cast<int>(&airwayEdge - data->edges.constData()));
 
-            if(mode & MODE_WAYPOINT)
-              nodeIndexes.insert(edge.toIndex);
-          }
+          // Skipped nodes have to be too far away for a connection to the destination
+          if(shortcut != -1 && originToDestDist - data->shortcuts.at(shortcut).lengthMeter > nearestDestDistanceM &&
+             (tracks.isNull() || !tracks->isShortcutBlocked(shortcut)))
+            edgePtr = &data->shortcuts.at(shortcut);
         }
+
+        addEdge(result, nodeIndexes, edgePtr, data->edgeIndex(edgePtr), originPoint, destinationPoint,
+                originToDestDist, originNotTrackEnd, prevEdge);
       }
     }
 
+    // Add track edges from overlay =======================================
+    if(mode & MODE_TRACK && !tracks.isNull())
+    {
+      for(const Edge& trackEdge : tracks->edgeRange(true, origin.index))
+        addEdge(result, nodeIndexes, &trackEdge, -1, originPoint, destinationPoint, originToDestDist,
+                originNotTrackEnd, prevEdge);
+    }
+
     // Additionally search for direct waypoint connections if result is limited
     if((mode & MODE_WAYPOINT && result.size() < 2) || origin.isDeparture())
     {
@@ -131,8 +125,7 @@ void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge
         {
           if(prevEdge->isTrack() != result.edges.at(i).isTrack())
           {
-            result.nodes.removeAt(i);
-            result.edges.removeAt(i);
+            result.removeAt(i);
           }
         }
       }
@@ -148,14 +141,144 @@ void RouteNetwork::getNeighbours(Result& result, const Node& origin, const Edge
     // Avoid jumping directly into a track
     if(!(originNotTrackEnd && prevEdge->isTrack()))
     {
-      result.nodes.append(destinationNode.index);
-      result.edges.append(Edge(Node::DESTINATION_INDEX, originPoint.gcDistanceMeter(destinationPoint)));
+      result.append(destinationNode.index,
+                    Edge(Node::DESTINATION_INDEX, originPoint.gcDistanceMeter(destinationPoint)));
     }
   }
 }
 
-int RouteNetwork::searchNearest(Result& result, const Node& origin,
-                                float minDistanceMeter, float maxDistanceMeter, const QSet<int> *excludeIndexes) const
+void RouteNetwork::getNeighboursReverse(Result& result, const Node& origin, const Edge *nextEdge) const
+{
+  Q_ASSERT(destinationNode.isValid());
+  Q_ASSERT(departureNode.isValid());
+
+  // Node might be also departure or destination
+  Point3D originPoint = point3D(origin.index);
+  float originToDepartDist = originPoint.directDistanceMeter(departurePoint);
+
+  // Same as in getNeighbours() but for transitions on the way back
+  bool originNotTrackEnd = source == SOURCE_AIRWAY && mode & MODE_TRACK &&
+                           nextEdge != nullptr && !(getNodeConnections(origin) & CONNECTION_TRACK_START_END);
+
+  if(source == SOURCE_AIRWAY)
+  {
+    // Add incoming airway edges =======================================
+    EdgeRange edges = getReverseEdges(origin);
+    result.reserve(edges.size());
+
+    // Avoid duplicates with direct neighbor search
+    QSet<int> nodeIndexes;
+
+    if(mode & MODE_AIRWAY)
+    {
+      bool useShortcuts = shortcutsEnabled && !data->reverseEdgeShortcuts.isEmpty() && !(mode & MODE_WAYPOINT);
+
+      for(const Edge& airwayEdge : edges)
+      {
+        const Edge *edgePtr = &airwayEdge;
+        if(useShortcuts)
+        {
+          int shortcut = data->reverseEdgeShortcuts.at(static_cast<int>(&airwayEdge - data->reverseEdges.constData()));
+
+          // Skipped nodes have to be too far away for a connection from the departure
+          if(shortcut != -1 &&
+             originToDepartDist - data->reverseShortcuts.at(shortcut).lengthMeter > nearestDepartureDistanceM &&
+             (tracks.isNull() || !tracks->isShortcutBlocked(shortcut)))
+            edgePtr = &data->reverseShortcuts.at(shortcut);
+        }
+
+        // Add only nodes/edges that lead back towards the departure
+        addEdge(result, nodeIndexes, edgePtr, data->edgeIndex(edgePtr), originPoint, departurePoint,
+                originToDepartDist, originNotTrackEnd, nextEdge);
+      }
+    }
+
+    // Add incoming track edges from overlay =======================================
+    if(mode & MODE_TRACK && !tracks.isNull())
+    {
+      for(const Edge& trackEdge : tracks->edgeRange(false, origin.index))
+        addEdge(result, nodeIndexes, &trackEdge, -1, originPoint, departurePoint, originToDepartDist,
+                originNotTrackEnd, nextEdge);
+    }
+
+    // Additionally search for direct waypoint connections if result is limited
+    if((mode & MODE_WAYPOINT && result.size() < 2) || origin.isDestination())
+    {
+      int found = searchNearest(result, origin, minNearestDistanceWpM, maxNearestDistanceWpM, &nodeIndexes,
+                                true /* reverse */);
+
+      if(found < 6)
+        searchNearest(result, origin, minNearestDistanceWpM * 2, maxNearestDistanceWpM * 5, &nodeIndexes,
+                      true /* reverse */);
+
+      if(originNotTrackEnd)
+      {
+        int size = result.edges.size();
+        for(int i = size - 1; i >= 0; i--)
+        {
+          if(nextEdge->isTrack() != result.edges.at(i).isTrack())
+          {
+            result.removeAt(i);
+          }
+        }
+      }
+    }
+  }
+  else
+    searchNearest(result, origin, minNearestDistanceRadioM, maxNearestDistanceRadioM, nullptr, true /* reverse */);
+
+  // Add departure node and calculate edges from it if in range ==========================================
+  if(originToDepartDist < nearestDepartureDistanceM)
+  {
+    if(!(originNotTrackEnd && nextEdge->isTrack()))
+    {
+      result.append(departureNode.index, Edge(Node::DEPARTURE_INDEX, originPoint.gcDistanceMeter(departurePoint)));
+    }
+  }
+}
+
+void RouteNetwork::addEdge(Result& result, QSet<int>& nodeIndexes, const Edge *edgePtr, int edgeIndex,
+                           const Point3D& originPoint, const Point3D& targetPoint, float originToTargetDist,
+                           bool originNotTrackEnd, const Edge *prevEdge) const
+{
+  const Edge& edge = *edgePtr;
+
+  // Check if edge type matches criteria (altitude, RNAV and airway type)
+  if(!matchEdge(edge))
+    return;
+
+  // Check if node type matches like airway type
+  if(!matchNode(getNode(edge.toIndex)))
+    return;
+
+  // Avoid track transitions at the wrong points
+  if(originNotTrackEnd &&
+     // Do not traverse between track and airway
+     (prevEdge->isTrack() != edge.isTrack() ||
+      // and not between different tracks
+      (prevEdge->isTrack() && edge.isTrack() && prevEdge->airwayHash != edge.airwayHash)))
+    return;
+
+  // Edge can have only another node - not departure or destination
+  const Point3D& curPoint = point3D(edge.toIndex);
+  float curToTargetDist = curPoint.directDistanceMeter(targetPoint);
+
+  // Add only nodes/edges that are ahead of the current node and lead towards the target
+  if(curToTargetDist < originToTargetDist)
+  {
+    float curToOriginDist = curPoint.directDistanceMeter(originPoint);
+    if(curToTargetDist + curToOriginDist < originToTargetDist * directDistanceFactorAirway)
+    {
+      result.append(edge.toIndex, edge, edgeIndex);
+
+      if(mode & MODE_WAYPOINT)
+        nodeIndexes.insert(edge.toIndex);
+    }
+  }
+}
+
+int RouteNetwork::searchNearest(Result& result, const Node& origin, float minDistanceMeter, float maxDistanceMeter,
+                                const QSet<int> *excludeIndexes, bool reverse) const
 {
   /* Callback class used for secondary stage filtering in radius searches.
    * Mainly used to keep all local variables accessible for the callback method. */
@@ -225,17 +348,21 @@ int RouteNetwork::searchNearest(Result& result, const Node& origin,
   // Prepare callback with data =========================
   RadiusCallback callbackObj;
   callbackObj.origin = nodeToCartesian(origin);
-  callbackObj.points = nodeIndex.getPoints3D();
+  callbackObj.points = data->nodeIndex.getPoints3D();
   callbackObj.excludeIndexes = (excludeIndexes == nullptr || excludeIndexes->isEmpty()) ? nullptr : excludeIndexes;
   callbackObj.radionav = isRadionavRouting();
 
   callbackObj.directDistFactor = isAirwayRouting() ? directDistanceFactorWp : directDistanceFactorRadio;
-  callbackObj.originToDestDist = getDirectDistanceMeter(origin, destinationNode);
-  callbackObj.dest = destinationPoint;
+  // Target is departure for backward search
+  callbackObj.originToDestDist = getDirectDistanceMeter(origin, reverse ? departureNode : destinationNode);
+  callbackObj.dest = reverse ? departurePoint : destinationPoint;
+
+  // Search start - departure or destination for backward search
+  bool originIsStart = reverse ? origin.isDestination() : origin.isDeparture();
 
   if(callbackObj.radionav)
   {
-    if(origin.isDeparture())
+    if(originIsStart)
       // Allow all points close to departure
       callbackObj.radiusMin = 0.f;
     else
@@ -246,7 +373,7 @@ int RouteNetwork::searchNearest(Result& result, const Node& origin,
   }
   else
   {
-    if(origin.isDeparture())
+    if(originIsStart)
       // Lower minimum distance for departure
       callbackObj.radiusMin = minDistanceMeter / 5.f;
     else
@@ -260,32 +387,104 @@ int RouteNetwork::searchNearest(Result& result, const Node& origin,
   if(!callbackObj.radionav)
     maxDistanceMeter = std::min(maxDistanceMeter, callbackObj.originToDestDist);
 
-  // Use a lambda instead of std::bind since this is faster
-  atools::geo::RadiusCallbackType callbackFunc = [&callbackObj](float dist, int index) -> bool {
-                                                   return callbackObj.callback(dist, index);
-                                                 };
-  QVector<int> indexes;
-  nodeIndex.getRadiusIndexes(indexes, origin.pos, maxDistanceMeter, callbackFunc);
+  // Search the grid cells touching the radius and call filter inline without std::function overhead
+  QVector<int>& indexes = nearestIndexes;
+  indexes.clear();
+  gridRadiusIndexes(indexes, origin.pos, callbackObj.origin, maxDistanceMeter, callbackObj);
 
-  result.nodes.reserve(indexes.size());
-  result.edges.reserve(indexes.size());
+  result.reserve(result.size() + indexes.size());
 
   // Copy node indexes and edges to result ======================
   int numFound = 0;
-  Point3D originPoint = nodeToCartesian(origin);
+  const Point3D& originPoint = callbackObj.origin;
   for(int idx : indexes)
   {
-    if(matchNode(nodeIndex.at(idx)))
+    if(matchNode(data->nodeIndex.at(idx)))
     {
       // Add node and edge leading to it
-      result.nodes.append(idx);
-      result.edges.append(Edge(idx, originPoint.gcDistanceMeter(nodeIndex.atPoint3D(idx))));
+      result.append(idx, Edge(idx, originPoint.gcDistanceMeter(data->nodeIndex.atPoint3D(idx))));
       numFound++;
     }
   }
   return numFound;
 }
 
+template<typename FILTER>
+void RouteNetwork::gridRadiusIndexes(QVector<int>& indexes, const atools::geo::Pos& origin, const Point3D& originPoint,
+                                     float radiusMeter, const FILTER& filter) const
+{
+  if(data->gridOffsets.isEmpty())
+    return;
+
+  // Latitude range in degree covered by the radius
+  float radiusDeg = atools::geo::meterToNm(radiusMeter) / 60.f;
+  float latMin = origin.getLatY() - radiusDeg, latMax = origin.getLatY() + radiusDeg;
+
+  // Longitude range depends on latitude - use the one closer to the poles
+  float lonRadiusDeg = 180.f;
+  if(latMin > -89.f && latMax < 89.f)
+  {
+    float maxLatAbs = std::max(std::abs(latMin), std::abs(latMax));
+    lonRadiusDeg = std::min(180.f, radiusDeg / std::cos(atools::geo::toRadians(maxLatAbs)));
+  }
+
+  int rowMin = RouteNetworkData::gridRow(latMin), rowMax = RouteNetworkData::gridRow(latMax);
+  int numCols = RouteNetworkData::GRID_COLUMNS;
+  if(lonRadiusDeg < 180.f)
+    numCols = std::min(numCols, static_cast<int>(std::ceil(lonRadiusDeg * 2.f / RouteNetworkData::GRID_CELL_DEG)) + 1);
+  int colStart = lonRadiusDeg < 180.f ? RouteNetworkData::gridColumn(origin.getLonX() - lonRadiusDeg) : 0;
+
+  const Point3D *points = data->nodeIndex.getPoints3D();
+  const int *gridNodes = data->gridNodes.constData();
+  const int *gridOffsets = data->gridOffsets.constData();
+
+  for(int row = rowMin; row <= rowMax; row++)
+  {
+    for(int c = 0; c < numCols; c++)
+    {
+      // Wrap around anti-meridian
+      int cell = row * RouteNetworkData::GRID_COLUMNS + (colStart + c) % RouteNetworkData::GRID_COLUMNS;
+
+      for(int i = gridOffsets[cell]; i < gridOffsets[cell + 1]; i++)
+      {
+        int idx = gridNodes[i];
+        if(points[idx].directDistanceMeter(originPoint) < radiusMeter && filter.callback(0.f, idx))
+          indexes.append(idx);
+      }
+    }
+  }
+}
+
+void RouteNetworkData::buildGrid()
+{
+  int numCells = GRID_ROWS * GRID_COLUMNS;
+  gridOffsets.fill(0, numCells + 1);
+  gridNodes.clear();
+
+  if(nodeIndex.isEmpty())
+    return;
+
+  // Count nodes per cell
+  QVector<int> cells(nodeIndex.size());
+  for(int i = 0; i < nodeIndex.size(); i++)
+  {
+    const atools::geo::Pos& pos = nodeIndex.at(i).pos;
+    int cell = gridRow(pos.getLatY()) * GRID_COLUMNS + gridColumn(pos.getLonX());
+    cells[i] = cell;
+    gridOffsets[cell + 1]++;
+  }
+
+  // Convert counts to offsets
+  for(int i = 0; i < numCells; i++)
+    gridOffsets[i + 1] += gridOffsets.at(i);
+
+  // Fill indexes using a running insert position for each cell
+  QVector<int> insertPos(gridOffsets);
+  gridNodes.resize(nodeIndex.size());
+  for(int i = 0; i < nodeIndex.size(); i++)
+    gridNodes[insertPos[cells.at(i)]++] = i;
+}
+
 void RouteNetwork::setParameters(const geo::Pos& departurePos, const geo::Pos& destinationPos, int altitudeParam,
                                  Modes modeParam)
 {
@@ -293,6 +492,7 @@ void RouteNetwork::setParameters(const geo::Pos& departurePos, const geo::Pos& d
 
   altitude = altitudeParam;
   mode = modeParam;
+  updateMatchTables();
 
   if(departurePos.isValid())
   {
@@ -303,6 +503,7 @@ void RouteNetwork::setParameters(const geo::Pos& departurePos, const geo::Pos& d
     departureNode.range = 0;
     departureNode.subtype = NODE_NONE;
     departureNode.con = CONNECTION_NONE;
+    departureNode.updateAttributes();
     departurePos.toCartesian(departurePoint);
   }
 
@@ -315,6 +516,7 @@ void RouteNetwork::setParameters(const geo::Pos& departurePos, const geo::Pos& d
     destinationNode.range = 0;
     destinationNode.subtype = NODE_NONE;
     destinationNode.con = CONNECTION_NONE;
+    destinationNode.updateAttributes();
     destinationPos.toCartesian(destinationPoint);
 
     if(departurePos.isValid())
@@ -329,6 +531,7 @@ void RouteNetwork::clearParameters()
 {
   altitude = 0;
   mode = MODE_ALL;
+  updateMatchTables();
   departureNode = Node();
   departurePoint = Point3D();
 
@@ -342,7 +545,14 @@ const Node& RouteNetwork::getNode(int index) const
   const static atools::routing::Node INVALID;
 
   if(index >= 0)
-    return nodeIndex.at(index);
+  {
+    if(index < data->nodeIndex.size())
+      return data->nodeIndex.at(index);
+    else if(!tracks.isNull() && index < tracks->numNodes())
+      return tracks->nodes.at(index - tracks->numBaseNodes);
+    else
+      return INVALID;
+  }
   else if(index == Node::DEPARTURE_INDEX)
     return departureNode;
   else if(index == Node::DESTINATION_INDEX)
@@ -386,7 +596,14 @@ const geo::Point3D& RouteNetwork::point3D(int index) const
   const static Point3D INVALID;
 
   if(index >= 0)
-    return nodeIndex.atPoint3D(index);
+  {
+    if(index < data->nodeIndex.size())
+      return data->nodeIndex.atPoint3D(index);
+    else if(!tracks.isNull() && index < tracks->numNodes())
+      return tracks->points.at(index - tracks->numBaseNodes);
+    else
+      return INVALID;
+  }
   else if(index == Node::DEPARTURE_INDEX)
     return departurePoint;
   else if(index == Node::DESTINATION_INDEX)
@@ -395,95 +612,89 @@ const geo::Point3D& RouteNetwork::point3D(int index) const
     return INVALID;
 }
 
-bool RouteNetwork::matchNode(const Node& node) const
+void RouteNetwork::updateMatchTables()
 {
-  atools::routing::NodeType nodeType = node.type;
-  bool ok = true;
-
-  switch(nodeType)
+  // Calculate result of matchEdge() type and RNAV checks for all attribute combinations ================
+  edgeMatchTable = 0;
+  for(quint32 attr = 0; attr < EDGE_ATTR_COMBINATIONS; attr++)
   {
-    case atools::routing::NODE_VOR:
-    case atools::routing::NODE_VORDME:
-    case atools::routing::NODE_DME:
-      ok &= mode.testFlag(MODE_RADIONAV_VOR);
-      break;
-
-    case atools::routing::NODE_NDB:
-      ok &= mode.testFlag(MODE_RADIONAV_NDB);
-      break;
-
-    case atools::routing::NODE_WAYPOINT:
-
-      if(mode.testFlag(MODE_WAYPOINT))
-        // Can use any waypoint in this mode
-        ok = true;
-      else
-      {
-        ok = false;
+    bool ok = (attr & EDGE_ATTR_JET && mode.testFlag(MODE_JET)) ||
+              (attr & EDGE_ATTR_VICTOR && mode.testFlag(MODE_VICTOR)) ||
+              (attr & EDGE_ATTR_DIRECT && mode.testFlag(MODE_WAYPOINT)) ||
+              (attr & EDGE_ATTR_TRACK && mode.testFlag(MODE_TRACK));
 
-        // Check if track or airway type matches filter mode
-        atools::routing::NodeConnections con = node.con;
+    // Check if RNAV has to be excluded
+    if(mode & MODE_NO_RNAV && attr & EDGE_ATTR_RNAV)
+      ok = false;
 
-        if(mode.testFlag(MODE_JET) && con.testFlag(CONNECTION_JET))
-          ok = true;
-
-        if(mode.testFlag(MODE_VICTOR) && con.testFlag(CONNECTION_VICTOR))
-          ok = true;
-
-        if(mode.testFlag(MODE_TRACK) && con.testFlag(CONNECTION_TRACK))
-          ok = true;
-      }
-      break;
+    if(ok)
+      edgeMatchTable |= 1u << attr;
+  }
 
-    case atools::routing::NODE_NONE:
-    case atools::routing::NODE_DEPARTURE:
-    case atools::routing::NODE_DESTINATION:
-      break;
+  // Same for matchNode() ================
+  nodeMatchTable = 0;
+  for(quint32 attr = 0; attr < NODE_ATTR_COMBINATIONS; attr++)
+  {
+    bool ok;
+    if(attr == NODE_ATTR_NONE)
+      // Departure, destination or no type
+      ok = true;
+    else
+      ok = (attr & NODE_ATTR_VOR && mode.testFlag(MODE_RADIONAV_VOR)) ||
+           (attr & NODE_ATTR_NDB && mode.testFlag(MODE_RADIONAV_NDB)) ||
+           // Can use any waypoint in this mode or check if track or airway type matches filter mode
+           (attr & NODE_ATTR_WAYPOINT && (mode.testFlag(MODE_WAYPOINT) ||
+                                          (attr & NODE_ATTR_JET && mode.testFlag(MODE_JET)) ||
+                                          (attr & NODE_ATTR_VICTOR && mode.testFlag(MODE_VICTOR)) ||
+                                          (attr & NODE_ATTR_TRACK && mode.testFlag(MODE_TRACK))));
+
+    if(ok)
+      nodeMatchTable |= Q_UINT64_C(1) << attr;
   }
-  return ok;
 }
 
-bool RouteNetwork::matchEdge(const Edge& edge) const
+bool RouteNetwork::matchAltLevels(const Edge& edge) const
 {
-  bool ok = (altitude == 0 || (altitude >= edge.minAltFt && altitude <= edge.maxAltFt));
+  // Test altitude levels if attached - independent of direction
+  if(tracks.isNull())
+    return true;
 
-  // Check if RNAV has to be excluded
-  if(mode & MODE_NO_RNAV)
-    ok &= edge.routeType != RNAV;
+  bool ok = true;
+  int level = altitude / 100;
 
-  // Check if track or airway type matches filter mode
-  if(ok)
-    ok &= (edge.isJetAirway() && mode.testFlag(MODE_JET)) ||
-          (edge.isVictorAirway() && mode.testFlag(MODE_VICTOR)) ||
-          (edge.isNoConnection() && mode.testFlag(MODE_WAYPOINT)) ||
-          (edge.isTrack() && mode.testFlag(MODE_TRACK));
+  if(tracks->altLevelsEast.contains(edge.id))
+    ok &= tracks->altLevelsEast.value(edge.id).contains(static_cast<quint16>(level));
+  if(tracks->altLevelsWest.contains(edge.id))
+    ok &= tracks->altLevelsWest.value(edge.id).contains(static_cast<quint16>(level));
 
-  // Test altitude levels if attached - independent of direction
-  if(ok && altitude > 0 && edge.hasAltLevels)
-  {
-    int level = altitude / 100;
+  return ok;
+}
 
-    if(altLevelsEast.contains(edge.id))
-      ok &= altLevelsEast.value(edge.id).contains(static_cast<quint16>(level));
-    if(altLevelsWest.contains(edge.id))
-      ok &= altLevelsWest.value(edge.id).contains(static_cast<quint16>(level));
+void RouteNetwork::setTracks(const QSharedPointer<const RouteTrackData>& trackData)
+{
+  if(!trackData.isNull() && trackData->numBaseNodes != data->nodeIndex.size())
+  {
+    qWarning() << Q_FUNC_INFO << "Track overlay built for" << trackData->numBaseNodes << "nodes but network has"
+               << data->nodeIndex.size();
+    tracks.reset();
   }
-
-  return ok;
+  else
+    tracks = trackData;
 }
 
 void RouteNetwork::clear()
 {
   clearParameters();
-  nodeIndex.clear();
-  nodeIndex.updateIndex();
-  altLevelsEast.clear();
-  altLevelsWest.clear();
+  tracks.reset();
+
+  // Detach from copies which might still use the old graph
+  data.reset(new RouteNetworkData);
+  data->nodeIndex.updateIndex();
 }
 
 bool RouteNetwork::isLoaded() const
 {
-  return !nodeIndex.isEmpty();
+  return !data->nodeIndex.isEmpty();
 }
 
 } // namespace route
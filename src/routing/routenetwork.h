@@ -21,10 +21,157 @@
 #include "geo/spatialindex.h"
 #include "routing/routenetworktypes.h"
 
+#include <QSharedPointer>
+
 namespace atools {
 namespace routing {
 
 class RouteNetworkLoader;
+class RouteWindCache;
+
+/*
+ * Immutable part of the network as loaded by RouteNetworkLoader. Shared between copies of RouteNetwork
+ * and not changed after loading which allows concurrent read access from several threads.
+ */
+struct RouteNetworkData
+{
+  /* Spatial index for nearest neighbor search using KD-tree internally */
+  atools::geo::SpatialIndex<Node> nodeIndex;
+
+  /* Outgoing edges of all nodes in compressed sparse row format. Edges for node index i are in range
+   * edgeOffsets[i] to edgeOffsets[i + 1]. Offsets are empty if the network has no edges (radionav). */
+  QVector<Edge> edges;
+  QVector<int> edgeOffsets;
+
+  /* Same as above for incoming edges. Edge::toIndex is the index of the start node.
+   * Used for backward search in bidirectional routing. */
+  QVector<Edge> reverseEdges;
+  QVector<int> reverseEdgeOffsets;
+
+  /* Shortcut edges replacing chains of airway edges which pass through nodes without other connections.
+   * Loaded from table route_shortcut_airway. Edge::id is the index in this vector and Edge::shortcut is true.
+   * reverseShortcuts contains the same edges for backward search with Edge::toIndex set to the chain start. */
+  QVector<Edge> shortcuts, reverseShortcuts;
+
+  /* Replaced edges for shortcut i are in range shortcutEdgeOffsets[i] to shortcutEdgeOffsets[i + 1]
+   * ordered from chain start to chain end */
+  QVector<Edge> shortcutEdges;
+  QVector<int> shortcutEdgeOffsets;
+
+  /* Index of the shortcut starting with the edge at the same position in edges or reverseEdges. -1 if none.
+   * Empty if no shortcuts are loaded. */
+  QVector<int> edgeShortcuts, reverseEdgeShortcuts;
+
+  /* Index over all stored edges in the order edges, reverseEdges, shortcuts and reverseShortcuts.
+   * Used for arrays aligned with the edge storage like in RouteWindCache. -1 if the edge is not stored. */
+  int edgeIndex(const Edge *edge) const
+  {
+    int offset = 0;
+    for(const QVector<Edge> *edgeVector : {&edges, &reverseEdges, &shortcuts, &reverseShortcuts})
+    {
+      if(edge >= edgeVector->constData() && edge < edgeVector->constData() + edgeVector->size())
+        return offset + static_cast<int>(edge - edgeVector->constData());
+      offset += edgeVector->size();
+    }
+    return -1;
+  }
+
+  int numEdgeIndexes() const
+  {
+    return edges.size() + reverseEdges.size() + shortcuts.size() + reverseShortcuts.size();
+  }
+
+  /* Bucket grid for radius searches. Node indexes sorted by cell are in gridNodes and the nodes for cell i
+   * can be found in the range gridOffsets[i] to gridOffsets[i + 1]. */
+  QVector<int> gridNodes;
+  QVector<int> gridOffsets;
+
+  /* Grid cell size in degree */
+  static Q_DECL_CONSTEXPR int GRID_CELL_DEG = 2;
+  static Q_DECL_CONSTEXPR int GRID_COLUMNS = 360 / GRID_CELL_DEG;
+  static Q_DECL_CONSTEXPR int GRID_ROWS = 180 / GRID_CELL_DEG;
+
+  /* Fill the grid from nodeIndex. Call after loading. */
+  void buildGrid();
+
+  static int gridRow(float laty)
+  {
+    return std::max(0, std::min(GRID_ROWS - 1, static_cast<int>((laty + 90.f) / GRID_CELL_DEG)));
+  }
+
+  static int gridColumn(float lonx)
+  {
+    int col = static_cast<int>(std::floor((lonx + 180.f) / GRID_CELL_DEG)) % GRID_COLUMNS;
+    return col < 0 ? col + GRID_COLUMNS : col;
+  }
+
+  atools::routing::EdgeRange edgeRange(const QVector<Edge>& edgeVector, const QVector<int>& offsets, int index) const
+  {
+    if(index < 0 || index + 1 >= offsets.size())
+      return EdgeRange();
+
+    return EdgeRange(edgeVector.constData() + offsets.at(index), edgeVector.constData() + offsets.at(index + 1));
+  }
+};
+
+/*
+ * Track edges and nodes as an overlay on top of the airway graph in RouteNetworkData.
+ * Built by RouteNetworkLoader::loadTracks() after each track download and swapped into a network using
+ * RouteNetwork::setTracks() without reloading the airway graph. Not changed after building and shared between
+ * copies of RouteNetwork like RouteNetworkData.
+ */
+struct RouteTrackData
+{
+  /* Number of nodes in the airway graph the overlay was built for. Track only nodes follow with indexes
+   * starting at this number. */
+  int numBaseNodes = 0;
+
+  /* Artificial track waypoints which are not part of the navdata. Node::index is numBaseNodes + position. */
+  QVector<Node> nodes;
+  QVector<atools::geo::Point3D> points;
+
+  /* Outgoing and incoming track edges in compressed sparse row format over airway graph and track nodes.
+   * Same layout as in RouteNetworkData. */
+  QVector<Edge> edges;
+  QVector<int> edgeOffsets;
+  QVector<Edge> reverseEdges;
+  QVector<int> reverseEdgeOffsets;
+
+  /* Flags CONNECTION_TRACK and CONNECTION_TRACK_START_END for all nodes of the airway graph and track nodes */
+  QVector<atools::routing::NodeConnections> connections;
+
+  /* true for shortcuts in RouteNetworkData which skip a node having track connections. Empty if none. */
+  QVector<bool> blockedShortcuts;
+
+  /* Map database track.track_id to altitude levels if existing */
+  QHash<int, QVector<quint16> > altLevelsEast, altLevelsWest;
+
+  int numNodes() const
+  {
+    return numBaseNodes + nodes.size();
+  }
+
+  atools::routing::NodeConnections nodeConnections(int index) const
+  {
+    return index >= 0 && index < connections.size() ? connections.at(index) : CONNECTION_NONE;
+  }
+
+  bool isShortcutBlocked(int shortcut) const
+  {
+    return shortcut < blockedShortcuts.size() && blockedShortcuts.at(shortcut);
+  }
+
+  /* Outgoing or incoming track edges for node index */
+  atools::routing::EdgeRange edgeRange(bool outgoing, int index) const
+  {
+    const QVector<int>& offsets = outgoing ? edgeOffsets : reverseEdgeOffsets;
+    if(index < 0 || index + 1 >= offsets.size())
+      return EdgeRange();
+
+    const Edge *first = (outgoing ? edges : reverseEdges).constData();
+    return EdgeRange(first + offsets.at(index), first + offsets.at(index + 1));
+  }
+};
 
 /*
  * Network forming a directed graph by navaid nodes and airway edges or generated edges by neares neighbor search.
@@ -36,6 +183,10 @@ class RouteNetworkLoader;
  * Several optimizations limit the number of returned neighbors.
  *
  * The class has a state (i.e. start and destination) and is not re-entrant.
+ * The loaded graph is kept in a shared read-only RouteNetworkData. Copies of a network are cheap and share the graph
+ * while having their own state. Use one copy per thread for parallel route calculations.
+ * Loading again detaches the network from existing copies which keep the old graph.
+ * Tracks are kept in a separate RouteTrackData overlay which can be replaced without loading the airway graph.
  *
  * A call to setParameters with valid departure and destination is required before using any other methods.
  */
@@ -44,6 +195,11 @@ class RouteNetwork
 public:
   /* Does not load the data */
   RouteNetwork(atools::routing::DataSource dataSource);
+
+  /* Shallow copy sharing the loaded graph. Copies parameters and state. */
+  RouteNetwork(const RouteNetwork& other) = default;
+  RouteNetwork& operator=(const RouteNetwork& other) = default;
+
   virtual ~RouteNetwork();
 
   /* true if network is loaded. */
@@ -52,7 +208,7 @@ public:
   /* Remove departure and destination nodes */
   void clear();
 
-  /* Get all adjacent nodes and attached edges for the given node. Edges might be different than Node::edges.
+  /* Get all adjacent nodes and attached edges for the given node. Edges might be different than getEdges().
    * Adjacent objects are filtered based on distance and type criteria like airway types.
    * Edges may be airways or generated edges by nearest neighbor search.
    * Nodes/edges having a longer distance to the destination than the origin are filtered out .*/
@@ -66,6 +222,14 @@ public:
     getNeighbours(result, getNearestNode(origin), prevEdge);
   }
 
+  /* Get all preceding nodes and incoming edges for the given node. This is the reverse of getNeighbours()
+   * used for a backward search starting at the destination.
+   * Result edges have Edge::toIndex set to the preceding node.
+   * Nodes/edges having a longer distance to the departure than the origin are filtered out.
+   * nextEdge is the edge leading away from origin towards the destination. */
+  void getNeighboursReverse(atools::routing::Result& result, const atools::routing::Node& origin,
+                            const Edge *nextEdge = nullptr) const;
+
   /* Get great circle distance between two nodes. The calculation in euclidian 3D space
    * which is used here is faster than the usual haversine formula. */
   float getGcDistanceMeter(const atools::routing::Node& node1, const atools::routing::Node& node2) const
@@ -73,6 +237,18 @@ public:
     return nodeToCartesian(node1).gcDistanceMeter(nodeToCartesian(node2));
   }
 
+  /* Get evaluator for repeated great circle distance calculations to a fixed target node */
+  atools::geo::Point3DTarget getDistanceTarget(const atools::routing::Node& node) const
+  {
+    return atools::geo::Point3DTarget(nodeToCartesian(node));
+  }
+
+  /* Get great circle distance between node and target. Faster than getGcDistanceMeter(). */
+  float getGcDistanceMeter(const atools::routing::Node& node, const atools::geo::Point3DTarget& target) const
+  {
+    return target.gcDistanceMeter(nodeToCartesian(node));
+  }
+
   /* Get direct euclidian distance (tunnel-through distance) in 3D space between two nodes.
    * The calculation is more efficient than getGcDistanceMeter
    * but underestimates the distance. */
@@ -101,19 +277,72 @@ public:
     return destinationNode;
   }
 
-  /* Get a node by routing network node index. If index is -1 an invalid node with id -1 is returned */
+  /* Get a node by routing network node index. If index is -1 an invalid node with id -1 is returned.
+   * Indexes above the airway graph refer to track nodes of the overlay. */
   const atools::routing::Node& getNode(int index) const;
 
-  /* Get a single nearest node to the position. */
+  /* Number of nodes including track only nodes. Use for arrays indexed by node index. */
+  int getNumNodes() const
+  {
+    return tracks.isNull() ? data->nodeIndex.size() : tracks->numNodes();
+  }
+
+  /* Replace the track overlay. Null removes all tracks. Copies of this network keep the previous overlay.
+   * The overlay has to be built for the loaded airway graph. Do not call while a route is calculated. */
+  void setTracks(const QSharedPointer<const atools::routing::RouteTrackData>& trackData);
+
+  const QSharedPointer<const atools::routing::RouteTrackData>& getTracks() const
+  {
+    return tracks;
+  }
+
+  /* Connection flags of a node including track connections from the overlay */
+  atools::routing::NodeConnections getNodeConnections(const atools::routing::Node& node) const
+  {
+    return tracks.isNull() ? node.getConnections() : node.getConnections() | tracks->nodeConnections(node.index);
+  }
+
+  /* Get a single nearest node to the position. Track only nodes are not included. */
   const atools::routing::Node& getNearestNode(const atools::geo::Pos& pos) const
   {
-    return nodeIndex.getNearest(pos);
+    return data->nodeIndex.getNearest(pos);
+  }
+
+  /* Attached outgoing edges for a node. Empty for departure, destination and radionav networks.
+   * Do not use this for routing since edges are not filtered. */
+  atools::routing::EdgeRange getEdges(const atools::routing::Node& node) const
+  {
+    return data->edgeRange(data->edges, data->edgeOffsets, node.index);
+  }
+
+  /* Attached incoming edges for a node. Edge::toIndex is the start node of the edge. */
+  atools::routing::EdgeRange getReverseEdges(const atools::routing::Node& node) const
+  {
+    return data->edgeRange(data->reverseEdges, data->reverseEdgeOffsets, node.index);
+  }
+
+  /* Edges replaced by a shortcut edge ordered from chain start to end. Empty if edge is not a shortcut. */
+  atools::routing::EdgeRange getShortcutEdges(const atools::routing::Edge& edge) const
+  {
+    return edge.shortcut ? data->edgeRange(data->shortcutEdges, data->shortcutEdgeOffsets, edge.id) : EdgeRange();
+  }
+
+  /* Use shortcuts for pure airway routing to skip nodes in the middle of airways if loaded. Default is true.
+   * Shortcuts are never used if direct waypoint connections are enabled by mode. */
+  void setShortcutsEnabled(bool value)
+  {
+    shortcutsEnabled = value;
+  }
+
+  bool isShortcutsEnabled() const
+  {
+    return shortcutsEnabled;
   }
 
   /* Get nodes vector. The index parameter can be used to access nodes fast.*/
   const QVector<atools::routing::Node>& getNodes() const
   {
-    return nodeIndex;
+    return data->nodeIndex;
   }
 
   /* true if airways and other navaids are used as data source. */
@@ -169,12 +398,12 @@ public:
   /* Altitude levels as assigned to NAT tracks. trackId is database track.track_id. */
   const QVector<quint16> getAltitudeLevelsEast(int trackId) const
   {
-    return altLevelsEast.value(trackId);
+    return tracks.isNull() ? QVector<quint16>() : tracks->altLevelsEast.value(trackId);
   }
 
   QVector<quint16> getAltitudeLevelsWest(int trackId) const
   {
-    return altLevelsWest.value(trackId);
+    return tracks.isNull() ? QVector<quint16>() : tracks->altLevelsWest.value(trackId);
   }
 
   /* Mode that defines which features are used for edge filtering (airways, tracks, direct connections, etc.) */
@@ -185,21 +414,65 @@ public:
 
 private:
   friend class atools::routing::RouteNetworkLoader;
+  friend class atools::routing::RouteWindCache;
 
-  /* Get nearest nodes and edges */
+  /* Get nearest nodes and edges. Filters by direction towards destination or towards departure if reverse is true. */
   int searchNearest(atools::routing::Result& result, const Node& origin, float minDistanceMeter,
-                    float maxDistanceMeter, const QSet<int> *excludeIndexes = nullptr) const;
+                    float maxDistanceMeter, const QSet<int> *excludeIndexes = nullptr, bool reverse = false) const;
+
+  /* Get all node indexes within radius around origin using the bucket grid. Calls filter for each candidate
+   * and adds the index to the result if it returns true. Result is not cleared. */
+  template<typename FILTER>
+  void gridRadiusIndexes(QVector<int>& indexes, const atools::geo::Pos& origin, const atools::geo::Point3D& originPoint,
+                         float radiusMeter, const FILTER& filter) const;
+
+  /* Check node filter based on mode. Looks up the precalculated node attributes in a table built for the mode. */
+  bool matchNode(const Node& node) const
+  {
+    quint32 attributes = node.attributes;
+
+    // Add track flag from overlay for waypoints
+    if(!tracks.isNull() && attributes & NODE_ATTR_WAYPOINT &&
+       tracks->nodeConnections(node.index) & CONNECTION_TRACK)
+      attributes |= NODE_ATTR_TRACK;
 
-  /* Check node filter based on mode. */
-  bool matchNode(const Node& node) const;
+    return (nodeMatchTable >> attributes) & 1;
+  }
 
   atools::geo::Point3D nodeToCartesian(const atools::routing::Node& node) const
   {
-    return node.index >= 0 ? nodeIndex.atPoint3D(node.index) : node.pos.toCartesian();
+    return node.index >= 0 ? point3D(node.index) : node.pos.toCartesian();
   }
 
-  /* Check if altitude, RNAV constraints and more allow to use this edge */
-  bool matchEdge(const atools::routing::Edge& edge) const;
+  /* Add airway or track edge to the result if it matches all filters and leads towards target.
+   * prevEdge is the edge leading to origin in search direction. */
+  void addEdge(atools::routing::Result& result, QSet<int>& nodeIndexes, const atools::routing::Edge *edgePtr,
+               int edgeIndex, const atools::geo::Point3D& originPoint, const atools::geo::Point3D& targetPoint,
+               float originToTargetDist, bool originNotTrackEnd, const atools::routing::Edge *prevEdge) const;
+
+  /* Check if altitude, RNAV constraints and more allow to use this edge.
+   * Type and RNAV checks use a single lookup of the precalculated edge attributes. */
+  bool matchEdge(const atools::routing::Edge& edge) const
+  {
+    if(!((edgeMatchTable >> edge.attributes) & 1))
+      return false;
+
+    if(altitude > 0)
+    {
+      if(altitude < edge.minAltFt || altitude > edge.maxAltFt)
+        return false;
+
+      if(edge.hasAltLevels)
+        return matchAltLevels(edge);
+    }
+    return true;
+  }
+
+  /* Check track altitude levels for the current altitude */
+  bool matchAltLevels(const atools::routing::Edge& edge) const;
+
+  /* Fill match tables for current mode. Called when mode changes. */
+  void updateMatchTables();
 
   /* Get point in 3D space. Returns destination or departure for appropriate indexes. */
   const atools::geo::Point3D& point3D(int index) const;
@@ -217,15 +490,24 @@ private:
   /* Filter for getNeighbours */
   atools::routing::Modes mode = atools::routing::MODE_ALL;
 
+  /* Bit n is set if edges or nodes with attributes n match the mode. See updateMatchTables(). */
+  quint32 edgeMatchTable = 0;
+  quint64 nodeMatchTable = 0;
+
   atools::routing::Node departureNode, destinationNode;
   atools::geo::Point3D departurePoint, destinationPoint;
   float routeDirectDistance = 0.f, routeGcDistance = 0.f;
 
-  /* Spatial index for nearest neighbor search using KD-tree internally */
-  atools::geo::SpatialIndex<Node> nodeIndex;
+  bool shortcutsEnabled = true;
 
-  /* Map database track.track_id to altitude levels if existing */
-  QHash<int, QVector<quint16> > altLevelsEast, altLevelsWest;
+  /* Reused result buffer for searchNearest() */
+  mutable QVector<int> nearestIndexes;
+
+  /* Shared graph. Never null. */
+  QSharedPointer<atools::routing::RouteNetworkData> data;
+
+  /* Shared track overlay. Null if no tracks are loaded. */
+  QSharedPointer<const atools::routing::RouteTrackData> tracks;
 
   atools::routing::DataSource source = atools::routing::SOURCE_NONE;
 };
@@ -17,21 +17,33 @@
 
 #include "routing/routenetworkloader.h"
 
+#include "sql/sqlconnectionpool.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
+#include "sql/sqlitestatement.h"
 #include "sql/sqlrecord.h"
 #include "sql/sqlutil.h"
 #include "geo/calculations.h"
 #include "routing/routenetwork.h"
 #include "track/tracktypes.h"
 #include "io/binaryutil.h"
+#include "util/trace.h"
+#include "util/parallel.h"
 
+#include <QBuffer>
+#include <QDataStream>
+#include <QDir>
 #include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <exception>
 
 using atools::sql::SqlUtil;
 using atools::sql::SqlQuery;
+using atools::sql::SqliteStatement;
 using atools::geo::nmToMeter;
 using atools::geo::Point3D;
+using atools::geo::SpatialIndex;
 
 // Calculate hash for airway name for quick comparison in routing algorithm
 inline quint32 airwayHash(const QString& name)
@@ -59,15 +71,31 @@ RouteNetworkLoader::~RouteNetworkLoader()
 
 void RouteNetworkLoader::load(atools::routing::RouteNetwork *networkParam)
 {
+  ATOOLS_TRACE_SCOPE("RouteNetworkLoader::load", "routing");
+
   QElapsedTimer timer;
   timer.start();
 
   network = networkParam;
   network->clear();
 
-  bool hasTracks = dbTrack != nullptr && SqlUtil(dbTrack).hasTableAndRows("track");
   bool hasNav = dbNav != nullptr && SqlUtil(dbNav).hasTableAndRows("waypoint");
 
+  // Try to use binary snapshot ==========================================
+  QString key, cacheFilename;
+  if(cacheEnabled)
+  {
+    cacheFilename = getCacheFilename();
+    key = cacheKey();
+
+    if(!cacheFilename.isEmpty() && readCache(cacheFilename, key))
+    {
+      loadTracks(network);
+      qDebug() << Q_FUNC_INFO << "from cache" << cacheFilename << timer.restart() << "ms";
+      return;
+    }
+  }
+
   if(network->source == SOURCE_RADIO && dbNav != nullptr)
   {
     // Load VOR, VORDME and VORTAC. No DME and no TACAN. ==========================================
@@ -87,14 +115,6 @@ void RouteNetworkLoader::load(atools::routing::RouteNetwork *networkParam)
     QMultiHash<int, Edge> nodeEdgeMap;
     nodeEdgeMap.reserve(200000);
 
-    // Read navdata edges ==========================================
-    if(hasNav)
-      readEdgesAirway(nodeEdgeMap, false);
-
-    // Read track edges ==========================================
-    if(hasTracks)
-      readEdgesAirway(nodeEdgeMap, true /* track */);
-
     // Maps the database node id to index position in vector
     QHash<int, int> nodeIdIndexMap;
     nodeIdIndexMap.reserve(300000);
@@ -103,83 +123,49 @@ void RouteNetworkLoader::load(atools::routing::RouteNetwork *networkParam)
     QVector<Node> nodeVector;
     nodeVector.reserve(300000);
 
-    // Column order is important in the queries
-
-    // Read navaids into nodeIdIndexMap and into nodesTemp ====================
-    // Named waypoints without airways
-    // Unnamed degree confluence waypoints
-    if(hasNav)
-      readNodesAirway(nodeVector, nodeIdIndexMap,
-                      "select w.waypoint_id, w.ident, w.type, w.lonx, w.laty "
-                      "from waypoint w "
-                      "where (w.type = 'WN' or (w.type = 'WU' and w.airport_id is null)) and "
-                      "w.num_jet_airway = 0 and w.num_victor_airway = 0",
-                      false, false, true /* filterUnnamed */, false);
-    // "where w.type = 'WN' and "
-
-    // Airway waypoints ====================
-    if(hasNav)
-      readNodesAirway(nodeVector, nodeIdIndexMap,
-                      "select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway "
-                      "from waypoint w "
-                      "where w.type like 'W%' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)",
-                      false, false, false, false);
-
-    // Track waypoints ====================
-    if(hasTracks)
-    {
-      QString where = hasNav ?
-                      (" where w.trackpoint_id >= " + QString::number(atools::track::TRACKPOINT_ID_OFFSET)) :
-                      QString();
-
-      readNodesAirway(nodeVector,
-                      nodeIdIndexMap,
-                      "select w.trackpoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway "
-                      "from trackpoint w " + where,
-                      false, false, false,
-                      true /* track */);
-    }
-
-    // Airway VOR waypoints ====================
-    if(hasNav)
-      readNodesAirway(nodeVector, nodeIdIndexMap,
-                      "select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway, "
-                      "v.range, v.type as radiotype, v.dme_altitude,  v.dme_only "
-                      "from waypoint w join vor v on w.nav_id = v.vor_id "
-                      "where w.type = 'V' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)",
-                      true /* VOR */, false, false, false);
-
-    // Airway NDB waypoints ====================
+    // Read navdata edges and nodes ==========================================
+    // Tracks are loaded separately into an overlay by loadTracks()
     if(hasNav)
-      readNodesAirway(nodeVector, nodeIdIndexMap,
-                      "select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway, "
-                      "n.range "
-                      "from waypoint w join ndb n on w.nav_id = n.ndb_id "
-                      "where w.type = 'N' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)",
-                      false, true /* NDB */, false, false);
-
-    // Insert outgoing edges to each node and copy node to the index ========================
-    network->nodeIndex.reserve(nodeVector.size());
-    for(Node& node : nodeVector)
+      readAirwayNetwork(nodeEdgeMap, nodeVector, nodeIdIndexMap);
+
+    // Insert outgoing edges to contiguous array and copy node to the index ========================
+    QVector<Edge>& edges = network->data->edges;
+    QVector<int>& edgeOffsets = network->data->edgeOffsets;
+    edges.reserve(nodeEdgeMap.size());
+    edgeOffsets.reserve(nodeVector.size() + 1);
+    network->data->nodeIndex.reserve(nodeVector.size());
+    for(const Node& node : nodeVector)
     {
-      node.edges = nodeEdgeMap.values(node.id).toVector();
+      edgeOffsets.append(edges.size());
 
-      // Replace database ids in Edge::toIndex with array indexes
-      for(Edge& edge : node.edges)
+      for(auto it = nodeEdgeMap.constFind(node.id); it != nodeEdgeMap.constEnd() && it.key() == node.id; ++it)
+      {
+        // Replace database ids in Edge::toIndex with array indexes
+        Edge edge = it.value();
         edge.toIndex = nodeIdIndexMap.value(edge.toIndex);
+        edges.append(edge);
+      }
 
-      network->nodeIndex.append(node);
+      network->data->nodeIndex.append(node);
     }
+    edgeOffsets.append(edges.size());
   } // else if(network->source == SOURCE_AIRWAY)
 
   // Update spatial index
-  network->nodeIndex.updateIndex();
+  network->data->nodeIndex.updateIndex();
 
   // Calculate distance for all edges of all nodes and set node connection flags ================
-  for(Node& node : network->nodeIndex)
-  {
+  // Nodes are independent and write only their own outgoing edges
+  SpatialIndex<Node>& nodeIndex = network->data->nodeIndex;
+  Node *nodes = nodeIndex.data();
+  QVector<MutableEdgeRange> ranges(nodeIndex.size());
+  for(int i = 0; i < nodeIndex.size(); i++)
+    ranges[i] = nodeEdges(i);
+
+  atools::util::parallelFor(nodeIndex.size(), [&nodeIndex, nodes, &ranges](int i) -> void {
+    Node& node = nodes[i];
     atools::routing::NodeConnections connections = CONNECTION_NONE;
-    for(Edge& edge : node.edges)
+    for(Edge& edge : ranges.at(i))
     {
       // Fill connection flags based on outgoing edges
       switch(edge.type)
@@ -200,30 +186,224 @@ void RouteNetworkLoader::load(atools::routing::RouteNetwork *networkParam)
           break;
 
         case atools::routing::EDGE_TRACK:
-          connections |= CONNECTION_TRACK;
+          // Tracks are in the overlay
           break;
       }
 
       // Calculate great circle distance for all edges ====================
-      edge.lengthMeter = atools::roundToInt(network->nodeIndex.atPoint3D(node.index).
-                                            gcDistanceMeter(network->nodeIndex.atPoint3D(edge.toIndex)));
+      edge.lengthMeter = atools::roundToInt(nodeIndex.atPoint3D(node.index).
+                                            gcDistanceMeter(nodeIndex.atPoint3D(edge.toIndex)));
     }
     node.setConnections(connections);
+  }, 10000);
+
+  // Save snapshot before reverse edges are added which are not stored
+  if(cacheEnabled && !cacheFilename.isEmpty())
+    writeCache(cacheFilename, key);
+
+  // Grid and reverse edges are independent
+  RouteNetworkData *data = network->data.data();
+  atools::util::TaskHandle gridTask =
+    atools::util::TaskScheduler::instance().run([data]() -> void {
+    data->buildGrid();
+  }, atools::util::TASK_INTERACTIVE);
+  buildReverseEdges();
+  gridTask.wait();
+
+  readShortcuts();
+  loadTracks(network);
+
+  qDebug() << Q_FUNC_INFO << timer.restart() << "ms";
+}
+
+void RouteNetworkLoader::loadTracks(atools::routing::RouteNetwork *networkParam)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  network = networkParam;
+  network->setTracks(QSharedPointer<const RouteTrackData>());
+
+  if(network->source != SOURCE_AIRWAY || dbTrack == nullptr || !SqlUtil(dbTrack).hasTableAndRows("track"))
+    return;
+
+  QSharedPointer<RouteTrackData> trackData(new RouteTrackData);
+  RouteTrackData *tracks = trackData.data();
+  const RouteNetworkData *data = network->data.data();
+  tracks->numBaseNodes = data->nodeIndex.size();
+
+  // Read track edges. Edge::toIndex gets database id temporarily ====================
+  QMultiHash<int, Edge> nodeEdgeMap;
+  readEdgesAirway(dbTrack, nodeEdgeMap, tracks);
+
+  // Track waypoints which are not part of the navdata ====================
+  QString where = data->nodeIndex.isEmpty() ? QString() :
+                  (" where w.trackpoint_id >= " + QString::number(atools::track::TRACKPOINT_ID_OFFSET));
+  QHash<int, int> trackIdIndexMap;
+  readNodesAirway(dbTrack, tracks->nodes, trackIdIndexMap,
+                  "select w.trackpoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway "
+                  "from trackpoint w " + where,
+                  false, false, false, true /* track */);
+
+  // Maps the database node id to index for airway graph and track nodes
+  QHash<int, int> nodeIdIndexMap;
+  nodeIdIndexMap.reserve(tracks->numNodes());
+  for(const Node& node : data->nodeIndex)
+    nodeIdIndexMap.insert(node.id, node.index);
+
+  tracks->points.reserve(tracks->nodes.size());
+  for(Node& node : tracks->nodes)
+  {
+    node.index += tracks->numBaseNodes;
+    nodeIdIndexMap.insert(node.id, node.index);
+    tracks->points.append(node.pos.toCartesian());
+  }
+
+  auto point = [data, tracks](int index) -> const Point3D& {
+    return index < tracks->numBaseNodes ? data->nodeIndex.atPoint3D(index) :
+           tracks->points.at(index - tracks->numBaseNodes);
+  };
+
+  // Replace ids with indexes and calculate distances ====================
+  // Start node index and edge
+  QVector<QPair<int, Edge> > nodeEdges;
+  nodeEdges.reserve(nodeEdgeMap.size());
+  int numInvalid = 0;
+  for(auto it = nodeEdgeMap.constBegin(); it != nodeEdgeMap.constEnd(); ++it)
+  {
+    Edge edge = it.value();
+    int fromIndex = nodeIdIndexMap.value(it.key(), -1);
+    edge.toIndex = nodeIdIndexMap.value(edge.toIndex, -1);
+
+    if(fromIndex == -1 || edge.toIndex == -1)
+      // Track uses a waypoint which is not part of the network
+      numInvalid++;
+    else
+    {
+      edge.lengthMeter = atools::roundToInt(point(fromIndex).gcDistanceMeter(point(edge.toIndex)));
+      nodeEdges.append(qMakePair(fromIndex, edge));
+    }
+  }
+
+  // Build outgoing and incoming edges in compressed sparse row format ====================
+  int numNodes = tracks->numNodes();
+  tracks->edgeOffsets.fill(0, numNodes + 1);
+  tracks->reverseEdgeOffsets.fill(0, numNodes + 1);
+  for(const QPair<int, Edge>& nodeEdge : nodeEdges)
+  {
+    tracks->edgeOffsets[nodeEdge.first + 1]++;
+    tracks->reverseEdgeOffsets[nodeEdge.second.toIndex + 1]++;
+  }
+
+  for(int i = 0; i < numNodes; i++)
+  {
+    tracks->edgeOffsets[i + 1] += tracks->edgeOffsets.at(i);
+    tracks->reverseEdgeOffsets[i + 1] += tracks->reverseEdgeOffsets.at(i);
+  }
+
+  QVector<int> insertPos(tracks->edgeOffsets), reverseInsertPos(tracks->reverseEdgeOffsets);
+  tracks->edges.resize(nodeEdges.size());
+  tracks->reverseEdges.resize(nodeEdges.size());
+  tracks->connections.fill(CONNECTION_NONE, numNodes);
+  for(const QPair<int, Edge>& nodeEdge : nodeEdges)
+  {
+    const Edge& edge = nodeEdge.second;
+    tracks->edges[insertPos[nodeEdge.first]++] = edge;
+
+    Edge reverseEdge(edge);
+    reverseEdge.toIndex = nodeEdge.first;
+    tracks->reverseEdges[reverseInsertPos[edge.toIndex]++] = reverseEdge;
+
+    // Connection flags based on outgoing edges
+    tracks->connections[nodeEdge.first] |= CONNECTION_TRACK;
   }
 
   // Assign CONNECTION_TRACK_START_END to all nodes which are track end or start points
-  if(hasTracks)
-    readTrackStartEndPoints();
+  readTrackStartEndPoints(nodeIdIndexMap, tracks);
 
-  qDebug() << Q_FUNC_INFO << timer.restart() << "ms";
+  for(Node& node : tracks->nodes)
+    node.setConnections(tracks->nodeConnections(node.index));
+
+  // Shortcuts must not skip nodes where tracks start, end or pass through ====================
+  int numBlocked = 0;
+  for(int i = 0; i + 1 < data->shortcutEdgeOffsets.size(); i++)
+  {
+    // Last edge leads to the chain end which is not skipped
+    for(int j = data->shortcutEdgeOffsets.at(i); j < data->shortcutEdgeOffsets.at(i + 1) - 1; j++)
+    {
+      if(tracks->nodeConnections(data->shortcutEdges.at(j).toIndex) != CONNECTION_NONE)
+      {
+        if(tracks->blockedShortcuts.isEmpty())
+          tracks->blockedShortcuts.fill(false, data->shortcuts.size());
+        tracks->blockedShortcuts[i] = true;
+        numBlocked++;
+        break;
+      }
+    }
+  }
+
+  network->setTracks(trackData);
+
+  qDebug() << Q_FUNC_INFO << "nodes" << tracks->nodes.size() << "edges" << tracks->edges.size()
+           << "invalid" << numInvalid << "blocked shortcuts" << numBlocked << timer.restart() << "ms";
+}
+
+void RouteNetworkLoader::buildReverseEdges()
+{
+  // Build incoming edges for backward search in bidirectional routing ================
+  // Edge::toIndex of a reverse edge points to the start node of the original edge
+  RouteNetworkData *data = network->data.data();
+  data->reverseEdges.clear();
+  data->reverseEdgeOffsets.clear();
+
+  if(data->edgeOffsets.isEmpty())
+    return;
+
+  int numNodes = data->nodeIndex.size();
+
+  // Count incoming edges for each node and convert counts to offsets
+  QVector<int>& offsets = data->reverseEdgeOffsets;
+  offsets.fill(0, numNodes + 1);
+  for(const Edge& edge : data->edges)
+    offsets[edge.toIndex + 1]++;
+
+  for(int i = 0; i < numNodes; i++)
+    offsets[i + 1] += offsets.at(i);
+
+  // Fill edges using a running insert position for each node
+  QVector<int> insertPos(offsets);
+  data->reverseEdges.resize(data->edges.size());
+  for(int i = 0; i < numNodes; i++)
+  {
+    for(const Edge& edge : nodeEdges(i))
+    {
+      Edge reverseEdge(edge);
+      reverseEdge.toIndex = i;
+      data->reverseEdges[insertPos[edge.toIndex]++] = reverseEdge;
+    }
+  }
 }
 
-void RouteNetworkLoader::readTrackStartEndPoints() const
+void RouteNetworkLoader::readShortcuts()
 {
+  RouteNetworkData *data = network->data.data();
+  data->shortcuts.clear();
+  data->reverseShortcuts.clear();
+  data->shortcutEdges.clear();
+  data->shortcutEdgeOffsets.clear();
+  data->edgeShortcuts.clear();
+  data->reverseEdgeShortcuts.clear();
+
+  if(network->source != SOURCE_AIRWAY || dbNav == nullptr || data->edges.isEmpty() ||
+     !SqlUtil(dbNav).hasTableAndRows("route_shortcut_airway"))
+    return;
+
   enum
   {
-    STARTPOINT_ID,
-    ENDPOINT_ID
+    FROM_ID,
+    VIA_ID,
+    TO_ID,
+    NUM_SEGMENTS
   };
 
   // Build a temporary index mapping id to array index
@@ -231,23 +411,496 @@ void RouteNetworkLoader::readTrackStartEndPoints() const
   for(const Node& node : network->getNodes())
     nodeIdIndexMap.insert(node.id, node.index);
 
+  data->edgeShortcuts.fill(-1, data->edges.size());
+  data->reverseEdgeShortcuts.fill(-1, data->reverseEdges.size());
+  data->shortcutEdgeOffsets.append(0);
+
+  int numInvalid = 0;
+  QVector<int> chain;
+  SqlQuery query("select from_waypoint_id, via_waypoint_id, to_waypoint_id, num_segments from route_shortcut_airway",
+                 dbNav);
+  query.exec();
+  while(query.next())
+  {
+    int fromIndex = nodeIdIndexMap.value(query.valueInt(FROM_ID), -1);
+    int viaIndex = nodeIdIndexMap.value(query.valueInt(VIA_ID), -1);
+    int toIndex = nodeIdIndexMap.value(query.valueInt(TO_ID), -1);
+
+    if(fromIndex == -1 || viaIndex == -1 || toIndex == -1 ||
+       !shortcutChain(chain, fromIndex, viaIndex, toIndex, query.valueInt(NUM_SEGMENTS)) ||
+       data->edgeShortcuts.at(chain.first()) != -1)
+    {
+      numInvalid++;
+      continue;
+    }
+
+    // Combine lengths and altitude restrictions the same way as the route finder does along the chain
+    Edge shortcut = data->edges.at(chain.first());
+    shortcut.toIndex = toIndex;
+    shortcut.lengthMeter = 0;
+    for(int edgeIndex : chain)
+    {
+      const Edge& edge = data->edges.at(edgeIndex);
+      shortcut.lengthMeter += edge.lengthMeter;
+      shortcut.minAltFt = std::max(shortcut.minAltFt, edge.minAltFt);
+      shortcut.maxAltFt = std::min(shortcut.maxAltFt, edge.maxAltFt);
+    }
+
+    if(shortcut.minAltFt > shortcut.maxAltFt)
+    {
+      // Chain cannot be used at any altitude
+      numInvalid++;
+      continue;
+    }
+
+    // Find the incoming edge at the chain end for the backward search
+    int lastFromIndex = chain.size() > 1 ? data->edges.at(chain.at(chain.size() - 2)).toIndex : fromIndex;
+    const Edge& lastEdge = data->edges.at(chain.last());
+    int reverseEdgeIndex = -1;
+    for(int i = data->reverseEdgeOffsets.at(toIndex); i < data->reverseEdgeOffsets.at(toIndex + 1); i++)
+    {
+      const Edge& edge = data->reverseEdges.at(i);
+      if(edge.toIndex == lastFromIndex && edge.airwayHash == lastEdge.airwayHash && edge.type == lastEdge.type)
+      {
+        reverseEdgeIndex = i;
+        break;
+      }
+    }
+
+    if(reverseEdgeIndex == -1 || data->reverseEdgeShortcuts.at(reverseEdgeIndex) != -1)
+    {
+      numInvalid++;
+      continue;
+    }
+
+    shortcut.id = data->shortcuts.size();
+    shortcut.shortcut = true;
+    data->edgeShortcuts[chain.first()] = shortcut.id;
+    data->reverseEdgeShortcuts[reverseEdgeIndex] = shortcut.id;
+    data->shortcuts.append(shortcut);
+
+    shortcut.toIndex = fromIndex;
+    data->reverseShortcuts.append(shortcut);
+
+    for(int edgeIndex : chain)
+      data->shortcutEdges.append(data->edges.at(edgeIndex));
+    data->shortcutEdgeOffsets.append(data->shortcutEdges.size());
+  }
+
+  if(data->shortcuts.isEmpty())
+  {
+    data->shortcutEdgeOffsets.clear();
+    data->edgeShortcuts.clear();
+    data->reverseEdgeShortcuts.clear();
+  }
+
+  qDebug() << Q_FUNC_INFO << "shortcuts" << data->shortcuts.size() << "skipped edges" << data->shortcutEdges.size()
+           << "invalid" << numInvalid;
+}
+
+bool RouteNetworkLoader::shortcutChain(QVector<int>& edgeIndexes, int fromIndex, int viaIndex, int toIndex,
+                                       int numSegments) const
+{
+  const RouteNetworkData *data = network->data.data();
+  edgeIndexes.clear();
+
+  // Find first edge of chain
+  for(int i = data->edgeOffsets.at(fromIndex); i < data->edgeOffsets.at(fromIndex + 1); i++)
+  {
+    const Edge& edge = data->edges.at(i);
+    if(edge.toIndex == viaIndex && edge.isAnyAirway())
+    {
+      edgeIndexes.append(i);
+      break;
+    }
+  }
+
+  if(edgeIndexes.isEmpty())
+    return false;
+
+  const Edge& firstEdge = data->edges.at(edgeIndexes.first());
+  auto sameAirway = [&firstEdge](const Edge& edge) -> bool {
+    return edge.airwayHash == firstEdge.airwayHash && edge.type == firstEdge.type &&
+           edge.routeType == firstEdge.routeType && !edge.hasAltLevels;
+  };
+
+  int previous = fromIndex, current = viaIndex;
+  while(current != toIndex)
+  {
+    if(edgeIndexes.size() >= numSegments || current == fromIndex)
+      return false;
+
+    // All outgoing edges have to lead back or to the next node along the same airway
+    int next = -1, nextEdgeIndex = -1;
+    for(int i = data->edgeOffsets.at(current); i < data->edgeOffsets.at(current + 1); i++)
+    {
+      const Edge& edge = data->edges.at(i);
+      if(!sameAirway(edge))
+        return false;
+
+      if(edge.toIndex != previous)
+      {
+        if(next != -1 && next != edge.toIndex)
+          return false;
+
+        next = edge.toIndex;
+        nextEdgeIndex = i;
+      }
+    }
+
+    if(next == -1)
+      return false;
+
+    // Same for incoming edges
+    for(int i = data->reverseEdgeOffsets.at(current); i < data->reverseEdgeOffsets.at(current + 1); i++)
+    {
+      const Edge& edge = data->reverseEdges.at(i);
+      if(!sameAirway(edge) || (edge.toIndex != previous && edge.toIndex != next))
+        return false;
+    }
+
+    edgeIndexes.append(nextEdgeIndex);
+    previous = current;
+    current = next;
+  }
+
+  return edgeIndexes.size() == numSegments;
+}
+
+RouteNetworkLoader::MutableEdgeRange RouteNetworkLoader::nodeEdges(int index)
+{
+  RouteNetworkData *data = network->data.data();
+  if(index + 1 >= data->edgeOffsets.size())
+    return MutableEdgeRange();
+
+  Edge *edges = data->edges.data();
+  return MutableEdgeRange(edges + data->edgeOffsets.at(index), edges + data->edgeOffsets.at(index + 1));
+}
+
+QString RouteNetworkLoader::getCacheFilename() const
+{
+  if(dbNav == nullptr)
+    return QString();
+
+  QFileInfo fi(dbNav->databaseName());
+  if(!fi.exists())
+    return QString();
+
+  return fi.absolutePath() + QDir::separator() + fi.completeBaseName() +
+         (network != nullptr && network->isRadionavRouting() ? "_route_radio.bin" : "_route_airway.bin");
+}
+
+QString RouteNetworkLoader::cacheKey() const
+{
+  QStringList key;
+  key.append(QString::number(network->source));
+
+  if(dbNav != nullptr && SqlUtil(dbNav).hasTable("metadata"))
+  {
+    SqlQuery query("select db_version_major, db_version_minor, last_load_timestamp, airac_cycle from metadata",
+                   dbNav);
+    query.exec();
+    if(query.next())
+      key << query.valueStr(0) << query.valueStr(1) << query.valueStr(2) << query.valueStr(3);
+  }
+  return key.join("|");
+}
+
+void RouteNetworkLoader::writeCache(const QString& filename, const QString& key) const
+{
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    out << CACHE_MAGIC_NUMBER << CACHE_VERSION << key;
+
+    const SpatialIndex<Node>& nodes = network->data->nodeIndex;
+    out << static_cast<qint32>(nodes.size());
+    for(const Node& node : nodes)
+    {
+      out << static_cast<qint32>(node.id) << static_cast<qint32>(node.range)
+          << node.pos.getLonX() << node.pos.getLatY()
+          << static_cast<quint8>(node.type) << static_cast<quint8>(node.subtype) << static_cast<quint8>(node.con);
+
+      EdgeRange edges = network->getEdges(node);
+      out << static_cast<qint32>(edges.size());
+      for(const Edge& edge : edges)
+        out << static_cast<qint32>(edge.toIndex) << static_cast<qint32>(edge.lengthMeter)
+            << static_cast<qint32>(edge.id) << edge.airwayHash << edge.minAltFt << edge.maxAltFt
+            << static_cast<quint8>(edge.type) << static_cast<quint8>(edge.routeType) << edge.hasAltLevels;
+    }
+
+    if(out.status() != QDataStream::Ok)
+    {
+      qWarning() << Q_FUNC_INFO << "Error writing" << filename;
+      file.close();
+      file.remove();
+    }
+    else
+      file.close();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << ":" << file.errorString();
+}
+
+bool RouteNetworkLoader::readCache(const QString& filename, const QString& key)
+{
+  QFile file(filename);
+  if(!file.exists())
+    return false;
+
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot read" << filename << ":" << file.errorString();
+    return false;
+  }
+
+  // Map file into memory and read without copying
+  uchar *mapped = file.map(0, file.size());
+  QByteArray bytes;
+  QDataStream in;
+  QBuffer buffer;
+  if(mapped != nullptr)
+  {
+    bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), static_cast<int>(file.size()));
+    buffer.setData(bytes);
+    buffer.open(QIODevice::ReadOnly);
+    in.setDevice(&buffer);
+  }
+  else
+    in.setDevice(&file);
+
+  in.setVersion(QDataStream::Qt_5_5);
+  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  quint32 magic;
+  quint16 version;
+  QString fileKey;
+  in >> magic >> version >> fileKey;
+
+  bool ok = false;
+  if(magic != CACHE_MAGIC_NUMBER)
+    qWarning() << Q_FUNC_INFO << "Invalid magic number in" << filename;
+  else if(version != CACHE_VERSION)
+    qInfo() << Q_FUNC_INFO << "Outdated version in" << filename;
+  else if(fileKey != key)
+    qInfo() << Q_FUNC_INFO << "Outdated" << filename << "key" << fileKey << "expected" << key;
+  else
+  {
+    SpatialIndex<Node>& nodes = network->data->nodeIndex;
+    QVector<Edge>& edges = network->data->edges;
+    QVector<int>& edgeOffsets = network->data->edgeOffsets;
+
+    qint32 numNodes;
+    in >> numNodes;
+    nodes.reserve(numNodes);
+    edgeOffsets.reserve(numNodes + 1);
+    for(qint32 i = 0; i < numNodes && in.status() == QDataStream::Ok; i++)
+    {
+      Node node;
+      qint32 id, range, numEdges;
+      float lonx, laty;
+      quint8 type, subtype, con;
+      in >> id >> range >> lonx >> laty >> type >> subtype >> con >> numEdges;
+
+      node.index = i;
+      node.id = id;
+      node.range = range;
+      node.pos = atools::geo::Pos(lonx, laty);
+      node.type = static_cast<NodeType>(type);
+      node.subtype = static_cast<NodeType>(subtype);
+      node.con = static_cast<NodeConnection>(con);
+      node.updateAttributes();
+
+      edgeOffsets.append(edges.size());
+      for(qint32 j = 0; j < numEdges; j++)
+      {
+        Edge edge;
+        qint32 toIndex, lengthMeter, edgeId;
+        quint8 edgeType, routeType;
+        in >> toIndex >> lengthMeter >> edgeId >> edge.airwayHash >> edge.minAltFt >> edge.maxAltFt
+        >> edgeType >> routeType >> edge.hasAltLevels;
+        edge.toIndex = toIndex;
+        edge.lengthMeter = lengthMeter;
+        edge.id = edgeId;
+        edge.type = static_cast<EdgeType>(edgeType);
+        edge.routeType = static_cast<RouteType>(routeType);
+        edge.updateAttributes();
+        edges.append(edge);
+      }
+      nodes.append(node);
+    }
+
+    // Radionav networks have no edges
+    if(!edges.isEmpty())
+      edgeOffsets.append(edges.size());
+    else
+      edgeOffsets.clear();
+
+    ok = in.status() == QDataStream::Ok;
+    if(ok)
+    {
+      nodes.updateIndex();
+      buildReverseEdges();
+      network->data->buildGrid();
+      readShortcuts();
+    }
+    else
+    {
+      qWarning() << Q_FUNC_INFO << "Error reading" << filename;
+      network->clear();
+    }
+  }
+
+  buffer.close();
+  if(mapped != nullptr)
+    file.unmap(mapped);
+  file.close();
+  return ok;
+}
+
+void RouteNetworkLoader::readTrackStartEndPoints(const QHash<int, int>& nodeIdIndexMap,
+                                                 RouteTrackData *trackData) const
+{
+  enum
+  {
+    STARTPOINT_ID,
+    ENDPOINT_ID
+  };
+
   SqlQuery query("select startpoint_id, endpoint_id from trackmeta", dbTrack);
   query.exec();
   while(query.next())
   {
-    network->nodeIndex[nodeIdIndexMap.value(query.valueInt(STARTPOINT_ID))].addConnection(CONNECTION_TRACK_START_END);
-    network->nodeIndex[nodeIdIndexMap.value(query.valueInt(ENDPOINT_ID))].addConnection(CONNECTION_TRACK_START_END);
+    for(int col : {STARTPOINT_ID, ENDPOINT_ID})
+    {
+      int index = nodeIdIndexMap.value(query.valueInt(col), -1);
+      if(index != -1)
+        trackData->connections[index] |= CONNECTION_TRACK_START_END;
+    }
   }
 }
 
-void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, bool track) const
+void RouteNetworkLoader::readAirwayNetwork(QMultiHash<int, Edge>& nodeEdgeMap, QVector<Node>& nodeVector,
+                                           QHash<int, int>& nodeIdIndexMap) const
 {
+  // Column order is important in the queries. Nodes are indexed in the order of the queries.
+  struct NodeQuery
+  {
+    QString queryStr;
+    bool vor, ndb, filterUnnamed;
+  };
+
+  const static QVector<NodeQuery> NODE_QUERIES({
+    // Named waypoints without airways
+    // Unnamed degree confluence waypoints
+    {"select w.waypoint_id, w.ident, w.type, w.lonx, w.laty "
+     "from waypoint w "
+     "where (w.type = 'WN' or (w.type = 'WU' and w.airport_id is null)) and "
+     "w.num_jet_airway = 0 and w.num_victor_airway = 0", false, false, true /* filterUnnamed */},
+
+    // Airway waypoints ====================
+    {"select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway "
+     "from waypoint w "
+     "where w.type like 'W%' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)", false, false, false},
+
+    // Airway VOR waypoints ====================
+    {"select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway, "
+     "v.range, v.type as radiotype, v.dme_altitude,  v.dme_only "
+     "from waypoint w join vor v on w.nav_id = v.vor_id "
+     "where w.type = 'V' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)", true /* VOR */, false, false},
+
+    // Airway NDB waypoints ====================
+    {"select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway, "
+     "n.range "
+     "from waypoint w join ndb n on w.nav_id = n.ndb_id "
+     "where w.type = 'N' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)", false, true /* NDB */, false}
+  });
+
+  // Buffers for each node query. Indexes and ids are local to the buffer.
+  QVector<QVector<Node> > nodeBuffers(NODE_QUERIES.size());
+  QVector<QHash<int, int> > idBuffers(NODE_QUERIES.size());
+
+  if(connectionPool != nullptr)
+  {
+    // Edges and each node query are read concurrently on own read-only connections ======================
+    QVector<std::exception_ptr> exceptions(NODE_QUERIES.size() + 1);
+    QVector<atools::util::TaskHandle> tasks;
+    atools::util::TaskScheduler& scheduler = atools::util::TaskScheduler::instance();
+
+    tasks.append(scheduler.run([this, &nodeEdgeMap, &exceptions]() -> void {
+      try
+      {
+        atools::sql::SqlConnectionLease lease(connectionPool);
+        readEdgesAirway(lease.db(), nodeEdgeMap, nullptr);
+      }
+      catch(...)
+      {
+        exceptions[0] = std::current_exception();
+      }
+    }, atools::util::TASK_INTERACTIVE));
+
+    for(int i = 0; i < NODE_QUERIES.size(); i++)
+    {
+      tasks.append(scheduler.run([this, i, &nodeBuffers, &idBuffers, &exceptions]() -> void {
+        try
+        {
+          const NodeQuery& q = NODE_QUERIES.at(i);
+          atools::sql::SqlConnectionLease lease(connectionPool);
+          readNodesAirway(lease.db(), nodeBuffers[i], idBuffers[i], q.queryStr, q.vor, q.ndb, q.filterUnnamed, false);
+        }
+        catch(...)
+        {
+          exceptions[i + 1] = std::current_exception();
+        }
+      }, atools::util::TASK_INTERACTIVE));
+    }
+
+    for(const atools::util::TaskHandle& task : tasks)
+      task.wait();
+
+    for(const std::exception_ptr& exception : exceptions)
+    {
+      if(exception)
+        std::rethrow_exception(exception);
+    }
+  }
+  else
+  {
+    // Read sequentially on the navdatabase connection ======================
+    readEdgesAirway(dbNav, nodeEdgeMap, nullptr);
+    for(int i = 0; i < NODE_QUERIES.size(); i++)
+    {
+      const NodeQuery& q = NODE_QUERIES.at(i);
+      readNodesAirway(dbNav, nodeBuffers[i], idBuffers[i], q.queryStr, q.vor, q.ndb, q.filterUnnamed, false);
+    }
+  }
+
+  // Merge buffers in query order ======================
+  for(const QVector<Node>& buffer : nodeBuffers)
+  {
+    for(Node node : buffer)
+    {
+      node.index = nodeVector.size();
+      nodeIdIndexMap.insert(node.id, node.index);
+      nodeVector.append(node);
+    }
+  }
+}
+
+void RouteNetworkLoader::readEdgesAirway(atools::sql::SqlDatabase *db, QMultiHash<int, Edge>& nodeEdgeMap,
+                                         RouteTrackData *trackData) const
+{
+  bool track = trackData != nullptr;
   atools::sql::SqlRecord rec;
   QString queryTxt;
 
   if(track)
   {
-    rec = dbTrack->record("track");
+    rec = db->record("track");
     queryTxt = "select track_id, from_waypoint_id, to_waypoint_id, airway_minimum_altitude, airway_maximum_altitude, "
                "track_name, 'T' as route_type, null as airway_type, 'F' as direction, "
                "altitude_levels_east, altitude_levels_west, track_type "
@@ -255,7 +908,7 @@ void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, boo
   }
   else
   {
-    rec = dbNav->record("airway");
+    rec = db->record("airway");
     if(rec.contains("route_type"))
       queryTxt = "select airway_id, from_waypoint_id, to_waypoint_id, minimum_altitude, maximum_altitude, airway_name, "
                  "route_type, airway_type, direction from airway";
@@ -281,8 +934,9 @@ void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, boo
     TRACK_TYPE
   };
 
-  SqlQuery query(queryTxt, track ? dbTrack : dbNav);
-  query.exec();
+  // Bulk read without QVariant conversion if available
+  SqliteStatement query(db);
+  query.exec(queryTxt);
   while(query.next())
   {
     Edge edge;
@@ -331,6 +985,7 @@ void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, boo
         edge.type = EDGE_VICTOR;
       else if(type == 'B')
         edge.type = EDGE_BOTH;
+      edge.updateAttributes();
 
       // Assign towards node ======================================
       // Add one edge for each allowed direction
@@ -360,22 +1015,21 @@ void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, boo
       /* T NAT, PACOTS or AUSOTS track */
       edge.routeType = TRACK;
       edge.type = EDGE_TRACK;
+      edge.updateAttributes();
 
       // Read altitude levels from array ====================
       if(!query.isNull(ALT_LEVELS_EAST))
       {
         edge.hasAltLevels = true;
-        network->altLevelsEast.insert(edge.id,
-                                      atools::io::readVector<quint16, quint16>(
-                                        query.value(ALT_LEVELS_EAST).toByteArray()));
+        trackData->altLevelsEast.insert(edge.id,
+                                        atools::io::readVector<quint16, quint16>(query.valueBytes(ALT_LEVELS_EAST)));
       }
 
       if(!query.isNull(ALT_LEVELS_WEST))
       {
         edge.hasAltLevels = true;
-        network->altLevelsWest.insert(edge.id,
-                                      atools::io::readVector<quint16, quint16>(
-                                        query.value(ALT_LEVELS_WEST).toByteArray()));
+        trackData->altLevelsWest.insert(edge.id,
+                                        atools::io::readVector<quint16, quint16>(query.valueBytes(ALT_LEVELS_WEST)));
       }
 
       // Forward only track is always running from/to
@@ -387,9 +1041,9 @@ void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, boo
   } // while(query.next())
 }
 
-void RouteNetworkLoader::readNodesAirway(QVector<Node>& nodes, QHash<int, int>& nodeIdIndexMap,
-                                         const QString& queryStr, bool vor, bool ndb,
-                                         bool filterUnnamed, bool track)
+void RouteNetworkLoader::readNodesAirway(atools::sql::SqlDatabase *db, QVector<Node>& nodes,
+                                         QHash<int, int>& nodeIdIndexMap, const QString& queryStr, bool vor, bool ndb,
+                                         bool filterUnnamed, bool track) const
 {
   // Column indexes
   // -> Required                          <- ->       if airway             <-  -> Optional
@@ -413,8 +1067,9 @@ void RouteNetworkLoader::readNodesAirway(QVector<Node>& nodes, QHash<int, int>&
     DME_ONLY
   };
 
-  SqlQuery query(queryStr, track ? dbTrack : dbNav);
-  query.exec();
+  // Bulk read without QVariant conversion if available
+  SqliteStatement query(db);
+  query.exec(queryStr);
   while(query.next())
   {
     QString type = query.valueStr(AIRWAY_TYPE);
@@ -475,7 +1130,7 @@ void RouteNetworkLoader::readNodesAirway(QVector<Node>& nodes, QHash<int, int>&
     // Connection flags are populated later by analyzing edges
 
     if(node.type == NODE_NONE)
-      qWarning() << Q_FUNC_INFO << "No node type" << query.record();
+      qWarning() << Q_FUNC_INFO << "No node type" << node.id << query.valueStr(IDENT);
 
     nodes.append(node);
     nodeIdIndexMap.insert(node.id, node.index);
@@ -500,7 +1155,7 @@ void RouteNetworkLoader::readNodesRadio(const QString& queryStr, bool vor)
   while(query.next())
   {
     Node node;
-    node.index = network->nodeIndex.size();
+    node.index = network->data->nodeIndex.size();
     node.id = query.valueInt(ID);
     node.pos.setLonX(query.valueFloat(LONX));
     node.pos.setLatY(query.valueFloat(LATY));
@@ -511,7 +1166,7 @@ void RouteNetworkLoader::readNodesRadio(const QString& queryStr, bool vor)
     else
       node.type = NODE_NDB;
 
-    network->nodeIndex.append(node);
+    network->data->nodeIndex.append(node);
   }
 }
 
@@ -23,11 +23,13 @@
 namespace atools {
 namespace sql {
 class SqlDatabase;
+class SqlConnectionPool;
 }
 
 namespace routing {
 
 class RouteNetwork;
+struct RouteTrackData;
 
 /*
  * Loader for routing network forming a directed graph by navaid nodes and airway/track edges
@@ -43,28 +45,112 @@ public:
   RouteNetworkLoader(atools::sql::SqlDatabase *sqlDbNav, sql::SqlDatabase *sqlDbTrack);
   virtual ~RouteNetworkLoader();
 
-  /* Loads network data from databases into memory in RouteNetwork.
+  /* Loads network data from databases into memory in RouteNetwork. Also loads tracks using loadTracks().
    * Not reentrant. */
   void load(atools::routing::RouteNetwork *networkParam);
 
+  /* Build the track overlay from the track database and swap it into the already loaded network.
+   * Removes tracks from the network if the track database is empty. Does not touch the airway graph and
+   * can be called after each track download. Not reentrant. */
+  void loadTracks(atools::routing::RouteNetwork *networkParam);
+
+  /* Write a binary snapshot of the loaded network next to the navdatabase file and read it on later loads
+   * instead of querying the database. The snapshot is invalidated if the navdatabase load timestamp,
+   * AIRAC cycle or tracks change. Default is false. */
+  void setCacheEnabled(bool value)
+  {
+    cacheEnabled = value;
+  }
+
+  /* Filename of the snapshot. Empty if navdatabase is not file based. */
+  QString getCacheFilename() const;
+
+  /* Read-only connections to the navdatabase file. Airway edges and the node queries are then read
+   * concurrently on separate connections. Loads sequentially on the navdatabase connection if null.
+   * Ownership is not transferred. */
+  void setConnectionPool(atools::sql::SqlConnectionPool *value)
+  {
+    connectionPool = value;
+  }
+
 private:
+  /* Build key which identifies database contents */
+  QString cacheKey() const;
+
+  /* Read snapshot into network. Returns false if file is missing, not readable or outdated. */
+  bool readCache(const QString& filename, const QString& key);
+
+  /* Write snapshot of the loaded network */
+  void writeCache(const QString& filename, const QString& key) const;
+
+  /* Fill RouteNetworkData::reverseEdges and offsets from outgoing edges */
+  void buildReverseEdges();
+
+  /* Read table route_shortcut_airway and fill shortcut edges. Chains are checked against the loaded edges and
+   * dropped if they pass through nodes with other connections. Shortcuts passing track nodes are blocked
+   * by the track overlay. Needs reverse edges. */
+  void readShortcuts();
+
+  /* Collect edge indexes of chain described by a route_shortcut_airway row. Returns false if chain is not valid. */
+  bool shortcutChain(QVector<int>& edgeIndexes, int fromIndex, int viaIndex, int toIndex, int numSegments) const;
+
+  /* Modifiable range of outgoing edges for node at index */
+  struct MutableEdgeRange
+  {
+    MutableEdgeRange()
+    {
+    }
+
+    MutableEdgeRange(Edge *firstParam, Edge *lastParam)
+      : first(firstParam), last(lastParam)
+    {
+    }
+
+    Edge *begin() const
+    {
+      return first;
+    }
+
+    Edge *end() const
+    {
+      return last;
+    }
+
+    Edge *first = nullptr, *last = nullptr;
+  };
+
+  MutableEdgeRange nodeEdges(int index);
+
   /* Read VOR and NDB into index */
   void readNodesRadio(const QString& queryStr, bool vor);
 
-  /* Read waypoints and airways into index */
-  void readNodesAirway(QVector<Node>& nodes, QHash<int, int>& nodeIdIndexMap, const QString& queryStr,
-                       bool vor, bool ndb,
-                       bool filterUnnamed, bool track);
+  /* Read all airway edges and nodes from the navdatabase using the connection pool if available.
+   * Edge::toIndex contains the database id of the node. */
+  void readAirwayNetwork(QMultiHash<int, Edge>& nodeEdgeMap, QVector<Node>& nodeVector,
+                         QHash<int, int>& nodeIdIndexMap) const;
 
-  /* Read edges from tables airway or track.
+  /* Read waypoints and airways into index. Thread safe if each call uses its own connection db. */
+  void readNodesAirway(atools::sql::SqlDatabase *db, QVector<Node>& nodes, QHash<int, int>& nodeIdIndexMap,
+                       const QString& queryStr, bool vor, bool ndb, bool filterUnnamed, bool track) const;
+
+  /* Read edges from table airway or from table track if trackData is not null.
+   * Altitude levels of tracks are added to trackData.
    * nodeEdgeMap receiives a list of node ids mapped to a list of edges. */
-  void readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, bool track) const;
+  void readEdgesAirway(atools::sql::SqlDatabase *db, QMultiHash<int, Edge>& nodeEdgeMap,
+                       atools::routing::RouteTrackData *trackData) const;
 
-  /* Reads metadata and adds CONNECTION_TRACK_START_END flag to nodes if they are a start or end of a track. */
-  void readTrackStartEndPoints() const;
+  /* Reads metadata and adds CONNECTION_TRACK_START_END flag to overlay connections of nodes if they are a
+   * start or end of a track. */
+  void readTrackStartEndPoints(const QHash<int, int>& nodeIdIndexMap,
+                               atools::routing::RouteTrackData *trackData) const;
 
   atools::routing::RouteNetwork *network = nullptr;
   atools::sql::SqlDatabase *dbNav = nullptr, *dbTrack = nullptr;
+  atools::sql::SqlConnectionPool *connectionPool = nullptr;
+  bool cacheEnabled = false;
+
+  const static quint32 CACHE_MAGIC_NUMBER = 0x4E5A7B12;
+  const static quint16 CACHE_VERSION = 2;
 };
 
 } // namespace routing
@@ -31,7 +31,6 @@ QDebug operator<<(QDebug out, const Node& obj)
                           << ", type " << nodeTypeToStr(obj.type)
                           << ", subtype " << nodeTypeToStr(obj.subtype)
                           << ", connections " << nodeConnectionsToStr(obj.con)
-                          << ", num edges " << obj.edges.size()
                           << ")";
   return out;
 
@@ -49,6 +48,67 @@ QDebug operator<<(QDebug out, const Edge& obj)
   return out;
 }
 
+void Edge::updateAttributes()
+{
+  switch(type)
+  {
+    case atools::routing::EDGE_NONE:
+      attributes = EDGE_ATTR_DIRECT;
+      break;
+
+    case atools::routing::EDGE_VICTOR:
+      attributes = EDGE_ATTR_VICTOR;
+      break;
+
+    case atools::routing::EDGE_JET:
+      attributes = EDGE_ATTR_JET;
+      break;
+
+    case atools::routing::EDGE_BOTH:
+      attributes = EDGE_ATTR_VICTOR | EDGE_ATTR_JET;
+      break;
+
+    case atools::routing::EDGE_TRACK:
+      attributes = EDGE_ATTR_TRACK;
+      break;
+  }
+
+  if(routeType == RNAV)
+    attributes |= EDGE_ATTR_RNAV;
+}
+
+void Node::updateAttributes()
+{
+  switch(type)
+  {
+    case atools::routing::NODE_VOR:
+    case atools::routing::NODE_VORDME:
+    case atools::routing::NODE_DME:
+      attributes = NODE_ATTR_VOR;
+      break;
+
+    case atools::routing::NODE_NDB:
+      attributes = NODE_ATTR_NDB;
+      break;
+
+    case atools::routing::NODE_WAYPOINT:
+      attributes = NODE_ATTR_WAYPOINT;
+      if(con & CONNECTION_VICTOR)
+        attributes |= NODE_ATTR_VICTOR;
+      if(con & CONNECTION_JET)
+        attributes |= NODE_ATTR_JET;
+      if(con & CONNECTION_TRACK)
+        attributes |= NODE_ATTR_TRACK;
+      break;
+
+    case atools::routing::NODE_NONE:
+    case atools::routing::NODE_DEPARTURE:
+    case atools::routing::NODE_DESTINATION:
+      attributes = NODE_ATTR_NONE;
+      break;
+  }
+}
+
 QString nodeTypeToStr(atools::routing::NodeType type)
 {
   if(type == atools::routing::NODE_NONE)
@@ -120,6 +120,36 @@ enum RouteType : unsigned char
   TRACK = 'T' /* NAT, PACTOTS or AUSOTS track. Not a real ARINC route type. */
 };
 
+/* Precalculated edge properties used for filtering by mode with a single lookup in a table.
+ * See RouteNetwork::matchEdge(). */
+enum EdgeAttribute : unsigned char
+{
+  EDGE_ATTR_NONE = 0,
+  EDGE_ATTR_VICTOR = 1 << 0, /* Victor airway or both */
+  EDGE_ATTR_JET = 1 << 1, /* Jet airway or both */
+  EDGE_ATTR_TRACK = 1 << 2,
+  EDGE_ATTR_DIRECT = 1 << 3, /* No airway and no track - usually a generated edge */
+  EDGE_ATTR_RNAV = 1 << 4, /* RNAV route type */
+
+  /* Number of attribute combinations */
+  EDGE_ATTR_COMBINATIONS = 1 << 5
+};
+
+/* Same as above for node properties. Zero for departure, destination and nodes without type.
+ * Airway and track flags are only set for waypoints. See RouteNetwork::matchNode(). */
+enum NodeAttribute : unsigned char
+{
+  NODE_ATTR_NONE = 0,
+  NODE_ATTR_VOR = 1 << 0, /* VOR, VORDME or DME */
+  NODE_ATTR_NDB = 1 << 1,
+  NODE_ATTR_WAYPOINT = 1 << 2,
+  NODE_ATTR_VICTOR = 1 << 3, /* Waypoint having victor airways */
+  NODE_ATTR_JET = 1 << 4, /* Waypoint having jet airways */
+  NODE_ATTR_TRACK = 1 << 5, /* Waypoint having tracks */
+
+  NODE_ATTR_COMBINATIONS = 1 << 6
+};
+
 /* Network edge that connects two nodes. Is loaded from the database or
  * generated based on a nearesr neighbor query.
  * Edges form a directed graph. Nodes connected by an airway without one-way restriction
@@ -133,17 +163,20 @@ struct Edge
   Edge()
     : toIndex(-1), lengthMeter(0), id(-1), airwayHash(0),
     minAltFt(MIN_ALTITUDE), maxAltFt(MAX_ALTITUDE), type(atools::routing::EDGE_NONE), routeType(NO_ROUTE_TYPE),
-    hasAltLevels(false)
+    hasAltLevels(false), shortcut(false), attributes(EDGE_ATTR_DIRECT)
   {
   }
 
   Edge(int to, float distance)
     : toIndex(to), lengthMeter(static_cast<int>(distance)), id(-1), airwayHash(0),
     minAltFt(MIN_ALTITUDE), maxAltFt(MAX_ALTITUDE), type(atools::routing::EDGE_NONE), routeType(NO_ROUTE_TYPE),
-    hasAltLevels(false)
+    hasAltLevels(false), shortcut(false), attributes(EDGE_ATTR_DIRECT)
   {
   }
 
+  /* Calculate attributes from type and route type. Call after changing these. */
+  void updateAttributes();
+
   bool isVictorAirway() const
   {
     return type == EDGE_VICTOR || type == EDGE_BOTH;
@@ -179,16 +212,61 @@ struct Edge
   RouteType routeType; /* Route according to ARINC 5.7 */
   bool hasAltLevels;
 
+  /* Edge replaces a chain of airway edges. Edge::id is the index of the shortcut in the network and
+   * the replaced edges can be fetched with RouteNetwork::getShortcutEdges() */
+  bool shortcut;
+
+  /* EdgeAttribute flags */
+  quint8 attributes;
+
   friend QDebug operator<<(QDebug out, const atools::routing::Edge& obj);
 
 };
 
+/* Range of edges from the contiguous edge array of a network. Used to iterate over edges attached to a node
+ * without copying. Valid as long as the network is not reloaded. */
+struct EdgeRange
+{
+  EdgeRange()
+  {
+  }
+
+  EdgeRange(const Edge *firstParam, const Edge *lastParam)
+    : first(firstParam), last(lastParam)
+  {
+  }
+
+  const Edge *begin() const
+  {
+    return first;
+  }
+
+  const Edge *end() const
+  {
+    return last;
+  }
+
+  int size() const
+  {
+    return static_cast<int>(last - first);
+  }
+
+  bool isEmpty() const
+  {
+    return first == last;
+  }
+
+private:
+  const Edge *first = nullptr, *last = nullptr;
+};
+
 /* Network node. VOR, NDB, waypoint or user defined departure/destination */
 struct Node
 {
   Node()
     : index(INVALID_INDEX), id(-1), range(0),
-    type(atools::routing::NODE_NONE), subtype(atools::routing::NODE_NONE), con(CONNECTION_NONE)
+    type(atools::routing::NODE_NONE), subtype(atools::routing::NODE_NONE), con(CONNECTION_NONE),
+    attributes(NODE_ATTR_NONE)
   {
   }
 
@@ -200,9 +278,9 @@ struct Node
   atools::routing::NodeType type /* VOR, NDB, ..., WAYPOINT_VICTOR, ... */,
                             subtype /* VOR, VORDME, NDB, ... for airway network if type is one of WAYPOINT_* */;
   atools::routing::NodeConnection con; /* Flags indicating all connected airways and tracks */
+  quint8 attributes; /* NodeAttribute flags calculated from type and connections */
 
-  QVector<Edge> edges; /* Attached outgoing edges on airway only.
-                        * Do not use this since edges are already filtered by the RouteNetwork. */
+  /* Attached outgoing and incoming edges are stored in RouteNetworkData in compressed sparse row format */
 
   /* Default unitialized */
   constexpr static int INVALID_INDEX = -1;
@@ -274,8 +352,12 @@ struct Node
   void setConnections(atools::routing::NodeConnections connections)
   {
     con = static_cast<NodeConnection>(connections.operator unsigned int());
+    updateAttributes();
   }
 
+  /* Calculate attributes from type and connections. Called by setConnections(). */
+  void updateAttributes();
+
   /* Add flag to connections */
   void addConnection(atools::routing::NodeConnections connections)
   {
@@ -302,16 +384,36 @@ struct Result
   QVector<int> nodes;
   QVector<Edge> edges;
 
+  /* Index of each edge in the network storage as returned by RouteNetworkData::edgeIndex() or -1 for
+   * generated edges. Used to look up precalculated values in arrays aligned with the edge storage. */
+  QVector<int> edgeIndexes;
+
+  void append(int node, const Edge& edge, int edgeIndex = -1)
+  {
+    nodes.append(node);
+    edges.append(edge);
+    edgeIndexes.append(edgeIndex);
+  }
+
+  void removeAt(int index)
+  {
+    nodes.removeAt(index);
+    edges.removeAt(index);
+    edgeIndexes.removeAt(index);
+  }
+
   void clear()
   {
     nodes.clear();
     edges.clear();
+    edgeIndexes.clear();
   }
 
   void reserve(int size)
   {
     nodes.reserve(size);
     edges.reserve(size);
+    edgeIndexes.reserve(size);
   }
 
   int size() const
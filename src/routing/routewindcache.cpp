@@ -0,0 +1,204 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "routing/routewindcache.h"
+
+#include "routing/routenetwork.h"
+#include "grib/windquery.h"
+#include "atools.h"
+#include "geo/calculations.h"
+#include "util/parallel.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <cmath>
+
+using atools::geo::Point3D;
+using atools::geo::Pos;
+using atools::grib::Wind;
+
+namespace atools {
+namespace routing {
+
+namespace {
+
+/* Positions per call of WindQuery::getWindForPosBatch() */
+const int NODE_CHUNK_SIZE = 4096;
+
+/* Average head wind along the great circle line using the course at the middle of the line */
+float lineHeadWind(const atools::grib::WindQuery& windQuery, const Pos& from, const Pos& to)
+{
+  Wind wind = windQuery.getWindAverageForLine(from, to);
+  if(!wind.isValid())
+    return 0.f;
+
+  Pos mid = from.interpolate(to, 0.5f);
+  return atools::geo::headWindForCourse(wind.speed, wind.dir, mid.angleDegTo(to));
+}
+
+/* Convert wind at position into a vector in 3D space pointing in the direction of movement */
+Point3D windToVector(const Pos& pos, const Wind& wind)
+{
+  if(!wind.isValid() || !pos.isValid())
+    return Point3D();
+
+  float lonRad = atools::geo::toRadians(pos.getLonX()), latRad = atools::geo::toRadians(pos.getLatY());
+  float sinLon = std::sin(lonRad), cosLon = std::cos(lonRad), sinLat = std::sin(latRad), cosLat = std::cos(latRad);
+
+  // Direction is where the wind comes from
+  float dirRad = atools::geo::toRadians(wind.dir);
+  float east = -wind.speed * std::sin(dirRad), north = -wind.speed * std::cos(dirRad);
+
+  // Local east is (-sinLon, cosLon, 0) and north is (-sinLat * cosLon, -sinLat * sinLon, cosLat)
+  return Point3D(-east * sinLon - north * sinLat * cosLon, east * cosLon - north * sinLat * sinLon, north * cosLat);
+}
+
+float vectorLength(const Point3D& vector)
+{
+  return std::sqrt(vector.getX() * vector.getX() + vector.getY() * vector.getY() + vector.getZ() * vector.getZ());
+}
+
+} // namespace
+
+RouteWindCache::RouteWindCache()
+{
+
+}
+
+RouteWindCache::~RouteWindCache()
+{
+
+}
+
+void RouteWindCache::build(const RouteNetwork& network, const atools::grib::WindQuery& windQuery, float altitudeFt)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+  data = network.data;
+  analysisTime = windQuery.getAnalyisTime();
+  altitude = altitudeFt;
+
+  const RouteNetworkData *graph = data.data();
+  const QVector<Node>& nodes = graph->nodeIndex;
+
+  // Wind vectors for all nodes in chunks ====================================
+  nodeWinds.resize(nodes.size());
+  Point3D *nodeWindsPtr = nodeWinds.data();
+  int numChunks = (nodes.size() + NODE_CHUNK_SIZE - 1) / NODE_CHUNK_SIZE;
+  atools::util::parallelFor(numChunks, [&windQuery, &nodes, nodeWindsPtr, altitudeFt](int chunk) {
+    int from = chunk * NODE_CHUNK_SIZE, to = std::min(nodes.size(), from + NODE_CHUNK_SIZE);
+    QVector<Pos> positions;
+    positions.reserve(to - from);
+    for(int i = from; i < to; i++)
+      positions.append(nodes.at(i).pos.alt(altitudeFt));
+
+    QVector<Wind> winds;
+    windQuery.getWindForPosBatch(winds, positions);
+    for(int i = from; i < to; i++)
+      nodeWindsPtr[i] = windToVector(positions.at(i - from), winds.at(i - from));
+  });
+
+  // Head wind for edges aligned with the edge storage ====================================
+  headWinds.fill(0.f, graph->numEdgeIndexes());
+  float *headWindsPtr = headWinds.data();
+  int reverseOffset = graph->edges.size();
+  int shortcutOffset = reverseOffset + graph->reverseEdges.size();
+  int reverseShortcutOffset = shortcutOffset + graph->shortcuts.size();
+
+  auto lineWind = [&windQuery, &nodes, altitudeFt](int fromIndex, int toIndex) -> float {
+                    return lineHeadWind(windQuery, nodes.at(fromIndex).pos.alt(altitudeFt),
+                                        nodes.at(toIndex).pos.alt(altitudeFt));
+                  };
+
+  // Outgoing and incoming edges by node - incoming edges point to the start node
+  atools::util::parallelFor(nodes.size(), [graph, headWindsPtr, reverseOffset, &lineWind](int nodeIndex) {
+    if(nodeIndex + 1 < graph->edgeOffsets.size())
+    {
+      for(int i = graph->edgeOffsets.at(nodeIndex); i < graph->edgeOffsets.at(nodeIndex + 1); i++)
+        headWindsPtr[i] = lineWind(nodeIndex, graph->edges.at(i).toIndex);
+    }
+
+    if(nodeIndex + 1 < graph->reverseEdgeOffsets.size())
+    {
+      for(int i = graph->reverseEdgeOffsets.at(nodeIndex); i < graph->reverseEdgeOffsets.at(nodeIndex + 1); i++)
+        headWindsPtr[reverseOffset + i] = lineWind(graph->reverseEdges.at(i).toIndex, nodeIndex);
+    }
+  }, 64);
+
+  // Shortcuts as length weighted average of the replaced edges - start node is taken from the reverse shortcut
+  atools::util::parallelFor(graph->shortcuts.size(), [graph, headWindsPtr, shortcutOffset, reverseShortcutOffset,
+                                                       &lineWind](int shortcut) {
+    float sum = 0.f, length = 0.f;
+    int fromIndex = graph->reverseShortcuts.at(shortcut).toIndex;
+    for(int i = graph->shortcutEdgeOffsets.at(shortcut); i < graph->shortcutEdgeOffsets.at(shortcut + 1); i++)
+    {
+      const Edge& edge = graph->shortcutEdges.at(i);
+      sum += lineWind(fromIndex, edge.toIndex) * edge.lengthMeter;
+      length += edge.lengthMeter;
+      fromIndex = edge.toIndex;
+    }
+
+    // Reverse shortcut covers the same chain in the same direction
+    headWindsPtr[shortcutOffset + shortcut] = headWindsPtr[reverseShortcutOffset + shortcut] =
+      length > 0.f ? sum / length : 0.f;
+  }, 16);
+
+  for(const Point3D& wind : nodeWinds)
+    maxWindSpeed = std::max(maxWindSpeed, vectorLength(wind));
+  for(float headWind : headWinds)
+    maxWindSpeed = std::max(maxWindSpeed, std::abs(headWind));
+
+  qDebug() << Q_FUNC_INFO << "altitude" << altitudeFt << "nodes" << nodeWinds.size() << "edges" << headWinds.size()
+           << "max wind" << maxWindSpeed << "kts" << timer.elapsed() << "ms";
+}
+
+void RouteWindCache::clear()
+{
+  headWinds.clear();
+  nodeWinds.clear();
+  data.reset();
+  analysisTime = QDateTime();
+  altitude = maxWindSpeed = 0.f;
+}
+
+bool RouteWindCache::isValid(const RouteNetwork& network, const atools::grib::WindQuery& windQuery,
+                             float altitudeFt) const
+{
+  return !data.isNull() && data == network.data && analysisTime == windQuery.getAnalyisTime() &&
+         atools::almostEqual(altitude, altitudeFt);
+}
+
+float RouteWindCache::getHeadWind(const Point3D& from, const Point3D& to, const Point3D& fromWind,
+                                  const Point3D& toWind)
+{
+  float dx = to.getX() - from.getX(), dy = to.getY() - from.getY(), dz = to.getZ() - from.getZ();
+  float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+  if(length < 1.f)
+    return 0.f;
+
+  // Wind moving along the chord is tail wind
+  float along = (fromWind.getX() + toWind.getX()) * dx + (fromWind.getY() + toWind.getY()) * dy +
+                (fromWind.getZ() + toWind.getZ()) * dz;
+  return -along / (2.f * length);
+}
+
+} // namespace routing
+} // namespace atools
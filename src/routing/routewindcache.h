@@ -0,0 +1,117 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_ROUTEWINDCACHE_H
+#define ATOOLS_ROUTEWINDCACHE_H
+
+#include "geo/point3d.h"
+
+#include <QDateTime>
+#include <QSharedPointer>
+#include <QVector>
+
+namespace atools {
+namespace grib {
+class WindQuery;
+}
+namespace routing {
+
+class RouteNetwork;
+struct RouteNetworkData;
+
+/*
+ * Precalculated winds at one altitude for all edges and nodes of a route network.
+ * Used by RouteFinder to calculate costs based on flying time without wind interpolation in the search loop.
+ *
+ * Head wind components are stored in an array aligned with the edge storage as given by
+ * RouteNetworkData::edgeIndex(). Values are averages along the great circle line of each edge and
+ * length weighted averages over the replaced edges for shortcuts.
+ * Wind vectors for all nodes are used for edges generated by nearest neighbor search.
+ *
+ * Has to be built again after the network is reloaded, the wind data is updated or for another altitude.
+ * Read-only after build() and can be shared between route finders running in parallel.
+ */
+class RouteWindCache
+{
+public:
+  RouteWindCache();
+  ~RouteWindCache();
+
+  RouteWindCache(const RouteWindCache& other) = delete;
+  RouteWindCache& operator=(const RouteWindCache& other) = delete;
+
+  /* Calculate winds for all edges and nodes of the network at the given altitude in feet.
+   * Uses the shared task scheduler. Must not be called while route finders use this cache. */
+  void build(const atools::routing::RouteNetwork& network, const atools::grib::WindQuery& windQuery, float altitudeFt);
+
+  void clear();
+
+  /* true if built for the loaded graph of the network and the current wind data at the given altitude */
+  bool isValid(const atools::routing::RouteNetwork& network, const atools::grib::WindQuery& windQuery,
+               float altitudeFt) const;
+
+  bool isEmpty() const
+  {
+    return data.isNull();
+  }
+
+  /* Head wind component in knots for a stored edge. Negative for tail wind. */
+  float getHeadWind(int edgeIndex) const
+  {
+    return headWinds.constData()[edgeIndex];
+  }
+
+  /* Wind vector in knots in 3D space for a node by index. Null vector for invalid indexes. */
+  atools::geo::Point3D getWindVector(int nodeIndex) const
+  {
+    return nodeIndex >= 0 && nodeIndex < nodeWinds.size() ? nodeWinds.at(nodeIndex) : atools::geo::Point3D();
+  }
+
+  /* Head wind component in knots for a direct connection between two points in 3D space having the
+   * given wind vectors. Uses the average of both vectors along the chord between the points. */
+  static float getHeadWind(const atools::geo::Point3D& from, const atools::geo::Point3D& to,
+                           const atools::geo::Point3D& fromWind, const atools::geo::Point3D& toWind);
+
+  /* Highest wind speed in knots found at nodes and edges */
+  float getMaxWindSpeed() const
+  {
+    return maxWindSpeed;
+  }
+
+  float getAltitude() const
+  {
+    return altitude;
+  }
+
+private:
+  /* Head wind for edges aligned with the edge storage */
+  QVector<float> headWinds;
+
+  /* Wind vectors for nodes with the same index */
+  QVector<atools::geo::Point3D> nodeWinds;
+
+  /* Graph used to build the cache. Keeps it alive and is used for validity check. */
+  QSharedPointer<atools::routing::RouteNetworkData> data;
+  QDateTime analysisTime;
+  float altitude = 0.f, maxWindSpeed = 0.f;
+};
+
+} // namespace routing
+} // namespace atools
+
+#endif // ATOOLS_ROUTEWINDCACHE_H
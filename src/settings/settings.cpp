@@ -30,6 +30,7 @@ namespace settings {
 
 Settings *Settings::settingsInstance = nullptr;
 QString Settings::overrideOrganisation;
+quint32 Settings::changeCounter = 0;
 
 Settings::Settings()
 {
@@ -161,6 +162,7 @@ QVariant Settings::getAndStoreValue(const QString& key, const QVariant& defaultV
 
 void Settings::syncSettings()
 {
+  changeCounter++;
   QSettings *qs = instance().getQSettings();
   qs->sync();
 
@@ -171,6 +173,7 @@ void Settings::syncSettings()
 
 void Settings::clearSettings()
 {
+  changeCounter++;
   QSettings *qs = instance().getQSettings();
   qs->clear();
 
@@ -187,6 +190,7 @@ bool Settings::contains(const QString& key) const
 
 void Settings::remove(const QString& key)
 {
+  changeCounter++;
   qSettings->remove(key);
 }
 
@@ -235,6 +239,7 @@ QVariant Settings::valueVar(const QString& key, QVariant defaultValue) const
 
 void Settings::setValue(const QString& key, const QStringList& value)
 {
+  changeCounter++;
   if(value.isEmpty())
     qSettings->setValue(key, QString());
   else
@@ -243,31 +248,37 @@ void Settings::setValue(const QString& key, const QStringList& value)
 
 void Settings::setValue(const QString& key, const QString& value)
 {
+  changeCounter++;
   qSettings->setValue(key, value);
 }
 
 void Settings::setValue(const QString& key, bool value)
 {
+  changeCounter++;
   qSettings->setValue(key, value);
 }
 
 void Settings::setValue(const QString& key, int value)
 {
+  changeCounter++;
   qSettings->setValue(key, QString::number(value));
 }
 
 void Settings::setValue(const QString& key, float value)
 {
+  changeCounter++;
   qSettings->setValue(key, QString::number(value, 'f', 10));
 }
 
 void Settings::setValue(const QString& key, double value)
 {
+  changeCounter++;
   qSettings->setValue(key, QString::number(value, 'f', 18));
 }
 
 void Settings::setValueVar(const QString& key, const QVariant& value)
 {
+  changeCounter++;
   qSettings->setValue(key, value);
 }
 
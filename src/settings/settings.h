@@ -45,6 +45,12 @@ public:
   /* Flush settings and release all resources */
   static void shutdown();
 
+  /* true if instance() was called and shutdown() not yet */
+  static bool isInitialized()
+  {
+    return settingsInstance != nullptr;
+  }
+
   /* Clear all values and shutdown */
   static void clearAndShutdown();
 
@@ -127,6 +133,14 @@ public:
 
   QStringList childGroups() const;
 
+  /* Incremented by all setValue(), remove(), syncSettings() and clearSettings() calls.
+   * Allows SettingsSnapshot to detect changes without reading values. Changes done directly on the QSettings
+   * object are not counted. */
+  static quint32 getChangeCounter()
+  {
+    return changeCounter;
+  }
+
 private:
   Settings();
   ~Settings();
@@ -134,6 +148,7 @@ private:
   QSettings *qSettings;
 
   static QString overrideOrganisation;
+  static quint32 changeCounter;
 
   static Settings *settingsInstance;
   static QString appNameForFiles();
@@ -0,0 +1,251 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SETTINGS_SETTINGSSNAPSHOT_H
+#define ATOOLS_SETTINGS_SETTINGSSNAPSHOT_H
+
+#include "settings/settings.h"
+
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+namespace atools {
+namespace settings {
+
+/*
+ * Typed copy of settings values for code which reads options in loops or other hot paths.
+ *
+ * Members of the struct OPTIONS are bound to settings keys once. reload() reads all keys into the struct and
+ * the values can then be accessed without key lookup or QVariant conversion.
+ * update() is cheap and reloads only if Settings::getChangeCounter() shows that settings were written since.
+ * Listeners are called with the new values if any member changed.
+ *
+ * Only usable in the thread using Settings which is usually the main thread. Copy the OPTIONS struct to pass
+ * values to other threads.
+ *
+ * struct MapOptions
+ * {
+ *   bool showGrid;
+ *   int maxLabels;
+ * };
+ *
+ * SettingsSnapshot<MapOptions> snapshot;
+ * snapshot.bind("Map/ShowGrid", &MapOptions::showGrid, true);
+ * snapshot.bind("Map/MaxLabels", &MapOptions::maxLabels, 100);
+ * snapshot.reload();
+ *
+ * if(snapshot.get().showGrid) ...
+ */
+template<typename OPTIONS>
+class SettingsSnapshot
+{
+public:
+  typedef std::function<void (const OPTIONS& options)> ListenerFuncType;
+
+  SettingsSnapshot()
+  {
+  }
+
+  explicit SettingsSnapshot(const OPTIONS& defaultOptions)
+    : options(defaultOptions)
+  {
+  }
+
+  SettingsSnapshot(const SettingsSnapshot& other) = delete;
+  SettingsSnapshot& operator=(const SettingsSnapshot& other) = delete;
+
+  /* Bind a struct member to a settings key. Sets the member to the default value until reload() is called. */
+  void bind(const QString& key, bool OPTIONS::*member, bool defaultValue)
+  {
+    bindValue(key, member, defaultValue, [](const Settings& s, const QString& k, bool d) -> bool {
+                return s.valueBool(k, d);
+              });
+  }
+
+  void bind(const QString& key, int OPTIONS::*member, int defaultValue)
+  {
+    bindValue(key, member, defaultValue, [](const Settings& s, const QString& k, int d) -> int {
+                return s.valueInt(k, d);
+              });
+  }
+
+  void bind(const QString& key, float OPTIONS::*member, float defaultValue)
+  {
+    bindValue(key, member, defaultValue, [](const Settings& s, const QString& k, float d) -> float {
+                return s.valueFloat(k, d);
+              });
+  }
+
+  void bind(const QString& key, double OPTIONS::*member, double defaultValue)
+  {
+    bindValue(key, member, defaultValue, [](const Settings& s, const QString& k, double d) -> double {
+                return s.valueDouble(k, d);
+              });
+  }
+
+  void bind(const QString& key, QString OPTIONS::*member, const QString& defaultValue = QString())
+  {
+    bindValue(key, member, defaultValue, [](const Settings& s, const QString& k, const QString& d) -> QString {
+                return s.valueStr(k, d);
+              });
+  }
+
+  void bind(const QString& key, QStringList OPTIONS::*member, const QStringList& defaultValue = QStringList())
+  {
+    bindValue(key, member, defaultValue,
+              [](const Settings& s, const QString& k, const QStringList& d) -> QStringList {
+                return s.valueStrList(k, d);
+              });
+  }
+
+  /* Read all bound keys from settings and notify listeners if anything changed. Returns true if changed. */
+  bool reload();
+
+  /* Reload only if settings were changed since the last call. Returns true if values changed. */
+  bool update()
+  {
+    if(changeCounter != Settings::getChangeCounter() || !loaded)
+      return reload();
+    else
+      return false;
+  }
+
+  /* Values as read by the last reload() */
+  const OPTIONS& get() const
+  {
+    return options;
+  }
+
+  /* Replace values, write them to settings and notify listeners if anything changed */
+  void set(const OPTIONS& value);
+
+  /* Write all bound values to settings */
+  void save() const;
+
+  /* Called after reload() or set() with the new values if a value changed */
+  void addListener(const ListenerFuncType& func)
+  {
+    listeners.append(func);
+  }
+
+private:
+  struct Binding
+  {
+    /* Read value into options and return true if it differs */
+    std::function<bool (const Settings& settings, OPTIONS& options)> read;
+
+    /* Write value from options */
+    std::function<void (Settings& settings, const OPTIONS& options)> write;
+
+    /* Compare value in both options */
+    std::function<bool (const OPTIONS& options1, const OPTIONS& options2)> equal;
+  };
+
+  template<typename TYPE, typename READFUNC>
+  void bindValue(const QString& key, TYPE OPTIONS::*member, const TYPE& defaultValue, READFUNC readFunc);
+
+  void notify()
+  {
+    for(const ListenerFuncType& func : listeners)
+      func(options);
+  }
+
+  OPTIONS options;
+  QVector<Binding> bindings;
+  QVector<ListenerFuncType> listeners;
+  quint32 changeCounter = 0;
+  bool loaded = false;
+};
+
+template<typename OPTIONS>
+template<typename TYPE, typename READFUNC>
+void SettingsSnapshot<OPTIONS>::bindValue(const QString& key, TYPE OPTIONS::*member, const TYPE& defaultValue,
+                                          READFUNC readFunc)
+{
+  options.*member = defaultValue;
+
+  Binding binding;
+  binding.read = [key, member, defaultValue, readFunc](const Settings& settings, OPTIONS& opts) -> bool {
+                   TYPE value = readFunc(settings, key, defaultValue);
+                   bool changed = !(opts.*member == value);
+                   opts.*member = value;
+                   return changed;
+                 };
+  binding.write = [key, member](Settings& settings, const OPTIONS& opts) -> void {
+                    settings.setValue(key, opts.*member);
+                  };
+  binding.equal = [member](const OPTIONS& opts1, const OPTIONS& opts2) -> bool {
+                    return opts1.*member == opts2.*member;
+                  };
+  bindings.append(binding);
+}
+
+template<typename OPTIONS>
+bool SettingsSnapshot<OPTIONS>::reload()
+{
+  const Settings& settings = Settings::instance();
+  bool changed = false;
+  for(const Binding& binding : bindings)
+    changed |= binding.read(settings, options);
+
+  changeCounter = Settings::getChangeCounter();
+  loaded = true;
+
+  if(changed)
+    notify();
+  return changed;
+}
+
+template<typename OPTIONS>
+void SettingsSnapshot<OPTIONS>::set(const OPTIONS& value)
+{
+  bool changed = false;
+  for(const Binding& binding : bindings)
+  {
+    if(!binding.equal(options, value))
+    {
+      changed = true;
+      break;
+    }
+  }
+
+  options = value;
+  save();
+
+  // Own writes do not need a reload
+  changeCounter = Settings::getChangeCounter();
+  loaded = true;
+
+  if(changed)
+    notify();
+}
+
+template<typename OPTIONS>
+void SettingsSnapshot<OPTIONS>::save() const
+{
+  Settings& settings = Settings::instance();
+  for(const Binding& binding : bindings)
+    binding.write(settings, options);
+}
+
+} // namespace settings
+} // namespace atools
+
+#endif // ATOOLS_SETTINGS_SETTINGSSNAPSHOT_H
@@ -0,0 +1,51 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "sql/sqlcolumnindex.h"
+
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "sql/sqlexception.h"
+
+namespace atools {
+namespace sql {
+
+SqlColumnIndex::SqlColumnIndex(const QStringList& columnNames)
+  : names(columnNames), indexes(columnNames.size(), -1)
+{
+}
+
+void SqlColumnIndex::resolve(const SqlQuery& query)
+{
+  resolve(query.record(true /* allow invalid query */));
+  queryString = query.getQueryString();
+}
+
+void SqlColumnIndex::resolve(const SqlRecord& record)
+{
+  for(int i = 0; i < names.size(); i++)
+    indexes[i] = record.contains(names.at(i)) ? record.indexOf(names.at(i)) : -1;
+}
+
+void SqlColumnIndex::throwNotFound(int id) const
+{
+  throw SqlException("SqlColumnIndex: Column name \"" + names.at(id) + "\" does not exist" +
+                     (queryString.isEmpty() ? QString() : " in query \"" + queryString + "\""));
+}
+
+} // namespace sql
+} // namespace atools
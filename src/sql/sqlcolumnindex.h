@@ -0,0 +1,162 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SQL_SQLCOLUMNINDEX_H
+#define ATOOLS_SQL_SQLCOLUMNINDEX_H
+
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+
+class SqlQuery;
+class SqlRecord;
+
+/*
+ * Resolves column names of a query or record to field indexes once and provides typed getters by column id.
+ * Avoids the name lookup of SqlQuery::value(const QString&) for each row when reading large tables.
+ *
+ * Column ids are the positions in the name list given to the constructor. Usually these are values of an enum.
+ *
+ * Example:
+ * enum {IDENT, LONX, LATY};
+ * SqlColumnIndex cols({"ident", "lonx", "laty"});
+ * query.exec();
+ * cols.resolve(query);
+ * while(query.next())
+ *   Pos pos(cols.valueFloat(query, LONX), cols.valueFloat(query, LATY));
+ *
+ * Getters work for SqlQuery and SqlRecord and throw SqlException if the column does not exist.
+ */
+class SqlColumnIndex
+{
+public:
+  SqlColumnIndex()
+  {
+  }
+
+  explicit SqlColumnIndex(const QStringList& columnNames);
+
+  /* Resolve all names for an executed query. Needs to be done only once for a prepared query.
+   * Columns not found get an invalid index which causes an exception when accessed. */
+  void resolve(const atools::sql::SqlQuery& query);
+
+  /* Resolve all names for records. All records used with this object must have the same layout. */
+  void resolve(const atools::sql::SqlRecord& record);
+
+  /* true if column was found in query or record */
+  bool hasColumn(int id) const
+  {
+    return indexes.at(id) != -1;
+  }
+
+  /* Get field index for column id. Throws SqlException if column was not found. */
+  int index(int id) const
+  {
+    int idx = indexes.at(id);
+    if(idx == -1)
+      throwNotFound(id);
+    return idx;
+  }
+
+  const QString& name(int id) const
+  {
+    return names.at(id);
+  }
+
+  /* Typed getters for SqlQuery or SqlRecord. Throw exception if column does not exist. */
+  template<typename ROW>
+  QVariant value(const ROW& row, int id) const
+  {
+    return row.value(index(id));
+  }
+
+  template<typename ROW>
+  QString valueStr(const ROW& row, int id) const
+  {
+    return row.valueStr(index(id));
+  }
+
+  template<typename ROW>
+  int valueInt(const ROW& row, int id) const
+  {
+    return row.valueInt(index(id));
+  }
+
+  template<typename ROW>
+  float valueFloat(const ROW& row, int id) const
+  {
+    return row.valueFloat(index(id));
+  }
+
+  template<typename ROW>
+  double valueDouble(const ROW& row, int id) const
+  {
+    return row.valueDouble(index(id));
+  }
+
+  template<typename ROW>
+  bool valueBool(const ROW& row, int id) const
+  {
+    return row.valueBool(index(id));
+  }
+
+  template<typename ROW>
+  bool isNull(const ROW& row, int id) const
+  {
+    return row.isNull(index(id));
+  }
+
+  /* Getters which return a default value if the column does not exist instead of throwing an exception. */
+  template<typename ROW>
+  QString valueStr(const ROW& row, int id, const QString& defaultValue) const
+  {
+    return hasColumn(id) ? row.valueStr(indexes.at(id)) : defaultValue;
+  }
+
+  template<typename ROW>
+  int valueInt(const ROW& row, int id, int defaultValue) const
+  {
+    return hasColumn(id) ? row.valueInt(indexes.at(id)) : defaultValue;
+  }
+
+  template<typename ROW>
+  float valueFloat(const ROW& row, int id, float defaultValue) const
+  {
+    return hasColumn(id) ? row.valueFloat(indexes.at(id)) : defaultValue;
+  }
+
+  template<typename ROW>
+  bool valueBool(const ROW& row, int id, bool defaultValue) const
+  {
+    return hasColumn(id) ? row.valueBool(indexes.at(id)) : defaultValue;
+  }
+
+private:
+  Q_NORETURN void throwNotFound(int id) const;
+
+  QStringList names;
+  QVector<int> indexes;
+  QString queryString;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLCOLUMNINDEX_H
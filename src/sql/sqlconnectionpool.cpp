@@ -0,0 +1,202 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlconnectionpool.h"
+
+#include "sql/sqldatabase.h"
+
+#include <QDebug>
+#include <QThread>
+
+#include <algorithm>
+
+namespace atools {
+namespace sql {
+
+const QStringList SqlConnectionPool::DEFAULT_PRAGMAS({"PRAGMA mmap_size=268435456", "PRAGMA query_only=ON"});
+
+SqlConnectionPool::SqlConnectionPool(const QString& databaseFilename, const QString& connectionPrefix, int size,
+                                     const QStringList& pragmas)
+  : filename(databaseFilename), prefix(connectionPrefix), pragmaList(pragmas.isEmpty() ? DEFAULT_PRAGMAS : pragmas)
+{
+  connections.resize(size > 0 ? size : std::max(1, QThread::idealThreadCount()));
+  available.release(connections.size());
+}
+
+SqlConnectionPool::~SqlConnectionPool()
+{
+  QMutexLocker locker(&mutex);
+  for(Connection& connection : connections)
+  {
+    if(connection.leased)
+      qWarning() << Q_FUNC_INFO << "Connection still leased" << connection.db->connectionName();
+    closeConnection(connection);
+  }
+}
+
+SqlDatabase *SqlConnectionPool::acquire()
+{
+  available.acquire();
+  return leaseInternal();
+}
+
+SqlDatabase *SqlConnectionPool::tryAcquire(int timeoutMs)
+{
+  if(available.tryAcquire(1, timeoutMs))
+    return leaseInternal();
+  else
+    return nullptr;
+}
+
+void SqlConnectionPool::release(SqlDatabase *db)
+{
+  if(db == nullptr)
+    return;
+
+  QMutexLocker locker(&mutex);
+  for(Connection& connection : connections)
+  {
+    if(connection.db == db && connection.leased)
+    {
+      connection.leased = false;
+      available.release();
+      return;
+    }
+  }
+  qWarning() << Q_FUNC_INFO << "Connection not found in pool" << db->connectionName();
+}
+
+void SqlConnectionPool::closeIdle()
+{
+  QMutexLocker locker(&mutex);
+  for(Connection& connection : connections)
+  {
+    if(!connection.leased)
+      closeConnection(connection);
+  }
+}
+
+int SqlConnectionPool::getNumOpen() const
+{
+  QMutexLocker locker(&mutex);
+  int num = 0;
+  for(const Connection& connection : connections)
+  {
+    if(connection.db != nullptr)
+      num++;
+  }
+  return num;
+}
+
+SqlDatabase *SqlConnectionPool::leaseInternal()
+{
+  // Semaphore guarantees that at least one connection is free
+  QMutexLocker locker(&mutex);
+  QThread *current = QThread::currentThread();
+  int freeIndex = -1, closedIndex = -1;
+
+  for(int i = 0; i < connections.size(); i++)
+  {
+    Connection& connection = connections[i];
+    if(!connection.leased)
+    {
+      if(connection.db != nullptr && connection.thread == current)
+      {
+        // Opened by this thread before - reuse
+        connection.leased = true;
+        return connection.db;
+      }
+
+      if(connection.db == nullptr)
+      {
+        if(closedIndex == -1)
+          closedIndex = i;
+      }
+      else if(freeIndex == -1)
+        freeIndex = i;
+    }
+  }
+
+  // Prefer a closed slot and keep connections of other threads open
+  int index = closedIndex != -1 ? closedIndex : freeIndex;
+  Connection& connection = connections[index];
+
+  try
+  {
+    // Connection cannot be used in this thread if opened by another one
+    closeConnection(connection);
+    openConnection(connection, index);
+  }
+  catch(...)
+  {
+    closeConnection(connection);
+    available.release();
+    throw;
+  }
+
+  connection.leased = true;
+  return connection.db;
+}
+
+void SqlConnectionPool::openConnection(Connection& connection, int index)
+{
+  connection.db = new SqlDatabase(SqlDatabase::addDatabase("QSQLITE", prefix + "_" + QString::number(index)));
+  connection.thread = QThread::currentThread();
+  connection.db->setDatabaseName(filename);
+
+  // Shared cache is disabled by default
+  connection.db->setConnectOptions("QSQLITE_OPEN_READONLY");
+  connection.db->setReadonly();
+  connection.db->setAutomaticTransactions(false);
+  connection.db->open(pragmaList);
+}
+
+void SqlConnectionPool::closeConnection(Connection& connection)
+{
+  if(connection.db != nullptr)
+  {
+    QString name = connection.db->connectionName();
+    if(connection.db->isOpen())
+      connection.db->close();
+    delete connection.db;
+    connection.db = nullptr;
+    connection.thread = nullptr;
+
+    SqlDatabase::removeDatabase(name);
+  }
+}
+
+SqlConnectionLease::SqlConnectionLease(SqlConnectionPool& connectionPool)
+  : pool(&connectionPool)
+{
+  database = pool->acquire();
+}
+
+SqlConnectionLease::SqlConnectionLease(SqlConnectionPool *connectionPool)
+  : pool(connectionPool)
+{
+  database = pool->acquire();
+}
+
+SqlConnectionLease::~SqlConnectionLease()
+{
+  pool->release(database);
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,143 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLCONNECTIONPOOL_H
+#define ATOOLS_SQL_SQLCONNECTIONPOOL_H
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QStringList>
+#include <QVector>
+
+class QThread;
+
+namespace atools {
+namespace sql {
+
+class SqlDatabase;
+
+/*
+ * Pool of read-only SQLite connections to the same database file which allows threads to query in parallel.
+ * Qt does not allow to use a connection in another thread than the one which opened it. Therefore a leased
+ * connection is bound to the calling thread. A free connection opened by another thread is closed and reopened
+ * in the calling thread. Connections are kept open between leases so threads from a thread pool will usually
+ * get their previous connection back without reopening.
+ *
+ * Connections are opened lazily with QSQLITE_OPEN_READONLY, without shared page cache and with memory mapped I/O.
+ * Automatic transactions are disabled.
+ *
+ * Acquire and release are thread safe. All queries using a leased connection have to be destroyed before
+ * the connection is released.
+ */
+class SqlConnectionPool
+{
+public:
+  /* Creates a pool for the given database file. Connection names are "connectionPrefix_N".
+   * Uses QThread::idealThreadCount() connections if size is zero or less.
+   * Pragmas are executed after opening each connection. Uses DEFAULT_PRAGMAS if empty. */
+  SqlConnectionPool(const QString& databaseFilename, const QString& connectionPrefix, int size = 0,
+                    const QStringList& pragmas = QStringList());
+
+  /* Closes and removes all connections. All connections have to be released before. */
+  ~SqlConnectionPool();
+
+  SqlConnectionPool(const SqlConnectionPool& other) = delete;
+  SqlConnectionPool& operator=(const SqlConnectionPool& other) = delete;
+
+  /* Lease a connection for the calling thread. Blocks until a connection is available.
+   * Throws SqlException if the database cannot be opened. */
+  atools::sql::SqlDatabase *acquire();
+
+  /* As above but waits at most timeoutMs milliseconds. Returns null if no connection is available in time. */
+  atools::sql::SqlDatabase *tryAcquire(int timeoutMs);
+
+  /* Return a leased connection to the pool */
+  void release(atools::sql::SqlDatabase *db);
+
+  /* Close all connections which are not leased. Call from the thread which leased them last or
+   * when no thread is using the pool anymore, e.g. before replacing the database file. */
+  void closeIdle();
+
+  /* Maximum number of connections */
+  int getSize() const
+  {
+    return connections.size();
+  }
+
+  /* Number of currently open connections */
+  int getNumOpen() const;
+
+  const QString& getFilename() const
+  {
+    return filename;
+  }
+
+  /* mmap I/O and query only */
+  static const QStringList DEFAULT_PRAGMAS;
+
+private:
+  struct Connection
+  {
+    atools::sql::SqlDatabase *db = nullptr;
+    QThread *thread = nullptr;
+    bool leased = false;
+  };
+
+  atools::sql::SqlDatabase *leaseInternal();
+  void openConnection(Connection& connection, int index);
+  void closeConnection(Connection& connection);
+
+  QString filename, prefix;
+  QStringList pragmaList;
+  QVector<Connection> connections;
+  QSemaphore available;
+  mutable QMutex mutex;
+};
+
+/*
+ * Leases a connection from the pool on instantiation and returns it in the destructor.
+ */
+class SqlConnectionLease
+{
+public:
+  explicit SqlConnectionLease(atools::sql::SqlConnectionPool& connectionPool);
+  explicit SqlConnectionLease(atools::sql::SqlConnectionPool *connectionPool);
+  ~SqlConnectionLease();
+
+  SqlConnectionLease(const SqlConnectionLease& other) = delete;
+  SqlConnectionLease& operator=(const SqlConnectionLease& other) = delete;
+
+  atools::sql::SqlDatabase *db() const
+  {
+    return database;
+  }
+
+  atools::sql::SqlDatabase *operator->() const
+  {
+    return database;
+  }
+
+private:
+  atools::sql::SqlConnectionPool *pool;
+  atools::sql::SqlDatabase *database;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLCONNECTIONPOOL_H
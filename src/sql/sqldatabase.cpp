@@ -17,19 +17,33 @@
 
 #include "sql/sqldatabase.h"
 #include "sql/sqlexception.h"
+#include "sql/sqlitecompressedvfs.h"
 #include "sql/sqlquery.h"
+#include "sql/sqlquerystats.h"
 #include "sql/sqlrecord.h"
+#include "util/trace.h"
 
 #include <QSettings>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QSqlIndex>
 #include <QSqlDriver>
+#include <QSqlQuery>
+
+#include <algorithm>
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+#include <sqlite3.h>
+#endif
 
 namespace atools {
 
 namespace sql {
 
+/* Default number of prepared queries kept in the cache */
+static const int QUERY_CACHE_SIZE = 64;
+
 SqlDatabase::SqlDatabase()
 {
 }
@@ -37,6 +51,7 @@ SqlDatabase::SqlDatabase()
 SqlDatabase::SqlDatabase(const QSqlDatabase& other)
 {
   db = QSqlDatabase(other);
+  queryCache.reset(new QCache<QString, QSqlQuery>(QUERY_CACHE_SIZE));
 }
 
 SqlDatabase::SqlDatabase(const SqlDatabase& other)
@@ -45,13 +60,20 @@ SqlDatabase::SqlDatabase(const SqlDatabase& other)
   autocommit = other.autocommit;
   readonly = other.readonly;
   automaticTransactions = other.automaticTransactions;
+  loadIntoMemory = other.loadIntoMemory;
+  mmapSize = other.mmapSize;
+  memorySourceFile = other.memorySourceFile;
+  compressedSourceFile = other.compressedSourceFile;
+  compressedConnectOptions = other.compressedConnectOptions;
   name = other.name;
+  queryCache = other.queryCache;
 }
 
 SqlDatabase::SqlDatabase(const QString& connectionName)
 {
   db = QSqlDatabase::database(connectionName, false);
   name = connectionName;
+  queryCache.reset(new QCache<QString, QSqlQuery>(QUERY_CACHE_SIZE));
 }
 
 SqlDatabase::SqlDatabase(const QSettings& settings, const QString& groupName)
@@ -70,6 +92,7 @@ SqlDatabase::SqlDatabase(const QSettings& settings, const QString& groupName)
   db.setPort(settings.value(groupName + "/Port").toInt());
   db.setUserName(settings.value(groupName + "/UserName").toString());
   db.setPassword(settings.value(groupName + "/Password").toString());
+  queryCache.reset(new QCache<QString, QSqlQuery>(QUERY_CACHE_SIZE));
 }
 
 SqlDatabase::~SqlDatabase()
@@ -82,15 +105,24 @@ SqlDatabase& SqlDatabase::operator=(const SqlDatabase& other)
   autocommit = other.autocommit;
   readonly = other.readonly;
   automaticTransactions = other.automaticTransactions;
+  loadIntoMemory = other.loadIntoMemory;
+  mmapSize = other.mmapSize;
+  memorySourceFile = other.memorySourceFile;
+  compressedSourceFile = other.compressedSourceFile;
+  compressedConnectOptions = other.compressedConnectOptions;
   name = other.name;
+  queryCache = other.queryCache;
   return *this;
 }
 
 void SqlDatabase::open(const QStringList& pragmas)
 {
+  ATOOLS_TRACE_SCOPE("SqlDatabase::open", "startup");
   checkError(!isOpen(), "Opening a database that is already open");
+  QString memorySource = prepareOpen();
   checkError(db.open(), "Error opening database");
   checkError(isValid(), "Database not valid after opening");
+  finishOpen(memorySource);
 
   for(const QString& pragma : pragmas)
   {
@@ -115,9 +147,12 @@ void SqlDatabase::open(const QStringList& pragmas)
 
 void SqlDatabase::open(const QString& user, const QString& password, const QStringList& pragmas)
 {
+  ATOOLS_TRACE_SCOPE("SqlDatabase::open", "startup");
   checkError(!isOpen(), "Opening a database that is already open");
+  QString memorySource = prepareOpen();
   checkError(db.open(user, password), "Error opening database");
   checkError(isValid(), "Database not valid after opening");
+  finishOpen(memorySource);
 
   qInfo() << "Opened database" << databaseName();
   for(const QString& pragma : pragmas)
@@ -130,16 +165,166 @@ void SqlDatabase::open(const QString& user, const QString& password, const QStri
     transactionInternal();
 }
 
+QString SqlDatabase::prepareOpen()
+{
+  QString memorySource;
+  if(loadIntoMemory && db.driverName() == "QSQLITE" && db.databaseName() != ":memory:")
+  {
+    memorySource = db.databaseName();
+    checkError(QFileInfo(memorySource).isFile(), "Database file \"" + memorySource + "\" not found");
+    db.setDatabaseName(":memory:");
+  }
+  else if(db.driverName() == "QSQLITE" && SqliteCompressedVfs::isCompressed(db.databaseName()))
+  {
+    // Open page compressed file through the VFS which needs an URI
+    checkError(readonly, "Compressed database \"" + db.databaseName() + "\" can only be opened read only");
+    checkError(SqliteCompressedVfs::registerVfs(), "Cannot register VFS for compressed database");
+
+    compressedSourceFile = db.databaseName();
+    compressedConnectOptions = db.connectOptions();
+    QStringList options = compressedConnectOptions.split(';', QString::SkipEmptyParts);
+    options << "QSQLITE_OPEN_URI" << "QSQLITE_OPEN_READONLY";
+    db.setConnectOptions(options.join(';'));
+    db.setDatabaseName(SqliteCompressedVfs::uri(compressedSourceFile));
+  }
+  return memorySource;
+}
+
+void SqlDatabase::finishOpen(const QString& memorySource)
+{
+  if(!memorySource.isEmpty())
+  {
+    memorySourceFile = memorySource;
+    try
+    {
+      copyIntoMemory(memorySource);
+    }
+    catch(...)
+    {
+      db.close();
+      db.setDatabaseName(memorySource);
+      memorySourceFile.clear();
+      throw;
+    }
+  }
+
+  if(mmapSize > 0 && memorySource.isEmpty())
+  {
+    db.exec("PRAGMA mmap_size=" + QString::number(mmapSize));
+    checkError(isValid(), "Database not valid after setting mmap size");
+  }
+}
+
+void SqlDatabase::copyIntoMemory(const QString& filename)
+{
+  qInfo() << Q_FUNC_INFO << "Loading" << filename << "into memory";
+  QElapsedTimer timer;
+  timer.start();
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  // Copy all pages using the backup API
+  QVariant driverHandle = db.driver()->handle();
+  checkError(driverHandle.isValid() && qstrcmp(driverHandle.typeName(), "sqlite3*") == 0,
+             "Cannot get SQLite handle for loading into memory");
+  sqlite3 *destHandle = *static_cast<sqlite3 **>(driverHandle.data());
+
+  // Read page compressed files through the VFS
+  const char *vfsName = nullptr;
+  if(SqliteCompressedVfs::isCompressed(filename))
+  {
+    checkError(SqliteCompressedVfs::registerVfs(), "Cannot register VFS for compressed database");
+    vfsName = SqliteCompressedVfs::VFS_NAME;
+  }
+
+  sqlite3 *sourceHandle = nullptr;
+  int result = sqlite3_open_v2(filename.toUtf8().constData(), &sourceHandle, SQLITE_OPEN_READONLY, vfsName);
+  if(result == SQLITE_OK)
+  {
+    sqlite3_backup *backup = sqlite3_backup_init(destHandle, "main", sourceHandle, "main");
+    if(backup != nullptr)
+    {
+      sqlite3_backup_step(backup, -1);
+      sqlite3_backup_finish(backup);
+    }
+    result = sqlite3_errcode(destHandle);
+  }
+  QString errorMessage = result == SQLITE_OK ? QString() : QString(sqlite3_errstr(result));
+  sqlite3_close(sourceHandle);
+
+  if(result != SQLITE_OK)
+    throw SqlException("Error loading \"" + filename + "\" into memory: " + errorMessage);
+#else
+  checkError(!SqliteCompressedVfs::isCompressed(filename),
+             "Loading compressed database \"" + filename + "\" into memory needs ATOOLS_SQLITE_NATIVE");
+
+  // Copy schema and content through an attached database - tables first and indexes after inserting
+  static const QString SCHEMA("memory_source");
+  SqlQuery query(this);
+  query.prepare("attach database :db as " + SCHEMA);
+  query.bindValue(":db", filename);
+  query.exec();
+
+  QStringList tables, others;
+  SqlQuery schema(this);
+  schema.exec("select type, name, sql from " + SCHEMA + ".sqlite_master "
+              "where sql is not null and name not like 'sqlite_%' order by rowid");
+  while(schema.next())
+  {
+    if(schema.valueStr(0) == "table")
+    {
+      query.exec(schema.valueStr(2));
+      tables.append(schema.valueStr(1));
+    }
+    else
+      others.append(schema.valueStr(2));
+  }
+  schema.finish();
+
+  checkError(db.transaction(), "SqlDatabase::copyIntoMemory() error");
+  for(const QString& table : tables)
+    query.exec("insert into main.\"" + table + "\" select * from " + SCHEMA + ".\"" + table + "\"");
+
+  for(const QString& sql : others)
+    query.exec(sql);
+  checkError(db.commit(), "SqlDatabase::copyIntoMemory() error");
+
+  query.exec("detach database " + SCHEMA);
+#endif
+
+  qInfo() << Q_FUNC_INFO << "Loaded" << filename << "in" << timer.elapsed() << "ms";
+}
+
 void SqlDatabase::close()
 {
   checkError(isValid(), "Trying to close invalid database");
   checkError(isOpen(), "Closing already closed database");
   if(!readonly && automaticTransactions)
     rollback();
+
+  // Prepared statements are invalid after closing
+  clearQueryCache();
   db.close();
 
   qInfo() << "Closed database" << databaseName();
 
+  if(!memorySourceFile.isEmpty())
+  {
+    // Allow to open file again
+    db.setDatabaseName(memorySourceFile);
+    memorySourceFile.clear();
+    return;
+  }
+
+  if(!compressedSourceFile.isEmpty())
+  {
+    // Replace URI with file name again - compressed files have no journal
+    db.setDatabaseName(compressedSourceFile);
+    db.setConnectOptions(compressedConnectOptions);
+    compressedSourceFile.clear();
+    compressedConnectOptions.clear();
+    return;
+  }
+
   QString journalName(db.databaseName() + "-journal");
   QFileInfo journal(journalName);
   if(journal.exists() && journal.isFile() && journal.size() == 0)
@@ -152,6 +337,7 @@ void SqlDatabase::close()
 void SqlDatabase::executePragmas(const QStringList& pragmas)
 {
   checkError(db.rollback(), "SqlDatabase::pragma() error");
+  clearQueryCache();
 
   for(const QString& pragma : pragmas)
   {
@@ -165,6 +351,7 @@ void SqlDatabase::executePragmas(const QStringList& pragmas)
 void SqlDatabase::attachDatabase(const QString& file, const QString& name)
 {
   checkError(db.rollback(), "SqlDatabase::attachDatabase() error");
+  clearQueryCache();
 
   SqlQuery query(db);
   query.prepare("attach database :db as :name");
@@ -178,6 +365,7 @@ void SqlDatabase::attachDatabase(const QString& file, const QString& name)
 void SqlDatabase::detachDatabase(const QString& name)
 {
   checkError(db.rollback(), "SqlDatabase::detachDatabase() error");
+  clearQueryCache();
 
   SqlQuery query(db);
   query.prepare("detach database :name");
@@ -190,10 +378,77 @@ void SqlDatabase::detachDatabase(const QString& name)
 void SqlDatabase::vacuum()
 {
   checkError(db.rollback(), "SqlDatabase::detachDatabase() error");
+  clearQueryCache();
   exec("vacuum");
   checkError(db.transaction(), "SqlDatabase::detachDatabase() error");
 }
 
+void SqlDatabase::setWalMode(bool enable)
+{
+  // Journal mode cannot be changed inside a transaction
+  bool transactions = !readonly && automaticTransactions;
+  if(transactions)
+    checkError(db.rollback(), "SqlDatabase::setWalMode() error");
+  clearQueryCache();
+
+  SqlQuery query = exec(enable ? "PRAGMA journal_mode=WAL" : "PRAGMA journal_mode=DELETE");
+  if(query.next())
+    qInfo() << Q_FUNC_INFO << databaseName() << "journal mode is now" << query.valueStr(0);
+  query.finish();
+
+  if(transactions)
+    transactionInternal();
+}
+
+bool SqlDatabase::isWalMode() const
+{
+  SqlQuery query = exec("PRAGMA journal_mode");
+  bool wal = query.next() && query.valueStr(0).compare("wal", Qt::CaseInsensitive) == 0;
+  query.finish();
+  return wal;
+}
+
+bool SqlDatabase::walCheckpoint(WalCheckpoint mode)
+{
+  // Commit reopens a deferred transaction which does not hold any locks
+  if(!readonly && automaticTransactions)
+    commit();
+
+  QString modeStr;
+  switch(mode)
+  {
+    case CHECKPOINT_PASSIVE:
+      modeStr = "PASSIVE";
+      break;
+    case CHECKPOINT_FULL:
+      modeStr = "FULL";
+      break;
+    case CHECKPOINT_RESTART:
+      modeStr = "RESTART";
+      break;
+    case CHECKPOINT_TRUNCATE:
+      modeStr = "TRUNCATE";
+      break;
+  }
+
+  // Returns one row with busy flag, number of frames in log and number of frames checkpointed
+  SqlQuery query = exec("PRAGMA wal_checkpoint(" + modeStr + ")");
+  bool busy = true;
+  if(query.next())
+  {
+    busy = query.valueInt(0) != 0;
+    qDebug() << Q_FUNC_INFO << databaseName() << modeStr << "busy" << busy
+             << "log frames" << query.valueInt(1) << "checkpointed" << query.valueInt(2);
+  }
+  query.finish();
+  return !busy;
+}
+
+void SqlDatabase::setWalAutoCheckpoint(int pages)
+{
+  exec("PRAGMA wal_autocheckpoint=" + QString::number(std::max(pages, 0))).finish();
+}
+
 void SqlDatabase::analyze()
 {
   exec("analyze");
@@ -202,6 +457,43 @@ void SqlDatabase::analyze()
   exec("analyze sqlite_master");
 }
 
+SqlQuery SqlDatabase::cachedQuery(const QString& queryStr) const
+{
+  if(queryCache.isNull())
+    queryCache.reset(new QCache<QString, QSqlQuery>(QUERY_CACHE_SIZE));
+
+  SqlQuery query(this);
+  QSqlQuery *cached = queryCache->object(queryStr);
+  if(cached != nullptr)
+  {
+    // Reset statement and copy - result is shared between copies
+    cached->finish();
+    query.query = *cached;
+    query.queryString = queryStr;
+    query.clearBoundValues();
+  }
+  else
+  {
+    query.prepare(queryStr);
+    queryCache->insert(queryStr, new QSqlQuery(query.query));
+  }
+  return query;
+}
+
+void SqlDatabase::clearQueryCache() const
+{
+  if(!queryCache.isNull())
+    queryCache->clear();
+}
+
+void SqlDatabase::setQueryCacheSize(int size)
+{
+  if(queryCache.isNull())
+    queryCache.reset(new QCache<QString, QSqlQuery>(size));
+  else
+    queryCache->setMaxCost(size);
+}
+
 bool SqlDatabase::isOpen() const
 {
   return db.isOpen();
@@ -240,7 +532,15 @@ SqlRecord SqlDatabase::record(const QString& tablename, const QString& prefix) c
 
 SqlQuery SqlDatabase::exec(const QString& query) const
 {
+  QElapsedTimer timer;
+  bool stats = SqlQueryStats::isEnabled();
+  if(stats)
+    timer.start();
+
   SqlQuery q = SqlQuery(db.exec(query), query);
+
+  if(stats)
+    SqlQueryStats::recordExec(query, timer.nsecsElapsed(), db);
   checkError(true, "SqlDatabase::exec() error creating query");
   return q;
 }
@@ -18,10 +18,13 @@
 #ifndef ATOOLS_SQL_SQLDATABASE_H
 #define ATOOLS_SQL_SQLDATABASE_H
 
+#include <QCache>
+#include <QSharedPointer>
 #include <QSqlDatabase>
 #include <QStringList>
 
 class QSettings;
+class QSqlQuery;
 
 namespace atools {
 namespace sql {
@@ -153,6 +156,51 @@ public:
   /* Sqlite only. Compresses the database */
   void vacuum();
 
+  /* Sqlite only. Checkpoint modes for walCheckpoint() */
+  enum WalCheckpoint
+  {
+    CHECKPOINT_PASSIVE, /* Checkpoint as much as possible without waiting for readers or writers */
+    CHECKPOINT_FULL, /* Wait for writers and checkpoint all frames */
+    CHECKPOINT_RESTART, /* As FULL and wait for readers so that the log can be restarted */
+    CHECKPOINT_TRUNCATE /* As RESTART and truncate the log file to zero bytes */
+  };
+
+  /* Sqlite only. Rolls the current transaction back if automatic transactions are on and switches the
+   * journal mode to write ahead log (WAL) or back to the default rollback journal.
+   * WAL allows readers on other connections to continue while one connection writes.
+   * The mode is persistent and stored in the database file. Opens transaction again afterwards. */
+  void setWalMode(bool enable = true);
+  bool isWalMode() const;
+
+  /* Sqlite only. Commits the current transaction if automatic transactions are on and copies the write
+   * ahead log content back into the database file.
+   * Returns false if the checkpoint could not complete because of other readers or writers. */
+  bool walCheckpoint(WalCheckpoint mode = CHECKPOINT_PASSIVE);
+
+  /* Sqlite only. If true open() creates an in-memory database and copies the content of the file set by
+   * setDatabaseName() into it. Query latency does not depend on disk access then. Changes are not written back.
+   * Uses the SQLite backup API if built with ATOOLS_SQLITE_NATIVE. Otherwise copies schema and tables through
+   * an attached database. Use only for read-only databases fitting into memory. */
+  void setLoadIntoMemory(bool value = true)
+  {
+    loadIntoMemory = value;
+  }
+
+  bool isLoadIntoMemory() const
+  {
+    return loadIntoMemory;
+  }
+
+  /* Sqlite only. Size in bytes for memory mapped I/O which is set after opening. Zero uses the SQLite default. */
+  void setMmapSize(qint64 bytes)
+  {
+    mmapSize = bytes;
+  }
+
+  /* Sqlite only. Run a passive checkpoint automatically whenever the log exceeds the given number of pages.
+   * Zero or negative disables automatic checkpoints. SQLite default is 1000 pages. */
+  void setWalAutoCheckpoint(int pages);
+
   /* Sqlite only. Gather schema statistics for query optimization. */
   void analyze();
 
@@ -166,6 +214,19 @@ public:
     automaticTransactions = value;
   }
 
+  /* Returns a prepared query for the statement from a least recently used cache which is shared between
+   * all copies of this database object. The query is finished and bound values are cleared before it is returned.
+   * Queries for the same statement share their result set. Do not use two of them at the same time.
+   * Prepares and inserts the statement if it is not cached yet. */
+  SqlQuery cachedQuery(const QString& queryStr) const;
+
+  /* Removes all prepared queries from the cache. Called automatically on close(), pragmas, attach, detach and
+   * vacuum. Call it after changing the schema (drop or alter table) by other means. */
+  void clearQueryCache() const;
+
+  /* Maximum number of cached prepared queries. Default is 64. */
+  void setQueryCacheSize(int size);
+
 private:
   friend class atools::sql::SqlTransaction;
 
@@ -175,9 +236,30 @@ private:
   void checkError(bool retval = true, const QString& msg = QString()) const;
   void transactionInternal();
 
+  /* Switch to in-memory database before opening if requested. Returns the file to load.
+   * Switches to the VFS URI for page compressed files. */
+  QString prepareOpen();
+
+  /* Load file into memory and set mmap size after opening */
+  void finishOpen(const QString& memorySource);
+
+  /* Copy file content into the opened in-memory database */
+  void copyIntoMemory(const QString& filename);
+
   QSqlDatabase db;
-  bool autocommit = false, readonly = false, automaticTransactions = true;
+  bool autocommit = false, readonly = false, automaticTransactions = true, loadIntoMemory = false;
+  qint64 mmapSize = 0;
   QString name;
+
+  /* File name loaded into memory if open */
+  QString memorySourceFile;
+
+  /* File name and original connect options of a compressed database if open through the VFS */
+  QString compressedSourceFile, compressedConnectOptions;
+
+  /* Prepared queries keyed by statement. Shared between copies since SqlQuery keeps a copy of the database.
+   * Created on demand for default constructed objects. */
+  mutable QSharedPointer<QCache<QString, QSqlQuery> > queryCache;
 };
 
 } // namespace sql
@@ -130,6 +130,8 @@ public:
   }
 
 private:
+  friend class SqlExportWriter;
+
   QString printEndl() const;
   QString buildString(QString value) const;
   QString printValue(QVariant value) const;
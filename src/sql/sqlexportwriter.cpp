@@ -0,0 +1,246 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlexportwriter.h"
+
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "zip/gzip.h"
+
+#include <QDebug>
+#include <QIODevice>
+
+namespace atools {
+namespace sql {
+
+/* Buffer is written to the device when exceeding this size */
+static const int BUFFER_SIZE = 64 * 1024;
+
+SqlExportWriter::SqlExportWriter(const SqlExport& sqlExport, QIODevice *outputDevice, bool gzip)
+  : format(sqlExport), device(outputDevice)
+{
+  if(gzip)
+    gzipWriter.reset(new atools::zip::GzipWriter(device));
+
+  buffer.reserve(BUFFER_SIZE + 4096);
+  separator = QString(format.separator).toUtf8();
+  escape = QString(format.escapeString).toUtf8();
+  escapeEscape = escape + escape;
+  nullValue = format.nullValue.toUtf8();
+}
+
+SqlExportWriter::~SqlExportWriter()
+{
+  close();
+}
+
+void SqlExportWriter::writeHeader(const SqlRecord& record)
+{
+  writeHeader(record.fieldNames());
+}
+
+void SqlExportWriter::writeHeader(const QStringList& columnNames)
+{
+  if(!columnsInitialized)
+    initColumns(columnNames);
+
+  for(int i = 0; i < columnNames.size(); i++)
+  {
+    if(i > 0)
+    {
+      buffer.append(separator);
+      appendString(columnNames.at(i));
+    }
+    else
+      // First column is not escaped like in SqlExport::getResultSetHeader()
+      buffer.append(columnNames.at(i).toUtf8());
+  }
+  endRow();
+}
+
+void SqlExportWriter::writeRow(const SqlQuery& query)
+{
+  if(!columnsInitialized)
+    initColumns(query.record().fieldNames());
+
+  for(int i = 0; i < conversionFuncs.size(); i++)
+  {
+    if(i > 0)
+      buffer.append(separator);
+    appendValue(query.value(i), i);
+  }
+  endRow();
+  numRows++;
+}
+
+void SqlExportWriter::writeRow(const SqlRecord& record)
+{
+  if(!columnsInitialized)
+    initColumns(record.fieldNames());
+
+  for(int i = 0; i < record.count(); i++)
+  {
+    if(i > 0)
+      buffer.append(separator);
+    appendValue(record.value(i), i);
+  }
+  endRow();
+  numRows++;
+}
+
+int SqlExportWriter::writeResultSet(SqlQuery& query)
+{
+  int num = 0;
+  while(query.next())
+  {
+    if(format.maxValues != -1 && num >= format.maxValues)
+      break;
+
+    if(num == 0 && format.header)
+      writeHeader(query.record());
+
+    writeRow(query);
+    num++;
+  }
+  return num;
+}
+
+void SqlExportWriter::writeLinefeed()
+{
+  endRow();
+}
+
+void SqlExportWriter::close()
+{
+  if(closed)
+    return;
+
+  closed = true;
+  flush();
+  if(!gzipWriter.isNull() && !gzipWriter->close())
+    ok = false;
+
+  if(!ok)
+    qWarning() << Q_FUNC_INFO << "Error writing" << device->errorString();
+}
+
+void SqlExportWriter::initColumns(const QStringList& columnNames)
+{
+  conversionFuncs.clear();
+  for(const QString& name : columnNames)
+  {
+    auto it = format.conversionFuncs.constFind(name);
+    conversionFuncs.append(it != format.conversionFuncs.constEnd() ? &it.value() : nullptr);
+  }
+  columnsInitialized = true;
+}
+
+void SqlExportWriter::appendValue(const QVariant& value, int column)
+{
+  const SqlExport::ConvertFuncType *func = column < conversionFuncs.size() ? conversionFuncs.at(column) : nullptr;
+
+  if(func != nullptr)
+    // Invoke callback for the given column
+    appendString((*func)(value));
+  else if(!value.isValid() && !value.isNull())
+    buffer.append("[INVALID_VALUE]");
+  else if(value.isNull())
+    buffer.append(nullValue);
+  else
+  {
+    switch(value.type())
+    {
+      case QVariant::Int:
+      case QVariant::LongLong:
+        buffer.append(QByteArray::number(value.toLongLong()));
+        break;
+
+      case QVariant::UInt:
+      case QVariant::ULongLong:
+        buffer.append(QByteArray::number(value.toULongLong()));
+        break;
+
+      case QVariant::Double:
+        buffer.append(QByteArray::number(value.toDouble(), 'f', format.numberPrecision));
+        break;
+
+      case QVariant::String:
+        appendString(value.toString());
+        break;
+
+      default:
+        if(value.canConvert(QVariant::String))
+          appendString(value.toString());
+        else
+        {
+          buffer.append("[CANNOT_CONVERT_VALUE:");
+          buffer.append(value.typeName());
+          buffer.append("]");
+        }
+    }
+  }
+}
+
+void SqlExportWriter::appendString(const QString& str)
+{
+  // Same rules as SqlExport::buildString() - surround with escape character if any special characters,
+  // the separator are found or the string consists of whitespace only
+  bool needsEscape = false, whitespace = !str.isEmpty();
+  for(QChar c : str)
+  {
+    if(c == format.separator || c == format.escapeString || c == QChar::LineFeed || c == QChar::CarriageReturn)
+    {
+      needsEscape = true;
+      break;
+    }
+    whitespace &= c.isSpace();
+  }
+
+  if(needsEscape || whitespace)
+  {
+    buffer.append(escape);
+    buffer.append(str.toUtf8().replace(escape, escapeEscape));
+    buffer.append(escape);
+  }
+  else
+    buffer.append(str.toUtf8());
+}
+
+void SqlExportWriter::endRow()
+{
+  buffer.append('\n');
+  if(buffer.size() > BUFFER_SIZE)
+    flush();
+}
+
+void SqlExportWriter::flush()
+{
+  if(buffer.isEmpty())
+    return;
+
+  if(gzipWriter.isNull())
+    ok &= device->write(buffer) == buffer.size();
+  else
+    ok &= gzipWriter->write(buffer);
+
+  // Keeps allocated memory
+  buffer.resize(0);
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,115 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLEXPORTWRITER_H
+#define ATOOLS_SQL_SQLEXPORTWRITER_H
+
+#include "sql/sqlexport.h"
+
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QVector>
+
+class QIODevice;
+
+namespace atools {
+namespace zip {
+class GzipWriter;
+}
+
+namespace sql {
+
+class SqlQuery;
+class SqlRecord;
+
+/*
+ * Streaming CSV writer which uses the format settings of a SqlExport object.
+ * Rows are formatted directly into a reusable UTF-8 buffer which is written to the device when full.
+ * Numbers are formatted without creating intermediate strings. Memory usage does not depend on the number of rows.
+ *
+ * Each row is terminated by a linefeed regardless of SqlExport::setEndline().
+ * Open the device with QIODevice::Text to get platform line endings.
+ * Conversion functions of SqlExport are applied by column name.
+ */
+class SqlExportWriter
+{
+public:
+  /* Device has to be open for writing. Output is GZIP compressed if gzip is true. */
+  SqlExportWriter(const atools::sql::SqlExport& sqlExport, QIODevice *outputDevice, bool gzip = false);
+  ~SqlExportWriter();
+
+  SqlExportWriter(const SqlExportWriter& other) = delete;
+  SqlExportWriter& operator=(const SqlExportWriter& other) = delete;
+
+  /* Write header row with column names */
+  void writeHeader(const atools::sql::SqlRecord& record);
+  void writeHeader(const QStringList& columnNames);
+
+  /* Write the current row of the query without creating a record */
+  void writeRow(const atools::sql::SqlQuery& query);
+
+  /* Write a row from the record */
+  void writeRow(const atools::sql::SqlRecord& record);
+
+  /* Write all rows from an executed query. Writes a header before the first row if enabled in SqlExport.
+   * Returns number of rows written. */
+  int writeResultSet(atools::sql::SqlQuery& query);
+
+  /* Write an empty line. Used e.g. to terminate the last line of a file before appending */
+  void writeLinefeed();
+
+  /* Write buffered data and the GZIP trailer if compressed. Called by destructor if not done before. */
+  void close();
+
+  /* Number of data rows written */
+  int getNumRows() const
+  {
+    return numRows;
+  }
+
+  /* false if writing to the device failed */
+  bool isOk() const
+  {
+    return ok;
+  }
+
+private:
+  /* Find conversion functions for columns */
+  void initColumns(const QStringList& columnNames);
+  void appendValue(const QVariant& value, int column);
+  void appendString(const QString& str);
+  void endRow();
+  void flush();
+
+  const atools::sql::SqlExport& format;
+  QIODevice *device;
+  QScopedPointer<atools::zip::GzipWriter> gzipWriter;
+
+  /* Conversion function for each column index or null */
+  QVector<const atools::sql::SqlExport::ConvertFuncType *> conversionFuncs;
+  bool columnsInitialized = false;
+
+  QByteArray buffer, separator, escape, escapeEscape, nullValue;
+  int numRows = 0;
+  bool ok = true, closed = false;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLEXPORTWRITER_H
@@ -0,0 +1,111 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlfulltextindex.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QStringList>
+
+namespace atools {
+namespace sql {
+
+SqlFullTextIndex::SqlFullTextIndex(SqlDatabase *sqlDb, const QString& tablename)
+  : db(sqlDb), table(tablename)
+{
+  available = hasIndex(db, table);
+}
+
+SqlFullTextIndex::~SqlFullTextIndex()
+{
+  delete query;
+}
+
+bool SqlFullTextIndex::hasIndex(SqlDatabase *sqlDb, const QString& tablename)
+{
+  return SqlUtil(sqlDb).hasTable(ftsTableName(tablename));
+}
+
+bool SqlFullTextIndex::isFts5Available(SqlDatabase *sqlDb)
+{
+  if(sqlDb->driverName() != "QSQLITE")
+    return false;
+
+  SqlQuery optionQuery("select sqlite_compileoption_used('ENABLE_FTS5')", sqlDb);
+  optionQuery.exec();
+  return optionQuery.next() && optionQuery.valueInt(0) == 1;
+}
+
+QString SqlFullTextIndex::matchExpression(const QString& text)
+{
+  // Split at the same characters as the unicode61 tokenizer
+  QStringList words;
+  QString word;
+  for(QChar c : text + ' ')
+  {
+    if(c.isLetterOrNumber())
+      word.append(c);
+    else if(!word.isEmpty())
+    {
+      // Quote to avoid interpretation of words like "AND" or "NEAR" as operators
+      words.append('"' + word + "\"*");
+      word.clear();
+    }
+  }
+  return words.join(' ');
+}
+
+QString SqlFullTextIndex::whereClause(const QString& tablename, const QString& idColumn)
+{
+  QString fts = ftsTableName(tablename);
+  return idColumn + " in (select rowid from " + fts + " where " + fts + " match :fts_match)";
+}
+
+void SqlFullTextIndex::bindText(SqlQuery& query, const QString& text)
+{
+  query.bindValue(":fts_match", matchExpression(text));
+}
+
+QVector<int> SqlFullTextIndex::getIds(const QString& text, int limit)
+{
+  QVector<int> ids;
+  QString match = matchExpression(text);
+
+  if(available && !match.isEmpty())
+  {
+    if(query == nullptr)
+    {
+      QString fts = ftsTableName(table);
+      query = new SqlQuery(db);
+      query->prepare("select rowid from " + fts + " where " + fts + " match :fts_match order by rank limit :limit");
+    }
+
+    query->bindValue(":fts_match", match);
+    query->bindValue(":limit", limit > 0 ? limit : -1);
+    query->exec();
+    while(query->next())
+      ids.append(query->valueInt(0));
+    query->finish();
+  }
+  return ids;
+}
+
+} // namespace sql
+} // namespace atools
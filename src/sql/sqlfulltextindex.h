@@ -0,0 +1,100 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLFULLTEXTINDEX_H
+#define ATOOLS_SQL_SQLFULLTEXTINDEX_H
+
+#include <QString>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+
+class SqlDatabase;
+class SqlQuery;
+
+/*
+ * Prefix search helper for the optional SQLite FTS5 virtual tables which accompany tables having names.
+ *
+ * The FTS5 table for a table "airport" is "airport_fts" using the table as external content and its
+ * primary key as rowid. All words of the search text have to match the beginning of a word in any of the
+ * indexed columns ignoring case and diacritics. "frank main" finds "Frankfurt am Main", for example.
+ *
+ * The navdatabase creates these tables with the option FullTextIndex. Always check isAvailable() and fall
+ * back to "like" queries if the index is missing.
+ */
+class SqlFullTextIndex
+{
+public:
+  /* Uses the FTS5 table for tablename, e.g. "airport_fts" for "airport" */
+  SqlFullTextIndex(atools::sql::SqlDatabase *sqlDb, const QString& tablename);
+  ~SqlFullTextIndex();
+
+  SqlFullTextIndex(const SqlFullTextIndex& other) = delete;
+  SqlFullTextIndex& operator=(const SqlFullTextIndex& other) = delete;
+
+  /* true if the FTS5 table exists */
+  bool isAvailable() const
+  {
+    return available;
+  }
+
+  /* Ids of all rows matching all words of text as prefix. Best matches first.
+   * Returns no more than limit ids if limit is > 0. Empty if the index is not available or text has no words. */
+  QVector<int> getIds(const QString& text, int limit = -1);
+
+  /* Name of the FTS5 table for the given table */
+  static QString ftsTableName(const QString& tablename)
+  {
+    return tablename + "_fts";
+  }
+
+  /* true if the FTS5 table for the given table exists */
+  static bool hasIndex(atools::sql::SqlDatabase *sqlDb, const QString& tablename);
+
+  /* true if the SQLite library was compiled with FTS5 */
+  static bool isFts5Available(atools::sql::SqlDatabase *sqlDb);
+
+  /*
+   * Converts user input to a FTS5 match expression where each word is a quoted prefix query.
+   * "frank main" results in "\"frank\"* \"main\"*". Quotes and FTS5 operators in text are not interpreted.
+   * Returns an empty string if text contains no words.
+   */
+  static QString matchExpression(const QString& text);
+
+  /*
+   * Expression for a where clause which selects rows of tablename by the full text index, e.g.
+   * "airport.airport_id in (select rowid from airport_fts where airport_fts match :fts_match)".
+   * Bind the placeholder using bindText().
+   */
+  static QString whereClause(const QString& tablename, const QString& idColumn);
+
+  /* Bind the placeholder ":fts_match" used by whereClause(). matchExpression() of text must not be empty. */
+  static void bindText(atools::sql::SqlQuery& query, const QString& text);
+
+private:
+  atools::sql::SqlDatabase *db;
+  QString table;
+  atools::sql::SqlQuery *query = nullptr;
+  bool available = false;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLFULLTEXTINDEX_H
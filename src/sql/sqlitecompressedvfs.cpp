@@ -0,0 +1,501 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlitecompressedvfs.h"
+
+#include "exception.h"
+#include "util/parallel.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUrl>
+#include <QVector>
+#include <QtEndian>
+
+#include <algorithm>
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+#include <sqlite3.h>
+#include <cstring>
+#include <new>
+#endif
+
+namespace atools {
+namespace sql {
+
+const char *SqliteCompressedVfs::VFS_NAME = "atools_compressed";
+
+namespace {
+
+const char MAGIC[8] = {'A', 'T', 'S', 'Q', 'L', 'Z', 'P', 'G'};
+const quint32 VERSION = 1;
+
+/* Magic, version, page size, page count, reserved and file size */
+const int HEADER_SIZE = 8 + 4 + 4 + 4 + 4 + 8;
+
+/* Number of pages compressed in parallel before writing */
+const int BATCH_SIZE = 1024;
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+
+/* State for an opened compressed database. Allocated by SQLite with the size given in szOsFile and
+ * followed by the file of the underlying VFS. */
+struct CompressedFile
+{
+  sqlite3_file base; /* Has to be first */
+  sqlite3_file *real;
+  int pageSize;
+  qint64 fileSize;
+  QVector<qint64> offsets;
+
+  /* Last decompressed page since SQLite reads the header of the first page in small pieces */
+  qint64 cachedPage;
+  QByteArray page, block;
+};
+
+sqlite3_vfs *baseVfs(sqlite3_vfs *vfs)
+{
+  return static_cast<sqlite3_vfs *>(vfs->pAppData);
+}
+
+int readRaw(CompressedFile *file, void *buffer, int amount, qint64 offset)
+{
+  return file->real->pMethods->xRead(file->real, buffer, amount, offset);
+}
+
+int loadPage(CompressedFile *file, qint64 pageNum)
+{
+  if(pageNum == file->cachedPage)
+    return SQLITE_OK;
+
+  file->cachedPage = -1;
+  qint64 blockSize = file->offsets.at(static_cast<int>(pageNum) + 1) - file->offsets.at(static_cast<int>(pageNum));
+  qint64 pageSize = std::min(static_cast<qint64>(file->pageSize), file->fileSize - pageNum * file->pageSize);
+  if(blockSize <= 0 || blockSize > pageSize)
+    return SQLITE_CORRUPT;
+
+  file->block.resize(static_cast<int>(blockSize));
+  int result = readRaw(file, file->block.data(), file->block.size(), file->offsets.at(static_cast<int>(pageNum)));
+  if(result != SQLITE_OK)
+    return result == SQLITE_IOERR_SHORT_READ ? SQLITE_CORRUPT : result;
+
+  // Blocks having the page size are not compressed
+  if(blockSize == pageSize)
+    file->page = file->block;
+  else
+  {
+    file->page = qUncompress(file->block);
+    if(file->page.size() != pageSize)
+      return SQLITE_CORRUPT;
+  }
+
+  file->cachedPage = pageNum;
+  return SQLITE_OK;
+}
+
+int compressedClose(sqlite3_file *sqliteFile)
+{
+  CompressedFile *file = reinterpret_cast<CompressedFile *>(sqliteFile);
+  int result = file->real->pMethods->xClose(file->real);
+  file->~CompressedFile();
+  return result;
+}
+
+int compressedRead(sqlite3_file *sqliteFile, void *buffer, int amount, sqlite3_int64 offset)
+{
+  CompressedFile *file = reinterpret_cast<CompressedFile *>(sqliteFile);
+  char *out = static_cast<char *>(buffer);
+
+  while(amount > 0)
+  {
+    if(offset >= file->fileSize)
+    {
+      // SQLite expects the rest to be filled with zeros
+      std::memset(out, 0, static_cast<size_t>(amount));
+      return SQLITE_IOERR_SHORT_READ;
+    }
+
+    qint64 pageNum = offset / file->pageSize;
+    int result = loadPage(file, pageNum);
+    if(result != SQLITE_OK)
+      return result;
+
+    int pos = static_cast<int>(offset - pageNum * file->pageSize);
+    int len = std::min(amount, file->page.size() - pos);
+    std::memcpy(out, file->page.constData() + pos, static_cast<size_t>(len));
+    out += len;
+    offset += len;
+    amount -= len;
+  }
+  return SQLITE_OK;
+}
+
+int compressedWrite(sqlite3_file *, const void *, int, sqlite3_int64)
+{
+  return SQLITE_READONLY;
+}
+
+int compressedTruncate(sqlite3_file *, sqlite3_int64)
+{
+  return SQLITE_READONLY;
+}
+
+int compressedSync(sqlite3_file *, int)
+{
+  return SQLITE_OK;
+}
+
+int compressedFileSize(sqlite3_file *sqliteFile, sqlite3_int64 *size)
+{
+  *size = reinterpret_cast<CompressedFile *>(sqliteFile)->fileSize;
+  return SQLITE_OK;
+}
+
+/* No locking needed since the file cannot be changed */
+int compressedLock(sqlite3_file *, int)
+{
+  return SQLITE_OK;
+}
+
+int compressedCheckReservedLock(sqlite3_file *, int *result)
+{
+  *result = 0;
+  return SQLITE_OK;
+}
+
+int compressedFileControl(sqlite3_file *, int, void *)
+{
+  return SQLITE_NOTFOUND;
+}
+
+int compressedSectorSize(sqlite3_file *)
+{
+  return 4096;
+}
+
+int compressedDeviceCharacteristics(sqlite3_file *)
+{
+  return SQLITE_IOCAP_IMMUTABLE;
+}
+
+/* Version one methods without shared memory for WAL and without memory mapping */
+const sqlite3_io_methods COMPRESSED_METHODS =
+{
+  1,
+  compressedClose,
+  compressedRead,
+  compressedWrite,
+  compressedTruncate,
+  compressedSync,
+  compressedFileSize,
+  compressedLock,
+  compressedLock,
+  compressedCheckReservedLock,
+  compressedFileControl,
+  compressedSectorSize,
+  compressedDeviceCharacteristics,
+  nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+/* Read header and index. Returns false if the file is not compressed. */
+bool readIndex(CompressedFile *file)
+{
+  char header[HEADER_SIZE];
+  if(readRaw(file, header, HEADER_SIZE, 0) != SQLITE_OK || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0)
+    return false;
+
+  const uchar *data = reinterpret_cast<const uchar *>(header) + sizeof(MAGIC);
+  if(qFromBigEndian<quint32>(data) != VERSION)
+    return false;
+
+  file->pageSize = static_cast<int>(qFromBigEndian<quint32>(data + 4));
+  quint32 pageCount = qFromBigEndian<quint32>(data + 8);
+  file->fileSize = static_cast<qint64>(qFromBigEndian<quint64>(data + 16));
+
+  sqlite3_int64 rawSize = 0;
+  uchar footer[8];
+  if(file->real->pMethods->xFileSize(file->real, &rawSize) != SQLITE_OK ||
+     readRaw(file, footer, sizeof(footer), rawSize - static_cast<qint64>(sizeof(footer))) != SQLITE_OK)
+    return false;
+
+  QByteArray index((static_cast<int>(pageCount) + 1) * 8, '\0');
+  if(readRaw(file, index.data(), index.size(), static_cast<qint64>(qFromBigEndian<quint64>(footer))) != SQLITE_OK)
+    return false;
+
+  file->offsets.resize(static_cast<int>(pageCount) + 1);
+  for(int i = 0; i < file->offsets.size(); i++)
+    file->offsets[i] = static_cast<qint64>(qFromBigEndian<quint64>(reinterpret_cast<const uchar *>(index.constData()) +
+                                                                   i * 8));
+  return file->pageSize > 0;
+}
+
+int compressedOpen(sqlite3_vfs *vfs, const char *name, sqlite3_file *sqliteFile, int flags, int *outFlags)
+{
+  sqlite3_vfs *base = baseVfs(vfs);
+
+  // Journals and temporary files are handled by the base VFS in the same memory
+  if(!(flags & SQLITE_OPEN_MAIN_DB))
+    return base->xOpen(base, name, sqliteFile, flags, outFlags);
+
+  CompressedFile *file = new (sqliteFile) CompressedFile;
+  file->base.pMethods = nullptr;
+  file->real = reinterpret_cast<sqlite3_file *>(file + 1);
+  file->cachedPage = -1;
+
+  int realFlags = (flags & ~(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)) | SQLITE_OPEN_READONLY;
+  int result = base->xOpen(base, name, file->real, realFlags, nullptr);
+  if(result != SQLITE_OK)
+  {
+    file->~CompressedFile();
+    return result;
+  }
+
+  if(readIndex(file))
+  {
+    file->base.pMethods = &COMPRESSED_METHODS;
+    if(outFlags != nullptr)
+      *outFlags = realFlags;
+    return SQLITE_OK;
+  }
+
+  // Not compressed - reopen using the base VFS as usual
+  file->real->pMethods->xClose(file->real);
+  file->~CompressedFile();
+  return base->xOpen(base, name, sqliteFile, flags, outFlags);
+}
+
+/* All other functions are passed to the base VFS */
+int compressedDelete(sqlite3_vfs *vfs, const char *name, int syncDir)
+{
+  return baseVfs(vfs)->xDelete(baseVfs(vfs), name, syncDir);
+}
+
+int compressedAccess(sqlite3_vfs *vfs, const char *name, int flags, int *result)
+{
+  return baseVfs(vfs)->xAccess(baseVfs(vfs), name, flags, result);
+}
+
+int compressedFullPathname(sqlite3_vfs *vfs, const char *name, int size, char *out)
+{
+  return baseVfs(vfs)->xFullPathname(baseVfs(vfs), name, size, out);
+}
+
+void *compressedDlOpen(sqlite3_vfs *vfs, const char *filename)
+{
+  return baseVfs(vfs)->xDlOpen(baseVfs(vfs), filename);
+}
+
+void compressedDlError(sqlite3_vfs *vfs, int size, char *message)
+{
+  baseVfs(vfs)->xDlError(baseVfs(vfs), size, message);
+}
+
+typedef void (*SymbolType)(void);
+SymbolType compressedDlSym(sqlite3_vfs *vfs, void *handle, const char *symbol)
+{
+  return baseVfs(vfs)->xDlSym(baseVfs(vfs), handle, symbol);
+}
+
+void compressedDlClose(sqlite3_vfs *vfs, void *handle)
+{
+  baseVfs(vfs)->xDlClose(baseVfs(vfs), handle);
+}
+
+int compressedRandomness(sqlite3_vfs *vfs, int size, char *out)
+{
+  return baseVfs(vfs)->xRandomness(baseVfs(vfs), size, out);
+}
+
+int compressedSleep(sqlite3_vfs *vfs, int microseconds)
+{
+  return baseVfs(vfs)->xSleep(baseVfs(vfs), microseconds);
+}
+
+int compressedCurrentTime(sqlite3_vfs *vfs, double *time)
+{
+  return baseVfs(vfs)->xCurrentTime(baseVfs(vfs), time);
+}
+
+int compressedGetLastError(sqlite3_vfs *vfs, int size, char *message)
+{
+  return baseVfs(vfs)->xGetLastError(baseVfs(vfs), size, message);
+}
+
+int compressedCurrentTimeInt64(sqlite3_vfs *vfs, sqlite3_int64 *time)
+{
+  return baseVfs(vfs)->xCurrentTimeInt64(baseVfs(vfs), time);
+}
+
+bool registerCompressedVfs()
+{
+  sqlite3_vfs *base = sqlite3_vfs_find(nullptr);
+  if(base == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "No default SQLite VFS";
+    return false;
+  }
+
+  static sqlite3_vfs vfs;
+  std::memset(&vfs, 0, sizeof(vfs));
+  vfs.iVersion = base->iVersion >= 2 && base->xCurrentTimeInt64 != nullptr ? 2 : 1;
+  vfs.szOsFile = static_cast<int>(sizeof(CompressedFile)) + base->szOsFile;
+  vfs.mxPathname = base->mxPathname;
+  vfs.zName = SqliteCompressedVfs::VFS_NAME;
+  vfs.pAppData = base;
+  vfs.xOpen = compressedOpen;
+  vfs.xDelete = compressedDelete;
+  vfs.xAccess = compressedAccess;
+  vfs.xFullPathname = compressedFullPathname;
+  vfs.xDlOpen = compressedDlOpen;
+  vfs.xDlError = compressedDlError;
+  vfs.xDlSym = compressedDlSym;
+  vfs.xDlClose = compressedDlClose;
+  vfs.xRandomness = compressedRandomness;
+  vfs.xSleep = compressedSleep;
+  vfs.xCurrentTime = compressedCurrentTime;
+  vfs.xGetLastError = compressedGetLastError;
+  if(vfs.iVersion >= 2)
+    vfs.xCurrentTimeInt64 = compressedCurrentTimeInt64;
+
+  int result = sqlite3_vfs_register(&vfs, 0);
+  if(result != SQLITE_OK)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot register VFS" << sqlite3_errstr(result);
+    return false;
+  }
+  return true;
+}
+
+#endif
+
+} // namespace
+
+void SqliteCompressedVfs::compressDatabase(const QString& filename, const QString& compressedFilename, int level)
+{
+  qInfo() << Q_FUNC_INFO << "Compressing" << filename << "to" << compressedFilename;
+
+  QFileInfo walFile(filename + "-wal");
+  if(walFile.exists() && walFile.size() > 0)
+    throw atools::Exception("Database \"" + filename + "\" has a non empty WAL file");
+
+  QFile in(filename);
+  if(!in.open(QIODevice::ReadOnly))
+    throw atools::Exception("Cannot open \"" + filename + "\": " + in.errorString());
+
+  QByteArray header = in.peek(100);
+  if(header.size() < 100 || !header.startsWith(QByteArray("SQLite format 3\0", 16)))
+    throw atools::Exception("\"" + filename + "\" is not a SQLite database");
+
+  // Page size one means 65536
+  quint32 pageSize = static_cast<quint32>(static_cast<uchar>(header.at(16)) << 8 | static_cast<uchar>(header.at(17)));
+  if(pageSize == 1)
+    pageSize = 65536;
+
+  qint64 fileSize = in.size();
+  quint32 pageCount = static_cast<quint32>((fileSize + pageSize - 1) / pageSize);
+
+  QSaveFile out(compressedFilename);
+  if(!out.open(QIODevice::WriteOnly))
+    throw atools::Exception("Cannot open \"" + compressedFilename + "\": " + out.errorString());
+
+  QDataStream stream(&out);
+  stream.setVersion(QDataStream::Qt_5_5);
+  stream.writeRawData(MAGIC, sizeof(MAGIC));
+  stream << VERSION << pageSize << pageCount << quint32(0) << static_cast<quint64>(fileSize);
+
+  QVector<quint64> offsets;
+  offsets.reserve(static_cast<int>(pageCount) + 1);
+  quint64 offset = HEADER_SIZE;
+  QVector<QByteArray> blocks;
+
+  for(quint32 batchStart = 0; batchStart < pageCount; batchStart += BATCH_SIZE)
+  {
+    int batchSize = static_cast<int>(std::min(pageCount - batchStart, static_cast<quint32>(BATCH_SIZE)));
+    blocks.resize(batchSize);
+    for(int i = 0; i < batchSize; i++)
+    {
+      blocks[i] = in.read(pageSize);
+      if(blocks.at(i).isEmpty())
+        throw atools::Exception("Error reading \"" + filename + "\": " + in.errorString());
+    }
+
+    if(batchStart == 0)
+    {
+      // Set file format to rollback journal since the VFS does not support shared memory for WAL
+      blocks[0][18] = 1;
+      blocks[0][19] = 1;
+    }
+
+    // Compress in place and keep pages uncompressed if they do not get smaller
+    QByteArray *data = blocks.data();
+    atools::util::parallelFor(batchSize, [data, level](int i) {
+      QByteArray compressed = qCompress(data[i], level);
+      if(compressed.size() < data[i].size())
+        data[i] = compressed;
+    }, 16);
+
+    for(const QByteArray& block : blocks)
+    {
+      offsets.append(offset);
+      stream.writeRawData(block.constData(), block.size());
+      offset += static_cast<quint64>(block.size());
+    }
+  }
+  offsets.append(offset);
+
+  for(quint64 pageOffset : offsets)
+    stream << pageOffset;
+  stream << offset;
+
+  if(stream.status() != QDataStream::Ok || !out.commit())
+    throw atools::Exception("Error writing \"" + compressedFilename + "\": " + out.errorString());
+
+  qInfo() << Q_FUNC_INFO << "Compressed" << pageCount << "pages from" << fileSize << "to"
+          << offset + static_cast<quint64>(offsets.size() + 1) * 8 << "bytes";
+}
+
+bool SqliteCompressedVfs::isCompressed(const QString& filename)
+{
+  QFile file(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    return false;
+  return file.read(sizeof(MAGIC)) == QByteArray(MAGIC, sizeof(MAGIC));
+}
+
+bool SqliteCompressedVfs::registerVfs()
+{
+#if defined(ATOOLS_SQLITE_NATIVE)
+  // Initialization of static locals is thread safe
+  static const bool registered = registerCompressedVfs();
+  return registered;
+#else
+  return false;
+#endif
+}
+
+QString SqliteCompressedVfs::uri(const QString& filename)
+{
+  return QUrl::fromLocalFile(QFileInfo(filename).absoluteFilePath()).toString(QUrl::FullyEncoded) +
+         "?vfs=" + VFS_NAME;
+}
+
+} // namespace sql
+} // namespace atools
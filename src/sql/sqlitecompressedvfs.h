@@ -0,0 +1,66 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLITECOMPRESSEDVFS_H
+#define ATOOLS_SQL_SQLITECOMPRESSEDVFS_H
+
+#include <QString>
+
+namespace atools {
+namespace sql {
+
+/*
+ * Read-only container for SQLite database files where each page is compressed separately with zlib.
+ * The container keeps an index of all pages which allows random access to single pages.
+ *
+ * Layout: header with magic, version, page size, page count and uncompressed file size followed by the
+ * compressed pages, the offset index and the offset of the index as last eight bytes.
+ * Pages which do not get smaller are stored uncompressed. All numbers are big endian.
+ *
+ * Compressed files are read through a SQLite VFS which decompresses pages on demand and is registered
+ * with the name VFS_NAME. SqlDatabase detects compressed files and uses the VFS automatically.
+ * Reading needs the native SQLite API, i.e. a build with ATOOLS_SQLITE_NATIVE.
+ * Files which are not compressed are opened by the VFS as usual.
+ */
+class SqliteCompressedVfs
+{
+public:
+  /* Name of the VFS used in the "vfs" URI parameter */
+  static const char *VFS_NAME;
+
+  /* Write a compressed copy of the database file. The database has to be checkpointed if WAL mode is used and
+   * must not be changed while compressing. The copy is set to rollback journal mode since it cannot be written.
+   * Level is the zlib compression level from 0 to 9 or -1 for the default.
+   * Throws atools::Exception on error. */
+  static void compressDatabase(const QString& filename, const QString& compressedFilename, int level = -1);
+
+  /* true if the file exists and is a compressed container */
+  static bool isCompressed(const QString& filename);
+
+  /* Register the VFS once. Thread safe. Returns false if not built with ATOOLS_SQLITE_NATIVE or on error. */
+  static bool registerVfs();
+
+  /* URI for opening the file through the VFS. Needs the connect option QSQLITE_OPEN_URI. */
+  static QString uri(const QString& filename);
+
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLITECOMPRESSEDVFS_H
@@ -0,0 +1,606 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "sql/sqlitestatement.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlexception.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+
+#include <QSqlDriver>
+#include <QSqlRecord>
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+#include <sqlite3.h>
+#endif
+
+namespace atools {
+namespace sql {
+
+SqliteStatement::SqliteStatement(const SqlDatabase *sqlDb)
+{
+#if defined(ATOOLS_SQLITE_NATIVE)
+  if(sqlDb->driverName() == "QSQLITE")
+  {
+    // Get the native handle from the Qt driver
+    QVariant driverHandle = sqlDb->driver()->handle();
+    if(driverHandle.isValid() && qstrcmp(driverHandle.typeName(), "sqlite3*") == 0)
+      handle = *static_cast<sqlite3 **>(driverHandle.data());
+  }
+
+  if(handle != nullptr)
+    return;
+#endif
+
+  // Fall back to Qt query
+  query.reset(new SqlQuery(sqlDb));
+}
+
+SqliteStatement::SqliteStatement(const SqlDatabase& sqlDb)
+  : SqliteStatement(&sqlDb)
+{
+}
+
+SqliteStatement::~SqliteStatement()
+{
+#if defined(ATOOLS_SQLITE_NATIVE)
+  if(stmt != nullptr)
+    sqlite3_finalize(stmt);
+#endif
+}
+
+bool SqliteStatement::isNative() const
+{
+  return query.isNull();
+}
+
+bool SqliteStatement::isNativeCompiled()
+{
+#if defined(ATOOLS_SQLITE_NATIVE)
+  return true;
+
+#else
+  return false;
+
+#endif
+}
+
+void SqliteStatement::prepare(const QString& queryString)
+{
+  queryStr = queryString;
+
+  if(query)
+  {
+    query->setForwardOnly(true);
+    query->prepare(queryString);
+    return;
+  }
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  if(stmt != nullptr)
+  {
+    sqlite3_finalize(stmt);
+    stmt = nullptr;
+  }
+
+  QByteArray utf8 = queryString.toUtf8();
+  checkResult(sqlite3_prepare_v3(handle, utf8.constData(), utf8.size(), SQLITE_PREPARE_PERSISTENT, &stmt, nullptr),
+              "SqliteStatement::prepare()");
+  rowPending = hasRow = done = false;
+#endif
+}
+
+void SqliteStatement::exec(const QString& queryString)
+{
+  prepare(queryString);
+  exec();
+}
+
+void SqliteStatement::exec()
+{
+  if(query)
+  {
+    query->exec();
+    return;
+  }
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  if(stmt == nullptr)
+    throw SqlException("SqliteStatement::exec(): Query not prepared");
+
+  sqlite3_reset(stmt);
+  rowPending = hasRow = done = false;
+
+  int result = sqlite3_step(stmt);
+  if(result == SQLITE_ROW)
+    // Keep for first call of next()
+    rowPending = true;
+  else if(result == SQLITE_DONE)
+  {
+    done = true;
+    changes = sqlite3_changes(handle);
+  }
+  else
+    checkResult(result, "SqliteStatement::exec()");
+#endif
+}
+
+bool SqliteStatement::next()
+{
+  if(query)
+    return query->next();
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  if(rowPending)
+  {
+    rowPending = false;
+    hasRow = true;
+    return true;
+  }
+
+  if(done || stmt == nullptr)
+  {
+    // Do not step again since this would restart the query
+    hasRow = false;
+    return false;
+  }
+
+  int result = sqlite3_step(stmt);
+  if(result == SQLITE_ROW)
+    hasRow = true;
+  else if(result == SQLITE_DONE)
+  {
+    hasRow = false;
+    done = true;
+  }
+  else
+    checkResult(result, "SqliteStatement::next()");
+  return hasRow;
+
+#else
+  return false;
+
+#endif
+}
+
+void SqliteStatement::finish()
+{
+  if(query)
+  {
+    query->finish();
+    return;
+  }
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  if(stmt != nullptr)
+    sqlite3_reset(stmt);
+  rowPending = hasRow = false;
+  done = true;
+#endif
+}
+
+void SqliteStatement::clearBoundValues()
+{
+  if(query)
+  {
+    query->clearBoundValues();
+    return;
+  }
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  if(stmt != nullptr)
+    sqlite3_clear_bindings(stmt);
+#endif
+}
+
+int SqliteStatement::numRowsAffected() const
+{
+  if(query)
+    return query->numRowsAffected();
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  return changes;
+
+#else
+  return 0;
+
+#endif
+}
+
+int SqliteStatement::columnIndex(const QString& name) const
+{
+  int index = -1;
+  if(query)
+    index = query->sqlRecord().indexOf(name);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else if(stmt != nullptr)
+  {
+    QByteArray utf8 = name.toUtf8();
+    for(int i = 0; i < sqlite3_column_count(stmt); i++)
+    {
+      if(qstricmp(sqlite3_column_name(stmt, i), utf8.constData()) == 0)
+      {
+        index = i;
+        break;
+      }
+    }
+  }
+#endif
+
+  if(index == -1)
+    throw SqlException("SqliteStatement::columnIndex(): Value name \"" + name +
+                       "\" does not exist in query \"" + queryStr + "\"");
+  return index;
+}
+
+int SqliteStatement::columnCount() const
+{
+  if(query)
+    return query->sqlRecord().count();
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  return stmt != nullptr ? sqlite3_column_count(stmt) : 0;
+
+#else
+  return 0;
+
+#endif
+}
+
+// Bind by position ==================================================================
+void SqliteStatement::bindNull(int pos)
+{
+  if(query)
+    query->bindValue(pos, QVariant());
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    checkResult(sqlite3_bind_null(stmt, pos + 1), "SqliteStatement::bindNull()");
+#endif
+}
+
+void SqliteStatement::bindInt(int pos, int value)
+{
+  if(query)
+    query->bindValue(pos, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    checkResult(sqlite3_bind_int(stmt, pos + 1, value), "SqliteStatement::bindInt()");
+#endif
+}
+
+void SqliteStatement::bindInt64(int pos, qint64 value)
+{
+  if(query)
+    query->bindValue(pos, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    checkResult(sqlite3_bind_int64(stmt, pos + 1, value), "SqliteStatement::bindInt64()");
+#endif
+}
+
+void SqliteStatement::bindDouble(int pos, double value)
+{
+  if(query)
+    query->bindValue(pos, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    checkResult(sqlite3_bind_double(stmt, pos + 1, value), "SqliteStatement::bindDouble()");
+#endif
+}
+
+void SqliteStatement::bindStr(int pos, const QString& value)
+{
+  if(query)
+    query->bindValue(pos, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else if(value.isNull())
+    bindNull(pos);
+  else
+  {
+    QByteArray utf8 = value.toUtf8();
+    checkResult(sqlite3_bind_text(stmt, pos + 1, utf8.constData(), utf8.size(), SQLITE_TRANSIENT),
+                "SqliteStatement::bindStr()");
+  }
+#endif
+}
+
+void SqliteStatement::bindBytes(int pos, const QByteArray& value)
+{
+  if(query)
+    query->bindValue(pos, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else if(value.isNull())
+    bindNull(pos);
+  else
+    checkResult(sqlite3_bind_blob(stmt, pos + 1, value.constData(), value.size(), SQLITE_TRANSIENT),
+                "SqliteStatement::bindBytes()");
+#endif
+}
+
+void SqliteStatement::bindValue(int pos, const QVariant& value)
+{
+  if(query)
+  {
+    query->bindValue(pos, value);
+    return;
+  }
+
+  if(value.isNull())
+    bindNull(pos);
+  else
+  {
+    switch(value.type())
+    {
+      case QVariant::Bool:
+      case QVariant::Int:
+      case QVariant::UInt:
+        bindInt(pos, value.toInt());
+        break;
+
+      case QVariant::LongLong:
+      case QVariant::ULongLong:
+        bindInt64(pos, value.toLongLong());
+        break;
+
+      case QVariant::Double:
+        bindDouble(pos, value.toDouble());
+        break;
+
+      case QVariant::ByteArray:
+        bindBytes(pos, value.toByteArray());
+        break;
+
+      default:
+        if(static_cast<QMetaType::Type>(value.type()) == QMetaType::Float)
+          bindDouble(pos, value.toDouble());
+        else
+          bindStr(pos, value.toString());
+        break;
+    }
+  }
+}
+
+// Bind by name ==================================================================
+void SqliteStatement::bindNull(const QString& placeholder)
+{
+  if(query)
+    query->bindValue(placeholder, QVariant());
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    bindNull(paramIndex(placeholder));
+#endif
+}
+
+void SqliteStatement::bindInt(const QString& placeholder, int value)
+{
+  if(query)
+    query->bindValue(placeholder, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    bindInt(paramIndex(placeholder), value);
+#endif
+}
+
+void SqliteStatement::bindInt64(const QString& placeholder, qint64 value)
+{
+  if(query)
+    query->bindValue(placeholder, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    bindInt64(paramIndex(placeholder), value);
+#endif
+}
+
+void SqliteStatement::bindDouble(const QString& placeholder, double value)
+{
+  if(query)
+    query->bindValue(placeholder, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    bindDouble(paramIndex(placeholder), value);
+#endif
+}
+
+void SqliteStatement::bindStr(const QString& placeholder, const QString& value)
+{
+  if(query)
+    query->bindValue(placeholder, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    bindStr(paramIndex(placeholder), value);
+#endif
+}
+
+void SqliteStatement::bindBytes(const QString& placeholder, const QByteArray& value)
+{
+  if(query)
+    query->bindValue(placeholder, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    bindBytes(paramIndex(placeholder), value);
+#endif
+}
+
+void SqliteStatement::bindValue(const QString& placeholder, const QVariant& value)
+{
+  if(query)
+    query->bindValue(placeholder, value);
+#if defined(ATOOLS_SQLITE_NATIVE)
+  else
+    bindValue(paramIndex(placeholder), value);
+#endif
+}
+
+// Getters ==================================================================
+bool SqliteStatement::isNull(int col) const
+{
+  if(query)
+    return query->isNull(col);
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  checkRow(col);
+  return sqlite3_column_type(stmt, col) == SQLITE_NULL;
+
+#else
+  return true;
+
+#endif
+}
+
+int SqliteStatement::valueInt(int col) const
+{
+  if(query)
+    return query->valueInt(col);
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  checkRow(col);
+  return sqlite3_column_int(stmt, col);
+
+#else
+  return 0;
+
+#endif
+}
+
+qint64 SqliteStatement::valueInt64(int col) const
+{
+  if(query)
+    return query->value(col).toLongLong();
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  checkRow(col);
+  return sqlite3_column_int64(stmt, col);
+
+#else
+  return 0L;
+
+#endif
+}
+
+double SqliteStatement::valueDouble(int col) const
+{
+  if(query)
+    return query->valueDouble(col);
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  checkRow(col);
+  return sqlite3_column_double(stmt, col);
+
+#else
+  return 0.;
+
+#endif
+}
+
+QString SqliteStatement::valueStr(int col) const
+{
+  if(query)
+    return query->valueStr(col);
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  checkRow(col);
+  const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, col));
+  return text != nullptr ? QString::fromUtf8(text, sqlite3_column_bytes(stmt, col)) : QString();
+
+#else
+  return QString();
+
+#endif
+}
+
+QByteArray SqliteStatement::valueBytes(int col) const
+{
+  if(query)
+    return query->value(col).toByteArray();
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  checkRow(col);
+  const char *blob = static_cast<const char *>(sqlite3_column_blob(stmt, col));
+  return blob != nullptr ? QByteArray(blob, sqlite3_column_bytes(stmt, col)) : QByteArray();
+
+#else
+  return QByteArray();
+
+#endif
+}
+
+QVariant SqliteStatement::value(int col) const
+{
+  if(query)
+    return query->value(col);
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  checkRow(col);
+  switch(sqlite3_column_type(stmt, col))
+  {
+    case SQLITE_INTEGER:
+      return static_cast<qlonglong>(sqlite3_column_int64(stmt, col));
+
+    case SQLITE_FLOAT:
+      return sqlite3_column_double(stmt, col);
+
+    case SQLITE_BLOB:
+      return valueBytes(col);
+
+    case SQLITE_NULL:
+      // Same as Qt driver
+      return QVariant(QVariant::String);
+  }
+  return valueStr(col);
+
+#else
+  return QVariant();
+
+#endif
+}
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+int SqliteStatement::paramIndex(const QString& placeholder) const
+{
+  if(stmt == nullptr)
+    throw SqlException("SqliteStatement: Query not prepared");
+
+  int index = sqlite3_bind_parameter_index(stmt, placeholder.toUtf8().constData());
+  if(index == 0)
+    throw SqlException("SqliteStatement: Placeholder \"" + placeholder +
+                       "\" does not exist in query \"" + queryStr + "\"");
+
+  // Convert to zero based index
+  return index - 1;
+}
+
+void SqliteStatement::checkResult(int result, const QString& msg) const
+{
+  if(result != SQLITE_OK)
+    throw SqlException(msg + ": " + QString::fromUtf8(sqlite3_errmsg(handle)), "Query is \"" + queryStr + "\"");
+}
+
+void SqliteStatement::checkRow(int col) const
+{
+  if(!hasRow)
+    throw SqlException("SqliteStatement: No current row in query \"" + queryStr + "\"");
+
+  if(col < 0 || col >= sqlite3_column_count(stmt))
+    throw SqlException("SqliteStatement: Column " + QString::number(col) +
+                       " does not exist in query \"" + queryStr + "\"");
+}
+
+#endif
+
+} // namespace sql
+} // namespace atools
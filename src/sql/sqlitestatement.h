@@ -0,0 +1,179 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SQL_SQLITESTATEMENT_H
+#define ATOOLS_SQL_SQLITESTATEMENT_H
+
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QString>
+#include <QVariant>
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+struct sqlite3;
+struct sqlite3_stmt;
+#endif
+
+namespace atools {
+namespace sql {
+
+class SqlDatabase;
+class SqlQuery;
+
+/*
+ * Prepared statement for bulk reading and writing of SQLite databases on the connection of a SqlDatabase.
+ * Has the same surface as SqlQuery for prepare, bind, exec, next and value access and adds typed accessors
+ * and typed bind methods which avoid QVariant conversions.
+ *
+ * If the library is built with ATOOLS_SQLITE_NATIVE and the database uses the QSQLITE driver the statement
+ * uses the native sqlite3 API on the driver handle. Otherwise it falls back to a SqlQuery.
+ * The native path needs the same SQLite library as the Qt driver, i.e. Qt built with "-system-sqlite".
+ *
+ * Bind positions are zero based like in SqlQuery. Named placeholders use the ":name" syntax.
+ * Errors throw SqlException. Not thread safe.
+ */
+class SqliteStatement
+{
+public:
+  explicit SqliteStatement(const atools::sql::SqlDatabase *sqlDb);
+  explicit SqliteStatement(const atools::sql::SqlDatabase& sqlDb);
+  ~SqliteStatement();
+
+  SqliteStatement(const SqliteStatement& other) = delete;
+  SqliteStatement& operator=(const SqliteStatement& other) = delete;
+
+  /* true if the native path is used for this statement */
+  bool isNative() const;
+
+  /* true if library is built with native SQLite support */
+  static bool isNativeCompiled();
+
+  void prepare(const QString& queryString);
+
+  /* Prepare and execute the query. */
+  void exec(const QString& queryString);
+
+  /* Execute prepared query. Bound values are kept. */
+  void exec();
+
+  /* Move to next result row. Returns false if no more rows are available. */
+  bool next();
+
+  /* Reset statement and release locks. Bound values are kept. */
+  void finish();
+
+  /* Set all bound values to null */
+  void clearBoundValues();
+
+  int numRowsAffected() const;
+
+  /* Get zero based column index for name. Throws exception if not found. */
+  int columnIndex(const QString& name) const;
+  int columnCount() const;
+
+  /* Typed bind methods using zero based position */
+  void bindNull(int pos);
+  void bindInt(int pos, int value);
+  void bindInt64(int pos, qint64 value);
+  void bindDouble(int pos, double value);
+  void bindStr(int pos, const QString& value);
+  void bindBytes(int pos, const QByteArray& value);
+  void bindValue(int pos, const QVariant& value);
+
+  /* Typed bind methods using named placeholders like ":ident" */
+  void bindNull(const QString& placeholder);
+  void bindInt(const QString& placeholder, int value);
+  void bindInt64(const QString& placeholder, qint64 value);
+  void bindDouble(const QString& placeholder, double value);
+  void bindStr(const QString& placeholder, const QString& value);
+  void bindBytes(const QString& placeholder, const QByteArray& value);
+  void bindValue(const QString& placeholder, const QVariant& value);
+
+  /* Typed getters for the current row which do not create a QVariant on the native path */
+  bool isNull(int col) const;
+  int valueInt(int col) const;
+  qint64 valueInt64(int col) const;
+  double valueDouble(int col) const;
+  QString valueStr(int col) const;
+  QByteArray valueBytes(int col) const;
+  QVariant value(int col) const;
+
+  float valueFloat(int col) const
+  {
+    return static_cast<float>(valueDouble(col));
+  }
+
+  bool valueBool(int col) const
+  {
+    return valueInt(col) != 0;
+  }
+
+  /* Getters by name. Slower since the column index has to be looked up. */
+  int valueInt(const QString& name) const
+  {
+    return valueInt(columnIndex(name));
+  }
+
+  double valueDouble(const QString& name) const
+  {
+    return valueDouble(columnIndex(name));
+  }
+
+  float valueFloat(const QString& name) const
+  {
+    return valueFloat(columnIndex(name));
+  }
+
+  QString valueStr(const QString& name) const
+  {
+    return valueStr(columnIndex(name));
+  }
+
+  QVariant value(const QString& name) const
+  {
+    return value(columnIndex(name));
+  }
+
+  const QString& getQueryString() const
+  {
+    return queryStr;
+  }
+
+private:
+  QString queryStr;
+
+  /* Fallback if native is not available */
+  QScopedPointer<atools::sql::SqlQuery> query;
+
+#if defined(ATOOLS_SQLITE_NATIVE)
+  int paramIndex(const QString& placeholder) const;
+  void checkResult(int result, const QString& msg) const;
+  void checkRow(int col) const;
+
+  sqlite3 *handle = nullptr;
+  sqlite3_stmt *stmt = nullptr;
+
+  /* Row from exec() which is not consumed by next() yet */
+  bool rowPending = false, hasRow = false, done = false;
+  int changes = 0;
+#endif
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLITESTATEMENT_H
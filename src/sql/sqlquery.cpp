@@ -18,9 +18,12 @@
 #include "sql/sqlquery.h"
 #include "sql/sqlexception.h"
 #include "sql/sqldatabase.h"
+#include "sql/sqlquerystats.h"
 
 #include "sql/sqlrecord.h"
+#include "util/trace.h"
 
+#include <QElapsedTimer>
 #include <QSqlError>
 
 namespace atools {
@@ -79,6 +82,7 @@ SqlQuery::SqlQuery(const QSqlQuery& otherQuery, QString queryStr)
 
 SqlQuery& SqlQuery::operator=(const SqlQuery& other)
 {
+  flushRowStats();
   this->query = other.query;
   this->queryString = other.queryString;
 
@@ -90,6 +94,7 @@ SqlQuery& SqlQuery::operator=(const SqlQuery& other)
 
 SqlQuery::~SqlQuery()
 {
+  flushRowStats();
   delete db;
 }
 
@@ -196,9 +201,21 @@ void SqlQuery::setForwardOnly(bool forward)
 
 void SqlQuery::exec(const QString& queryStr)
 {
+  ATOOLS_TRACE_SCOPE("SqlQuery::exec", "sql");
+
+  flushRowStats();
   this->queryString = queryStr;
+
+  QElapsedTimer timer;
+  bool stats = SqlQueryStats::isEnabled();
+  if(stats)
+    timer.start();
+
   checkError(query.exec(queryStr), "SqlQuery::exec(): Error executing query");
 
+  if(stats)
+    SqlQueryStats::recordExec(queryString, timer.nsecsElapsed(), db->getQSqlDatabase());
+
   if(db->isAutocommit())
     db->commit();
 }
@@ -253,7 +270,11 @@ bool SqlQuery::next()
 {
   checkError(isSelect(), "SqlQuery::next() on query which is not a select");
   checkError(isActive(), "SqlQuery::next() on inactive query");
-  return query.next();
+  bool retval = query.next();
+
+  if(retval && SqlQueryStats::isEnabled())
+    numRowsRead++;
+  return retval;
 }
 
 bool SqlQuery::previous()
@@ -296,15 +317,37 @@ void SqlQuery::clearBoundValues()
 
 void SqlQuery::exec()
 {
+  ATOOLS_TRACE_SCOPE("SqlQuery::exec", "sql");
+
+  flushRowStats();
+
+  QElapsedTimer timer;
+  bool stats = SqlQueryStats::isEnabled();
+  if(stats)
+    timer.start();
+
   checkError(query.exec(), "SqlQuery::exec(): Error executing query");
+
+  if(stats)
+    SqlQueryStats::recordExec(queryString, timer.nsecsElapsed(), db->getQSqlDatabase());
   if(db->isAutocommit())
     db->commit();
 }
 
 void SqlQuery::execBatch(QSqlQuery::BatchExecutionMode mode)
 {
+  flushRowStats();
+
+  QElapsedTimer timer;
+  bool stats = SqlQueryStats::isEnabled();
+  if(stats)
+    timer.start();
+
   checkError(query.execBatch(mode), "SqlQuery::execBatch(): Error executing query batch");
 
+  if(stats)
+    SqlQueryStats::recordExec(queryString, timer.nsecsElapsed(), db->getQSqlDatabase());
+
   if(db->isAutocommit())
     db->commit();
 }
@@ -388,12 +431,77 @@ void SqlQuery::bindRecord(const SqlRecord& record)
 
 void SqlQuery::bindAndExecRecords(const SqlRecordVector& records)
 {
-  for(const SqlRecord& record:records)
+  if(records.isEmpty())
+    return;
+
+  const SqlRecord& first = records.first();
+  int numCols = first.count(), numRecords = records.size();
+  QStringList names = first.fieldNames();
+
+  // Check if all records have the same layout - remaining ones are usually built by the same code
+  bool sameLayout = numRecords > 1;
+  for(int i = 1; i < numRecords && sameLayout; i++)
+  {
+    const SqlRecord& record = records.at(i);
+    if(record.count() != numCols)
+      sameLayout = false;
+    else
+    {
+      for(int col = 0; col < numCols && sameLayout; col++)
+        sameLayout = record.fieldName(col) == names.at(col);
+    }
+  }
+
+  if(!sameLayout)
   {
-    bindRecord(record);
-    exec();
-    clearBoundValues();
+    for(const SqlRecord& record : records)
+    {
+      bindRecord(record);
+      exec();
+      clearBoundValues();
+    }
+    return;
+  }
+
+  // Transpose records into one value list per column
+  QVector<QVariantList> columns(numCols);
+  for(QVariantList& column : columns)
+    column.reserve(numRecords);
+
+  for(const SqlRecord& record : records)
+  {
+    for(int col = 0; col < numCols; col++)
+      columns[col].append(record.value(col));
   }
+
+  // Batch execution needs a list for each placeholder
+  QMap<QString, QVariant> bound = boundValues();
+  for(const QString& name : names)
+  {
+    if(!bound.contains(name))
+      throw SqlException("SqlQuery::bindAndExecRecords(): Bind name \"" + name + "\" does not exist in query \"" +
+                         queryString + "\"");
+  }
+  for(auto it = bound.constBegin(); it != bound.constEnd(); ++it)
+  {
+    int col = names.indexOf(it.key());
+    if(col == -1)
+    {
+      QVariantList nullValues;
+      nullValues.reserve(numRecords);
+      for(int i = 0; i < numRecords; i++)
+        nullValues.append(QVariant(it.value().type()));
+      query.bindValue(it.key(), nullValues);
+    }
+    else
+      query.bindValue(it.key(), columns.at(col));
+  }
+
+  execBatch();
+
+  // Reset lists to null values of original type
+  for(auto it = bound.constBegin(); it != bound.constEnd(); ++it)
+    query.bindValue(it.key(), QVariant(it.value().type()));
 }
 
 void SqlQuery::bindAndExecRecord(const SqlRecord& record)
@@ -441,9 +549,19 @@ QVariant SqlQuery::lastInsertId() const
 
 void SqlQuery::finish()
 {
+  flushRowStats();
   query.finish();
 }
 
+void SqlQuery::flushRowStats()
+{
+  if(numRowsRead > 0)
+  {
+    SqlQueryStats::recordRows(queryString, numRowsRead);
+    numRowsRead = 0;
+  }
+}
+
 bool SqlQuery::nextResult()
 {
   return query.nextResult();
@@ -203,6 +203,9 @@ public:
 
   void bindRecord(const atools::sql::SqlRecord& record);
 
+  /* Bind and execute all records. Records having the same columns in the same order are transposed into
+   * one value list per placeholder and executed as batch. Placeholders not set by the records are null.
+   * Falls back to binding record by record if the layout differs. Does not commit. */
   void bindAndExecRecords(const atools::sql::SqlRecordVector& records);
   void bindAndExecRecord(const SqlRecord& record);
 
@@ -235,9 +238,15 @@ private:
 
   void checkError(bool retval = true, const QString& msg = QString()) const;
 
+  /* Pass number of rows read to statistics if enabled */
+  void flushRowStats();
+
   QSqlQuery query;
   QString queryString;
   SqlDatabase *db = nullptr;
+
+  /* Rows read since last execution. Only counted if SqlQueryStats is enabled. */
+  int numRowsRead = 0;
   QString boundValuesAsString() const;
 
 };
@@ -0,0 +1,184 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlquerystats.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QVector>
+
+#include <algorithm>
+
+namespace atools {
+namespace sql {
+
+std::atomic_bool SqlQueryStats::enabled(false);
+
+namespace {
+
+struct QueryStat
+{
+  qint64 count = 0, totalNs = 0, maxNs = 0, rows = 0;
+};
+
+/* Collected statistics and settings. Protected by mutex. */
+QMutex statsMutex;
+QHash<QString, QueryStat> queryStats;
+
+/* Slow queries already logged with query plan */
+QSet<QString> explainedQueries;
+qint64 slowThresholdNs = 100LL * 1000000LL;
+int summarySize = 50;
+bool postRoutineAdded = false;
+
+void logSummaryAtExit()
+{
+  SqlQueryStats::logSummary();
+}
+
+} // namespace
+
+void SqlQueryStats::setEnabled(bool value)
+{
+  enabled.store(value);
+
+  QMutexLocker locker(&statsMutex);
+  if(value && !postRoutineAdded && QCoreApplication::instance() != nullptr)
+  {
+    qAddPostRoutine(logSummaryAtExit);
+    postRoutineAdded = true;
+  }
+}
+
+void SqlQueryStats::setSlowThresholdMs(int value)
+{
+  QMutexLocker locker(&statsMutex);
+  slowThresholdNs = static_cast<qint64>(value) * 1000000LL;
+}
+
+void SqlQueryStats::setSummarySize(int value)
+{
+  QMutexLocker locker(&statsMutex);
+  summarySize = value;
+}
+
+void SqlQueryStats::recordExec(const QString& queryStr, qint64 nanoseconds, const QSqlDatabase& db)
+{
+  bool explain = false;
+  {
+    QMutexLocker locker(&statsMutex);
+    QueryStat& stat = queryStats[queryStr];
+    stat.count++;
+    stat.totalNs += nanoseconds;
+    stat.maxNs = std::max(stat.maxNs, nanoseconds);
+
+    if(nanoseconds > slowThresholdNs && !explainedQueries.contains(queryStr))
+    {
+      explainedQueries.insert(queryStr);
+      explain = true;
+    }
+  }
+
+  if(explain)
+    // Explain outside of lock - executes another query
+    qWarning().noquote().nospace() << "Slow query " << (nanoseconds / 1000000LL) << " ms: \"" << queryStr
+                                   << "\"\n" << explainQueryPlan(queryStr, db);
+}
+
+void SqlQueryStats::recordRows(const QString& queryStr, int rows)
+{
+  QMutexLocker locker(&statsMutex);
+  queryStats[queryStr].rows += rows;
+}
+
+void SqlQueryStats::logSummary()
+{
+  QVector<std::pair<QString, QueryStat> > stats;
+  {
+    QMutexLocker locker(&statsMutex);
+    for(auto it = queryStats.constBegin(); it != queryStats.constEnd(); ++it)
+      stats.append(std::make_pair(it.key(), it.value()));
+  }
+
+  if(stats.isEmpty())
+    return;
+
+  // Most expensive first
+  std::sort(stats.begin(), stats.end(), [](const std::pair<QString, QueryStat>& s1,
+                                           const std::pair<QString, QueryStat>& s2) -> bool {
+    return s1.second.totalNs > s2.second.totalNs;
+  });
+
+  int size = std::min(stats.size(), summarySize);
+  qInfo().noquote().nospace() << "SQL query statistics for " << stats.size() << " queries. Top " << size
+                              << " by total time. count; total ms; average ms; max ms; rows; query";
+  for(int i = 0; i < size; i++)
+  {
+    const QueryStat& stat = stats.at(i).second;
+    qInfo().noquote().nospace() << stat.count << "; "
+                                << QString::number(stat.totalNs / 1000000., 'f', 2) << "; "
+                                << QString::number(stat.totalNs / 1000000. / std::max(stat.count, 1LL), 'f', 3) << "; "
+                                << QString::number(stat.maxNs / 1000000., 'f', 2) << "; "
+                                << stat.rows << "; "
+                                << QString(stats.at(i).first).replace('\n', ' ');
+  }
+}
+
+void SqlQueryStats::clear()
+{
+  QMutexLocker locker(&statsMutex);
+  queryStats.clear();
+  explainedQueries.clear();
+}
+
+QString SqlQueryStats::explainQueryPlan(const QString& queryStr, const QSqlDatabase& db)
+{
+  if(!db.isOpen() || db.driverName() != "QSQLITE")
+    return QString();
+
+  QString trimmed = queryStr.trimmed();
+  if(!trimmed.startsWith("select", Qt::CaseInsensitive) && !trimmed.startsWith("with", Qt::CaseInsensitive) &&
+     !trimmed.startsWith("update", Qt::CaseInsensitive) && !trimmed.startsWith("delete", Qt::CaseInsensitive) &&
+     !trimmed.startsWith("insert", Qt::CaseInsensitive))
+    return QString();
+
+  // Not instrumented since it does not use SqlQuery. Unbound parameters are null.
+  QSqlQuery query(db);
+  query.setForwardOnly(true);
+  QString retval;
+  if(query.prepare("explain query plan " + trimmed) && query.exec())
+  {
+    // Columns are id, parent, notused and detail
+    int detailIndex = query.record().indexOf("detail");
+    while(query.next())
+      retval += "  " + query.value(detailIndex >= 0 ? detailIndex : query.record().count() - 1).toString() + "\n";
+  }
+  else
+    retval = "  Cannot explain: " + query.lastError().text();
+  return retval;
+}
+
+} // namespace sql
+} // namespace atools
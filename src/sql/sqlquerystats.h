@@ -0,0 +1,80 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLQUERYSTATS_H
+#define ATOOLS_SQL_SQLQUERYSTATS_H
+
+#include <QString>
+
+#include <atomic>
+
+class QSqlDatabase;
+
+namespace atools {
+namespace sql {
+
+/*
+ * Opt-in execution statistics for SqlQuery collected per query string.
+ * Records number of executions, total and maximum execution time and number of rows read.
+ *
+ * Queries exceeding the slow query threshold are logged once together with the output of
+ * "EXPLAIN QUERY PLAN" for SQLite databases. This helps to find missing indexes.
+ * A summary is logged when the application shuts down or when calling logSummary().
+ *
+ * All methods are thread safe. Statistics cost nothing but a flag check if disabled.
+ */
+class SqlQueryStats
+{
+public:
+  /* Enable or disable collection. Registers summary logging at application shutdown on first enable. */
+  static void setEnabled(bool value = true);
+
+  static bool isEnabled()
+  {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /* Log query and query plan if a single execution takes longer. Default is 100 ms. */
+  static void setSlowThresholdMs(int value);
+
+  /* Number of queries printed by logSummary() sorted by total time descending. Default is 50. */
+  static void setSummarySize(int value);
+
+  /* Record execution of a query. Called by SqlQuery. db is used to explain slow queries. */
+  static void recordExec(const QString& queryStr, qint64 nanoseconds, const QSqlDatabase& db);
+
+  /* Record rows read from a query. Called by SqlQuery. */
+  static void recordRows(const QString& queryStr, int rows);
+
+  /* Log all collected statistics */
+  static void logSummary();
+
+  /* Remove all collected statistics */
+  static void clear();
+
+private:
+  /* Run "explain query plan" and return readable result */
+  static QString explainQueryPlan(const QString& queryStr, const QSqlDatabase& db);
+
+  static std::atomic_bool enabled;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLQUERYSTATS_H
@@ -17,18 +17,38 @@
 
 #include "sql/sqlscript.h"
 
+#include "sql/sqldatabase.h"
 #include "sql/sqlexception.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
 
 #include <QDebug>
 #include <QFile>
+#include <QRegularExpression>
 #include <QTextStream>
 
 namespace atools {
 
 namespace sql {
 
+namespace {
+
+/* Returns name of index if statement is a non-unique "create index". Unique indexes are not deferred
+ * since they act as constraints while loading. */
+QString indexName(const QString& sql)
+{
+  static const QRegularExpression CREATE_INDEX("^\\s*create\\s+index\\s+(if\\s+not\\s+exists\\s+)?(\\w+)",
+                                               QRegularExpression::CaseInsensitiveOption);
+
+  QRegularExpressionMatch match = CREATE_INDEX.match(sql);
+  return match.hasMatch() ? match.captured(2) : QString();
+}
+
+} // namespace
+
+QHash<QString, QList<SqlScript::ScriptCmd> > SqlScript::scriptCache;
+QMutex SqlScript::cacheMutex;
+
 SqlScript::SqlScript(SqlDatabase *sqlDb, bool verboseLogging)
   : db(sqlDb), verbose(verboseLogging)
 {
@@ -42,6 +62,33 @@ SqlScript::SqlScript(SqlDatabase& sqlDb, bool verboseLogging)
 
 void SqlScript::executeScript(const QString& filename)
 {
+  bool resource = filename.startsWith(':');
+  if(resource)
+  {
+    QList<ScriptCmd> statements;
+    bool found = false;
+    {
+      QMutexLocker locker(&cacheMutex);
+      auto it = scriptCache.constFind(filename);
+      if(it != scriptCache.constEnd())
+      {
+        statements = it.value();
+        found = true;
+      }
+    }
+
+    if(found)
+    {
+      if(verbose)
+      {
+        qDebug() << "-- Running cached script ------------------------------------------";
+        qDebug() << "--" << filename << "--";
+      }
+      executeStatements(statements);
+      return;
+    }
+  }
+
   QFile scriptFile(filename);
   if(scriptFile.open(QIODevice::Text | QIODevice::ReadOnly))
   {
@@ -52,7 +99,16 @@ void SqlScript::executeScript(const QString& filename)
       qDebug() << "-- Running script ------------------------------------------";
       qDebug() << "--" << scriptFile.fileName() << "--";
     }
-    executeScript(scriptStream);
+
+    QList<ScriptCmd> statements;
+    parseSqlScript(scriptStream, statements);
+
+    if(resource)
+    {
+      QMutexLocker locker(&cacheMutex);
+      scriptCache.insert(filename, statements);
+    }
+    executeStatements(statements);
   }
   else
     throw SqlException(
@@ -65,10 +121,30 @@ void SqlScript::executeScript(QTextStream& script)
 {
   QList<ScriptCmd> statements;
   parseSqlScript(script, statements);
+  executeStatements(statements);
+}
+
+void SqlScript::clearCache()
+{
+  QMutexLocker locker(&cacheMutex);
+  scriptCache.clear();
+}
 
+void SqlScript::executeStatements(const QList<ScriptCmd>& statements)
+{
+  // Result sets of selects are only read once
   SqlQuery query(db);
-  for(ScriptCmd cmd : statements)
+  query.setForwardOnly(true);
+  for(const ScriptCmd& cmd : statements)
   {
+    if(deferIndexes && isDeferredIndex(cmd))
+    {
+      if(verbose)
+        qDebug().nospace() << cmd.lineNumber << ": deferred " << QString(cmd.sql).replace('\n', ' ');
+      deferredStatements.append(cmd.sql);
+      continue;
+    }
+
     if(verbose)
       qDebug().nospace() << cmd.lineNumber << ": " << QString(cmd.sql).replace('\n', ' ');
     query.exec(cmd.sql);
@@ -114,10 +190,18 @@ void SqlScript::executeScript(QTextStream& script)
   }
   query.finish();
 
+  // Scripts usually create or drop tables - remove prepared statements which might refer to old tables
+  db->clearQueryCache();
+
   if(verbose)
     qDebug() << "-- Done Running script ------------------------------------------";
 }
 
+bool SqlScript::isDeferredIndex(const ScriptCmd& cmd) const
+{
+  return !cmd.indexName.isEmpty() && !keepIndexes.contains(cmd.indexName, Qt::CaseInsensitive);
+}
+
 void SqlScript::parseSqlScript(QTextStream& script, QList<ScriptCmd>& statements)
 {
   QString line;
@@ -201,7 +285,7 @@ void SqlScript::parseSqlScript(QTextStream& script, QList<ScriptCmd>& statements
           if(!isBlockComment)
           {
             // End of statement - reset all values
-            statements.append(ScriptCmd({currentStatement, currentLine}));
+            statements.append(ScriptCmd({currentStatement, currentLine, indexName(currentStatement)}));
             currentStatement.clear();
             isSingleString = false;
             isDoubleString = false;
@@ -18,7 +18,9 @@
 #ifndef ATOOLS_SQL_SQLSCRIPT_H
 #define ATOOLS_SQL_SQLSCRIPT_H
 
-#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
 
 class QTextStream;
 
@@ -37,6 +39,9 @@ class SqlDatabase;
  * is thrown in case of error.
  *
  * Complex SQL as Oracle PL/SQL is not supported.
+ *
+ * Parsed statements of Qt resource scripts (path starting with ":") are cached for the lifetime of the process
+ * since resources cannot change. Statements run in the transaction of the database and are not committed.
  */
 class SqlScript
 {
@@ -47,24 +52,58 @@ public:
   SqlScript(atools::sql::SqlDatabase *sqlDb, bool verboseLogging = true);
   SqlScript(atools::sql::SqlDatabase& sqlDb, bool verboseLogging = true);
 
-  /* Run a script provided in the given filename */
+  /* Run a script provided in the given filename. Uses cached statements for resource files. */
   void executeScript(const QString& filename);
 
   /* Read script from stream and execute it */
   void executeScript(QTextStream& script);
 
+  /*
+   * If true non-unique "create index" statements are not executed but collected for later execution.
+   * Indexes having a name in keepIndexNames are still created immediately.
+   * Collected statements are kept across calls to executeScript().
+   */
+  void setDeferIndexes(bool value, const QStringList& keepIndexNames = QStringList())
+  {
+    deferIndexes = value;
+    keepIndexes = keepIndexNames;
+  }
+
+  /* Get all "create index" statements deferred by setDeferIndexes() in script order */
+  const QStringList& getDeferredStatements() const
+  {
+    return deferredStatements;
+  }
+
+  /* Remove all parsed resource scripts from the cache */
+  static void clearCache();
+
 private:
   struct ScriptCmd
   {
     QString sql;
     int lineNumber;
+
+    /* Name of index if this is a non-unique "create index" statement. Otherwise empty. */
+    QString indexName;
   };
 
+  /* Run all parsed statements using one forward only query */
+  void executeStatements(const QList<ScriptCmd>& statements);
+
   /* Extract line number / SQL statement pairs from the script */
-  void parseSqlScript(QTextStream& script, QList<ScriptCmd>& statements);
+  static void parseSqlScript(QTextStream& script, QList<ScriptCmd>& statements);
+
+  /* true if statement is a deferrable "create index" */
+  bool isDeferredIndex(const ScriptCmd& cmd) const;
+
+  /* Parsed statements of resource scripts by filename */
+  static QHash<QString, QList<ScriptCmd> > scriptCache;
+  static QMutex cacheMutex;
 
   SqlDatabase *db;
-  bool verbose = true;
+  bool verbose = true, deferIndexes = false;
+  QStringList keepIndexes, deferredStatements;
 };
 
 } // namespace sql
@@ -0,0 +1,100 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlspatialindex.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+#include "geo/rect.h"
+
+#include <algorithm>
+
+namespace atools {
+namespace sql {
+
+SqlSpatialIndex::SqlSpatialIndex(SqlDatabase *sqlDb, const QString& tablename)
+  : db(sqlDb), table(tablename)
+{
+  available = hasIndex(db, table);
+}
+
+SqlSpatialIndex::~SqlSpatialIndex()
+{
+  delete query;
+}
+
+bool SqlSpatialIndex::hasIndex(SqlDatabase *sqlDb, const QString& tablename)
+{
+  return SqlUtil(sqlDb).hasTable(rtreeTableName(tablename));
+}
+
+QString SqlSpatialIndex::selectStatement(const QString& tablename)
+{
+  return "select id from " + rtreeTableName(tablename) +
+         " where max_lonx >= :rtree_west and min_lonx <= :rtree_east and "
+         "max_laty >= :rtree_south and min_laty <= :rtree_north";
+}
+
+QString SqlSpatialIndex::whereClause(const QString& tablename, const QString& idColumn)
+{
+  return idColumn + " in (" + selectStatement(tablename) + ")";
+}
+
+void SqlSpatialIndex::bindRect(SqlQuery& query, const geo::Rect& rect)
+{
+  query.bindValue(":rtree_west", rect.getWest());
+  query.bindValue(":rtree_east", rect.getEast());
+  query.bindValue(":rtree_south", rect.getSouth());
+  query.bindValue(":rtree_north", rect.getNorth());
+}
+
+QVector<int> SqlSpatialIndex::getIds(const geo::Rect& rect)
+{
+  QVector<int> ids;
+  if(available)
+  {
+    QList<geo::Rect> rects = rect.splitAtAntiMeridian();
+    for(const geo::Rect& r : rects)
+      queryIds(r, ids);
+
+    std::sort(ids.begin(), ids.end());
+    if(rects.size() > 1)
+      // Objects covering the anti-meridian are found in both parts
+      ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  }
+  return ids;
+}
+
+void SqlSpatialIndex::queryIds(const geo::Rect& rect, QVector<int>& ids)
+{
+  if(query == nullptr)
+  {
+    query = new SqlQuery(db);
+    query->prepare(selectStatement(table));
+  }
+
+  bindRect(*query, rect);
+  query->exec();
+  while(query->next())
+    ids.append(query->valueInt(0));
+  query->finish();
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,102 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLSPATIALINDEX_H
+#define ATOOLS_SQL_SQLSPATIALINDEX_H
+
+#include <QString>
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class Rect;
+}
+namespace sql {
+
+class SqlDatabase;
+class SqlQuery;
+
+/*
+ * Query helper for the optional SQLite R*Tree virtual tables which accompany tables having coordinates.
+ *
+ * The R*Tree table for a table "airport" is "airport_rtree" with the columns "id" (primary key of the
+ * table), "min_lonx", "max_lonx", "min_laty" and "max_laty". Points have a rectangle of zero size.
+ * Objects crossing the anti-meridian cover the whole longitude range in the index.
+ *
+ * Rectangles crossing the anti-meridian are split into two queries. Coordinates are stored as 32 bit floats
+ * rounded outwards, so the result can contain objects slightly outside of the rectangle.
+ *
+ * The navdatabase creates these tables with the option SpatialIndex. Always check isAvailable() and use the
+ * plain coordinate columns if the index is missing.
+ */
+class SqlSpatialIndex
+{
+public:
+  /* Uses the R*Tree table for tablename, e.g. "airport_rtree" for "airport" */
+  SqlSpatialIndex(atools::sql::SqlDatabase *sqlDb, const QString& tablename);
+  ~SqlSpatialIndex();
+
+  SqlSpatialIndex(const SqlSpatialIndex& other) = delete;
+  SqlSpatialIndex& operator=(const SqlSpatialIndex& other) = delete;
+
+  /* true if the R*Tree table exists */
+  bool isAvailable() const
+  {
+    return available;
+  }
+
+  /* Ids of all objects overlapping the rectangle in ascending order. Empty if the index is not available. */
+  QVector<int> getIds(const atools::geo::Rect& rect);
+
+  /* Name of the R*Tree table for the given table */
+  static QString rtreeTableName(const QString& tablename)
+  {
+    return tablename + "_rtree";
+  }
+
+  /* true if the R*Tree table for the given table exists */
+  static bool hasIndex(atools::sql::SqlDatabase *sqlDb, const QString& tablename);
+
+  /*
+   * Expression for a where clause which selects rows of tablename by the spatial index, e.g.
+   * "airport.airport_id in (select id from airport_rtree where ...)".
+   * Uses the named binds ":rtree_west", ":rtree_east", ":rtree_south" and ":rtree_north" which are set by
+   * bindRect(). Run the query once for each part of Rect::splitAtAntiMeridian().
+   */
+  static QString whereClause(const QString& tablename, const QString& idColumn);
+
+  /* Bind the placeholders used by whereClause() and the internal query. rect must not cross the anti-meridian. */
+  static void bindRect(atools::sql::SqlQuery& query, const atools::geo::Rect& rect);
+
+private:
+  /* Select statement for the ids overlapping the bound rectangle */
+  static QString selectStatement(const QString& tablename);
+
+  /* Run the query for one rectangle not crossing the anti-meridian and append ids */
+  void queryIds(const atools::geo::Rect& rect, QVector<int>& ids);
+
+  atools::sql::SqlDatabase *db;
+  QString table;
+  atools::sql::SqlQuery *query = nullptr;
+  bool available = false;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLSPATIALINDEX_H
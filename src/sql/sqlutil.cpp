@@ -139,8 +139,9 @@ int SqlUtil::getTableColumnAndDistinctRows(const QString& tablename, const QStri
 
 int SqlUtil::rowCount(const QString& tablename, const QString& criteria)
 {
-  SqlQuery q(db);
-  q.exec("select count(1) from " + tablename + (criteria.isEmpty() ? QString() : " where " + criteria));
+  SqlQuery q = db->cachedQuery("select count(1) from " + tablename +
+                                (criteria.isEmpty() ? QString() : " where " + criteria));
+  q.exec();
   if(q.next())
     return q.value(0).toInt();
 
@@ -149,9 +150,12 @@ int SqlUtil::rowCount(const QString& tablename, const QString& criteria)
 
 bool SqlUtil::hasRows(const QString& tablename, const QString& criteria)
 {
-  SqlQuery q(db);
-  q.exec("select 1 from " + tablename + (criteria.isEmpty() ? QString() : " where " + criteria) + " limit 1");
-  return q.next();
+  SqlQuery q = db->cachedQuery("select 1 from " + tablename +
+                                (criteria.isEmpty() ? QString() : " where " + criteria) + " limit 1");
+  q.exec();
+  bool retval = q.next();
+  q.finish();
+  return retval;
 }
 
 void SqlUtil::copyRowValues(const SqlQuery& from, SqlQuery& to)
@@ -217,6 +221,117 @@ int SqlUtil::copyResultValues(SqlQuery& from, SqlQuery& to)
   return copied;
 }
 
+int SqlUtil::copyTable(SqlDatabase *sourceDb, const QString& sourceTable, const QString& destTable,
+                       const ColumnMapType& columnMap, const QString& whereClause, const CopyRowFuncType& func)
+{
+  ColumnMapType columns(columnMap);
+  if(columns.isEmpty())
+  {
+    // Use all columns existing in both tables
+    SqlRecord sourceRec = sourceDb->record(sourceTable);
+    for(const QString& column : buildColumnList(destTable))
+    {
+      if(sourceRec.contains(column))
+        columns.append(std::make_pair(column, column));
+    }
+  }
+
+  if(columns.isEmpty())
+  {
+    qWarning() << Q_FUNC_INFO << "No common columns for" << sourceTable << destTable;
+    return 0;
+  }
+
+  bool attach = !func && db->driverName() == "QSQLITE" && sourceDb->driverName() == "QSQLITE" &&
+                db->isAutomaticTransactions() && !db->isReadonly() &&
+                !sourceDb->databaseName().isEmpty() && sourceDb->databaseName() != ":memory:" &&
+                sourceDb->databaseName() != db->databaseName();
+
+  if(attach)
+    return copyTableAttached(sourceDb, sourceTable, destTable, columns, whereClause);
+  else
+    return copyTableRows(sourceDb, sourceTable, destTable, columns, whereClause, func);
+}
+
+int SqlUtil::copyTableAttached(SqlDatabase *sourceDb, const QString& sourceTable, const QString& destTable,
+                               const ColumnMapType& columnMap, const QString& whereClause)
+{
+  static const QString SCHEMA("copy_table_source");
+
+  QStringList destCols, sourceCols;
+  for(const std::pair<QString, QString>& col : columnMap)
+  {
+    destCols.append(col.first);
+    sourceCols.append(col.second);
+  }
+
+  db->attachDatabase(sourceDb->databaseName(), SCHEMA);
+  int copied = 0;
+  try
+  {
+    SqlQuery query(db);
+    query.exec("insert into " + destTable + " (" + destCols.join(", ") + ") " +
+               "select " + sourceCols.join(", ") + " from " + SCHEMA + "." + sourceTable +
+               (whereClause.isEmpty() ? QString() : " where " + whereClause));
+    copied = query.numRowsAffected();
+
+    // Detach rolls back
+    db->commit();
+  }
+  catch(...)
+  {
+    db->detachDatabase(SCHEMA);
+    throw;
+  }
+
+  db->detachDatabase(SCHEMA);
+  return copied;
+}
+
+int SqlUtil::copyTableRows(SqlDatabase *sourceDb, const QString& sourceTable, const QString& destTable,
+                           const ColumnMapType& columnMap, const QString& whereClause, const CopyRowFuncType& func)
+{
+  QStringList destCols, sourceCols;
+  for(const std::pair<QString, QString>& col : columnMap)
+  {
+    destCols.append(col.first);
+    sourceCols.append(col.second);
+  }
+  int numCols = destCols.size();
+
+  // Forward only avoids caching all rows of large tables
+  SqlQuery select(sourceDb);
+  select.setForwardOnly(true);
+  select.prepare("select " + sourceCols.join(", ") + " from " + sourceTable +
+                 (whereClause.isEmpty() ? QString() : " where " + whereClause));
+
+  SqlQuery insert(db);
+  insert.prepare("insert into " + destTable + " (" + destCols.join(", ") + ") values(" +
+                 QString("?, ").repeated(numCols - 1) + "?)");
+
+  int copied = 0;
+  QVariantList values;
+  values.reserve(numCols);
+
+  select.exec();
+  while(select.next())
+  {
+    values.clear();
+    for(int i = 0; i < numCols; i++)
+      values.append(select.value(i));
+
+    if(func && !func(values))
+      continue;
+
+    for(int i = 0; i < numCols; i++)
+      insert.bindValue(i, values.at(i));
+    insert.exec();
+    copied++;
+  }
+  select.finish();
+  return copied;
+}
+
 void SqlUtil::updateColumnInTable(const QString& table, const QString& idColum, const QStringList& queryColumns,
                                   const QStringList& insertcolumns, UpdateColFuncType func)
 {
@@ -230,7 +345,10 @@ void SqlUtil::updateColumnInTable(const QString& table, const QString& idColum,
 
   QStringList queryCols(queryColumns);
   queryCols.append(idColum);
-  SqlQuery select(util.buildSelectStatement(table, queryCols), db);
+  // Forward only avoids caching all rows of large tables
+  SqlQuery select(db);
+  select.setForwardOnly(true);
+  select.prepare(util.buildSelectStatement(table, queryCols));
 
   QStringList insertSet;
   for(const QString& ic : insertcolumns)
@@ -445,8 +563,7 @@ int SqlUtil::bindAndExec(const QString& sql, const QString& bind, const QVariant
 
 int SqlUtil::bindAndExec(const QString& sql, QVector<std::pair<QString, QVariant> > params)
 {
-  SqlQuery query(db);
-  query.prepare(sql);
+  SqlQuery query = db->cachedQuery(sql);
 
   for(const std::pair<QString, QVariant>& bind : params)
     query.bindValue(bind.first, bind.second);
@@ -482,6 +599,9 @@ bool SqlUtil::addColumnIf(const QString& table, const QString& column, const QSt
   {
     // Add missing column
     db->exec("alter table " + table + " add column " + column + " " + type + " " + suffix);
+
+    // Cached "select *" statements do not know the new column
+    db->clearQueryCache();
     return true;
   }
   return false;
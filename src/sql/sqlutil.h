@@ -20,6 +20,7 @@
 
 #include <QStringList>
 #include <QVariant>
+#include <QVector>
 #include <functional>
 
 namespace atools {
@@ -101,6 +102,36 @@ public:
    */
   static void copyRowValues(const atools::sql::SqlQuery& from, atools::sql::SqlQuery& to);
 
+  /* Transform function for copyTable(). Gets the values of one row in the order of the destination columns
+   * and can modify them but must not change the number of values. Row is skipped if the function returns false. */
+  typedef std::function<bool (QVariantList& values)> CopyRowFuncType;
+
+  /* Destination column and source column or expression pairs for copyTable() */
+  typedef QVector<std::pair<QString, QString> > ColumnMapType;
+
+  /*
+   * Copies all rows of a table from another database into a table of the database of this object.
+   * @param sourceDb Source database. Can be the same as the database of this object.
+   * @param sourceTable Table in source database
+   * @param destTable Table in this database
+   * @param columnMap Destination columns and source columns or expressions. Copies all destination columns which
+   * exist in the source table if empty.
+   * @param whereClause Optional filter for the source table without "where"
+   * @param func Optional transform function called for each row
+   *
+   * Uses "attach database" and one "insert into ... select" statement if both databases are SQLite,
+   * automatic transactions are enabled and no transform function is given. Attaching rolls back the current
+   * transaction, so commit changes before. Changes are committed after copying in this case.
+   * Uncommitted changes in the source database are not visible when attaching.
+   *
+   * Otherwise rows are read with a forward only query and inserted using a prepared statement with reused
+   * positional binds. Nothing is committed in this case.
+   * @return number of rows copied
+   */
+  int copyTable(atools::sql::SqlDatabase *sourceDb, const QString& sourceTable, const QString& destTable,
+                const ColumnMapType& columnMap = ColumnMapType(), const QString& whereClause = QString(),
+                const CopyRowFuncType& func = nullptr);
+
   void reportRangeViolations(QDebug& out, const QString& table, const QStringList& reportCols,
                              const QString& column, const QVariant& minValue,
                              const QVariant& maxValue);
@@ -127,6 +158,15 @@ private:
   SqlDatabase *db;
 
   QStringList buildTableList(const QStringList& tables);
+
+  /* Copy using insert-select after attaching the source database */
+  int copyTableAttached(atools::sql::SqlDatabase *sourceDb, const QString& sourceTable, const QString& destTable,
+                        const ColumnMapType& columnMap, const QString& whereClause);
+
+  /* Copy row by row using prepared queries */
+  int copyTableRows(atools::sql::SqlDatabase *sourceDb, const QString& sourceTable, const QString& destTable,
+                    const ColumnMapType& columnMap, const QString& whereClause, const CopyRowFuncType& func);
+
   QStringList buildResultList(atools::sql::SqlQuery& query);
 
   static void copyRowValuesInternal(const atools::sql::SqlQuery& from, atools::sql::SqlQuery& to,
@@ -0,0 +1,349 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlwindowedquery.h"
+
+#include "sql/sqlconnectionpool.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+
+#include <limits>
+
+namespace atools {
+namespace sql {
+
+using atools::util::TaskHandle;
+using atools::util::TaskScheduler;
+
+SqlWindowedQuery::SqlWindowedQuery(SqlConnectionPool *connectionPool, const QString& from, const QString& keyColumn,
+                                   const QStringList& columns, int windowSize, int maxWindows)
+  : pool(connectionPool), fromClause(from), key(keyColumn), columnNames(columns), windowSize(std::max(windowSize, 1)),
+  maximumWindows(std::max(maxWindows, 2)), endWindow(std::numeric_limits<int>::max()), rowCount(-1)
+{
+}
+
+SqlWindowedQuery::~SqlWindowedQuery()
+{
+  QVector<TaskHandle> handles;
+  {
+    QMutexLocker locker(&mutex);
+    token.cancel();
+    handles = pending.values().toVector();
+    handles.append(countTask);
+  }
+
+  // Tasks which are running already refer to this
+  for(const TaskHandle& handle : handles)
+  {
+    if(handle.isValid())
+      handle.wait();
+  }
+}
+
+void SqlWindowedQuery::setFilter(const QString& whereClause, const QVector<std::pair<QString, QVariant> >& bindValues)
+{
+  filter = whereClause;
+  filterBindValues = bindValues;
+}
+
+void SqlWindowedQuery::start()
+{
+  QVector<TaskHandle> handles;
+  int gen;
+  {
+    QMutexLocker locker(&mutex);
+    token.cancel();
+    handles = pending.values().toVector();
+    handles.append(countTask);
+
+    // Results of tasks still running are dropped since the generation changes
+    generation++;
+    gen = generation;
+    windows.clear();
+    pending.clear();
+    anchors.clear();
+    endWindow = std::numeric_limits<int>::max();
+    lastWindow = 0;
+    rowCount.store(-1);
+    token = atools::util::CancellationToken();
+  }
+
+  for(const TaskHandle& handle : handles)
+  {
+    if(handle.isValid())
+      handle.wait();
+  }
+
+  QString queryStr = "select count(1) from " + fromClause + whereClause(false);
+  TaskHandle handle = TaskScheduler::instance().run([this, gen, queryStr]() -> void {
+    try
+    {
+      SqlConnectionLease lease(pool);
+      SqlQuery query(queryStr, lease.db());
+      query.bindValues(filterBindValues);
+      query.exec();
+      int count = query.next() ? query.valueInt(0) : 0;
+
+      QMutexLocker locker(&mutex);
+      if(gen == generation)
+      {
+        endWindow = std::min(endWindow, (count + windowSize - 1) / windowSize);
+        rowCount.store(count);
+      }
+    }
+    catch(std::exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Counting rows failed" << e.what();
+    }
+  }, atools::util::TASK_BACKGROUND, token);
+
+  QMutexLocker locker(&mutex);
+  countTask = handle;
+}
+
+int SqlWindowedQuery::waitForRowCount()
+{
+  TaskHandle handle;
+  {
+    QMutexLocker locker(&mutex);
+    handle = countTask;
+  }
+
+  if(handle.isValid())
+    handle.wait();
+  return rowCount.load();
+}
+
+QVariant SqlWindowedQuery::value(int row, int column)
+{
+  if(row < 0 || column < 0 || column >= columnNames.size())
+    return QVariant();
+
+  WindowPtr window = windowForRow(row);
+  int windowRow = row % windowSize;
+  if(windowRow < window->numRows)
+    return window->values.at(windowRow * columnNames.size() + column);
+  else
+    return QVariant();
+}
+
+QVector<QVariant> SqlWindowedQuery::values(int row)
+{
+  if(row < 0)
+    return QVector<QVariant>();
+
+  WindowPtr window = windowForRow(row);
+  int windowRow = row % windowSize;
+  if(windowRow < window->numRows)
+    return window->values.mid(windowRow * columnNames.size(), columnNames.size());
+  else
+    return QVector<QVariant>();
+}
+
+SqlWindowedQuery::WindowPtr SqlWindowedQuery::windowForRow(int row)
+{
+  int index = row / windowSize;
+  bool forward;
+  {
+    QMutexLocker locker(&mutex);
+    forward = index >= lastWindow;
+    lastWindow = index;
+  }
+
+  WindowPtr window = getWindow(index);
+  prefetch(forward ? index + 1 : index - 1);
+  return window;
+}
+
+SqlWindowedQuery::WindowPtr SqlWindowedQuery::getWindow(int index)
+{
+  QMutexLocker locker(&mutex);
+  while(true)
+  {
+    WindowPtr window = windows.value(index);
+    if(!window.isNull())
+      return window;
+
+    TaskHandle handle = pending.value(index);
+    if(!handle.isValid())
+      break;
+
+    // Prefetch is running or queued - wait for it instead of loading twice
+    locker.unlock();
+    handle.wait();
+    locker.relock();
+
+    // Task failed or was canceled if the window is still missing
+    TaskHandle finished = pending.value(index);
+    if(!windows.contains(index) && finished.isValid() && finished.isFinished())
+      pending.remove(index);
+  }
+
+  int gen = generation;
+  locker.unlock();
+  WindowPtr window = loadWindow(index, gen);
+
+  locker.relock();
+  if(gen == generation)
+    insertWindow(index, window);
+  return window;
+}
+
+SqlWindowedQuery::WindowPtr SqlWindowedQuery::loadWindow(int index, int gen)
+{
+  QSharedPointer<Window> window(new Window);
+
+  int baseIndex = 0;
+  QVariant anchor;
+  {
+    QMutexLocker locker(&mutex);
+    if(index >= endWindow)
+      return window;
+
+    // Find nearest known window start before or at index
+    QMap<int, QVariant>::const_iterator it = anchors.upperBound(index);
+    if(it != anchors.constBegin())
+    {
+      --it;
+      baseIndex = it.key();
+      anchor = it.value();
+    }
+  }
+
+  SqlConnectionLease lease(pool);
+  QString order = " order by " + key + (descending ? " desc" : "");
+
+  if(baseIndex < index)
+  {
+    // Skip whole windows by reading only the key column of the last row before the window
+    SqlQuery skipQuery("select " + key + " from " + fromClause + whereClause(baseIndex > 0) + order +
+                       " limit 1 offset " + QString::number((index - baseIndex) * windowSize - 1), lease.db());
+    skipQuery.bindValues(filterBindValues);
+    if(baseIndex > 0)
+      skipQuery.bindValue(":windowAnchor", anchor);
+    skipQuery.exec();
+
+    if(!skipQuery.next())
+    {
+      QMutexLocker locker(&mutex);
+      if(gen == generation)
+        endWindow = std::min(endWindow, index);
+      return window;
+    }
+
+    anchor = skipQuery.value(0);
+    QMutexLocker locker(&mutex);
+    if(gen == generation)
+      anchors.insert(index, anchor);
+  }
+
+  // Key is read as last column to continue with the next window
+  SqlQuery query("select " + columnNames.join(", ") + ", " + key + " from " + fromClause + whereClause(index > 0) +
+                 order + " limit " + QString::number(windowSize), lease.db());
+  query.bindValues(filterBindValues);
+  if(index > 0)
+    query.bindValue(":windowAnchor", anchor);
+  query.exec();
+
+  int numColumns = columnNames.size();
+  window->values.reserve(windowSize * numColumns);
+  while(query.next())
+  {
+    for(int i = 0; i < numColumns; i++)
+      window->values.append(query.value(i));
+    window->lastKey = query.value(numColumns);
+    window->numRows++;
+  }
+
+  QMutexLocker locker(&mutex);
+  if(gen == generation)
+  {
+    if(window->numRows == windowSize)
+      anchors.insert(index + 1, window->lastKey);
+    else
+      endWindow = std::min(endWindow, index + 1);
+  }
+  return window;
+}
+
+void SqlWindowedQuery::insertWindow(int index, const WindowPtr& window)
+{
+  windows.insert(index, window);
+
+  while(windows.size() > maximumWindows)
+  {
+    // Drop the window farthest away from the scroll position
+    int farthest = index, maxDistance = -1;
+    for(auto it = windows.constBegin(); it != windows.constEnd(); ++it)
+    {
+      int distance = std::abs(it.key() - lastWindow);
+      if(distance > maxDistance)
+      {
+        maxDistance = distance;
+        farthest = it.key();
+      }
+    }
+    windows.remove(farthest);
+  }
+}
+
+void SqlWindowedQuery::prefetch(int index)
+{
+  QMutexLocker locker(&mutex);
+  int count = rowCount.load();
+  if(index < 0 || index >= endWindow || (count >= 0 && index * windowSize >= count) ||
+     windows.contains(index) || pending.contains(index))
+    return;
+
+  int gen = generation;
+  pending.insert(index, TaskScheduler::instance().run([this, index, gen]() -> void {
+    WindowPtr window;
+    try
+    {
+      window = loadWindow(index, gen);
+    }
+    catch(std::exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Prefetching window" << index << "failed" << e.what();
+    }
+
+    QMutexLocker taskLocker(&mutex);
+    if(gen == generation)
+    {
+      if(!window.isNull())
+        insertWindow(index, window);
+      pending.remove(index);
+    }
+  }, atools::util::TASK_BACKGROUND, token));
+}
+
+QString SqlWindowedQuery::whereClause(bool withAnchor) const
+{
+  QStringList conditions;
+  if(!filter.isEmpty())
+    conditions.append("(" + filter + ")");
+  if(withAnchor)
+    conditions.append(key + (descending ? " < " : " > ") + ":windowAnchor");
+
+  return conditions.isEmpty() ? QString() : " where " + conditions.join(" and ");
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,160 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLWINDOWEDQUERY_H
+#define ATOOLS_SQL_SQLWINDOWEDQUERY_H
+
+#include "util/taskscheduler.h"
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+#include <atomic>
+
+namespace atools {
+namespace sql {
+
+class SqlConnectionPool;
+
+/*
+ * Random row access to large ordered result sets with constant memory.
+ *
+ * Rows are fetched in windows of windowSize rows using keyset pagination on an ordered unique column
+ * ("where key > :last order by key limit n") instead of iterating or seeking over the whole result.
+ * The start key of each window is remembered. Jumps to unknown positions need only one index scan
+ * which reads the key column.
+ *
+ * At most maxWindows windows are kept. The one farthest from the last accessed row is dropped first.
+ * The window ahead in scroll direction is prefetched in the background and rows are counted
+ * asynchronously. Both use the shared TaskScheduler and connections from the pool.
+ *
+ * Access methods have to be called from one thread only. The key column should be indexed.
+ */
+class SqlWindowedQuery
+{
+public:
+  /* from is a table name or join and keyColumn an unique not null column like "waypoint_id" */
+  SqlWindowedQuery(atools::sql::SqlConnectionPool *connectionPool, const QString& from, const QString& keyColumn,
+                   const QStringList& columns, int windowSize = 250, int maxWindows = 8);
+
+  /* Cancels and waits for background tasks */
+  ~SqlWindowedQuery();
+
+  SqlWindowedQuery(const SqlWindowedQuery& other) = delete;
+  SqlWindowedQuery& operator=(const SqlWindowedQuery& other) = delete;
+
+  /* Optional condition without "where" and its bind values. Call start() afterwards. */
+  void setFilter(const QString& whereClause,
+                 const QVector<std::pair<QString, QVariant> >& bindValues = QVector<std::pair<QString, QVariant> >());
+
+  /* Order descending by key. Call start() afterwards. */
+  void setDescending(bool value)
+  {
+    descending = value;
+  }
+
+  /* Drops all windows and starts counting rows in the background */
+  void start();
+
+  /* Value of column in row or null variant if row is beyond the end.
+   * Loads the window synchronously if not available. Throws SqlException on error. */
+  QVariant value(int row, int column);
+
+  /* Values of all columns or empty if row is beyond the end */
+  QVector<QVariant> values(int row);
+
+  /* Number of rows or -1 if counting is not finished yet */
+  int getRowCount() const
+  {
+    return rowCount.load();
+  }
+
+  /* Waits until counting is finished and returns the number of rows */
+  int waitForRowCount();
+
+  const QStringList& getColumns() const
+  {
+    return columnNames;
+  }
+
+  int getWindowSize() const
+  {
+    return windowSize;
+  }
+
+private:
+  /* Rows of one window with all columns in one vector */
+  struct Window
+  {
+    QVector<QVariant> values;
+    int numRows = 0;
+    QVariant lastKey;
+  };
+
+  typedef QSharedPointer<const Window> WindowPtr;
+
+  /* Get window containing row and prefetch the next one in scroll direction */
+  WindowPtr windowForRow(int row);
+
+  /* Get window from cache, wait for a prefetch or load it */
+  WindowPtr getWindow(int index);
+
+  /* Load a window using a connection from the pool. Can be called from any thread. */
+  WindowPtr loadWindow(int index, int gen);
+
+  /* Add loaded window and remove the one farthest away if the cache is full. Needs lock. */
+  void insertWindow(int index, const WindowPtr& window);
+
+  /* Queue loading of the window ahead in scroll direction unless known to be beyond the end */
+  void prefetch(int index);
+
+  QString whereClause(bool withAnchor) const;
+
+  atools::sql::SqlConnectionPool *pool;
+  QString fromClause, key, filter;
+  QStringList columnNames;
+  QVector<std::pair<QString, QVariant> > filterBindValues;
+  int windowSize, maximumWindows;
+  bool descending = false;
+
+  /* Guards all members below */
+  mutable QMutex mutex;
+  QHash<int, WindowPtr> windows;
+  QHash<int, atools::util::TaskHandle> pending;
+
+  /* Last key of the window before index. Missing for window zero. */
+  QMap<int, QVariant> anchors;
+
+  /* Number of first window which is known to be empty or INT_MAX */
+  int endWindow;
+  int lastWindow = 0, generation = 0;
+
+  std::atomic<int> rowCount;
+  atools::util::TaskHandle countTask;
+  atools::util::CancellationToken token;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLWINDOWEDQUERY_H
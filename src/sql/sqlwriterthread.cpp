@@ -0,0 +1,165 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "sql/sqlwriterthread.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqltransaction.h"
+
+#include <QDebug>
+
+namespace atools {
+namespace sql {
+
+SqlWriterThread::SqlWriterThread(const SqlDatabase *sourceDb, const QString& connectionName, QObject *parent)
+  : QThread(parent), driverName(sourceDb->driverName()), databaseName(sourceDb->databaseName()),
+  connectOptions(sourceDb->connectOptions()), name(connectionName)
+{
+}
+
+SqlWriterThread::~SqlWriterThread()
+{
+  terminateThread();
+}
+
+int SqlWriterThread::post(const std::function<void(SqlDatabase *writerDb)>& job)
+{
+  int id;
+  {
+    QMutexLocker locker(&mutex);
+    id = nextJobId++;
+    jobs.enqueue({id, job});
+    waitCondition.wakeAll();
+  }
+
+  if(!isRunning())
+    start();
+  return id;
+}
+
+void SqlWriterThread::terminateThread()
+{
+  {
+    QMutexLocker locker(&mutex);
+    terminate = true;
+    waitCondition.wakeAll();
+  }
+  wait();
+
+  QMutexLocker locker(&mutex);
+  terminate = false;
+}
+
+int SqlWriterThread::getNumQueued() const
+{
+  QMutexLocker locker(&mutex);
+  return jobs.size();
+}
+
+void SqlWriterThread::run()
+{
+  qDebug() << Q_FUNC_INFO << name << databaseName;
+
+  QString openError;
+  SqlDatabase *db = nullptr;
+  try
+  {
+    db = openDatabase();
+  }
+  catch(std::exception& e)
+  {
+    openError = e.what();
+    qWarning() << Q_FUNC_INFO << "Cannot open" << databaseName << openError;
+  }
+
+  while(true)
+  {
+    Job job;
+    {
+      QMutexLocker locker(&mutex);
+      while(jobs.isEmpty() && !terminate)
+        waitCondition.wait(&mutex);
+
+      // Leave only if all jobs are done
+      if(jobs.isEmpty())
+        break;
+      job = jobs.dequeue();
+    }
+
+    bool success = false;
+    QString errorMessage = openError;
+    if(db != nullptr)
+    {
+      try
+      {
+        // Rolls back if job throws
+        SqlTransaction transaction(db);
+        job.func(db);
+        transaction.commit();
+        success = true;
+      }
+      catch(std::exception& e)
+      {
+        errorMessage = e.what();
+        qWarning() << Q_FUNC_INFO << "Job" << job.id << "failed" << errorMessage;
+      }
+      catch(...)
+      {
+        errorMessage = tr("Unknown exception");
+        qWarning() << Q_FUNC_INFO << "Job" << job.id << "failed with unknown exception";
+      }
+    }
+
+    emit jobFinished(job.id, success, errorMessage);
+  }
+
+  closeDatabase(db);
+  qDebug() << Q_FUNC_INFO << name << "done";
+}
+
+SqlDatabase *SqlWriterThread::openDatabase()
+{
+  SqlDatabase *db = new SqlDatabase(SqlDatabase::addDatabase(driverName, name));
+  try
+  {
+    db->setDatabaseName(databaseName);
+    db->setConnectOptions(connectOptions);
+    db->setAutomaticTransactions(false);
+    db->open();
+  }
+  catch(...)
+  {
+    closeDatabase(db);
+    throw;
+  }
+  return db;
+}
+
+void SqlWriterThread::closeDatabase(SqlDatabase *db)
+{
+  if(db != nullptr)
+  {
+    if(db->isOpen())
+      db->close();
+    delete db;
+    SqlDatabase::removeDatabase(name);
+  }
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,93 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_SQL_SQLWRITERTHREAD_H
+#define ATOOLS_SQL_SQLWRITERTHREAD_H
+
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <functional>
+
+namespace atools {
+namespace sql {
+
+class SqlDatabase;
+
+/*
+ * Background thread which executes write jobs on its own connection to a database file.
+ * The connection is opened in the thread with the same driver, file and connect options as the given database
+ * and closed when the thread stops.
+ *
+ * Each job is called with the writer connection and runs in a transaction which is committed after the job
+ * returns or rolled back if it throws an exception. Jobs are executed in the order they were posted.
+ *
+ * Switch the database to WAL mode to allow readers on other connections to continue during writes.
+ * Readers with an open transaction see the state at the time their transaction started.
+ */
+class SqlWriterThread :
+  public QThread
+{
+  Q_OBJECT
+
+public:
+  /* Copies driver, file and options from database. connectionName has to be unique. */
+  SqlWriterThread(const atools::sql::SqlDatabase *sourceDb, const QString& connectionName,
+                  QObject *parent = nullptr);
+  virtual ~SqlWriterThread() override;
+
+  /* Queue a job and start the thread if not running. Returns an id which is passed to jobFinished. */
+  int post(const std::function<void(atools::sql::SqlDatabase *writerDb)>& job);
+
+  /* Execute all queued jobs, stop the thread, wait for termination and reset flag afterwards */
+  void terminateThread();
+
+  /* Number of jobs not started yet */
+  int getNumQueued() const;
+
+signals:
+  /* Sent from the writer thread after a job is done. errorMessage contains the exception text if not successful. */
+  void jobFinished(int jobId, bool success, const QString& errorMessage);
+
+private:
+  struct Job
+  {
+    int id = 0;
+    std::function<void(atools::sql::SqlDatabase *writerDb)> func;
+  };
+
+  virtual void run() override;
+  atools::sql::SqlDatabase *openDatabase();
+  void closeDatabase(atools::sql::SqlDatabase *db);
+
+  QString driverName, databaseName, connectOptions, name;
+  QQueue<Job> jobs;
+  int nextJobId = 1;
+  bool terminate = false;
+
+  /* Protects job queue and flag */
+  mutable QMutex mutex;
+  QWaitCondition waitCondition;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLWRITERTHREAD_H
@@ -0,0 +1,354 @@
+/**
+ *  @file
+ */
+
+#include "compiledtemplate.h"
+#include "template.h"
+#include <QStringList>
+#include <algorithm>
+
+using namespace stefanfrings;
+
+namespace {
+
+/** Names of tags must not contain spaces or braces */
+bool isName(const QStringRef& name)
+{
+  if(name.isEmpty())
+  {
+    return false;
+  }
+  for(const QChar& c : name)
+  {
+    if(c.isSpace() || c == '{' || c == '}')
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+void TemplateData::clear()
+{
+  variables.clear();
+  conditions.clear();
+  loops.clear();
+}
+
+CompiledTemplate::CompiledTemplate(const QString& source, const QString& sourceName)
+{
+  this->source = source;
+  this->sourceName = sourceName;
+  valid = parse();
+  if(!valid)
+  {
+    qWarning("CompiledTemplate: invalid structure in %s, using text replacement", qPrintable(sourceName));
+    nodes.clear();
+  }
+}
+
+bool CompiledTemplate::parse()
+{
+  // Blocks which are not closed yet. Content goes into the else part once the else tag was found.
+  struct OpenBlock
+  {
+    Node node;
+    bool inElse;
+  };
+  QVector<OpenBlock> stack;
+  QString text;
+
+  // Nodes of the innermost open block or the root
+  auto current = [&]() -> QVector<Node>& {
+                   if(stack.isEmpty())
+                   {
+                     return nodes;
+                   }
+                   OpenBlock& block = stack.last();
+                   return block.inElse ? block.node.elseChildren : block.node.children;
+                 };
+
+  auto flushText = [&]() {
+                     if(!text.isEmpty())
+                     {
+                       Node node;
+                       node.type = TEXT;
+                       node.text = text;
+                       node.hasElse = false;
+                       current().append(node);
+                       text.clear();
+                     }
+                   };
+
+  // true if a block with the given name is open but not the innermost one
+  auto isCrossed = [&](const QStringRef& name) -> bool {
+                     for(int i = 0; i < stack.size() - 1; i++)
+                     {
+                       if(stack.at(i).node.text == name)
+                       {
+                         return true;
+                       }
+                     }
+                     return false;
+                   };
+
+  int pos = 0;
+  while(pos < source.size())
+  {
+    int open = source.indexOf('{', pos);
+    int close = open >= 0 ? source.indexOf('}', open + 1) : -1;
+    if(close < 0)
+    {
+      text.append(source.midRef(pos));
+      break;
+    }
+
+    QStringRef content = source.midRef(open + 1, close - open - 1);
+    int nested = content.lastIndexOf('{');
+    if(nested >= 0)
+    {
+      // Another brace opens before this one closes - skip the text up to the inner brace
+      text.append(source.midRef(pos, open + 1 + nested - pos));
+      pos = open + 1 + nested;
+      continue;
+    }
+
+    // Text before the tag
+    text.append(source.midRef(pos, open - pos));
+    QStringRef tagText = source.midRef(open, close - open + 1);
+    pos = close + 1;
+
+    int space = content.indexOf(' ');
+    QStringRef keyword = space >= 0 ? content.left(space) : QStringRef();
+    QStringRef name = space >= 0 ? content.mid(space + 1) : content;
+
+    if(!isName(name))
+    {
+      text.append(tagText);
+    }
+    else if(keyword.isNull())
+    {
+      flushText();
+      Node node;
+      node.type = VARIABLE;
+      node.text = name.toString();
+      node.hasElse = false;
+      current().append(node);
+    }
+    else if(keyword == "if" || keyword == "ifnot" || keyword == "loop")
+    {
+      flushText();
+      OpenBlock block;
+      block.node.type = keyword == "if" ? IF : (keyword == "ifnot" ? IFNOT : LOOP);
+      block.node.text = name.toString();
+      block.node.hasElse = false;
+      block.inElse = false;
+      stack.append(block);
+    }
+    else if(keyword == "else" || keyword == "end")
+    {
+      if(!stack.isEmpty() && stack.last().node.text == name && !(keyword == "else" && stack.last().inElse))
+      {
+        flushText();
+        if(keyword == "else")
+        {
+          stack.last().inElse = true;
+          stack.last().node.hasElse = true;
+        }
+        else
+        {
+          Node node = stack.last().node;
+          stack.removeLast();
+          current().append(node);
+        }
+      }
+      else if(isCrossed(name))
+      {
+        qWarning("CompiledTemplate: unexpected tag %s in %s", qPrintable(tagText.toString()), qPrintable(sourceName));
+        return false;
+      }
+      else
+      {
+        // Tag without block is kept as text like in Template
+        text.append(tagText);
+      }
+    }
+    else
+    {
+      text.append(tagText);
+    }
+  }
+
+  if(!stack.isEmpty())
+  {
+    qWarning("CompiledTemplate: missing end tag for %s in %s", qPrintable(stack.last().node.text),
+             qPrintable(sourceName));
+    return false;
+  }
+
+  flushText();
+  return true;
+}
+
+QString CompiledTemplate::render(const TemplateData& data) const
+{
+  QString output;
+  render(data, output);
+  return output;
+}
+
+void CompiledTemplate::render(const TemplateData& data, QString& output) const
+{
+  // Loops usually make the result larger than the source
+  output.reserve(output.size() + source.size() + source.size() / 2);
+
+  if(valid)
+  {
+    QVector<Scope> scopes;
+    renderNodes(nodes, data, scopes, output);
+  }
+  else
+  {
+    renderText(data, output);
+  }
+}
+
+void CompiledTemplate::renderNodes(const QVector<Node>& nodes, const TemplateData& data, QVector<Scope>& scopes,
+                                   QString& output) const
+{
+  for(const Node& node : nodes)
+  {
+    if(node.type == TEXT)
+    {
+      output.append(node.text);
+      continue;
+    }
+
+    QString name = scopedName(node.text, scopes);
+    switch(node.type)
+    {
+      case TEXT:
+        break;
+
+      case VARIABLE:
+        {
+          QHash<QString, QString>::const_iterator it = data.variables.constFind(name);
+          if(it != data.variables.constEnd())
+          {
+            output.append(it.value());
+          }
+          else
+          {
+            // Keep tag unchanged
+            output.append('{');
+            output.append(name);
+            output.append('}');
+          }
+        }
+        break;
+
+      case IF:
+      case IFNOT:
+        {
+          QHash<QString, bool>::const_iterator it = data.conditions.constFind(name);
+          if(it != data.conditions.constEnd())
+          {
+            renderNodes((node.type == IF) == it.value() ? node.children : node.elseChildren, data, scopes, output);
+          }
+          else
+          {
+            renderLiteral(node, name, data, scopes, output);
+          }
+        }
+        break;
+
+      case LOOP:
+        {
+          QHash<QString, int>::const_iterator it = data.loops.constFind(name);
+          if(it == data.loops.constEnd())
+          {
+            renderLiteral(node, name, data, scopes, output);
+          }
+          else if(it.value() == 0)
+          {
+            renderNodes(node.elseChildren, data, scopes, output);
+          }
+          else
+          {
+            // Number variables, conditions and sub-loops within the loop
+            Scope scope;
+            scope.from = name + '.';
+            scopes.append(scope);
+            for(int i = 0; i < it.value(); i++)
+            {
+              scopes.last().to = name + QString::number(i) + '.';
+              renderNodes(node.children, data, scopes, output);
+            }
+            scopes.removeLast();
+          }
+        }
+        break;
+    }
+  }
+}
+
+void CompiledTemplate::renderLiteral(const Node& node, const QString& name, const TemplateData& data,
+                                     QVector<Scope>& scopes, QString& output) const
+{
+  output.append(node.type == IF ? "{if " : (node.type == IFNOT ? "{ifnot " : "{loop "));
+  output.append(name);
+  output.append('}');
+  renderNodes(node.children, data, scopes, output);
+  if(node.hasElse)
+  {
+    output.append("{else ");
+    output.append(name);
+    output.append('}');
+    renderNodes(node.elseChildren, data, scopes, output);
+  }
+  output.append("{end ");
+  output.append(name);
+  output.append('}');
+}
+
+QString CompiledTemplate::scopedName(const QString& name, const QVector<Scope>& scopes)
+{
+  QString result = name;
+  for(const Scope& scope : scopes)
+  {
+    if(result.startsWith(scope.from))
+    {
+      result = scope.to + result.midRef(scope.from.size());
+    }
+  }
+  return result;
+}
+
+void CompiledTemplate::renderText(const TemplateData& data, QString& output) const
+{
+  Template t(source, sourceName);
+
+  // Outer loops first since these number the names of the inner loops
+  QStringList loopNames = data.loops.keys();
+  std::sort(loopNames.begin(), loopNames.end(), [](const QString& name1, const QString& name2) -> bool {
+              return name1.count('.') < name2.count('.');
+            });
+  foreach(const QString& name, loopNames)
+  {
+    t.loop(name, data.loops.value(name));
+  }
+
+  for(QHash<QString, bool>::const_iterator it = data.conditions.constBegin(); it != data.conditions.constEnd(); ++it)
+  {
+    t.setCondition(it.key(), it.value());
+  }
+
+  for(QHash<QString, QString>::const_iterator it = data.variables.constBegin(); it != data.variables.constEnd();
+      ++it)
+  {
+    t.setVariable(it.key(), it.value());
+  }
+  output.append(t);
+}
@@ -0,0 +1,150 @@
+/**
+ *  @file
+ */
+
+#ifndef COMPILEDTEMPLATE_H
+#define COMPILEDTEMPLATE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "templateglobal.h"
+
+namespace stefanfrings {
+
+/**
+ *  Values for rendering a CompiledTemplate. Uses the same names as the methods of Template.
+ *  Names of variables, conditions and loops inside loops are numbered the same way, e.g.
+ *  "row0.column1.value" for the variable "{row.column.value}" inside the nested loops "row" and
+ *  "row.column".
+ *  <p>
+ *  Setting values is cheap since nothing is replaced before rendering.
+ *  @see Template
+ */
+
+class DECLSPEC TemplateData
+{
+public:
+  /** Value for a tag {name} */
+  void setVariable(const QString& name, const QString& value)
+  {
+    variables.insert(name, value);
+  }
+
+  /** Value for the tags {if name} and {ifnot name} */
+  void setCondition(const QString& name, bool value)
+  {
+    conditions.insert(name, value);
+  }
+
+  /** Number of repetitions for the tag {loop name} */
+  void loop(const QString& name, int repetitions)
+  {
+    Q_ASSERT(repetitions >= 0);
+    loops.insert(name, repetitions);
+  }
+
+  /** Remove all values */
+  void clear();
+
+private:
+  friend class CompiledTemplate;
+
+  QHash<QString, QString> variables;
+  QHash<QString, bool> conditions;
+  QHash<QString, int> loops;
+};
+
+/**
+ *  Template which is parsed once into a tree of text, variables, conditions and loops.
+ *  Rendering needs a single pass over the tree and writes the result into a preallocated buffer.
+ *  This avoids the repeated search and replace over the whole text done by Template for each
+ *  call of setVariable(), setCondition() and loop().
+ *  <p>
+ *  The syntax and the output are the same as for Template. This includes that tags without a value
+ *  are left in the output unchanged. Templates with an invalid structure like crossed blocks cannot be
+ *  compiled. isValid() is false for these and render() falls back to the text replacement of Template.
+ *  <p>
+ *  Instances are immutable after construction and can be shared between threads.
+ *  @see TemplateCache::getCompiledTemplate()
+ */
+
+class DECLSPEC CompiledTemplate
+{
+public:
+  /**
+   *  Parse the given source.
+   *  @param source The template source text
+   *  @param sourceName Name of the source file, used for logging
+   */
+  CompiledTemplate(const QString& source, const QString& sourceName);
+
+  /** Render the template with the given values */
+  QString render(const TemplateData& data) const;
+
+  /** Render the template with the given values and append the result to output */
+  void render(const TemplateData& data, QString& output) const;
+
+  /** true if the template could be parsed. Otherwise rendering uses the slower text replacement. */
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  /** Name of the source file */
+  const QString& getSourceName() const
+  {
+    return sourceName;
+  }
+
+private:
+  enum NodeType
+  {
+    TEXT, VARIABLE, IF, IFNOT, LOOP
+  };
+
+  struct Node
+  {
+    NodeType type;
+
+    /** Text for TEXT or unnumbered name for all other types */
+    QString text;
+
+    /** Content of blocks and the else part if hasElse is true */
+    QVector<Node> children, elseChildren;
+    bool hasElse;
+  };
+
+  /** Mapping for numbering names inside a loop, e.g. "row." to "row2." */
+  struct Scope
+  {
+    QString from, to;
+  };
+
+  /** Parse source into root nodes. Returns false if the structure is invalid. */
+  bool parse();
+
+  void renderNodes(const QVector<Node>& nodes, const TemplateData& data, QVector<Scope>& scopes,
+                   QString& output) const;
+
+  /** Render a block without value unchanged including its tags */
+  void renderLiteral(const Node& node, const QString& name, const TemplateData& data, QVector<Scope>& scopes,
+                     QString& output) const;
+
+  /** Apply the loop numbering of all enclosing loops to name */
+  static QString scopedName(const QString& name, const QVector<Scope>& scopes);
+
+  /** Fallback for invalid templates */
+  void renderText(const TemplateData& data, QString& output) const;
+
+  QString source, sourceName;
+  QVector<Node> nodes;
+  bool valid;
+};
+
+typedef std::shared_ptr<const CompiledTemplate> CompiledTemplatePtr;
+
+} // end of namespace
+
+#endif // COMPILEDTEMPLATE_H
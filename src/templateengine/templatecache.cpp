@@ -1,7 +1,9 @@
 #include "templatecache.h"
+#include "util/memorybudget.h"
 #include <QDateTime>
 #include <QStringList>
 #include <QSet>
+#include <algorithm>
 
 using namespace stefanfrings;
 
@@ -11,26 +13,94 @@ TemplateCache::TemplateCache(QHash<QString, QVariant> settings, QObject *parent)
   cache.setMaxCost(settings.value("cacheSize", "1000000").toInt());
   cacheTimeout = settings.value("cacheTime", "60000").toInt();
   qDebug("TemplateCache: timeout=%i, size=%i", cacheTimeout, cache.maxCost());
+
+  reportedCost = 0;
+  memoryBudgetId = atools::util::MemoryBudget::instance().add("Templates", atools::util::MEMORY_LOW,
+                                                              [this](qint64 bytes) {
+        shrink(bytes);
+      });
 }
 
-QString TemplateCache::tryFile(const QString localizedName)
+TemplateCache::~TemplateCache()
+{
+  atools::util::MemoryBudget::instance().remove(memoryBudgetId);
+}
+
+void TemplateCache::shrink(qint64 bytes)
+{
+  {
+    QMutexLocker locker(&mutex);
+    // QCache drops least recently used entries when lowering the limit
+    int maxCost = cache.maxCost();
+    cache.setMaxCost(static_cast<int>(std::max(cache.totalCost() - bytes, qint64(0))));
+    cache.setMaxCost(maxCost);
+  }
+  updateMemoryCost();
+}
+
+void TemplateCache::updateMemoryCost()
+{
+  int cost;
+  {
+    QMutexLocker locker(&mutex);
+    if(cache.totalCost() == reportedCost)
+    {
+      return;
+    }
+    cost = reportedCost = cache.totalCost();
+  }
+  atools::util::MemoryBudget::instance().setCost(memoryBudgetId, cost);
+}
+
+TemplateCache::CacheEntry *TemplateCache::entry(const QString& localizedName)
 {
   qint64 now = QDateTime::currentMSecsSinceEpoch();
-  mutex.lock();
   // search in cache
   qDebug("TemplateCache: trying cached %s", qPrintable(localizedName));
   CacheEntry *entry = cache.object(localizedName);
   if(entry && (cacheTimeout == 0 || entry->created > now - cacheTimeout))
   {
-    mutex.unlock();
-    return entry->document;
+    return entry;
   }
   // search on filesystem
   entry = new CacheEntry();
   entry->created = now;
   entry->document = TemplateLoader::tryFile(localizedName);
   // Store in cache even when the file did not exist, to remember that there is no such file
+  if(entry->document.size() > cache.maxCost())
+  {
+    // Would be deleted immediately by the cache
+    uncached = *entry;
+    delete entry;
+    return &uncached;
+  }
   cache.insert(localizedName, entry, entry->document.size());
-  mutex.unlock();
-  return entry->document;
+  return entry;
+}
+
+QString TemplateCache::tryFile(const QString localizedName)
+{
+  QString document;
+  {
+    QMutexLocker locker(&mutex);
+    document = entry(localizedName)->document;
+  }
+  updateMemoryCost();
+  return document;
+}
+
+CompiledTemplatePtr TemplateCache::tryCompiledFile(const QString localizedName)
+{
+  CompiledTemplatePtr compiled;
+  {
+    QMutexLocker locker(&mutex);
+    CacheEntry *cacheEntry = entry(localizedName);
+    if(!cacheEntry->compiled && !cacheEntry->document.isEmpty())
+    {
+      cacheEntry->compiled = std::make_shared<const CompiledTemplate>(cacheEntry->document, localizedName);
+    }
+    compiled = cacheEntry->compiled;
+  }
+  updateMemoryCost();
+  return compiled;
 }
@@ -60,6 +60,9 @@ public:
    */
   TemplateCache(QHash<QString, QVariant> settings, QObject *parent = nullptr);
 
+  /** Destructor */
+  virtual ~TemplateCache();
+
 protected:
   /**
    *  Try to get a file from cache or filesystem.
@@ -68,21 +71,47 @@ protected:
    */
   virtual QString tryFile(const QString localizedName);
 
+  /**
+   *  Try to get a compiled template from cache or compile the file.
+   *  Templates are compiled once per cached file.
+   *  @param localizedName Name of the template with locale to find
+   *  @return The compiled template, or null if not found
+   */
+  virtual CompiledTemplatePtr tryCompiledFile(const QString localizedName);
+
 private:
   struct CacheEntry
   {
     QString document;
     qint64 created;
+
+    /** Compiled on first use */
+    CompiledTemplatePtr compiled;
   };
 
+  /** Get an entry from cache or load it. Mutex has to be locked. */
+  CacheEntry *entry(const QString& localizedName);
+
   /** Timeout for each cached file */
   int cacheTimeout;
 
   /** Cache storage */
   QCache<QString, CacheEntry> cache;
 
+  /** Last loaded file which is too large for the cache */
+  CacheEntry uncached;
+
   /** Used to synchronize threads */
   QMutex mutex;
+
+  /** Id of the cache in atools::util::MemoryBudget and last cost passed to it */
+  int memoryBudgetId, reportedCost;
+
+  /** Remove least recently used entries to free the given number of bytes. Called by the memory budget. */
+  void shrink(qint64 bytes);
+
+  /** Pass the cache size to the memory budget if changed. Mutex must not be locked. */
+  void updateMemoryCost();
 };
 
 } // end of namespace
@@ -62,9 +62,19 @@ QString TemplateLoader::tryFile(QString localizedName)
   return "";
 }
 
-Template TemplateLoader::getTemplate(QString templateName, QString locales)
+CompiledTemplatePtr TemplateLoader::tryCompiledFile(const QString localizedName)
+{
+  QString document = tryFile(localizedName);
+  if(!document.isEmpty())
+  {
+    return std::make_shared<const CompiledTemplate>(document, localizedName);
+  }
+  return CompiledTemplatePtr();
+}
+
+QStringList TemplateLoader::localizedNames(QString templateName, QString locales) const
 {
-  QSet<QString> tried;   // used to suppress duplicate attempts
+  QStringList names;
   QStringList locs = locales.split(',', QString::SkipEmptyParts);
 
   // Search for exact match
@@ -73,14 +83,9 @@ Template TemplateLoader::getTemplate(QString templateName, QString locales)
     loc.replace(QRegExp(";.*"), "");
     loc.replace('-', '_');
     QString localizedName = templateName + "-" + loc.trimmed();
-    if(!tried.contains(localizedName))
+    if(!names.contains(localizedName))
     {
-      QString document = tryFile(localizedName);
-      if(!document.isEmpty())
-      {
-        return Template(document, localizedName);
-      }
-      tried.insert(localizedName);
+      names.append(localizedName);
     }
   }
 
@@ -89,22 +94,41 @@ Template TemplateLoader::getTemplate(QString templateName, QString locales)
   {
     loc.replace(QRegExp("[;_-].*"), "");
     QString localizedName = templateName + "-" + loc.trimmed();
-    if(!tried.contains(localizedName))
+    if(!names.contains(localizedName))
     {
-      QString document = tryFile(localizedName);
-      if(!document.isEmpty())
-      {
-        return Template(document, localizedName);
-      }
-      tried.insert(localizedName);
+      names.append(localizedName);
     }
   }
 
   // Search for default file
-  QString document = tryFile(templateName);
-  if(!document.isEmpty())
+  names.append(templateName);
+  return names;
+}
+
+CompiledTemplatePtr TemplateLoader::getCompiledTemplate(QString templateName, QString locales)
+{
+  foreach(const QString& localizedName, localizedNames(templateName, locales))
   {
-    return Template(document, templateName);
+    CompiledTemplatePtr compiled = tryCompiledFile(localizedName);
+    if(compiled)
+    {
+      return compiled;
+    }
+  }
+
+  qCritical("TemplateCache: cannot find template %s", qPrintable(templateName));
+  return CompiledTemplatePtr();
+}
+
+Template TemplateLoader::getTemplate(QString templateName, QString locales)
+{
+  foreach(const QString& localizedName, localizedNames(templateName, locales))
+  {
+    QString document = tryFile(localizedName);
+    if(!document.isEmpty())
+    {
+      return Template(document, localizedName);
+    }
   }
 
   qCritical("TemplateCache: cannot find template %s", qPrintable(templateName));
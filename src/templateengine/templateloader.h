@@ -12,6 +12,7 @@
 #include <QMutex>
 #include "templateglobal.h"
 #include "template.h"
+#include "compiledtemplate.h"
 
 namespace stefanfrings {
 
@@ -65,6 +66,14 @@ public:
    */
   Template getTemplate(const QString templateName, const QString locales = QString());
 
+  /**
+   *  Get a compiled template for a given locale. The same file is searched as for getTemplate().
+   *  Render it with CompiledTemplate::render() instead of modifying a Template.
+   *  This method is thread safe.
+   *  @return The compiled template or null if it cannot be loaded.
+   */
+  CompiledTemplatePtr getCompiledTemplate(const QString templateName, const QString locales = QString());
+
 protected:
   /**
    *  Try to get a file from cache or filesystem.
@@ -73,6 +82,19 @@ protected:
    */
   virtual QString tryFile(const QString localizedName);
 
+  /**
+   *  Try to get a file and compile it.
+   *  @param localizedName Name of the template with locale to find
+   *  @return The compiled template, or null if not found
+   */
+  virtual CompiledTemplatePtr tryCompiledFile(const QString localizedName);
+
+  /**
+   *  Names of the files to search for a template in the order of preference.
+   *  @see getTemplate()
+   */
+  QStringList localizedNames(const QString templateName, const QString locales) const;
+
   /** Directory where the templates are searched */
   QString templatePath;
 
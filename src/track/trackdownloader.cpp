@@ -19,14 +19,63 @@
 
 #include "track/trackreader.h"
 #include "util/httpdownloader.h"
+#include "util/taskscheduler.h"
 
 #include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
 
 using atools::util::HttpDownloader;
 
 namespace atools {
 namespace track {
 
+/* Result of a parser task */
+struct TrackParseResult
+{
+  atools::track::TrackVectorType tracks;
+  QString error;
+  int generation = 0;
+};
+
+/* Shared between the downloader and parser tasks. owner is set to null when the downloader is deleted. */
+struct TrackParseState
+{
+  QMutex mutex;
+  TrackDownloader *owner = nullptr;
+  QHash<atools::track::TrackType, TrackParseResult> results;
+};
+
+namespace {
+
+/* Parse downloaded data and pass the result to the owner if still alive. Runs in a scheduler task. */
+void parseTracks(const QSharedPointer<TrackParseState>& state, const QByteArray& data, atools::track::TrackType type,
+                 int generation)
+{
+  TrackParseResult result;
+  result.generation = generation;
+  try
+  {
+    TrackReader reader;
+    reader.readTracks(data, type);
+    result.tracks = reader.getTracks();
+  }
+  catch(const std::exception& e)
+  {
+    result.error = QString::fromLocal8Bit(e.what());
+  }
+
+  QMutexLocker locker(&state->mutex);
+  if(state->owner != nullptr)
+  {
+    state->results.insert(type, result);
+    QMetaObject::invokeMethod(state->owner, "parseFinished", Qt::QueuedConnection,
+                              Q_ARG(int, static_cast<int>(type)));
+  }
+}
+
+} // namespace
+
 /* Public default values ====================================================== */
 const QHash<atools::track::TrackType, QString> TrackDownloader::URL =
 {
@@ -69,8 +118,10 @@ const QHash<atools::track::TrackType, QStringList> TrackDownloader::PARAM =
 };
 
 TrackDownloader::TrackDownloader(QObject *parent, bool logVerbose)
-  : QObject(parent), verbose(logVerbose)
+  : QObject(parent), verbose(logVerbose), parseState(new TrackParseState)
 {
+  parseState->owner = this;
+
   // Initialize NAT downloader ============================================================
   HttpDownloader *natDownloader = new HttpDownloader(parent, verbose);
   natDownloader->setUrl(URL.value(NAT));
@@ -104,9 +155,51 @@ TrackDownloader::TrackDownloader(QObject *parent, bool logVerbose)
 
 TrackDownloader::~TrackDownloader()
 {
+  {
+    // Running parser tasks drop their results
+    QMutexLocker locker(&parseState->mutex);
+    parseState->owner = nullptr;
+  }
   qDeleteAll(downloaders);
 }
 
+void TrackDownloader::startParse(const QByteArray& data, TrackType type)
+{
+  QSharedPointer<TrackParseState> state = parseState;
+  int generation = generations.value(type);
+  atools::util::TaskScheduler::instance().run([state, data, type, generation]() {
+        parseTracks(state, data, type, generation);
+      });
+}
+
+void TrackDownloader::parseFinished(int typeParam)
+{
+  TrackType type = static_cast<TrackType>(typeParam);
+  TrackParseResult result;
+  {
+    QMutexLocker locker(&parseState->mutex);
+    if(!parseState->results.contains(type))
+      // Already taken by an earlier call
+      return;
+    result = parseState->results.take(type);
+  }
+
+  if(result.generation != generations.value(type))
+    // Canceled or started again in the meantime
+    return;
+
+  if(!result.error.isEmpty())
+  {
+    emit trackDownloadFailed(result.error, 0, downloaders.value(type)->getUrl(), type);
+    return;
+  }
+
+  changed.insert(type, result.tracks != trackList.value(type));
+  trackList[type] = result.tracks;
+
+  emit trackDownloadFinished(trackList.value(type), type);
+}
+
 void TrackDownloader::natDownloadFinished(const QByteArray& data, QString)
 {
 #ifdef DEBUG_TRACK_TEST_SAVE
@@ -118,11 +211,7 @@ void TrackDownloader::natDownloadFinished(const QByteArray& data, QString)
   }
 #endif
 
-  TrackReader reader;
-  reader.readTracks(data, NAT);
-  trackList[NAT] = reader.getTracks();
-
-  emit trackDownloadFinished(trackList.value(NAT), NAT);
+  startParse(data, NAT);
 }
 
 void TrackDownloader::pacotsDownloadFinished(const QByteArray& data, QString)
@@ -136,11 +225,7 @@ void TrackDownloader::pacotsDownloadFinished(const QByteArray& data, QString)
   }
 #endif
 
-  TrackReader reader;
-  reader.readTracks(data, PACOTS);
-  trackList[PACOTS] = reader.getTracks();
-
-  emit trackDownloadFinished(trackList.value(PACOTS), PACOTS);
+  startParse(data, PACOTS);
 }
 
 void TrackDownloader::ausotsDownloadFinished(const QByteArray& data, QString)
@@ -154,11 +239,7 @@ void TrackDownloader::ausotsDownloadFinished(const QByteArray& data, QString)
   }
 #endif
 
-  TrackReader reader;
-  reader.readTracks(data, AUSOTS);
-  trackList[AUSOTS] = reader.getTracks();
-
-  emit trackDownloadFinished(trackList.value(AUSOTS), AUSOTS);
+  startParse(data, AUSOTS);
 }
 
 void TrackDownloader::natDownloadFailed(const QString& error, int errorCode, QString downloadUrl)
@@ -195,19 +276,23 @@ void TrackDownloader::setUrl(TrackType type, const QString& url, const QStringLi
 
 void TrackDownloader::startAllDownloads()
 {
-  for(HttpDownloader *downloader : downloaders.values())
-    downloader->startDownload();
+  for(TrackType type : downloaders.keys())
+    startDownload(type);
 }
 
 void TrackDownloader::startDownload(TrackType type)
 {
+  generations[type]++;
   downloaders[type]->startDownload();
 }
 
 void TrackDownloader::cancelAllDownloads()
 {
-  for(HttpDownloader *downloader : downloaders.values())
-    downloader->cancelDownload();
+  for(TrackType type : downloaders.keys())
+  {
+    generations[type]++;
+    downloaders.value(type)->cancelDownload();
+  }
 }
 
 const atools::track::TrackVectorType& TrackDownloader::getTracks(TrackType type)
@@ -218,7 +303,10 @@ const atools::track::TrackVectorType& TrackDownloader::getTracks(TrackType type)
 void TrackDownloader::clearTracks()
 {
   for(atools::track::TrackType key : trackList.keys())
+  {
     trackList[key].clear();
+    changed.remove(key);
+  }
 }
 
 bool TrackDownloader::hasAnyTracks()
@@ -248,5 +336,17 @@ void TrackDownloader::setIgnoreSslErrors(bool value)
     downloader->setIgnoreSslErrors(value);
 }
 
+void TrackDownloader::setDiskCache(atools::util::HttpCache *cache)
+{
+  for(HttpDownloader *downloader : downloaders.values())
+    downloader->setDiskCache(cache);
+}
+
+void TrackDownloader::setScheduler(atools::util::HttpScheduler *scheduler)
+{
+  for(HttpDownloader *downloader : downloaders.values())
+    downloader->setScheduler(scheduler, atools::util::PRIORITY_NORMAL);
+}
+
 } // namespace track
 } // namespace atools
@@ -21,13 +21,18 @@
 #include "track/tracktypes.h"
 
 #include <QObject>
+#include <QSharedPointer>
 
 namespace atools {
 namespace util {
 class HttpDownloader;
+class HttpCache;
+class HttpScheduler;
 }
 namespace track {
 
+struct TrackParseState;
+
 /*
  * Downloads HTML pages asynchronously from various services for NAT, AUSOTS and PACOTS and fills a list
  * of Track objects.
@@ -37,6 +42,9 @@ namespace track {
  * NAT: https://notams.aim.faa.gov/nat.html
  * PACOTS: https://www.notams.faa.gov/dinsQueryWeb/advancedNotamMapAction.do
  *         Uses POST with parameters "queryType=pacificTracks&actionType=advancedNOTAMFunctions"
+ *
+ * Downloaded pages are parsed by the shared task scheduler. Signals are emitted in the thread of this object once
+ * parsing is done. Results of downloads which were canceled or restarted in the meantime are dropped.
  */
 class TrackDownloader :
   public QObject
@@ -65,6 +73,13 @@ public:
   /* Remove downloaded tracks. */
   void clearTracks();
 
+  /* true if the tracks of the last download differ from the ones of the download before.
+   * Allows to skip rebuilding the track database and the route network if nothing changed. */
+  bool hasChanged(atools::track::TrackType type) const
+  {
+    return changed.value(type, true);
+  }
+
   /* true if any track or a track for the given type exists. */
   bool hasAnyTracks();
   bool hasTracks(atools::track::TrackType type);
@@ -81,6 +96,13 @@ public:
    * Sets value to all downloaders. */
   void setIgnoreSslErrors(bool value);
 
+  /* Use the persistent disk cache for all GET downloads. POST requests like PACOTS are not cached.
+   * Cache is not owned. Set to null to disable. */
+  void setDiskCache(atools::util::HttpCache *cache);
+
+  /* Use the shared download scheduler. Scheduler is not owned. Set to null to disable. */
+  void setScheduler(atools::util::HttpScheduler *scheduler);
+
 signals:
   /* Emitted when HTML page was downloaded and parsed */
   void trackDownloadFinished(const atools::track::TrackVectorType& tracks, atools::track::TrackType type);
@@ -92,6 +114,12 @@ signals:
   void trackDownloadSslErrors(const QStringList& errors, const QString& downloadUrl);
 
 private:
+  /* Called from the parser task through the event queue */
+  Q_INVOKABLE void parseFinished(int type);
+
+  /* Start parser task for downloaded data */
+  void startParse(const QByteArray& data, atools::track::TrackType type);
+
   void natDownloadFinished(const QByteArray & data, QString);
   void pacotsDownloadFinished(const QByteArray & data, QString);
   void ausotsDownloadFinished(const QByteArray & data, QString);
@@ -106,6 +134,15 @@ private:
   /* List of tracks for each type */
   QHash<atools::track::TrackType, atools::track::TrackVectorType> trackList;
 
+  /* Result of last download differs from the one before */
+  QHash<atools::track::TrackType, bool> changed;
+
+  /* Incremented when a download is started or canceled. Parse results of older generations are dropped. */
+  QHash<atools::track::TrackType, int> generations;
+
+  /* Shared with running parser tasks */
+  QSharedPointer<TrackParseState> parseState;
+
   bool verbose = false;
 };
 
@@ -91,6 +91,18 @@ struct Track
     return typeToString(type);
   }
 
+  bool operator==(const Track& other) const
+  {
+    return name == other.name && type == other.type && direction == other.direction && route == other.route &&
+           eastLevels == other.eastLevels && westLevels == other.westLevels && validFrom == other.validFrom &&
+           validTo == other.validTo;
+  }
+
+  bool operator!=(const Track& other) const
+  {
+    return !operator==(other);
+  }
+
 };
 
 typedef QVector<atools::track::Track> TrackVectorType;
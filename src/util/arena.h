@@ -0,0 +1,120 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_ARENA_H
+#define ATOOLS_UTIL_ARENA_H
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace atools {
+namespace util {
+
+/*
+ * Monotonic allocator which hands out memory from large blocks and frees all at once.
+ * Useful for large numbers of short living objects which are all deleted together.
+ *
+ * Memory is not freed for single objects. reset() makes all memory available again and keeps the blocks
+ * for reuse. Destructors are not called by the arena and have to be called by the owner before reset().
+ *
+ * Not thread safe.
+ */
+class Arena
+{
+public:
+  explicit Arena(std::size_t blockSizeParam = 64 * 1024)
+    : blockSize(blockSizeParam)
+  {
+  }
+
+  ~Arena()
+  {
+    for(Block& block : blocks)
+      delete[] block.data;
+  }
+
+  Arena(const Arena& other) = delete;
+  Arena& operator=(const Arena& other) = delete;
+
+  /* Get uninitialized memory. Alignment must not exceed the one of std::max_align_t. */
+  void *allocate(std::size_t size, std::size_t alignment)
+  {
+    Q_ASSERT(alignment <= alignof(std::max_align_t));
+
+    std::size_t start = (pos + alignment - 1) & ~(alignment - 1);
+    while(current >= blocks.size() || start + size > blocks.at(current).size)
+    {
+      if(current < blocks.size())
+        // Does not fit into current block - try next one
+        current++;
+
+      if(current == blocks.size())
+      {
+        // Reserve space for large objects
+        std::size_t newSize = std::max(blockSize, size);
+        blocks.push_back({new char[newSize], newSize});
+      }
+      start = pos = 0;
+    }
+
+    pos = start + size;
+    return blocks.at(current).data + start;
+  }
+
+  /* Allocate and construct an object. Destructor has to be called explicitly. */
+  template<typename TYPE, typename ... ARGS>
+  TYPE *create(ARGS&& ... args)
+  {
+    return new (allocate(sizeof(TYPE), alignof(TYPE)))TYPE(std::forward<ARGS>(args) ...);
+  }
+
+  /* Make all memory available again. Keeps blocks. */
+  void reset()
+  {
+    current = pos = 0;
+  }
+
+  /* Size of all blocks in bytes */
+  std::size_t getReservedBytes() const
+  {
+    std::size_t size = 0;
+    for(const Block& block : blocks)
+      size += block.size;
+    return size;
+  }
+
+private:
+  struct Block
+  {
+    char *data;
+    std::size_t size;
+  };
+
+  std::vector<Block> blocks;
+  std::size_t blockSize, current = 0, pos = 0;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_ARENA_H
@@ -0,0 +1,306 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/csvfilereader.h"
+
+#include <QDebug>
+#include <QFile>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ATOOLS_CSV_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace atools {
+namespace util {
+
+#ifdef ATOOLS_CSV_SSE2
+static inline int countTrailingZeros(unsigned int value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+#endif
+
+CsvFileReader::CsvFileReader(char separatorChar, char escapeChar, bool trimValues)
+  : separator(separatorChar), escape(escapeChar), trim(trimValues)
+{
+
+}
+
+CsvFileReader::~CsvFileReader()
+{
+  close();
+}
+
+void CsvFileReader::open(QFile *file)
+{
+  close();
+
+  qint64 fileSize = file->size() - file->pos();
+  if(fileSize > 0)
+    mapped = file->map(file->pos(), fileSize);
+
+  if(mapped != nullptr)
+  {
+    mappedFile = file;
+    data = reinterpret_cast<const char *>(mapped);
+    size = fileSize;
+  }
+  else
+  {
+    // Fall back to reading the whole file
+    buffer = file->readAll();
+    data = buffer.constData();
+    size = buffer.size();
+  }
+
+  // Skip UTF-8 byte order mark
+  if(size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    pos = 3;
+}
+
+void CsvFileReader::open(const QString& text)
+{
+  close();
+  buffer = text.toUtf8();
+  data = buffer.constData();
+  size = buffer.size();
+}
+
+void CsvFileReader::close()
+{
+  if(mappedFile != nullptr && mapped != nullptr)
+    mappedFile->unmap(mapped);
+
+  mappedFile = nullptr;
+  mapped = nullptr;
+  buffer.clear();
+  data = recordData = nullptr;
+  size = pos = 0L;
+  recordSize = lineNumber = recordLineNumber = 0;
+  fields.clear();
+}
+
+const char *CsvFileReader::findSpecial(const char *cur, const char *end) const
+{
+#ifdef ATOOLS_CSV_SSE2
+  const __m128i sep = _mm_set1_epi8(separator), esc = _mm_set1_epi8(escape), lf = _mm_set1_epi8('\n');
+  while(end - cur >= 16)
+  {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cur));
+    __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, sep), _mm_cmpeq_epi8(chunk, esc)),
+                                 _mm_cmpeq_epi8(chunk, lf));
+    unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(found));
+    if(mask != 0)
+      return cur + countTrailingZeros(mask);
+    cur += 16;
+  }
+#endif
+
+  // Remaining bytes
+  while(cur < end && *cur != separator && *cur != escape && *cur != '\n')
+    cur++;
+  return cur;
+}
+
+bool CsvFileReader::readRecord()
+{
+  // Keeps allocated memory
+  fields.resize(0);
+
+  // Skip empty lines
+  while(pos < size)
+  {
+    if(data[pos] == '\n')
+      pos++;
+    else if(data[pos] == '\r' && pos + 1 < size && data[pos + 1] == '\n')
+      pos += 2;
+    else
+      break;
+    lineNumber++;
+  }
+
+  if(atEnd())
+  {
+    recordData = nullptr;
+    recordSize = 0;
+    return false;
+  }
+
+  const char *cur = data + pos, *end = data + size, *fieldStart = cur, *recordEnd = end;
+  recordData = cur;
+  recordLineNumber = lineNumber;
+  bool inEscape = false, fieldEscaped = false;
+
+  while(true)
+  {
+    if(inEscape)
+    {
+      // Skip escaped text which can contain line feeds
+      const char *next = static_cast<const char *>(std::memchr(cur, escape, static_cast<size_t>(end - cur)));
+      const char *escapedEnd = next != nullptr ? next : end;
+      for(const char *c = cur; c < escapedEnd; c++)
+      {
+        if(*c == '\n')
+          lineNumber++;
+      }
+
+      if(next == nullptr)
+      {
+        qWarning() << Q_FUNC_INFO << "Escaped text not closed at line" << recordLineNumber + 1;
+        addField(fieldStart, end, true);
+        cur = end;
+        break;
+      }
+
+      inEscape = false;
+      cur = next + 1;
+      continue;
+    }
+
+    const char *next = findSpecial(cur, end);
+    if(next == end)
+    {
+      // Last line without line feed
+      addField(fieldStart, end, fieldEscaped);
+      cur = end;
+      break;
+    }
+
+    if(*next == escape)
+    {
+      inEscape = fieldEscaped = true;
+      cur = next + 1;
+    }
+    else if(*next == separator)
+    {
+      addField(fieldStart, next, fieldEscaped);
+      fieldEscaped = false;
+      cur = fieldStart = next + 1;
+    }
+    else
+    {
+      // Line feed ends the record - remove carriage return
+      recordEnd = next;
+      if(recordEnd > fieldStart && *(recordEnd - 1) == '\r')
+        recordEnd--;
+      addField(fieldStart, recordEnd, fieldEscaped);
+      lineNumber++;
+      cur = next + 1;
+      break;
+    }
+  }
+
+  recordSize = static_cast<int>(recordEnd - recordData);
+  pos = cur - data;
+  return true;
+}
+
+void CsvFileReader::addField(const char *start, const char *end, bool escaped)
+{
+  if(trim && !escaped)
+  {
+    while(start < end && isSpace(*start))
+      start++;
+    while(end > start && isSpace(*(end - 1)))
+      end--;
+  }
+
+  CsvField field;
+  field.data = start;
+  field.size = static_cast<int>(end - start);
+  field.escaped = escaped;
+  fields.append(field);
+}
+
+QString CsvFileReader::value(int index) const
+{
+  if(index < 0 || index >= fields.size())
+    return QString();
+
+  const CsvField& field = fields.at(index);
+  return field.escaped ? unescape(field) : QString::fromUtf8(field.data, field.size);
+}
+
+QString CsvFileReader::unescape(const CsvField& field) const
+{
+  // Same state machine as CsvReader
+  QByteArray bytes;
+  bytes.reserve(field.size);
+  bool inEscape = false;
+  char lastChar = '\0';
+  const char *end = field.data + field.size;
+  for(const char *cur = field.data; cur < end; cur++)
+  {
+    char c = *cur;
+    if(c == escape)
+    {
+      if(inEscape)
+        // End of escaped text
+        inEscape = false;
+      else
+      {
+        if(lastChar == escape)
+          // Escape char itself doubled "" - add single escape " to value and keep escaped state
+          bytes.append(c);
+        inEscape = true;
+      }
+    }
+    else if(!(c == '\r' && cur + 1 < end && *(cur + 1) == '\n'))
+      // Line ends in escaped text are added as a single line feed
+      bytes.append(c);
+    lastChar = c;
+  }
+  return QString::fromUtf8(bytes);
+}
+
+void CsvFileReader::values(QStringList& valueList) const
+{
+  for(int i = 0; i < fields.size(); i++)
+  {
+    if(i < valueList.size())
+      valueList[i] = value(i);
+    else
+      valueList.append(value(i));
+  }
+
+  while(valueList.size() > fields.size())
+    valueList.removeLast();
+}
+
+QStringList CsvFileReader::values() const
+{
+  QStringList valueList;
+  values(valueList);
+  return valueList;
+}
+
+} // namespace util
+} // namespace atools
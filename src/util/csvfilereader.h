@@ -0,0 +1,148 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_CSVFILEREADER_H
+#define ATOOLS_UTIL_CSVFILEREADER_H
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+
+class QFile;
+
+namespace atools {
+namespace util {
+
+/* View of a field in the buffer of CsvFileReader. Only valid until the next call of readRecord(). */
+struct CsvField
+{
+  const char *data = nullptr;
+  int size = 0;
+
+  /* Field contains escape characters which have to be removed on conversion */
+  bool escaped = false;
+};
+
+/*
+ * Fast CSV reader working on the raw UTF-8 bytes of a memory mapped file.
+ * Uses the same rules as CsvReader: escaped text can contain separators and line feeds, doubled escape characters
+ * are added as single ones and trimming is only done for values which are not escaped.
+ * Empty lines outside of escaped text are ignored.
+ *
+ * Delimiters are found by scanning 16 bytes at once with SSE2 if available. Escaped text is skipped using memchr.
+ * Fields are returned as views into the buffer and only converted to QString on request.
+ */
+class CsvFileReader
+{
+public:
+  /* trimValues: Trims only text which is not escaped */
+  CsvFileReader(char separatorChar = ',', char escapeChar = '"', bool trimValues = true);
+  ~CsvFileReader();
+
+  CsvFileReader(const CsvFileReader& other) = delete;
+  CsvFileReader& operator=(const CsvFileReader& other) = delete;
+
+  /* Memory maps the opened file or reads it into memory if mapping is not possible. Skips a UTF-8 BOM. */
+  void open(QFile *file);
+
+  /* Use already decoded text. Converts to UTF-8 internally. */
+  void open(const QString& text);
+
+  void close();
+
+  bool atEnd() const
+  {
+    return pos >= size;
+  }
+
+  /* Read next record which can span multiple lines. Returns false if at end. */
+  bool readRecord();
+
+  int getNumFields() const
+  {
+    return fields.size();
+  }
+
+  const CsvField& getField(int index) const
+  {
+    return fields.at(index);
+  }
+
+  /* Field converted to QString. Empty if index is out of range. */
+  QString value(int index) const;
+
+  /* Fill list with all field values like CsvReader::getValues(). Reuses the strings in the list. */
+  void values(QStringList& valueList) const;
+  QStringList values() const;
+
+  /* Raw text of the current record without the final line end */
+  QString record() const
+  {
+    return QString::fromUtf8(recordData, recordSize);
+  }
+
+  /* Line number of the first line of the current record starting at 0 */
+  int getLineNumber() const
+  {
+    return recordLineNumber;
+  }
+
+  /* Current byte position in the buffer for progress reports */
+  qint64 getPosition() const
+  {
+    return pos;
+  }
+
+  qint64 getSize() const
+  {
+    return size;
+  }
+
+private:
+  static bool isSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  /* Find next separator, escape or line feed or end */
+  const char *findSpecial(const char *cur, const char *end) const;
+
+  /* Add field between start and end and trim if needed */
+  void addField(const char *start, const char *end, bool escaped);
+
+  /* Convert escaped field */
+  QString unescape(const CsvField& field) const;
+
+  char separator = ',', escape = '"';
+  bool trim = true;
+
+  QFile *mappedFile = nullptr;
+  uchar *mapped = nullptr;
+  QByteArray buffer;
+
+  const char *data = nullptr, *recordData = nullptr;
+  qint64 size = 0L, pos = 0L;
+  int recordSize = 0, lineNumber = 0, recordLineNumber = 0;
+
+  QVector<CsvField> fields;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_CSVFILEREADER_H
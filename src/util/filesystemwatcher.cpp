@@ -19,6 +19,7 @@
 
 #include "atools.h"
 
+#include <QDir>
 #include <QFileInfo>
 #include <QRegularExpression>
 #include <QTextStream>
@@ -48,6 +49,77 @@ void FileSystemWatcher::stopWatching()
 {
   deleteFsWatcher();
   filename.clear();
+  directory.clear();
+  nameFilters.clear();
+  fileStates.clear();
+  changedFiles.clear();
+}
+
+void FileSystemWatcher::startDelay()
+{
+  if(!delayTimer.isActive())
+    delayStart.start();
+
+  if(!delayTimer.isActive() || delayStart.elapsed() + delayMs <= maxDelayMs)
+    // Start or extend the delayed notification
+    delayTimer.start(delayMs);
+  // else leave running timer to avoid postponing the notification forever
+}
+
+QStringList FileSystemWatcher::getDirectoryFiles() const
+{
+  QStringList files;
+  if(!directory.isEmpty())
+  {
+    for(const QFileInfo& fileinfo : QDir(directory).entryInfoList(nameFilters, QDir::Files, QDir::Name))
+      files.append(fileinfo.filePath());
+  }
+  return files;
+}
+
+void FileSystemWatcher::checkDirectory()
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << directory;
+
+  for(const QFileInfo& fileinfo : QDir(directory).entryInfoList(nameFilters, QDir::Files, QDir::Name))
+  {
+    if(fileinfo.size() <= minFileSize)
+      continue;
+
+    QPair<QDateTime, qint64> state = fileStates.value(fileinfo.filePath());
+    if(!state.first.isValid() || state.first != fileinfo.lastModified() || state.second != fileinfo.size())
+      changedFiles.insert(fileinfo.filePath());
+  }
+
+  if(!changedFiles.isEmpty())
+    startDelay();
+}
+
+void FileSystemWatcher::directoryUpdatedDelayed()
+{
+  QStringList files;
+  for(const QString& file : changedFiles)
+  {
+    QFileInfo fileinfo(file);
+    if(fileinfo.exists() && fileinfo.isFile() && fileinfo.size() > minFileSize)
+    {
+      // Remember file size and timestamp of the file
+      fileStates.insert(file, qMakePair(fileinfo.lastModified(), fileinfo.size()));
+      files.append(file);
+    }
+  }
+  changedFiles.clear();
+
+  if(!files.isEmpty())
+  {
+    files.sort();
+
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << files;
+
+    emit filesUpdated(files);
+  }
 }
 
 /* Called on directory or file change and QTimer event */
@@ -58,6 +130,14 @@ void FileSystemWatcher::pathOrFileChanged()
 
   periodicCheckTimer.stop();
 
+  if(!directory.isEmpty())
+  {
+    // Directory mode ===============================
+    checkDirectory();
+    periodicCheckTimer.start(checkMs);
+    return;
+  }
+
   QFileInfo fileinfo(filename);
   if(fileinfo.exists())
   {
@@ -80,8 +160,7 @@ void FileSystemWatcher::pathOrFileChanged()
           if(verbose)
             qDebug() << Q_FUNC_INFO << "changed" << filename;
 
-          // Start or extend the delayed notification
-          delayTimer.start(delayMs);
+          startDelay();
         }
         else
         {
@@ -121,6 +200,13 @@ void FileSystemWatcher::fileUpdatedDelayed()
   if(verbose)
     qDebug() << Q_FUNC_INFO;
 
+  if(!directory.isEmpty())
+  {
+    directoryUpdatedDelayed();
+    periodicCheckTimer.start(checkMs);
+    return;
+  }
+
   QFileInfo fileinfo(filename);
   if(fileinfo.exists() && fileinfo.isFile() && fileinfo.size() > minFileSize)
   {
@@ -144,6 +230,17 @@ void FileSystemWatcher::setFilenameAndStart(const QString& value)
   createFsWatcher();
 }
 
+void FileSystemWatcher::setDirectoryAndStart(const QString& dir, const QStringList& filters)
+{
+  qDebug() << Q_FUNC_INFO << dir << filters;
+
+  stopWatching();
+  directory = dir;
+  nameFilters = filters;
+
+  createFsWatcher();
+}
+
 void FileSystemWatcher::deleteFsWatcher()
 {
   delayTimer.stop();
@@ -173,11 +270,19 @@ void FileSystemWatcher::createFsWatcher()
   setPaths(false);
 
   // Initialize size and timestamp which will omit the first update signal - user has to do the initial load
-  QFileInfo fileinfo(filename);
-  if(fileinfo.exists() && fileinfo.isFile())
+  if(!directory.isEmpty())
   {
-    fileTimestampLastRead = fileinfo.lastModified();
-    lastFileSizeRead = fileinfo.size();
+    for(const QFileInfo& fileinfo : QDir(directory).entryInfoList(nameFilters, QDir::Files))
+      fileStates.insert(fileinfo.filePath(), qMakePair(fileinfo.lastModified(), fileinfo.size()));
+  }
+  else
+  {
+    QFileInfo fileinfo(filename);
+    if(fileinfo.exists() && fileinfo.isFile())
+    {
+      fileTimestampLastRead = fileinfo.lastModified();
+      lastFileSizeRead = fileinfo.size();
+    }
   }
 
   // Check every ten seconds since the watcher is unreliable
@@ -187,11 +292,23 @@ void FileSystemWatcher::createFsWatcher()
 
 void FileSystemWatcher::setPaths(bool update)
 {
+  if(fsWatcher == nullptr)
+    return;
+
   if(verbose)
     qDebug() << Q_FUNC_INFO << filename << "files" << fsWatcher->files() << "dirs" << fsWatcher->directories();
 
-  if(fsWatcher == nullptr)
+  if(!directory.isEmpty())
+  {
+    // Watch only the directory which notifies about added, removed and renamed files
+    // Changed files are found by the periodic check
+    if(!fsWatcher->directories().contains(directory) && !fsWatcher->addPath(directory))
+    {
+      if(warn())
+        qWarning() << "cannot watch dir" << directory;
+    }
     return;
+  }
 
   // Watch file to get changes
   if(!fsWatcher->files().contains(filename))
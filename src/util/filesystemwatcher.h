@@ -19,6 +19,10 @@
 #define ATOOLS_UTIL_FILESYSTEMWATCHER_H
 
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
 #include <QTimer>
 
 class QFileSystemWatcher;
@@ -31,6 +35,9 @@ namespace util {
  * the process by checking size and timestamp.
  *
  * Notifications are sent with a delay to catch intermediate changes.
+ *
+ * Can also watch all files matching a filter in a directory. Size and timestamp are tracked for each file and
+ * changes of several files within the delay are sent as one notification.
  */
 class FileSystemWatcher
   : public QObject
@@ -49,6 +56,13 @@ public:
   /* Set file and start watching. Does not emit an initial message. */
   void setFilenameAndStart(const QString& value);
 
+  /* Watch all files in directory matching the name filters like "*.txt". Emits filesUpdated with all new or
+   * changed files. Does not emit an initial message. */
+  void setDirectoryAndStart(const QString& directory, const QStringList& filters);
+
+  /* Files in directory matching the filters. Empty if not watching a directory. */
+  QStringList getDirectoryFiles() const;
+
   /* Stop all notifications and watching */
   void stopWatching();
 
@@ -74,9 +88,23 @@ public:
     delayMs = value;
   }
 
+  int getMaxDelayMs() const
+  {
+    return maxDelayMs;
+  }
+
+  /* Each change extends the delay but the signal is sent not later than this after the first change */
+  void setMaxDelayMs(int value)
+  {
+    maxDelayMs = value;
+  }
+
 signals:
   void fileUpdated(const QString& filename);
 
+  /* Sent in directory mode with all files changed or added since the last signal */
+  void filesUpdated(const QStringList& filenames);
+
 private:
   void deleteFsWatcher();
   void createFsWatcher();
@@ -85,18 +113,37 @@ private:
   void setPaths(bool update);
   bool warn();
 
+  /* Start or extend delay timer for notification */
+  void startDelay();
+
+  /* Compare files in directory with last state and collect changed ones */
+  void checkDirectory();
+  void directoryUpdatedDelayed();
+
   QString filename;
   QDateTime fileTimestampLastRead;
   qint64 lastFileSizeRead = 0;
   QFileSystemWatcher *fsWatcher = nullptr;
   QTimer periodicCheckTimer, delayTimer;
 
+  /* Time since first change for the current delay */
+  QElapsedTimer delayStart;
+
+  /* Directory mode. Maps file path to last modification time and size as last sent. */
+  QString directory;
+  QStringList nameFilters;
+  QHash<QString, QPair<QDateTime, qint64> > fileStates;
+  QSet<QString> changedFiles;
+
   /* Need at least one megabyte to be valid */
   int minFileSize = 1024 * 1024;
 
   /* Delay event about two seconds to catch intermediate changes renamed files, etc. */
   int delayMs = 2000;
 
+  /* Send signal at the latest after ten seconds if changes keep coming */
+  int maxDelayMs = 10000;
+
   /* Additionally check every ten seconds for changes */
   int checkMs = 10000;
 
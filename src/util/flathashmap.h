@@ -0,0 +1,238 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_FLATHASHMAP_H
+#define ATOOLS_UTIL_FLATHASHMAP_H
+
+#include <QString>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace atools {
+namespace util {
+
+/*
+ * Pack up to eight Latin1 characters into an integer. Longer strings are truncated.
+ * Case is kept. The empty string gives 0.
+ * Allows to use short idents like ICAO codes, runway names or navaid idents as compact hash keys.
+ */
+inline quint64 packIdent(const QString& str)
+{
+  quint64 value = 0;
+  int size = std::min(str.size(), 8);
+  for(int i = 0; i < size; i++)
+    value |= static_cast<quint64>(static_cast<uchar>(str.at(i).toLatin1())) << (i * 8);
+  return value;
+}
+
+/* Reverse of packIdent() */
+inline QString unpackIdent(quint64 value)
+{
+  QString str;
+  for(int i = 0; i < 8 && (value >> (i * 8)) != 0; i++)
+    str.append(QLatin1Char(static_cast<char>((value >> (i * 8)) & 0xff)));
+  return str;
+}
+
+/* Hash functions for FlatHashMap. Keys are mixed since only the lowest bits are used for the bucket index. */
+template<typename KEY>
+struct FlatHash;
+
+template<>
+struct FlatHash<quint64>
+{
+  std::size_t operator()(quint64 key) const
+  {
+    // Finalizer of splitmix64
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return static_cast<std::size_t>(key);
+  }
+};
+
+template<std::size_t N>
+struct FlatHash<std::array<quint64, N> >
+{
+  std::size_t operator()(const std::array<quint64, N>& key) const
+  {
+    quint64 value = 0;
+    for(quint64 k : key)
+      value = value * 31 + k;
+    return FlatHash<quint64>()(value);
+  }
+};
+
+/*
+ * Hash map using open addressing with linear probing in flat arrays. Avoids the node allocations of QHash
+ * and is much faster for small primitive keys like the ones given by packIdent().
+ *
+ * Entries cannot be removed. Capacity is a power of two and the map is kept at most half full.
+ * KEY and VALUE need default constructors. Not thread safe.
+ */
+template<typename KEY, typename VALUE, typename HASH = FlatHash<KEY> >
+class FlatHashMap
+{
+public:
+  /* Insert or replace value */
+  void insert(const KEY& key, const VALUE& value)
+  {
+    if((numEntries + 1) * 2 > keys.size())
+      rehash(std::max(keys.size() * 2, static_cast<std::size_t>(16)));
+
+    std::size_t index = findSlot(key);
+    if(!used[index])
+    {
+      used[index] = true;
+      keys[index] = key;
+      numEntries++;
+    }
+    values[index] = value;
+  }
+
+  bool contains(const KEY& key) const
+  {
+    return numEntries > 0 && used[findSlot(key)];
+  }
+
+  /* Get value or defaultValue if key is not found */
+  VALUE value(const KEY& key, const VALUE& defaultValue = VALUE()) const
+  {
+    if(numEntries > 0)
+    {
+      std::size_t index = findSlot(key);
+      if(used[index])
+        return values[index];
+    }
+    return defaultValue;
+  }
+
+  /* Preallocate space for size entries */
+  void reserve(int size)
+  {
+    std::size_t capacity = 16;
+    while(capacity < static_cast<std::size_t>(size) * 2)
+      capacity *= 2;
+    if(capacity > keys.size())
+      rehash(capacity);
+  }
+
+  void clear()
+  {
+    keys.clear();
+    values.clear();
+    used.clear();
+    numEntries = 0;
+  }
+
+  int size() const
+  {
+    return static_cast<int>(numEntries);
+  }
+
+  bool isEmpty() const
+  {
+    return numEntries == 0;
+  }
+
+private:
+  /* Index of the entry for key or of the empty slot where it would be inserted */
+  std::size_t findSlot(const KEY& key) const
+  {
+    std::size_t mask = keys.size() - 1;
+    std::size_t index = HASH()(key) & mask;
+    while(used[index] && !(keys[index] == key))
+      index = (index + 1) & mask;
+    return index;
+  }
+
+  void rehash(std::size_t capacity)
+  {
+    std::vector<KEY> oldKeys(capacity);
+    std::vector<VALUE> oldValues(capacity);
+    std::vector<bool> oldUsed(capacity, false);
+    oldKeys.swap(keys);
+    oldValues.swap(values);
+    oldUsed.swap(used);
+
+    for(std::size_t i = 0; i < oldKeys.size(); i++)
+    {
+      if(oldUsed[i])
+      {
+        std::size_t index = findSlot(oldKeys[i]);
+        used[index] = true;
+        keys[index] = oldKeys[i];
+        values[index] = oldValues[i];
+      }
+    }
+  }
+
+  std::vector<KEY> keys;
+  std::vector<VALUE> values;
+  std::vector<bool> used;
+  std::size_t numEntries = 0;
+};
+
+/* Set based on FlatHashMap */
+template<typename KEY, typename HASH = FlatHash<KEY> >
+class FlatHashSet
+{
+public:
+  void insert(const KEY& key)
+  {
+    map.insert(key, true);
+  }
+
+  bool contains(const KEY& key) const
+  {
+    return map.contains(key);
+  }
+
+  void reserve(int size)
+  {
+    map.reserve(size);
+  }
+
+  void clear()
+  {
+    map.clear();
+  }
+
+  int size() const
+  {
+    return map.size();
+  }
+
+  bool isEmpty() const
+  {
+    return map.isEmpty();
+  }
+
+private:
+  FlatHashMap<KEY, bool, HASH> map;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_FLATHASHMAP_H
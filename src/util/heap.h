@@ -168,6 +168,226 @@ void Heap<TYPE, COST>::changeOrPush(const TYPE& data, COST cost)
   }
 }
 
+/*
+ * Binary min heap for integral data with a position map allowing O(1) lookups by contains() and
+ * O(log n) updates by change() and changeOrPush().
+ *
+ * Data values have to be in the range [-offset, size - offset) as given in resize().
+ * The position map uses one int per possible data value.
+ */
+template<typename COST>
+class IndexedHeap
+{
+public:
+  IndexedHeap(int reserve)
+  {
+    heap.reserve(static_cast<size_t>(reserve));
+  }
+
+  /* Clears the heap and prepares the position map for data values in range [-offset, size - offset) */
+  void resize(int size, int offset);
+
+  /* Remove all elements. Keeps position map size. */
+  void clear();
+
+  /* Take an element from the top of the heap. This will be the one with the lowest cost assigned */
+  COST pop(int& data);
+
+  /* Return data directly. */
+  int popData();
+
+  /* Get lowest cost without removing the element. Heap must not be empty. */
+  COST peekCost() const
+  {
+    return heap.front().cost;
+  }
+
+  void pop(int& data, COST& cost)
+  {
+    cost = pop(data);
+  }
+
+  /* Add element to the heap. Element must not be already contained in the heap. */
+  void push(int data, COST cost);
+
+  void pushData(int data, COST cost)
+  {
+    push(data, cost);
+  }
+
+  bool contains(int data) const
+  {
+    return positions.at(static_cast<size_t>(data + offset)) != INVALID_POS;
+  }
+
+  /* Update the costs of an element. The heap will be updated. Does nothing if element does not exist. */
+  void change(int data, COST cost);
+
+  /* Update the costs of an element or add it if not contained */
+  void changeOrPush(int data, COST cost);
+
+  bool isEmpty() const
+  {
+    return heap.empty();
+  }
+
+  int size() const
+  {
+    return static_cast<int>(heap.size());
+  }
+
+private:
+  struct HeapNode
+  {
+    int data;
+    COST cost;
+  };
+
+  enum
+  {
+    INVALID_POS = -1
+  };
+
+  int& position(int data)
+  {
+    return positions[static_cast<size_t>(data + offset)];
+  }
+
+  /* Move element up or down until heap order is restored */
+  void siftUp(int pos);
+  void siftDown(int pos);
+
+  /* Assign node to heap position and update position map */
+  void place(const HeapNode& node, int pos)
+  {
+    heap[static_cast<size_t>(pos)] = node;
+    position(node.data) = pos;
+  }
+
+  std::vector<HeapNode> heap;
+
+  /* Maps data plus offset to position in heap vector or INVALID_POS if not contained */
+  std::vector<int> positions;
+  int offset = 0;
+};
+
+template<typename COST>
+void IndexedHeap<COST>::resize(int size, int offsetParam)
+{
+  heap.clear();
+  offset = offsetParam;
+  positions.assign(static_cast<size_t>(size), INVALID_POS);
+}
+
+template<typename COST>
+void IndexedHeap<COST>::clear()
+{
+  for(const HeapNode& node : heap)
+    position(node.data) = INVALID_POS;
+  heap.clear();
+}
+
+template<typename COST>
+COST IndexedHeap<COST>::pop(int& data)
+{
+  HeapNode top = heap.front();
+  position(top.data) = INVALID_POS;
+
+  HeapNode last = heap.back();
+  heap.pop_back();
+
+  if(!heap.empty())
+  {
+    place(last, 0);
+    siftDown(0);
+  }
+
+  data = top.data;
+  return top.cost;
+}
+
+template<typename COST>
+int IndexedHeap<COST>::popData()
+{
+  int data;
+  pop(data);
+  return data;
+}
+
+template<typename COST>
+void IndexedHeap<COST>::push(int data, COST cost)
+{
+  heap.push_back({data, cost});
+  int pos = size() - 1;
+  position(data) = pos;
+  siftUp(pos);
+}
+
+template<typename COST>
+void IndexedHeap<COST>::change(int data, COST cost)
+{
+  int pos = position(data);
+  if(pos != INVALID_POS)
+  {
+    COST oldCost = heap[static_cast<size_t>(pos)].cost;
+    heap[static_cast<size_t>(pos)].cost = cost;
+
+    if(cost < oldCost)
+      siftUp(pos);
+    else
+      siftDown(pos);
+  }
+}
+
+template<typename COST>
+void IndexedHeap<COST>::changeOrPush(int data, COST cost)
+{
+  if(contains(data))
+    change(data, cost);
+  else
+    push(data, cost);
+}
+
+template<typename COST>
+void IndexedHeap<COST>::siftUp(int pos)
+{
+  HeapNode node = heap[static_cast<size_t>(pos)];
+  while(pos > 0)
+  {
+    int parent = (pos - 1) / 2;
+    if(!(node.cost < heap[static_cast<size_t>(parent)].cost))
+      break;
+
+    place(heap[static_cast<size_t>(parent)], pos);
+    pos = parent;
+  }
+  place(node, pos);
+}
+
+template<typename COST>
+void IndexedHeap<COST>::siftDown(int pos)
+{
+  int num = size();
+  HeapNode node = heap[static_cast<size_t>(pos)];
+  while(true)
+  {
+    int child = 2 * pos + 1;
+    if(child >= num)
+      break;
+
+    // Use the smaller of both children
+    if(child + 1 < num && heap[static_cast<size_t>(child + 1)].cost < heap[static_cast<size_t>(child)].cost)
+      child++;
+
+    if(!(heap[static_cast<size_t>(child)].cost < node.cost))
+      break;
+
+    place(heap[static_cast<size_t>(child)], pos);
+    pos = child;
+  }
+  place(node, pos);
+}
+
 } // namespace util
 } // namespace atools
 
@@ -24,6 +24,9 @@
 #include <QBuffer>
 #include <QIcon>
 #include <QRegularExpression>
+#include <QStringBuilder>
+
+#include <array>
 
 namespace atools {
 namespace util {
@@ -32,6 +35,43 @@ namespace util {
 static const QRegularExpression LINK_REGEXP(
   "\\b((http[s]?|ftp|file)://[a-zA-Z0-9\\./:_\\?\\&=\\-\\$\\+\\!\\*'\\(\\),;%#\\[\\]@]+)\\b");
 
+/* Replacements for ASCII characters in HTML text. Empty if the character is copied unchanged.
+ * Same as QString::toHtmlEscaped() and replacing newlines with <br/>. */
+static std::array<QLatin1String, 128> createEscapeTable()
+{
+  std::array<QLatin1String, 128> table;
+  table['<'] = QLatin1String("&lt;");
+  table['>'] = QLatin1String("&gt;");
+  table['&'] = QLatin1String("&amp;");
+  table['"'] = QLatin1String("&quot;");
+  table['\n'] = QLatin1String("<br/>");
+  return table;
+}
+
+static const std::array<QLatin1String, 128> ESCAPE_TABLE = createEscapeTable();
+
+/* Tags for HTML formatting flags in order of nesting */
+static const struct
+{
+  html::Flag flag;
+  QLatin1String begin, end;
+} TEXT_TAGS[] =
+{
+  {html::BOLD, QLatin1String("<b>"), QLatin1String("</b>")},
+  {html::ITALIC, QLatin1String("<i>"), QLatin1String("</i>")},
+  {html::UNDERLINE, QLatin1String("<u>"), QLatin1String("</u>")},
+  {html::STRIKEOUT, QLatin1String("<s>"), QLatin1String("</s>")},
+  {html::SUBSCRIPT, QLatin1String("<sub>"), QLatin1String("</sub>")},
+  {html::SUPERSCRIPT, QLatin1String("<sup>"), QLatin1String("</sup>")},
+  {html::SMALL, QLatin1String("<small>"), QLatin1String("</small>")},
+  {html::BIG, QLatin1String("<big>"), QLatin1String("</big>")},
+  {html::CODE, QLatin1String("<code>"), QLatin1String("</code>")},
+  {html::PRE, QLatin1String("<pre>"), QLatin1String("</pre>")},
+  {html::NOBR, QLatin1String("<nobr>"), QLatin1String("</nobr>")}
+};
+
+static Q_DECL_CONSTEXPR int NUM_TEXT_TAGS = sizeof(TEXT_TAGS) / sizeof(TEXT_TAGS[0]);
+
 HtmlBuilder::HtmlBuilder(const QColor& rowColor, const QColor& rowColorAlt)
   : hasBackColor(true)
 {
@@ -66,9 +106,6 @@ HtmlBuilder& HtmlBuilder::operator=(const atools::util::HtmlBuilder& other)
   rowBackColorAltStr = other.rowBackColorAltStr;
   rowBackColor = other.rowBackColor;
   rowBackColorAlt = other.rowBackColorAlt;
-  tableRowHeader = other.tableRowHeader;
-  tableRow = other.tableRow;
-  tableRowAlignRight = other.tableRowAlignRight;
   tableRowBegin = other.tableRowBegin;
   tableIndex = other.tableIndex;
   defaultPrecision = other.defaultPrecision;
@@ -90,33 +127,24 @@ void HtmlBuilder::initColors(const QColor& rowColor, const QColor& rowColorAlt)
   rowBackColorStr = rowBackColor.name(QColor::HexRgb);
   rowBackColorAltStr = rowBackColorAlt.name(QColor::HexRgb);
 
+  tableRowBegin.clear();
   if(hasBackColor)
   {
-    tableRow.append("<tr bgcolor=\"" + rowBackColorStr + "\"><td>%1</td><td>%2</td></tr>");
-    tableRow.append("<tr bgcolor=\"" + rowBackColorAltStr + "\"><td>%1</td><td>%2</td></tr>");
-
-    tableRowAlignRight.append(
-      "<tr bgcolor=\"" + rowBackColorStr + "\"><td>%1</td><td align=\"right\">%2</td></tr>");
-    tableRowAlignRight.append(
-      "<tr bgcolor=\"" + rowBackColorAltStr + "\"><td>%1</td><td align=\"right\">%2</td></tr>");
-
-    tableRowBegin.append("<tr bgcolor=\"" + rowBackColorStr + "\">");
-    tableRowBegin.append("<tr bgcolor=\"" + rowBackColorAltStr + "\">");
+    tableRowBegin.append("<tr bgcolor=\"" % rowBackColorStr % "\">");
+    tableRowBegin.append("<tr bgcolor=\"" % rowBackColorAltStr % "\">");
   }
   else
   {
-    tableRow.append("<tr><td>%1</td><td>%2</td></tr>");
-    tableRow.append("<tr><td>%1</td><td>%2</td></tr>");
-
-    tableRowAlignRight.append("<tr><td>%1</td><td align=\"right\">%2</td></tr>");
-    tableRowAlignRight.append("<tr><td>%1</td><td align=\"right\">%2</td></tr>");
+    // Used by row2 only - tr() adds its own row begin if no background color is used
+    tableRowBegin.append(QLatin1String("<tr>"));
+    tableRowBegin.append(QLatin1String("<tr>"));
   }
-  tableRowHeader = "<tr><td>%1</td></tr>";
 }
 
 HtmlBuilder& HtmlBuilder::clear()
 {
-  htmlText.clear();
+  // Keep allocated buffer for reuse
+  htmlText.truncate(0);
   numLines = 0;
   tableIndex = 0;
   return *this;
@@ -129,12 +157,28 @@ HtmlBuilder HtmlBuilder::cleared() const
   return html;
 }
 
+void HtmlBuilder::reserve(int size)
+{
+  htmlText.reserve(size);
+}
+
 HtmlBuilder& HtmlBuilder::append(const HtmlBuilder& other)
 {
   htmlText += other.getHtml();
   return *this;
 }
 
+HtmlBuilder& HtmlBuilder::append(HtmlBuilder&& other)
+{
+  if(htmlText.isEmpty() && htmlText.capacity() <= other.htmlText.capacity())
+    // Take the buffer of the other builder instead of copying
+    htmlText.swap(other.htmlText);
+  else
+    htmlText += other.htmlText;
+  other.clear();
+  return *this;
+}
+
 HtmlBuilder& HtmlBuilder::append(const QString& other)
 {
   htmlText += other;
@@ -143,7 +187,8 @@ HtmlBuilder& HtmlBuilder::append(const QString& other)
 
 HtmlBuilder& HtmlBuilder::error(const QString& str)
 {
-  htmlText += HtmlBuilder::errorMessage(str);
+  if(!str.isEmpty())
+    appendText(htmlText, str, html::BOLD | html::NO_ENTITIES, QColor("#ffffff"), QColor("#ff0000"));
   return *this;
 }
 
@@ -165,7 +210,8 @@ QString HtmlBuilder::errorMessage(const QString& str)
 
 HtmlBuilder& HtmlBuilder::warning(const QString& str)
 {
-  htmlText += HtmlBuilder::warningMessage(str);
+  if(!str.isEmpty())
+    appendText(htmlText, str, html::BOLD | html::NO_ENTITIES, QColor("#ff5000"), QColor());
   return *this;
 }
 
@@ -187,7 +233,8 @@ QString HtmlBuilder::warningMessage(const QStringList& stringList, const QString
 
 HtmlBuilder& HtmlBuilder::note(const QString& str)
 {
-  htmlText += HtmlBuilder::noteMessage(str);
+  if(!str.isEmpty())
+    appendText(htmlText, str, html::BOLD | html::NO_ENTITIES, QColor("#00aa00"), QColor());
   return *this;
 }
 
@@ -209,7 +256,8 @@ QString HtmlBuilder::noteMessage(const QStringList& stringList, const QString& s
 
 HtmlBuilder& HtmlBuilder::message(const QString& str, html::Flags flags, QColor foreground, QColor background)
 {
-  htmlText.append(textMessage(str, flags, foreground, background));
+  if(!str.isEmpty())
+    appendText(htmlText, str, flags, foreground, background);
   numLines++;
   return *this;
 }
@@ -288,10 +336,7 @@ HtmlBuilder& HtmlBuilder::row2Var(const QString& name, const QVariant& value, ht
       valueStr = QString("Error: Invalid variant type \"%1\"").arg(value.typeName());
 
   }
-  htmlText += alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).
-              arg(asText(name, flags, color), value.toString());
-  tableIndex++;
-  numLines++;
+  appendRow2(name, flags, value.toString(), flags | html::NO_ENTITIES, color);
   return *this;
 }
 
@@ -299,13 +344,7 @@ HtmlBuilder& HtmlBuilder::row2If(const QString& name, const QString& value, html
 {
   flags |= row2AlignRightFlag ? html::ALIGN_RIGHT : html::NONE;
   if(!value.isEmpty())
-  {
-    htmlText += alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).
-                arg(asText(name, flags | atools::util::html::BOLD, color)).
-                arg(asText(value, flags, color));
-    tableIndex++;
-    numLines++;
-  }
+    appendRow2(name, flags | html::BOLD, value, flags, color);
   return *this;
 }
 
@@ -343,13 +382,30 @@ HtmlBuilder& HtmlBuilder::row2Error(const QString& name, const QString& value)
 HtmlBuilder& HtmlBuilder::row2(const QString& name, const QString& value, html::Flags flags, QColor color)
 {
   flags |= row2AlignRightFlag ? html::ALIGN_RIGHT : html::NONE;
-  htmlText += alt(flags & html::ALIGN_RIGHT ? tableRowAlignRight : tableRow).
-              arg(asText(name, flags | html::BOLD, color)).
-              // Add space to avoid formatting issues with table
-              arg(value.isEmpty() ? "&nbsp;" : asText(value, flags, color));
+  appendRow2(name, flags | html::BOLD, value, flags, color);
+  return *this;
+}
+
+void HtmlBuilder::appendRow2(const QString& name, html::Flags nameFlags, const QString& value,
+                             html::Flags valueFlags, QColor color)
+{
+  htmlText += alt(tableRowBegin) % QLatin1String("<td>");
+  appendText(htmlText, name, nameFlags, color, QColor());
+
+  if(valueFlags & html::ALIGN_RIGHT)
+    htmlText += QLatin1String("</td><td align=\"right\">");
+  else
+    htmlText += QLatin1String("</td><td>");
+
+  if(value.isEmpty())
+    // Add space to avoid formatting issues with table
+    htmlText += QLatin1String("&nbsp;");
+  else
+    appendText(htmlText, value, valueFlags, color, QColor());
+
+  htmlText += QLatin1String("</td></tr>");
   tableIndex++;
   numLines++;
-  return *this;
 }
 
 HtmlBuilder& HtmlBuilder::row2(const QString& name, float value, int precision, html::Flags flags,
@@ -373,16 +429,18 @@ HtmlBuilder& HtmlBuilder::row2(const QString& name, int value, html::Flags flags
 
 HtmlBuilder& HtmlBuilder::td(const QString& str, html::Flags flags, QColor color)
 {
-  htmlText += QString("<td") + (flags & html::ALIGN_RIGHT ? " style=\"text-align: right;\"" : "") + ">";
-  text(str, flags, color);
-  htmlText += "</td>\n";
+  tdF(flags);
+  appendText(htmlText, str, flags, color, QColor());
+  htmlText += QLatin1String("</td>\n");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::tdF(html::Flags flags)
 {
-  htmlText += QString("<td") +
-              (flags & html::ALIGN_RIGHT ? " style=\"text-align: right;\"" : "") + ">";
+  if(flags & html::ALIGN_RIGHT)
+    htmlText += QLatin1String("<td style=\"text-align: right;\">");
+  else
+    htmlText += QLatin1String("<td>");
   return *this;
 }
 
@@ -392,14 +450,14 @@ HtmlBuilder& HtmlBuilder::tdAtts(const QHash<QString, QString>& attributes)
   for(const QString& name : attributes.keys())
     atts += QString(" %1=\"%2\" ").arg(name).arg(attributes.value(name));
 
-  htmlText += "<td " + atts + ">";
+  htmlText += "<td " % atts % ">";
   tableIndex = 0;
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::td()
 {
-  htmlText += QString("<td>");
+  htmlText += QLatin1String("<td>");
   return *this;
 }
 
@@ -411,28 +469,31 @@ HtmlBuilder& HtmlBuilder::tdW(int widthPercent)
 
 HtmlBuilder& HtmlBuilder::tdEnd()
 {
-  htmlText += QString("</td>\n");
+  htmlText += QLatin1String("</td>\n");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::th(const QString& str, html::Flags flags, QColor color)
 {
-  htmlText += QString("<th") + (flags & html::ALIGN_RIGHT ? " align=\"right\"" : "") + ">";
-  text(str, flags, color);
-  htmlText += "</th>\n";
+  if(flags & html::ALIGN_RIGHT)
+    htmlText += QLatin1String("<th align=\"right\">");
+  else
+    htmlText += QLatin1String("<th>");
+  appendText(htmlText, str, flags, color, QColor());
+  htmlText += QLatin1String("</th>\n");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::tr(QColor backgroundColor)
 {
   if(backgroundColor.isValid())
-    htmlText += "<tr bgcolor=\"" + backgroundColor.name(QColor::HexRgb) + "\">\n";
+    htmlText += "<tr bgcolor=\"" % backgroundColor.name(QColor::HexRgb) % "\">\n";
   else
   {
     if(hasBackColor)
       htmlText += alt(tableRowBegin);
     else
-      htmlText += "<tr>\n";
+      htmlText += QLatin1String("<tr>\n");
   }
   tableIndex++;
   numLines++;
@@ -441,7 +502,7 @@ HtmlBuilder& HtmlBuilder::tr(QColor backgroundColor)
 
 HtmlBuilder& HtmlBuilder::tr()
 {
-  htmlText += "<tr>\n";
+  htmlText += QLatin1String("<tr>\n");
   tableIndex++;
   numLines++;
   return *this;
@@ -449,18 +510,22 @@ HtmlBuilder& HtmlBuilder::tr()
 
 HtmlBuilder& HtmlBuilder::trEnd()
 {
-  htmlText += "</tr>\n";
+  htmlText += QLatin1String("</tr>\n");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::table(int border, int padding, int spacing, int widthPercent, QColor bgcolor)
 {
-  htmlText += "<table border=\"" + QString::number(border) + "\" cellpadding=\"" +
-              QString::number(padding) + "\" cellspacing=\"" + QString::number(spacing) + "\"" +
-              (bgcolor.isValid() ? " bgcolor=\"" + bgcolor.name(QColor::HexRgb) + "\"" : QString()) +
-              (widthPercent > 0 ? " width=\"" + QString::number(widthPercent) + "%\"" : QString()) +
+  htmlText += "<table border=\"" % QString::number(border) % "\" cellpadding=\"" % QString::number(padding) %
+              "\" cellspacing=\"" % QString::number(spacing) % "\"";
+
+  if(bgcolor.isValid())
+    htmlText += " bgcolor=\"" % bgcolor.name(QColor::HexRgb) % "\"";
+
+  if(widthPercent > 0)
+    htmlText += " width=\"" % QString::number(widthPercent) % "%\"";
 
-              ">\n<tbody>\n";
+  htmlText += QLatin1String(">\n<tbody>\n");
   tableIndex = 0;
   return *this;
 }
@@ -471,14 +536,14 @@ HtmlBuilder& HtmlBuilder::tableAtts(const QHash<QString, QString>& attributes)
   for(const QString& name : attributes.keys())
     atts += QString(" %1=\"%2\" ").arg(name).arg(attributes.value(name));
 
-  htmlText += "<table " + atts + ">\n<tbody>\n";
+  htmlText += "<table " % atts % ">\n<tbody>\n";
   tableIndex = 0;
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::tableEnd()
 {
-  htmlText += "</tbody>\n</table>\n";
+  htmlText += QLatin1String("</tbody>\n</table>\n");
   tableIndex = 0;
   return *this;
 }
@@ -487,8 +552,12 @@ HtmlBuilder& HtmlBuilder::h(int level, const QString& str, html::Flags flags, QC
                             const QString& id)
 {
   QString num = QString::number(level);
-  htmlText += "<h" + num + (id.isEmpty() ? QString() : " id=\"" + id + "\"") + ">" +
-              asText(str, flags, color) + "</h" + num + ">\n";
+  htmlText += "<h" % num;
+  if(!id.isEmpty())
+    htmlText += " id=\"" % id % "\"";
+  htmlText += QLatin1Char('>');
+  appendText(htmlText, str, flags, color, QColor());
+  htmlText += "</h" % num % ">\n";
   tableIndex = 0;
   numLines++;
   return *this;
@@ -532,31 +601,31 @@ HtmlBuilder& HtmlBuilder::b(const QString& str)
 
 HtmlBuilder& HtmlBuilder::b()
 {
-  htmlText += "<b>";
+  htmlText += QLatin1String("<b>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::bEnd()
 {
-  htmlText += "</b>";
+  htmlText += QLatin1String("</b>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::i()
 {
-  htmlText += "<i>";
+  htmlText += QLatin1String("<i>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::iEnd()
 {
-  htmlText += "</i>";
+  htmlText += QLatin1String("</i>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::nbsp()
 {
-  htmlText += "&nbsp;";
+  htmlText += QLatin1String("&nbsp;");
   return *this;
 }
 
@@ -568,13 +637,13 @@ HtmlBuilder& HtmlBuilder::u(const QString& str)
 
 HtmlBuilder& HtmlBuilder::u()
 {
-  htmlText += "<u>";
+  htmlText += QLatin1String("<u>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::uEnd()
 {
-  htmlText += "</u>";
+  htmlText += QLatin1String("</u>");
   return *this;
 }
 
@@ -586,13 +655,13 @@ HtmlBuilder& HtmlBuilder::sub(const QString& str)
 
 HtmlBuilder& HtmlBuilder::sub()
 {
-  htmlText += "<sub>";
+  htmlText += QLatin1String("<sub>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::subEnd()
 {
-  htmlText += "</sub>";
+  htmlText += QLatin1String("</sub>");
   return *this;
 }
 
@@ -604,13 +673,13 @@ HtmlBuilder& HtmlBuilder::sup(const QString& str)
 
 HtmlBuilder& HtmlBuilder::sup()
 {
-  htmlText += "<sup>";
+  htmlText += QLatin1String("<sup>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::supEnd()
 {
-  htmlText += "</sup>";
+  htmlText += QLatin1String("</sup>");
   return *this;
 }
 
@@ -622,13 +691,13 @@ HtmlBuilder& HtmlBuilder::small(const QString& str)
 
 HtmlBuilder& HtmlBuilder::small()
 {
-  htmlText += "<small>";
+  htmlText += QLatin1String("<small>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::smallEnd()
 {
-  htmlText += "</small>";
+  htmlText += QLatin1String("</small>");
   return *this;
 }
 
@@ -640,13 +709,13 @@ HtmlBuilder& HtmlBuilder::big(const QString& str)
 
 HtmlBuilder& HtmlBuilder::big()
 {
-  htmlText += "<big>";
+  htmlText += QLatin1String("<big>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::bigEnd()
 {
-  htmlText += "</big>";
+  htmlText += QLatin1String("</big>");
   return *this;
 }
 
@@ -658,13 +727,13 @@ HtmlBuilder& HtmlBuilder::code(const QString& str)
 
 HtmlBuilder& HtmlBuilder::code()
 {
-  htmlText += "<code>";
+  htmlText += QLatin1String("<code>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::codeEnd()
 {
-  htmlText += "</code>";
+  htmlText += QLatin1String("</code>");
   return *this;
 }
 
@@ -676,7 +745,7 @@ HtmlBuilder& HtmlBuilder::nobr(const QString& str)
 
 HtmlBuilder& HtmlBuilder::br()
 {
-  htmlText += "<br/>";
+  htmlText += QLatin1String("<br/>");
   numLines++;
   return *this;
 }
@@ -684,11 +753,11 @@ HtmlBuilder& HtmlBuilder::br()
 HtmlBuilder& HtmlBuilder::p(const QString& str, html::Flags flags, QColor color)
 {
   if(flags & html::NOBR_WHITESPACE)
-    htmlText += "<p style=\"white-space:pre\">";
+    htmlText += QLatin1String("<p style=\"white-space:pre\">");
   else
-    htmlText += "<p>";
+    htmlText += QLatin1String("<p>");
   text(str, flags, color);
-  htmlText += "</p>\n";
+  htmlText += QLatin1String("</p>\n");
   tableIndex = 0;
   numLines++;
   return *this;
@@ -697,38 +766,38 @@ HtmlBuilder& HtmlBuilder::p(const QString& str, html::Flags flags, QColor color)
 HtmlBuilder& HtmlBuilder::p(html::Flags flags)
 {
   if(flags & html::NOBR_WHITESPACE)
-    htmlText += "<p style=\"white-space:pre\">";
+    htmlText += QLatin1String("<p style=\"white-space:pre\">");
   else
-    htmlText += "<p>";
+    htmlText += QLatin1String("<p>");
   numLines++;
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::pEnd()
 {
-  htmlText += "</p>\n";
+  htmlText += QLatin1String("</p>\n");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::pre()
 {
-  htmlText += "<pre>";
+  htmlText += QLatin1String("<pre>");
   numLines++;
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::preEnd()
 {
-  htmlText += "</pre>\n";
+  htmlText += QLatin1String("</pre>\n");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::pre(const QString& str, html::Flags flags, QColor color)
 {
 
-  htmlText += "<pre>";
+  htmlText += QLatin1String("<pre>");
   text(str, flags, color);
-  htmlText += "</pre>";
+  htmlText += QLatin1String("</pre>");
   return *this;
 }
 
@@ -747,20 +816,23 @@ HtmlBuilder& HtmlBuilder::textBr(const QString& str, html::Flags flags, QColor c
 
 HtmlBuilder& HtmlBuilder::hr(int size, int widthPercent)
 {
-  htmlText += "<hr size=\"" + QString::number(size) + "\" width=\"" + QString::number(widthPercent) +
-              "%\"/>\n";
+  htmlText += "<hr size=\"" % QString::number(size) % "\" width=\"" % QString::number(widthPercent) % "%\"/>\n";
   numLines++;
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::a(const QString& text, const QString& href, html::Flags flags, QColor color)
 {
-  QString styleTxt;
   if(flags & html::LINK_NO_UL)
-    styleTxt = "style=\"text-decoration:none;\"";
+    htmlText += QLatin1String("<a style=\"text-decoration:none;\" ");
+  else
+    htmlText += QLatin1String("<a  ");
 
-  htmlText += "<a " + styleTxt + " " + (href.isEmpty() ? QString() : " href=\"" + href + "\"") + ">" +
-              asText(text, flags, color) + "</a>";
+  if(!href.isEmpty())
+    htmlText += " href=\"" % href % "\"";
+  htmlText += QLatin1Char('>');
+  appendText(htmlText, text, flags, color, QColor());
+  htmlText += QLatin1String("</a>");
   return *this;
 }
 
@@ -776,147 +848,154 @@ HtmlBuilder& HtmlBuilder::img(const QIcon& icon, const QString& alt, const QStri
 
 HtmlBuilder& HtmlBuilder::img(const QString& src, const QString& alt, const QString& style, QSize size)
 {
-  htmlText += "<img src='" + src + "'" + (style.isEmpty() ? QString() : " style=\"" + style + "\"") +
-              (alt.isEmpty() ? QString() : " alt=\"" + alt + "\"") +
-              (size.isValid() ?
-               QString(" width=\"") + QString::number(size.width()) + "\"" +
-               " height=\"" + QString::number(size.height()) + "\"" : QString()) + "/>";
+  htmlText += "<img src='" % src % "'";
+
+  if(!style.isEmpty())
+    htmlText += " style=\"" % style % "\"";
+
+  if(!alt.isEmpty())
+    htmlText += " alt=\"" % alt % "\"";
+
+  if(size.isValid())
+    htmlText += " width=\"" % QString::number(size.width()) % "\" height=\"" % QString::number(size.height()) % "\"";
+
+  htmlText += QLatin1String("/>");
 
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::ol()
 {
-  htmlText += "<ol>";
+  htmlText += QLatin1String("<ol>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::olEnd()
 {
-  htmlText += "</ol>\n";
+  htmlText += QLatin1String("</ol>\n");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::ul()
 {
-  htmlText += "<ul>";
+  htmlText += QLatin1String("<ul>");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::ulEnd()
 {
-  htmlText += "</ul>\n";
+  htmlText += QLatin1String("</ul>\n");
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::li(const QString& str, html::Flags flags, QColor color)
 {
-  htmlText += "<li>" + asText(str, flags, color) + "</li>\n";
+  htmlText += QLatin1String("<li>");
+  appendText(htmlText, str, flags, color, QColor());
+  htmlText += QLatin1String("</li>\n");
   numLines++;
   return *this;
 }
 
-QString HtmlBuilder::asText(QString str, html::Flags flags, QColor foreground, QColor background)
+QString HtmlBuilder::asText(const QString& str, html::Flags flags, QColor foreground, QColor background)
 {
-  QString prefix, suffix;
-  if(flags & html::BOLD)
-  {
-    prefix.append("<b>");
-    suffix.prepend("</b>");
-  }
+  QString out;
+  appendText(out, str, flags, foreground, background);
+  return out;
+}
 
-  if(flags & html::ITALIC)
+void HtmlBuilder::appendText(QString& out, const QString& str, html::Flags flags, QColor foreground,
+                             QColor background)
+{
+  for(int i = 0; i < NUM_TEXT_TAGS; i++)
   {
-    prefix.append("<i>");
-    suffix.prepend("</i>");
+    if(flags & TEXT_TAGS[i].flag)
+      out += TEXT_TAGS[i].begin;
   }
 
-  if(flags & html::UNDERLINE)
+  bool span = foreground.isValid() || background.isValid();
+  if(span)
   {
-    prefix.append("<u>");
-    suffix.prepend("</u>");
-  }
+    out += QLatin1String("<span style=\"");
 
-  if(flags & html::STRIKEOUT)
-  {
-    prefix.append("<s>");
-    suffix.prepend("</s>");
-  }
+    if(foreground.isValid())
+      out += "color:" % foreground.name(QColor::HexRgb);
 
-  if(flags & html::SUBSCRIPT)
-  {
-    prefix.append("<sub>");
-    suffix.prepend("</sub>");
-  }
+    if(background.isValid())
+    {
+      if(foreground.isValid())
+        out += QLatin1String("; ");
+      out += "background-color:" % background.name(QColor::HexRgb);
+    }
 
-  if(flags & html::SUPERSCRIPT)
-  {
-    prefix.append("<sup>");
-    suffix.prepend("</sup>");
+    out += QLatin1String("\">");
   }
 
-  if(flags & html::SMALL)
+  if(flags & (html::REPLACE_CRLF | html::AUTOLINK))
   {
-    prefix.append("<small>");
-    suffix.prepend("</small>");
-  }
+    // Slow path - replacements need a temporary string
+    QString tmp;
+    if(flags & html::NO_ENTITIES)
+      tmp = str;
+    else
+      appendEscaped(tmp, str);
 
-  if(flags & html::BIG)
-  {
-    prefix.append("<big>");
-    suffix.prepend("</big>");
-  }
+    if(flags & html::REPLACE_CRLF)
+    {
+      tmp.replace("\r\n", "<br/>");
+      tmp.replace("\n", "<br/>");
+      tmp.replace("\r", "<br/>");
+    }
 
-  if(flags & html::CODE)
-  {
-    prefix.append("<code>");
-    suffix.prepend("</code>");
-  }
+    if(flags & html::AUTOLINK)
+      tmp.replace(LINK_REGEXP, "<a href=\"\\1\">\\1</a>");
 
-  if(flags & html::PRE)
-  {
-    prefix.append("<pre>");
-    suffix.prepend("</pre>");
+    out += tmp;
   }
+  else if(flags & html::NO_ENTITIES)
+    out += str;
+  else
+    appendEscaped(out, str);
+
+  if(span)
+    out += QLatin1String("</span>");
 
-  if(flags & html::NOBR)
+  for(int i = NUM_TEXT_TAGS - 1; i >= 0; i--)
   {
-    prefix.append("<nobr>");
-    suffix.prepend("</nobr>");
+    if(flags & TEXT_TAGS[i].flag)
+      out += TEXT_TAGS[i].end;
   }
+}
 
-  if(foreground.isValid() || background.isValid())
+void HtmlBuilder::appendEscaped(QString& out, const QString& str)
+{
+  const QChar *data = str.constData();
+  int size = str.size(), start = 0;
+  for(int i = 0; i < size; i++)
   {
-    prefix.append("<span style=\"");
-
-    if(foreground.isValid())
-      prefix.append("color:" + foreground.name(QColor::HexRgb));
-
-    if(background.isValid())
+    ushort c = data[i].unicode();
+    if(c < 128)
     {
-      if(foreground.isValid())
-        prefix.append("; ");
-      prefix.append("background-color:" + background.name(QColor::HexRgb));
+      const QLatin1String& replacement = ESCAPE_TABLE[c];
+      if(replacement.size() > 0)
+      {
+        // Copy all unchanged characters up to here at once
+        out.append(data + start, i - start);
+        out += replacement;
+        start = i + 1;
+      }
+    }
+    else if(c > 128)
+    {
+      // Numeric entity for all non ASCII characters
+      char entity[16];
+      int len = qsnprintf(entity, sizeof(entity), "&#%u;", static_cast<unsigned int>(c));
+      out.append(data + start, i - start);
+      out += QLatin1String(entity, len);
+      start = i + 1;
     }
-
-    prefix.append("\">");
-    suffix.prepend("</span>");
-  }
-
-  if(!(flags & html::NO_ENTITIES))
-    str = toEntities(str.toHtmlEscaped()).replace("\n", "<br/>");
-
-  if(flags & html::REPLACE_CRLF)
-  {
-    str = str.replace("\r\n", "<br/>");
-    str = str.replace("\n", "<br/>");
-    str = str.replace("\r", "<br/>");
   }
-
-  if(flags & html::AUTOLINK)
-    str.replace(LINK_REGEXP, "<a href=\"\\1\">\\1</a>");
-
-  return prefix + str + suffix;
+  out.append(data + start, size - start);
 }
 
 bool HtmlBuilder::checklength(int maxLines, const QString& msg)
@@ -953,23 +1032,23 @@ HtmlBuilder& HtmlBuilder::textBar(int lenght, html::Flags flags, QColor color)
 
 HtmlBuilder& HtmlBuilder::text(const QString& str, html::Flags flags, QColor color)
 {
-  htmlText += asText(str, flags, color);
+  appendText(htmlText, str, flags, color, QColor());
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::textHtml(const HtmlBuilder& other)
 {
-  text(other.getHtml(), html::NO_ENTITIES);
+  htmlText += other.getHtml();
   return *this;
 }
 
 HtmlBuilder& HtmlBuilder::doc(const QString& title, const QString& css, const QString& bodyStyle,
                               const QStringList& headerLines)
 {
-  htmlText +=
+  htmlText += QLatin1String(
     "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.0//EN\" \"http://www.w3.org/TR/REC-html40/strict.dtd\">\n"
       "<html>\n"
-        "<head>\n";
+        "<head>\n");
 
   if(!css.isEmpty())
     htmlText += QString("<style type=\"text/css\" xml:space=\"preserve\">\n%1</style>\n").arg(css);
@@ -982,12 +1061,12 @@ HtmlBuilder& HtmlBuilder::doc(const QString& title, const QString& css, const QS
     htmlText += line;
 
   // <link rel="stylesheet" href="css/style.css" type="text/css" />
-  htmlText += "</head>\n";
+  htmlText += QLatin1String("</head>\n");
 
   if(!bodyStyle.isEmpty())
-    htmlText += "<body style=\"" + bodyStyle + "\">\n";
+    htmlText += "<body style=\"" % bodyStyle % "\">\n";
   else
-    htmlText += "<body>\n";
+    htmlText += QLatin1String("<body>\n");
 
   tableIndex = 0;
   return *this;
@@ -995,7 +1074,7 @@ HtmlBuilder& HtmlBuilder::doc(const QString& title, const QString& css, const QS
 
 HtmlBuilder& HtmlBuilder::docEnd()
 {
-  htmlText += "</body>\n</html>\n";
+  htmlText += QLatin1String("</body>\n</html>\n");
   return *this;
 }
 
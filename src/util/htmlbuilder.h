@@ -81,6 +81,7 @@ public:
   HtmlBuilder(const QColor& rowColor, const QColor& rowColorAlt);
 
   HtmlBuilder(const atools::util::HtmlBuilder& other);
+  HtmlBuilder(atools::util::HtmlBuilder&& other) = default;
   ~HtmlBuilder();
 
   const QString& getHtml() const
@@ -89,16 +90,23 @@ public:
   }
 
   HtmlBuilder& operator=(const atools::util::HtmlBuilder& other);
+  HtmlBuilder& operator=(atools::util::HtmlBuilder&& other) = default;
 
-  /* Clears this instance except settings */
+  /* Clears this instance except settings. Keeps the allocated buffer for reuse. */
   HtmlBuilder& clear();
 
+  /* Preallocate buffer for the given number of characters to avoid reallocations while appending */
+  void reserve(int size);
+
   /* Returns a clean copy of this instance */
   HtmlBuilder cleared() const;
 
   /* Appends raw data without conversion */
   atools::util::HtmlBuilder& append(const atools::util::HtmlBuilder& other);
 
+  /* Appends raw data without conversion. Takes the buffer of other if this is empty. other is cleared. */
+  atools::util::HtmlBuilder& append(atools::util::HtmlBuilder&& other);
+
   /* Appends raw data without conversion */
   atools::util::HtmlBuilder& append(const QString& other);
 
@@ -372,13 +380,25 @@ public:
 private:
   /* Select alternating entries based on the index from the string list */
   const QString& alt(const QStringList& list) const;
-  static QString asText(QString str, html::Flags flags, QColor foreground, QColor background = QColor());
+  static QString asText(const QString& str, html::Flags flags, QColor foreground, QColor background = QColor());
+
+  /* Append text with tags for flags and color to out */
+  static void appendText(QString& out, const QString& str, html::Flags flags, QColor foreground,
+                         QColor background);
+
+  /* Append text with HTML characters and newlines escaped and non ASCII characters as numeric entities.
+   * Same as toEntities(str.toHtmlEscaped()).replace("\n", "<br/>") but without temporary strings. */
+  static void appendEscaped(QString& out, const QString& str);
+
+  /* Append a two column table row with alternating background color */
+  void appendRow2(const QString& name, html::Flags nameFlags, const QString& value, html::Flags valueFlags,
+                  QColor color);
 
   void initColors(const QColor& rowColor, const QColor& rowColorAlt);
 
-  QString rowBackColorStr, rowBackColorAltStr, tableRowHeader;
+  QString rowBackColorStr, rowBackColorAltStr;
   QColor rowBackColor, rowBackColorAlt;
-  QStringList tableRow, tableRowAlignRight, tableRowBegin;
+  QStringList tableRowBegin;
 
   int tableIndex = 0, defaultPrecision = 0, numLines = 0;
   QString htmlText;
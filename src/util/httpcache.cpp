@@ -0,0 +1,346 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/httpcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLocale>
+#include <QSaveFile>
+#include <QSet>
+#include <QVector>
+
+#include <algorithm>
+
+namespace atools {
+namespace util {
+
+/* Index file format */
+static const QLatin1String INDEX_FILENAME("index");
+static const QLatin1String DATA_SUFFIX(".data");
+static Q_DECL_CONSTEXPR quint32 INDEX_MAGIC_NUMBER = 0x48C4C3E1;
+static Q_DECL_CONSTEXPR quint16 INDEX_VERSION = 1;
+
+HttpCache::HttpCache(const QString& directory, qint64 maxSizeBytes)
+  : cacheDir(directory), maxSize(maxSizeBytes)
+{
+  QDir dir(cacheDir);
+  if(!dir.exists() && !dir.mkpath(cacheDir))
+    qWarning() << Q_FUNC_INFO << "Cannot create cache directory" << cacheDir;
+
+  readIndex();
+
+  // Delete orphaned files from crashes or older versions
+  QSet<QString> filenames;
+  for(const IndexEntry& entry : index)
+    filenames.insert(entry.filename);
+
+  for(const QString& filename : dir.entryList({QString("*") + DATA_SUFFIX}, QDir::Files))
+  {
+    if(!filenames.contains(filename))
+      dir.remove(filename);
+  }
+
+  evict();
+  if(indexChanged)
+    writeIndex();
+
+  qDebug() << Q_FUNC_INFO << cacheDir << "entries" << index.size() << "size" << totalSize;
+}
+
+HttpCache::~HttpCache()
+{
+  if(indexChanged)
+    writeIndex();
+}
+
+bool HttpCache::lookup(const QString& url, HttpCacheEntry& entry, bool readData)
+{
+  QHash<QString, IndexEntry>::iterator it = index.find(url);
+  if(it == index.end())
+    return false;
+
+  entry.etag = it->etag;
+  entry.lastModified = it->lastModified;
+  entry.expires = it->expires;
+
+  if(!readData)
+    return true;
+
+  entry.data.clear();
+  QFile file(filePath(it->filename));
+  if(file.open(QIODevice::ReadOnly))
+  {
+    entry.data = file.readAll();
+    file.close();
+  }
+
+  if(entry.data.size() != it->size)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot read cache file" << file.fileName() << file.errorString();
+    entry.data.clear();
+    removeInternal(url);
+    writeIndex();
+    return false;
+  }
+
+  it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+  indexChanged = true;
+  return true;
+}
+
+void HttpCache::insert(const QString& url, const HttpCacheEntry& entry)
+{
+  removeInternal(url);
+
+  if(entry.data.size() > maxSize)
+  {
+    // Would evict everything else
+    writeIndex();
+    return;
+  }
+
+  IndexEntry indexEntry;
+  indexEntry.filename = filenameForUrl(url);
+  indexEntry.etag = entry.etag;
+  indexEntry.lastModified = entry.lastModified;
+  indexEntry.expires = entry.expires;
+  indexEntry.size = entry.data.size();
+  indexEntry.lastAccess = QDateTime::currentMSecsSinceEpoch();
+
+  QSaveFile file(filePath(indexEntry.filename));
+  if(file.open(QIODevice::WriteOnly) && file.write(entry.data) == entry.data.size() && file.commit())
+  {
+    index.insert(url, indexEntry);
+    totalSize += indexEntry.size;
+    evict(url);
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write cache file" << file.fileName() << file.errorString();
+
+  writeIndex();
+}
+
+void HttpCache::updateExpires(const QString& url, const QDateTime& expires)
+{
+  QHash<QString, IndexEntry>::iterator it = index.find(url);
+  if(it != index.end())
+  {
+    it->expires = expires;
+    it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+    writeIndex();
+  }
+}
+
+void HttpCache::remove(const QString& url)
+{
+  if(index.contains(url))
+  {
+    removeInternal(url);
+    writeIndex();
+  }
+}
+
+void HttpCache::clear()
+{
+  for(const IndexEntry& entry : index)
+    QFile::remove(filePath(entry.filename));
+  index.clear();
+  totalSize = 0;
+  writeIndex();
+}
+
+void HttpCache::setMaxSize(qint64 value)
+{
+  maxSize = value;
+  evict();
+  if(indexChanged)
+    writeIndex();
+}
+
+QDateTime HttpCache::expiresFromHeaders(const QByteArray& cacheControl, const QByteArray& expiresHeader,
+                                        bool& noStore)
+{
+  QDateTime now = QDateTime::currentDateTimeUtc();
+  noStore = false;
+
+  bool noCache = false;
+  qint64 maxAge = -1;
+  for(const QByteArray& directive : cacheControl.toLower().split(','))
+  {
+    QByteArray dir = directive.trimmed();
+    if(dir == "no-store")
+      noStore = true;
+    else if(dir == "no-cache")
+      noCache = true;
+    else if(dir.startsWith("max-age="))
+    {
+      bool ok;
+      qint64 age = dir.mid(8).toLongLong(&ok);
+      if(ok)
+        maxAge = std::max(age, static_cast<qint64>(0));
+    }
+  }
+
+  if(noStore)
+    return QDateTime();
+
+  if(noCache)
+    // Revalidate on each use
+    return now;
+
+  if(maxAge >= 0)
+    return now.addSecs(maxAge);
+
+  if(!expiresHeader.isEmpty())
+  {
+    // RFC 7231 date like "Wed, 21 Oct 2015 07:28:00 GMT" - invalid values like "0" mean already expired
+    QDateTime expires = QLocale::c().toDateTime(QString::fromLatin1(expiresHeader.trimmed()),
+                                                "ddd, dd MMM yyyy hh:mm:ss 'GMT'");
+    if(expires.isValid())
+    {
+      expires.setTimeSpec(Qt::UTC);
+      return expires;
+    }
+  }
+
+  // No freshness information - always ask server
+  return now;
+}
+
+void HttpCache::readIndex()
+{
+  index.clear();
+  totalSize = 0;
+
+  QFile file(filePath(INDEX_FILENAME));
+  if(!file.exists())
+    return;
+
+  if(file.open(QIODevice::ReadOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    quint32 magic;
+    quint16 version;
+    qint32 size;
+    stream >> magic >> version >> size;
+
+    if(magic == INDEX_MAGIC_NUMBER && version == INDEX_VERSION)
+    {
+      for(qint32 i = 0; i < size && stream.status() == QDataStream::Ok; i++)
+      {
+        QString url;
+        IndexEntry entry;
+        stream >> url >> entry.filename >> entry.etag >> entry.lastModified >> entry.expires >> entry.size >>
+          entry.lastAccess;
+
+        if(stream.status() == QDataStream::Ok && QFileInfo(filePath(entry.filename)).size() == entry.size)
+        {
+          index.insert(url, entry);
+          totalSize += entry.size;
+        }
+        else
+          // Dropped entries - file is deleted as orphaned
+          indexChanged = true;
+      }
+    }
+    else
+    {
+      qWarning() << Q_FUNC_INFO << "Invalid cache index" << file.fileName() << "magic" << magic << "version" << version;
+      indexChanged = true;
+    }
+    file.close();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot read cache index" << file.fileName() << file.errorString();
+}
+
+void HttpCache::writeIndex()
+{
+  QSaveFile file(filePath(INDEX_FILENAME));
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_5);
+
+    stream << INDEX_MAGIC_NUMBER << INDEX_VERSION << static_cast<qint32>(index.size());
+    for(QHash<QString, IndexEntry>::const_iterator it = index.constBegin(); it != index.constEnd(); ++it)
+      stream << it.key() << it->filename << it->etag << it->lastModified << it->expires << it->size << it->lastAccess;
+
+    if(file.commit())
+      indexChanged = false;
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot write cache index" << file.fileName() << file.errorString();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write cache index" << file.fileName() << file.errorString();
+}
+
+void HttpCache::evict(const QString& keepUrl)
+{
+  if(totalSize <= maxSize)
+    return;
+
+  // Sort by last access - oldest first
+  QVector<QPair<qint64, QString> > entries;
+  entries.reserve(index.size());
+  for(QHash<QString, IndexEntry>::const_iterator it = index.constBegin(); it != index.constEnd(); ++it)
+  {
+    if(it.key() != keepUrl)
+      entries.append(qMakePair(it->lastAccess, it.key()));
+  }
+  std::sort(entries.begin(), entries.end());
+
+  for(const QPair<qint64, QString>& entry : entries)
+  {
+    if(totalSize <= maxSize)
+      break;
+    removeInternal(entry.second);
+  }
+}
+
+void HttpCache::removeInternal(const QString& url)
+{
+  QHash<QString, IndexEntry>::iterator it = index.find(url);
+  if(it != index.end())
+  {
+    QFile::remove(filePath(it->filename));
+    totalSize -= it->size;
+    index.erase(it);
+    indexChanged = true;
+  }
+}
+
+QString HttpCache::filePath(const QString& filename) const
+{
+  return cacheDir + QDir::separator() + filename;
+}
+
+QString HttpCache::filenameForUrl(const QString& url)
+{
+  return QString::fromLatin1(QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex()) +
+         DATA_SUFFIX;
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,156 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_HTTPCACHE_H
+#define ATOOLS_UTIL_HTTPCACHE_H
+
+#include <QDateTime>
+#include <QHash>
+
+namespace atools {
+namespace util {
+
+/* Cached HTTP response as returned by HttpCache::lookup() */
+struct HttpCacheEntry
+{
+  QByteArray data,
+             etag, /* Value of the ETag header or empty */
+             lastModified; /* Value of the Last-Modified header or empty */
+
+  /* Response can be used without asking the server until this time. Has to be revalidated after. */
+  QDateTime expires;
+
+  /* true if the entry can be used without revalidation */
+  bool isFresh() const
+  {
+    return expires.isValid() && expires > QDateTime::currentDateTimeUtc();
+  }
+
+  /* true if the entry has ETag or Last-Modified for a conditional request */
+  bool hasValidator() const
+  {
+    return !etag.isEmpty() || !lastModified.isEmpty();
+  }
+};
+
+/*
+ * Persistent disk cache for HTTP GET responses keyed by URL.
+ *
+ * Each response is stored in a separate file in the cache directory. URL, validators (ETag and Last-Modified),
+ * expiration time and last access time are kept in an index file which is rewritten on each change.
+ * Entries are evicted in least recently used order if the total size exceeds the limit.
+ *
+ * Freshness is calculated from the Cache-Control and Expires headers. Stale entries are kept and can
+ * be revalidated using a conditional request.
+ *
+ * Not thread safe. An instance can be shared between all HttpDownloader objects living in the same thread.
+ */
+class HttpCache
+{
+public:
+  /* Opens the cache in directory which is created if needed. Data files not in the index are deleted.
+   * maxSizeBytes limits the total size of all cached responses. */
+  HttpCache(const QString& directory, qint64 maxSizeBytes);
+  ~HttpCache();
+
+  HttpCache(const HttpCache& other) = delete;
+  HttpCache& operator=(const HttpCache& other) = delete;
+
+  /* Get a cached response and mark it as recently used. Returns false if not found or not readable.
+   * Only validators and expiration are returned if readData is false. Access order is not changed then. */
+  bool lookup(const QString& url, HttpCacheEntry& entry, bool readData = true);
+
+  /* true if a response is cached. Does not change the access order. */
+  bool contains(const QString& url) const
+  {
+    return index.contains(url);
+  }
+
+  /* Store a response replacing any previous one for the URL. Evicts least recently used entries if needed. */
+  void insert(const QString& url, const HttpCacheEntry& entry);
+
+  /* Set new expiration time after successful revalidation (304 Not Modified) */
+  void updateExpires(const QString& url, const QDateTime& expires);
+
+  /* Remove entry and its file */
+  void remove(const QString& url);
+
+  /* Remove all entries and files */
+  void clear();
+
+  /* Total size of all cached responses in bytes */
+  qint64 getSize() const
+  {
+    return totalSize;
+  }
+
+  qint64 getMaxSize() const
+  {
+    return maxSize;
+  }
+
+  /* Change limit and evict entries if needed */
+  void setMaxSize(qint64 value);
+
+  const QString& getDirectory() const
+  {
+    return cacheDir;
+  }
+
+  /*
+   * Calculate the expiration time from the values of the Cache-Control and Expires headers.
+   * max-age has priority over Expires. Returns the current time if the response has to be revalidated
+   * each time or if no freshness information is given. noStore is set to true if the response
+   * must not be cached at all.
+   */
+  static QDateTime expiresFromHeaders(const QByteArray& cacheControl, const QByteArray& expiresHeader,
+                                      bool& noStore);
+
+private:
+  struct IndexEntry
+  {
+    QString filename;
+    QByteArray etag, lastModified;
+    QDateTime expires;
+    qint64 size, lastAccess; /* Bytes and milliseconds since epoch */
+  };
+
+  void readIndex();
+  void writeIndex();
+
+  /* Remove least recently used entries until size is below maximum. Keeps entry for keepUrl. */
+  void evict(const QString& keepUrl = QString());
+
+  /* Remove file and entry without writing the index */
+  void removeInternal(const QString& url);
+
+  QString filePath(const QString& filename) const;
+  static QString filenameForUrl(const QString& url);
+
+  QHash<QString, IndexEntry> index;
+  QString cacheDir;
+  qint64 maxSize, totalSize = 0;
+
+  /* Access times are only written with the next change or on destruction */
+  bool indexChanged = false;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_HTTPCACHE_H
@@ -16,7 +16,9 @@
 *****************************************************************************/
 
 #include "util/httpdownloader.h"
-#include "util/timedcache.h"
+#include "util/lrucache.h"
+#include "util/httpcache.h"
+#include "util/httpscheduler.h"
 
 #include <QApplication>
 #include <QFileInfo>
@@ -81,15 +83,25 @@ void HttpDownloader::startDownload()
   else
   {
     // Start download ================================================================
-    QByteArray *cachedData = nullptr;
-    if(dataCache != nullptr && (cachedData = dataCache->value(QUrl(downloadUrl).toString())) != nullptr)
+    QString cacheUrl = QUrl(downloadUrl).toString();
+    HttpCacheEntry cacheEntry;
+    bool diskCached = isDiskCacheUsed() && diskCache->lookup(cacheUrl, cacheEntry, false /* readData */);
+
+    if(dataCache != nullptr && dataCache->find(cacheUrl, data))
     {
       // Found value in the cache
-      data = *cachedData;
       emit downloadFinished(data, downloadUrl);
 
       startTimer();
     }
+    else if(diskCached && cacheEntry.isFresh() && finishFromDiskCache(cacheUrl, cacheEntry))
+    {
+      // Fresh response in disk cache - no need to ask the server
+      if(verbose)
+        qDebug() << Q_FUNC_INFO << "Fresh in disk cache" << cacheUrl;
+
+      startTimer();
+    }
     else
     {
       // Either cancel requested, request in process or no periodic downloads done
@@ -97,38 +109,11 @@ void HttpDownloader::startDownload()
       {
         cancelDownload();
 
-        QNetworkRequest request(downloadUrl);
-
-        if(!userAgent.isEmpty())
-          request.setHeader(QNetworkRequest::UserAgentHeader, userAgent);
-
-        if(!postParameters.isEmpty())
-          // Post raw data ============================
-          reply = networkManager.post(request, postParameters);
-        else if(!postParametersQuery.isEmpty())
-        {
-          // Post form data ============================
-          request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-
-          QUrlQuery params;
-          for(const QString& key : postParametersQuery.keys())
-            params.addQueryItem(key, postParametersQuery.value(key));
-
-          reply = networkManager.post(request, params.query().toUtf8());
-        }
+        if(scheduler != nullptr)
+          // Request is started once the scheduler has a free slot
+          scheduler->enqueue(this, QUrl(downloadUrl).host(), priority);
         else
-          // Get request ============================
-          reply = networkManager.get(request);
-
-        if(reply != nullptr)
-        {
-          connect(reply, &QNetworkReply::finished, this, &HttpDownloader::httpFinished);
-          connect(reply, &QNetworkReply::readyRead, this, &HttpDownloader::readyRead);
-          connect(reply, &QNetworkReply::downloadProgress, this, &HttpDownloader::downloadProgressInternal);
-          connect(reply, &QNetworkReply::sslErrors, this, &HttpDownloader::sslErrors);
-        }
-        else
-          qWarning() << Q_FUNC_INFO << "Reply is null" << downloadUrl;
+          startRequest(&networkManager);
       }
       else
         // is already downloading and waiting for finished required (restartRequest = false)
@@ -137,6 +122,84 @@ void HttpDownloader::startDownload()
   }
 }
 
+void HttpDownloader::setScheduler(HttpScheduler *httpScheduler, int httpPriority)
+{
+  if(scheduler != nullptr)
+    scheduler->release(this);
+
+  scheduler = httpScheduler;
+  priority = httpPriority;
+}
+
+void HttpDownloader::startRequest(QNetworkAccessManager *manager)
+{
+  QNetworkRequest request(downloadUrl);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+  if(scheduler != nullptr && scheduler->isHttp2Allowed())
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#endif
+
+  if(!userAgent.isEmpty())
+    request.setHeader(QNetworkRequest::UserAgentHeader, userAgent);
+
+  if(!postParameters.isEmpty())
+    // Post raw data ============================
+    reply = manager->post(request, postParameters);
+  else if(!postParametersQuery.isEmpty())
+  {
+    // Post form data ============================
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+
+    QUrlQuery params;
+    for(const QString& key : postParametersQuery.keys())
+      params.addQueryItem(key, postParametersQuery.value(key));
+
+    reply = manager->post(request, params.query().toUtf8());
+  }
+  else
+  {
+    // Get request ============================
+    QString cacheUrl = QUrl(downloadUrl).toString();
+    HttpCacheEntry cacheEntry;
+    bool diskCached = isDiskCacheUsed() && diskCache->lookup(cacheUrl, cacheEntry, false /* readData */);
+
+    if(diskCached && cacheEntry.hasValidator())
+    {
+      // Revalidate stale response from disk cache
+      if(!cacheEntry.etag.isEmpty())
+        request.setRawHeader("If-None-Match", cacheEntry.etag);
+      if(!cacheEntry.lastModified.isEmpty())
+        request.setRawHeader("If-Modified-Since", cacheEntry.lastModified);
+    }
+    else if(conditionalRequests)
+    {
+      QPair<QByteArray, QByteArray> validator = validators.value(cacheUrl);
+      if(!validator.first.isEmpty())
+        request.setRawHeader("If-None-Match", validator.first);
+      if(!validator.second.isEmpty())
+        request.setRawHeader("If-Modified-Since", validator.second);
+    }
+
+    reply = manager->get(request);
+  }
+
+  if(reply != nullptr)
+  {
+    connect(reply, &QNetworkReply::finished, this, &HttpDownloader::httpFinished);
+    connect(reply, &QNetworkReply::readyRead, this, &HttpDownloader::readyRead);
+    connect(reply, &QNetworkReply::downloadProgress, this, &HttpDownloader::downloadProgressInternal);
+    connect(reply, &QNetworkReply::sslErrors, this, &HttpDownloader::sslErrors);
+  }
+  else
+  {
+    qWarning() << Q_FUNC_INFO << "Reply is null" << downloadUrl;
+
+    if(scheduler != nullptr)
+      scheduler->release(this);
+  }
+}
+
 void HttpDownloader::sslErrors(const QList<QSslError>& errors)
 {
   if(reply != nullptr)
@@ -181,10 +244,10 @@ void HttpDownloader::setPostParameters(const QStringList& parameters)
     postParametersQuery.insert(parameters.at(i), parameters.at(i + 1));
 }
 
-void HttpDownloader::enableCache(int secondsTimeout)
+void HttpDownloader::enableCache(int secondsTimeout, qint64 maxBytes)
 {
   delete dataCache;
-  dataCache = new atools::util::TimedCache<QString, QByteArray>(secondsTimeout);
+  dataCache = new atools::util::LruCache<QString, QByteArray>(maxBytes, secondsTimeout * 1000L);
 }
 
 void HttpDownloader::disableCache()
@@ -193,11 +256,70 @@ void HttpDownloader::disableCache()
   dataCache = nullptr;
 }
 
+bool HttpDownloader::isDiskCacheUsed() const
+{
+  return diskCache != nullptr && postParameters.isEmpty() && postParametersQuery.isEmpty();
+}
+
+bool HttpDownloader::finishFromDiskCache(const QString& url, const HttpCacheEntry& entry)
+{
+  QPair<QByteArray, QByteArray> validator(entry.etag, entry.lastModified);
+  if(conditionalRequests && entry.hasValidator() && validators.value(url) == validator)
+    // Already delivered by this downloader
+    emit downloadNotModified(url);
+  else
+  {
+    HttpCacheEntry dataEntry;
+    if(!diskCache->lookup(url, dataEntry))
+      return false;
+
+    data = dataEntry.data;
+
+    if(conditionalRequests)
+      validators.insert(url, validator);
+
+    if(dataCache != nullptr)
+      dataCache->insert(url, data, data.size());
+
+    emit downloadFinished(data, url);
+  }
+  return true;
+}
+
+void HttpDownloader::insertDiskCache(const QString& url)
+{
+  bool noStore;
+  QDateTime expires = HttpCache::expiresFromHeaders(reply->rawHeader("Cache-Control"), reply->rawHeader("Expires"),
+                                                    noStore);
+  if(noStore)
+    diskCache->remove(url);
+  else
+  {
+    HttpCacheEntry entry;
+    entry.data = data;
+    entry.etag = reply->rawHeader("ETag");
+    entry.lastModified = reply->rawHeader("Last-Modified");
+    entry.expires = expires;
+    diskCache->insert(url, entry);
+  }
+}
+
+void HttpDownloader::setConditionalRequests(bool value)
+{
+  conditionalRequests = value;
+  if(!conditionalRequests)
+    validators.clear();
+}
+
 void HttpDownloader::startTimer()
 {
   if(updatePeriodSeconds > 0)
   {
-    updateTimer.setInterval(updatePeriodSeconds * 1000);
+    if(scheduler != nullptr)
+      // Spread recurring downloads of all downloaders over time
+      updateTimer.setInterval(scheduler->jitter(updatePeriodSeconds * 1000));
+    else
+      updateTimer.setInterval(updatePeriodSeconds * 1000);
     updateTimer.start();
   }
   else
@@ -247,6 +369,10 @@ void HttpDownloader::deleteReply()
     reply->deleteLater();
     reply = nullptr;
   }
+
+  // Remove from queue or free slot
+  if(scheduler != nullptr)
+    scheduler->release(this);
 }
 
 void HttpDownloader::downloadProgressInternal(qint64 bytesReceived, qint64 bytesTotal)
@@ -271,10 +397,44 @@ void HttpDownloader::httpFinished()
 
     data.append(reply->readAll());
 
-    if(reply->error() == QNetworkReply::NoError)
+    if(reply->error() == QNetworkReply::NoError &&
+       reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
     {
+      // Conditional request and file is unchanged - data is empty
+      if(verbose)
+        qDebug() << Q_FUNC_INFO << "Not modified" << curUrl();
+
+      QString url = reply->request().url().toString();
+      HttpCacheEntry cacheEntry;
+      if(reply->operation() == QNetworkAccessManager::GetOperation && diskCache != nullptr &&
+         diskCache->lookup(url, cacheEntry, false /* readData */) && cacheEntry.hasValidator())
+      {
+        // Revalidated response from disk cache - update freshness from new headers
+        bool noStore;
+        QDateTime expires = HttpCache::expiresFromHeaders(reply->rawHeader("Cache-Control"),
+                                                          reply->rawHeader("Expires"), noStore);
+        diskCache->updateExpires(url, expires);
+
+        if(!finishFromDiskCache(url, cacheEntry))
+          emit downloadFailed(tr("Cannot read cached file."), QNetworkReply::UnknownContentError, url);
+      }
+      else
+        emit downloadNotModified(url);
+
+      deleteReply();
+      startTimer();
+    }
+    else if(reply->error() == QNetworkReply::NoError)
+    {
+      if(conditionalRequests)
+        validators.insert(reply->request().url().toString(),
+                          qMakePair(reply->rawHeader("ETag"), reply->rawHeader("Last-Modified")));
+
       if(dataCache != nullptr)
-        dataCache->insert(reply->url().toString(), data);
+        dataCache->insert(reply->url().toString(), data, data.size());
+
+      if(reply->operation() == QNetworkAccessManager::GetOperation && diskCache != nullptr)
+        insertDiskCache(reply->request().url().toString());
 
       emit downloadFinished(data, reply->url().toString());
       deleteReply();
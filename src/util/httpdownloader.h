@@ -18,6 +18,8 @@
 #ifndef ATOOLS_HTTPDOWNLOADER_H
 #define ATOOLS_HTTPDOWNLOADER_H
 
+#include "util/httpscheduler.h"
+
 #include <QNetworkAccessManager>
 #include <QTimer>
 
@@ -27,11 +29,14 @@ namespace atools {
 namespace util {
 
 template<typename KEY, typename TYPE>
-class TimedCache;
+class LruCache;
+
+class HttpCache;
+struct HttpCacheEntry;
 
 /*
  * Simple async HTTP download tool that reads files from web addresses.
- * Has a timer to do recurring downloads and can use a timed cache.
+ * Has a timer to do recurring downloads and can use a memory cache with timeout.
  */
 class HttpDownloader :
   public QObject
@@ -77,12 +82,28 @@ public:
     return postParameters;
   }
 
-  /* Enable an internal cache for each request URL */
-  void enableCache(int secondsTimeout);
+  /* Enable an internal cache for each request URL. Least recently used responses are dropped
+   * if all cached responses exceed maxBytes. */
+  void enableCache(int secondsTimeout, qint64 maxBytes = 32L * 1024L * 1024L);
 
   /* Disable and clear cache*/
   void disableCache();
 
+  /* Use a persistent disk cache for GET requests. The cache is not owned and can be shared between downloaders.
+   * Fresh responses are returned without network access. Stale responses are revalidated with a conditional
+   * request and returned from the cache if the server replies with 304 Not Modified.
+   * downloadNotModified is emitted instead of downloadFinished if conditional requests are enabled and
+   * the cached response was already delivered by this downloader. Set to null to disable. */
+  void setDiskCache(atools::util::HttpCache *cache)
+  {
+    diskCache = cache;
+  }
+
+  atools::util::HttpCache *getDiskCache() const
+  {
+    return diskCache;
+  }
+
   const QString& getUrl() const
   {
     return downloadUrl;
@@ -128,10 +149,19 @@ public:
    */
   void setDefaultUserAgentShort(const QString& extension = QString());
 
-  /* true if download is in progress */
+  /* true if download is in progress or waiting in the scheduler queue */
   bool isDownloading() const
   {
-    return reply != nullptr;
+    return reply != nullptr || (scheduler != nullptr && scheduler->contains(this));
+  }
+
+  /* Use a shared scheduler for network connections, queuing and jittered update periods.
+   * The scheduler is not owned. Call before starting downloads. Set to null to use the own network manager. */
+  void setScheduler(atools::util::HttpScheduler *httpScheduler, int httpPriority = atools::util::PRIORITY_NORMAL);
+
+  atools::util::HttpScheduler *getScheduler() const
+  {
+    return scheduler;
   }
 
   /* Cancels current request if true. Waits for request to be finished if false */
@@ -157,12 +187,25 @@ public:
     return ignoreSslErrors;
   }
 
+  /* Send If-None-Match and If-Modified-Since headers for GET requests using ETag and Last-Modified of the last
+   * response for the same URL. downloadNotModified is emitted instead of downloadFinished if the server
+   * replies with 304 Not Modified. Transfer compression is negotiated by Qt automatically. */
+  void setConditionalRequests(bool value);
+
+  bool isConditionalRequests() const
+  {
+    return conditionalRequests;
+  }
+
 signals:
   /* Emitted when file was downloaded and udpated */
   void downloadFinished(const QByteArray& data, QString downloadUrl);
   void downloadFailed(const QString& error, int errorCode, QString downloadUrl);
   void downloadProgress(qint64 bytesReceived, qint64 bytesTotal, QString downloadUrl);
 
+  /* Emitted for conditional requests if the file did not change since the last download */
+  void downloadNotModified(QString downloadUrl);
+
   /* Emitted on SSL errors. Call setIgnoreSslErrors to ignore future errors and continue.  */
   void downloadSslErrors(const QStringList& errors, const QString& downloadUrl);
 
@@ -180,7 +223,22 @@ private:
 
   void sslErrors(const QList<QSslError>& errors);
 
-  bool restartRequest = true, ignoreSslErrors = false, sslErrorLogged = false;
+  friend class atools::util::HttpScheduler;
+
+  /* Build request and start it using the given network manager. Called directly or by the scheduler. */
+  void startRequest(QNetworkAccessManager *manager);
+
+  /* true if the disk cache can be used for the current request */
+  bool isDiskCacheUsed() const;
+
+  /* Emit downloadFinished with the cached response or downloadNotModified if it was already delivered.
+   * Returns false if the cached file cannot be read. */
+  bool finishFromDiskCache(const QString& url, const atools::util::HttpCacheEntry& entry);
+
+  /* Store response of the current reply in the disk cache or drop it depending on the cache headers */
+  void insertDiskCache(const QString& url);
+
+  bool restartRequest = true, ignoreSslErrors = false, sslErrorLogged = false, conditionalRequests = false;
 
   QString curUrl();
 
@@ -196,8 +254,18 @@ private:
   QByteArray data;
   bool verbose;
 
+  /* Maps URL to ETag and Last-Modified header values of the last reply */
+  QHash<QString, QPair<QByteArray, QByteArray> > validators;
+
   /* Maps URL to result */
-  atools::util::TimedCache<QString, QByteArray> *dataCache = nullptr;
+  atools::util::LruCache<QString, QByteArray> *dataCache = nullptr;
+
+  /* Persistent cache shared with other downloaders - not owned */
+  atools::util::HttpCache *diskCache = nullptr;
+
+  /* Queues requests and provides network managers - not owned */
+  atools::util::HttpScheduler *scheduler = nullptr;
+  int priority = atools::util::PRIORITY_NORMAL;
 
 };
 
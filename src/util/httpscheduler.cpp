@@ -0,0 +1,156 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/httpscheduler.h"
+#include "util/httpdownloader.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QNetworkAccessManager>
+
+#include <algorithm>
+
+namespace atools {
+namespace util {
+
+HttpScheduler::HttpScheduler(QObject *parent, int maxParallelRequests, int maxParallelRequestsPerHost)
+  : QObject(parent), maxParallel(maxParallelRequests), maxParallelPerHost(maxParallelRequestsPerHost),
+  randomEngine(static_cast<std::mt19937::result_type>(QDateTime::currentMSecsSinceEpoch()))
+{
+}
+
+HttpScheduler::~HttpScheduler()
+{
+  if(!active.isEmpty() || !queue.isEmpty())
+    qWarning() << Q_FUNC_INFO << "Deleted with" << active.size() << "active and" << queue.size() << "queued requests";
+
+  // Network managers are deleted as children
+}
+
+QNetworkAccessManager *HttpScheduler::getNetworkManager(const QString& host)
+{
+  QNetworkAccessManager *manager = managers.value(host, nullptr);
+  if(manager == nullptr)
+  {
+    manager = new QNetworkAccessManager(this);
+    managers.insert(host, manager);
+  }
+  return manager;
+}
+
+void HttpScheduler::setMaxParallelRequests(int value)
+{
+  maxParallel = value;
+  startNext();
+}
+
+void HttpScheduler::setMaxParallelRequestsPerHost(int value)
+{
+  maxParallelPerHost = value;
+  startNext();
+}
+
+void HttpScheduler::enqueue(HttpDownloader *downloader, const QString& host, int priority)
+{
+  for(int i = queue.size() - 1; i >= 0; i--)
+  {
+    if(queue.at(i).downloader == downloader)
+      queue.remove(i);
+  }
+
+  queue.append({downloader, host, priority, sequence++});
+  startNext();
+}
+
+void HttpScheduler::release(HttpDownloader *downloader)
+{
+  for(int i = queue.size() - 1; i >= 0; i--)
+  {
+    if(queue.at(i).downloader == downloader)
+      queue.remove(i);
+  }
+
+  QHash<const HttpDownloader *, QString>::iterator it = active.find(downloader);
+  if(it != active.end())
+  {
+    QHash<QString, int>::iterator hostIt = activePerHost.find(it.value());
+    if(hostIt != activePerHost.end() && --hostIt.value() <= 0)
+      activePerHost.erase(hostIt);
+    active.erase(it);
+
+    startNext();
+  }
+}
+
+bool HttpScheduler::contains(const HttpDownloader *downloader) const
+{
+  if(active.contains(downloader))
+    return true;
+
+  for(const QueueEntry& entry : queue)
+  {
+    if(entry.downloader == downloader)
+      return true;
+  }
+  return false;
+}
+
+void HttpScheduler::startNext()
+{
+  // Avoid recursion if a downloader releases its slot while being started
+  if(starting)
+    return;
+
+  starting = true;
+  while(active.size() < maxParallel)
+  {
+    // Find entry with highest priority and lowest sequence number for a host which has free slots
+    int best = -1;
+    for(int i = 0; i < queue.size(); i++)
+    {
+      const QueueEntry& entry = queue.at(i);
+      if(activePerHost.value(entry.host, 0) < maxParallelPerHost &&
+         (best == -1 || entry.priority < queue.at(best).priority ||
+          (entry.priority == queue.at(best).priority && entry.sequence < queue.at(best).sequence)))
+        best = i;
+    }
+
+    if(best == -1)
+      // Nothing left or all hosts busy
+      break;
+
+    QueueEntry entry = queue.takeAt(best);
+    active.insert(entry.downloader, entry.host);
+    activePerHost[entry.host]++;
+    entry.downloader->startRequest(getNetworkManager(entry.host));
+  }
+  starting = false;
+}
+
+int HttpScheduler::jitter(int intervalMs)
+{
+  if(jitterPercent <= 0)
+    return intervalMs;
+
+  int range = static_cast<int>(static_cast<qint64>(intervalMs) * jitterPercent / 100);
+  std::uniform_int_distribution<int> distribution(-range, range);
+  return std::max(intervalMs + distribution(randomEngine), 1);
+}
+
+} // namespace util
+} // namespace atools
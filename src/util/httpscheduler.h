@@ -0,0 +1,162 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_HTTPSCHEDULER_H
+#define ATOOLS_UTIL_HTTPSCHEDULER_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include <random>
+
+class QNetworkAccessManager;
+
+namespace atools {
+namespace util {
+
+class HttpDownloader;
+
+/* Order of requests waiting in the scheduler queue */
+enum HttpPriority
+{
+  PRIORITY_USER = 0, /* Data visible to the user like weather or online networks */
+  PRIORITY_NORMAL = 1, /* Data needed later like winds aloft or tracks */
+  PRIORITY_BACKGROUND = 2 /* Anything else like update checks */
+};
+
+/*
+ * Download scheduler which can be shared by all HttpDownloader objects living in the same thread.
+ *
+ * Provides one QNetworkAccessManager per host to allow reuse of keep-alive, TLS and HTTP/2 connections
+ * across downloaders. Requests are queued and started in priority order while the number of parallel
+ * requests is limited overall and per host. This avoids firing all downloads at once on startup.
+ *
+ * Update periods of downloaders using the scheduler are jittered to spread recurring downloads over time.
+ *
+ * The scheduler has to be deleted after all downloaders using it.
+ */
+class HttpScheduler :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  HttpScheduler(QObject *parent, int maxParallelRequests = 4, int maxParallelRequestsPerHost = 2);
+  virtual ~HttpScheduler() override;
+
+  /* Get the shared network manager for a host. Created on demand and owned by this scheduler. */
+  QNetworkAccessManager *getNetworkManager(const QString& host);
+
+  /* Maximum number of requests running at the same time for all hosts */
+  void setMaxParallelRequests(int value);
+
+  int getMaxParallelRequests() const
+  {
+    return maxParallel;
+  }
+
+  /* Maximum number of requests running at the same time for the same host */
+  void setMaxParallelRequestsPerHost(int value);
+
+  int getMaxParallelRequestsPerHost() const
+  {
+    return maxParallelPerHost;
+  }
+
+  /* Update periods of downloaders are randomly changed by up to this percentage. 0 disables jitter. */
+  void setTimerJitterPercent(int value)
+  {
+    jitterPercent = value;
+  }
+
+  int getTimerJitterPercent() const
+  {
+    return jitterPercent;
+  }
+
+  /* Allow HTTP/2 for requests started by the scheduler. Needs Qt 5.10 or later. Enabled by default. */
+  void setHttp2Allowed(bool value)
+  {
+    http2Allowed = value;
+  }
+
+  bool isHttp2Allowed() const
+  {
+    return http2Allowed;
+  }
+
+  /* Number of requests waiting to be started */
+  int getNumQueued() const
+  {
+    return queue.size();
+  }
+
+  /* Number of requests running */
+  int getNumActive() const
+  {
+    return active.size();
+  }
+
+private:
+  friend class HttpDownloader;
+
+  struct QueueEntry
+  {
+    HttpDownloader *downloader;
+    QString host;
+    int priority;
+    quint64 sequence; /* Keeps order for same priority */
+  };
+
+  /* Queue a request. The scheduler calls HttpDownloader::startRequest() once a slot is free.
+   * Replaces any queued request of the same downloader. */
+  void enqueue(HttpDownloader *downloader, const QString& host, int priority);
+
+  /* Remove a request from the queue or release its slot if running and start the next ones */
+  void release(HttpDownloader *downloader);
+
+  /* true if queued or running */
+  bool contains(const HttpDownloader *downloader) const;
+
+  /* Start queued requests while limits allow */
+  void startNext();
+
+  /* Apply jitter to a timer interval */
+  int jitter(int intervalMs);
+
+  QVector<QueueEntry> queue;
+
+  /* Running downloaders and their hosts */
+  QHash<const HttpDownloader *, QString> active;
+  QHash<QString, int> activePerHost;
+
+  /* Host to network manager map */
+  QHash<QString, QNetworkAccessManager *> managers;
+
+  int maxParallel, maxParallelPerHost, jitterPercent = 10;
+  quint64 sequence = 0;
+  bool starting = false, http2Allowed = true;
+
+  std::mt19937 randomEngine;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_HTTPSCHEDULER_H
@@ -0,0 +1,250 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/jsonstreamreader.h"
+
+namespace atools {
+namespace util {
+
+/* Remove consumed bytes from buffer if more than this number */
+const static int COMPACT_SIZE = 65536;
+
+JsonStreamReader::JsonStreamReader()
+{
+
+}
+
+void JsonStreamReader::addData(const QByteArray& data)
+{
+  addData(data.constData(), data.size());
+}
+
+void JsonStreamReader::addData(const char *data, int size)
+{
+  if(pos > COMPACT_SIZE)
+  {
+    buffer.remove(0, pos);
+    pos = 0;
+  }
+  buffer.append(data, size);
+}
+
+void JsonStreamReader::clear()
+{
+  buffer.clear();
+  pos = 0;
+  stack.clear();
+  key.clear();
+  value.clear();
+  errorString.clear();
+  string = false;
+}
+
+JsonStreamReader::TokenType JsonStreamReader::setError(const QString& message)
+{
+  if(errorString.isEmpty())
+    errorString = message + QString(" at buffer position %1").arg(pos);
+  return INVALID;
+}
+
+bool JsonStreamReader::skipWhitespace()
+{
+  while(pos < buffer.size())
+  {
+    char c = buffer.at(pos);
+    if(c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ',')
+      pos++;
+    else
+      return true;
+  }
+  return false;
+}
+
+JsonStreamReader::TokenType JsonStreamReader::readNext()
+{
+  if(hasError())
+    return INVALID;
+
+  // Rewind to start of token if it is incomplete
+  int start = pos;
+  if(!skipWhitespace())
+    return NONE;
+
+  key.clear();
+  value.clear();
+  string = false;
+
+  char c = buffer.at(pos);
+  if(c == '}' || c == ']')
+  {
+    if(stack.isEmpty() || stack.last().array != (c == ']'))
+      return setError("Unexpected closing bracket");
+
+    pos++;
+    key = stack.last().key;
+    stack.removeLast();
+    return c == '}' ? END_OBJECT : END_ARRAY;
+  }
+
+  if(!stack.isEmpty() && !stack.last().array)
+  {
+    // Member of object - read key and colon first
+    if(c != '"')
+      return setError("Expected key");
+
+    QString memberKey;
+    if(!readString(memberKey) || !skipWhitespace())
+    {
+      pos = start;
+      return hasError() ? INVALID : NONE;
+    }
+
+    if(buffer.at(pos) != ':')
+      return setError("Expected colon");
+    pos++;
+
+    if(!skipWhitespace())
+    {
+      pos = start;
+      return NONE;
+    }
+    key = memberKey;
+    c = buffer.at(pos);
+  }
+
+  if(c == '{' || c == '[')
+  {
+    pos++;
+    stack.append({key, c == '['});
+    return c == '{' ? START_OBJECT : START_ARRAY;
+  }
+  else if(c == '"')
+  {
+    if(!readString(value))
+    {
+      pos = start;
+      return hasError() ? INVALID : NONE;
+    }
+    string = true;
+    return VALUE;
+  }
+  else
+  {
+    // Number, boolean or null - needs the following delimiter to be complete
+    int end = pos;
+    while(end < buffer.size())
+    {
+      char e = buffer.at(end);
+      if(e == ',' || e == '}' || e == ']' || e == ' ' || e == '\n' || e == '\r' || e == '\t')
+        break;
+      end++;
+    }
+
+    if(end == buffer.size())
+    {
+      pos = start;
+      return NONE;
+    }
+
+    value = QString::fromLatin1(buffer.constData() + pos, end - pos);
+    pos = end;
+    return VALUE;
+  }
+}
+
+bool JsonStreamReader::readString(QString& str)
+{
+  const char *data = buffer.constData();
+  int size = buffer.size();
+
+  // Find closing quote
+  int end = pos + 1;
+  bool escaped = false;
+  while(end < size && data[end] != '"')
+  {
+    if(data[end] == '\\')
+    {
+      escaped = true;
+      end++;
+    }
+    end++;
+  }
+
+  if(end >= size)
+    // Incomplete
+    return false;
+
+  if(!escaped)
+    str = QString::fromUtf8(data + pos + 1, end - pos - 1);
+  else
+  {
+    str.clear();
+    int segment = pos + 1;
+    for(int i = pos + 1; i < end; i++)
+    {
+      if(data[i] == '\\')
+      {
+        str.append(QString::fromUtf8(data + segment, i - segment));
+        char e = data[++i];
+        switch(e)
+        {
+          case 'b':
+            str.append('\b');
+            break;
+          case 'f':
+            str.append('\f');
+            break;
+          case 'n':
+            str.append('\n');
+            break;
+          case 'r':
+            str.append('\r');
+            break;
+          case 't':
+            str.append('\t');
+            break;
+          case 'u':
+            {
+              // Append UTF-16 code unit - surrogate pairs are joined by QString
+              bool ok = false;
+              ushort unit = i + 4 < end ? QByteArray(data + i + 1, 4).toUShort(&ok, 16) : 0;
+              if(!ok)
+              {
+                setError("Invalid unicode escape");
+                return false;
+              }
+              str.append(QChar(unit));
+              i += 4;
+            }
+            break;
+          default:
+            // Quote, backslash and slash
+            str.append(QLatin1Char(e));
+        }
+        segment = i + 1;
+      }
+    }
+    str.append(QString::fromUtf8(data + segment, end - segment));
+  }
+
+  pos = end + 1;
+  return true;
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,125 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_JSONSTREAMREADER_H
+#define ATOOLS_UTIL_JSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+namespace atools {
+namespace util {
+
+/*
+ * Incremental pull parser for UTF-8 encoded JSON documents which arrive in chunks, e.g. while downloading.
+ * Works similar to QXmlStreamReader and avoids materializing the whole document like QJsonDocument.
+ *
+ * Call addData() for each chunk and readNext() until it returns NONE which indicates that more data is needed.
+ * Only the data of an incomplete token is kept in the buffer.
+ *
+ * Commas and structure are checked leniently.
+ */
+class JsonStreamReader
+{
+public:
+  enum TokenType
+  {
+    NONE, /* More data needed */
+    START_OBJECT,
+    END_OBJECT,
+    START_ARRAY,
+    END_ARRAY,
+    VALUE, /* String, number, boolean or null */
+    INVALID /* Syntax error. See getErrorString() */
+  };
+
+  JsonStreamReader();
+
+  void addData(const QByteArray& data);
+  void addData(const char *data, int size);
+
+  /* Read next token. Returns NONE if more data is needed and INVALID on error. */
+  TokenType readNext();
+
+  /* Key of the current value or container if it is a member of an object. Empty for array elements. */
+  const QString& getKey() const
+  {
+    return key;
+  }
+
+  /* Unescaped content of string or text of a number, boolean or null literal */
+  const QString& getValue() const
+  {
+    return value;
+  }
+
+  /* true if the current value is a string */
+  bool isString() const
+  {
+    return string;
+  }
+
+  /* true if the current value is the literal null */
+  bool isNull() const
+  {
+    return !string && value == QLatin1String("null");
+  }
+
+  /* Number of open containers. Includes the container for START_* tokens and excludes it for END_* tokens. */
+  int getDepth() const
+  {
+    return stack.size();
+  }
+
+  bool hasError() const
+  {
+    return !errorString.isEmpty();
+  }
+
+  const QString& getErrorString() const
+  {
+    return errorString;
+  }
+
+  /* Clear buffer and state to read a new document */
+  void clear();
+
+private:
+  struct Container
+  {
+    QString key;
+    bool array;
+  };
+
+  /* Returns false if string is incomplete. Sets the error if string is invalid. pos has to point to the quote. */
+  bool readString(QString& str);
+  bool skipWhitespace();
+  TokenType setError(const QString& message);
+
+  QByteArray buffer;
+  int pos = 0;
+  QVector<Container> stack;
+  QString key, value, errorString;
+  bool string = false;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_JSONSTREAMREADER_H
@@ -0,0 +1,371 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_LRUCACHE_H
+#define ATOOLS_UTIL_LRUCACHE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <list>
+#include <memory>
+
+namespace atools {
+namespace util {
+
+/*
+ * Cache with a total cost limit, least recently used eviction and an optional time to live for entries.
+ *
+ * Values are returned as copies. Use implicitly shared Qt types or std::shared_ptr<const T> for large values.
+ * The time to live is measured using a monotonic clock and checked when an entry is accessed.
+ * Eviction removes entries from the tail of the usage list and never scans the whole cache.
+ *
+ * A cache with numShards > 0 is split into shards selected by key hash. Each shard has its own mutex and
+ * an equal part of the total cost so that threads using different keys rarely block each other.
+ * numShards = 0 uses one shard without locking which is only usable from a single thread.
+ */
+template<typename KEY, typename TYPE>
+class LruCache
+{
+public:
+  /* maxCost is the total cost of all entries. timeoutMs is the time to live of an entry or 0 for no timeout. */
+  explicit LruCache(qint64 maxCost, qint64 timeoutMs = 0, int numShards = 0);
+
+  LruCache(const LruCache& other) = delete;
+  LruCache& operator=(const LruCache& other) = delete;
+
+  /* Add or replace an entry and mark it as most recently used. Evicts least recently used entries if
+   * the cost limit is exceeded. Returns false and drops an existing entry if cost is larger than a shard. */
+  bool insert(const KEY& key, const TYPE& value, qint64 cost = 1);
+
+  /* Copy entry to value and mark it as most recently used. Returns false if not found or timed out.
+   * Timed out entries are removed. */
+  bool find(const KEY& key, TYPE& value);
+
+  /* Get entry or defaultValue if not found or timed out */
+  TYPE value(const KEY& key, const TYPE& defaultValue = TYPE());
+
+  /* true if entry exists and is not timed out. Does not change the usage order. */
+  bool contains(const KEY& key);
+
+  /* Return a copy of the entry and remove it. Returns a default constructed value if not found or timed out. */
+  TYPE take(const KEY& key);
+
+  /* Remove entry. Returns true if it was found. */
+  bool remove(const KEY& key);
+
+  /* Remove all entries */
+  void clear();
+
+  /* Remove all timed out entries. This scans the whole cache. Returns number of removed entries. */
+  int removeTimedOut();
+
+  /* Change cost limit and evict entries if needed */
+  void setMaxCost(qint64 cost);
+
+  qint64 getMaxCost() const
+  {
+    return maxCost;
+  }
+
+  /* Change time to live in milliseconds. Applies to existing entries too. 0 disables the timeout. */
+  void setTimeout(qint64 timeoutMs)
+  {
+    timeout.store(timeoutMs);
+  }
+
+  qint64 getTimeout() const
+  {
+    return timeout.load();
+  }
+
+  /* Number of entries including timed out ones which were not accessed yet */
+  int size() const;
+
+  /* Total cost of all entries */
+  qint64 totalCost() const;
+
+  /* Number of locked shards or 0 if not thread safe */
+  int getNumShards() const
+  {
+    return threadSafe ? numShards : 0;
+  }
+
+private:
+  struct Node
+  {
+    KEY key;
+    TYPE value;
+    qint64 cost, inserted;
+  };
+
+  typedef std::list<Node> NodeList;
+
+  struct Shard
+  {
+    /* Most recently used first */
+    NodeList nodes;
+    QHash<KEY, typename NodeList::iterator> index;
+    qint64 cost = 0, maxCost = 0;
+    mutable QMutex mutex;
+  };
+
+  Shard& shardFor(const KEY& key) const
+  {
+    return shards[numShards > 1 ? qHash(key) % static_cast<uint>(numShards) : 0];
+  }
+
+  /* Null if not locking which disables QMutexLocker */
+  QMutex *mutexFor(const Shard& shard) const
+  {
+    return threadSafe ? &shard.mutex : nullptr;
+  }
+
+  bool isTimedOut(const Node& node) const
+  {
+    qint64 ttl = timeout.load();
+    return ttl > 0 && clock.elapsed() - node.inserted > ttl;
+  }
+
+  /* Find entry, remove it if timed out and return end() if not found */
+  typename NodeList::iterator findNode(Shard& shard, const KEY& key);
+  void removeNode(Shard& shard, typename NodeList::iterator node);
+
+  /* Remove timed out entries from the tail and least recently used entries until the shard fits */
+  void evict(Shard& shard);
+
+  std::unique_ptr<Shard[]> shards;
+  int numShards;
+  bool threadSafe;
+  qint64 maxCost;
+  std::atomic<qint64> timeout;
+
+  /* Monotonic clock for entry timestamps */
+  QElapsedTimer clock;
+};
+
+template<typename KEY, typename TYPE>
+LruCache<KEY, TYPE>::LruCache(qint64 maxCostParam, qint64 timeoutMs, int numShardsParam)
+  : shards(new Shard[static_cast<size_t>(std::max(numShardsParam, 1))]), numShards(std::max(numShardsParam, 1)),
+  threadSafe(numShardsParam > 0), maxCost(0), timeout(timeoutMs)
+{
+  clock.start();
+  setMaxCost(maxCostParam);
+}
+
+template<typename KEY, typename TYPE>
+bool LruCache<KEY, TYPE>::insert(const KEY& key, const TYPE& value, qint64 cost)
+{
+  Shard& shard = shardFor(key);
+  QMutexLocker locker(mutexFor(shard));
+
+  auto it = shard.index.find(key);
+  if(it != shard.index.end())
+    removeNode(shard, it.value());
+
+  if(cost > shard.maxCost)
+    return false;
+
+  shard.nodes.push_front({key, value, cost, clock.elapsed()});
+  shard.index.insert(key, shard.nodes.begin());
+  shard.cost += cost;
+  evict(shard);
+  return true;
+}
+
+template<typename KEY, typename TYPE>
+bool LruCache<KEY, TYPE>::find(const KEY& key, TYPE& value)
+{
+  Shard& shard = shardFor(key);
+  QMutexLocker locker(mutexFor(shard));
+
+  typename NodeList::iterator node = findNode(shard, key);
+  if(node == shard.nodes.end())
+    return false;
+
+  // Move to front - iterators stay valid
+  if(node != shard.nodes.begin())
+    shard.nodes.splice(shard.nodes.begin(), shard.nodes, node);
+  value = node->value;
+  return true;
+}
+
+template<typename KEY, typename TYPE>
+TYPE LruCache<KEY, TYPE>::value(const KEY& key, const TYPE& defaultValue)
+{
+  TYPE retval;
+  if(find(key, retval))
+    return retval;
+  else
+    return defaultValue;
+}
+
+template<typename KEY, typename TYPE>
+bool LruCache<KEY, TYPE>::contains(const KEY& key)
+{
+  Shard& shard = shardFor(key);
+  QMutexLocker locker(mutexFor(shard));
+  return findNode(shard, key) != shard.nodes.end();
+}
+
+template<typename KEY, typename TYPE>
+TYPE LruCache<KEY, TYPE>::take(const KEY& key)
+{
+  Shard& shard = shardFor(key);
+  QMutexLocker locker(mutexFor(shard));
+
+  TYPE retval;
+  typename NodeList::iterator node = findNode(shard, key);
+  if(node != shard.nodes.end())
+  {
+    retval = node->value;
+    removeNode(shard, node);
+  }
+  return retval;
+}
+
+template<typename KEY, typename TYPE>
+bool LruCache<KEY, TYPE>::remove(const KEY& key)
+{
+  Shard& shard = shardFor(key);
+  QMutexLocker locker(mutexFor(shard));
+
+  auto it = shard.index.find(key);
+  if(it == shard.index.end())
+    return false;
+
+  removeNode(shard, it.value());
+  return true;
+}
+
+template<typename KEY, typename TYPE>
+void LruCache<KEY, TYPE>::clear()
+{
+  for(int i = 0; i < numShards; i++)
+  {
+    Shard& shard = shards[i];
+    QMutexLocker locker(mutexFor(shard));
+    shard.index.clear();
+    shard.nodes.clear();
+    shard.cost = 0;
+  }
+}
+
+template<typename KEY, typename TYPE>
+int LruCache<KEY, TYPE>::removeTimedOut()
+{
+  int removed = 0;
+  for(int i = 0; i < numShards; i++)
+  {
+    Shard& shard = shards[i];
+    QMutexLocker locker(mutexFor(shard));
+    for(auto node = shard.nodes.begin(); node != shard.nodes.end();)
+    {
+      auto next = std::next(node);
+      if(isTimedOut(*node))
+      {
+        removeNode(shard, node);
+        removed++;
+      }
+      node = next;
+    }
+  }
+  return removed;
+}
+
+template<typename KEY, typename TYPE>
+void LruCache<KEY, TYPE>::setMaxCost(qint64 cost)
+{
+  maxCost = cost;
+  for(int i = 0; i < numShards; i++)
+  {
+    Shard& shard = shards[i];
+    QMutexLocker locker(mutexFor(shard));
+    shard.maxCost = cost / numShards;
+    evict(shard);
+  }
+}
+
+template<typename KEY, typename TYPE>
+int LruCache<KEY, TYPE>::size() const
+{
+  int num = 0;
+  for(int i = 0; i < numShards; i++)
+  {
+    const Shard& shard = shards[i];
+    QMutexLocker locker(mutexFor(shard));
+    num += shard.index.size();
+  }
+  return num;
+}
+
+template<typename KEY, typename TYPE>
+qint64 LruCache<KEY, TYPE>::totalCost() const
+{
+  qint64 cost = 0;
+  for(int i = 0; i < numShards; i++)
+  {
+    const Shard& shard = shards[i];
+    QMutexLocker locker(mutexFor(shard));
+    cost += shard.cost;
+  }
+  return cost;
+}
+
+template<typename KEY, typename TYPE>
+typename LruCache<KEY, TYPE>::NodeList::iterator LruCache<KEY, TYPE>::findNode(Shard& shard, const KEY& key)
+{
+  auto it = shard.index.find(key);
+  if(it == shard.index.end())
+    return shard.nodes.end();
+
+  typename NodeList::iterator node = it.value();
+  if(isTimedOut(*node))
+  {
+    removeNode(shard, node);
+    return shard.nodes.end();
+  }
+  return node;
+}
+
+template<typename KEY, typename TYPE>
+void LruCache<KEY, TYPE>::removeNode(Shard& shard, typename NodeList::iterator node)
+{
+  shard.cost -= node->cost;
+  shard.index.remove(node->key);
+  shard.nodes.erase(node);
+}
+
+template<typename KEY, typename TYPE>
+void LruCache<KEY, TYPE>::evict(Shard& shard)
+{
+  // Timed out entries at the tail are not used anymore - drop them early
+  while(!shard.nodes.empty() && isTimedOut(shard.nodes.back()))
+    removeNode(shard, std::prev(shard.nodes.end()));
+
+  while(shard.cost > shard.maxCost && !shard.nodes.empty())
+    removeNode(shard, std::prev(shard.nodes.end()));
+}
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_LRUCACHE_H
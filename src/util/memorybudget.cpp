@@ -0,0 +1,198 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/memorybudget.h"
+
+#include <QDebug>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace atools {
+namespace util {
+
+MemoryBudget& MemoryBudget::instance()
+{
+  static MemoryBudget budget;
+  return budget;
+}
+
+int MemoryBudget::add(const QString& name, MemoryPriority priority, const ShrinkFunc& shrink, QObject *context)
+{
+  std::shared_ptr<ShrinkState> state;
+  if(shrink)
+  {
+    state = std::make_shared<ShrinkState>();
+    state->shrink = shrink;
+    state->context = context;
+    state->hasContext = context != nullptr;
+  }
+
+  QMutexLocker locker(&mutex);
+  int id = nextId++;
+  clients.insert(id, {name, priority, state, 0, false});
+  return id;
+}
+
+void MemoryBudget::remove(int id)
+{
+  std::shared_ptr<ShrinkState> state;
+  {
+    QMutexLocker locker(&mutex);
+    auto it = clients.find(id);
+    if(it != clients.end())
+    {
+      totalCost -= it->cost;
+      state = it->state;
+      clients.erase(it);
+    }
+  }
+
+  if(state != nullptr)
+  {
+    // Wait for a running shrink call
+    QMutexLocker stateLocker(&state->mutex);
+    state->removed = true;
+  }
+}
+
+void MemoryBudget::setCost(int id, qint64 bytes)
+{
+  QVector<ShrinkCall> calls;
+  {
+    QMutexLocker locker(&mutex);
+    auto it = clients.find(id);
+    if(it == clients.end())
+      return;
+
+    totalCost += bytes - it->cost;
+    it->cost = bytes;
+    it->shrinkPending = false;
+    calls = collectShrinkCalls();
+  }
+  callShrink(calls);
+}
+
+void MemoryBudget::setBudget(qint64 bytes)
+{
+  QVector<ShrinkCall> calls;
+  {
+    QMutexLocker locker(&mutex);
+    budget = std::max(bytes, qint64(0));
+    qDebug() << Q_FUNC_INFO << "budget" << budget << "total cost" << totalCost;
+    calls = collectShrinkCalls();
+  }
+  callShrink(calls);
+}
+
+qint64 MemoryBudget::getBudget() const
+{
+  QMutexLocker locker(&mutex);
+  return budget;
+}
+
+qint64 MemoryBudget::getTotalCost() const
+{
+  QMutexLocker locker(&mutex);
+  return totalCost;
+}
+
+void MemoryBudget::logStatus() const
+{
+  QMutexLocker locker(&mutex);
+  qDebug() << Q_FUNC_INFO << "budget" << budget << "total cost" << totalCost;
+  for(const Client& client : clients)
+    qDebug() << Q_FUNC_INFO << client.name << "priority" << client.priority << "cost" << client.cost
+             << "shrink pending" << client.shrinkPending;
+}
+
+QVector<MemoryBudget::ShrinkCall> MemoryBudget::collectShrinkCalls()
+{
+  QVector<ShrinkCall> calls;
+  if(budget == 0 || totalCost <= budget)
+    return calls;
+
+  // Caches which can be asked to shrink and did not get a request since their last update
+  QVector<Client *> candidates;
+  for(Client& client : clients)
+  {
+    if(client.state != nullptr && !client.shrinkPending && client.cost > 0)
+      candidates.append(&client);
+  }
+
+  // Lowest priority first and largest first within a priority
+  std::sort(candidates.begin(), candidates.end(), [](const Client *client1, const Client *client2) -> bool {
+        if(client1->priority != client2->priority)
+          return client1->priority < client2->priority;
+        else
+          return client1->cost > client2->cost;
+      });
+
+  qint64 excess = totalCost - static_cast<qint64>(budget * SHRINK_TARGET);
+  for(Client *client : candidates)
+  {
+    if(excess <= 0)
+      break;
+
+    qint64 bytes = std::min(excess, client->cost);
+    client->shrinkPending = true;
+    calls.append({client->state, bytes});
+    excess -= bytes;
+
+    qDebug() << Q_FUNC_INFO << "shrinking" << client->name << "by" << bytes << "total cost" << totalCost
+             << "budget" << budget;
+  }
+  return calls;
+}
+
+void MemoryBudget::callShrink(const QVector<ShrinkCall>& calls)
+{
+  for(const ShrinkCall& call : calls)
+  {
+    if(call.state->hasContext)
+    {
+      // Context was deleted after collecting - cache is gone
+      QObject *context = call.state->context.data();
+      if(context == nullptr)
+        continue;
+
+      std::shared_ptr<ShrinkState> state = call.state;
+      qint64 bytes = call.bytes;
+      QTimer::singleShot(0, context, [state, bytes]() {
+            callShrink(*state, bytes);
+          });
+    }
+    else
+      callShrink(*call.state, call.bytes);
+  }
+}
+
+void MemoryBudget::callShrink(ShrinkState& state, qint64 bytes)
+{
+  // Do not block if the cache is shrinking already in another thread or reports its cost from
+  // within the shrink function
+  if(state.mutex.tryLock())
+  {
+    if(!state.removed)
+      state.shrink(bytes);
+    state.mutex.unlock();
+  }
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,145 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_MEMORYBUDGET_H
+#define ATOOLS_UTIL_MEMORYBUDGET_H
+
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+
+namespace atools {
+namespace util {
+
+/* Order in which caches are asked to shrink. Low priority caches are asked first. */
+enum MemoryPriority
+{
+  /* Cheap to rebuild like file caches */
+  MEMORY_LOW,
+  MEMORY_NORMAL,
+
+  /* Expensive to rebuild. Only asked if lower priorities cannot free enough. */
+  MEMORY_HIGH
+};
+
+/*
+ * Process wide registry for memory used by caches and a coordinator keeping the sum below a budget.
+ *
+ * Caches register with a name, a priority and a shrink function and update their current cost in bytes
+ * whenever it changes. If the total exceeds the budget the coordinator asks caches to free memory in the
+ * order of priority and cost, largest low priority caches first, until the total is expected to drop
+ * below SHRINK_TARGET of the budget. A cache is not asked again until it reported a new cost.
+ *
+ * The shrink function is called with the number of bytes to free. It is called in the thread of the context
+ * object through the event queue if a context is given. Otherwise it is called directly in the thread
+ * calling setCost() and has to be thread safe. A request is dropped if the shrink function of the same cache
+ * is already running. Caches without shrink function are only counted.
+ *
+ * All methods are thread safe. A budget of 0 disables shrinking.
+ */
+class MemoryBudget
+{
+public:
+  typedef std::function<void(qint64 bytes)> ShrinkFunc;
+
+  /* Fraction of the budget which should be used after shrinking. Avoids shrinking on each insert. */
+  static constexpr double SHRINK_TARGET = 0.8;
+
+  MemoryBudget() = default;
+
+  MemoryBudget(const MemoryBudget& other) = delete;
+  MemoryBudget& operator=(const MemoryBudget& other) = delete;
+
+  /* Shared instance used by all caches */
+  static MemoryBudget& instance();
+
+  /* Register a cache and get an id for setCost() and remove(). Cost is 0 initially.
+   * The shrink call is dropped if context is deleted. */
+  int add(const QString& name, MemoryPriority priority, const ShrinkFunc& shrink = nullptr, QObject *context = nullptr);
+
+  /* Unregister a cache. Waits for a running shrink function. No shrink function is called after this returns.
+   * Must not be called from within the shrink function. */
+  void remove(int id);
+
+  /* Update the current cost of a cache in bytes and shrink caches if the budget is exceeded */
+  void setCost(int id, qint64 bytes);
+
+  /* Set budget in bytes and shrink caches if needed. 0 disables shrinking. */
+  void setBudget(qint64 bytes);
+
+  qint64 getBudget() const;
+
+  /* Sum of the cost of all registered caches */
+  qint64 getTotalCost() const;
+
+  /* Log name, priority and cost for all caches */
+  void logStatus() const;
+
+private:
+  /* Shared with queued calls to detect removed caches */
+  struct ShrinkState
+  {
+    ShrinkFunc shrink;
+    QPointer<QObject> context;
+    bool hasContext;
+
+    /* Locked while calling shrink. removed is set by remove(). */
+    QMutex mutex;
+    bool removed = false;
+  };
+
+  struct Client
+  {
+    QString name;
+    MemoryPriority priority;
+    std::shared_ptr<ShrinkState> state;
+    qint64 cost;
+
+    /* Shrinking was requested and cache did not report a new cost yet */
+    bool shrinkPending;
+  };
+
+  struct ShrinkCall
+  {
+    std::shared_ptr<ShrinkState> state;
+    qint64 bytes;
+  };
+
+  /* Collect shrink requests if over budget. Mutex has to be locked. */
+  QVector<ShrinkCall> collectShrinkCalls();
+
+  /* Call shrink functions. Mutex must not be locked. */
+  static void callShrink(const QVector<ShrinkCall>& calls);
+  static void callShrink(ShrinkState& state, qint64 bytes);
+
+  QHash<int, Client> clients;
+  qint64 budget = 0, totalCost = 0;
+  int nextId = 1;
+
+  /* Guards all fields. Not held while calling shrink functions. */
+  mutable QMutex mutex;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_MEMORYBUDGET_H
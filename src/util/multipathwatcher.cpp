@@ -0,0 +1,286 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/multipathwatcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QStorageInfo>
+
+namespace atools {
+namespace util {
+
+MultiPathWatcher::MultiPathWatcher(QObject *parent, bool verboseLogging)
+  : QObject(parent), verbose(verboseLogging)
+{
+  qRegisterMetaType<atools::util::FileChangeSet>();
+
+  delayTimer.setSingleShot(true);
+  connect(&delayTimer, &QTimer::timeout, this, &MultiPathWatcher::changedDelayed);
+  connect(&checkTimer, &QTimer::timeout, this, &MultiPathWatcher::check);
+}
+
+MultiPathWatcher::~MultiPathWatcher()
+{
+  stopWatching();
+}
+
+void MultiPathWatcher::setPathsAndStart(const QStringList& pathList, const QStringList& filters, bool recursiveParam)
+{
+  qDebug() << Q_FUNC_INFO << pathList << filters << recursiveParam;
+
+  stopWatching();
+  nameFilters = filters;
+  recursive = recursiveParam;
+
+  for(const QString& path : pathList)
+  {
+    paths.append(QDir::cleanPath(path));
+    networkPaths.append(pollingOnly || isNetworkPath(path));
+
+    if(networkPaths.last())
+      qDebug() << Q_FUNC_INFO << "Polling" << paths.last();
+  }
+
+  // Initial state which will omit the first update signal - user has to do the initial load
+  QStringList watchPaths;
+  readSnapshot(snapshot, watchPaths);
+
+  if(!watchPaths.isEmpty())
+  {
+    fsWatcher = new QFileSystemWatcher(this);
+    connect(fsWatcher, &QFileSystemWatcher::fileChanged, this, &MultiPathWatcher::pathChanged);
+    connect(fsWatcher, &QFileSystemWatcher::directoryChanged, this, &MultiPathWatcher::pathChanged);
+    updateWatchedPaths(watchPaths);
+  }
+
+  checkTimer.start(pollingOnly ? pollMs : checkMs);
+}
+
+void MultiPathWatcher::stopWatching()
+{
+  delayTimer.stop();
+  checkTimer.stop();
+
+  if(fsWatcher != nullptr)
+  {
+    fsWatcher->disconnect(this);
+    fsWatcher->deleteLater();
+    fsWatcher = nullptr;
+  }
+
+  paths.clear();
+  networkPaths.clear();
+  nameFilters.clear();
+  snapshot.clear();
+}
+
+bool MultiPathWatcher::isNetworkPath(const QString& path)
+{
+  // UNC paths on Windows or SMB URLs
+  if(path.startsWith(QLatin1String("//")) || path.startsWith(QLatin1String("\\\\")))
+    return true;
+
+  static const QList<QByteArray> NETWORK_FS_TYPES({"cifs", "smb", "smbfs", "smb2", "smb3", "nfs", "nfs4",
+                                                   "afpfs", "webdav", "davfs", "fuse.sshfs", "9p"});
+
+  QStorageInfo storage(path);
+  return storage.isValid() && NETWORK_FS_TYPES.contains(storage.fileSystemType().toLower());
+}
+
+void MultiPathWatcher::readSnapshot(Snapshot& files, QStringList& watchPaths) const
+{
+  for(int i = 0; i < paths.size(); i++)
+  {
+    const QString& path = paths.at(i);
+    bool watch = !networkPaths.at(i);
+
+    QFileInfo fileinfo(path);
+    if(fileinfo.isDir())
+      readDirectory(path, watch, files, watchPaths);
+    else
+    {
+      // Single file - watch the parent directory too to catch creation, deletion and renaming
+      if(fileinfo.isFile() && fileinfo.size() >= minFileSize)
+        files.insert(path, {fileinfo.size(), fileinfo.lastModified().toMSecsSinceEpoch()});
+
+      if(watch)
+      {
+        if(fileinfo.isFile())
+          watchPaths.append(path);
+        if(fileinfo.dir().exists())
+          watchPaths.append(fileinfo.absolutePath());
+      }
+    }
+  }
+}
+
+void MultiPathWatcher::readDirectory(const QString& dir, bool watch, Snapshot& files, QStringList& watchPaths) const
+{
+  if(watch)
+    watchPaths.append(dir);
+
+  // Uses the file information from the directory listing where the platform provides it
+  QDirIterator fileIt(dir, nameFilters, QDir::Files);
+  while(fileIt.hasNext())
+  {
+    fileIt.next();
+    const QFileInfo fileinfo = fileIt.fileInfo();
+    if(fileinfo.size() >= minFileSize)
+      files.insert(fileinfo.filePath(), {fileinfo.size(), fileinfo.lastModified().toMSecsSinceEpoch()});
+  }
+
+  if(recursive)
+  {
+    // Name filters do not apply to directories
+    QDirIterator dirIt(dir, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    while(dirIt.hasNext())
+      readDirectory(dirIt.next(), watch, files, watchPaths);
+  }
+}
+
+FileChangeSet MultiPathWatcher::changes(const Snapshot& from, const Snapshot& to)
+{
+  FileChangeSet changeSet;
+  for(auto it = to.constBegin(); it != to.constEnd(); ++it)
+  {
+    auto fromIt = from.constFind(it.key());
+    if(fromIt == from.constEnd())
+      changeSet.added.append(it.key());
+    else if(fromIt.value() != it.value())
+      changeSet.modified.append(it.key());
+  }
+
+  for(auto it = from.constBegin(); it != from.constEnd(); ++it)
+  {
+    if(!to.contains(it.key()))
+      changeSet.removed.append(it.key());
+  }
+
+  changeSet.added.sort();
+  changeSet.modified.sort();
+  changeSet.removed.sort();
+  return changeSet;
+}
+
+void MultiPathWatcher::pathChanged()
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO;
+
+  // Scan later to coalesce all events of a burst
+  startDelay();
+}
+
+void MultiPathWatcher::check()
+{
+  if(delayTimer.isActive())
+    // Scan is pending anyway
+    return;
+
+  Snapshot files;
+  QStringList watchPaths;
+  readSnapshot(files, watchPaths);
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "files" << files.size();
+
+  if(!changes(snapshot, files).isEmpty())
+    startDelay();
+
+  // Add newly created directories
+  updateWatchedPaths(watchPaths);
+}
+
+void MultiPathWatcher::changedDelayed()
+{
+  Snapshot files;
+  QStringList watchPaths;
+  readSnapshot(files, watchPaths);
+  updateWatchedPaths(watchPaths);
+
+  FileChangeSet changeSet = changes(snapshot, files);
+  snapshot.swap(files);
+
+  if(!changeSet.isEmpty())
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "added" << changeSet.added << "modified" << changeSet.modified
+               << "removed" << changeSet.removed;
+
+    emit filesChanged(changeSet);
+  }
+}
+
+void MultiPathWatcher::startDelay()
+{
+  if(!delayTimer.isActive())
+    delayStart.start();
+
+  if(!delayTimer.isActive() || delayStart.elapsed() + delayMs <= maxDelayMs)
+    // Start or extend the delayed notification
+    delayTimer.start(delayMs);
+  // else leave running timer to avoid postponing the notification forever
+}
+
+void MultiPathWatcher::updateWatchedPaths(const QStringList& watchPaths)
+{
+  if(fsWatcher == nullptr)
+    return;
+
+  // Paths of deleted files and directories are removed by QFileSystemWatcher automatically
+  QSet<QString> watched = (fsWatcher->files() + fsWatcher->directories()).toSet();
+  QStringList missing;
+  for(const QString& path : watchPaths)
+  {
+    if(!watched.contains(path))
+    {
+      missing.append(path);
+      watched.insert(path);
+    }
+  }
+
+  if(!missing.isEmpty())
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "adding" << missing;
+
+    QStringList failed = fsWatcher->addPaths(missing);
+    if(!failed.isEmpty() && warn())
+      qWarning() << Q_FUNC_INFO << "cannot watch" << failed;
+  }
+}
+
+bool MultiPathWatcher::warn()
+{
+  if(numWarnings < MAX_WARNINGS)
+  {
+    numWarnings++;
+    return true;
+  }
+  else if(numWarnings++ == MAX_WARNINGS)
+    qWarning() << Q_FUNC_INFO << "Maximum number of warnings exceeded";
+  return false;
+}
+
+} // namespace util
+} // namespace atools
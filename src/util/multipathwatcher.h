@@ -0,0 +1,197 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_MULTIPATHWATCHER_H
+#define ATOOLS_UTIL_MULTIPATHWATCHER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+class QFileSystemWatcher;
+
+namespace atools {
+namespace util {
+
+/* Files added, modified or removed since the last notification. Lists are sorted. */
+struct FileChangeSet
+{
+  QStringList added, modified, removed;
+
+  bool isEmpty() const
+  {
+    return added.isEmpty() && modified.isEmpty() && removed.isEmpty();
+  }
+
+  /* All added and modified files */
+  QStringList updated() const
+  {
+    return added + modified;
+  }
+};
+
+/*
+ * Watches a set of files and directories and reports all changes within a burst as one change set.
+ *
+ * Changes are detected by comparing snapshots of size and modification time. QFileSystemWatcher events and a
+ * periodic check trigger a new snapshot. Each event extends the delay up to a maximum so that a long running
+ * copy operation results in a few notifications only.
+ *
+ * Paths on network drives are only polled since QFileSystemWatcher does not get notifications for these.
+ * Polling can also be forced for all paths.
+ */
+class MultiPathWatcher
+  : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MultiPathWatcher(QObject *parent, bool verboseLogging);
+  virtual ~MultiPathWatcher() override;
+
+  MultiPathWatcher(const MultiPathWatcher& other) = delete;
+  MultiPathWatcher& operator=(const MultiPathWatcher& other) = delete;
+
+  /* Watch the given files and directories. Files in directories have to match the name filters like "*.txt"
+   * if filters are not empty. Subdirectories are included if recursive is true.
+   * Takes the initial snapshot and does not emit an initial message. */
+  void setPathsAndStart(const QStringList& paths, const QStringList& filters = QStringList(), bool recursive = false);
+
+  /* Stop all notifications and watching */
+  void stopWatching();
+
+  const QStringList& getPaths() const
+  {
+    return paths;
+  }
+
+  /* All files as found by the last snapshot */
+  QStringList getFiles() const
+  {
+    return snapshot.keys();
+  }
+
+  /* Files smaller than this are ignored until they grow. Use to avoid half written files. */
+  void setMinFileSize(qint64 value)
+  {
+    minFileSize = value;
+  }
+
+  /* Delay for the signal after the last detected change */
+  void setDelayMs(int value)
+  {
+    delayMs = value;
+  }
+
+  /* Signal is sent not later than this after the first change even if changes keep coming */
+  void setMaxDelayMs(int value)
+  {
+    maxDelayMs = value;
+  }
+
+  /* Interval for the periodic check which is done in addition to file system notifications */
+  void setCheckMs(int value)
+  {
+    checkMs = value;
+  }
+
+  /* Interval for checks of paths on network drives or if polling is forced */
+  void setPollMs(int value)
+  {
+    pollMs = value;
+  }
+
+  /* Do not use QFileSystemWatcher and rely on polling only. Has to be set before setPathsAndStart(). */
+  void setPollingOnly(bool value)
+  {
+    pollingOnly = value;
+  }
+
+  /* true if the path is on a network file system which does not send change notifications */
+  static bool isNetworkPath(const QString& path);
+
+signals:
+  /* Sent with all changes since the last signal */
+  void filesChanged(const atools::util::FileChangeSet& changes);
+
+private:
+  /* Size and modification time in milliseconds since epoch */
+  struct FileState
+  {
+    qint64 size, lastModified;
+
+    bool operator!=(const FileState& other) const
+    {
+      return size != other.size || lastModified != other.lastModified;
+    }
+
+  };
+
+  typedef QHash<QString, FileState> Snapshot;
+
+  /* Collect state of all watched files and the directories and files to add to the QFileSystemWatcher */
+  void readSnapshot(Snapshot& files, QStringList& directories) const;
+  void readDirectory(const QString& dir, bool watch, Snapshot& files, QStringList& directories) const;
+
+  /* Compare snapshots */
+  static FileChangeSet changes(const Snapshot& from, const Snapshot& to);
+
+  /* Called by QFileSystemWatcher and timers. Starts the delay if something changed. */
+  void pathChanged();
+  void check();
+  void changedDelayed();
+
+  /* Start or extend delay timer for notification */
+  void startDelay();
+
+  /* Add new directories and files to the QFileSystemWatcher */
+  void updateWatchedPaths(const QStringList& watchPaths);
+  bool warn();
+
+  QStringList paths, nameFilters;
+  bool recursive = false, pollingOnly = false;
+
+  /* Flag for each entry in paths. Network paths are only polled. */
+  QVector<bool> networkPaths;
+
+  Snapshot snapshot;
+  QFileSystemWatcher *fsWatcher = nullptr;
+  QTimer checkTimer, delayTimer;
+
+  /* Time since first change for the current delay */
+  QElapsedTimer delayStart;
+
+  qint64 minFileSize = 0;
+  int delayMs = 2000, maxDelayMs = 10000;
+
+  /* Check every ten seconds since the watcher is unreliable and every 30 seconds for network drives */
+  int checkMs = 10000, pollMs = 30000;
+
+  bool verbose;
+  int numWarnings = 0;
+  const static int MAX_WARNINGS = 20;
+};
+
+} // namespace util
+} // namespace atools
+
+Q_DECLARE_METATYPE(atools::util::FileChangeSet);
+
+#endif // ATOOLS_UTIL_MULTIPATHWATCHER_H
@@ -0,0 +1,79 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_PARALLEL_H
+#define ATOOLS_UTIL_PARALLEL_H
+
+#include "util/taskscheduler.h"
+
+#include <QThread>
+
+#include <algorithm>
+
+namespace atools {
+namespace util {
+
+/*
+ * Calls func(i) for all i in range [0, size) using the shared TaskScheduler and waits until all calls are done.
+ * The range is split into one chunk per thread but chunks are not smaller than minChunkSize.
+ * The calling thread works on the first chunk.
+ *
+ * func has to be thread safe and must not throw exceptions.
+ * Can be nested or called from a scheduler task since waiting workers run other tasks.
+ */
+template<typename FUNC>
+void parallelFor(int size, const FUNC& func, int minChunkSize = 1)
+{
+  if(size <= 0)
+    return;
+
+  int numThreads = std::max(1, QThread::idealThreadCount());
+  int chunkSize = std::max(std::max(minChunkSize, 1), (size + numThreads - 1) / numThreads);
+
+  if(numThreads == 1 || chunkSize >= size)
+  {
+    // Not worth to use threads
+    for(int i = 0; i < size; i++)
+      func(i);
+    return;
+  }
+
+  TaskScheduler& scheduler = TaskScheduler::instance();
+  QVector<TaskHandle> tasks;
+  for(int from = chunkSize; from < size; from += chunkSize)
+  {
+    int to = std::min(from + chunkSize, size);
+
+    // Caller is blocked until all chunks are done - take these before queued background work
+    tasks.append(scheduler.run([&func, from, to]() {
+          for(int i = from; i < to; i++)
+            func(i);
+        }, TASK_INTERACTIVE));
+  }
+
+  // Work on first chunk in this thread
+  for(int i = 0; i < chunkSize; i++)
+    func(i);
+
+  for(const TaskHandle& task : tasks)
+    task.wait();
+}
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_PARALLEL_H
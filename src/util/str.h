@@ -21,6 +21,7 @@
 #include <QString>
 #include <tuple>
 #include <cstring>
+#include <algorithm>
 
 namespace atools {
 namespace util {
@@ -38,8 +39,15 @@ class Str
 public:
   explicit Str(const QString& strParam)
   {
-    std::strncpy(str, strParam.toLatin1().data(), SIZE); // Limit to SIZE
-    str[SIZE - 1] = '\0'; // Ensure null termination
+    // Copy directly without the temporary array of toLatin1() and limit to SIZE
+    int size = std::min(strParam.size(), SIZE - 1);
+    const QChar *data = strParam.constData();
+    for(int i = 0; i < size; i++)
+    {
+      ushort c = data[i].unicode();
+      str[i] = c < 256 ? static_cast<char>(c) : '?'; // Same replacement as toLatin1()
+    }
+    str[size] = '\0'; // Ensure null termination
   }
 
   Str()
@@ -0,0 +1,147 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "util/stringinterner.h"
+
+namespace atools {
+namespace util {
+
+namespace {
+/* Set by StringInternerScope. Separate for each thread so that concurrent compilations do not interfere. */
+thread_local StringInterner *currentInterner = nullptr;
+}
+
+StringInterner::StringInterner()
+  : numLookups(0), numHits(0)
+{
+}
+
+StringInterner::~StringInterner()
+{
+}
+
+QString StringInterner::intern(const QString& value)
+{
+  if(value.isEmpty())
+    return value;
+
+  QString shared;
+  lookup(value, &shared);
+  return shared;
+}
+
+int StringInterner::id(const QString& value)
+{
+  if(value.isEmpty())
+    return -1;
+
+  return lookup(value, nullptr);
+}
+
+int StringInterner::lookup(const QString& value, QString *shared)
+{
+  uint hash = qHash(value);
+  int shardIndex = static_cast<int>(hash % NUM_SHARDS);
+  Shard& shard = shards[shardIndex];
+
+  numLookups.fetch_add(1, std::memory_order_relaxed);
+
+  QMutexLocker locker(&shard.mutex);
+  QHash<QString, int>::const_iterator it = shard.ids.constFind(value);
+  int index;
+  if(it != shard.ids.constEnd())
+  {
+    numHits.fetch_add(1, std::memory_order_relaxed);
+    index = it.value();
+    if(shared != nullptr)
+      *shared = shard.values.at(index);
+  }
+  else
+  {
+    // Detach from the buffer of the caller which might be a part of a larger string
+    QString copy(value.constData(), value.size());
+    index = shard.values.size();
+    shard.values.append(copy);
+    shard.ids.insert(copy, index);
+    if(shared != nullptr)
+      *shared = copy;
+  }
+
+  // Shard in lower bits
+  return index * NUM_SHARDS + shardIndex;
+}
+
+QString StringInterner::value(int id) const
+{
+  if(id < 0)
+    return QString();
+
+  const Shard& shard = shards[id % NUM_SHARDS];
+  QMutexLocker locker(&shard.mutex);
+  return shard.values.value(id / NUM_SHARDS);
+}
+
+int StringInterner::size() const
+{
+  int num = 0;
+  for(const Shard& shard : shards)
+  {
+    QMutexLocker locker(&shard.mutex);
+    num += shard.values.size();
+  }
+  return num;
+}
+
+void StringInterner::clear()
+{
+  for(Shard& shard : shards)
+  {
+    QMutexLocker locker(&shard.mutex);
+    shard.ids.clear();
+    shard.values.clear();
+  }
+  numLookups.store(0);
+  numHits.store(0);
+}
+
+StringInterner *StringInterner::current()
+{
+  return currentInterner;
+}
+
+// =====================================================================================
+StringInternerScope::StringInternerScope(StringInterner *interner)
+  : previous(currentInterner)
+{
+  currentInterner = interner;
+}
+
+StringInternerScope::~StringInternerScope()
+{
+  currentInterner = previous;
+}
+
+// =====================================================================================
+QString intern(const QString& value)
+{
+  StringInterner *interner = StringInterner::current();
+  return interner != nullptr ? interner->intern(value) : value;
+}
+
+} // namespace util
+} // namespace atools
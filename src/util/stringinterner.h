@@ -0,0 +1,126 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef ATOOLS_UTIL_STRINGINTERNER_H
+#define ATOOLS_UTIL_STRINGINTERNER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+namespace atools {
+namespace util {
+
+/*
+ * Thread safe pool of shared strings for text values which repeat often like region codes, airway names
+ * or city, state and country names.
+ *
+ * intern() returns the first instance seen for a value. Copies share the data by the implicit sharing of QString
+ * which keeps only one allocation for each distinct value in memory. Each distinct value also gets a dictionary id
+ * which is stable for the lifetime of the interner and can be used to write dictionary coded columns.
+ *
+ * Values are distributed across locked shards to allow concurrent use by the BGL reader threads.
+ */
+class StringInterner
+{
+public:
+  StringInterner();
+  ~StringInterner();
+
+  StringInterner(const StringInterner& other) = delete;
+  StringInterner& operator=(const StringInterner& other) = delete;
+
+  /* Get the shared instance of value. Null and empty strings are returned unchanged. */
+  QString intern(const QString& value);
+
+  /* Dictionary id of value. Adds the value if not already known. -1 for null or empty strings. */
+  int id(const QString& value);
+
+  /* Value for a dictionary id or a null string if the id is not valid */
+  QString value(int id) const;
+
+  /* Number of distinct values */
+  int size() const;
+
+  /* Number of calls to intern() and id() and how many of these found an existing value */
+  quint64 getNumLookups() const
+  {
+    return numLookups.load();
+  }
+
+  quint64 getNumHits() const
+  {
+    return numHits.load();
+  }
+
+  /* Remove all values and reset statistics. Dictionary ids are not valid anymore. */
+  void clear();
+
+  /* Interner installed for the calling thread by StringInternerScope or null if none */
+  static StringInterner *current();
+
+private:
+  friend class StringInternerScope;
+
+  static const int NUM_SHARDS = 16;
+
+  struct Shard
+  {
+    mutable QMutex mutex;
+
+    /* Value to index in values */
+    QHash<QString, int> ids;
+    QVector<QString> values;
+  };
+
+  /* Find or add value and return the dictionary id. Copies the shared instance to shared if not null. */
+  int lookup(const QString& value, QString *shared);
+
+  Shard shards[NUM_SHARDS];
+  std::atomic<quint64> numLookups, numHits;
+};
+
+/*
+ * Installs an interner for the calling thread only for the lifetime of this object and restores the previous
+ * one of this thread on destruction. Other threads are not affected.
+ * Each thread using intern() like BGL reader tasks has to create its own scope. The interner is not owned and has
+ * to outlive all scopes referring to it. Null disables interning for the calling thread.
+ */
+class StringInternerScope
+{
+public:
+  explicit StringInternerScope(StringInterner *interner);
+  ~StringInternerScope();
+
+  StringInternerScope(const StringInternerScope& other) = delete;
+  StringInternerScope& operator=(const StringInternerScope& other) = delete;
+
+private:
+  StringInterner *previous;
+};
+
+/* Intern value using the interner of the calling thread or return value unchanged if no scope is active */
+QString intern(const QString& value);
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_STRINGINTERNER_H
@@ -0,0 +1,373 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/taskscheduler.h"
+
+#include <QDebug>
+#include <QThread>
+
+#include <algorithm>
+
+namespace atools {
+namespace util {
+
+namespace internal {
+
+struct TaskState
+{
+  std::function<void()> func;
+  TaskPriority priority;
+  CancellationToken token;
+  TaskScheduler *scheduler;
+
+  /* Guards the fields below */
+  QMutex mutex;
+  QWaitCondition finishedCondition;
+  bool finished = false, canceled = false;
+  QVector<QSharedPointer<TaskState> > continuations;
+};
+
+/* Local queue of a worker */
+struct TaskQueue
+{
+  QMutex mutex;
+  std::deque<QSharedPointer<TaskState> > tasks;
+};
+
+class TaskWorker :
+  public QThread
+{
+public:
+  TaskWorker(TaskScheduler *schedulerParam, int indexParam)
+    : scheduler(schedulerParam), index(indexParam)
+  {
+    setObjectName(QString("TaskWorker %1").arg(index));
+  }
+
+  virtual void run() override
+  {
+    scheduler->workerLoop(index);
+  }
+
+private:
+  TaskScheduler *scheduler;
+  int index;
+};
+
+}
+
+using internal::TaskState;
+using internal::TaskQueue;
+using internal::TaskWorker;
+
+namespace {
+
+/* Worker running in the current thread */
+thread_local TaskScheduler *currentScheduler = nullptr;
+thread_local int currentIndex = -1;
+
+}
+
+// ===============================================================================================
+// TaskHandle
+// ===============================================================================================
+
+bool TaskHandle::isFinished() const
+{
+  if(state.isNull())
+    return true;
+
+  QMutexLocker locker(&state->mutex);
+  return state->finished;
+}
+
+bool TaskHandle::isCanceled() const
+{
+  if(state.isNull())
+    return false;
+
+  QMutexLocker locker(&state->mutex);
+  return state->canceled;
+}
+
+void TaskHandle::wait() const
+{
+  if(state.isNull())
+    return;
+
+  TaskScheduler *scheduler = state->scheduler;
+  int workerIndex = scheduler->currentWorkerIndex();
+
+  if(workerIndex >= 0)
+  {
+    // Help with other tasks instead of blocking the worker
+    while(!isFinished())
+    {
+      if(!scheduler->runOne(workerIndex))
+      {
+        // Nothing to do - task is running in another worker
+        QMutexLocker locker(&state->mutex);
+        if(!state->finished)
+          state->finishedCondition.wait(&state->mutex, 1);
+      }
+    }
+  }
+  else
+  {
+    QMutexLocker locker(&state->mutex);
+    while(!state->finished)
+      state->finishedCondition.wait(&state->mutex);
+  }
+}
+
+TaskHandle TaskHandle::then(const std::function<void()>& func, TaskPriority priority) const
+{
+  Q_ASSERT(!state.isNull());
+
+  QSharedPointer<TaskState> continuation = QSharedPointer<TaskState>::create();
+  continuation->func = func;
+  continuation->priority = priority;
+  continuation->token = state->token;
+  continuation->scheduler = state->scheduler;
+
+  bool scheduleNow;
+  {
+    QMutexLocker locker(&state->mutex);
+    scheduleNow = state->finished;
+    if(!scheduleNow)
+      state->continuations.append(continuation);
+  }
+
+  if(scheduleNow)
+    state->scheduler->schedule(continuation);
+
+  return TaskHandle(continuation);
+}
+
+// ===============================================================================================
+// TaskScheduler
+// ===============================================================================================
+
+TaskScheduler::TaskScheduler(int numThreads)
+  : numQueued(0)
+{
+  if(numThreads < 1)
+    numThreads = std::max(1, QThread::idealThreadCount());
+
+  for(int i = 0; i < numThreads; i++)
+  {
+    localQueues.append(new TaskQueue);
+    workers.append(new TaskWorker(this, i));
+  }
+
+  for(TaskWorker *worker : workers)
+    worker->start();
+
+  qDebug() << Q_FUNC_INFO << "Started" << numThreads << "workers";
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  {
+    QMutexLocker locker(&mutex);
+    stopping = true;
+    condition.wakeAll();
+  }
+
+  for(TaskWorker *worker : workers)
+    worker->wait();
+
+  qDeleteAll(workers);
+  qDeleteAll(localQueues);
+}
+
+TaskScheduler& TaskScheduler::instance()
+{
+  static TaskScheduler scheduler;
+  return scheduler;
+}
+
+TaskHandle TaskScheduler::run(const std::function<void()>& func, TaskPriority priority,
+                              const CancellationToken& token)
+{
+  TaskPtr task = QSharedPointer<TaskState>::create();
+  task->func = func;
+  task->priority = priority;
+  task->token = token;
+  task->scheduler = this;
+
+  schedule(task);
+  return TaskHandle(task);
+}
+
+int TaskScheduler::currentWorkerIndex() const
+{
+  return currentScheduler == this ? currentIndex : -1;
+}
+
+void TaskScheduler::schedule(const TaskPtr& task)
+{
+  int workerIndex = currentWorkerIndex();
+
+  if(task->priority == TASK_BACKGROUND && workerIndex >= 0)
+  {
+    // Nested background work stays local to the worker and can be stolen by others
+    TaskQueue *queue = localQueues.at(workerIndex);
+    QMutexLocker locker(&queue->mutex);
+    queue->tasks.push_back(task);
+  }
+
+  QMutexLocker locker(&mutex);
+  if(task->priority == TASK_INTERACTIVE)
+    interactiveQueue.push_back(task);
+  else if(workerIndex < 0)
+    backgroundQueue.push_back(task);
+
+  // Increment while locked to avoid lost wakeups for workers going idle
+  numQueued++;
+  condition.wakeOne();
+}
+
+TaskScheduler::TaskPtr TaskScheduler::take(int workerIndex)
+{
+  TaskPtr task;
+
+  {
+    QMutexLocker locker(&mutex);
+    if(!interactiveQueue.empty())
+    {
+      task = interactiveQueue.front();
+      interactiveQueue.pop_front();
+    }
+  }
+
+  if(task.isNull() && workerIndex >= 0)
+  {
+    // Newest task from own queue which is probably still in cache
+    TaskQueue *queue = localQueues.at(workerIndex);
+    QMutexLocker locker(&queue->mutex);
+    if(!queue->tasks.empty())
+    {
+      task = queue->tasks.back();
+      queue->tasks.pop_back();
+    }
+  }
+
+  if(task.isNull())
+  {
+    QMutexLocker locker(&mutex);
+    if(!backgroundQueue.empty())
+    {
+      task = backgroundQueue.front();
+      backgroundQueue.pop_front();
+    }
+  }
+
+  // Steal oldest task from other workers
+  for(int i = 1; task.isNull() && i <= localQueues.size(); i++)
+  {
+    int victim = (std::max(workerIndex, 0) + i) % localQueues.size();
+    if(victim == workerIndex)
+      continue;
+
+    TaskQueue *queue = localQueues.at(victim);
+    QMutexLocker locker(&queue->mutex);
+    if(!queue->tasks.empty())
+    {
+      task = queue->tasks.front();
+      queue->tasks.pop_front();
+    }
+  }
+
+  if(!task.isNull())
+    numQueued--;
+  return task;
+}
+
+bool TaskScheduler::runOne(int workerIndex)
+{
+  TaskPtr task = take(workerIndex);
+  if(task.isNull())
+    return false;
+
+  execute(task);
+  return true;
+}
+
+void TaskScheduler::execute(const TaskPtr& task)
+{
+  bool canceled = task->token.isCanceled();
+
+  if(!canceled)
+  {
+    try
+    {
+      task->func();
+    }
+    catch(const std::exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Caught exception" << e.what();
+    }
+    catch(...)
+    {
+      qWarning() << Q_FUNC_INFO << "Caught unknown exception";
+    }
+  }
+
+  // Release captured data early since handles may be kept for a long time
+  task->func = nullptr;
+
+  QVector<TaskPtr> continuations;
+  {
+    QMutexLocker locker(&task->mutex);
+    task->finished = true;
+    task->canceled = canceled;
+    continuations.swap(task->continuations);
+    task->finishedCondition.wakeAll();
+  }
+
+  for(const TaskPtr& continuation : continuations)
+    schedule(continuation);
+}
+
+void TaskScheduler::workerLoop(int workerIndex)
+{
+  currentScheduler = this;
+  currentIndex = workerIndex;
+
+  while(true)
+  {
+    if(runOne(workerIndex))
+      continue;
+
+    QMutexLocker locker(&mutex);
+    if(numQueued.load() > 0)
+      // Added in the meantime
+      continue;
+
+    if(stopping)
+      break;
+
+    condition.wait(&mutex);
+  }
+
+  currentScheduler = nullptr;
+  currentIndex = -1;
+}
+
+} // namespace util
+} // namespace atools
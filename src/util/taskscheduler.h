@@ -0,0 +1,192 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_TASKSCHEDULER_H
+#define ATOOLS_UTIL_TASKSCHEDULER_H
+
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+
+namespace atools {
+namespace util {
+
+class TaskScheduler;
+
+enum TaskPriority
+{
+  /* Short work a user is waiting for. Always taken before background tasks. */
+  TASK_INTERACTIVE,
+
+  /* Long running work like loading, compiling, parsing or decoding */
+  TASK_BACKGROUND
+};
+
+/*
+ * Shared flag to cancel tasks. Tasks which are not started yet are skipped after cancel().
+ * Long running tasks should check isCanceled() and return early. Copies share the same flag.
+ */
+class CancellationToken
+{
+public:
+  CancellationToken()
+    : canceled(new std::atomic<bool>(false))
+  {
+  }
+
+  void cancel()
+  {
+    canceled->store(true);
+  }
+
+  bool isCanceled() const
+  {
+    return canceled->load();
+  }
+
+private:
+  QSharedPointer<std::atomic<bool> > canceled;
+};
+
+namespace internal {
+struct TaskState;
+struct TaskQueue;
+class TaskWorker;
+}
+
+/* Handle of a scheduled task. Copies refer to the same task. */
+class TaskHandle
+{
+public:
+  TaskHandle()
+  {
+  }
+
+  /* false if default constructed */
+  bool isValid() const
+  {
+    return !state.isNull();
+  }
+
+  /* true if the task has run or was skipped due to cancellation */
+  bool isFinished() const;
+
+  /* true if the task was skipped since the token was canceled before it started */
+  bool isCanceled() const;
+
+  /* Wait until the task is finished. Runs other queued tasks while waiting if called from a worker thread
+   * which avoids deadlocks for nested tasks. */
+  void wait() const;
+
+  /* Schedule func to run once this task is finished or skipped. The continuation uses the same token and is skipped
+   * too if the token is canceled. Returns the handle of the continuation. */
+  TaskHandle then(const std::function<void()>& func, TaskPriority priority = TASK_BACKGROUND) const;
+
+private:
+  friend class TaskScheduler;
+
+  explicit TaskHandle(const QSharedPointer<internal::TaskState>& stateParam)
+    : state(stateParam)
+  {
+  }
+
+  QSharedPointer<internal::TaskState> state;
+};
+
+/*
+ * Work stealing task scheduler with a fixed number of worker threads.
+ *
+ * Each worker has its own queue. Background tasks started from a worker go into its queue and are taken LIFO by
+ * the worker itself while idle workers steal the oldest tasks. Tasks from other threads and all interactive tasks
+ * go into shared queues. Interactive tasks are always taken first.
+ *
+ * Tasks must not block on anything else than other tasks of the scheduler since this ties up a worker.
+ * Exceptions thrown by tasks are logged and dropped.
+ *
+ * Use instance() for shared background work instead of creating own threads or pools.
+ */
+class TaskScheduler
+{
+public:
+  /* Creates numThreads workers. Uses the number of cores if numThreads is less than one. */
+  explicit TaskScheduler(int numThreads = 0);
+
+  /* Runs all queued tasks and stops the workers */
+  ~TaskScheduler();
+
+  /* Shared scheduler for all atools background work */
+  static TaskScheduler& instance();
+
+  /* Queue func which will be skipped if token is canceled before it starts */
+  TaskHandle run(const std::function<void()>& func, TaskPriority priority = TASK_BACKGROUND,
+                 const CancellationToken& token = CancellationToken());
+
+  int getNumThreads() const
+  {
+    return workers.size();
+  }
+
+  /* true if called from one of the worker threads of this scheduler */
+  bool isWorkerThread() const
+  {
+    return currentWorkerIndex() >= 0;
+  }
+
+private:
+  Q_DISABLE_COPY(TaskScheduler)
+
+  friend class TaskHandle;
+  friend class internal::TaskWorker;
+
+  typedef QSharedPointer<internal::TaskState> TaskPtr;
+
+  /* Index of the worker of this scheduler running in the calling thread or -1 */
+  int currentWorkerIndex() const;
+
+  void schedule(const TaskPtr& task);
+
+  /* Take the next task for the worker or any task if workerIndex is -1. Returns null if all queues are empty. */
+  TaskPtr take(int workerIndex);
+
+  /* Run the next task if any. Returns false if nothing was found. */
+  bool runOne(int workerIndex);
+
+  void execute(const TaskPtr& task);
+  void workerLoop(int workerIndex);
+
+  QVector<internal::TaskWorker *> workers;
+  QVector<internal::TaskQueue *> localQueues;
+
+  /* Guards the shared queues and is used for waiting idle workers */
+  QMutex mutex;
+  QWaitCondition condition;
+  std::deque<TaskPtr> interactiveQueue, backgroundQueue;
+
+  /* Number of tasks in all queues. Can be off by one for a short time since local queues have own locks. */
+  std::atomic<int> numQueued;
+  bool stopping = false;
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_TASKSCHEDULER_H
@@ -23,7 +23,8 @@
 namespace atools {
 namespace util {
 
-/* Simple hash that removes entries on timeout when they are accessed */
+/* Simple hash that removes entries on timeout when they are accessed.
+ * Unbounded and not thread safe. Use LruCache for new code. */
 template<typename KEY, typename TYPE>
 class TimedCache
 {
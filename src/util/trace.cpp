@@ -0,0 +1,235 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/trace.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace atools {
+namespace util {
+
+namespace {
+
+struct TraceEvent
+{
+  const char *name, *category;
+  qint64 startUs, durationUs;
+};
+
+/* Ring buffer of one thread. Locked since writing the JSON file reads buffers of other threads. */
+struct TraceBuffer
+{
+  QMutex mutex;
+  QVector<TraceEvent> events;
+  int next = 0, threadId = 0;
+  QString threadName;
+};
+
+/* All buffers of running and finished threads */
+QMutex buffersMutex;
+QVector<QSharedPointer<TraceBuffer> > buffers;
+
+thread_local QSharedPointer<TraceBuffer> threadBuffer;
+
+TraceBuffer *currentBuffer()
+{
+  if(threadBuffer.isNull())
+  {
+    threadBuffer = QSharedPointer<TraceBuffer>::create();
+    threadBuffer->events.reserve(Trace::BUFFER_SIZE);
+
+    QThread *thread = QThread::currentThread();
+    threadBuffer->threadName = thread != nullptr ? thread->objectName() : QString();
+
+    QMutexLocker locker(&buffersMutex);
+    threadBuffer->threadId = buffers.size() + 1;
+    buffers.append(threadBuffer);
+  }
+  return threadBuffer.data();
+}
+
+void writeJsonString(QByteArray& out, const QString& str)
+{
+  out.append('"');
+  for(QChar c : str)
+  {
+    if(c == '"' || c == '\\')
+      out.append('\\').append(c.toLatin1());
+    else if(c.unicode() < 0x20)
+      out.append(QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0')).toLatin1());
+    else
+      out.append(QString(c).toUtf8());
+  }
+  out.append('"');
+}
+
+}
+
+std::atomic<bool> Trace::enabled(false);
+
+void Trace::setEnabled(bool value)
+{
+  qDebug() << Q_FUNC_INFO << value;
+  enabled.store(value, std::memory_order_relaxed);
+}
+
+qint64 Trace::nowUs()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::addEvent(const char *name, const char *category, qint64 startUs, qint64 durationUs)
+{
+  TraceBuffer *buffer = currentBuffer();
+  QMutexLocker locker(&buffer->mutex);
+
+  TraceEvent event = {name, category, startUs, durationUs};
+  if(buffer->events.size() < BUFFER_SIZE)
+    buffer->events.append(event);
+  else
+    // Full - overwrite oldest
+    buffer->events[buffer->next] = event;
+  buffer->next = (buffer->next + 1) % BUFFER_SIZE;
+}
+
+void Trace::clear()
+{
+  QMutexLocker locker(&buffersMutex);
+  for(const QSharedPointer<TraceBuffer>& buffer : buffers)
+  {
+    QMutexLocker bufferLocker(&buffer->mutex);
+    buffer->events.clear();
+    buffer->next = 0;
+  }
+}
+
+void Trace::logSummary(const char *category)
+{
+  struct Summary
+  {
+    int count = 0;
+    qint64 totalUs = 0, maxUs = 0;
+  };
+
+  // Keep order of first occurrence
+  QVector<QByteArray> names;
+  QHash<QByteArray, Summary> summaries;
+  {
+    QMutexLocker locker(&buffersMutex);
+    for(const QSharedPointer<TraceBuffer>& buffer : buffers)
+    {
+      QMutexLocker bufferLocker(&buffer->mutex);
+      for(const TraceEvent& event : buffer->events)
+      {
+        if(category != nullptr && std::strcmp(event.category, category) != 0)
+          continue;
+
+        QByteArray name(event.name);
+        if(!summaries.contains(name))
+          names.append(name);
+
+        Summary& summary = summaries[name];
+        summary.count++;
+        summary.totalUs += event.durationUs;
+        summary.maxUs = std::max(summary.maxUs, event.durationUs);
+      }
+    }
+  }
+
+  qInfo() << Q_FUNC_INFO << "Category" << (category != nullptr ? category : "all");
+  for(const QByteArray& name : names)
+  {
+    const Summary& summary = summaries.value(name);
+    qInfo().noquote() << name << "count" << summary.count << "total" << summary.totalUs / 1000. << "ms"
+                      << "max" << summary.maxUs / 1000. << "ms";
+  }
+}
+
+bool Trace::writeJson(const QString& filename)
+{
+  QByteArray out;
+  QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+  bool first = true;
+
+  out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  {
+    QMutexLocker locker(&buffersMutex);
+    for(const QSharedPointer<TraceBuffer>& buffer : buffers)
+    {
+      QMutexLocker bufferLocker(&buffer->mutex);
+      QByteArray tid = QByteArray::number(buffer->threadId);
+
+      if(!buffer->threadName.isEmpty())
+      {
+        // Metadata event naming the thread
+        out.append(first ? "" : ",\n");
+        out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":").append(pid).
+        append(",\"tid\":").append(tid).append(",\"args\":{\"name\":");
+        writeJsonString(out, buffer->threadName);
+        out.append("}}");
+        first = false;
+      }
+
+      // Oldest first if the ring buffer wrapped around
+      int size = buffer->events.size();
+      int start = size < BUFFER_SIZE ? 0 : buffer->next;
+      for(int i = 0; i < size; i++)
+      {
+        const TraceEvent& event = buffer->events.at((start + i) % size);
+        out.append(first ? "" : ",\n");
+        out.append("{\"name\":");
+        writeJsonString(out, QString::fromLatin1(event.name));
+        out.append(",\"cat\":");
+        writeJsonString(out, QString::fromLatin1(event.category));
+        out.append(",\"ph\":\"X\",\"ts\":").append(QByteArray::number(event.startUs)).
+        append(",\"dur\":").append(QByteArray::number(event.durationUs)).
+        append(",\"pid\":").append(pid).append(",\"tid\":").append(tid).append('}');
+        first = false;
+      }
+    }
+  }
+  out.append("\n]}\n");
+
+  QFile file(filename);
+  if(file.open(QIODevice::WriteOnly))
+  {
+    bool ok = file.write(out) == out.size();
+    file.close();
+    qDebug() << Q_FUNC_INFO << "Wrote" << out.size() << "bytes to" << filename;
+    return ok;
+  }
+  else
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+    return false;
+  }
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,117 @@
+/*****************************************************************************
+* Copyright 2015-2020 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_TRACE_H
+#define ATOOLS_UTIL_TRACE_H
+
+#include <QtGlobal>
+
+#include <atomic>
+
+class QString;
+
+namespace atools {
+namespace util {
+
+/*
+ * Lightweight tracing of scoped spans. Each thread records complete events into its own ring buffer
+ * which keeps the last BUFFER_SIZE events. All buffers can be saved as Chrome trace event JSON which can be
+ * loaded into chrome://tracing or Perfetto.
+ *
+ * Disabled by default. A span costs a relaxed atomic load if disabled.
+ * Define ATOOLS_NO_TRACE to remove all spans at compile time.
+ *
+ * Use the macro ATOOLS_TRACE_SCOPE("name", "category") to trace the enclosing scope.
+ * Name and category are not copied and have to be string literals.
+ */
+class Trace
+{
+public:
+  /* Maximum number of events kept per thread */
+  static const int BUFFER_SIZE = 16384;
+
+  /* Enable or disable recording. Spans already started are recorded when they end. */
+  static void setEnabled(bool value);
+
+  static bool isEnabled()
+  {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /* Write events of all threads to the file in Chrome trace event JSON format. Returns false on error. */
+  static bool writeJson(const QString& filename);
+
+  /* Remove all recorded events */
+  static void clear();
+
+  /* Log number of calls, total and maximum duration for each span name in the given category or for all
+   * spans if category is null. Call logSummary("startup") once the application is initialized to see the startup
+   * spans of a real run. atools::gui::StartupBenchmark measures the same steps cold and warm. */
+  static void logSummary(const char *category = nullptr);
+
+  /* Current timestamp in microseconds of a monotonic clock */
+  static qint64 nowUs();
+
+  /* Add a complete event to the buffer of the calling thread. Used by TraceSpan. */
+  static void addEvent(const char *name, const char *category, qint64 startUs, qint64 durationUs);
+
+private:
+  static std::atomic<bool> enabled;
+};
+
+/* Records a complete event covering the lifetime of this object if tracing was enabled on construction */
+class TraceSpan
+{
+public:
+  TraceSpan(const char *spanName, const char *spanCategory)
+  {
+    if(Trace::isEnabled())
+    {
+      name = spanName;
+      category = spanCategory;
+      start = Trace::nowUs();
+    }
+  }
+
+  ~TraceSpan()
+  {
+    if(name != nullptr)
+      Trace::addEvent(name, category, start, Trace::nowUs() - start);
+  }
+
+private:
+  Q_DISABLE_COPY(TraceSpan)
+
+  const char *name = nullptr, *category = nullptr;
+  qint64 start = 0L;
+};
+
+} // namespace util
+} // namespace atools
+
+#define ATOOLS_TRACE_CONCAT_INTERNAL(a, b) a ## b
+#define ATOOLS_TRACE_CONCAT(a, b) ATOOLS_TRACE_CONCAT_INTERNAL(a, b)
+
+#if defined(ATOOLS_NO_TRACE)
+#define ATOOLS_TRACE_SCOPE(name, category)
+#else
+/* Trace the enclosing scope. Name and category have to be string literals. */
+#define ATOOLS_TRACE_SCOPE(name, category) \
+  atools::util::TraceSpan ATOOLS_TRACE_CONCAT(atoolsTraceSpan, __LINE__)(name, category)
+#endif
+
+#endif // ATOOLS_UTIL_TRACE_H
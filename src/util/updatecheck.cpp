@@ -17,6 +17,7 @@
 
 #include "util/updatecheck.h"
 #include "util/version.h"
+#include "util/httpscheduler.h"
 
 #include <QNetworkReply>
 #include <QApplication>
@@ -63,7 +64,11 @@ void UpdateCheck::checkForUpdates(const QString& versionsAlreadChecked, bool not
 
   // Post the request
   QNetworkRequest request(url);
-  reply = networkManager.get(request);
+  if(scheduler != nullptr)
+    // Single request - only share the connection but do not queue
+    reply = scheduler->getNetworkManager(url.host())->get(request);
+  else
+    reply = networkManager.get(request);
 
   if(reply != nullptr)
   {
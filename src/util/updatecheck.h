@@ -24,6 +24,8 @@
 namespace atools {
 namespace util {
 
+class HttpScheduler;
+
 /* Updates can be fetched for each channel in one call */
 enum UpdateChannel
 {
@@ -113,6 +115,12 @@ public:
   /* Force notification and ignore time and skip lists */
   void setForceDebug(bool value);
 
+  /* Use the network manager of the shared download scheduler to reuse connections. Scheduler is not owned. */
+  void setScheduler(atools::util::HttpScheduler *value)
+  {
+    scheduler = value;
+  }
+
 signals:
   /* Sent if updates were found */
   void updateFound(UpdateList updates);
@@ -136,6 +144,7 @@ private:
 
   QNetworkAccessManager networkManager;
   QNetworkReply *reply = nullptr;
+  atools::util::HttpScheduler *scheduler = nullptr;
   QUrl url;
 
   /* Also send message if nothing was found */
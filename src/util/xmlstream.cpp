@@ -20,10 +20,45 @@
 
 #include <QFileDevice>
 #include <QDebug>
+#include <QVarLengthArray>
 
 namespace atools {
 namespace util {
 
+XmlNameTable::XmlNameTable(std::initializer_list<std::pair<const char *, int> > names)
+{
+  // Table size is power of two and at least twice the number of names to keep probe sequences short
+  int size = 4;
+  while(size < static_cast<int>(names.size()) * 2)
+    size *= 2;
+  entries.resize(size);
+  mask = static_cast<uint>(size - 1);
+
+  for(const std::pair<const char *, int>& name : names)
+  {
+    QString str = QLatin1String(name.first);
+    uint index = qHash(QStringRef(&str)) & mask;
+    while(!entries.at(static_cast<int>(index)).name.isNull())
+      index = (index + 1) & mask;
+    entries[static_cast<int>(index)].name = str;
+    entries[static_cast<int>(index)].id = name.second;
+  }
+}
+
+int XmlNameTable::id(const QStringRef& name, int unknown) const
+{
+  uint index = qHash(name) & mask;
+  while(true)
+  {
+    const Entry& entry = entries.at(static_cast<int>(index));
+    if(entry.name.isNull())
+      return unknown;
+    if(entry.name == name)
+      return entry.id;
+    index = (index + 1) & mask;
+  }
+}
+
 void XmlStream::readUntilElement(const QString& name)
 {
   while(reader.name() != name)
@@ -41,12 +76,8 @@ void XmlStream::checkError(QXmlStreamReader& reader)
 {
   if(reader.hasError())
   {
-    // Try to get filename for report
-    QFileDevice *df = dynamic_cast<QFileDevice *>(reader.device());
-    QString filename = df != nullptr ? df->fileName() : QString();
-
     QString msg = tr("Error reading \"%1\" on line %2 column %3: %4").
-                  arg(filename).arg(reader.lineNumber()).arg(reader.columnNumber()).arg(reader.errorString());
+                  arg(getFilename()).arg(reader.lineNumber()).arg(reader.columnNumber()).arg(reader.errorString());
     qWarning() << Q_FUNC_INFO << msg;
     throw atools::Exception(msg);
   }
@@ -56,14 +87,130 @@ void XmlStream::skipCurrentElement(bool warning)
 {
   if(warning)
   {
-    // Try to get filename for warning
-    QFileDevice *df = dynamic_cast<QFileDevice *>(reader.device());
-    QString filename = df != nullptr ? df->fileName() : QString();
     qWarning() << Q_FUNC_INFO << "Unexpected element" << reader.name()
-               << "in file" << filename << "in line" << reader.lineNumber();
+               << "in file" << getFilename() << "in line" << reader.lineNumber();
   }
   reader.skipCurrentElement();
 }
 
+template<typename FUNC>
+bool XmlStream::readElementTextRef(FUNC func)
+{
+  // Text is usually one token which is converted right away since the reference is invalid after readNext().
+  // A copy on the stack is kept for the rare case of several tokens like CDATA sections or comments.
+  QVarLengthArray<QChar, 64> text;
+  int numTokens = 0;
+  bool found = false;
+
+  while(!reader.atEnd())
+  {
+    QXmlStreamReader::TokenType token = reader.readNext();
+    if(token == QXmlStreamReader::Characters || token == QXmlStreamReader::EntityReference)
+    {
+      const QStringRef ref = reader.text();
+      if(numTokens == 0)
+        found = func(ref);
+      text.append(ref.constData(), ref.size());
+      numTokens++;
+    }
+    else if(token == QXmlStreamReader::EndElement)
+      break;
+    else if(token == QXmlStreamReader::StartElement)
+    {
+      reader.raiseError(tr("Expected character data."));
+      return false;
+    }
+    else if(token == QXmlStreamReader::Invalid)
+      return false;
+    // Ignore comments and processing instructions
+  }
+
+  if(numTokens > 1)
+  {
+    const QString str(text.constData(), text.size());
+    found = func(QStringRef(&str));
+  }
+  return found;
+}
+
+float XmlStream::readElementTextFloat(float defaultValue, bool *ok)
+{
+  float value = defaultValue;
+  bool valid = readElementTextRef([&value, defaultValue](const QStringRef& text) -> bool {
+                                    bool conv;
+                                    value = text.toFloat(&conv);
+                                    if(!conv)
+                                      value = defaultValue;
+                                    return conv;
+                                  });
+  if(ok != nullptr)
+    *ok = valid;
+  return value;
+}
+
+double XmlStream::readElementTextDouble(double defaultValue, bool *ok)
+{
+  double value = defaultValue;
+  bool valid = readElementTextRef([&value, defaultValue](const QStringRef& text) -> bool {
+                                    bool conv;
+                                    value = text.toDouble(&conv);
+                                    if(!conv)
+                                      value = defaultValue;
+                                    return conv;
+                                  });
+  if(ok != nullptr)
+    *ok = valid;
+  return value;
+}
+
+int XmlStream::readElementTextInt(int defaultValue, bool *ok)
+{
+  int value = defaultValue;
+  bool valid = readElementTextRef([&value, defaultValue](const QStringRef& text) -> bool {
+                                    bool conv;
+                                    value = text.trimmed().toInt(&conv);
+                                    if(!conv)
+                                      value = defaultValue;
+                                    return conv;
+                                  });
+  if(ok != nullptr)
+    *ok = valid;
+  return value;
+}
+
+float XmlStream::readAttributeFloat(QLatin1String name, float defaultValue, bool *ok) const
+{
+  bool conv;
+  float value = reader.attributes().value(name).toFloat(&conv);
+  if(ok != nullptr)
+    *ok = conv;
+  return conv ? value : defaultValue;
+}
+
+double XmlStream::readAttributeDouble(QLatin1String name, double defaultValue, bool *ok) const
+{
+  bool conv;
+  double value = reader.attributes().value(name).toDouble(&conv);
+  if(ok != nullptr)
+    *ok = conv;
+  return conv ? value : defaultValue;
+}
+
+int XmlStream::readAttributeInt(QLatin1String name, int defaultValue, bool *ok) const
+{
+  bool conv;
+  int value = reader.attributes().value(name).trimmed().toInt(&conv);
+  if(ok != nullptr)
+    *ok = conv;
+  return conv ? value : defaultValue;
+}
+
+QString XmlStream::getFilename() const
+{
+  // Try to get filename for report
+  QFileDevice *df = dynamic_cast<QFileDevice *>(reader.device());
+  return df != nullptr ? df->fileName() : filename;
+}
+
 } // namespace util
 } // namespace atools
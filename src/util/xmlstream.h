@@ -20,10 +20,40 @@
 
 #include <QXmlStreamReader>
 #include <QApplication>
+#include <QVector>
+
+#include <initializer_list>
+#include <utility>
 
 namespace atools {
 namespace util {
 
+/*
+ * Maps element or attribute names to integer ids which allows to use a switch statement instead of comparing
+ * the reader's QStringRef against string literals. Each such comparison converts the literal to a temporary QString.
+ *
+ * Build once as static constant and use with XmlStream::elementId().
+ * Lookup is an open addressing hash on the string reference and does not allocate memory.
+ */
+class XmlNameTable
+{
+public:
+  XmlNameTable(std::initializer_list<std::pair<const char *, int> > names);
+
+  /* Id for name or unknown if not found */
+  int id(const QStringRef& name, int unknown = -1) const;
+
+private:
+  struct Entry
+  {
+    QString name;
+    int id = -1;
+  };
+
+  QVector<Entry> entries;
+  uint mask = 0;
+};
+
 /*
  * Provides a simple extension to XML stream reader. Methods do error checking and throw exception on error.
  * Initializes a QXmlStreamReader on construction and cannot be copied.
@@ -54,6 +84,13 @@ public:
 
   }
 
+  /* Read from memory and use filename for error messages */
+  XmlStream(const QByteArray& data, const QString& filenameParam)
+    : reader(data), filename(filenameParam)
+  {
+
+  }
+
   explicit XmlStream(const QString& data)
     : reader(data)
   {
@@ -78,6 +115,25 @@ public:
   /* Checks stream for error. Throws exception in case of error */
   void checkError(QXmlStreamReader& reader);
 
+  /* Id of the current element name in the table or unknown if not found */
+  int elementId(const XmlNameTable& names, int unknown = -1) const
+  {
+    return names.id(reader.name(), unknown);
+  }
+
+  /* Read text of the current element like QXmlStreamReader::readElementText() and convert it to a number.
+   * The number is parsed directly from the reader buffer and no QString is created for the usual single text node.
+   * Returns defaultValue and sets ok to false if the text is empty or not a valid number. */
+  float readElementTextFloat(float defaultValue = 0.f, bool *ok = nullptr);
+  double readElementTextDouble(double defaultValue = 0., bool *ok = nullptr);
+  int readElementTextInt(int defaultValue = 0, bool *ok = nullptr);
+
+  /* Attribute of the current element converted to a number without creating a QString.
+   * Returns defaultValue and sets ok to false if the attribute is missing or not a valid number. */
+  float readAttributeFloat(QLatin1String name, float defaultValue = 0.f, bool *ok = nullptr) const;
+  double readAttributeDouble(QLatin1String name, double defaultValue = 0., bool *ok = nullptr) const;
+  int readAttributeInt(QLatin1String name, int defaultValue = 0, bool *ok = nullptr) const;
+
   /* Get underlying constructed stream reader */
   QXmlStreamReader& getReader()
   {
@@ -85,7 +141,15 @@ public:
   }
 
 private:
+  /* Name of file device or filename given in constructor */
+  QString getFilename() const;
+
+  /* Read element text and pass it to func as string reference. Returns false if no text was found. */
+  template<typename FUNC>
+  bool readElementTextRef(FUNC func);
+
   QXmlStreamReader reader;
+  QString filename;
   QString errorMsg = tr("Cannot open file %1. Reason: %2");
 
 };
@@ -19,6 +19,7 @@
 #include "io/tempfile.h"
 #include "exception.h"
 #include "geo/pos.h"
+#include "util/parallel.h"
 
 extern "C" {
 #include <stdio.h>
@@ -40,15 +41,21 @@ extern "C" {
 #include <QFile>
 #include <QVector>
 
+#include <atomic>
 #include <cstring>
+#include <vector>
 
 namespace atools {
 namespace wmm {
 
-/* Copy of MAG_Grid function with simplifications also avoiding the need to write the output to a file */
-QVector<float> MAG_GridInternal(int year, int month,
-                                MAGtype_MagneticModel *magneticModel,
-                                MAGtype_Geoid *Geoid, MAGtype_Ellipsoid ellipsoid);
+/* Replacement for the MAG_Grid function which calculates the whole one degree grid.
+ * The model is modified to the date once and the Legendre functions and radius powers are calculated only once per
+ * latitude row. Sums over the degree n are collected per row for each order m which leaves only a sum over m
+ * with the sin/cos(m * lambda) tables of each longitude for each point.
+ * Points are on the ellipsoid, i.e. the geoid height is ignored. This changes declination values by less than
+ * 0.01 degree except for a few points close to the magnetic poles. */
+QVector<float> MAG_GridRows(int year, int month, MAGtype_MagneticModel *magneticModel,
+                            MAGtype_Ellipsoid ellipsoid, bool parallel);
 
 // ==============================================================================
 
@@ -62,12 +69,12 @@ MagDecTool::~MagDecTool()
   clear();
 }
 
-void MagDecTool::init(const QDate& dateTimeParam)
+void MagDecTool::init(const QDate& dateTimeParam, bool parallel)
 {
-  return init(dateTimeParam.year(), dateTimeParam.month());
+  return init(dateTimeParam.year(), dateTimeParam.month(), parallel);
 }
 
-void MagDecTool::init(int year, int month)
+void MagDecTool::init(int year, int month, bool parallel)
 {
   clear();
 
@@ -112,14 +119,10 @@ void MagDecTool::init(int year, int month)
   if(!MAG_SetDefaults(&ellipsoid, &geoid))
     throw atools::Exception(tr("Error in MAG_SetDefaults."));
 
-  QVector<float> geoidBuffer = readGeoidBuffer();
-  geoid.GeoidHeightBuffer = geoidBuffer.data();
-  geoid.Geoid_Initialized = 1;
-
   // Calculate declination grid
-  QVector<float> declinations = MAG_GridInternal(year, month, magneticModel, &geoid, ellipsoid);
+  QVector<float> declinations = MAG_GridRows(year, month, magneticModel, ellipsoid, parallel);
   if(declinations.isEmpty())
-    throw atools::Exception(tr("Error in MAG_GridInternal."));
+    throw atools::Exception(tr("Error in MAG_GridRows."));
 
   MAG_FreeMagneticModelMemory(magneticModel);
 
@@ -193,119 +196,154 @@ void MagDecTool::clear()
   magdecGrid = nullptr;
 }
 
-QVector<float> MagDecTool::readGeoidBuffer()
+QVector<float> MAG_GridRows(int year, int month, MAGtype_MagneticModel *magneticModel,
+                            MAGtype_Ellipsoid ellipsoid, bool parallel)
 {
-  QVector<float> retval;
-  QFile file(":/atools/resources/wmm/EGM9615.buf");
-  if(file.open(QIODevice::ReadOnly))
+  static const int NUM_COLUMNS = 360, NUM_ROWS = 181;
+
+  int nMax = magneticModel->nMax;
+  int numTerms = ((nMax + 1) * (nMax + 2) / 2);
+
+  // Only one date - modify coefficients once for all points
+  MAGtype_Date date;
+  date.DecimalYear = year + (month - 1) / 12.;
+  MAGtype_MagneticModel *timedMagneticModel = MAG_AllocateModelMemory(numTerms);
+  MAG_TimelyModifyMagneticModel(date, magneticModel, timedMagneticModel);
+  const double *coeffG = timedMagneticModel->Main_Field_Coeff_G, *coeffH = timedMagneticModel->Main_Field_Coeff_H;
+
+  // cos(m * lambda) and sin(m * lambda) for each longitude -180 to 179
+  QVector<double> cosTable(NUM_COLUMNS * (nMax + 1)), sinTable(NUM_COLUMNS * (nMax + 1));
+  MAGtype_SphericalHarmonicVariables *sphericalVariables = MAG_AllocateSphVarMemory(nMax);
+  for(int col = 0; col < NUM_COLUMNS; col++)
   {
-    QDataStream ds(&file);
-    ds.setFloatingPointPrecision(QDataStream::SinglePrecision);
-
-    while(!ds.atEnd())
+    MAGtype_CoordSpherical coordSpherical;
+    coordSpherical.lambda = col - 180.;
+    coordSpherical.phig = 0.;
+    coordSpherical.r = ellipsoid.re;
+    MAG_ComputeSphericalHarmonicVariables(ellipsoid, coordSpherical, nMax, sphericalVariables);
+    for(int m = 0; m <= nMax; m++)
     {
-      float value;
-      ds >> value;
-      retval.append(value);
+      cosTable[col * (nMax + 1) + m] = sphericalVariables->cos_mlambda[m];
+      sinTable[col * (nMax + 1) + m] = sphericalVariables->sin_mlambda[m];
     }
-    file.close();
   }
-  else
-    throw atools::Exception(tr("Cannot open geoid buffer \"%1\".").arg(file.fileName()));
-
-  return retval;
-}
+  MAG_FreeSphVarMemory(sphericalVariables);
 
-QVector<float> MAG_GridInternal(int year, int month, MAGtype_MagneticModel *magneticModel,
-                                MAGtype_Geoid *geoid, MAGtype_Ellipsoid ellipsoid)
-{
-  // Boundary always covers whole world
-  MAGtype_CoordGeodetic minimum;
-  minimum.phi = -90.;
-  minimum.lambda = -180.;
-  minimum.HeightAboveGeoid = minimum.HeightAboveEllipsoid = 0.;
-  minimum.UseGeoid = 1;
-
-  MAGtype_CoordGeodetic maximum;
-  maximum.phi = 90.;
-  maximum.lambda = 179.;
-  maximum.HeightAboveGeoid = maximum.HeightAboveEllipsoid = 0.;
-  maximum.UseGeoid = 1;
-
-  // Only one date - no range
-  MAGtype_Date startdate, enddate;
-  startdate.DecimalYear = enddate.DecimalYear = year + (month - 1) / 12.;
-
-  int numTerms;
-  double b, c;
-
-  MAGtype_MagneticModel *timedMagneticModel;
-  MAGtype_CoordSpherical coordSpherical;
-  MAGtype_MagneticResults magneticResultsSph, magneticResultsGeo, magneticResultsSphVar, magneticResultsGeoVar;
-  MAGtype_SphericalHarmonicVariables *sphericalVariables;
-  MAGtype_GeoMagneticElements geoMagneticElements, errors;
-  MAGtype_LegendreFunction *legendreFunction;
-
-  double cord_step_size = 1.;
-  if(fabs(cord_step_size) < 1.0e-10)
-    cord_step_size = 99999.0; // checks to make sure that the step_size is not too small
-
-  numTerms = ((magneticModel->nMax + 1) * (magneticModel->nMax + 2) / 2);
-  timedMagneticModel = MAG_AllocateModelMemory(numTerms);
-  legendreFunction = MAG_AllocateLegendreFunctionMemory(numTerms); // For storing the ALF functions
-  sphericalVariables = MAG_AllocateSphVarMemory(magneticModel->nMax);
-
-  QVector<float> retval;
-  retval.reserve(360 * 181);
-
-  b = minimum.phi;
-  c = minimum.lambda;
-  for(minimum.phi = b; minimum.phi <= maximum.phi; minimum.phi += cord_step_size) // Latitude Y loop
-  {
-    for(minimum.lambda = c; minimum.lambda <= maximum.lambda; minimum.lambda += cord_step_size) // Longitude X loop
+  QVector<float> retval(NUM_COLUMNS * NUM_ROWS);
+  float *retvalData = retval.data();
+  const double *cosData = cosTable.constData(), *sinData = sinTable.constData();
+  std::atomic<bool> error(false);
+
+  // Latitude Y loop - calculate one row from -90 to 90
+  auto rowFunc = [&](int row) -> void {
+    MAGtype_CoordGeodetic coordGeodetic;
+    coordGeodetic.phi = row - 90.;
+    coordGeodetic.lambda = 0.;
+    coordGeodetic.HeightAboveGeoid = coordGeodetic.HeightAboveEllipsoid = 0.;
+    coordGeodetic.UseGeoid = 0;
+
+    MAGtype_CoordSpherical coordSpherical;
+    MAG_GeodeticToSpherical(ellipsoid, coordGeodetic, &coordSpherical);
+
+    // Compute ALF  Equations 5-6, WMM Technical report
+    MAGtype_LegendreFunction *legendreFunction = MAG_AllocateLegendreFunctionMemory(numTerms);
+    if(!MAG_AssociatedLegendreFunction(coordSpherical, nMax, legendreFunction))
     {
-      if(geoid->UseGeoid == 1)
-        // This converts the height above mean sea level to height above the WGS-84 ellipsoid
-        MAG_ConvertGeoidToEllipsoidHeight(&minimum, geoid);
-      else
-        minimum.HeightAboveEllipsoid = minimum.HeightAboveGeoid;
-
-      MAG_GeodeticToSpherical(ellipsoid, minimum, &coordSpherical);
-
-      // Compute Spherical Harmonic variables
-      MAG_ComputeSphericalHarmonicVariables(ellipsoid, coordSpherical, magneticModel->nMax, sphericalVariables);
+      error = true;
+      MAG_FreeLegendreMemory(legendreFunction);
+      return;
+    }
 
-      // Compute ALF  Equations 5-6, WMM Technical report
-      MAG_AssociatedLegendreFunction(coordSpherical, magneticModel->nMax, legendreFunction);
+    // (a/r)^(n+2)
+    std::vector<double> radiusPower(static_cast<size_t>(nMax + 1));
+    radiusPower[0] = (ellipsoid.re / coordSpherical.r) * (ellipsoid.re / coordSpherical.r);
+    for(int n = 1; n <= nMax; n++)
+      radiusPower[static_cast<size_t>(n)] = radiusPower[static_cast<size_t>(n - 1)] * (ellipsoid.re / coordSpherical.r);
 
-      // This modifies the Magnetic coefficients to the correct date.
-      MAG_TimelyModifyMagneticModel(startdate, magneticModel, timedMagneticModel);
+    // Sums over n for each m for the terms of g and h in Equations 10-12, WMM Technical report
+    std::vector<double> gx(static_cast<size_t>(nMax + 1), 0.), hx(gx), gy(gx), hy(gx), gz(gx), hz(gx);
+    for(int n = 1; n <= nMax; n++)
+    {
+      for(int m = 0; m <= n; m++)
+      {
+        int index = (n * (n + 1) / 2 + m);
+        size_t mi = static_cast<size_t>(m);
+        double rp = radiusPower[static_cast<size_t>(n)];
+        double pcup = legendreFunction->Pcup[index], dPcup = legendreFunction->dPcup[index];
+        gx[mi] += rp * coeffG[index] * dPcup;
+        hx[mi] += rp * coeffH[index] * dPcup;
+        gy[mi] += rp * coeffG[index] * m * pcup;
+        hy[mi] += rp * coeffH[index] * m * pcup;
+        gz[mi] += rp * coeffG[index] * (n + 1) * pcup;
+        hz[mi] += rp * coeffH[index] * (n + 1) * pcup;
+      }
+    }
+    MAG_FreeLegendreMemory(legendreFunction);
 
-      // Accumulate the spherical harmonic coefficients Equations 10:12 , WMM Technical report
-      MAG_Summation(legendreFunction, timedMagneticModel, *sphericalVariables, coordSpherical, &magneticResultsSph);
+    double cosPhi = cos(DEG2RAD(coordSpherical.phig));
+    bool pole = fabs(cosPhi) <= 1.0e-10;
+    MAGtype_SphericalHarmonicVariables *poleVariables = nullptr;
+    if(pole)
+    {
+      poleVariables = MAG_AllocateSphVarMemory(nMax);
+      for(int n = 0; n <= nMax; n++)
+        poleVariables->RelativeRadiusPower[n] = radiusPower[static_cast<size_t>(n)];
+    }
 
-      // Sum the Secular Variation Coefficients, Equations 13:15 , WMM Technical report
-      MAG_SecVarSummation(legendreFunction, timedMagneticModel, *sphericalVariables, coordSpherical,
-                          &magneticResultsSphVar);
+    // Longitude X loop
+    for(int col = 0; col < NUM_COLUMNS; col++)
+    {
+      const double *cosM = cosData + col * (nMax + 1), *sinM = sinData + col * (nMax + 1);
+
+      MAGtype_MagneticResults magneticResultsSph, magneticResultsGeo;
+      magneticResultsSph.Bx = magneticResultsSph.By = magneticResultsSph.Bz = 0.;
+      for(int m = 0; m <= nMax; m++)
+      {
+        size_t mi = static_cast<size_t>(m);
+        magneticResultsSph.Bx -= gx[mi] * cosM[m] + hx[mi] * sinM[m];
+        magneticResultsSph.By += gy[mi] * sinM[m] - hy[mi] * cosM[m];
+        magneticResultsSph.Bz -= gz[mi] * cosM[m] + hz[mi] * sinM[m];
+      }
+
+      if(!pole)
+        magneticResultsSph.By /= cosPhi;
+      else
+      {
+        // Special calculation for component By at geographic poles
+        for(int m = 0; m <= nMax; m++)
+        {
+          poleVariables->cos_mlambda[m] = cosM[m];
+          poleVariables->sin_mlambda[m] = sinM[m];
+        }
+        coordSpherical.lambda = col - 180.;
+        MAG_SummationSpecial(timedMagneticModel, *poleVariables, coordSpherical, &magneticResultsSph);
+      }
 
       // Map the computed Magnetic fields to Geodetic coordinates Equation 16 , WMM Technical report
-      MAG_RotateMagneticVector(coordSpherical, minimum, magneticResultsSph, &magneticResultsGeo);
+      coordGeodetic.lambda = col - 180.;
+      MAG_RotateMagneticVector(coordSpherical, coordGeodetic, magneticResultsSph, &magneticResultsGeo);
 
-      // Map the secular variation field components to Geodetic coordinates, Equation 17 , WMM Technical report
-      MAG_RotateMagneticVector(coordSpherical, minimum, magneticResultsSphVar, &magneticResultsGeoVar);
+      // Declination as in MAG_CalculateGeoMagneticElements, Equation 18 , WMM Technical report
+      retvalData[row * NUM_COLUMNS + col] =
+        static_cast<float>(RAD2DEG(atan2(magneticResultsGeo.By, magneticResultsGeo.Bx)));
+    } // Longitude Loop
 
-      // Calculate the Geomagnetic elements, Equation 18 , WMM Technical report
-      MAG_CalculateGeoMagneticElements(&magneticResultsGeo, &geoMagneticElements);
-      MAG_WMMErrorCalc(geoMagneticElements.H, &errors);
+    if(poleVariables != nullptr)
+      MAG_FreeSphVarMemory(poleVariables);
+  };
 
-      retval.append(static_cast<float>(geoMagneticElements.Decl));
-    } // Longitude Loop
-  } // Latitude Loop
+  if(parallel)
+    atools::util::parallelFor(NUM_ROWS, rowFunc);
+  else
+  {
+    for(int row = 0; row < NUM_ROWS; row++)
+      rowFunc(row);
+  }
 
   MAG_FreeMagneticModelMemory(timedMagneticModel);
-  MAG_FreeLegendreMemory(legendreFunction);
-  MAG_FreeSphVarMemory(sphericalVariables);
 
+  if(error)
+    retval.clear();
   return retval;
 }
 
@@ -32,6 +32,8 @@ namespace wmm {
 /*
  * Interface to GeomagnetismLibrary. Calculates an array for 360 x 181 values and provides accessors and
  * interpolation methods to this array (i.e. one degree grid).
+ * The grid is calculated row by row sharing the Legendre functions of each latitude and the sin/cos tables
+ * of each longitude.
  *
  * Declination values are not calculated on the fly.
  */
@@ -43,9 +45,10 @@ public:
   MagDecTool();
   ~MagDecTool();
 
-  /* Build the declination array for current year/month or given values. January = 1 */
-  void init(int year = 0, int month = 1);
-  void init(const QDate& dateTime);
+  /* Build the declination array for current year/month or given values. January = 1
+   * Latitude rows are calculated in parallel if parallel is true. */
+  void init(int year = 0, int month = 1, bool parallel = false);
+  void init(const QDate& dateTime, bool parallel = false);
 
   /* Get version information for the GeomagnetismLibrary */
   QString getVersion() const;
@@ -84,9 +87,6 @@ private:
     return magdecGrid[atools::roundToInt(col) + 180 + (atools::roundToInt(row) + 90) * 360];
   }
 
-  // Read EGM9615.buf - only needed for grid creating
-  QVector<float> readGeoidBuffer();
-
   // latY (-90 to 90), lonX (-180 to 179)
   // -90.00 -180.00, -90.00 -179.00 ... 90.00 178.00, 90.00 179.00
   float *magdecGrid = nullptr;
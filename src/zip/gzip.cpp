@@ -20,7 +20,12 @@
 #include "zip/gzip.h"
 
 #include <QByteArray>
+#include <QDebug>
 #include <QFile>
+#include <QIODevice>
+
+#include <algorithm>
+#include <climits>
 
 #define GZIP_WINDOWS_BIT 15 + 16
 #define GZIP_CHUNK_SIZE 32 * 1024
@@ -250,5 +255,339 @@ QByteArray gzipDecompress(const QByteArray& input)
     return QByteArray();
 }
 
+GzipWriter::GzipWriter(QIODevice *outputDevice, int level)
+  : device(outputDevice)
+{
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  strm.avail_in = 0;
+  strm.next_in = Z_NULL;
+  initialized = deflateInit2(&strm, qMax(-1, qMin(9, level)), Z_DEFLATED, GZIP_WINDOWS_BIT, 8,
+                             Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+GzipWriter::~GzipWriter()
+{
+  close();
+}
+
+bool GzipWriter::write(const char *data, int size)
+{
+  if(!initialized || closed)
+    return false;
+
+  return size > 0 ? deflateInternal(data, size, Z_NO_FLUSH) : true;
+}
+
+bool GzipWriter::write(const QByteArray& data)
+{
+  return write(data.constData(), data.size());
+}
+
+bool GzipWriter::close()
+{
+  if(!initialized || closed)
+    return false;
+
+  closed = true;
+  bool retval = deflateInternal(nullptr, 0, Z_FINISH);
+  deflateEnd(&strm);
+  return retval;
+}
+
+bool GzipWriter::deflateInternal(const char *data, int size, int flush)
+{
+  strm.next_in = reinterpret_cast<unsigned char *>(const_cast<char *>(data));
+  strm.avail_in = static_cast<uInt>(size);
+
+  char out[GZIP_CHUNK_SIZE];
+  do
+  {
+    strm.next_out = reinterpret_cast<unsigned char *>(out);
+    strm.avail_out = GZIP_CHUNK_SIZE;
+
+    if(deflate(&strm, flush) == Z_STREAM_ERROR)
+      return false;
+
+    int have = GZIP_CHUNK_SIZE - static_cast<int>(strm.avail_out);
+    if(have > 0 && device->write(out, have) != have)
+      return false;
+  } while(strm.avail_out == 0);
+
+  return true;
+}
+
+GzipReader::GzipReader()
+{
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  strm.avail_in = 0;
+  strm.next_in = Z_NULL;
+  initialized = inflateInit2(&strm, GZIP_WINDOWS_BIT) == Z_OK;
+}
+
+GzipReader::~GzipReader()
+{
+  if(initialized)
+    inflateEnd(&strm);
+}
+
+bool GzipReader::decompress(const char *data, int size, QByteArray& output)
+{
+  if(!initialized || failed)
+    return false;
+
+  if(finished || size <= 0)
+    return true;
+
+  strm.next_in = reinterpret_cast<unsigned char *>(const_cast<char *>(data));
+  strm.avail_in = static_cast<uInt>(size);
+
+  char out[GZIP_CHUNK_SIZE];
+  do
+  {
+    strm.next_out = reinterpret_cast<unsigned char *>(out);
+    strm.avail_out = GZIP_CHUNK_SIZE;
+
+    int ret = inflate(&strm, Z_NO_FLUSH);
+    if(ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR)
+    {
+      failed = true;
+      return false;
+    }
+
+    int have = GZIP_CHUNK_SIZE - static_cast<int>(strm.avail_out);
+    if(have > 0)
+      output.append(out, have);
+
+    if(ret == Z_STREAM_END)
+    {
+      finished = true;
+      break;
+    }
+    else if(ret == Z_BUF_ERROR)
+      // No progress possible - wait for more input
+      break;
+  } while(strm.avail_out == 0 || strm.avail_in > 0);
+
+  return true;
+}
+
+bool GzipReader::decompress(const QByteArray& data, QByteArray& output)
+{
+  return decompress(data.constData(), data.size(), output);
+}
+
+GzipDevice::GzipDevice(QIODevice *compressedDevice, int compressionLevel, int windowSize)
+  : device(compressedDevice), window(std::max(windowSize, 1024), '\0'), level(qMax(-1, qMin(9, compressionLevel)))
+{
+  for(z_stream *strm : {&inflateStrm, &deflateStrm})
+  {
+    strm->zalloc = Z_NULL;
+    strm->zfree = Z_NULL;
+    strm->opaque = Z_NULL;
+    strm->avail_in = 0;
+    strm->next_in = Z_NULL;
+  }
+}
+
+GzipDevice::~GzipDevice()
+{
+  close();
+
+  if(inflateInitialized)
+    inflateEnd(&inflateStrm);
+  if(deflateInitialized)
+    deflateEnd(&deflateStrm);
+}
+
+void GzipDevice::setDevice(QIODevice *value)
+{
+  if(isOpen())
+    qWarning() << Q_FUNC_INFO << "Cannot change device while open";
+  else
+    device = value;
+}
+
+void GzipDevice::setCompressionLevel(int value)
+{
+  level = qMax(-1, qMin(9, value));
+}
+
+bool GzipDevice::open(QIODevice::OpenMode mode)
+{
+  finished = failed = false;
+
+  QIODevice::OpenMode direction = mode & QIODevice::ReadWrite;
+  if(device == nullptr || (direction != QIODevice::ReadOnly && direction != QIODevice::WriteOnly) ||
+     mode & (QIODevice::Append | QIODevice::Truncate))
+  {
+    setErrorString(tr("Unsupported open mode for GZIP device"));
+    return false;
+  }
+
+  if(!(device->openMode() & direction))
+  {
+    setErrorString(tr("Device is not open"));
+    return false;
+  }
+
+  if(direction == QIODevice::ReadOnly)
+  {
+    // Reuse state if already initialized
+    int ret = inflateInitialized ? inflateReset(&inflateStrm) : inflateInit2(&inflateStrm, GZIP_WINDOWS_BIT);
+    inflateInitialized = ret == Z_OK;
+    inflateStrm.avail_in = 0;
+    inflateStrm.next_in = Z_NULL;
+  }
+  else
+  {
+    int ret;
+    if(deflateInitialized)
+    {
+      ret = deflateReset(&deflateStrm);
+      if(ret == Z_OK && deflateLevel != level)
+        ret = deflateParams(&deflateStrm, level, Z_DEFAULT_STRATEGY);
+    }
+    else
+      ret = deflateInit2(&deflateStrm, level, Z_DEFLATED, GZIP_WINDOWS_BIT, 8, Z_DEFAULT_STRATEGY);
+
+    deflateInitialized = ret == Z_OK;
+    deflateLevel = level;
+  }
+
+  if(direction == QIODevice::ReadOnly ? !inflateInitialized : !deflateInitialized)
+  {
+    setErrorString(tr("Cannot initialize zlib"));
+    return false;
+  }
+
+  return QIODevice::open(mode);
+}
+
+void GzipDevice::close()
+{
+  if(!isOpen())
+    return;
+
+  if(openMode() & QIODevice::WriteOnly && !failed)
+    deflateInternal(Z_FINISH);
+
+  QIODevice::close();
+}
+
+bool GzipDevice::atEnd() const
+{
+  return (finished || failed) && QIODevice::atEnd();
+}
+
+qint64 GzipDevice::readData(char *data, qint64 maxSize)
+{
+  if(failed)
+    return -1;
+
+  qint64 total = 0;
+  while(total < maxSize && !finished)
+  {
+    if(inflateStrm.avail_in == 0)
+    {
+      // Fill input window
+      qint64 num = device->read(window.data(), window.size());
+      if(num < 0)
+      {
+        setFailed(tr("Error reading compressed data: %1").arg(device->errorString()));
+        break;
+      }
+      else if(num == 0)
+      {
+        if(device->atEnd())
+        {
+          if(inflateStrm.total_in == 0)
+            // Empty input
+            finished = true;
+          else
+            setFailed(tr("Compressed data is truncated"));
+        }
+        // else wait for more data on sequential devices
+        break;
+      }
+
+      inflateStrm.next_in = reinterpret_cast<unsigned char *>(window.data());
+      inflateStrm.avail_in = static_cast<uInt>(num);
+    }
+
+    // Decompress directly into the buffer of the caller
+    inflateStrm.next_out = reinterpret_cast<unsigned char *>(data + total);
+    inflateStrm.avail_out = static_cast<uInt>(std::min(maxSize - total, static_cast<qint64>(UINT_MAX)));
+    uInt availOut = inflateStrm.avail_out;
+
+    int ret = inflate(&inflateStrm, Z_NO_FLUSH);
+    if(ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR)
+    {
+      setFailed(tr("Error decompressing data: %1").arg(inflateStrm.msg != nullptr ? inflateStrm.msg : "-"));
+      break;
+    }
+
+    total += availOut - inflateStrm.avail_out;
+
+    if(ret == Z_STREAM_END)
+      finished = true;
+  }
+
+  return total == 0 && failed ? -1 : total;
+}
+
+qint64 GzipDevice::writeData(const char *data, qint64 maxSize)
+{
+  if(failed)
+    return -1;
+
+  qint64 written = 0;
+  while(written < maxSize)
+  {
+    uInt size = static_cast<uInt>(std::min(maxSize - written, static_cast<qint64>(UINT_MAX)));
+    deflateStrm.next_in = reinterpret_cast<unsigned char *>(const_cast<char *>(data + written));
+    deflateStrm.avail_in = size;
+
+    if(!deflateInternal(Z_NO_FLUSH))
+      return -1;
+    written += size;
+  }
+  return written;
+}
+
+bool GzipDevice::deflateInternal(int flush)
+{
+  do
+  {
+    deflateStrm.next_out = reinterpret_cast<unsigned char *>(window.data());
+    deflateStrm.avail_out = static_cast<uInt>(window.size());
+
+    if(deflate(&deflateStrm, flush) == Z_STREAM_ERROR)
+    {
+      setFailed(tr("Error compressing data"));
+      return false;
+    }
+
+    qint64 have = window.size() - static_cast<qint64>(deflateStrm.avail_out);
+    if(have > 0 && device->write(window.constData(), have) != have)
+    {
+      setFailed(tr("Error writing compressed data: %1").arg(device->errorString()));
+      return false;
+    }
+  } while(deflateStrm.avail_out == 0);
+
+  return true;
+}
+
+void GzipDevice::setFailed(const QString& message)
+{
+  qWarning() << Q_FUNC_INFO << message;
+  failed = true;
+  setErrorString(message);
+}
+
 } // namespace zip
 } // namespace atools
@@ -20,9 +20,11 @@
 #ifndef ATOOLS_ZIP_GZIP_H
 #define ATOOLS_ZIP_GZIP_H
 
+#include <QByteArray>
+#include <QIODevice>
+
 #include <zlib.h>
 
-class QByteArray;
 class QString;
 
 /* Gzip compression support functions
@@ -54,6 +56,150 @@ QByteArray gzipCompress(const QByteArray& input, int level = -1);
 bool gzipDecompress(const QByteArray& input, QByteArray& output);
 QByteArray gzipDecompress(const QByteArray& input);
 
+/*
+ * Compresses data in chunks and writes the GZIP stream to an open device.
+ * Only one chunk of compressed data is kept in memory.
+ */
+class GzipWriter
+{
+public:
+  /* Device has to be open for writing. Ownership is not transferred. */
+  explicit GzipWriter(QIODevice *outputDevice, int level = -1);
+  ~GzipWriter();
+
+  GzipWriter(const GzipWriter& other) = delete;
+  GzipWriter& operator=(const GzipWriter& other) = delete;
+
+  /* Compress and write data. Returns false on error. */
+  bool write(const char *data, int size);
+  bool write(const QByteArray& data);
+
+  /* Write remaining data and the GZIP trailer. Called by destructor if not done before. Returns false on error. */
+  bool close();
+
+private:
+  bool deflateInternal(const char *data, int size, int flush);
+
+  QIODevice *device;
+  z_stream strm;
+  bool initialized = false, closed = false;
+};
+
+/*
+ * Decompresses a GZIP stream which is given in chunks, e.g. while downloading.
+ * Only the decompressed data of the current chunk is kept in memory.
+ */
+class GzipReader
+{
+public:
+  GzipReader();
+  ~GzipReader();
+
+  GzipReader(const GzipReader& other) = delete;
+  GzipReader& operator=(const GzipReader& other) = delete;
+
+  /* Decompress data and append the result to output. Data after the end of the GZIP stream is ignored.
+   * Returns false on error. */
+  bool decompress(const char *data, int size, QByteArray& output);
+  bool decompress(const QByteArray& data, QByteArray& output);
+
+  /* true if the end of the GZIP stream was reached */
+  bool isFinished() const
+  {
+    return finished;
+  }
+
+private:
+  z_stream strm;
+  bool initialized = false, finished = false, failed = false;
+};
+
+/*
+ * Sequential device which decompresses a GZIP stream while reading or compresses while writing.
+ * Wraps another device like a QFile, QBuffer or a finished QNetworkReply which is not owned.
+ * Allows QTextStream, XmlStream or other parsers to work on compressed data without
+ * decompressing all into memory first.
+ *
+ * Only ReadOnly or WriteOnly mode is supported. The wrapped device has to be opened in the same mode
+ * before calling open(). Input and output are passed through windows of fixed size.
+ *
+ * The zlib state is kept after close() and reset for the next open() which allows to reuse one
+ * instance for several files by calling setDevice() in between.
+ *
+ * Data after the end of the first GZIP member is ignored like in gzipDecompress().
+ */
+class GzipDevice :
+  public QIODevice
+{
+  Q_OBJECT
+
+public:
+  /*
+   * @param compressedDevice Source for reading or target for writing. Can be set later.
+   * @param compressionLevel Level for writing (0 = no compression, 9 = max, -1 = default)
+   * @param windowSize Size of the buffer for compressed data
+   */
+  explicit GzipDevice(QIODevice *compressedDevice = nullptr, int compressionLevel = -1, int windowSize = 32 * 1024);
+  virtual ~GzipDevice() override;
+
+  GzipDevice(const GzipDevice& other) = delete;
+  GzipDevice& operator=(const GzipDevice& other) = delete;
+
+  /* Change wrapped device. Only allowed if closed. */
+  void setDevice(QIODevice *value);
+
+  QIODevice *getDevice() const
+  {
+    return device;
+  }
+
+  /* Compression level for writing. Used with the next call of open(). */
+  void setCompressionLevel(int value);
+
+  int getCompressionLevel() const
+  {
+    return level;
+  }
+
+  /* Open in ReadOnly or WriteOnly mode. Text mode is allowed. Returns false if the mode is not supported,
+   * the wrapped device is not open or zlib cannot be initialized. */
+  virtual bool open(QIODevice::OpenMode mode) override;
+
+  /* Writes the remaining compressed data and the GZIP trailer in write mode. The wrapped device is not closed. */
+  virtual void close() override;
+
+  virtual bool isSequential() const override
+  {
+    return true;
+  }
+
+  /* true if the end of the GZIP stream was reached or an error occured and all data was read */
+  virtual bool atEnd() const override;
+
+  /* true if the stream was corrupt, truncated or writing failed. See errorString(). */
+  bool hasError() const
+  {
+    return failed;
+  }
+
+protected:
+  virtual qint64 readData(char *data, qint64 maxSize) override;
+  virtual qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+  /* Compress available input and write output to the device */
+  bool deflateInternal(int flush);
+  void setFailed(const QString& message);
+
+  QIODevice *device;
+  QByteArray window;
+  z_stream inflateStrm, deflateStrm;
+  int level, deflateLevel = -1; /* Requested level and level of the deflate state */
+
+  /* zlib state is created on first use for each direction and kept until destruction */
+  bool inflateInitialized = false, deflateInitialized = false, finished = false, failed = false;
+};
+
 } // namespace zip
 } // namespace atools
 
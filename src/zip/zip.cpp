@@ -35,11 +35,19 @@
 
 #include "zip/zipreader.h"
 #include "zip/zipwriter.h"
+#include "util/parallel.h"
 
 #include <QDebug>
 #include <QDateTime>
 #include <QtEndian>
 #include <QDir>
+#include <QBuffer>
+#include <QAtomicInt>
+#include <QFileInfo>
+#include <QHash>
+#include <QVector>
+
+#include <limits>
 
 #if defined(Q_CC_MSVC)
 #include <QtZlib/zlib.h>
@@ -51,6 +59,9 @@
 // (actually, the only basic support of this version is implemented but it is enough for now)
 #define ZIP_VERSION 20
 
+// Size of the chunks used when streaming entries to a device
+#define ZIP_CHUNK_SIZE (64 * 1024)
+
 #if 0
 #define ZDEBUG qDebug
 #else
@@ -127,43 +138,6 @@ static void writeMSDosDate(uchar *dest, const QDateTime& dt)
   }
 }
 
-static int inflate(Bytef *dest, ulong *destLen, const Bytef *source, ulong sourceLen)
-{
-  z_stream stream;
-  int err;
-
-  stream.next_in = const_cast<Bytef *>(source);
-  stream.avail_in = (uInt)sourceLen;
-  if((uLong)stream.avail_in != sourceLen)
-    return Z_BUF_ERROR;
-
-  stream.next_out = dest;
-  stream.avail_out = (uInt) * destLen;
-  if((uLong)stream.avail_out != *destLen)
-    return Z_BUF_ERROR;
-
-  stream.zalloc = (alloc_func)0;
-  stream.zfree = (free_func)0;
-
-  err = inflateInit2(&stream, -MAX_WBITS);
-  if(err != Z_OK)
-    return err;
-
-  err = inflate(&stream, Z_FINISH);
-  if(err != Z_STREAM_END)
-  {
-    inflateEnd(&stream);
-    if(err == Z_NEED_DICT || (err == Z_BUF_ERROR && stream.avail_in == 0))
-      return Z_DATA_ERROR;
-
-    return err;
-  }
-  *destLen = stream.total_out;
-
-  err = inflateEnd(&stream);
-  return err;
-}
-
 static int deflate(Bytef *dest, ulong *destLen, const Bytef *source, ulong sourceLen)
 {
   z_stream stream;
@@ -458,7 +432,7 @@ class ZipPrivate
 {
 public:
   ZipPrivate(QIODevice *device, bool ownDev)
-    : device(device), ownDevice(ownDev), dirtyFileTree(true), start_of_directory(0)
+    : device(device), ownDevice(ownDev), dirtyFileTree(true), start_of_directory(0), mapped(nullptr), mappedSize(0)
   {
   }
 
@@ -476,6 +450,10 @@ public:
   QList<FileHeader> fileHeaders;
   QByteArray comment;
   uint start_of_directory;
+
+  // Archive file mapped into memory or null if the device is not a file or mapping failed
+  uchar *mapped;
+  qint64 mappedSize;
 };
 
 void ZipPrivate::fillFileInfo(int index, ZipReader::FileInfo& fileInfo) const
@@ -556,7 +534,24 @@ public:
 
   void scanFiles();
 
+  // Map the device into memory if it is a file
+  void mapFile();
+  void unmapFile();
+
+  // Offset of the entry data behind the local file header or -1 on error
+  qint64 entryDataOffset(const FileHeader& header) const;
+
+  // Inflate or copy the entry at index in chunks into out. Does not change the state of this object and
+  // can be called from several threads at once if the archive is mapped.
+  ZipReader::Status extractEntry(int index, QIODevice *out) const;
+
+  // Extract the regular file entries at indexes below destinationDir. Runs in parallel if the archive is mapped.
+  bool extractFiles(const QVector<int>& indexes, const QString& destinationDir);
+
   ZipReader::Status status;
+
+  // Maps file names as stored in the archive to the index in fileHeaders
+  QHash<QString, int> fileIndex;
 };
 
 class ZipWriterPrivate :
@@ -617,6 +612,8 @@ void ZipReaderPrivate::scanFiles()
   }
 
   dirtyFileTree = false;
+  mapFile();
+
   uchar tmp[4];
   device->read((char *)tmp, 4);
   if(readUInt(tmp) != 0x04034b50)
@@ -705,7 +702,225 @@ void ZipReaderPrivate::scanFiles()
 
     ZDEBUG("found file '%s'", header.file_name.data());
     fileHeaders.append(header);
+
+    // Keep the first entry for duplicate names
+    const QString name = QString::fromLocal8Bit(header.file_name);
+    if(!fileIndex.contains(name))
+      fileIndex.insert(name, fileHeaders.size() - 1);
+  }
+}
+
+void ZipReaderPrivate::mapFile()
+{
+  QFile *file = qobject_cast<QFile *>(device);
+  if(file != nullptr && mapped == nullptr && file->size() > 0)
+  {
+    mapped = file->map(0, file->size());
+    if(mapped != nullptr)
+      mappedSize = file->size();
+    else
+      ZDEBUG() << "Zip: cannot map" << file->fileName() << file->errorString();
+  }
+}
+
+void ZipReaderPrivate::unmapFile()
+{
+  QFile *file = qobject_cast<QFile *>(device);
+  if(file != nullptr && mapped != nullptr)
+    file->unmap(mapped);
+  mapped = nullptr;
+  mappedSize = 0;
+}
+
+qint64 ZipReaderPrivate::entryDataOffset(const FileHeader& header) const
+{
+  qint64 start = readUInt(header.h.offset_local_header);
+  LocalFileHeader lh;
+  if(mapped != nullptr)
+  {
+    if(start + qint64(sizeof(LocalFileHeader)) > mappedSize)
+      return -1;
+    memcpy(&lh, mapped + start, sizeof(LocalFileHeader));
+  }
+  else
+  {
+    if(!device->seek(start) || device->read((char *)&lh, sizeof(LocalFileHeader)) != sizeof(LocalFileHeader))
+      return -1;
+  }
+
+  if(readUInt(lh.signature) != 0x04034b50)
+    return -1;
+
+  return start + qint64(sizeof(LocalFileHeader)) + readUShort(lh.file_name_length) +
+         readUShort(lh.extra_field_length);
+}
+
+ZipReader::Status ZipReaderPrivate::extractEntry(int index, QIODevice *out) const
+{
+  const FileHeader& header = fileHeaders.at(index);
+
+  ushort version_needed = readUShort(header.h.version_needed);
+  if(version_needed > ZIP_VERSION)
+  {
+    qWarning("Zip: .ZIP specification version %d implementationis needed to extract the data.",
+             version_needed);
+    return ZipReader::FileNotSupported;
+  }
+
+  if((readUShort(header.h.general_purpose_bits) & Encrypted) != 0)
+  {
+    qWarning("Zip: Unsupported encryption method is needed to extract the data.");
+    return ZipReader::FileEncryptionMethodNotSupported;
+  }
+
+  int compression_method = readUShort(header.h.compression_method);
+  if(compression_method != CompressionMethodStored && compression_method != CompressionMethodDeflated)
+  {
+    qWarning("Zip: Unsupported compression method %d is needed to extract the data.", compression_method);
+    return ZipReader::FileEncryptionMethodNotSupported;
+  }
+
+  const qint64 compressed_size = readUInt(header.h.compressed_size);
+  qint64 offset = entryDataOffset(header);
+  if(offset < 0 || (mapped != nullptr && offset + compressed_size > mappedSize))
+  {
+    qWarning("Zip: Entry %d is outside of the archive.", index);
+    return ZipReader::FileCorrupted;
+  }
+
+  if(mapped == nullptr && !device->seek(offset))
+    return ZipReader::FileReadError;
+
+  z_stream stream;
+  if(compression_method == CompressionMethodDeflated)
+  {
+    memset(&stream, 0, sizeof(stream));
+    if(inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+      return ZipReader::MemoryError;
+  }
+
+  ZipReader::Status result = ZipReader::NoError;
+  QByteArray input, output;
+  qint64 remaining = compressed_size;
+  int err = Z_OK;
+  while(remaining > 0 && result == ZipReader::NoError && err != Z_STREAM_END)
+  {
+    // Use the mapped data in place or read the next chunk from the device
+    const char *in;
+    qint64 inSize;
+    if(mapped != nullptr)
+    {
+      in = reinterpret_cast<const char *>(mapped + offset);
+      inSize = qMin(remaining, qint64(std::numeric_limits<int>::max()));
+      offset += inSize;
+    }
+    else
+    {
+      input = device->read(qMin(remaining, qint64(ZIP_CHUNK_SIZE)));
+      if(input.isEmpty())
+      {
+        result = ZipReader::FileReadError;
+        break;
+      }
+      in = input.constData();
+      inSize = input.size();
+    }
+    remaining -= inSize;
+
+    if(compression_method == CompressionMethodStored)
+    {
+      if(out->write(in, inSize) != inSize)
+        result = ZipReader::FileError;
+      continue;
+    }
+
+    // Deflate - inflate into a fixed buffer until all input is consumed
+    output.resize(ZIP_CHUNK_SIZE);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+    stream.avail_in = uInt(inSize);
+    do
+    {
+      stream.next_out = reinterpret_cast<Bytef *>(output.data());
+      stream.avail_out = ZIP_CHUNK_SIZE;
+      err = inflate(&stream, Z_NO_FLUSH);
+      if(err == Z_NEED_DICT || err == Z_DATA_ERROR)
+      {
+        qWarning("Zip: Z_DATA_ERROR: Input data is corrupted");
+        result = ZipReader::FileCorrupted;
+      }
+      else if(err == Z_MEM_ERROR)
+      {
+        qWarning("Zip: Z_MEM_ERROR: Not enough memory");
+        result = ZipReader::MemoryError;
+      }
+      else
+      {
+        qint64 have = ZIP_CHUNK_SIZE - stream.avail_out;
+        if(have > 0 && out->write(output.constData(), have) != have)
+          result = ZipReader::FileError;
+      }
+    } while(result == ZipReader::NoError && err != Z_STREAM_END && stream.avail_out == 0);
+  }
+
+  if(compression_method == CompressionMethodDeflated)
+  {
+    if(result == ZipReader::NoError && err != Z_STREAM_END && compressed_size > 0)
+    {
+      qWarning("Zip: Z_DATA_ERROR: Input data is truncated");
+      result = ZipReader::FileCorrupted;
+    }
+    inflateEnd(&stream);
+  }
+  return result;
+}
+
+bool ZipReaderPrivate::extractFiles(const QVector<int>& indexes, const QString& destinationDir)
+{
+  // Create all parent directories before extracting in parallel
+  QDir baseDir(destinationDir);
+  QVector<ZipReader::FileInfo> infos(indexes.size());
+  for(int i = 0; i < indexes.size(); i++)
+  {
+    fillFileInfo(indexes.at(i), infos[i]);
+    const QString path = QFileInfo(infos.at(i).filePath).path();
+    if(!path.isEmpty() && path != QLatin1String(".") && !baseDir.mkpath(path))
+      return false;
+  }
+
+  // Remember the first error and skip all remaining entries
+  QAtomicInt error(ZipReader::NoError);
+  auto extract = [&](int i) -> void {
+                   if(error.load() != ZipReader::NoError)
+                     return;
+
+                   ZipReader::Status result = ZipReader::FileOpenError;
+                   QFile f(destinationDir + QDir::separator() + infos.at(i).filePath);
+                   if(f.open(QIODevice::WriteOnly))
+                   {
+                     result = extractEntry(indexes.at(i), &f);
+                     f.setPermissions(infos.at(i).permissions);
+                     f.close();
+                   }
+
+                   if(result != ZipReader::NoError)
+                     error.testAndSetOrdered(ZipReader::NoError, result);
+                 };
+
+  if(mapped != nullptr)
+    // Mapped memory can be read from all threads without locking
+    atools::util::parallelFor(indexes.size(), extract);
+  else
+  {
+    for(int i = 0; i < indexes.size(); i++)
+      extract(i);
+  }
+
+  if(error.load() != ZipReader::NoError)
+  {
+    status = ZipReader::Status(error.load());
+    return false;
   }
+  return true;
 }
 
 void ZipWriterPrivate::addEntry(EntryType type, const QString& fileName, const QByteArray& contents /*, QFile::Permissions permissions, QZip::Method m*/)
@@ -1014,101 +1229,112 @@ ZipReader::FileInfo ZipReader::entryInfoAt(int index) const
   return fi;
 }
 
+/*!
+ *   Returns the index of the entry \a fileName as stored in the archive or -1 if
+ *   the archive does not contain it. The lookup uses a hash built when reading the
+ *   central directory.
+ */
+int ZipReader::indexOf(const QString& fileName) const
+{
+  d->scanFiles();
+  return d->fileIndex.value(fileName, -1);
+}
+
+/*!
+ *   Returns \c true if the archive contains the entry \a fileName.
+ */
+bool ZipReader::contains(const QString& fileName) const
+{
+  return indexOf(fileName) != -1;
+}
+
+/*!
+ *   Returns \c true if the archive is a file which could be mapped into memory.
+ *   Entries are extracted without copying the compressed data and extractFiles()
+ *   runs in parallel in this case.
+ */
+bool ZipReader::isMapped() const
+{
+  d->scanFiles();
+  return d->mapped != nullptr;
+}
+
 /*!
  *   Fetch the file contents from the zip archive and return the uncompressed bytes.
  */
 QByteArray ZipReader::fileData(const QString& fileName) const
 {
-  d->scanFiles();
-  int i;
-  for(i = 0; i < d->fileHeaders.size(); i++)
-  {
-    if(QString::fromLocal8Bit(d->fileHeaders.at(i).file_name) == fileName)
-      break;
-  }
-  if(i == d->fileHeaders.size())
+  int index = indexOf(fileName);
+  if(index == -1)
     return QByteArray();
 
-  FileHeader header = d->fileHeaders.at(i);
+  QByteArray data;
+  data.reserve(int(readUInt(d->fileHeaders.at(index).h.uncompressed_size)));
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
 
-  ushort version_needed = readUShort(header.h.version_needed);
-  if(version_needed > ZIP_VERSION)
+  Status result = d->extractEntry(index, &buffer);
+  if(result != NoError)
   {
-    qWarning("Zip: .ZIP specification version %d implementationis needed to extract the data.",
-             version_needed);
-    d->status = FileNotSupported;
+    d->status = result;
     return QByteArray();
   }
+  return data;
+}
 
-  ushort general_purpose_bits = readUShort(header.h.general_purpose_bits);
-  int compressed_size = readUInt(header.h.compressed_size);
-  int uncompressed_size = readUInt(header.h.uncompressed_size);
-  int start = readUInt(header.h.offset_local_header);
-  // qDebug("uncompressing file %d: local header at %d", i, start);
-
-  d->device->seek(start);
-  LocalFileHeader lh;
-  d->device->read((char *)&lh, sizeof(LocalFileHeader));
-  uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
-  d->device->seek(d->device->pos() + skip);
-
-  int compression_method = readUShort(lh.compression_method);
-  // qDebug("file=%s: compressed_size=%d, uncompressed_size=%d", fileName.toLocal8Bit().data(), compressed_size, uncompressed_size);
+/*!
+ *   Uncompress the entry \a fileName in chunks and write it to \a device which
+ *   has to be open for writing. The entry is never kept completely in memory.
+ *   Returns \c false if the entry was not found or an error occurred.
+ */
+bool ZipReader::extractFile(const QString& fileName, QIODevice *device) const
+{
+  int index = indexOf(fileName);
+  if(index == -1)
+    return false;
 
-  if((general_purpose_bits & Encrypted) != 0)
+  Status result = d->extractEntry(index, device);
+  if(result != NoError)
   {
-    qWarning("Zip: Unsupported encryption method is needed to extract the data.");
-    d->status = FileEncryptionMethodNotSupported;
-    return QByteArray();
+    d->status = result;
+    return false;
   }
+  return true;
+}
 
-  // qDebug("file at %lld", d->device->pos());
-  QByteArray compressed = d->device->read(compressed_size);
-  if(compression_method == CompressionMethodStored)
-  {
-    // no compression
-    compressed.truncate(uncompressed_size);
-    return compressed;
-  }
-  else if(compression_method == CompressionMethodDeflated)
+/*!
+ *   Extracts the entries \a fileNames into \a destinationDir. Directory entries are
+ *   created and missing parent directories are added. Symbolic links are not
+ *   supported. Use extractAll() for these.
+ *   Files are extracted in parallel using the shared task scheduler if the archive
+ *   is memory mapped.
+ *   Returns \c false if an entry was not found or extraction failed.
+ */
+bool ZipReader::extractFiles(const QStringList& fileNames, const QString& destinationDir) const
+{
+  QDir baseDir(destinationDir);
+  QVector<int> indexes;
+  indexes.reserve(fileNames.size());
+  for(const QString& fileName : fileNames)
   {
-    // Deflate
-    // qDebug("compressed=%d", compressed.size());
-    compressed.truncate(compressed_size);
-    QByteArray baunzip;
-    ulong len = qMax(uncompressed_size, 1);
-    int res;
-    do
+    int index = indexOf(fileName);
+    if(index == -1)
     {
-      baunzip.resize(len);
-      res = inflate((uchar *)baunzip.data(), &len,
-                    (const uchar *)compressed.constData(), compressed_size);
+      qWarning() << "Zip: entry" << fileName << "not found";
+      return false;
+    }
 
-      switch(res)
-      {
-        case Z_OK:
-          if((int)len != baunzip.size())
-            baunzip.resize(len);
-          break;
-        case Z_MEM_ERROR:
-          qWarning("Zip: Z_MEM_ERROR: Not enough memory");
-          d->status = MemoryError;
-          break;
-        case Z_BUF_ERROR:
-          len *= 2;
-          break;
-        case Z_DATA_ERROR:
-          qWarning("Zip: Z_DATA_ERROR: Input data is corrupted");
-          d->status = FileCorrupted;
-          break;
-      }
-    } while(res == Z_BUF_ERROR);
-    return baunzip;
+    FileInfo fi;
+    d->fillFileInfo(index, fi);
+    if(fi.isDir)
+    {
+      if(!baseDir.mkpath(fi.filePath))
+        return false;
+    }
+    else if(fi.isFile)
+      indexes.append(index);
   }
-
-  qWarning("Zip: Unsupported compression method %d is needed to extract the data.", compression_method);
-  d->status = FileEncryptionMethodNotSupported;
-  return QByteArray();
+  return d->extractFiles(indexes, destinationDir);
 }
 
 /*!
@@ -1157,22 +1383,14 @@ bool ZipReader::extractAll(const QString& destinationDir) const
     }
   }
 
-  foreach(const FileInfo &fi, allFiles)
+  // Extract files in parallel if possible
+  QVector<int> indexes;
+  for(int i = 0; i < allFiles.size(); i++)
   {
-    const QString absPath = destinationDir + QDir::separator() + fi.filePath;
-    if(fi.isFile)
-    {
-      QFile f(absPath);
-      if(!f.open(QIODevice::WriteOnly))
-        return false;
-
-      f.write(fileData(fi.filePath));
-      f.setPermissions(fi.permissions);
-      f.close();
-    }
+    if(allFiles.at(i).isFile)
+      indexes.append(i);
   }
-
-  return true;
+  return d->extractFiles(indexes, destinationDir);
 }
 
 /*!
@@ -1201,6 +1419,7 @@ ZipReader::Status ZipReader::status() const
  */
 void ZipReader::close()
 {
+  d->unmapFile();
   d->device->close();
 }
 
@@ -39,6 +39,7 @@
 #include <QDateTime>
 #include <QFile>
 #include <QString>
+#include <QStringList>
 
 namespace atools {
 namespace zip {
@@ -82,7 +83,13 @@ public:
   int count() const;
 
   FileInfo entryInfoAt(int index) const;
+  int indexOf(const QString& fileName) const;
+  bool contains(const QString& fileName) const;
+  bool isMapped() const;
+
   QByteArray fileData(const QString& fileName) const;
+  bool extractFile(const QString& fileName, QIODevice *device) const;
+  bool extractFiles(const QStringList& fileNames, const QString& destinationDir) const;
   bool extractAll(const QString& destinationDir) const;
 
   enum Status